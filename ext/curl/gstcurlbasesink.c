@@ -70,6 +70,7 @@
 #define DEFAULT_URL                    "localhost:5555"
 #define DEFAULT_TIMEOUT                30
 #define DEFAULT_QOS_DSCP               0
+#define DEFAULT_MAX_QUEUED_BYTES       0
 
 #define DSCP_MIN                       0
 #define DSCP_MAX                       63
@@ -91,7 +92,8 @@ enum
   PROP_USER_PASSWD,
   PROP_FILE_NAME,
   PROP_TIMEOUT,
-  PROP_QOS_DSCP
+  PROP_QOS_DSCP,
+  PROP_MAX_QUEUED_BYTES
 };
 
 /* Object class function declarations */
@@ -141,6 +143,11 @@ static void gst_curl_base_sink_new_file_notify_unlocked
 static void gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked
     (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_wait_for_queue_drained_unlocked
+    (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_next_buffer_unlocked (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_release_buffer_unlocked (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_clear_queue_unlocked (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_wait_for_response (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_got_response_notify (GstCurlBaseSink * sink);
 
@@ -154,7 +161,7 @@ G_DEFINE_TYPE (GstCurlBaseSink, gst_curl_base_sink, GST_TYPE_BASE_SINK);
 static gboolean
 gst_curl_base_sink_default_has_buffered_data_unlocked (GstCurlBaseSink * sink)
 {
-  return sink->transfer_buf->len > 0;
+  return sink->transfer_buf->len > 0 || !g_queue_is_empty (sink->buffer_queue);
 }
 
 static gboolean
@@ -235,18 +242,39 @@ gst_curl_base_sink_class_init (GstCurlBaseSinkClass * klass)
           DSCP_MIN, DSCP_MAX, DEFAULT_QOS_DSCP,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstCurlBaseSink:max-queued-bytes:
+   *
+   * Number of bytes that may be queued for the transfer thread before
+   * rendering blocks. With the default of 0 every buffer is sent before the
+   * next one is accepted, larger values let the upload run in parallel with
+   * the rest of the pipeline.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUED_BYTES,
+      g_param_spec_uint64 ("max-queued-bytes", "Max queued bytes",
+          "Maximum number of bytes queued for upload before blocking "
+          "(0 = send each buffer before accepting the next)",
+          0, G_MAXUINT64, DEFAULT_MAX_QUEUED_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &sinktemplate);
 }
 
 static void
 gst_curl_base_sink_init (GstCurlBaseSink * sink)
 {
-  sink->transfer_buf = g_malloc (sizeof (TransferBuffer));
+  sink->transfer_buf = g_malloc0 (sizeof (TransferBuffer));
   sink->transfer_cond = g_malloc (sizeof (TransferCondition));
   g_cond_init (&sink->transfer_cond->cond);
   sink->transfer_cond->data_sent = FALSE;
   sink->transfer_cond->data_available = FALSE;
   sink->transfer_cond->wait_for_response = FALSE;
+  sink->buffer_queue = g_queue_new ();
+  sink->transfer_buffer = NULL;
+  sink->queued_bytes = 0;
+  sink->max_queued_bytes = DEFAULT_MAX_QUEUED_BYTES;
   sink->timeout = DEFAULT_TIMEOUT;
   sink->qos_dscp = DEFAULT_QOS_DSCP;
   sink->url = g_strdup (DEFAULT_URL);
@@ -268,6 +296,8 @@ gst_curl_base_sink_finalize (GObject * gobject)
   }
 
   gst_curl_base_sink_transfer_cleanup (this);
+  gst_curl_base_sink_clear_queue_unlocked (this);
+  g_queue_free (this->buffer_queue);
   g_cond_clear (&this->transfer_cond->cond);
   g_free (this->transfer_cond);
   g_free (this->transfer_buf);
@@ -338,9 +368,7 @@ static GstFlowReturn
 gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
   GstCurlBaseSink *sink;
-  GstMapInfo map;
-  guint8 *data;
-  size_t size;
+  gsize size;
   GstFlowReturn ret;
   gchar *error;
 
@@ -348,12 +376,8 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 
   sink = GST_CURL_BASE_SINK (bsink);
 
-  gst_buffer_map (buf, &map, GST_MAP_READ);
-  data = map.data;
-  size = map.size;
-
+  size = gst_buffer_get_size (buf);
   if (size == 0) {
-    gst_buffer_unmap (buf, &map);
     return GST_FLOW_OK;
   }
 
@@ -365,8 +389,6 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     goto done;
   }
 
-  g_assert (sink->transfer_cond->data_available == FALSE);
-
   /* if there is no transfer thread created, lets create one */
   if (sink->transfer_thread == NULL) {
     if (!gst_curl_base_sink_transfer_start_unlocked (sink)) {
@@ -375,20 +397,18 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     }
   }
 
-  /* make data available for the transfer thread and notify */
-  sink->transfer_buf->ptr = data;
-  sink->transfer_buf->len = size;
-  sink->transfer_buf->offset = 0;
+  /* queue the data for the transfer thread and notify, the curl read
+   * callback maps the buffers in turn and copies from them directly */
+  g_queue_push_tail (sink->buffer_queue, gst_buffer_ref (buf));
+  sink->queued_bytes += size;
   gst_curl_base_sink_transfer_thread_notify_unlocked (sink);
 
-  /* wait for the transfer thread to send the data. This will be notified
-   * either when transfer is completed by the curl read callback or by
-   * the thread function if an error has occurred. */
+  /* wait for the transfer thread to get below the queued bytes limit. This
+   * will be notified either when sending a buffer is completed by the curl
+   * read callback or by the thread function if an error has occurred. */
   gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked (sink);
 
 done:
-  gst_buffer_unmap (buf, &map);
-
   /* Hand over error from transfer thread to streaming thread */
   error = sink->error;
   sink->error = NULL;
@@ -415,6 +435,9 @@ gst_curl_base_sink_event (GstBaseSink * bsink, GstEvent * event)
   switch (event->type) {
     case GST_EVENT_EOS:
       GST_DEBUG_OBJECT (sink, "received EOS");
+      GST_OBJECT_LOCK (sink);
+      gst_curl_base_sink_wait_for_queue_drained_unlocked (sink);
+      GST_OBJECT_UNLOCK (sink);
       gst_curl_base_sink_transfer_thread_close (sink);
       gst_curl_base_sink_wait_for_response (sink);
       break;
@@ -464,6 +487,9 @@ gst_curl_base_sink_stop (GstBaseSink * bsink)
   GstCurlBaseSink *sink = GST_CURL_BASE_SINK (bsink);
 
   gst_curl_base_sink_transfer_thread_close (sink);
+  GST_OBJECT_LOCK (sink);
+  gst_curl_base_sink_clear_queue_unlocked (sink);
+  GST_OBJECT_UNLOCK (sink);
   if (sink->fdset != NULL) {
     gst_poll_free (sink->fdset);
     sink->fdset = NULL;
@@ -542,6 +568,11 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
         gst_curl_base_sink_setup_dscp_unlocked (sink);
         GST_DEBUG_OBJECT (sink, "dscp set to %d", sink->qos_dscp);
         break;
+      case PROP_MAX_QUEUED_BYTES:
+        sink->max_queued_bytes = g_value_get_uint64 (value);
+        GST_DEBUG_OBJECT (sink, "max queued bytes set to %" G_GUINT64_FORMAT,
+            sink->max_queued_bytes);
+        break;
       default:
         GST_DEBUG_OBJECT (sink, "invalid property id %d", prop_id);
         break;
@@ -571,6 +602,13 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
       gst_curl_base_sink_setup_dscp_unlocked (sink);
       GST_DEBUG_OBJECT (sink, "dscp set to %d", sink->qos_dscp);
       break;
+    case PROP_MAX_QUEUED_BYTES:
+      sink->max_queued_bytes = g_value_get_uint64 (value);
+      GST_DEBUG_OBJECT (sink, "max queued bytes set to %" G_GUINT64_FORMAT,
+          sink->max_queued_bytes);
+      /* a larger limit may unblock the render function */
+      g_cond_broadcast (&sink->transfer_cond->cond);
+      break;
     default:
       GST_WARNING_OBJECT (sink, "cannot set property when PLAYING");
       break;
@@ -607,6 +645,11 @@ gst_curl_base_sink_get_property (GObject * object, guint prop_id,
     case PROP_QOS_DSCP:
       g_value_set_int (value, sink->qos_dscp);
       break;
+    case PROP_MAX_QUEUED_BYTES:
+      GST_OBJECT_LOCK (sink);
+      g_value_set_uint64 (value, sink->max_queued_bytes);
+      GST_OBJECT_UNLOCK (sink);
+      break;
     default:
       GST_DEBUG_OBJECT (sink, "invalid property id");
       break;
@@ -845,6 +888,9 @@ gst_curl_base_sink_transfer_read_cb (void *curl_ptr, size_t size, size_t nmemb,
     return 0;
   }
 
+  /* only the transfer thread touches the transfer buffer, so it can be
+   * used without the lock once the next queued buffer is mapped */
+  gst_curl_base_sink_next_buffer_unlocked (sink);
   GST_OBJECT_UNLOCK (sink);
 
   bytes_to_send = klass->transfer_data_buffer (sink, curl_ptr,
@@ -1172,6 +1218,8 @@ gst_curl_base_sink_transfer_thread_func (gpointer data)
      * for this file and go directly to the new file */
     data_available = gst_curl_base_sink_wait_for_data_unlocked (sink);
     if (data_available) {
+      /* map the first buffer so the protocol options can depend on it */
+      gst_curl_base_sink_next_buffer_unlocked (sink);
       if (G_UNLIKELY (!klass->set_protocol_dynamic_options_unlocked (sink))) {
         sink->error = g_strdup ("unexpected state");
         sink->flow_ret = GST_FLOW_ERROR;
@@ -1318,6 +1366,8 @@ static void
 gst_curl_base_sink_new_file_notify_unlocked (GstCurlBaseSink * sink)
 {
   GST_LOG ("new file name");
+  /* the queued data still belongs to the previous file */
+  gst_curl_base_sink_wait_for_queue_drained_unlocked (sink);
   sink->new_file = TRUE;
   g_cond_signal (&sink->transfer_cond->cond);
 }
@@ -1326,26 +1376,95 @@ static void
     gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked
     (GstCurlBaseSink * sink)
 {
-  GST_LOG ("waiting for buffer send to complete");
+  GST_LOG ("waiting for queued bytes %" G_GUINT64_FORMAT " to drop to %"
+      G_GUINT64_FORMAT, sink->queued_bytes, sink->max_queued_bytes);
 
   /* this function should not check if the transfer thread is set to be closed
    * since that flag only can be set by the EOS event (by the pipeline thread).
    * This can therefore never happen while this function is running since this
    * function also is called by the pipeline thread (in the render function) */
-  while (!sink->transfer_cond->data_sent) {
+  while (sink->queued_bytes > sink->max_queued_bytes &&
+      sink->flow_ret == GST_FLOW_OK) {
     g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
   }
   GST_LOG ("buffer send completed");
 }
 
+static void
+gst_curl_base_sink_wait_for_queue_drained_unlocked (GstCurlBaseSink * sink)
+{
+  GST_LOG ("waiting for queued buffers to be sent");
+
+  while (sink->queued_bytes > 0 && sink->transfer_thread != NULL &&
+      sink->flow_ret == GST_FLOW_OK) {
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
+}
+
+/* Maps the next queued buffer into the transfer buffer once the current one
+ * has been sent */
+static void
+gst_curl_base_sink_next_buffer_unlocked (GstCurlBaseSink * sink)
+{
+  GstBuffer *buf;
+
+  if (sink->transfer_buffer != NULL)
+    return;
+
+  buf = g_queue_pop_head (sink->buffer_queue);
+  if (buf == NULL)
+    return;
+
+  if (!gst_buffer_map (buf, &sink->transfer_map, GST_MAP_READ)) {
+    GST_WARNING_OBJECT (sink, "could not map buffer, skipping it");
+    sink->queued_bytes -= gst_buffer_get_size (buf);
+    gst_buffer_unref (buf);
+    return;
+  }
+
+  sink->transfer_buffer = buf;
+  sink->transfer_buf->ptr = sink->transfer_map.data;
+  sink->transfer_buf->len = sink->transfer_map.size;
+  sink->transfer_buf->offset = 0;
+}
+
+static void
+gst_curl_base_sink_release_buffer_unlocked (GstCurlBaseSink * sink)
+{
+  if (sink->transfer_buffer == NULL)
+    return;
+
+  sink->queued_bytes -= sink->transfer_map.size;
+  gst_buffer_unmap (sink->transfer_buffer, &sink->transfer_map);
+  gst_buffer_unref (sink->transfer_buffer);
+  sink->transfer_buffer = NULL;
+  sink->transfer_buf->ptr = NULL;
+  sink->transfer_buf->len = 0;
+  sink->transfer_buf->offset = 0;
+}
+
+static void
+gst_curl_base_sink_clear_queue_unlocked (GstCurlBaseSink * sink)
+{
+  gst_curl_base_sink_release_buffer_unlocked (sink);
+  g_queue_foreach (sink->buffer_queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (sink->buffer_queue);
+  sink->queued_bytes = 0;
+  sink->transfer_cond->data_available = FALSE;
+}
+
 static void
 gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink)
 {
   GST_LOG ("transfer completed");
   GST_OBJECT_LOCK (sink);
-  sink->transfer_cond->data_available = FALSE;
-  sink->transfer_cond->data_sent = TRUE;
-  g_cond_signal (&sink->transfer_cond->cond);
+  gst_curl_base_sink_release_buffer_unlocked (sink);
+  if (g_queue_is_empty (sink->buffer_queue)) {
+    sink->transfer_cond->data_available = FALSE;
+    sink->transfer_cond->data_sent = TRUE;
+  }
+  /* both the render function and a file name change may be waiting */
+  g_cond_broadcast (&sink->transfer_cond->cond);
   GST_OBJECT_UNLOCK (sink);
 }
 
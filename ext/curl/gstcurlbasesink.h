@@ -73,6 +73,11 @@ struct _GstCurlBaseSink
   GstFlowReturn flow_ret;
   TransferBuffer *transfer_buf;
   TransferCondition *transfer_cond;
+  GQueue *buffer_queue;
+  GstBuffer *transfer_buffer;
+  GstMapInfo transfer_map;
+  guint64 queued_bytes;
+  guint64 max_queued_bytes;
   gint num_buffers_per_packet;
   gint timeout;
   gchar *url;
@@ -403,6 +403,19 @@ gst_curl_http_sink_set_options_unlocked (GstCurlBaseSink * bcsink)
   parent_class = GST_CURL_TLS_SINK_GET_CLASS (sink);
 
   if (g_str_has_prefix (bcsink->url, "https://")) {
+#ifdef CURL_VERSION_HTTP2
+    /* negotiated through ALPN, so servers without HTTP/2 keep working. The
+     * connection then carries the uploads of consecutive files without
+     * another handshake */
+    if (curl_version_info (CURLVERSION_NOW)->features & CURL_VERSION_HTTP2) {
+      res = curl_easy_setopt (bcsink->curl, CURLOPT_HTTP_VERSION,
+          CURL_HTTP_VERSION_2_0);
+      if (res != CURLE_OK) {
+        GST_WARNING_OBJECT (sink, "failed to enable HTTP/2: %s",
+            curl_easy_strerror (res));
+      }
+    }
+#endif
     GST_DEBUG_OBJECT (bcsink, "setting up tls options");
     return parent_class->set_options_unlocked (bcsink);
   }
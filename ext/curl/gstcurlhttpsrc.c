@@ -71,6 +71,17 @@
  * MPD file. This requires GStreamer to have been built with dashdemux from
  * gst-plugins-bad.
  * </refsect2>
+ *
+ * All instances share one curl multi handle. Over HTTP/2 the requests to the
+ * same server are multiplexed on a single connection, so the fragments of
+ * an adaptive stream do not each pay for a connection and TLS handshake.
+ *
+ * The structure of the sticky "http-headers" event and of the matching
+ * element message contains a "timing" structure with the "dns-time",
+ * "connect-time", "tls-time" and "ttfb" (time to first byte, from the
+ * start of the request) of the response, in nanoseconds. When the whole
+ * body has been received, an "http-timing" element message is posted with
+ * the same fields and the "uri", "total-time" and "size" of the transfer.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -107,6 +118,9 @@ static void gst_curl_http_src_finalize (GObject * obj);
 static GstFlowReturn gst_curl_http_src_create (GstPushSrc * psrc,
     GstBuffer ** outbuf);
 static GstFlowReturn gst_curl_http_src_handle_response (GstCurlHttpSrc * src);
+static GstStructure *gst_curl_http_src_get_timing (GstCurlHttpSrc * src,
+    gboolean complete);
+static void gst_curl_http_src_post_timing (GstCurlHttpSrc * src);
 static gboolean gst_curl_http_src_negotiate_caps (GstCurlHttpSrc * src);
 static GstStateChangeReturn gst_curl_http_src_change_state (GstElement *
     element, GstStateChange transition);
@@ -656,8 +670,14 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
     /* set up curl */
     klass->multi_task_context.multi_handle = curl_multi_init ();
 
+#ifdef CURLPIPE_MULTIPLEX
+    /* Multiplex the HTTP/2 requests to the same server on one connection */
+    curl_multi_setopt (klass->multi_task_context.multi_handle,
+        CURLMOPT_PIPELINING, CURLPIPE_HTTP1 | CURLPIPE_MULTIPLEX);
+#else
     curl_multi_setopt (klass->multi_task_context.multi_handle,
         CURLMOPT_PIPELINING, 1);
+#endif
 #ifdef CURLMOPT_MAX_HOST_CONNECTIONS
     curl_multi_setopt (klass->multi_task_context.multi_handle,
         CURLMOPT_MAX_HOST_CONNECTIONS, 1);
@@ -805,8 +825,7 @@ retry:
 
   if (src->state == GSTCURL_UNLOCK) {
     if (src->buffer_len > 0) {
-      g_free (src->buffer);
-      src->buffer = NULL;
+      gst_buffer_replace (&src->buffer, NULL);
       src->buffer_len = 0;
     }
     ret = GST_FLOW_FLUSHING;
@@ -859,10 +878,7 @@ retry:
 
     GST_DEBUG_OBJECT (src, "Pushing %u bytes of transfer for URI %s to pad",
         src->buffer_len, src->uri);
-    *outbuf = gst_buffer_new_allocate (NULL, src->buffer_len, NULL);
-    gst_buffer_fill (*outbuf, 0, src->buffer, src->buffer_len);
-
-    g_free (src->buffer);
+    *outbuf = src->buffer;
     src->buffer = NULL;
     src->buffer_len = 0;
     src->data_received = TRUE;
@@ -871,6 +887,7 @@ retry:
   } else if ((src->state == GSTCURL_DONE) && (src->buffer_len == 0)) {
     GST_INFO_OBJECT (src, "Full body received, signalling EOS for URI %s.",
         src->uri);
+    gst_curl_http_src_post_timing (src);
     src->state = GSTCURL_NONE;
     src->transfer_begun = FALSE;
     src->status_code = 0;
@@ -1036,6 +1053,12 @@ gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
 
   gst_curl_setopt_str (s, handle, CURLOPT_ERRORBUFFER, s->curl_errbuf);
 
+#ifdef CURLOPT_PIPEWAIT
+  /* Rather wait for a connection that can be multiplexed than open another
+   * one, requests to other host names of the same server share it too */
+  gst_curl_setopt_int (s, handle, CURLOPT_PIPEWAIT, 1);
+#endif
+
   GSTCURL_FUNCTION_EXIT (s);
   return handle;
 }
@@ -1053,6 +1076,7 @@ gst_curl_http_src_handle_response (GstCurlHttpSrc * src)
   gchar *redirect_url;
   GstBaseSrc *basesrc;
   const GValue *response_headers;
+  GstStructure *timing;
   GstFlowReturn ret = GST_FLOW_OK;
 
   GSTCURL_FUNCTION_ENTRY (src);
@@ -1155,6 +1179,11 @@ gst_curl_http_src_handle_response (GstCurlHttpSrc * src)
     }
   }
 
+  timing = gst_curl_http_src_get_timing (src, FALSE);
+  gst_structure_set (src->http_headers, TIMING_NAME, GST_TYPE_STRUCTURE,
+      timing, NULL);
+  gst_structure_free (timing);
+
   /*
    * Push all the received headers down via a sicky event
    */
@@ -1189,6 +1218,71 @@ gst_curl_http_src_handle_response (GstCurlHttpSrc * src)
   return ret;
 }
 
+static GstClockTime
+curl_info_time (GstCurlHttpSrc * src, CURLINFO info)
+{
+  gdouble secs;
+
+  if (curl_easy_getinfo (src->curl_handle, info, &secs) != CURLE_OK ||
+      secs <= 0)
+    return 0;
+
+  return (GstClockTime) (secs * GST_SECOND);
+}
+
+/*
+ * Get the time the request spent in each phase, for bandwidth estimators
+ * that want to tell the latency of a request from its throughput. The
+ * "tls-time" is 0 for plain HTTP and for reused connections, as are the
+ * "dns-time" and "connect-time".
+ */
+static GstStructure *
+gst_curl_http_src_get_timing (GstCurlHttpSrc * src, gboolean complete)
+{
+  GstClockTime dns, connect, tls, ttfb;
+  GstStructure *timing;
+  gdouble size;
+
+  dns = curl_info_time (src, CURLINFO_NAMELOOKUP_TIME);
+  connect = curl_info_time (src, CURLINFO_CONNECT_TIME);
+  tls = curl_info_time (src, CURLINFO_APPCONNECT_TIME);
+  ttfb = curl_info_time (src, CURLINFO_STARTTRANSFER_TIME);
+
+  timing = gst_structure_new (complete ? TIMING_MESSAGE_NAME : TIMING_NAME,
+      "dns-time", G_TYPE_UINT64, dns,
+      "connect-time", G_TYPE_UINT64, connect > dns ? connect - dns : 0,
+      "tls-time", G_TYPE_UINT64, tls > connect ? tls - connect : 0,
+      "ttfb", G_TYPE_UINT64, ttfb, NULL);
+
+  if (complete) {
+    if (curl_easy_getinfo (src->curl_handle, CURLINFO_SIZE_DOWNLOAD,
+            &size) != CURLE_OK)
+      size = 0;
+
+    gst_structure_set (timing, URI_NAME, G_TYPE_STRING, src->uri,
+        "total-time", G_TYPE_UINT64,
+        curl_info_time (src, CURLINFO_TOTAL_TIME),
+        "size", G_TYPE_UINT64, (guint64) size, NULL);
+  }
+
+  return timing;
+}
+
+static void
+gst_curl_http_src_post_timing (GstCurlHttpSrc * src)
+{
+  GstStructure *timing;
+
+  if (src->curl_handle == NULL)
+    return;
+
+  timing = gst_curl_http_src_get_timing (src, TRUE);
+  GST_DEBUG_OBJECT (src, "Transfer timing: %" GST_PTR_FORMAT, timing);
+
+  gst_element_post_message (GST_ELEMENT_CAST (src),
+      gst_message_new_element (GST_OBJECT_CAST (src), timing));
+}
+
 /*
  * "Negotiate" capabilities between us and the sink.
  * I.e. tell the sink device what data to expect. We can't be told what to send
@@ -1310,8 +1404,7 @@ gst_curl_http_src_cleanup_instance (GstCurlHttpSrc * src)
 
   g_cond_clear (&src->signal);
 
-  g_free (src->buffer);
-  src->buffer = NULL;
+  gst_buffer_replace (&src->buffer, NULL);
 
   if (src->http_headers != NULL) {
     gst_structure_free (src->http_headers);
@@ -1824,6 +1917,7 @@ gst_curl_http_src_get_chunks (void *chunk, size_t size, size_t nmemb, void *src)
 {
   GstCurlHttpSrc *s = src;
   size_t chunk_len = size * nmemb;
+  gpointer data;
   GST_TRACE_OBJECT (s,
       "Received curl chunk for URI %s of size %d", s->uri, (int) chunk_len);
   g_mutex_lock (&s->buffer_mutex);
@@ -1831,15 +1925,18 @@ gst_curl_http_src_get_chunks (void *chunk, size_t size, size_t nmemb, void *src)
     g_mutex_unlock (&s->buffer_mutex);
     return chunk_len;
   }
-  s->buffer =
-      g_realloc (s->buffer, (s->buffer_len + chunk_len + 1) * sizeof (char));
+
+  /* The chunk is only valid during the callback, so it is copied once into
+   * memory that is pushed downstream as it is. create only waits when there
+   * was no data yet */
   if (s->buffer == NULL) {
-    GST_ERROR_OBJECT (s, "Realloc for cURL response message failed!\n");
-    return 0;
+    s->buffer = gst_buffer_new ();
+    g_cond_signal (&s->signal);
   }
-  memcpy (s->buffer + s->buffer_len, chunk, chunk_len);
+  data = g_memdup (chunk, chunk_len);
+  gst_buffer_append_memory (s->buffer,
+      gst_memory_new_wrapped (0, data, chunk_len, 0, chunk_len, data, g_free));
   s->buffer_len += chunk_len;
-  g_cond_signal (&s->signal);
   g_mutex_unlock (&s->buffer_mutex);
   return chunk_len;
 }
@@ -90,6 +90,8 @@ typedef struct _GstCurlHttpSrcQueueElement GstCurlHttpSrcQueueElement;
 #define REQUEST_HEADERS_NAME    "request-headers"
 #define RESPONSE_HEADERS_NAME   "response-headers"
 #define REDIRECT_URI_NAME       "redirection-uri"
+#define TIMING_NAME             "timing"
+#define TIMING_MESSAGE_NAME     "http-timing"
 
 typedef enum
   {
@@ -201,7 +203,7 @@ struct _GstCurlHttpSrc
   CURL *curl_handle;
   GMutex buffer_mutex;
   GCond signal;
-  gchar *buffer;
+  GstBuffer *buffer;          /* the chunks received since the last create */
   guint buffer_len;
   gboolean transfer_begun;
   gboolean data_received;
@@ -327,6 +327,9 @@ enum
   PROP_MAX_VIDEO_HEIGHT,
   PROP_MAX_VIDEO_FRAMERATE,
   PROP_PRESENTATION_DELAY,
+  PROP_LOW_LATENCY,
+  PROP_TARGET_LATENCY,
+  PROP_INCREMENTAL_UPDATES,
   PROP_LAST
 };
 
@@ -339,6 +342,9 @@ enum
 #define DEFAULT_MAX_VIDEO_FRAMERATE_N     0
 #define DEFAULT_MAX_VIDEO_FRAMERATE_D     1
 #define DEFAULT_PRESENTATION_DELAY     "10s"    /* 10s */
+#define DEFAULT_LOW_LATENCY           FALSE
+#define DEFAULT_TARGET_LATENCY   (3 * GST_SECOND)
+#define DEFAULT_INCREMENTAL_UPDATES   FALSE
 
 /* Clock drift compensation for live streams */
 #define SLOW_CLOCK_UPDATE_INTERVAL  (1000000 * 30 * 60) /* 30 minutes */
@@ -388,6 +394,8 @@ static GstFlowReturn
 gst_dash_demux_stream_advance_fragment (GstAdaptiveDemuxStream * stream);
 static gboolean
 gst_dash_demux_stream_advance_subfragment (GstAdaptiveDemuxStream * stream);
+static gboolean gst_dash_demux_stream_get_bitrates (GstAdaptiveDemuxStream *
+    stream, GArray * bitrates, guint64 * current_bitrate);
 static gboolean gst_dash_demux_stream_select_bitrate (GstAdaptiveDemuxStream *
     stream, guint64 bitrate);
 static gint64 gst_dash_demux_get_manifest_update_interval (GstAdaptiveDemux *
@@ -436,6 +444,11 @@ SIDX_ENTRY (GstDashDemuxStream * s, gint i)
 
 #define SIDX_CURRENT_ENTRY(s) SIDX_ENTRY(s, SIDX(s)->entry_index)
 
+/* In reverse playback, download consecutive subsegments together in a single
+ * range request, as many as can be downloaded in about this time according
+ * to the measured download rate */
+#define SIDX_GROUP_DOWNLOAD_TIME (GST_SECOND)
+
 static void gst_dash_demux_send_content_protection_event (gpointer cp_data,
     gpointer stream);
 
@@ -595,6 +608,27 @@ gst_dash_demux_class_init (GstDashDemuxClass * klass)
           DEFAULT_PRESENTATION_DELAY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Request live segments as soon as their first chunks are available "
+          "(according to SegmentBase@availabilityTimeOffset) and skip ahead "
+          "when falling behind the target latency",
+          DEFAULT_LOW_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TARGET_LATENCY,
+      g_param_spec_uint64 ("target-latency", "Target latency",
+          "Distance to the live edge to keep in low-latency mode (in ns)",
+          0, G_MAXUINT64, DEFAULT_TARGET_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INCREMENTAL_UPDATES,
+      g_param_spec_boolean ("incremental-updates", "Incremental updates",
+          "Skip unchanged live manifest refreshes and merge new "
+          "SegmentTimeline entries into the current manifest instead of "
+          "rebuilding the streams when only those changed",
+          DEFAULT_INCREMENTAL_UPDATES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class,
       &gst_dash_demux_audiosrc_template);
   gst_element_class_add_static_pad_template (gstelement_class,
@@ -635,6 +669,8 @@ gst_dash_demux_class_init (GstDashDemuxClass * klass)
   gstadaptivedemux_class->stream_seek = gst_dash_demux_stream_seek;
   gstadaptivedemux_class->stream_select_bitrate =
       gst_dash_demux_stream_select_bitrate;
+  gstadaptivedemux_class->stream_get_bitrates =
+      gst_dash_demux_stream_get_bitrates;
   gstadaptivedemux_class->stream_update_fragment_info =
       gst_dash_demux_stream_update_fragment_info;
   gstadaptivedemux_class->stream_free = gst_dash_demux_stream_free;
@@ -664,6 +700,9 @@ gst_dash_demux_init (GstDashDemux * demux)
   demux->max_video_framerate_n = DEFAULT_MAX_VIDEO_FRAMERATE_N;
   demux->max_video_framerate_d = DEFAULT_MAX_VIDEO_FRAMERATE_D;
   demux->default_presentation_delay = g_strdup (DEFAULT_PRESENTATION_DELAY);
+  demux->low_latency = DEFAULT_LOW_LATENCY;
+  demux->target_latency = DEFAULT_TARGET_LATENCY;
+  demux->incremental_updates = DEFAULT_INCREMENTAL_UPDATES;
 
   g_mutex_init (&demux->client_lock);
 
@@ -702,6 +741,15 @@ gst_dash_demux_set_property (GObject * object, guint prop_id,
       g_free (demux->default_presentation_delay);
       demux->default_presentation_delay = g_value_dup_string (value);
       break;
+    case PROP_LOW_LATENCY:
+      demux->low_latency = g_value_get_boolean (value);
+      break;
+    case PROP_TARGET_LATENCY:
+      demux->target_latency = g_value_get_uint64 (value);
+      break;
+    case PROP_INCREMENTAL_UPDATES:
+      demux->incremental_updates = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -741,6 +789,15 @@ gst_dash_demux_get_property (GObject * object, guint prop_id, GValue * value,
       else
         g_value_set_string (value, demux->default_presentation_delay);
       break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, demux->low_latency);
+      break;
+    case PROP_TARGET_LATENCY:
+      g_value_set_uint64 (value, demux->target_latency);
+      break;
+    case PROP_INCREMENTAL_UPDATES:
+      g_value_set_boolean (value, demux->incremental_updates);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -857,6 +914,7 @@ gst_dash_demux_setup_all_streams (GstDashDemux * demux)
     stream->index = i;
     stream->pending_seek_ts = GST_CLOCK_TIME_NONE;
     stream->sidx_position = GST_CLOCK_TIME_NONE;
+    stream->sidx_group_first = -1;
     stream->actual_position = GST_CLOCK_TIME_NONE;
     stream->target_time = GST_CLOCK_TIME_NONE;
     /* Set a default average keyframe download time of a quarter of a second */
@@ -1114,6 +1172,8 @@ gst_dash_demux_reset (GstAdaptiveDemux * ademux)
   }
   gst_dash_demux_clock_drift_free (demux->clock_drift);
   demux->clock_drift = NULL;
+  g_free (demux->manifest_checksum);
+  demux->manifest_checksum = NULL;
   demux->client = gst_mpd_client_new ();
   gst_mpd_client_set_uri_downloader (demux->client, ademux->downloader);
 
@@ -1252,6 +1312,43 @@ gst_dash_demux_stream_update_headers_info (GstAdaptiveDemuxStream * stream)
   }
 }
 
+/* Selects the sidx entries before the current one that are downloaded
+ * together with it in reverse playback. The range request then still ends
+ * at the current entry, so the subsegment based advancing in
+ * gst_dash_demux_handle_isobmff() is unchanged, and only one request is
+ * needed for all of them instead of one per subsegment.
+ *
+ * Returns: the first entry of the group */
+static GstSidxBoxEntry *
+gst_dash_demux_stream_group_sidx_entries (GstDashDemuxStream * dashstream)
+{
+  GstAdaptiveDemuxStream *stream = (GstAdaptiveDemuxStream *) dashstream;
+  GstSidxBox *sidx = SIDX (dashstream);
+  guint64 max_size, size;
+  gint first;
+
+  first = sidx->entry_index;
+  if (dashstream->is_isobmff && stream->current_download_rate > 0) {
+    max_size = gst_util_uint64_scale (stream->current_download_rate,
+        SIDX_GROUP_DOWNLOAD_TIME, 8 * GST_SECOND);
+    size = sidx->entries[first].size;
+
+    while (first > 0 && size + sidx->entries[first - 1].size <= max_size
+        && sidx->entries[first - 1].offset + sidx->entries[first - 1].size ==
+        sidx->entries[first].offset) {
+      first--;
+      size += sidx->entries[first].size;
+    }
+  }
+
+  if (first != sidx->entry_index)
+    GST_DEBUG_OBJECT (stream->pad, "Downloading sidx entries %d to %d at once",
+        first, sidx->entry_index);
+
+  dashstream->sidx_group_first = first;
+  return &sidx->entries[first];
+}
+
 static GstFlowReturn
 gst_dash_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream)
 {
@@ -1349,8 +1446,17 @@ gst_dash_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream)
       dashstream->current_fragment_duration = stream->fragment.duration =
           entry->duration;
       if (stream->demux->segment.rate < 0.0) {
+        GstSidxBoxEntry *first = gst_dash_demux_stream_group_sidx_entries
+            (dashstream);
+
+        stream->fragment.range_start =
+            dashstream->sidx_base_offset + first->offset;
         stream->fragment.range_end =
-            stream->fragment.range_start + entry->size - 1;
+            dashstream->sidx_base_offset + entry->offset + entry->size - 1;
+        dashstream->current_fragment_timestamp = stream->fragment.timestamp =
+            first->pts;
+        dashstream->current_fragment_duration = stream->fragment.duration =
+            entry->pts + entry->duration - first->pts;
         dashstream->actual_position += entry->duration;
       } else {
         stream->fragment.range_end = fragment.range_end;
@@ -1453,6 +1559,7 @@ gst_dash_demux_stream_sidx_seek (GstDashDemuxStream * dashstream,
   g_assert (sidx->entry_index < sidx->entries_count);
 
   sidx->entry_index = idx;
+  dashstream->sidx_group_first = -1;
   dashstream->sidx_position = sidx->entries[idx].pts;
 
   if (final_ts)
@@ -1572,7 +1679,12 @@ gst_dash_demux_stream_has_next_subfragment (GstAdaptiveDemuxStream * stream)
       if (sidx->entry_index + 1 < sidx->entries_count)
         return TRUE;
     } else {
-      if (sidx->entry_index >= 1)
+      gint first = sidx->entry_index;
+
+      if (dashstream->sidx_group_first >= 0
+          && dashstream->sidx_group_first <= first)
+        first = dashstream->sidx_group_first;
+      if (first >= 1)
         return TRUE;
     }
   }
@@ -1705,7 +1817,13 @@ gst_dash_demux_stream_advance_subfragment (GstAdaptiveDemuxStream * stream)
       else
         dashstream->sidx_position = sidx->entries[idx].pts;
     } else {
-      gint idx = --sidx->entry_index;
+      gint idx;
+
+      /* skip the entries that were downloaded with the current one */
+      if (dashstream->sidx_group_first >= 0
+          && dashstream->sidx_group_first <= sidx->entry_index)
+        sidx->entry_index = dashstream->sidx_group_first;
+      idx = --sidx->entry_index;
 
       if (idx >= 0) {
         fragment_finished = FALSE;
@@ -1715,6 +1833,7 @@ gst_dash_demux_stream_advance_subfragment (GstAdaptiveDemuxStream * stream)
       }
     }
   }
+  dashstream->sidx_group_first = -1;
 
   GST_DEBUG_OBJECT (stream->pad, "New sidx index: %d / %d. "
       "Finished fragment: %d", sidx->entry_index, sidx->entries_count,
@@ -1969,6 +2088,68 @@ out:
   return ret;
 }
 
+/* In low-latency mode, skip forward to the fragment containing the live
+ * edge minus the target latency if the next fragment lags behind it by more
+ * than one fragment. The playback rate is never changed: the skipped part is
+ * dropped and the stream is marked discontinuous, which lets a live sink
+ * catch up with the clock again. All streams compute the same target from
+ * the wall clock and thus stay aligned. */
+static void
+gst_dash_demux_stream_catch_up (GstDashDemux * dashdemux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstDashDemuxStream *dashstream = (GstDashDemuxStream *) stream;
+  GstDateTime *ast;
+  GDateTime *now, *mstart;
+  GTimeSpan stream_now;
+  GstClockTime live_edge, period_start, next_ts, target, final_ts;
+  GstClockTime duration;
+
+  if (!dashdemux->low_latency || stream->demux->segment.rate != 1.0
+      || !gst_mpd_client_is_live (dashdemux->client)
+      || GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (dashdemux))
+    return;
+
+  ast = dashdemux->client->mpd_node->availabilityStartTime;
+  if (ast == NULL)
+    return;
+
+  now = gst_dash_demux_get_server_now_utc (dashdemux);
+  mstart = gst_date_time_to_g_date_time (ast);
+  stream_now = g_date_time_difference (now, mstart);
+  g_date_time_unref (now);
+  g_date_time_unref (mstart);
+  if (stream_now <= 0)
+    return;
+
+  live_edge = stream_now * GST_USECOND;
+  period_start = gst_mpd_parser_get_period_start_time (dashdemux->client);
+  if (live_edge < period_start + dashdemux->target_latency)
+    return;
+  target = live_edge - period_start - dashdemux->target_latency;
+
+  if (!gst_mpd_client_get_next_fragment_timestamp (dashdemux->client,
+          dashstream->index, &next_ts))
+    return;
+
+  duration = gst_mpd_client_get_maximum_segment_duration (dashdemux->client);
+  if (next_ts + duration >= target)
+    return;
+
+  if (!gst_mpd_client_stream_seek (dashdemux->client,
+          dashstream->active_stream, TRUE, GST_SEEK_FLAG_SNAP_BEFORE, target,
+          &final_ts))
+    return;
+
+  GST_INFO_OBJECT (stream->pad, "Latency %" GST_TIME_FORMAT " above target %"
+      GST_TIME_FORMAT ", skipping from %" GST_TIME_FORMAT " to %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (target + dashdemux->target_latency -
+          next_ts), GST_TIME_ARGS (dashdemux->target_latency),
+      GST_TIME_ARGS (next_ts), GST_TIME_ARGS (final_ts));
+
+  stream->discont = TRUE;
+}
+
 static GstFlowReturn
 gst_dash_demux_stream_advance_fragment (GstAdaptiveDemuxStream * stream)
 {
@@ -2155,10 +2336,37 @@ gst_dash_demux_stream_advance_fragment (GstAdaptiveDemuxStream * stream)
 
     ret = gst_mpd_client_advance_segment (dashdemux->client,
         dashstream->active_stream, stream->demux->segment.rate > 0.0);
+
+    if (ret == GST_FLOW_OK)
+      gst_dash_demux_stream_catch_up (dashdemux, stream);
   }
   return ret;
 }
 
+static gboolean
+gst_dash_demux_stream_get_bitrates (GstAdaptiveDemuxStream * stream,
+    GArray * bitrates, guint64 * current_bitrate)
+{
+  GstDashDemuxStream *dashstream = (GstDashDemuxStream *) stream;
+  GstActiveStream *active_stream = dashstream->active_stream;
+  GList *l;
+
+  if (active_stream == NULL || active_stream->cur_adapt_set == NULL)
+    return FALSE;
+
+  for (l = active_stream->cur_adapt_set->Representations; l; l = l->next) {
+    GstRepresentationNode *rep = l->data;
+    guint64 bandwidth = rep->bandwidth;
+
+    g_array_append_val (bitrates, bandwidth);
+  }
+
+  *current_bitrate = active_stream->cur_representation ?
+      active_stream->cur_representation->bandwidth : 0;
+
+  return TRUE;
+}
+
 static gboolean
 gst_dash_demux_stream_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate)
@@ -2396,15 +2604,28 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
   GstDashDemux *dashdemux = GST_DASH_DEMUX_CAST (demux);
   GstMpdClient *new_client = NULL;
   GstMapInfo mapinfo;
+  gchar *checksum = NULL;
 
   GST_DEBUG_OBJECT (demux, "Updating manifest file from URL");
 
+  gst_buffer_map (buffer, &mapinfo, GST_MAP_READ);
+
+  if (dashdemux->incremental_updates) {
+    checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, mapinfo.data,
+        mapinfo.size);
+    if (g_strcmp0 (checksum, dashdemux->manifest_checksum) == 0) {
+      GST_DEBUG_OBJECT (demux, "Manifest did not change");
+      g_free (checksum);
+      gst_buffer_unmap (buffer, &mapinfo);
+      return GST_FLOW_OK;
+    }
+  }
+
   /* parse the manifest file */
   new_client = gst_mpd_client_new ();
   gst_mpd_client_set_uri_downloader (new_client, demux->downloader);
   new_client->mpd_uri = g_strdup (demux->manifest_uri);
   new_client->mpd_base_uri = g_strdup (demux->manifest_base_uri);
-  gst_buffer_map (buffer, &mapinfo, GST_MAP_READ);
 
   if (gst_mpd_parse (new_client, (gchar *) mapinfo.data, mapinfo.size)) {
     const gchar *period_id;
@@ -2413,6 +2634,19 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     GList *streams_iter;
     GList *streams;
 
+    /* only new SegmentTimeline entries? Keep the current model and streams */
+    if (dashdemux->incremental_updates &&
+        gst_mpd_client_merge_update (dashdemux->client, new_client)) {
+      GST_DEBUG_OBJECT (demux, "Merged manifest update");
+      gst_mpd_client_free (new_client);
+      gst_buffer_unmap (buffer, &mapinfo);
+      g_free (dashdemux->manifest_checksum);
+      dashdemux->manifest_checksum = checksum;
+      if (dashdemux->clock_drift)
+        gst_dash_demux_poll_clock_drift (dashdemux);
+      return GST_FLOW_OK;
+    }
+
     /* prepare the new manifest and try to transfer the stream position
      * status from the old manifest client  */
 
@@ -2432,6 +2666,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
         GST_DEBUG_OBJECT (demux, "Error setting up the updated manifest file");
         gst_mpd_client_free (new_client);
         gst_buffer_unmap (buffer, &mapinfo);
+        g_free (checksum);
         return GST_FLOW_EOS;
       }
     } else {
@@ -2439,6 +2674,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
         GST_DEBUG_OBJECT (demux, "Error setting up the updated manifest file");
         gst_mpd_client_free (new_client);
         gst_buffer_unmap (buffer, &mapinfo);
+        g_free (checksum);
         return GST_FLOW_EOS;
       }
     }
@@ -2447,6 +2683,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
       GST_ERROR_OBJECT (demux, "Failed to setup streams on manifest " "update");
       gst_mpd_client_free (new_client);
       gst_buffer_unmap (buffer, &mapinfo);
+      g_free (checksum);
       return GST_FLOW_ERROR;
     }
 
@@ -2474,6 +2711,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
             demux_stream->index);
         gst_mpd_client_free (new_client);
         gst_buffer_unmap (buffer, &mapinfo);
+        g_free (checksum);
         return GST_FLOW_EOS;
       }
 
@@ -2502,6 +2740,8 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
 
     gst_mpd_client_free (dashdemux->client);
     dashdemux->client = new_client;
+    g_free (dashdemux->manifest_checksum);
+    dashdemux->manifest_checksum = checksum;
 
     GST_DEBUG_OBJECT (demux, "Manifest file successfully updated");
     if (dashdemux->clock_drift) {
@@ -2514,6 +2754,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     GST_WARNING_OBJECT (demux, "Error parsing the manifest.");
     gst_mpd_client_free (new_client);
     gst_buffer_unmap (buffer, &mapinfo);
+    g_free (checksum);
     return GST_FLOW_ERROR;
   }
 
@@ -2548,6 +2789,20 @@ gst_dash_demux_stream_get_fragment_waiting_time (GstAdaptiveDemuxStream *
         segmentAvailability);
     gst_date_time_unref (segmentAvailability);
     gst_date_time_unref (cur_time);
+
+    /* In low-latency mode the segment can be requested availabilityTimeOffset
+     * before it is complete, the server then sends its chunks (e.g. CMAF
+     * chunks with chunked transfer encoding) as they are produced */
+    if (dashdemux->low_latency) {
+      GstClockTime offset =
+          gst_mpd_client_get_availability_time_offset (dashdemux->client,
+          active_stream, NULL);
+
+      if (!GST_CLOCK_TIME_IS_VALID (offset))
+        return 0;
+      diff -= offset;
+    }
+
     /* subtract the server's clock drift, so that if the server's
        time is behind our idea of UTC, we need to sleep for longer
        before requesting a fragment */
@@ -2940,6 +3195,7 @@ gst_dash_demux_parse_isobmff (GstAdaptiveDemux * demux,
 
             if (dash_stream->sidx_position == GST_CLOCK_TIME_NONE) {
               SIDX (dash_stream)->entry_index = 0;
+              dash_stream->sidx_group_first = -1;
             } else {
               if (gst_dash_demux_stream_sidx_seek (dash_stream,
                       demux->segment.rate >= 0, GST_SEEK_FLAG_SNAP_BEFORE,
@@ -70,6 +70,9 @@ struct _GstDashDemuxStream
   GstSidxParser sidx_parser;
   GstClockTime sidx_position;
   gint64 sidx_base_offset;
+  /* in reverse playback, first of the sidx entries downloaded together with
+   * the current one, or -1 */
+  gint sidx_group_first;
   gboolean allow_sidx;
   GstClockTime pending_seek_ts;
 
@@ -139,6 +142,11 @@ struct _GstDashDemux
   gint max_video_width, max_video_height;
   gint max_video_framerate_n, max_video_framerate_d;
   gchar* default_presentation_delay; /* presentation time delay if MPD@suggestedPresentationDelay is not present */
+  gboolean low_latency;       /* request segments early, at availabilityTimeOffset */
+  GstClockTime target_latency; /* latency to the live edge kept in low-latency mode */
+  gboolean incremental_updates; /* merge live manifest refreshes into the current model */
+
+  gchar *manifest_checksum;   /* of the last applied manifest update */
 
   gint n_audio_streams;
   gint n_video_streams;
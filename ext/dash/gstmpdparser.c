@@ -25,6 +25,7 @@
  */
 
 #include <string.h>
+#include <math.h>
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 #include "gstmpdparser.h"
@@ -1441,6 +1442,7 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
   guint intval;
   guint64 int64val;
   gboolean boolval;
+  gdouble doubleval;
   GstRange *rangeval;
 
   gst_mpdparser_free_seg_base_type_ext (*pointer);
@@ -1449,6 +1451,8 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
   /* Initialize values that have defaults */
   seg_base_type->indexRangeExact = FALSE;
   seg_base_type->timescale = 1;
+  seg_base_type->availabilityTimeOffset = 0;
+  seg_base_type->availabilityTimeComplete = TRUE;
 
   /* Inherit attribute values from parent */
   if (parent) {
@@ -1456,6 +1460,8 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
     seg_base_type->presentationTimeOffset = parent->presentationTimeOffset;
     seg_base_type->indexRange = gst_mpdparser_clone_range (parent->indexRange);
     seg_base_type->indexRangeExact = parent->indexRangeExact;
+    seg_base_type->availabilityTimeOffset = parent->availabilityTimeOffset;
+    seg_base_type->availabilityTimeComplete = parent->availabilityTimeComplete;
     seg_base_type->Initialization =
         gst_mpdparser_clone_URL (parent->Initialization);
     seg_base_type->RepresentationIndex =
@@ -1483,6 +1489,15 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
           FALSE, &boolval)) {
     seg_base_type->indexRangeExact = boolval;
   }
+  /* availabilityTimeOffset may be "INF", which sscanf handles for us */
+  if (gst_mpdparser_get_xml_prop_double (a_node, "availabilityTimeOffset",
+          &doubleval) && doubleval >= 0) {
+    seg_base_type->availabilityTimeOffset = doubleval;
+  }
+  if (gst_mpdparser_get_xml_prop_boolean (a_node, "availabilityTimeComplete",
+          TRUE, &boolval)) {
+    seg_base_type->availabilityTimeComplete = boolval;
+  }
 
   /* explore children nodes */
   for (cur_node = a_node->children; cur_node; cur_node = cur_node->next) {
@@ -3826,6 +3841,378 @@ gst_mpd_parse (GstMpdClient * client, const gchar * data, gint size)
   return ret;
 }
 
+/* Incremental manifest updates
+ *
+ * A live MPD refresh usually only appends S entries to the SegmentTimelines
+ * and drops the ones that left the timeShiftBuffer. Instead of rebuilding
+ * all streams from the freshly parsed model, the new entries can then be
+ * merged into the existing model and the segment lists of the active
+ * streams, which keeps everything else (and the stream positions) as is. */
+
+static gboolean
+gst_mpdparser_timeline_has_open_repeat (GstSegmentTimelineNode * timeline)
+{
+  GList *list;
+
+  if (timeline == NULL)
+    return FALSE;
+
+  for (list = g_queue_peek_head_link (&timeline->S); list; list = list->next) {
+    if (((GstSNode *) list->data)->r < 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static gboolean
+gst_mpdparser_templates_compatible (GstSegmentTemplateNode * a,
+    GstSegmentTemplateNode * b)
+{
+  GstMultSegmentBaseType *ma, *mb;
+
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  if (g_strcmp0 (a->media, b->media) != 0 ||
+      g_strcmp0 (a->initialization, b->initialization) != 0 ||
+      g_strcmp0 (a->index, b->index) != 0)
+    return FALSE;
+
+  ma = a->MultSegBaseType;
+  mb = b->MultSegBaseType;
+  if (ma == NULL || mb == NULL)
+    return ma == mb;
+
+  if (ma->duration != mb->duration || ma->startNumber != mb->startNumber)
+    return FALSE;
+  if ((ma->SegBaseType == NULL) != (mb->SegBaseType == NULL))
+    return FALSE;
+  if (ma->SegBaseType && (ma->SegBaseType->timescale !=
+          mb->SegBaseType->timescale
+          || ma->SegBaseType->presentationTimeOffset !=
+          mb->SegBaseType->presentationTimeOffset))
+    return FALSE;
+
+  if ((ma->SegmentTimeline == NULL) != (mb->SegmentTimeline == NULL))
+    return FALSE;
+
+  /* open ended repeats can't be merged entry by entry */
+  return !gst_mpdparser_timeline_has_open_repeat (ma->SegmentTimeline) &&
+      !gst_mpdparser_timeline_has_open_repeat (mb->SegmentTimeline);
+}
+
+static gboolean
+gst_mpdparser_periods_compatible (GstPeriodNode * a, GstPeriodNode * b)
+{
+  GList *la, *lb, *ra, *rb;
+
+  if (g_strcmp0 (a->id, b->id) != 0 || a->start != b->start
+      || a->duration != b->duration)
+    return FALSE;
+
+  /* SegmentList based live streams would need their SegmentURLs merged too */
+  if (a->SegmentList || b->SegmentList)
+    return FALSE;
+  if (!gst_mpdparser_templates_compatible (a->SegmentTemplate,
+          b->SegmentTemplate))
+    return FALSE;
+
+  for (la = a->AdaptationSets, lb = b->AdaptationSets; la && lb;
+      la = la->next, lb = lb->next) {
+    GstAdaptationSetNode *asa = la->data, *asb = lb->data;
+
+    if (asa->id != asb->id || asa->SegmentList || asb->SegmentList)
+      return FALSE;
+    if (!gst_mpdparser_templates_compatible (asa->SegmentTemplate,
+            asb->SegmentTemplate))
+      return FALSE;
+
+    for (ra = asa->Representations, rb = asb->Representations; ra && rb;
+        ra = ra->next, rb = rb->next) {
+      GstRepresentationNode *repa = ra->data, *repb = rb->data;
+
+      if (g_strcmp0 (repa->id, repb->id) != 0
+          || repa->bandwidth != repb->bandwidth
+          || repa->SegmentList || repb->SegmentList)
+        return FALSE;
+      if (!gst_mpdparser_templates_compatible (repa->SegmentTemplate,
+              repb->SegmentTemplate))
+        return FALSE;
+    }
+    if (ra || rb)
+      return FALSE;
+  }
+
+  return la == NULL && lb == NULL;
+}
+
+/* Merges the S entries of @update into @timeline: entries that expired from
+ * @update are dropped from the head, new ones are appended (or extend the
+ * repeat count of the last entry). Works in timescale units. */
+static void
+gst_mpdparser_merge_segment_timeline (GstSegmentTimelineNode * timeline,
+    GstSegmentTimelineNode * update)
+{
+  GList *list;
+  guint64 first_start = 0, start = 0, end = 0;
+  gboolean have_first = FALSE;
+  GstSNode *last;
+
+  /* drop what expired: everything that ends before the first new entry */
+  if (!g_queue_is_empty (&update->S))
+    first_start = ((GstSNode *) g_queue_peek_head (&update->S))->t;
+
+  start = 0;
+  while (first_start > 0 && (last = g_queue_peek_head (&timeline->S))) {
+    guint64 s_end;
+
+    if (last->t > 0)
+      start = last->t;
+    s_end = start + last->d * (last->r + 1);
+    if (s_end > first_start) {
+      if (start < first_start && last->d > 0 && last->r > 0) {
+        guint skip = MIN ((first_start - start) / last->d, last->r);
+
+        start += skip * last->d;
+        last->r -= skip;
+      }
+      /* the new head might have relied on its predecessors for its start */
+      last->t = start;
+      break;
+    }
+    start = s_end;
+    gst_mpdparser_free_s_node (g_queue_pop_head (&timeline->S));
+  }
+
+  /* find where the current timeline ends */
+  start = 0;
+  for (list = g_queue_peek_head_link (&timeline->S); list; list = list->next) {
+    GstSNode *S = list->data;
+
+    if (S->t > 0)
+      start = S->t;
+    end = start + S->d * (S->r + 1);
+    start = end;
+  }
+  last = g_queue_peek_tail (&timeline->S);
+
+  /* and append what comes after */
+  start = 0;
+  for (list = g_queue_peek_head_link (&update->S); list; list = list->next) {
+    GstSNode *S = list->data;
+    guint64 s_end;
+    guint skip = 0;
+
+    if (S->t > 0)
+      start = S->t;
+    s_end = start + S->d * (S->r + 1);
+
+    if (s_end <= end || S->d == 0) {
+      start = s_end;
+      continue;
+    }
+
+    if (start < end)
+      skip = MIN ((end - start + S->d - 1) / S->d, S->r);
+
+    if (last && !have_first && last->d == S->d && start + skip * S->d == end) {
+      last->r += S->r + 1 - skip;
+    } else {
+      GstSNode *node = g_slice_new0 (GstSNode);
+
+      node->t = start + skip * S->d;
+      node->d = S->d;
+      node->r = S->r - skip;
+      g_queue_push_tail (&timeline->S, node);
+      last = node;
+    }
+    have_first = TRUE;
+    end = s_end;
+    start = s_end;
+  }
+}
+
+static void
+gst_mpdparser_merge_segment_template (GstSegmentTemplateNode * tmpl,
+    GstSegmentTemplateNode * update)
+{
+  if (tmpl && tmpl->MultSegBaseType && tmpl->MultSegBaseType->SegmentTimeline)
+    gst_mpdparser_merge_segment_timeline (tmpl->MultSegBaseType->
+        SegmentTimeline, update->MultSegBaseType->SegmentTimeline);
+}
+
+/* Brings the GstMediaSegment list of @stream in line with its (merged)
+ * SegmentTimeline, adjusting the current segment index accordingly */
+static void
+gst_mpd_client_stream_merge_segments (GstActiveStream * stream)
+{
+  GstMultSegmentBaseType *mult_seg;
+  GstMediaSegment *last;
+  GstSNode *head;
+  GList *list;
+  guint64 start, end;
+  guint timescale, n_expired = 0;
+
+  if (stream->segments == NULL || stream->cur_seg_template == NULL)
+    return;
+  mult_seg = stream->cur_seg_template->MultSegBaseType;
+  if (mult_seg == NULL || mult_seg->SegmentTimeline == NULL
+      || mult_seg->SegBaseType == NULL)
+    return;
+  timescale = mult_seg->SegBaseType->timescale;
+
+  /* drop the segments that left the timeline */
+  head = g_queue_peek_head (&mult_seg->SegmentTimeline->S);
+  if (head) {
+    while (n_expired < stream->segments->len) {
+      GstMediaSegment *segment =
+          g_ptr_array_index (stream->segments, n_expired);
+
+      if (segment->scale_start + segment->scale_duration *
+          (segment->repeat + 1) > head->t)
+        break;
+      n_expired++;
+    }
+  }
+  if (n_expired > 0) {
+    g_ptr_array_remove_range (stream->segments, 0, n_expired);
+    if (stream->segment_index >= n_expired) {
+      stream->segment_index -= n_expired;
+    } else {
+      stream->segment_index = 0;
+      stream->segment_repeat_index = 0;
+    }
+  }
+
+  if (stream->segments->len == 0)
+    return;
+
+  /* and append the new ones */
+  last = g_ptr_array_index (stream->segments, stream->segments->len - 1);
+  end = last->scale_start + last->scale_duration * (last->repeat + 1);
+
+  start = 0;
+  for (list = g_queue_peek_head_link (&mult_seg->SegmentTimeline->S); list;
+      list = list->next) {
+    GstSNode *S = list->data;
+    guint64 s_end;
+    guint skip = 0;
+
+    if (S->t > 0)
+      start = S->t;
+    s_end = start + S->d * (S->r + 1);
+    if (s_end <= end || S->d == 0) {
+      start = s_end;
+      continue;
+    }
+
+    if (start < end)
+      skip = MIN ((end - start + S->d - 1) / S->d, S->r);
+    start += skip * S->d;
+
+    if (last->scale_duration == S->d && start == end) {
+      last->repeat += S->r + 1 - skip;
+    } else {
+      GstClockTime start_time, duration;
+
+      duration = gst_util_uint64_scale (S->d, GST_SECOND, timescale);
+      if (start == end)
+        start_time = last->start + last->duration * (last->repeat + 1);
+      else
+        start_time = gst_util_uint64_scale (start, GST_SECOND, timescale);
+
+      gst_mpd_client_add_media_segment (stream, NULL,
+          last->number + last->repeat + 1, S->r - skip, start, S->d,
+          start_time, duration);
+      last = g_ptr_array_index (stream->segments, stream->segments->len - 1);
+    }
+    end = s_end;
+    start = s_end;
+  }
+}
+
+/**
+ * gst_mpd_client_merge_update:
+ * @client: the #GstMpdClient currently in use
+ * @update: a #GstMpdClient holding the freshly parsed manifest
+ *
+ * Tries to apply a manifest refresh to @client in place: if the MPD type,
+ * the Periods, AdaptationSets and Representations did not change, the new
+ * SegmentTimeline entries of @update are merged into the model of @client
+ * and into the segment lists of its active streams.
+ *
+ * Returns: %TRUE if @update was merged, %FALSE if the structure changed and
+ * the caller has to set up the streams from @update instead.
+ */
+gboolean
+gst_mpd_client_merge_update (GstMpdClient * client, GstMpdClient * update)
+{
+  GstMPDNode *mpd, *new_mpd;
+  GList *pa, *pb, *la, *lb, *ra, *rb;
+
+  g_return_val_if_fail (client != NULL, FALSE);
+  g_return_val_if_fail (update != NULL, FALSE);
+
+  mpd = client->mpd_node;
+  new_mpd = update->mpd_node;
+  if (mpd == NULL || new_mpd == NULL || mpd->type != GST_MPD_FILE_TYPE_DYNAMIC
+      || new_mpd->type != mpd->type
+      || new_mpd->mediaPresentationDuration != mpd->mediaPresentationDuration)
+    return FALSE;
+
+  if ((mpd->availabilityStartTime == NULL) !=
+      (new_mpd->availabilityStartTime == NULL))
+    return FALSE;
+  if (mpd->availabilityStartTime &&
+      gst_mpd_client_calculate_time_difference (mpd->availabilityStartTime,
+          new_mpd->availabilityStartTime) != 0)
+    return FALSE;
+
+  for (pa = mpd->Periods, pb = new_mpd->Periods; pa && pb;
+      pa = pa->next, pb = pb->next) {
+    if (!gst_mpdparser_periods_compatible (pa->data, pb->data))
+      return FALSE;
+  }
+  if (pa || pb)
+    return FALSE;
+
+  GST_DEBUG ("Merging manifest update into the current model");
+
+  mpd->minimumUpdatePeriod = new_mpd->minimumUpdatePeriod;
+  mpd->timeShiftBufferDepth = new_mpd->timeShiftBufferDepth;
+  mpd->suggestedPresentationDelay = new_mpd->suggestedPresentationDelay;
+  mpd->maxSegmentDuration = new_mpd->maxSegmentDuration;
+
+  for (pa = mpd->Periods, pb = new_mpd->Periods; pa && pb;
+      pa = pa->next, pb = pb->next) {
+    GstPeriodNode *period = pa->data, *new_period = pb->data;
+
+    gst_mpdparser_merge_segment_template (period->SegmentTemplate,
+        new_period->SegmentTemplate);
+
+    for (la = period->AdaptationSets, lb = new_period->AdaptationSets;
+        la && lb; la = la->next, lb = lb->next) {
+      GstAdaptationSetNode *as = la->data, *new_as = lb->data;
+
+      gst_mpdparser_merge_segment_template (as->SegmentTemplate,
+          new_as->SegmentTemplate);
+
+      for (ra = as->Representations, rb = new_as->Representations; ra && rb;
+          ra = ra->next, rb = rb->next) {
+        GstRepresentationNode *rep = ra->data, *new_rep = rb->data;
+
+        gst_mpdparser_merge_segment_template (rep->SegmentTemplate,
+            new_rep->SegmentTemplate);
+      }
+    }
+  }
+
+  for (la = client->active_streams; la; la = la->next)
+    gst_mpd_client_stream_merge_segments (la->data);
+
+  return TRUE;
+}
+
 const gchar *
 gst_mpdparser_get_baseURL (GstMpdClient * client, guint indexStream)
 {
@@ -3860,6 +4247,31 @@ gst_mpdparser_get_segment_end_time (GstMpdClient * client, GPtrArray * segments,
   return end;
 }
 
+/* Returns the index of the first segment ending after @ts (at or after @ts
+ * if @inclusive), or the number of segments if there is none. The segments
+ * are sorted by time, so a binary search is enough even for long DVR
+ * windows. */
+static guint
+gst_mpdparser_find_segment_index (GstMpdClient * client, GPtrArray * segments,
+    GstClockTime ts, gboolean inclusive)
+{
+  guint lo = 0, hi = segments->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GstMediaSegment *segment = g_ptr_array_index (segments, mid);
+    GstClockTime end =
+        gst_mpdparser_get_segment_end_time (client, segments, segment, mid);
+
+    if (inclusive ? ts <= end : ts < end)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return lo;
+}
+
 static gboolean
 gst_mpd_client_add_media_segment (GstActiveStream * stream,
     GstSegmentURLNode * url_node, guint number, gint repeat,
@@ -4102,6 +4514,23 @@ gst_mpd_client_setup_representation (GstMpdClient * client,
             start_time = gst_util_uint64_scale (S->t, GST_SECOND, timescale);
           }
 
+          /* keep the list in run-length form: contiguous entries of the
+           * same duration only extend the repeat count of the previous one */
+          if (stream->segments->len > 0 && S->r >= 0) {
+            GstMediaSegment *prev = g_ptr_array_index (stream->segments,
+                stream->segments->len - 1);
+
+            if (prev->repeat >= 0 && prev->scale_duration == S->d &&
+                prev->scale_start + prev->scale_duration * (prev->repeat + 1)
+                == start) {
+              prev->repeat += S->r + 1;
+              i += S->r + 1;
+              start += S->d * (S->r + 1);
+              start_time += duration * (S->r + 1);
+              continue;
+            }
+          }
+
           if (!gst_mpd_client_add_media_segment (stream, NULL, i, S->r, start,
                   S->d, start_time, duration)) {
             return FALSE;
@@ -4781,67 +5210,54 @@ gst_mpd_client_stream_seek (GstMpdClient * client, GstActiveStream * stream,
   g_return_val_if_fail (stream != NULL, 0);
 
   if (stream->segments) {
-    for (index = 0; index < stream->segments->len; index++) {
-      gboolean in_segment = FALSE;
-      GstMediaSegment *segment = g_ptr_array_index (stream->segments, index);
-      GstClockTime end_time;
-
-      GST_DEBUG ("Looking at fragment sequence chunk %d / %d", index,
-          stream->segments->len);
-
-      end_time =
-          gst_mpdparser_get_segment_end_time (client, stream->segments,
-          segment, index);
+    /* avoid downloading another fragment just for 1ns in reverse mode */
+    index = gst_mpdparser_find_segment_index (client, stream->segments, ts,
+        !forward);
+    GST_DEBUG ("Found fragment sequence chunk %d / %d", index,
+        stream->segments->len);
 
-      /* avoid downloading another fragment just for 1ns in reverse mode */
-      if (forward)
-        in_segment = ts < end_time;
-      else
-        in_segment = ts <= end_time;
-
-      if (in_segment) {
-        GstClockTime chunk_time;
+    if (index < stream->segments->len) {
+      GstMediaSegment *segment = g_ptr_array_index (stream->segments, index);
+      GstClockTime chunk_time;
 
-        selectedChunk = segment;
-        repeat_index = (ts - segment->start) / segment->duration;
+      selectedChunk = segment;
+      repeat_index = (ts - segment->start) / segment->duration;
 
-        chunk_time = segment->start + segment->duration * repeat_index;
+      chunk_time = segment->start + segment->duration * repeat_index;
 
-        /* At the end of a segment in reverse mode, start from the previous fragment */
-        if (!forward && repeat_index > 0
-            && ((ts - segment->start) % segment->duration == 0))
-          repeat_index--;
+      /* At the end of a segment in reverse mode, start from the previous fragment */
+      if (!forward && repeat_index > 0
+          && ((ts - segment->start) % segment->duration == 0))
+        repeat_index--;
 
-        if ((flags & GST_SEEK_FLAG_SNAP_NEAREST) == GST_SEEK_FLAG_SNAP_NEAREST) {
-          if (repeat_index + 1 < segment->repeat) {
-            if (ts - chunk_time > chunk_time + segment->duration - ts)
-              repeat_index++;
-          } else if (index + 1 < stream->segments->len) {
-            GstMediaSegment *next_segment =
-                g_ptr_array_index (stream->segments, index + 1);
+      if ((flags & GST_SEEK_FLAG_SNAP_NEAREST) == GST_SEEK_FLAG_SNAP_NEAREST) {
+        if (repeat_index + 1 < segment->repeat) {
+          if (ts - chunk_time > chunk_time + segment->duration - ts)
+            repeat_index++;
+        } else if (index + 1 < stream->segments->len) {
+          GstMediaSegment *next_segment =
+              g_ptr_array_index (stream->segments, index + 1);
 
-            if (ts - chunk_time > next_segment->start - ts) {
-              repeat_index = 0;
-              selectedChunk = next_segment;
-              index++;
-            }
+          if (ts - chunk_time > next_segment->start - ts) {
+            repeat_index = 0;
+            selectedChunk = next_segment;
+            index++;
           }
-        } else if (((forward && flags & GST_SEEK_FLAG_SNAP_AFTER) ||
-                (!forward && flags & GST_SEEK_FLAG_SNAP_BEFORE)) &&
-            ts != chunk_time) {
+        }
+      } else if (((forward && flags & GST_SEEK_FLAG_SNAP_AFTER) ||
+              (!forward && flags & GST_SEEK_FLAG_SNAP_BEFORE)) &&
+          ts != chunk_time) {
 
-          if (repeat_index + 1 < segment->repeat) {
-            repeat_index++;
+        if (repeat_index + 1 < segment->repeat) {
+          repeat_index++;
+        } else {
+          repeat_index = 0;
+          if (index + 1 >= stream->segments->len) {
+            selectedChunk = NULL;
           } else {
-            repeat_index = 0;
-            if (index + 1 >= stream->segments->len) {
-              selectedChunk = NULL;
-            } else {
-              selectedChunk = g_ptr_array_index (stream->segments, ++index);
-            }
+            selectedChunk = g_ptr_array_index (stream->segments, ++index);
           }
         }
-        break;
       }
     }
 
@@ -6003,6 +6419,38 @@ gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client,
   return rv;
 }
 
+/* Returns the SegmentBase@availabilityTimeOffset that applies to the active
+ * representation of @stream, GST_CLOCK_TIME_NONE if segments are available
+ * as soon as the first chunk is produced (offset "INF"). If @complete is
+ * given it will be set to the matching availabilityTimeComplete. */
+GstClockTime
+gst_mpd_client_get_availability_time_offset (GstMpdClient * client,
+    GstActiveStream * stream, gboolean * complete)
+{
+  GstSegmentBaseType *base = NULL;
+
+  g_return_val_if_fail (client != NULL, 0);
+  g_return_val_if_fail (stream != NULL, 0);
+
+  if (stream->cur_seg_template && stream->cur_seg_template->MultSegBaseType)
+    base = stream->cur_seg_template->MultSegBaseType->SegBaseType;
+  else if (stream->cur_segment_list && stream->cur_segment_list->MultSegBaseType)
+    base = stream->cur_segment_list->MultSegBaseType->SegBaseType;
+  else
+    base = stream->cur_segment_base;
+
+  if (complete)
+    *complete = base ? base->availabilityTimeComplete : TRUE;
+
+  if (base == NULL || base->availabilityTimeOffset <= 0)
+    return 0;
+
+  if (isinf (base->availabilityTimeOffset))
+    return GST_CLOCK_TIME_NONE;
+
+  return (GstClockTime) (base->availabilityTimeOffset * GST_SECOND);
+}
+
 gboolean
 gst_mpd_client_seek_to_time (GstMpdClient * client, GDateTime * time)
 {
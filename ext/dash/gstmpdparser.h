@@ -169,6 +169,8 @@ struct _GstSegmentBaseType
   guint64 presentationTimeOffset;
   GstRange *indexRange;
   gboolean indexRangeExact;
+  gdouble availabilityTimeOffset;  /* in seconds, may be INF */
+  gboolean availabilityTimeComplete;
   /* Initialization node */
   GstURLType *Initialization;
   /* RepresentationIndex node */
@@ -532,6 +534,7 @@ void gst_mpd_client_set_uri_downloader (GstMpdClient * client, GstUriDownloader
 
 /* MPD file parsing */
 gboolean gst_mpd_parse (GstMpdClient *client, const gchar *data, gint size);
+gboolean gst_mpd_client_merge_update (GstMpdClient * client, GstMpdClient * update);
 
 /* Streaming management */
 gboolean gst_mpd_client_setup_media_presentation (GstMpdClient *client, GstClockTime time, gint period_index, const gchar *period_id);
@@ -582,6 +585,7 @@ gboolean gst_mpd_client_has_next_segment (GstMpdClient * client, GstActiveStream
 GstFlowReturn gst_mpd_client_advance_segment (GstMpdClient * client, GstActiveStream * stream, gboolean forward);
 void gst_mpd_client_seek_to_first_segment (GstMpdClient * client);
 GstDateTime *gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client, GstActiveStream * stream);
+GstClockTime gst_mpd_client_get_availability_time_offset (GstMpdClient * client, GstActiveStream * stream, gboolean * complete);
 
 /* Get audio/video stream parameters (caps, width, height, rate, number of channels) */
 GstCaps * gst_mpd_client_get_stream_caps (GstActiveStream * stream);
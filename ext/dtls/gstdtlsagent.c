@@ -39,6 +39,8 @@
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 
+#include <string.h>
+
 GST_DEBUG_CATEGORY_STATIC (gst_dtls_agent_debug);
 #define GST_CAT_DEFAULT gst_dtls_agent_debug
 
@@ -55,11 +57,17 @@ enum
 
 static GParamSpec *properties[NUM_PROPERTIES];
 
+/* Sessions are kept for this many connection ids at most */
+#define MAX_CLIENT_SESSIONS 1024
+
 struct _GstDtlsAgentPrivate
 {
   SSL_CTX *ssl_context;
 
   GstDtlsCertificate *certificate;
+
+  GMutex session_lock;
+  GHashTable *client_sessions;
 };
 
 static void gst_dtls_agent_finalize (GObject * gobject);
@@ -174,6 +182,10 @@ gst_dtls_agent_init (GstDtlsAgent * self)
   GstDtlsAgentPrivate *priv = GST_DTLS_AGENT_GET_PRIVATE (self);
   self->priv = priv;
 
+  g_mutex_init (&priv->session_lock);
+  priv->client_sessions = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) SSL_SESSION_free);
+
   ERR_clear_error ();
 
 #if OPENSSL_VERSION_NUMBER >= 0x1000200fL
@@ -200,6 +212,13 @@ gst_dtls_agent_init (GstDtlsAgent * self)
 #if OPENSSL_VERSION_NUMBER >= 0x1000200fL
   SSL_CTX_set_ecdh_auto (priv->ssl_context, 1);
 #endif
+
+  /* Let peers that connect again resume their session, with a session id
+   * or a ticket, instead of doing a full handshake. The server cache needs
+   * a session id context as peers are verified */
+  SSL_CTX_set_session_cache_mode (priv->ssl_context, SSL_SESS_CACHE_SERVER);
+  SSL_CTX_set_session_id_context (priv->ssl_context,
+      (const guchar *) "gstdtls", strlen ("gstdtls"));
 }
 
 static void
@@ -207,6 +226,10 @@ gst_dtls_agent_finalize (GObject * gobject)
 {
   GstDtlsAgentPrivate *priv = GST_DTLS_AGENT (gobject)->priv;
 
+  g_hash_table_unref (priv->client_sessions);
+  priv->client_sessions = NULL;
+  g_mutex_clear (&priv->session_lock);
+
   SSL_CTX_free (priv->ssl_context);
   priv->ssl_context = NULL;
 
@@ -282,3 +305,55 @@ _gst_dtls_agent_peek_context (GstDtlsAgent * self)
   g_return_val_if_fail (GST_IS_DTLS_AGENT (self), NULL);
   return self->priv->ssl_context;
 }
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+static int
+SSL_SESSION_up_ref (SSL_SESSION * session)
+{
+  CRYPTO_add (&session->references, 1, CRYPTO_LOCK_SSL_SESSION);
+  return 1;
+}
+#endif
+
+void
+_gst_dtls_agent_store_session (GstDtlsAgent * self, const gchar * id,
+    gpointer session)
+{
+  GstDtlsAgentPrivate *priv;
+
+  g_return_if_fail (GST_IS_DTLS_AGENT (self));
+  g_return_if_fail (id);
+
+  priv = self->priv;
+
+  if (!session)
+    return;
+
+  g_mutex_lock (&priv->session_lock);
+  if (g_hash_table_size (priv->client_sessions) >= MAX_CLIENT_SESSIONS)
+    g_hash_table_remove_all (priv->client_sessions);
+
+  SSL_SESSION_up_ref (session);
+  g_hash_table_replace (priv->client_sessions, g_strdup (id), session);
+  g_mutex_unlock (&priv->session_lock);
+}
+
+gpointer
+_gst_dtls_agent_get_session (GstDtlsAgent * self, const gchar * id)
+{
+  GstDtlsAgentPrivate *priv;
+  SSL_SESSION *session;
+
+  g_return_val_if_fail (GST_IS_DTLS_AGENT (self), NULL);
+  g_return_val_if_fail (id, NULL);
+
+  priv = self->priv;
+
+  g_mutex_lock (&priv->session_lock);
+  session = g_hash_table_lookup (priv->client_sessions, id);
+  if (session)
+    SSL_SESSION_up_ref (session);
+  g_mutex_unlock (&priv->session_lock);
+
+  return session;
+}
@@ -77,6 +77,14 @@ gchar *gst_dtls_agent_get_certificate_pem(GstDtlsAgent *self);
 void _gst_dtls_init_openssl(void);
 const GstDtlsAgentContext _gst_dtls_agent_peek_context(GstDtlsAgent *);
 
+/*
+ * Client sessions of the agent, by connection id, to resume a connection
+ * that is started again with the same id. store takes its own reference to
+ * the SSL_SESSION, get returns a new reference or NULL.
+ */
+void _gst_dtls_agent_store_session(GstDtlsAgent *, const gchar *id, gpointer session);
+gpointer _gst_dtls_agent_get_session(GstDtlsAgent *, const gchar *id);
+
 G_END_DECLS
 
 #endif /* gstdtlsagent_h */
@@ -69,6 +69,7 @@ enum
 {
   PROP_0,
   PROP_AGENT,
+  PROP_CONNECTION_ID,
   NUM_PROPERTIES
 };
 
@@ -79,11 +80,27 @@ static int connection_ex_index;
 static GstClock *system_clock;
 static void handle_timeout (gpointer data, gpointer user_data);
 
+/* Handshake packets of all connections are processed by this pool, so that
+ * the key exchanges and signatures do not run on the streaming threads and
+ * many handshakes at once are spread over the available cores */
+static GThreadPool *handshake_pool;
+static void handle_handshake (gpointer data, gpointer user_data);
+
+typedef struct
+{
+  GstDtlsConnection *connection;
+  gpointer data;
+  gint len;
+} HandshakePacket;
+
 struct _GstDtlsConnectionPrivate
 {
   SSL *ssl;
   BIO *bio;
 
+  GstDtlsAgent *agent;
+  gchar *id;
+
   gboolean is_client;
   gboolean is_alive;
   gboolean keys_exported;
@@ -107,6 +124,9 @@ static void gst_dtls_connection_set_property (GObject *, guint prop_id,
 static void log_state (GstDtlsConnection *, const gchar * str);
 static void export_srtp_keys (GstDtlsConnection *);
 static void openssl_poll (GstDtlsConnection *);
+static void queue_handshake_packet (GstDtlsConnection *, gconstpointer data,
+    gint len);
+static gboolean verify_resumed_session (GstDtlsConnection *);
 static int openssl_verify_callback (int preverify_ok,
     X509_STORE_CTX * x509_ctx);
 
@@ -154,6 +174,12 @@ gst_dtls_connection_class_init (GstDtlsConnectionClass * klass)
       GST_TYPE_DTLS_AGENT,
       G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
 
+  properties[PROP_CONNECTION_ID] =
+      g_param_spec_string ("connection-id",
+      "Connection id",
+      "Id used to resume the session when the connection is made again",
+      NULL, G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 
   _gst_dtls_init_openssl ();
@@ -161,6 +187,10 @@ gst_dtls_connection_class_init (GstDtlsConnectionClass * klass)
   gobject_class->finalize = gst_dtls_connection_finalize;
 
   system_clock = gst_system_clock_obtain ();
+
+  handshake_pool = g_thread_pool_new (handle_handshake, NULL,
+      g_get_num_processors (), FALSE, NULL);
+  g_assert (handshake_pool);
 }
 
 static void
@@ -205,6 +235,10 @@ gst_dtls_connection_finalize (GObject * gobject)
   SSL_free (priv->ssl);
   priv->ssl = NULL;
 
+  g_clear_object (&priv->agent);
+  g_free (priv->id);
+  priv->id = NULL;
+
   if (priv->send_closure) {
     g_closure_unref (priv->send_closure);
     priv->send_closure = NULL;
@@ -266,6 +300,7 @@ gst_dtls_connection_set_property (GObject * object, guint prop_id,
       g_return_if_fail (GST_IS_DTLS_AGENT (agent));
 
       ssl_context = _gst_dtls_agent_peek_context (agent);
+      priv->agent = g_object_ref (agent);
 
       priv->ssl = SSL_new (ssl_context);
       g_return_if_fail (priv->ssl);
@@ -283,6 +318,10 @@ gst_dtls_connection_set_property (GObject * object, guint prop_id,
 
       log_state (self, "connection created");
       break;
+    case PROP_CONNECTION_ID:
+      g_free (priv->id);
+      priv->id = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
   }
@@ -311,20 +350,76 @@ gst_dtls_connection_start (GstDtlsConnection * self, gboolean is_client)
 
   priv->is_client = is_client;
   if (priv->is_client) {
+    SSL_SESSION *session = NULL;
+
+    if (priv->id)
+      session = _gst_dtls_agent_get_session (priv->agent, priv->id);
+    if (session) {
+      GST_DEBUG_OBJECT (self, "trying to resume the previous session");
+      SSL_set_session (priv->ssl, session);
+      SSL_SESSION_free (session);
+    }
+
     SSL_set_connect_state (priv->ssl);
   } else {
     SSL_set_accept_state (priv->ssl);
   }
   log_state (self, "initial state set");
 
-  openssl_poll (self);
-
-  log_state (self, "first poll done");
+  /* The first poll is done by the handshake pool too */
+  queue_handshake_packet (self, NULL, 0);
 
   GST_TRACE_OBJECT (self, "unlocking @ start");
   g_mutex_unlock (&priv->mutex);
 }
 
+/* Called with the connection lock held, @data is copied if set */
+static void
+queue_handshake_packet (GstDtlsConnection * self, gconstpointer data, gint len)
+{
+  HandshakePacket *packet = g_slice_new (HandshakePacket);
+
+  packet->connection = g_object_ref (self);
+  packet->data = data ? g_memdup (data, len) : NULL;
+  packet->len = len;
+
+  g_thread_pool_push (handshake_pool, packet, NULL);
+}
+
+static void
+handle_handshake (gpointer data, gpointer user_data)
+{
+  HandshakePacket *packet = data;
+  GstDtlsConnection *self = packet->connection;
+  GstDtlsConnectionPrivate *priv = self->priv;
+  gint result;
+
+  g_mutex_lock (&priv->mutex);
+  if (priv->is_alive) {
+    if (packet->data) {
+      priv->bio_buffer = packet->data;
+      priv->bio_buffer_len = packet->len;
+      priv->bio_buffer_offset = 0;
+
+      result = SSL_read (priv->ssl, packet->data, packet->len);
+      if (result > 0)
+        GST_WARNING_OBJECT (self, "dropping %d bytes of data received "
+            "with the handshake", result);
+
+      priv->bio_buffer = NULL;
+    }
+
+    log_state (self, "handshake packet before poll");
+    openssl_poll (self);
+    log_state (self, "handshake packet after poll");
+  }
+  g_mutex_unlock (&priv->mutex);
+
+  g_free (packet->data);
+  g_object_unref (self);
+  g_slice_free (HandshakePacket, packet);
+}
+
 static void
 handle_timeout (gpointer data, gpointer user_data)
 {
@@ -532,6 +627,17 @@ gst_dtls_connection_process (GstDtlsConnection * self, gpointer data, gint len)
 
   log_state (self, "process start");
 
+  if (!SSL_is_init_finished (priv->ssl)) {
+    GST_DEBUG_OBJECT (self, "queueing handshake packet of %d bytes", len);
+    queue_handshake_packet (self, data, len);
+    priv->bio_buffer = NULL;
+
+    GST_TRACE_OBJECT (self, "unlocking @ process");
+    g_mutex_unlock (&priv->mutex);
+
+    return 0;
+  }
+
   if (SSL_want_write (priv->ssl)) {
     openssl_poll (self);
     log_state (self, "process want write, after poll");
@@ -709,6 +815,31 @@ beach:
   self->priv->keys_exported = TRUE;
 }
 
+/* The certificate of a resumed session is not verified again by OpenSSL, so
+ * the application gets to check it again here */
+static gboolean
+verify_resumed_session (GstDtlsConnection * self)
+{
+  X509 *cert;
+  gchar *pem;
+  gboolean accepted = FALSE;
+
+  cert = SSL_get_peer_certificate (self->priv->ssl);
+  if (!cert)
+    return FALSE;
+
+  pem = _gst_dtls_x509_to_pem (cert);
+  X509_free (cert);
+
+  if (pem) {
+    g_signal_emit (self, signals[SIGNAL_ON_PEER_CERTIFICATE], 0, pem,
+        &accepted);
+    g_free (pem);
+  }
+
+  return accepted;
+}
+
 static void
 openssl_poll (GstDtlsConnection * self)
 {
@@ -724,6 +855,22 @@ openssl_poll (GstDtlsConnection * self)
 
   if (ret == 1) {
     if (!self->priv->keys_exported) {
+      if (SSL_session_reused (self->priv->ssl)) {
+        if (!verify_resumed_session (self)) {
+          GST_WARNING_OBJECT (self, "peer of the resumed session rejected");
+          self->priv->keys_exported = TRUE;
+          self->priv->is_alive = FALSE;
+          return;
+        }
+        GST_INFO_OBJECT (self, "resumed the previous session");
+      } else if (self->priv->is_client && self->priv->id) {
+        SSL_SESSION *session = SSL_get1_session (self->priv->ssl);
+
+        _gst_dtls_agent_store_session (self->priv->agent, self->priv->id,
+            session);
+        SSL_SESSION_free (session);
+      }
+
       GST_INFO_OBJECT (self,
           "handshake just completed successfully, exporting keys");
       export_srtp_keys (self);
@@ -109,6 +109,7 @@ void gst_dtls_connection_set_send_callback(GstDtlsConnection *, GClosure *);
 /*
  * Processes data that has been recevied, the transformation is done in-place.
  * Returns the length of the plaintext data that was decoded, if no data is available, 0<= will be returned.
+ * Until the handshake is completed the data is copied and handled by a worker thread, and 0 is returned.
  */
 gint gst_dtls_connection_process(GstDtlsConnection *, gpointer ptr, gint len);
 
@@ -722,7 +722,8 @@ create_connection (GstDtlsDec * self, gchar * id)
   }
 
   self->connection =
-      g_object_new (GST_TYPE_DTLS_CONNECTION, "agent", self->agent, NULL);
+      g_object_new (GST_TYPE_DTLS_CONNECTION, "agent", self->agent,
+      "connection-id", id, NULL);
 
   g_object_weak_ref (G_OBJECT (self->connection),
       (GWeakNotify) connection_weak_ref_notify, g_strdup (id));
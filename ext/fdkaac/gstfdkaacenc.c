@@ -29,7 +29,7 @@
 
 /* TODO:
  * - Add support for other AOT / profiles
- * - Expose more properties, e.g. afterburner and vbr
+ * - Expose more properties, e.g. vbr
  * - Signal encoder delay
  * - LOAS / LATM support
  */
@@ -37,10 +37,14 @@
 enum
 {
   PROP_0,
-  PROP_BITRATE
+  PROP_BITRATE,
+  PROP_AFTERBURNER,
+  PROP_FRAMES_PER_BUFFER
 };
 
 #define DEFAULT_BITRATE (0)
+#define DEFAULT_AFTERBURNER (FALSE)
+#define DEFAULT_FRAMES_PER_BUFFER (1)
 
 #define SAMPLE_RATES " 8000, " \
                     "11025, " \
@@ -152,6 +156,7 @@ static GstFlowReturn gst_fdkaacenc_handle_frame (GstAudioEncoder * enc,
     GstBuffer * in_buf);
 static GstCaps *gst_fdkaacenc_get_caps (GstAudioEncoder * enc,
     GstCaps * filter);
+static void gst_fdkaacenc_clear_pool (GstFdkAacEnc * self);
 
 G_DEFINE_TYPE (GstFdkAacEnc, gst_fdkaacenc, GST_TYPE_AUDIO_ENCODER);
 
@@ -163,7 +168,19 @@ gst_fdkaacenc_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_BITRATE:
+      GST_OBJECT_LOCK (self);
       self->bitrate = g_value_get_int (value);
+      self->params_changed = TRUE;
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_AFTERBURNER:
+      GST_OBJECT_LOCK (self);
+      self->afterburner = g_value_get_boolean (value);
+      self->params_changed = TRUE;
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_FRAMES_PER_BUFFER:
+      self->frames_per_buffer = g_value_get_uint (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -182,6 +199,12 @@ gst_fdkaacenc_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE:
       g_value_set_int (value, self->bitrate);
       break;
+    case PROP_AFTERBURNER:
+      g_value_set_boolean (value, self->afterburner);
+      break;
+    case PROP_FRAMES_PER_BUFFER:
+      g_value_set_uint (value, self->frames_per_buffer);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -209,6 +232,139 @@ gst_fdkaacenc_stop (GstAudioEncoder * enc)
   if (self->enc)
     aacEncClose (&self->enc);
 
+  gst_fdkaacenc_clear_pool (self);
+
+  return TRUE;
+}
+
+static GstBufferPool *
+gst_fdkaacenc_create_pool (GstFdkAacEnc * self, guint size)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+
+  if (!gst_buffer_pool_set_config (pool, config) ||
+      !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (self, "failed to set up buffer pool of size %u", size);
+    gst_object_unref (pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+static void
+gst_fdkaacenc_clear_pool (GstFdkAacEnc * self)
+{
+  if (self->pool) {
+    gst_buffer_pool_set_active (self->pool, FALSE);
+    gst_object_unref (self->pool);
+    self->pool = NULL;
+  }
+}
+
+/* Output buffers come from a pool of maxOutBufBytes sized buffers, so that
+ * encoding does not allocate memory per frame */
+static GstBuffer *
+gst_fdkaacenc_acquire_buffer (GstFdkAacEnc * self)
+{
+  GstBuffer *buf = NULL;
+
+  if (self->pool
+      && gst_buffer_pool_acquire_buffer (self->pool, &buf, NULL) == GST_FLOW_OK)
+    return buf;
+
+  return gst_audio_encoder_allocate_output_buffer (GST_AUDIO_ENCODER (self),
+      self->outbuf_size);
+}
+
+/* See
+ * http://wiki.hydrogenaud.io/index.php?title=Fraunhofer_FDK_AAC#Recommended_Sampling_Rate_and_Bitrate_Combinations
+ */
+static gint
+gst_fdkaacenc_get_default_bitrate (GstAudioInfo * info)
+{
+  gint bitrate;
+
+  if (GST_AUDIO_INFO_CHANNELS (info) == 1) {
+    if (GST_AUDIO_INFO_RATE (info) < 16000) {
+      bitrate = 8000;
+    } else if (GST_AUDIO_INFO_RATE (info) == 16000) {
+      bitrate = 16000;
+    } else if (GST_AUDIO_INFO_RATE (info) < 32000) {
+      bitrate = 24000;
+    } else if (GST_AUDIO_INFO_RATE (info) == 32000) {
+      bitrate = 32000;
+    } else if (GST_AUDIO_INFO_RATE (info) <= 44100) {
+      bitrate = 56000;
+    } else {
+      bitrate = 160000;
+    }
+  } else if (GST_AUDIO_INFO_CHANNELS (info) == 2) {
+    if (GST_AUDIO_INFO_RATE (info) < 16000) {
+      bitrate = 16000;
+    } else if (GST_AUDIO_INFO_RATE (info) == 16000) {
+      bitrate = 24000;
+    } else if (GST_AUDIO_INFO_RATE (info) < 22050) {
+      bitrate = 32000;
+    } else if (GST_AUDIO_INFO_RATE (info) < 32000) {
+      bitrate = 40000;
+    } else if (GST_AUDIO_INFO_RATE (info) == 32000) {
+      bitrate = 96000;
+    } else if (GST_AUDIO_INFO_RATE (info) <= 44100) {
+      bitrate = 112000;
+    } else {
+      bitrate = 320000;
+    }
+  } else {
+    /* 5, 5.1 */
+    if (GST_AUDIO_INFO_RATE (info) < 32000) {
+      bitrate = 160000;
+    } else if (GST_AUDIO_INFO_RATE (info) <= 44100) {
+      bitrate = 240000;
+    } else {
+      bitrate = 320000;
+    }
+  }
+
+  return bitrate;
+}
+
+/* Bitrate and afterburner can be changed while encoding, the encoder picks
+ * up new values on the next aacEncEncode() call without being reopened */
+static gboolean
+gst_fdkaacenc_set_live_params (GstFdkAacEnc * self, GstAudioInfo * info)
+{
+  AACENC_ERROR err;
+  gint bitrate;
+  gboolean afterburner;
+
+  GST_OBJECT_LOCK (self);
+  bitrate = self->bitrate;
+  afterburner = self->afterburner;
+  self->params_changed = FALSE;
+  GST_OBJECT_UNLOCK (self);
+
+  if (bitrate == 0)
+    bitrate = gst_fdkaacenc_get_default_bitrate (info);
+
+  if ((err = aacEncoder_SetParam (self->enc, AACENC_BITRATE,
+              bitrate)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to set bitrate %d: %d", bitrate, err);
+    return FALSE;
+  }
+
+  if ((err = aacEncoder_SetParam (self->enc, AACENC_AFTERBURNER,
+              afterburner ? 1 : 0)) != AACENC_OK) {
+    GST_ERROR_OBJECT (self, "Unable to set afterburner %d: %d", afterburner,
+        err);
+    return FALSE;
+  }
+
   return TRUE;
 }
 
@@ -258,7 +414,6 @@ gst_fdkaacenc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
   gint mpegversion = 4;
   CHANNEL_MODE channel_mode;
   AACENC_InfoStruct enc_info = { 0 };
-  gint bitrate;
 
   if (self->enc) {
     /* drain */
@@ -362,64 +517,14 @@ gst_fdkaacenc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
     return FALSE;
   }
 
-  bitrate = self->bitrate;
-  /* See
-   * http://wiki.hydrogenaud.io/index.php?title=Fraunhofer_FDK_AAC#Recommended_Sampling_Rate_and_Bitrate_Combinations
-   */
-  if (bitrate == 0) {
-    if (GST_AUDIO_INFO_CHANNELS (info) == 1) {
-      if (GST_AUDIO_INFO_RATE (info) < 16000) {
-        bitrate = 8000;
-      } else if (GST_AUDIO_INFO_RATE (info) == 16000) {
-        bitrate = 16000;
-      } else if (GST_AUDIO_INFO_RATE (info) < 32000) {
-        bitrate = 24000;
-      } else if (GST_AUDIO_INFO_RATE (info) == 32000) {
-        bitrate = 32000;
-      } else if (GST_AUDIO_INFO_RATE (info) <= 44100) {
-        bitrate = 56000;
-      } else {
-        bitrate = 160000;
-      }
-    } else if (GST_AUDIO_INFO_CHANNELS (info) == 2) {
-      if (GST_AUDIO_INFO_RATE (info) < 16000) {
-        bitrate = 16000;
-      } else if (GST_AUDIO_INFO_RATE (info) == 16000) {
-        bitrate = 24000;
-      } else if (GST_AUDIO_INFO_RATE (info) < 22050) {
-        bitrate = 32000;
-      } else if (GST_AUDIO_INFO_RATE (info) < 32000) {
-        bitrate = 40000;
-      } else if (GST_AUDIO_INFO_RATE (info) == 32000) {
-        bitrate = 96000;
-      } else if (GST_AUDIO_INFO_RATE (info) <= 44100) {
-        bitrate = 112000;
-      } else {
-        bitrate = 320000;
-      }
-    } else {
-      /* 5, 5.1 */
-      if (GST_AUDIO_INFO_RATE (info) < 32000) {
-        bitrate = 160000;
-      } else if (GST_AUDIO_INFO_RATE (info) <= 44100) {
-        bitrate = 240000;
-      } else {
-        bitrate = 320000;
-      }
-    }
-  }
-
   if ((err = aacEncoder_SetParam (self->enc, AACENC_TRANSMUX,
               transmux)) != AACENC_OK) {
     GST_ERROR_OBJECT (self, "Unable to set transmux %d: %d", transmux, err);
     return FALSE;
   }
 
-  if ((err = aacEncoder_SetParam (self->enc, AACENC_BITRATE,
-              bitrate)) != AACENC_OK) {
-    GST_ERROR_OBJECT (self, "Unable to set bitrate %d: %d", bitrate, err);
+  if (!gst_fdkaacenc_set_live_params (self, info))
     return FALSE;
-  }
 
   if ((err = aacEncEncode (self->enc, NULL, NULL, NULL, NULL)) != AACENC_OK) {
     GST_ERROR_OBJECT (self, "Unable to initialize encoder: %d", err);
@@ -431,13 +536,16 @@ gst_fdkaacenc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
     return FALSE;
   }
 
-  gst_audio_encoder_set_frame_max (enc, 1);
+  gst_audio_encoder_set_frame_max (enc, self->frames_per_buffer);
   gst_audio_encoder_set_frame_samples_min (enc, enc_info.frameLength);
   gst_audio_encoder_set_frame_samples_max (enc, enc_info.frameLength);
   gst_audio_encoder_set_hard_min (enc, FALSE);
   self->outbuf_size = enc_info.maxOutBufBytes;
   self->samples_per_frame = enc_info.frameLength;
 
+  gst_fdkaacenc_clear_pool (self);
+  self->pool = gst_fdkaacenc_create_pool (self, self->outbuf_size);
+
   src_caps = gst_caps_new_simple ("audio/mpeg",
       "mpegversion", G_TYPE_INT, mpegversion,
       "channels", G_TYPE_INT, GST_AUDIO_INFO_CHANNELS (info),
@@ -471,6 +579,8 @@ gst_fdkaacenc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
   return ret;
 }
 
+/* All frames of the input buffer are encoded in one call, the base class
+ * hands over up to frames-per-buffer frames at once */
 static GstFlowReturn
 gst_fdkaacenc_handle_frame (GstAudioEncoder * enc, GstBuffer * inbuf)
 {
@@ -478,7 +588,7 @@ gst_fdkaacenc_handle_frame (GstAudioEncoder * enc, GstBuffer * inbuf)
   GstFlowReturn ret = GST_FLOW_OK;
   GstAudioInfo *info;
   GstMapInfo imap, omap;
-  GstBuffer *outbuf;
+  GstBuffer *outbuf = NULL;
   AACENC_BufDesc in_desc = { 0 };
   AACENC_BufDesc out_desc = { 0 };
   AACENC_InArgs in_args = { 0 };
@@ -486,10 +596,15 @@ gst_fdkaacenc_handle_frame (GstAudioEncoder * enc, GstBuffer * inbuf)
   gint in_id = IN_AUDIO_DATA, out_id = OUT_BITSTREAM_DATA;
   gint in_sizes, out_sizes;
   gint in_el_sizes, out_el_sizes;
+  guint8 *in_data = NULL;
   AACENC_ERROR err;
 
   info = gst_audio_encoder_get_audio_info (enc);
 
+  if (G_UNLIKELY (self->params_changed)
+      && !gst_fdkaacenc_set_live_params (self, info))
+    return GST_FLOW_ERROR;
+
   if (!inbuf) {
     in_args.numInSamples = -1;
   } else {
@@ -505,61 +620,66 @@ gst_fdkaacenc_handle_frame (GstAudioEncoder * enc, GstBuffer * inbuf)
 
     in_args.numInSamples = imap.size / GST_AUDIO_INFO_BPS (info);
 
+    in_data = imap.data;
     in_sizes = imap.size;
     in_el_sizes = 2;
     in_desc.bufferIdentifiers = &in_id;
     in_desc.numBufs = 1;
-    in_desc.bufs = (void *) &imap.data;
+    in_desc.bufs = (void *) &in_data;
     in_desc.bufSizes = &in_sizes;
     in_desc.bufElSizes = &in_el_sizes;
   }
 
-  outbuf = gst_audio_encoder_allocate_output_buffer (enc, self->outbuf_size);
-  if (!outbuf) {
-    ret = GST_FLOW_ERROR;
-    goto out;
-  }
+  /* every call consumes input for at most one frame and outputs at most
+   * one frame, but nothing during the encoder delay */
+  do {
+    if (!outbuf) {
+      outbuf = gst_fdkaacenc_acquire_buffer (self);
+      if (!outbuf) {
+        ret = GST_FLOW_ERROR;
+        goto out;
+      }
+    }
 
-  gst_buffer_map (outbuf, &omap, GST_MAP_WRITE);
-  out_sizes = omap.size;
-  out_el_sizes = 1;
-  out_desc.bufferIdentifiers = &out_id;
-  out_desc.numBufs = 1;
-  out_desc.bufs = (void *) &omap.data;
-  out_desc.bufSizes = &out_sizes;
-  out_desc.bufElSizes = &out_el_sizes;
-
-  if ((err = aacEncEncode (self->enc, &in_desc, &out_desc, &in_args,
-              &out_args)) != AACENC_OK) {
-    if (!inbuf && err == AACENC_ENCODE_EOF)
-      goto out;
+    gst_buffer_map (outbuf, &omap, GST_MAP_WRITE);
+    out_sizes = omap.size;
+    out_el_sizes = 1;
+    out_desc.bufferIdentifiers = &out_id;
+    out_desc.numBufs = 1;
+    out_desc.bufs = (void *) &omap.data;
+    out_desc.bufSizes = &out_sizes;
+    out_desc.bufElSizes = &out_el_sizes;
 
-    GST_ERROR_OBJECT (self, "Failed to encode data: %d", err);
-    ret = GST_FLOW_ERROR;
-    goto out;
-  }
+    err = aacEncEncode (self->enc, &in_desc, &out_desc, &in_args, &out_args);
+    gst_buffer_unmap (outbuf, &omap);
 
-  if (inbuf) {
-    gst_buffer_unmap (inbuf, &imap);
-    if (self->need_reorder)
-      gst_buffer_unref (inbuf);
-    inbuf = NULL;
-  }
+    if (err != AACENC_OK) {
+      if (!inbuf && err == AACENC_ENCODE_EOF)
+        goto out;
 
-  if (!out_args.numOutBytes)
-    goto out;
+      GST_ERROR_OBJECT (self, "Failed to encode data: %d", err);
+      ret = GST_FLOW_ERROR;
+      goto out;
+    }
 
-  gst_buffer_unmap (outbuf, &omap);
-  gst_buffer_set_size (outbuf, out_args.numOutBytes);
+    if (inbuf) {
+      in_data += out_args.numInSamples * GST_AUDIO_INFO_BPS (info);
+      in_sizes -= out_args.numInSamples * GST_AUDIO_INFO_BPS (info);
+      in_args.numInSamples -= out_args.numInSamples;
+    }
 
-  ret = gst_audio_encoder_finish_frame (enc, outbuf, self->samples_per_frame);
-  outbuf = NULL;
+    if (out_args.numOutBytes) {
+      gst_buffer_set_size (outbuf, out_args.numOutBytes);
+      ret = gst_audio_encoder_finish_frame (enc, outbuf,
+          self->samples_per_frame);
+      outbuf = NULL;
+    }
+  } while (ret == GST_FLOW_OK && inbuf && in_args.numInSamples > 0
+      && (out_args.numInSamples > 0 || out_args.numOutBytes > 0));
 
 out:
-  if (outbuf) {
-    gst_buffer_unmap (outbuf, &omap);
+  if (outbuf)
     gst_buffer_unref (outbuf);
-  }
   if (inbuf) {
     gst_buffer_unmap (inbuf, &imap);
     if (self->need_reorder)
@@ -573,6 +693,8 @@ static void
 gst_fdkaacenc_init (GstFdkAacEnc * self)
 {
   self->bitrate = DEFAULT_BITRATE;
+  self->afterburner = DEFAULT_AFTERBURNER;
+  self->frames_per_buffer = DEFAULT_FRAMES_PER_BUFFER;
   self->enc = NULL;
 
   gst_audio_encoder_set_drainable (GST_AUDIO_ENCODER (self), TRUE);
@@ -600,7 +722,23 @@ gst_fdkaacenc_class_init (GstFdkAacEncClass * klass)
           "Target Audio Bitrate (0 = fixed value based on "
           " sample rate and channel count)",
           0, G_MAXINT, DEFAULT_BITRATE,
-          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_AFTERBURNER,
+      g_param_spec_boolean ("afterburner", "Afterburner",
+          "Use the afterburner for better quality at a higher CPU cost",
+          DEFAULT_AFTERBURNER,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_FRAMES_PER_BUFFER,
+      g_param_spec_uint ("frames-per-buffer", "Frames per buffer",
+          "Number of AAC frames to encode from one input buffer, higher "
+          "values lower the per frame overhead", 1, 64,
+          DEFAULT_FRAMES_PER_BUFFER,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_static_pad_template (element_class, &sink_template);
   gst_element_class_add_static_pad_template (element_class, &src_template);
@@ -46,6 +46,11 @@ struct _GstFdkAacEnc {
 
   HANDLE_AACENCODER enc;
   gint bitrate;
+  gboolean afterburner;
+  gboolean params_changed;
+  guint frames_per_buffer;
+
+  GstBufferPool *pool;
 
   guint outbuf_size, samples_per_frame;
   gboolean need_reorder;
@@ -58,6 +58,10 @@ struct _GstGLBaseMixerPrivate
   gboolean negotiated;
 
   GstGLContext *other_context;
+
+  /* protected by the object lock outside of the GL thread */
+  GstGLTimer *timer;
+  GstGLContext *timer_context;
 };
 
 G_DEFINE_TYPE (GstGLBaseMixerPad, gst_gl_base_mixer_pad,
@@ -229,7 +233,8 @@ enum
 enum
 {
   PROP_0,
-  PROP_CONTEXT
+  PROP_CONTEXT,
+  PROP_GPU_STATS
 };
 
 static gboolean gst_gl_base_mixer_src_query (GstAggregator * agg,
@@ -248,6 +253,8 @@ static void gst_gl_base_mixer_get_property (GObject * object, guint prop_id,
 
 static gboolean gst_gl_base_mixer_decide_allocation (GstAggregator * agg,
     GstQuery * query);
+static GstFlowReturn gst_gl_base_mixer_aggregate (GstAggregator * agg,
+    gboolean timeout);
 
 static void
 gst_gl_base_mixer_class_init (GstGLBaseMixerClass * klass)
@@ -278,6 +285,7 @@ gst_gl_base_mixer_class_init (GstGLBaseMixerClass * klass)
   agg_class->start = gst_gl_base_mixer_start;
   agg_class->decide_allocation = gst_gl_base_mixer_decide_allocation;
   agg_class->propose_allocation = gst_gl_base_mixer_propose_allocation;
+  agg_class->aggregate = gst_gl_base_mixer_aggregate;
 
   g_object_class_install_property (gobject_class, PROP_CONTEXT,
       g_param_spec_object ("context",
@@ -285,6 +293,12 @@ gst_gl_base_mixer_class_init (GstGLBaseMixerClass * klass)
           "Get OpenGL context",
           GST_TYPE_GL_CONTEXT, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_GPU_STATS,
+      g_param_spec_boxed ("gpu-stats", "GPU statistics",
+          "GPU time statistics of the output buffers, see "
+          "gst_gl_timer_get_stats()", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   /* Register the pad class */
   g_type_class_ref (GST_TYPE_GL_BASE_MIXER_PAD);
 
@@ -370,6 +384,28 @@ gst_gl_base_mixer_src_query (GstAggregator * agg, GstQuery * query)
   return GST_AGGREGATOR_CLASS (parent_class)->src_query (agg, query);
 }
 
+static void
+_create_timer (GstGLContext * context, GstGLBaseMixer * mix)
+{
+  GstGLTimer *timer = gst_gl_timer_new (context);
+
+  GST_OBJECT_LOCK (mix);
+  mix->priv->timer = timer;
+  GST_OBJECT_UNLOCK (mix);
+}
+
+static void
+_free_timer (GstGLContext * context, GstGLBaseMixer * mix)
+{
+  GstGLTimer *timer = mix->priv->timer;
+
+  GST_OBJECT_LOCK (mix);
+  mix->priv->timer = NULL;
+  GST_OBJECT_UNLOCK (mix);
+
+  gst_gl_timer_free (timer);
+}
+
 static gboolean
 gst_gl_base_mixer_decide_allocation (GstAggregator * agg, GstQuery * query)
 {
@@ -378,9 +414,57 @@ gst_gl_base_mixer_decide_allocation (GstAggregator * agg, GstQuery * query)
   if (!_get_gl_context (mix))
     return FALSE;
 
+  if (mix->priv->timer && mix->priv->timer_context != mix->context)
+    gst_gl_context_thread_add (mix->priv->timer_context,
+        (GstGLContextThreadFunc) _free_timer, mix);
+  if (!mix->priv->timer) {
+    gst_object_replace ((GstObject **) & mix->priv->timer_context,
+        (GstObject *) mix->context);
+    gst_gl_context_thread_add (mix->context,
+        (GstGLContextThreadFunc) _create_timer, mix);
+  }
+
   return TRUE;
 }
 
+static void
+_timer_start (GstGLContext * context, GstGLBaseMixer * mix)
+{
+  if (mix->priv->timer)
+    gst_gl_timer_start (mix->priv->timer);
+}
+
+static void
+_timer_end (GstGLContext * context, GstGLBaseMixer * mix)
+{
+  if (mix->priv->timer)
+    gst_gl_timer_end (mix->priv->timer);
+}
+
+/* times all the GL work done by the subclass for one output buffer, the
+ * timer calls are queued in the GL thread without waiting for them */
+static GstFlowReturn
+gst_gl_base_mixer_aggregate (GstAggregator * agg, gboolean timeout)
+{
+  GstGLBaseMixer *mix = GST_GL_BASE_MIXER (agg);
+  GstGLContext *context = mix->priv->timer ? mix->priv->timer_context : NULL;
+  GstFlowReturn ret;
+
+  if (context)
+    gst_gl_context_thread_add_async (context,
+        (GstGLContextThreadFunc) _timer_start, gst_object_ref (mix),
+        gst_object_unref);
+
+  ret = GST_AGGREGATOR_CLASS (parent_class)->aggregate (agg, timeout);
+
+  if (context)
+    gst_gl_context_thread_add_async (context,
+        (GstGLContextThreadFunc) _timer_end, gst_object_ref (mix),
+        gst_object_unref);
+
+  return ret;
+}
+
 static void
 gst_gl_base_mixer_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec)
@@ -391,6 +475,14 @@ gst_gl_base_mixer_get_property (GObject * object,
     case PROP_CONTEXT:
       g_value_set_object (value, mixer->context);
       break;
+    case PROP_GPU_STATS:
+      GST_OBJECT_LOCK (mixer);
+      if (mixer->priv->timer)
+        g_value_take_boxed (value, gst_gl_timer_get_stats (mixer->priv->timer));
+      else
+        g_value_set_boxed (value, NULL);
+      GST_OBJECT_UNLOCK (mixer);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -419,6 +511,11 @@ gst_gl_base_mixer_stop (GstAggregator * agg)
 {
   GstGLBaseMixer *mix = GST_GL_BASE_MIXER (agg);
 
+  if (mix->priv->timer)
+    gst_gl_context_thread_add (mix->priv->timer_context,
+        (GstGLContextThreadFunc) _free_timer, mix);
+  gst_object_replace ((GstObject **) & mix->priv->timer_context, NULL);
+
   if (mix->context) {
     gst_object_unref (mix->context);
     mix->context = NULL;
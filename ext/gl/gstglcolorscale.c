@@ -39,12 +39,32 @@
  * ]| A pipeline to test hardware scaling and colorspace conversion.
  * FBO and GLSL are required.
  *
+ * ## Scaling methods
+ *
+ * The default bilinear method samples the input once per output pixel,
+ * which aliases when downscaling by more than a factor of two. The bicubic
+ * and lanczos methods filter the frame in two separable passes, widening
+ * the kernel with the downscaling ratio so strong downscales, e.g. from 4K
+ * to the lower renditions of an adaptive bitrate ladder, keep their
+ * details without aliasing. The ladder itself is built by teeing the GL
+ * memory into one glcolorscale per rendition, the frame is only uploaded
+ * once.
+ *
+ * |[
+ * gst-launch-1.0 -v videotestsrc ! video/x-raw,width=3840,height=2160 ! \
+ *   glupload ! glcolorscale method=lanczos ! \
+ *   video/x-raw(memory:GLMemory),width=640,height=360 ! glimagesink
+ * ]| A pipeline downscaling with the lanczos kernel.
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#include <math.h>
+
+#include <gst/gl/gstglfuncs.h>
+
 #include "gstglcolorscale.h"
 
 #define GST_CAT_DEFAULT gst_gl_colorscale_debug
@@ -53,9 +73,96 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 /* Properties */
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD
 };
 
+#define DEFAULT_METHOD GST_GL_COLORSCALE_METHOD_BILINEAR
+
+/* bounds the cost of strong downscales, the kernel is narrowed beyond */
+#define MAX_TAPS 64
+
+#define GST_TYPE_GL_COLORSCALE_METHOD (gst_gl_colorscale_method_get_type ())
+static GType
+gst_gl_colorscale_method_get_type (void)
+{
+  static GType method_type = 0;
+  static const GEnumValue methods[] = {
+    {GST_GL_COLORSCALE_METHOD_BILINEAR, "Bilinear", "bilinear"},
+    {GST_GL_COLORSCALE_METHOD_BICUBIC, "Bicubic (Catmull-Rom)", "bicubic"},
+    {GST_GL_COLORSCALE_METHOD_LANCZOS, "Lanczos (3 lobes)", "lanczos"},
+    {0, NULL, NULL}
+  };
+
+  if (!method_type)
+    method_type = g_enum_register_static ("GstGLColorscaleMethod", methods);
+
+  return method_type;
+}
+
+/* One pass of a separable filter along @direction. The taps are placed on
+ * the texel centers around the sampled position, and the kernel is
+ * stretched by the downscaling ratio so every input texel contributes */
+/* *INDENT-OFF* */
+static const gchar *scale_fragment_source =
+    "#ifdef GL_ES\n"
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "#endif\n"
+    "varying vec2 v_texcoord;\n"
+    "uniform sampler2D tex;\n"
+    "uniform vec2 in_size;\n"
+    "uniform vec2 direction;\n"
+    "uniform float stretch;\n"
+    "uniform int radius;\n"
+    "%s"
+    "void main ()\n"
+    "{\n"
+    "  float size = dot (in_size, direction);\n"
+    "  float pos = dot (v_texcoord, direction) * size - 0.5;\n"
+    "  float first = floor (pos) - float (radius) + 1.0;\n"
+    "  vec2 other = v_texcoord * (vec2 (1.0) - direction);\n"
+    "  vec4 sum = vec4 (0.0);\n"
+    "  float weights = 0.0;\n"
+    "  for (int i = 0; i < " G_STRINGIFY (MAX_TAPS) "; i++) {\n"
+    "    if (i >= 2 * radius)\n"
+    "      break;\n"
+    "    float x = first + float (i);\n"
+    "    float w = kernel ((x - pos) / stretch);\n"
+    "    float c = clamp (x, 0.0, size - 1.0);\n"
+    "    sum += w * texture2D (tex, other + direction * (c + 0.5) / size);\n"
+    "    weights += w;\n"
+    "  }\n"
+    "  gl_FragColor = sum / weights;\n"
+    "}\n";
+
+static const gchar *bicubic_kernel =
+    "float kernel (float x)\n"
+    "{\n"
+    "  x = abs (x);\n"
+    "  if (x < 1.0)\n"
+    "    return (1.5 * x - 2.5) * x * x + 1.0;\n"
+    "  if (x < 2.0)\n"
+    "    return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;\n"
+    "  return 0.0;\n"
+    "}\n";
+
+static const gchar *lanczos_kernel =
+    "float kernel (float x)\n"
+    "{\n"
+    "  x = abs (x);\n"
+    "  if (x < 0.00001)\n"
+    "    return 1.0;\n"
+    "  if (x >= 3.0)\n"
+    "    return 0.0;\n"
+    "  float px = 3.14159265 * x;\n"
+    "  return 3.0 * sin (px) * sin (px / 3.0) / (px * px);\n"
+    "}\n";
+/* *INDENT-ON* */
+
 #define DEBUG_INIT \
   GST_DEBUG_CATEGORY_INIT (gst_gl_colorscale_debug, "glcolorscale", 0, "glcolorscale element");
 #define gst_gl_colorscale_parent_class parent_class
@@ -93,6 +200,19 @@ gst_gl_colorscale_class_init (GstGLColorscaleClass * klass)
   gobject_class->set_property = gst_gl_colorscale_set_property;
   gobject_class->get_property = gst_gl_colorscale_get_property;
 
+  /**
+   * GstGLColorscale:method:
+   *
+   * The scaling method. The bicubic and lanczos methods take two passes.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method", "The scaling method",
+          GST_TYPE_GL_COLORSCALE_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_metadata (element_class, "OpenGL color scale",
       "Filter/Effect/Video", "Colorspace converter and video scaler",
       "Julien Isorce <julien.isorce@gmail.com>\n"
@@ -111,13 +231,19 @@ gst_gl_colorscale_class_init (GstGLColorscaleClass * klass)
 static void
 gst_gl_colorscale_init (GstGLColorscale * colorscale)
 {
+  colorscale->method = DEFAULT_METHOD;
 }
 
 static void
 gst_gl_colorscale_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstGLColorscale *colorscale = GST_GL_COLORSCALE (object);
+
   switch (prop_id) {
+    case PROP_METHOD:
+      colorscale->method = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -128,7 +254,12 @@ static void
 gst_gl_colorscale_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstGLColorscale *colorscale = GST_GL_COLORSCALE (object);
+
   switch (prop_id) {
+    case PROP_METHOD:
+      g_value_set_enum (value, colorscale->method);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -143,10 +274,26 @@ gst_gl_colorscale_gl_start (GstGLBaseFilter * base_filter)
   GstGLShader *shader;
   GError *error = NULL;
 
-  if (!(shader = gst_gl_shader_new_default (base_filter->context, &error))) {
+  if (colorscale->method == GST_GL_COLORSCALE_METHOD_BILINEAR) {
+    shader = gst_gl_shader_new_default (base_filter->context, &error);
+  } else {
+    gchar *source = g_strdup_printf (scale_fragment_source,
+        colorscale->method == GST_GL_COLORSCALE_METHOD_BICUBIC ?
+        bicubic_kernel : lanczos_kernel);
+
+    shader = gst_gl_shader_new_link_with_stages (base_filter->context, &error,
+        gst_glsl_stage_new_default_vertex (base_filter->context),
+        gst_glsl_stage_new_with_string (base_filter->context,
+            GL_FRAGMENT_SHADER, GST_GLSL_VERSION_NONE,
+            GST_GLSL_PROFILE_ES | GST_GLSL_PROFILE_COMPATIBILITY, source),
+        NULL);
+    g_free (source);
+  }
+
+  if (!shader) {
     GST_ERROR_OBJECT (colorscale, "Failed to initialize shader: %s",
         error->message);
-    gst_object_unref (shader);
+    g_clear_error (&error);
     return FALSE;
   }
 
@@ -170,18 +317,137 @@ gst_gl_colorscale_gl_stop (GstGLBaseFilter * base_filter)
     colorscale->shader = NULL;
   }
 
+  if (colorscale->midtexture) {
+    gst_memory_unref (GST_MEMORY_CAST (colorscale->midtexture));
+    colorscale->midtexture = NULL;
+  }
+
   return GST_GL_BASE_FILTER_CLASS (parent_class)->gl_stop (base_filter);
 }
 
+struct ScalePass
+{
+  gboolean vertical;
+  gint in_width, in_height;
+  gfloat stretch;
+};
+
+static gboolean
+_scale_pass (GstGLFilter * filter, GstGLMemory * in_tex,
+    struct ScalePass *pass)
+{
+  GstGLColorscale *colorscale = GST_GL_COLORSCALE (filter);
+  const GstGLFuncs *gl = GST_GL_BASE_FILTER (filter)->context->gl_vtable;
+  gfloat support =
+      colorscale->method == GST_GL_COLORSCALE_METHOD_BICUBIC ? 2.0 : 3.0;
+  gint radius = (gint) ceil (support * pass->stretch);
+
+  gst_gl_shader_use (colorscale->shader);
+
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->BindTexture (GL_TEXTURE_2D, gst_gl_memory_get_texture_id (in_tex));
+
+  gst_gl_shader_set_uniform_1i (colorscale->shader, "tex", 1);
+  gst_gl_shader_set_uniform_2f (colorscale->shader, "in_size",
+      pass->in_width, pass->in_height);
+  gst_gl_shader_set_uniform_2f (colorscale->shader, "direction",
+      pass->vertical ? 0.0 : 1.0, pass->vertical ? 1.0 : 0.0);
+  gst_gl_shader_set_uniform_1f (colorscale->shader, "stretch", pass->stretch);
+  gst_gl_shader_set_uniform_1i (colorscale->shader, "radius",
+      MIN (radius, MAX_TAPS / 2));
+
+  gst_gl_filter_draw_fullscreen_quad (filter);
+
+  return TRUE;
+}
+
+/* The horizontal pass goes into a texture with the output width and the
+ * input height, so each pass filters along a single direction */
+static gboolean
+gst_gl_colorscale_filter_separable (GstGLColorscale * colorscale,
+    GstGLMemory * in_tex, GstGLMemory * out_tex)
+{
+  GstGLFilter *filter = GST_GL_FILTER (colorscale);
+  GstGLContext *context = GST_GL_BASE_FILTER (colorscale)->context;
+  gint in_width = GST_VIDEO_INFO_WIDTH (&filter->in_info);
+  gint in_height = GST_VIDEO_INFO_HEIGHT (&filter->in_info);
+  gint out_width = GST_VIDEO_INFO_WIDTH (&filter->out_info);
+  gint out_height = GST_VIDEO_INFO_HEIGHT (&filter->out_info);
+  struct ScalePass pass;
+  GstGLMemory *src = in_tex;
+
+  filter->default_shader = colorscale->shader;
+  filter->valid_attributes = FALSE;
+
+  if (in_width != out_width) {
+    GstGLMemory *dest = out_tex;
+
+    if (in_height != out_height) {
+      if (colorscale->midtexture && (gst_gl_memory_get_texture_width
+              (colorscale->midtexture) != out_width
+              || gst_gl_memory_get_texture_height (colorscale->midtexture) !=
+              in_height)) {
+        gst_memory_unref (GST_MEMORY_CAST (colorscale->midtexture));
+        colorscale->midtexture = NULL;
+      }
+
+      if (!colorscale->midtexture) {
+        GstGLBaseMemoryAllocator *base_alloc;
+        GstGLAllocationParams *params;
+        GstVideoInfo info;
+
+        gst_video_info_set_format (&info, GST_VIDEO_FORMAT_RGBA, out_width,
+            in_height);
+        base_alloc = (GstGLBaseMemoryAllocator *)
+            gst_allocator_find (GST_GL_MEMORY_ALLOCATOR_NAME);
+        params = (GstGLAllocationParams *)
+            gst_gl_video_allocation_params_new (context, NULL, &info, 0, NULL,
+            GST_GL_TEXTURE_TARGET_2D, GST_GL_RGBA);
+        colorscale->midtexture =
+            (GstGLMemory *) gst_gl_base_memory_alloc (base_alloc, params);
+        gst_gl_allocation_params_free (params);
+        gst_object_unref (base_alloc);
+      }
+
+      dest = colorscale->midtexture;
+    }
+
+    pass.vertical = FALSE;
+    pass.in_width = in_width;
+    pass.in_height = in_height;
+    pass.stretch = MAX (1.0, (gfloat) in_width / out_width);
+    gst_gl_filter_render_to_target (filter, src, dest,
+        (GstGLFilterRenderFunc) _scale_pass, &pass);
+    src = dest;
+  }
+
+  /* at the same size, the kernels sample the texels as they are */
+  if (in_height != out_height || src == in_tex) {
+    pass.vertical = TRUE;
+    pass.in_width = out_width;
+    pass.in_height = in_height;
+    pass.stretch = MAX (1.0, (gfloat) in_height / out_height);
+    gst_gl_filter_render_to_target (filter, src, out_tex,
+        (GstGLFilterRenderFunc) _scale_pass, &pass);
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_gl_colorscale_filter_texture (GstGLFilter * filter, GstGLMemory * in_tex,
     GstGLMemory * out_tex)
 {
   GstGLColorscale *colorscale = GST_GL_COLORSCALE (filter);
 
-  if (gst_gl_context_get_gl_api (GST_GL_BASE_FILTER (filter)->context))
-    gst_gl_filter_render_to_target_with_shader (filter, in_tex, out_tex,
-        colorscale->shader);
+  if (!gst_gl_context_get_gl_api (GST_GL_BASE_FILTER (filter)->context))
+    return TRUE;
+
+  if (colorscale->method != GST_GL_COLORSCALE_METHOD_BILINEAR)
+    return gst_gl_colorscale_filter_separable (colorscale, in_tex, out_tex);
+
+  gst_gl_filter_render_to_target_with_shader (filter, in_tex, out_tex,
+      colorscale->shader);
 
   return TRUE;
 }
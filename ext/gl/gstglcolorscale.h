@@ -38,12 +38,21 @@ G_BEGIN_DECLS
 typedef struct _GstGLColorscale GstGLColorscale;
 typedef struct _GstGLColorscaleClass GstGLColorscaleClass;
 
+typedef enum
+{
+    GST_GL_COLORSCALE_METHOD_BILINEAR,
+    GST_GL_COLORSCALE_METHOD_BICUBIC,
+    GST_GL_COLORSCALE_METHOD_LANCZOS
+} GstGLColorscaleMethod;
 
 struct _GstGLColorscale
 {
     GstGLFilter filter;
 
+    GstGLColorscaleMethod method;
     GstGLShader *shader;
+    /* the horizontally scaled frame of the separable methods */
+    GstGLMemory *midtexture;
 };
 
 struct _GstGLColorscaleClass
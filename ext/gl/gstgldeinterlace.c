@@ -24,10 +24,19 @@
  *
  * Deinterlacing using based on fragment shaders.
  *
+ * The field based methods, bob and yadif, can output one frame per field
+ * with the #GstGLDeinterlace:mode property, doubling the framerate. The
+ * yadif method uses the previous frame for its temporal prediction and
+ * does not add any latency.
+ *
  * ## Examples
  * |[
  * gst-launch-1.0 videotestsrc ! glupload ! gldeinterlace ! glimagesink
  * ]|
+ * |[
+ * gst-launch-1.0 filesrc location=interlaced.ts ! decodebin ! glupload ! \
+ *     gldeinterlace method=yadif mode=fields ! glimagesink
+ * ]|
  * FBO (Frame Buffer Object) and GLSL (OpenGL Shading Language) are required.
  *
  */
@@ -46,7 +55,8 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 enum
 {
   PROP_0,
-  PROP_METHOD
+  PROP_METHOD,
+  PROP_MODE
 };
 
 #define DEBUG_INIT \
@@ -71,6 +81,14 @@ static gboolean gst_gl_deinterlace_vfir_callback (GstGLFilter * filter,
     GstGLMemory * in_tex, gpointer stuff);
 static gboolean gst_gl_deinterlace_greedyh_callback (GstGLFilter * filter,
     GstGLMemory * in_tex, gpointer stuff);
+static gboolean gst_gl_deinterlace_bob_callback (GstGLFilter * filter,
+    GstGLMemory * in_tex, gpointer stuff);
+static gboolean gst_gl_deinterlace_yadif_callback (GstGLFilter * filter,
+    GstGLMemory * in_tex, gpointer stuff);
+static GstCaps *gst_gl_deinterlace_transform_internal_caps (GstGLFilter *
+    filter, GstPadDirection direction, GstCaps * caps, GstCaps * filter_caps);
+static GstFlowReturn gst_gl_deinterlace_generate_output (GstBaseTransform *
+    trans, GstBuffer ** outbuf);
 
 /* *INDENT-OFF* */
 static const gchar *greedyh_fragment_source =
@@ -181,13 +199,130 @@ const gchar *vfir_fragment_source =
   "  bot_color = texture2D(tex, botcoord);\n"
   "  gl_FragColor = 0.5*cur_color + 0.25*top_color + 0.25*bot_color;\n"
   "}";
+
+/* keeps the lines of the field of parity @field and interpolates the
+ * others from the lines above and below */
+static const gchar *bob_fragment_source =
+  "#ifdef GL_ES\n"
+  "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+  "precision highp float;\n"
+  "#else\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "#endif\n"
+  "uniform sampler2D tex;\n"
+  "uniform float height;\n"
+  "uniform float field;\n"
+  "varying vec2 v_texcoord;\n"
+  "void main()\n"
+  "{\n"
+  "  float line = floor(v_texcoord.y * height);\n"
+  "  vec2 dy = vec2(0.0, 1.0 / height);\n"
+  "  if (mod(line, 2.0) == field) {\n"
+  "    gl_FragColor = texture2D(tex, v_texcoord);\n"
+  "  } else {\n"
+  "    /* the missing first or last line only has one neighbour */\n"
+  "    vec2 up = line < 1.0 ? v_texcoord + dy : v_texcoord - dy;\n"
+  "    vec2 down = line + 1.0 >= height ? v_texcoord - dy : v_texcoord + dy;\n"
+  "    gl_FragColor = 0.5 * (texture2D(tex, up) + texture2D(tex, down));\n"
+  "  }\n"
+  "}";
+
+/* Yet Another DeInterlacing Filter, after the algorithm of the CPU yadif
+ * element. The lines of the field of parity @field are kept, the others are
+ * predicted spatially along the best of five edge directions and the result
+ * is clamped around the temporal prediction from the neighbouring fields of
+ * the same parity in @tex_prev2 and @tex_next2. The scores are computed on
+ * the luma */
+static const gchar *yadif_fragment_source =
+  "#ifdef GL_ES\n"
+  "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+  "precision highp float;\n"
+  "#else\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "#endif\n"
+  "uniform sampler2D tex;\n"
+  "uniform sampler2D tex_prev;\n"
+  "uniform sampler2D tex_next;\n"
+  "uniform sampler2D tex_prev2;\n"
+  "uniform sampler2D tex_next2;\n"
+  "uniform float width;\n"
+  "uniform float height;\n"
+  "uniform float field;\n"
+  "varying vec2 v_texcoord;\n"
+  "const vec3 luma = vec3 (0.299011, 0.586987, 0.114001);\n"
+  "vec2 dx, dy;\n"
+  "vec4 cur (float x, float y)\n"
+  "{\n"
+  "  return texture2D(tex, v_texcoord + x * dx + y * dy);\n"
+  "}\n"
+  "float score (float j)\n"
+  "{\n"
+  "  return dot(abs(cur(j - 1.0, -1.0).rgb - cur(-j - 1.0, 1.0).rgb)\n"
+  "      + abs(cur(j, -1.0).rgb - cur(-j, 1.0).rgb)\n"
+  "      + abs(cur(j + 1.0, -1.0).rgb - cur(-j + 1.0, 1.0).rgb), luma);\n"
+  "}\n"
+  "void main()\n"
+  "{\n"
+  "  float line = floor(v_texcoord.y * height);\n"
+  "  dx = vec2(1.0 / width, 0.0);\n"
+  "  dy = vec2(0.0, 1.0 / height);\n"
+  "  if (mod(line, 2.0) == field || line < 1.0 || line + 1.0 >= height) {\n"
+  "    gl_FragColor = texture2D(tex, v_texcoord);\n"
+  "    return;\n"
+  "  }\n"
+  "  vec4 c = cur(0.0, -1.0);\n"
+  "  vec4 e = cur(0.0, 1.0);\n"
+  "  vec4 p2 = texture2D(tex_prev2, v_texcoord);\n"
+  "  vec4 n2 = texture2D(tex_next2, v_texcoord);\n"
+  "  vec4 d = 0.5 * (p2 + n2);\n"
+  "  vec4 tdiff0 = abs(p2 - n2);\n"
+  "  vec4 tdiff1 = 0.5 * (abs(texture2D(tex_prev, v_texcoord - dy) - c)\n"
+  "      + abs(texture2D(tex_prev, v_texcoord + dy) - e));\n"
+  "  vec4 tdiff2 = 0.5 * (abs(texture2D(tex_next, v_texcoord - dy) - c)\n"
+  "      + abs(texture2D(tex_next, v_texcoord + dy) - e));\n"
+  "  vec4 diff = max(0.5 * tdiff0, max(tdiff1, tdiff2));\n"
+  "  vec4 spatial_pred = 0.5 * (c + e);\n"
+  "  float spatial_score = score(0.0) - 1.0 / 255.0;\n"
+  "  float s = score(-1.0);\n"
+  "  if (s < spatial_score) {\n"
+  "    spatial_score = s;\n"
+  "    spatial_pred = 0.5 * (cur(-1.0, -1.0) + cur(1.0, 1.0));\n"
+  "    s = score(-2.0);\n"
+  "    if (s < spatial_score) {\n"
+  "      spatial_score = s;\n"
+  "      spatial_pred = 0.5 * (cur(-2.0, -1.0) + cur(2.0, 1.0));\n"
+  "    }\n"
+  "  }\n"
+  "  s = score(1.0);\n"
+  "  if (s < spatial_score) {\n"
+  "    spatial_score = s;\n"
+  "    spatial_pred = 0.5 * (cur(1.0, -1.0) + cur(-1.0, 1.0));\n"
+  "    s = score(2.0);\n"
+  "    if (s < spatial_score)\n"
+  "      spatial_pred = 0.5 * (cur(2.0, -1.0) + cur(-2.0, 1.0));\n"
+  "  }\n"
+  "  if (line >= 2.0 && line + 2.0 < height) {\n"
+  "    vec4 b = 0.5 * (texture2D(tex_prev2, v_texcoord - 2.0 * dy)\n"
+  "        + texture2D(tex_next2, v_texcoord - 2.0 * dy));\n"
+  "    vec4 f = 0.5 * (texture2D(tex_prev2, v_texcoord + 2.0 * dy)\n"
+  "        + texture2D(tex_next2, v_texcoord + 2.0 * dy));\n"
+  "    vec4 dmax = max(max(d - e, d - c), min(b - c, f - e));\n"
+  "    vec4 dmin = min(min(d - e, d - c), max(b - c, f - e));\n"
+  "    diff = max(max(diff, dmin), -dmax);\n"
+  "  }\n"
+  "  gl_FragColor = clamp(spatial_pred, d - diff, d + diff);\n"
+  "}";
 /* *INDENT-ON* */
 
 /* dont' forget to edit the following when a new method is added */
 typedef enum
 {
   GST_GL_DEINTERLACE_VFIR,
-  GST_GL_DEINTERLACE_GREEDYH
+  GST_GL_DEINTERLACE_GREEDYH,
+  GST_GL_DEINTERLACE_BOB,
+  GST_GL_DEINTERLACE_YADIF
 } GstGLDeinterlaceMethod;
 
 static const GEnumValue *
@@ -197,6 +332,8 @@ gst_gl_deinterlace_get_methods (void)
     {GST_GL_DEINTERLACE_VFIR, "Blur Vertical", "vfir"},
     {GST_GL_DEINTERLACE_GREEDYH, "Motion Adaptive: Advanced Detection",
         "greedyh"},
+    {GST_GL_DEINTERLACE_BOB, "Bob: Interpolate the missing lines", "bob"},
+    {GST_GL_DEINTERLACE_YADIF, "Yet Another DeInterlacing Filter", "yadif"},
     {0, NULL, NULL}
   };
   return method_types;
@@ -215,6 +352,43 @@ gst_gl_deinterlace_method_get_type (void)
   return gl_deinterlace_method_type;
 }
 
+typedef enum
+{
+  GST_GL_DEINTERLACE_MODE_FRAMES,
+  GST_GL_DEINTERLACE_MODE_FIELDS
+} GstGLDeinterlaceMode;
+
+#define DEFAULT_MODE GST_GL_DEINTERLACE_MODE_FRAMES
+
+#define GST_TYPE_GL_DEINTERLACE_MODES (gst_gl_deinterlace_mode_get_type ())
+static GType
+gst_gl_deinterlace_mode_get_type (void)
+{
+  static GType gl_deinterlace_mode_type = 0;
+  static const GEnumValue mode_types[] = {
+    {GST_GL_DEINTERLACE_MODE_FRAMES, "Output one frame for each frame",
+        "frames"},
+    {GST_GL_DEINTERLACE_MODE_FIELDS,
+        "Output one frame for each field (field based methods only)", "fields"},
+    {0, NULL, NULL}
+  };
+
+  if (!gl_deinterlace_mode_type) {
+    gl_deinterlace_mode_type =
+        g_enum_register_static ("GstGLDeinterlaceMode", mode_types);
+  }
+  return gl_deinterlace_mode_type;
+}
+
+/* whether each input frame produces one output frame per field */
+static gboolean
+gst_gl_deinterlace_outputs_fields (GstGLDeinterlace * deinterlace)
+{
+  return deinterlace->mode == GST_GL_DEINTERLACE_MODE_FIELDS &&
+      (deinterlace->current_method == GST_GL_DEINTERLACE_BOB ||
+      deinterlace->current_method == GST_GL_DEINTERLACE_YADIF);
+}
+
 static void
 gst_gl_deinterlace_set_method (GstGLDeinterlace * deinterlace,
     guint method_types)
@@ -228,6 +402,14 @@ gst_gl_deinterlace_set_method (GstGLDeinterlace * deinterlace,
       deinterlace->deinterlacefunc = gst_gl_deinterlace_greedyh_callback;
       deinterlace->current_method = method_types;
       break;
+    case GST_GL_DEINTERLACE_BOB:
+      deinterlace->deinterlacefunc = gst_gl_deinterlace_bob_callback;
+      deinterlace->current_method = method_types;
+      break;
+    case GST_GL_DEINTERLACE_YADIF:
+      deinterlace->deinterlacefunc = gst_gl_deinterlace_yadif_callback;
+      deinterlace->current_method = method_types;
+      break;
     default:
       g_assert_not_reached ();
       break;
@@ -261,13 +443,33 @@ gst_gl_deinterlace_class_init (GstGLDeinterlaceClass * klass)
           GST_TYPE_GL_DEINTERLACE_METHODS,
           GST_GL_DEINTERLACE_VFIR, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGLDeinterlace:mode:
+   *
+   * With the bob and yadif methods, output one frame for each field at
+   * twice the input framerate instead of one frame for each frame.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_MODE,
+      g_param_spec_enum ("mode",
+          "Deinterlace Mode",
+          "Whether to output one frame per frame or per field",
+          GST_TYPE_GL_DEINTERLACE_MODES,
+          DEFAULT_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_BASE_TRANSFORM_CLASS (klass)->start = gst_gl_deinterlace_start;
   GST_BASE_TRANSFORM_CLASS (klass)->stop = gst_gl_deinterlace_reset;
+  GST_BASE_TRANSFORM_CLASS (klass)->generate_output =
+      gst_gl_deinterlace_generate_output;
 
   GST_GL_FILTER_CLASS (klass)->filter = gst_gl_deinterlace_filter;
   GST_GL_FILTER_CLASS (klass)->filter_texture =
       gst_gl_deinterlace_filter_texture;
   GST_GL_FILTER_CLASS (klass)->init_fbo = gst_gl_deinterlace_init_fbo;
+  GST_GL_FILTER_CLASS (klass)->transform_internal_caps =
+      gst_gl_deinterlace_transform_internal_caps;
 
   GST_GL_BASE_FILTER_CLASS (klass)->supported_gl_api =
       GST_GL_API_OPENGL | GST_GL_API_GLES2 | GST_GL_API_OPENGL3;
@@ -281,6 +483,9 @@ gst_gl_deinterlace_init (GstGLDeinterlace * filter)
   filter->current_method = GST_GL_DEINTERLACE_VFIR;
   filter->prev_buffer = NULL;
   filter->prev_tex = NULL;
+  filter->mode = DEFAULT_MODE;
+  filter->field_buffer = NULL;
+  filter->field = 0;
 }
 
 static gboolean
@@ -310,6 +515,7 @@ gst_gl_deinterlace_reset (GstBaseTransform * trans)
   GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (trans);
 
   gst_buffer_replace (&deinterlace_filter->prev_buffer, NULL);
+  gst_buffer_replace (&deinterlace_filter->field_buffer, NULL);
 
   //blocking call, wait the opengl thread has destroyed the shader
   if (deinterlace_filter->shaderstable) {
@@ -336,6 +542,11 @@ gst_gl_deinterlace_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_METHOD:
       gst_gl_deinterlace_set_method (filter, g_value_get_enum (value));
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (filter));
+      break;
+    case PROP_MODE:
+      filter->mode = g_value_get_enum (value);
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (filter));
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -353,6 +564,9 @@ gst_gl_deinterlace_get_property (GObject * object, guint prop_id,
     case PROP_METHOD:
       g_value_set_enum (value, filter->current_method);
       break;
+    case PROP_MODE:
+      g_value_set_enum (value, filter->mode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -365,6 +579,120 @@ gst_gl_deinterlace_init_fbo (GstGLFilter * filter)
   return TRUE;
 }
 
+static void
+_scale_framerate (GstCaps * caps, gint num, gint denom)
+{
+  guint i;
+
+  for (i = 0; i < gst_caps_get_size (caps); i++) {
+    GstStructure *s = gst_caps_get_structure (caps, i);
+    const GValue *fps = gst_structure_get_value (s, "framerate");
+    gint fps_n, fps_d;
+
+    /* ranges are left as they are, they are usually open anyway */
+    if (!fps || !GST_VALUE_HOLDS_FRACTION (fps))
+      continue;
+
+    fps_n = gst_value_get_fraction_numerator (fps);
+    fps_d = gst_value_get_fraction_denominator (fps);
+    if (fps_n > 0 && gst_util_fraction_multiply (fps_n, fps_d, num, denom,
+            &fps_n, &fps_d))
+      gst_structure_set (s, "framerate", GST_TYPE_FRACTION, fps_n, fps_d,
+          NULL);
+  }
+}
+
+static GstCaps *
+gst_gl_deinterlace_transform_internal_caps (GstGLFilter * filter,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter_caps)
+{
+  GstGLDeinterlace *deinterlace = GST_GL_DEINTERLACE (filter);
+  GstCaps *result;
+  guint i;
+
+  result = GST_GL_FILTER_CLASS (parent_class)->transform_internal_caps (filter,
+      direction, caps, filter_caps);
+  result = gst_caps_make_writable (result);
+
+  for (i = 0; i < gst_caps_get_size (result); i++) {
+    GstStructure *s = gst_caps_get_structure (result, i);
+
+    if (direction == GST_PAD_SINK)
+      gst_structure_set (s, "interlace-mode", G_TYPE_STRING, "progressive",
+          NULL);
+    else
+      gst_structure_remove_field (s, "interlace-mode");
+  }
+
+  if (gst_gl_deinterlace_outputs_fields (deinterlace)) {
+    if (direction == GST_PAD_SINK)
+      _scale_framerate (result, 2, 1);
+    else
+      _scale_framerate (result, 1, 2);
+  }
+
+  return result;
+}
+
+/* Outputs the frame once per field when needed, by handing the input buffer
+ * to the base class a second time.  The timestamps of the input are split
+ * between the two fields */
+static GstFlowReturn
+gst_gl_deinterlace_generate_output (GstBaseTransform * trans,
+    GstBuffer ** outbuf)
+{
+  GstGLDeinterlace *deinterlace = GST_GL_DEINTERLACE (trans);
+  GstGLFilter *filter = GST_GL_FILTER (trans);
+  gboolean fields = gst_gl_deinterlace_outputs_fields (deinterlace);
+  GstClockTime pts, duration;
+  GstFlowReturn ret;
+
+  if (trans->queued_buf) {
+    deinterlace->field = 0;
+    if (fields)
+      gst_buffer_replace (&deinterlace->field_buffer, trans->queued_buf);
+  } else if (fields && deinterlace->field_buffer) {
+    deinterlace->field = 1;
+    trans->queued_buf = deinterlace->field_buffer;
+    deinterlace->field_buffer = NULL;
+  }
+
+  ret = GST_BASE_TRANSFORM_CLASS (parent_class)->generate_output (trans,
+      outbuf);
+
+  if (ret != GST_FLOW_OK || *outbuf == NULL)
+    return ret;
+
+  GST_BUFFER_FLAG_UNSET (*outbuf, GST_VIDEO_BUFFER_FLAG_INTERLACED |
+      GST_VIDEO_BUFFER_FLAG_TFF | GST_VIDEO_BUFFER_FLAG_RFF |
+      GST_VIDEO_BUFFER_FLAG_ONEFIELD);
+
+  if (!fields)
+    return ret;
+
+  pts = GST_BUFFER_PTS (*outbuf);
+  duration = GST_BUFFER_DURATION (*outbuf);
+  if (!GST_CLOCK_TIME_IS_VALID (duration)
+      && GST_VIDEO_INFO_FPS_N (&filter->in_info) > 0)
+    duration = gst_util_uint64_scale_int (GST_SECOND,
+        GST_VIDEO_INFO_FPS_D (&filter->in_info),
+        GST_VIDEO_INFO_FPS_N (&filter->in_info));
+
+  if (GST_CLOCK_TIME_IS_VALID (duration)) {
+    duration /= 2;
+    GST_BUFFER_DURATION (*outbuf) = duration;
+    if (GST_CLOCK_TIME_IS_VALID (pts) && deinterlace->field == 1)
+      GST_BUFFER_PTS (*outbuf) = pts + duration;
+  }
+  if (deinterlace->field == 1) {
+    GST_BUFFER_DTS (*outbuf) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_OFFSET (*outbuf) = GST_BUFFER_OFFSET_NONE;
+    GST_BUFFER_OFFSET_END (*outbuf) = GST_BUFFER_OFFSET_NONE;
+  }
+
+  return ret;
+}
+
 static gboolean
 gst_gl_deinterlace_filter_texture (GstGLFilter * filter, GstGLMemory * in_tex,
     GstGLMemory * out_tex)
@@ -386,7 +714,10 @@ gst_gl_deinterlace_filter (GstGLFilter * filter, GstBuffer * inbuf,
 
   gst_gl_filter_filter_texture (filter, inbuf, outbuf);
 
-  gst_buffer_replace (&deinterlace_filter->prev_buffer, inbuf);
+  /* the previous frame is still needed for the second field */
+  if (!gst_gl_deinterlace_outputs_fields (deinterlace_filter)
+      || deinterlace_filter->field == 1)
+    gst_buffer_replace (&deinterlace_filter->prev_buffer, inbuf);
 
   return TRUE;
 }
@@ -515,3 +846,130 @@ gst_gl_deinterlace_greedyh_callback (GstGLFilter * filter, GstGLMemory * in_tex,
 
   return TRUE;
 }
+
+/* the field kept from the frame: the first one in time for the first output
+ * and the other one for the second output when outputting fields */
+static gfloat
+gst_gl_deinterlace_get_field (GstGLDeinterlace * deinterlace)
+{
+  GstGLFilter *filter = GST_GL_FILTER (deinterlace);
+  gboolean tff = GST_BUFFER_FLAG_IS_SET (filter->inbuf,
+      GST_VIDEO_BUFFER_FLAG_TFF);
+
+  gfloat first = tff ? 0.0f : 1.0f;
+
+  return deinterlace->field == 0 ? first : 1.0f - first;
+}
+
+static gboolean
+gst_gl_deinterlace_bob_callback (GstGLFilter * filter, GstGLMemory * in_tex,
+    gpointer user_data)
+{
+  GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (filter);
+  GstGLContext *context = GST_GL_BASE_FILTER (filter)->context;
+  const GstGLFuncs *gl = context->gl_vtable;
+  GstGLShader *shader;
+
+  shader = gst_gl_deinterlace_get_fragment_shader (filter, "bob",
+      bob_fragment_source);
+
+  if (!shader)
+    return FALSE;
+
+#if GST_GL_HAVE_OPENGL
+  if (USING_OPENGL (context)) {
+    gl->MatrixMode (GL_PROJECTION);
+    gl->LoadIdentity ();
+  }
+#endif
+
+  gst_gl_shader_use (shader);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, gst_gl_memory_get_texture_id (in_tex));
+
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+  gst_gl_shader_set_uniform_1f (shader, "height",
+      GST_VIDEO_INFO_HEIGHT (&filter->out_info));
+  gst_gl_shader_set_uniform_1f (shader, "field",
+      gst_gl_deinterlace_get_field (deinterlace_filter));
+
+  gst_gl_filter_draw_fullscreen_quad (filter);
+
+  return TRUE;
+}
+
+static gboolean
+gst_gl_deinterlace_yadif_callback (GstGLFilter * filter, GstGLMemory * in_tex,
+    gpointer user_data)
+{
+  GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (filter);
+  GstGLContext *context = GST_GL_BASE_FILTER (filter)->context;
+  const GstGLFuncs *gl = context->gl_vtable;
+  GstGLMemory *prev_tex = in_tex;
+  GstGLShader *shader;
+  gfloat field;
+  guint cur_id, prev_id;
+
+  shader = gst_gl_deinterlace_get_fragment_shader (filter, "yadif",
+      yadif_fragment_source);
+
+  if (!shader)
+    return FALSE;
+
+  if (deinterlace_filter->prev_buffer
+      && deinterlace_filter->prev_buffer != filter->inbuf) {
+    GstMemory *mem = gst_buffer_peek_memory (deinterlace_filter->prev_buffer,
+        0);
+
+    if (gst_is_gl_memory (mem))
+      prev_tex = (GstGLMemory *) mem;
+  }
+
+  cur_id = gst_gl_memory_get_texture_id (in_tex);
+  prev_id = gst_gl_memory_get_texture_id (prev_tex);
+  field = gst_gl_deinterlace_get_field (deinterlace_filter);
+
+#if GST_GL_HAVE_OPENGL
+  if (USING_OPENGL (context)) {
+    gl->MatrixMode (GL_PROJECTION);
+    gl->LoadIdentity ();
+  }
+#endif
+
+  gst_gl_shader_use (shader);
+
+  /* waiting for the next frame would add a frame of latency, the current
+   * frame stands in for it like in the CPU element */
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->BindTexture (GL_TEXTURE_2D, prev_id);
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, cur_id);
+
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+  gst_gl_shader_set_uniform_1i (shader, "tex_prev", 1);
+  gst_gl_shader_set_uniform_1i (shader, "tex_next", 0);
+  /* the missing lines of the first field in time are between the previous
+   * and the current frame, those of the second one are in the current
+   * frame */
+  if (deinterlace_filter->field == 0) {
+    gst_gl_shader_set_uniform_1i (shader, "tex_prev2", 1);
+    gst_gl_shader_set_uniform_1i (shader, "tex_next2", 0);
+  } else {
+    gst_gl_shader_set_uniform_1i (shader, "tex_prev2", 0);
+    gst_gl_shader_set_uniform_1i (shader, "tex_next2", 0);
+  }
+  gst_gl_shader_set_uniform_1f (shader, "width",
+      GST_VIDEO_INFO_WIDTH (&filter->out_info));
+  gst_gl_shader_set_uniform_1f (shader, "height",
+      GST_VIDEO_INFO_HEIGHT (&filter->out_info));
+  gst_gl_shader_set_uniform_1f (shader, "field", field);
+
+  gst_gl_filter_draw_fullscreen_quad (filter);
+
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+  gl->ActiveTexture (GL_TEXTURE0);
+
+  return TRUE;
+}
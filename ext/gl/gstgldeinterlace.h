@@ -47,6 +47,11 @@ struct _GstGLDeinterlace
   GstGLMemory *             prev_tex;
 
   gint	                    current_method;
+  gint                      mode;
+
+  /* frame being output field by field */
+  GstBuffer                *field_buffer;
+  guint                     field;
 };
 
 struct _GstGLDeinterlaceClass
@@ -25,9 +25,31 @@
 #include <gst/gl/gl.h>
 #include "gstgldownloadelement.h"
 
+#if GST_GL_HAVE_DMABUF
+#include <gst/allocators/gstdmabuf.h>
+#include <gst/gl/egl/gsteglimage.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_gl_download_element_debug);
 #define GST_CAT_DEFAULT gst_gl_download_element_debug
 
+#define DEFAULT_ASYNC_DEPTH 0
+#define DEFAULT_EXPORT_DMABUF FALSE
+
+enum
+{
+  PROP_0,
+  PROP_ASYNC_DEPTH,
+  PROP_EXPORT_DMABUF,
+};
+
+#if GST_GL_HAVE_DMABUF
+#define DMABUF_SRC_CAPS "; video/x-raw(" GST_CAPS_FEATURE_MEMORY_DMABUF ")"
+static GQuark _dmabuf_buffer_quark;
+#else
+#define DMABUF_SRC_CAPS ""
+#endif
+
 #define gst_gl_download_element_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GstGLDownloadElement, gst_gl_download_element,
     GST_TYPE_GL_BASE_FILTER,
@@ -45,12 +67,25 @@ gst_gl_download_element_prepare_output_buffer (GstBaseTransform * bt,
     GstBuffer * buffer, GstBuffer ** outbuf);
 static GstFlowReturn gst_gl_download_element_transform (GstBaseTransform * bt,
     GstBuffer * buffer, GstBuffer * outbuf);
+static GstFlowReturn gst_gl_download_element_generate_output (GstBaseTransform *
+    bt, GstBuffer ** outbuf);
+static gboolean gst_gl_download_element_sink_event (GstBaseTransform * bt,
+    GstEvent * event);
+static gboolean gst_gl_download_element_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query);
+static gboolean gst_gl_download_element_stop (GstBaseTransform * bt);
+static void gst_gl_download_element_finalize (GObject * object);
+static void gst_gl_download_element_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_gl_download_element_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
 
 static GstStaticPadTemplate gst_gl_download_element_src_pad_template =
     GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("video/x-raw; video/x-raw(memory:GLMemory)"));
+    GST_STATIC_CAPS ("video/x-raw; video/x-raw(memory:GLMemory)"
+        DMABUF_SRC_CAPS));
 
 static GstStaticPadTemplate gst_gl_download_element_sink_pad_template =
     GST_STATIC_PAD_TEMPLATE ("sink",
@@ -61,18 +96,67 @@ static GstStaticPadTemplate gst_gl_download_element_sink_pad_template =
 static void
 gst_gl_download_element_class_init (GstGLDownloadElementClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstBaseTransformClass *bt_class = GST_BASE_TRANSFORM_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
 
+  gobject_class->finalize = gst_gl_download_element_finalize;
+  gobject_class->set_property = gst_gl_download_element_set_property;
+  gobject_class->get_property = gst_gl_download_element_get_property;
+
   bt_class->transform_caps = gst_gl_download_element_transform_caps;
   bt_class->set_caps = gst_gl_download_element_set_caps;
   bt_class->get_unit_size = gst_gl_download_element_get_unit_size;
   bt_class->prepare_output_buffer =
       gst_gl_download_element_prepare_output_buffer;
   bt_class->transform = gst_gl_download_element_transform;
+  bt_class->generate_output = gst_gl_download_element_generate_output;
+  bt_class->sink_event = gst_gl_download_element_sink_event;
+  bt_class->query = gst_gl_download_element_query;
+  bt_class->stop = gst_gl_download_element_stop;
 
   bt_class->passthrough_on_same_caps = TRUE;
 
+  /**
+   * GstGLDownloadElement:async-depth:
+   *
+   * Number of frames whose download to system memory is kept in flight.
+   * A frame is only pushed once the read back of the frames after it has
+   * been started and its own read back has finished, so mapping it doesn't
+   * stall the GL pipeline. This adds as many frames of latency. With 0 the
+   * frames are pushed right away and downloaded when mapped.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC_DEPTH,
+      g_param_spec_uint ("async-depth", "Async depth",
+          "Number of frames whose download is kept in flight, adding as many "
+          "frames of latency", 0, 16, DEFAULT_ASYNC_DEPTH,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGLDownloadElement:export-dmabuf:
+   *
+   * Offer the textures as dmabufs to downstream, exported through
+   * EGLImages, so encoders and display sinks that import dmabufs get the
+   * frames without a read back into system memory. This needs an EGL context
+   * supporting EGL_MESA_image_dma_buf_export.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_EXPORT_DMABUF,
+      g_param_spec_boolean ("export-dmabuf", "Export DMABuf",
+          "Offer the textures as dmabufs if the GL context can export them",
+          DEFAULT_EXPORT_DMABUF,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+#if GST_GL_HAVE_DMABUF
+  _dmabuf_buffer_quark =
+      g_quark_from_static_string ("GstGLDownloadDMABufBuffer");
+#endif
+
   gst_element_class_add_static_pad_template (element_class,
       &gst_gl_download_element_src_pad_template);
   gst_element_class_add_static_pad_template (element_class,
@@ -88,8 +172,79 @@ gst_gl_download_element_init (GstGLDownloadElement * download)
 {
   gst_base_transform_set_prefer_passthrough (GST_BASE_TRANSFORM (download),
       TRUE);
+
+  download->async_depth = DEFAULT_ASYNC_DEPTH;
+  download->export_dmabuf = DEFAULT_EXPORT_DMABUF;
+  g_queue_init (&download->pending);
+}
+
+static void
+gst_gl_download_element_finalize (GObject * object)
+{
+  GstGLDownloadElement *dl = GST_GL_DOWNLOAD_ELEMENT (object);
+
+  g_queue_foreach (&dl->pending, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&dl->pending);
+
+  if (dl->dmabuf_allocator)
+    gst_object_unref (dl->dmabuf_allocator);
+  dl->dmabuf_allocator = NULL;
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_gl_download_element_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLDownloadElement *dl = GST_GL_DOWNLOAD_ELEMENT (object);
+
+  switch (prop_id) {
+    case PROP_ASYNC_DEPTH:
+      dl->async_depth = g_value_get_uint (value);
+      break;
+    case PROP_EXPORT_DMABUF:
+      dl->export_dmabuf = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
+static void
+gst_gl_download_element_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLDownloadElement *dl = GST_GL_DOWNLOAD_ELEMENT (object);
+
+  switch (prop_id) {
+    case PROP_ASYNC_DEPTH:
+      g_value_set_uint (value, dl->async_depth);
+      break;
+    case PROP_EXPORT_DMABUF:
+      g_value_set_boolean (value, dl->export_dmabuf);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+#if GST_GL_HAVE_DMABUF
+/* Without a context yet, assume it can and check again in set_caps() */
+static gboolean
+_context_can_export_dmabuf (GstGLContext * context)
+{
+  if (!context)
+    return TRUE;
+
+  return gst_gl_context_get_gl_platform (context) == GST_GL_PLATFORM_EGL
+      && gst_gl_context_check_feature (context,
+      "EGL_MESA_image_dma_buf_export");
+}
+#endif
+
 static gboolean
 gst_gl_download_element_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
     GstCaps * out_caps)
@@ -105,6 +260,23 @@ gst_gl_download_element_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
 
   dl->do_pbo_transfers = (!features || gst_caps_features_contains (features,
           GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY));
+  dl->fps_n = GST_VIDEO_INFO_FPS_N (&out_info);
+  dl->fps_d = GST_VIDEO_INFO_FPS_D (&out_info);
+
+#if GST_GL_HAVE_DMABUF
+  dl->do_dmabuf_exports = features && gst_caps_features_contains (features,
+      GST_CAPS_FEATURE_MEMORY_DMABUF);
+  if (dl->do_dmabuf_exports) {
+    if (!_context_can_export_dmabuf (GST_GL_BASE_FILTER (bt)->context)) {
+      GST_WARNING_OBJECT (dl, "GL context cannot export dmabufs");
+      return FALSE;
+    }
+
+    dl->out_info = out_info;
+    if (!dl->dmabuf_allocator)
+      dl->dmabuf_allocator = gst_dmabuf_allocator_new ();
+  }
+#endif
 
   return TRUE;
 }
@@ -133,8 +305,16 @@ gst_gl_download_element_transform_caps (GstBaseTransform * bt,
     tmp = _set_caps_features (caps, GST_CAPS_FEATURE_MEMORY_GL_MEMORY);
     tmp = gst_caps_merge (gst_caps_ref (caps), tmp);
   } else {
-    tmp = _set_caps_features (caps, GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY);
-    tmp = gst_caps_merge (gst_caps_ref (caps), tmp);
+    tmp = gst_caps_ref (caps);
+#if GST_GL_HAVE_DMABUF
+    /* exporting is preferred over reading back */
+    if (GST_GL_DOWNLOAD_ELEMENT (bt)->export_dmabuf
+        && _context_can_export_dmabuf (GST_GL_BASE_FILTER (bt)->context))
+      tmp = gst_caps_merge (tmp, _set_caps_features (caps,
+              GST_CAPS_FEATURE_MEMORY_DMABUF));
+#endif
+    tmp = gst_caps_merge (tmp, _set_caps_features (caps,
+            GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY));
   }
 
   if (filter) {
@@ -163,28 +343,297 @@ gst_gl_download_element_get_unit_size (GstBaseTransform * trans, GstCaps * caps,
   return TRUE;
 }
 
+/* Starts reading back the textures of @buffer into their PBOs */
+static void
+gst_gl_download_element_start_transfer (GstBuffer * buffer)
+{
+  gint i, n;
+
+  n = gst_buffer_n_memory (buffer);
+  for (i = 0; i < n; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+
+    if (gst_is_gl_memory_pbo (mem))
+      gst_gl_memory_pbo_download_transfer ((GstGLMemoryPBO *) mem);
+  }
+}
+
+#if GST_GL_HAVE_DMABUF
+struct DMABufExport
+{
+  GstGLDownloadElement *dl;
+  GstBuffer *inbuf;
+  GstBuffer *outbuf;
+};
+
+/* Wraps each texture of the input buffer into a dmabuf memory exported from
+ * an EGLImage of it. The dmabufs share the storage of the textures, so each
+ * one keeps the input buffer alive. Runs in the GL thread */
+static void
+_export_dmabuf_gl (GstGLContext * context, struct DMABufExport *data)
+{
+  GstVideoInfo *info = &data->dl->out_info;
+  gsize offset[GST_VIDEO_MAX_PLANES];
+  gint stride[GST_VIDEO_MAX_PLANES];
+  GstGLSyncMeta *sync_meta;
+  GstBuffer *buffer;
+  gsize total = 0;
+  guint i, n;
+
+  n = gst_buffer_n_memory (data->inbuf);
+  if (n != GST_VIDEO_INFO_N_PLANES (info))
+    return;
+
+  buffer = gst_buffer_new ();
+  for (i = 0; i < n; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (data->inbuf, i);
+    GstMemory *dmabuf;
+    GstEGLImage *image;
+    gsize fd_offset, size;
+    gint fd;
+
+    if (!gst_is_gl_memory (mem))
+      goto error;
+
+    image = gst_egl_image_from_texture (context, (GstGLMemory *) mem, NULL);
+    if (!image)
+      goto error;
+
+    if (!gst_egl_image_export_dmabuf (image, &fd, &stride[i], &fd_offset)) {
+      gst_egl_image_unref (image);
+      goto error;
+    }
+    /* the dmabuf references the storage on its own */
+    gst_egl_image_unref (image);
+
+    size = (gsize) stride[i] *
+        gst_gl_memory_get_texture_height ((GstGLMemory *) mem);
+    dmabuf = gst_dmabuf_allocator_alloc (data->dl->dmabuf_allocator, fd,
+        fd_offset + size);
+    gst_memory_resize (dmabuf, fd_offset, size);
+    gst_mini_object_set_qdata (GST_MINI_OBJECT (dmabuf), _dmabuf_buffer_quark,
+        gst_buffer_ref (data->inbuf), (GDestroyNotify) gst_buffer_unref);
+    gst_buffer_append_memory (buffer, dmabuf);
+
+    offset[i] = total;
+    total += size;
+  }
+
+  gst_buffer_add_video_meta_full (buffer, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info),
+      GST_VIDEO_INFO_HEIGHT (info), n, offset, stride);
+
+  /* the consumer of the dmabuf cannot wait on GL */
+  sync_meta = gst_buffer_get_gl_sync_meta (data->inbuf);
+  if (sync_meta)
+    gst_gl_sync_meta_wait_cpu (sync_meta, context);
+  else
+    context->gl_vtable->Finish ();
+
+  data->outbuf = buffer;
+  return;
+
+error:
+  gst_buffer_unref (buffer);
+}
+
+static GstBuffer *
+gst_gl_download_element_export_dmabuf (GstGLDownloadElement * dl,
+    GstBuffer * inbuf)
+{
+  GstGLContext *context = GST_GL_BASE_FILTER (dl)->context;
+  struct DMABufExport data = { dl, inbuf, NULL };
+
+  if (!_context_can_export_dmabuf (context))
+    return NULL;
+
+  gst_gl_context_thread_add (context,
+      (GstGLContextThreadFunc) _export_dmabuf_gl, &data);
+  if (data.outbuf)
+    gst_buffer_copy_into (data.outbuf, inbuf,
+        GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+  return data.outbuf;
+}
+#endif
+
 static GstFlowReturn
 gst_gl_download_element_prepare_output_buffer (GstBaseTransform * bt,
     GstBuffer * inbuf, GstBuffer ** outbuf)
 {
   GstGLDownloadElement *dl = GST_GL_DOWNLOAD_ELEMENT (bt);
-  gint i, n;
+
+#if GST_GL_HAVE_DMABUF
+  if (dl->do_dmabuf_exports) {
+    *outbuf = gst_gl_download_element_export_dmabuf (dl, inbuf);
+    if (!*outbuf) {
+      GST_ELEMENT_ERROR (dl, RESOURCE, FAILED,
+          ("Failed to export the GL textures as dmabufs"), (NULL));
+      return GST_FLOW_ERROR;
+    }
+
+    return GST_FLOW_OK;
+  }
+#endif
 
   *outbuf = inbuf;
 
-  if (dl->do_pbo_transfers) {
-    n = gst_buffer_n_memory (*outbuf);
-    for (i = 0; i < n; i++) {
-      GstMemory *mem = gst_buffer_peek_memory (*outbuf, i);
+  if (dl->do_pbo_transfers)
+    gst_gl_download_element_start_transfer (*outbuf);
 
-      if (gst_is_gl_memory_pbo (mem))
-        gst_gl_memory_pbo_download_transfer ((GstGLMemoryPBO *) mem);
-    }
+  return GST_FLOW_OK;
+}
+
+/* Waits for the read back of the oldest pending buffer and returns it */
+static GstBuffer *
+gst_gl_download_element_pop_pending (GstGLDownloadElement * dl)
+{
+  GstGLContext *context = GST_GL_BASE_FILTER (dl)->context;
+  GstGLSyncMeta *sync_meta;
+  GstBuffer *buffer;
+
+  buffer = g_queue_pop_head (&dl->pending);
+  if (buffer && context) {
+    sync_meta = gst_buffer_get_gl_sync_meta (buffer);
+    if (sync_meta)
+      gst_gl_sync_meta_wait_cpu (sync_meta, context);
   }
 
+  return buffer;
+}
+
+static GstFlowReturn
+gst_gl_download_element_drain (GstGLDownloadElement * dl)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buffer;
+
+  while ((buffer = gst_gl_download_element_pop_pending (dl))) {
+    if (ret == GST_FLOW_OK)
+      ret = gst_pad_push (GST_BASE_TRANSFORM_SRC_PAD (dl), buffer);
+    else
+      gst_buffer_unref (buffer);
+  }
+
+  return ret;
+}
+
+static void
+gst_gl_download_element_clear_pending (GstGLDownloadElement * dl)
+{
+  g_queue_foreach (&dl->pending, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&dl->pending);
+}
+
+/* With an async-depth, the read back of a buffer is started and a fence is
+ * set after it, and the buffer is only pushed once async-depth newer
+ * buffers were started and its fence has passed */
+static GstFlowReturn
+gst_gl_download_element_generate_output (GstBaseTransform * bt,
+    GstBuffer ** outbuf)
+{
+  GstGLDownloadElement *dl = GST_GL_DOWNLOAD_ELEMENT (bt);
+  GstGLContext *context = GST_GL_BASE_FILTER (bt)->context;
+  GstGLSyncMeta *sync_meta;
+  GstBuffer *inbuf;
+
+  if (dl->async_depth == 0 || !dl->do_pbo_transfers || !context)
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->generate_output (bt,
+        outbuf);
+
+  *outbuf = NULL;
+  inbuf = bt->queued_buf;
+  bt->queued_buf = NULL;
+  if (!inbuf)
+    return GST_FLOW_OK;
+
+  gst_gl_download_element_start_transfer (inbuf);
+
+  sync_meta = gst_buffer_get_gl_sync_meta (inbuf);
+  if (!sync_meta) {
+    inbuf = gst_buffer_make_writable (inbuf);
+    sync_meta = gst_buffer_add_gl_sync_meta (context, inbuf);
+  }
+  gst_gl_sync_meta_set_sync_point (sync_meta, context);
+
+  g_queue_push_tail (&dl->pending, inbuf);
+  if (g_queue_get_length (&dl->pending) > dl->async_depth)
+    *outbuf = gst_gl_download_element_pop_pending (dl);
+
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_gl_download_element_sink_event (GstBaseTransform * bt, GstEvent * event)
+{
+  GstGLDownloadElement *dl = GST_GL_DOWNLOAD_ELEMENT (bt);
+
+  /* pending buffers go before any serialized event */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+    gst_gl_download_element_clear_pending (dl);
+  else if (GST_EVENT_IS_SERIALIZED (event))
+    gst_gl_download_element_drain (dl);
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->sink_event (bt, event);
+}
+
+static gboolean
+gst_gl_download_element_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query)
+{
+  GstGLDownloadElement *dl = GST_GL_DOWNLOAD_ELEMENT (bt);
+  gboolean ret;
+
+  ret = GST_BASE_TRANSFORM_CLASS (parent_class)->query (bt, direction, query);
+  if (!ret || dl->async_depth == 0)
+    return ret;
+
+  if (direction == GST_PAD_SRC && GST_QUERY_TYPE (query) == GST_QUERY_LATENCY
+      && dl->fps_n > 0 && dl->fps_d > 0) {
+    GstClockTime min, max, latency;
+    gboolean live;
+
+    gst_query_parse_latency (query, &live, &min, &max);
+    latency = gst_util_uint64_scale_int (dl->async_depth * GST_SECOND,
+        dl->fps_d, dl->fps_n);
+    min += latency;
+    if (max != GST_CLOCK_TIME_NONE)
+      max += latency;
+    gst_query_set_latency (query, live, min, max);
+  } else if (direction == GST_PAD_SINK &&
+      GST_QUERY_TYPE (query) == GST_QUERY_ALLOCATION) {
+    guint i, n, size, min, max;
+    GstBufferPool *pool;
+
+    /* upstream has to provide the buffers that are held back */
+    n = gst_query_get_n_allocation_pools (query);
+    for (i = 0; i < n; i++) {
+      gst_query_parse_nth_allocation_pool (query, i, &pool, &size, &min, &max);
+      min += dl->async_depth;
+      if (max != 0)
+        max += dl->async_depth;
+      gst_query_set_nth_allocation_pool (query, i, pool, size, min, max);
+      if (pool)
+        gst_object_unref (pool);
+    }
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_gl_download_element_stop (GstBaseTransform * bt)
+{
+  GstGLDownloadElement *dl = GST_GL_DOWNLOAD_ELEMENT (bt);
+
+  gst_gl_download_element_clear_pending (dl);
+  if (dl->dmabuf_allocator)
+    gst_object_unref (dl->dmabuf_allocator);
+  dl->dmabuf_allocator = NULL;
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->stop (bt);
+}
+
 static GstFlowReturn
 gst_gl_download_element_transform (GstBaseTransform * bt,
     GstBuffer * inbuf, GstBuffer * outbuf)
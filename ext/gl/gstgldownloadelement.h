@@ -45,6 +45,17 @@ struct _GstGLDownloadElement
   GstGLBaseFilter  parent;
 
   gboolean do_pbo_transfers;
+
+  /* buffers whose download is still in flight */
+  guint async_depth;
+  GQueue pending;
+  gint fps_n, fps_d;
+
+  /* exporting the textures as dmabufs */
+  gboolean export_dmabuf;
+  gboolean do_dmabuf_exports;
+  GstAllocator *dmabuf_allocator;
+  GstVideoInfo out_info;
 };
 
 struct _GstGLDownloadElementClass
@@ -100,6 +100,8 @@ GST_DEBUG_CATEGORY (gst_debug_glimage_sink);
 #define DEFAULT_HANDLE_EVENTS       TRUE
 #define DEFAULT_FORCE_ASPECT_RATIO  TRUE
 #define DEFAULT_IGNORE_ALPHA        TRUE
+#define DEFAULT_SWAP_INTERVAL       -1
+#define DEFAULT_DROP_LATE           TRUE
 
 #define DEFAULT_MULTIVIEW_MODE GST_VIDEO_MULTIVIEW_MODE_MONO
 #define DEFAULT_MULTIVIEW_FLAGS GST_VIDEO_MULTIVIEW_FLAGS_NONE
@@ -122,7 +124,10 @@ enum
   PROP_BIN_SHOW_PREROLL_FRAME,
   PROP_BIN_OUTPUT_MULTIVIEW_LAYOUT,
   PROP_BIN_OUTPUT_MULTIVIEW_FLAGS,
-  PROP_BIN_OUTPUT_MULTIVIEW_DOWNMIX_MODE
+  PROP_BIN_OUTPUT_MULTIVIEW_DOWNMIX_MODE,
+  PROP_BIN_SWAP_INTERVAL,
+  PROP_BIN_DROP_LATE,
+  PROP_BIN_PRESENTATION_STATS
 };
 
 enum
@@ -284,6 +289,20 @@ gst_gl_image_sink_bin_class_init (GstGLImageSinkBinClass * klass)
           "Output anaglyph type to generate when downmixing to mono",
           GST_TYPE_GL_STEREO_DOWNMIX_MODE_TYPE, DEFAULT_MULTIVIEW_DOWNMIX,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BIN_SWAP_INTERVAL,
+      g_param_spec_int ("swap-interval", "Swap interval",
+          "Number of vertical blanks to wait for on each swap "
+          "(-1 = leave the system default)", -1, G_MAXINT,
+          DEFAULT_SWAP_INTERVAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BIN_DROP_LATE,
+      g_param_spec_boolean ("drop-late", "Drop late frames",
+          "Skip the upload and conversion of the frames that are already "
+          "later than max-lateness", DEFAULT_DROP_LATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BIN_PRESENTATION_STATS,
+      g_param_spec_boxed ("presentation-stats", "Presentation statistics",
+          "Statistics of the presented and dropped frames", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
   gst_gl_image_sink_bin_signals[SIGNAL_BIN_CLIENT_DRAW] =
       g_signal_new ("client-draw", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST,
       0, NULL, NULL, g_cclosure_marshal_generic, G_TYPE_BOOLEAN, 2,
@@ -354,6 +373,8 @@ static void gst_glimage_sink_set_render_rectangle (GstVideoOverlay * overlay,
 static void gst_glimage_sink_handle_events (GstVideoOverlay * overlay,
     gboolean handle_events);
 static gboolean update_output_format (GstGLImageSink * glimage_sink);
+static GstStructure *gst_glimage_sink_get_presentation_stats (GstGLImageSink *
+    gl_sink);
 
 #define GST_GL_SINK_CAPS \
     "video/x-raw(" GST_CAPS_FEATURE_MEMORY_GL_MEMORY "), "              \
@@ -389,7 +410,10 @@ enum
   PROP_IGNORE_ALPHA,
   PROP_OUTPUT_MULTIVIEW_LAYOUT,
   PROP_OUTPUT_MULTIVIEW_FLAGS,
-  PROP_OUTPUT_MULTIVIEW_DOWNMIX_MODE
+  PROP_OUTPUT_MULTIVIEW_DOWNMIX_MODE,
+  PROP_SWAP_INTERVAL,
+  PROP_DROP_LATE,
+  PROP_PRESENTATION_STATS
 };
 
 enum
@@ -692,6 +716,53 @@ gst_glimage_sink_class_init (GstGLImageSinkClass * klass)
           GST_TYPE_GL_STEREO_DOWNMIX_MODE_TYPE, DEFAULT_MULTIVIEW_DOWNMIX,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGLImageSink:swap-interval:
+   *
+   * The number of vertical blanks a buffer swap waits for: 0 presents
+   * immediately, 1 synchronises every frame on the vertical blank and -1
+   * keeps the default of the platform.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_SWAP_INTERVAL,
+      g_param_spec_int ("swap-interval", "Swap interval",
+          "Number of vertical blanks to wait for on each swap "
+          "(-1 = leave the system default)", -1, G_MAXINT,
+          DEFAULT_SWAP_INTERVAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGLImageSink:drop-late:
+   *
+   * When synchronising on the clock, skip the upload and conversion of the
+   * frames that are already later than #GstBaseSink:max-lateness when they
+   * are prepared, as the base class would drop them anyway.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DROP_LATE,
+      g_param_spec_boolean ("drop-late", "Drop late frames",
+          "Skip the upload and conversion of the frames that are already "
+          "later than max-lateness", DEFAULT_DROP_LATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGLImageSink:presentation-stats:
+   *
+   * Statistics of the presentation, in a structure with the fields
+   * "presented" and "dropped" (#guint64 frame counts), "missed-vsyncs"
+   * (#guint64, the vertical blanks a frame stayed on screen beyond its
+   * duration) and "refresh-period" (#GstClockTime, 0 when unknown). The
+   * vertical blank information is only available when the platform reports
+   * it, e.g. with GLX_OML_sync_control.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PRESENTATION_STATS,
+      g_param_spec_boxed ("presentation-stats", "Presentation statistics",
+          "Statistics of the presented and dropped frames", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_metadata (element_class, "OpenGL video sink",
       "Sink/Video", "A videosink based on OpenGL",
       "Julien Isorce <julien.isorce@gmail.com>");
@@ -772,6 +843,9 @@ gst_glimage_sink_init (GstGLImageSink * glimage_sink)
   glimage_sink->current_rotate_method = DEFAULT_ROTATE_METHOD;
   glimage_sink->transform_matrix = NULL;
 
+  glimage_sink->swap_interval = DEFAULT_SWAP_INTERVAL;
+  glimage_sink->drop_late = DEFAULT_DROP_LATE;
+
   g_mutex_init (&glimage_sink->drawing_lock);
 }
 
@@ -826,6 +900,15 @@ gst_glimage_sink_set_property (GObject * object, guint prop_id,
       glimage_sink->output_mode_changed = TRUE;
       GST_GLIMAGE_SINK_UNLOCK (glimage_sink);
       break;
+    case PROP_SWAP_INTERVAL:
+      GST_GLIMAGE_SINK_LOCK (glimage_sink);
+      glimage_sink->swap_interval = g_value_get_int (value);
+      glimage_sink->swap_interval_changed = TRUE;
+      GST_GLIMAGE_SINK_UNLOCK (glimage_sink);
+      break;
+    case PROP_DROP_LATE:
+      glimage_sink->drop_late = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -884,6 +967,16 @@ gst_glimage_sink_get_property (GObject * object, guint prop_id,
     case PROP_OUTPUT_MULTIVIEW_DOWNMIX_MODE:
       g_value_set_enum (value, glimage_sink->mview_downmix_mode);
       break;
+    case PROP_SWAP_INTERVAL:
+      g_value_set_int (value, glimage_sink->swap_interval);
+      break;
+    case PROP_DROP_LATE:
+      g_value_set_boolean (value, glimage_sink->drop_late);
+      break;
+    case PROP_PRESENTATION_STATS:
+      g_value_take_boxed (value,
+          gst_glimage_sink_get_presentation_stats (glimage_sink));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -967,6 +1060,7 @@ _ensure_gl_setup (GstGLImageSink * gl_sink)
       }
 
       gst_gl_window_handle_events (window, gl_sink->handle_events);
+      gl_sink->swap_interval_changed = TRUE;
 
       /* setup callbacks */
       gst_gl_window_set_resize_callback (window,
@@ -1154,6 +1248,13 @@ gst_glimage_sink_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       g_atomic_int_set (&glimage_sink->to_quit, 0);
+      GST_OBJECT_LOCK (glimage_sink);
+      glimage_sink->presented = glimage_sink->dropped = 0;
+      glimage_sink->missed_vsyncs = 0;
+      glimage_sink->last_vsync_count = 0;
+      glimage_sink->refresh_period = 0;
+      GST_OBJECT_UNLOCK (glimage_sink);
+      glimage_sink->skipped_buffer = NULL;
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
@@ -1647,16 +1748,99 @@ fail:
   return FALSE;
 }
 
+/* Whether @buf is already later than max-lateness, in which case the base
+ * class drops it after prepare() and uploading it would be wasted. Mirrors
+ * the computation of gst_base_sink_do_sync() */
+static gboolean
+gst_glimage_sink_is_too_late (GstGLImageSink * glimage_sink, GstBuffer * buf)
+{
+  GstBaseSink *bsink = GST_BASE_SINK (glimage_sink);
+  GstClockTime start = GST_CLOCK_TIME_NONE, end = GST_CLOCK_TIME_NONE;
+  GstClockTime base_time, now, deadline;
+  GstClockTimeDiff ts_offset;
+  gint64 max_lateness;
+  guint64 running_time;
+  GstClock *clock;
+
+  if (!glimage_sink->drop_late || !gst_base_sink_get_sync (bsink))
+    return FALSE;
+
+  /* never drop the frame of a new segment or the preroll frame */
+  if (GST_STATE (glimage_sink) != GST_STATE_PLAYING
+      || GST_STATE_PENDING (glimage_sink) != GST_STATE_VOID_PENDING)
+    return FALSE;
+
+  max_lateness = gst_base_sink_get_max_lateness (bsink);
+  if (max_lateness == -1 || bsink->segment.format != GST_FORMAT_TIME)
+    return FALSE;
+
+  gst_glimage_sink_get_times (bsink, buf, &start, &end);
+  if (GST_CLOCK_TIME_IS_VALID (end))
+    start = end;
+  if (!GST_CLOCK_TIME_IS_VALID (start))
+    return FALSE;
+
+  running_time = gst_segment_to_running_time (&bsink->segment,
+      GST_FORMAT_TIME, start);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return FALSE;
+
+  GST_OBJECT_LOCK (glimage_sink);
+  clock = GST_ELEMENT_CLOCK (glimage_sink);
+  if (!clock) {
+    GST_OBJECT_UNLOCK (glimage_sink);
+    return FALSE;
+  }
+  clock = gst_object_ref (clock);
+  base_time = GST_ELEMENT_CAST (glimage_sink)->base_time;
+  GST_OBJECT_UNLOCK (glimage_sink);
+
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+
+  ts_offset = gst_base_sink_get_ts_offset (bsink);
+  if (ts_offset < 0 && running_time < -ts_offset)
+    return FALSE;
+  running_time += ts_offset;
+
+  deadline = base_time + running_time + gst_base_sink_get_latency (bsink) +
+      gst_base_sink_get_render_delay (bsink) + max_lateness;
+
+  return now > deadline;
+}
+
+static GstFlowReturn gst_glimage_sink_upload (GstGLImageSink * glimage_sink,
+    GstBuffer * buf);
+
 static GstFlowReturn
 gst_glimage_sink_prepare (GstBaseSink * bsink, GstBuffer * buf)
 {
-  GstGLImageSink *glimage_sink;
+  GstGLImageSink *glimage_sink = GST_GLIMAGE_SINK (bsink);
+
+  glimage_sink->skipped_buffer = NULL;
+
+  if (gst_glimage_sink_is_too_late (glimage_sink, buf)) {
+    GST_DEBUG_OBJECT (glimage_sink, "buffer %p is too late, not uploading it",
+        buf);
+    glimage_sink->skipped_buffer = buf;
+
+    GST_OBJECT_LOCK (glimage_sink);
+    glimage_sink->dropped++;
+    GST_OBJECT_UNLOCK (glimage_sink);
+
+    return GST_FLOW_OK;
+  }
+
+  return gst_glimage_sink_upload (glimage_sink, buf);
+}
+
+static GstFlowReturn
+gst_glimage_sink_upload (GstGLImageSink * glimage_sink, GstBuffer * buf)
+{
   GstGLSyncMeta *sync_meta;
   GstBuffer **target;
   GstBuffer *old_input;
 
-  glimage_sink = GST_GLIMAGE_SINK (bsink);
-
   GST_TRACE ("preparing buffer:%p", buf);
 
   if (GST_VIDEO_SINK_WIDTH (glimage_sink) < 1 ||
@@ -1731,6 +1915,21 @@ gst_glimage_sink_show_frame (GstVideoSink * vsink, GstBuffer * buf)
 
   glimage_sink = GST_GLIMAGE_SINK (vsink);
 
+  /* the base class did not drop the frame after all, e.g. because the clock
+   * jumped while waiting */
+  if (G_UNLIKELY (glimage_sink->skipped_buffer == buf)) {
+    GstFlowReturn ret;
+
+    glimage_sink->skipped_buffer = NULL;
+
+    GST_OBJECT_LOCK (glimage_sink);
+    glimage_sink->dropped--;
+    GST_OBJECT_UNLOCK (glimage_sink);
+
+    if ((ret = gst_glimage_sink_upload (glimage_sink, buf)) != GST_FLOW_OK)
+      return ret;
+  }
+
   GST_TRACE ("redisplay texture:%u of size:%ux%u, window size:%ux%u",
       glimage_sink->next_tex, GST_VIDEO_INFO_WIDTH (&glimage_sink->out_info),
       GST_VIDEO_INFO_HEIGHT (&glimage_sink->out_info),
@@ -1741,6 +1940,10 @@ gst_glimage_sink_show_frame (GstVideoSink * vsink, GstBuffer * buf)
   if (!gst_glimage_sink_redisplay (glimage_sink))
     goto redisplay_failed;
 
+  GST_OBJECT_LOCK (glimage_sink);
+  glimage_sink->presented++;
+  GST_OBJECT_UNLOCK (glimage_sink);
+
   GST_TRACE ("post redisplay");
 
   if (g_atomic_int_get (&glimage_sink->to_quit) != 0) {
@@ -2150,6 +2353,70 @@ gst_glimage_sink_on_resize (GstGLImageSink * gl_sink, gint width, gint height)
   GST_GLIMAGE_SINK_UNLOCK (gl_sink);
 }
 
+/* Called from the GL thread before drawing the next frame, when the previous
+ * one has been swapped. Accounts for the vertical blanks the previous frame
+ * was displayed for beyond its duration */
+static void
+gst_glimage_sink_update_vsync_stats (GstGLImageSink * gl_sink)
+{
+  GstClockTime duration = GST_CLOCK_TIME_NONE;
+  gint64 vsync_time;
+  guint64 vsync_count;
+
+  if (!gst_gl_context_get_last_vsync (gl_sink->context, &vsync_time,
+          &vsync_count))
+    return;
+
+  if (gl_sink->stored_buffer[0]
+      && GST_BUFFER_DURATION_IS_VALID (gl_sink->stored_buffer[0]))
+    duration = GST_BUFFER_DURATION (gl_sink->stored_buffer[0]);
+  else if (GST_VIDEO_INFO_FPS_N (&gl_sink->out_info) > 0)
+    duration = gst_util_uint64_scale_int (GST_SECOND,
+        GST_VIDEO_INFO_FPS_D (&gl_sink->out_info),
+        GST_VIDEO_INFO_FPS_N (&gl_sink->out_info));
+
+  GST_OBJECT_LOCK (gl_sink);
+  if (gl_sink->last_vsync_count && vsync_count > gl_sink->last_vsync_count
+      && vsync_time > gl_sink->last_vsync_time) {
+    guint64 vsyncs = vsync_count - gl_sink->last_vsync_count;
+    GstClockTime period = (vsync_time - gl_sink->last_vsync_time) *
+        GST_USECOND / vsyncs;
+
+    /* smooth out the jitter of the measurement */
+    if (gl_sink->refresh_period)
+      gl_sink->refresh_period = (7 * gl_sink->refresh_period + period) / 8;
+    else
+      gl_sink->refresh_period = period;
+
+    if (GST_CLOCK_TIME_IS_VALID (duration)) {
+      guint64 expected = MAX (1, (duration + gl_sink->refresh_period / 2) /
+          gl_sink->refresh_period);
+
+      if (vsyncs > expected)
+        gl_sink->missed_vsyncs += vsyncs - expected;
+    }
+  }
+  gl_sink->last_vsync_time = vsync_time;
+  gl_sink->last_vsync_count = vsync_count;
+  GST_OBJECT_UNLOCK (gl_sink);
+}
+
+static GstStructure *
+gst_glimage_sink_get_presentation_stats (GstGLImageSink * gl_sink)
+{
+  GstStructure *s;
+
+  GST_OBJECT_LOCK (gl_sink);
+  s = gst_structure_new ("application/x-glimagesink-stats",
+      "presented", G_TYPE_UINT64, gl_sink->presented,
+      "dropped", G_TYPE_UINT64, gl_sink->dropped,
+      "missed-vsyncs", G_TYPE_UINT64, gl_sink->missed_vsyncs,
+      "refresh-period", G_TYPE_UINT64, gl_sink->refresh_period, NULL);
+  GST_OBJECT_UNLOCK (gl_sink);
+
+  return s;
+}
+
 static void
 gst_glimage_sink_on_draw (GstGLImageSink * gl_sink)
 {
@@ -2180,6 +2447,17 @@ gst_glimage_sink_on_draw (GstGLImageSink * gl_sink)
   window = gst_gl_context_get_window (gl_sink->context);
   window->is_drawing = TRUE;
 
+  if (gl_sink->swap_interval_changed) {
+    gl_sink->swap_interval_changed = FALSE;
+    if (gl_sink->swap_interval >= 0
+        && !gst_gl_context_set_swap_interval (gl_sink->context,
+            gl_sink->swap_interval))
+      GST_WARNING_OBJECT (gl_sink, "Could not set the swap interval to %i",
+          gl_sink->swap_interval);
+  }
+
+  gst_glimage_sink_update_vsync_stats (gl_sink);
+
   /* opengl scene */
   gst_gl_insert_debug_marker (gl_sink->context, "%s element drawing texture %u",
       GST_OBJECT_NAME (gl_sink), gl_sink->redisplay_texture);
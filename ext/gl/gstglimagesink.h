@@ -141,6 +141,22 @@ struct _GstGLImageSink
     GstGLRotateMethod current_rotate_method;
     GstGLRotateMethod rotate_method;
     const gfloat *transform_matrix;
+
+    /* protected with drawing_lock */
+    gint swap_interval;
+    gboolean swap_interval_changed;
+
+    gboolean drop_late;
+    /* prepared but not uploaded because too late */
+    GstBuffer *skipped_buffer;
+
+    /* presentation statistics, protected with the object lock */
+    guint64 presented;
+    guint64 dropped;
+    guint64 missed_vsyncs;
+    GstClockTime refresh_period;
+    gint64 last_vsync_time;
+    guint64 last_vsync_count;
 };
 
 struct _GstGLImageSinkClass
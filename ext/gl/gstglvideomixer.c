@@ -469,19 +469,66 @@ static gboolean gst_gl_video_mixer_callback (gpointer stuff);
 
 /* *INDENT-OFF* */
 
+/* Up to BATCH_SIZE pads are drawn with a single draw call, each with its
+ * own texture unit. The positions are transformed on the CPU and the alpha
+ * and unit are passed as vertex attributes, so there is nothing to change
+ * between the pads of a batch. */
+#define BATCH_SIZE 8
+
+/* vertex source */
+static const gchar *video_mixer_v_src =
+    "attribute vec4 a_position;\n"
+    "attribute vec2 a_texcoord;\n"
+    "attribute float a_alpha;\n"
+    "attribute float a_unit;\n"
+    "varying vec2 v_texcoord;\n"
+    "varying float v_alpha;\n"
+    "varying float v_unit;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = a_position;\n"
+    "   v_texcoord = a_texcoord;\n"
+    "   v_alpha = a_alpha;\n"
+    "   v_unit = a_unit;\n"
+    "}\n";
+
 /* fragment source */
 static const gchar *video_mixer_f_src =
     "#ifdef GL_ES\n"
     "precision mediump float;\n"
     "#endif\n"
-    "uniform sampler2D texture;                     \n"
-    "uniform float alpha;\n"
-    "varying vec2 v_texcoord;                            \n"
-    "void main()                                         \n"
-    "{                                                   \n"
-    "  vec4 rgba = texture2D(texture, v_texcoord);\n"
-    "  gl_FragColor = vec4(rgba.rgb, rgba.a * alpha);\n"
-    "}                                                   \n";
+    "uniform sampler2D tex0;\n"
+    "uniform sampler2D tex1;\n"
+    "uniform sampler2D tex2;\n"
+    "uniform sampler2D tex3;\n"
+    "uniform sampler2D tex4;\n"
+    "uniform sampler2D tex5;\n"
+    "uniform sampler2D tex6;\n"
+    "uniform sampler2D tex7;\n"
+    "varying vec2 v_texcoord;\n"
+    "varying float v_alpha;\n"
+    "varying float v_unit;\n"
+    "void main()\n"
+    "{\n"
+    "  vec4 rgba;\n"
+    "  if (v_unit < 0.5)\n"
+    "    rgba = texture2D(tex0, v_texcoord);\n"
+    "  else if (v_unit < 1.5)\n"
+    "    rgba = texture2D(tex1, v_texcoord);\n"
+    "  else if (v_unit < 2.5)\n"
+    "    rgba = texture2D(tex2, v_texcoord);\n"
+    "  else if (v_unit < 3.5)\n"
+    "    rgba = texture2D(tex3, v_texcoord);\n"
+    "  else if (v_unit < 4.5)\n"
+    "    rgba = texture2D(tex4, v_texcoord);\n"
+    "  else if (v_unit < 5.5)\n"
+    "    rgba = texture2D(tex5, v_texcoord);\n"
+    "  else if (v_unit < 6.5)\n"
+    "    rgba = texture2D(tex6, v_texcoord);\n"
+    "  else\n"
+    "    rgba = texture2D(tex7, v_texcoord);\n"
+    "  gl_FragColor = vec4(rgba.rgb, rgba.a * v_alpha);\n"
+    "}\n";
 
 /* checker vertex source */
 static const gchar *checker_v_src =
@@ -556,7 +603,9 @@ struct _GstGLVideoMixerPad
   gdouble blend_constant_color_alpha;
 
   gboolean geometry_change;
-  GLuint vertex_buffer;
+  /* left, bottom, right and top of the pad in normalized device
+   * coordinates */
+  gfloat rect[4];
 };
 
 struct _GstGLVideoMixerPadClass
@@ -603,6 +652,7 @@ gst_gl_video_mixer_pad_init (GstGLVideoMixerPad * pad)
   pad->blend_function_src_alpha = DEFAULT_PAD_BLEND_FUNCTION_SRC_ALPHA;
   pad->blend_function_dst_rgb = DEFAULT_PAD_BLEND_FUNCTION_DST_RGB;
   pad->blend_function_dst_alpha = DEFAULT_PAD_BLEND_FUNCTION_DST_ALPHA;
+  pad->geometry_change = TRUE;
 }
 
 static void
@@ -823,26 +873,6 @@ gst_gl_video_mixer_pad_set_property (GObject * object, guint prop_id,
   gst_object_unref (mix);
 }
 
-static void
-_del_buffer (GstGLContext * context, GLuint * pBuffer)
-{
-  context->gl_vtable->DeleteBuffers (1, pBuffer);
-}
-
-static void
-gst_gl_video_mixer_release_pad (GstElement * element, GstPad * p)
-{
-  GstGLVideoMixerPad *pad = GST_GL_VIDEO_MIXER_PAD (p);
-  if (pad->vertex_buffer) {
-    GstGLBaseMixer *mix = GST_GL_BASE_MIXER (element);
-    gst_gl_context_thread_add (mix->context, (GstGLContextThreadFunc)
-        _del_buffer, &pad->vertex_buffer);
-    pad->vertex_buffer = 0;
-  }
-  GST_ELEMENT_CLASS (g_type_class_peek_parent (G_OBJECT_GET_CLASS (element)))
-      ->release_pad (element, p);
-}
-
 static void
 gst_gl_video_mixer_class_init (GstGLVideoMixerClass * klass)
 {
@@ -853,7 +883,6 @@ gst_gl_video_mixer_class_init (GstGLVideoMixerClass * klass)
 
   gobject_class = (GObjectClass *) klass;
   element_class = GST_ELEMENT_CLASS (klass);
-  element_class->release_pad = gst_gl_video_mixer_release_pad;
 
   gobject_class->set_property = gst_gl_video_mixer_set_property;
   gobject_class->get_property = gst_gl_video_mixer_get_property;
@@ -1094,20 +1123,6 @@ _fixate_caps (GstAggregator * agg, GstCaps * caps)
   return ret;
 }
 
-static gboolean
-_reset_pad_gl (GstElement * agg, GstPad * aggpad, gpointer udata)
-{
-  const GstGLFuncs *gl = GST_GL_BASE_MIXER (agg)->context->gl_vtable;
-  GstGLVideoMixerPad *pad = GST_GL_VIDEO_MIXER_PAD (aggpad);
-
-  if (pad->vertex_buffer) {
-    gl->DeleteBuffers (1, &pad->vertex_buffer);
-    pad->vertex_buffer = 0;
-  }
-
-  return TRUE;
-}
-
 static void
 _reset_gl (GstGLContext * context, GstGLVideoMixer * video_mixer)
 {
@@ -1128,7 +1143,15 @@ _reset_gl (GstGLContext * context, GstGLVideoMixer * video_mixer)
     video_mixer->checker_vbo = 0;
   }
 
-  gst_element_foreach_sink_pad (GST_ELEMENT (video_mixer), _reset_pad_gl, NULL);
+  if (video_mixer->batch_vbo) {
+    gl->DeleteBuffers (1, &video_mixer->batch_vbo);
+    video_mixer->batch_vbo = 0;
+  }
+
+  if (video_mixer->batch_indices) {
+    gl->DeleteBuffers (1, &video_mixer->batch_indices);
+    video_mixer->batch_indices = 0;
+  }
 }
 
 static void
@@ -1164,8 +1187,7 @@ gst_gl_video_mixer_init_shader (GstGLMixer * mixer, GstCaps * outcaps)
   video_mixer->output_geo_change = TRUE;
 
   return gst_gl_context_gen_shader (GST_GL_BASE_MIXER (mixer)->context,
-      gst_gl_shader_string_vertex_mat4_vertex_transform,
-      video_mixer_f_src, &video_mixer->shader);
+      video_mixer_v_src, video_mixer_f_src, &video_mixer->shader);
 }
 
 static void
@@ -1404,21 +1426,157 @@ _set_blend_state (GstGLVideoMixer * video_mixer, GstGLVideoMixerPad * mix_pad)
   return TRUE;
 }
 
+static gboolean
+_same_blend_state (GstGLVideoMixerPad * a, GstGLVideoMixerPad * b)
+{
+  return a->blend_equation_rgb == b->blend_equation_rgb
+      && a->blend_equation_alpha == b->blend_equation_alpha
+      && a->blend_function_src_rgb == b->blend_function_src_rgb
+      && a->blend_function_src_alpha == b->blend_function_src_alpha
+      && a->blend_function_dst_rgb == b->blend_function_dst_rgb
+      && a->blend_function_dst_alpha == b->blend_function_dst_alpha
+      && a->blend_constant_color_red == b->blend_constant_color_red
+      && a->blend_constant_color_green == b->blend_constant_color_green
+      && a->blend_constant_color_blue == b->blend_constant_color_blue
+      && a->blend_constant_color_alpha == b->blend_constant_color_alpha;
+}
+
+/* position (4), texcoord (2), alpha and texture unit */
+#define BATCH_VERTEX_SIZE 8
+
+typedef struct
+{
+  GLint attr_position_loc;
+  GLint attr_texture_loc;
+  GLint attr_alpha_loc;
+  GLint attr_unit_loc;
+
+  guint n_pads;
+  GstGLVideoMixerPad *first_pad;
+  guint textures[BATCH_SIZE];
+  gfloat vertices[BATCH_SIZE * 4 * BATCH_VERTEX_SIZE];
+} VideoMixerBatch;
+
+static void
+_init_batch_buffers (GstGLVideoMixer * video_mixer)
+{
+  const GstGLFuncs *gl = GST_GL_BASE_MIXER (video_mixer)->context->gl_vtable;
+
+  if (!video_mixer->batch_indices) {
+    GLushort batch_indices[BATCH_SIZE * G_N_ELEMENTS (indices)];
+    guint i, j;
+
+    for (i = 0; i < BATCH_SIZE; i++)
+      for (j = 0; j < G_N_ELEMENTS (indices); j++)
+        batch_indices[i * G_N_ELEMENTS (indices) + j] = i * 4 + indices[j];
+
+    gl->GenBuffers (1, &video_mixer->batch_indices);
+    gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, video_mixer->batch_indices);
+    gl->BufferData (GL_ELEMENT_ARRAY_BUFFER, sizeof (batch_indices),
+        batch_indices, GL_STATIC_DRAW);
+  }
+
+  if (!video_mixer->batch_vbo)
+    gl->GenBuffers (1, &video_mixer->batch_vbo);
+}
+
+static void
+_update_pad_rect (GstGLVideoMixer * video_mixer, GstGLVideoMixerPad * pad)
+{
+  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (video_mixer);
+  guint out_width = GST_VIDEO_INFO_WIDTH (&vagg->info);
+  guint out_height = GST_VIDEO_INFO_HEIGHT (&vagg->info);
+  gint pad_width, pad_height;
+
+  _mixer_pad_get_output_size (video_mixer, pad,
+      GST_VIDEO_INFO_PAR_N (&vagg->info), GST_VIDEO_INFO_PAR_D (&vagg->info),
+      &pad_width, &pad_height);
+
+  pad->rect[0] = 2.0f * (gfloat) pad->xpos / (gfloat) out_width - 1.0f;
+  pad->rect[1] = 2.0f * (gfloat) pad->ypos / (gfloat) out_height - 1.0f;
+  pad->rect[2] = pad->rect[0] + 2.0f * (gfloat) pad_width / (gfloat) out_width;
+  pad->rect[3] = pad->rect[1] + 2.0f * (gfloat) pad_height /
+      (gfloat) out_height;
+
+  pad->geometry_change = FALSE;
+}
+
+/* Appends the quad of @pad, transformed by @matrix, to @batch */
+static void
+_batch_add_pad (VideoMixerBatch * batch, GstGLVideoMixerPad * pad,
+    guint tex_id, const gfloat * matrix)
+{
+  static const gfloat texcoords[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
+    0.0f, 1.0f
+  };
+  gfloat *v = &batch->vertices[batch->n_pads * 4 * BATCH_VERTEX_SIZE];
+  guint i, j;
+
+  for (i = 0; i < 4; i++, v += BATCH_VERTEX_SIZE) {
+    /* same corners as the indices, starting at the bottom-left */
+    gfloat pos[4] = { pad->rect[i == 1 || i == 2 ? 2 : 0],
+      pad->rect[i >= 2 ? 3 : 1], -1.0f, 1.0f
+    };
+
+    /* column-major, as glUniformMatrix4fv() without transposing */
+    for (j = 0; j < 4; j++)
+      v[j] = matrix[j] * pos[0] + matrix[4 + j] * pos[1] +
+          matrix[8 + j] * pos[2] + matrix[12 + j] * pos[3];
+    v[4] = texcoords[i * 2];
+    v[5] = texcoords[i * 2 + 1];
+    v[6] = pad->alpha;
+    v[7] = batch->n_pads;
+  }
+
+  if (batch->n_pads == 0)
+    batch->first_pad = pad;
+  batch->textures[batch->n_pads++] = tex_id;
+}
+
+static void
+_draw_batch (GstGLVideoMixer * video_mixer, VideoMixerBatch * batch)
+{
+  const GstGLFuncs *gl = GST_GL_BASE_MIXER (video_mixer)->context->gl_vtable;
+  guint i;
+
+  if (batch->n_pads == 0)
+    return;
+
+  /* all pads of a batch have the same blend state */
+  if (!_set_blend_state (video_mixer, batch->first_pad)) {
+    GST_FIXME_OBJECT (batch->first_pad,
+        "skipping %u pads due to incorrect blend parameters", batch->n_pads);
+    batch->n_pads = 0;
+    return;
+  }
+
+  GST_TRACE_OBJECT (video_mixer, "drawing %u pads", batch->n_pads);
+
+  for (i = 0; i < batch->n_pads; i++) {
+    gl->ActiveTexture (GL_TEXTURE0 + i);
+    gl->BindTexture (GL_TEXTURE_2D, batch->textures[i]);
+  }
+
+  gl->BufferData (GL_ARRAY_BUFFER,
+      batch->n_pads * 4 * BATCH_VERTEX_SIZE * sizeof (GLfloat),
+      batch->vertices, GL_STREAM_DRAW);
+
+  gl->DrawElements (GL_TRIANGLES, batch->n_pads * G_N_ELEMENTS (indices),
+      GL_UNSIGNED_SHORT, 0);
+
+  batch->n_pads = 0;
+}
+
 /* opengl scene, params: input texture (not the output mixer->texture) */
 static gboolean
 gst_gl_video_mixer_callback (gpointer stuff)
 {
   GstGLVideoMixer *video_mixer = GST_GL_VIDEO_MIXER (stuff);
-  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (stuff);
   GstGLMixer *mixer = GST_GL_MIXER (video_mixer);
   GstGLFuncs *gl = GST_GL_BASE_MIXER (mixer)->context->gl_vtable;
-  GLint attr_position_loc = 0;
-  GLint attr_texture_loc = 0;
-  guint out_width, out_height;
+  VideoMixerBatch batch;
   GList *walk;
-
-  out_width = GST_VIDEO_INFO_WIDTH (&vagg->info);
-  out_height = GST_VIDEO_INFO_HEIGHT (&vagg->info);
+  guint i;
 
   gst_gl_context_clear_shader (GST_GL_BASE_MIXER (mixer)->context);
   gl->BindTexture (GL_TEXTURE_2D, 0);
@@ -1437,10 +1595,43 @@ gst_gl_video_mixer_callback (gpointer stuff)
 
   gst_gl_shader_use (video_mixer->shader);
 
-  attr_position_loc =
+  for (i = 0; i < BATCH_SIZE; i++) {
+    gchar name[8];
+
+    g_snprintf (name, sizeof (name), "tex%u", i);
+    gst_gl_shader_set_uniform_1i (video_mixer->shader, name, i);
+  }
+
+  batch.n_pads = 0;
+  batch.attr_position_loc =
       gst_gl_shader_get_attribute_location (video_mixer->shader, "a_position");
-  attr_texture_loc =
+  batch.attr_texture_loc =
       gst_gl_shader_get_attribute_location (video_mixer->shader, "a_texcoord");
+  batch.attr_alpha_loc =
+      gst_gl_shader_get_attribute_location (video_mixer->shader, "a_alpha");
+  batch.attr_unit_loc =
+      gst_gl_shader_get_attribute_location (video_mixer->shader, "a_unit");
+
+  _init_batch_buffers (video_mixer);
+  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, video_mixer->batch_indices);
+  gl->BindBuffer (GL_ARRAY_BUFFER, video_mixer->batch_vbo);
+
+  gl->EnableVertexAttribArray (batch.attr_position_loc);
+  gl->EnableVertexAttribArray (batch.attr_texture_loc);
+  gl->EnableVertexAttribArray (batch.attr_alpha_loc);
+  gl->EnableVertexAttribArray (batch.attr_unit_loc);
+
+  gl->VertexAttribPointer (batch.attr_position_loc, 4, GL_FLOAT,
+      GL_FALSE, BATCH_VERTEX_SIZE * sizeof (GLfloat), (void *) 0);
+  gl->VertexAttribPointer (batch.attr_texture_loc, 2, GL_FLOAT,
+      GL_FALSE, BATCH_VERTEX_SIZE * sizeof (GLfloat),
+      (void *) (4 * sizeof (GLfloat)));
+  gl->VertexAttribPointer (batch.attr_alpha_loc, 1, GL_FLOAT,
+      GL_FALSE, BATCH_VERTEX_SIZE * sizeof (GLfloat),
+      (void *) (6 * sizeof (GLfloat)));
+  gl->VertexAttribPointer (batch.attr_unit_loc, 1, GL_FLOAT,
+      GL_FALSE, BATCH_VERTEX_SIZE * sizeof (GLfloat),
+      (void *) (7 * sizeof (GLfloat)));
 
   gl->Enable (GL_BLEND);
 
@@ -1450,18 +1641,10 @@ gst_gl_video_mixer_callback (gpointer stuff)
     GstGLMixerPad *mix_pad = walk->data;
     GstGLVideoMixerPad *pad = walk->data;
     GstVideoAggregatorPad *vagg_pad = walk->data;
+    GstVideoAffineTransformationMeta *af_meta;
     GstVideoInfo *v_info;
-    guint in_tex;
     guint in_width, in_height;
-
-    /* *INDENT-OFF* */
-    gfloat v_vertices[] = {
-      -1.0,-1.0,-1.0f, 0.0f, 0.0f,
-       1.0,-1.0,-1.0f, 1.0f, 0.0f,
-       1.0, 1.0,-1.0f, 1.0f, 1.0f,
-      -1.0, 1.0,-1.0f, 0.0f, 1.0f,
-    };
-    /* *INDENT-ON* */
+    gfloat matrix[16];
 
     v_info = &GST_VIDEO_AGGREGATOR_PAD (pad)->info;
     in_width = GST_VIDEO_INFO_WIDTH (v_info);
@@ -1475,98 +1658,47 @@ gst_gl_video_mixer_callback (gpointer stuff)
       continue;
     }
 
-    if (!_set_blend_state (video_mixer, pad)) {
-      GST_FIXME_OBJECT (pad, "skipping due to incorrect blend parameters");
-      walk = g_list_next (walk);
-      continue;
-    }
-
-    in_tex = mix_pad->current_texture;
-
-    _init_vbo_indices (video_mixer);
-
-    if (video_mixer->output_geo_change
-        || pad->geometry_change || !pad->vertex_buffer) {
-      gint pad_width, pad_height;
-      gfloat w, h;
-
-      _mixer_pad_get_output_size (video_mixer, pad,
-          GST_VIDEO_INFO_PAR_N (&vagg->info),
-          GST_VIDEO_INFO_PAR_D (&vagg->info), &pad_width, &pad_height);
+    /* the pads are drawn in order, a different blend state needs a new
+     * draw call */
+    if (batch.n_pads == BATCH_SIZE || (batch.n_pads > 0
+            && !_same_blend_state (batch.first_pad, pad)))
+      _draw_batch (video_mixer, &batch);
 
-      w = ((gfloat) pad_width / (gfloat) out_width);
-      h = ((gfloat) pad_height / (gfloat) out_height);
+    if (video_mixer->output_geo_change || pad->geometry_change)
+      _update_pad_rect (video_mixer, pad);
 
-      /* top-left */
-      v_vertices[0] = v_vertices[15] =
-          2.0f * (gfloat) pad->xpos / (gfloat) out_width - 1.0f;
-      /* bottom-left */
-      v_vertices[1] = v_vertices[6] =
-          2.0f * (gfloat) pad->ypos / (gfloat) out_height - 1.0f;
-      /* top-right */
-      v_vertices[5] = v_vertices[10] = v_vertices[0] + 2.0f * w;
-      /* bottom-right */
-      v_vertices[11] = v_vertices[16] = v_vertices[1] + 2.0f * h;
-      GST_TRACE ("processing texture:%u dimensions:%ux%u, at %f,%f %fx%f with "
-          "alpha:%f", in_tex, in_width, in_height, v_vertices[0], v_vertices[1],
-          v_vertices[5], v_vertices[11], pad->alpha);
+    GST_TRACE ("processing texture:%u dimensions:%ux%u, at %f,%f %fx%f with "
+        "alpha:%f", mix_pad->current_texture, in_width, in_height,
+        pad->rect[0], pad->rect[1], pad->rect[2], pad->rect[3], pad->alpha);
 
-      if (!pad->vertex_buffer)
-        gl->GenBuffers (1, &pad->vertex_buffer);
+    af_meta =
+        gst_buffer_get_video_affine_transformation_meta (vagg_pad->buffer);
+    gst_gl_get_affine_transformation_meta_as_ndc_ext (af_meta, matrix);
 
-      gl->BindBuffer (GL_ARRAY_BUFFER, pad->vertex_buffer);
-
-      gl->BufferData (GL_ARRAY_BUFFER, 4 * 5 * sizeof (GLfloat), v_vertices,
-          GL_STATIC_DRAW);
-
-      pad->geometry_change = FALSE;
-    } else {
-      gl->BindBuffer (GL_ARRAY_BUFFER, pad->vertex_buffer);
-    }
-    gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, video_mixer->vbo_indices);
-
-    gl->ActiveTexture (GL_TEXTURE0);
-    gl->BindTexture (GL_TEXTURE_2D, in_tex);
-    gst_gl_shader_set_uniform_1i (video_mixer->shader, "texture", 0);
-    gst_gl_shader_set_uniform_1f (video_mixer->shader, "alpha", pad->alpha);
-
-    {
-      GstVideoAffineTransformationMeta *af_meta;
-      gfloat matrix[16];
-
-      af_meta =
-          gst_buffer_get_video_affine_transformation_meta (vagg_pad->buffer);
-      gst_gl_get_affine_transformation_meta_as_ndc_ext (af_meta, matrix);
-      gst_gl_shader_set_uniform_matrix_4fv (video_mixer->shader,
-          "u_transformation", 1, FALSE, matrix);
-    }
-
-    gl->EnableVertexAttribArray (attr_position_loc);
-    gl->EnableVertexAttribArray (attr_texture_loc);
-
-    gl->VertexAttribPointer (attr_position_loc, 3, GL_FLOAT,
-        GL_FALSE, 5 * sizeof (GLfloat), (void *) 0);
-
-    gl->VertexAttribPointer (attr_texture_loc, 2, GL_FLOAT,
-        GL_FALSE, 5 * sizeof (GLfloat), (void *) (3 * sizeof (GLfloat)));
-
-    gl->DrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+    _batch_add_pad (&batch, pad, mix_pad->current_texture, matrix);
 
     walk = g_list_next (walk);
   }
 
+  _draw_batch (video_mixer, &batch);
+
   video_mixer->output_geo_change = FALSE;
   GST_OBJECT_UNLOCK (video_mixer);
 
-  gl->DisableVertexAttribArray (attr_position_loc);
-  gl->DisableVertexAttribArray (attr_texture_loc);
+  gl->DisableVertexAttribArray (batch.attr_position_loc);
+  gl->DisableVertexAttribArray (batch.attr_texture_loc);
+  gl->DisableVertexAttribArray (batch.attr_alpha_loc);
+  gl->DisableVertexAttribArray (batch.attr_unit_loc);
 
   if (gl->GenVertexArrays)
     gl->BindVertexArray (0);
 
   gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
   gl->BindBuffer (GL_ARRAY_BUFFER, 0);
-  gl->BindTexture (GL_TEXTURE_2D, 0);
+  for (i = BATCH_SIZE; i > 0; i--) {
+    gl->ActiveTexture (GL_TEXTURE0 + i - 1);
+    gl->BindTexture (GL_TEXTURE_2D, 0);
+  }
 
   gl->Disable (GL_BLEND);
 
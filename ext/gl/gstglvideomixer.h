@@ -125,6 +125,8 @@ struct _GstGLVideoMixer
     GLuint vao;
     GLuint vbo_indices;
     GLuint checker_vbo;
+    GLuint batch_vbo;
+    GLuint batch_indices;
     GstGLMemory *out_tex;
 
     gboolean output_geo_change;
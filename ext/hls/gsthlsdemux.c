@@ -61,7 +61,26 @@ GST_DEBUG_CATEGORY (gst_hls_demux_debug);
 #define GST_M3U8_CLIENT_LOCK(l) /* FIXME */
 #define GST_M3U8_CLIENT_UNLOCK(l)       /* FIXME */
 
+enum
+{
+  PROP_0,
+
+  PROP_LOW_LATENCY,
+  PROP_LAST
+};
+
+#define DEFAULT_LOW_LATENCY FALSE
+
+/* Encrypted data is collected until at least this much is available before
+ * it is decrypted, so the cipher runs over large contiguous blocks instead
+ * of every small buffer the source pushes */
+#define GST_HLS_DEMUX_DECRYPT_BATCH_SIZE (64 * 1024)
+
 /* GObject */
+static void gst_hls_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_hls_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_hls_demux_finalize (GObject * obj);
 
 /* GstElement */
@@ -81,6 +100,8 @@ static gboolean
 gst_hls_demux_stream_decrypt_start (GstHLSDemuxStream * stream,
     const guint8 * key_data, const guint8 * iv_data);
 static void gst_hls_demux_stream_decrypt_end (GstHLSDemuxStream * stream);
+static GstFlowReturn gst_hls_demux_stream_decrypt_pending (GstAdaptiveDemux *
+    demux, GstAdaptiveDemuxStream * stream, gboolean at_eos);
 
 static gboolean gst_hls_demux_is_live (GstAdaptiveDemux * demux);
 static GstClockTime gst_hls_demux_get_duration (GstAdaptiveDemux * demux);
@@ -107,6 +128,10 @@ static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
+static gboolean gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream *
+    stream, guint offset, GstAdaptiveDemuxStreamFragment * fragment);
+static gboolean gst_hls_demux_stream_get_bitrates (GstAdaptiveDemuxStream *
+    stream, GArray * bitrates, guint64 * current_bitrate);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate);
 static void gst_hls_demux_reset (GstAdaptiveDemux * demux);
@@ -145,8 +170,17 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   element_class = (GstElementClass *) klass;
   adaptivedemux_class = (GstAdaptiveDemuxClass *) klass;
 
+  gobject_class->set_property = gst_hls_demux_set_property;
+  gobject_class->get_property = gst_hls_demux_get_property;
   gobject_class->finalize = gst_hls_demux_finalize;
 
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Play live streams close to the live edge using partial segments "
+          "(EXT-X-PART), preload hints and blocking playlist reloads when "
+          "the server offers them",
+          DEFAULT_LOW_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class->change_state = GST_DEBUG_FUNCPTR (gst_hls_demux_change_state);
 
   gst_element_class_add_static_pad_template (element_class, &srctemplate);
@@ -174,7 +208,10 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
+  adaptivedemux_class->stream_peek_fragment =
+      gst_hls_demux_stream_peek_fragment;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
+  adaptivedemux_class->stream_get_bitrates = gst_hls_demux_stream_get_bitrates;
   adaptivedemux_class->stream_free = gst_hls_demux_stream_free;
 
   adaptivedemux_class->start_fragment = gst_hls_demux_start_fragment;
@@ -193,6 +230,40 @@ gst_hls_demux_init (GstHLSDemux * demux)
 
   demux->keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
   g_mutex_init (&demux->keys_lock);
+
+  demux->low_latency = DEFAULT_LOW_LATENCY;
+}
+
+static void
+gst_hls_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstHLSDemux *demux = GST_HLS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      demux->low_latency = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_hls_demux_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstHLSDemux *demux = GST_HLS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, demux->low_latency);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static GstStateChangeReturn
@@ -452,6 +523,8 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
   hls_stream->playlist->sequence = current_sequence;
   hls_stream->playlist->current_file = walk;
   hls_stream->playlist->sequence_position = current_pos;
+  hls_stream->playlist->part_index = 0;
+  hls_stream->playlist->current_is_part = FALSE;
   GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
 
   /* Play from the end of the current selected segment */
@@ -563,6 +636,22 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
   if (hlsdemux->current_variant == variant || variant == NULL)
     return;
 
+  if (hlsdemux->low_latency) {
+    gint i;
+
+    gst_m3u8_set_low_latency (variant->m3u8, TRUE);
+    for (i = 0; i < GST_HLS_N_MEDIA_TYPES; ++i) {
+      GList *mlist;
+
+      for (mlist = variant->media[i]; mlist; mlist = mlist->next) {
+        GstHLSMedia *media = mlist->data;
+
+        if (media->playlist)
+          gst_m3u8_set_low_latency (media->playlist, TRUE);
+      }
+    }
+  }
+
   if (hlsdemux->current_variant != NULL) {
     gint i;
 
@@ -572,6 +661,7 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
     variant->m3u8->sequence_position =
         hlsdemux->current_variant->m3u8->sequence_position;
     variant->m3u8->sequence = hlsdemux->current_variant->m3u8->sequence;
+    variant->m3u8->part_index = hlsdemux->current_variant->m3u8->part_index;
 
     GST_DEBUG_OBJECT (hlsdemux,
         "Switching Variant. Copying over sequence %" G_GINT64_FORMAT
@@ -588,6 +678,7 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
 
         if (new_media) {
           new_media->playlist->sequence = old_media->playlist->sequence;
+          new_media->playlist->part_index = old_media->playlist->part_index;
           new_media->playlist->sequence_position =
               old_media->playlist->sequence_position;
         }
@@ -902,8 +993,13 @@ gst_hls_demux_finish_fragment (GstAdaptiveDemux * demux,
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);   // FIXME: pass HlsStream into function
   GstFlowReturn ret = GST_FLOW_OK;
 
-  if (hls_stream->current_key)
+  if (hls_stream->current_key) {
+    if (stream->last_ret == GST_FLOW_OK)
+      ret = gst_hls_demux_stream_decrypt_pending (demux, stream, TRUE);
     gst_hls_demux_stream_decrypt_end (hls_stream);
+    if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)
+      return ret;
+  }
 
   if (stream->last_ret == GST_FLOW_OK) {
     if (hls_stream->pending_decrypted_buffer) {
@@ -957,48 +1053,62 @@ gst_hls_demux_finish_fragment (GstAdaptiveDemux * demux,
   return ret;
 }
 
+/* Decrypts the collected encrypted data once enough of it is available, or
+ * everything that is left at the end of the fragment */
+static GstFlowReturn
+gst_hls_demux_stream_decrypt_pending (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, gboolean at_eos)
+{
+  GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
+  GError *err = NULL;
+  GstBuffer *buffer, *tmp_buffer;
+  gsize size;
+
+  if (hls_stream->pending_encrypted_data == NULL)
+    return GST_FLOW_OK;
+
+  size = gst_adapter_available (hls_stream->pending_encrypted_data);
+
+  /* must be a multiple of 16 */
+  size &= (~0xF);
+
+  if (size == 0 || (!at_eos && size < GST_HLS_DEMUX_DECRYPT_BATCH_SIZE))
+    return GST_FLOW_OK;
+
+  buffer = gst_adapter_take_buffer (hls_stream->pending_encrypted_data, size);
+  buffer = gst_hls_demux_decrypt_fragment (hlsdemux, hls_stream, buffer, &err);
+  if (buffer == NULL) {
+    GST_ELEMENT_ERROR (demux, STREAM, DECODE, ("Failed to decrypt buffer"),
+        ("decryption failed %s", err->message));
+    g_error_free (err);
+    return GST_FLOW_ERROR;
+  }
+
+  /* keep the last decrypted buffer around for the pkcs7 unpadding */
+  tmp_buffer = hls_stream->pending_decrypted_buffer;
+  hls_stream->pending_decrypted_buffer = buffer;
+
+  return gst_hls_demux_handle_buffer (demux, stream, tmp_buffer, FALSE);
+}
+
 static GstFlowReturn
 gst_hls_demux_data_received (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
 {
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
-  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
 
   if (hls_stream->current_offset == -1)
     hls_stream->current_offset = 0;
 
   /* Is it encrypted? */
   if (hls_stream->current_key) {
-    GError *err = NULL;
-    gsize size;
-    GstBuffer *tmp_buffer;
-
     if (hls_stream->pending_encrypted_data == NULL)
       hls_stream->pending_encrypted_data = gst_adapter_new ();
 
     gst_adapter_push (hls_stream->pending_encrypted_data, buffer);
-    size = gst_adapter_available (hls_stream->pending_encrypted_data);
 
-    /* must be a multiple of 16 */
-    size &= (~0xF);
-
-    if (size == 0) {
-      return GST_FLOW_OK;
-    }
-
-    buffer = gst_adapter_take_buffer (hls_stream->pending_encrypted_data, size);
-    buffer =
-        gst_hls_demux_decrypt_fragment (hlsdemux, hls_stream, buffer, &err);
-    if (buffer == NULL) {
-      GST_ELEMENT_ERROR (demux, STREAM, DECODE, ("Failed to decrypt buffer"),
-          ("decryption failed %s", err->message));
-      g_error_free (err);
-      return GST_FLOW_ERROR;
-    }
-
-    tmp_buffer = hls_stream->pending_decrypted_buffer;
-    hls_stream->pending_decrypted_buffer = buffer;
-    buffer = tmp_buffer;
+    return gst_hls_demux_stream_decrypt_pending (demux, stream, FALSE);
   }
 
   return gst_hls_demux_handle_buffer (demux, stream, buffer, FALSE);
@@ -1126,6 +1236,70 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream * stream,
+    guint offset, GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstHLSDemuxStream *hlsdemux_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (hlsdemux_stream);
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0,
+      offset);
+  if (file == NULL)
+    return FALSE;
+
+  g_free (fragment->uri);
+  fragment->uri = g_strdup (file->uri);
+  fragment->range_start = file->offset;
+  if (file->size != -1)
+    fragment->range_end = file->offset + file->size - 1;
+  else
+    fragment->range_end = -1;
+  fragment->duration = file->duration;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
+static gboolean
+gst_hls_demux_stream_get_bitrates (GstAdaptiveDemuxStream * stream,
+    GArray * bitrates, guint64 * current_bitrate)
+{
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (stream->demux);
+  GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstHLSVariantStream *current;
+  GList *l;
+
+  /* only the primary stream switches variants */
+  if (hls_stream->is_primary_playlist == FALSE)
+    return FALSE;
+
+  GST_M3U8_CLIENT_LOCK (hlsdemux->client);
+  current = hlsdemux->current_variant;
+  if (hlsdemux->master == NULL || hlsdemux->master->is_simple
+      || current == NULL) {
+    GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
+    return FALSE;
+  }
+
+  l = current->iframe ? hlsdemux->master->iframe_variants :
+      hlsdemux->master->variants;
+  for (; l; l = l->next) {
+    GstHLSVariantStream *variant = l->data;
+    guint64 bandwidth = variant->bandwidth;
+
+    g_array_append_val (bitrates, bandwidth);
+  }
+  *current_bitrate = current->bandwidth;
+  GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
+
+  return TRUE;
+}
+
 static gboolean
 gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
 {
@@ -1316,18 +1490,22 @@ gst_hls_demux_update_rendition_manifest (GstHLSDemux * demux,
   gchar *playlist;
   const gchar *main_uri;
   GstM3U8 *m3u8;
-  gchar *uri = media->uri;
+  gchar *uri = NULL;
+
+  m3u8 = media->playlist;
+
+  if (demux->low_latency && gst_m3u8_can_block_reload (m3u8))
+    uri = gst_m3u8_get_reload_uri (m3u8);
 
   main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
   download =
-      gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri, main_uri,
-      TRUE, TRUE, TRUE, err);
+      gst_uri_downloader_fetch_uri (adaptive_demux->downloader,
+      uri ? uri : media->uri, main_uri, TRUE, TRUE, TRUE, err);
+  g_free (uri);
 
   if (download == NULL)
     return FALSE;
 
-  m3u8 = media->playlist;
-
   /* Set the base URI of the playlist to the redirect target if any */
   if (download->redirect_permanent && download->redirect_uri) {
     gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL, media->name);
@@ -1372,7 +1550,10 @@ gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean update,
   gint i;
 
 retry:
-  uri = gst_m3u8_get_uri (demux->current_variant->m3u8);
+  if (demux->low_latency && update)
+    uri = gst_m3u8_get_reload_uri (demux->current_variant->m3u8);
+  else
+    uri = gst_m3u8_get_uri (demux->current_variant->m3u8);
   main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
   download =
       gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri, main_uri,
@@ -1488,8 +1669,12 @@ retry:
   }
 
   /* If it's a live source, do not let the sequence number go beyond
-   * three fragments before the end of the list */
-  if (update == FALSE && gst_m3u8_is_live (m3u8)) {
+   * three fragments before the end of the list. In low-latency mode the
+   * playlist already picked its start from the part hold back */
+  if (update == FALSE && gst_m3u8_is_live (m3u8) && m3u8->low_latency) {
+    GST_DEBUG_OBJECT (demux, "Low-latency start at sequence %" G_GINT64_FORMAT
+        ", part %d", m3u8->sequence, m3u8->part_index);
+  } else if (update == FALSE && gst_m3u8_is_live (m3u8)) {
     gint64 last_sequence, first_sequence;
 
     GST_M3U8_CLIENT_LOCK (demux->client);
@@ -1769,8 +1954,13 @@ decrypt_fragment (GstHLSDemuxStream * stream, gsize length,
 {
   gcry_error_t err = 0;
 
-  err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length,
-      encrypted_data, length);
+  /* libgcrypt wants NULL input for in-place operation */
+  if (encrypted_data == decrypted_data)
+    err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length,
+        NULL, 0);
+  else
+    err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length,
+        encrypted_data, length);
 
   return err == 0;
 }
@@ -1789,39 +1979,32 @@ static GstBuffer *
 gst_hls_demux_decrypt_fragment (GstHLSDemux * demux, GstHLSDemuxStream * stream,
     GstBuffer * encrypted_buffer, GError ** err)
 {
-  GstBuffer *decrypted_buffer = NULL;
-  GstMapInfo encrypted_info, decrypted_info;
-
-  decrypted_buffer =
-      gst_buffer_new_allocate (NULL, gst_buffer_get_size (encrypted_buffer),
-      NULL);
-
-  gst_buffer_map (encrypted_buffer, &encrypted_info, GST_MAP_READ);
-  gst_buffer_map (decrypted_buffer, &decrypted_info, GST_MAP_WRITE);
+  GstBuffer *buffer;
+  GstMapInfo info;
 
-  if (!decrypt_fragment (stream, encrypted_info.size,
-          encrypted_info.data, decrypted_info.data))
+  /* CBC decryption works in place, this only copies the data if the
+   * memory is shared with someone else */
+  buffer = gst_buffer_make_writable (encrypted_buffer);
+  if (!gst_buffer_map (buffer, &info, GST_MAP_READWRITE)) {
+    gst_buffer_unref (buffer);
     goto decrypt_error;
+  }
 
+  if (!decrypt_fragment (stream, info.size, info.data, info.data)) {
+    gst_buffer_unmap (buffer, &info);
+    gst_buffer_unref (buffer);
+    goto decrypt_error;
+  }
 
-  gst_buffer_unmap (decrypted_buffer, &decrypted_info);
-  gst_buffer_unmap (encrypted_buffer, &encrypted_info);
-
-  gst_buffer_unref (encrypted_buffer);
+  gst_buffer_unmap (buffer, &info);
 
-  return decrypted_buffer;
+  return buffer;
 
 decrypt_error:
   GST_ERROR_OBJECT (demux, "Failed to decrypt fragment");
   g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_DECRYPT,
       "Failed to decrypt fragment");
 
-  gst_buffer_unmap (decrypted_buffer, &decrypted_info);
-  gst_buffer_unmap (encrypted_buffer, &encrypted_info);
-
-  gst_buffer_unref (encrypted_buffer);
-  gst_buffer_unref (decrypted_buffer);
-
   return NULL;
 }
 
@@ -1831,6 +2014,18 @@ gst_hls_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
   GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
   GstClockTime target_duration;
 
+  if (hlsdemux->low_latency && hlsdemux->current_variant) {
+    GstM3U8 *m3u8 = hlsdemux->current_variant->m3u8;
+    GstClockTime part_target = gst_m3u8_get_part_target (m3u8);
+
+    /* blocking reloads are held by the server until the next partial
+     * segment is available, so they can be issued right away */
+    if (gst_m3u8_can_block_reload (m3u8))
+      return 0;
+    if (GST_CLOCK_TIME_IS_VALID (part_target))
+      return gst_util_uint64_scale (part_target, G_USEC_PER_SEC, GST_SECOND);
+  }
+
   if (hlsdemux->current_variant) {
     target_duration =
         gst_m3u8_get_target_duration (hlsdemux->current_variant->m3u8);
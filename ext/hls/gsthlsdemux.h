@@ -147,6 +147,9 @@ struct _GstHLSDemux
   GstHLSMasterPlaylist *master;
 
   GstHLSVariantStream  *current_variant;
+
+  /* properties */
+  gboolean low_latency;
 };
 
 struct _GstHLSDemuxClass
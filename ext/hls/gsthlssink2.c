@@ -29,6 +29,16 @@
  * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! hlssink max-files=5
  * ]|
  *
+ * With #GstHlsSink2:segment-format set to fmp4, the streams are muxed into
+ * fragmented MP4 by a single mp4mux and every fragment is written directly
+ * to its own segment file. All of them share the init segment written to
+ * #GstHlsSink2:init-location, which the playlist references with
+ * EXT-X-MAP, so the output can also be referenced from a DASH manifest.
+ * |[
+ * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! hlssink2 \
+ *     segment-format=fmp4 location=segment%05d.m4s
+ * ]|
+ *
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -39,6 +49,8 @@
 #include <gst/video/video.h>
 #include <glib/gstdio.h>
 #include <memory.h>
+#include <string.h>
+#include <errno.h>
 
 
 GST_DEBUG_CATEGORY_STATIC (gst_hls_sink2_debug);
@@ -50,8 +62,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_hls_sink2_debug);
 #define DEFAULT_MAX_FILES 10
 #define DEFAULT_TARGET_DURATION 15
 #define DEFAULT_PLAYLIST_LENGTH 5
+#define DEFAULT_SEGMENT_FORMAT GST_HLS_SINK2_SEGMENT_FORMAT_MPEGTS
+#define DEFAULT_INIT_LOCATION "init.mp4"
 
 #define GST_M3U8_PLAYLIST_VERSION 3
+/* needed for EXT-X-MAP in media playlists */
+#define GST_M3U8_PLAYLIST_FMP4_VERSION 7
 
 enum
 {
@@ -61,9 +77,31 @@ enum
   PROP_PLAYLIST_ROOT,
   PROP_MAX_FILES,
   PROP_TARGET_DURATION,
-  PROP_PLAYLIST_LENGTH
+  PROP_PLAYLIST_LENGTH,
+  PROP_SEGMENT_FORMAT,
+  PROP_INIT_LOCATION
 };
 
+GType
+gst_hls_sink2_segment_format_get_type (void)
+{
+  static volatile gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_HLS_SINK2_SEGMENT_FORMAT_MPEGTS, "MPEG transport stream segments",
+        "mpegts"},
+    {GST_HLS_SINK2_SEGMENT_FORMAT_FMP4,
+        "Fragmented MP4 segments sharing one init segment", "fmp4"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = g_enum_register_static ("GstHlsSink2SegmentFormat", values);
+    g_once_init_leave (&type, _type);
+  }
+
+  return type;
+}
+
 static GstStaticPadTemplate video_template = GST_STATIC_PAD_TEMPLATE ("video",
     GST_PAD_SINK,
     GST_PAD_REQUEST,
@@ -87,6 +125,9 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans);
 static GstPad *gst_hls_sink2_request_new_pad (GstElement * element,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 static void gst_hls_sink2_release_pad (GstElement * element, GstPad * pad);
+static void gst_hls_sink2_setup_elements (GstHlsSink2 * sink);
+static GstPadProbeReturn gst_hls_sink2_fmp4_probe (GstPad * pad,
+    GstPadProbeInfo * info, gpointer user_data);
 
 static void
 gst_hls_sink2_dispose (GObject * object)
@@ -104,6 +145,9 @@ gst_hls_sink2_finalize (GObject * object)
   g_free (sink->location);
   g_free (sink->playlist_location);
   g_free (sink->playlist_root);
+  g_free (sink->init_location);
+  g_free (sink->playlist_header);
+  g_free (sink->current_location);
   if (sink->playlist)
     gst_m3u8_playlist_free (sink->playlist);
 
@@ -176,34 +220,120 @@ gst_hls_sink2_class_init (GstHlsSink2Class * klass)
           "the playlist will be infinite.",
           0, G_MAXUINT, DEFAULT_PLAYLIST_LENGTH,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SEGMENT_FORMAT,
+      g_param_spec_enum ("segment-format", "Segment format",
+          "Container format of the segments. Can only be changed before any "
+          "pad is requested", GST_TYPE_HLS_SINK2_SEGMENT_FORMAT,
+          DEFAULT_SEGMENT_FORMAT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_INIT_LOCATION,
+      g_param_spec_string ("init-location", "Init segment location",
+          "Location of the init segment shared by all fMP4 segments",
+          DEFAULT_INIT_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_hls_sink2_init (GstHlsSink2 * sink)
 {
-  GstElement *mux;
-
   sink->location = g_strdup (DEFAULT_LOCATION);
   sink->playlist_location = g_strdup (DEFAULT_PLAYLIST_LOCATION);
   sink->playlist_root = g_strdup (DEFAULT_PLAYLIST_ROOT);
   sink->playlist_length = DEFAULT_PLAYLIST_LENGTH;
   sink->max_files = DEFAULT_MAX_FILES;
   sink->target_duration = DEFAULT_TARGET_DURATION;
+  sink->segment_format = DEFAULT_SEGMENT_FORMAT;
+  sink->init_location = g_strdup (DEFAULT_INIT_LOCATION);
   g_queue_init (&sink->old_locations);
 
-  sink->splitmuxsink = gst_element_factory_make ("splitmuxsink", NULL);
-  gst_bin_add (GST_BIN (sink), sink->splitmuxsink);
-
-  mux = gst_element_factory_make ("mpegtsmux", NULL);
-  g_object_set (sink->splitmuxsink, "location", sink->location, "max-size-time",
-      ((GstClockTime) sink->target_duration * GST_SECOND),
-      "send-keyframe-requests", TRUE, "muxer", mux, NULL);
+  gst_hls_sink2_setup_elements (sink);
 
   GST_OBJECT_FLAG_SET (sink, GST_ELEMENT_FLAG_SINK);
 
   gst_hls_sink2_reset (sink);
 }
 
+/* (Re)creates the internal elements for the current segment format */
+static void
+gst_hls_sink2_setup_elements (GstHlsSink2 * sink)
+{
+  GstElement *mux;
+  GstPad *pad;
+
+  if (sink->splitmuxsink) {
+    gst_bin_remove (GST_BIN (sink), sink->splitmuxsink);
+    sink->splitmuxsink = NULL;
+  }
+  if (sink->mp4mux) {
+    gst_bin_remove (GST_BIN (sink), sink->mp4mux);
+    gst_bin_remove (GST_BIN (sink), sink->fakesink);
+    sink->mp4mux = sink->fakesink = NULL;
+  }
+
+  if (sink->segment_format == GST_HLS_SINK2_SEGMENT_FORMAT_MPEGTS) {
+    sink->splitmuxsink = gst_element_factory_make ("splitmuxsink", NULL);
+    if (sink->splitmuxsink == NULL)
+      return;
+    gst_bin_add (GST_BIN (sink), sink->splitmuxsink);
+
+    mux = gst_element_factory_make ("mpegtsmux", NULL);
+    g_object_set (sink->splitmuxsink, "location", sink->location,
+        "max-size-time", ((GstClockTime) sink->target_duration * GST_SECOND),
+        "send-keyframe-requests", TRUE, "muxer", mux, NULL);
+    return;
+  }
+
+  sink->mp4mux = gst_element_factory_make ("mp4mux", NULL);
+  sink->fakesink = gst_element_factory_make ("fakesink", NULL);
+  if (sink->mp4mux == NULL || sink->fakesink == NULL) {
+    if (sink->mp4mux)
+      gst_object_unref (sink->mp4mux);
+    if (sink->fakesink)
+      gst_object_unref (sink->fakesink);
+    sink->mp4mux = sink->fakesink = NULL;
+    return;
+  }
+
+  /* one moof per segment, and the moov is written up front */
+  g_object_set (sink->mp4mux, "fragment-duration",
+      sink->target_duration * 1000, "streamable", TRUE, NULL);
+  g_object_set (sink->fakesink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (sink), sink->mp4mux, sink->fakesink, NULL);
+  gst_element_link (sink->mp4mux, sink->fakesink);
+
+  pad = gst_element_get_static_pad (sink->mp4mux, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      gst_hls_sink2_fmp4_probe, sink, NULL);
+  gst_object_unref (pad);
+}
+
+static gchar *
+gst_hls_sink2_get_entry_location (GstHlsSink2 * sink, const gchar * location)
+{
+  gchar *name = g_path_get_basename (location);
+  gchar *entry_location;
+
+  if (sink->playlist_root == NULL)
+    return name;
+
+  entry_location = g_build_filename (sink->playlist_root, name, NULL);
+  g_free (name);
+
+  return entry_location;
+}
+
+static void
+gst_hls_sink2_close_fmp4_files (GstHlsSink2 * sink)
+{
+  if (sink->init_file)
+    fclose (sink->init_file);
+  sink->init_file = NULL;
+  if (sink->segment_file)
+    fclose (sink->segment_file);
+  sink->segment_file = NULL;
+  sink->box_remaining = 0;
+  sink->segment_start = sink->segment_end = GST_CLOCK_TIME_NONE;
+}
+
 static void
 gst_hls_sink2_reset (GstHlsSink2 * sink)
 {
@@ -211,31 +341,310 @@ gst_hls_sink2_reset (GstHlsSink2 * sink)
 
   if (sink->playlist)
     gst_m3u8_playlist_free (sink->playlist);
-  sink->playlist =
-      gst_m3u8_playlist_new (GST_M3U8_PLAYLIST_VERSION, sink->playlist_length,
-      FALSE);
+  if (sink->segment_format == GST_HLS_SINK2_SEGMENT_FORMAT_FMP4) {
+    sink->playlist = gst_m3u8_playlist_new (GST_M3U8_PLAYLIST_FMP4_VERSION,
+        sink->playlist_length, FALSE);
+    sink->playlist->map_uri =
+        gst_hls_sink2_get_entry_location (sink, sink->init_location);
+  } else {
+    sink->playlist =
+        gst_m3u8_playlist_new (GST_M3U8_PLAYLIST_VERSION,
+        sink->playlist_length, FALSE);
+  }
+  g_free (sink->playlist_header);
+  sink->playlist_header = NULL;
+
+  gst_hls_sink2_close_fmp4_files (sink);
+  g_free (sink->current_location);
+  sink->current_location = NULL;
 
   g_queue_foreach (&sink->old_locations, (GFunc) g_free, NULL);
   g_queue_clear (&sink->old_locations);
 }
 
+static gboolean
+gst_hls_sink2_replace_playlist (GstHlsSink2 * sink, const gchar * content,
+    GError ** error)
+{
+  gchar *tmp_location;
+  FILE *file;
+  gboolean ret = FALSE;
+  gsize len = strlen (content);
+
+  /* Readers must always see a complete playlist, so write it next to the
+   * old one and rename it over. Contrary to g_file_set_contents() this
+   * doesn't fsync() on every segment, losing the playlist on a crash is
+   * harmless as it is rewritten with the next segment */
+  tmp_location = g_strdup_printf ("%s.tmp", sink->playlist_location);
+  file = g_fopen (tmp_location, "wb");
+  if (file == NULL)
+    goto done;
+  if (fwrite (content, 1, len, file) != len) {
+    fclose (file);
+    g_remove (tmp_location);
+    goto done;
+  }
+  if (fclose (file) != 0 || g_rename (tmp_location, sink->playlist_location)) {
+    g_remove (tmp_location);
+    goto done;
+  }
+  ret = TRUE;
+
+done:
+  if (!ret) {
+    gint errsv = errno;
+
+    g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+        "%s: %s", tmp_location, g_strerror (errsv));
+  }
+  g_free (tmp_location);
+  return ret;
+}
+
+/* Appends the last entry to the playlist written before, if the rest
+ * of it is still the same */
+static gboolean
+gst_hls_sink2_append_playlist (GstHlsSink2 * sink, const gchar * header)
+{
+  gchar *content;
+  FILE *file;
+  gsize len;
+  gboolean ret;
+
+  if (sink->playlist_header == NULL || strcmp (sink->playlist_header,
+          header) != 0 || sink->playlist->entries->length != sink->index
+      || sink->playlist->end_list)
+    return FALSE;
+
+  file = g_fopen (sink->playlist_location, "ab");
+  if (file == NULL)
+    return FALSE;
+
+  content = gst_m3u8_playlist_render_last_entry (sink->playlist);
+  len = strlen (content);
+  ret = fwrite (content, 1, len, file) == len;
+  ret &= fclose (file) == 0;
+  g_free (content);
+
+  return ret;
+}
+
 static void
 gst_hls_sink2_write_playlist (GstHlsSink2 * sink)
 {
   char *playlist_content;
+  gchar *header;
   GError *error = NULL;
 
+  /* Infinite playlists only ever grow, write just the new entry */
+  header = gst_m3u8_playlist_render_header (sink->playlist);
+  if (sink->playlist_length == 0
+      && gst_hls_sink2_append_playlist (sink, header)) {
+    g_free (header);
+    return;
+  }
+
   playlist_content = gst_m3u8_playlist_render (sink->playlist);
-  if (!g_file_set_contents (sink->playlist_location,
-          playlist_content, -1, &error)) {
+  if (!gst_hls_sink2_replace_playlist (sink, playlist_content, &error)) {
     GST_ERROR ("Failed to write playlist: %s", error->message);
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
         (("Failed to write playlist '%s'."), error->message), (NULL));
     g_error_free (error);
     error = NULL;
+    g_free (header);
+    header = NULL;
   }
   g_free (playlist_content);
 
+  g_free (sink->playlist_header);
+  sink->playlist_header = header;
+}
+
+static void
+gst_hls_sink2_add_fragment (GstHlsSink2 * sink, GstClockTime duration)
+{
+  gchar *entry_location;
+
+  GST_INFO_OBJECT (sink, "COUNT %d", sink->index);
+  entry_location =
+      gst_hls_sink2_get_entry_location (sink, sink->current_location);
+
+  gst_m3u8_playlist_add_entry (sink->playlist, entry_location,
+      NULL, duration, sink->index++, FALSE);
+  g_free (entry_location);
+
+  gst_hls_sink2_write_playlist (sink);
+
+  g_queue_push_tail (&sink->old_locations, g_strdup (sink->current_location));
+
+  while (g_queue_get_length (&sink->old_locations) >
+      g_queue_get_length (sink->playlist->entries)) {
+    gchar *old_location = g_queue_pop_head (&sink->old_locations);
+    g_remove (old_location);
+    g_free (old_location);
+  }
+}
+
+/* called from the streaming thread of mp4mux */
+static void
+gst_hls_sink2_finish_fmp4_segment (GstHlsSink2 * sink)
+{
+  GstClockTime duration;
+
+  if (sink->segment_file == NULL)
+    return;
+
+  fclose (sink->segment_file);
+  sink->segment_file = NULL;
+
+  if (GST_CLOCK_TIME_IS_VALID (sink->segment_start)
+      && GST_CLOCK_TIME_IS_VALID (sink->segment_end)
+      && sink->segment_end > sink->segment_start)
+    duration = sink->segment_end - sink->segment_start;
+  else
+    duration = (GstClockTime) sink->target_duration * GST_SECOND;
+  sink->segment_start = sink->segment_end = GST_CLOCK_TIME_NONE;
+
+  gst_hls_sink2_add_fragment (sink, duration);
+}
+
+static gboolean
+gst_hls_sink2_start_fmp4_segment (GstHlsSink2 * sink)
+{
+  g_free (sink->current_location);
+  sink->current_location = g_strdup_printf (sink->location, sink->index);
+
+  sink->segment_file = g_fopen (sink->current_location, "wb");
+  if (sink->segment_file == NULL) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
+        (("Could not open file \"%s\" for writing."), sink->current_location),
+        GST_ERROR_SYSTEM);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Splits the mp4mux output at its top-level boxes: ftyp and moov go to the
+ * init segment, a moof starts the next media segment. */
+static gboolean
+gst_hls_sink2_write_fmp4 (GstHlsSink2 * sink, GstBuffer * buffer)
+{
+  GstMapInfo map;
+  gsize offset = 0;
+  gboolean ret = TRUE;
+
+  if (GST_BUFFER_PTS_IS_VALID (buffer) && sink->segment_file) {
+    GstClockTime end = GST_BUFFER_PTS (buffer);
+
+    if (GST_BUFFER_DURATION_IS_VALID (buffer))
+      end += GST_BUFFER_DURATION (buffer);
+    if (!GST_CLOCK_TIME_IS_VALID (sink->segment_start))
+      sink->segment_start = GST_BUFFER_PTS (buffer);
+    if (!GST_CLOCK_TIME_IS_VALID (sink->segment_end)
+        || end > sink->segment_end)
+      sink->segment_end = end;
+  }
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return FALSE;
+
+  while (ret && offset < map.size) {
+    FILE *file;
+    gsize len;
+
+    if (sink->box_remaining == 0 && map.size - offset >= 8) {
+      guint64 size = GST_READ_UINT32_BE (map.data + offset);
+      guint32 fourcc = GST_READ_UINT32_LE (map.data + offset + 4);
+
+      if (size == 1 && map.size - offset >= 16)
+        size = GST_READ_UINT64_BE (map.data + offset + 8);
+      else if (size < 8)
+        size = G_MAXUINT64;
+
+      switch (fourcc) {
+        case GST_MAKE_FOURCC ('f', 't', 'y', 'p'):
+        case GST_MAKE_FOURCC ('m', 'o', 'o', 'v'):
+          /* a new init segment also ends the current media segment */
+          gst_hls_sink2_finish_fmp4_segment (sink);
+          if (sink->init_file == NULL) {
+            sink->init_file = g_fopen (sink->init_location, "wb");
+            if (sink->init_file == NULL) {
+              GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
+                  (("Could not open file \"%s\" for writing."),
+                      sink->init_location), GST_ERROR_SYSTEM);
+              ret = FALSE;
+              continue;
+            }
+          }
+          break;
+        case GST_MAKE_FOURCC ('m', 'o', 'o', 'f'):
+          if (sink->init_file) {
+            fclose (sink->init_file);
+            sink->init_file = NULL;
+          }
+          gst_hls_sink2_finish_fmp4_segment (sink);
+          if (!gst_hls_sink2_start_fmp4_segment (sink)) {
+            ret = FALSE;
+            continue;
+          }
+          break;
+        case GST_MAKE_FOURCC ('m', 'f', 'r', 'a'):
+          /* random access index at the very end, not part of a segment */
+          gst_hls_sink2_finish_fmp4_segment (sink);
+          break;
+        default:
+          break;
+      }
+      sink->box_remaining = size;
+    }
+
+    len = MIN (map.size - offset, sink->box_remaining);
+    if (len == 0)
+      len = map.size - offset;
+
+    file = sink->segment_file ? sink->segment_file : sink->init_file;
+    if (file && fwrite (map.data + offset, 1, len, file) != len) {
+      GST_ELEMENT_ERROR (sink, RESOURCE, WRITE,
+          (("Error while writing to file \"%s\"."),
+              sink->segment_file ? sink->current_location :
+              sink->init_location), GST_ERROR_SYSTEM);
+      ret = FALSE;
+    }
+
+    if (sink->box_remaining != G_MAXUINT64)
+      sink->box_remaining -= MIN (len, sink->box_remaining);
+    offset += len;
+  }
+
+  gst_buffer_unmap (buffer, &map);
+  return ret;
+}
+
+static GstPadProbeReturn
+gst_hls_sink2_fmp4_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstHlsSink2 *sink = GST_HLS_SINK2_CAST (user_data);
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    if (!gst_hls_sink2_write_fmp4 (sink, GST_PAD_PROBE_INFO_BUFFER (info)))
+      return GST_PAD_PROBE_DROP;
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0; i < len; i++) {
+      if (!gst_hls_sink2_write_fmp4 (sink, gst_buffer_list_get (list, i)))
+        return GST_PAD_PROBE_DROP;
+    }
+  } else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+      GST_EVENT_EOS) {
+    /* before the EOS message that finishes the playlist */
+    gst_hls_sink2_finish_fmp4_segment (sink);
+  }
+
+  return GST_PAD_PROBE_OK;
 }
 
 static void
@@ -256,38 +665,14 @@ gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
               &sink->current_running_time_start);
         } else if (gst_structure_has_name (s, "splitmuxsink-fragment-closed")) {
           GstClockTime running_time;
-          gchar *entry_location;
 
           g_assert (strcmp (sink->current_location, gst_structure_get_string (s,
                       "location")) == 0);
 
           gst_structure_get_clock_time (s, "running-time", &running_time);
 
-          GST_INFO_OBJECT (sink, "COUNT %d", sink->index);
-          if (sink->playlist_root == NULL) {
-            entry_location = g_path_get_basename (sink->current_location);
-          } else {
-            gchar *name = g_path_get_basename (sink->current_location);
-            entry_location = g_build_filename (sink->playlist_root, name, NULL);
-            g_free (name);
-          }
-
-          gst_m3u8_playlist_add_entry (sink->playlist, entry_location,
-              NULL, running_time - sink->current_running_time_start,
-              sink->index++, FALSE);
-          g_free (entry_location);
-
-          gst_hls_sink2_write_playlist (sink);
-
-          g_queue_push_tail (&sink->old_locations,
-              g_strdup (sink->current_location));
-
-          while (g_queue_get_length (&sink->old_locations) >
-              g_queue_get_length (sink->playlist->entries)) {
-            gchar *old_location = g_queue_pop_head (&sink->old_locations);
-            g_remove (old_location);
-            g_free (old_location);
-          }
+          gst_hls_sink2_add_fragment (sink,
+              running_time - sink->current_running_time_start);
         }
       }
       break;
@@ -322,9 +707,16 @@ gst_hls_sink2_request_new_pad (GstElement * element, GstPadTemplate * templ,
 
   is_audio = strcmp (templ->name_template, "audio") == 0;
 
-  peer =
-      gst_element_get_request_pad (sink->splitmuxsink,
-      is_audio ? "audio_0" : "video");
+  if (sink->mp4mux)
+    peer =
+        gst_element_get_request_pad (sink->mp4mux,
+        is_audio ? "audio_%u" : "video_%u");
+  else if (sink->splitmuxsink)
+    peer =
+        gst_element_get_request_pad (sink->splitmuxsink,
+        is_audio ? "audio_0" : "video");
+  else
+    peer = NULL;
   if (!peer)
     return NULL;
 
@@ -349,9 +741,10 @@ gst_hls_sink2_release_pad (GstElement * element, GstPad * pad)
 
   g_return_if_fail (pad == sink->audio_sink || pad == sink->video_sink);
 
-  peer = gst_pad_get_peer (pad);
+  peer = gst_ghost_pad_get_target (GST_GHOST_PAD (pad));
   if (peer) {
-    gst_element_release_request_pad (sink->splitmuxsink, pad);
+    gst_element_release_request_pad (sink->mp4mux ? sink->mp4mux :
+        sink->splitmuxsink, peer);
     gst_object_unref (peer);
   }
 
@@ -374,9 +767,10 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans)
 
   switch (trans) {
     case GST_STATE_CHANGE_NULL_TO_READY:
-      if (!sink->splitmuxsink) {
+      if (!sink->splitmuxsink && !sink->mp4mux) {
         return GST_STATE_CHANGE_FAILURE;
       }
+      gst_hls_sink2_reset (sink);
       break;
     default:
       break;
@@ -428,11 +822,28 @@ gst_hls_sink2_set_property (GObject * object, guint prop_id,
         g_object_set (sink->splitmuxsink, "max-size-time",
             ((GstClockTime) sink->target_duration * GST_SECOND), NULL);
       }
+      if (sink->mp4mux) {
+        g_object_set (sink->mp4mux, "fragment-duration",
+            sink->target_duration * 1000, NULL);
+      }
       break;
     case PROP_PLAYLIST_LENGTH:
       sink->playlist_length = g_value_get_uint (value);
       sink->playlist->window_size = sink->playlist_length;
       break;
+    case PROP_SEGMENT_FORMAT:
+      if (sink->audio_sink || sink->video_sink) {
+        g_warning ("Can't change the segment format with requested pads");
+        break;
+      }
+      sink->segment_format = g_value_get_enum (value);
+      gst_hls_sink2_setup_elements (sink);
+      gst_hls_sink2_reset (sink);
+      break;
+    case PROP_INIT_LOCATION:
+      g_free (sink->init_location);
+      sink->init_location = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -464,6 +875,12 @@ gst_hls_sink2_get_property (GObject * object, guint prop_id,
     case PROP_PLAYLIST_LENGTH:
       g_value_set_uint (value, sink->playlist_length);
       break;
+    case PROP_SEGMENT_FORMAT:
+      g_value_set_enum (value, sink->segment_format);
+      break;
+    case PROP_INIT_LOCATION:
+      g_value_set_string (value, sink->init_location);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -21,6 +21,7 @@
 
 #include "gstm3u8playlist.h"
 #include <gst/gst.h>
+#include <stdio.h>
 
 G_BEGIN_DECLS
 
@@ -34,11 +35,36 @@ G_BEGIN_DECLS
 typedef struct _GstHlsSink2 GstHlsSink2;
 typedef struct _GstHlsSink2Class GstHlsSink2Class;
 
+typedef enum
+{
+  GST_HLS_SINK2_SEGMENT_FORMAT_MPEGTS,
+  GST_HLS_SINK2_SEGMENT_FORMAT_FMP4
+} GstHlsSink2SegmentFormat;
+
+#define GST_TYPE_HLS_SINK2_SEGMENT_FORMAT (gst_hls_sink2_segment_format_get_type())
+GType gst_hls_sink2_segment_format_get_type (void);
+
 struct _GstHlsSink2
 {
   GstBin bin;
 
+  GstHlsSink2SegmentFormat segment_format;
+
+  /* MPEG-TS segments, through splitmuxsink */
   GstElement *splitmuxsink;
+
+  /* fMP4 segments, written directly from the output of a fragmenting mp4mux
+   * to files that all share one init segment */
+  GstElement *mp4mux;
+  GstElement *fakesink;
+  gchar *init_location;
+  FILE *init_file;
+  FILE *segment_file;
+  /* remaining bytes of the top-level box being written */
+  guint64 box_remaining;
+  GstClockTime segment_start;
+  GstClockTime segment_end;
+
   GstPad *audio_sink, *video_sink;
 
   gchar *location;
@@ -50,6 +76,9 @@ struct _GstHlsSink2
 
   GstM3U8Playlist *playlist;
   guint index;
+  /* header of the playlist file as last written, to append new entries
+   * instead of rewriting the file when it didn't change */
+  gchar *playlist_header;
 
   gchar *current_location;
   GstClockTime current_running_time_start;
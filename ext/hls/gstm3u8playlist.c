@@ -91,6 +91,7 @@ gst_m3u8_playlist_free (GstM3U8Playlist * playlist)
 
   g_queue_foreach (playlist->entries, (GFunc) gst_m3u8_entry_free, NULL);
   g_queue_free (playlist->entries);
+  g_free (playlist->map_uri);
   g_free (playlist);
 }
 
@@ -142,15 +143,11 @@ gst_m3u8_playlist_target_duration (GstM3U8Playlist * playlist)
   return (guint) ((target_duration + 500 * GST_MSECOND) / GST_SECOND);
 }
 
-gchar *
-gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
+static void
+gst_m3u8_playlist_render_header_to (GstM3U8Playlist * playlist,
+    GString * playlist_str)
 {
-  GString *playlist_str;
-  GList *l;
-
-  g_return_val_if_fail (playlist != NULL, NULL);
-
-  playlist_str = g_string_new ("#EXTM3U\n");
+  g_string_append (playlist_str, "#EXTM3U\n");
 
   g_string_append_printf (playlist_str, "#EXT-X-VERSION:%d\n",
       playlist->version);
@@ -163,31 +160,83 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
 
   g_string_append_printf (playlist_str, "#EXT-X-TARGETDURATION:%u\n",
       gst_m3u8_playlist_target_duration (playlist));
+
+  if (playlist->map_uri)
+    g_string_append_printf (playlist_str, "#EXT-X-MAP:URI=\"%s\"\n",
+        playlist->map_uri);
   g_string_append (playlist_str, "\n");
+}
 
-  /* Entries */
-  for (l = playlist->entries->head; l != NULL; l = l->next) {
-    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
-    GstM3U8Entry *entry = l->data;
+static void
+gst_m3u8_playlist_render_entry_to (GstM3U8Playlist * playlist,
+    GstM3U8Entry * entry, GString * playlist_str)
+{
+  gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  if (entry->discontinuous)
+    g_string_append (playlist_str, "#EXT-X-DISCONTINUITY\n");
+
+  if (playlist->version < 3) {
+    g_string_append_printf (playlist_str, "#EXTINF:%d,%s\n",
+        (gint) ((entry->duration + 500 * GST_MSECOND) / GST_SECOND),
+        entry->title ? entry->title : "");
+  } else {
+    g_string_append_printf (playlist_str, "#EXTINF:%s,%s\n",
+        g_ascii_dtostr (buf, sizeof (buf), entry->duration / GST_SECOND),
+        entry->title ? entry->title : "");
+  }
 
-    if (entry->discontinuous)
-      g_string_append (playlist_str, "#EXT-X-DISCONTINUITY\n");
-
-    if (playlist->version < 3) {
-      g_string_append_printf (playlist_str, "#EXTINF:%d,%s\n",
-          (gint) ((entry->duration + 500 * GST_MSECOND) / GST_SECOND),
-          entry->title ? entry->title : "");
-    } else {
-      g_string_append_printf (playlist_str, "#EXTINF:%s,%s\n",
-          g_ascii_dtostr (buf, sizeof (buf), entry->duration / GST_SECOND),
-          entry->title ? entry->title : "");
-    }
+  g_string_append_printf (playlist_str, "%s\n", entry->url);
+}
 
-    g_string_append_printf (playlist_str, "%s\n", entry->url);
-  }
+gchar *
+gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
+{
+  GString *playlist_str;
+  GList *l;
+
+  g_return_val_if_fail (playlist != NULL, NULL);
+
+  playlist_str = g_string_new (NULL);
+  gst_m3u8_playlist_render_header_to (playlist, playlist_str);
+
+  /* Entries */
+  for (l = playlist->entries->head; l != NULL; l = l->next)
+    gst_m3u8_playlist_render_entry_to (playlist, l->data, playlist_str);
 
   if (playlist->end_list)
     g_string_append (playlist_str, "#EXT-X-ENDLIST");
 
   return g_string_free (playlist_str, FALSE);
 }
+
+/* Renders only the header tags, up to the first entry. As long as it does
+ * not change, a playlist written before can be updated by appending
+ * gst_m3u8_playlist_render_last_entry() to it. */
+gchar *
+gst_m3u8_playlist_render_header (GstM3U8Playlist * playlist)
+{
+  GString *playlist_str;
+
+  g_return_val_if_fail (playlist != NULL, NULL);
+
+  playlist_str = g_string_new (NULL);
+  gst_m3u8_playlist_render_header_to (playlist, playlist_str);
+
+  return g_string_free (playlist_str, FALSE);
+}
+
+gchar *
+gst_m3u8_playlist_render_last_entry (GstM3U8Playlist * playlist)
+{
+  GString *playlist_str;
+
+  g_return_val_if_fail (playlist != NULL, NULL);
+  g_return_val_if_fail (playlist->entries->length > 0, NULL);
+
+  playlist_str = g_string_new (NULL);
+  gst_m3u8_playlist_render_entry_to (playlist,
+      g_queue_peek_tail (playlist->entries), playlist_str);
+
+  return g_string_free (playlist_str, FALSE);
+}
@@ -36,6 +36,8 @@ struct _GstM3U8Playlist
   gint type;
   gboolean end_list;
   guint sequence_number;
+  /* media initialization section of all entries, for EXT-X-MAP */
+  gchar *map_uri;
 
   /*< Private >*/
   GQueue *entries;
@@ -57,6 +59,10 @@ gboolean          gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
 
 gchar *           gst_m3u8_playlist_render (GstM3U8Playlist * playlist);
 
+gchar *           gst_m3u8_playlist_render_header (GstM3U8Playlist * playlist);
+
+gchar *           gst_m3u8_playlist_render_last_entry (GstM3U8Playlist * playlist);
+
 G_END_DECLS
 
 #endif /* __M3U8_H__ */
@@ -48,6 +48,8 @@ gst_m3u8_new (void)
   m3u8->sequence_position = 0;
   m3u8->highest_sequence_number = -1;
   m3u8->duration = GST_CLOCK_TIME_NONE;
+  m3u8->part_hold_back = GST_CLOCK_TIME_NONE;
+  m3u8->part_target = GST_CLOCK_TIME_NONE;
 
   g_mutex_init (&m3u8->lock);
   m3u8->ref_count = 1;
@@ -106,6 +108,10 @@ gst_m3u8_unref (GstM3U8 * self)
 
     g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
     g_list_free (self->files);
+    g_list_free_full (self->pending_parts,
+        (GDestroyNotify) gst_m3u8_media_file_unref);
+    if (self->preload_hint)
+      gst_m3u8_media_file_unref (self->preload_hint);
 
     g_free (self->last_data);
     g_free (self);
@@ -123,6 +129,7 @@ gst_m3u8_media_file_new (gchar * uri, gchar * title, GstClockTime duration,
   file->title = title;
   file->duration = duration;
   file->sequence = sequence;
+  file->part_index = -1;
   file->ref_count = 1;
 
   return file;
@@ -146,6 +153,7 @@ gst_m3u8_media_file_unref (GstM3U8MediaFile * self)
     g_free (self->title);
     g_free (self->uri);
     g_free (self->key);
+    g_list_free_full (self->parts, (GDestroyNotify) gst_m3u8_media_file_unref);
     g_free (self);
   }
 }
@@ -443,6 +451,156 @@ generate_media_seqnums (GstM3U8 * self, GList * previous_files)
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
+/* Returns a new reference to the media file of the previous update that
+ * has sequence number @sequence, if it still describes the same segment.
+ * @previous is advanced past it so the whole list is only walked once. For
+ * live playlists all but the few newest segments are already known, this
+ * saves their URI join and allocation on every reload. */
+static GstM3U8MediaFile *
+gst_m3u8_reuse_media_file (GList ** previous, gint64 sequence,
+    const gchar * uri, GstClockTime duration, const gchar * key,
+    gboolean have_iv, const guint8 * iv, gint64 size, gint64 offset,
+    gboolean discont)
+{
+  GstM3U8MediaFile *file = NULL;
+
+  while (*previous) {
+    file = (*previous)->data;
+    if (file->sequence >= sequence)
+      break;
+    *previous = (*previous)->next;
+  }
+
+  if (*previous == NULL || file->sequence != sequence)
+    return NULL;
+  *previous = (*previous)->next;
+
+  /* the line holds the URI as given in the playlist, which is the tail of
+   * the resolved URI for everything but relative paths going up */
+  if (file->duration != duration || file->discont != discont
+      || !g_str_has_suffix (file->uri, uri) || g_strcmp0 (file->key, key) != 0)
+    return NULL;
+  if (key && have_iv && memcmp (file->iv, iv, sizeof (file->iv)) != 0)
+    return NULL;
+  if (file->size != size || (size != -1 && file->offset != offset))
+    return NULL;
+
+  return gst_m3u8_media_file_ref (file);
+}
+
+/* Parses the attributes of an EXT-X-PART tag into a partial segment of the
+ * segment with sequence number @sequence. @prev is the previously parsed
+ * partial segment, used for BYTERANGEs without an offset */
+static GstM3U8MediaFile *
+gst_m3u8_parse_part (GstM3U8 * self, gchar * desc, gint64 sequence,
+    gint part_index, GstM3U8MediaFile * prev)
+{
+  GstM3U8MediaFile *part;
+  GstClockTime duration = GST_CLOCK_TIME_NONE;
+  gboolean independent = FALSE;
+  gint64 size = -1, offset = -1;
+  gchar *uri = NULL;
+  gchar *a, *v;
+
+  while (desc && parse_attributes (&desc, &a, &v)) {
+    if (g_str_equal (a, "DURATION")) {
+      gdouble fval;
+
+      if (double_from_string (v, NULL, &fval))
+        duration = fval * (gdouble) GST_SECOND;
+    } else if (g_str_equal (a, "URI")) {
+      g_free (uri);
+      uri = uri_join (self->base_uri ? self->base_uri : self->uri, v);
+    } else if (g_str_equal (a, "INDEPENDENT")) {
+      independent = g_ascii_strcasecmp (v, "YES") == 0;
+    } else if (g_str_equal (a, "BYTERANGE")) {
+      if (int64_from_string (v, &v, &size) && *v == '@')
+        int64_from_string (v + 1, NULL, &offset);
+    }
+  }
+
+  if (uri == NULL || !GST_CLOCK_TIME_IS_VALID (duration)) {
+    GST_WARNING ("Invalid EXT-X-PART, it needs a URI and a DURATION");
+    g_free (uri);
+    return NULL;
+  }
+
+  part = gst_m3u8_media_file_new (uri, NULL, duration, sequence);
+  part->part_index = part_index;
+  part->independent = independent;
+  if (size != -1) {
+    part->size = size;
+    if (offset != -1)
+      part->offset = offset;
+    else if (prev && g_str_equal (prev->uri, uri))
+      part->offset = prev->offset + prev->size;
+  } else {
+    part->size = -1;
+  }
+
+  return part;
+}
+
+/* call with M3U8_LOCK held */
+static gboolean
+m3u8_select_low_latency_start (GstM3U8 * self)
+{
+  GstClockTime hold_back, distance = 0, end;
+  GstM3U8MediaFile *start = NULL;
+  GList *l, *p;
+
+  if (!GST_M3U8_IS_LIVE (self) || !GST_CLOCK_TIME_IS_VALID (self->part_target))
+    return FALSE;
+
+  hold_back = self->part_hold_back;
+  if (!GST_CLOCK_TIME_IS_VALID (hold_back))
+    hold_back = 3 * self->part_target;
+
+  end = self->last_file_end;
+  for (p = self->pending_parts; p; p = p->next)
+    end += GST_M3U8_MEDIA_FILE (p->data)->duration;
+
+  /* walk back from the live edge until we are at least the hold back away
+   * from it, and start at the first independent partial segment there */
+  for (p = g_list_last (self->pending_parts); p && !start; p = p->prev) {
+    GstM3U8MediaFile *part = p->data;
+
+    distance += part->duration;
+    if (distance >= hold_back && part->independent)
+      start = part;
+  }
+
+  for (l = g_list_last (self->files); l && !start; l = l->prev) {
+    GstM3U8MediaFile *file = l->data;
+
+    if (file->parts == NULL) {
+      distance += file->duration;
+      if (distance >= hold_back)
+        start = file;
+      continue;
+    }
+
+    for (p = g_list_last (file->parts); p && !start; p = p->prev) {
+      GstM3U8MediaFile *part = p->data;
+
+      distance += part->duration;
+      if (distance >= hold_back && part->independent)
+        start = part;
+    }
+  }
+
+  if (start == NULL)
+    return FALSE;
+
+  self->current_file = NULL;
+  self->current_is_part = FALSE;
+  self->sequence = start->sequence;
+  self->part_index = MAX (start->part_index, 0);
+  self->sequence_position = end > distance ? end - distance : 0;
+
+  return TRUE;
+}
+
 gboolean
 gst_m3u8_update (GstM3U8 * self, gchar * data)
 {
@@ -455,8 +613,10 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   guint8 iv[16] = { 0, };
   gint64 size = -1, offset = -1;
   gint64 mediasequence;
-  GList *previous_files = NULL;
+  GList *previous_files = NULL, *reuse;
   gboolean have_mediasequence = FALSE;
+  GList *parts = NULL;
+  gboolean skip_failed = FALSE;
 
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (data != NULL, FALSE);
@@ -490,7 +650,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   self->last_data = data;
 
   self->current_file = NULL;
-  previous_files = self->files;
+  previous_files = reuse = self->files;
   self->files = NULL;
   self->duration = GST_CLOCK_TIME_NONE;
   mediasequence = 0;
@@ -498,6 +658,17 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   /* By default, allow caching */
   self->allowcache = TRUE;
 
+  g_list_free_full (self->pending_parts,
+      (GDestroyNotify) gst_m3u8_media_file_unref);
+  self->pending_parts = NULL;
+  if (self->preload_hint)
+    gst_m3u8_media_file_unref (self->preload_hint);
+  self->preload_hint = NULL;
+  self->can_block_reload = FALSE;
+  self->can_skip_until = 0;
+  self->part_hold_back = GST_CLOCK_TIME_NONE;
+  self->part_target = GST_CLOCK_TIME_NONE;
+
   duration = 0;
   title = NULL;
   data += 7;
@@ -518,6 +689,34 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         goto next_line;
       }
 
+      if (have_mediasequence && reuse) {
+        GstM3U8MediaFile *file;
+        gint64 file_offset = offset;
+
+        if (size != -1 && offset == -1) {
+          GstM3U8MediaFile *prev = self->files ? self->files->data : NULL;
+
+          file_offset = prev ? prev->offset + prev->size : 0;
+        }
+
+        file = gst_m3u8_reuse_media_file (&reuse, mediasequence, data,
+            duration, current_key, have_iv, iv, size, file_offset,
+            discontinuity);
+        if (file) {
+          /* keep the partial segments of the previous update */
+          g_list_free_full (parts, (GDestroyNotify) gst_m3u8_media_file_unref);
+          parts = NULL;
+          mediasequence++;
+          g_free (title);
+          duration = 0;
+          title = NULL;
+          discontinuity = FALSE;
+          size = offset = -1;
+          self->files = g_list_prepend (self->files, file);
+          goto next_line;
+        }
+      }
+
       data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
       if (data != NULL) {
         GstM3U8MediaFile *file;
@@ -554,6 +753,8 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         }
 
         file->discont = discontinuity;
+        file->parts = g_list_reverse (parts);
+        parts = NULL;
 
         duration = 0;
         title = NULL;
@@ -662,6 +863,101 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
             }
           }
         }
+      } else if (g_str_has_prefix (data_ext_x, "SERVER-CONTROL:")) {
+        gchar *v, *a;
+        gdouble fval;
+
+        data = data + 22;
+        while (data && parse_attributes (&data, &a, &v)) {
+          if (g_str_equal (a, "CAN-BLOCK-RELOAD")) {
+            self->can_block_reload = g_ascii_strcasecmp (v, "YES") == 0;
+          } else if (g_str_equal (a, "CAN-SKIP-UNTIL")) {
+            if (double_from_string (v, NULL, &fval))
+              self->can_skip_until = fval * (gdouble) GST_SECOND;
+          } else if (g_str_equal (a, "PART-HOLD-BACK")) {
+            if (double_from_string (v, NULL, &fval))
+              self->part_hold_back = fval * (gdouble) GST_SECOND;
+          }
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PART-INF:")) {
+        gchar *v, *a;
+        gdouble fval;
+
+        data = data + 16;
+        while (data && parse_attributes (&data, &a, &v)) {
+          if (g_str_equal (a, "PART-TARGET")
+              && double_from_string (v, NULL, &fval))
+            self->part_target = fval * (gdouble) GST_SECOND;
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PART:")) {
+        GstM3U8MediaFile *part;
+
+        part = gst_m3u8_parse_part (self, data + 12, mediasequence,
+            g_list_length (parts), parts ? parts->data : NULL);
+        if (part) {
+          part->key = g_strdup (current_key);
+          if (part->key) {
+            if (have_iv) {
+              memcpy (part->iv, iv, sizeof (iv));
+            } else {
+              guint8 *iv = part->iv + 12;
+              GST_WRITE_UINT32_BE (iv, part->sequence);
+            }
+          }
+          part->discont = discontinuity && parts == NULL;
+          parts = g_list_prepend (parts, part);
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PRELOAD-HINT:")) {
+        gchar *v, *a, *uri = NULL;
+        gboolean is_part = FALSE;
+
+        data = data + 20;
+        while (data && parse_attributes (&data, &a, &v)) {
+          if (g_str_equal (a, "TYPE")) {
+            is_part = g_str_equal (v, "PART");
+          } else if (g_str_equal (a, "URI")) {
+            g_free (uri);
+            uri = uri_join (self->base_uri ? self->base_uri : self->uri, v);
+          }
+        }
+        if (is_part && uri) {
+          if (self->preload_hint)
+            gst_m3u8_media_file_unref (self->preload_hint);
+          self->preload_hint = gst_m3u8_media_file_new (uri, NULL,
+              self->part_target, mediasequence);
+          self->preload_hint->part_index = g_list_length (parts);
+          self->preload_hint->size = -1;
+        } else {
+          g_free (uri);
+        }
+      } else if (g_str_has_prefix (data_ext_x, "SKIP:")) {
+        gchar *v, *a;
+        gint skipped = 0;
+
+        data = data + 12;
+        while (data && parse_attributes (&data, &a, &v)) {
+          if (g_str_equal (a, "SKIPPED-SEGMENTS"))
+            int_from_string (v, NULL, &skipped);
+        }
+
+        /* the skipped segments are the oldest ones of the playlist, take
+         * them from the previous update */
+        for (; skipped > 0; skipped--) {
+          while (reuse
+              && GST_M3U8_MEDIA_FILE (reuse->data)->sequence < mediasequence)
+            reuse = reuse->next;
+          if (!reuse
+              || GST_M3U8_MEDIA_FILE (reuse->data)->sequence != mediasequence) {
+            GST_WARNING ("Skipped segment %" G_GINT64_FORMAT " is unknown",
+                mediasequence);
+            skip_failed = TRUE;
+            break;
+          }
+          self->files = g_list_prepend (self->files,
+              gst_m3u8_media_file_ref (reuse->data));
+          reuse = reuse->next;
+          mediasequence++;
+        }
       } else if (g_str_has_prefix (data_ext_x, "BYTERANGE:")) {
         gchar *v = data + 17;
 
@@ -688,6 +984,19 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   current_key = NULL;
 
   self->files = g_list_reverse (self->files);
+  self->pending_parts = g_list_reverse (parts);
+
+  if (skip_failed) {
+    /* drop everything so the next reload asks for the full playlist */
+    g_list_free_full (self->files, (GDestroyNotify) gst_m3u8_media_file_unref);
+    self->files = NULL;
+    g_list_free_full (previous_files,
+        (GDestroyNotify) gst_m3u8_media_file_unref);
+    g_free (self->last_data);
+    self->last_data = NULL;
+    GST_M3U8_UNLOCK (self);
+    return FALSE;
+  }
 
   if (previous_files) {
     gboolean consistent = TRUE;
@@ -762,7 +1071,11 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   }
 
   /* first-time setup */
-  if (self->files && self->sequence == -1) {
+  if (self->files && self->sequence == -1 && self->low_latency
+      && m3u8_select_low_latency_start (self)) {
+    GST_DEBUG ("first sequence: %u, part %d", (guint) self->sequence,
+        self->part_index);
+  } else if (self->files && self->sequence == -1) {
     GList *file;
 
     if (GST_M3U8_IS_LIVE (self)) {
@@ -834,6 +1147,66 @@ m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
   return l;
 }
 
+/* Returns the fragment to play for partial segment @part_index of the
+ * segment with sequence number @sequence: the complete segment when starting
+ * at its beginning, otherwise a partial segment or the preload hint.
+ * call with M3U8_LOCK held */
+static GstM3U8MediaFile *
+m3u8_find_part (GstM3U8 * m3u8, gint64 sequence, gint part_index)
+{
+  GList *l;
+
+  for (l = m3u8->files; l; l = l->next) {
+    GstM3U8MediaFile *file = l->data;
+
+    if (file->sequence == sequence) {
+      if (part_index == 0)
+        return file;
+      return g_list_nth_data (file->parts, part_index);
+    }
+  }
+
+  /* the segment is still being produced */
+  l = g_list_last (m3u8->files);
+  if (l == NULL || GST_M3U8_MEDIA_FILE (l->data)->sequence + 1 != sequence)
+    return NULL;
+
+  if (part_index < (gint) g_list_length (m3u8->pending_parts))
+    return g_list_nth_data (m3u8->pending_parts, part_index);
+
+  if (m3u8->preload_hint && m3u8->preload_hint->part_index == part_index)
+    return m3u8->preload_hint;
+
+  return NULL;
+}
+
+/* Computes the position following the current partial segment.
+ * call with M3U8_LOCK held */
+static GList *
+m3u8_find_next_part (GstM3U8 * m3u8, gint64 * sequence, gint * part_index)
+{
+  GList *l;
+
+  *sequence = m3u8->sequence;
+  *part_index = m3u8->part_index + 1;
+
+  for (l = m3u8->files; l; l = l->next) {
+    GstM3U8MediaFile *file = l->data;
+
+    if (file->sequence == m3u8->sequence) {
+      /* all partial segments of a complete segment are done */
+      if (*part_index >= (gint) g_list_length (file->parts)) {
+        *sequence = m3u8->sequence + 1;
+        *part_index = 0;
+        return l->next;
+      }
+      break;
+    }
+  }
+
+  return NULL;
+}
+
 GstM3U8MediaFile *
 gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
     GstClockTime * sequence_position, gboolean * discont)
@@ -849,6 +1222,37 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
   if (m3u8->sequence < 0)       /* can't happen really */
     goto out;
 
+  m3u8->current_is_part = FALSE;
+  if (m3u8->low_latency && forward) {
+    GstM3U8MediaFile *part;
+
+    part = m3u8_find_part (m3u8, m3u8->sequence, m3u8->part_index);
+    if (part && part->part_index >= 0) {
+      file = gst_m3u8_media_file_ref (part);
+
+      GST_DEBUG ("Got part %d of sequence %u", file->part_index,
+          (guint) file->sequence);
+
+      if (sequence_position)
+        *sequence_position = m3u8->sequence_position;
+      if (discont)
+        *discont = file->discont;
+
+      m3u8->current_file = NULL;
+      m3u8->current_file_duration = file->duration;
+      m3u8->current_is_part = TRUE;
+      goto out;
+    } else if (part == NULL && m3u8->part_index > 0) {
+      GstM3U8MediaFile *first = m3u8->files ? m3u8->files->data : NULL;
+
+      /* wait for the next partial segment, unless the segment fell out of
+       * the playlist already */
+      if (first && first->sequence <= m3u8->sequence)
+        goto out;
+      m3u8->part_index = 0;
+    }
+  }
+
   if (m3u8->current_file == NULL)
     m3u8->current_file = m3u8_find_next_fragment (m3u8, forward);
 
@@ -896,11 +1300,46 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
 
   have_next = cur && ((forward && cur->next) || (!forward && cur->prev));
 
+  if (!have_next && m3u8->low_latency && forward) {
+    gint64 sequence = m3u8->sequence + 1;
+    gint part_index = 0;
+
+    if (m3u8->current_is_part)
+      m3u8_find_next_part (m3u8, &sequence, &part_index);
+    have_next = m3u8_find_part (m3u8, sequence, part_index) != NULL;
+  }
+
   GST_M3U8_UNLOCK (m3u8);
 
   return have_next;
 }
 
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint offset)
+{
+  GstM3U8MediaFile *file = NULL;
+  GList *l;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (m3u8->current_file)
+    l = m3u8->current_file;
+  else
+    l = m3u8_find_next_fragment (m3u8, forward);
+
+  while (l && offset--)
+    l = forward ? l->next : l->prev;
+
+  if (l)
+    file = gst_m3u8_media_file_ref (l->data);
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
@@ -952,6 +1391,20 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     GST_DEBUG ("Sequence position now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (m3u8->sequence_position));
   }
+  if (m3u8->low_latency && forward && m3u8->current_is_part) {
+    GList *next;
+
+    next = m3u8_find_next_part (m3u8, &m3u8->sequence, &m3u8->part_index);
+    m3u8->current_file = next;
+    m3u8->current_is_part = FALSE;
+    if (next)
+      m3u8->current_file_duration = GST_M3U8_MEDIA_FILE (next->data)->duration;
+    GST_DEBUG ("Advanced to part %d of sequence %" G_GINT64_FORMAT,
+        m3u8->part_index, m3u8->sequence);
+    goto out;
+  }
+  m3u8->part_index = 0;
+  m3u8->current_is_part = FALSE;
   if (!m3u8->current_file) {
     GList *l;
 
@@ -1179,6 +1632,95 @@ out:
   return (duration > 0);
 }
 
+void
+gst_m3u8_set_low_latency (GstM3U8 * m3u8, gboolean low_latency)
+{
+  g_return_if_fail (m3u8 != NULL);
+
+  GST_M3U8_LOCK (m3u8);
+  if (low_latency && !m3u8->low_latency && m3u8->files
+      && GST_M3U8_IS_LIVE (m3u8)) {
+    /* the playlist was already loaded, move closer to the live edge */
+    if (m3u8_select_low_latency_start (m3u8))
+      GST_DEBUG ("low-latency start at sequence %" G_GINT64_FORMAT ", part %d",
+          m3u8->sequence, m3u8->part_index);
+  }
+  m3u8->low_latency = low_latency;
+  if (!low_latency) {
+    m3u8->part_index = 0;
+    m3u8->current_is_part = FALSE;
+  }
+  GST_M3U8_UNLOCK (m3u8);
+}
+
+/* Returns the URI to use for the next reload of a live playlist. If the
+ * server supports it, this is a blocking request for the playlist that
+ * contains the next partial segment (or segment), asking for a delta
+ * update if possible */
+gchar *
+gst_m3u8_get_reload_uri (GstM3U8 * m3u8)
+{
+  GstM3U8MediaFile *last;
+  GString *uri;
+  gchar *p;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+  if (!m3u8->can_block_reload || !m3u8->files || !GST_M3U8_IS_LIVE (m3u8)) {
+    GST_M3U8_UNLOCK (m3u8);
+    return gst_m3u8_get_uri (m3u8);
+  }
+
+  /* drop the directives of the previous request */
+  uri = g_string_new (m3u8->uri);
+  p = strstr (uri->str, "?_HLS_");
+  if (p == NULL)
+    p = strstr (uri->str, "&_HLS_");
+  if (p)
+    g_string_truncate (uri, p - uri->str);
+
+  last = g_list_last (m3u8->files)->data;
+  g_string_append_printf (uri, "%c_HLS_msn=%" G_GINT64_FORMAT,
+      strchr (uri->str, '?') ? '&' : '?', last->sequence + 1);
+  if (GST_CLOCK_TIME_IS_VALID (m3u8->part_target))
+    g_string_append_printf (uri, "&_HLS_part=%u",
+        g_list_length (m3u8->pending_parts));
+  if (m3u8->can_skip_until > 0)
+    g_string_append (uri, "&_HLS_skip=YES");
+  GST_M3U8_UNLOCK (m3u8);
+
+  return g_string_free (uri, FALSE);
+}
+
+gboolean
+gst_m3u8_can_block_reload (GstM3U8 * m3u8)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (m3u8 != NULL, FALSE);
+
+  GST_M3U8_LOCK (m3u8);
+  ret = m3u8->can_block_reload && GST_M3U8_IS_LIVE (m3u8);
+  GST_M3U8_UNLOCK (m3u8);
+
+  return ret;
+}
+
+GstClockTime
+gst_m3u8_get_part_target (GstM3U8 * m3u8)
+{
+  GstClockTime part_target;
+
+  g_return_val_if_fail (m3u8 != NULL, GST_CLOCK_TIME_NONE);
+
+  GST_M3U8_LOCK (m3u8);
+  part_target = m3u8->part_target;
+  GST_M3U8_UNLOCK (m3u8);
+
+  return part_target;
+}
+
 GstHLSMedia *
 gst_hls_media_ref (GstHLSMedia * media)
 {
@@ -63,7 +63,15 @@ struct _GstM3U8
   GstClockTime targetduration;  /* last EXT-X-TARGETDURATION */
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
 
+  /* low-latency extensions */
+  gboolean can_block_reload;    /* EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD */
+  GstClockTime can_skip_until;  /* EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL */
+  GstClockTime part_hold_back;  /* EXT-X-SERVER-CONTROL:PART-HOLD-BACK */
+  GstClockTime part_target;     /* EXT-X-PART-INF:PART-TARGET */
+
   GList *files;
+  GList *pending_parts;         /* partial segments following the last complete one */
+  GstM3U8MediaFile *preload_hint; /* EXT-X-PRELOAD-HINT partial segment */
 
   /* state */
   GList *current_file;
@@ -75,6 +83,9 @@ struct _GstM3U8
   GstClockTime last_file_end;         /* timecode of the end of the last fragment in the current media playlist */
   GstClockTime duration;              /* cached total duration */
   gint discont_sequence;              /* currently expected EXT-X-DISCONTINUITY-SEQUENCE */
+  gboolean low_latency;               /* play partial segments close to the live edge */
+  gint part_index;                    /* next partial segment of the current sequence */
+  gboolean current_is_part;           /* the current fragment is a partial segment */
 
   /*< private > */
   gchar *last_data;
@@ -98,6 +109,9 @@ struct _GstM3U8MediaFile
   gchar *key;
   guint8 iv[16];
   gint64 offset, size;
+  gint part_index;              /* index in its segment for partial segments, -1 for segments */
+  gboolean independent;         /* partial segment starting with an independent frame */
+  GList *parts;                 /* partial segments making up this segment */
   gint ref_count;               /* ATOMIC */
 };
 
@@ -126,6 +140,10 @@ gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     offset);
+
 GstClockTime       gst_m3u8_get_duration         (GstM3U8 * m3u8);
 
 GstClockTime       gst_m3u8_get_target_duration  (GstM3U8 * m3u8);
@@ -138,6 +156,15 @@ gboolean           gst_m3u8_get_seek_range       (GstM3U8 * m3u8,
                                                   gint64  * start,
                                                   gint64  * stop);
 
+void               gst_m3u8_set_low_latency      (GstM3U8 * m3u8,
+                                                  gboolean  low_latency);
+
+gchar *            gst_m3u8_get_reload_uri       (GstM3U8 * m3u8);
+
+gboolean           gst_m3u8_can_block_reload     (GstM3U8 * m3u8);
+
+GstClockTime       gst_m3u8_get_part_target      (GstM3U8 * m3u8);
+
 typedef enum
 {
   GST_HLS_MEDIA_TYPE_INVALID = -1,
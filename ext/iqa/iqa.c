@@ -33,12 +33,19 @@
  * For each reference frame, IQA will post a message containing
  * a structure named IQA.
  *
- * The only metric supported for now is "dssim", which will be available
- * if https://github.com/pornel/dssim was installed on the system
- * at the time that plugin was compiled.
+ * The supported metrics are "psnr", "ssim" and "ms-ssim", and "dssim" which
+ * will be available if https://github.com/pornel/dssim was installed on the
+ * system at the time that plugin was compiled. PSNR is in dB over the 8 bit
+ * samples, capped at 100 dB for identical frames. SSIM and MS-SSIM are
+ * computed on 8x8 windows every 4 pixels, and MS-SSIM on up to 5 scales.
+ * With luma-only, PSNR and SSIM only compare the luma of the frames instead
+ * of their red, green and blue channels, and with downscale they compare
+ * frames downscaled by that factor, which is much faster on large frames.
  *
  * For each metric activated, this structure will contain another
- * structure, named after the metric.
+ * structure, named after the metric, holding one double per compared pad,
+ * named after the pad. Applications can read them with gst_structure_get()
+ * without any string parsing.
  *
  * The message will also contain a "time" field.
  *
@@ -49,6 +56,9 @@
  * sink_2\=\(double\)0.0082939683976297474\;",
  * time=(guint64)0;
  *
+ * The compared pads are evaluated in parallel when n-threads is not 1, and
+ * the PSNR and SSIM of each of them are also split in bands of lines.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -m uridecodebin uri=file:///test/file/1 ! iqa name=iqa do-dssim=true \
@@ -61,6 +71,10 @@
 #include "config.h"
 #endif
 
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "iqa.h"
 
 #ifdef HAVE_DSSIM
@@ -76,16 +90,32 @@ GST_DEBUG_CATEGORY_STATIC (gst_iqa_debug);
 
 #define SRC_FORMAT " { RGBA } "
 
+/* PSNR of identical frames */
+#define MAX_PSNR 100.0
+
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (SRC_FORMAT))
     );
 
+#define DEFAULT_DO_PSNR FALSE
+#define DEFAULT_DO_SSIM FALSE
+#define DEFAULT_DO_MS_SSIM FALSE
+#define DEFAULT_LUMA_ONLY FALSE
+#define DEFAULT_DOWNSCALE 1
+#define DEFAULT_N_THREADS 1
+
 enum
 {
   PROP_0,
+  PROP_DO_DSSIM,
+  PROP_DO_PSNR,
   PROP_DO_SSIM,
+  PROP_DO_MS_SSIM,
+  PROP_LUMA_ONLY,
+  PROP_DOWNSCALE,
+  PROP_N_THREADS,
   PROP_LAST,
 };
 
@@ -95,6 +125,36 @@ static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink_%u",
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (SINK_FORMATS))
     );
 
+typedef enum
+{
+  /* extracts the planes of a picture, downscales them and builds the
+   * MS-SSIM scales */
+  GST_IQA_JOB_PREPARE,
+  /* PSNR and SSIM of a band of lines of a picture */
+  GST_IQA_JOB_BAND,
+  /* SSIM of one of the smaller MS-SSIM scales of a picture */
+  GST_IQA_JOB_SCALE,
+  GST_IQA_JOB_DSSIM,
+} GstIqaJobType;
+
+struct _GstIqaJob
+{
+  GstIqaJobType type;
+  GstIqaPicture *ref;
+  GstIqaPicture *picture;
+  gint band, n_bands;
+  gint scale;
+
+  /* results, summed into the picture once all the jobs are done */
+  guint64 sse;
+  guint64 n_samples;
+  IqaSsimSums ssim;
+};
+
+/* MS-SSIM weights of Wang et al. for each scale */
+static const gdouble ms_ssim_weights[GST_IQA_MAX_SCALES] = {
+  0.0448, 0.2856, 0.3001, 0.2363, 0.1333
+};
 
 /* GstIqa */
 
@@ -112,49 +172,25 @@ to_byte (float in)
   return in * 256.f;
 }
 
-static gboolean
-do_dssim (GstIqa * self, GstVideoFrame * ref, GstVideoFrame * cmp,
-    GstBuffer * outbuf, GstStructure * msg_structure, gchar * padname)
+/* computes the dssim of the picture and keeps its ssim map, which is
+ * drawn later if the picture turns out to be the most different one */
+static void
+do_dssim (GstIqa * self, GstVideoFrame * ref, GstIqaPicture * picture)
 {
+  GstVideoFrame *cmp = picture->frame;
   dssim_attr *attr = dssim_create_attr ();
   gint y;
   unsigned char **ptrs, **ptrs2;
   GstMapInfo ref_info;
   GstMapInfo cmp_info;
-  GstMapInfo out_info;
   dssim_image *ref_image;
   dssim_image *cmp_image;
-  double dssim;
   dssim_ssim_map map_meta;
-  float *map;
-  gint i;
-  dssim_rgba *out;
-  GstStructure *dssim_structure;
-
-  gst_structure_get (msg_structure, "dssim", GST_TYPE_STRUCTURE,
-      &dssim_structure, NULL);
 
   dssim_set_save_ssim_maps (attr, 1, 1);
-  if (ref->info.width != cmp->info.width ||
-      ref->info.height != cmp->info.height) {
-    GST_OBJECT_UNLOCK (self);
-
-    GST_ELEMENT_ERROR (self, STREAM, FAILED,
-        ("Video streams do not have the same sizes (add videoscale"
-            " and force the sizes to be equal on all sink pads.)"),
-        ("Reference width %d - compared width: %d. "
-            "Reference height %d - compared height: %d",
-            ref->info.width, cmp->info.width, ref->info.height,
-            cmp->info.height));
-
-    GST_OBJECT_LOCK (self);
-    return FALSE;
-  }
 
   gst_buffer_map (ref->buffer, &ref_info, GST_MAP_READ);
   gst_buffer_map (cmp->buffer, &cmp_info, GST_MAP_READ);
-  gst_buffer_map (outbuf, &out_info, GST_MAP_WRITE);
-  out = (dssim_rgba *) out_info.data;
 
   ptrs = g_malloc (sizeof (char **) * ref->info.height);
 
@@ -175,105 +211,516 @@ do_dssim (GstIqa * self, GstVideoFrame * ref, GstVideoFrame * cmp,
   cmp_image =
       dssim_create_image (attr, ptrs2, DSSIM_RGBA, cmp->info.width,
       cmp->info.height, 0.45455);
-  dssim = dssim_compare (attr, ref_image, cmp_image);
+  picture->dssim = dssim_compare (attr, ref_image, cmp_image);
 
   map_meta = dssim_pop_ssim_map (attr, 0, 0);
-
-  if (dssim > self->max_dssim) {
-    map = map_meta.data;
-
-    for (i = 0; i < map_meta.width * map_meta.height; i++) {
-      const float max = 1.0 - map[i];
-      const float maxsq = max * max;
-      out[i] = (dssim_rgba) {
-      .r = to_byte (max * 3.0),.g = to_byte (maxsq * 6.0),.b =
-            to_byte (max / ((1.0 - map_meta.dssim) * 4.0)),.a = 255,};
-    }
-    self->max_dssim = dssim;
-  }
-
-  gst_structure_set (dssim_structure, padname, G_TYPE_DOUBLE, dssim, NULL);
-  gst_structure_set (msg_structure, "dssim", GST_TYPE_STRUCTURE,
-      dssim_structure, NULL);
-  gst_structure_free (dssim_structure);
+  picture->dssim_map = g_memdup (&map_meta, sizeof (map_meta));
 
   g_free (ptrs);
   g_free (ptrs2);
   gst_buffer_unmap (ref->buffer, &ref_info);
   gst_buffer_unmap (cmp->buffer, &cmp_info);
-  gst_buffer_unmap (outbuf, &out_info);
   dssim_dealloc_image (ref_image);
   dssim_dealloc_image (cmp_image);
   dssim_dealloc_attr (attr);
+}
+
+static void
+draw_dssim_map (GstIqaPicture * picture, GstBuffer * outbuf)
+{
+  dssim_ssim_map *map_meta = picture->dssim_map;
+  float *map = map_meta->data;
+  GstMapInfo out_info;
+  dssim_rgba *out;
+  gint i;
+
+  gst_buffer_map (outbuf, &out_info, GST_MAP_WRITE);
+  out = (dssim_rgba *) out_info.data;
+
+  for (i = 0; i < map_meta->width * map_meta->height; i++) {
+    const float max = 1.0 - map[i];
+    const float maxsq = max * max;
+    out[i] = (dssim_rgba) {
+    .r = to_byte (max * 3.0),.g = to_byte (maxsq * 6.0),.b =
+          to_byte (max / ((1.0 - map_meta->dssim) * 4.0)),.a = 255,};
+  }
 
-  return TRUE;
+  gst_buffer_unmap (outbuf, &out_info);
+}
+
+static void
+free_dssim_map (GstIqaPicture * picture)
+{
+  dssim_ssim_map *map_meta = picture->dssim_map;
+
+  if (map_meta) {
+    /* allocated by dssim with malloc () */
+    free (map_meta->data);
+    g_free (map_meta);
+    picture->dssim_map = NULL;
+  }
 }
 #endif
 
-static gboolean
-compare_frames (GstIqa * self, GstVideoFrame * ref, GstVideoFrame * cmp,
-    GstBuffer * outbuf, GstStructure * msg_structure, gchar * padname)
+/* Fills the planes of the first scale with the red, green and blue channels
+ * of the frame, or its BT.601 luma, averaged over squares of
+ * self->downscale pixels */
+static void
+prepare_planes (GstIqa * self, GstIqaPicture * picture)
+{
+  GstVideoFrame *frame = picture->frame;
+  guint factor = self->downscale;
+  gint width = GST_VIDEO_FRAME_WIDTH (frame) / factor;
+  gint height = GST_VIDEO_FRAME_HEIGHT (frame) / factor;
+  const guint8 *comp[3];
+  gint stride[3], pstride[3];
+  guint area = factor * factor;
+  gint c, p, x, y;
+  guint i, j;
+
+  for (c = 0; c < 3; c++) {
+    comp[c] = GST_VIDEO_FRAME_COMP_DATA (frame, c);
+    stride[c] = GST_VIDEO_FRAME_COMP_STRIDE (frame, c);
+    pstride[c] = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, c);
+  }
+
+  picture->n_planes = self->luma_only ? 1 : 3;
+  for (p = 0; p < picture->n_planes; p++)
+    iqa_plane_alloc (&picture->planes[0][p], width, height);
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      guint sum[3] = { 0, 0, 0 };
+
+      for (c = 0; c < 3; c++) {
+        for (j = 0; j < factor; j++) {
+          const guint8 *s = comp[c] + (y * factor + j) * stride[c] +
+              x * factor * pstride[c];
+
+          for (i = 0; i < factor; i++)
+            sum[c] += s[i * pstride[c]];
+        }
+        sum[c] = (sum[c] + area / 2) / area;
+      }
+
+      if (self->luma_only) {
+        picture->planes[0][0].data[y * picture->planes[0][0].stride + x] =
+            (77 * sum[0] + 150 * sum[1] + 29 * sum[2] + 128) >> 8;
+      } else {
+        for (p = 0; p < 3; p++)
+          picture->planes[0][p].data[y * picture->planes[0][p].stride + x] =
+              sum[p];
+      }
+    }
+  }
+
+  picture->n_scales = 1;
+  if (!self->do_ms_ssim)
+    return;
+
+  /* every scale needs at least one 8x8 window */
+  while (picture->n_scales < GST_IQA_MAX_SCALES &&
+      picture->planes[picture->n_scales - 1][0].width >= 16 &&
+      picture->planes[picture->n_scales - 1][0].height >= 16) {
+    for (p = 0; p < picture->n_planes; p++)
+      iqa_plane_downscale_2x (&picture->planes[picture->n_scales - 1][p],
+          &picture->planes[picture->n_scales][p]);
+    picture->n_scales++;
+  }
+}
+
+static void
+free_planes (GstIqaPicture * picture)
 {
+  gint s, p;
+
+  for (s = 0; s < picture->n_scales; s++)
+    for (p = 0; p < picture->n_planes; p++)
+      iqa_plane_free (&picture->planes[s][p]);
+  picture->n_scales = 0;
+}
+
+static void
+do_band (GstIqa * self, GstIqaJob * job)
+{
+  gint p;
+
+  for (p = 0; p < job->picture->n_planes; p++) {
+    const IqaPlane *a = &job->ref->planes[0][p];
+    const IqaPlane *b = &job->picture->planes[0][p];
+
+    if (self->do_psnr) {
+      gint start = a->height * job->band / job->n_bands;
+      gint end = a->height * (job->band + 1) / job->n_bands;
+
+      job->sse += iqa_plane_sse (a, b, start, end);
+      job->n_samples += (guint64) a->width * (end - start);
+    }
+
+    if (self->do_ssim || self->do_ms_ssim) {
+      gint rows = iqa_plane_ssim_rows (a);
+
+      iqa_plane_ssim (a, b, rows * job->band / job->n_bands,
+          rows * (job->band + 1) / job->n_bands, &job->ssim);
+    }
+  }
+}
+
+static void
+do_scale (GstIqa * self, GstIqaJob * job)
+{
+  gint p;
+
+  for (p = 0; p < job->picture->n_planes; p++) {
+    const IqaPlane *a = &job->ref->planes[job->scale][p];
+    const IqaPlane *b = &job->picture->planes[job->scale][p];
+
+    iqa_plane_ssim (a, b, 0, iqa_plane_ssim_rows (a), &job->ssim);
+  }
+}
+
+static void
+gst_iqa_run_job (GstIqa * self, GstIqaJob * job)
+{
+  switch (job->type) {
+    case GST_IQA_JOB_PREPARE:
+      prepare_planes (self, job->picture);
+      break;
+    case GST_IQA_JOB_BAND:
+      do_band (self, job);
+      break;
+    case GST_IQA_JOB_SCALE:
+      do_scale (self, job);
+      break;
+    case GST_IQA_JOB_DSSIM:
 #ifdef HAVE_DSSIM
-  if (self->do_dssim) {
-    if (!do_dssim (self, ref, cmp, outbuf, msg_structure, padname))
-      return FALSE;
+      do_dssim (self, job->ref->frame, job->picture);
+#endif
+      break;
+  }
+}
+
+/* runs jobs until all of them are taken */
+static void
+gst_iqa_run_jobs (GstIqa * self)
+{
+  gint i;
+
+  while ((i = g_atomic_int_add (&self->next_job, 1)) < self->n_jobs)
+    gst_iqa_run_job (self, &self->jobs[i]);
+}
+
+static void
+gst_iqa_worker_func (gpointer data, gpointer user_data)
+{
+  GstIqa *self = user_data;
+
+  gst_iqa_run_jobs (self);
+
+  g_mutex_lock (&self->jobs_lock);
+  if (--self->workers_pending == 0)
+    g_cond_signal (&self->jobs_cond);
+  g_mutex_unlock (&self->jobs_lock);
+}
+
+/* WITH OBJECT LOCK
+ * The jobs only read the frames and the properties and write their own
+ * results, so they are shared between the streaming thread and up to
+ * n-threads - 1 workers. Returns once all of them are done. */
+static void
+gst_iqa_do_jobs (GstIqa * self, GstIqaJob * jobs, gint n_jobs,
+    guint n_threads)
+{
+  gint n_workers, i;
+
+  n_workers = MIN ((gint) n_threads, n_jobs) - 1;
+
+  self->jobs = jobs;
+  self->n_jobs = n_jobs;
+  self->next_job = 0;
+
+  if (n_workers > 0) {
+    if (!self->pool) {
+      self->pool = g_thread_pool_new (gst_iqa_worker_func, self,
+          n_workers, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (self->pool) < n_workers) {
+      g_thread_pool_set_max_threads (self->pool, n_workers, NULL);
+    }
+
+    self->workers_pending = n_workers;
+    for (i = 0; i < n_workers; i++)
+      g_thread_pool_push (self->pool, self, NULL);
+  }
+
+  gst_iqa_run_jobs (self);
+
+  if (n_workers > 0) {
+    g_mutex_lock (&self->jobs_lock);
+    while (self->workers_pending > 0)
+      g_cond_wait (&self->jobs_cond, &self->jobs_lock);
+    g_mutex_unlock (&self->jobs_lock);
   }
+
+  self->jobs = NULL;
+  self->n_jobs = 0;
+}
+
+/* WITH OBJECT LOCK
+ * pictures[0] is the reference, the others are compared to it */
+static void
+compare_pictures (GstIqa * self, GstIqaPicture * pictures, gint n_pictures)
+{
+  gboolean do_planes = self->do_psnr || self->do_ssim || self->do_ms_ssim;
+  guint n_threads = self->n_threads;
+  GstIqaJob *jobs;
+  gint n_jobs = 0, n_bands, i, j;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_bands = n_threads;
+
+  jobs = g_new0 (GstIqaJob, n_pictures * (n_bands + GST_IQA_MAX_SCALES + 1));
+
+  if (do_planes) {
+    for (i = 0; i < n_pictures; i++) {
+      jobs[n_jobs].type = GST_IQA_JOB_PREPARE;
+      jobs[n_jobs++].picture = &pictures[i];
+    }
+    gst_iqa_do_jobs (self, jobs, n_jobs, n_threads);
+    memset (jobs, 0, n_jobs * sizeof (GstIqaJob));
+    n_jobs = 0;
+  }
+
+  for (i = 1; i < n_pictures; i++) {
+    GstIqaJob *job;
+
+#ifdef HAVE_DSSIM
+    if (self->do_dssim) {
+      job = &jobs[n_jobs++];
+      job->type = GST_IQA_JOB_DSSIM;
+      job->ref = &pictures[0];
+      job->picture = &pictures[i];
+    }
 #endif
 
-  return TRUE;
+    if (!do_planes)
+      continue;
+
+    for (j = 0; j < n_bands; j++) {
+      job = &jobs[n_jobs++];
+      job->type = GST_IQA_JOB_BAND;
+      job->ref = &pictures[0];
+      job->picture = &pictures[i];
+      job->band = j;
+      job->n_bands = n_bands;
+    }
+
+    for (j = 1; j < MIN (pictures[0].n_scales, pictures[i].n_scales); j++) {
+      job = &jobs[n_jobs++];
+      job->type = GST_IQA_JOB_SCALE;
+      job->ref = &pictures[0];
+      job->picture = &pictures[i];
+      job->scale = j;
+    }
+  }
+
+  gst_iqa_do_jobs (self, jobs, n_jobs, n_threads);
+
+  for (i = 0; i < n_jobs; i++) {
+    GstIqaPicture *picture = jobs[i].picture;
+    IqaSsimSums *ssim = &picture->ssim[jobs[i].scale];
+
+    picture->sse += jobs[i].sse;
+    picture->n_samples += jobs[i].n_samples;
+    ssim->ssim += jobs[i].ssim.ssim;
+    ssim->cs += jobs[i].ssim.cs;
+    ssim->n_windows += jobs[i].ssim.n_windows;
+  }
+
+  g_free (jobs);
+}
+
+static gdouble
+picture_psnr (GstIqaPicture * picture)
+{
+  gdouble mse;
+
+  if (picture->sse == 0 || picture->n_samples == 0)
+    return MAX_PSNR;
+
+  mse = (gdouble) picture->sse / picture->n_samples;
+  return MIN (10.0 * log10 (255.0 * 255.0 / mse), MAX_PSNR);
+}
+
+static gdouble
+picture_ssim (GstIqaPicture * picture)
+{
+  if (picture->ssim[0].n_windows == 0)
+    return 1.0;
+
+  return picture->ssim[0].ssim / picture->ssim[0].n_windows;
+}
+
+/* contrast-structure terms of every scale but the last one, and SSIM of the
+ * last one, with the weights of the scales that fit in the frame scaled so
+ * that they add up to 1 */
+static gdouble
+picture_ms_ssim (GstIqaPicture * picture, gint n_scales)
+{
+  gdouble weights = 0.0, ms_ssim = 1.0;
+  gint s;
+
+  for (s = 0; s < n_scales; s++)
+    weights += ms_ssim_weights[s];
+
+  for (s = 0; s < n_scales; s++) {
+    IqaSsimSums *sums = &picture->ssim[s];
+    gdouble value;
+
+    if (sums->n_windows == 0)
+      continue;
+
+    if (s == n_scales - 1)
+      value = sums->ssim / sums->n_windows;
+    else
+      value = sums->cs / sums->n_windows;
+
+    ms_ssim *= pow (MAX (value, 0.0), ms_ssim_weights[s] / weights);
+  }
+
+  return ms_ssim;
+}
+
+static void
+add_metric (GstStructure * msg_structure, const gchar * metric,
+    GstIqaPicture * pictures, gint n_pictures, gdouble values[])
+{
+  GstStructure *s = gst_structure_new_empty (metric);
+  GValue v = G_VALUE_INIT;
+  gint i;
+
+  for (i = 1; i < n_pictures; i++)
+    gst_structure_set (s, pictures[i].padname, G_TYPE_DOUBLE, values[i], NULL);
+
+  g_value_init (&v, GST_TYPE_STRUCTURE);
+  g_value_take_boxed (&v, s);
+  gst_structure_take_value (msg_structure, metric, &v);
 }
 
 static GstFlowReturn
 gst_iqa_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
 {
   GList *l;
-  GstVideoFrame *ref_frame = NULL;
   GstIqa *self = GST_IQA (vagg);
   GstStructure *msg_structure = gst_structure_new_empty ("IQA");
-  GstMessage *m = gst_message_new_element (GST_OBJECT (self), msg_structure);
   GstAggregator *agg = GST_AGGREGATOR (vagg);
-
-  if (self->do_dssim) {
-    gst_structure_set (msg_structure, "dssim", GST_TYPE_STRUCTURE,
-        gst_structure_new_empty ("dssim"), NULL);
-    self->max_dssim = 0.0;
-  }
+  GstIqaPicture *pictures;
+  gdouble *values;
+  gint n_pictures = 0, n_scales, i;
 
   GST_OBJECT_LOCK (vagg);
+  pictures = g_new0 (GstIqaPicture, GST_ELEMENT (vagg)->numsinkpads);
   for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
     GstVideoAggregatorPad *pad = l->data;
+    GstVideoFrame *frame = pad->aggregated_frame;
 
-    if (pad->aggregated_frame != NULL) {
-      if (!ref_frame) {
-        ref_frame = pad->aggregated_frame;
-      } else {
-        gboolean res;
-        gchar *padname = gst_pad_get_name (pad);
-        GstVideoFrame *cmp_frame = pad->aggregated_frame;
+    if (frame == NULL)
+      continue;
+
+    if (n_pictures > 0 && (pictures[0].frame->info.width != frame->info.width
+            || pictures[0].frame->info.height != frame->info.height)) {
+      GstVideoFrame *ref = pictures[0].frame;
+
+      GST_OBJECT_UNLOCK (vagg);
 
-        res = compare_frames (self, ref_frame, cmp_frame, outbuf, msg_structure,
-            padname);
-        g_free (padname);
+      GST_ELEMENT_ERROR (self, STREAM, FAILED,
+          ("Video streams do not have the same sizes (add videoscale"
+              " and force the sizes to be equal on all sink pads.)"),
+          ("Reference width %d - compared width: %d. "
+              "Reference height %d - compared height: %d",
+              ref->info.width, frame->info.width, ref->info.height,
+              frame->info.height));
 
-        if (!res)
-          goto failed;
+      goto failed;
+    }
+
+    pictures[n_pictures].frame = frame;
+    pictures[n_pictures++].padname = gst_pad_get_name (pad);
+  }
+
+  if (n_pictures > 1)
+    compare_pictures (self, pictures, n_pictures);
+
+  values = g_new0 (gdouble, n_pictures);
+
+  if (self->do_psnr) {
+    for (i = 1; i < n_pictures; i++)
+      values[i] = picture_psnr (&pictures[i]);
+    add_metric (msg_structure, "psnr", pictures, n_pictures, values);
+  }
+
+  if (self->do_ssim) {
+    for (i = 1; i < n_pictures; i++)
+      values[i] = picture_ssim (&pictures[i]);
+    add_metric (msg_structure, "ssim", pictures, n_pictures, values);
+  }
+
+  if (self->do_ms_ssim) {
+    for (i = 1; i < n_pictures; i++) {
+      n_scales = MIN (pictures[0].n_scales, pictures[i].n_scales);
+      values[i] = picture_ms_ssim (&pictures[i], n_scales);
+    }
+    add_metric (msg_structure, "ms-ssim", pictures, n_pictures, values);
+  }
+
+#ifdef HAVE_DSSIM
+  if (self->do_dssim) {
+    GstIqaPicture *worst = NULL;
+
+    self->max_dssim = 0.0;
+    for (i = 1; i < n_pictures; i++) {
+      values[i] = pictures[i].dssim;
+      if (pictures[i].dssim > self->max_dssim) {
+        self->max_dssim = pictures[i].dssim;
+        worst = &pictures[i];
       }
     }
+
+    /* the heat map of the most different picture */
+    if (worst)
+      draw_dssim_map (worst, outbuf);
+
+    add_metric (msg_structure, "dssim", pictures, n_pictures, values);
   }
+#endif
+
+  g_free (values);
 
   GST_OBJECT_UNLOCK (vagg);
 
+  for (i = 0; i < n_pictures; i++) {
+    free_planes (&pictures[i]);
+#ifdef HAVE_DSSIM
+    free_dssim_map (&pictures[i]);
+#endif
+    g_free (pictures[i].padname);
+  }
+  g_free (pictures);
+
   /* We only post the message here, because we can't post it while the object
    * is locked.
    */
   gst_structure_set (msg_structure, "time", GST_TYPE_CLOCK_TIME,
       agg->segment.position, NULL);
-  gst_element_post_message (GST_ELEMENT (self), m);
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self), msg_structure));
   return GST_FLOW_OK;
 
 failed:
-  GST_OBJECT_UNLOCK (vagg);
+  for (i = 0; i < n_pictures; i++)
+    g_free (pictures[i].padname);
+  g_free (pictures);
+  gst_structure_free (msg_structure);
 
   return GST_FLOW_ERROR;
 }
@@ -284,14 +731,34 @@ _set_property (GObject * object, guint prop_id, const GValue * value,
 {
   GstIqa *self = GST_IQA (object);
 
+  GST_OBJECT_LOCK (self);
   switch (prop_id) {
-    case PROP_DO_SSIM:
+    case PROP_DO_DSSIM:
       self->do_dssim = g_value_get_boolean (value);
       break;
+    case PROP_DO_PSNR:
+      self->do_psnr = g_value_get_boolean (value);
+      break;
+    case PROP_DO_SSIM:
+      self->do_ssim = g_value_get_boolean (value);
+      break;
+    case PROP_DO_MS_SSIM:
+      self->do_ms_ssim = g_value_get_boolean (value);
+      break;
+    case PROP_LUMA_ONLY:
+      self->luma_only = g_value_get_boolean (value);
+      break;
+    case PROP_DOWNSCALE:
+      self->downscale = g_value_get_uint (value);
+      break;
+    case PROP_N_THREADS:
+      self->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
+  GST_OBJECT_UNLOCK (self);
 }
 
 static void
@@ -300,14 +767,47 @@ _get_property (GObject * object,
 {
   GstIqa *self = GST_IQA (object);
 
+  GST_OBJECT_LOCK (self);
   switch (prop_id) {
-    case PROP_DO_SSIM:
+    case PROP_DO_DSSIM:
       g_value_set_boolean (value, self->do_dssim);
       break;
+    case PROP_DO_PSNR:
+      g_value_set_boolean (value, self->do_psnr);
+      break;
+    case PROP_DO_SSIM:
+      g_value_set_boolean (value, self->do_ssim);
+      break;
+    case PROP_DO_MS_SSIM:
+      g_value_set_boolean (value, self->do_ms_ssim);
+      break;
+    case PROP_LUMA_ONLY:
+      g_value_set_boolean (value, self->luma_only);
+      break;
+    case PROP_DOWNSCALE:
+      g_value_set_uint (value, self->downscale);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, self->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_iqa_finalize (GObject * object)
+{
+  GstIqa *self = GST_IQA (object);
+
+  if (self->pool)
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+  g_mutex_clear (&self->jobs_lock);
+  g_cond_clear (&self->jobs_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 /* GObject boilerplate */
@@ -328,13 +828,91 @@ gst_iqa_class_init (GstIqaClass * klass)
 
   gobject_class->set_property = _set_property;
   gobject_class->get_property = _get_property;
+  gobject_class->finalize = gst_iqa_finalize;
 
 #ifdef HAVE_DSSIM
-  g_object_class_install_property (gobject_class, PROP_DO_SSIM,
+  g_object_class_install_property (gobject_class, PROP_DO_DSSIM,
       g_param_spec_boolean ("do-dssim", "do-dssim",
           "Run structural similarity checks", FALSE, G_PARAM_READWRITE));
 #endif
 
+  /**
+   * GstIqa:do-psnr:
+   *
+   * Compute the peak signal to noise ratio of the compared frames, in dB.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DO_PSNR,
+      g_param_spec_boolean ("do-psnr", "do-psnr",
+          "Compute the peak signal to noise ratio", DEFAULT_DO_PSNR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstIqa:do-ssim:
+   *
+   * Compute the structural similarity of the compared frames.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DO_SSIM,
+      g_param_spec_boolean ("do-ssim", "do-ssim",
+          "Compute the structural similarity", DEFAULT_DO_SSIM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstIqa:do-ms-ssim:
+   *
+   * Compute the multi-scale structural similarity of the compared frames.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DO_MS_SSIM,
+      g_param_spec_boolean ("do-ms-ssim", "do-ms-ssim",
+          "Compute the multi-scale structural similarity", DEFAULT_DO_MS_SSIM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstIqa:luma-only:
+   *
+   * Only compare the luma of the frames in PSNR, SSIM and MS-SSIM, instead
+   * of their red, green and blue channels.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_LUMA_ONLY,
+      g_param_spec_boolean ("luma-only", "Luma only",
+          "Only compare the luma in PSNR, SSIM and MS-SSIM", DEFAULT_LUMA_ONLY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstIqa:downscale:
+   *
+   * Factor by which the frames are downscaled before computing PSNR, SSIM
+   * and MS-SSIM.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DOWNSCALE,
+      g_param_spec_uint ("downscale", "Downscale",
+          "Factor by which the frames are downscaled for PSNR, SSIM and "
+          "MS-SSIM", 1, 16, DEFAULT_DOWNSCALE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstIqa:n-threads:
+   *
+   * Number of threads comparing the frames, 0 uses one thread per
+   * processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads comparing the frames (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Iqa",
       "Filter/Analyzer/Video",
       "Provides various Image Quality Assessment metrics",
@@ -344,6 +922,14 @@ gst_iqa_class_init (GstIqaClass * klass)
 static void
 gst_iqa_init (GstIqa * self)
 {
+  self->do_psnr = DEFAULT_DO_PSNR;
+  self->do_ssim = DEFAULT_DO_SSIM;
+  self->do_ms_ssim = DEFAULT_DO_MS_SSIM;
+  self->luma_only = DEFAULT_LUMA_ONLY;
+  self->downscale = DEFAULT_DOWNSCALE;
+  self->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&self->jobs_lock);
+  g_cond_init (&self->jobs_cond);
 }
 
 static gboolean
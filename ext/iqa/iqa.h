@@ -24,6 +24,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideoaggregator.h>
 
+#include "iqametrics.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_IQA (gst_iqa_get_type())
@@ -36,8 +38,32 @@ G_BEGIN_DECLS
 #define GST_IS_IQA_CLASS(klass) \
         (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_IQA))
 
+#define GST_IQA_MAX_PLANES 3
+#define GST_IQA_MAX_SCALES 5
+
 typedef struct _GstIqa GstIqa;
 typedef struct _GstIqaClass GstIqaClass;
+typedef struct _GstIqaPicture GstIqaPicture;
+typedef struct _GstIqaJob GstIqaJob;
+
+/* A frame of one of the sink pads, the first one being the reference, and
+ * the metrics comparing it to the reference */
+struct _GstIqaPicture
+{
+  GstVideoFrame *frame;
+  gchar *padname;
+
+  /* planes[scale][plane], the first scale is at the downscaled size */
+  IqaPlane planes[GST_IQA_MAX_SCALES][GST_IQA_MAX_PLANES];
+  gint n_planes;
+  gint n_scales;
+
+  guint64 sse;
+  guint64 n_samples;
+  IqaSsimSums ssim[GST_IQA_MAX_SCALES];
+  gdouble dssim;
+  gpointer dssim_map;
+};
 
 /**
  * GstIqa:
@@ -50,6 +76,21 @@ struct _GstIqa
 
   gboolean do_dssim;
   double max_dssim;
+
+  gboolean do_psnr;
+  gboolean do_ssim;
+  gboolean do_ms_ssim;
+  gboolean luma_only;
+  guint downscale;
+  guint n_threads;
+
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  gint workers_pending;
+  GstIqaJob *jobs;
+  gint n_jobs;
+  gint next_job;
 };
 
 struct _GstIqaClass
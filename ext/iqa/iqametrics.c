@@ -0,0 +1,246 @@
+/* Image Quality Assessment plugin
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* PSNR and SSIM kernels on 8 bit planes.
+ *
+ * SSIM is computed on 8x8 windows every 4 pixels, from the sums of the 4x4
+ * blocks they are made of, like x264 does. The sums of a row of blocks are
+ * reused by the two rows of windows that cover it. The windows of a plane
+ * can be split in rows, so that parts of the same plane are computed in
+ * parallel. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "iqametrics.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SSIM_C1 (0.01 * 0.01 * 255 * 255 * 64)
+#define SSIM_C2 (0.03 * 0.03 * 255 * 255 * 64 * 63)
+
+void
+iqa_plane_alloc (IqaPlane * plane, gint width, gint height)
+{
+  plane->width = width;
+  plane->height = height;
+  /* padded so the vector loads never read past the end */
+  plane->stride = (MAX (width, 1) + 15) & ~15;
+  plane->data = g_malloc (plane->stride * MAX (height, 1) + 16);
+}
+
+void
+iqa_plane_free (IqaPlane * plane)
+{
+  g_free (plane->data);
+  plane->data = NULL;
+}
+
+/* 2x2 box filter, the odd last column or line is dropped */
+void
+iqa_plane_downscale_2x (const IqaPlane * src, IqaPlane * dest)
+{
+  gint x, y;
+
+  iqa_plane_alloc (dest, src->width / 2, src->height / 2);
+
+  for (y = 0; y < dest->height; y++) {
+    const guint8 *s0 = src->data + 2 * y * src->stride;
+    const guint8 *s1 = s0 + src->stride;
+    guint8 *d = dest->data + y * dest->stride;
+
+    for (x = 0; x < dest->width; x++)
+      d[x] = (s0[2 * x] + s0[2 * x + 1] + s1[2 * x] + s1[2 * x + 1] + 2) >> 2;
+  }
+}
+
+static guint64
+line_sse (const guint8 * a, const guint8 * b, gint width)
+{
+  guint64 sse = 0;
+  gint x = 0;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128 ();
+  __m128i acc = _mm_setzero_si128 ();
+  guint32 lanes[4];
+
+  /* each 32 bit lane gets at most 4 * 255^2 per iteration, which does not
+   * overflow for any line of less than 32768 pixels */
+  for (; x + 16 <= width; x += 16) {
+    __m128i va = _mm_loadu_si128 ((const __m128i *) (a + x));
+    __m128i vb = _mm_loadu_si128 ((const __m128i *) (b + x));
+    __m128i dlo = _mm_sub_epi16 (_mm_unpacklo_epi8 (va, zero),
+        _mm_unpacklo_epi8 (vb, zero));
+    __m128i dhi = _mm_sub_epi16 (_mm_unpackhi_epi8 (va, zero),
+        _mm_unpackhi_epi8 (vb, zero));
+
+    acc = _mm_add_epi32 (acc, _mm_madd_epi16 (dlo, dlo));
+    acc = _mm_add_epi32 (acc, _mm_madd_epi16 (dhi, dhi));
+  }
+  _mm_storeu_si128 ((__m128i *) lanes, acc);
+  sse = (guint64) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+  for (; x < width; x++) {
+    gint d = a[x] - b[x];
+    sse += d * d;
+  }
+
+  return sse;
+}
+
+/* sum of the squared differences of the lines [@y_start, @y_end) */
+guint64
+iqa_plane_sse (const IqaPlane * a, const IqaPlane * b, gint y_start,
+    gint y_end)
+{
+  guint64 sse = 0;
+  gint y;
+
+  for (y = y_start; y < y_end; y++)
+    sse += line_sse (a->data + y * a->stride, b->data + y * b->stride,
+        a->width);
+
+  return sse;
+}
+
+/* sums[4 * bx + i] gets the sum of a, of b, of a^2 + b^2 and of a * b over
+ * the 4x4 block bx of the row of blocks at @a and @b */
+static void
+block_row_sums (const guint8 * a, gint stride_a, const guint8 * b,
+    gint stride_b, gint n_blocks, gint * sums)
+{
+  gint bx = 0, x, y;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i ones = _mm_set1_epi16 (1);
+  gint32 t[4][4];
+
+  /* two blocks at a time, in the low and high halves of the vectors */
+  for (; bx + 2 <= n_blocks; bx += 2) {
+    __m128i s1 = _mm_setzero_si128 ();
+    __m128i s2 = _mm_setzero_si128 ();
+    __m128i ss = _mm_setzero_si128 ();
+    __m128i s12 = _mm_setzero_si128 ();
+
+    for (y = 0; y < 4; y++) {
+      __m128i va = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)
+              (a + y * stride_a + 4 * bx)), zero);
+      __m128i vb = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)
+              (b + y * stride_b + 4 * bx)), zero);
+
+      s1 = _mm_add_epi16 (s1, va);
+      s2 = _mm_add_epi16 (s2, vb);
+      ss = _mm_add_epi32 (ss, _mm_add_epi32 (_mm_madd_epi16 (va, va),
+              _mm_madd_epi16 (vb, vb)));
+      s12 = _mm_add_epi32 (s12, _mm_madd_epi16 (va, vb));
+    }
+
+    _mm_storeu_si128 ((__m128i *) t[0], _mm_madd_epi16 (s1, ones));
+    _mm_storeu_si128 ((__m128i *) t[1], _mm_madd_epi16 (s2, ones));
+    _mm_storeu_si128 ((__m128i *) t[2], ss);
+    _mm_storeu_si128 ((__m128i *) t[3], s12);
+
+    for (x = 0; x < 4; x++) {
+      sums[4 * bx + x] = t[x][0] + t[x][1];
+      sums[4 * (bx + 1) + x] = t[x][2] + t[x][3];
+    }
+  }
+#endif
+
+  for (; bx < n_blocks; bx++) {
+    gint s1 = 0, s2 = 0, ss = 0, s12 = 0;
+
+    for (y = 0; y < 4; y++) {
+      const guint8 *pa = a + y * stride_a + 4 * bx;
+      const guint8 *pb = b + y * stride_b + 4 * bx;
+
+      for (x = 0; x < 4; x++) {
+        s1 += pa[x];
+        s2 += pb[x];
+        ss += pa[x] * pa[x] + pb[x] * pb[x];
+        s12 += pa[x] * pb[x];
+      }
+    }
+    sums[4 * bx + 0] = s1;
+    sums[4 * bx + 1] = s2;
+    sums[4 * bx + 2] = ss;
+    sums[4 * bx + 3] = s12;
+  }
+}
+
+/* number of rows of windows of @plane */
+gint
+iqa_plane_ssim_rows (const IqaPlane * plane)
+{
+  return MAX (plane->height / 4 - 1, 0);
+}
+
+/* adds the SSIM and its contrast-structure term for the windows of the
+ * rows [@row_start, @row_end) to @sums */
+void
+iqa_plane_ssim (const IqaPlane * a, const IqaPlane * b, gint row_start,
+    gint row_end, IqaSsimSums * sums)
+{
+  gint n_blocks = a->width / 4;
+  gint *block_sums[2];
+  gint row, bx;
+
+  if (n_blocks < 2 || row_start >= row_end)
+    return;
+
+  block_sums[0] = g_new (gint, 4 * n_blocks);
+  block_sums[1] = g_new (gint, 4 * n_blocks);
+
+  block_row_sums (a->data + 4 * row_start * a->stride, a->stride,
+      b->data + 4 * row_start * b->stride, b->stride, n_blocks,
+      block_sums[row_start & 1]);
+
+  for (row = row_start; row < row_end; row++) {
+    const gint *top = block_sums[row & 1];
+    const gint *bottom = block_sums[(row + 1) & 1];
+
+    block_row_sums (a->data + 4 * (row + 1) * a->stride, a->stride,
+        b->data + 4 * (row + 1) * b->stride, b->stride, n_blocks,
+        block_sums[(row + 1) & 1]);
+
+    for (bx = 0; bx < n_blocks - 1; bx++) {
+      const gint *t = top + 4 * bx, *u = bottom + 4 * bx;
+      gdouble s1 = t[0] + t[4] + u[0] + u[4];
+      gdouble s2 = t[1] + t[5] + u[1] + u[5];
+      gdouble ss = t[2] + t[6] + u[2] + u[6];
+      gdouble s12 = t[3] + t[7] + u[3] + u[7];
+      gdouble vars = ss * 64 - s1 * s1 - s2 * s2;
+      gdouble covar = s12 * 64 - s1 * s2;
+      gdouble l = (2 * s1 * s2 + SSIM_C1) / (s1 * s1 + s2 * s2 + SSIM_C1);
+      gdouble cs = (2 * covar + SSIM_C2) / (vars + SSIM_C2);
+
+      sums->ssim += l * cs;
+      sums->cs += cs;
+    }
+    sums->n_windows += n_blocks - 1;
+  }
+
+  g_free (block_sums[0]);
+  g_free (block_sums[1]);
+}
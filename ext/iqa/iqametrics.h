@@ -0,0 +1,55 @@
+/* Image Quality Assessment plugin
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_IQA_METRICS_H__
+#define __GST_IQA_METRICS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A plane of 8 bit samples, as compared by the metrics */
+typedef struct
+{
+  guint8 *data;
+  gint width, height;
+  gint stride;
+} IqaPlane;
+
+/* Partial sums of the SSIM of some windows of a plane */
+typedef struct
+{
+  gdouble ssim;
+  gdouble cs;
+  guint64 n_windows;
+} IqaSsimSums;
+
+void iqa_plane_alloc (IqaPlane * plane, gint width, gint height);
+void iqa_plane_free (IqaPlane * plane);
+void iqa_plane_downscale_2x (const IqaPlane * src, IqaPlane * dest);
+
+guint64 iqa_plane_sse (const IqaPlane * a, const IqaPlane * b,
+    gint y_start, gint y_end);
+
+gint iqa_plane_ssim_rows (const IqaPlane * plane);
+void iqa_plane_ssim (const IqaPlane * a, const IqaPlane * b,
+    gint row_start, gint row_end, IqaSsimSums * sums);
+
+G_END_DECLS
+
+#endif /* __GST_IQA_METRICS_H__ */
@@ -60,8 +60,10 @@ MotionCells::MotionCells ()
   m_motioncellsidxcstr = NULL;
   m_saveInDatafile = false;
   mc_savefile = NULL;
-  m_pcurFrame = NULL;
-  m_pprevFrame = NULL;
+  m_pgreyImage = NULL;
+  m_pcurgreyImage = NULL;
+  m_pprevgreyImage = NULL;
+  m_prevrect = cvRect (0, 0, 0, 0);
   transparencyimg = NULL;
   m_pdifferenceImage = NULL;
   m_pbwImage = NULL;
@@ -74,6 +76,8 @@ MotionCells::MotionCells ()
   m_useAlpha = false;
   m_isVisible = false;
   m_pCells = NULL;
+  m_cellsgridx = 0;
+  m_cellsgridy = 0;
   m_gridx = 0;
   m_gridy = 0;
   m_cellwidth = 0;
@@ -101,16 +105,120 @@ MotionCells::~MotionCells ()
   delete[]m_savedatafilefailed;
   if (m_motioncellsidxcstr)
     delete[]m_motioncellsidxcstr;
-  if (m_pcurFrame)
-    cvReleaseImage (&m_pcurFrame);
-  if (m_pprevFrame)
-    cvReleaseImage (&m_pprevFrame);
+  if (m_pgreyImage)
+    cvReleaseImage (&m_pgreyImage);
+  if (m_pcurgreyImage)
+    cvReleaseImage (&m_pcurgreyImage);
+  if (m_pprevgreyImage)
+    cvReleaseImage (&m_pprevgreyImage);
   if (transparencyimg)
     cvReleaseImage (&transparencyimg);
   if (m_pdifferenceImage)
     cvReleaseImage (&m_pdifferenceImage);
   if (m_pbwImage)
     cvReleaseImage (&m_pbwImage);
+  freeMotionCells ();
+}
+
+static bool
+rectEqual (CvRect a, CvRect b)
+{
+  return a.x == b.x && a.y == b.y && a.width == b.width
+      && a.height == b.height;
+}
+
+void
+MotionCells::setPrevFrame (IplImage * p_prevframe)
+{
+  allocateImages (p_prevframe);
+  convertToGrey (p_prevframe, m_pprevgreyImage, cvRect (0, 0,
+          m_pprevgreyImage->width, m_pprevgreyImage->height));
+}
+
+//(re)allocates the working images when the frame size changes
+void
+MotionCells::allocateImages (IplImage * p_frame)
+{
+  CvSize frameSize = cvGetSize (p_frame);
+
+  if (m_pgreyImage && m_pgreyImage->width == frameSize.width
+      && m_pgreyImage->height == frameSize.height)
+    return;
+
+  if (m_pgreyImage)
+    cvReleaseImage (&m_pgreyImage);
+  if (m_pcurgreyImage)
+    cvReleaseImage (&m_pcurgreyImage);
+  if (m_pprevgreyImage)
+    cvReleaseImage (&m_pprevgreyImage);
+  if (m_pdifferenceImage)
+    cvReleaseImage (&m_pdifferenceImage);
+  if (m_pbwImage)
+    cvReleaseImage (&m_pbwImage);
+
+  m_pgreyImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
+  frameSize.width /= 2;
+  frameSize.height /= 2;
+  m_pcurgreyImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
+  m_pprevgreyImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
+  m_pdifferenceImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
+  m_pbwImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
+  cvSetZero (m_pprevgreyImage);
+  //the previous frame is unknown, the next one starts over
+  m_prevrect = cvRect (0, 0, 0, 0);
+}
+
+//converts the rectangle of the frame to grey, then downscales it by 2 to the
+//same rectangle, in downscaled coordinates, of p_grey. Converting before
+//downscaling only filters one channel.
+void
+MotionCells::convertToGrey (IplImage * p_frame, IplImage * p_grey,
+    CvRect p_rect)
+{
+  CvRect rect =
+      cvRect (p_rect.x * 2, p_rect.y * 2, p_rect.width * 2, p_rect.height * 2);
+
+  cvSetImageROI (p_frame, rect);
+  cvSetImageROI (m_pgreyImage, rect);
+  cvSetImageROI (p_grey, p_rect);
+  cvCvtColor (p_frame, m_pgreyImage, CV_RGB2GRAY);
+  cvPyrDown (m_pgreyImage, p_grey);
+  cvResetImageROI (p_frame);
+  cvResetImageROI (m_pgreyImage);
+  cvResetImageROI (p_grey);
+}
+
+//the part of the downscaled frame the enabled motion cells need, or the
+//whole frame if they are all enabled
+CvRect
+MotionCells::calculateProcessingRect (motioncellidx * p_motioncellsidx,
+    int p_motioncells_count)
+{
+  int width = m_pcurgreyImage->width;
+  int height = m_pcurgreyImage->height;
+  int x1 = width, y1 = height, x2 = 0, y2 = 0;
+
+  if (p_motioncells_count == 0)
+    return cvRect (0, 0, width, height);
+
+  for (int k = 0; k < p_motioncells_count; ++k) {
+    int i = p_motioncellsidx[k].lineidx;
+    int j = p_motioncellsidx[k].columnidx;
+
+    x1 = MIN (x1, (int) floor ((double) j * m_cellwidth));
+    y1 = MIN (y1, (int) floor ((double) i * m_cellheight));
+    x2 = MAX (x2, (int) floor ((double) (j + 1) * m_cellwidth));
+    y2 = MAX (y2, (int) floor ((double) (i + 1) * m_cellheight));
+  }
+
+  x1 = MAX (x1 - MC_ROI_MARGIN, 0);
+  y1 = MAX (y1 - MC_ROI_MARGIN, 0);
+  x2 = MIN (x2 + MC_ROI_MARGIN, width);
+  y2 = MIN (y2 + MC_ROI_MARGIN, height);
+  if (x2 <= x1 || y2 <= y1)
+    return cvRect (0, 0, width, height);
+
+  return cvRect (x1, y1, x2 - x1, y2 - y1);
 }
 
 int
@@ -147,26 +255,31 @@ MotionCells::performDetectionMotionCells (IplImage * p_frame,
         return ret;
     }
 
-    frameSize = cvGetSize (p_frame);
-    frameSize.width /= 2;
-    frameSize.height /= 2;
+    allocateImages (p_frame);
+    frameSize = cvGetSize (m_pcurgreyImage);
     setMotionCells (frameSize.width, frameSize.height);
     m_sensitivity = 1 - p_sensitivity;
     m_isVisible = p_isVisible;
-    m_pcurFrame = cvCloneImage (p_frame);
-    IplImage *m_pcurgreyImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
-    IplImage *m_pprevgreyImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
-    IplImage *m_pgreyImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
-    IplImage *m_pcurDown =
-        cvCreateImage (frameSize, m_pcurFrame->depth, m_pcurFrame->nChannels);
-    IplImage *m_pprevDown = cvCreateImage (frameSize, m_pprevFrame->depth,
-        m_pprevFrame->nChannels);
-    m_pbwImage = cvCreateImage (frameSize, IPL_DEPTH_8U, 1);
-    cvPyrDown (m_pprevFrame, m_pprevDown);
-    cvCvtColor (m_pprevDown, m_pprevgreyImage, CV_RGB2GRAY);
-    cvPyrDown (m_pcurFrame, m_pcurDown);
-    cvCvtColor (m_pcurDown, m_pcurgreyImage, CV_RGB2GRAY);
-    m_pdifferenceImage = cvCloneImage (m_pcurgreyImage);
+
+    //only the area around the enabled motion cells is processed. When that
+    //area changes, the previous grey image is outdated outside of the old
+    //one: convert the whole frame and start over from it.
+    CvRect rect = calculateProcessingRect (motioncellsidx, motioncells_count);
+    if (!rectEqual (rect, m_prevrect)) {
+      m_prevrect = rect;
+      convertToGrey (p_frame, m_pcurgreyImage, cvRect (0, 0,
+              frameSize.width, frameSize.height));
+      cvCopy (m_pcurgreyImage, m_pprevgreyImage);
+    } else {
+      convertToGrey (p_frame, m_pcurgreyImage, rect);
+    }
+    if (rect.width != frameSize.width || rect.height != frameSize.height)
+      cvSetZero (m_pbwImage);
+
+    cvSetImageROI (m_pprevgreyImage, rect);
+    cvSetImageROI (m_pcurgreyImage, rect);
+    cvSetImageROI (m_pdifferenceImage, rect);
+    cvSetImageROI (m_pbwImage, rect);
     //cvSmooth(m_pcurgreyImage, m_pcurgreyImage, CV_GAUSSIAN, 3, 0);//TODO camera noise reduce,something smoothing, and rethink runningavg weights
 
     //Minus the current gray frame from the 8U moving average.
@@ -180,6 +293,11 @@ MotionCells::performDetectionMotionCells (IplImage * p_frame,
     cvDilate (m_pbwImage, m_pbwImage, NULL, 2);
     cvErode (m_pbwImage, m_pbwImage, NULL, 2);
 
+    cvResetImageROI (m_pprevgreyImage);
+    cvResetImageROI (m_pcurgreyImage);
+    cvResetImageROI (m_pdifferenceImage);
+    cvResetImageROI (m_pbwImage);
+
     //mask-out the overlay on difference image
     if (motionmaskcoord_count > 0)
       performMotionMaskCoords (motionmaskcoords, motionmaskcoord_count);
@@ -188,14 +306,17 @@ MotionCells::performDetectionMotionCells (IplImage * p_frame,
     if (getIsNonZero (m_pbwImage)) {    //detect Motion
       if (m_MotionCells.size () > 0)    //it contains previous motioncells what we used when frames dropped
         m_MotionCells.clear ();
-      if (transparencyimg)
+      if (transparencyimg && (transparencyimg->width != p_frame->width
+              || transparencyimg->height != p_frame->height))
         cvReleaseImage (&transparencyimg);
       (motioncells_count > 0) ?
           calculateMotionPercentInMotionCells (motioncellsidx,
           motioncells_count)
           : calculateMotionPercentInMotionCells (motionmaskcellsidx, 0);
 
-      transparencyimg = cvCreateImage (cvGetSize (p_frame), p_frame->depth, 3);
+      if (!transparencyimg)
+        transparencyimg =
+            cvCreateImage (cvGetSize (p_frame), p_frame->depth, 3);
       cvSetZero (transparencyimg);
       if (m_motioncellsidxcstr)
         delete[]m_motioncellsidxcstr;
@@ -256,42 +377,17 @@ MotionCells::performDetectionMotionCells (IplImage * p_frame,
       m_motioncells_idx_count = 0;
       if (m_MotionCells.size () > 0)
         m_MotionCells.clear ();
-      if (transparencyimg)
-        cvReleaseImage (&transparencyimg);
     }
 
-    if (m_pprevFrame)
-      cvReleaseImage (&m_pprevFrame);
-    m_pprevFrame = cvCloneImage (m_pcurFrame);
+    //the current grey image is the previous one of the next frame
+    IplImage *tmp = m_pprevgreyImage;
+    m_pprevgreyImage = m_pcurgreyImage;
+    m_pcurgreyImage = tmp;
     m_framecnt = 0;
-    if (m_pcurFrame)
-      cvReleaseImage (&m_pcurFrame);
-    if (m_pdifferenceImage)
-      cvReleaseImage (&m_pdifferenceImage);
-    if (m_pcurgreyImage)
-      cvReleaseImage (&m_pcurgreyImage);
-    if (m_pprevgreyImage)
-      cvReleaseImage (&m_pprevgreyImage);
-    if (m_pgreyImage)
-      cvReleaseImage (&m_pgreyImage);
-    if (m_pbwImage)
-      cvReleaseImage (&m_pbwImage);
-    if (m_pprevDown)
-      cvReleaseImage (&m_pprevDown);
-    if (m_pcurDown)
-      cvReleaseImage (&m_pcurDown);
-    if (m_pCells) {
-      for (int i = 0; i < m_gridy; ++i) {
-        delete[]m_pCells[i];
-      }
-      delete[]m_pCells;
-    }
 
     if (p_framerate <= 5) {
       if (m_MotionCells.size () > 0)
         m_MotionCells.clear ();
-      if (transparencyimg)
-        cvReleaseImage (&transparencyimg);
     }
   } else {                      //we do frame drop
     m_motioncells_idx_count = 0;
@@ -431,9 +527,6 @@ double
 MotionCells::calculateMotionPercentInCell (int p_row, int p_col,
     double *p_cellarea, double *p_motionarea)
 {
-  double cntpixelsnum = 0;
-  double cntmotionpixelnum = 0;
-
   int ybegin = floor ((double) p_row * m_cellheight);
   int yend = floor ((double) (p_row + 1) * m_cellheight);
   int xbegin = floor ((double) (p_col) * m_cellwidth);
@@ -442,28 +535,17 @@ MotionCells::calculateMotionPercentInCell (int p_row, int p_col,
   int cellh = yend - ybegin;
   int cellarea = cellw * cellh;
   *p_cellarea = cellarea;
-  int thresholdmotionpixelnum = floor ((double) cellarea * m_sensitivity);
-
-  for (int i = ybegin; i < yend; i++) {
-    for (int j = xbegin; j < xend; j++) {
-      cntpixelsnum++;
-      if ((((uchar *) (m_pbwImage->imageData + m_pbwImage->widthStep * i))[j]) >
-          0) {
-        cntmotionpixelnum++;
-        if (cntmotionpixelnum >= thresholdmotionpixelnum) {     //we dont needs calculate anymore
-          *p_motionarea = cntmotionpixelnum;
-          return (cntmotionpixelnum / cntpixelsnum);
-        }
-      }
-      int remainingpixelsnum = cellarea - cntpixelsnum;
-      if ((cntmotionpixelnum + remainingpixelsnum) < thresholdmotionpixelnum) { //moving pixels number will be less than threshold
-        *p_motionarea = 0;
-        return 0;
-      }
-    }
+
+  if (cellarea <= 0) {
+    *p_motionarea = 0;
+    return 0;
   }
 
-  return (cntmotionpixelnum / cntpixelsnum);
+  cvSetImageROI (m_pbwImage, cvRect (xbegin, ybegin, cellw, cellh));
+  *p_motionarea = cvCountNonZero (m_pbwImage);
+  cvResetImageROI (m_pbwImage);
+
+  return *p_motionarea / cellarea;
 }
 
 void
@@ -550,10 +632,12 @@ MotionCells::performMotionMask (motioncellidx * p_motionmaskcellsidx,
         (double) p_motionmaskcellsidx[k].columnidx * m_cellwidth + m_cellwidth;
     int endy =
         (double) p_motionmaskcellsidx[k].lineidx * m_cellheight + m_cellheight;
-    for (int i = beginy; i < endy; i++)
-      for (int j = beginx; j < endx; j++) {
-        ((uchar *) (m_pbwImage->imageData + m_pbwImage->widthStep * i))[j] = 0;
-      }
+    if (endx <= beginx || endy <= beginy)
+      continue;
+    cvSetImageROI (m_pbwImage, cvRect (beginx, beginy, endx - beginx,
+            endy - beginy));
+    cvSetZero (m_pbwImage);
+    cvResetImageROI (m_pbwImage);
   }
 }
 
@@ -63,6 +63,9 @@
 #define MC_VERSIONTEXT "MotionCells-1"
 #define MSGLEN 6
 #define BUSMSGLEN 20
+//extra pixels processed around the motion cells, enough for the adaptive
+//threshold, dilate and erode to see the same neighbourhood as on full frames
+#define MC_ROI_MARGIN 8
 
 using namespace std;
 
@@ -139,10 +142,7 @@ public:
       int motioncells_count, motioncellidx * motioncellsidx, gint64 starttime,
       char *datafile, bool p_changed_datafile, int p_thickness);
 
-  void setPrevFrame (IplImage * p_prevframe)
-  {
-    m_pprevFrame = cvCloneImage (p_prevframe);
-  }
+  void setPrevFrame (IplImage * p_prevframe);
   char *getMotionCellsIdx ()
   {
     return m_motioncellsidxcstr;
@@ -201,6 +201,10 @@ private:
   int initDataFile (char *p_datafile, gint64 starttime);
   void blendImages (IplImage * p_actFrame, IplImage * p_cellsFrame,
       float p_alpha, float p_beta);
+  void allocateImages (IplImage * p_frame);
+  CvRect calculateProcessingRect (motioncellidx * p_motioncellsidx,
+      int p_motioncells_count);
+  void convertToGrey (IplImage * p_frame, IplImage * p_grey, CvRect p_rect);
 
   void setData (IplImage * img, int lin, int col, uchar valor)
   {
@@ -214,14 +218,17 @@ private:
 
   bool getIsNonZero (IplImage * img)
   {
-    int lin, col;
+    return cvCountNonZero (img) > 0;
+  }
 
-    for (lin = 0; lin < img->height; lin++)
-      for (col = 0; col < img->width; col++) {
-        if ((((uchar *) (img->imageData + img->widthStep * lin))[col]) > 0)
-          return true;
-      }
-    return false;
+  void freeMotionCells ()
+  {
+    if (m_pCells) {
+      for (int i = 0; i < m_cellsgridy; ++i)
+        delete[]m_pCells[i];
+      delete[]m_pCells;
+      m_pCells = NULL;
+    }
   }
 
   void setMotionCells (int p_frameWidth, int p_frameHeight)
@@ -230,9 +237,14 @@ private:
 
     m_cellwidth = (double) p_frameWidth / (double) m_gridx;
     m_cellheight = (double) p_frameHeight / (double) m_gridy;
-    m_pCells = new Cell *[m_gridy];
-    for (i = 0; i < m_gridy; i++)
-      m_pCells[i] = new Cell[m_gridx];
+    if (!m_pCells || m_cellsgridx != m_gridx || m_cellsgridy != m_gridy) {
+      freeMotionCells ();
+      m_pCells = new Cell *[m_gridy];
+      for (i = 0; i < m_gridy; i++)
+        m_pCells[i] = new Cell[m_gridx];
+      m_cellsgridx = m_gridx;
+      m_cellsgridy = m_gridy;
+    }
 
     //init cells
     for (i = 0; i < m_gridy; i++)
@@ -244,10 +256,14 @@ private:
       }
   }
 
-  IplImage *m_pcurFrame, *m_pprevFrame, *m_pdifferenceImage,
-      *m_pbwImage,*transparencyimg;
+  //the grey images are downscaled by 2, the previous one is kept from the
+  //last processed frame
+  IplImage *m_pgreyImage, *m_pcurgreyImage, *m_pprevgreyImage,
+      *m_pdifferenceImage, *m_pbwImage, *transparencyimg;
+  CvRect m_prevrect;
   bool m_isVisible, m_changed_datafile, m_useAlpha, m_saveInDatafile;
   Cell **m_pCells;
+  int m_cellsgridx, m_cellsgridy;
   vector < MotionCellsIdx > m_MotionCells;
   vector < OverlayRegions > m_OverlayRegions;
   int m_gridx, m_gridy;
@@ -0,0 +1,92 @@
+/* GStreamer
+ *
+ * gstcvanalysispool.cpp: threads shared by the analysis elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* One pool of threads, as many as there are processors, runs the analysis
+ * of all the element instances of the plugin, so that many streams don't
+ * start more threads than the machine can run. The elements skip the frames
+ * they can't get analysed right away instead of queueing them, which would
+ * only add latency. */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "gstcvanalysispool.h"
+
+typedef struct
+{
+  GFunc func;
+  gpointer data;
+} GstCvAnalysisTask;
+
+static GOnce once = G_ONCE_INIT;
+static guint n_threads;
+/* the tasks pushed and not finished yet */
+static volatile gint n_tasks;
+
+static void
+gst_cv_analysis_pool_run (gpointer data, gpointer user_data)
+{
+  GstCvAnalysisTask *task = (GstCvAnalysisTask *) data;
+
+  task->func (task->data, NULL);
+  g_slice_free (GstCvAnalysisTask, task);
+  g_atomic_int_add (&n_tasks, -1);
+}
+
+static gpointer
+gst_cv_analysis_pool_create (gpointer data)
+{
+  n_threads = g_get_num_processors ();
+
+  return g_thread_pool_new (gst_cv_analysis_pool_run, NULL, n_threads, FALSE,
+      NULL);
+}
+
+/* Reserves one of the threads for a task, pushed with
+ * gst_cv_analysis_pool_push(). Returns FALSE if they are all busy, the caller
+ * should then skip the analysis: a queued task would only wait for another
+ * one to finish. */
+gboolean
+gst_cv_analysis_pool_reserve (void)
+{
+  g_once (&once, gst_cv_analysis_pool_create, NULL);
+
+  if (g_atomic_int_add (&n_tasks, 1) >= (gint) n_threads) {
+    g_atomic_int_add (&n_tasks, -1);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Runs func (data, NULL) in the thread reserved by
+ * gst_cv_analysis_pool_reserve() */
+void
+gst_cv_analysis_pool_push (GFunc func, gpointer data)
+{
+  GstCvAnalysisTask *task;
+
+  task = g_slice_new (GstCvAnalysisTask);
+  task->func = func;
+  task->data = data;
+
+  g_thread_pool_push ((GThreadPool *) once.retval, task, NULL);
+}
@@ -0,0 +1,34 @@
+/* GStreamer
+ *
+ * gstcvanalysispool.h: threads shared by the analysis elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CV_ANALYSIS_POOL_H__
+#define __GST_CV_ANALYSIS_POOL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gboolean gst_cv_analysis_pool_reserve (void);
+
+void gst_cv_analysis_pool_push (GFunc func, gpointer data);
+
+G_END_DECLS
+
+#endif /* __GST_CV_ANALYSIS_POOL_H__ */
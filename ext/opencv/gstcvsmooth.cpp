@@ -134,8 +134,14 @@ static void gst_cv_smooth_set_property (GObject * object, guint prop_id,
 static void gst_cv_smooth_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
+static void gst_cv_smooth_finalize (GObject * obj);
+
 static GstFlowReturn gst_cv_smooth_transform_ip (GstOpencvVideoFilter *
-    filter, GstBuffer * buf, IplImage * img);
+    filter, GstBuffer * buf, cv::Mat & img);
+#ifdef GST_OPENCV_HAVE_UMAT
+static GstFlowReturn gst_cv_smooth_transform_ip_umat (GstOpencvVideoFilter *
+    filter, GstBuffer * buf, cv::UMat & img);
+#endif
 
 /* initialize the cvsmooth's class */
 static void
@@ -152,8 +158,13 @@ gst_cv_smooth_class_init (GstCvSmoothClass * klass)
 
   gobject_class->set_property = gst_cv_smooth_set_property;
   gobject_class->get_property = gst_cv_smooth_get_property;
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_cv_smooth_finalize);
 
-  gstopencvbasefilter_class->cv_trans_ip_func = gst_cv_smooth_transform_ip;
+  gstopencvbasefilter_class->cv_trans_ip_mat_func = gst_cv_smooth_transform_ip;
+#ifdef GST_OPENCV_HAVE_UMAT
+  gstopencvbasefilter_class->cv_trans_ip_umat_func =
+      gst_cv_smooth_transform_ip_umat;
+#endif
 
   g_object_class_install_property (gobject_class, PROP_SMOOTH_TYPE,
       g_param_spec_enum ("type",
@@ -245,10 +256,28 @@ gst_cv_smooth_init (GstCvSmooth * filter)
   filter->width = DEFAULT_WIDTH;
   filter->height = DEFAULT_HEIGHT;
 
+  filter->cvSrc = new cv::Mat ();
+#ifdef GST_OPENCV_HAVE_UMAT
+  filter->ucvSrc = new cv::UMat ();
+#endif
+
   gst_opencv_video_filter_set_in_place (GST_OPENCV_VIDEO_FILTER_CAST (filter),
       TRUE);
 }
 
+static void
+gst_cv_smooth_finalize (GObject * obj)
+{
+  GstCvSmooth *filter = GST_CV_SMOOTH (obj);
+
+  delete filter->cvSrc;
+#ifdef GST_OPENCV_HAVE_UMAT
+  delete filter->ucvSrc;
+#endif
+
+  G_OBJECT_CLASS (gst_cv_smooth_parent_class)->finalize (obj);
+}
+
 static void
 gst_cv_smooth_change_type (GstCvSmooth * filter, gint value)
 {
@@ -366,12 +395,11 @@ gst_cv_smooth_get_property (GObject * object, guint prop_id,
   }
 }
 
-static GstFlowReturn
-gst_cv_smooth_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img)
+/* M is cv::Mat or cv::UMat */
+template < typename M > static void
+gst_cv_smooth_process (GstCvSmooth * filter, M & img, M & src)
 {
-  GstCvSmooth *filter = GST_CV_SMOOTH (base);
-  Mat mat = cvarrToMat(img);
+  M mat = img;
 
   if (filter->positionx != 0 || filter->positiony != 0 ||
       filter->width != G_MAXINT || filter->height != G_MAXINT) {
@@ -380,10 +408,10 @@ gst_cv_smooth_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     /* if the effect would start outside the image, just skip it */
     if (filter->positionx >= mat_size.width
         || filter->positiony >= mat_size.height)
-      return GST_FLOW_OK;
+      return;
     /* explicitly account for empty area */
     if (filter->width <= 0 || filter->height <= 0)
-      return GST_FLOW_OK;
+      return;
 
     Rect mat_rect(filter->positionx,
         filter->positiony,
@@ -403,18 +431,43 @@ gst_cv_smooth_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
           filter->colorsigma, filter->colorsigma);
       break;
     case CV_MEDIAN:
-      medianBlur (mat, mat, filter->kernelwidth);
+      /* neither filter supports the destination being the source */
+      mat.copyTo (src);
+      medianBlur (src, mat, filter->kernelwidth);
       break;
     case CV_BILATERAL:
-      bilateralFilter (mat, mat, -1, filter->colorsigma, 0.0);
+      mat.copyTo (src);
+      bilateralFilter (src, mat, -1, filter->colorsigma, 0.0);
       break;
     default:
       break;
   }
+}
+
+static GstFlowReturn
+gst_cv_smooth_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
+    cv::Mat & img)
+{
+  GstCvSmooth *filter = GST_CV_SMOOTH (base);
+
+  gst_cv_smooth_process (filter, img, *filter->cvSrc);
 
   return GST_FLOW_OK;
 }
 
+#ifdef GST_OPENCV_HAVE_UMAT
+static GstFlowReturn
+gst_cv_smooth_transform_ip_umat (GstOpencvVideoFilter * base, GstBuffer * buf,
+    cv::UMat & img)
+{
+  GstCvSmooth *filter = GST_CV_SMOOTH (base);
+
+  gst_cv_smooth_process (filter, img, *filter->ucvSrc);
+
+  return GST_FLOW_OK;
+}
+#endif
+
 gboolean
 gst_cv_smooth_plugin_init (GstPlugin * plugin)
 {
@@ -79,6 +79,12 @@ struct _GstCvSmooth
   gint positiony;
   gint width;
   gint height;
+
+  /* copy of the source for the filters that can't work in place */
+  cv::Mat *cvSrc;
+#ifdef GST_OPENCV_HAVE_UMAT
+  cv::UMat *ucvSrc;
+#endif
 };
 
 struct _GstCvSmoothClass
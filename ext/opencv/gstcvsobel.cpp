@@ -59,6 +59,7 @@
 #endif
 
 #include "gstcvsobel.h"
+#include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/imgproc/imgproc_c.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_cv_sobel_debug);
@@ -104,10 +105,12 @@ static void gst_cv_sobel_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_cv_sobel_transform (GstOpencvVideoFilter * filter,
-    GstBuffer * buf, IplImage * img, GstBuffer * outbuf, IplImage * outimg);
-static gboolean gst_cv_sobel_set_caps (GstOpencvVideoFilter * transform,
-    gint in_width, gint in_height, gint in_depth, gint in_channels,
-    gint out_width, gint out_height, gint out_depth, gint out_channels);
+    GstBuffer * buf, cv::Mat & img, GstBuffer * outbuf, cv::Mat & outimg);
+#ifdef GST_OPENCV_HAVE_UMAT
+static GstFlowReturn gst_cv_sobel_transform_umat (GstOpencvVideoFilter *
+    filter, GstBuffer * buf, cv::UMat & img, GstBuffer * outbuf,
+    cv::UMat & outimg);
+#endif
 
 /* Clean up */
 static void
@@ -115,10 +118,12 @@ gst_cv_sobel_finalize (GObject * obj)
 {
   GstCvSobel *filter = GST_CV_SOBEL (obj);
 
-  if (filter->cvSobel != NULL) {
-    cvReleaseImage (&filter->cvGray);
-    cvReleaseImage (&filter->cvSobel);
-  }
+  delete filter->cvGray;
+  delete filter->cvSobel;
+#ifdef GST_OPENCV_HAVE_UMAT
+  delete filter->ucvGray;
+  delete filter->ucvSobel;
+#endif
 
   G_OBJECT_CLASS (gst_cv_sobel_parent_class)->finalize (obj);
 }
@@ -138,8 +143,10 @@ gst_cv_sobel_class_init (GstCvSobelClass * klass)
   gobject_class->set_property = gst_cv_sobel_set_property;
   gobject_class->get_property = gst_cv_sobel_get_property;
 
-  gstopencvbasefilter_class->cv_trans_func = gst_cv_sobel_transform;
-  gstopencvbasefilter_class->cv_set_caps = gst_cv_sobel_set_caps;
+  gstopencvbasefilter_class->cv_trans_mat_func = gst_cv_sobel_transform;
+#ifdef GST_OPENCV_HAVE_UMAT
+  gstopencvbasefilter_class->cv_trans_umat_func = gst_cv_sobel_transform_umat;
+#endif
 
   g_object_class_install_property (gobject_class, PROP_X_ORDER,
       g_param_spec_int ("x-order", "x order",
@@ -178,29 +185,18 @@ gst_cv_sobel_init (GstCvSobel * filter)
   filter->aperture_size = DEFAULT_APERTURE_SIZE;
   filter->mask = DEFAULT_MASK;
 
+  /* allocated on the first frame, and again only if the size changes */
+  filter->cvGray = new cv::Mat ();
+  filter->cvSobel = new cv::Mat ();
+#ifdef GST_OPENCV_HAVE_UMAT
+  filter->ucvGray = new cv::UMat ();
+  filter->ucvSobel = new cv::UMat ();
+#endif
+
   gst_opencv_video_filter_set_in_place (GST_OPENCV_VIDEO_FILTER_CAST (filter),
       FALSE);
 }
 
-/* this function handles the link with other elements */
-static gboolean
-gst_cv_sobel_set_caps (GstOpencvVideoFilter * transform,
-    gint in_width, gint in_height, gint in_depth, gint in_channels,
-    gint out_width, gint out_height, gint out_depth, gint out_channels)
-{
-  GstCvSobel *filter = GST_CV_SOBEL (transform);
-
-  if (filter->cvSobel != NULL) {
-      cvReleaseImage (&filter->cvGray);
-      cvReleaseImage (&filter->cvSobel);
-  }
-
-  filter->cvGray = cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U, 1);
-  filter->cvSobel = cvCreateImage (cvSize (out_width, out_height), IPL_DEPTH_8U, 1);
-
-  return TRUE;
-}
-
 static void
 gst_cv_sobel_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -257,25 +253,48 @@ gst_cv_sobel_get_property (GObject * object, guint prop_id,
   }
 }
 
+/* M is cv::Mat or cv::UMat, the border mode is the one of cvSobel() */
+template < typename M > static void
+gst_cv_sobel_process (GstCvSobel * filter, M & img, M & outimg, M & gray,
+    M & sobel)
+{
+  cv::cvtColor (img, gray, CV_RGB2GRAY);
+  cv::Sobel (gray, sobel, CV_8U, filter->x_order, filter->y_order,
+      filter->aperture_size, 1, 0, cv::BORDER_REPLICATE);
+
+  outimg.setTo (cv::Scalar::all (0));
+  if (filter->mask) {
+    img.copyTo (outimg, sobel);
+  } else {
+    cv::cvtColor (sobel, outimg, CV_GRAY2RGB);
+  }
+}
+
 static GstFlowReturn
 gst_cv_sobel_transform (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img, GstBuffer * outbuf, IplImage * outimg)
+    cv::Mat & img, GstBuffer * outbuf, cv::Mat & outimg)
 {
   GstCvSobel *filter = GST_CV_SOBEL (base);
 
-  cvCvtColor (img, filter->cvGray, CV_RGB2GRAY);
-  cvSobel (filter->cvGray, filter->cvSobel, filter->x_order, filter->y_order,
-      filter->aperture_size);
+  gst_cv_sobel_process (filter, img, outimg, *filter->cvGray,
+      *filter->cvSobel);
 
-  cvZero (outimg);
-  if (filter->mask) {
-    cvCopy (img, outimg, filter->cvSobel);
-  } else {
-    cvCvtColor (filter->cvSobel, outimg, CV_GRAY2RGB);
-  }
+  return GST_FLOW_OK;
+}
+
+#ifdef GST_OPENCV_HAVE_UMAT
+static GstFlowReturn
+gst_cv_sobel_transform_umat (GstOpencvVideoFilter * base, GstBuffer * buf,
+    cv::UMat & img, GstBuffer * outbuf, cv::UMat & outimg)
+{
+  GstCvSobel *filter = GST_CV_SOBEL (base);
+
+  gst_cv_sobel_process (filter, img, outimg, *filter->ucvGray,
+      *filter->ucvSobel);
 
   return GST_FLOW_OK;
 }
+#endif
 
 gboolean
 gst_cv_sobel_plugin_init (GstPlugin * plugin)
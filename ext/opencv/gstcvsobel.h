@@ -72,8 +72,12 @@ struct _GstCvSobel
   gint aperture_size;
   gboolean mask;
 
-  IplImage *cvGray;
-  IplImage *cvSobel;
+  cv::Mat *cvGray;
+  cv::Mat *cvSobel;
+#ifdef GST_OPENCV_HAVE_UMAT
+  cv::UMat *ucvGray;
+  cv::UMat *ucvSobel;
+#endif
 };
 
 struct _GstCvSobelClass
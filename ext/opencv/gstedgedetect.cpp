@@ -61,6 +61,7 @@
 #endif
 
 #include "gstedgedetect.h"
+#include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/imgproc/imgproc_c.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_edge_detect_debug);
@@ -106,10 +107,12 @@ static void gst_edge_detect_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_edge_detect_transform (GstOpencvVideoFilter * filter,
-    GstBuffer * buf, IplImage * img, GstBuffer * outbuf, IplImage * outimg);
-static gboolean gst_edge_detect_set_caps (GstOpencvVideoFilter * transform,
-    gint in_width, gint in_height, gint in_depth, gint in_channels,
-    gint out_width, gint out_height, gint out_depth, gint out_channels);
+    GstBuffer * buf, cv::Mat & img, GstBuffer * outbuf, cv::Mat & outimg);
+#ifdef GST_OPENCV_HAVE_UMAT
+static GstFlowReturn gst_edge_detect_transform_umat (GstOpencvVideoFilter *
+    filter, GstBuffer * buf, cv::UMat & img, GstBuffer * outbuf,
+    cv::UMat & outimg);
+#endif
 
 /* Clean up */
 static void
@@ -117,10 +120,12 @@ gst_edge_detect_finalize (GObject * obj)
 {
   GstEdgeDetect *filter = GST_EDGE_DETECT (obj);
 
-  if (filter->cvEdge != NULL) {
-    cvReleaseImage (&filter->cvGray);
-    cvReleaseImage (&filter->cvEdge);
-  }
+  delete filter->cvGray;
+  delete filter->cvEdge;
+#ifdef GST_OPENCV_HAVE_UMAT
+  delete filter->ucvGray;
+  delete filter->ucvEdge;
+#endif
 
   G_OBJECT_CLASS (gst_edge_detect_parent_class)->finalize (obj);
 }
@@ -140,8 +145,11 @@ gst_edge_detect_class_init (GstEdgeDetectClass * klass)
   gobject_class->set_property = gst_edge_detect_set_property;
   gobject_class->get_property = gst_edge_detect_get_property;
 
-  gstopencvbasefilter_class->cv_trans_func = gst_edge_detect_transform;
-  gstopencvbasefilter_class->cv_set_caps = gst_edge_detect_set_caps;
+  gstopencvbasefilter_class->cv_trans_mat_func = gst_edge_detect_transform;
+#ifdef GST_OPENCV_HAVE_UMAT
+  gstopencvbasefilter_class->cv_trans_umat_func =
+      gst_edge_detect_transform_umat;
+#endif
 
   g_object_class_install_property (gobject_class, PROP_MASK,
       g_param_spec_boolean ("mask", "Mask",
@@ -183,6 +191,14 @@ gst_edge_detect_init (GstEdgeDetect * filter)
   filter->threshold2 = 150;
   filter->aperture = 3;
 
+  /* allocated on the first frame, and again only if the size changes */
+  filter->cvGray = new cv::Mat ();
+  filter->cvEdge = new cv::Mat ();
+#ifdef GST_OPENCV_HAVE_UMAT
+  filter->ucvGray = new cv::UMat ();
+  filter->ucvEdge = new cv::UMat ();
+#endif
+
   gst_opencv_video_filter_set_in_place (GST_OPENCV_VIDEO_FILTER_CAST (filter),
       FALSE);
 }
@@ -239,44 +255,48 @@ gst_edge_detect_get_property (GObject * object, guint prop_id,
 
 /* GstElement vmethod implementations */
 
-/* this function handles the link with other elements */
-static gboolean
-gst_edge_detect_set_caps (GstOpencvVideoFilter * transform,
-    gint in_width, gint in_height, gint in_depth, gint in_channels,
-    gint out_width, gint out_height, gint out_depth, gint out_channels)
+/* M is cv::Mat or cv::UMat */
+template < typename M > static void
+gst_edge_detect_process (GstEdgeDetect * filter, M & img, M & outimg,
+    M & gray, M & edge)
 {
-  GstEdgeDetect *filter = GST_EDGE_DETECT (transform);
+  cv::cvtColor (img, gray, CV_RGB2GRAY);
+  cv::Canny (gray, edge, filter->threshold1, filter->threshold2,
+      filter->aperture);
 
-  if (filter->cvEdge != NULL) {
-      cvReleaseImage (&filter->cvGray);
-      cvReleaseImage (&filter->cvEdge);
+  outimg.setTo (cv::Scalar::all (0));
+  if (filter->mask) {
+    img.copyTo (outimg, edge);
+  } else {
+    cv::cvtColor (edge, outimg, CV_GRAY2RGB);
   }
-
-  filter->cvGray = cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U, 1);
-  filter->cvEdge = cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U, 1);
-
-  return TRUE;
 }
 
 static GstFlowReturn
 gst_edge_detect_transform (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img, GstBuffer * outbuf, IplImage * outimg)
+    cv::Mat & img, GstBuffer * outbuf, cv::Mat & outimg)
 {
   GstEdgeDetect *filter = GST_EDGE_DETECT (base);
 
-  cvCvtColor (img, filter->cvGray, CV_RGB2GRAY);
-  cvCanny (filter->cvGray, filter->cvEdge, filter->threshold1,
-      filter->threshold2, filter->aperture);
+  gst_edge_detect_process (filter, img, outimg, *filter->cvGray,
+      *filter->cvEdge);
 
-  cvZero (outimg);
-  if (filter->mask) {
-    cvCopy (img, outimg, filter->cvEdge);
-  } else {
-    cvCvtColor (filter->cvEdge, outimg, CV_GRAY2RGB);
-  }
+  return GST_FLOW_OK;
+}
+
+#ifdef GST_OPENCV_HAVE_UMAT
+static GstFlowReturn
+gst_edge_detect_transform_umat (GstOpencvVideoFilter * base, GstBuffer * buf,
+    cv::UMat & img, GstBuffer * outbuf, cv::UMat & outimg)
+{
+  GstEdgeDetect *filter = GST_EDGE_DETECT (base);
+
+  gst_edge_detect_process (filter, img, outimg, *filter->ucvGray,
+      *filter->ucvEdge);
 
   return GST_FLOW_OK;
 }
+#endif
 
 /* entry point to initialize the plug-in
  * initialize the plug-in itself
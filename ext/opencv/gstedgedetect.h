@@ -75,8 +75,12 @@ struct _GstEdgeDetect
   int threshold2;
   int aperture;
 
-  IplImage *cvEdge;
-  IplImage *cvGray;
+  cv::Mat *cvEdge;
+  cv::Mat *cvGray;
+#ifdef GST_OPENCV_HAVE_UMAT
+  cv::UMat *ucvEdge;
+  cv::UMat *ucvGray;
+#endif
 };
 
 struct _GstEdgeDetectClass
@@ -63,6 +63,20 @@
  * |[
  * gst-launch-1.0 autovideosrc ! video/x-raw,width=320,height=240 ! videoconvert ! facedetect min-size-width=60 min-size-height=60 ! colorspace ! xvimagesink
  * ]| Detect large faces on a smaller image
+ * |[
+ * gst-launch-1.0 v4l2src ! videoconvert ! facedetect detection-scale=0.25 detection-interval=5 async-detection=true ! videoconvert ! xvimagesink
+ * ]| Detect on a quarter size copy of every fifth frame, in a separate thread
+ *
+ * With #GstFaceDetect:detection-scale below 1 the detection runs on a
+ * downscaled copy of the frame, and with #GstFaceDetect:detection-interval
+ * above 1 only on some of the frames. The faces are moved along with their
+ * estimated motion on the frames in between. With
+ * #GstFaceDetect:async-detection the detection runs in a separate thread and
+ * the video is never delayed by it: the frames are annotated with the latest
+ * detection that finished, whichever frame it was run on.
+ *
+ * The faces are also attached to the buffers as
+ * #GstVideoRegionOfInterestMeta.
  *
  * </refsect2>
  */
@@ -101,6 +115,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_face_detect_debug);
 #define DEFAULT_MIN_SIZE_WIDTH 30
 #define DEFAULT_MIN_SIZE_HEIGHT 30
 #define DEFAULT_MIN_STDDEV 0
+#define DEFAULT_DETECTION_INTERVAL 1
+#define DEFAULT_DETECTION_SCALE 1.0
+#define DEFAULT_ASYNC_DETECTION FALSE
+
+/* the faces are not extrapolated further than this */
+#define MAX_PREDICTION_FRAMES 30
 
 using namespace cv;
 /* Filter signals and args */
@@ -124,7 +144,10 @@ enum
   PROP_MIN_SIZE_WIDTH,
   PROP_MIN_SIZE_HEIGHT,
   PROP_UPDATES,
-  PROP_MIN_STDDEV
+  PROP_MIN_STDDEV,
+  PROP_DETECTION_INTERVAL,
+  PROP_DETECTION_SCALE,
+  PROP_ASYNC_DETECTION
 };
 
 
@@ -141,19 +164,17 @@ typedef enum
 #define GST_TYPE_OPENCV_FACE_DETECT_FLAGS (gst_opencv_face_detect_flags_get_type())
 
 inline void
-structure_and_message (const vector < Rect > &rectangles, const gchar * name,
-    guint rx, guint ry, GstFaceDetect * filter, GstStructure * s)
+structure_and_message (const Rect & sr, const gchar * name,
+    GstFaceDetect * filter, GstStructure * s)
 {
-  Rect sr = rectangles[0];
   gchar *nx = g_strconcat (name, "->x", NULL);
   gchar *ny = g_strconcat (name, "->y", NULL);
   gchar *nw = g_strconcat (name, "->width", NULL);
   gchar *nh = g_strconcat (name, "->height", NULL);
 
-  GST_LOG_OBJECT (filter,
-      "%s/%" G_GSIZE_FORMAT ": x,y = %4u,%4u: w.h = %4u,%4u",
-      name, rectangles.size (), rx + sr.x, ry + sr.y, sr.width, sr.height);
-  gst_structure_set (s, nx, G_TYPE_UINT, rx + sr.x, ny, G_TYPE_UINT, ry + sr.y,
+  GST_LOG_OBJECT (filter, "%s: x,y = %4u,%4u: w.h = %4u,%4u",
+      name, sr.x, sr.y, sr.width, sr.height);
+  gst_structure_set (s, nx, G_TYPE_UINT, sr.x, ny, G_TYPE_UINT, sr.y,
       nw, G_TYPE_UINT, sr.width, nh, G_TYPE_UINT, sr.height, NULL);
 
   g_free (nx);
@@ -230,11 +251,9 @@ static void gst_face_detect_set_property (GObject * object, guint prop_id,
 static void gst_face_detect_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
-static gboolean gst_face_detect_set_caps (GstOpencvVideoFilter * transform,
-    gint in_width, gint in_height, gint in_depth, gint in_channels,
-    gint out_width, gint out_height, gint out_depth, gint out_channels);
+static gboolean gst_face_detect_stop (GstBaseTransform * trans);
 static GstFlowReturn gst_face_detect_transform_ip (GstOpencvVideoFilter * base,
-    GstBuffer * buf, IplImage * img);
+    GstBuffer * buf, cv::Mat & img);
 
 static CascadeClassifier *gst_face_detect_load_profile (GstFaceDetect *
     filter, gchar * profile);
@@ -245,8 +264,15 @@ gst_face_detect_finalize (GObject * obj)
 {
   GstFaceDetect *filter = GST_FACE_DETECT (obj);
 
-  if (filter->cvGray)
-    cvReleaseImage (&filter->cvGray);
+  delete filter->cvScaled;
+  delete filter->cvGray;
+  delete filter->job_gray;
+  delete filter->faces;
+  delete filter->result_faces;
+
+  g_mutex_clear (&filter->lock);
+  g_cond_clear (&filter->cond);
+  g_mutex_clear (&filter->cascade_lock);
 
   g_free (filter->face_profile);
   g_free (filter->nose_profile);
@@ -270,18 +296,22 @@ static void
 gst_face_detect_class_init (GstFaceDetectClass * klass)
 {
   GObjectClass *gobject_class;
+  GstBaseTransformClass *trans_class;
   GstOpencvVideoFilterClass *gstopencvbasefilter_class;
 
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   gobject_class = (GObjectClass *) klass;
+  trans_class = (GstBaseTransformClass *) klass;
   gstopencvbasefilter_class = (GstOpencvVideoFilterClass *) klass;
 
   gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_face_detect_finalize);
   gobject_class->set_property = gst_face_detect_set_property;
   gobject_class->get_property = gst_face_detect_get_property;
 
-  gstopencvbasefilter_class->cv_trans_ip_func = gst_face_detect_transform_ip;
-  gstopencvbasefilter_class->cv_set_caps = gst_face_detect_set_caps;
+  trans_class->stop = GST_DEBUG_FUNCPTR (gst_face_detect_stop);
+
+  gstopencvbasefilter_class->cv_trans_ip_mat_func =
+      gst_face_detect_transform_ip;
 
   g_object_class_install_property (gobject_class, PROP_DISPLAY,
       g_param_spec_boolean ("display", "Display",
@@ -346,6 +376,46 @@ gst_face_detect_class_init (GstFaceDetectClass * klass)
           "false positives not performing face detection on images with "
           "little changes", 0, 255, DEFAULT_MIN_STDDEV,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  /**
+   * GstFaceDetect:detection-interval:
+   *
+   * Number of frames between two detections. The faces of the frames in
+   * between are extrapolated from the latest detection.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DETECTION_INTERVAL,
+      g_param_spec_uint ("detection-interval", "Detection interval",
+          "Run the detection once every this many frames", 1, G_MAXUINT,
+          DEFAULT_DETECTION_INTERVAL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  /**
+   * GstFaceDetect:detection-scale:
+   *
+   * Scale of the copy of the frame the detection runs on. The minimum face
+   * sizes are scaled accordingly.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DETECTION_SCALE,
+      g_param_spec_double ("detection-scale", "Detection scale",
+          "Scale the frames by this factor before running the detection",
+          0.05, 1.0, DEFAULT_DETECTION_SCALE,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  /**
+   * GstFaceDetect:async-detection:
+   *
+   * Run the detection in a separate thread. The video is then never
+   * delayed by it, and frames are skipped by the detection whenever it is
+   * slower than the video.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC_DETECTION,
+      g_param_spec_boolean ("async-detection", "Asynchronous detection",
+          "Run the detection in a separate thread, without delaying the video",
+          DEFAULT_ASYNC_DETECTION,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
   gst_element_class_set_static_metadata (element_class,
       "facedetect",
@@ -375,6 +445,19 @@ gst_face_detect_init (GstFaceDetect * filter)
   filter->min_size_width = DEFAULT_MIN_SIZE_WIDTH;
   filter->min_size_height = DEFAULT_MIN_SIZE_HEIGHT;
   filter->min_stddev = DEFAULT_MIN_STDDEV;
+  filter->detection_interval = DEFAULT_DETECTION_INTERVAL;
+  filter->detection_scale = DEFAULT_DETECTION_SCALE;
+  filter->async_detection = DEFAULT_ASYNC_DETECTION;
+
+  filter->cvScaled = new Mat ();
+  filter->cvGray = new Mat ();
+  filter->job_gray = new Mat ();
+  filter->faces = new vector < GstFaceDetectFace > ();
+  filter->result_faces = new vector < GstFaceDetectFace > ();
+  g_mutex_init (&filter->lock);
+  g_cond_init (&filter->cond);
+  g_mutex_init (&filter->cascade_lock);
+
   filter->cvFaceDetect =
       gst_face_detect_load_profile (filter, filter->face_profile);
   filter->cvNoseDetect =
@@ -398,35 +481,43 @@ gst_face_detect_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_FACE_PROFILE:
       g_free (filter->face_profile);
+      g_mutex_lock (&filter->cascade_lock);
       if (filter->cvFaceDetect)
         delete (filter->cvFaceDetect);
       filter->face_profile = g_value_dup_string (value);
       filter->cvFaceDetect =
           gst_face_detect_load_profile (filter, filter->face_profile);
+      g_mutex_unlock (&filter->cascade_lock);
       break;
     case PROP_NOSE_PROFILE:
       g_free (filter->nose_profile);
+      g_mutex_lock (&filter->cascade_lock);
       if (filter->cvNoseDetect)
         delete (filter->cvNoseDetect);
       filter->nose_profile = g_value_dup_string (value);
       filter->cvNoseDetect =
           gst_face_detect_load_profile (filter, filter->nose_profile);
+      g_mutex_unlock (&filter->cascade_lock);
       break;
     case PROP_MOUTH_PROFILE:
       g_free (filter->mouth_profile);
+      g_mutex_lock (&filter->cascade_lock);
       if (filter->cvMouthDetect)
         delete (filter->cvMouthDetect);
       filter->mouth_profile = g_value_dup_string (value);
       filter->cvMouthDetect =
           gst_face_detect_load_profile (filter, filter->mouth_profile);
+      g_mutex_unlock (&filter->cascade_lock);
       break;
     case PROP_EYES_PROFILE:
       g_free (filter->eyes_profile);
+      g_mutex_lock (&filter->cascade_lock);
       if (filter->cvEyesDetect)
         delete (filter->cvEyesDetect);
       filter->eyes_profile = g_value_dup_string (value);
       filter->cvEyesDetect =
           gst_face_detect_load_profile (filter, filter->eyes_profile);
+      g_mutex_unlock (&filter->cascade_lock);
       break;
     case PROP_DISPLAY:
       filter->display = g_value_get_boolean (value);
@@ -452,6 +543,15 @@ gst_face_detect_set_property (GObject * object, guint prop_id,
     case PROP_UPDATES:
       filter->updates = g_value_get_enum (value);
       break;
+    case PROP_DETECTION_INTERVAL:
+      filter->detection_interval = g_value_get_uint (value);
+      break;
+    case PROP_DETECTION_SCALE:
+      filter->detection_scale = g_value_get_double (value);
+      break;
+    case PROP_ASYNC_DETECTION:
+      filter->async_detection = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -501,6 +601,15 @@ gst_face_detect_get_property (GObject * object, guint prop_id,
     case PROP_UPDATES:
       g_value_set_enum (value, filter->updates);
       break;
+    case PROP_DETECTION_INTERVAL:
+      g_value_set_uint (value, filter->detection_interval);
+      break;
+    case PROP_DETECTION_SCALE:
+      g_value_set_double (value, filter->detection_scale);
+      break;
+    case PROP_ASYNC_DETECTION:
+      g_value_set_boolean (value, filter->async_detection);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -509,21 +618,34 @@ gst_face_detect_get_property (GObject * object, guint prop_id,
 
 /* GstElement vmethod implementations */
 
-/* this function handles the link with other elements */
 static gboolean
-gst_face_detect_set_caps (GstOpencvVideoFilter * transform, gint in_width,
-    gint in_height, gint in_depth, gint in_channels,
-    gint out_width, gint out_height, gint out_depth, gint out_channels)
+gst_face_detect_stop (GstBaseTransform * trans)
 {
-  GstFaceDetect *filter;
+  GstFaceDetect *filter = GST_FACE_DETECT (trans);
 
-  filter = GST_FACE_DETECT (transform);
+  if (filter->thread) {
+    g_mutex_lock (&filter->lock);
+    filter->thread_stop = TRUE;
+    g_cond_signal (&filter->cond);
+    g_mutex_unlock (&filter->lock);
 
-  if (filter->cvGray)
-    cvReleaseImage (&filter->cvGray);
+    g_thread_join (filter->thread);
+    filter->thread = NULL;
+    filter->thread_stop = FALSE;
+  }
+
+  filter->job_pending = FALSE;
+  filter->job_busy = FALSE;
+  filter->result_ready = FALSE;
+  filter->result_faces->clear ();
+  filter->faces->clear ();
+  filter->frame_count = 0;
+  filter->have_detection = FALSE;
+  filter->face_detected = FALSE;
 
-  filter->cvGray = cvCreateImage (cvSize (in_width, in_height), IPL_DEPTH_8U,
-      1);
+  if (GST_BASE_TRANSFORM_CLASS (gst_face_detect_parent_class)->stop)
+    return GST_BASE_TRANSFORM_CLASS (gst_face_detect_parent_class)->stop
+        (trans);
 
   return TRUE;
 }
@@ -551,24 +673,233 @@ gst_face_detect_message_new (GstFaceDetect * filter, GstBuffer * buf)
 
 static void
 gst_face_detect_run_detector (GstFaceDetect * filter,
-    CascadeClassifier * detector, gint min_size_width,
+    CascadeClassifier * detector, Mat & gray, gint min_size_width,
     gint min_size_height, Rect r, vector < Rect > &faces)
 {
-  double img_stddev = 0;
+  Mat roi (gray, r);
+
+  detector->detectMultiScale (roi, faces, filter->scale_factor,
+      filter->min_neighbors, filter->flags, cvSize (min_size_width,
+          min_size_height), cvSize (0, 0));
+}
+
+static Rect
+gst_face_detect_scale_rect (const Rect & r, gdouble scale)
+{
+  return Rect (cvRound (r.x / scale), cvRound (r.y / scale),
+      cvRound (r.width / scale), cvRound (r.height / scale));
+}
+
+/* Detects the faces and their features on a gray image, which is the frame
+ * scaled by @scale, and returns them in frame coordinates. Called from the
+ * streaming thread or from the detection thread. */
+static void
+gst_face_detect_detect (GstFaceDetect * filter, Mat & gray, gdouble scale,
+    vector < GstFaceDetectFace > &result)
+{
+  vector < Rect > faces;
+  gint min_size_width = cvRound (filter->min_size_width * scale);
+  gint min_size_height = cvRound (filter->min_size_height * scale);
+
+  result.clear ();
+
   if (filter->min_stddev > 0) {
-    CvScalar mean, stddev;
-    cvAvgSdv (filter->cvGray, &mean, &stddev, NULL);
-    img_stddev = stddev.val[0];
+    Scalar mean, stddev;
+
+    meanStdDev (gray, mean, stddev);
+    if (stddev[0] < filter->min_stddev) {
+      GST_LOG_OBJECT (filter,
+          "Calculated stddev %f lesser than min_stddev %d, detection not performed",
+          stddev[0], filter->min_stddev);
+      return;
+    }
+  }
+
+  g_mutex_lock (&filter->cascade_lock);
+  if (!filter->cvFaceDetect) {
+    g_mutex_unlock (&filter->cascade_lock);
+    return;
+  }
+
+  gst_face_detect_run_detector (filter, filter->cvFaceDetect, gray,
+      min_size_width, min_size_height, Rect (0, 0, gray.cols, gray.rows),
+      faces);
+
+  for (unsigned int i = 0; i < faces.size (); ++i) {
+    Rect r = faces[i];
+    GstFaceDetectFace face;
+    vector < Rect > mouth;
+    vector < Rect > nose;
+    vector < Rect > eyes;
+    gint mw = min_size_width / 8;
+    gint mh = min_size_height / 8;
+    gint rhh = r.height / 2;
+    Rect rn (r.x + r.width / 4, r.y + r.height / 4, r.width / 2, rhh);
+    Rect rm (r.x, r.y + r.height / 2, r.width, rhh);
+    Rect re (r.x, r.y, r.width, rhh);
+
+    /* detect face features */
+
+    face.have_nose = face.have_mouth = face.have_eyes = FALSE;
+    face.dx = face.dy = 0;
+
+    if (filter->cvNoseDetect) {
+      gst_face_detect_run_detector (filter, filter->cvNoseDetect, gray, mw, mh,
+          rn, nose);
+      if (!nose.empty ()) {
+        face.have_nose = TRUE;
+        face.nose = gst_face_detect_scale_rect (nose[0] + rn.tl (), scale);
+      }
+    }
+
+    if (filter->cvMouthDetect) {
+      gst_face_detect_run_detector (filter, filter->cvMouthDetect, gray, mw,
+          mh, rm, mouth);
+      if (!mouth.empty ()) {
+        face.have_mouth = TRUE;
+        face.mouth = gst_face_detect_scale_rect (mouth[0] + rm.tl (), scale);
+      }
+    }
+
+    if (filter->cvEyesDetect) {
+      gst_face_detect_run_detector (filter, filter->cvEyesDetect, gray, mw, mh,
+          re, eyes);
+      if (!eyes.empty ()) {
+        face.have_eyes = TRUE;
+        face.eyes = gst_face_detect_scale_rect (eyes[0] + re.tl (), scale);
+      }
+    }
+
+    face.face = gst_face_detect_scale_rect (r, scale);
+    result.push_back (face);
   }
-  if (img_stddev >= filter->min_stddev) {
-    Mat roi (cv::cvarrToMat (filter->cvGray), r);
-    detector->detectMultiScale (roi, faces, filter->scale_factor,
-        filter->min_neighbors, filter->flags, cvSize (min_size_width,
-            min_size_height), cvSize (0, 0));
+  g_mutex_unlock (&filter->cascade_lock);
+}
+
+static gpointer
+gst_face_detect_thread (gpointer data)
+{
+  GstFaceDetect *filter = GST_FACE_DETECT (data);
+  vector < GstFaceDetectFace > faces;
+  Mat gray;
+
+  g_mutex_lock (&filter->lock);
+  while (!filter->thread_stop) {
+    guint64 frame;
+    gdouble scale;
+
+    if (!filter->job_pending) {
+      g_cond_wait (&filter->cond, &filter->lock);
+      continue;
+    }
+
+    /* take the image, and leave our previous one to be filled next */
+    std::swap (gray, *filter->job_gray);
+    frame = filter->job_frame;
+    scale = filter->job_scale;
+    filter->job_pending = FALSE;
+    filter->job_busy = TRUE;
+    g_mutex_unlock (&filter->lock);
+
+    gst_face_detect_detect (filter, gray, scale, faces);
+
+    g_mutex_lock (&filter->lock);
+    filter->result_faces->swap (faces);
+    filter->result_frame = frame;
+    filter->result_ready = TRUE;
+    filter->job_busy = FALSE;
+  }
+  g_mutex_unlock (&filter->lock);
+
+  return NULL;
+}
+
+/* Replaces the faces with a new detection run on @frame, estimating the
+ * motion of each face from the closest face of the previous detection */
+static void
+gst_face_detect_update_faces (GstFaceDetect * filter,
+    vector < GstFaceDetectFace > &faces, guint64 frame)
+{
+  vector < GstFaceDetectFace > &prev = *filter->faces;
+  gdouble elapsed = frame - filter->faces_frame;
+
+  for (unsigned int i = 0; i < faces.size (); ++i) {
+    Rect r = faces[i].face;
+    Point2d c (r.x + r.width / 2.0, r.y + r.height / 2.0);
+    gdouble best = r.width * r.width / 4.0;
+    gint match = -1;
+
+    if (elapsed <= 0 || elapsed > MAX_PREDICTION_FRAMES)
+      break;
+
+    for (unsigned int j = 0; j < prev.size (); ++j) {
+      Rect p = prev[j].face;
+      gdouble x = p.x + p.width / 2.0 + prev[j].dx * elapsed - c.x;
+      gdouble y = p.y + p.height / 2.0 + prev[j].dy * elapsed - c.y;
+
+      if (x * x + y * y < best) {
+        best = x * x + y * y;
+        match = j;
+      }
+    }
+
+    if (match >= 0) {
+      Rect p = prev[match].face;
+
+      faces[i].dx = (c.x - p.x - p.width / 2.0) / elapsed;
+      faces[i].dy = (c.y - p.y - p.height / 2.0) / elapsed;
+    }
+  }
+
+  filter->faces->swap (faces);
+  filter->faces_frame = frame;
+  filter->have_detection = TRUE;
+}
+
+static Rect
+gst_face_detect_predict_rect (const Rect & r, const Point & offset,
+    const Rect & bounds)
+{
+  return (r + offset) & bounds;
+}
+
+/* Moves the faces of the latest detection to where they are expected to be
+ * on @frame, dropping the ones which left the image */
+static void
+gst_face_detect_predict_faces (GstFaceDetect * filter, guint64 frame,
+    const Rect & bounds, vector < GstFaceDetectFace > &faces)
+{
+  guint64 elapsed = MIN (frame - filter->faces_frame, MAX_PREDICTION_FRAMES);
+
+  faces.clear ();
+  for (unsigned int i = 0; i < filter->faces->size (); ++i) {
+    GstFaceDetectFace face = (*filter->faces)[i];
+    Point offset (cvRound (face.dx * elapsed), cvRound (face.dy * elapsed));
+
+    face.face = gst_face_detect_predict_rect (face.face, offset, bounds);
+    if (face.face.area () == 0)
+      continue;
+    face.nose = gst_face_detect_predict_rect (face.nose, offset, bounds);
+    face.have_nose = face.have_nose && face.nose.area () > 0;
+    face.mouth = gst_face_detect_predict_rect (face.mouth, offset, bounds);
+    face.have_mouth = face.have_mouth && face.mouth.area () > 0;
+    face.eyes = gst_face_detect_predict_rect (face.eyes, offset, bounds);
+    face.have_eyes = face.have_eyes && face.eyes.area () > 0;
+    faces.push_back (face);
+  }
+}
+
+/* Converts the frame to the gray, possibly downscaled, image the detection
+ * runs on */
+static void
+gst_face_detect_prepare_gray (GstFaceDetect * filter, Mat & img,
+    gdouble scale)
+{
+  if (scale < 1.0) {
+    resize (img, *filter->cvScaled, Size (), scale, scale, INTER_AREA);
+    cvtColor (*filter->cvScaled, *filter->cvGray, CV_RGB2GRAY);
   } else {
-    GST_LOG_OBJECT (filter,
-        "Calculated stddev %f lesser than min_stddev %d, detection not performed",
-        img_stddev, filter->min_stddev);
+    cvtColor (img, *filter->cvGray, CV_RGB2GRAY);
   }
 }
 
@@ -577,7 +908,7 @@ gst_face_detect_run_detector (GstFaceDetect * filter,
  */
 static GstFlowReturn
 gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
-    IplImage * img)
+    Mat & img)
 {
   GstFaceDetect *filter = GST_FACE_DETECT (base);
 
@@ -586,20 +917,47 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     GstStructure *s;
     GValue facelist = { 0 };
     GValue facedata = { 0 };
-    vector < Rect > faces;
-    vector < Rect > mouth;
-    vector < Rect > nose;
-    vector < Rect > eyes;
+    vector < GstFaceDetectFace > faces;
     gboolean post_msg = FALSE;
+    gboolean detect;
+    guint64 frame = filter->frame_count++;
+    gdouble scale = filter->detection_scale;
+
+    detect = !filter->have_detection
+        || frame - filter->last_detection >= filter->detection_interval;
+
+    if (filter->async_detection) {
+      if (!filter->thread)
+        filter->thread = g_thread_new ("facedetect", gst_face_detect_thread,
+            filter);
+
+      /* only the image conversion is done here, the detection itself never
+       * delays the frame */
+      g_mutex_lock (&filter->lock);
+      if (filter->result_ready) {
+        filter->result_ready = FALSE;
+        gst_face_detect_update_faces (filter, *filter->result_faces,
+            filter->result_frame);
+      }
+      if (detect && !filter->job_pending && !filter->job_busy) {
+        gst_face_detect_prepare_gray (filter, img, scale);
+        std::swap (*filter->cvGray, *filter->job_gray);
+        filter->job_frame = frame;
+        filter->job_scale = scale;
+        filter->job_pending = TRUE;
+        filter->last_detection = frame;
+        g_cond_signal (&filter->cond);
+      }
+      g_mutex_unlock (&filter->lock);
+    } else if (detect) {
+      gst_face_detect_prepare_gray (filter, img, scale);
+      gst_face_detect_detect (filter, *filter->cvGray, scale, faces);
+      gst_face_detect_update_faces (filter, faces, frame);
+      filter->last_detection = frame;
+    }
 
-    Mat mtxOrg (cv::cvarrToMat (img));
-
-    cvCvtColor (img, filter->cvGray, CV_RGB2GRAY);
-
-    gst_face_detect_run_detector (filter, filter->cvFaceDetect,
-        filter->min_size_width, filter->min_size_height,
-        Rect (filter->cvGray->origin, filter->cvGray->origin,
-            filter->cvGray->width, filter->cvGray->height), faces);
+    gst_face_detect_predict_faces (filter, frame, Rect (0, 0, img.cols,
+            img.rows), faces);
 
     switch (filter->updates) {
       case GST_FACEDETECT_UPDATES_EVERY_FRAME:
@@ -638,70 +996,26 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     }
 
     for (unsigned int i = 0; i < faces.size (); ++i) {
-      Rect r = faces[i];
-      guint mw = filter->min_size_width / 8;
-      guint mh = filter->min_size_height / 8;
-      guint rnx = 0, rny = 0, rnw, rnh;
-      guint rmx = 0, rmy = 0, rmw, rmh;
-      guint rex = 0, rey = 0, rew, reh;
-      guint rhh = r.height / 2;
-      gboolean have_nose, have_mouth, have_eyes;
-
-      /* detect face features */
-
-      if (filter->cvNoseDetect) {
-        rnx = r.x + r.width / 4;
-        rny = r.y + r.height / 4;
-        rnw = r.width / 2;
-        rnh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvNoseDetect, mw, mh,
-            Rect (rnx, rny, rnw, rnh), nose);
-        have_nose = !nose.empty ();
-      } else {
-        have_nose = FALSE;
-      }
-
-      if (filter->cvMouthDetect) {
-        rmx = r.x;
-        rmy = r.y + r.height / 2;
-        rmw = r.width;
-        rmh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvMouthDetect, mw,
-            mh, Rect (rmx, rmy, rmw, rmh), mouth);
-        have_mouth = !mouth.empty ();
-      } else {
-        have_mouth = FALSE;
-      }
-
-      if (filter->cvEyesDetect) {
-        rex = r.x;
-        rey = r.y;
-        rew = r.width;
-        reh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvEyesDetect, mw, mh,
-            Rect (rex, rey, rew, reh), eyes);
-        have_eyes = !eyes.empty ();
-      } else {
-        have_eyes = FALSE;
-      }
+      const GstFaceDetectFace & face = faces[i];
+      Rect r = face.face;
 
       GST_LOG_OBJECT (filter,
           "%2d/%2" G_GSIZE_FORMAT
           ": x,y = %4u,%4u: w.h = %4u,%4u : features(e,n,m) = %d,%d,%d", i,
-          faces.size (), r.x, r.y, r.width, r.height, have_eyes, have_nose,
-          have_mouth);
+          faces.size (), r.x, r.y, r.width, r.height, face.have_eyes,
+          face.have_nose, face.have_mouth);
       if (post_msg) {
         s = gst_structure_new ("face",
             "x", G_TYPE_UINT, r.x,
             "y", G_TYPE_UINT, r.y,
             "width", G_TYPE_UINT, r.width,
             "height", G_TYPE_UINT, r.height, NULL);
-        if (have_nose)
-          structure_and_message (nose, "nose", rnx, rny, filter, s);
-        if (have_mouth)
-          structure_and_message (mouth, "mouth", rmx, rmy, filter, s);
-        if (have_eyes)
-          structure_and_message (eyes, "eyes", rex, rey, filter, s);
+        if (face.have_nose)
+          structure_and_message (face.nose, "nose", filter, s);
+        if (face.have_mouth)
+          structure_and_message (face.mouth, "mouth", filter, s);
+        if (face.have_eyes)
+          structure_and_message (face.eyes, "eyes", filter, s);
 
         g_value_init (&facedata, GST_TYPE_STRUCTURE);
         g_value_take_boxed (&facedata, s);
@@ -724,43 +1038,40 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
         center.y = cvRound ((r.y + h));
         axes.width = w;
         axes.height = h * 1.25; /* tweak for face form */
-        ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 3, 8, 0);
+        ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 3, 8, 0);
 
-        if (have_nose) {
-          Rect sr = nose[0];
+        if (face.have_nose) {
+          Rect sr = face.nose;
 
           w = sr.width / 2;
           h = sr.height / 2;
-          center.x = cvRound ((rnx + sr.x + w));
-          center.y = cvRound ((rny + sr.y + h));
+          center.x = cvRound ((sr.x + w));
+          center.y = cvRound ((sr.y + h));
           axes.width = w;
           axes.height = h * 1.25;       /* tweak for nose form */
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
-              0);
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
         }
-        if (have_mouth) {
-          Rect sr = mouth[0];
+        if (face.have_mouth) {
+          Rect sr = face.mouth;
 
           w = sr.width / 2;
           h = sr.height / 2;
-          center.x = cvRound ((rmx + sr.x + w));
-          center.y = cvRound ((rmy + sr.y + h));
+          center.x = cvRound ((sr.x + w));
+          center.y = cvRound ((sr.y + h));
           axes.width = w * 1.5; /* tweak for mouth form */
           axes.height = h;
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
-              0);
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
         }
-        if (have_eyes) {
-          Rect sr = eyes[0];
+        if (face.have_eyes) {
+          Rect sr = face.eyes;
 
           w = sr.width / 2;
           h = sr.height / 2;
-          center.x = cvRound ((rex + sr.x + w));
-          center.y = cvRound ((rey + sr.y + h));
+          center.x = cvRound ((sr.x + w));
+          center.y = cvRound ((sr.y + h));
           axes.width = w * 1.5; /* tweak for eyes form */
           axes.height = h;
-          ellipse (mtxOrg, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8,
-              0);
+          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
         }
       }
       gst_buffer_add_video_region_of_interest_meta (buf, "face",
@@ -773,7 +1084,6 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
       g_value_unset (&facelist);
       gst_element_post_message (GST_ELEMENT (filter), msg);
     }
-    mtxOrg.release ();
   }
 
   return GST_FLOW_OK;
@@ -49,6 +49,7 @@
 #define __GST_FACE_DETECT_H__
 
 #include <gst/gst.h>
+#include <vector>
 #include <opencv2/core/version.hpp>
 #include <cv.h>
 #include <gst/opencv/gstopencvvideofilter.h>
@@ -85,6 +86,22 @@ enum _GstFaceDetectUpdates {
   GST_FACEDETECT_UPDATES_NONE             = 3
 };
 
+/* a detected face and its features, in frame coordinates */
+typedef struct _GstFaceDetectFace
+{
+  cv::Rect face;
+  cv::Rect nose;
+  cv::Rect mouth;
+  cv::Rect eyes;
+  gboolean have_nose;
+  gboolean have_mouth;
+  gboolean have_eyes;
+
+  /* motion in pixels per frame since the previous detection */
+  gdouble dx;
+  gdouble dy;
+} GstFaceDetectFace;
+
 struct _GstFaceDetect
 {
   GstOpencvVideoFilter element;
@@ -103,12 +120,39 @@ struct _GstFaceDetect
   gint min_size_height;
   gint min_stddev;
   gint updates;
+  guint detection_interval;
+  gdouble detection_scale;
+  gboolean async_detection;
 
-  IplImage *cvGray;
+  cv::Mat *cvScaled;
+  cv::Mat *cvGray;
+  /* protects the classifiers, which the detection thread uses */
+  GMutex cascade_lock;
   cv::CascadeClassifier *cvFaceDetect;
   cv::CascadeClassifier *cvNoseDetect;
   cv::CascadeClassifier *cvMouthDetect;
   cv::CascadeClassifier *cvEyesDetect;
+
+  /* latest detection, and the frame it was run on */
+  std::vector < GstFaceDetectFace > *faces;
+  guint64 faces_frame;
+  guint64 frame_count;
+  guint64 last_detection;
+  gboolean have_detection;
+
+  /* detection thread, everything below is protected by lock */
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  gboolean thread_stop;
+  gboolean job_pending;
+  gboolean job_busy;
+  cv::Mat *job_gray;
+  gdouble job_scale;
+  guint64 job_frame;
+  gboolean result_ready;
+  std::vector < GstFaceDetectFace > *result_faces;
+  guint64 result_frame;
 };
 
 struct _GstFaceDetectClass
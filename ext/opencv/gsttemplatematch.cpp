@@ -54,6 +54,15 @@
  * |[
  * gst-launch-1.0 videotestsrc ! decodebin ! videoconvert ! templatematch template=/path/to/file.jpg ! videoconvert ! xvimagesink
  * ]|
+ * The best match is also attached to the buffers as a
+ * #GstVideoRegionOfInterestMeta of type "template-match", with a
+ * "template-match" parameter structure holding the "result".
+ *
+ * With #GstTemplateMatch:max-latency set, the matching runs in threads
+ * shared by all the instances of the analysis elements instead of the
+ * streaming thread. Frames are skipped by the matching while these threads
+ * are all busy, and the results are applied to the following frames for as
+ * long as they are not older than the latency.
  * </refsect2>
  */
 
@@ -63,12 +72,16 @@
 
 #include "../../gst-libs/gst/gst-i18n-plugin.h"
 #include "gsttemplatematch.h"
+#include "gstcvanalysispool.h"
+#include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/imgproc/imgproc_c.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_template_match_debug);
 #define GST_CAT_DEFAULT gst_template_match_debug
 
 #define DEFAULT_METHOD (3)
+#define DEFAULT_MAX_LATENCY 0
+#define DEFAULT_POST_MESSAGES TRUE
 
 /* Filter signals and args */
 enum
@@ -83,8 +96,20 @@ enum
   PROP_METHOD,
   PROP_TEMPLATE,
   PROP_DISPLAY,
+  PROP_MAX_LATENCY,
+  PROP_POST_MESSAGES
 };
 
+/* a frame to match in the analysis threads */
+typedef struct
+{
+  GstTemplateMatch *filter;
+  cv::Mat frame;
+  cv::Mat templ;
+  int method;
+  GstClockTime time;
+} GstTemplateMatchJob;
+
 /* the capabilities of the inputs and outputs.
  */
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -140,6 +165,33 @@ gst_template_match_class_init (GstTemplateMatchClass * klass)
       g_param_spec_boolean ("display", "Display",
           "Sets whether the detected template should be highlighted in the output",
           TRUE, (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  /**
+   * GstTemplateMatch:max-latency:
+   *
+   * Run the matching in the analysis threads shared by all the analysis
+   * elements, and use the results for as long as they are not older than
+   * this. 0 matches every frame in the streaming thread.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_LATENCY,
+      g_param_spec_uint64 ("max-latency", "Maximum latency",
+          "Match in the shared analysis threads, using results up to this old "
+          "(in nanoseconds, 0 = match every frame in the streaming thread)",
+          0, G_MAXUINT64, DEFAULT_MAX_LATENCY,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  /**
+   * GstTemplateMatch:post-messages:
+   *
+   * Post an element message for every match. The matches are also always
+   * attached to the buffers as #GstVideoRegionOfInterestMeta.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_POST_MESSAGES,
+      g_param_spec_boolean ("post-messages", "Post messages",
+          "Post a bus message for every match", DEFAULT_POST_MESSAGES,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
   gst_element_class_set_static_metadata (element_class,
       "templatematch",
@@ -164,6 +216,10 @@ gst_template_match_init (GstTemplateMatch * filter)
   filter->cvTemplateImage = NULL;
   filter->cvDistImage = NULL;
   filter->method = DEFAULT_METHOD;
+  filter->max_latency = DEFAULT_MAX_LATENCY;
+  filter->post_messages = DEFAULT_POST_MESSAGES;
+  filter->job_running = FALSE;
+  filter->have_result = FALSE;
 
   gst_opencv_video_filter_set_in_place (GST_OPENCV_VIDEO_FILTER_CAST (filter),
       TRUE);
@@ -244,6 +300,16 @@ gst_template_match_set_property (GObject * object, guint prop_id,
       filter->display = g_value_get_boolean (value);
       GST_OBJECT_UNLOCK (filter);
       break;
+    case PROP_MAX_LATENCY:
+      GST_OBJECT_LOCK (filter);
+      filter->max_latency = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_POST_MESSAGES:
+      GST_OBJECT_LOCK (filter);
+      filter->post_messages = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -266,6 +332,12 @@ gst_template_match_get_property (GObject * object, guint prop_id,
     case PROP_DISPLAY:
       g_value_set_boolean (value, filter->display);
       break;
+    case PROP_MAX_LATENCY:
+      g_value_set_uint64 (value, filter->max_latency);
+      break;
+    case PROP_POST_MESSAGES:
+      g_value_set_boolean (value, filter->post_messages);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -293,13 +365,13 @@ gst_template_match_finalize (GObject * object)
 }
 
 static void
-gst_template_match_match (IplImage * input, IplImage * templ,
-    IplImage * dist_image, double *best_res, CvPoint * best_pos, int method)
+gst_template_match_match (const cv::Mat & input, const cv::Mat & templ,
+    cv::Mat & dist_image, double *best_res, CvPoint * best_pos, int method)
 {
   double dist_min = 0, dist_max = 0;
-  CvPoint min_pos, max_pos;
-  cvMatchTemplate (input, templ, dist_image, method);
-  cvMinMaxLoc (dist_image, &dist_min, &dist_max, &min_pos, &max_pos, NULL);
+  cv::Point min_pos, max_pos;
+  cv::matchTemplate (input, templ, dist_image, method);
+  cv::minMaxLoc (dist_image, &dist_min, &dist_max, &min_pos, &max_pos);
   if ((CV_TM_SQDIFF_NORMED == method) || (CV_TM_SQDIFF == method)) {
     *best_res = dist_min;
     *best_pos = min_pos;
@@ -312,6 +384,86 @@ gst_template_match_match (IplImage * input, IplImage * templ,
   }
 }
 
+static void
+gst_template_match_job_run (gpointer data, gpointer user_data)
+{
+  GstTemplateMatchJob *job = (GstTemplateMatchJob *) data;
+  GstTemplateMatch *filter = job->filter;
+  cv::Mat dist;
+  CvPoint best_pos;
+  double best_res;
+
+  gst_template_match_match (job->frame, job->templ, dist, &best_res,
+      &best_pos, job->method);
+
+  GST_OBJECT_LOCK (filter);
+  filter->result_pos = best_pos;
+  filter->result_res = best_res;
+  filter->result_width = job->templ.cols;
+  filter->result_height = job->templ.rows;
+  filter->result_time = job->time;
+  filter->have_result = TRUE;
+  filter->job_running = FALSE;
+  GST_OBJECT_UNLOCK (filter);
+
+  gst_object_unref (filter);
+  delete job;
+}
+
+/* Hands a copy of the frame over to the analysis threads, unless they are all
+ * busy or still matching the previous frame, and gets the latest match if it
+ * is recent enough. Called with the object lock. */
+static gboolean
+gst_template_match_match_async (GstTemplateMatch * filter, GstBuffer * buf,
+    IplImage * img, double *best_res, CvPoint * best_pos, gint * width,
+    gint * height)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (filter);
+  GstClockTime time;
+
+  time = gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buf));
+
+  if (!filter->job_running && filter->cvTemplateImage
+      && filter->cvTemplateImage->width <= img->width
+      && filter->cvTemplateImage->height <= img->height) {
+    if (gst_cv_analysis_pool_reserve ()) {
+      GstTemplateMatchJob *job = new GstTemplateMatchJob;
+
+      job->filter = GST_TEMPLATE_MATCH (gst_object_ref (filter));
+      job->frame = cv::cvarrToMat (img, true);
+      job->templ = cv::cvarrToMat (filter->cvTemplateImage, true);
+      job->method = filter->method;
+      job->time = time;
+      filter->job_running = TRUE;
+      gst_cv_analysis_pool_push (gst_template_match_job_run, job);
+    } else {
+      GST_LOG_OBJECT (filter, "analysis threads busy, skipping frame");
+    }
+  }
+
+  if (!filter->have_result)
+    return FALSE;
+
+  if (GST_CLOCK_TIME_IS_VALID (time)
+      && GST_CLOCK_TIME_IS_VALID (filter->result_time)) {
+    GstClockTimeDiff age = GST_CLOCK_DIFF (filter->result_time, time);
+
+    if (ABS (age) > (GstClockTimeDiff) filter->max_latency) {
+      GST_LOG_OBJECT (filter, "latest match too old: %" GST_STIME_FORMAT,
+          GST_STIME_ARGS (age));
+      return FALSE;
+    }
+  }
+
+  *best_res = filter->result_res;
+  *best_pos = filter->result_pos;
+  *width = filter->result_width;
+  *height = filter->result_height;
+
+  return TRUE;
+}
+
 /* chain function
  * this function does the actual processing
  */
@@ -322,6 +474,8 @@ gst_template_match_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
   GstTemplateMatch *filter;
   CvPoint best_pos;
   double best_res;
+  gint width = 0, height = 0;
+  gboolean have_match = FALSE;
   GstMessage *m = NULL;
 
   filter = GST_TEMPLATE_MATCH (base);
@@ -329,40 +483,64 @@ gst_template_match_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
   GST_LOG_OBJECT (filter, "Buffer size %u", (guint) gst_buffer_get_size (buf));
 
   GST_OBJECT_LOCK (filter);
-  if (filter->cvTemplateImage && !filter->cvDistImage) {
-    if (filter->cvTemplateImage->width > img->width) {
-      GST_WARNING ("Template Image is wider than input image");
-    } else if (filter->cvTemplateImage->height > img->height) {
-      GST_WARNING ("Template Image is taller than input image");
-    } else {
+  if (filter->max_latency > 0) {
+    have_match = gst_template_match_match_async (filter, buf, img, &best_res,
+        &best_pos, &width, &height);
+  } else {
+    if (filter->cvTemplateImage && !filter->cvDistImage) {
+      if (filter->cvTemplateImage->width > img->width) {
+        GST_WARNING ("Template Image is wider than input image");
+      } else if (filter->cvTemplateImage->height > img->height) {
+        GST_WARNING ("Template Image is taller than input image");
+      } else {
 
-      GST_DEBUG_OBJECT (filter, "cvCreateImage (Size(%d-%d+1,%d) %d, %d)",
-          img->width, filter->cvTemplateImage->width,
-          img->height - filter->cvTemplateImage->height + 1, IPL_DEPTH_32F, 1);
-      filter->cvDistImage =
-          cvCreateImage (cvSize (img->width -
-              filter->cvTemplateImage->width + 1,
-              img->height - filter->cvTemplateImage->height + 1),
-          IPL_DEPTH_32F, 1);
-      if (!filter->cvDistImage) {
-        GST_WARNING ("Couldn't create dist image.");
+        GST_DEBUG_OBJECT (filter, "cvCreateImage (Size(%d-%d+1,%d) %d, %d)",
+            img->width, filter->cvTemplateImage->width,
+            img->height - filter->cvTemplateImage->height + 1, IPL_DEPTH_32F,
+            1);
+        filter->cvDistImage =
+            cvCreateImage (cvSize (img->width -
+                filter->cvTemplateImage->width + 1,
+                img->height - filter->cvTemplateImage->height + 1),
+            IPL_DEPTH_32F, 1);
+        if (!filter->cvDistImage) {
+          GST_WARNING ("Couldn't create dist image.");
+        }
       }
     }
+    if (filter->cvTemplateImage && filter->cvDistImage) {
+      cv::Mat dist = cv::cvarrToMat (filter->cvDistImage);
+
+      gst_template_match_match (cv::cvarrToMat (img),
+          cv::cvarrToMat (filter->cvTemplateImage), dist, &best_res,
+          &best_pos, filter->method);
+      width = filter->cvTemplateImage->width;
+      height = filter->cvTemplateImage->height;
+      have_match = TRUE;
+    }
   }
-  if (filter->cvTemplateImage && filter->cvDistImage) {
-    GstStructure *s;
 
-    gst_template_match_match (img, filter->cvTemplateImage,
-        filter->cvDistImage, &best_res, &best_pos, filter->method);
+  if (have_match) {
+    GstVideoRegionOfInterestMeta *meta;
+
+    if (filter->post_messages) {
+      GstStructure *s;
 
-    s = gst_structure_new ("template_match",
-        "x", G_TYPE_UINT, best_pos.x,
-        "y", G_TYPE_UINT, best_pos.y,
-        "width", G_TYPE_UINT, filter->cvTemplateImage->width,
-        "height", G_TYPE_UINT, filter->cvTemplateImage->height,
-        "result", G_TYPE_DOUBLE, best_res, NULL);
+      s = gst_structure_new ("template_match",
+          "x", G_TYPE_UINT, best_pos.x,
+          "y", G_TYPE_UINT, best_pos.y,
+          "width", G_TYPE_UINT, width,
+          "height", G_TYPE_UINT, height, "result", G_TYPE_DOUBLE, best_res,
+          NULL);
 
-    m = gst_message_new_element (GST_OBJECT (filter), s);
+      m = gst_message_new_element (GST_OBJECT (filter), s);
+    }
+
+    meta = gst_buffer_add_video_region_of_interest_meta (buf, "template-match",
+        best_pos.x, best_pos.y, width, height);
+    gst_video_region_of_interest_meta_add_param (meta,
+        gst_structure_new ("template-match", "result", G_TYPE_DOUBLE,
+            best_res, NULL));
 
     if (filter->display) {
       CvPoint corner = best_pos;
@@ -378,10 +556,8 @@ gst_template_match_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
         color = CV_RGB (255, 32, 32);
       }
 
-      buf = gst_buffer_make_writable (buf);
-
-      corner.x += filter->cvTemplateImage->width;
-      corner.y += filter->cvTemplateImage->height;
+      corner.x += width;
+      corner.y += height;
       cvRectangle (img, best_pos, corner, color, 3, 8, 0);
     }
 
@@ -78,8 +78,19 @@ struct _GstTemplateMatch
   gboolean display;
 
   gchar *templ;
+  GstClockTime max_latency;
+  gboolean post_messages;
 
   IplImage *cvGray, *cvTemplateImage, *cvDistImage;
+
+  /* matching in the analysis threads, protected by the object lock */
+  gboolean job_running;
+  gboolean have_result;
+  CvPoint result_pos;
+  gdouble result_res;
+  gint result_width;
+  gint result_height;
+  GstClockTime result_time;
 };
 
 struct _GstTemplateMatchClass
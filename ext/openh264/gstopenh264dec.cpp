@@ -310,10 +310,17 @@ gst_openh264dec_handle_frame (GstVideoDecoder * decoder,
         i <
         1 ? dst_buf_info.UsrData.sSystemBuffer.
         iStride[0] : dst_buf_info.UsrData.sSystemBuffer.iStride[1];
-    for (row = 0; row < component_height; row++) {
-      memcpy (p, yuvdata[i], component_width);
-      p += row_stride;
-      yuvdata[i] += src_width;
+    /* openh264 decodes into its own picture buffers, so the planes are
+     * copied, in one go if the layouts match */
+    if (row_stride == src_width) {
+      memcpy (p, yuvdata[i], row_stride * (component_height - 1) +
+          component_width);
+    } else {
+      for (row = 0; row < component_height; row++) {
+        memcpy (p, yuvdata[i], component_width);
+        p += row_stride;
+        yuvdata[i] += src_width;
+      }
     }
   }
   gst_video_codec_state_unref (state);
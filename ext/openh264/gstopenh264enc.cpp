@@ -108,6 +108,8 @@ gst_openh264enc_slice_mode_get_type (void)
 {
   static const GEnumValue types[] = {
     {GST_OPENH264_SLICE_MODE_N_SLICES, "Fixed number of slices", "n-slices"},
+    {GST_OPENH264_SLICE_MODE_SIZE_LIMITED,
+        "Slices limited to max-slice-size bytes", "size-limited"},
     {GST_OPENH264_SLICE_MODE_AUTO,
         "Number of slices equal to number of threads", "auto"},
     {0, NULL, NULL},
@@ -276,9 +278,11 @@ gst_openh264enc_class_init (GstOpenh264EncClass * klass)
           GST_TYPE_RC_MODES, RC_QUALITY_MODE,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  /* with many encoders running at once, multi-thread=1 avoids creating
+   * threads that only compete with the other encoders */
   g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_MULTI_THREAD,
       g_param_spec_uint ("multi-thread", "Number of threads",
-          "The number of threads.",
+          "The number of threads (0 = number of processors).",
           0, G_MAXUINT, DEFAULT_MULTI_THREAD,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
@@ -324,7 +328,8 @@ gst_openh264enc_class_init (GstOpenh264EncClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_MAX_SLICE_SIZE,
       g_param_spec_uint ("max-slice-size", "Max slice size",
-          "The maximum size of one slice (in bytes).",
+          "The maximum size of one slice (in bytes, "
+          "needs slice-mode=size-limited).",
           0, G_MAXUINT, DEFAULT_MAX_SLICE_SIZE,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
@@ -396,6 +401,7 @@ gst_openh264enc_init (GstOpenh264Enc * openh264enc)
   openh264enc->complexity = DEFAULT_COMPLEXITY;
   openh264enc->bitrate_changed = FALSE;
   openh264enc->max_bitrate_changed = FALSE;
+  openh264enc->output_pool = NULL;
   gst_openh264enc_set_usage_type (openh264enc, CAMERA_VIDEO_REAL_TIME);
   gst_openh264enc_set_rate_control (openh264enc, RC_QUALITY_MODE);
 }
@@ -667,12 +673,52 @@ gst_openh264enc_stop (GstVideoEncoder * encoder)
   }
   openh264enc->input_state = NULL;
 
+  if (openh264enc->output_pool) {
+    gst_buffer_pool_set_active (openh264enc->output_pool, FALSE);
+    gst_object_unref (openh264enc->output_pool);
+    openh264enc->output_pool = NULL;
+  }
+
   GST_DEBUG_OBJECT (openh264enc, "openh264_enc_stop called");
 
   return TRUE;
 }
 
 
+/* The encoded frames are copied out of the encoder into buffers of a pool
+ * instead of newly allocated ones, which matters with many encoders running
+ * at once. The buffers are as large as a raw frame, bigger frames fall back
+ * to a normal allocation. */
+static void
+gst_openh264enc_create_output_pool (GstOpenh264Enc * openh264enc,
+    GstVideoInfo * info)
+{
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  GstStructure *config;
+  GstBufferPool *pool;
+
+  gst_video_encoder_get_allocator (GST_VIDEO_ENCODER (openh264enc),
+      &allocator, &params);
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL,
+      GST_VIDEO_INFO_SIZE (info), 0, 0);
+  gst_buffer_pool_config_set_allocator (config, allocator, &params);
+  if (allocator)
+    gst_object_unref (allocator);
+
+  if (!gst_buffer_pool_set_config (pool, config) ||
+      !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (openh264enc, "Failed to set up the output pool");
+    gst_object_unref (pool);
+    return;
+  }
+
+  openh264enc->output_pool = pool;
+}
+
 static gboolean
 gst_openh264enc_set_format (GstVideoEncoder * encoder,
     GstVideoCodecState * state)
@@ -760,6 +806,14 @@ gst_openh264enc_set_format (GstVideoEncoder * encoder,
     else
       slice_mode = SM_FIXEDSLCNUM_SLICE;
     n_slices = openh264enc->num_slices;
+  } else if (openh264enc->slice_mode == GST_OPENH264_SLICE_MODE_SIZE_LIMITED) {
+#if OPENH264_MAJOR == 1 && OPENH264_MINOR < 6
+    slice_mode = SM_DYN_SLICE;
+#else
+    slice_mode = SM_SIZELIMITED_SLICE;
+#endif
+    n_slices = 0;
+    enc_params.uiMaxNalSize = openh264enc->max_slice_size;
   } else if (openh264enc->slice_mode == GST_OPENH264_SLICE_MODE_AUTO) {
 #if OPENH264_MAJOR == 1 && OPENH264_MINOR < 6
     slice_mode = SM_AUTO_SLICE;
@@ -776,9 +830,13 @@ gst_openh264enc_set_format (GstVideoEncoder * encoder,
 #if OPENH264_MAJOR == 1 && OPENH264_MINOR < 6
   enc_params.sSpatialLayers[0].sSliceCfg.uiSliceMode = slice_mode;
   enc_params.sSpatialLayers[0].sSliceCfg.sSliceArgument.uiSliceNum = n_slices;
+  enc_params.sSpatialLayers[0].sSliceCfg.sSliceArgument.uiSliceSizeConstraint =
+      openh264enc->max_slice_size;
 #else
   enc_params.sSpatialLayers[0].sSliceArgument.uiSliceMode = slice_mode;
   enc_params.sSpatialLayers[0].sSliceArgument.uiSliceNum = n_slices;
+  enc_params.sSpatialLayers[0].sSliceArgument.uiSliceSizeConstraint =
+      openh264enc->max_slice_size;
 #endif
 
   openh264enc->framerate = (1 + fps_n / fps_d);
@@ -804,7 +862,12 @@ gst_openh264enc_set_format (GstVideoEncoder * encoder,
   output_state = gst_video_encoder_set_output_state (encoder, outcaps, state);
   gst_video_codec_state_unref (output_state);
 
-  return gst_video_encoder_negotiate (encoder);
+  if (!gst_video_encoder_negotiate (encoder))
+    return FALSE;
+
+  gst_openh264enc_create_output_pool (openh264enc, &state->info);
+
+  return TRUE;
 }
 
 static gboolean
@@ -822,6 +885,7 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     GstVideoCodecFrame * frame)
 {
   GstOpenh264Enc *openh264enc = GST_OPENH264ENC (encoder);
+  SSourcePicture src_picture;
   SSourcePicture *src_pic = NULL;
   GstVideoFrame video_frame;
   gboolean force_keyframe;
@@ -864,13 +928,8 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
   GST_OBJECT_UNLOCK (openh264enc);
 
   if (frame) {
-    src_pic = new SSourcePicture;
-
-    if (src_pic == NULL) {
-      if (frame)
-        gst_video_codec_frame_unref (frame);
-      return GST_FLOW_ERROR;
-    }
+    src_pic = &src_picture;
+    memset (src_pic, 0, sizeof (SSourcePicture));
     //fill default src_pic
     src_pic->iColorFormat = videoFormatI420;
     src_pic->uiTimeStamp = frame->pts / GST_MSECOND;
@@ -919,7 +978,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     if (frame) {
       gst_video_frame_unmap (&video_frame);
       gst_video_codec_frame_unref (frame);
-      delete src_pic;
       GST_ELEMENT_ERROR (openh264enc, STREAM, ENCODE,
           ("Could not encode frame"), ("Openh264 returned %d", ret));
       return GST_FLOW_ERROR;
@@ -932,7 +990,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     if (frame) {
       gst_video_frame_unmap (&video_frame);
       gst_video_encoder_finish_frame (encoder, frame);
-      delete src_pic;
     }
 
     return GST_FLOW_OK;
@@ -941,7 +998,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
   if (frame) {
     gst_video_frame_unmap (&video_frame);
     gst_video_codec_frame_unref (frame);
-    delete src_pic;
     src_pic = NULL;
     frame = NULL;
   }
@@ -969,8 +1025,16 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     }
   }
 
-  frame->output_buffer =
-      gst_video_encoder_allocate_output_buffer (encoder, buf_length);
+  frame->output_buffer = NULL;
+  if (openh264enc->output_pool
+      && buf_length <= GST_VIDEO_INFO_SIZE (&openh264enc->input_state->info)
+      && gst_buffer_pool_acquire_buffer (openh264enc->output_pool,
+          &frame->output_buffer, NULL) == GST_FLOW_OK) {
+    gst_buffer_resize (frame->output_buffer, 0, buf_length);
+  } else {
+    frame->output_buffer =
+        gst_video_encoder_allocate_output_buffer (encoder, buf_length);
+  }
   gst_buffer_map (frame->output_buffer, &map, GST_MAP_WRITE);
 
   buf_length = 0;
@@ -50,6 +50,7 @@ typedef enum _GstOpenh264encDeblockingMode
 typedef enum
 {
   GST_OPENH264_SLICE_MODE_N_SLICES = 1,  /* SM_FIXEDSLCNUM_SLICE */
+  GST_OPENH264_SLICE_MODE_SIZE_LIMITED = 4, /* SM_SIZELIMITED_SLICE */
   GST_OPENH264_SLICE_MODE_AUTO = 5       /* former SM_AUTO_SLICE */
 } GstOpenh264EncSliceMode;
 
@@ -93,6 +94,8 @@ struct _GstOpenh264Enc
   ECOMPLEXITY_MODE complexity;
   gboolean bitrate_changed;
   gboolean max_bitrate_changed;
+  /* output buffers, sized for the raw frame */
+  GstBufferPool *output_pool;
 };
 
 struct _GstOpenh264EncClass
@@ -39,4 +39,10 @@
 #define OPJ_CPRL CPRL
 #endif
 
+/* multi-threaded decoding was added in OpenJPEG 2.2 */
+#if !defined (HAVE_OPENJPEG_1) && (OPJ_VERSION_MAJOR > 2 || \
+    (OPJ_VERSION_MAJOR == 2 && OPJ_VERSION_MINOR >= 2))
+#define GST_OPENJPEG_HAVE_THREADS 1
+#endif
+
 #endif /* __GST_OPENJPEG_H__ */
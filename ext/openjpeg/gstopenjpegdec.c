@@ -38,8 +38,28 @@ static gboolean gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
     GstVideoCodecState * state);
 static GstFlowReturn gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame);
+static GstFlowReturn gst_openjpeg_dec_finish (GstVideoDecoder * decoder);
+static gboolean gst_openjpeg_dec_flush (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder,
     GstQuery * query);
+static void gst_openjpeg_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_dec_finalize (GObject * object);
+static GstFlowReturn gst_openjpeg_dec_finish_jobs (GstOpenJPEGDec * self,
+    guint max_pending);
+static void gst_openjpeg_dec_discard_jobs (GstOpenJPEGDec * self);
+
+enum
+{
+  PROP_0,
+  PROP_MAX_THREADS,
+  PROP_FRAME_THREADS
+};
+
+#define DEFAULT_MAX_THREADS 0
+#define DEFAULT_FRAME_THREADS 1
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 #define GRAY16 "GRAY16_LE"
@@ -73,12 +93,46 @@ G_DEFINE_TYPE (GstOpenJPEGDec, gst_openjpeg_dec, GST_TYPE_VIDEO_DECODER);
 static void
 gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
 {
+  GObjectClass *gobject_class;
   GstElementClass *element_class;
   GstVideoDecoderClass *video_decoder_class;
 
+  gobject_class = (GObjectClass *) klass;
   element_class = (GstElementClass *) klass;
   video_decoder_class = (GstVideoDecoderClass *) klass;
 
+  gobject_class->set_property = gst_openjpeg_dec_set_property;
+  gobject_class->get_property = gst_openjpeg_dec_get_property;
+  gobject_class->finalize = gst_openjpeg_dec_finalize;
+
+  /**
+   * GstOpenJPEGDec:max-threads:
+   *
+   * Number of threads OpenJPEG uses to decode each frame. 0 shares the
+   * processors among the #GstOpenJPEGDec:frame-threads. This requires
+   * OpenJPEG 2.2 or newer and is ignored otherwise.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_THREADS,
+      g_param_spec_int ("max-threads", "Maximum threads",
+          "Maximum number of threads to decode each frame (0 = automatic)",
+          0, G_MAXINT, DEFAULT_MAX_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstOpenJPEGDec:frame-threads:
+   *
+   * Number of frames decoded in parallel. Each additional frame adds one
+   * frame of latency. Changes are applied when the decoder is started.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAME_THREADS,
+      g_param_spec_uint ("frame-threads", "Frame threads",
+          "Number of frames decoded in parallel", 1, 64,
+          DEFAULT_FRAME_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class,
       &gst_openjpeg_dec_src_template);
   gst_element_class_add_static_pad_template (element_class,
@@ -96,6 +150,9 @@ gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_set_format);
   video_decoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_handle_frame);
+  video_decoder_class->finish = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_finish);
+  video_decoder_class->drain = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_finish);
+  video_decoder_class->flush = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_flush);
   video_decoder_class->decide_allocation = gst_openjpeg_dec_decide_allocation;
 
   GST_DEBUG_CATEGORY_INIT (gst_openjpeg_dec_debug, "openjpegdec", 0,
@@ -117,8 +174,26 @@ gst_openjpeg_dec_init (GstOpenJPEGDec * self)
   self->params.cp_limit_decoding = NO_LIMITATION;
 #endif
   self->sampling = GST_JPEG2000_SAMPLING_NONE;
+  self->max_threads = DEFAULT_MAX_THREADS;
+  self->frame_threads = DEFAULT_FRAME_THREADS;
+  g_queue_init (&self->pending_jobs);
+  g_mutex_init (&self->job_lock);
+  g_cond_init (&self->job_cond);
+}
+
+static void
+gst_openjpeg_dec_finalize (GObject * object)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  g_mutex_clear (&self->job_lock);
+  g_cond_clear (&self->job_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void gst_openjpeg_dec_job_func (gpointer data, gpointer user_data);
+
 static gboolean
 gst_openjpeg_dec_start (GstVideoDecoder * decoder)
 {
@@ -126,6 +201,21 @@ gst_openjpeg_dec_start (GstVideoDecoder * decoder)
 
   GST_DEBUG_OBJECT (self, "Starting");
 
+  GST_OBJECT_LOCK (self);
+  self->n_threads = self->max_threads;
+  if (self->n_threads == 0)
+    self->n_threads = MAX (g_get_num_processors () / self->frame_threads, 1);
+
+  self->n_frame_threads = self->frame_threads;
+  if (self->n_frame_threads > 1) {
+    self->job_pool = g_thread_pool_new (gst_openjpeg_dec_job_func, self,
+        self->n_frame_threads, FALSE, NULL);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  GST_DEBUG_OBJECT (self, "Decoding %u frames at once with %d threads each",
+      self->n_frame_threads, self->n_threads);
+
   return TRUE;
 }
 
@@ -136,6 +226,12 @@ gst_openjpeg_dec_stop (GstVideoDecoder * video_decoder)
 
   GST_DEBUG_OBJECT (self, "Stopping");
 
+  gst_openjpeg_dec_discard_jobs (self);
+  if (self->job_pool) {
+    g_thread_pool_free (self->job_pool, FALSE, TRUE);
+    self->job_pool = NULL;
+  }
+
   if (self->output_state) {
     gst_video_codec_state_unref (self->output_state);
     self->output_state = NULL;
@@ -160,6 +256,9 @@ gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
 
   GST_DEBUG_OBJECT (self, "Setting format: %" GST_PTR_FORMAT, state->caps);
 
+  /* the frames being decoded still use the previous format */
+  gst_openjpeg_dec_finish_jobs (self, 0);
+
   s = gst_caps_get_structure (state->caps, 0);
 
   self->color_space = OPJ_CLRSPC_UNKNOWN;
@@ -195,6 +294,13 @@ gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
     gst_video_codec_state_unref (self->input_state);
   self->input_state = gst_video_codec_state_ref (state);
 
+  if (self->n_frame_threads > 1 && state->info.fps_n > 0) {
+    GstClockTime latency = gst_util_uint64_scale (GST_SECOND *
+        (self->n_frame_threads - 1), state->info.fps_d, state->info.fps_n);
+
+    gst_video_decoder_set_latency (decoder, latency, latency);
+  }
+
   return TRUE;
 }
 
@@ -1046,13 +1152,35 @@ seek_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
 }
 #endif
 
-static GstFlowReturn
-gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
-    GstVideoCodecFrame * frame)
+typedef enum
 {
-  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint64 deadline;
+  DECODE_OK,
+  DECODE_INIT_ERROR,
+  DECODE_MAP_ERROR,
+  DECODE_OPEN_ERROR,
+  DECODE_ERROR
+} GstOpenJPEGDecResult;
+
+/* One frame to decode, along with a copy of the decoder settings, so it
+ * can be decoded on another thread */
+typedef struct
+{
+  GstVideoCodecFrame *frame;
+  OPJ_CODEC_FORMAT codec_format;
+  gboolean is_jp2c;
+  opj_dparameters_t params;
+  gint n_threads;
+
+  opj_image_t *image;
+  GstOpenJPEGDecResult result;
+  gboolean done;
+} GstOpenJPEGDecJob;
+
+static GstOpenJPEGDecResult
+gst_openjpeg_dec_decode (GstOpenJPEGDec * self, GstOpenJPEGDecJob * job)
+{
+  GstVideoCodecFrame *frame = job->frame;
+  GstOpenJPEGDecResult result = DECODE_OK;
   GstMapInfo map;
 #ifdef HAVE_OPENJPEG_1
   opj_dinfo_t *dec;
@@ -1062,23 +1190,11 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
   opj_stream_t *stream;
   MemStream mstream;
 #endif
-  opj_image_t *image;
-  GstVideoFrame vframe;
-  opj_dparameters_t params;
-
-  GST_DEBUG_OBJECT (self, "Handling frame");
-
-  deadline = gst_video_decoder_get_max_decode_time (decoder, frame);
-  if (deadline < 0) {
-    GST_LOG_OBJECT (self, "Dropping too late frame: deadline %" G_GINT64_FORMAT,
-        deadline);
-    ret = gst_video_decoder_drop_frame (decoder, frame);
-    return ret;
-  }
+  opj_image_t *image = NULL;
 
-  dec = opj_create_decompress (self->codec_format);
+  dec = opj_create_decompress (job->codec_format);
   if (!dec)
-    goto initialization_error;
+    return DECODE_INIT_ERROR;
 
 #ifdef HAVE_OPENJPEG_1
   if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
@@ -1105,34 +1221,55 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
   }
 #endif
 
-  params = self->params;
-  if (self->ncomps)
-    params.jpwl_exp_comps = self->ncomps;
-  opj_setup_decoder (dec, &params);
+  opj_setup_decoder (dec, &job->params);
 
-  if (!gst_buffer_map (frame->input_buffer, &map, GST_MAP_READ))
-    goto map_read_error;
+#ifdef GST_OPENJPEG_HAVE_THREADS
+  if (job->n_threads > 1 && !opj_codec_set_threads (dec, job->n_threads))
+    GST_WARNING_OBJECT (self, "Failed to use %d threads", job->n_threads);
+#endif
 
-  if (self->is_jp2c && map.size < 8)
-    goto open_error;
+  if (!gst_buffer_map (frame->input_buffer, &map, GST_MAP_READ)) {
+#ifdef HAVE_OPENJPEG_1
+    opj_destroy_decompress (dec);
+#else
+    opj_destroy_codec (dec);
+#endif
+    return DECODE_MAP_ERROR;
+  }
 
+  if (job->is_jp2c && map.size < 8) {
 #ifdef HAVE_OPENJPEG_1
-  io = opj_cio_open ((opj_common_ptr) dec, map.data + (self->is_jp2c ? 8 : 0),
-      map.size - (self->is_jp2c ? 8 : 0));
-  if (!io)
-    goto open_error;
+    opj_destroy_decompress (dec);
+#else
+    opj_destroy_codec (dec);
+#endif
+    gst_buffer_unmap (frame->input_buffer, &map);
+    return DECODE_OPEN_ERROR;
+  }
+
+#ifdef HAVE_OPENJPEG_1
+  io = opj_cio_open ((opj_common_ptr) dec, map.data + (job->is_jp2c ? 8 : 0),
+      map.size - (job->is_jp2c ? 8 : 0));
+  if (!io) {
+    opj_destroy_decompress (dec);
+    gst_buffer_unmap (frame->input_buffer, &map);
+    return DECODE_OPEN_ERROR;
+  }
 
   image = opj_decode (dec, io);
   if (!image)
-    goto decode_error;
+    result = DECODE_ERROR;
 #else
   stream = opj_stream_create (4096, OPJ_TRUE);
-  if (!stream)
-    goto open_error;
+  if (!stream) {
+    opj_destroy_codec (dec);
+    gst_buffer_unmap (frame->input_buffer, &map);
+    return DECODE_OPEN_ERROR;
+  }
 
-  mstream.data = map.data + (self->is_jp2c ? 8 : 0);
+  mstream.data = map.data + (job->is_jp2c ? 8 : 0);
   mstream.offset = 0;
-  mstream.size = map.size - (self->is_jp2c ? 8 : 0);
+  mstream.size = map.size - (job->is_jp2c ? 8 : 0);
 
   opj_stream_set_read_function (stream, read_fn);
   opj_stream_set_write_function (stream, write_fn);
@@ -1141,26 +1278,73 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
   opj_stream_set_user_data (stream, &mstream, NULL);
   opj_stream_set_user_data_length (stream, mstream.size);
 
-  image = NULL;
   if (!opj_read_header (stream, dec, &image))
-    goto decode_error;
-
-  if (!opj_decode (dec, stream, image))
-    goto decode_error;
+    result = DECODE_ERROR;
+  else if (!opj_decode (dec, stream, image))
+    result = DECODE_ERROR;
 #endif
 
-  {
+  if (result == DECODE_OK) {
     gint i;
 
     for (i = 0; i < image->numcomps; i++) {
       if (image->comps[i].data == NULL)
-        goto decode_error;
+        result = DECODE_ERROR;
     }
   }
 
+#ifdef HAVE_OPENJPEG_1
+  opj_cio_close (io);
+  opj_destroy_decompress (dec);
+#else
+  if (result == DECODE_OK)
+    opj_end_decompress (dec, stream);
+  opj_stream_destroy (stream);
+  opj_destroy_codec (dec);
+#endif
   gst_buffer_unmap (frame->input_buffer, &map);
 
-  ret = gst_openjpeg_dec_negotiate (self, image);
+  if (result != DECODE_OK && image) {
+    opj_image_destroy (image);
+    image = NULL;
+  }
+  job->image = image;
+
+  return result;
+}
+
+static void
+gst_openjpeg_dec_job_free (GstOpenJPEGDecJob * job)
+{
+  if (job->image)
+    opj_image_destroy (job->image);
+  g_slice_free (GstOpenJPEGDecJob, job);
+}
+
+/* converts the decoded image of the job to the output frame and finishes
+ * it, to be called from the streaming thread in the order of the input */
+static GstFlowReturn
+gst_openjpeg_dec_finish_job (GstOpenJPEGDec * self, GstOpenJPEGDecJob * job)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
+  GstVideoCodecFrame *frame = job->frame;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstVideoFrame vframe;
+
+  switch (job->result) {
+    case DECODE_OK:
+      break;
+    case DECODE_INIT_ERROR:
+      goto initialization_error;
+    case DECODE_MAP_ERROR:
+      goto map_read_error;
+    case DECODE_OPEN_ERROR:
+      goto open_error;
+    case DECODE_ERROR:
+      goto decode_error;
+  }
+
+  ret = gst_openjpeg_dec_negotiate (self, job->image);
   if (ret != GST_FLOW_OK)
     goto negotiate_error;
 
@@ -1172,20 +1356,11 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
           frame->output_buffer, GST_MAP_WRITE))
     goto map_write_error;
 
-  self->fill_frame (&vframe, image);
+  self->fill_frame (&vframe, job->image);
 
   gst_video_frame_unmap (&vframe);
 
-#ifdef HAVE_OPENJPEG_1
-  opj_cio_close (io);
-  opj_image_destroy (image);
-  opj_destroy_decompress (dec);
-#else
-  opj_end_decompress (dec, stream);
-  opj_stream_destroy (stream);
-  opj_image_destroy (image);
-  opj_destroy_codec (dec);
-#endif
+  gst_openjpeg_dec_job_free (job);
 
   ret = gst_video_decoder_finish_frame (decoder, frame);
 
@@ -1193,6 +1368,7 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
 
 initialization_error:
   {
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
     GST_ELEMENT_ERROR (self, LIBRARY, INIT,
         ("Failed to initialize OpenJPEG decoder"), (NULL));
@@ -1200,11 +1376,7 @@ initialization_error:
   }
 map_read_error:
   {
-#ifdef HAVE_OPENJPEG_1
-    opj_destroy_decompress (dec);
-#else
-    opj_destroy_codec (dec);
-#endif
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1213,12 +1385,7 @@ map_read_error:
   }
 open_error:
   {
-#ifdef HAVE_OPENJPEG_1
-    opj_destroy_decompress (dec);
-#else
-    opj_destroy_codec (dec);
-#endif
-    gst_buffer_unmap (frame->input_buffer, &map);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, LIBRARY, INIT,
@@ -1227,16 +1394,7 @@ open_error:
   }
 decode_error:
   {
-    if (image)
-      opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
-    gst_buffer_unmap (frame->input_buffer, &map);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
@@ -1245,14 +1403,7 @@ decode_error:
   }
 negotiate_error:
   {
-    opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, NEGOTIATION,
@@ -1261,14 +1412,7 @@ negotiate_error:
   }
 allocate_error:
   {
-    opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1277,14 +1421,7 @@ allocate_error:
   }
 map_write_error:
   {
-    opj_image_destroy (image);
-#ifdef HAVE_OPENJPEG_1
-    opj_cio_close (io);
-    opj_destroy_decompress (dec);
-#else
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-#endif
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1293,6 +1430,127 @@ map_write_error:
   }
 }
 
+static void
+gst_openjpeg_dec_job_func (gpointer data, gpointer user_data)
+{
+  GstOpenJPEGDecJob *job = data;
+  GstOpenJPEGDec *self = user_data;
+  GstOpenJPEGDecResult result;
+
+  result = gst_openjpeg_dec_decode (self, job);
+
+  g_mutex_lock (&self->job_lock);
+  job->result = result;
+  job->done = TRUE;
+  g_cond_broadcast (&self->job_cond);
+  g_mutex_unlock (&self->job_lock);
+}
+
+/* Finishes the decoded frames at the head of the queue, waiting for
+ * decoding to complete until at most max_pending frames are left */
+static GstFlowReturn
+gst_openjpeg_dec_finish_jobs (GstOpenJPEGDec * self, guint max_pending)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstOpenJPEGDecJob *job;
+
+  while ((job = g_queue_peek_head (&self->pending_jobs))) {
+    GstFlowReturn job_ret;
+    gboolean done;
+
+    g_mutex_lock (&self->job_lock);
+    while (!job->done && self->pending_jobs.length > max_pending)
+      g_cond_wait (&self->job_cond, &self->job_lock);
+    done = job->done;
+    g_mutex_unlock (&self->job_lock);
+
+    if (!done)
+      break;
+
+    g_queue_pop_head (&self->pending_jobs);
+    job_ret = gst_openjpeg_dec_finish_job (self, job);
+    if (ret == GST_FLOW_OK)
+      ret = job_ret;
+  }
+
+  return ret;
+}
+
+/* waits for the frames being decoded and drops them */
+static void
+gst_openjpeg_dec_discard_jobs (GstOpenJPEGDec * self)
+{
+  GstOpenJPEGDecJob *job;
+
+  while ((job = g_queue_pop_head (&self->pending_jobs))) {
+    g_mutex_lock (&self->job_lock);
+    while (!job->done)
+      g_cond_wait (&self->job_cond, &self->job_lock);
+    g_mutex_unlock (&self->job_lock);
+
+    gst_video_codec_frame_unref (job->frame);
+    gst_openjpeg_dec_job_free (job);
+  }
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstOpenJPEGDecJob *job;
+  gint64 deadline;
+
+  GST_DEBUG_OBJECT (self, "Handling frame");
+
+  deadline = gst_video_decoder_get_max_decode_time (decoder, frame);
+  if (deadline < 0) {
+    GST_LOG_OBJECT (self, "Dropping too late frame: deadline %" G_GINT64_FORMAT,
+        deadline);
+    ret = gst_video_decoder_drop_frame (decoder, frame);
+    return ret;
+  }
+
+  job = g_slice_new0 (GstOpenJPEGDecJob);
+  job->frame = frame;
+  job->codec_format = self->codec_format;
+  job->is_jp2c = self->is_jp2c;
+  job->params = self->params;
+  if (self->ncomps)
+    job->params.jpwl_exp_comps = self->ncomps;
+  job->n_threads = self->n_threads;
+
+  if (!self->job_pool) {
+    job->result = gst_openjpeg_dec_decode (self, job);
+    job->done = TRUE;
+    return gst_openjpeg_dec_finish_job (self, job);
+  }
+
+  g_queue_push_tail (&self->pending_jobs, job);
+  g_thread_pool_push (self->job_pool, job, NULL);
+
+  return gst_openjpeg_dec_finish_jobs (self, self->n_frame_threads - 1);
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_finish (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  return gst_openjpeg_dec_finish_jobs (self, 0);
+}
+
+static gboolean
+gst_openjpeg_dec_flush (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  gst_openjpeg_dec_discard_jobs (self);
+
+  return TRUE;
+}
+
 static gboolean
 gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
 {
@@ -1317,3 +1575,49 @@ gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
 
   return TRUE;
 }
+
+static void
+gst_openjpeg_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  switch (prop_id) {
+    case PROP_MAX_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->max_threads = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_FRAME_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->frame_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_openjpeg_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  switch (prop_id) {
+    case PROP_MAX_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->max_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_FRAME_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->frame_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
@@ -61,6 +61,20 @@ struct _GstOpenJPEGDec
   void (*fill_frame) (GstVideoFrame *frame, opj_image_t * image);
 
   opj_dparameters_t params;
+
+  /* properties */
+  gint max_threads;
+  guint frame_threads;
+
+  /* threads used per frame and frames decoded at once while running */
+  gint n_threads;
+  guint n_frame_threads;
+
+  /* frames decoded on the job pool, in input order */
+  GThreadPool *job_pool;
+  GQueue pending_jobs;
+  GMutex job_lock;
+  GCond job_cond;
 };
 
 struct _GstOpenJPEGDecClass
@@ -22,6 +22,7 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <string.h>
 #include <gst/tag/tag.h>
 #include <gst/base/gstbytewriter.h>
 #include "gstopusheader.h"
@@ -36,54 +37,57 @@ gst_opus_header_is_header (GstBuffer * buf, const char *magic, guint magic_size)
 gboolean
 gst_opus_header_is_id_header (GstBuffer * buf)
 {
-  gsize size = gst_buffer_get_size (buf);
-  guint8 *data = NULL;
-  guint8 version, channels, channel_mapping_family, n_streams, n_stereo_streams;
-  gboolean ret = FALSE;
+  gboolean ret;
   GstMapInfo map;
 
-  if (size < 19)
-    goto beach;
-  if (!gst_opus_header_is_header (buf, "OpusHead", 8))
-    goto beach;
+  if (!gst_buffer_map (buf, &map, GST_MAP_READ))
+    return FALSE;
+  ret = gst_opus_header_is_id_header_data (map.data, map.size);
+  gst_buffer_unmap (buf, &map);
+
+  return ret;
+}
 
-  gst_buffer_map (buf, &map, GST_MAP_READ);
-  data = map.data;
-  size = map.size;
+/* same as gst_opus_header_is_id_header(), for callers that already have the
+ * buffer mapped */
+gboolean
+gst_opus_header_is_id_header_data (const guint8 * data, gsize size)
+{
+  guint8 version, channels, channel_mapping_family, n_streams, n_stereo_streams;
+
+  if (size < 19)
+    return FALSE;
+  if (memcmp (data, "OpusHead", 8) != 0)
+    return FALSE;
 
   version = data[8];
   if (version >= 0x0f)          /* major version >=0 is what we grok */
-    goto beach;
+    return FALSE;
 
   channels = data[9];
 
   if (channels == 0)
-    goto beach;
+    return FALSE;
 
   channel_mapping_family = data[18];
 
   if (channel_mapping_family == 0) {
     if (channels > 2)
-      goto beach;
+      return FALSE;
   } else {
-    channels = data[9];
     if (size < 21 + channels)
-      goto beach;
+      return FALSE;
     n_streams = data[19];
     n_stereo_streams = data[20];
     if (n_streams == 0)
-      goto beach;
+      return FALSE;
     if (n_stereo_streams > n_streams)
-      goto beach;
+      return FALSE;
     if (n_streams + n_stereo_streams > 255)
-      goto beach;
+      return FALSE;
   }
-  ret = TRUE;
 
-beach:
-  if (data)
-    gst_buffer_unmap (buf, &map);
-  return ret;
+  return TRUE;
 }
 
 gboolean
@@ -91,3 +95,9 @@ gst_opus_header_is_comment_header (GstBuffer * buf)
 {
   return gst_opus_header_is_header (buf, "OpusTags", 8);
 }
+
+gboolean
+gst_opus_header_is_comment_header_data (const guint8 * data, gsize size)
+{
+  return size >= 8 && memcmp (data, "OpusTags", 8) == 0;
+}
@@ -30,6 +30,10 @@ extern gboolean gst_opus_header_is_header (GstBuffer * buf,
     const char *magic, guint magic_size);
 extern gboolean gst_opus_header_is_id_header (GstBuffer * buf);
 extern gboolean gst_opus_header_is_comment_header (GstBuffer * buf);
+extern gboolean gst_opus_header_is_id_header_data (const guint8 * data,
+    gsize size);
+extern gboolean gst_opus_header_is_comment_header_data (const guint8 * data,
+    gsize size);
 
 
 G_END_DECLS
@@ -72,7 +72,9 @@ static gboolean gst_opus_parse_stop (GstBaseParse * parse);
 static GstFlowReturn gst_opus_parse_handle_frame (GstBaseParse * base,
     GstBaseParseFrame * frame, gint * skip);
 static GstFlowReturn gst_opus_parse_parse_frame (GstBaseParse * base,
-    GstBaseParseFrame * frame);
+    GstBaseParseFrame * frame, gboolean is_idheader,
+    gboolean is_commentheader, guint64 duration);
+static guint64 packet_duration_opus (const guint8 * data, size_t len);
 
 static void
 gst_opus_parse_class_init (GstOpusParseClass * klass)
@@ -147,6 +149,7 @@ gst_opus_parse_handle_frame (GstBaseParse * base,
   int payload_offset;
   int packet_offset = 0;
   gboolean is_header, is_idheader, is_commentheader;
+  guint64 duration = 0;
   GstMapInfo map;
 
   parse = GST_OPUS_PARSE (base);
@@ -160,8 +163,8 @@ gst_opus_parse_handle_frame (GstBaseParse * base,
       "Checking for frame, %" G_GSIZE_FORMAT " bytes in buffer", size);
 
   /* check for headers */
-  is_idheader = gst_opus_header_is_id_header (frame->buffer);
-  is_commentheader = gst_opus_header_is_comment_header (frame->buffer);
+  is_idheader = gst_opus_header_is_id_header_data (data, size);
+  is_commentheader = gst_opus_header_is_comment_header_data (data, size);
   is_header = is_idheader || is_commentheader;
 
   if (!is_header) {
@@ -215,6 +218,8 @@ gst_opus_parse_handle_frame (GstBaseParse * base,
   } else {
     *skip = packet_offset;
     size = payload_offset;
+    /* only used once the packet is at the start, i.e. when not skipping */
+    duration = packet_duration_opus (data, size);
   }
 
   GST_DEBUG_OBJECT (parse,
@@ -250,7 +255,8 @@ beach:
     gst_buffer_unref (frame->buffer);
   }
 
-  ret = gst_opus_parse_parse_frame (base, frame);
+  ret = gst_opus_parse_parse_frame (base, frame, is_idheader, is_commentheader,
+      duration);
 
   if (ret == GST_BASE_PARSE_FLOW_DROPPED) {
     frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
@@ -318,12 +324,13 @@ packet_duration_opus (const guint8 * data, size_t len)
   return duration;
 }
 
+/* the header checks and the duration come from handle_frame, which already
+ * had the data mapped, so steady state frames are only mapped once */
 static GstFlowReturn
-gst_opus_parse_parse_frame (GstBaseParse * base, GstBaseParseFrame * frame)
+gst_opus_parse_parse_frame (GstBaseParse * base, GstBaseParseFrame * frame,
+    gboolean is_idheader, gboolean is_commentheader, guint64 duration)
 {
-  guint64 duration;
   GstOpusParse *parse;
-  gboolean is_idheader, is_commentheader;
   GstMapInfo map;
   GstAudioClippingMeta *cmeta =
       gst_buffer_get_audio_clipping_meta (frame->buffer);
@@ -332,9 +339,6 @@ gst_opus_parse_parse_frame (GstBaseParse * base, GstBaseParseFrame * frame)
 
   g_assert (!cmeta || cmeta->format == GST_FORMAT_DEFAULT);
 
-  is_idheader = gst_opus_header_is_id_header (frame->buffer);
-  is_commentheader = gst_opus_header_is_comment_header (frame->buffer);
-
   if (!parse->got_headers || !parse->header_sent) {
     GstCaps *caps;
 
@@ -355,10 +359,6 @@ gst_opus_parse_parse_frame (GstBaseParse * base, GstBaseParseFrame * frame)
     if (cmeta && cmeta->start) {
       parse->pre_skip += cmeta->start;
 
-      gst_buffer_map (frame->buffer, &map, GST_MAP_READ);
-      duration = packet_duration_opus (map.data, map.size);
-      gst_buffer_unmap (frame->buffer, &map);
-
       /* Queue frame for later once we know all initial padding */
       if (duration == cmeta->start) {
         frame->flags |= GST_BASE_PARSE_FRAME_FLAG_QUEUE;
@@ -415,10 +415,6 @@ gst_opus_parse_parse_frame (GstBaseParse * base, GstBaseParseFrame * frame)
   }
 
   GST_BUFFER_TIMESTAMP (frame->buffer) = parse->next_ts;
-
-  gst_buffer_map (frame->buffer, &map, GST_MAP_READ);
-  duration = packet_duration_opus (map.data, map.size);
-  gst_buffer_unmap (frame->buffer, &map);
   parse->next_ts += duration;
 
   GST_BUFFER_DURATION (frame->buffer) = duration;
@@ -33,6 +33,13 @@
  * gst-launch-1.0 -v videotestsrc ! ffenc_flv ! flvmux ! rtmpsink location='rtmp://localhost/path/to/stream live=1'
  * ]| Encode a test video stream to FLV video format and stream it via RTMP.
  *
+ * By default the data is written from the streaming thread, which blocks
+ * upstream while the network stalls. Setting #GstRTMPSink:max-queue-time
+ * makes the element connect and write from a separate thread instead. When
+ * more than that amount of data is waiting, the queued data is dropped and
+ * sending resumes with the next keyframe, so live encoders keep running
+ * through network hiccups.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -45,19 +52,31 @@
 
 #ifdef G_OS_WIN32
 #include <winsock2.h>
+#else
+#include <sys/socket.h>
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_rtmp_sink_debug);
 #define GST_CAT_DEFAULT gst_rtmp_sink_debug
 
+#ifndef RTMP_PACKET_TYPE_CHUNK_SIZE
+#define RTMP_PACKET_TYPE_CHUNK_SIZE 0x01
+#endif
+
 #define DEFAULT_LOCATION NULL
+#define DEFAULT_CHUNK_SIZE 128
+#define DEFAULT_MAX_QUEUE_TIME 0
 
 enum
 {
   PROP_0,
-  PROP_LOCATION
+  PROP_LOCATION,
+  PROP_CHUNK_SIZE,
+  PROP_MAX_QUEUE_TIME,
+  PROP_DROPPED
 };
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -78,6 +97,7 @@ static gboolean gst_rtmp_sink_start (GstBaseSink * sink);
 static gboolean gst_rtmp_sink_event (GstBaseSink * sink, GstEvent * event);
 static gboolean gst_rtmp_sink_setcaps (GstBaseSink * sink, GstCaps * caps);
 static GstFlowReturn gst_rtmp_sink_render (GstBaseSink * sink, GstBuffer * buf);
+static gpointer gst_rtmp_sink_writer_func (gpointer data);
 
 #define gst_rtmp_sink_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GstRTMPSink, gst_rtmp_sink, GST_TYPE_BASE_SINK,
@@ -104,6 +124,46 @@ gst_rtmp_sink_class_init (GstRTMPSinkClass * klass)
       g_param_spec_string ("location", "RTMP Location", "RTMP url",
           DEFAULT_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTMPSink:chunk-size:
+   *
+   * Size of the RTMP chunks sent to the server. Larger chunks need fewer
+   * chunk headers for the same amount of data.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_CHUNK_SIZE,
+      g_param_spec_uint ("chunk-size", "Chunk size",
+          "Outgoing RTMP chunk size announced to the server", 128, 0xffffff,
+          DEFAULT_CHUNK_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTMPSink:max-queue-time:
+   *
+   * Maximum duration of data waiting to be sent before it is dropped up to
+   * the next keyframe. 0 writes from the streaming thread.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_TIME,
+      g_param_spec_uint64 ("max-queue-time", "Max queue time",
+          "Maximum duration of queued data in nanoseconds before dropping "
+          "(0 = write from the streaming thread without a queue)", 0,
+          G_MAXUINT64, DEFAULT_MAX_QUEUE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTMPSink:dropped:
+   *
+   * Number of buffers dropped because the queue was full.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_DROPPED,
+      g_param_spec_uint64 ("dropped", "Dropped",
+          "Number of buffers dropped from the outgoing queue", 0, G_MAXUINT64,
+          0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "RTMP output sink",
       "Sink/Network", "Sends FLV content to a server via RTMP",
@@ -134,6 +194,12 @@ gst_rtmp_sink_init (GstRTMPSink * sink)
     GST_ERROR_OBJECT (sink, "WSAStartup failed: 0x%08x", WSAGetLastError ());
   }
 #endif
+
+  sink->chunk_size = DEFAULT_CHUNK_SIZE;
+  sink->max_queue_time = DEFAULT_MAX_QUEUE_TIME;
+  g_mutex_init (&sink->lock);
+  g_cond_init (&sink->cond);
+  g_queue_init (&sink->queue);
 }
 
 static void
@@ -145,6 +211,8 @@ gst_rtmp_sink_finalize (GObject * object)
   WSACleanup ();
 #endif
   g_free (sink->uri);
+  g_mutex_clear (&sink->lock);
+  g_cond_clear (&sink->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -183,6 +251,15 @@ gst_rtmp_sink_start (GstBaseSink * basesink)
 
   sink->first = TRUE;
   sink->have_write_error = FALSE;
+  sink->flushing = FALSE;
+  sink->writing = FALSE;
+  sink->skip_to_keyframe = FALSE;
+  sink->flow_ret = GST_FLOW_OK;
+  sink->dropped = 0;
+
+  if (sink->max_queue_time > 0) {
+    sink->writer = g_thread_new ("rtmpsink", gst_rtmp_sink_writer_func, sink);
+  }
 
   return TRUE;
 
@@ -201,6 +278,26 @@ gst_rtmp_sink_stop (GstBaseSink * basesink)
 {
   GstRTMPSink *sink = GST_RTMP_SINK (basesink);
 
+  if (sink->writer) {
+    g_mutex_lock (&sink->lock);
+    sink->flushing = TRUE;
+    g_cond_broadcast (&sink->cond);
+    /* interrupt a write blocked on the network */
+    if (sink->writing && RTMP_IsConnected (sink->rtmp)) {
+#ifdef G_OS_WIN32
+      shutdown (RTMP_Socket (sink->rtmp), SD_BOTH);
+#else
+      shutdown (RTMP_Socket (sink->rtmp), SHUT_RDWR);
+#endif
+    }
+    g_mutex_unlock (&sink->lock);
+
+    g_thread_join (sink->writer);
+    sink->writer = NULL;
+  }
+  g_queue_foreach (&sink->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&sink->queue);
+
   if (sink->header) {
     gst_buffer_unref (sink->header);
     sink->header = NULL;
@@ -218,39 +315,68 @@ gst_rtmp_sink_stop (GstBaseSink * basesink)
   return TRUE;
 }
 
-static GstFlowReturn
-gst_rtmp_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+/* Announces the outgoing chunk size, librtmp only ever uses the default of
+ * 128 bytes on its own */
+static gboolean
+gst_rtmp_sink_set_chunk_size (GstRTMPSink * sink)
 {
-  GstRTMPSink *sink = GST_RTMP_SINK (bsink);
-  gboolean need_unref = FALSE;
-  GstMapInfo map = GST_MAP_INFO_INIT;
+  RTMPPacket packet;
+  gchar pbuf[RTMP_MAX_HEADER_SIZE + 4];
 
-  if (sink->rtmp == NULL) {
-    /* Do not crash */
-    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL), ("Failed to write data"));
-    return GST_FLOW_ERROR;
-  }
+  if (sink->chunk_size == DEFAULT_CHUNK_SIZE)
+    return TRUE;
 
-  /* Ignore buffers that are in the stream headers (caps) */
-  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER)) {
-    return GST_FLOW_OK;
+  memset (&packet, 0, sizeof (packet));
+  packet.m_nChannel = 0x02;
+  packet.m_headerType = RTMP_PACKET_SIZE_LARGE;
+  packet.m_packetType = RTMP_PACKET_TYPE_CHUNK_SIZE;
+  packet.m_body = pbuf + RTMP_MAX_HEADER_SIZE;
+  packet.m_nBodySize = 4;
+  AMF_EncodeInt32 (packet.m_body, packet.m_body + 4, sink->chunk_size);
+
+  if (!RTMP_SendPacket (sink->rtmp, &packet, FALSE))
+    return FALSE;
+
+  sink->rtmp->m_outChunkSize = sink->chunk_size;
+  GST_DEBUG_OBJECT (sink, "Set chunk size to %u", sink->chunk_size);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtmp_sink_connect (GstRTMPSink * sink)
+{
+  if (RTMP_IsConnected (sink->rtmp))
+    return TRUE;
+
+  if (!RTMP_Connect (sink->rtmp, NULL)
+      || !RTMP_ConnectStream (sink->rtmp, 0)) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+        ("Could not connect to RTMP stream \"%s\" for writing", sink->uri));
+    return FALSE;
   }
+  GST_DEBUG_OBJECT (sink, "Opened connection to %s", sink->rtmp_uri);
+
+  if (!gst_rtmp_sink_set_chunk_size (sink))
+    GST_WARNING_OBJECT (sink, "Could not set chunk size, using the default");
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_rtmp_sink_write (GstRTMPSink * sink, GstBuffer * buf)
+{
+  gboolean need_unref = FALSE;
+  GstMapInfo map = GST_MAP_INFO_INIT;
 
   if (sink->first) {
     /* open the connection */
-    if (!RTMP_IsConnected (sink->rtmp)) {
-      if (!RTMP_Connect (sink->rtmp, NULL)
-          || !RTMP_ConnectStream (sink->rtmp, 0)) {
-        GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
-            ("Could not connect to RTMP stream \"%s\" for writing", sink->uri));
-        RTMP_Free (sink->rtmp);
-        sink->rtmp = NULL;
-        g_free (sink->rtmp_uri);
-        sink->rtmp_uri = NULL;
-        sink->have_write_error = TRUE;
-        return GST_FLOW_ERROR;
-      }
-      GST_DEBUG_OBJECT (sink, "Opened connection to %s", sink->rtmp_uri);
+    if (!gst_rtmp_sink_connect (sink)) {
+      /* the context is freed in stop, the writer thread might still be
+       * interrupted through its socket until then */
+      sink->first = FALSE;
+      sink->have_write_error = TRUE;
+      return GST_FLOW_ERROR;
     }
 
     /* Prepend the header from the caps to the first non header buffer */
@@ -292,6 +418,114 @@ write_failed:
   }
 }
 
+static gpointer
+gst_rtmp_sink_writer_func (gpointer data)
+{
+  GstRTMPSink *sink = GST_RTMP_SINK (data);
+  GstBuffer *buf;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&sink->lock);
+  while (TRUE) {
+    while (g_queue_is_empty (&sink->queue) && !sink->flushing)
+      g_cond_wait (&sink->cond, &sink->lock);
+    if (sink->flushing)
+      break;
+
+    buf = g_queue_pop_head (&sink->queue);
+    sink->writing = TRUE;
+    g_mutex_unlock (&sink->lock);
+
+    ret = gst_rtmp_sink_write (sink, buf);
+    gst_buffer_unref (buf);
+
+    g_mutex_lock (&sink->lock);
+    sink->writing = FALSE;
+    g_cond_broadcast (&sink->cond);
+    if (ret != GST_FLOW_OK) {
+      sink->flow_ret = ret;
+      break;
+    }
+  }
+  g_mutex_unlock (&sink->lock);
+
+  GST_DEBUG_OBJECT (sink, "Writer thread stopped");
+
+  return NULL;
+}
+
+/* Drops the queued data once it spans more than max-queue-time. The next
+ * data sent is a keyframe so the server can resume decoding right away */
+static void
+gst_rtmp_sink_check_queue (GstRTMPSink * sink)
+{
+  GstBuffer *head, *tail;
+  GstClockTime first, last;
+
+  head = g_queue_peek_head (&sink->queue);
+  tail = g_queue_peek_tail (&sink->queue);
+  if (head == NULL)
+    return;
+
+  first = GST_BUFFER_DTS_OR_PTS (head);
+  last = GST_BUFFER_DTS_OR_PTS (tail);
+  if (!GST_CLOCK_TIME_IS_VALID (first) || !GST_CLOCK_TIME_IS_VALID (last) ||
+      last < first + sink->max_queue_time)
+    return;
+
+  GST_WARNING_OBJECT (sink, "Dropping %u queued buffers spanning %"
+      GST_TIME_FORMAT, g_queue_get_length (&sink->queue),
+      GST_TIME_ARGS (last - first));
+
+  sink->dropped += g_queue_get_length (&sink->queue);
+  g_queue_foreach (&sink->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&sink->queue);
+  sink->skip_to_keyframe = TRUE;
+}
+
+static GstFlowReturn
+gst_rtmp_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+{
+  GstRTMPSink *sink = GST_RTMP_SINK (bsink);
+  GstFlowReturn ret;
+
+  if (sink->rtmp == NULL) {
+    /* Do not crash */
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL), ("Failed to write data"));
+    return GST_FLOW_ERROR;
+  }
+
+  /* Ignore buffers that are in the stream headers (caps) */
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER)) {
+    return GST_FLOW_OK;
+  }
+
+  if (sink->writer == NULL)
+    return gst_rtmp_sink_write (sink, buf);
+
+  g_mutex_lock (&sink->lock);
+  ret = sink->flow_ret;
+  if (ret != GST_FLOW_OK)
+    goto done;
+
+  if (sink->skip_to_keyframe) {
+    if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+      sink->dropped++;
+      goto done;
+    }
+    sink->skip_to_keyframe = FALSE;
+  }
+
+  g_queue_push_tail (&sink->queue, gst_buffer_ref (buf));
+  gst_rtmp_sink_check_queue (sink);
+  g_cond_broadcast (&sink->cond);
+
+done:
+  g_mutex_unlock (&sink->lock);
+
+  return ret;
+}
+
 /*
  * URI interface support.
  */
@@ -386,6 +620,12 @@ gst_rtmp_sink_set_property (GObject * object, guint prop_id,
       gst_rtmp_sink_uri_set_uri (GST_URI_HANDLER (sink),
           g_value_get_string (value), NULL);
       break;
+    case PROP_CHUNK_SIZE:
+      sink->chunk_size = g_value_get_uint (value);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      sink->max_queue_time = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -444,6 +684,15 @@ gst_rtmp_sink_event (GstBaseSink * sink, GstEvent * event)
     case GST_EVENT_FLUSH_STOP:
       rtmpsink->have_write_error = FALSE;
       break;
+    case GST_EVENT_EOS:
+      /* send everything queued before posting EOS */
+      g_mutex_lock (&rtmpsink->lock);
+      while (rtmpsink->writer && rtmpsink->flow_ret == GST_FLOW_OK &&
+          !rtmpsink->flushing && (rtmpsink->writing ||
+              !g_queue_is_empty (&rtmpsink->queue)))
+        g_cond_wait (&rtmpsink->cond, &rtmpsink->lock);
+      g_mutex_unlock (&rtmpsink->lock);
+      break;
     default:
       break;
   }
@@ -461,6 +710,17 @@ gst_rtmp_sink_get_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       g_value_set_string (value, sink->uri);
       break;
+    case PROP_CHUNK_SIZE:
+      g_value_set_uint (value, sink->chunk_size);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      g_value_set_uint64 (value, sink->max_queue_time);
+      break;
+    case PROP_DROPPED:
+      g_mutex_lock (&sink->lock);
+      g_value_set_uint64 (value, sink->dropped);
+      g_mutex_unlock (&sink->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -56,6 +56,20 @@ struct _GstRTMPSink {
   GstBuffer *header;
   gboolean first;
   gboolean have_write_error;
+
+  guint chunk_size;
+  GstClockTime max_queue_time;
+
+  /* outgoing queue, served by the writer thread */
+  GMutex lock;
+  GCond cond;
+  GQueue queue;
+  GThread *writer;
+  gboolean flushing;
+  gboolean writing;
+  gboolean skip_to_keyframe;
+  GstFlowReturn flow_ret;
+  guint64 dropped;
 };
 
 struct _GstRTMPSinkClass {
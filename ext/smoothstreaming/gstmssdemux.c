@@ -697,28 +697,16 @@ gst_mss_demux_data_received (GstAdaptiveDemux * demux,
 {
   GstMssDemux *mssdemux = GST_MSS_DEMUX_CAST (demux);
   GstMssDemuxStream *mssstream = (GstMssDemuxStream *) stream;
-  gsize available;
 
   if (!gst_mss_manifest_is_live (mssdemux->manifest)) {
     return GST_ADAPTIVE_DEMUX_CLASS (parent_class)->data_received (demux,
         stream, buffer);
   }
 
-  if (gst_mss_stream_fragment_parsing_needed (mssstream->manifest_stream)) {
-    gst_mss_manifest_live_adapter_push (mssstream->manifest_stream, buffer);
-    available =
-        gst_mss_manifest_live_adapter_available (mssstream->manifest_stream);
-    // FIXME: try to reduce this minimal size.
-    if (available < 4096) {
-      return GST_FLOW_OK;
-    } else {
-      GST_LOG_OBJECT (stream->pad, "enough data, parsing fragment.");
-      buffer =
-          gst_mss_manifest_live_adapter_take_buffer (mssstream->manifest_stream,
-          available);
-      gst_mss_stream_parse_fragment (mssstream->manifest_stream, buffer);
-    }
-  }
+  /* The parser only keeps references to the data until it has seen the
+   * moof, so buffers go downstream right away */
+  if (gst_mss_stream_fragment_parsing_needed (mssstream->manifest_stream))
+    gst_mss_stream_parse_fragment (mssstream->manifest_stream, buffer);
 
   return GST_ADAPTIVE_DEMUX_CLASS (parent_class)->data_received (demux, stream,
       buffer);
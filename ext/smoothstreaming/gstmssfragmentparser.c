@@ -34,6 +34,7 @@ void
 gst_mss_fragment_parser_init (GstMssFragmentParser * parser)
 {
   parser->status = GST_MSS_FRAGMENT_HEADER_PARSER_INIT;
+  parser->offset = 0;
 }
 
 void
@@ -43,32 +44,42 @@ gst_mss_fragment_parser_clear (GstMssFragmentParser * parser)
     gst_isoff_moof_box_free (parser->moof);
   parser->moof = NULL;
   parser->current_fourcc = 0;
+  gst_buffer_replace (&parser->pending, NULL);
+  parser->offset = 0;
 }
 
+/* Can be called with consecutive buffers of a fragment until it returns
+ * TRUE. The data is neither copied nor merged, the boxes before mdat are
+ * parsed as soon as they are complete. */
 gboolean
 gst_mss_fragment_parser_add_buffer (GstMssFragmentParser * parser,
     GstBuffer * buffer)
 {
-  GstByteReader reader;
-  GstMapInfo info;
   guint64 size;
   guint32 fourcc;
   guint header_size;
+  gsize available;
   gboolean error = FALSE;
 
-  if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
+  if (parser->status != GST_MSS_FRAGMENT_HEADER_PARSER_INIT)
     return FALSE;
-  }
 
-  gst_byte_reader_init (&reader, info.data, info.size);
-  GST_TRACE ("Total buffer size: %u", gst_byte_reader_get_size (&reader));
+  if (parser->pending)
+    parser->pending = gst_buffer_append (parser->pending,
+        gst_buffer_ref (buffer));
+  else
+    parser->pending = gst_buffer_ref (buffer);
+
+  available = gst_buffer_get_size (parser->pending);
+  GST_TRACE ("Total buffer size: %" G_GSIZE_FORMAT, available);
 
-  do {
+  while (parser->offset < available) {
     parser->current_fourcc = 0;
 
-    if (!gst_isoff_parse_box_header (&reader, &fourcc, NULL, &header_size,
-            &size)) {
-      break;
+    if (!gst_isoff_parse_box_header_buffer (parser->pending, parser->offset,
+            &fourcc, NULL, &header_size, &size)) {
+      /* need more data */
+      return FALSE;
     }
 
     parser->current_fourcc = fourcc;
@@ -76,26 +87,39 @@ gst_mss_fragment_parser_add_buffer (GstMssFragmentParser * parser,
     GST_LOG ("box %" GST_FOURCC_FORMAT " size %" G_GUINT64_FORMAT,
         GST_FOURCC_ARGS (fourcc), size);
 
-    parser->current_fourcc = fourcc;
+    if (fourcc == GST_ISOFF_FOURCC_MDAT)
+      goto beach;
 
-    if (parser->current_fourcc == GST_ISOFF_FOURCC_MOOF) {
-      GstByteReader sub_reader;
+    if (size < header_size) {
+      GST_ERROR ("Invalid box size %" G_GUINT64_FORMAT, size);
+      error = TRUE;
+      goto beach;
+    }
+
+    if (fourcc == GST_ISOFF_FOURCC_MOOF) {
+      if (parser->offset + size > available) {
+        /* wait for the complete box */
+        return FALSE;
+      }
 
       g_assert (parser->moof == NULL);
-      gst_byte_reader_get_sub_reader (&reader, &sub_reader, size - header_size);
-      parser->moof = gst_isoff_moof_box_parse (&sub_reader);
+      parser->moof = gst_isoff_moof_box_parse_buffer (parser->pending,
+          parser->offset + header_size, size - header_size);
       if (parser->moof == NULL) {
         GST_ERROR ("Failed to parse moof");
         error = TRUE;
+        goto beach;
       }
-    } else if (parser->current_fourcc == GST_ISOFF_FOURCC_MDAT) {
-      goto beach;
-    } else {
-      gst_byte_reader_skip (&reader, size - header_size);
     }
-  } while (gst_byte_reader_get_remaining (&reader) > 0);
+
+    /* other boxes are skipped without waiting for their content */
+    parser->offset += size;
+  }
+
+  return FALSE;
 
 beach:
+  gst_buffer_replace (&parser->pending, NULL);
 
   /* Do sanity check */
   if (parser->current_fourcc != GST_ISOFF_FOURCC_MDAT || !parser->moof ||
@@ -113,10 +137,9 @@ beach:
     }
   }
 
-  if (!error)
-    parser->status = GST_MSS_FRAGMENT_HEADER_PARSER_FINISHED;
+  /* either way, nothing more to look for in this fragment */
+  parser->status = GST_MSS_FRAGMENT_HEADER_PARSER_FINISHED;
 
   GST_LOG ("Fragment parsing successful: %s", error ? "no" : "yes");
-  gst_buffer_unmap (buffer, &info);
   return !error;
 }
@@ -42,6 +42,11 @@ typedef struct _GstMssFragmentParser
   GstFragmentHeaderParserStatus status;
   GstMoofBox *moof;
   guint32 current_fourcc;
+
+  /* data received so far, references the memories of the fragment buffers */
+  GstBuffer *pending;
+  /* offset of the next box header in pending */
+  guint64 offset;
 } GstMssFragmentParser;
 
 void gst_mss_fragment_parser_init (GstMssFragmentParser * parser);
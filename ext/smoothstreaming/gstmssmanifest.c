@@ -78,7 +78,6 @@ struct _GstMssStream
   gint selectedQualityIndex;
 
   gboolean has_live_fragments;
-  GstAdapter *live_adapter;
 
   GList *fragments;
   GList *qualities;
@@ -280,10 +279,6 @@ _gst_mss_stream_init (GstMssManifest * manifest, GstMssStream * stream,
     }
   }
 
-  if (stream->has_live_fragments) {
-    stream->live_adapter = gst_adapter_new ();
-  }
-
   if (builder.fragments) {
     stream->fragments = g_list_reverse (builder.fragments);
     stream->current_fragment = stream->fragments;
@@ -412,11 +407,6 @@ gst_mss_manifest_new (GstBuffer * data)
 static void
 gst_mss_stream_free (GstMssStream * stream)
 {
-  if (stream->live_adapter) {
-    gst_adapter_clear (stream->live_adapter);
-    g_object_unref (stream->live_adapter);
-  }
-
   g_list_free_full (stream->fragments, g_free);
   g_list_free_full (stream->qualities,
       (GDestroyNotify) gst_mss_stream_quality_free);
@@ -1573,24 +1563,6 @@ gst_mss_manifest_get_live_seek_range (GstMssManifest * manifest, gint64 * start,
   return ret;
 }
 
-void
-gst_mss_manifest_live_adapter_push (GstMssStream * stream, GstBuffer * buffer)
-{
-  gst_adapter_push (stream->live_adapter, buffer);
-}
-
-gsize
-gst_mss_manifest_live_adapter_available (GstMssStream * stream)
-{
-  return gst_adapter_available (stream->live_adapter);
-}
-
-GstBuffer *
-gst_mss_manifest_live_adapter_take_buffer (GstMssStream * stream, gsize nbytes)
-{
-  return gst_adapter_take_buffer (stream->live_adapter, nbytes);
-}
-
 gboolean
 gst_mss_stream_fragment_parsing_needed (GstMssStream * stream)
 {
@@ -58,9 +58,24 @@ enum
   ARG_OUT_RATE,
   ARG_RATE,
   ARG_TEMPO,
-  ARG_PITCH
+  ARG_PITCH,
+  ARG_SEQUENCE_MS,
+  ARG_SEEKWINDOW_MS,
+  ARG_OVERLAP_MS,
+  ARG_MAX_OUTPUT_SAMPLES
 };
 
+/* 0 lets soundtouch pick the sequence and seek window lengths from the
+ * tempo, the overlap is the soundtouch default */
+#define DEFAULT_SEQUENCE_MS 0
+#define DEFAULT_SEEKWINDOW_MS 0
+#define DEFAULT_OVERLAP_MS 8
+#define DEFAULT_MAX_OUTPUT_SAMPLES 0
+
+/* how much silence is pushed through soundtouch on caps changes, to grow
+ * its internal FIFOs before the first buffer instead of while streaming */
+#define PRIME_DURATION_MS 1000
+
 /* For soundtouch 1.4 */
 #if defined(INTEGER_SAMPLES)
 #define SOUNDTOUCH_INTEGER_SAMPLES 1
@@ -161,6 +176,37 @@ gst_pitch_class_init (GstPitchClass * klass)
           (GParamFlags) (G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE |
               G_PARAM_STATIC_STRINGS)));
 
+  g_object_class_install_property (gobject_class, ARG_SEQUENCE_MS,
+      g_param_spec_uint ("sequence-ms", "Sequence length",
+          "Length in ms of the sequences the stream is cut into for time "
+          "stretching (0 = automatic)", 0, 1000, DEFAULT_SEQUENCE_MS,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, ARG_SEEKWINDOW_MS,
+      g_param_spec_uint ("seekwindow-ms", "Seek window length",
+          "Length in ms of the window searched for the best overlap "
+          "position (0 = automatic)", 0, 1000, DEFAULT_SEEKWINDOW_MS,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, ARG_OVERLAP_MS,
+      g_param_spec_uint ("overlap-ms", "Overlap length",
+          "Length in ms of the crossfade between sequences", 1, 1000,
+          DEFAULT_OVERLAP_MS,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  /**
+   * GstPitch:max-output-samples:
+   *
+   * Output buffers hold at most this many samples. Lower values give
+   * smaller, more regular output buffers, e.g. for interactive scrubbing,
+   * 0 outputs everything that is available in one buffer.
+   */
+  g_object_class_install_property (gobject_class, ARG_MAX_OUTPUT_SAMPLES,
+      g_param_spec_uint ("max-output-samples", "Maximum output samples",
+          "Maximum number of samples per output buffer (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_MAX_OUTPUT_SAMPLES,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
   element_class->change_state = GST_DEBUG_FUNCPTR (gst_pitch_change_state);
 
   gst_element_class_add_static_pad_template (element_class, &gst_pitch_src_template);
@@ -202,6 +248,10 @@ gst_pitch_init (GstPitch * pitch)
   pitch->out_seg_rate = 1.0;
   pitch->seg_arate = 1.0;
   pitch->pitch = 1.0;
+  pitch->sequence_ms = DEFAULT_SEQUENCE_MS;
+  pitch->seekwindow_ms = DEFAULT_SEEKWINDOW_MS;
+  pitch->overlap_ms = DEFAULT_OVERLAP_MS;
+  pitch->max_output_samples = DEFAULT_MAX_OUTPUT_SAMPLES;
   pitch->next_buffer_time = GST_CLOCK_TIME_NONE;
   pitch->next_buffer_offset = 0;
 
@@ -271,6 +321,26 @@ gst_pitch_set_property (GObject * object, guint prop_id,
       pitch->priv->st->setPitch (pitch->pitch);
       GST_OBJECT_UNLOCK (pitch);
       break;
+    case ARG_SEQUENCE_MS:
+      pitch->sequence_ms = g_value_get_uint (value);
+      pitch->priv->st->setSetting (SETTING_SEQUENCE_MS, pitch->sequence_ms);
+      GST_OBJECT_UNLOCK (pitch);
+      break;
+    case ARG_SEEKWINDOW_MS:
+      pitch->seekwindow_ms = g_value_get_uint (value);
+      pitch->priv->st->setSetting (SETTING_SEEKWINDOW_MS,
+          pitch->seekwindow_ms);
+      GST_OBJECT_UNLOCK (pitch);
+      break;
+    case ARG_OVERLAP_MS:
+      pitch->overlap_ms = g_value_get_uint (value);
+      pitch->priv->st->setSetting (SETTING_OVERLAP_MS, pitch->overlap_ms);
+      GST_OBJECT_UNLOCK (pitch);
+      break;
+    case ARG_MAX_OUTPUT_SAMPLES:
+      pitch->max_output_samples = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (pitch);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       GST_OBJECT_UNLOCK (pitch);
@@ -298,6 +368,18 @@ gst_pitch_get_property (GObject * object, guint prop_id,
     case ARG_PITCH:
       g_value_set_float (value, pitch->pitch);
       break;
+    case ARG_SEQUENCE_MS:
+      g_value_set_uint (value, pitch->sequence_ms);
+      break;
+    case ARG_SEEKWINDOW_MS:
+      g_value_set_uint (value, pitch->seekwindow_ms);
+      break;
+    case ARG_OVERLAP_MS:
+      g_value_set_uint (value, pitch->overlap_ms);
+      break;
+    case ARG_MAX_OUTPUT_SAMPLES:
+      g_value_set_uint (value, pitch->max_output_samples);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -309,20 +391,32 @@ static gboolean
 gst_pitch_setcaps (GstPitch * pitch, GstCaps * caps)
 {
   GstPitchPrivate *priv;
+  guint prime_samples;
+  gpointer silence;
 
   priv = GST_PITCH_GET_PRIVATE (pitch);
 
   if (!gst_audio_info_from_caps (&pitch->info, caps))
     return FALSE;
 
+  prime_samples = pitch->info.rate * PRIME_DURATION_MS / 1000;
+  silence = g_malloc0 (prime_samples * pitch->info.bpf);
+
   GST_OBJECT_LOCK (pitch);
 
   /* notify the soundtouch instance of this change */
   priv->st->setSampleRate (pitch->info.rate);
   priv->st->setChannels (pitch->info.channels);
 
+  /* the FIFOs keep their size when cleared, so this preallocates them for
+   * input buffers of up to PRIME_DURATION_MS */
+  priv->st->putSamples ((soundtouch::SAMPLETYPE *) silence, prime_samples);
+  priv->st->clear ();
+
   GST_OBJECT_UNLOCK (pitch);
 
+  g_free (silence);
+
   return TRUE;
 }
 
@@ -364,6 +458,11 @@ gst_pitch_prepare_buffer (GstPitch * pitch)
   if (samples == 0)
     return NULL;
 
+  GST_OBJECT_LOCK (pitch);
+  if (pitch->max_output_samples > 0)
+    samples = MIN (samples, pitch->max_output_samples);
+  GST_OBJECT_UNLOCK (pitch);
+
   buffer = gst_buffer_new_and_alloc (samples * pitch->info.bpf);
 
   gst_buffer_map (buffer, &info, (GstMapFlags) GST_MAP_READWRITE);
@@ -383,14 +482,30 @@ gst_pitch_prepare_buffer (GstPitch * pitch)
   return buffer;
 }
 
+/* push everything soundtouch has ready, in buffers of at most
+ * max-output-samples */
+static GstFlowReturn
+gst_pitch_push_output (GstPitch * pitch)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buffer;
+
+  while (ret == GST_FLOW_OK && !pitch->priv->st->isEmpty ()) {
+    buffer = gst_pitch_prepare_buffer (pitch);
+    if (!buffer)
+      break;
+    ret = gst_pitch_forward_buffer (pitch, buffer);
+  }
+
+  return ret;
+}
+
 /* process the last samples, in a later stage we should make sure no more
  * samples are sent out here as strictly necessary, because soundtouch could
  * append zero samples, which could disturb looping.  */
 static GstFlowReturn
 gst_pitch_flush_buffer (GstPitch * pitch, gboolean send)
 {
-  GstBuffer *buffer;
-
   GST_DEBUG_OBJECT (pitch, "flushing buffer");
 
   if (pitch->next_buffer_offset == 0)
@@ -400,12 +515,7 @@ gst_pitch_flush_buffer (GstPitch * pitch, gboolean send)
   if (!send)
     return GST_FLOW_OK;
 
-  buffer = gst_pitch_prepare_buffer (pitch);
-
-  if (!buffer)
-    return GST_FLOW_OK;
-
-  return gst_pitch_forward_buffer (pitch, buffer);
+  return gst_pitch_push_output (pitch);
 }
 
 static gboolean
@@ -886,15 +996,7 @@ gst_pitch_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
   gst_pitch_update_latency (pitch, timestamp);
   /* and try to extract some samples from the soundtouch buffer */
-  if (!priv->st->isEmpty ()) {
-    GstBuffer *out_buffer;
-
-    out_buffer = gst_pitch_prepare_buffer (pitch);
-    if (out_buffer)
-      return gst_pitch_forward_buffer (pitch, out_buffer);
-  }
-
-  return GST_FLOW_OK;
+  return gst_pitch_push_output (pitch);
 }
 
 static GstStateChangeReturn
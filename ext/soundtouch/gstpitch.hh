@@ -71,6 +71,13 @@ struct _GstPitch
 
   gfloat  seg_arate;            /* Rate to apply from input segment */
 
+  /* time stretching parameters, 0 for automatic sequence and seek window */
+  guint    sequence_ms;
+  guint    seekwindow_ms;
+  guint    overlap_ms;
+
+  guint    max_output_samples;  /* 0 for unlimited */
+
   /* values extracted from caps */
   GstAudioInfo  info;
 
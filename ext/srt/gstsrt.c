@@ -153,6 +153,25 @@ failed:
   return SRT_INVALID_SOCK;
 }
 
+/* The latency recommended for the live mode is four times the RTT, this
+ * measures it on the connection of @sock so the next connection can use
+ * it. Never returns less than @min_latency */
+gint
+gst_srt_get_tuned_latency (SRTSOCKET sock, gint min_latency)
+{
+  SRT_TRACEBSTATS stats;
+  gint latency;
+
+  if (sock == SRT_INVALID_SOCK || srt_bstats (sock, &stats, 0) < 0
+      || stats.msRTT <= 0)
+    return min_latency;
+
+  latency = (gint) (4 * stats.msRTT + 0.5);
+  GST_DEBUG ("RTT %.1f ms, tuned latency %d ms", stats.msRTT, latency);
+
+  return MAX (latency, min_latency);
+}
+
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
@@ -31,6 +31,7 @@
 #define SRT_DEFAULT_HOST "127.0.0.1"
 #define SRT_DEFAULT_URI SRT_URI_SCHEME"://"SRT_DEFAULT_HOST":"G_STRINGIFY(SRT_DEFAULT_PORT)
 #define SRT_DEFAULT_LATENCY 125
+#define SRT_DEFAULT_AUTO_LATENCY FALSE
 
 G_BEGIN_DECLS
 
@@ -40,6 +41,9 @@ gst_srt_client_connect (GstElement * elem, int sender,
     const gchar * bind_address, guint16 bind_port, int latency,
     GSocketAddress ** socket_address, gint * poll_id);
 
+gint
+gst_srt_get_tuned_latency (SRTSOCKET sock, gint min_latency);
+
 G_END_DECLS
 
 
@@ -29,6 +29,9 @@
 #include <netinet/in.h>
 
 #define SRT_DEFAULT_POLL_TIMEOUT -1
+/* seven MPEG-TS packets, the most that fits in an SRT live mode packet */
+#define SRT_DEFAULT_PAYLOAD_SIZE (7 * 188)
+#define SRT_DEFAULT_MAX_DELAY (10 * GST_MSECOND)
 
 #define GST_CAT_DEFAULT gst_debug_srt_base_sink
 GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
@@ -37,6 +40,9 @@ enum
 {
   PROP_URI = 1,
   PROP_LATENCY,
+  PROP_PAYLOAD_SIZE,
+  PROP_MAX_DELAY,
+  PROP_AUTO_LATENCY,
   /*< private > */
   PROP_LAST
 };
@@ -73,6 +79,19 @@ gst_srt_base_sink_get_property (GObject * object,
     case PROP_LATENCY:
       g_value_set_int (value, self->latency);
       break;
+    case PROP_PAYLOAD_SIZE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->payload_size);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_DELAY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->max_delay);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_AUTO_LATENCY:
+      g_value_set_boolean (value, self->auto_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -93,6 +112,19 @@ gst_srt_base_sink_set_property (GObject * object,
     case PROP_LATENCY:
       self->latency = g_value_get_int (value);
       break;
+    case PROP_PAYLOAD_SIZE:
+      GST_OBJECT_LOCK (self);
+      self->payload_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_DELAY:
+      GST_OBJECT_LOCK (self);
+      self->max_delay = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_AUTO_LATENCY:
+      self->auto_latency = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -105,17 +137,77 @@ gst_srt_base_sink_finalize (GObject * object)
   GstSRTBaseSink *self = GST_SRT_BASE_SINK (object);
 
   g_clear_pointer (&self->uri, gst_uri_unref);
+  g_object_unref (self->adapter);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static gboolean
+gst_srt_base_sink_send (GstSRTBaseSink * self, GstBuffer * buffer)
+{
+  GstSRTBaseSinkClass *bclass = GST_SRT_BASE_SINK_GET_CLASS (self);
+  GstMapInfo info;
+  gboolean ret;
+
+  if (bclass->queue_buffer)
+    return bclass->queue_buffer (self, buffer);
+
+  if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, READ,
+        ("Could not map the input stream"), (NULL));
+    return FALSE;
+  }
+
+  ret = bclass->send_buffer (self, &info);
+
+  gst_buffer_unmap (buffer, &info);
+
+  return ret;
+}
+
+/* Sends the aggregated data in payload_size chunks. The rest is sent as
+ * well once it waited for max_delay, or if @drain is set */
+static GstFlowReturn
+gst_srt_base_sink_send_pending (GstSRTBaseSink * self, gboolean drain)
+{
+  guint payload_size;
+  GstClockTime max_delay, now;
+  GstBuffer *buffer;
+  gsize avail;
+  gboolean ret = TRUE;
+
+  GST_OBJECT_LOCK (self);
+  payload_size = self->payload_size;
+  max_delay = self->max_delay;
+  GST_OBJECT_UNLOCK (self);
+
+  now = gst_util_get_timestamp ();
+
+  while (payload_size > 0 && ret
+      && gst_adapter_available (self->adapter) >= payload_size) {
+    buffer = gst_adapter_take_buffer (self->adapter, payload_size);
+    ret = gst_srt_base_sink_send (self, buffer);
+    gst_buffer_unref (buffer);
+    /* what is left came with the latest buffers */
+    self->pending_since = now;
+  }
+
+  avail = gst_adapter_available (self->adapter);
+  if (ret && avail > 0 && (drain || payload_size == 0
+          || now - self->pending_since >= max_delay)) {
+    buffer = gst_adapter_take_buffer (self->adapter, avail);
+    ret = gst_srt_base_sink_send (self, buffer);
+    gst_buffer_unref (buffer);
+  }
+
+  return ret ? GST_FLOW_OK : GST_FLOW_ERROR;
+}
+
 static GstFlowReturn
 gst_srt_base_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstSRTBaseSink *self = GST_SRT_BASE_SINK (sink);
-  GstMapInfo info;
-  GstSRTBaseSinkClass *bclass = GST_SRT_BASE_SINK_GET_CLASS (sink);
-  GstFlowReturn ret = GST_FLOW_OK;
+  guint payload_size;
 
   GST_TRACE_OBJECT (self, "sending buffer %p, offset %"
       G_GINT64_FORMAT ", offset_end %" G_GINT64_FORMAT
@@ -127,16 +219,51 @@ gst_srt_base_sink_render (GstBaseSink * sink, GstBuffer * buffer)
       GST_TIME_ARGS (GST_BUFFER_DURATION (buffer)),
       gst_buffer_get_size (buffer));
 
-  if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
-    GST_ELEMENT_ERROR (self, RESOURCE, READ,
-        ("Could not map the input stream"), (NULL));
-    return GST_FLOW_ERROR;
+  GST_OBJECT_LOCK (self);
+  payload_size = self->payload_size;
+  GST_OBJECT_UNLOCK (self);
+
+  if (payload_size == 0 && gst_adapter_available (self->adapter) == 0)
+    return gst_srt_base_sink_send (self, buffer) ? GST_FLOW_OK :
+        GST_FLOW_ERROR;
+
+  if (gst_adapter_available (self->adapter) == 0)
+    self->pending_since = gst_util_get_timestamp ();
+  gst_adapter_push (self->adapter, gst_buffer_ref (buffer));
+
+  return gst_srt_base_sink_send_pending (self, FALSE);
+}
+
+static gboolean
+gst_srt_base_sink_event (GstBaseSink * sink, GstEvent * event)
+{
+  GstSRTBaseSink *self = GST_SRT_BASE_SINK (sink);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+      gst_srt_base_sink_send_pending (self, TRUE);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_adapter_clear (self->adapter);
+      break;
+    default:
+      break;
   }
 
-  if (!bclass->send_buffer (self, &info))
-    ret = GST_FLOW_ERROR;
+  return GST_BASE_SINK_CLASS (parent_class)->event (sink, event);
+}
 
-  gst_buffer_unmap (buffer, &info);
+static GstStateChangeReturn
+gst_srt_base_sink_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstSRTBaseSink *self = GST_SRT_BASE_SINK (element);
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    gst_adapter_clear (self->adapter);
 
   return ret;
 }
@@ -145,6 +272,7 @@ static void
 gst_srt_base_sink_class_init (GstSRTBaseSinkClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
   GstBaseSinkClass *gstbasesink_class = GST_BASE_SINK_CLASS (klass);
 
   gobject_class->set_property = gst_srt_base_sink_set_property;
@@ -166,9 +294,49 @@ gst_srt_base_sink_class_init (GstSRTBaseSinkClass * klass)
       G_MAXINT32, SRT_DEFAULT_LATENCY,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSRTBaseSink:payload-size:
+   *
+   * Small buffers, like the 188 byte packets of mpegtsmux, are aggregated
+   * and sent in payloads of this size.
+   */
+  properties[PROP_PAYLOAD_SIZE] =
+      g_param_spec_uint ("payload-size", "Payload Size",
+      "Aggregate the data into payloads of this size (0 = send buffers as is)",
+      0, G_MAXUINT, SRT_DEFAULT_PAYLOAD_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstSRTBaseSink:max-delay:
+   *
+   * How long data may wait for a payload to be completed. This is checked
+   * as new data arrives, and everything still waiting is sent at EOS.
+   */
+  properties[PROP_MAX_DELAY] =
+      g_param_spec_uint64 ("max-delay", "Max Delay",
+      "Maximum time to wait for a payload to be filled (nanoseconds)",
+      0, G_MAXUINT64, SRT_DEFAULT_MAX_DELAY,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstSRTBaseSink:auto-latency:
+   *
+   * Raise the latency of the following connections to four times the RTT
+   * measured on the last one that closed. The latency property stays the
+   * lower bound.
+   */
+  properties[PROP_AUTO_LATENCY] =
+      g_param_spec_boolean ("auto-latency", "Auto Latency",
+      "Adjust the latency of new connections to the measured RTT",
+      SRT_DEFAULT_AUTO_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, properties);
 
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_srt_base_sink_change_state);
+
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_srt_base_sink_render);
+  gstbasesink_class->event = GST_DEBUG_FUNCPTR (gst_srt_base_sink_event);
 }
 
 static void
@@ -177,6 +345,10 @@ gst_srt_base_sink_init (GstSRTBaseSink * self)
   self->uri = gst_uri_from_string (SRT_DEFAULT_URI);
   self->queued_buffers = NULL;
   self->latency = SRT_DEFAULT_LATENCY;
+  self->auto_latency = SRT_DEFAULT_AUTO_LATENCY;
+  self->payload_size = SRT_DEFAULT_PAYLOAD_SIZE;
+  self->max_delay = SRT_DEFAULT_MAX_DELAY;
+  self->adapter = gst_adapter_new ();
 }
 
 static GstURIType
@@ -284,7 +456,7 @@ gst_srt_base_sink_get_stats (GSocketAddress * sockaddr, SRTSOCKET sock)
         /* number of too-late-to-send dropped packets */
         "packets-sent-dropped", G_TYPE_INT, stats.pktSndDrop,
         /* sending rate in Mb/s */
-        "send-rate-mbps", G_TYPE_DOUBLE, stats.msRTT,
+        "send-rate-mbps", G_TYPE_DOUBLE, stats.mbpsSendRate,
         /* estimated bandwidth, in Mb/s */
         "bandwidth-mbps", G_TYPE_DOUBLE, stats.mbpsBandwidth,
         /* busy sending time (i.e., idle time exclusive) */
@@ -300,3 +472,25 @@ gst_srt_base_sink_get_stats (GSocketAddress * sockaddr, SRTSOCKET sock)
 
   return s;
 }
+
+/* The latency to configure on new connections */
+gint
+gst_srt_base_sink_get_latency (GstSRTBaseSink * self)
+{
+  if (self->auto_latency)
+    return MAX (self->latency, self->tuned_latency);
+
+  return self->latency;
+}
+
+/* Called with the connection of @sock before it is closed */
+void
+gst_srt_base_sink_tune_latency (GstSRTBaseSink * self, SRTSOCKET sock)
+{
+  if (!self->auto_latency)
+    return;
+
+  self->tuned_latency = gst_srt_get_tuned_latency (sock, self->latency);
+  GST_INFO_OBJECT (self, "using a latency of %d ms for new connections",
+      self->tuned_latency);
+}
@@ -23,6 +23,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
+#include <gst/base/gstadapter.h>
 #include <gio/gio.h>
 
 #include <srt/srt.h>
@@ -47,6 +48,14 @@ struct _GstSRTBaseSink {
   GstUri *uri;
   GList *queued_buffers;
   gint latency;
+  gboolean auto_latency;
+  gint tuned_latency;
+
+  /* payload aggregation */
+  guint payload_size;
+  GstClockTime max_delay;
+  GstAdapter *adapter;
+  GstClockTime pending_since;
 
   /*< private >*/
   gpointer _gst_reserved[GST_PADDING];
@@ -58,7 +67,11 @@ struct _GstSRTBaseSinkClass {
   /* ask the subclass to send a buffer */
   gboolean (*send_buffer)       (GstSRTBaseSink *self, const GstMapInfo *mapinfo);
 
-  gpointer _gst_reserved[GST_PADDING_LARGE];
+  /* optional: hand a buffer to the subclass, which may keep a reference
+   * instead of sending it right away. Used instead of send_buffer */
+  gboolean (*queue_buffer)      (GstSRTBaseSink *self, GstBuffer *buffer);
+
+  gpointer _gst_reserved[GST_PADDING_LARGE - 1];
 };
 
 GST_EXPORT
@@ -67,6 +80,9 @@ GType gst_srt_base_sink_get_type (void);
 GstStructure * gst_srt_base_sink_get_stats (GSocketAddress *sockaddr,
     SRTSOCKET sock);
 
+gint gst_srt_base_sink_get_latency (GstSRTBaseSink *self);
+void gst_srt_base_sink_tune_latency (GstSRTBaseSink *self, SRTSOCKET sock);
+
 
 G_END_DECLS
 
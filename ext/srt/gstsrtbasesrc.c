@@ -29,6 +29,8 @@
 
 #include <netinet/in.h>
 
+#define SRT_DEFAULT_BUFFER_LIST_SIZE 32
+
 #define GST_CAT_DEFAULT gst_debug_srt_base_src
 GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
 
@@ -37,6 +39,8 @@ enum
   PROP_URI = 1,
   PROP_CAPS,
   PROP_LATENCY,
+  PROP_AUTO_LATENCY,
+  PROP_BUFFER_LIST_SIZE,
 
   /*< private > */
   PROP_LAST
@@ -78,6 +82,14 @@ gst_srt_base_src_get_property (GObject * object,
     case PROP_LATENCY:
       g_value_set_int (value, self->latency);
       break;
+    case PROP_AUTO_LATENCY:
+      g_value_set_boolean (value, self->auto_latency);
+      break;
+    case PROP_BUFFER_LIST_SIZE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->buffer_list_size);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -104,6 +116,14 @@ gst_srt_base_src_set_property (GObject * object,
     case PROP_LATENCY:
       self->latency = g_value_get_int (value);
       break;
+    case PROP_AUTO_LATENCY:
+      self->auto_latency = g_value_get_boolean (value);
+      break;
+    case PROP_BUFFER_LIST_SIZE:
+      GST_OBJECT_LOCK (self);
+      self->buffer_list_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -147,12 +167,118 @@ gst_srt_base_src_get_caps (GstBaseSrc * src, GstCaps * filter)
   return result;
 }
 
+static GstFlowReturn
+gst_srt_base_src_alloc_and_fill (GstSRTBaseSrc * self, GstBuffer ** buffer)
+{
+  GstBaseSrc *bsrc = GST_BASE_SRC (self);
+  GstFlowReturn ret;
+
+  ret = GST_BASE_SRC_GET_CLASS (self)->alloc (bsrc, -1,
+      gst_base_src_get_blocksize (bsrc), buffer);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  ret = GST_PUSH_SRC_GET_CLASS (self)->fill (GST_PUSH_SRC (self), *buffer);
+  if (ret != GST_FLOW_OK)
+    gst_buffer_replace (buffer, NULL);
+
+  return ret;
+}
+
+/* Receives the messages that are ready without blocking, so they can be
+ * pushed together with the first one */
+static GstBufferList *
+gst_srt_base_src_read_ready (GstSRTBaseSrc * self, SRTSOCKET sock,
+    GstBuffer * first, guint max)
+{
+  GstBaseSrc *bsrc = GST_BASE_SRC (self);
+  GstBufferList *list = NULL;
+
+  srt_setsockopt (sock, 0, SRTO_RCVSYN, &(int) {
+      0}, sizeof (int));
+
+  while (!list || gst_buffer_list_length (list) < max) {
+    GstBuffer *buffer = NULL;
+    GstMapInfo info;
+    gint recv_len;
+
+    if (GST_BASE_SRC_GET_CLASS (self)->alloc (bsrc, -1,
+            gst_base_src_get_blocksize (bsrc), &buffer) != GST_FLOW_OK)
+      break;
+
+    if (!gst_buffer_map (buffer, &info, GST_MAP_WRITE)) {
+      gst_buffer_unref (buffer);
+      break;
+    }
+    recv_len = srt_recvmsg (sock, (char *) info.data, info.size);
+    gst_buffer_unmap (buffer, &info);
+
+    if (recv_len <= 0) {
+      /* Nothing ready or an error, which fill will see again */
+      srt_clearlasterror ();
+      gst_buffer_unref (buffer);
+      break;
+    }
+
+    gst_buffer_resize (buffer, 0, recv_len);
+    GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS (first);
+
+    if (!list) {
+      list = gst_buffer_list_new_sized (max);
+      gst_buffer_list_add (list, first);
+    }
+    gst_buffer_list_add (list, buffer);
+  }
+
+  srt_setsockopt (sock, 0, SRTO_RCVSYN, &(int) {
+      1}, sizeof (int));
+
+  return list;
+}
+
+static GstFlowReturn
+gst_srt_base_src_create (GstPushSrc * src, GstBuffer ** outbuf)
+{
+  GstSRTBaseSrc *self = GST_SRT_BASE_SRC (src);
+  GstSRTBaseSrcClass *klass = GST_SRT_BASE_SRC_GET_CLASS (self);
+  SRTSOCKET sock = SRT_INVALID_SOCK;
+  GstBufferList *list = NULL;
+  GstBuffer *buffer = NULL;
+  GstFlowReturn ret;
+  guint max;
+
+  ret = gst_srt_base_src_alloc_and_fill (self, &buffer);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  GST_OBJECT_LOCK (self);
+  max = self->buffer_list_size;
+  GST_OBJECT_UNLOCK (self);
+
+  if (max > 1 && gst_buffer_get_size (buffer) > 0 && klass->get_socket)
+    sock = klass->get_socket (self);
+  if (sock != SRT_INVALID_SOCK)
+    list = gst_srt_base_src_read_ready (self, sock, buffer, max);
+
+  if (!list) {
+    *outbuf = buffer;
+    return GST_FLOW_OK;
+  }
+
+  GST_LOG_OBJECT (self, "pushing %u messages as a buffer list",
+      gst_buffer_list_length (list));
+  gst_base_src_submit_buffer_list (GST_BASE_SRC (self), list);
+  *outbuf = NULL;
+
+  return GST_FLOW_OK;
+}
 
 static void
 gst_srt_base_src_class_init (GstSRTBaseSrcClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstBaseSrcClass *gstbasesrc_class = GST_BASE_SRC_CLASS (klass);
+  GstPushSrcClass *gstpushsrc_class = GST_PUSH_SRC_CLASS (klass);
 
   gobject_class->set_property = gst_srt_base_src_set_property;
   gobject_class->get_property = gst_srt_base_src_get_property;
@@ -182,9 +308,35 @@ gst_srt_base_src_class_init (GstSRTBaseSrcClass * klass)
       G_MAXINT32, SRT_DEFAULT_LATENCY,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSRTBaseSrc:auto-latency:
+   *
+   * Raise the latency of the following connections to four times the RTT
+   * measured on the last one that closed. The latency property stays the
+   * lower bound.
+   */
+  properties[PROP_AUTO_LATENCY] =
+      g_param_spec_boolean ("auto-latency", "Auto Latency",
+      "Adjust the latency of new connections to the measured RTT",
+      SRT_DEFAULT_AUTO_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstSRTBaseSrc:buffer-list-size:
+   *
+   * Messages that were already received when a buffer is produced are
+   * pushed along with it in a buffer list of up to this many buffers.
+   */
+  properties[PROP_BUFFER_LIST_SIZE] =
+      g_param_spec_uint ("buffer-list-size", "Buffer List Size",
+      "Maximum number of received messages to push at once (1 = no lists)",
+      1, G_MAXUINT, SRT_DEFAULT_BUFFER_LIST_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, properties);
 
   gstbasesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_srt_base_src_get_caps);
+
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_srt_base_src_create);
 }
 
 static void
@@ -194,6 +346,8 @@ gst_srt_base_src_init (GstSRTBaseSrc * self)
   gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
   gst_base_src_set_live (GST_BASE_SRC (self), TRUE);
   self->latency = SRT_DEFAULT_LATENCY;
+  self->auto_latency = SRT_DEFAULT_AUTO_LATENCY;
+  self->buffer_list_size = SRT_DEFAULT_BUFFER_LIST_SIZE;
 }
 
 static GstURIType
@@ -260,3 +414,25 @@ gst_srt_base_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
   iface->get_uri = gst_srt_base_src_uri_get_uri;
   iface->set_uri = gst_srt_base_src_uri_set_uri;
 }
+
+/* The latency to configure on new connections */
+gint
+gst_srt_base_src_get_latency (GstSRTBaseSrc * self)
+{
+  if (self->auto_latency)
+    return MAX (self->latency, self->tuned_latency);
+
+  return self->latency;
+}
+
+/* Called with the connection of @sock before it is closed */
+void
+gst_srt_base_src_tune_latency (GstSRTBaseSrc * self, SRTSOCKET sock)
+{
+  if (!self->auto_latency)
+    return;
+
+  self->tuned_latency = gst_srt_get_tuned_latency (sock, self->latency);
+  GST_INFO_OBJECT (self, "using a latency of %d ms for new connections",
+      self->tuned_latency);
+}
@@ -24,6 +24,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstpushsrc.h>
 
+#include <srt/srt.h>
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_SRT_BASE_SRC              (gst_srt_base_src_get_type ())
@@ -44,6 +46,9 @@ struct _GstSRTBaseSrc {
   GstUri *uri;
   GstCaps *caps;
   gint latency;
+  gboolean auto_latency;
+  gint tuned_latency;
+  guint buffer_list_size;
 
   /*< private >*/
   gpointer _gst_reserved[GST_PADDING];
@@ -52,12 +57,18 @@ struct _GstSRTBaseSrc {
 struct _GstSRTBaseSrcClass {
   GstPushSrcClass parent_class;
 
-  gpointer _gst_reserved[GST_PADDING_LARGE];
+  /* the connected socket more messages can be read from, if any */
+  SRTSOCKET (*get_socket)       (GstSRTBaseSrc *self);
+
+  gpointer _gst_reserved[GST_PADDING_LARGE - 1];
 };
 
 GST_EXPORT
 GType gst_srt_base_src_get_type (void);
 
+gint gst_srt_base_src_get_latency (GstSRTBaseSrc *self);
+void gst_srt_base_src_tune_latency (GstSRTBaseSrc *self, SRTSOCKET sock);
+
 G_END_DECLS
 
 #endif /* __GST_SRT_BASE_SRC_H__ */
@@ -159,7 +159,8 @@ gst_srt_client_sink_start (GstBaseSink * sink)
 
   priv->sock = gst_srt_client_connect (GST_ELEMENT (sink), FALSE,
       gst_uri_get_host (uri), gst_uri_get_port (uri), priv->rendez_vous,
-      priv->bind_address, priv->bind_port, base->latency,
+      priv->bind_address, priv->bind_port,
+      gst_srt_base_sink_get_latency (base),
       &priv->sockaddr, &priv->poll_id);
 
   g_clear_pointer (&uri, gst_uri_unref);
@@ -192,6 +193,8 @@ gst_srt_client_sink_stop (GstBaseSink * sink)
 
   GST_DEBUG_OBJECT (self, "closing SRT connection");
 
+  gst_srt_base_sink_tune_latency (GST_SRT_BASE_SINK (self), priv->sock);
+
   if (priv->poll_id != SRT_ERROR) {
     srt_epoll_remove_usock (priv->poll_id, priv->sock);
     srt_epoll_release (priv->poll_id);
@@ -242,8 +242,8 @@ gst_srt_client_src_start (GstBaseSrc * src)
 
   priv->sock = gst_srt_client_connect (GST_ELEMENT (src), FALSE,
       gst_uri_get_host (uri), gst_uri_get_port (uri), priv->rendez_vous,
-      priv->bind_address, priv->bind_port, base->latency,
-      &socket_address, &priv->poll_id);
+      priv->bind_address, priv->bind_port,
+      gst_srt_base_src_get_latency (base), &socket_address, &priv->poll_id);
 
   g_clear_object (&socket_address);
   g_clear_pointer (&uri, gst_uri_unref);
@@ -265,13 +265,23 @@ gst_srt_client_src_stop (GstBaseSrc * src)
   priv->poll_id = SRT_ERROR;
 
   GST_DEBUG_OBJECT (self, "closing SRT connection");
-  if (priv->sock != SRT_INVALID_SOCK)
+  if (priv->sock != SRT_INVALID_SOCK) {
+    gst_srt_base_src_tune_latency (GST_SRT_BASE_SRC (self), priv->sock);
     srt_close (priv->sock);
+  }
   priv->sock = SRT_INVALID_SOCK;
 
   return TRUE;
 }
 
+static SRTSOCKET
+gst_srt_client_src_get_socket (GstSRTBaseSrc * src)
+{
+  GstSRTClientSrcPrivate *priv = GST_SRT_CLIENT_SRC_GET_PRIVATE (src);
+
+  return priv->sock;
+}
+
 static void
 gst_srt_client_src_class_init (GstSRTClientSrcClass * klass)
 {
@@ -279,6 +289,7 @@ gst_srt_client_src_class_init (GstSRTClientSrcClass * klass)
   GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
   GstBaseSrcClass *gstbasesrc_class = GST_BASE_SRC_CLASS (klass);
   GstPushSrcClass *gstpushsrc_class = GST_PUSH_SRC_CLASS (klass);
+  GstSRTBaseSrcClass *gstsrtbasesrc_class = GST_SRT_BASE_SRC_CLASS (klass);
 
   gobject_class->set_property = gst_srt_client_src_set_property;
   gobject_class->get_property = gst_srt_client_src_get_property;
@@ -323,6 +334,9 @@ gst_srt_client_src_class_init (GstSRTClientSrcClass * klass)
   gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_srt_client_src_stop);
 
   gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_srt_client_src_fill);
+
+  gstsrtbasesrc_class->get_socket =
+      GST_DEBUG_FUNCPTR (gst_srt_client_src_get_socket);
 }
 
 static void
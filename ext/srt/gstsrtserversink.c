@@ -45,6 +45,11 @@
 #include <gio/gio.h>
 
 #define SRT_DEFAULT_POLL_TIMEOUT -1
+#define SRT_DEFAULT_MAX_CLIENT_BACKLOG (4 * 1024 * 1024)
+
+/* How often the send thread checks whether it is stopped, in ms */
+#define SRT_SEND_POLL_TIMEOUT 100
+#define SRT_SEND_POLL_SOCKETS 64
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -68,6 +73,13 @@ struct _GstSRTServerSinkPrivate
   GThread *thread;
 
   GList *clients;
+  guint max_client_backlog;
+
+  /* Clients with queued buffers are polled for writing by the send thread,
+   * so that the streaming thread never waits for a slow client */
+  gint send_poll_id;
+  GThread *send_thread;
+  gboolean send_stopped;
 };
 
 #define GST_SRT_SERVER_SINK_GET_PRIVATE(obj)  \
@@ -77,6 +89,7 @@ enum
 {
   PROP_POLL_TIMEOUT = 1,
   PROP_STATS,
+  PROP_MAX_CLIENT_BACKLOG,
   /*< private > */
   PROP_LAST
 };
@@ -103,6 +116,12 @@ typedef struct
 {
   int sock;
   GSocketAddress *sockaddr;
+
+  /* Buffers not sent yet, shared with the other clients */
+  GQueue queue;
+  gsize queued_bytes;
+  /* the send poll the socket is in, or -1 */
+  gint poll_id;
 } SRTClient;
 
 static SRTClient *
@@ -110,6 +129,8 @@ srt_client_new (void)
 {
   SRTClient *client = g_new0 (SRTClient, 1);
   client->sock = SRT_INVALID_SOCK;
+  g_queue_init (&client->queue);
+  client->poll_id = -1;
   return client;
 }
 
@@ -119,6 +140,11 @@ srt_client_free (SRTClient * client)
   g_return_if_fail (client != NULL);
 
   g_clear_object (&client->sockaddr);
+  g_queue_foreach (&client->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&client->queue);
+
+  if (client->poll_id != -1)
+    srt_epoll_remove_usock (client->poll_id, client->sock);
 
   if (client->sock != SRT_INVALID_SOCK) {
     srt_close (client->sock);
@@ -127,6 +153,19 @@ srt_client_free (SRTClient * client)
   g_free (client);
 }
 
+static SRTClient *
+srt_client_find (GList * clients, SRTSOCKET sock)
+{
+  for (; clients; clients = clients->next) {
+    SRTClient *client = clients->data;
+
+    if (client->sock == sock)
+      return client;
+  }
+
+  return NULL;
+}
+
 static void
 srt_emit_client_removed (SRTClient * client, gpointer user_data)
 {
@@ -157,14 +196,24 @@ gst_srt_server_sink_get_property (GObject * object,
         SRTClient *client = item->data;
         GValue tmp = G_VALUE_INIT;
 
+        GstStructure *s;
+
+        s = gst_srt_base_sink_get_stats (client->sockaddr, client->sock);
+        gst_structure_set (s,
+            "queued-bytes", G_TYPE_UINT64, (guint64) client->queued_bytes,
+            "queued-buffers", G_TYPE_UINT, client->queue.length, NULL);
         g_value_init (&tmp, GST_TYPE_STRUCTURE);
-        g_value_take_boxed (&tmp, gst_srt_base_sink_get_stats (client->sockaddr,
-                client->sock));
+        g_value_take_boxed (&tmp, s);
         gst_value_array_append_and_take_value (value, &tmp);
       }
       GST_OBJECT_UNLOCK (self);
       break;
     }
+    case PROP_MAX_CLIENT_BACKLOG:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, priv->max_client_backlog);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -182,6 +231,11 @@ gst_srt_server_sink_set_property (GObject * object,
     case PROP_POLL_TIMEOUT:
       priv->poll_timeout = g_value_get_int (value);
       break;
+    case PROP_MAX_CLIENT_BACKLOG:
+      GST_OBJECT_LOCK (self);
+      priv->max_client_backlog = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -256,6 +310,118 @@ thread_func (gpointer data)
   return NULL;
 }
 
+static void
+gst_srt_server_sink_remove_client (GstSRTServerSink * self,
+    SRTClient * client)
+{
+  GstSRTBaseSink *base = GST_SRT_BASE_SINK (self);
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+
+  if (base->auto_latency) {
+    int lat;
+
+    /* Accepted sockets take the latency of the listening one */
+    GST_OBJECT_LOCK (self);
+    gst_srt_base_sink_tune_latency (base, client->sock);
+    lat = gst_srt_base_sink_get_latency (base);
+    GST_OBJECT_UNLOCK (self);
+    srt_setsockopt (priv->sock, 0, SRTO_TSBPDDELAY, &lat, sizeof (int));
+  }
+
+  g_signal_emit (self, signals[SIG_CLIENT_REMOVED], 0, client->sock,
+      client->sockaddr);
+  srt_client_free (client);
+}
+
+/* Sends the queued buffers of the client until its send buffer is full.
+ * Called with the object lock, returns FALSE if the client failed and was
+ * removed from the list */
+static gboolean
+gst_srt_server_sink_send_queued (GstSRTServerSink * self, SRTClient * client)
+{
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+  GstBuffer *buffer;
+
+  while ((buffer = g_queue_peek_head (&client->queue))) {
+    GstMapInfo info;
+    int ret;
+
+    if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
+      GST_WARNING_OBJECT (self, "failed to map queued buffer");
+      ret = 0;
+    } else {
+      ret = srt_sendmsg2 (client->sock, (char *) info.data, info.size, 0);
+      gst_buffer_unmap (buffer, &info);
+    }
+
+    if (ret == SRT_ERROR) {
+      if (srt_getlasterror (NULL) == SRT_EASYNCSND) {
+        /* Wait until the client is writable again */
+        srt_clearlasterror ();
+        return TRUE;
+      }
+
+      GST_WARNING_OBJECT (self, "%s", srt_getlasterror_str ());
+      srt_clearlasterror ();
+      priv->clients = g_list_remove (priv->clients, client);
+      return FALSE;
+    }
+
+    g_queue_pop_head (&client->queue);
+    client->queued_bytes -= gst_buffer_get_size (buffer);
+    gst_buffer_unref (buffer);
+  }
+
+  if (client->poll_id != -1) {
+    srt_epoll_remove_usock (client->poll_id, client->sock);
+    client->poll_id = -1;
+  }
+
+  return TRUE;
+}
+
+static gpointer
+send_thread_func (gpointer data)
+{
+  GstSRTServerSink *self = GST_SRT_SERVER_SINK (data);
+  GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
+  SRTSOCKET ready[SRT_SEND_POLL_SOCKETS];
+
+  while (!g_atomic_int_get (&priv->send_stopped)) {
+    int n_ready = G_N_ELEMENTS (ready);
+    int i;
+
+    if (srt_epoll_wait (priv->send_poll_id, NULL, 0, ready, &n_ready,
+            SRT_SEND_POLL_TIMEOUT, 0, 0, 0, 0) == -1) {
+      int srt_errno = srt_getlasterror (NULL);
+
+      srt_clearlasterror ();
+      if (srt_errno != SRT_ETIMEOUT) {
+        GST_WARNING_OBJECT (self, "failed to poll clients (reason: %d)",
+            srt_errno);
+        g_usleep (SRT_SEND_POLL_TIMEOUT * 1000);
+      }
+      continue;
+    }
+
+    for (i = 0; i < MIN (n_ready, G_N_ELEMENTS (ready)); i++) {
+      SRTClient *client;
+      gboolean ok = TRUE;
+
+      GST_OBJECT_LOCK (self);
+      client = srt_client_find (priv->clients, ready[i]);
+      if (client)
+        ok = gst_srt_server_sink_send_queued (self, client);
+      GST_OBJECT_UNLOCK (self);
+
+      if (!ok)
+        gst_srt_server_sink_remove_client (self, client);
+    }
+  }
+
+  return NULL;
+}
+
 static gboolean
 gst_srt_server_sink_start (GstBaseSink * sink)
 {
@@ -269,7 +435,7 @@ gst_srt_server_sink_start (GstBaseSink * sink)
   struct sockaddr sa;
   size_t sa_len;
   const gchar *host;
-  int lat = base->latency;
+  int lat = gst_srt_base_sink_get_latency (base);
 
   if (gst_uri_get_port (uri) == GST_URI_NO_PORT) {
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, NULL, (("Invalid port")));
@@ -343,6 +509,23 @@ gst_srt_server_sink_start (GstBaseSink * sink)
     goto failed;
   }
 
+  priv->send_poll_id = srt_epoll_create ();
+  if (priv->send_poll_id == -1) {
+    GST_WARNING_OBJECT (self,
+        "failed to create poll id for SRT clients (reason: %s)",
+        srt_getlasterror_str ());
+    goto failed;
+  }
+
+  priv->send_stopped = FALSE;
+  priv->send_thread = g_thread_try_new ("srtserversink-send",
+      send_thread_func, self, &error);
+  if (error != NULL) {
+    GST_WARNING_OBJECT (self, "failed to create send thread (reason: %s)",
+        error->message);
+    goto failed;
+  }
+
   priv->context = g_main_context_new ();
 
   priv->server_source = g_idle_source_new ();
@@ -366,6 +549,11 @@ gst_srt_server_sink_start (GstBaseSink * sink)
   return ret;
 
 failed:
+  if (priv->send_poll_id != SRT_ERROR) {
+    srt_epoll_release (priv->send_poll_id);
+    priv->send_poll_id = SRT_ERROR;
+  }
+
   if (priv->poll_id != SRT_ERROR) {
     srt_epoll_release (priv->poll_id);
     priv->poll_id = SRT_ERROR;
@@ -383,33 +571,47 @@ failed:
   return FALSE;
 }
 
+/* Queues a reference to the buffer for every client and leaves the sending
+ * to the send thread. Clients that fall behind by more than
+ * max-client-backlog bytes are dropped */
 static gboolean
-gst_srt_server_sink_send_buffer (GstSRTBaseSink * sink,
-    const GstMapInfo * mapinfo)
+gst_srt_server_sink_queue_buffer (GstSRTBaseSink * sink, GstBuffer * buffer)
 {
   GstSRTServerSink *self = GST_SRT_SERVER_SINK (sink);
   GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
-  GList *clients = priv->clients;
+  gsize size = gst_buffer_get_size (buffer);
+  GList *clients, *dropped = NULL;
 
   GST_OBJECT_LOCK (sink);
+  clients = priv->clients;
   while (clients != NULL) {
     SRTClient *client = clients->data;
     clients = clients->next;
 
-    if (srt_sendmsg2 (client->sock, (char *) mapinfo->data, mapinfo->size,
-            0) == SRT_ERROR) {
-      GST_WARNING_OBJECT (self, "%s", srt_getlasterror_str ());
-
+    if (priv->max_client_backlog > 0 && client->queue.length > 0
+        && client->queued_bytes + size > priv->max_client_backlog) {
+      GST_WARNING_OBJECT (self, "client %d is %" G_GSIZE_FORMAT " bytes "
+          "behind, dropping it", client->sock, client->queued_bytes);
       priv->clients = g_list_remove (priv->clients, client);
-      GST_OBJECT_UNLOCK (sink);
-      g_signal_emit (self, signals[SIG_CLIENT_REMOVED], 0, client->sock,
-          client->sockaddr);
-      srt_client_free (client);
-      GST_OBJECT_LOCK (sink);
+      dropped = g_list_prepend (dropped, client);
+      continue;
+    }
+
+    g_queue_push_tail (&client->queue, gst_buffer_ref (buffer));
+    client->queued_bytes += size;
+
+    if (client->poll_id == -1) {
+      client->poll_id = priv->send_poll_id;
+      srt_epoll_add_usock (client->poll_id, client->sock, &(int) {
+          SRT_EPOLL_OUT | SRT_EPOLL_ERR});
     }
   }
   GST_OBJECT_UNLOCK (sink);
 
+  for (clients = dropped; clients; clients = clients->next)
+    gst_srt_server_sink_remove_client (self, clients->data);
+  g_list_free (dropped);
+
   return TRUE;
 }
 
@@ -421,6 +623,12 @@ gst_srt_server_sink_stop (GstBaseSink * sink)
   gboolean ret = TRUE;
   GList *clients;
 
+  if (priv->send_thread) {
+    g_atomic_int_set (&priv->send_stopped, TRUE);
+    g_thread_join (priv->send_thread);
+    priv->send_thread = NULL;
+  }
+
   GST_DEBUG_OBJECT (self, "closing client sockets");
 
   GST_OBJECT_LOCK (sink);
@@ -431,6 +639,11 @@ gst_srt_server_sink_stop (GstBaseSink * sink)
   g_list_foreach (clients, (GFunc) srt_emit_client_removed, self);
   g_list_free_full (clients, (GDestroyNotify) srt_client_free);
 
+  if (priv->send_poll_id != SRT_ERROR) {
+    srt_epoll_release (priv->send_poll_id);
+    priv->send_poll_id = SRT_ERROR;
+  }
+
   GST_DEBUG_OBJECT (self, "closing SRT connection");
   srt_epoll_remove_usock (priv->poll_id, priv->sock);
   srt_epoll_release (priv->poll_id);
@@ -499,6 +712,18 @@ gst_srt_server_sink_class_init (GstSRTServerSinkClass * klass)
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS),
       G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSRTServerSink:max-client-backlog:
+   *
+   * The number of queued bytes after which a client that does not keep up
+   * is disconnected, so it cannot hold back the other clients.
+   */
+  properties[PROP_MAX_CLIENT_BACKLOG] =
+      g_param_spec_uint ("max-client-backlog", "Max Client Backlog",
+      "Disconnect clients with more queued bytes than this (0 = unlimited)",
+      0, G_MAXUINT, SRT_DEFAULT_MAX_CLIENT_BACKLOG,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, properties);
 
   /**
@@ -543,8 +768,8 @@ gst_srt_server_sink_class_init (GstSRTServerSinkClass * klass)
   gstbasesink_class->unlock_stop =
       GST_DEBUG_FUNCPTR (gst_srt_server_sink_unlock_stop);
 
-  gstsrtbasesink_class->send_buffer =
-      GST_DEBUG_FUNCPTR (gst_srt_server_sink_send_buffer);
+  gstsrtbasesink_class->queue_buffer =
+      GST_DEBUG_FUNCPTR (gst_srt_server_sink_queue_buffer);
 }
 
 static void
@@ -552,4 +777,7 @@ gst_srt_server_sink_init (GstSRTServerSink * self)
 {
   GstSRTServerSinkPrivate *priv = GST_SRT_SERVER_SINK_GET_PRIVATE (self);
   priv->poll_timeout = SRT_DEFAULT_POLL_TIMEOUT;
+  priv->max_client_backlog = SRT_DEFAULT_MAX_CLIENT_BACKLOG;
+  priv->poll_id = SRT_ERROR;
+  priv->send_poll_id = SRT_ERROR;
 }
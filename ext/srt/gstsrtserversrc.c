@@ -154,6 +154,7 @@ gst_srt_server_src_fill (GstPushSrc * src, GstBuffer * outbuf)
 {
   GstSRTServerSrc *self = GST_SRT_SERVER_SRC (src);
   GstSRTServerSrcPrivate *priv = GST_SRT_SERVER_SRC_GET_PRIVATE (self);
+  GstSRTBaseSrc *base = GST_SRT_BASE_SRC (src);
   GstFlowReturn ret = GST_FLOW_OK;
   GstMapInfo info;
   SRTSOCKET ready[2];
@@ -228,6 +229,15 @@ gst_srt_server_src_fill (GstPushSrc * src, GstBuffer * outbuf)
     g_signal_emit (self, signals[SIG_CLIENT_CLOSED], 0,
         priv->client_sock, priv->client_sockaddr);
 
+    /* Only the connections accepted from now on get the new latency */
+    if (base->auto_latency) {
+      int lat;
+
+      gst_srt_base_src_tune_latency (base, priv->client_sock);
+      lat = gst_srt_base_src_get_latency (base);
+      srt_setsockopt (priv->sock, 0, SRTO_TSBPDDELAY, &lat, sizeof (int));
+    }
+
     srt_close (priv->client_sock);
     priv->client_sock = SRT_INVALID_SOCK;
     g_clear_object (&priv->client_sockaddr);
@@ -271,7 +281,7 @@ gst_srt_server_src_start (GstBaseSrc * src)
   size_t sa_len;
   GSocketAddress *socket_address;
   const gchar *host;
-  int lat = base->latency;
+  int lat = gst_srt_base_src_get_latency (base);
 
   if (gst_uri_get_port (uri) == GST_URI_NO_PORT) {
     GST_ELEMENT_ERROR (src, RESOURCE, OPEN_WRITE, NULL, (("Invalid port")));
@@ -421,6 +431,14 @@ gst_srt_server_src_unlock_stop (GstBaseSrc * src)
   return TRUE;
 }
 
+static SRTSOCKET
+gst_srt_server_src_get_socket (GstSRTBaseSrc * src)
+{
+  GstSRTServerSrcPrivate *priv = GST_SRT_SERVER_SRC_GET_PRIVATE (src);
+
+  return priv->has_client ? priv->client_sock : SRT_INVALID_SOCK;
+}
+
 static void
 gst_srt_server_src_class_init (GstSRTServerSrcClass * klass)
 {
@@ -428,6 +446,7 @@ gst_srt_server_src_class_init (GstSRTServerSrcClass * klass)
   GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
   GstBaseSrcClass *gstbasesrc_class = GST_BASE_SRC_CLASS (klass);
   GstPushSrcClass *gstpushsrc_class = GST_PUSH_SRC_CLASS (klass);
+  GstSRTBaseSrcClass *gstsrtbasesrc_class = GST_SRT_BASE_SRC_CLASS (klass);
 
   gobject_class->set_property = gst_srt_server_src_set_property;
   gobject_class->get_property = gst_srt_server_src_get_property;
@@ -490,6 +509,9 @@ gst_srt_server_src_class_init (GstSRTServerSrcClass * klass)
       GST_DEBUG_FUNCPTR (gst_srt_server_src_unlock_stop);
 
   gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_srt_server_src_fill);
+
+  gstsrtbasesrc_class->get_socket =
+      GST_DEBUG_FUNCPTR (gst_srt_server_src_get_socket);
 }
 
 static void
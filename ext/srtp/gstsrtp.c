@@ -192,6 +192,16 @@ set_crypto_policy_cipher_auth (GstSrtpCipherType cipher,
       policy->cipher_type = AES_ICM;
       policy->cipher_key_len = 46;
       break;
+#ifdef HAVE_SRTP_GCM
+    case GST_SRTP_CIPHER_AES_128_GCM:
+      policy->cipher_type = AES_128_GCM;
+      policy->cipher_key_len = 28;
+      break;
+    case GST_SRTP_CIPHER_AES_256_GCM:
+      policy->cipher_type = AES_256_GCM;
+      policy->cipher_key_len = 44;
+      break;
+#endif
     case GST_SRTP_CIPHER_NULL:
       policy->cipher_type = NULL_CIPHER;
       policy->cipher_key_len = 0;
@@ -218,7 +228,13 @@ set_crypto_policy_cipher_auth (GstSrtpCipherType cipher,
       break;
   }
 
-  if (cipher == GST_SRTP_CIPHER_NULL && auth == GST_SRTP_AUTH_NULL)
+  /* GCM authenticates the packets itself, with a 16 bytes tag */
+  if (cipher_is_aead (cipher)) {
+    policy->auth_type = NULL_AUTH;
+    policy->auth_key_len = 0;
+    policy->auth_tag_len = 16;
+    policy->sec_serv = sec_serv_conf_and_auth;
+  } else if (cipher == GST_SRTP_CIPHER_NULL && auth == GST_SRTP_AUTH_NULL)
     policy->sec_serv = sec_serv_none;
   else if (cipher == GST_SRTP_CIPHER_NULL)
     policy->sec_serv = sec_serv_auth;
@@ -240,6 +256,12 @@ cipher_key_size (GstSrtpCipherType cipher)
     case GST_SRTP_CIPHER_AES_256_ICM:
       size = 46;
       break;
+    case GST_SRTP_CIPHER_AES_128_GCM:
+      size = 28;
+      break;
+    case GST_SRTP_CIPHER_AES_256_GCM:
+      size = 44;
+      break;
     case GST_SRTP_CIPHER_NULL:
       size = 0;
       break;
@@ -250,6 +272,15 @@ cipher_key_size (GstSrtpCipherType cipher)
   return size;
 }
 
+/* Whether @cipher also authenticates, in which case the auth type is
+ * ignored */
+gboolean
+cipher_is_aead (GstSrtpCipherType cipher)
+{
+  return cipher == GST_SRTP_CIPHER_AES_128_GCM ||
+      cipher == GST_SRTP_CIPHER_AES_256_GCM;
+}
+
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
@@ -49,11 +49,18 @@
 
 #include <srtp/srtp.h>
 
+/* libsrtp only has the AES-GCM ciphers when built with OpenSSL */
+#ifdef AES_128_GCM
+#define HAVE_SRTP_GCM 1
+#endif
+
 typedef enum
 {
   GST_SRTP_CIPHER_NULL,
   GST_SRTP_CIPHER_AES_128_ICM,
-  GST_SRTP_CIPHER_AES_256_ICM
+  GST_SRTP_CIPHER_AES_256_ICM,
+  GST_SRTP_CIPHER_AES_128_GCM,
+  GST_SRTP_CIPHER_AES_256_GCM
 } GstSrtpCipherType;
 
 typedef enum
@@ -75,5 +82,6 @@ void set_crypto_policy_cipher_auth (GstSrtpCipherType cipher,
     GstSrtpAuthType auth, crypto_policy_t * policy);
 
 guint cipher_key_size (GstSrtpCipherType cipher);
+gboolean cipher_is_aead (GstSrtpCipherType cipher);
 
 #endif /* __GST_SRTP_H__ */
@@ -68,6 +68,7 @@
  * Encryption
  * - AES_ICM 256 bits (maximum security)
  * - AES_ICM 128 bits (default)
+ * - AES_GCM 128 and 256 bits, when libsrtp is built with OpenSSL
  * - NULL
  *
  * Authentication
@@ -210,6 +211,10 @@ static GstFlowReturn gst_srtp_dec_chain_rtp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
 static GstFlowReturn gst_srtp_dec_chain_rtcp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_srtp_dec_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
+static GstFlowReturn gst_srtp_dec_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
 
 static GstStateChangeReturn gst_srtp_dec_change_state (GstElement * element,
     GstStateChange transition);
@@ -373,6 +378,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtp));
   gst_pad_set_chain_function (filter->rtp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtp));
+  gst_pad_set_chain_list_function (filter->rtp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtp));
 
   filter->rtp_srcpad =
       gst_pad_new_from_static_template (&rtp_src_template, "rtp_src");
@@ -396,6 +403,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (filter->rtcp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtcp));
+  gst_pad_set_chain_list_function (filter->rtcp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtcp));
 
   filter->rtcp_srcpad =
       gst_pad_new_from_static_template (&rtcp_src_template, "rtcp_src");
@@ -556,7 +565,16 @@ get_stream_from_caps (GstSrtpDec * filter, GstCaps * caps, guint32 ssrc)
     goto error;
   }
 
-  if (stream->rtcp_cipher != NULL_CIPHER && stream->rtcp_auth == NULL_AUTH) {
+#ifndef HAVE_SRTP_GCM
+  if (cipher_is_aead (stream->rtp_cipher) ||
+      cipher_is_aead (stream->rtcp_cipher)) {
+    GST_WARNING_OBJECT (filter, "AES-GCM is not supported by libsrtp");
+    goto error;
+  }
+#endif
+
+  if (stream->rtcp_cipher != NULL_CIPHER && stream->rtcp_auth == NULL_AUTH &&
+      !cipher_is_aead (stream->rtcp_cipher)) {
     GST_WARNING_OBJECT (filter,
         "Cannot have SRTP NULL authentication with a not-NULL encryption"
         " cipher.");
@@ -1135,9 +1153,10 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
  * This function should be called while holding the filter lock
  */
 static gboolean
-gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
-    gboolean is_rtcp, guint32 ssrc)
+gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad,
+    GstBuffer ** bufp, gboolean is_rtcp, guint32 ssrc)
 {
+  GstBuffer *buf;
   GstMapInfo map;
   err_status_t err;
   gint size;
@@ -1146,8 +1165,8 @@ gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
       " with SSRC = %u", is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (buf),
       ssrc);
 
-  /* Change buffer to remove protection */
-  buf = gst_buffer_make_writable (buf);
+  /* Change buffer to remove protection, in place when possible */
+  buf = *bufp = gst_buffer_make_writable (*bufp);
 
   gst_buffer_map (buf, &map, GST_MAP_READWRITE);
   size = map.size;
@@ -1237,21 +1256,20 @@ unprotect:
   return TRUE;
 }
 
-static GstFlowReturn
-gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
-    gboolean is_rtcp)
+/* Takes ownership of @buf and returns the unprotected buffer, or NULL if it
+ * was dropped. @is_rtcp is updated when RTCP is received on the RTP pad */
+static GstBuffer *
+gst_srtp_dec_process_buffer (GstSrtpDec * filter, GstPad * pad,
+    GstBuffer * buf, gboolean * is_rtcp)
 {
-  GstSrtpDec *filter = GST_SRTP_DEC (parent);
-  GstPad *otherpad;
   GstSrtpDecSsrcStream *stream = NULL;
-  GstFlowReturn ret = GST_FLOW_OK;
   guint32 ssrc = 0;
 
   GST_OBJECT_LOCK (filter);
 
   /* Check if this stream exists, if not create a new stream */
 
-  if (!(stream = validate_buffer (filter, buf, &ssrc, &is_rtcp))) {
+  if (!(stream = validate_buffer (filter, buf, &ssrc, is_rtcp))) {
     GST_OBJECT_UNLOCK (filter);
     GST_WARNING_OBJECT (filter, "Invalid buffer, dropping");
     goto drop_buffer;
@@ -1259,10 +1277,10 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
   if (!STREAM_HAS_CRYPTO (stream)) {
     GST_OBJECT_UNLOCK (filter);
-    goto push_out;
+    return buf;
   }
 
-  if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, ssrc)) {
+  if (!gst_srtp_dec_decode_buffer (filter, pad, &buf, *is_rtcp, ssrc)) {
     GST_OBJECT_UNLOCK (filter);
     goto drop_buffer;
   }
@@ -1273,29 +1291,99 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
   if (gst_srtp_get_soft_limit_reached ())
     request_key_with_signal (filter, ssrc, SIGNAL_SOFT_LIMIT);
 
-push_out:
-  /* Push buffer to source pad */
+  return buf;
+
+drop_buffer:
+  gst_buffer_unref (buf);
+
+  return NULL;
+}
+
+static GstPad *
+gst_srtp_dec_get_push_pad (GstSrtpDec * filter, gboolean is_rtcp)
+{
   if (is_rtcp) {
-    otherpad = filter->rtcp_srcpad;
     if (!filter->rtcp_has_segment)
       gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
           filter->rtp_srcpad, TRUE);
+    return filter->rtcp_srcpad;
   } else {
-    otherpad = filter->rtp_srcpad;
     if (!filter->rtp_has_segment)
       gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
           filter->rtcp_srcpad, FALSE);
+    return filter->rtp_srcpad;
   }
-  ret = gst_pad_push (otherpad, buf);
+}
 
-  return ret;
+static GstFlowReturn
+gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
+    gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
 
-drop_buffer:
-  /* Drop buffer, except if gst_pad_push returned OK or an error */
+  /* Dropped buffers are not an error */
+  if (!(buf = gst_srtp_dec_process_buffer (filter, pad, buf, &is_rtcp)))
+    return GST_FLOW_OK;
 
-  gst_buffer_unref (buf);
+  /* Push buffer to source pad */
+  return gst_pad_push (gst_srtp_dec_get_push_pad (filter, is_rtcp), buf);
+}
 
-  return ret;
+typedef struct
+{
+  GstSrtpDec *filter;
+  GstPad *pad;
+  gboolean is_rtcp;
+  GstFlowReturn ret;
+} ProcessBufferItData;
+
+static gboolean
+process_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
+{
+  ProcessBufferItData *data = user_data;
+  gboolean is_rtcp = data->is_rtcp;
+
+  *buffer = gst_srtp_dec_process_buffer (data->filter, data->pad, *buffer,
+      &is_rtcp);
+
+  /* RTCP muxed with the RTP packets goes out on its own pad */
+  if (*buffer && is_rtcp != data->is_rtcp) {
+    data->ret = gst_pad_push (gst_srtp_dec_get_push_pad (data->filter,
+            is_rtcp), *buffer);
+    *buffer = NULL;
+  }
+
+  return data->ret == GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  ProcessBufferItData process_data;
+
+  GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
+      gst_buffer_list_length (buf_list));
+
+  /* The list owns the only reference to its buffers, so that they can be
+   * unprotected in place */
+  buf_list = gst_buffer_list_make_writable (buf_list);
+
+  process_data.filter = filter;
+  process_data.pad = pad;
+  process_data.is_rtcp = is_rtcp;
+  process_data.ret = GST_FLOW_OK;
+
+  gst_buffer_list_foreach (buf_list, process_buffer_it, &process_data);
+
+  if (process_data.ret != GST_FLOW_OK || !gst_buffer_list_length (buf_list)) {
+    gst_buffer_list_unref (buf_list);
+    return process_data.ret;
+  }
+
+  return gst_pad_push_list (gst_srtp_dec_get_push_pad (filter, is_rtcp),
+      buf_list);
 }
 
 static GstFlowReturn
@@ -1310,6 +1398,20 @@ gst_srtp_dec_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_dec_chain (pad, parent, buf, TRUE);
 }
 
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, TRUE);
+}
+
 static GstStateChangeReturn
 gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
 {
@@ -70,6 +70,7 @@
  * Encryption (properties rtp-cipher and rtcp-cipher)
  * - AES_ICM 256 bits (maximum security)
  * - AES_ICM 128 bits (default)
+ * - AES_GCM 128 and 256 bits, when libsrtp is built with OpenSSL
  * - NULL
  *
  * Authentication (properties rtp-auth and rtcp-auth)
@@ -78,7 +79,13 @@
  * - NULL
  *
  * Note that for SRTP protection, authentication is mandatory (non-null)
- * if encryption is used (non-null).
+ * if encryption is used (non-null). The AES_GCM ciphers authenticate the
+ * packets themselves and ignore the authentication properties, and are
+ * the fastest choice on CPUs with AES instructions. Their master keys are
+ * 28 and 44 bytes long (12 bytes of salt).
+ *
+ * Buffers that are writable and were allocated with enough padding at the
+ * end are protected in place, other buffers are copied first.
  *
  * When requested to create a sink pad, a linked source pad is created.
  * Each packet received is first analysed (checked for valid SSRC) then
@@ -168,8 +175,8 @@ typedef struct ProcessBufferItData
 {
   GstSrtpEnc *filter;
   GstPad *pad;
-  GstBufferList *out_list;
   gboolean is_rtcp;
+  err_status_t err;
 } ProcessBufferItData;
 
 /* the capabilities of the inputs and outputs.
@@ -382,6 +389,18 @@ gst_srtp_enc_create_session (GstSrtpEnc * filter)
 
   memset (&policy, 0, sizeof (srtp_policy_t));
 
+#ifndef HAVE_SRTP_GCM
+  if (cipher_is_aead (filter->rtp_cipher) ||
+      cipher_is_aead (filter->rtcp_cipher)) {
+    GST_OBJECT_UNLOCK (filter);
+    GST_ELEMENT_ERROR (filter, LIBRARY, SETTINGS,
+        ("AES-GCM is not supported"),
+        ("libsrtp was built without the AES-GCM ciphers"));
+    GST_OBJECT_LOCK (filter);
+    return err_status_fail;
+  }
+#endif
+
   if (HAS_CRYPTO (filter)) {
     guint expected;
     gsize keysize;
@@ -1018,64 +1037,108 @@ gst_srtp_enc_check_set_caps (GstSrtpEnc * filter, GstPad * pad,
   return GST_FLOW_OK;
 }
 
-static GstBuffer *
-gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
-    GstBuffer * buf, gboolean is_rtcp)
+static gboolean
+buffer_has_tailroom (GstBuffer * buf, gsize needed)
 {
-  gint size_max, size;
-  GstBuffer *bufout = NULL;
-  GstMapInfo mapout;
-  err_status_t err;
+  GstMemory *mem;
+  gsize size, offset, maxsize;
 
-  /* Create a bigger buffer to add protection */
-  size = gst_buffer_get_size (buf);
-  size_max = size + SRTP_MAX_TRAILER_LEN + 10;
-  bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
+  if (!gst_buffer_is_writable (buf) || gst_buffer_n_memory (buf) != 1)
+    return FALSE;
 
-  gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  mem = gst_buffer_peek_memory (buf, 0);
+  if (!gst_memory_is_writable (mem))
+    return FALSE;
 
-  gst_buffer_extract (buf, 0, mapout.data, size);
+  size = gst_memory_get_sizes (mem, &offset, &maxsize);
 
-  GST_OBJECT_LOCK (filter);
+  return maxsize - offset - size >= needed;
+}
 
-  gst_srtp_init_event_reporter ();
+/*
+ * This function should be called while holding the filter lock. It takes
+ * ownership of @buf, which is protected in place when it is writable and
+ * was allocated with room for the trailer, and copied otherwise.
+ */
+static GstBuffer *
+gst_srtp_enc_protect_buffer (GstSrtpEnc * filter, GstBuffer * buf,
+    gboolean is_rtcp, err_status_t * err)
+{
+  GstBuffer *bufout;
+  GstMapInfo mapout;
+  gint size;
+
+  size = gst_buffer_get_size (buf);
+
+  if (buffer_has_tailroom (buf, SRTP_MAX_TRAILER_LEN)) {
+    bufout = buf;
+    gst_buffer_set_size (bufout, size + SRTP_MAX_TRAILER_LEN);
+    gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  } else {
+    /* Create a bigger buffer to add protection */
+    bufout = gst_buffer_new_allocate (NULL,
+        size + SRTP_MAX_TRAILER_LEN + 10, NULL);
+    gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+    gst_buffer_extract (buf, 0, mapout.data, size);
+    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+    gst_buffer_unref (buf);
+  }
 
   if (is_rtcp)
-    err = srtp_protect_rtcp (filter->session, mapout.data, &size);
+    *err = srtp_protect_rtcp (filter->session, mapout.data, &size);
   else
-    err = srtp_protect (filter->session, mapout.data, &size);
-
-  GST_OBJECT_UNLOCK (filter);
+    *err = srtp_protect (filter->session, mapout.data, &size);
 
   gst_buffer_unmap (bufout, &mapout);
 
-  if (err == err_status_ok) {
-    /* Buffer protected */
-    gst_buffer_set_size (bufout, size);
-    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+  if (*err != err_status_ok) {
+    gst_buffer_unref (bufout);
+    return NULL;
+  }
 
-    GST_LOG_OBJECT (pad, "Encoding %s buffer of size %d",
-        is_rtcp ? "RTCP" : "RTP", size);
+  /* Buffer protected */
+  gst_buffer_set_size (bufout, size);
 
-  } else if (err == err_status_key_expired) {
+  return bufout;
+}
 
+static void
+gst_srtp_enc_post_protect_error (GstSrtpEnc * filter, err_status_t err)
+{
+  if (err == err_status_key_expired) {
     GST_ELEMENT_ERROR (GST_ELEMENT_CAST (filter), STREAM, ENCODE,
         ("Key usage limit has been reached"),
         ("Unable to protect buffer (hard key usage limit reached)"));
-    goto fail;
-
   } else {
     /* srtp_protect failed */
     GST_ELEMENT_ERROR (filter, LIBRARY, FAILED, (NULL),
         ("Unable to protect buffer (protect failed) code %d", err));
-    goto fail;
   }
+}
 
-  return bufout;
+static GstBuffer *
+gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
+    GstBuffer * buf, gboolean is_rtcp)
+{
+  GstBuffer *bufout;
+  err_status_t err;
 
-fail:
-  gst_buffer_unref (bufout);
-  return NULL;
+  GST_OBJECT_LOCK (filter);
+
+  gst_srtp_init_event_reporter ();
+  bufout = gst_srtp_enc_protect_buffer (filter, buf, is_rtcp, &err);
+
+  GST_OBJECT_UNLOCK (filter);
+
+  if (!bufout) {
+    gst_srtp_enc_post_protect_error (filter, err);
+    return NULL;
+  }
+
+  GST_LOG_OBJECT (pad, "Encoding %s buffer of size %" G_GSIZE_FORMAT,
+      is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (bufout));
+
+  return bufout;
 }
 
 static GstFlowReturn
@@ -1101,7 +1164,10 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
   GST_OBJECT_UNLOCK (filter);
 
-  if ((bufout = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp))) {
+  bufout = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp);
+  buf = NULL;
+
+  if (bufout) {
     /* Push buffer to source pad */
     otherpad = get_rtp_other_pad (pad);
     ret = gst_pad_push (otherpad, bufout);
@@ -1127,7 +1193,8 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 out:
 
-  gst_buffer_unref (buf);
+  if (buf)
+    gst_buffer_unref (buf);
 
   return ret;
 
@@ -1136,18 +1203,21 @@ fail:
   goto out;
 }
 
+/* Called with the filter lock held, protects the buffers of the list in
+ * place */
 static gboolean
 process_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
 {
   ProcessBufferItData *data = user_data;
-  GstBuffer *bufout;
+  err_status_t err;
 
-  if ((bufout =
-          gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
-              data->is_rtcp))) {
-    gst_buffer_list_add (data->out_list, bufout);
-  } else {
+  *buffer = gst_srtp_enc_protect_buffer (data->filter, *buffer,
+      data->is_rtcp, &err);
+
+  if (!*buffer) {
     GST_WARNING_OBJECT (data->filter, "Error encoding buffer, dropping");
+    if (data->err == err_status_ok)
+      data->err = err;
   }
 
   return TRUE;
@@ -1160,7 +1230,6 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   GstSrtpEnc *filter = GST_SRTP_ENC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
-  GstBufferList *out_list = NULL;
   ProcessBufferItData process_data;
 
   GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
@@ -1182,17 +1251,24 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
 
   GST_OBJECT_UNLOCK (filter);
 
-  out_list = gst_buffer_list_new ();
+  buf_list = gst_buffer_list_make_writable (buf_list);
 
   process_data.filter = filter;
   process_data.pad = pad;
   process_data.is_rtcp = is_rtcp;
-  process_data.out_list = out_list;
+  process_data.err = err_status_ok;
 
+  /* The whole list is protected in one go, without releasing the lock
+   * between the packets */
+  GST_OBJECT_LOCK (filter);
+  gst_srtp_init_event_reporter ();
   gst_buffer_list_foreach (buf_list, process_buffer_it, &process_data);
+  GST_OBJECT_UNLOCK (filter);
+
+  if (process_data.err != err_status_ok)
+    gst_srtp_enc_post_protect_error (filter, process_data.err);
 
-  if (!gst_buffer_list_length (out_list)) {
-    gst_buffer_list_unref (out_list);
+  if (!gst_buffer_list_length (buf_list)) {
     ret = GST_FLOW_OK;
     goto out;
   }
@@ -1201,7 +1277,8 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   otherpad = get_rtp_other_pad (pad);
   GST_LOG_OBJECT (pad, "Pushing buffer chain of %d",
       gst_buffer_list_length (buf_list));
-  ret = gst_pad_push_list (otherpad, out_list);
+  ret = gst_pad_push_list (otherpad, buf_list);
+  buf_list = NULL;
 
   if (ret != GST_FLOW_OK) {
     goto out;
@@ -1221,7 +1298,8 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
 
 out:
 
-  gst_buffer_list_unref (buf_list);
+  if (buf_list)
+    gst_buffer_list_unref (buf_list);
 
   return ret;
 }
@@ -1279,7 +1357,8 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
         }
       }
       if ((filter->rtcp_cipher != NULL_CIPHER)
-          && (filter->rtcp_auth == NULL_AUTH)) {
+          && (filter->rtcp_auth == NULL_AUTH)
+          && !cipher_is_aead (filter->rtcp_cipher)) {
         GST_ERROR_OBJECT (filter,
             "RTCP authentication can't be NULL if encryption is not NULL.");
         return GST_STATE_CHANGE_FAILURE;
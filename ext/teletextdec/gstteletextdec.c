@@ -278,6 +278,7 @@ gst_teletextdec_init (GstTeletextDec * teletext)
 
   teletext->export_func = NULL;
   teletext->buf_pool = NULL;
+  teletext->rgba_cache = NULL;
 }
 
 static void
@@ -288,6 +289,7 @@ gst_teletextdec_finalize (GObject * object)
   g_mutex_clear (&teletext->queue_lock);
 
   g_free (teletext->frame);
+  g_free (teletext->rgba_cache);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -340,6 +342,9 @@ gst_teletextdec_zvbi_clear (GstTeletextDec * teletext)
   teletext->pageno = 0x100;
   teletext->subno = -1;
   teletext->last_ts = 0;
+
+  g_free (teletext->rgba_cache);
+  teletext->rgba_cache = NULL;
 }
 
 static void
@@ -679,6 +684,8 @@ gst_teletextdec_negotiate_caps (GstTeletextDec * teletext, guint width,
   if (!g_strcmp0 (caps_name, "video/x-raw")) {
     teletext->width = width;
     teletext->height = height;
+    g_free (teletext->rgba_cache);
+    teletext->rgba_cache = NULL;
     teletext->export_func = gst_teletextdec_export_rgba_page;
     gst_structure_set (caps_struct,
         "width", G_TYPE_INT, width,
@@ -887,6 +894,64 @@ gst_teletextdec_export_text_page (GstTeletextDec * teletext, vbi_page * page,
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_teletextdec_row_changed (GstTeletextDec * teletext, vbi_page * page,
+    gint row)
+{
+  const vbi_char *text = page->text + row * page->columns;
+  gint i;
+
+  /* the DRCS glyphs may change without the characters referring to them */
+  for (i = 0; i < page->columns; i++) {
+    if (vbi_is_drcs (text[i].unicode))
+      return TRUE;
+  }
+
+  return memcmp (text, teletext->last_text + row * page->columns,
+      page->columns * sizeof (vbi_char)) != 0;
+}
+
+/* Updates the RGBA image of the last page for the given page, drawing only
+ * the rows whose characters or attributes changed. Subtitle pages in
+ * particular often only change a row or two, and most rows are empty. */
+static void
+gst_teletextdec_draw_rgba_page (GstTeletextDec * teletext, vbi_page * page)
+{
+  const gint rowstride = COLUMNS_TO_WIDTH (page->columns) * sizeof (vbi_rgba);
+  gint row, n_changed = 0;
+
+  if (teletext->rgba_cache == NULL ||
+      teletext->last_rows != page->rows ||
+      teletext->last_columns != page->columns ||
+      memcmp (teletext->last_color_map, page->color_map,
+          sizeof (teletext->last_color_map)) != 0) {
+    g_free (teletext->rgba_cache);
+    teletext->rgba_cache = g_malloc (teletext->width * teletext->height *
+        sizeof (vbi_rgba));
+    vbi_draw_vt_page (page, VBI_PIXFMT_RGBA32_LE, teletext->rgba_cache,
+        FALSE, TRUE);
+    n_changed = page->rows;
+  } else {
+    for (row = 0; row < page->rows; row++) {
+      if (gst_teletextdec_row_changed (teletext, page, row)) {
+        vbi_draw_vt_page_region (page, VBI_PIXFMT_RGBA32_LE,
+            teletext->rgba_cache + ROWS_TO_HEIGHT (row) * rowstride,
+            rowstride, 0, row, page->columns, 1, FALSE, TRUE);
+        n_changed++;
+      }
+    }
+  }
+
+  GST_LOG_OBJECT (teletext, "Drew %d of %d rows", n_changed, page->rows);
+
+  memcpy (teletext->last_text, page->text,
+      page->rows * page->columns * sizeof (vbi_char));
+  memcpy (teletext->last_color_map, page->color_map,
+      sizeof (teletext->last_color_map));
+  teletext->last_rows = page->rows;
+  teletext->last_columns = page->columns;
+}
+
 static GstFlowReturn
 gst_teletextdec_export_rgba_page (GstTeletextDec * teletext, vbi_page * page,
     GstBuffer ** buf)
@@ -915,7 +980,8 @@ gst_teletextdec_export_rgba_page (GstTeletextDec * teletext, vbi_page * page,
     return GST_FLOW_ERROR;
   }
 
-  vbi_draw_vt_page (page, VBI_PIXFMT_RGBA32_LE, buf_map.data, FALSE, TRUE);
+  gst_teletextdec_draw_rgba_page (teletext, page);
+  memcpy (buf_map.data, teletext->rgba_cache, size);
   gst_buffer_unmap (lbuf, &buf_map);
   *buf = lbuf;
 
@@ -80,6 +80,14 @@ struct _GstTeletextDec
 
   /* buffer pool received from the peer pad - used in RGBA output only. */
   GstBufferPool *buf_pool;
+
+  /* last page drawn in RGBA mode, only the rows that changed since are
+   * drawn again. */
+  guint8 *rgba_cache;
+  vbi_char last_text[1056]; /* as vbi_page.text */
+  vbi_rgba last_color_map[40];
+  gint last_rows;
+  gint last_columns;
 };
 
 struct _GstTeletextFrame
@@ -278,10 +278,14 @@ gst_ttml_render_finalize (GObject * object)
 {
   GstTtmlRender *render = GST_TTML_RENDER (object);
 
-  if (render->compositions) {
-    g_list_free_full (render->compositions,
-        (GDestroyNotify) gst_video_overlay_composition_unref);
-    render->compositions = NULL;
+  if (render->composition) {
+    gst_video_overlay_composition_unref (render->composition);
+    render->composition = NULL;
+  }
+
+  if (render->region_cache) {
+    g_hash_table_unref (render->region_cache);
+    render->region_cache = NULL;
   }
 
   if (render->text_buffer) {
@@ -353,7 +357,9 @@ gst_ttml_render_init (GstTtmlRender * render, GstTtmlRenderClass * klass)
   render->text_buffer = NULL;
   render->text_linked = FALSE;
 
-  render->compositions = NULL;
+  render->attach_compo_to_buffer = FALSE;
+  render->composition = NULL;
+  render->region_cache = NULL;
   render->layout =
       pango_layout_new (GST_TTML_RENDER_GET_CLASS (render)->pango_context);
 
@@ -462,6 +468,8 @@ gst_ttml_render_negotiate (GstTtmlRender * render, GstCaps * caps)
   if (!ret) {
     GST_DEBUG_OBJECT (render, "negotiation failed, schedule reconfigure");
     gst_pad_mark_reconfigure (render->srcpad);
+  } else {
+    render->attach_compo_to_buffer = attach;
   }
 
   gst_caps_unref (caps);
@@ -791,10 +799,9 @@ static GstFlowReturn
 gst_ttml_render_push_frame (GstTtmlRender * render, GstBuffer * video_frame)
 {
   GstVideoFrame frame;
-  GList *compositions = render->compositions;
 
-  if (compositions == NULL) {
-    GST_CAT_DEBUG (ttmlrender_debug, "No compositions.");
+  if (render->composition == NULL) {
+    GST_CAT_DEBUG (ttmlrender_debug, "No composition.");
     goto done;
   }
 
@@ -811,15 +818,20 @@ gst_ttml_render_push_frame (GstTtmlRender * render, GstBuffer * video_frame)
 
   video_frame = gst_buffer_make_writable (video_frame);
 
+  /* the same composition is attached to all the frames showing the same
+   * subtitles, so downstream can tell they didn't change */
+  if (render->attach_compo_to_buffer) {
+    GST_CAT_LOG (ttmlrender_debug, "Attaching composition.");
+    gst_buffer_add_video_overlay_composition_meta (video_frame,
+        render->composition);
+    goto done;
+  }
+
   if (!gst_video_frame_map (&frame, &render->info, video_frame,
           GST_MAP_READWRITE))
     goto invalid_frame;
 
-  while (compositions) {
-    GstVideoOverlayComposition *composition = compositions->data;
-    gst_video_overlay_composition_blend (composition, &frame);
-    compositions = compositions->next;
-  }
+  gst_video_overlay_composition_blend (render->composition, &frame);
 
   gst_video_frame_unmap (&frame);
 
@@ -986,8 +998,14 @@ gst_ttml_render_video_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
       gst_event_parse_caps (event, &caps);
       ret = gst_ttml_render_setcaps (render, caps);
-      if (render->width != prev_width || render->height != prev_height)
+      if (render->width != prev_width || render->height != prev_height) {
         render->need_render = TRUE;
+        /* the regions are rendered relative to the video size */
+        if (render->region_cache) {
+          g_hash_table_unref (render->region_cache);
+          render->region_cache = NULL;
+        }
+      }
       gst_event_unref (event);
       break;
     }
@@ -2752,6 +2770,150 @@ gst_ttml_render_render_text_region (GstTtmlRender * render,
 }
 
 
+static void
+gst_ttml_render_append_style_key (GString * key,
+    const GstSubtitleStyleSet * s)
+{
+  /* %a prints the doubles exactly */
+  g_string_append_printf (key, "%d|%s|%a|%a|%d|%02x%02x%02x%02x|"
+      "%02x%02x%02x%02x|%d|%d|%d|%d|%d|%d|%a|%a|%a|%a|%a|%d|%a|%a|%a|%a|"
+      "%d|%d|%d;", s->text_direction, GST_STR_NULL (s->font_family),
+      s->font_size, s->line_height, s->text_align, s->color.r, s->color.g,
+      s->color.b, s->color.a, s->background_color.r, s->background_color.g,
+      s->background_color.b, s->background_color.a, s->font_style,
+      s->font_weight, s->text_decoration, s->unicode_bidi, s->wrap_option,
+      s->multi_row_align, s->line_padding, s->origin_x, s->origin_y,
+      s->extent_w, s->extent_h, s->display_align, s->padding_start,
+      s->padding_end, s->padding_before, s->padding_after, s->writing_mode,
+      s->show_background, s->overflow);
+}
+
+/* Returns a string identifying everything the rendering of @region depends on
+ * apart from the video size: its styles and its text. */
+static gchar *
+gst_ttml_render_region_cache_key (GstSubtitleRegion * region,
+    GstBuffer * text_buf)
+{
+  GString *key = g_string_new (NULL);
+  guint i, j;
+
+  gst_ttml_render_append_style_key (key, region->style_set);
+
+  for (i = 0; i < gst_subtitle_region_get_block_count (region); ++i) {
+    const GstSubtitleBlock *block = gst_subtitle_region_get_block (region, i);
+
+    g_string_append_c (key, 'B');
+    gst_ttml_render_append_style_key (key, block->style_set);
+
+    for (j = 0; j < gst_subtitle_block_get_element_count (block); ++j) {
+      const GstSubtitleElement *element =
+          gst_subtitle_block_get_element (block, j);
+      gchar *text =
+          gst_ttml_render_get_text_from_buffer (text_buf, element->text_index);
+
+      g_string_append_c (key, 'E');
+      gst_ttml_render_append_style_key (key, element->style_set);
+      /* prefixed with its length, so the text can't be mistaken for styles */
+      g_string_append_printf (key, "%d|%" G_GSIZE_FORMAT ":%s",
+          element->suppress_whitespace, text ? strlen (text) : 0,
+          GST_STR_NULL (text));
+      g_free (text);
+    }
+  }
+
+  return g_string_free (key, FALSE);
+}
+
+/* Renders the regions of the current text buffer into one composition. The
+ * regions that were also in the previous text buffer, with the same styles
+ * and text, are not rendered again, and if all of them are the same the
+ * previous composition itself is kept. */
+static void
+gst_ttml_render_update_composition (GstTtmlRender * render)
+{
+  GstSubtitleMeta *subtitle_meta;
+  GHashTable *cache;
+  GPtrArray *rectangles;
+  GstVideoOverlayComposition *composition = NULL;
+  gboolean changed;
+  guint i, j;
+
+  subtitle_meta = gst_buffer_get_subtitle_meta (render->text_buffer);
+  if (!subtitle_meta) {
+    GST_CAT_WARNING (ttmlrender_debug, "Failed to get subtitle meta.");
+    if (render->composition) {
+      gst_video_overlay_composition_unref (render->composition);
+      render->composition = NULL;
+    }
+    return;
+  }
+
+  cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_mini_object_unref);
+  rectangles = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gst_video_overlay_rectangle_unref);
+
+  for (i = 0; i < subtitle_meta->regions->len; ++i) {
+    GstSubtitleRegion *region = g_ptr_array_index (subtitle_meta->regions, i);
+    GstVideoOverlayComposition *region_composition = NULL;
+    gchar *key;
+
+    key = gst_ttml_render_region_cache_key (region, render->text_buffer);
+
+    if (render->region_cache)
+      region_composition = g_hash_table_lookup (render->region_cache, key);
+
+    if (region_composition) {
+      GST_CAT_LOG (ttmlrender_debug, "Region %u unchanged", i);
+      gst_video_overlay_composition_ref (region_composition);
+    } else {
+      region_composition = gst_ttml_render_render_text_region (render, region,
+          render->text_buffer);
+    }
+
+    if (region_composition) {
+      for (j = 0; j < gst_video_overlay_composition_n_rectangles
+          (region_composition); ++j)
+        g_ptr_array_add (rectangles,
+            gst_video_overlay_rectangle_ref
+            (gst_video_overlay_composition_get_rectangle (region_composition,
+                    j)));
+      g_hash_table_replace (cache, key, region_composition);
+    } else {
+      g_free (key);
+    }
+  }
+
+  changed = !render->composition || rectangles->len !=
+      gst_video_overlay_composition_n_rectangles (render->composition);
+  for (i = 0; !changed && i < rectangles->len; ++i)
+    changed = g_ptr_array_index (rectangles, i) !=
+        gst_video_overlay_composition_get_rectangle (render->composition, i);
+
+  if (changed) {
+    for (i = 0; i < rectangles->len; ++i) {
+      GstVideoOverlayRectangle *rectangle = g_ptr_array_index (rectangles, i);
+
+      if (!composition)
+        composition = gst_video_overlay_composition_new (rectangle);
+      else
+        gst_video_overlay_composition_add_rectangle (composition, rectangle);
+    }
+
+    if (render->composition)
+      gst_video_overlay_composition_unref (render->composition);
+    render->composition = composition;
+  } else {
+    GST_CAT_DEBUG (ttmlrender_debug, "Subtitles unchanged, keeping composition");
+  }
+
+  g_ptr_array_unref (rectangles);
+  if (render->region_cache)
+    g_hash_table_unref (render->region_cache);
+  render->region_cache = cache;
+}
+
+
 static GstFlowReturn
 gst_ttml_render_video_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer)
@@ -2892,31 +3054,7 @@ wait_for_text_buf:
       ret = gst_pad_push (render->srcpad, buffer);
     } else {
       if (render->need_render) {
-        GstSubtitleRegion *region = NULL;
-        GstSubtitleMeta *subtitle_meta = NULL;
-        guint i;
-
-        if (render->compositions) {
-          g_list_free_full (render->compositions,
-              (GDestroyNotify) gst_video_overlay_composition_unref);
-          render->compositions = NULL;
-        }
-
-        subtitle_meta = gst_buffer_get_subtitle_meta (render->text_buffer);
-        if (!subtitle_meta) {
-          GST_CAT_WARNING (ttmlrender_debug, "Failed to get subtitle meta.");
-        } else {
-          for (i = 0; i < subtitle_meta->regions->len; ++i) {
-            GstVideoOverlayComposition *composition;
-            region = g_ptr_array_index (subtitle_meta->regions, i);
-            composition = gst_ttml_render_render_text_region (render, region,
-                render->text_buffer);
-            if (composition) {
-              render->compositions = g_list_append (render->compositions,
-                  composition);
-            }
-          }
-        }
+        gst_ttml_render_update_composition (render);
         render->need_render = FALSE;
       }
 
@@ -90,9 +90,13 @@ struct _GstTtmlRender {
     gboolean                 wait_text;
 
     gboolean                 need_render;
+    gboolean                 attach_compo_to_buffer;
 
     PangoLayout             *layout;
-    GList * compositions;
+    /* all the regions of the current text buffer */
+    GstVideoOverlayComposition *composition;
+    /* the rendered regions of the current text buffer, by content */
+    GHashTable              *region_cache;
 };
 
 struct _GstTtmlRenderClass {
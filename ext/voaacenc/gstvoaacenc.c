@@ -46,11 +46,13 @@
 #define VOAAC_ENC_MPEGVERSION (4)
 #define VOAAC_ENC_CODECDATA_LEN (2)
 #define VOAAC_ENC_BITS_PER_SAMPLE (16)
+#define VOAAC_ENC_DEFAULT_FRAMES_PER_BUFFER (1)
 
 enum
 {
   PROP_0,
-  PROP_BITRATE
+  PROP_BITRATE,
+  PROP_FRAMES_PER_BUFFER
 };
 
 #define SAMPLE_RATES " 8000, " \
@@ -97,6 +99,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_voaacenc_debug);
 static gboolean voaacenc_core_init (GstVoAacEnc * voaacenc);
 static gboolean voaacenc_core_set_parameter (GstVoAacEnc * voaacenc);
 static void voaacenc_core_uninit (GstVoAacEnc * voaacenc);
+static void gst_voaacenc_clear_pool (GstVoAacEnc * voaacenc);
 
 static gboolean gst_voaacenc_start (GstAudioEncoder * enc);
 static gboolean gst_voaacenc_stop (GstAudioEncoder * enc);
@@ -117,6 +120,9 @@ gst_voaacenc_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE:
       self->bitrate = g_value_get_int (value);
       break;
+    case PROP_FRAMES_PER_BUFFER:
+      self->frames_per_buffer = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -134,6 +140,9 @@ gst_voaacenc_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE:
       g_value_set_int (value, self->bitrate);
       break;
+    case PROP_FRAMES_PER_BUFFER:
+      g_value_set_uint (value, self->frames_per_buffer);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -163,6 +172,14 @@ gst_voaacenc_class_init (GstVoAacEncClass * klass)
           0, 320000, VOAAC_ENC_DEFAULT_BITRATE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_FRAMES_PER_BUFFER,
+      g_param_spec_uint ("frames-per-buffer", "Frames per buffer",
+          "Number of AAC frames to encode from one input buffer, higher "
+          "values lower the per frame overhead", 1, 64,
+          VOAAC_ENC_DEFAULT_FRAMES_PER_BUFFER,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &sink_template);
   gst_element_class_add_static_pad_template (element_class, &src_template);
 
@@ -178,6 +195,7 @@ gst_voaacenc_init (GstVoAacEnc * voaacenc)
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_AUDIO_ENCODER_SINK_PAD (voaacenc));
   voaacenc->bitrate = VOAAC_ENC_DEFAULT_BITRATE;
   voaacenc->output_format = VOAAC_ENC_DEFAULT_OUTPUTFORMAT;
+  voaacenc->frames_per_buffer = VOAAC_ENC_DEFAULT_FRAMES_PER_BUFFER;
 
   /* init rest */
   voaacenc->handle = NULL;
@@ -206,10 +224,42 @@ gst_voaacenc_stop (GstAudioEncoder * enc)
 
   GST_DEBUG_OBJECT (enc, "stop");
   voaacenc_core_uninit (voaacenc);
+  gst_voaacenc_clear_pool (voaacenc);
 
   return TRUE;
 }
 
+static GstBufferPool *
+gst_voaacenc_create_pool (GstVoAacEnc * voaacenc, guint size)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+
+  if (!gst_buffer_pool_set_config (pool, config) ||
+      !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (voaacenc, "failed to set up buffer pool of size %u",
+        size);
+    gst_object_unref (pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+static void
+gst_voaacenc_clear_pool (GstVoAacEnc * voaacenc)
+{
+  if (voaacenc->pool) {
+    gst_buffer_pool_set_active (voaacenc->pool, FALSE);
+    gst_object_unref (voaacenc->pool);
+    voaacenc->pool = NULL;
+  }
+}
+
 #define VOAAC_ENC_MAX_CHANNELS 6
 /* describe the channels position */
 static const GstAudioChannelPosition
@@ -346,6 +396,10 @@ gst_voaacenc_set_format (GstAudioEncoder * benc, GstAudioInfo * info)
   /* precalc buffer size as it's constant now */
   voaacenc->inbuf_size = voaacenc->channels * 2 * 1024;
 
+  /* an encoded frame is never larger than the raw one */
+  gst_voaacenc_clear_pool (voaacenc);
+  voaacenc->pool = gst_voaacenc_create_pool (voaacenc, voaacenc->inbuf_size);
+
   gst_voaacenc_negotiate (voaacenc);
 
   /* create reverse caps */
@@ -361,11 +415,13 @@ gst_voaacenc_set_format (GstAudioEncoder * benc, GstAudioInfo * info)
   /* report needs to base class */
   gst_audio_encoder_set_frame_samples_min (benc, 1024);
   gst_audio_encoder_set_frame_samples_max (benc, 1024);
-  gst_audio_encoder_set_frame_max (benc, 1);
+  gst_audio_encoder_set_frame_max (benc, voaacenc->frames_per_buffer);
 
   return ret;
 }
 
+/* The input buffer holds up to frames-per-buffer frames, which are all
+ * taken from one SetInputData() call, one GetOutputData() call each */
 static GstFlowReturn
 gst_voaacenc_handle_frame (GstAudioEncoder * benc, GstBuffer * buf)
 {
@@ -377,6 +433,7 @@ gst_voaacenc_handle_frame (GstAudioEncoder * benc, GstBuffer * buf)
   VO_CODECBUFFER output = { 0 };
   GstMapInfo map, omap;
   GstAudioInfo *info = gst_audio_encoder_get_audio_info (benc);
+  guint i, n_frames;
 
   voaacenc = GST_VOAACENC (benc);
 
@@ -405,33 +462,40 @@ gst_voaacenc_handle_frame (GstAudioEncoder * benc, GstBuffer * buf)
     goto exit;
   }
 
-  /* max size */
-  out = gst_buffer_new_and_alloc (voaacenc->inbuf_size);
-  gst_buffer_map (out, &omap, GST_MAP_WRITE);
-
-  output.Buffer = omap.data;
-  output.Length = voaacenc->inbuf_size;
-
-  g_assert (map.size == voaacenc->inbuf_size);
+  n_frames = map.size / voaacenc->inbuf_size;
+  g_assert (map.size == n_frames * voaacenc->inbuf_size);
   input.Buffer = map.data;
-  input.Length = voaacenc->inbuf_size;
+  input.Length = map.size;
   voaacenc->codec_api.SetInputData (voaacenc->handle, &input);
 
-  /* encode */
-  if (voaacenc->codec_api.GetOutputData (voaacenc->handle, &output,
-          &output_info) != VO_ERR_NONE) {
-    gst_buffer_unmap (buf, &map);
+  for (i = 0; i < n_frames && ret == GST_FLOW_OK; i++) {
+    /* max size */
+    out = NULL;
+    if (!voaacenc->pool
+        || gst_buffer_pool_acquire_buffer (voaacenc->pool, &out,
+            NULL) != GST_FLOW_OK)
+      out = gst_buffer_new_and_alloc (voaacenc->inbuf_size);
+    gst_buffer_map (out, &omap, GST_MAP_WRITE);
+
+    output.Buffer = omap.data;
+    output.Length = voaacenc->inbuf_size;
+
+    /* encode */
+    if (voaacenc->codec_api.GetOutputData (voaacenc->handle, &output,
+            &output_info) != VO_ERR_NONE) {
+      gst_buffer_unmap (buf, &map);
+      gst_buffer_unmap (out, &omap);
+      gst_buffer_unref (out);
+      goto encode_failed;
+    }
+
+    GST_LOG_OBJECT (voaacenc, "encoded to %lu bytes", output.Length);
     gst_buffer_unmap (out, &omap);
-    gst_buffer_unref (out);
-    goto encode_failed;
-  }
+    gst_buffer_resize (out, 0, output.Length);
 
-  GST_LOG_OBJECT (voaacenc, "encoded to %lu bytes", output.Length);
+    ret = gst_audio_encoder_finish_frame (benc, out, 1024);
+  }
   gst_buffer_unmap (buf, &map);
-  gst_buffer_unmap (out, &omap);
-  gst_buffer_resize (out, 0, output.Length);
-
-  ret = gst_audio_encoder_finish_frame (benc, out, 1024);
 
 exit:
   return ret;
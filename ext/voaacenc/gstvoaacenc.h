@@ -56,6 +56,9 @@ struct _GstVoAacEnc {
   gint output_format;
 
   gint inbuf_size;
+  guint frames_per_buffer;
+
+  GstBufferPool *pool;
 
   /* library handle */
   VO_AUDIO_CODECAPI codec_api;
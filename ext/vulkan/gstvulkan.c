@@ -31,6 +31,11 @@
 
 #include "vksink.h"
 #include "vkupload.h"
+#include "vkdownload.h"
+#if GST_VULKAN_HAVE_SHADERS
+#include "vkcolorconvert.h"
+#include "vkscale.h"
+#endif
 
 #if GST_VULKAN_HAVE_WINDOW_X11
 #include <X11/Xlib.h>
@@ -59,6 +64,23 @@ plugin_init (GstPlugin * plugin)
     return FALSE;
   }
 
+  if (!gst_element_register (plugin, "vulkandownload",
+          GST_RANK_NONE, GST_TYPE_VULKAN_DOWNLOAD)) {
+    return FALSE;
+  }
+#if GST_VULKAN_HAVE_SHADERS
+
+  if (!gst_element_register (plugin, "vulkancolorconvert",
+          GST_RANK_NONE, GST_TYPE_VULKAN_COLOR_CONVERT)) {
+    return FALSE;
+  }
+
+  if (!gst_element_register (plugin, "vulkanscale",
+          GST_RANK_NONE, GST_TYPE_VULKAN_SCALE)) {
+    return FALSE;
+  }
+#endif
+
   return TRUE;
 }
 
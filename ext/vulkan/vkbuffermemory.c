@@ -152,13 +152,9 @@ _vk_buffer_mem_new_alloc (GstAllocator * allocator, GstMemory * parent,
   if (gst_vulkan_error_to_g_error (err, &error, "vkBindBufferMemory") < 0)
     goto vk_error;
 
+  /* only texel buffers can have views */
   if (usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT |
-          VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT |
-          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
-          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-          VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
-          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-          VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)) {
+          VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)) {
     VkBufferViewCreateInfo view_info;
 
     _create_view_from_args (&view_info, mem->buffer, format, 0,
@@ -209,13 +205,9 @@ _vk_buffer_mem_new_wrapped (GstAllocator * allocator, GstMemory * parent,
 
   /* XXX: we don't actually if the buffer has a vkDeviceMemory bound so
    * this may fail */
+  /* only texel buffers can have views */
   if (usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT |
-          VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT |
-          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
-          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-          VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
-          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-          VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)) {
+          VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)) {
     VkBufferViewCreateInfo view_info;
 
     _create_view_from_args (&view_info, mem->buffer, format, 0,
@@ -242,6 +234,119 @@ error:
   }
 }
 
+#ifdef VK_EXT_external_memory_dma_buf
+static GstVulkanBufferMemory *
+_vk_buffer_mem_new_dmabuf (GstAllocator * allocator, GstVulkanDevice * device,
+    VkFormat format, gint fd, gsize dmabuf_size, gsize offset, gsize size,
+    VkBufferUsageFlags usage)
+{
+  VkExternalMemoryBufferCreateInfoKHR external_info = { 0, };
+  VkMemoryFdPropertiesKHR fd_props = { 0, };
+  PFN_vkGetMemoryFdPropertiesKHR get_fd_props;
+  GstVulkanBufferMemory *mem = NULL;
+  GstAllocationParams params = { 0, };
+  VkBufferCreateInfo buffer_info;
+  GstMemory *imported = NULL;
+  GError *error = NULL;
+  guint32 type_idx;
+  VkBuffer buffer;
+  VkResult err;
+
+  get_fd_props =
+      gst_vulkan_device_get_proc_address (device, "vkGetMemoryFdPropertiesKHR");
+  if (!get_fd_props) {
+    GST_CAT_ERROR (GST_CAT_VULKAN_BUFFER_MEMORY,
+        "Could not retrieve vkGetMemoryFdPropertiesKHR");
+    return NULL;
+  }
+
+  fd_props.sType = VK_STRUCTURE_TYPE_MEMORY_FD_PROPERTIES_KHR;
+  err = get_fd_props (device->device,
+      VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT, fd, &fd_props);
+  if (gst_vulkan_error_to_g_error (err, &error,
+          "vkGetMemoryFdPropertiesKHR") < 0)
+    goto vk_error;
+
+  if (!_create_info_from_args (&buffer_info, size, usage)) {
+    GST_CAT_ERROR (GST_CAT_VULKAN_BUFFER_MEMORY, "Incorrect buffer parameters");
+    goto error;
+  }
+  external_info.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO_KHR;
+  external_info.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+  buffer_info.pNext = &external_info;
+
+  err = vkCreateBuffer (device->device, &buffer_info, NULL, &buffer);
+  if (gst_vulkan_error_to_g_error (err, &error, "vkCreateBuffer") < 0)
+    goto vk_error;
+
+  mem = g_new0 (GstVulkanBufferMemory, 1);
+  vkGetBufferMemoryRequirements (device->device, buffer, &mem->requirements);
+  mem->buffer = buffer;
+
+  if (offset % mem->requirements.alignment != 0
+      || offset + mem->requirements.size > dmabuf_size) {
+    GST_CAT_DEBUG (GST_CAT_VULKAN_BUFFER_MEMORY, "dmabuf offset %"
+        G_GSIZE_FORMAT " does not fit the buffer requirements", offset);
+    goto error;
+  }
+
+  /* prefer mappable memory so the buffer can still be read back directly */
+  fd_props.memoryTypeBits &= mem->requirements.memoryTypeBits;
+  if (!gst_vulkan_memory_find_memory_type_index_with_type_properties (device,
+          fd_props.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+          &type_idx)
+      && !gst_vulkan_memory_find_memory_type_index_with_type_properties (device,
+          fd_props.memoryTypeBits, 0, &type_idx)) {
+    GST_CAT_DEBUG (GST_CAT_VULKAN_BUFFER_MEMORY,
+        "No memory type can import the dmabuf");
+    goto error;
+  }
+
+  imported = gst_vulkan_memory_import_dmabuf (device, fd, type_idx,
+      dmabuf_size);
+  if (!imported)
+    goto error;
+
+  err = vkBindBufferMemory (device->device, buffer,
+      ((GstVulkanMemory *) imported)->mem_ptr, offset);
+  if (gst_vulkan_error_to_g_error (err, &error, "vkBindBufferMemory") < 0)
+    goto vk_error;
+
+  params.align = mem->requirements.alignment - 1;
+  if (!(((GstVulkanMemory *) imported)->properties &
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+    params.flags = GST_MEMORY_FLAG_NOT_MAPPABLE;
+  _vk_buffer_mem_init (mem, allocator, NULL, device, usage, &params,
+      mem->requirements.size, NULL, NULL);
+
+  /* maps start at the offset the buffer is bound to */
+  mem->vk_mem = (GstVulkanMemory *) gst_memory_share (imported, offset,
+      mem->requirements.size);
+  gst_memory_unref (imported);
+
+  return mem;
+
+vk_error:
+  {
+    GST_CAT_ERROR (GST_CAT_VULKAN_BUFFER_MEMORY,
+        "Failed to import dmabuf %s", error->message);
+    g_clear_error (&error);
+    goto error;
+  }
+
+error:
+  {
+    if (imported)
+      gst_memory_unref (imported);
+    if (mem) {
+      vkDestroyBuffer (device->device, mem->buffer, NULL);
+      g_free (mem);
+    }
+    return NULL;
+  }
+}
+#endif
+
 static gpointer
 _vk_buffer_mem_map_full (GstVulkanBufferMemory * mem, GstMapInfo * info,
     gsize size)
@@ -366,6 +471,41 @@ gst_vulkan_buffer_memory_wrapped (GstVulkanDevice * device, VkBuffer buffer,
   return (GstMemory *) mem;
 }
 
+#ifdef VK_EXT_external_memory_dma_buf
+/**
+ * gst_vulkan_buffer_memory_import_dmabuf:
+ * @device: a #GstVulkanDevice
+ * @format: the #VkFormat of the buffer view
+ * @fd: a dmabuf file descriptor
+ * @dmabuf_size: the size of the whole dmabuf
+ * @offset: the offset of the buffer in the dmabuf
+ * @size: the size of the buffer
+ * @usage: the #VkBufferUsageFlags of the buffer
+ *
+ * Creates a #GstVulkanBufferMemory bound to @size bytes at @offset of the
+ * dmabuf @fd, without copying.  @device must have the
+ * VK_EXT_external_memory_dma_buf extension enabled.
+ *
+ * Returns: a #GstMemory object backed by the dmabuf, or %NULL if the dmabuf
+ * cannot be imported
+ */
+GstMemory *
+gst_vulkan_buffer_memory_import_dmabuf (GstVulkanDevice * device,
+    VkFormat format, gint fd, gsize dmabuf_size, gsize offset, gsize size,
+    VkBufferUsageFlags usage)
+{
+  GstVulkanBufferMemory *mem;
+
+  g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), NULL);
+  g_return_val_if_fail (fd >= 0, NULL);
+
+  mem = _vk_buffer_mem_new_dmabuf (_vulkan_buffer_memory_allocator, device,
+      format, fd, dmabuf_size, offset, size, usage);
+
+  return (GstMemory *) mem;
+}
+#endif
+
 G_DEFINE_TYPE (GstVulkanBufferMemoryAllocator,
     gst_vulkan_buffer_memory_allocator, GST_TYPE_ALLOCATOR);
 
@@ -97,6 +97,16 @@ GstMemory *     gst_vulkan_buffer_memory_wrapped         (GstVulkanDevice * devi
                                                          gpointer user_data,
                                                          GDestroyNotify notify);
 
+#ifdef VK_EXT_external_memory_dma_buf
+GstMemory *     gst_vulkan_buffer_memory_import_dmabuf   (GstVulkanDevice * device,
+                                                         VkFormat format,
+                                                         gint fd,
+                                                         gsize dmabuf_size,
+                                                         gsize offset,
+                                                         gsize size,
+                                                         VkBufferUsageFlags usage);
+#endif
+
 G_END_DECLS
 
 #endif /* _VK_BUFFER_MEMORY_H_ */
@@ -0,0 +1,100 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vulkancolorconvert
+ * @title: vulkancolorconvert
+ *
+ * vulkancolorconvert converts between YUV and RGB formats of frames in Vulkan
+ * buffers with a compute shader.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 videotestsrc ! video/x-raw,format=NV12 ! vulkanupload ! vulkancolorconvert ! vulkansink
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vkcolorconvert.h"
+#include "vkvideoconvert.h"
+
+GST_DEBUG_CATEGORY (gst_debug_vulkan_color_convert);
+#define GST_CAT_DEFAULT gst_debug_vulkan_color_convert
+
+static GstCaps *gst_vulkan_color_convert_transform_internal_caps
+    (GstVulkanFilter * filter, GstPadDirection direction, GstCaps * caps,
+    GstCaps * filter_caps);
+
+#define gst_vulkan_color_convert_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstVulkanColorConvert, gst_vulkan_color_convert,
+    GST_TYPE_VULKAN_FILTER,
+    GST_DEBUG_CATEGORY_INIT (gst_debug_vulkan_color_convert,
+        "vulkancolorconvert", 0, "Vulkan Color Convert"));
+
+static void
+gst_vulkan_color_convert_class_init (GstVulkanColorConvertClass * klass)
+{
+  GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstVulkanFilterClass *filter_class = (GstVulkanFilterClass *) klass;
+  GstCaps *caps;
+
+  gst_element_class_set_metadata (gstelement_class, "Vulkan Color Convert",
+      "Filter/Converter/Video", "Converts between video formats with Vulkan",
+      "Matthew Waters <matthew@centricular.com>");
+
+  caps = gst_caps_from_string (GST_VULKAN_VIDEO_CONVERT_CAPS);
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS, caps));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS, caps));
+  gst_caps_unref (caps);
+
+  gst_vulkan_video_convert_class_init (filter_class);
+  filter_class->transform_internal_caps =
+      gst_vulkan_color_convert_transform_internal_caps;
+}
+
+static void
+gst_vulkan_color_convert_init (GstVulkanColorConvert * convert)
+{
+}
+
+static GstCaps *
+gst_vulkan_color_convert_transform_internal_caps (GstVulkanFilter * filter,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter_caps)
+{
+  GstCaps *res;
+  guint i, n;
+
+  /* the unconverted caps come first so that they are preferred */
+  res = gst_caps_copy (caps);
+  n = gst_caps_get_size (res);
+  for (i = 0; i < n; i++) {
+    GstStructure *s = gst_structure_copy (gst_caps_get_structure (res, i));
+
+    gst_structure_remove_fields (s, "format", "colorimetry", "chroma-site",
+        NULL);
+    res = gst_caps_merge_structure (res, s);
+  }
+
+  return res;
+}
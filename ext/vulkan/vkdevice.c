@@ -38,6 +38,16 @@ static const char *device_validation_layers[] = {
   "VK_LAYER_LUNARG_image",
 };
 
+/* enabled when the device provides them, for importing dmabufs */
+static const char *optional_device_extensions[] = {
+#ifdef VK_EXT_external_memory_dma_buf
+  VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
+  VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
+  VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME,
+#endif
+  NULL,
+};
+
 #define GST_CAT_DEFAULT gst_vulkan_device_debug
 GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_CONTEXT);
@@ -53,6 +63,12 @@ static void gst_vulkan_device_finalize (GObject * object);
 struct _GstVulkanDevicePrivate
 {
   gboolean opened;
+
+  gchar **enabled_extensions;
+
+  /* signaled fences returned by their last user, see
+   * gst_vulkan_device_acquire_fence() */
+  GQueue free_fences;
 };
 
 GstVulkanDevice *
@@ -94,6 +110,18 @@ gst_vulkan_device_finalize (GObject * object)
   g_free (device->queue_family_props);
   device->queue_family_props = NULL;
 
+  g_strfreev (device->priv->enabled_extensions);
+  device->priv->enabled_extensions = NULL;
+
+  /* pooled fences do not hold a reference on the device and still have
+   * their single reference, so they are freed directly */
+  while (!g_queue_is_empty (&device->priv->free_fences)) {
+    GstVulkanFence *fence = g_queue_pop_head (&device->priv->free_fences);
+
+    vkDestroyFence (device->device, fence->fence, NULL);
+    g_free (fence);
+  }
+
   if (device->cmd_pool)
     vkDestroyCommandPool (device->device, device->cmd_pool, NULL);
   device->cmd_pool = VK_NULL_HANDLE;
@@ -171,7 +199,7 @@ gst_vulkan_device_open (GstVulkanDevice * device, GError ** error)
   gboolean have_swapchain_ext;
   VkPhysicalDevice gpu;
   VkResult err;
-  guint i;
+  guint i, j;
 
   g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), FALSE);
 
@@ -241,6 +269,15 @@ gst_vulkan_device_open (GstVulkanDevice * device, GError ** error)
       extension_names[enabled_extension_count++] =
           (gchar *) VK_KHR_SWAPCHAIN_EXTENSION_NAME;
     }
+    for (j = 0; optional_device_extensions[j]; j++) {
+      if (!strcmp (optional_device_extensions[j],
+              device_extensions[i].extensionName)) {
+        GST_DEBUG_OBJECT (device, "enabling optional extension %s",
+            optional_device_extensions[j]);
+        extension_names[enabled_extension_count++] =
+            optional_device_extensions[j];
+      }
+    }
     g_assert (enabled_extension_count < 64);
   }
   if (!have_swapchain_ext) {
@@ -314,13 +351,20 @@ gst_vulkan_device_open (GstVulkanDevice * device, GError ** error)
   }
   g_strfreev (enabled_layers);
 
+  g_strfreev (device->priv->enabled_extensions);
+  device->priv->enabled_extensions = g_new0 (gchar *,
+      enabled_extension_count + 1);
+  for (i = 0; i < enabled_extension_count; i++)
+    device->priv->enabled_extensions[i] = g_strdup (extension_names[i]);
+
   {
     VkCommandPoolCreateInfo cmd_pool_info = { 0, };
 
     cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     cmd_pool_info.pNext = NULL;
     cmd_pool_info.queueFamilyIndex = device->queue_family_id;
-    cmd_pool_info.flags = 0;
+    /* command buffers are recorded again instead of being reallocated */
+    cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
     err =
         vkCreateCommandPool (device->device, &cmd_pool_info, NULL,
@@ -339,6 +383,31 @@ error:
   }
 }
 
+/**
+ * gst_vulkan_device_is_extension_enabled:
+ * @device: an opened #GstVulkanDevice
+ * @name: the name of a device extension
+ *
+ * Returns: whether the extension @name was enabled when opening @device
+ */
+gboolean
+gst_vulkan_device_is_extension_enabled (GstVulkanDevice * device,
+    const gchar * name)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), FALSE);
+  g_return_val_if_fail (name != NULL, FALSE);
+
+  GST_OBJECT_LOCK (device);
+  ret = device->priv->enabled_extensions
+      && g_strv_contains ((const gchar * const *)
+      device->priv->enabled_extensions, name);
+  GST_OBJECT_UNLOCK (device);
+
+  return ret;
+}
+
 GstVulkanQueue *
 gst_vulkan_device_get_queue (GstVulkanDevice * device, guint32 queue_family,
     guint32 queue_i)
@@ -439,6 +508,66 @@ gst_vulkan_device_create_cmd_buffer (GstVulkanDevice * device,
   return TRUE;
 }
 
+/**
+ * gst_vulkan_device_acquire_fence:
+ * @device: an opened #GstVulkanDevice
+ * @error: a #GError
+ *
+ * Returns an unsignaled fence for @device, reusing one that was released
+ * after being signaled if possible.  Releasing the last reference of the
+ * fence once it is signaled returns it to @device.
+ *
+ * Returns: (transfer full): a #GstVulkanFence or %NULL on error
+ */
+GstVulkanFence *
+gst_vulkan_device_acquire_fence (GstVulkanDevice * device, GError ** error)
+{
+  GstVulkanFence *fence;
+
+  g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), NULL);
+  g_return_val_if_fail (device->device != NULL, NULL);
+
+  GST_OBJECT_LOCK (device);
+  fence = g_queue_pop_head (&device->priv->free_fences);
+  GST_OBJECT_UNLOCK (device);
+
+  if (fence) {
+    GST_TRACE_OBJECT (device, "reusing fence %p", fence);
+    fence->device = gst_object_ref (device);
+    return fence;
+  }
+
+  fence = gst_vulkan_fence_new (device, 0, error);
+  if (fence)
+    fence->pooled = TRUE;
+
+  return fence;
+}
+
+/* Called from the dispose function of a pooled @fence holding a reference
+ * on @device, returns whether @fence was taken back */
+gboolean
+_gst_vulkan_device_release_fence (GstVulkanDevice * device,
+    GstVulkanFence * fence)
+{
+  VkResult err;
+
+  err = vkResetFences (device->device, 1, &fence->fence);
+  if (err != VK_SUCCESS) {
+    GST_WARNING_OBJECT (device, "Failed to reset fence %p", fence);
+    return FALSE;
+  }
+
+  /* the pool does not keep the device alive, the device frees the pool */
+  fence->device = NULL;
+  GST_OBJECT_LOCK (device);
+  g_queue_push_tail (&device->priv->free_fences, fence);
+  GST_OBJECT_UNLOCK (device);
+  gst_object_unref (device);
+
+  return TRUE;
+}
+
 /**
  * gst_context_set_vulkan_device:
  * @context: a #GstContext
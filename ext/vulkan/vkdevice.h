@@ -83,6 +83,10 @@ VkPhysicalDevice    gst_vulkan_device_get_physical_device   (GstVulkanDevice * d
 gboolean            gst_vulkan_device_create_cmd_buffer     (GstVulkanDevice * device,
                                                              VkCommandBuffer * cmd,
                                                              GError ** error);
+gboolean            gst_vulkan_device_is_extension_enabled  (GstVulkanDevice * device,
+                                                             const gchar * name);
+GstVulkanFence *    gst_vulkan_device_acquire_fence         (GstVulkanDevice * device,
+                                                             GError ** error);
 
 void                gst_context_set_vulkan_device           (GstContext * context,
                                                              GstVulkanDevice * device);
@@ -0,0 +1,493 @@
+/*
+ * GStreamer
+ * Copyright (C) 2016 Matthew Waters <matthew@centricular.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vulkandownload
+ * @title: vulkandownload
+ *
+ * vulkandownload downloads data from Vulkan memory objects into system
+ * memory.  Host visible memory is read directly, device local memory is
+ * first copied into host visible staging buffers.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "vkdownload.h"
+
+GST_DEBUG_CATEGORY (gst_debug_vulkan_download);
+#define GST_CAT_DEFAULT gst_debug_vulkan_download
+
+/* 1 second, a copy of a frame is expected to be much faster */
+#define STAGING_FENCE_TIMEOUT (G_GUINT64_CONSTANT (1000000000))
+
+static GstStaticPadTemplate gst_vulkan_download_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER ")"));
+
+static GstStaticPadTemplate gst_vulkan_download_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static gboolean gst_vulkan_download_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query);
+static void gst_vulkan_download_set_context (GstElement * element,
+    GstContext * context);
+static GstStateChangeReturn gst_vulkan_download_change_state (GstElement *
+    element, GstStateChange transition);
+
+static gboolean gst_vulkan_download_set_caps (GstBaseTransform * bt,
+    GstCaps * in_caps, GstCaps * out_caps);
+static GstCaps *gst_vulkan_download_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter);
+static gboolean gst_vulkan_download_propose_allocation (GstBaseTransform * bt,
+    GstQuery * decide_query, GstQuery * query);
+static GstFlowReturn gst_vulkan_download_prepare_output_buffer (GstBaseTransform
+    * bt, GstBuffer * inbuf, GstBuffer ** outbuf);
+static GstFlowReturn gst_vulkan_download_transform (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+
+#define gst_vulkan_download_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstVulkanDownload, gst_vulkan_download,
+    GST_TYPE_BASE_TRANSFORM,
+    GST_DEBUG_CATEGORY_INIT (gst_debug_vulkan_download, "vulkandownload", 0,
+        "Vulkan Downloader"));
+
+static void
+gst_vulkan_download_class_init (GstVulkanDownloadClass * klass)
+{
+  GstElementClass *gstelement_class;
+  GstBaseTransformClass *gstbasetransform_class;
+
+  gstelement_class = (GstElementClass *) klass;
+  gstbasetransform_class = (GstBaseTransformClass *) klass;
+
+  gst_element_class_set_metadata (gstelement_class, "Vulkan Downloader",
+      "Filter/Video", "A Vulkan data downloader",
+      "Matthew Waters <matthew@centricular.com>");
+
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_vulkan_download_sink_template);
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_vulkan_download_src_template);
+
+  gstelement_class->change_state = gst_vulkan_download_change_state;
+  gstelement_class->set_context = gst_vulkan_download_set_context;
+  gstbasetransform_class->query = GST_DEBUG_FUNCPTR (gst_vulkan_download_query);
+  gstbasetransform_class->set_caps = gst_vulkan_download_set_caps;
+  gstbasetransform_class->transform_caps = gst_vulkan_download_transform_caps;
+  gstbasetransform_class->propose_allocation =
+      gst_vulkan_download_propose_allocation;
+  gstbasetransform_class->prepare_output_buffer =
+      gst_vulkan_download_prepare_output_buffer;
+  gstbasetransform_class->transform = gst_vulkan_download_transform;
+}
+
+static void
+gst_vulkan_download_init (GstVulkanDownload * vk_download)
+{
+}
+
+static void
+_free_staging (GstVulkanDownload * vk_download)
+{
+  guint i;
+
+  for (i = 0; i < GST_VIDEO_MAX_PLANES; i++) {
+    if (vk_download->staging[i])
+      gst_memory_unref (vk_download->staging[i]);
+    vk_download->staging[i] = NULL;
+  }
+
+  if (vk_download->fence)
+    gst_vulkan_fence_unref (vk_download->fence);
+  vk_download->fence = NULL;
+
+  if (vk_download->cmd)
+    vkFreeCommandBuffers (vk_download->device->device,
+        vk_download->device->cmd_pool, 1, &vk_download->cmd);
+  vk_download->cmd = VK_NULL_HANDLE;
+}
+
+static gboolean
+gst_vulkan_download_query (GstBaseTransform * bt, GstPadDirection direction,
+    GstQuery * query)
+{
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (bt);
+  gboolean res = FALSE;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:{
+      res = gst_vulkan_handle_context_query (GST_ELEMENT (vk_download), query,
+          &vk_download->display, &vk_download->instance, &vk_download->device);
+
+      if (res)
+        return res;
+      break;
+    }
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->query (bt, direction, query);
+}
+
+static void
+gst_vulkan_download_set_context (GstElement * element, GstContext * context)
+{
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (element);
+
+  gst_vulkan_handle_set_context (element, context, &vk_download->display,
+      &vk_download->instance);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static GstStateChangeReturn
+gst_vulkan_download_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (element);
+  GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_vulkan_ensure_element_data (element, &vk_download->display,
+              &vk_download->instance)) {
+        GST_ELEMENT_ERROR (vk_download, RESOURCE, NOT_FOUND,
+            ("Failed to retreive vulkan instance/display"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      if (!gst_vulkan_device_run_context_query (GST_ELEMENT (vk_download),
+              &vk_download->device)) {
+        GST_ELEMENT_ERROR (vk_download, RESOURCE, NOT_FOUND,
+            ("Failed to retreive vulkan device"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      vk_download->queue = gst_vulkan_device_get_queue (vk_download->device,
+          vk_download->device->queue_family_id, 0);
+      if (!vk_download->queue) {
+        GST_ELEMENT_ERROR (vk_download, RESOURCE, NOT_FOUND,
+            ("Failed to retreive vulkan queue"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      _free_staging (vk_download);
+      if (vk_download->queue)
+        gst_object_unref (vk_download->queue);
+      vk_download->queue = NULL;
+      if (vk_download->display)
+        gst_object_unref (vk_download->display);
+      vk_download->display = NULL;
+      if (vk_download->device)
+        gst_object_unref (vk_download->device);
+      vk_download->device = NULL;
+      if (vk_download->instance)
+        gst_object_unref (vk_download->instance);
+      vk_download->instance = NULL;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static GstCaps *
+gst_vulkan_download_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  GstCaps *result, *tmp;
+  guint i, n;
+
+  tmp = gst_caps_copy (caps);
+  n = gst_caps_get_size (tmp);
+  for (i = 0; i < n; i++) {
+    gst_caps_set_features (tmp, i,
+        gst_caps_features_from_string (direction == GST_PAD_SINK ?
+            GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY :
+            GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER));
+  }
+
+  if (filter) {
+    result = gst_caps_intersect_full (filter, tmp, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (tmp);
+  } else {
+    result = tmp;
+  }
+
+  return result;
+}
+
+static gboolean
+gst_vulkan_download_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
+    GstCaps * out_caps)
+{
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (bt);
+
+  if (!gst_video_info_from_caps (&vk_download->in_info, in_caps))
+    return FALSE;
+
+  if (!gst_video_info_from_caps (&vk_download->out_info, out_caps))
+    return FALSE;
+
+  /* the plane sizes may have changed */
+  _free_staging (vk_download);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vulkan_download_propose_allocation (GstBaseTransform * bt,
+    GstQuery * decide_query, GstQuery * query)
+{
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (bt);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  gboolean need_pool;
+  GstCaps *caps;
+  GstVideoInfo info;
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+  if (caps == NULL || !gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  if (need_pool) {
+    pool = gst_vulkan_buffer_pool_new (vk_download->device);
+
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, info.size, 0, 0);
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      gst_object_unref (pool);
+      return FALSE;
+    }
+  }
+
+  gst_query_add_allocation_pool (query, pool, info.size, 1, 0);
+  if (pool)
+    gst_object_unref (pool);
+
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_vulkan_download_prepare_output_buffer (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer ** outbuf)
+{
+  GstBaseTransformClass *bclass = GST_BASE_TRANSFORM_GET_CLASS (bt);
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (bt);
+
+  *outbuf = gst_buffer_new_allocate (NULL, vk_download->out_info.size, NULL);
+  if (!*outbuf)
+    return GST_FLOW_ERROR;
+
+  bclass->copy_metadata (bt, inbuf, *outbuf);
+
+  return GST_FLOW_OK;
+}
+
+/* Copies the device local @buf_mem into the host visible staging buffer of
+ * @plane and waits for the copy to finish */
+static GstMemory *
+_copy_to_staging (GstVulkanDownload * vk_download, guint plane,
+    GstVulkanBufferMemory * buf_mem, GError ** error)
+{
+  GstVulkanDevice *device = vk_download->device;
+  GstVulkanBufferMemory *staging;
+  gsize size = buf_mem->requirements.size;
+  VkResult err;
+
+  if (vk_download->staging[plane]
+      && ((GstVulkanBufferMemory *) vk_download->staging[plane])->
+      requirements.size < size) {
+    gst_memory_unref (vk_download->staging[plane]);
+    vk_download->staging[plane] = NULL;
+  }
+
+  if (!vk_download->staging[plane]) {
+    vk_download->staging[plane] = gst_vulkan_buffer_memory_alloc (device,
+        gst_vulkan_format_from_video_format (GST_VIDEO_INFO_FORMAT
+            (&vk_download->in_info), plane), size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    if (!vk_download->staging[plane]) {
+      g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_OUT_OF_HOST_MEMORY,
+          "Failed to allocate the staging buffer");
+      return NULL;
+    }
+  }
+  staging = (GstVulkanBufferMemory *) vk_download->staging[plane];
+
+  if (!vk_download->fence) {
+    vk_download->fence = gst_vulkan_fence_new (device, 0, error);
+    if (!vk_download->fence)
+      return NULL;
+  } else {
+    err = vkResetFences (device->device, 1, &vk_download->fence->fence);
+    if (gst_vulkan_error_to_g_error (err, error, "vkResetFences") < 0)
+      return NULL;
+  }
+
+  /* the command pool allows resetting, so the command buffer is simply
+   * recorded again for the next copy */
+  if (!vk_download->cmd
+      && !gst_vulkan_device_create_cmd_buffer (device, &vk_download->cmd,
+          error))
+    return NULL;
+
+  {
+    VkCommandBufferBeginInfo cmd_buf_info = { 0, };
+    VkBufferCopy region = { 0, };
+
+    cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmd_buf_info.pNext = NULL;
+    cmd_buf_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    cmd_buf_info.pInheritanceInfo = NULL;
+
+    err = vkBeginCommandBuffer (vk_download->cmd, &cmd_buf_info);
+    if (gst_vulkan_error_to_g_error (err, error, "vkBeginCommandBuffer") < 0)
+      return NULL;
+
+    region.srcOffset = 0;
+    region.dstOffset = 0;
+    region.size = size;
+    vkCmdCopyBuffer (vk_download->cmd, buf_mem->buffer, staging->buffer, 1,
+        &region);
+
+    err = vkEndCommandBuffer (vk_download->cmd);
+    if (gst_vulkan_error_to_g_error (err, error, "vkEndCommandBuffer") < 0)
+      return NULL;
+  }
+
+  {
+    VkSubmitInfo submit_info = { 0, };
+
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = NULL;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &vk_download->cmd;
+
+    err = vkQueueSubmit (vk_download->queue->queue, 1, &submit_info,
+        GST_VULKAN_FENCE_FENCE (vk_download->fence));
+    if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
+      return NULL;
+  }
+
+  if (!gst_vulkan_fence_wait (vk_download->fence, STAGING_FENCE_TIMEOUT,
+          error))
+    return NULL;
+
+  return vk_download->staging[plane];
+}
+
+static GstFlowReturn
+gst_vulkan_download_transform (GstBaseTransform * bt, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (bt);
+  GstVideoInfo *in_info = &vk_download->in_info;
+  GstVideoFrame out_frame;
+  GstVideoMeta *meta;
+  GError *error = NULL;
+  guint i;
+
+  if (!gst_video_frame_map (&out_frame, &vk_download->out_info, outbuf,
+          GST_MAP_WRITE)) {
+    GST_ELEMENT_ERROR (vk_download, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to map output buffer"), NULL);
+    return GST_FLOW_ERROR;
+  }
+
+  meta = gst_buffer_get_video_meta (inbuf);
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (in_info); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (inbuf, i);
+    gint src_stride, dest_stride, row_size, rows, j;
+    const guint8 *src;
+    guint8 *dest;
+    GstMapInfo map_info;
+
+    if (!gst_is_vulkan_buffer_memory (mem)) {
+      GST_ELEMENT_ERROR (vk_download, RESOURCE, NOT_FOUND,
+          ("%s", "Input buffer is not backed by Vulkan buffer memory"), NULL);
+      goto error;
+    }
+
+    if (GST_MEMORY_FLAG_IS_SET (mem, GST_MEMORY_FLAG_NOT_MAPPABLE)) {
+      mem = _copy_to_staging (vk_download, i, (GstVulkanBufferMemory *) mem,
+          &error);
+      if (!mem) {
+        GST_ELEMENT_ERROR (vk_download, RESOURCE, READ,
+            ("Failed to copy to the staging buffer: %s", error->message),
+            (NULL));
+        g_clear_error (&error);
+        goto error;
+      }
+    }
+
+    if (!gst_memory_map (mem, &map_info, GST_MAP_READ)) {
+      GST_ELEMENT_ERROR (vk_download, RESOURCE, NOT_FOUND,
+          ("%s", "Failed to map input memory"), NULL);
+      goto error;
+    }
+
+    src_stride = meta ? meta->stride[i] : GST_VIDEO_INFO_PLANE_STRIDE (in_info,
+        i);
+    dest_stride = GST_VIDEO_FRAME_PLANE_STRIDE (&out_frame, i);
+    row_size = MIN (src_stride, dest_stride);
+    rows = GST_VIDEO_FRAME_COMP_HEIGHT (&out_frame, i);
+
+    src = map_info.data;
+    dest = GST_VIDEO_FRAME_PLANE_DATA (&out_frame, i);
+    for (j = 0; j < rows && (j + 1) * src_stride <= map_info.size; j++) {
+      memcpy (dest, src, row_size);
+      src += src_stride;
+      dest += dest_stride;
+    }
+
+    gst_memory_unmap (mem, &map_info);
+  }
+
+  gst_video_frame_unmap (&out_frame);
+
+  return GST_FLOW_OK;
+
+error:
+  gst_video_frame_unmap (&out_frame);
+  return GST_FLOW_ERROR;
+}
@@ -40,6 +40,22 @@ _init_debug (void)
   }
 }
 
+static gboolean
+gst_vulkan_fence_dispose (GstVulkanFence * fence)
+{
+  /* a fence may only be reset once it is not pending anymore */
+  if (!fence->pooled || !gst_vulkan_fence_is_signaled (fence))
+    return TRUE;
+
+  gst_vulkan_fence_ref (fence);
+  if (_gst_vulkan_device_release_fence (fence->device, fence))
+    return FALSE;
+
+  fence->pooled = FALSE;
+  gst_mini_object_unref (GST_MINI_OBJECT_CAST (fence));
+  return FALSE;
+}
+
 static void
 gst_vulkan_fence_free (GstVulkanFence * fence)
 {
@@ -82,7 +98,8 @@ gst_vulkan_fence_new (GstVulkanDevice * device, VkFenceCreateFlags flags,
   }
 
   gst_mini_object_init (GST_MINI_OBJECT_CAST (fence), 0, GST_TYPE_VULKAN_FENCE,
-      NULL, NULL, (GstMiniObjectFreeFunction) gst_vulkan_fence_free);
+      NULL, (GstMiniObjectDisposeFunction) gst_vulkan_fence_dispose,
+      (GstMiniObjectFreeFunction) gst_vulkan_fence_free);
 
   return fence;
 }
@@ -95,4 +112,33 @@ gst_vulkan_fence_is_signaled (GstVulkanFence * fence)
   return vkGetFenceStatus (fence->device->device, fence->fence) == VK_SUCCESS;
 }
 
+/**
+ * gst_vulkan_fence_wait:
+ * @fence: a #GstVulkanFence
+ * @timeout: the timeout in nanoseconds
+ * @error: a #GError
+ *
+ * Waits until @fence is signaled or @timeout elapsed.
+ *
+ * Returns: whether @fence is signaled
+ */
+gboolean
+gst_vulkan_fence_wait (GstVulkanFence * fence, guint64 timeout,
+    GError ** error)
+{
+  VkResult err;
+
+  g_return_val_if_fail (fence != NULL, FALSE);
+
+  err = vkWaitForFences (fence->device->device, 1, &fence->fence, TRUE,
+      timeout);
+  if (err == VK_TIMEOUT) {
+    g_set_error (error, GST_VULKAN_ERROR, VK_TIMEOUT,
+        "Timed out waiting for fence %p", fence);
+    return FALSE;
+  }
+
+  return gst_vulkan_error_to_g_error (err, error, "vkWaitForFences") >= 0;
+}
+
 GST_DEFINE_MINI_OBJECT_TYPE (GstVulkanFence, gst_vulkan_fence);
@@ -38,12 +38,18 @@ struct _GstVulkanFence
   GstVulkanDevice *device;
 
   VkFence fence;
+
+  /* <private> */
+  /* returned to the device once signaled and released */
+  gboolean pooled;
 };
 
 GstVulkanFence *    gst_vulkan_fence_new            (GstVulkanDevice * device,
                                                      VkFenceCreateFlags flags,
                                                      GError ** error);
-GstVulkanFence *    gst_vulkan_fence_wait           (GstVulkanFence * fence);
+gboolean            gst_vulkan_fence_wait           (GstVulkanFence * fence,
+                                                     guint64 timeout,
+                                                     GError ** error);
 gboolean            gst_vulkan_fence_is_signaled    (GstVulkanFence * fence);
 
 static inline GstVulkanFence *
@@ -0,0 +1,666 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:vkfilter
+ * @title: GstVulkanFilter
+ * @short_description: base class for Vulkan compute filters
+ *
+ * #GstVulkanFilter negotiates Vulkan buffer memory on both pads and runs the
+ * compute shader of the subclass with every input buffer.  The output buffers
+ * come from a #GstVulkanBufferPool.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vkfilter.h"
+
+GST_DEBUG_CATEGORY (gst_debug_vulkan_filter);
+#define GST_CAT_DEFAULT gst_debug_vulkan_filter
+
+/* 1 second, a dispatch is expected to be much faster */
+#define DISPATCH_FENCE_TIMEOUT (G_GUINT64_CONSTANT (1000000000))
+
+static GstStaticPadTemplate gst_vulkan_filter_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER ")"));
+
+static GstStaticPadTemplate gst_vulkan_filter_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER ")"));
+
+static void gst_vulkan_filter_finalize (GObject * object);
+
+static gboolean gst_vulkan_filter_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query);
+static void gst_vulkan_filter_set_context (GstElement * element,
+    GstContext * context);
+static GstStateChangeReturn gst_vulkan_filter_change_state (GstElement *
+    element, GstStateChange transition);
+
+static GstCaps *gst_vulkan_filter_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter);
+static gboolean gst_vulkan_filter_set_caps (GstBaseTransform * bt,
+    GstCaps * in_caps, GstCaps * out_caps);
+static gboolean gst_vulkan_filter_propose_allocation (GstBaseTransform * bt,
+    GstQuery * decide_query, GstQuery * query);
+static gboolean gst_vulkan_filter_decide_allocation (GstBaseTransform * bt,
+    GstQuery * query);
+static GstFlowReturn gst_vulkan_filter_transform (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+
+#define gst_vulkan_filter_parent_class parent_class
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstVulkanFilter, gst_vulkan_filter,
+    GST_TYPE_BASE_TRANSFORM, GST_DEBUG_CATEGORY_INIT (gst_debug_vulkan_filter,
+        "vulkanfilter", 0, "Vulkan Filter"));
+
+static void
+gst_vulkan_filter_class_init (GstVulkanFilterClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseTransformClass *gstbasetransform_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gstelement_class = (GstElementClass *) klass;
+  gstbasetransform_class = (GstBaseTransformClass *) klass;
+
+  gobject_class->finalize = gst_vulkan_filter_finalize;
+
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_vulkan_filter_sink_template);
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_vulkan_filter_src_template);
+
+  gstelement_class->change_state = gst_vulkan_filter_change_state;
+  gstelement_class->set_context = gst_vulkan_filter_set_context;
+  gstbasetransform_class->query = GST_DEBUG_FUNCPTR (gst_vulkan_filter_query);
+  gstbasetransform_class->transform_caps = gst_vulkan_filter_transform_caps;
+  gstbasetransform_class->set_caps = gst_vulkan_filter_set_caps;
+  gstbasetransform_class->propose_allocation =
+      gst_vulkan_filter_propose_allocation;
+  gstbasetransform_class->decide_allocation =
+      gst_vulkan_filter_decide_allocation;
+  gstbasetransform_class->transform = gst_vulkan_filter_transform;
+  gstbasetransform_class->passthrough_on_same_caps = TRUE;
+}
+
+static void
+gst_vulkan_filter_init (GstVulkanFilter * filter)
+{
+}
+
+static void
+gst_vulkan_filter_finalize (GObject * object)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (object);
+
+  gst_caps_replace (&filter->in_caps, NULL);
+  gst_caps_replace (&filter->out_caps, NULL);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+_destroy_pipeline (GstVulkanFilter * filter)
+{
+  VkDevice device;
+
+  if (!filter->device)
+    return;
+  device = filter->device->device;
+
+  /* the last dispatch was waited for */
+  if (filter->fence)
+    gst_vulkan_fence_unref (filter->fence);
+  filter->fence = NULL;
+
+  if (filter->cmd_pool)
+    vkDestroyCommandPool (device, filter->cmd_pool, NULL);
+  filter->cmd_pool = VK_NULL_HANDLE;
+  filter->cmd = VK_NULL_HANDLE;
+
+  if (filter->descriptor_pool)
+    vkDestroyDescriptorPool (device, filter->descriptor_pool, NULL);
+  filter->descriptor_pool = VK_NULL_HANDLE;
+  filter->descriptor_set = VK_NULL_HANDLE;
+
+  if (filter->pipeline)
+    vkDestroyPipeline (device, filter->pipeline, NULL);
+  filter->pipeline = VK_NULL_HANDLE;
+
+  if (filter->pipeline_layout)
+    vkDestroyPipelineLayout (device, filter->pipeline_layout, NULL);
+  filter->pipeline_layout = VK_NULL_HANDLE;
+
+  if (filter->set_layout)
+    vkDestroyDescriptorSetLayout (device, filter->set_layout, NULL);
+  filter->set_layout = VK_NULL_HANDLE;
+
+  if (filter->shader)
+    vkDestroyShaderModule (device, filter->shader, NULL);
+  filter->shader = VK_NULL_HANDLE;
+}
+
+static gboolean
+_create_pipeline (GstVulkanFilter * filter, GError ** error)
+{
+  GstVulkanFilterClass *klass = GST_VULKAN_FILTER_GET_CLASS (filter);
+  VkDevice device = filter->device->device;
+  VkResult err;
+  guint i;
+
+  {
+    VkShaderModuleCreateInfo info = { 0, };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.codeSize = klass->shader_size;
+    info.pCode = klass->shader_code;
+
+    err = vkCreateShaderModule (device, &info, NULL, &filter->shader);
+    if (gst_vulkan_error_to_g_error (err, error, "vkCreateShaderModule") < 0)
+      goto error;
+  }
+
+  {
+    VkDescriptorSetLayoutBinding bindings[GST_VULKAN_FILTER_N_BINDINGS];
+    VkDescriptorSetLayoutCreateInfo info = { 0, };
+
+    for (i = 0; i < GST_VULKAN_FILTER_N_BINDINGS; i++) {
+      bindings[i].binding = i;
+      bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      bindings[i].descriptorCount = 1;
+      bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+      bindings[i].pImmutableSamplers = NULL;
+    }
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.bindingCount = GST_VULKAN_FILTER_N_BINDINGS;
+    info.pBindings = bindings;
+
+    err = vkCreateDescriptorSetLayout (device, &info, NULL,
+        &filter->set_layout);
+    if (gst_vulkan_error_to_g_error (err, error,
+            "vkCreateDescriptorSetLayout") < 0)
+      goto error;
+  }
+
+  {
+    VkPushConstantRange range = { 0, };
+    VkPipelineLayoutCreateInfo info = { 0, };
+
+    range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    range.offset = 0;
+    range.size = klass->push_constants_size;
+
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.setLayoutCount = 1;
+    info.pSetLayouts = &filter->set_layout;
+    info.pushConstantRangeCount = klass->push_constants_size > 0 ? 1 : 0;
+    info.pPushConstantRanges = &range;
+
+    err = vkCreatePipelineLayout (device, &info, NULL,
+        &filter->pipeline_layout);
+    if (gst_vulkan_error_to_g_error (err, error, "vkCreatePipelineLayout") < 0)
+      goto error;
+  }
+
+  {
+    VkComputePipelineCreateInfo info = { 0, };
+
+    info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    info.stage.module = filter->shader;
+    info.stage.pName = "main";
+    info.layout = filter->pipeline_layout;
+
+    err = vkCreateComputePipelines (device, VK_NULL_HANDLE, 1, &info, NULL,
+        &filter->pipeline);
+    if (gst_vulkan_error_to_g_error (err, error,
+            "vkCreateComputePipelines") < 0)
+      goto error;
+  }
+
+  {
+    VkDescriptorPoolSize pool_size = { 0, };
+    VkDescriptorPoolCreateInfo info = { 0, };
+    VkDescriptorSetAllocateInfo alloc_info = { 0, };
+
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = GST_VULKAN_FILTER_N_BINDINGS;
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.maxSets = 1;
+    info.poolSizeCount = 1;
+    info.pPoolSizes = &pool_size;
+
+    err = vkCreateDescriptorPool (device, &info, NULL,
+        &filter->descriptor_pool);
+    if (gst_vulkan_error_to_g_error (err, error, "vkCreateDescriptorPool") < 0)
+      goto error;
+
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = filter->descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &filter->set_layout;
+
+    err = vkAllocateDescriptorSets (device, &alloc_info,
+        &filter->descriptor_set);
+    if (gst_vulkan_error_to_g_error (err, error,
+            "vkAllocateDescriptorSets") < 0)
+      goto error;
+  }
+
+  {
+    VkCommandPoolCreateInfo info = { 0, };
+    VkCommandBufferAllocateInfo alloc_info = { 0, };
+
+    /* the command buffer is recorded again for every buffer */
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    info.queueFamilyIndex = filter->queue->family;
+
+    err = vkCreateCommandPool (device, &info, NULL, &filter->cmd_pool);
+    if (gst_vulkan_error_to_g_error (err, error, "vkCreateCommandPool") < 0)
+      goto error;
+
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = filter->cmd_pool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandBufferCount = 1;
+
+    err = vkAllocateCommandBuffers (device, &alloc_info, &filter->cmd);
+    if (gst_vulkan_error_to_g_error (err, error,
+            "vkAllocateCommandBuffers") < 0)
+      goto error;
+  }
+
+  filter->fence = gst_vulkan_fence_new (filter->device, 0, error);
+  if (!filter->fence)
+    goto error;
+
+  return TRUE;
+
+error:
+  _destroy_pipeline (filter);
+  return FALSE;
+}
+
+static gboolean
+gst_vulkan_filter_query (GstBaseTransform * bt, GstPadDirection direction,
+    GstQuery * query)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (bt);
+  gboolean res = FALSE;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:{
+      res = gst_vulkan_handle_context_query (GST_ELEMENT (filter), query,
+          &filter->display, &filter->instance, &filter->device);
+
+      if (res)
+        return res;
+      break;
+    }
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->query (bt, direction, query);
+}
+
+static void
+gst_vulkan_filter_set_context (GstElement * element, GstContext * context)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (element);
+
+  gst_vulkan_handle_set_context (element, context, &filter->display,
+      &filter->instance);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static GstStateChangeReturn
+gst_vulkan_filter_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (element);
+  GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_vulkan_ensure_element_data (element, &filter->display,
+              &filter->instance)) {
+        GST_ELEMENT_ERROR (filter, RESOURCE, NOT_FOUND,
+            ("Failed to retreive vulkan instance/display"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      if (!gst_vulkan_device_run_context_query (GST_ELEMENT (filter),
+              &filter->device)) {
+        GST_ELEMENT_ERROR (filter, RESOURCE, NOT_FOUND,
+            ("Failed to retreive vulkan device"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      filter->queue = gst_vulkan_device_get_queue (filter->device,
+          filter->device->queue_family_id, 0);
+      if (!filter->queue) {
+        GST_ELEMENT_ERROR (filter, RESOURCE, NOT_FOUND,
+            ("Failed to retreive vulkan queue"), (NULL));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      _destroy_pipeline (filter);
+      if (filter->queue)
+        gst_object_unref (filter->queue);
+      filter->queue = NULL;
+      if (filter->display)
+        gst_object_unref (filter->display);
+      filter->display = NULL;
+      if (filter->device)
+        gst_object_unref (filter->device);
+      filter->device = NULL;
+      if (filter->instance)
+        gst_object_unref (filter->instance);
+      filter->instance = NULL;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static GstCaps *
+gst_vulkan_filter_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter_caps)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (bt);
+  GstVulkanFilterClass *klass = GST_VULKAN_FILTER_GET_CLASS (filter);
+  GstCaps *tmp, *result;
+  guint i, n;
+
+  if (klass->transform_internal_caps)
+    tmp = klass->transform_internal_caps (filter, direction, caps,
+        filter_caps);
+  else
+    tmp = gst_caps_ref (caps);
+
+  tmp = gst_caps_make_writable (tmp);
+  n = gst_caps_get_size (tmp);
+  for (i = 0; i < n; i++)
+    gst_caps_set_features (tmp, i,
+        gst_caps_features_from_string (GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER));
+
+  if (filter_caps) {
+    result = gst_caps_intersect_full (filter_caps, tmp,
+        GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (tmp);
+  } else {
+    result = tmp;
+  }
+
+  return result;
+}
+
+static gboolean
+gst_vulkan_filter_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
+    GstCaps * out_caps)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (bt);
+  GstVulkanFilterClass *klass = GST_VULKAN_FILTER_GET_CLASS (filter);
+
+  if (!gst_video_info_from_caps (&filter->in_info, in_caps))
+    return FALSE;
+  if (!gst_video_info_from_caps (&filter->out_info, out_caps))
+    return FALSE;
+
+  gst_caps_replace (&filter->in_caps, in_caps);
+  gst_caps_replace (&filter->out_caps, out_caps);
+
+  if (klass->set_caps)
+    return klass->set_caps (filter, in_caps, out_caps);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vulkan_filter_propose_allocation (GstBaseTransform * bt,
+    GstQuery * decide_query, GstQuery * query)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (bt);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  gboolean need_pool;
+  GstCaps *caps;
+  GstVideoInfo info;
+
+  /* passthrough */
+  if (!decide_query)
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->propose_allocation (bt,
+        decide_query, query);
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+  if (caps == NULL || !gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  if (need_pool) {
+    pool = gst_vulkan_buffer_pool_new (filter->device);
+
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, info.size, 0, 0);
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      gst_object_unref (pool);
+      return FALSE;
+    }
+  }
+
+  gst_query_add_allocation_pool (query, pool, info.size, 1, 0);
+  if (pool)
+    gst_object_unref (pool);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vulkan_filter_decide_allocation (GstBaseTransform * bt, GstQuery * query)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (bt);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  guint min = 0, max = 0, size = 0;
+  gboolean update_pool;
+  GstCaps *caps;
+  GstVideoInfo info;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+  if (!caps || !gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  update_pool = gst_query_get_n_allocation_pools (query) > 0;
+  if (update_pool)
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+
+  /* the shader can only write into Vulkan buffers of our device */
+  if (pool && !GST_IS_VULKAN_BUFFER_POOL (pool)) {
+    gst_object_unref (pool);
+    pool = NULL;
+  }
+  if (pool && GST_VULKAN_BUFFER_POOL (pool)->device != filter->device) {
+    gst_object_unref (pool);
+    pool = NULL;
+  }
+
+  if (!pool)
+    pool = gst_vulkan_buffer_pool_new (filter->device);
+
+  size = MAX (size, info.size);
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  gst_buffer_pool_set_config (pool, config);
+
+  if (update_pool)
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+  else
+    gst_query_add_allocation_pool (query, pool, size, min, max);
+
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_vulkan_filter_transform (GstBaseTransform * bt, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstVulkanFilter *filter = GST_VULKAN_FILTER (bt);
+  GstVulkanFilterClass *klass = GST_VULKAN_FILTER_GET_CLASS (filter);
+  GstMemory *planes[GST_VULKAN_FILTER_N_BINDINGS] = { NULL, };
+  VkDescriptorBufferInfo buffer_infos[GST_VULKAN_FILTER_N_BINDINGS];
+  VkWriteDescriptorSet writes[GST_VULKAN_FILTER_N_BINDINGS];
+  guint32 group_count[3] = { 1, 1, 1 };
+  gpointer push_constants;
+  GError *error = NULL;
+  VkResult err;
+  guint i;
+
+  if (!filter->pipeline && !_create_pipeline (filter, &error))
+    goto vk_error;
+
+  push_constants = g_alloca (MAX (klass->push_constants_size, 1));
+  if (!klass->prepare_dispatch (filter, inbuf, outbuf, planes, push_constants,
+          group_count)) {
+    GST_ELEMENT_ERROR (filter, STREAM, FAILED,
+        ("Failed to prepare the compute dispatch"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+
+  for (i = 0; i < GST_VULKAN_FILTER_N_BINDINGS; i++) {
+    GstVulkanBufferMemory *buf_mem = (GstVulkanBufferMemory *) planes[i];
+
+    if (!buf_mem || !gst_is_vulkan_buffer_memory (planes[i])) {
+      GST_ELEMENT_ERROR (filter, RESOURCE, NOT_FOUND,
+          ("Plane %u is not backed by Vulkan buffer memory", i), (NULL));
+      return GST_FLOW_ERROR;
+    }
+
+    buffer_infos[i].buffer = buf_mem->buffer;
+    buffer_infos[i].offset = 0;
+    buffer_infos[i].range = VK_WHOLE_SIZE;
+
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].pNext = NULL;
+    writes[i].dstSet = filter->descriptor_set;
+    writes[i].dstBinding = i;
+    writes[i].dstArrayElement = 0;
+    writes[i].descriptorCount = 1;
+    writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[i].pImageInfo = NULL;
+    writes[i].pBufferInfo = &buffer_infos[i];
+    writes[i].pTexelBufferView = NULL;
+  }
+  /* the previous dispatch finished, the set is not in use anymore */
+  vkUpdateDescriptorSets (filter->device->device,
+      GST_VULKAN_FILTER_N_BINDINGS, writes, 0, NULL);
+
+  {
+    VkCommandBufferBeginInfo begin_info = { 0, };
+    VkMemoryBarrier barrier = { 0, };
+
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    err = vkBeginCommandBuffer (filter->cmd, &begin_info);
+    if (gst_vulkan_error_to_g_error (err, &error, "vkBeginCommandBuffer") < 0)
+      goto vk_error;
+
+    vkCmdBindPipeline (filter->cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+        filter->pipeline);
+    vkCmdBindDescriptorSets (filter->cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+        filter->pipeline_layout, 0, 1, &filter->descriptor_set, 0, NULL);
+    if (klass->push_constants_size > 0)
+      vkCmdPushConstants (filter->cmd, filter->pipeline_layout,
+          VK_SHADER_STAGE_COMPUTE_BIT, 0, klass->push_constants_size,
+          push_constants);
+    vkCmdDispatch (filter->cmd, group_count[0], group_count[1],
+        group_count[2]);
+
+    /* the output may be read back by the host */
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT |
+        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier (filter->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT |
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0,
+        NULL);
+
+    err = vkEndCommandBuffer (filter->cmd);
+    if (gst_vulkan_error_to_g_error (err, &error, "vkEndCommandBuffer") < 0)
+      goto vk_error;
+  }
+
+  err = vkResetFences (filter->device->device, 1, &filter->fence->fence);
+  if (gst_vulkan_error_to_g_error (err, &error, "vkResetFences") < 0)
+    goto vk_error;
+
+  {
+    VkSubmitInfo submit_info = { 0, };
+
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &filter->cmd;
+
+    err = vkQueueSubmit (filter->queue->queue, 1, &submit_info,
+        GST_VULKAN_FENCE_FENCE (filter->fence));
+    if (gst_vulkan_error_to_g_error (err, &error, "vkQueueSubmit") < 0)
+      goto vk_error;
+  }
+
+  /* downstream accesses the output without any further synchronisation */
+  if (!gst_vulkan_fence_wait (filter->fence, DISPATCH_FENCE_TIMEOUT, &error))
+    goto vk_error;
+
+  return GST_FLOW_OK;
+
+vk_error:
+  {
+    GST_ELEMENT_ERROR (filter, RESOURCE, FAILED, ("%s", error->message),
+        (NULL));
+    g_clear_error (&error);
+    return GST_FLOW_ERROR;
+  }
+}
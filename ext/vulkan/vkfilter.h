@@ -0,0 +1,116 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _VK_FILTER_H_
+#define _VK_FILTER_H_
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <vk.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_VULKAN_FILTER            (gst_vulkan_filter_get_type())
+#define GST_VULKAN_FILTER(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_VULKAN_FILTER,GstVulkanFilter))
+#define GST_VULKAN_FILTER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_VULKAN_FILTER,GstVulkanFilterClass))
+#define GST_IS_VULKAN_FILTER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_VULKAN_FILTER))
+#define GST_IS_VULKAN_FILTER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_VULKAN_FILTER))
+#define GST_VULKAN_FILTER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj),GST_TYPE_VULKAN_FILTER,GstVulkanFilterClass))
+
+/* the planes of the input frame are bound to the first
+ * GST_VULKAN_FILTER_MAX_PLANES storage buffers, followed by the planes of the
+ * output frame */
+#define GST_VULKAN_FILTER_MAX_PLANES 3
+#define GST_VULKAN_FILTER_N_BINDINGS (2 * GST_VULKAN_FILTER_MAX_PLANES)
+
+typedef struct _GstVulkanFilter GstVulkanFilter;
+typedef struct _GstVulkanFilterClass GstVulkanFilterClass;
+
+/**
+ * GstVulkanFilter:
+ *
+ * Runs a compute shader over each buffer, with the planes of the input and
+ * output buffers bound as storage buffers.  The pipeline, descriptor set,
+ * command buffer and fence are created once and reused for every buffer.
+ */
+struct _GstVulkanFilter
+{
+  GstBaseTransform      parent;
+
+  GstVulkanInstance     *instance;
+  GstVulkanDevice       *device;
+  GstVulkanQueue        *queue;
+
+  GstVulkanDisplay      *display;
+
+  GstCaps               *in_caps;
+  GstCaps               *out_caps;
+  GstVideoInfo          in_info;
+  GstVideoInfo          out_info;
+
+  /* <private> */
+  VkShaderModule        shader;
+  VkDescriptorSetLayout set_layout;
+  VkPipelineLayout      pipeline_layout;
+  VkPipeline            pipeline;
+  VkDescriptorPool      descriptor_pool;
+  VkDescriptorSet       descriptor_set;
+  VkCommandPool         cmd_pool;
+  VkCommandBuffer       cmd;
+  GstVulkanFence        *fence;
+};
+
+/**
+ * GstVulkanFilterClass:
+ * @shader_code: the SPIR-V code of the compute shader
+ * @shader_size: the size of @shader_code in bytes
+ * @push_constants_size: the size of the push constants of the shader
+ * @transform_internal_caps: transforms caps without the memory features
+ * @set_caps: called with the negotiated caps
+ * @prepare_dispatch: fills the planes to bind, the push constants and the
+ *   number of workgroups to dispatch for the given buffers
+ */
+struct _GstVulkanFilterClass
+{
+  GstBaseTransformClass parent_class;
+
+  const guint32 *shader_code;
+  gsize shader_size;
+  guint push_constants_size;
+
+  GstCaps *     (*transform_internal_caps)  (GstVulkanFilter * filter,
+                                             GstPadDirection direction,
+                                             GstCaps * caps,
+                                             GstCaps * filter_caps);
+  gboolean      (*set_caps)                 (GstVulkanFilter * filter,
+                                             GstCaps * in_caps,
+                                             GstCaps * out_caps);
+  gboolean      (*prepare_dispatch)         (GstVulkanFilter * filter,
+                                             GstBuffer * inbuf,
+                                             GstBuffer * outbuf,
+                                             GstMemory * planes[GST_VULKAN_FILTER_N_BINDINGS],
+                                             gpointer push_constants,
+                                             guint32 group_count[3]);
+};
+
+GType gst_vulkan_filter_get_type(void);
+
+G_END_DECLS
+
+#endif
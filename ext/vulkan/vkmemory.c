@@ -26,6 +26,10 @@
 
 #include "vkmemory.h"
 
+#ifdef VK_EXT_external_memory_dma_buf
+#include <unistd.h>
+#endif
+
 /**
  * SECTION:vkmemory
  * @title: GstVkMemory
@@ -296,6 +300,59 @@ gst_vulkan_memory_alloc (GstVulkanDevice * device, guint32 memory_type_index,
   return (GstMemory *) mem;
 }
 
+#ifdef VK_EXT_external_memory_dma_buf
+/**
+ * gst_vulkan_memory_import_dmabuf:
+ * @device:a #GstVulkanDevice
+ * @fd: a dmabuf file descriptor
+ * @memory_type_index: the Vulkan memory type index
+ * @size: the size of the dmabuf
+ *
+ * Imports the dmabuf @fd as a new #GstVulkanMemory.  @device must have
+ * the VK_EXT_external_memory_dma_buf extension enabled.  @fd is duplicated.
+ *
+ * Returns: a #GstMemory object backed by the imported dmabuf
+ */
+GstMemory *
+gst_vulkan_memory_import_dmabuf (GstVulkanDevice * device, gint fd,
+    guint32 memory_type_index, gsize size)
+{
+  VkImportMemoryFdInfoKHR import_info = { 0, };
+  GstVulkanMemory *mem;
+  GError *error = NULL;
+  VkResult err;
+
+  g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), NULL);
+  g_return_val_if_fail (fd >= 0, NULL);
+
+  mem = g_new0 (GstVulkanMemory, 1);
+  _vk_mem_init (mem, _vulkan_memory_allocator, NULL, device,
+      memory_type_index, NULL, size,
+      device->memory_properties.memoryTypes[memory_type_index].propertyFlags,
+      NULL, NULL);
+
+  /* the driver owns the fd after a successful import */
+  import_info.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR;
+  import_info.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+  import_info.fd = dup (fd);
+  mem->alloc_info.pNext = &import_info;
+
+  err =
+      vkAllocateMemory (device->device, &mem->alloc_info, NULL, &mem->mem_ptr);
+  mem->alloc_info.pNext = NULL;
+  if (gst_vulkan_error_to_g_error (err, &error, "vkAllocMemory") < 0) {
+    GST_CAT_ERROR (GST_CAT_VULKAN_MEMORY, "Failed to import dmabuf %d %s", fd,
+        error->message);
+    close (import_info.fd);
+    gst_memory_unref ((GstMemory *) mem);
+    g_clear_error (&error);
+    return NULL;
+  }
+
+  return (GstMemory *) mem;
+}
+#endif
+
 G_DEFINE_TYPE (GstVulkanMemoryAllocator, gst_vulkan_memory_allocator,
     GST_TYPE_ALLOCATOR);
 
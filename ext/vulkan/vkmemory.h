@@ -96,6 +96,13 @@ GstMemory *     gst_vulkan_memory_alloc         (GstVulkanDevice * device,
                                                  gsize size,
                                                  VkMemoryPropertyFlags mem_prop_flags);
 
+#ifdef VK_EXT_external_memory_dma_buf
+GstMemory *     gst_vulkan_memory_import_dmabuf (GstVulkanDevice * device,
+                                                 gint fd,
+                                                 guint32 memory_type_index,
+                                                 gsize size);
+#endif
+
 gboolean        gst_vulkan_memory_find_memory_type_index_with_type_properties   (GstVulkanDevice * device,
                                                                                  guint32 typeBits,
                                                                                  VkMemoryPropertyFlags properties,
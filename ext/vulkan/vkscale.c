@@ -0,0 +1,135 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vulkanscale
+ * @title: vulkanscale
+ *
+ * vulkanscale resizes frames in Vulkan buffers with bilinear filtering in a
+ * compute shader.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 videotestsrc ! vulkanupload ! vulkanscale ! video/x-raw(memory:VulkanBuffer),width=1280,height=720 ! vulkansink
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vkscale.h"
+#include "vkvideoconvert.h"
+
+GST_DEBUG_CATEGORY (gst_debug_vulkan_scale);
+#define GST_CAT_DEFAULT gst_debug_vulkan_scale
+
+static GstCaps *gst_vulkan_scale_transform_internal_caps (GstVulkanFilter *
+    filter, GstPadDirection direction, GstCaps * caps, GstCaps * filter_caps);
+static GstCaps *gst_vulkan_scale_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps);
+
+#define gst_vulkan_scale_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstVulkanScale, gst_vulkan_scale,
+    GST_TYPE_VULKAN_FILTER, GST_DEBUG_CATEGORY_INIT (gst_debug_vulkan_scale,
+        "vulkanscale", 0, "Vulkan Scale"));
+
+static void
+gst_vulkan_scale_class_init (GstVulkanScaleClass * klass)
+{
+  GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstBaseTransformClass *gstbasetransform_class =
+      (GstBaseTransformClass *) klass;
+  GstVulkanFilterClass *filter_class = (GstVulkanFilterClass *) klass;
+  GstCaps *caps;
+
+  gst_element_class_set_metadata (gstelement_class, "Vulkan Scale",
+      "Filter/Effect/Video", "Resizes video with Vulkan",
+      "Matthew Waters <matthew@centricular.com>");
+
+  caps = gst_caps_from_string (GST_VULKAN_VIDEO_CONVERT_CAPS);
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS, caps));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS, caps));
+  gst_caps_unref (caps);
+
+  gst_vulkan_video_convert_class_init (filter_class);
+  filter_class->transform_internal_caps =
+      gst_vulkan_scale_transform_internal_caps;
+  gstbasetransform_class->fixate_caps = gst_vulkan_scale_fixate_caps;
+}
+
+static void
+gst_vulkan_scale_init (GstVulkanScale * scale)
+{
+}
+
+static GstCaps *
+gst_vulkan_scale_transform_internal_caps (GstVulkanFilter * filter,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter_caps)
+{
+  GstCaps *res;
+  guint i, n;
+
+  /* the unscaled caps come first so that they are preferred */
+  res = gst_caps_copy (caps);
+  n = gst_caps_get_size (res);
+  for (i = 0; i < n; i++) {
+    GstStructure *s = gst_structure_copy (gst_caps_get_structure (res, i));
+
+    gst_structure_set (s, "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+        "height", GST_TYPE_INT_RANGE, 1, G_MAXINT, NULL);
+    if (gst_structure_has_field (s, "pixel-aspect-ratio"))
+      gst_structure_set (s, "pixel-aspect-ratio", GST_TYPE_FRACTION_RANGE, 1,
+          G_MAXINT, G_MAXINT, 1, NULL);
+    res = gst_caps_merge_structure (res, s);
+  }
+
+  return res;
+}
+
+/* keeps the size of the input where downstream allows it */
+static GstCaps *
+gst_vulkan_scale_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstStructure *ins, *outs;
+  gint width = 0, height = 0, par_n = 1, par_d = 1;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+
+  gst_structure_get_int (ins, "width", &width);
+  gst_structure_get_int (ins, "height", &height);
+  gst_structure_get_fraction (ins, "pixel-aspect-ratio", &par_n, &par_d);
+
+  if (width)
+    gst_structure_fixate_field_nearest_int (outs, "width", width);
+  if (height)
+    gst_structure_fixate_field_nearest_int (outs, "height", height);
+  if (gst_structure_has_field (outs, "pixel-aspect-ratio"))
+    gst_structure_fixate_field_nearest_fraction (outs, "pixel-aspect-ratio",
+        par_n, par_d);
+
+  return gst_caps_fixate (othercaps);
+}
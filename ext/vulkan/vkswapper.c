@@ -38,11 +38,32 @@ G_DEFINE_TYPE_WITH_CODE (GstVulkanSwapper, gst_vulkan_swapper,
 #define RENDER_LOCK(o) g_mutex_lock (RENDER_GET_LOCK(o));
 #define RENDER_UNLOCK(o) g_mutex_unlock (RENDER_GET_LOCK(o));
 
+/* Number of frames that may be submitted before waiting on the oldest one */
+#define MAX_FRAMES_IN_FLIGHT 3
+
+/* The resources of one submitted frame.  Frames complete in submission
+ * order, so once the fence of the oldest frame is signaled its command
+ * buffer, semaphore and buffer can be reused without any allocation */
+struct frame_slot
+{
+  VkCommandBuffer cmd;
+  VkSemaphore acquire_semaphore;
+  GstVulkanFence *fence;
+  GstBuffer *buffer;
+};
+
 struct _GstVulkanSwapperPrivate
 {
   GMutex render_lock;
 
   GList *trash_list;
+
+  struct frame_slot frames[MAX_FRAMES_IN_FLIGHT];
+  guint frame_idx;
+
+  /* one per swap chain image, waited on by the presentation engine */
+  VkSemaphore *present_semaphores;
+  guint32 n_present_semaphores;
 };
 
 static void _on_window_draw (GstVulkanWindow * window,
@@ -329,6 +350,74 @@ _on_window_close (GstVulkanWindow * window, GstVulkanSwapper * swapper)
   return TRUE;
 }
 
+static gboolean
+_wait_frame_slot (GstVulkanSwapper * swapper, struct frame_slot *slot,
+    GError ** error)
+{
+  if (slot->fence) {
+    if (!gst_vulkan_fence_wait (slot->fence, -1, error))
+      return FALSE;
+    /* returns the fence to the device */
+    gst_vulkan_fence_unref (slot->fence);
+    slot->fence = NULL;
+  }
+  gst_buffer_replace (&slot->buffer, NULL);
+
+  return TRUE;
+}
+
+static void
+_free_frame_slot (GstVulkanSwapper * swapper, struct frame_slot *slot)
+{
+  if (!_wait_frame_slot (swapper, slot, NULL))
+    GST_WARNING_OBJECT (swapper, "Failed to wait for a frame to complete "
+        "before freeing it");
+
+  if (slot->cmd)
+    vkFreeCommandBuffers (swapper->device->device, swapper->device->cmd_pool,
+        1, &slot->cmd);
+  slot->cmd = VK_NULL_HANDLE;
+
+  if (slot->acquire_semaphore)
+    vkDestroySemaphore (swapper->device->device, slot->acquire_semaphore,
+        NULL);
+  slot->acquire_semaphore = VK_NULL_HANDLE;
+}
+
+static void
+_free_present_semaphores (GstVulkanSwapper * swapper)
+{
+  guint32 i;
+
+  for (i = 0; i < swapper->priv->n_present_semaphores; i++) {
+    if (swapper->priv->present_semaphores[i])
+      vkDestroySemaphore (swapper->device->device,
+          swapper->priv->present_semaphores[i], NULL);
+  }
+  g_free (swapper->priv->present_semaphores);
+  swapper->priv->present_semaphores = NULL;
+  swapper->priv->n_present_semaphores = 0;
+}
+
+static VkSemaphore
+_create_semaphore (GstVulkanSwapper * swapper, GError ** error)
+{
+  VkSemaphoreCreateInfo semaphore_info = { 0, };
+  VkSemaphore semaphore;
+  VkResult err;
+
+  semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphore_info.pNext = NULL;
+  semaphore_info.flags = 0;
+
+  err = vkCreateSemaphore (swapper->device->device, &semaphore_info,
+      NULL, &semaphore);
+  if (gst_vulkan_error_to_g_error (err, error, "vkCreateSemaphore") < 0)
+    return VK_NULL_HANDLE;
+
+  return semaphore;
+}
+
 static void
 gst_vulkan_swapper_finalize (GObject * object)
 {
@@ -340,6 +429,13 @@ gst_vulkan_swapper_finalize (GObject * object)
         "before shutting down");
   swapper->priv->trash_list = NULL;
 
+  /* also covers the pending presentations waiting on the semaphores */
+  if (swapper->queue)
+    vkQueueWaitIdle (swapper->queue->queue);
+  for (i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    _free_frame_slot (swapper, &swapper->priv->frames[i]);
+  _free_present_semaphores (swapper);
+
   if (swapper->swap_chain_images) {
     for (i = 0; i < swapper->n_swap_chain_images; i++) {
       gst_memory_unref ((GstMemory *) swapper->swap_chain_images[i]);
@@ -507,7 +603,7 @@ _swapper_set_image_layout (GstVulkanSwapper * swapper,
   if (!gst_vulkan_device_create_cmd_buffer (swapper->device, &cmd, error))
     goto error;
 
-  fence = gst_vulkan_fence_new (swapper->device, 0, error);
+  fence = gst_vulkan_device_acquire_fence (swapper->device, error);
   if (!fence)
     goto error;
 
@@ -748,8 +844,21 @@ _allocate_swapchain (GstVulkanSwapper * swapper, GstCaps * caps,
       return FALSE;
     }
   }
-
   g_free (swap_chain_images);
+
+  if (swapper->priv->n_present_semaphores != swapper->n_swap_chain_images) {
+    _free_present_semaphores (swapper);
+    swapper->priv->present_semaphores =
+        g_new0 (VkSemaphore, swapper->n_swap_chain_images);
+    swapper->priv->n_present_semaphores = swapper->n_swap_chain_images;
+    for (i = 0; i < swapper->n_swap_chain_images; i++) {
+      swapper->priv->present_semaphores[i] =
+          _create_semaphore (swapper, error);
+      if (!swapper->priv->present_semaphores[i])
+        return FALSE;
+    }
+  }
+
   return TRUE;
 }
 
@@ -764,6 +873,11 @@ _swapchain_resize (GstVulkanSwapper * swapper, GError ** error)
     }
   }
 
+  /* the present semaphores may be replaced and the swap chain images are
+   * still used by the pending frames */
+  if (swapper->queue)
+    vkQueueWaitIdle (swapper->queue->queue);
+
   if (swapper->swap_chain_images) {
     for (i = 0; i < swapper->n_swap_chain_images; i++) {
       if (swapper->swap_chain_images[i])
@@ -793,19 +907,15 @@ gst_vulkan_swapper_set_caps (GstVulkanSwapper * swapper, GstCaps * caps,
 
 static gboolean
 _build_render_buffer_cmd (GstVulkanSwapper * swapper, guint32 swap_idx,
-    GstBuffer * buffer, VkCommandBuffer * cmd_ret, GError ** error)
+    GstBuffer * buffer, VkCommandBuffer cmd, GError ** error)
 {
   GstVulkanBufferMemory *buf_mem;
   GstVulkanImageMemory *swap_mem;
-  VkCommandBuffer cmd;
   VkResult err;
 
   g_return_val_if_fail (swap_idx < swapper->n_swap_chain_images, FALSE);
   swap_mem = swapper->swap_chain_images[swap_idx];
 
-  if (!gst_vulkan_device_create_cmd_buffer (swapper->device, &cmd, error))
-    return FALSE;
-
   buf_mem = (GstVulkanBufferMemory *) gst_buffer_peek_memory (buffer, 0);
 
   {
@@ -839,11 +949,20 @@ _build_render_buffer_cmd (GstVulkanSwapper * swapper, guint32 swap_idx,
   {
     VkBufferImageCopy region = { 0, };
     GstVideoRectangle src, dst, rslt;
+    GstVideoMeta *meta;
+    guint row_length;
 
     src.x = src.y = 0;
     src.w = GST_VIDEO_INFO_WIDTH (&swapper->v_info);
     src.h = GST_VIDEO_INFO_HEIGHT (&swapper->v_info);
 
+    /* imported buffers keep the stride of their producer */
+    row_length = src.w;
+    meta = gst_buffer_get_video_meta (buffer);
+    if (meta && GST_VIDEO_INFO_COMP_PSTRIDE (&swapper->v_info, 0) > 0)
+      row_length = meta->stride[0] /
+          GST_VIDEO_INFO_COMP_PSTRIDE (&swapper->v_info, 0);
+
     dst.x = dst.y = 0;
     dst.w = gst_vulkan_image_memory_get_width (swap_mem);
     dst.h = gst_vulkan_image_memory_get_height (swap_mem);
@@ -853,7 +972,7 @@ _build_render_buffer_cmd (GstVulkanSwapper * swapper, guint32 swap_idx,
     GST_TRACE_OBJECT (swapper, "rendering into result rectangle %ux%u+%u,%u "
         "src %ux%u dst %ux%u", rslt.w, rslt.h, rslt.x, rslt.y, src.w, src.h,
         dst.w, dst.h);
-    GST_VK_BUFFER_IMAGE_COPY (region, 0, src.w, src.h,
+    GST_VK_BUFFER_IMAGE_COPY (region, 0, row_length, src.h,
         GST_VK_IMAGE_SUBRESOURCE_LAYERS_INIT (VK_IMAGE_ASPECT_COLOR_BIT, 0, 0,
             1), GST_VK_OFFSET3D_INIT (rslt.x, rslt.y, 0),
         GST_VK_EXTENT3D_INIT (rslt.w, rslt.h, 1));
@@ -871,8 +990,6 @@ _build_render_buffer_cmd (GstVulkanSwapper * swapper, guint32 swap_idx,
   if (gst_vulkan_error_to_g_error (err, error, "vkEndCommandBuffer") < 0)
     return FALSE;
 
-  *cmd_ret = cmd;
-
   return TRUE;
 }
 
@@ -880,65 +997,69 @@ static gboolean
 _render_buffer_unlocked (GstVulkanSwapper * swapper,
     GstBuffer * buffer, GError ** error)
 {
-  VkSemaphore acquire_semaphore = { 0, };
-  VkSemaphore present_semaphore = { 0, };
-  VkSemaphoreCreateInfo semaphore_info = { 0, };
+  struct frame_slot *slot;
   GstVulkanFence *fence = NULL;
   VkPresentInfoKHR present;
-  VkCommandBuffer cmd = VK_NULL_HANDLE;
+  VkSemaphore present_semaphore;
   guint32 swap_idx;
   VkResult err, present_err = VK_SUCCESS;
 
-  swapper->priv->trash_list =
-      gst_vulkan_trash_list_gc (swapper->priv->trash_list);
-
-  semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-  semaphore_info.pNext = NULL;
-  semaphore_info.flags = 0;
+  if (swapper->priv->trash_list)
+    swapper->priv->trash_list =
+        gst_vulkan_trash_list_gc (swapper->priv->trash_list);
 
   if (!buffer) {
     g_set_error (error, GST_VULKAN_ERROR,
         VK_ERROR_INITIALIZATION_FAILED, "Invalid buffer");
-    goto error;
+    return FALSE;
   }
 
   if (g_atomic_int_get (&swapper->to_quit)) {
     g_set_error (error, GST_VULKAN_ERROR, VK_ERROR_SURFACE_LOST_KHR,
         "Output window was closed");
-    goto error;
+    return FALSE;
   }
 
   gst_buffer_replace (&swapper->current_buffer, buffer);
 
-reacquire:
-  err = vkCreateSemaphore (swapper->device->device, &semaphore_info,
-      NULL, &acquire_semaphore);
-  if (gst_vulkan_error_to_g_error (err, error, "vkCreateSemaphore") < 0)
-    goto error;
+  /* the oldest frame in flight, its resources are free once it completed */
+  slot = &swapper->priv->frames[swapper->priv->frame_idx];
+  if (!_wait_frame_slot (swapper, slot, error))
+    return FALSE;
 
+  if (!slot->acquire_semaphore) {
+    slot->acquire_semaphore = _create_semaphore (swapper, error);
+    if (!slot->acquire_semaphore)
+      return FALSE;
+  }
+
+  if (!slot->cmd
+      && !gst_vulkan_device_create_cmd_buffer (swapper->device, &slot->cmd,
+          error))
+    return FALSE;
+
+reacquire:
   err =
       swapper->AcquireNextImageKHR (swapper->device->device,
-      swapper->swap_chain, -1, acquire_semaphore, VK_NULL_HANDLE, &swap_idx);
+      swapper->swap_chain, -1, slot->acquire_semaphore, VK_NULL_HANDLE,
+      &swap_idx);
   /* TODO: Deal with the VK_SUBOPTIMAL_KHR and VK_ERROR_OUT_OF_DATE_KHR */
   if (err == VK_ERROR_OUT_OF_DATE_KHR) {
     GST_DEBUG_OBJECT (swapper, "out of date frame acquired");
 
-    vkDestroySemaphore (swapper->device->device, acquire_semaphore, NULL);
+    /* the semaphore is left unsignaled and can be used again */
     if (!_swapchain_resize (swapper, error))
-      goto error;
+      return FALSE;
     goto reacquire;
   } else if (gst_vulkan_error_to_g_error (err, error,
           "vkAcquireNextImageKHR") < 0) {
-    goto error;
+    return FALSE;
   }
 
-  if (!_build_render_buffer_cmd (swapper, swap_idx, buffer, &cmd, error))
-    goto error;
+  if (!_build_render_buffer_cmd (swapper, swap_idx, buffer, slot->cmd, error))
+    goto drop_semaphore;
 
-  err = vkCreateSemaphore (swapper->device->device, &semaphore_info,
-      NULL, &present_semaphore);
-  if (gst_vulkan_error_to_g_error (err, error, "vkCreateSemaphore") < 0)
-    goto error;
+  present_semaphore = swapper->priv->present_semaphores[swap_idx];
 
   {
     VkSubmitInfo submit_info = { 0, };
@@ -947,31 +1068,30 @@ reacquire:
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submit_info.pNext = NULL;
     submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = &acquire_semaphore;
+    submit_info.pWaitSemaphores = &slot->acquire_semaphore;
     submit_info.pWaitDstStageMask = &stages;
     submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &cmd;
+    submit_info.pCommandBuffers = &slot->cmd;
     submit_info.signalSemaphoreCount = 1;
     submit_info.pSignalSemaphores = &present_semaphore;
 
-    fence = gst_vulkan_fence_new (swapper->device, 0, error);
+    fence = gst_vulkan_device_acquire_fence (swapper->device, error);
     if (!fence)
-      goto error;
+      goto drop_semaphore;
 
     err =
         vkQueueSubmit (swapper->queue->queue, 1, &submit_info,
         GST_VULKAN_FENCE_FENCE (fence));
-    if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
-      goto error;
-
-    swapper->priv->trash_list = g_list_prepend (swapper->priv->trash_list,
-        gst_vulkan_trash_new_free_command_buffer (gst_vulkan_fence_ref (fence),
-            cmd));
-    swapper->priv->trash_list = g_list_prepend (swapper->priv->trash_list,
-        gst_vulkan_trash_new_free_semaphore (fence, acquire_semaphore));
+    if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0) {
+      gst_vulkan_fence_unref (fence);
+      goto drop_semaphore;
+    }
 
-    cmd = VK_NULL_HANDLE;
-    fence = NULL;
+    /* the buffer is read by the copy until the fence is signaled */
+    slot->fence = fence;
+    slot->buffer = gst_buffer_ref (buffer);
+    swapper->priv->frame_idx =
+        (swapper->priv->frame_idx + 1) % MAX_FRAMES_IN_FLIGHT;
   }
 
   present.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -985,51 +1105,24 @@ reacquire:
 
   err = swapper->QueuePresentKHR (swapper->queue->queue, &present);
   if (gst_vulkan_error_to_g_error (err, error, "vkQueuePresentKHR") < 0)
-    goto error;
+    return FALSE;
 
   if (present_err == VK_ERROR_OUT_OF_DATE_KHR) {
     GST_DEBUG_OBJECT (swapper, "out of date frame submitted");
 
     if (!_swapchain_resize (swapper, error))
-      goto error;
+      return FALSE;
   } else if (gst_vulkan_error_to_g_error (err, error, "vkQueuePresentKHR") < 0)
-    goto error;
-
-  {
-    VkSubmitInfo submit_info = { 0, };
-    VkPipelineStageFlags stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-
-    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.pWaitDstStageMask = &stages;
-
-    fence = gst_vulkan_fence_new (swapper->device, 0, error);
-    if (!fence)
-      goto error;
-
-    err =
-        vkQueueSubmit (swapper->queue->queue, 1, &submit_info,
-        GST_VULKAN_FENCE_FENCE (fence));
-    if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
-      goto error;
-
-    swapper->priv->trash_list = g_list_prepend (swapper->priv->trash_list,
-        gst_vulkan_trash_new_free_semaphore (fence, present_semaphore));
-    fence = NULL;
-  }
+    return FALSE;
 
   return TRUE;
 
-error:
-  {
-    if (acquire_semaphore)
-      vkDestroySemaphore (swapper->device->device, acquire_semaphore, NULL);
-    if (present_semaphore)
-      vkDestroySemaphore (swapper->device->device, present_semaphore, NULL);
-    if (cmd)
-      vkFreeCommandBuffers (swapper->device->device, swapper->device->cmd_pool,
-          1, &cmd);
-    return FALSE;
-  }
+drop_semaphore:
+  /* the acquired image signals the semaphore without anyone waiting on it */
+  vkQueueWaitIdle (swapper->queue->queue);
+  vkDestroySemaphore (swapper->device->device, slot->acquire_semaphore, NULL);
+  slot->acquire_semaphore = VK_NULL_HANDLE;
+  return FALSE;
 }
 
 gboolean
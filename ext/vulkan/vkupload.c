@@ -31,6 +31,8 @@
 
 #include <string.h>
 
+#include <gst/allocators/gstdmabuf.h>
+
 #include "vkupload.h"
 
 GST_DEBUG_CATEGORY (gst_debug_vulkan_upload);
@@ -180,6 +182,200 @@ static const struct UploadMethod buffer_upload = {
   _buffer_free,
 };
 
+#ifdef VK_EXT_external_memory_dma_buf
+struct DmabufUpload
+{
+  GstVulkanUpload *upload;
+
+  GstVideoInfo in_info;
+};
+
+static GQuark
+_dmabuf_upload_quark (guint plane)
+{
+  static GQuark quarks[GST_VIDEO_MAX_PLANES] = { 0, };
+
+  if (!quarks[plane]) {
+    gchar *name = g_strdup_printf ("GstVulkanDmabufUploadPlane%u", plane);
+    quarks[plane] = g_quark_from_string (name);
+    g_free (name);
+  }
+
+  return quarks[plane];
+}
+
+static gpointer
+_dmabuf_new_impl (GstVulkanUpload * upload)
+{
+  struct DmabufUpload *dmabuf = g_new0 (struct DmabufUpload, 1);
+
+  dmabuf->upload = upload;
+
+  return dmabuf;
+}
+
+static GstCaps *
+_dmabuf_transform_caps (gpointer impl, GstPadDirection direction,
+    GstCaps * caps)
+{
+  GstCaps *ret;
+
+  if (direction == GST_PAD_SINK) {
+    ret =
+        _set_caps_features_with_passthrough (caps,
+        GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER, NULL);
+  } else {
+    ret =
+        _set_caps_features_with_passthrough (caps,
+        GST_CAPS_FEATURE_MEMORY_DMABUF, NULL);
+  }
+
+  return ret;
+}
+
+static gboolean
+_dmabuf_set_caps (gpointer impl, GstCaps * in_caps, GstCaps * out_caps)
+{
+  struct DmabufUpload *dmabuf = impl;
+
+  if (!dmabuf->upload->device
+      || !gst_vulkan_device_is_extension_enabled (dmabuf->upload->device,
+          VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME))
+    return FALSE;
+
+  return gst_video_info_from_caps (&dmabuf->in_info, in_caps);
+}
+
+static void
+_dmabuf_propose_allocation (gpointer impl, GstQuery * decide_query,
+    GstQuery * query)
+{
+  /* dmabufs come from the upstream allocator */
+}
+
+/* Imports the plane of @inbuf, reusing the import of a previous buffer when
+ * upstream recycles its dmabufs */
+static GstMemory *
+_dmabuf_import_plane (struct DmabufUpload * dmabuf, GstBuffer * inbuf,
+    guint plane, gsize offset, gsize size)
+{
+  GstVulkanDevice *device = dmabuf->upload->device;
+  GstVulkanBufferMemory *vk_mem;
+  gsize mem_skip, mem_offset, mem_maxsize;
+  guint mem_idx, mem_len;
+  GstMemory *mem;
+  GQuark quark;
+
+  if (!gst_buffer_find_memory (inbuf, offset, size, &mem_idx, &mem_len,
+          &mem_skip) || mem_len != 1)
+    return NULL;
+
+  mem = gst_buffer_peek_memory (inbuf, mem_idx);
+  if (!gst_is_dmabuf_memory (mem))
+    return NULL;
+
+  gst_memory_get_sizes (mem, &mem_offset, &mem_maxsize);
+  offset = mem_offset + mem_skip;
+
+  quark = _dmabuf_upload_quark (plane);
+  vk_mem = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (mem), quark);
+  if (vk_mem && vk_mem->device == device
+      && GST_MEMORY_CAST (vk_mem)->size >= size)
+    return gst_memory_ref (GST_MEMORY_CAST (vk_mem));
+
+  vk_mem = (GstVulkanBufferMemory *)
+      gst_vulkan_buffer_memory_import_dmabuf (device,
+      gst_vulkan_format_from_video_format (GST_VIDEO_INFO_FORMAT
+          (&dmabuf->in_info), plane), gst_dmabuf_memory_get_fd (mem),
+      mem_maxsize, offset, size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+  if (!vk_mem)
+    return NULL;
+
+  GST_LOG_OBJECT (dmabuf->upload, "imported plane %u of dmabuf %d at offset %"
+      G_GSIZE_FORMAT, plane, gst_dmabuf_memory_get_fd (mem), offset);
+
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem), quark,
+      gst_memory_ref (GST_MEMORY_CAST (vk_mem)),
+      (GDestroyNotify) gst_memory_unref);
+
+  return GST_MEMORY_CAST (vk_mem);
+}
+
+static GstFlowReturn
+_dmabuf_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
+{
+  struct DmabufUpload *dmabuf = impl;
+  GstVideoInfo *info = &dmabuf->in_info;
+  gsize offsets[GST_VIDEO_MAX_PLANES];
+  gint strides[GST_VIDEO_MAX_PLANES];
+  GstVideoMeta *meta;
+  gsize out_offset = 0;
+  guint i;
+
+  meta = gst_buffer_get_video_meta (inbuf);
+
+  *outbuf = gst_buffer_new ();
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (info); i++) {
+    gsize offset, size;
+    GstMemory *mem;
+    gint stride;
+
+    offset = meta ? meta->offset[i] : GST_VIDEO_INFO_PLANE_OFFSET (info, i);
+    stride = meta ? meta->stride[i] : GST_VIDEO_INFO_PLANE_STRIDE (info, i);
+    size = stride * GST_VIDEO_INFO_COMP_HEIGHT (info, i);
+
+    mem = _dmabuf_import_plane (dmabuf, inbuf, i, offset, size);
+    if (!mem) {
+      GST_DEBUG_OBJECT (dmabuf->upload, "could not import plane %u", i);
+      gst_buffer_unref (*outbuf);
+      *outbuf = NULL;
+      return GST_FLOW_ERROR;
+    }
+
+    offsets[i] = out_offset;
+    strides[i] = stride;
+    out_offset += gst_memory_get_sizes (mem, NULL, NULL);
+    gst_buffer_append_memory (*outbuf, mem);
+  }
+
+  gst_buffer_add_video_meta_full (*outbuf, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info),
+      GST_VIDEO_INFO_HEIGHT (info), GST_VIDEO_INFO_N_PLANES (info), offsets,
+      strides);
+
+  /* the imported memory aliases the dmabufs of @inbuf */
+  gst_buffer_add_parent_buffer_meta (*outbuf, inbuf);
+
+  return GST_FLOW_OK;
+}
+
+static void
+_dmabuf_free (gpointer impl)
+{
+  g_free (impl);
+}
+
+static GstStaticCaps _dmabuf_in_templ =
+    GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_DMABUF ") ;"
+    "video/x-raw");
+static GstStaticCaps _dmabuf_out_templ =
+GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER ")");
+
+static const struct UploadMethod dmabuf_upload = {
+  "DmabufToVulkanBuffer",
+  &_dmabuf_in_templ,
+  &_dmabuf_out_templ,
+  _dmabuf_new_impl,
+  _dmabuf_transform_caps,
+  _dmabuf_set_caps,
+  _dmabuf_propose_allocation,
+  _dmabuf_perform,
+  _dmabuf_free,
+};
+#endif
+
 struct RawToBufferUpload
 {
   GstVulkanUpload *upload;
@@ -369,6 +565,9 @@ static const struct UploadMethod raw_to_buffer_upload = {
 
 static const struct UploadMethod *upload_methods[] = {
   &buffer_upload,
+#ifdef VK_EXT_external_memory_dma_buf
+  &dmabuf_upload,
+#endif
   &raw_to_buffer_upload,
 };
 
@@ -777,7 +976,7 @@ _upload_find_method (GstVulkanUpload * vk_upload)
 {
   vk_upload->current_impl++;
 
-  if (vk_upload->current_impl > G_N_ELEMENTS (upload_methods))
+  if (vk_upload->current_impl >= G_N_ELEMENTS (upload_methods))
     return FALSE;
 
   GST_DEBUG_OBJECT (vk_upload, "attempting upload with uploader %s",
@@ -794,7 +993,7 @@ gst_vulkan_upload_prepare_output_buffer (GstBaseTransform * bt,
   GstVulkanUpload *vk_upload = GST_VULKAN_UPLOAD (bt);
   GstFlowReturn ret;
 
-  do {
+  while (TRUE) {
     gpointer method_impl;
     const struct UploadMethod *method;
 
@@ -802,25 +1001,22 @@ gst_vulkan_upload_prepare_output_buffer (GstBaseTransform * bt,
     method_impl = vk_upload->upload_impls[vk_upload->current_impl];
 
     ret = method->perform (method_impl, inbuf, outbuf);
-    if (ret != GST_FLOW_OK) {
-      do {
-        if (!_upload_find_method (vk_upload)) {
-          GST_ELEMENT_ERROR (bt, RESOURCE, NOT_FOUND,
-              ("Could not find suitable uploader"), (NULL));
-          return GST_FLOW_ERROR;
-        }
-
-        method = upload_methods[vk_upload->current_impl];
-        method_impl = vk_upload->upload_impls[vk_upload->current_impl];
-        if (!method->set_caps (method_impl, vk_upload->in_caps,
-                vk_upload->out_caps))
-          /* try the next method */
-          continue;
-      } while (FALSE);
-      /* try the uploading with the next method */
-      continue;
-    }
-  } while (FALSE);
+    if (ret == GST_FLOW_OK)
+      break;
+
+    /* try the uploading with the next method that accepts the caps */
+    do {
+      if (!_upload_find_method (vk_upload)) {
+        GST_ELEMENT_ERROR (bt, RESOURCE, NOT_FOUND,
+            ("Could not find suitable uploader"), (NULL));
+        return GST_FLOW_ERROR;
+      }
+
+      method = upload_methods[vk_upload->current_impl];
+      method_impl = vk_upload->upload_impls[vk_upload->current_impl];
+    } while (!method->set_caps (method_impl, vk_upload->in_caps,
+            vk_upload->out_caps));
+  }
 
   if (ret == GST_FLOW_OK) {
     /* basetransform doesn't unref if they're the same */
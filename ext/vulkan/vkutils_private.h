@@ -29,6 +29,9 @@ gboolean _check_for_all_layers (uint32_t check_count, const char ** check_names,
     uint32_t layer_count, VkLayerProperties * layers, guint32 * enabled_layer_count,
     gchar *** enabled_layers);
 
+gboolean _gst_vulkan_device_release_fence (GstVulkanDevice * device,
+    GstVulkanFence * fence);
+
 G_END_DECLS
 
 #endif /*_VK_UTILS_H_ */
@@ -0,0 +1,220 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Shared by the filters running shaders/convert.comp, which converts between
+ * any two of the supported formats while scaling with bilinear sampling */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "vkvideoconvert.h"
+
+#define KIND_PACKED 0
+#define KIND_PLANAR_420 1
+#define KIND_SEMI_PLANAR_420 2
+
+#define BLOCK_WIDTH 8
+#define BLOCK_HEIGHT 2
+#define LOCAL_SIZE 8
+
+static const guint32 convert_shader[] =
+#include "convert.comp.h"
+    ;
+
+/* Fills the position of each component in a packed word or chroma pair.
+ * Padding bytes have no position in the input and get the alpha in the
+ * output */
+static gboolean
+_format_layout (GstVideoFormat format, gboolean output, gint32 order[4],
+    gint32 * kind)
+{
+  gint32 x = output ? 3 : -1;
+  gint32 i;
+
+  *kind = KIND_PACKED;
+
+#define SET_ORDER(a,b,c,d) G_STMT_START { \
+    order[0] = a; order[1] = b; order[2] = c; order[3] = d; \
+  } G_STMT_END
+
+  switch (format) {
+    case GST_VIDEO_FORMAT_RGBA:
+      SET_ORDER (0, 1, 2, 3);
+      break;
+    case GST_VIDEO_FORMAT_BGRA:
+      SET_ORDER (2, 1, 0, 3);
+      break;
+    case GST_VIDEO_FORMAT_RGBx:
+      SET_ORDER (0, 1, 2, x);
+      break;
+    case GST_VIDEO_FORMAT_BGRx:
+      SET_ORDER (2, 1, 0, x);
+      break;
+    case GST_VIDEO_FORMAT_ARGB:
+    case GST_VIDEO_FORMAT_AYUV:
+      SET_ORDER (1, 2, 3, 0);
+      break;
+    case GST_VIDEO_FORMAT_ABGR:
+      SET_ORDER (3, 2, 1, 0);
+      break;
+    case GST_VIDEO_FORMAT_xRGB:
+      i = output ? 0 : -1;
+      SET_ORDER (1, 2, 3, i);
+      break;
+    case GST_VIDEO_FORMAT_xBGR:
+      i = output ? 0 : -1;
+      SET_ORDER (3, 2, 1, i);
+      break;
+    case GST_VIDEO_FORMAT_I420:
+    case GST_VIDEO_FORMAT_YV12:
+      *kind = KIND_PLANAR_420;
+      SET_ORDER (0, 0, 0, 0);
+      break;
+    case GST_VIDEO_FORMAT_NV12:
+      *kind = KIND_SEMI_PLANAR_420;
+      SET_ORDER (0, 0, 1, 0);
+      break;
+    case GST_VIDEO_FORMAT_NV21:
+      *kind = KIND_SEMI_PLANAR_420;
+      SET_ORDER (0, 1, 0, 0);
+      break;
+    default:
+      return FALSE;
+  }
+
+#undef SET_ORDER
+
+  return TRUE;
+}
+
+/* Fills the memories and strides of @buffer in the order the shader expects
+ * the planes, i.e. with the U plane of YV12 first */
+static gboolean
+_get_planes (GstVulkanFilter * filter, GstVideoInfo * info, GstBuffer * buffer,
+    GstMemory * planes[GST_VULKAN_FILTER_MAX_PLANES], gint32 strides[4])
+{
+  GstVideoMeta *meta = gst_buffer_get_video_meta (buffer);
+  guint i, n_planes = GST_VIDEO_INFO_N_PLANES (info);
+
+  if (gst_buffer_n_memory (buffer) < n_planes) {
+    GST_WARNING_OBJECT (filter, "expected a memory per plane in %"
+        GST_PTR_FORMAT, buffer);
+    return FALSE;
+  }
+
+  for (i = 0; i < GST_VULKAN_FILTER_MAX_PLANES; i++) {
+    guint plane = i;
+
+    if (GST_VIDEO_INFO_FORMAT (info) == GST_VIDEO_FORMAT_YV12 && i > 0)
+      plane = 3 - i;
+
+    /* unused bindings still need a valid buffer */
+    if (plane >= n_planes) {
+      planes[i] = planes[0];
+      strides[i] = 0;
+      continue;
+    }
+
+    planes[i] = gst_buffer_peek_memory (buffer, plane);
+    strides[i] = meta ? meta->stride[plane] :
+        GST_VIDEO_INFO_PLANE_STRIDE (info, plane);
+    if (strides[i] % 4 != 0) {
+      GST_WARNING_OBJECT (filter, "stride %d of plane %u is not a multiple "
+          "of 4", strides[i], plane);
+      return FALSE;
+    }
+  }
+  strides[3] = 0;
+
+  return TRUE;
+}
+
+gboolean
+gst_vulkan_video_convert_prepare_dispatch (GstVulkanFilter * filter,
+    GstBuffer * inbuf, GstBuffer * outbuf,
+    GstMemory * planes[GST_VULKAN_FILTER_N_BINDINGS], gpointer push_constants,
+    guint32 group_count[3])
+{
+  GstVulkanVideoConvertParams *params = push_constants;
+  GstVideoInfo *in_info = &filter->in_info, *out_info = &filter->out_info;
+  gboolean in_yuv, out_yuv;
+  GstVideoInfo *yuv_info;
+  gdouble kr = 0.299, kb = 0.114;
+
+  memset (params, 0, sizeof (*params));
+
+  if (!_format_layout (GST_VIDEO_INFO_FORMAT (in_info), FALSE,
+          params->in_order, &params->in_kind)
+      || !_format_layout (GST_VIDEO_INFO_FORMAT (out_info), TRUE,
+          params->out_order, &params->out_kind))
+    return FALSE;
+
+  if (!_get_planes (filter, in_info, inbuf, planes, params->in_stride))
+    return FALSE;
+  if (!_get_planes (filter, out_info, outbuf,
+          &planes[GST_VULKAN_FILTER_MAX_PLANES], params->out_stride))
+    return FALSE;
+
+  params->in_size[0] = GST_VIDEO_INFO_WIDTH (in_info);
+  params->in_size[1] = GST_VIDEO_INFO_HEIGHT (in_info);
+  params->out_size[0] = GST_VIDEO_INFO_WIDTH (out_info);
+  params->out_size[1] = GST_VIDEO_INFO_HEIGHT (out_info);
+
+  in_yuv = GST_VIDEO_INFO_IS_YUV (in_info);
+  out_yuv = GST_VIDEO_INFO_IS_YUV (out_info);
+  if (in_yuv && !out_yuv)
+    params->matrix = 1;
+  else if (!in_yuv && out_yuv)
+    params->matrix = 2;
+
+  yuv_info = in_yuv ? in_info : out_info;
+  gst_video_color_matrix_get_Kr_Kb (GST_VIDEO_INFO_COLORIMETRY (yuv_info).
+      matrix, &kr, &kb);
+  params->kr_kb[0] = kr;
+  params->kr_kb[1] = kb;
+  params->full_range = GST_VIDEO_INFO_COLORIMETRY (yuv_info).range ==
+      GST_VIDEO_COLOR_RANGE_0_255;
+
+  /* every invocation writes a block of pixels */
+  group_count[0] = GST_ROUND_UP_N (params->out_size[0],
+      BLOCK_WIDTH * LOCAL_SIZE) / (BLOCK_WIDTH * LOCAL_SIZE);
+  group_count[1] = GST_ROUND_UP_N (params->out_size[1],
+      BLOCK_HEIGHT * LOCAL_SIZE) / (BLOCK_HEIGHT * LOCAL_SIZE);
+  group_count[2] = 1;
+
+  return TRUE;
+}
+
+/**
+ * gst_vulkan_video_convert_class_init:
+ * @klass: a #GstVulkanFilterClass
+ *
+ * Makes the filters of @klass run shaders/convert.comp
+ */
+void
+gst_vulkan_video_convert_class_init (GstVulkanFilterClass * klass)
+{
+  klass->shader_code = convert_shader;
+  klass->shader_size = sizeof (convert_shader);
+  klass->push_constants_size = sizeof (GstVulkanVideoConvertParams);
+  klass->prepare_dispatch = gst_vulkan_video_convert_prepare_dispatch;
+}
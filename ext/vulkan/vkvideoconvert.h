@@ -0,0 +1,63 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _VK_VIDEO_CONVERT_H_
+#define _VK_VIDEO_CONVERT_H_
+
+#include "vkfilter.h"
+
+G_BEGIN_DECLS
+
+/* the formats supported by shaders/convert.comp */
+#define GST_VULKAN_VIDEO_CONVERT_FORMATS \
+    "{ RGBA, BGRA, RGBx, BGRx, ARGB, ABGR, xRGB, xBGR, AYUV, I420, YV12, " \
+    "NV12, NV21 }"
+
+#define GST_VULKAN_VIDEO_CONVERT_CAPS \
+    GST_VIDEO_CAPS_MAKE_WITH_FEATURES (GST_CAPS_FEATURE_MEMORY_VULKAN_BUFFER, \
+        GST_VULKAN_VIDEO_CONVERT_FORMATS)
+
+/* the push constants of shaders/convert.comp */
+typedef struct
+{
+  gint32 in_size[2];
+  gint32 out_size[2];
+  gint32 in_stride[4];
+  gint32 out_stride[4];
+  gint32 in_order[4];
+  gint32 out_order[4];
+  gint32 in_kind;
+  gint32 out_kind;
+  gint32 matrix;
+  gint32 full_range;
+  gfloat kr_kb[2];
+} GstVulkanVideoConvertParams;
+
+void        gst_vulkan_video_convert_class_init         (GstVulkanFilterClass * klass);
+
+gboolean    gst_vulkan_video_convert_prepare_dispatch   (GstVulkanFilter * filter,
+                                                         GstBuffer * inbuf,
+                                                         GstBuffer * outbuf,
+                                                         GstMemory * planes[GST_VULKAN_FILTER_N_BINDINGS],
+                                                         gpointer push_constants,
+                                                         guint32 group_count[3]);
+
+G_END_DECLS
+
+#endif
@@ -35,9 +35,14 @@ enum
   PROP_0,
   PROP_BYPASS_FILTERING,
   PROP_NO_FANCY_UPSAMPLING,
-  PROP_USE_THREADS
+  PROP_USE_THREADS,
+  PROP_MAX_WIDTH,
+  PROP_MAX_HEIGHT
 };
 
+#define DEFAULT_MAX_WIDTH 0
+#define DEFAULT_MAX_HEIGHT 0
+
 static GstStaticPadTemplate gst_webp_dec_sink_pad_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -75,6 +80,7 @@ static gboolean gst_webp_dec_decide_allocation (GstVideoDecoder * bdec,
 static gboolean gst_webp_dec_sink_event (GstVideoDecoder * bdec,
     GstEvent * event);
 
+static gboolean gst_webp_dec_flush (GstVideoDecoder * bdec);
 static gboolean gst_webp_dec_reset_frame (GstWebPDec * webpdec);
 
 #define gst_webp_dec_parent_class parent_class
@@ -119,8 +125,39 @@ gst_webp_dec_class_init (GstWebPDecClass * klass)
           "When enabled, use multi-threaded decoding", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWebPDec:max-width:
+   *
+   * Images wider than this are scaled down while decoding, keeping their
+   * aspect ratio, which is much faster than decoding the full image and
+   * scaling it afterwards. If downstream requires a fixed size, the images
+   * are decoded at that size instead.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_WIDTH,
+      g_param_spec_uint ("max-width", "Maximum width",
+          "Scale down wider images while decoding (0 = unlimited)",
+          0, MAX_WIDTH, DEFAULT_MAX_WIDTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWebPDec:max-height:
+   *
+   * Images higher than this are scaled down while decoding, see
+   * #GstWebPDec:max-width.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_HEIGHT,
+      g_param_spec_uint ("max-height", "Maximum height",
+          "Scale down higher images while decoding (0 = unlimited)",
+          0, MAX_HEIGHT, DEFAULT_MAX_HEIGHT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   vdec_class->start = gst_webp_dec_start;
   vdec_class->stop = gst_webp_dec_stop;
+  vdec_class->flush = gst_webp_dec_flush;
   vdec_class->parse = gst_webp_dec_parse;
   vdec_class->set_format = gst_webp_dec_set_format;
   vdec_class->handle_frame = gst_webp_dec_handle_frame;
@@ -141,6 +178,8 @@ gst_webp_dec_init (GstWebPDec * dec)
   dec->bypass_filtering = FALSE;
   dec->no_fancy_upsampling = FALSE;
   dec->use_threads = FALSE;
+  dec->max_width = DEFAULT_MAX_WIDTH;
+  dec->max_height = DEFAULT_MAX_HEIGHT;
   gst_video_decoder_set_use_default_pad_acceptcaps (GST_VIDEO_DECODER_CAST
       (dec), TRUE);
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_VIDEO_DECODER_SINK_PAD (dec));
@@ -179,6 +218,12 @@ gst_webp_dec_set_property (GObject * object, guint prop_id,
     case PROP_USE_THREADS:
       dec->use_threads = g_value_get_boolean (value);
       break;
+    case PROP_MAX_WIDTH:
+      dec->max_width = g_value_get_uint (value);
+      break;
+    case PROP_MAX_HEIGHT:
+      dec->max_height = g_value_get_uint (value);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -204,6 +249,12 @@ gst_webp_dec_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_USE_THREADS:
       g_value_set_boolean (value, dec->use_threads);
       break;
+    case PROP_MAX_WIDTH:
+      g_value_set_uint (value, dec->max_width);
+      break;
+    case PROP_MAX_HEIGHT:
+      g_value_set_uint (value, dec->max_height);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -235,6 +286,16 @@ gst_webp_dec_stop (GstVideoDecoder * bdec)
   return TRUE;
 }
 
+/* the pipeline may be reused for many images by flushing it in between,
+ * so forget about a partially parsed image */
+static gboolean
+gst_webp_dec_flush (GstVideoDecoder * bdec)
+{
+  GstWebPDec *webpdec = (GstWebPDec *) bdec;
+
+  return gst_webp_dec_reset_frame (webpdec);
+}
+
 static gboolean
 gst_webp_dec_set_format (GstVideoDecoder * decoder, GstVideoCodecState * state)
 {
@@ -366,9 +427,56 @@ error:
   return GST_FLOW_ERROR;
 }
 
+/* picks the size to decode the image at, from the size downstream requires
+ * or else the maximum size properties */
+static void
+gst_webp_dec_get_output_size (GstWebPDec * dec, gint * width, gint * height)
+{
+  GstPad *srcpad = GST_VIDEO_DECODER_SRC_PAD (dec);
+  GstCaps *templ, *peercaps;
+  guint max_width, max_height;
+
+  templ = gst_pad_get_pad_template_caps (srcpad);
+  peercaps = gst_pad_peer_query_caps (srcpad, templ);
+  gst_caps_unref (templ);
+
+  if (!gst_caps_is_empty (peercaps) && !gst_caps_is_any (peercaps)) {
+    GstStructure *s = gst_caps_get_structure (peercaps, 0);
+    gint w, h;
+
+    if (gst_structure_get_int (s, "width", &w) &&
+        gst_structure_get_int (s, "height", &h) &&
+        w >= MIN_WIDTH && h >= MIN_HEIGHT) {
+      GST_LOG_OBJECT (dec, "downstream requires %dx%d", w, h);
+      gst_caps_unref (peercaps);
+      *width = w;
+      *height = h;
+      return;
+    }
+  }
+  gst_caps_unref (peercaps);
+
+  GST_OBJECT_LOCK (dec);
+  max_width = dec->max_width;
+  max_height = dec->max_height;
+  GST_OBJECT_UNLOCK (dec);
+
+  if (max_width && (guint) * width > max_width) {
+    *height = MAX (gst_util_uint64_scale_round (*height, max_width, *width),
+        MIN_HEIGHT);
+    *width = max_width;
+  }
+  if (max_height && (guint) * height > max_height) {
+    *width = MAX (gst_util_uint64_scale_round (*width, max_height, *height),
+        MIN_WIDTH);
+    *height = max_height;
+  }
+}
+
 static GstFlowReturn
 gst_webp_dec_update_src_caps (GstWebPDec * dec, GstMapInfo * map_info)
 {
+  gint width, height;
   WebPBitstreamFeatures features;
   GstVideoFormat format = GST_VIDEO_FORMAT_UNKNOWN;
 
@@ -384,6 +492,14 @@ gst_webp_dec_update_src_caps (GstWebPDec * dec, GstMapInfo * map_info)
     return GST_FLOW_ERROR;
   }
 
+  width = features.width;
+  height = features.height;
+  gst_webp_dec_get_output_size (dec, &width, &height);
+  dec->use_scaling = (width != features.width || height != features.height);
+  if (dec->use_scaling)
+    GST_DEBUG_OBJECT (dec, "decoding %dx%d image at %dx%d", features.width,
+        features.height, width, height);
+
   /* TODO: Add support for other formats */
   if (features.has_alpha) {
     format = GST_VIDEO_FORMAT_ARGB;
@@ -397,8 +513,8 @@ gst_webp_dec_update_src_caps (GstWebPDec * dec, GstMapInfo * map_info)
   if (dec->output_state) {
     GstVideoInfo *info = &dec->output_state->info;
 
-    if (features.width == GST_VIDEO_INFO_WIDTH (info) &&
-        features.height == GST_VIDEO_INFO_HEIGHT (info) &&
+    if (width == GST_VIDEO_INFO_WIDTH (info) &&
+        height == GST_VIDEO_INFO_HEIGHT (info) &&
         GST_VIDEO_INFO_FORMAT (info) == format) {
       goto beach;
     }
@@ -407,7 +523,7 @@ gst_webp_dec_update_src_caps (GstWebPDec * dec, GstMapInfo * map_info)
 
   dec->output_state =
       gst_video_decoder_set_output_state (GST_VIDEO_DECODER (dec), format,
-      features.width, features.height, dec->input_state);
+      width, height, dec->input_state);
 
   if (!gst_video_decoder_negotiate (GST_VIDEO_DECODER (dec)))
     return GST_FLOW_NOT_NEGOTIATED;
@@ -458,6 +574,11 @@ gst_webp_dec_handle_frame (GstVideoDecoder * decoder,
   webpdec->config.options.bypass_filtering = webpdec->bypass_filtering;
   webpdec->config.options.no_fancy_upsampling = webpdec->no_fancy_upsampling;
   webpdec->config.options.use_threads = webpdec->use_threads;
+  webpdec->config.options.use_scaling = webpdec->use_scaling;
+  webpdec->config.options.scaled_width =
+      GST_VIDEO_INFO_WIDTH (&webpdec->output_state->info);
+  webpdec->config.options.scaled_height =
+      GST_VIDEO_INFO_HEIGHT (&webpdec->output_state->info);
   webpdec->config.output.colorspace = webpdec->colorspace;
   webpdec->config.output.u.RGBA.rgba = (uint8_t *) vframe.map[0].data;
   webpdec->config.output.u.RGBA.stride =
@@ -59,6 +59,11 @@ struct _GstWebPDec {
   gboolean bypass_filtering;
   gboolean no_fancy_upsampling;
   gboolean use_threads;
+  guint max_width;
+  guint max_height;
+
+  /* decoding at a different size than the image */
+  gboolean use_scaling;
 
   WEBP_CSP_MODE colorspace;
   WebPDecoderConfig config;
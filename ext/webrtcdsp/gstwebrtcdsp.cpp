@@ -39,6 +39,12 @@
  * webrtcdsp looks for webrtcechoprobe0, which means it just work if you have
  * a single probe and DSP.
  *
+ * Both 16 bit integer and 32 bit float samples are accepted. Float samples
+ * go through the floating point interface of the library, which works on
+ * separate channels and saves the conversion to and from integers that
+ * happens internally otherwise. Buffers holding a multiple of 10ms of audio
+ * are processed in place when nothing is pending in the adapter.
+ *
  * The probe can only be used within the same top level GstPipeline.
  * Additonally, to simplify the code, the probe element must be created
  * before the DSP sink pad is activated. It does not need to be in any
@@ -92,7 +98,8 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
+        "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32)
+        " }, "
         "layout = (string) interleaved, "
         "rate = (int) { 48000, 32000, 16000, 8000 }, "
         "channels = (int) [1, MAX]")
@@ -103,7 +110,8 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
+        "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32)
+        " }, "
         "layout = (string) interleaved, "
         "rate = (int) { 48000, 32000, 16000, 8000 }, "
         "channels = (int) [1, MAX]")
@@ -231,12 +239,20 @@ struct _GstWebrtcDsp
   /* Protected by the object lock */
   GstAudioInfo info;
   guint period_size;
+  guint period_samples;
   gboolean stream_has_voice;
 
   /* Protected by the stream lock */
   GstAdapter *adapter;
+  GstBuffer *aligned_buffer;
   webrtc::AudioProcessing * apm;
 
+  /* Channels for the float interface, the capture ones are only allocated
+   * for F32 streams */
+  gfloat **capture_channels;
+  gfloat **reverse_channels;
+  guint reverse_n_channels;
+
   /* Protected by the object lock */
   gchar *probe_name;
   GstWebrtcEchoProbe *probe;
@@ -339,13 +355,110 @@ gst_webrtc_dsp_take_buffer (GstWebrtcDsp * self)
   return buffer;
 }
 
+/* The channel pointers and the samples are allocated in one block, free the
+ * result with g_free() */
+static gfloat **
+gst_webrtc_dsp_channels_new (guint n_channels, guint n_samples)
+{
+  gfloat **channels;
+  gfloat *data;
+  guint i;
+
+  channels = (gfloat **) g_malloc (n_channels * (sizeof (gfloat *) +
+          n_samples * sizeof (gfloat)));
+  data = (gfloat *) (channels + n_channels);
+
+  for (i = 0; i < n_channels; i++)
+    channels[i] = data + i * n_samples;
+
+  return channels;
+}
+
+static void
+gst_webrtc_dsp_deinterleave (gfloat ** channels, const guint8 * data,
+    GstAudioFormat format, guint n_channels, guint n_samples)
+{
+  guint i, c;
+
+  if (format == GST_AUDIO_FORMAT_S16) {
+    const gint16 *in = (const gint16 *) data;
+
+    for (i = 0; i < n_samples; i++)
+      for (c = 0; c < n_channels; c++)
+        channels[c][i] = *in++ * (1.0f / 32768.0f);
+  } else if (n_channels == 1) {
+    memcpy (channels[0], data, n_samples * sizeof (gfloat));
+  } else if (n_channels == 2) {
+    const gfloat *in = (const gfloat *) data;
+    gfloat *left = channels[0], *right = channels[1];
+
+    for (i = 0; i < n_samples; i++) {
+      left[i] = in[2 * i];
+      right[i] = in[2 * i + 1];
+    }
+  } else {
+    const gfloat *in = (const gfloat *) data;
+
+    for (i = 0; i < n_samples; i++)
+      for (c = 0; c < n_channels; c++)
+        channels[c][i] = *in++;
+  }
+}
+
+static void
+gst_webrtc_dsp_interleave (guint8 * data, gfloat * const *channels,
+    guint n_channels, guint n_samples)
+{
+  gfloat *out = (gfloat *) data;
+  guint i, c;
+
+  if (n_channels == 1) {
+    memcpy (out, channels[0], n_samples * sizeof (gfloat));
+  } else if (n_channels == 2) {
+    const gfloat *left = channels[0], *right = channels[1];
+
+    for (i = 0; i < n_samples; i++) {
+      out[2 * i] = left[i];
+      out[2 * i + 1] = right[i];
+    }
+  } else {
+    for (i = 0; i < n_samples; i++)
+      for (c = 0; c < n_channels; c++)
+        *out++ = channels[c][i];
+  }
+}
+
+/* Fills a frame for the integer interface from probe data in either
+ * format */
+static void
+gst_webrtc_dsp_fill_frame (webrtc::AudioFrame * frame, const guint8 * data,
+    const GstAudioInfo * info, guint n_samples)
+{
+  guint i, n = n_samples * info->channels;
+
+  frame->num_channels_ = info->channels;
+  frame->sample_rate_hz_ = info->rate;
+  frame->samples_per_channel_ = n_samples;
+
+  if (GST_AUDIO_INFO_FORMAT (info) == GST_AUDIO_FORMAT_S16) {
+    memcpy (frame->data_, data, n * sizeof (gint16));
+  } else {
+    const gfloat *in = (const gfloat *) data;
+
+    for (i = 0; i < n; i++)
+      frame->data_[i] = (gint16) CLAMP (in[i] * 32768.0f, -32768.0f, 32767.0f);
+  }
+}
+
 static GstFlowReturn
 gst_webrtc_dsp_analyze_reverse_stream (GstWebrtcDsp * self,
     GstClockTime rec_time)
 {
   GstWebrtcEchoProbe *probe = NULL;
   webrtc::AudioProcessing * apm;
-  webrtc::AudioFrame frame;
+  GstAudioInfo info;
+  GstBuffer *buffer;
+  GstMapInfo map;
   GstFlowReturn ret = GST_FLOW_OK;
   gint err, delay;
 
@@ -364,22 +477,54 @@ gst_webrtc_dsp_analyze_reverse_stream (GstWebrtcDsp * self,
     rec_time = GST_CLOCK_TIME_NONE;
 
 again:
-  delay = gst_webrtc_echo_probe_read (probe, rec_time, (gpointer) &frame);
+  delay = gst_webrtc_echo_probe_read (probe, rec_time, &info, &buffer);
   apm->set_stream_delay_ms (delay);
 
   if (delay < 0)
     goto done;
 
-  if (frame.sample_rate_hz_ != self->info.rate) {
+  if (info.rate != self->info.rate) {
+    gst_buffer_unref (buffer);
     GST_ELEMENT_ERROR (self, STREAM, FORMAT,
         ("Echo Probe has rate %i , while the DSP is running at rate %i,"
          " use a caps filter to ensure those are the same.",
-         frame.sample_rate_hz_, self->info.rate), (NULL));
+         info.rate, self->info.rate), (NULL));
     ret = GST_FLOW_ERROR;
     goto done;
   }
 
-  if ((err = apm->AnalyzeReverseStream (&frame)) < 0)
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    gst_buffer_unref (buffer);
+    ret = GST_FLOW_ERROR;
+    goto done;
+  }
+
+  /* The reverse stream uses the same interface as the capture stream */
+  if (self->capture_channels) {
+    webrtc::StreamConfig config (info.rate, info.channels, false);
+
+    if (self->reverse_n_channels != (guint) info.channels) {
+      g_free (self->reverse_channels);
+      self->reverse_channels =
+          gst_webrtc_dsp_channels_new (info.channels, self->period_samples);
+      self->reverse_n_channels = info.channels;
+    }
+
+    gst_webrtc_dsp_deinterleave (self->reverse_channels, map.data,
+        GST_AUDIO_INFO_FORMAT (&info), info.channels, self->period_samples);
+    err = apm->ProcessReverseStream (self->reverse_channels, config, config,
+        self->reverse_channels);
+  } else {
+    webrtc::AudioFrame frame;
+
+    gst_webrtc_dsp_fill_frame (&frame, map.data, &info, self->period_samples);
+    err = apm->AnalyzeReverseStream (&frame);
+  }
+
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  if (err < 0)
     GST_WARNING_OBJECT (self, "Reverse stream analyses failed: %s.",
         webrtc_error_to_string (err));
 
@@ -414,44 +559,78 @@ gst_webrtc_vad_post_message (GstWebrtcDsp *self, GstClockTime timestamp,
       gst_message_new_element (GST_OBJECT (self), s));
 }
 
-static GstFlowReturn
-gst_webrtc_dsp_process_stream (GstWebrtcDsp * self,
-    GstBuffer * buffer)
+static void
+gst_webrtc_dsp_process_period (GstWebrtcDsp * self, guint8 * data,
+    GstClockTime timestamp)
 {
-  GstMapInfo info;
   webrtc::AudioProcessing * apm = self->apm;
-  webrtc::AudioFrame frame;
   gint err;
 
-  frame.num_channels_ = self->info.channels;
-  frame.sample_rate_hz_ = self->info.rate;
-  frame.samples_per_channel_ = self->period_size / self->info.bpf;
+  if (self->capture_channels) {
+    webrtc::StreamConfig config (self->info.rate, self->info.channels, false);
 
-  if (!gst_buffer_map (buffer, &info, (GstMapFlags) GST_MAP_READWRITE)) {
-    gst_buffer_unref (buffer);
-    return GST_FLOW_ERROR;
-  }
+    gst_webrtc_dsp_deinterleave (self->capture_channels, data,
+        GST_AUDIO_FORMAT_F32, self->info.channels, self->period_samples);
+    err = apm->ProcessStream (self->capture_channels, config, config,
+        self->capture_channels);
+    if (err >= 0)
+      gst_webrtc_dsp_interleave (data, self->capture_channels,
+          self->info.channels, self->period_samples);
+  } else {
+    webrtc::AudioFrame frame;
+
+    frame.num_channels_ = self->info.channels;
+    frame.sample_rate_hz_ = self->info.rate;
+    frame.samples_per_channel_ = self->period_samples;
 
-  memcpy (frame.data_, info.data, self->period_size);
+    memcpy (frame.data_, data, self->period_size);
+    err = apm->ProcessStream (&frame);
+    if (err >= 0)
+      memcpy (data, frame.data_, self->period_size);
+  }
 
-  if ((err = apm->ProcessStream (&frame)) < 0) {
+  if (err < 0) {
     GST_WARNING_OBJECT (self, "Failed to filter the audio: %s.",
         webrtc_error_to_string (err));
-  } else {
-    if (self->voice_detection) {
-      gboolean stream_has_voice = apm->voice_detection ()->stream_has_voice ();
+  } else if (self->voice_detection) {
+    gboolean stream_has_voice = apm->voice_detection ()->stream_has_voice ();
 
-      if (stream_has_voice != self->stream_has_voice)
-        gst_webrtc_vad_post_message (self, GST_BUFFER_PTS (buffer), stream_has_voice);
+    if (stream_has_voice != self->stream_has_voice)
+      gst_webrtc_vad_post_message (self, timestamp, stream_has_voice);
 
-      self->stream_has_voice = stream_has_voice;
-    }
-    memcpy (info.data, frame.data_, self->period_size);
+    self->stream_has_voice = stream_has_voice;
+  }
+}
+
+/* The buffer holds a whole number of periods, each one is processed in place
+ * after feeding the matching reverse stream data */
+static GstFlowReturn
+gst_webrtc_dsp_process_stream (GstWebrtcDsp * self,
+    GstBuffer * buffer)
+{
+  GstMapInfo info;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gsize offset;
+
+  if (!gst_buffer_map (buffer, &info, (GstMapFlags) GST_MAP_READWRITE))
+    return GST_FLOW_ERROR;
+
+  for (offset = 0; offset + self->period_size <= info.size;
+      offset += self->period_size) {
+    GstClockTime timestamp = GST_BUFFER_PTS (buffer) +
+        gst_util_uint64_scale_int (offset / self->info.bpf, GST_SECOND,
+        self->info.rate);
+
+    ret = gst_webrtc_dsp_analyze_reverse_stream (self, timestamp);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    gst_webrtc_dsp_process_period (self, info.data + offset, timestamp);
   }
 
   gst_buffer_unmap (buffer, &info);
 
-  return GST_FLOW_OK;
+  return ret;
 }
 
 static GstFlowReturn
@@ -459,6 +638,7 @@ gst_webrtc_dsp_submit_input_buffer (GstBaseTransform * btrans,
     gboolean is_discont, GstBuffer * buffer)
 {
   GstWebrtcDsp *self = GST_WEBRTC_DSP (btrans);
+  gsize size;
 
   buffer = gst_buffer_make_writable (buffer);
   GST_BUFFER_PTS (buffer) = gst_segment_to_running_time (&btrans->segment,
@@ -470,6 +650,18 @@ gst_webrtc_dsp_submit_input_buffer (GstBaseTransform * btrans,
     gst_adapter_clear (self->adapter);
   }
 
+  /* Buffers holding whole periods don't need to go through the adapter,
+   * they will be processed in place when nothing is pending */
+  size = gst_buffer_get_size (buffer);
+  if (self->aligned_buffer == NULL && size > 0
+      && size % self->period_size == 0
+      && gst_adapter_available (self->adapter) == 0
+      && GST_BUFFER_PTS_IS_VALID (buffer)) {
+    GST_BUFFER_DURATION (buffer) = size / self->period_size * 10 * GST_MSECOND;
+    self->aligned_buffer = buffer;
+    return GST_FLOW_OK;
+  }
+
   gst_adapter_push (self->adapter, buffer);
 
   return GST_FLOW_OK;
@@ -479,20 +671,18 @@ static GstFlowReturn
 gst_webrtc_dsp_generate_output (GstBaseTransform * btrans, GstBuffer ** outbuf)
 {
   GstWebrtcDsp *self = GST_WEBRTC_DSP (btrans);
-  GstFlowReturn ret;
 
-  if (gst_adapter_available (self->adapter) < self->period_size) {
+  if (self->aligned_buffer) {
+    *outbuf = self->aligned_buffer;
+    self->aligned_buffer = NULL;
+  } else if (gst_adapter_available (self->adapter) >= self->period_size) {
+    *outbuf = gst_webrtc_dsp_take_buffer (self);
+  } else {
     *outbuf = NULL;
     return GST_FLOW_OK;
   }
 
-  *outbuf = gst_webrtc_dsp_take_buffer (self);
-  ret = gst_webrtc_dsp_analyze_reverse_stream (self, GST_BUFFER_PTS (*outbuf));
-
-  if (ret == GST_FLOW_OK)
-    ret = gst_webrtc_dsp_process_stream (self, *outbuf);
-
-  return ret;
+  return gst_webrtc_dsp_process_stream (self, *outbuf);
 }
 
 static gboolean
@@ -545,13 +735,26 @@ gst_webrtc_dsp_setup (GstAudioFilter * filter, const GstAudioInfo * info)
   GST_OBJECT_LOCK (self);
 
   gst_adapter_clear (self->adapter);
+  gst_buffer_replace (&self->aligned_buffer, NULL);
   self->info = *info;
   apm = self->apm;
 
   /* WebRTC library works with 10ms buffers, compute once this size */
-  self->period_size = info->bpf * info->rate / 100;
-
-  if ((webrtc::AudioFrame::kMaxDataSizeSamples * 2) < self->period_size)
+  self->period_samples = info->rate / 100;
+  self->period_size = info->bpf * self->period_samples;
+
+  g_free (self->capture_channels);
+  self->capture_channels = NULL;
+  g_free (self->reverse_channels);
+  self->reverse_channels = NULL;
+  self->reverse_n_channels = 0;
+
+  /* Only the integer interface is limited in size */
+  if (GST_AUDIO_INFO_FORMAT (info) == GST_AUDIO_FORMAT_F32)
+    self->capture_channels =
+        gst_webrtc_dsp_channels_new (info->channels, self->period_samples);
+  else if (webrtc::AudioFrame::kMaxDataSizeSamples <
+      self->period_samples * info->channels)
     goto period_too_big;
 
   if (self->probe) {
@@ -647,7 +850,8 @@ period_too_big:
   GST_WARNING_OBJECT (self, "webrtcdsp format produce too big period "
       "(maximum is %" G_GSIZE_FORMAT " samples and we have %u samples), "
       "reduce the number of channels or the rate.",
-      webrtc::AudioFrame::kMaxDataSizeSamples, self->period_size / 2);
+      webrtc::AudioFrame::kMaxDataSizeSamples,
+      self->period_samples * info->channels);
   return FALSE;
 
 probe_has_wrong_rate:
@@ -676,6 +880,7 @@ gst_webrtc_dsp_stop (GstBaseTransform * btrans)
   GST_OBJECT_LOCK (self);
 
   gst_adapter_clear (self->adapter);
+  gst_buffer_replace (&self->aligned_buffer, NULL);
 
   if (self->probe) {
     gst_webrtc_release_echo_probe (self->probe);
@@ -841,6 +1046,8 @@ gst_webrtc_dsp_finalize (GObject * object)
 
   gst_object_unref (self->adapter);
   g_free (self->probe_name);
+  g_free (self->capture_channels);
+  g_free (self->reverse_channels);
 
   G_OBJECT_CLASS (gst_webrtc_dsp_parent_class)->finalize (object);
 }
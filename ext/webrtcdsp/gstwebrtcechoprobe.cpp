@@ -46,7 +46,8 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
+        "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32)
+        " }, "
         "layout = (string) interleaved, "
         "rate = (int) { 48000, 32000, 16000, 8000 }, "
         "channels = (int) [1, MAX]")
@@ -57,7 +58,8 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
+        "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32)
+        " }, "
         "layout = (string) interleaved, "
         "rate = (int) { 48000, 32000, 16000, 8000 }, "
         "channels = (int) [1, MAX]")
@@ -84,7 +86,8 @@ gst_webrtc_echo_probe_setup (GstAudioFilter * filter, const GstAudioInfo * info)
   /* WebRTC library works with 10ms buffers, compute once this size */
   self->period_size = info->bpf * info->rate / 100;
 
-  if ((webrtc::AudioFrame::kMaxDataSizeSamples * 2) < self->period_size)
+  if (webrtc::AudioFrame::kMaxDataSizeSamples <
+      (guint) (info->rate / 100 * info->channels))
     goto period_too_big;
 
   GST_WEBRTC_ECHO_PROBE_UNLOCK (self);
@@ -96,7 +99,8 @@ period_too_big:
   GST_WARNING_OBJECT (self, "webrtcdsp format produce too big period "
       "(maximum is %" G_GSIZE_FORMAT " samples and we have %u samples), "
       "reduce the number of channels or the rate.",
-      webrtc::AudioFrame::kMaxDataSizeSamples, self->period_size / 2);
+      webrtc::AudioFrame::kMaxDataSizeSamples,
+      self->period_size / self->info.bpf * self->info.channels);
   return FALSE;
 }
 
@@ -159,7 +163,10 @@ gst_webrtc_echo_probe_transform_ip (GstBaseTransform * btrans,
   GstBuffer *newbuf = NULL;
 
   GST_WEBRTC_ECHO_PROBE_LOCK (self);
-  newbuf = gst_buffer_copy (buffer);
+  /* Only references the memory, the data is shared with the buffer going
+   * downstream and the metas are not needed */
+  newbuf = gst_buffer_copy_region (buffer, (GstBufferCopyFlags)
+      (GST_BUFFER_COPY_TIMESTAMPS | GST_BUFFER_COPY_MEMORY), 0, -1);
   /* Moves the buffer timestamp to be in Running time */
   GST_BUFFER_PTS (newbuf) = gst_segment_to_running_time (&btrans->segment,
       GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
@@ -266,11 +273,13 @@ gst_webrtc_release_echo_probe (GstWebrtcEchoProbe * probe)
   gst_object_unref (probe);
 }
 
+/* Returns one period of audio in @buf and the format of the probe in @info.
+ * When the period is found in a single adapter buffer, the returned buffer
+ * shares its memory instead of holding a copy. */
 gint
 gst_webrtc_echo_probe_read (GstWebrtcEchoProbe * self, GstClockTime rec_time,
-    gpointer _frame)
+    GstAudioInfo * info, GstBuffer ** buf)
 {
-  webrtc::AudioFrame * frame = (webrtc::AudioFrame *) _frame;
   GstClockTimeDiff diff;
   gsize avail, skip, offset, size;
   gint delay = -1;
@@ -329,19 +338,26 @@ gst_webrtc_echo_probe_read (GstWebrtcEchoProbe * self, GstClockTime rec_time,
 
   size = MIN (avail - offset, self->period_size - skip);
 
-  if (size < self->period_size)
-    memset (frame->data_, 0, self->period_size);
-
 copy:
-  if (size) {
-    gst_adapter_copy (self->adapter, (guint8 *) frame->data_ + skip,
-        offset, size);
-    gst_adapter_flush (self->adapter, offset + size);
+  if (size == self->period_size) {
+    gst_adapter_flush (self->adapter, offset);
+    *buf = gst_adapter_take_buffer (self->adapter, size);
+  } else {
+    GstMapInfo map;
+
+    *buf = gst_buffer_new_allocate (NULL, self->period_size, NULL);
+    gst_buffer_map (*buf, &map, GST_MAP_WRITE);
+    memset (map.data, 0, self->period_size);
+
+    if (size) {
+      gst_adapter_copy (self->adapter, map.data + skip, offset, size);
+      gst_adapter_flush (self->adapter, offset + size);
+    }
+
+    gst_buffer_unmap (*buf, &map);
   }
 
-  frame->num_channels_ = self->info.channels;
-  frame->sample_rate_hz_ = self->info.rate;
-  frame->samples_per_channel_ = self->period_size / self->info.bpf;
+  *info = self->info;
 
   delay = self->delay;
 
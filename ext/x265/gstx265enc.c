@@ -53,7 +53,11 @@ enum
   PROP_OPTION_STRING,
   PROP_X265_LOG_LEVEL,
   PROP_SPEED_PRESET,
-  PROP_TUNE
+  PROP_TUNE,
+  PROP_POOLS,
+  PROP_FRAME_THREADS,
+  PROP_LOOKAHEAD_SLICES,
+  PROP_WPP
 };
 
 #define PROP_BITRATE_DEFAULT            (2 * 1024)
@@ -62,6 +66,10 @@ enum
 #define PROP_LOG_LEVEL_DEFAULT           -1     // None
 #define PROP_SPEED_PRESET_DEFAULT        6      // Medium
 #define PROP_TUNE_DEFAULT                2      // SSIM
+#define PROP_POOLS_DEFAULT               NULL   // One pool per NUMA node
+#define PROP_FRAME_THREADS_DEFAULT       0      // Automatic
+#define PROP_LOOKAHEAD_SLICES_DEFAULT    -1     // From the preset
+#define PROP_WPP_DEFAULT                 TRUE
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 #define FORMATS "I420, Y444, I420_10LE, Y444_10LE"
@@ -396,6 +404,66 @@ gst_x265_enc_class_init (GstX265EncClass * klass)
           "Preset name for tuning options", GST_X265_ENC_TUNE_TYPE,
           PROP_TUNE_DEFAULT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstX265Enc:pools:
+   *
+   * Thread pools to create, as a comma separated list with one entry per
+   * NUMA node, as with the pools option of x265: "+" uses all the threads
+   * of the node, "-" none of them and a number that many threads. A single
+   * number creates one pool of that many threads. For example "-,+" only
+   * runs the encoder on the second socket of a dual-socket system.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_POOLS,
+      g_param_spec_string ("pools", "Thread pools",
+          "Thread pools per NUMA node, as in x265's pools option "
+          "(NULL = one pool on each node)", PROP_POOLS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstX265Enc:frame-threads:
+   *
+   * Number of frames encoded concurrently. More frames improve the
+   * throughput, at the price of latency and of some quality as the motion
+   * search is restricted. Use 1 together with tune=zerolatency for the
+   * lowest latency.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAME_THREADS,
+      g_param_spec_uint ("frame-threads", "Frame threads",
+          "Number of concurrently encoded frames (0 = automatic)", 0, 16,
+          PROP_FRAME_THREADS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstX265Enc:lookahead-slices:
+   *
+   * Number of slices the lookahead analysis of each frame is split into, to
+   * run it on several threads.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_LOOKAHEAD_SLICES,
+      g_param_spec_int ("lookahead-slices", "Lookahead slices",
+          "Number of slices for the lookahead analysis (-1 = from preset)",
+          -1, 16, PROP_LOOKAHEAD_SLICES_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstX265Enc:wpp:
+   *
+   * Encode the rows of the CTUs of each frame in parallel (wavefront
+   * parallel processing).
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_WPP,
+      g_param_spec_boolean ("wpp", "WPP",
+          "Wavefront parallel processing of the CTU rows", PROP_WPP_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (element_class,
       "x265enc", "Codec/Encoder/Video", "H265 Encoder",
       "Thijs Vermeir <thijs.vermeir@barco.com>");
@@ -422,14 +490,28 @@ gst_x265_enc_init (GstX265Enc * encoder)
   encoder->log_level = PROP_LOG_LEVEL_DEFAULT;
   encoder->speed_preset = PROP_SPEED_PRESET_DEFAULT;
   encoder->tune = PROP_TUNE_DEFAULT;
+  encoder->pools = g_strdup (PROP_POOLS_DEFAULT);
+  encoder->frame_threads = PROP_FRAME_THREADS_DEFAULT;
+  encoder->lookahead_slices = PROP_LOOKAHEAD_SLICES_DEFAULT;
+  encoder->wpp = PROP_WPP_DEFAULT;
 }
 
+/* The input frames are mapped until x265 is done with them, as it reads the
+ * pixels in place. The mapping is kept as user data of the codec frame: x265
+ * returns the frames in coding order, which makes a FIFO unsuitable, and
+ * this avoids looking them up. */
 typedef struct
 {
-  GstVideoCodecFrame *frame;
   GstVideoFrame vframe;
 } FrameData;
 
+static void
+gst_x265_enc_frame_data_free (FrameData * fdata)
+{
+  gst_video_frame_unmap (&fdata->vframe);
+  g_slice_free (FrameData, fdata);
+}
+
 static FrameData *
 gst_x265_enc_queue_frame (GstX265Enc * enc, GstVideoCodecFrame * frame,
     GstVideoInfo * info)
@@ -441,10 +523,10 @@ gst_x265_enc_queue_frame (GstX265Enc * enc, GstVideoCodecFrame * frame,
     return NULL;
 
   fdata = g_slice_new (FrameData);
-  fdata->frame = gst_video_codec_frame_ref (frame);
   fdata->vframe = vframe;
 
-  enc->pending_frames = g_list_prepend (enc->pending_frames, fdata);
+  gst_video_codec_frame_set_user_data (frame, fdata,
+      (GDestroyNotify) gst_x265_enc_frame_data_free);
 
   return fdata;
 }
@@ -452,37 +534,19 @@ gst_x265_enc_queue_frame (GstX265Enc * enc, GstVideoCodecFrame * frame,
 static void
 gst_x265_enc_dequeue_frame (GstX265Enc * enc, GstVideoCodecFrame * frame)
 {
-  GList *l;
-
-  for (l = enc->pending_frames; l; l = l->next) {
-    FrameData *fdata = l->data;
-
-    if (fdata->frame != frame)
-      continue;
-
-    gst_video_frame_unmap (&fdata->vframe);
-    gst_video_codec_frame_unref (fdata->frame);
-    g_slice_free (FrameData, fdata);
-
-    enc->pending_frames = g_list_delete_link (enc->pending_frames, l);
-    return;
-  }
+  /* unmaps the input frame */
+  gst_video_codec_frame_set_user_data (frame, NULL, NULL);
 }
 
 static void
 gst_x265_enc_dequeue_all_frames (GstX265Enc * enc)
 {
-  GList *l;
+  GList *frames, *l;
 
-  for (l = enc->pending_frames; l; l = l->next) {
-    FrameData *fdata = l->data;
-
-    gst_video_frame_unmap (&fdata->vframe);
-    gst_video_codec_frame_unref (fdata->frame);
-    g_slice_free (FrameData, fdata);
-  }
-  g_list_free (enc->pending_frames);
-  enc->pending_frames = NULL;
+  frames = gst_video_encoder_get_frames (GST_VIDEO_ENCODER (enc));
+  for (l = frames; l; l = l->next)
+    gst_x265_enc_dequeue_frame (enc, l->data);
+  g_list_free_full (frames, (GDestroyNotify) gst_video_codec_frame_unref);
 }
 
 static gboolean
@@ -540,6 +604,7 @@ gst_x265_enc_finalize (GObject * object)
   gst_x265_enc_close_encoder (encoder);
 
   g_string_free (encoder->option_string_prop, TRUE);
+  g_free (encoder->pools);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -673,6 +738,18 @@ gst_x265_enc_init_encoder (GstX265Enc * encoder)
     encoder->x265param.rc.rateControlMode = X265_RC_ABR;
   }
 
+  /* threading */
+#if X265_BUILD >= 47
+  encoder->x265param.numaPools = encoder->pools;
+#else
+  if (encoder->pools)
+    GST_WARNING_OBJECT (encoder, "pools are not supported by this x265");
+#endif
+  encoder->x265param.frameNumThreads = encoder->frame_threads;
+  if (encoder->lookahead_slices != -1)
+    encoder->x265param.lookaheadSlices = encoder->lookahead_slices;
+  encoder->x265param.bEnableWavefront = encoder->wpp;
+
   /* apply option-string property */
   if (encoder->option_string_prop && encoder->option_string_prop->len) {
     GST_DEBUG_OBJECT (encoder, "Applying option-string: %s",
@@ -1197,6 +1274,19 @@ gst_x265_enc_set_property (GObject * object, guint prop_id,
     case PROP_TUNE:
       encoder->tune = g_value_get_enum (value);
       break;
+    case PROP_POOLS:
+      g_free (encoder->pools);
+      encoder->pools = g_value_dup_string (value);
+      break;
+    case PROP_FRAME_THREADS:
+      encoder->frame_threads = g_value_get_uint (value);
+      break;
+    case PROP_LOOKAHEAD_SLICES:
+      encoder->lookahead_slices = g_value_get_int (value);
+      break;
+    case PROP_WPP:
+      encoder->wpp = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1241,6 +1331,18 @@ gst_x265_enc_get_property (GObject * object, guint prop_id,
     case PROP_TUNE:
       g_value_set_enum (value, encoder->tune);
       break;
+    case PROP_POOLS:
+      g_value_set_string (value, encoder->pools);
+      break;
+    case PROP_FRAME_THREADS:
+      g_value_set_uint (value, encoder->frame_threads);
+      break;
+    case PROP_LOOKAHEAD_SLICES:
+      g_value_set_int (value, encoder->lookahead_slices);
+      break;
+    case PROP_WPP:
+      g_value_set_boolean (value, encoder->wpp);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
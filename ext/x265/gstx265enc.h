@@ -51,10 +51,6 @@ struct _GstX265Enc
   GstClockTime dts_offset;
   gboolean push_header;
 
-  /* List of frame/buffer mapping structs for
-   * pending frames */
-  GList *pending_frames;
-
   /* properties */
   guint bitrate;
   gint qp;
@@ -62,6 +58,10 @@ struct _GstX265Enc
   gint tune;
   gint speed_preset;
   GString *option_string_prop;  /* option-string property */
+  gchar *pools;
+  guint frame_threads;
+  gint lookahead_slices;
+  gboolean wpp;
   /*GString *option_string; *//* used by set prop */
 
   /* input description */
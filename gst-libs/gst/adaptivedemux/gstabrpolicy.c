@@ -0,0 +1,151 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Bitrate selection policies for GstAdaptiveDemux.
+ *
+ * A policy returns the bitrate to request from the subclass
+ * stream_select_bitrate vfunc, which picks the highest representation not
+ * above it. Adding a policy only needs a new entry in impls[].
+ *
+ * The buffer based policy implements BOLA-O from "BOLA: Near-Optimal
+ * Bitrate Adaptation for Online Videos" (Spiteri, Urgaonkar, Sitaraman):
+ * with Q the buffer level and Qmax the buffer target in fragments, and
+ * v_m = ln (S_m / S_0) the utility of representation m of size S_m, it
+ * picks the m maximizing (V * (v_m + gp) - Q) / S_m where
+ * V = (Qmax - 1) / (v_max + gp). To avoid oscillations it never switches up
+ * beyond what the throughput sustains, unless that would mean switching
+ * down.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "gstabrpolicy.h"
+
+#define BOLA_GAMMA_P 5.0
+/* BOLA needs room for more than one fragment */
+#define BOLA_MIN_BUFFER_FRAGMENTS 2.0
+
+typedef struct
+{
+  guint64 (*select_bitrate) (const GstAbrPolicyInfo * info);
+} GstAbrPolicyImpl;
+
+static guint64
+throughput_select_bitrate (const GstAbrPolicyInfo * info)
+{
+  return info->throughput;
+}
+
+/* index of the highest bitrate not above @bitrate, 0 if none */
+static guint
+ladder_index (const GstAbrPolicyInfo * info, guint64 bitrate)
+{
+  guint i;
+
+  for (i = info->n_bitrates; i > 1; i--) {
+    if (info->bitrates[i - 1] <= bitrate)
+      break;
+  }
+
+  return i ? i - 1 : 0;
+}
+
+static guint64
+buffer_select_bitrate (const GstAbrPolicyInfo * info)
+{
+  gdouble p, q, q_max, v, best_score = 0.0;
+  guint m, best = 0;
+
+  if (info->n_bitrates == 0 || info->bitrates[0] == 0
+      || !GST_CLOCK_TIME_IS_VALID (info->buffer_level)
+      || !GST_CLOCK_TIME_IS_VALID (info->buffer_target)
+      || !GST_CLOCK_TIME_IS_VALID (info->fragment_duration)
+      || info->fragment_duration == 0)
+    return throughput_select_bitrate (info);
+
+  p = (gdouble) info->fragment_duration;
+  q = info->buffer_level / p;
+  q_max = MAX (info->buffer_target / p, BOLA_MIN_BUFFER_FRAGMENTS);
+  v = (q_max - 1.0) / (log ((gdouble) info->bitrates[info->n_bitrates - 1] /
+          info->bitrates[0]) + BOLA_GAMMA_P);
+
+  for (m = 0; m < info->n_bitrates; m++) {
+    gdouble utility = log ((gdouble) info->bitrates[m] / info->bitrates[0]);
+    gdouble score = (v * (utility + BOLA_GAMMA_P) - q) / info->bitrates[m];
+
+    if (m == 0 || score > best_score) {
+      best = m;
+      best_score = score;
+    }
+  }
+
+  if (info->current_bitrate) {
+    guint current = ladder_index (info, info->current_bitrate);
+
+    if (best > current) {
+      guint sustainable = ladder_index (info, info->throughput);
+
+      if (sustainable < best)
+        best = MAX (sustainable, current);
+    }
+  }
+
+  GST_DEBUG ("buffer %.2f/%.2f fragments, picked %" G_GUINT64_FORMAT " bps", q,
+      q_max, info->bitrates[best]);
+
+  return info->bitrates[best];
+}
+
+static const GstAbrPolicyImpl impls[] = {
+  [GST_ABR_POLICY_THROUGHPUT] = {throughput_select_bitrate},
+  [GST_ABR_POLICY_BUFFER] = {buffer_select_bitrate},
+};
+
+GType
+gst_abr_policy_type_get_type (void)
+{
+  static volatile gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_ABR_POLICY_THROUGHPUT,
+        "Highest bitrate the measured throughput allows", "throughput"},
+    {GST_ABR_POLICY_BUFFER,
+        "Buffer based selection (BOLA-O)", "buffer"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = g_enum_register_static ("GstAbrPolicyType", values);
+    g_once_init_leave (&type, _type);
+  }
+
+  return type;
+}
+
+guint64
+gst_abr_policy_select_bitrate (GstAbrPolicyType type,
+    const GstAbrPolicyInfo * info)
+{
+  g_return_val_if_fail (type < G_N_ELEMENTS (impls), info->throughput);
+
+  return impls[type].select_bitrate (info);
+}
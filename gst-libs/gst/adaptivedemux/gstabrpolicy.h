@@ -0,0 +1,75 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_ABR_POLICY_H_
+#define _GST_ABR_POLICY_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstAbrPolicyType:
+ * @GST_ABR_POLICY_THROUGHPUT: use the highest bitrate the estimated
+ *   throughput allows
+ * @GST_ABR_POLICY_BUFFER: buffer based selection (BOLA-O), falls back to
+ *   the throughput policy while the buffer level is unknown
+ *
+ * The policies available to choose the bitrate of the next fragment.
+ */
+typedef enum
+{
+  GST_ABR_POLICY_THROUGHPUT,
+  GST_ABR_POLICY_BUFFER
+} GstAbrPolicyType;
+
+#define GST_TYPE_ABR_POLICY_TYPE (gst_abr_policy_type_get_type ())
+GST_EXPORT
+GType gst_abr_policy_type_get_type (void);
+
+/**
+ * GstAbrPolicyInfo:
+ * @throughput: estimated usable throughput in bits per second
+ * @buffer_level: amount of data buffered downstream, or
+ *   %GST_CLOCK_TIME_NONE if unknown
+ * @buffer_target: amount of data the policy should aim to keep buffered
+ * @fragment_duration: duration of a fragment
+ * @bitrates: the available bitrates, in bits per second, sorted ascending
+ * @n_bitrates: number of entries in @bitrates
+ * @current_bitrate: bitrate of the current representation, 0 if unknown
+ *
+ * Everything an ABR policy bases its decision on.
+ */
+typedef struct
+{
+  guint64 throughput;
+  GstClockTime buffer_level;
+  GstClockTime buffer_target;
+  GstClockTime fragment_duration;
+  const guint64 *bitrates;
+  guint n_bitrates;
+  guint64 current_bitrate;
+} GstAbrPolicyInfo;
+
+GST_EXPORT
+guint64 gst_abr_policy_select_bitrate (GstAbrPolicyType type,
+    const GstAbrPolicyInfo * info);
+
+G_END_DECLS
+
+#endif
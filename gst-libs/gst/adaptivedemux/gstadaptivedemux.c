@@ -134,8 +134,16 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_FAILED_COUNT 3
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
+#define DEFAULT_MAX_PREFETCH_FRAGMENTS 0
+#define DEFAULT_MAX_PREFETCH_BYTES (16 * 1024 * 1024)
+#define DEFAULT_MAX_PREFETCH_TIME (30 * GST_SECOND)
+#define DEFAULT_BANDWIDTH_ESTIMATOR GST_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE
+#define DEFAULT_ABR_POLICY GST_ABR_POLICY_THROUGHPUT
+#define DEFAULT_ABR_BUFFER_TARGET (30 * GST_SECOND)
+#define DEFAULT_FRAGMENT_CACHE FALSE
+#define DEFAULT_FAST_START FALSE
+#define DEFAULT_START_LOWEST_BITRATE FALSE
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
-#define NUM_LOOKBACK_FRAGMENTS 3
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -162,6 +170,19 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_MAX_PREFETCH_FRAGMENTS,
+  PROP_MAX_PREFETCH_BYTES,
+  PROP_MAX_PREFETCH_TIME,
+  PROP_CONNECTION_STATS,
+  PROP_BANDWIDTH_ESTIMATOR,
+  PROP_ABR_POLICY,
+  PROP_ABR_BUFFER_TARGET,
+  PROP_FRAGMENT_CACHE,
+  PROP_FRAGMENT_CACHE_MAX_MEMORY,
+  PROP_FRAGMENT_CACHE_MAX_DISK,
+  PROP_FRAGMENT_CACHE_STATS,
+  PROP_FAST_START,
+  PROP_START_LOWEST_BITRATE,
   PROP_LAST
 };
 
@@ -210,8 +231,43 @@ struct _GstAdaptiveDemuxPrivate
    * without needing to stop tasks when they just want to
    * update the segment boundaries */
   GMutex segment_lock;
+
+  /* download-ahead window, protected by manifest_lock */
+  guint max_prefetch_fragments;
+  guint64 max_prefetch_bytes;
+  GstClockTime max_prefetch_time;
+
+  GstBandwidthEstimatorType bandwidth_estimator;        /* protected by manifest_lock */
+  GstAbrPolicyType abr_policy;  /* protected by manifest_lock */
+  GstClockTime abr_buffer_target;       /* protected by manifest_lock */
+  gboolean fragment_cache;      /* protected by manifest_lock */
+  gboolean fast_start;          /* protected by manifest_lock */
+  gboolean start_lowest_bitrate;        /* protected by manifest_lock */
+
+  /* runs the prefetch downloads. prefetch_lock/prefetch_cond protect the
+   * completion state of every GstAdaptiveDemuxPrefetch */
+  GThreadPool *prefetch_pool;
+  GMutex prefetch_lock;
+  GCond prefetch_cond;
 };
 
+typedef struct _GstAdaptiveDemuxPrefetch
+{
+  volatile gint ref_count;
+
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+  GstClockTime duration;
+
+  GstUriDownloader *downloader;
+
+  /* protected by prefetch_lock */
+  gboolean done;
+  GstBuffer *buffer;
+  GstClockTime download_time;
+} GstAdaptiveDemuxPrefetch;
+
 typedef struct _GstAdaptiveDemuxTimer
 {
   volatile gint ref_count;
@@ -302,6 +358,10 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
 static gboolean
 gst_adaptive_demux_wait_until (GstClock * clock, GCond * cond, GMutex * mutex,
     GstClockTime end_time);
+static void gst_adaptive_demux_prefetch_func (GstAdaptiveDemuxPrefetch *
+    prefetch, GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream *
+    stream);
 static gboolean gst_adaptive_demux_clock_callback (GstClock * clock,
     GstClockTime time, GstClockID id, gpointer user_data);
 static gboolean
@@ -354,6 +414,57 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_MAX_PREFETCH_FRAGMENTS:
+      demux->priv->max_prefetch_fragments = g_value_get_uint (value);
+      break;
+    case PROP_MAX_PREFETCH_BYTES:
+      demux->priv->max_prefetch_bytes = g_value_get_uint64 (value);
+      break;
+    case PROP_MAX_PREFETCH_TIME:
+      demux->priv->max_prefetch_time = g_value_get_uint64 (value);
+      break;
+    case PROP_BANDWIDTH_ESTIMATOR:{
+      GList *iter;
+
+      demux->priv->bandwidth_estimator = g_value_get_enum (value);
+      for (iter = demux->streams; iter; iter = g_list_next (iter)) {
+        GstAdaptiveDemuxStream *stream = iter->data;
+
+        gst_bandwidth_estimator_free (stream->estimator);
+        stream->estimator =
+            gst_bandwidth_estimator_new (demux->priv->bandwidth_estimator);
+      }
+      break;
+    }
+    case PROP_ABR_POLICY:
+      demux->priv->abr_policy = g_value_get_enum (value);
+      break;
+    case PROP_ABR_BUFFER_TARGET:
+      demux->priv->abr_buffer_target = g_value_get_uint64 (value);
+      break;
+    case PROP_FRAGMENT_CACHE:
+      demux->priv->fragment_cache = g_value_get_boolean (value);
+      break;
+    case PROP_FAST_START:
+      demux->priv->fast_start = g_value_get_boolean (value);
+      break;
+    case PROP_START_LOWEST_BITRATE:
+      demux->priv->start_lowest_bitrate = g_value_get_boolean (value);
+      break;
+    case PROP_FRAGMENT_CACHE_MAX_MEMORY:{
+      guint64 max_disk;
+
+      gst_fragment_cache_get_limits (NULL, &max_disk);
+      gst_fragment_cache_set_limits (g_value_get_uint64 (value), max_disk);
+      break;
+    }
+    case PROP_FRAGMENT_CACHE_MAX_DISK:{
+      guint64 max_memory;
+
+      gst_fragment_cache_get_limits (&max_memory, NULL);
+      gst_fragment_cache_set_limits (max_memory, g_value_get_uint64 (value));
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -378,6 +489,54 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_MAX_PREFETCH_FRAGMENTS:
+      g_value_set_uint (value, demux->priv->max_prefetch_fragments);
+      break;
+    case PROP_MAX_PREFETCH_BYTES:
+      g_value_set_uint64 (value, demux->priv->max_prefetch_bytes);
+      break;
+    case PROP_MAX_PREFETCH_TIME:
+      g_value_set_uint64 (value, demux->priv->max_prefetch_time);
+      break;
+    case PROP_CONNECTION_STATS:
+      g_value_take_boxed (value,
+          gst_uri_downloader_connection_pool_get_stats ());
+      break;
+    case PROP_BANDWIDTH_ESTIMATOR:
+      g_value_set_enum (value, demux->priv->bandwidth_estimator);
+      break;
+    case PROP_ABR_POLICY:
+      g_value_set_enum (value, demux->priv->abr_policy);
+      break;
+    case PROP_ABR_BUFFER_TARGET:
+      g_value_set_uint64 (value, demux->priv->abr_buffer_target);
+      break;
+    case PROP_FRAGMENT_CACHE:
+      g_value_set_boolean (value, demux->priv->fragment_cache);
+      break;
+    case PROP_FAST_START:
+      g_value_set_boolean (value, demux->priv->fast_start);
+      break;
+    case PROP_START_LOWEST_BITRATE:
+      g_value_set_boolean (value, demux->priv->start_lowest_bitrate);
+      break;
+    case PROP_FRAGMENT_CACHE_MAX_MEMORY:{
+      guint64 max_memory;
+
+      gst_fragment_cache_get_limits (&max_memory, NULL);
+      g_value_set_uint64 (value, max_memory);
+      break;
+    }
+    case PROP_FRAGMENT_CACHE_MAX_DISK:{
+      guint64 max_disk;
+
+      gst_fragment_cache_get_limits (NULL, &max_disk);
+      g_value_set_uint64 (value, max_disk);
+      break;
+    }
+    case PROP_FRAGMENT_CACHE_STATS:
+      g_value_take_boxed (value, gst_fragment_cache_get_stats ());
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -421,6 +580,93 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_MAX_PREFETCH_FRAGMENTS,
+      g_param_spec_uint ("max-prefetch-fragments", "Max prefetch fragments",
+          "Maximum number of upcoming fragments to download ahead of the "
+          "current one per stream (0 = disabled). Only used by subclasses "
+          "that can look ahead in their fragment list", 0, G_MAXUINT,
+          DEFAULT_MAX_PREFETCH_FRAGMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_PREFETCH_BYTES,
+      g_param_spec_uint64 ("max-prefetch-bytes", "Max prefetch bytes",
+          "Maximum amount of data to download ahead per stream (0 = unlimited)",
+          0, G_MAXUINT64, DEFAULT_MAX_PREFETCH_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_PREFETCH_TIME,
+      g_param_spec_uint64 ("max-prefetch-time", "Max prefetch time",
+          "Maximum duration of fragments to download ahead per stream, in "
+          "nanoseconds (0 = unlimited)", 0, G_MAXUINT64,
+          DEFAULT_MAX_PREFETCH_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CONNECTION_STATS,
+      g_param_spec_boxed ("connection-stats", "Connection statistics",
+          "Process-wide statistics on the reuse of source elements and "
+          "shared HTTP connections by all adaptive demuxers",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BANDWIDTH_ESTIMATOR,
+      g_param_spec_enum ("bandwidth-estimator", "Bandwidth estimator",
+          "Algorithm used to estimate the download bandwidth from the "
+          "previous fragments", GST_TYPE_BANDWIDTH_ESTIMATOR_TYPE,
+          DEFAULT_BANDWIDTH_ESTIMATOR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ABR_POLICY,
+      g_param_spec_enum ("abr-policy", "ABR policy",
+          "Policy used to choose the bitrate of the next fragment",
+          GST_TYPE_ABR_POLICY_TYPE, DEFAULT_ABR_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ABR_BUFFER_TARGET,
+      g_param_spec_uint64 ("abr-buffer-target", "ABR buffer target",
+          "Amount of data, in nanoseconds, the buffer based ABR policy aims "
+          "to keep buffered downstream", 0, G_MAXUINT64,
+          DEFAULT_ABR_BUFFER_TARGET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FRAGMENT_CACHE,
+      g_param_spec_boolean ("fragment-cache", "Fragment cache",
+          "Share downloaded fragments with all adaptive demuxers of the "
+          "process that use the cache, and use the fragments they downloaded",
+          DEFAULT_FRAGMENT_CACHE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_FRAGMENT_CACHE_MAX_MEMORY,
+      g_param_spec_uint64 ("fragment-cache-max-memory",
+          "Fragment cache max memory",
+          "Maximum amount of data the process-wide fragment cache keeps in "
+          "memory, in bytes", 0, G_MAXUINT64,
+          GST_FRAGMENT_CACHE_DEFAULT_MAX_MEMORY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FRAGMENT_CACHE_MAX_DISK,
+      g_param_spec_uint64 ("fragment-cache-max-disk", "Fragment cache max disk",
+          "Maximum amount of data the process-wide fragment cache keeps in "
+          "memory-mapped temporary files once the memory is full, in bytes",
+          0, G_MAXUINT64, GST_FRAGMENT_CACHE_DEFAULT_MAX_DISK,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FRAGMENT_CACHE_STATS,
+      g_param_spec_boxed ("fragment-cache-stats", "Fragment cache statistics",
+          "Process-wide statistics of the fragment cache",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FAST_START,
+      g_param_spec_boolean ("fast-start", "Fast start",
+          "Download the first fragment of a stream while its header is "
+          "being downloaded instead of after it",
+          DEFAULT_FAST_START, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_START_LOWEST_BITRATE,
+      g_param_spec_boolean ("start-lowest-bitrate", "Start at lowest bitrate",
+          "Start playback with the lowest bitrate of each stream and let the "
+          "bitrate adaptation switch up from there",
+          DEFAULT_START_LOWEST_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -513,6 +759,21 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->max_prefetch_fragments = DEFAULT_MAX_PREFETCH_FRAGMENTS;
+  demux->priv->max_prefetch_bytes = DEFAULT_MAX_PREFETCH_BYTES;
+  demux->priv->max_prefetch_time = DEFAULT_MAX_PREFETCH_TIME;
+  demux->priv->fragment_cache = DEFAULT_FRAGMENT_CACHE;
+  demux->priv->fast_start = DEFAULT_FAST_START;
+  demux->priv->start_lowest_bitrate = DEFAULT_START_LOWEST_BITRATE;
+  demux->priv->bandwidth_estimator = DEFAULT_BANDWIDTH_ESTIMATOR;
+  demux->priv->abr_policy = DEFAULT_ABR_POLICY;
+  demux->priv->abr_buffer_target = DEFAULT_ABR_BUFFER_TARGET;
+
+  g_mutex_init (&demux->priv->prefetch_lock);
+  g_cond_init (&demux->priv->prefetch_cond);
+  demux->priv->prefetch_pool =
+      g_thread_pool_new ((GFunc) gst_adaptive_demux_prefetch_func, demux, -1,
+      FALSE, NULL);
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -525,6 +786,11 @@ gst_adaptive_demux_finalize (GObject * object)
 
   GST_DEBUG_OBJECT (object, "finalize");
 
+  /* all streams are gone and their prefetches cancelled by now */
+  g_thread_pool_free (priv->prefetch_pool, FALSE, TRUE);
+  g_mutex_clear (&priv->prefetch_lock);
+  g_cond_clear (&priv->prefetch_cond);
+
   g_object_unref (priv->input_adapter);
   g_object_unref (demux->downloader);
 
@@ -710,6 +976,14 @@ gst_adaptive_demux_sink_event (GstPad * pad, GstObject * parent,
         }
 
         if (demux->next_streams) {
+          if (demux->priv->start_lowest_bitrate) {
+            GList *iter;
+
+            /* no representation fits, so the subclass takes its lowest */
+            for (iter = demux->next_streams; iter; iter = g_list_next (iter))
+              gst_adaptive_demux_stream_select_bitrate (demux, iter->data, 1);
+          }
+
           gst_adaptive_demux_prepare_streams (demux,
               gst_adaptive_demux_is_live (demux));
           gst_adaptive_demux_start_tasks (demux, TRUE);
@@ -901,6 +1175,15 @@ gst_adaptive_demux_handle_message (GstBin * bin, GstMessage * msg)
       msg = NULL;
     }
       break;
+    case GST_MESSAGE_HAVE_CONTEXT:{
+      GstContext *context;
+
+      /* let the sources of all other streams and demuxers share it */
+      gst_message_parse_have_context (msg, &context);
+      gst_uri_downloader_connection_pool_add (context);
+      gst_context_unref (context);
+    }
+      break;
     default:
       break;
   }
@@ -1306,8 +1589,8 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
 
   stream->pad = pad;
   stream->demux = demux;
-  stream->fragment_bitrates =
-      g_malloc0 (sizeof (guint64) * NUM_LOOKBACK_FRAGMENTS);
+  stream->estimator =
+      gst_bandwidth_estimator_new (demux->priv->bandwidth_estimator);
   gst_pad_set_element_private (pad, stream);
   stream->qos_earliest_time = GST_CLOCK_TIME_NONE;
 
@@ -1345,6 +1628,100 @@ gst_adaptive_demux_find_stream_for_pad (GstAdaptiveDemux * demux, GstPad * pad)
   return NULL;
 }
 
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_new (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  prefetch = g_slice_new0 (GstAdaptiveDemuxPrefetch);
+  prefetch->ref_count = 1;
+  prefetch->uri = g_strdup (fragment->uri);
+  prefetch->range_start = fragment->range_start;
+  prefetch->range_end = fragment->range_end;
+  prefetch->duration = fragment->duration;
+  prefetch->download_time = GST_CLOCK_TIME_NONE;
+
+  prefetch->downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_parent (prefetch->downloader,
+      GST_ELEMENT_CAST (demux));
+
+  return prefetch;
+}
+
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_ref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  g_atomic_int_inc (&prefetch->ref_count);
+  return prefetch;
+}
+
+static void
+gst_adaptive_demux_prefetch_unref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  if (g_atomic_int_dec_and_test (&prefetch->ref_count)) {
+    g_free (prefetch->uri);
+    gst_object_unref (prefetch->downloader);
+    if (prefetch->buffer)
+      gst_buffer_unref (prefetch->buffer);
+    g_slice_free (GstAdaptiveDemuxPrefetch, prefetch);
+  }
+}
+
+/* runs in a thread of priv->prefetch_pool, without any demux lock */
+static void
+gst_adaptive_demux_prefetch_func (GstAdaptiveDemuxPrefetch * prefetch,
+    GstAdaptiveDemux * demux)
+{
+  GstFragment *download;
+  GstBuffer *buffer = NULL;
+  GstClockTime start;
+  GError *err = NULL;
+
+  start = gst_adaptive_demux_get_monotonic_time (demux);
+  download = gst_uri_downloader_fetch_uri_with_range (prefetch->downloader,
+      prefetch->uri, NULL, FALSE, FALSE, TRUE, prefetch->range_start,
+      prefetch->range_end, &err);
+
+  if (download) {
+    buffer = gst_fragment_get_buffer (download);
+    g_object_unref (download);
+  } else {
+    GST_DEBUG_OBJECT (demux, "Prefetch of %s failed: %s", prefetch->uri,
+        err ? err->message : "cancelled");
+    g_clear_error (&err);
+  }
+
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  prefetch->buffer = buffer;
+  prefetch->download_time = gst_adaptive_demux_get_monotonic_time (demux) -
+      start;
+  prefetch->done = TRUE;
+  g_cond_broadcast (&demux->priv->prefetch_cond);
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+
+  gst_adaptive_demux_prefetch_unref (prefetch);
+}
+
+/* must be called with manifest_lock taken.
+ * Cancels and drops every fragment downloaded ahead for @stream. A download
+ * thread waiting on stream->prefetch_current is woken up by the cancellation.
+ */
+static void
+gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  if (stream->prefetch_current)
+    gst_uri_downloader_cancel (((GstAdaptiveDemuxPrefetch *)
+            stream->prefetch_current)->downloader);
+
+  while ((prefetch = g_queue_pop_head (&stream->prefetch_queue))) {
+    gst_uri_downloader_cancel (prefetch->downloader);
+    gst_adaptive_demux_prefetch_unref (prefetch);
+  }
+}
+
 /* must be called with manifest_lock taken.
  * It will temporarily drop the manifest_lock in order to join the task.
  * It will join only the old_streams (the demux->streams are joined by
@@ -1373,6 +1750,7 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
     }
+    gst_adaptive_demux_stream_clear_prefetch (stream);
     GST_LOG_OBJECT (demux, "Waiting for task to finish");
 
     /* temporarily drop the manifest lock to join the task */
@@ -1423,7 +1801,7 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
 
   g_cond_clear (&stream->fragment_download_cond);
   g_mutex_clear (&stream->fragment_download_lock);
-  g_free (stream->fragment_bitrates);
+  gst_bandwidth_estimator_free (stream->estimator);
 
   if (stream->pad) {
     gst_object_unref (stream->pad);
@@ -1433,6 +1811,7 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
     gst_caps_unref (stream->pending_caps);
 
   g_clear_pointer (&stream->pending_tags, gst_tag_list_unref);
+  gst_buffer_replace (&stream->cache_buffer, NULL);
 
   g_free (stream);
 }
@@ -2082,6 +2461,9 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
       gst_task_stop (stream->download_task);
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      /* whatever was downloaded ahead is stale after a seek or flush */
+      gst_adaptive_demux_stream_clear_prefetch (stream);
     }
     list_to_process = demux->prepared_streams;
   }
@@ -2191,31 +2573,13 @@ gst_adaptive_demux_stream_queue_event (GstAdaptiveDemuxStream * stream,
   stream->pending_events = g_list_append (stream->pending_events, event);
 }
 
-/* must be called with manifest_lock taken */
-static guint64
-_update_average_bitrate (GstAdaptiveDemux * demux,
-    GstAdaptiveDemuxStream * stream, guint64 new_bitrate)
-{
-  gint index = stream->moving_index % NUM_LOOKBACK_FRAGMENTS;
-
-  stream->moving_bitrate -= stream->fragment_bitrates[index];
-  stream->fragment_bitrates[index] = new_bitrate;
-  stream->moving_bitrate += new_bitrate;
-
-  stream->moving_index += 1;
-
-  if (stream->moving_index > NUM_LOOKBACK_FRAGMENTS)
-    return stream->moving_bitrate / NUM_LOOKBACK_FRAGMENTS;
-  return stream->moving_bitrate / stream->moving_index;
-}
-
 /* must be called with manifest_lock taken */
 static guint64
 gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream)
 {
-  guint64 average_bitrate;
-  guint64 fragment_bitrate;
+  guint64 fragment_bitrate, throughput, bitrate;
+  GstClockTime latency;
 
   if (demux->connection_speed) {
     GST_LOG_OBJECT (demux, "Connection-speed is set to %u kbps, using it",
@@ -2227,18 +2591,23 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
   GST_DEBUG_OBJECT (demux, "Download bitrate is : %" G_GUINT64_FORMAT " bps",
       fragment_bitrate);
 
-  average_bitrate = _update_average_bitrate (demux, stream, fragment_bitrate);
+  gst_bandwidth_estimator_add_sample (stream->estimator,
+      gst_util_uint64_scale (fragment_bitrate, stream->last_download_time,
+          8 * GST_SECOND), stream->last_latency, stream->last_download_time);
+
+  throughput = gst_bandwidth_estimator_get_throughput (stream->estimator);
+  latency = gst_bandwidth_estimator_get_latency (stream->estimator);
+  bitrate = gst_bandwidth_estimator_get_bitrate (stream->estimator,
+      stream->fragment.duration);
 
   GST_INFO_OBJECT (stream, "last fragment bitrate was %" G_GUINT64_FORMAT,
       fragment_bitrate);
-  GST_INFO_OBJECT (stream,
-      "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
-      NUM_LOOKBACK_FRAGMENTS, average_bitrate);
-
-  /* Conservative approach, make sure we don't upgrade too fast */
-  stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+  GST_INFO_OBJECT (stream, "%s estimate: throughput %" G_GUINT64_FORMAT
+      " latency %" GST_TIME_FORMAT " bitrate %" G_GUINT64_FORMAT,
+      gst_bandwidth_estimator_get_name (stream->estimator), throughput,
+      GST_TIME_ARGS (latency), bitrate);
 
-  stream->current_download_rate *= demux->bitrate_limit;
+  stream->current_download_rate = bitrate * demux->bitrate_limit;
   GST_DEBUG_OBJECT (demux, "Bitrate after bitrate limit (%0.2f): %"
       G_GUINT64_FORMAT, demux->bitrate_limit, stream->current_download_rate);
 
@@ -2254,9 +2623,105 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
   }
 #endif
 
+  gst_element_post_message (GST_ELEMENT_CAST (demux),
+      gst_message_new_element (GST_OBJECT_CAST (demux),
+          gst_structure_new (GST_ADAPTIVE_DEMUX_BANDWIDTH_MESSAGE_NAME,
+              "manifest-uri", G_TYPE_STRING, demux->manifest_uri,
+              "stream", G_TYPE_STRING, GST_PAD_NAME (stream->pad),
+              "estimator", G_TYPE_STRING,
+              gst_bandwidth_estimator_get_name (stream->estimator),
+              "throughput", G_TYPE_UINT64, throughput,
+              "latency", GST_TYPE_CLOCK_TIME, latency,
+              "bitrate", G_TYPE_UINT64, stream->current_download_rate,
+              NULL)));
+
   return stream->current_download_rate;
 }
 
+/* must be called with manifest_lock taken.
+ * Returns how far the data pushed on @stream is ahead of the playback
+ * position downstream, or GST_CLOCK_TIME_NONE if it can't be queried */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  gint64 position;
+  guint64 pushed;
+
+  if (!gst_pad_peer_query_position (stream->pad, GST_FORMAT_TIME, &position)
+      || position < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
+  pushed = gst_segment_to_stream_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  GST_ADAPTIVE_DEMUX_SEGMENT_UNLOCK (demux);
+
+  if (!GST_CLOCK_TIME_IS_VALID (pushed))
+    return GST_CLOCK_TIME_NONE;
+
+  return pushed > position ? pushed - position : 0;
+}
+
+static gint
+_compare_bitrates (gconstpointer a, gconstpointer b)
+{
+  guint64 ba = *(const guint64 *) a, bb = *(const guint64 *) b;
+
+  return ba < bb ? -1 : (ba > bb ? 1 : 0);
+}
+
+/* must be called with manifest_lock taken.
+ * Lets the ABR policy turn the download rate estimate into the bitrate to
+ * request from the subclass */
+static guint64
+gst_adaptive_demux_stream_apply_abr_policy (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, guint64 bitrate)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAbrPolicyInfo info = { 0, };
+  GArray *bitrates;
+  guint i, n;
+
+  if (demux->priv->abr_policy == GST_ABR_POLICY_THROUGHPUT
+      || demux->connection_speed || klass->stream_get_bitrates == NULL)
+    return bitrate;
+
+  bitrates = g_array_new (FALSE, FALSE, sizeof (guint64));
+  if (!klass->stream_get_bitrates (stream, bitrates, &info.current_bitrate)
+      || bitrates->len == 0) {
+    g_array_free (bitrates, TRUE);
+    return bitrate;
+  }
+
+  /* sort and drop duplicates */
+  g_array_sort (bitrates, _compare_bitrates);
+  for (i = 1, n = 1; i < bitrates->len; i++) {
+    if (g_array_index (bitrates, guint64, i) !=
+        g_array_index (bitrates, guint64, n - 1))
+      g_array_index (bitrates, guint64, n++) =
+          g_array_index (bitrates, guint64, i);
+  }
+
+  info.throughput = bitrate;
+  info.buffer_level = gst_adaptive_demux_stream_get_buffer_level (demux,
+      stream);
+  info.buffer_target = demux->priv->abr_buffer_target;
+  info.fragment_duration = stream->fragment.duration;
+  info.bitrates = (const guint64 *) bitrates->data;
+  info.n_bitrates = n;
+
+  bitrate = gst_abr_policy_select_bitrate (demux->priv->abr_policy, &info);
+
+  GST_DEBUG_OBJECT (stream->pad, "ABR policy picked %" G_GUINT64_FORMAT
+      " bps (throughput %" G_GUINT64_FORMAT ", buffer %" GST_TIME_FORMAT ")",
+      bitrate, info.throughput, GST_TIME_ARGS (info.buffer_level));
+
+  g_array_free (bitrates, TRUE);
+
+  return bitrate;
+}
+
 /* must be called with manifest_lock taken */
 static GstFlowReturn
 gst_adaptive_demux_combine_flows (GstAdaptiveDemux * demux)
@@ -2538,6 +3003,16 @@ _src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   }
   g_mutex_unlock (&stream->fragment_download_lock);
 
+  /* keep the raw data for the fragment cache, the memory is shared so this
+   * only copies if someone modifies it in place later */
+  if (stream->cache_collect) {
+    if (stream->cache_buffer)
+      stream->cache_buffer =
+          gst_buffer_append (stream->cache_buffer, gst_buffer_ref (buffer));
+    else
+      stream->cache_buffer = gst_buffer_ref (buffer);
+  }
+
   /* starting_fragment is set to TRUE at the beginning of
    * _stream_download_fragment()
    * /!\ If there is a header/index being downloaded, then this will
@@ -2758,6 +3233,10 @@ _src_query (GstPad * pad, GstObject * parent, GstQuery * query)
     case GST_QUERY_ALLOCATION:
       return FALSE;
       break;
+    case GST_QUERY_CONTEXT:
+      if (gst_uri_downloader_connection_pool_query (query))
+        return TRUE;
+      break;
     default:
       break;
   }
@@ -2931,6 +3410,8 @@ gst_adaptive_demux_stream_update_source (GstAdaptiveDemuxStream * stream,
         gst_element_set_state (src, GST_STATE_NULL);
         gst_bin_remove (GST_BIN_CAST (demux), src);
         GST_MANIFEST_LOCK (demux);
+      } else {
+        gst_uri_downloader_connection_pool_count_request (TRUE);
       }
     }
     g_free (old_uri);
@@ -3068,6 +3549,8 @@ gst_adaptive_demux_stream_update_source (GstAdaptiveDemuxStream * stream,
     stream->uri_handler = uri_handler;
     stream->queue = queue;
 
+    gst_uri_downloader_connection_pool_count_request (FALSE);
+
     stream->last_status_code = 200;     /* default to OK */
   }
   return TRUE;
@@ -3100,6 +3583,64 @@ uritype (GstAdaptiveDemuxStream * s)
 }
 #endif
 
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ * Pushes the data of @uri through the stream as
+ * gst_adaptive_demux_stream_download_uri() would if it is in the fragment
+ * cache. Returns FALSE if it isn't and the data has to be downloaded.
+ */
+static gboolean
+gst_adaptive_demux_stream_push_cached (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, const gchar * uri, gint64 start,
+    gint64 end, GstFlowReturn * ret)
+{
+  GstBuffer *buffer;
+
+  if (stream->internal_pad == NULL)
+    return FALSE;
+
+  buffer = gst_fragment_cache_lookup (uri, start, end);
+  if (buffer == NULL)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (stream->pad, "Using cached %s, %" G_GSIZE_FORMAT
+      " bytes", uri, gst_buffer_get_size (buffer));
+
+  /* nothing was downloaded, keep this out of the bandwidth estimation */
+  stream->last_latency = 0;
+  stream->last_download_time = 0;
+  stream->last_bitrate = 0;
+
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* _src_chain() takes the manifest lock itself */
+  GST_MANIFEST_UNLOCK (demux);
+  *ret = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    return TRUE;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* the whole fragment was pushed, behave like EOS from the source */
+  if (*ret == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+  else if (stream->last_ret == GST_FLOW_OK)
+    stream->last_ret = *ret;
+  *ret = stream->last_ret;
+
+  return TRUE;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  *
@@ -3111,6 +3652,8 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
     gint64 end, guint * http_status)
 {
   GstFlowReturn ret = GST_FLOW_OK;
+  gint64 range_end = end;
+
   GST_DEBUG_OBJECT (stream->pad,
       "Downloading %s uri: %s, range:%" G_GINT64_FORMAT " - %" G_GINT64_FORMAT,
       uritype (stream), uri, start, end);
@@ -3118,6 +3661,15 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
   if (http_status)
     *http_status = 200;         /* default to ok if no further information */
 
+  gst_buffer_replace (&stream->cache_buffer, NULL);
+  stream->cache_collect = FALSE;
+  if (demux->priv->fragment_cache) {
+    if (gst_adaptive_demux_stream_push_cached (demux, stream, uri, start, end,
+            &ret))
+      return ret;
+    stream->cache_collect = TRUE;
+  }
+
   if (!gst_adaptive_demux_stream_update_source (stream, uri, NULL, FALSE, TRUE)) {
     ret = stream->last_ret = GST_FLOW_ERROR;
     return ret;
@@ -3214,6 +3766,8 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
       GST_DEBUG_OBJECT (stream->pad, "%s download finished: %s %d %s",
           uritype (stream), uri, stream->last_ret,
           gst_flow_get_name (stream->last_ret));
+      if (ret == GST_FLOW_OK && stream->cache_collect && stream->cache_buffer)
+        gst_fragment_cache_insert (uri, start, range_end, stream->cache_buffer);
       if (stream->last_ret != GST_FLOW_OK && http_status) {
         *http_status = stream->last_status_code;
       }
@@ -3231,6 +3785,8 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
   }
 
   stream->src_at_ready = FALSE;
+  stream->cache_collect = FALSE;
+  gst_buffer_replace (&stream->cache_buffer, NULL);
 
   gst_element_set_locked_state (stream->src, TRUE);
   gst_pad_add_probe (stream->src_srcpad, GST_PAD_PROBE_TYPE_IDLE,
@@ -3304,6 +3860,239 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   return ret;
 }
 
+static gboolean
+gst_adaptive_demux_prefetch_matches (GstAdaptiveDemuxPrefetch * prefetch,
+    GstAdaptiveDemuxStreamFragment * fragment)
+{
+  return g_strcmp0 (prefetch->uri, fragment->uri) == 0 &&
+      prefetch->range_start == fragment->range_start &&
+      prefetch->range_end == fragment->range_end;
+}
+
+/* must be called with manifest_lock taken.
+ * Returns the prefetch for the current fragment, if there is one. If the
+ * head of the queue is for another fragment, the fragment list changed
+ * (bitrate switch, manifest update) and the whole queue is dropped.
+ */
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_stream_take_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  prefetch = g_queue_peek_head (&stream->prefetch_queue);
+  if (prefetch == NULL)
+    return NULL;
+
+  if (gst_adaptive_demux_prefetch_matches (prefetch, &stream->fragment))
+    return g_queue_pop_head (&stream->prefetch_queue);
+
+  GST_DEBUG_OBJECT (stream->pad, "Prefetched fragments don't follow %s, "
+      "dropping them", stream->fragment.uri);
+  gst_adaptive_demux_stream_clear_prefetch (stream);
+
+  return NULL;
+}
+
+/* must be called with manifest_lock taken.
+ * Tops up the download-ahead window of @stream with the fragments following
+ * the current one, within the limits of the max-prefetch-* properties.
+ */
+static void
+gst_adaptive_demux_stream_schedule_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  GstAdaptiveDemuxStreamFragment fragment = { 0, };
+  GstAdaptiveDemuxPrefetch *prefetch;
+  guint64 bytes = 0;
+  GstClockTime time = 0;
+  GList *l;
+  guint offset;
+
+  if (klass->stream_peek_fragment == NULL || priv->max_prefetch_fragments == 0) {
+    gst_adaptive_demux_stream_clear_prefetch (stream);
+    return;
+  }
+
+  fragment.range_end = -1;
+  l = stream->prefetch_queue.head;
+  for (offset = 1; offset <= priv->max_prefetch_fragments; offset++) {
+    if (priv->max_prefetch_bytes && bytes >= priv->max_prefetch_bytes)
+      break;
+    if (priv->max_prefetch_time && time >= priv->max_prefetch_time)
+      break;
+
+    if (!klass->stream_peek_fragment (stream, offset, &fragment)
+        || fragment.uri == NULL) {
+      gst_adaptive_demux_stream_fragment_clear (&fragment);
+      break;
+    }
+
+    if (l && !gst_adaptive_demux_prefetch_matches (l->data, &fragment)) {
+      GList *prev = l->prev;
+
+      /* the fragment list changed, drop everything from here on */
+      while (g_queue_peek_tail_link (&stream->prefetch_queue) != prev) {
+        prefetch = g_queue_pop_tail (&stream->prefetch_queue);
+        gst_uri_downloader_cancel (prefetch->downloader);
+        gst_adaptive_demux_prefetch_unref (prefetch);
+      }
+      l = NULL;
+    }
+
+    if (l) {
+      prefetch = l->data;
+      l = l->next;
+    } else {
+      GST_DEBUG_OBJECT (stream->pad, "Prefetching %s %" G_GINT64_FORMAT "-%"
+          G_GINT64_FORMAT, fragment.uri, fragment.range_start,
+          fragment.range_end);
+      prefetch = gst_adaptive_demux_prefetch_new (demux, &fragment);
+      g_queue_push_tail (&stream->prefetch_queue, prefetch);
+      g_thread_pool_push (priv->prefetch_pool,
+          gst_adaptive_demux_prefetch_ref (prefetch), NULL);
+    }
+    gst_adaptive_demux_stream_fragment_clear (&fragment);
+
+    g_mutex_lock (&priv->prefetch_lock);
+    if (prefetch->buffer)
+      bytes += gst_buffer_get_size (prefetch->buffer);
+    else if (prefetch->range_end != -1)
+      bytes += prefetch->range_end - prefetch->range_start + 1;
+    g_mutex_unlock (&priv->prefetch_lock);
+    if (GST_CLOCK_TIME_IS_VALID (prefetch->duration))
+      time += prefetch->duration;
+  }
+}
+
+/* must be called with manifest_lock taken.
+ * Starts downloading the current fragment in the prefetch pool, so it
+ * arrives while the header is downloaded by the stream task.
+ */
+static void
+gst_adaptive_demux_stream_prefetch_current (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  /* chunked downloads and fragments located by an index that has not been
+   * downloaded yet can't be fetched in one go. Neither can the rest of a
+   * single file media, which would be downloaded completely */
+  if (stream->fragment.uri == NULL || stream->fragment.index_uri != NULL
+      || GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (demux))
+    return;
+  if (stream->fragment.range_end == -1
+      && g_strcmp0 (stream->fragment.header_uri, stream->fragment.uri) == 0)
+    return;
+
+  prefetch = g_queue_peek_head (&stream->prefetch_queue);
+  if (prefetch && gst_adaptive_demux_prefetch_matches (prefetch,
+          &stream->fragment))
+    return;
+  gst_adaptive_demux_stream_clear_prefetch (stream);
+
+  GST_DEBUG_OBJECT (stream->pad, "Fetching %s together with the header",
+      stream->fragment.uri);
+  prefetch = gst_adaptive_demux_prefetch_new (demux, &stream->fragment);
+  g_queue_push_tail (&stream->prefetch_queue, prefetch);
+  g_thread_pool_push (demux->priv->prefetch_pool,
+      gst_adaptive_demux_prefetch_ref (prefetch), NULL);
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ * Waits for @prefetch to complete and pushes its data through the stream as
+ * gst_adaptive_demux_stream_download_uri() would. Returns FALSE if the
+ * prefetch failed and the fragment has to be downloaded normally.
+ */
+static gboolean
+gst_adaptive_demux_stream_push_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstAdaptiveDemuxPrefetch * prefetch,
+    GstFlowReturn * ret)
+{
+  GstBuffer *buffer;
+  gsize size;
+
+  stream->prefetch_current = prefetch;
+
+  GST_DEBUG_OBJECT (stream->pad, "Waiting for prefetch of %s", prefetch->uri);
+
+  GST_MANIFEST_UNLOCK (demux);
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  while (!prefetch->done)
+    g_cond_wait (&demux->priv->prefetch_cond, &demux->priv->prefetch_lock);
+  buffer = prefetch->buffer;
+  prefetch->buffer = NULL;
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+  GST_MANIFEST_LOCK (demux);
+
+  stream->prefetch_current = NULL;
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    if (buffer)
+      gst_buffer_unref (buffer);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    goto done;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  if (buffer == NULL || stream->internal_pad == NULL) {
+    if (buffer)
+      gst_buffer_unref (buffer);
+    gst_adaptive_demux_prefetch_unref (prefetch);
+    return FALSE;
+  }
+
+  size = gst_buffer_get_size (buffer);
+  GST_DEBUG_OBJECT (stream->pad, "Using prefetched %s, %" G_GSIZE_FORMAT
+      " bytes in %" GST_TIME_FORMAT, prefetch->uri, size,
+      GST_TIME_ARGS (prefetch->download_time));
+
+  /* the download measurements normally taken by _uri_handler_probe() */
+  stream->last_latency = 0;
+  stream->last_download_time = prefetch->download_time;
+  stream->last_bitrate = prefetch->download_time ?
+      gst_util_uint64_scale (size, 8 * GST_SECOND,
+      prefetch->download_time) : 0;
+  if (stream->fragment.bitrate == 0 && stream->fragment.duration != 0)
+    stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+            8 * GST_SECOND, stream->fragment.duration));
+
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* _src_chain() takes the manifest lock itself */
+  GST_MANIFEST_UNLOCK (demux);
+  *ret = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    goto done;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* the whole fragment was pushed, behave like EOS from the source */
+  if (*ret == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+  else if (stream->last_ret == GST_FLOW_OK)
+    stream->last_ret = *ret;
+  *ret = stream->last_ret;
+
+done:
+  gst_adaptive_demux_prefetch_unref (prefetch);
+  return TRUE;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3334,6 +4123,9 @@ gst_adaptive_demux_stream_download_fragment (GstAdaptiveDemuxStream * stream)
     goto no_url_error;
 
   if (stream->need_header) {
+    if (demux->priv->fast_start)
+      gst_adaptive_demux_stream_prefetch_current (demux, stream);
+
     ret = gst_adaptive_demux_stream_download_header_fragment (stream);
     if (ret != GST_FLOW_OK) {
       return ret;
@@ -3422,9 +4214,18 @@ again:
         chunk_end = MIN (chunk_end, range_end);
     }
   } else {
-    ret =
-        gst_adaptive_demux_stream_download_uri (demux, stream, url,
-        stream->fragment.range_start, stream->fragment.range_end, &http_status);
+    GstAdaptiveDemuxPrefetch *prefetch;
+
+    prefetch = gst_adaptive_demux_stream_take_prefetch (stream);
+    gst_adaptive_demux_stream_schedule_prefetch (demux, stream);
+
+    if (prefetch == NULL
+        || !gst_adaptive_demux_stream_push_prefetch (demux, stream, prefetch,
+            &ret))
+      ret =
+          gst_adaptive_demux_stream_download_uri (demux, stream, url,
+          stream->fragment.range_start, stream->fragment.range_end,
+          &http_status);
     GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
         stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
   }
@@ -4206,8 +5007,12 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
       GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
 
   if (ret == GST_FLOW_OK) {
-    if (gst_adaptive_demux_stream_select_bitrate (demux, stream,
-            gst_adaptive_demux_stream_update_current_bitrate (demux, stream))) {
+    guint64 bitrate =
+        gst_adaptive_demux_stream_update_current_bitrate (demux, stream);
+
+    bitrate = gst_adaptive_demux_stream_apply_abr_policy (demux, stream,
+        bitrate);
+    if (gst_adaptive_demux_stream_select_bitrate (demux, stream, bitrate)) {
       stream->need_header = TRUE;
       ret = (GstFlowReturn) GST_ADAPTIVE_DEMUX_FLOW_SWITCH;
     }
@@ -25,6 +25,9 @@
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
 #include <gst/uridownloader/gsturidownloader.h>
+#include "gstabrpolicy.h"
+#include "gstbandwidthestimator.h"
+#include "gstfragmentcache.h"
 
 G_BEGIN_DECLS
 
@@ -74,6 +77,14 @@ G_BEGIN_DECLS
  */
 #define GST_ADAPTIVE_DEMUX_STATISTICS_MESSAGE_NAME "adaptive-streaming-statistics"
 
+/**
+ * GST_ADAPTIVE_DEMUX_BANDWIDTH_MESSAGE_NAME:
+ *
+ * Name of the ELEMENT type messages posted with the bandwidth estimate of a
+ * stream after each fragment.
+ */
+#define GST_ADAPTIVE_DEMUX_BANDWIDTH_MESSAGE_NAME "adaptive-streaming-bandwidth"
+
 #define GST_ELEMENT_ERROR_FROM_ERROR(el, msg, err) G_STMT_START { \
   gchar *__dbg = g_strdup_printf ("%s: %s", msg, err->message);         \
   GST_WARNING_OBJECT (el, "error: %s", __dbg);                          \
@@ -178,10 +189,8 @@ struct _GstAdaptiveDemuxStream
   GstClockTime last_latency;
   GstClockTime last_download_time;
 
-  /* Average for the last fragments */
-  guint64 moving_bitrate;
-  guint moving_index;
-  guint64 *fragment_bitrates;
+  /* throughput and latency of the last fragments */
+  GstBandwidthEstimator *estimator;
 
   /* QoS data */
   GstClockTime qos_earliest_time;
@@ -194,6 +203,15 @@ struct _GstAdaptiveDemuxStream
   gboolean eos;
 
   gboolean do_block; /* TRUE if stream should block on preroll */
+
+  /* fragments downloaded ahead of the current one, see
+   * GstAdaptiveDemuxClass::stream_peek_fragment */
+  GQueue prefetch_queue;
+  gpointer prefetch_current;
+
+  /* data of the current download, for the fragment cache */
+  gboolean cache_collect;
+  GstBuffer *cache_buffer;
 };
 
 /**
@@ -481,6 +499,38 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment:
+   * @stream: #GstAdaptiveDemuxStream
+   * @offset: how many fragments ahead of the current one to look
+   * @fragment: (out): #GstAdaptiveDemuxStreamFragment to fill
+   *
+   * Optional. Fills the uri, range and duration of the fragment @offset
+   * positions after the current one, honouring the playback direction,
+   * without changing the stream position. Implementing this allows the
+   * base class to download upcoming fragments ahead of time, see the
+   * max-prefetch-fragments property.
+   *
+   * Return: %TRUE if such a fragment is known.
+   */
+  gboolean (*stream_peek_fragment) (GstAdaptiveDemuxStream * stream,
+      guint offset, GstAdaptiveDemuxStreamFragment * fragment);
+
+  /**
+   * stream_get_bitrates:
+   * @stream: #GstAdaptiveDemuxStream
+   * @bitrates: (element-type guint64): array to append the bitrates to
+   * @current_bitrate: (out): bitrate of the representation in use
+   *
+   * Optional. Appends the bitrates of the representations available for
+   * @stream, in any order. Policies other than the throughput one, see
+   * the abr-policy property, need it.
+   *
+   * Return: %TRUE if @stream can switch between the returned bitrates
+   */
+  gboolean (*stream_get_bitrates) (GstAdaptiveDemuxStream * stream,
+      GArray * bitrates, guint64 * current_bitrate);
 };
 
 GST_EXPORT
@@ -0,0 +1,316 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Download bandwidth estimators for the bitrate selection of
+ * GstAdaptiveDemux.
+ *
+ * Every fragment download gives a sample made of its size, the time to its
+ * first byte (latency) and its total download time. The latency mostly
+ * depends on the round trip time and the server, not on the link capacity,
+ * so except for the legacy moving average the estimators only use the time
+ * after the first byte to compute throughput samples, and track the
+ * latency on its own. gst_bandwidth_estimator_get_bitrate() puts both back
+ * together for fragments of a given duration.
+ *
+ * Adding an algorithm only needs a new GstBandwidthEstimatorImpl.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "gstbandwidthestimator.h"
+
+/* samples kept for the window based estimators */
+#define SAMPLE_WINDOW 10
+#define MOVING_AVERAGE_WINDOW 3
+#define HARMONIC_MEAN_WINDOW 5
+#define PERCENTILE 25
+
+/* half-lives of the EWMA estimators, in seconds of download time */
+#define EWMA_FAST_HALF_LIFE 2.0
+#define EWMA_SLOW_HALF_LIFE 5.0
+
+/* weight of a new latency sample */
+#define LATENCY_ALPHA 0.25
+
+typedef struct
+{
+  const gchar *name;
+  /* if TRUE, samples include the latency and no correction is applied */
+  gboolean include_latency;
+  void (*add_sample) (GstBandwidthEstimator * estimator, guint64 bitrate,
+      gdouble weight);
+  guint64 (*get_throughput) (GstBandwidthEstimator * estimator);
+} GstBandwidthEstimatorImpl;
+
+typedef struct
+{
+  gdouble estimate;
+  gdouble total_weight;
+} GstEwma;
+
+struct _GstBandwidthEstimator
+{
+  const GstBandwidthEstimatorImpl *impl;
+
+  GstClockTime latency;
+
+  /* the most recent sample is at (index + SAMPLE_WINDOW - 1) % SAMPLE_WINDOW */
+  guint64 samples[SAMPLE_WINDOW];
+  guint n_samples;
+  guint index;
+
+  GstEwma fast;
+  GstEwma slow;
+};
+
+static guint64
+gst_bandwidth_estimator_get_sample (GstBandwidthEstimator * estimator,
+    guint age)
+{
+  return estimator->samples[(estimator->index + SAMPLE_WINDOW - 1 - age) %
+      SAMPLE_WINDOW];
+}
+
+static void
+window_add_sample (GstBandwidthEstimator * estimator, guint64 bitrate,
+    gdouble weight)
+{
+  estimator->samples[estimator->index] = bitrate;
+  estimator->index = (estimator->index + 1) % SAMPLE_WINDOW;
+  if (estimator->n_samples < SAMPLE_WINDOW)
+    estimator->n_samples++;
+}
+
+static guint64
+moving_average_get_throughput (GstBandwidthEstimator * estimator)
+{
+  guint i, n = MIN (estimator->n_samples, MOVING_AVERAGE_WINDOW);
+  guint64 sum = 0;
+
+  if (n == 0)
+    return 0;
+
+  for (i = 0; i < n; i++)
+    sum += gst_bandwidth_estimator_get_sample (estimator, i);
+
+  /* Conservative approach, make sure we don't upgrade too fast */
+  return MIN (sum / n, gst_bandwidth_estimator_get_sample (estimator, 0));
+}
+
+static void
+ewma_update (GstEwma * ewma, gdouble half_life, gdouble value, gdouble weight)
+{
+  gdouble alpha = pow (0.5, weight / half_life);
+
+  ewma->estimate = value * (1.0 - alpha) + ewma->estimate * alpha;
+  ewma->total_weight += weight;
+}
+
+static gdouble
+ewma_get (GstEwma * ewma, gdouble half_life)
+{
+  /* correct the bias towards the initial 0 estimate */
+  gdouble zero_factor = 1.0 - pow (0.5, ewma->total_weight / half_life);
+
+  return zero_factor > 0.0 ? ewma->estimate / zero_factor : 0.0;
+}
+
+static void
+ewma_add_sample (GstBandwidthEstimator * estimator, guint64 bitrate,
+    gdouble weight)
+{
+  ewma_update (&estimator->fast, EWMA_FAST_HALF_LIFE, bitrate, weight);
+  ewma_update (&estimator->slow, EWMA_SLOW_HALF_LIFE, bitrate, weight);
+}
+
+static guint64
+ewma_get_throughput (GstBandwidthEstimator * estimator)
+{
+  /* drop quickly, recover slowly */
+  return MIN (ewma_get (&estimator->fast, EWMA_FAST_HALF_LIFE),
+      ewma_get (&estimator->slow, EWMA_SLOW_HALF_LIFE));
+}
+
+static guint64
+harmonic_mean_get_throughput (GstBandwidthEstimator * estimator)
+{
+  guint i, n = MIN (estimator->n_samples, HARMONIC_MEAN_WINDOW);
+  gdouble sum = 0.0;
+
+  for (i = 0; i < n; i++) {
+    guint64 sample = gst_bandwidth_estimator_get_sample (estimator, i);
+
+    /* a single stalled download brings the mean to 0 */
+    if (sample == 0)
+      return 0;
+    sum += 1.0 / sample;
+  }
+
+  return sum > 0.0 ? n / sum : 0;
+}
+
+static gint
+compare_samples (gconstpointer a, gconstpointer b)
+{
+  guint64 sa = *(const guint64 *) a, sb = *(const guint64 *) b;
+
+  return sa < sb ? -1 : (sa > sb ? 1 : 0);
+}
+
+static guint64
+percentile_get_throughput (GstBandwidthEstimator * estimator)
+{
+  guint64 sorted[SAMPLE_WINDOW];
+  guint n = estimator->n_samples;
+
+  if (n == 0)
+    return 0;
+
+  memcpy (sorted, estimator->samples, sizeof (sorted));
+  /* the window is only partially filled from 0 up to n */
+  qsort (sorted, n, sizeof (guint64), compare_samples);
+
+  return sorted[(n - 1) * PERCENTILE / 100];
+}
+
+static const GstBandwidthEstimatorImpl impls[] = {
+  [GST_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE] = {"moving-average", TRUE,
+      window_add_sample, moving_average_get_throughput},
+  [GST_BANDWIDTH_ESTIMATOR_EWMA] = {"ewma", FALSE, ewma_add_sample,
+      ewma_get_throughput},
+  [GST_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN] = {"harmonic-mean", FALSE,
+      window_add_sample, harmonic_mean_get_throughput},
+  [GST_BANDWIDTH_ESTIMATOR_PERCENTILE] = {"percentile", FALSE,
+      window_add_sample, percentile_get_throughput},
+};
+
+GType
+gst_bandwidth_estimator_type_get_type (void)
+{
+  static volatile gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE,
+        "Average of the last fragment download rates", "moving-average"},
+    {GST_BANDWIDTH_ESTIMATOR_EWMA,
+        "Exponentially weighted moving average of the throughput", "ewma"},
+    {GST_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN,
+        "Harmonic mean of the last throughput samples", "harmonic-mean"},
+    {GST_BANDWIDTH_ESTIMATOR_PERCENTILE,
+        "Lower quartile of the last throughput samples", "percentile"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = g_enum_register_static ("GstBandwidthEstimatorType", values);
+    g_once_init_leave (&type, _type);
+  }
+
+  return type;
+}
+
+GstBandwidthEstimator *
+gst_bandwidth_estimator_new (GstBandwidthEstimatorType type)
+{
+  GstBandwidthEstimator *estimator;
+
+  g_return_val_if_fail (type < G_N_ELEMENTS (impls), NULL);
+
+  estimator = g_slice_new0 (GstBandwidthEstimator);
+  estimator->impl = &impls[type];
+  estimator->latency = GST_CLOCK_TIME_NONE;
+
+  return estimator;
+}
+
+void
+gst_bandwidth_estimator_free (GstBandwidthEstimator * estimator)
+{
+  g_slice_free (GstBandwidthEstimator, estimator);
+}
+
+/* @size in bytes. @latency is the time from the request to the first byte,
+ * @download_time the time from the request to the last byte */
+void
+gst_bandwidth_estimator_add_sample (GstBandwidthEstimator * estimator,
+    guint64 size, GstClockTime latency, GstClockTime download_time)
+{
+  GstClockTime transfer_time = download_time;
+
+  if (!GST_CLOCK_TIME_IS_VALID (download_time) || download_time == 0)
+    return;
+
+  if (GST_CLOCK_TIME_IS_VALID (latency) && latency < download_time) {
+    if (!GST_CLOCK_TIME_IS_VALID (estimator->latency))
+      estimator->latency = latency;
+    else
+      estimator->latency = LATENCY_ALPHA * latency +
+          (1.0 - LATENCY_ALPHA) * estimator->latency;
+
+    if (!estimator->impl->include_latency)
+      transfer_time -= latency;
+  }
+
+  estimator->impl->add_sample (estimator,
+      gst_util_uint64_scale (size, 8 * GST_SECOND, transfer_time),
+      (gdouble) transfer_time / GST_SECOND);
+}
+
+/* bits per second, 0 if unknown */
+guint64
+gst_bandwidth_estimator_get_throughput (GstBandwidthEstimator * estimator)
+{
+  return estimator->impl->get_throughput (estimator);
+}
+
+GstClockTime
+gst_bandwidth_estimator_get_latency (GstBandwidthEstimator * estimator)
+{
+  return estimator->latency;
+}
+
+/* The highest bitrate that can be downloaded in real time with fragments of
+ * @fragment_duration, accounting for the latency of each request */
+guint64
+gst_bandwidth_estimator_get_bitrate (GstBandwidthEstimator * estimator,
+    GstClockTime fragment_duration)
+{
+  guint64 throughput = gst_bandwidth_estimator_get_throughput (estimator);
+
+  if (estimator->impl->include_latency
+      || !GST_CLOCK_TIME_IS_VALID (fragment_duration) || fragment_duration == 0
+      || !GST_CLOCK_TIME_IS_VALID (estimator->latency))
+    return throughput;
+
+  if (estimator->latency >= fragment_duration)
+    return 0;
+
+  return gst_util_uint64_scale (throughput,
+      fragment_duration - estimator->latency, fragment_duration);
+}
+
+const gchar *
+gst_bandwidth_estimator_get_name (GstBandwidthEstimator * estimator)
+{
+  return estimator->impl->name;
+}
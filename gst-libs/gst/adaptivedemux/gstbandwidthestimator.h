@@ -0,0 +1,80 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_BANDWIDTH_ESTIMATOR_H_
+#define _GST_BANDWIDTH_ESTIMATOR_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstBandwidthEstimatorType:
+ * @GST_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE: average of the last few fragment
+ *   download rates, latency included
+ * @GST_BANDWIDTH_ESTIMATOR_EWMA: minimum of a fast and a slow exponentially
+ *   weighted moving average of the throughput
+ * @GST_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN: harmonic mean of the last few
+ *   throughput samples
+ * @GST_BANDWIDTH_ESTIMATOR_PERCENTILE: lower quartile of a sliding window of
+ *   throughput samples
+ *
+ * The algorithms available to estimate the download bandwidth. All but
+ * the moving average measure the throughput after the first byte and track
+ * the time to first byte separately.
+ */
+typedef enum
+{
+  GST_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE,
+  GST_BANDWIDTH_ESTIMATOR_EWMA,
+  GST_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN,
+  GST_BANDWIDTH_ESTIMATOR_PERCENTILE
+} GstBandwidthEstimatorType;
+
+#define GST_TYPE_BANDWIDTH_ESTIMATOR_TYPE (gst_bandwidth_estimator_type_get_type ())
+GST_EXPORT
+GType gst_bandwidth_estimator_type_get_type (void);
+
+typedef struct _GstBandwidthEstimator GstBandwidthEstimator;
+
+GST_EXPORT
+GstBandwidthEstimator * gst_bandwidth_estimator_new (GstBandwidthEstimatorType type);
+
+GST_EXPORT
+void gst_bandwidth_estimator_free (GstBandwidthEstimator * estimator);
+
+GST_EXPORT
+void gst_bandwidth_estimator_add_sample (GstBandwidthEstimator * estimator,
+    guint64 size, GstClockTime latency, GstClockTime download_time);
+
+GST_EXPORT
+guint64 gst_bandwidth_estimator_get_throughput (GstBandwidthEstimator * estimator);
+
+GST_EXPORT
+GstClockTime gst_bandwidth_estimator_get_latency (GstBandwidthEstimator * estimator);
+
+GST_EXPORT
+guint64 gst_bandwidth_estimator_get_bitrate (GstBandwidthEstimator * estimator,
+    GstClockTime fragment_duration);
+
+GST_EXPORT
+const gchar * gst_bandwidth_estimator_get_name (GstBandwidthEstimator * estimator);
+
+G_END_DECLS
+
+#endif
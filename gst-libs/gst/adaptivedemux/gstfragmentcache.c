@@ -0,0 +1,346 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Process-wide cache of downloaded fragments, shared by all
+ * GstAdaptiveDemux instances, keyed by URI and byte range.
+ *
+ * Entries start in the memory tier. When that is full, the least recently
+ * used ones are written to an unlinked temporary file and memory-mapped,
+ * so the kernel can page them out instead of us holding on to the memory.
+ * That disk tier is bounded on its own, its least recently used entries
+ * are dropped. Both tiers are least recently used lists under one lock.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib/gstdio.h>
+
+#include "gstfragmentcache.h"
+
+GST_DEBUG_CATEGORY_STATIC (fragment_cache_debug);
+#define GST_CAT_DEFAULT fragment_cache_debug
+
+typedef struct
+{
+  GList link;                   /* in memory_lru or disk_lru */
+  gchar *key;
+  gsize size;
+
+  /* exactly one of them is set, depending on the tier */
+  GstBuffer *buffer;
+  GMappedFile *mapped;
+} GstFragmentCacheEntry;
+
+static GMutex cache_lock;
+static GHashTable *cache_entries;
+/* most recently used first */
+static GQueue memory_lru = G_QUEUE_INIT;
+static GQueue disk_lru = G_QUEUE_INIT;
+static guint64 memory_size;
+static guint64 disk_size;
+static guint64 max_memory_size = GST_FRAGMENT_CACHE_DEFAULT_MAX_MEMORY;
+static guint64 max_disk_size = GST_FRAGMENT_CACHE_DEFAULT_MAX_DISK;
+static guint64 cache_hits;
+static guint64 cache_misses;
+
+static void
+gst_fragment_cache_entry_free (GstFragmentCacheEntry * entry)
+{
+  g_free (entry->key);
+  if (entry->buffer)
+    gst_buffer_unref (entry->buffer);
+  if (entry->mapped)
+    g_mapped_file_unref (entry->mapped);
+  g_slice_free (GstFragmentCacheEntry, entry);
+}
+
+/* call with cache_lock held */
+static void
+gst_fragment_cache_init (void)
+{
+  if (cache_entries)
+    return;
+
+  GST_DEBUG_CATEGORY_INIT (fragment_cache_debug, "fragmentcache", 0,
+      "Adaptive demuxer fragment cache");
+  cache_entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify) gst_fragment_cache_entry_free);
+}
+
+static gchar *
+gst_fragment_cache_make_key (const gchar * uri, gint64 range_start,
+    gint64 range_end)
+{
+  return g_strdup_printf ("%" G_GINT64_FORMAT "-%" G_GINT64_FORMAT " %s",
+      range_start, range_end, uri);
+}
+
+/* Moves the data of @entry to the disk tier.
+ * call with cache_lock held */
+static gboolean
+gst_fragment_cache_entry_spill (GstFragmentCacheEntry * entry)
+{
+  GError *err = NULL;
+  GMappedFile *mapped = NULL;
+  GstMapInfo info;
+  gchar *path = NULL;
+  gint fd;
+
+  fd = g_file_open_tmp ("gst-fragment-XXXXXX", &path, &err);
+  if (fd == -1)
+    goto error;
+  g_close (fd, NULL);
+
+  if (!gst_buffer_map (entry->buffer, &info, GST_MAP_READ))
+    goto error;
+  if (!g_file_set_contents (path, (const gchar *) info.data, info.size, &err)) {
+    gst_buffer_unmap (entry->buffer, &info);
+    goto error;
+  }
+  gst_buffer_unmap (entry->buffer, &info);
+
+  mapped = g_mapped_file_new (path, FALSE, &err);
+  if (mapped == NULL)
+    goto error;
+
+  /* the mapping keeps the data around, and nothing is left behind on disk
+   * once the entry goes away or the process exits */
+  g_unlink (path);
+  g_free (path);
+
+  gst_buffer_unref (entry->buffer);
+  entry->buffer = NULL;
+  entry->mapped = mapped;
+
+  return TRUE;
+
+error:
+  GST_WARNING ("Could not move %s to disk: %s", entry->key,
+      err ? err->message : "mapping failed");
+  g_clear_error (&err);
+  if (path) {
+    g_unlink (path);
+    g_free (path);
+  }
+  return FALSE;
+}
+
+/* call with cache_lock held */
+static void
+gst_fragment_cache_trim (void)
+{
+  GstFragmentCacheEntry *entry;
+  GList *link;
+
+  while (memory_size > max_memory_size
+      && (link = g_queue_pop_tail_link (&memory_lru))) {
+    entry = link->data;
+    memory_size -= entry->size;
+
+    if (entry->size <= max_disk_size && gst_fragment_cache_entry_spill (entry)) {
+      GST_LOG ("Moved %s to disk", entry->key);
+      g_queue_push_head_link (&disk_lru, &entry->link);
+      disk_size += entry->size;
+    } else {
+      g_hash_table_remove (cache_entries, entry->key);
+    }
+  }
+
+  while (disk_size > max_disk_size
+      && (link = g_queue_pop_tail_link (&disk_lru))) {
+    entry = link->data;
+    GST_LOG ("Dropping %s", entry->key);
+    disk_size -= entry->size;
+    g_hash_table_remove (cache_entries, entry->key);
+  }
+}
+
+/**
+ * gst_fragment_cache_lookup:
+ * @uri: the URI of the fragment
+ * @range_start: the first byte of the requested range
+ * @range_end: the last byte of the requested range, or -1
+ *
+ * Looks up the data of a fragment downloaded before by any adaptive demuxer
+ * of the process.
+ *
+ * Returns: (transfer full) (nullable): a read-only buffer with the data, or
+ * %NULL if it is not in the cache
+ */
+GstBuffer *
+gst_fragment_cache_lookup (const gchar * uri, gint64 range_start,
+    gint64 range_end)
+{
+  GstFragmentCacheEntry *entry = NULL;
+  GstBuffer *buffer = NULL;
+  gchar *key;
+
+  g_return_val_if_fail (uri != NULL, NULL);
+
+  key = gst_fragment_cache_make_key (uri, range_start, range_end);
+
+  g_mutex_lock (&cache_lock);
+  gst_fragment_cache_init ();
+  entry = g_hash_table_lookup (cache_entries, key);
+  if (entry == NULL) {
+    cache_misses++;
+    g_mutex_unlock (&cache_lock);
+    g_free (key);
+    return NULL;
+  }
+
+  cache_hits++;
+  if (entry->buffer) {
+    g_queue_unlink (&memory_lru, &entry->link);
+    g_queue_push_head_link (&memory_lru, &entry->link);
+    buffer = gst_buffer_ref (entry->buffer);
+  } else {
+    g_queue_unlink (&disk_lru, &entry->link);
+    g_queue_push_head_link (&disk_lru, &entry->link);
+    buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        g_mapped_file_get_contents (entry->mapped), entry->size, 0,
+        entry->size, g_mapped_file_ref (entry->mapped),
+        (GDestroyNotify) g_mapped_file_unref);
+  }
+  g_mutex_unlock (&cache_lock);
+
+  GST_LOG ("Hit for %s", key);
+  g_free (key);
+
+  return buffer;
+}
+
+/**
+ * gst_fragment_cache_insert:
+ * @uri: the URI of the fragment
+ * @range_start: the first byte of the downloaded range
+ * @range_end: the last byte of the downloaded range, or -1
+ * @buffer: the complete data of the fragment
+ *
+ * Adds a completely downloaded fragment to the cache. @buffer is only
+ * referenced, it must not be modified afterwards.
+ */
+void
+gst_fragment_cache_insert (const gchar * uri, gint64 range_start,
+    gint64 range_end, GstBuffer * buffer)
+{
+  GstFragmentCacheEntry *entry;
+  gsize size;
+
+  g_return_if_fail (uri != NULL);
+  g_return_if_fail (GST_IS_BUFFER (buffer));
+
+  size = gst_buffer_get_size (buffer);
+  if (size == 0)
+    return;
+
+  g_mutex_lock (&cache_lock);
+  gst_fragment_cache_init ();
+
+  if (size > MAX (max_memory_size, max_disk_size)) {
+    g_mutex_unlock (&cache_lock);
+    return;
+  }
+
+  entry = g_slice_new0 (GstFragmentCacheEntry);
+  entry->link.data = entry;
+  entry->key = gst_fragment_cache_make_key (uri, range_start, range_end);
+
+  if (g_hash_table_contains (cache_entries, entry->key)) {
+    g_mutex_unlock (&cache_lock);
+    gst_fragment_cache_entry_free (entry);
+    return;
+  }
+
+  GST_LOG ("Adding %s, %" G_GSIZE_FORMAT " bytes", entry->key, size);
+  entry->size = size;
+  entry->buffer = gst_buffer_ref (buffer);
+  g_hash_table_insert (cache_entries, entry->key, entry);
+  g_queue_push_head_link (&memory_lru, &entry->link);
+  memory_size += size;
+
+  gst_fragment_cache_trim ();
+  g_mutex_unlock (&cache_lock);
+}
+
+/**
+ * gst_fragment_cache_set_limits:
+ * @max_memory: maximum number of bytes kept in memory
+ * @max_disk: maximum number of bytes kept in memory-mapped temporary files
+ *
+ * Sets the size of both cache tiers for the whole process. Entries over the
+ * new limits are moved to disk or dropped right away.
+ */
+void
+gst_fragment_cache_set_limits (guint64 max_memory, guint64 max_disk)
+{
+  g_mutex_lock (&cache_lock);
+  gst_fragment_cache_init ();
+  max_memory_size = max_memory;
+  max_disk_size = max_disk;
+  gst_fragment_cache_trim ();
+  g_mutex_unlock (&cache_lock);
+}
+
+/**
+ * gst_fragment_cache_get_limits:
+ * @max_memory: (out) (optional): maximum number of bytes kept in memory
+ * @max_disk: (out) (optional): maximum number of bytes kept on disk
+ *
+ * Gets the size of both cache tiers.
+ */
+void
+gst_fragment_cache_get_limits (guint64 * max_memory, guint64 * max_disk)
+{
+  g_mutex_lock (&cache_lock);
+  if (max_memory)
+    *max_memory = max_memory_size;
+  if (max_disk)
+    *max_disk = max_disk_size;
+  g_mutex_unlock (&cache_lock);
+}
+
+/**
+ * gst_fragment_cache_get_stats:
+ *
+ * Returns the process-wide cache statistics: the number of "hits" and
+ * "misses" of lookups, the number of "entries" and the bytes in the
+ * "memory-bytes" and "disk-bytes" tiers.
+ *
+ * Returns: (transfer full): a new #GstStructure
+ */
+GstStructure *
+gst_fragment_cache_get_stats (void)
+{
+  GstStructure *stats;
+
+  g_mutex_lock (&cache_lock);
+  stats = gst_structure_new ("fragment-cache-stats",
+      "hits", G_TYPE_UINT64, cache_hits,
+      "misses", G_TYPE_UINT64, cache_misses,
+      "entries", G_TYPE_UINT,
+      cache_entries ? g_hash_table_size (cache_entries) : 0,
+      "memory-bytes", G_TYPE_UINT64, memory_size,
+      "disk-bytes", G_TYPE_UINT64, disk_size, NULL);
+  g_mutex_unlock (&cache_lock);
+
+  return stats;
+}
@@ -144,8 +144,10 @@ GST_DEBUG_CATEGORY_STATIC (aggregator_debug);
 #define PAD_WAIT_EVENT(pad)   G_STMT_START {                            \
   GST_LOG_OBJECT (pad, "Waiting for buffer to be consumed thread %p",   \
         g_thread_self());                                               \
+  ((GstAggregatorPad*)pad)->priv->n_event_waiters++;                    \
   g_cond_wait(&(((GstAggregatorPad* )pad)->priv->event_cond),           \
       (&((GstAggregatorPad*)pad)->priv->lock));                         \
+  ((GstAggregatorPad*)pad)->priv->n_event_waiters--;                    \
   GST_LOG_OBJECT (pad, "DONE Waiting for buffer to be consumed on thread %p", \
         g_thread_self());                                               \
   } G_STMT_END
@@ -231,8 +233,19 @@ struct _GstAggregatorPadPrivate
 
   gboolean eos;
 
+  /* how long to wait for data in live mode, GST_CLOCK_TIME_NONE to use the
+   * latency of the aggregator */
+  GstClockTime latency;
+  /* stats */
+  guint64 missed_deadlines;
+  GstClockTime last_missed_deadline;
+  guint64 late_buffers;
+  guint64 queued_bytes;         /* size of the buffers in data */
+
   GMutex lock;
   GCond event_cond;
+  /* number of threads blocked in PAD_WAIT_EVENT */
+  guint n_event_waiters;
   /* This lock prevents a flush start processing happening while
    * the chain function is also happening.
    */
@@ -279,6 +292,11 @@ static GstElementClass *aggregator_parent_class = NULL;
 
 /* All members are protected by the object lock unless otherwise noted */
 
+/* aggregate() durations are counted in buckets of less than 0.5ms, 1ms,
+ * 2ms ... 32ms and one for everything longer */
+#define AGGREGATE_HISTOGRAM_BUCKETS 8
+#define AGGREGATE_HISTOGRAM_FIRST_BOUND (GST_MSECOND / 2)
+
 struct _GstAggregatorPrivate
 {
   gint max_padserial;
@@ -325,6 +343,18 @@ struct _GstAggregatorPrivate
 
   /* properties */
   gint64 latency;               /* protected by both src_lock and all pad locks */
+
+  /* stats, protected by the object lock */
+  guint64 aggregate_count;
+  GstClockTime aggregate_time;
+  GstClockTime aggregate_time_max;
+  guint64 aggregate_histogram[AGGREGATE_HISTOGRAM_BUCKETS];
+  GstClockTime wait_time;
+  GstClockTime push_time;
+  GstClockTime push_time_max;
+  /* time spent pushing during the current aggregate() call, only accessed
+   * from the src task */
+  GstClockTime aggregate_push_time;
 };
 
 /* Seek event forwarding helper */
@@ -350,6 +380,7 @@ enum
   PROP_LATENCY,
   PROP_START_TIME_SELECTION,
   PROP_START_TIME,
+  PROP_STATS,
   PROP_LAST
 };
 
@@ -537,9 +568,23 @@ gst_aggregator_finish_buffer (GstAggregator * self, GstBuffer * buffer)
 
   GST_OBJECT_LOCK (self);
   if (!self->priv->flush_seeking && gst_pad_is_active (self->srcpad)) {
+    GstClockTime start, elapsed;
+    GstFlowReturn ret;
+
     GST_TRACE_OBJECT (self, "pushing buffer %" GST_PTR_FORMAT, buffer);
     GST_OBJECT_UNLOCK (self);
-    return gst_pad_push (self->srcpad, buffer);
+
+    start = gst_util_get_timestamp ();
+    ret = gst_pad_push (self->srcpad, buffer);
+    elapsed = gst_util_get_timestamp () - start;
+
+    GST_OBJECT_LOCK (self);
+    self->priv->push_time += elapsed;
+    self->priv->push_time_max = MAX (self->priv->push_time_max, elapsed);
+    self->priv->aggregate_push_time += elapsed;
+    GST_OBJECT_UNLOCK (self);
+
+    return ret;
   } else {
     GST_INFO_OBJECT (self, "Not pushing (active: %i, flushing: %i)",
         self->priv->flush_seeking, gst_pad_is_active (self->srcpad));
@@ -576,10 +621,72 @@ gst_aggregator_get_next_time (GstAggregator * self)
   return GST_CLOCK_TIME_NONE;
 }
 
+/* WITH OBJECT_LOCK
+ * The time to wait after the start of the next output buffer: the longest
+ * latency budget of the pads that do not have data yet, capped by the
+ * @latency of the aggregator. Pads with a shorter budget than the aggregator
+ * time out earlier and don't hold back the output for the others. */
+static GstClockTime
+gst_aggregator_get_wait_latency_unlocked (GstAggregator * self,
+    GstClockTime latency)
+{
+  GstClockTime wait_latency = 0;
+  gboolean waiting = FALSE;
+  GList *l;
+
+  for (l = GST_ELEMENT_CAST (self)->sinkpads; l; l = l->next) {
+    GstAggregatorPad *pad = l->data;
+
+    PAD_LOCK (pad);
+    if (pad->priv->num_buffers == 0 && !pad->priv->eos) {
+      GstClockTime budget = pad->priv->latency;
+
+      if (!GST_CLOCK_TIME_IS_VALID (budget) || budget > latency)
+        budget = latency;
+      wait_latency = MAX (wait_latency, budget);
+      waiting = TRUE;
+    }
+    PAD_UNLOCK (pad);
+  }
+
+  return waiting ? wait_latency : latency;
+}
+
+/* Counts a missed deadline on each pad that still has no data after waiting
+ * for the output buffer at @start */
+static void
+gst_aggregator_record_missed_deadlines (GstAggregator * self,
+    GstClockTime start, GstClockTime latency)
+{
+  GList *l;
+
+  GST_OBJECT_LOCK (self);
+  for (l = GST_ELEMENT_CAST (self)->sinkpads; l; l = l->next) {
+    GstAggregatorPad *pad = l->data;
+
+    PAD_LOCK (pad);
+    if (pad->priv->num_buffers == 0 && !pad->priv->eos) {
+      GstClockTime budget = pad->priv->latency;
+
+      if (!GST_CLOCK_TIME_IS_VALID (budget) || budget > latency)
+        budget = latency;
+
+      pad->priv->missed_deadlines++;
+      pad->priv->last_missed_deadline = start + budget;
+      GST_INFO_OBJECT (pad, "missed deadline %" GST_TIME_FORMAT
+          " for the output at %" GST_TIME_FORMAT " (%" G_GUINT64_FORMAT
+          " missed)", GST_TIME_ARGS (start + budget), GST_TIME_ARGS (start),
+          pad->priv->missed_deadlines);
+    }
+    PAD_UNLOCK (pad);
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
 static gboolean
 gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
 {
-  GstClockTime latency;
+  GstClockTime latency, wait_latency;
   GstClockTime start;
   gboolean res;
 
@@ -636,17 +743,18 @@ gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
 
     base_time = GST_ELEMENT_CAST (self)->base_time;
     clock = gst_object_ref (GST_ELEMENT_CLOCK (self));
+    wait_latency = gst_aggregator_get_wait_latency_unlocked (self, latency);
     GST_OBJECT_UNLOCK (self);
 
     time = base_time + start;
-    time += latency;
+    time += wait_latency;
 
     GST_DEBUG_OBJECT (self, "possibly waiting for clock to reach %"
         GST_TIME_FORMAT " (base %" GST_TIME_FORMAT " start %" GST_TIME_FORMAT
         " latency %" GST_TIME_FORMAT " current %" GST_TIME_FORMAT ")",
         GST_TIME_ARGS (time),
         GST_TIME_ARGS (base_time),
-        GST_TIME_ARGS (start), GST_TIME_ARGS (latency),
+        GST_TIME_ARGS (start), GST_TIME_ARGS (wait_latency),
         GST_TIME_ARGS (gst_clock_get_time (clock)));
 
     self->priv->aggregate_id = gst_clock_new_single_shot_id (clock, time);
@@ -669,6 +777,7 @@ gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
     /* we timed out */
     if (status == GST_CLOCK_OK || status == GST_CLOCK_EARLY) {
       SRC_UNLOCK (self);
+      gst_aggregator_record_missed_deadlines (self, start, latency);
       *timeout = TRUE;
       return TRUE;
     }
@@ -776,6 +885,7 @@ gst_aggregator_pad_set_flushing (GstAggregatorPad * aggpad,
     item = next;
   }
   aggpad->priv->num_buffers = 0;
+  aggpad->priv->queued_bytes = 0;
   gst_buffer_replace (&aggpad->priv->clipped_buffer, NULL);
 
   PAD_BROADCAST_EVENT (aggpad);
@@ -1008,12 +1118,93 @@ done:
   return ret;
 }
 
+/* Accounts for one aggregate() call that took @elapsed, excluding the time
+ * it spent pushing downstream */
+static void
+gst_aggregator_update_aggregate_stats (GstAggregator * self,
+    GstClockTime elapsed)
+{
+  GstAggregatorPrivate *priv = self->priv;
+  GstClockTime bound = AGGREGATE_HISTOGRAM_FIRST_BOUND;
+  guint bucket = 0;
+
+  GST_OBJECT_LOCK (self);
+  if (priv->aggregate_push_time < elapsed)
+    elapsed -= priv->aggregate_push_time;
+  else
+    elapsed = 0;
+
+  while (bucket < AGGREGATE_HISTOGRAM_BUCKETS - 1 && elapsed >= bound) {
+    bucket++;
+    bound *= 2;
+  }
+
+  priv->aggregate_count++;
+  priv->aggregate_time += elapsed;
+  priv->aggregate_time_max = MAX (priv->aggregate_time_max, elapsed);
+  priv->aggregate_histogram[bucket]++;
+  GST_OBJECT_UNLOCK (self);
+
+  GST_TRACE_OBJECT (self, "aggregate took %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (elapsed));
+}
+
+static void
+gst_aggregator_reset_stats (GstAggregator * self)
+{
+  GstAggregatorPrivate *priv = self->priv;
+
+  GST_OBJECT_LOCK (self);
+  priv->aggregate_count = 0;
+  priv->aggregate_time = 0;
+  priv->aggregate_time_max = 0;
+  memset (priv->aggregate_histogram, 0, sizeof (priv->aggregate_histogram));
+  priv->wait_time = 0;
+  priv->push_time = 0;
+  priv->push_time_max = 0;
+  GST_OBJECT_UNLOCK (self);
+}
+
+static GstStructure *
+gst_aggregator_create_stats (GstAggregator * self)
+{
+  GstAggregatorPrivate *priv = self->priv;
+  GValue histogram = G_VALUE_INIT;
+  GValue v = G_VALUE_INIT;
+  GstStructure *s;
+  guint i;
+
+  g_value_init (&histogram, GST_TYPE_ARRAY);
+  g_value_init (&v, G_TYPE_UINT64);
+
+  GST_OBJECT_LOCK (self);
+  s = gst_structure_new ("application/x-aggregator-stats",
+      "aggregate-count", G_TYPE_UINT64, priv->aggregate_count,
+      "aggregate-time", G_TYPE_UINT64, priv->aggregate_time,
+      "aggregate-time-max", G_TYPE_UINT64, priv->aggregate_time_max,
+      "wait-time", G_TYPE_UINT64, priv->wait_time,
+      "push-time", G_TYPE_UINT64, priv->push_time,
+      "push-time-max", G_TYPE_UINT64, priv->push_time_max, NULL);
+  for (i = 0; i < AGGREGATE_HISTOGRAM_BUCKETS; i++) {
+    g_value_set_uint64 (&v, priv->aggregate_histogram[i]);
+    gst_value_array_append_value (&histogram, &v);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  gst_structure_take_value (s, "aggregate-histogram", &histogram);
+  g_value_unset (&v);
+
+  return s;
+}
+
 static void
 gst_aggregator_aggregate_func (GstAggregator * self)
 {
   GstAggregatorPrivate *priv = self->priv;
   GstAggregatorClass *klass = GST_AGGREGATOR_GET_CLASS (self);
   gboolean timeout = FALSE;
+  GstClockTime start, elapsed;
+  gboolean ready;
 
   if (self->priv->running == FALSE) {
     GST_DEBUG_OBJECT (self, "Not running anymore");
@@ -1030,7 +1221,15 @@ gst_aggregator_aggregate_func (GstAggregator * self)
 
     /* Ensure we have buffers ready (either in clipped_buffer or at the head of
      * the queue */
-    if (!gst_aggregator_wait_and_check (self, &timeout))
+    start = gst_util_get_timestamp ();
+    ready = gst_aggregator_wait_and_check (self, &timeout);
+    elapsed = gst_util_get_timestamp () - start;
+
+    GST_OBJECT_LOCK (self);
+    priv->wait_time += elapsed;
+    GST_OBJECT_UNLOCK (self);
+
+    if (!ready)
       continue;
 
     gst_element_foreach_sink_pad (GST_ELEMENT_CAST (self),
@@ -1047,7 +1246,11 @@ gst_aggregator_aggregate_func (GstAggregator * self)
 
     if (timeout || flow_return >= GST_FLOW_OK) {
       GST_TRACE_OBJECT (self, "Actually aggregating!");
+      priv->aggregate_push_time = 0;
+      start = gst_util_get_timestamp ();
       flow_return = klass->aggregate (self, timeout);
+      elapsed = gst_util_get_timestamp () - start;
+      gst_aggregator_update_aggregate_stats (self, elapsed);
     }
 
     if (flow_return == GST_AGGREGATOR_FLOW_NEED_DATA)
@@ -1104,6 +1307,7 @@ gst_aggregator_start (GstAggregator * self)
   self->priv->srccaps = NULL;
 
   gst_aggregator_set_allocation (self, NULL, NULL, NULL, NULL);
+  gst_aggregator_reset_stats (self);
 
   klass = GST_AGGREGATOR_GET_CLASS (self);
 
@@ -2205,6 +2409,9 @@ gst_aggregator_get_property (GObject * object, guint prop_id,
     case PROP_START_TIME:
       g_value_set_uint64 (value, agg->priv->start_time);
       break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_aggregator_create_stats (agg));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2269,6 +2476,34 @@ gst_aggregator_class_init (GstAggregatorClass * klass)
           G_MAXUINT64,
           DEFAULT_START_TIME, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAggregator:stats:
+   *
+   * Timing statistics of the aggregator since it was started, with the
+   * fields:
+   *
+   * * "aggregate-count" (#guint64): the number of aggregate() calls
+   * * "aggregate-time" (#guint64): the total time spent in aggregate(),
+   *   without the time spent pushing downstream
+   * * "aggregate-time-max" (#guint64): the longest aggregate() call
+   * * "aggregate-histogram" (#GstValueArray of #guint64): the number of
+   *   aggregate() calls that took less than 0.5ms, 1ms, 2ms, 4ms, 8ms, 16ms
+   *   and 32ms, and the number of longer calls
+   * * "wait-time" (#guint64): the total time spent waiting for data or for
+   *   the deadline in live mode
+   * * "push-time" (#guint64): the total time spent pushing buffers
+   *   downstream from gst_aggregator_finish_buffer()
+   * * "push-time-max" (#guint64): the longest push
+   *
+   * All times are in nanoseconds. See #GstAggregatorPad:stats for the
+   * statistics of the sink pads.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "Aggregator statistics",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_REGISTER_FUNCPTR (gst_aggregator_do_events_and_queries);
 }
 
@@ -2438,9 +2673,18 @@ gst_aggregator_pad_chain_internal (GstAggregator * self,
       else
         g_queue_push_tail (&aggpad->priv->data, buffer);
       apply_buffer (aggpad, buffer, head);
-      aggpad->priv->num_buffers++;
+      aggpad->priv->queued_bytes += gst_buffer_get_size (buffer);
+      if (head && GST_CLOCK_TIME_IS_VALID (aggpad->priv->last_missed_deadline)
+          && GST_CLOCK_TIME_IS_VALID (aggpad->priv->head_time)
+          && aggpad->priv->head_time <= aggpad->priv->last_missed_deadline) {
+        aggpad->priv->late_buffers++;
+        GST_DEBUG_OBJECT (aggpad, "late buffer %" GST_PTR_FORMAT, buffer);
+      }
       buffer = NULL;
-      SRC_BROADCAST (self);
+      /* The src task only waits for pads without buffers, so there is
+       * nothing new for it to look at unless this pad was empty */
+      if (aggpad->priv->num_buffers++ == 0)
+        SRC_BROADCAST (self);
       break;
     }
 
@@ -2677,6 +2921,71 @@ gst_aggregator_pad_activate_mode_func (GstPad * pad,
  ************************************/
 G_DEFINE_TYPE (GstAggregatorPad, gst_aggregator_pad, GST_TYPE_PAD);
 
+#define DEFAULT_PAD_LATENCY GST_CLOCK_TIME_NONE
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_LATENCY,
+  PROP_PAD_STATS,
+};
+
+static GstStructure *
+gst_aggregator_pad_create_stats (GstAggregatorPad * pad)
+{
+  GstStructure *s;
+
+  PAD_LOCK (pad);
+  s = gst_structure_new ("application/x-aggregator-pad-stats",
+      "missed-deadlines", G_TYPE_UINT64, pad->priv->missed_deadlines,
+      "last-missed-deadline", G_TYPE_UINT64, pad->priv->last_missed_deadline,
+      "late-buffers", G_TYPE_UINT64, pad->priv->late_buffers,
+      "queued-buffers", G_TYPE_UINT, pad->priv->num_buffers,
+      "queued-bytes", G_TYPE_UINT64, pad->priv->queued_bytes,
+      "queued-time", G_TYPE_UINT64, pad->priv->time_level, NULL);
+  PAD_UNLOCK (pad);
+
+  return s;
+}
+
+static void
+gst_aggregator_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstAggregatorPad *pad = GST_AGGREGATOR_PAD (object);
+
+  switch (prop_id) {
+    case PROP_PAD_LATENCY:
+      PAD_LOCK (pad);
+      pad->priv->latency = g_value_get_uint64 (value);
+      PAD_UNLOCK (pad);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_aggregator_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstAggregatorPad *pad = GST_AGGREGATOR_PAD (object);
+
+  switch (prop_id) {
+    case PROP_PAD_LATENCY:
+      PAD_LOCK (pad);
+      g_value_set_uint64 (value, pad->priv->latency);
+      PAD_UNLOCK (pad);
+      break;
+    case PROP_PAD_STATS:
+      g_value_take_boxed (value, gst_aggregator_pad_create_stats (pad));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_aggregator_pad_constructed (GObject * object)
 {
@@ -2724,6 +3033,48 @@ gst_aggregator_pad_class_init (GstAggregatorPadClass * klass)
   gobject_class->constructed = gst_aggregator_pad_constructed;
   gobject_class->finalize = gst_aggregator_pad_finalize;
   gobject_class->dispose = gst_aggregator_pad_dispose;
+  gobject_class->set_property = gst_aggregator_pad_set_property;
+  gobject_class->get_property = gst_aggregator_pad_get_property;
+
+  /**
+   * GstAggregatorPad:latency:
+   *
+   * How long to wait for data on this pad in live mode after the start of
+   * the output buffer, %GST_CLOCK_TIME_NONE to wait for the full latency of
+   * the aggregator. A pad with a shorter budget times out on its own, and
+   * the other pads are aggregated without waiting for it. The budget can't
+   * be longer than the latency of the aggregator.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_LATENCY,
+      g_param_spec_uint64 ("latency", "Latency",
+          "How long to wait for data on this pad in live mode "
+          "(in nanoseconds, -1 = the latency of the aggregator)", 0,
+          G_MAXUINT64, DEFAULT_PAD_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAggregatorPad:stats:
+   *
+   * Statistics of the pad, with the fields:
+   *
+   * * "missed-deadlines" (#guint64): the number of times the aggregator
+   *   timed out without data on this pad
+   * * "last-missed-deadline" (#guint64): the running time of the last
+   *   deadline this pad missed, %GST_CLOCK_TIME_NONE if none
+   * * "late-buffers" (#guint64): the number of buffers that ended before
+   *   the last deadline this pad missed when they arrived
+   * * "queued-buffers" (#guint): the number of buffers currently queued
+   * * "queued-bytes" (#guint64): the size of the buffers currently queued
+   * * "queued-time" (#guint64): the duration of the data currently queued,
+   *   only known in live mode with a latency set
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "Pad statistics",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -2741,6 +3092,11 @@ gst_aggregator_pad_init (GstAggregatorPad * pad)
 
   gst_aggregator_pad_reset_unlocked (pad);
   pad->priv->negotiated = FALSE;
+  pad->priv->latency = DEFAULT_PAD_LATENCY;
+  pad->priv->missed_deadlines = 0;
+  pad->priv->last_missed_deadline = GST_CLOCK_TIME_NONE;
+  pad->priv->late_buffers = 0;
+  pad->priv->queued_bytes = 0;
 }
 
 /* Must be called with the PAD_LOCK held */
@@ -2749,7 +3105,8 @@ gst_aggregator_pad_buffer_consumed (GstAggregatorPad * pad)
 {
   pad->priv->num_buffers--;
   GST_TRACE_OBJECT (pad, "Consuming buffer");
-  PAD_BROADCAST_EVENT (pad);
+  if (pad->priv->n_event_waiters > 0)
+    PAD_BROADCAST_EVENT (pad);
 }
 
 /* Must be called with the PAD_LOCK held */
@@ -2763,6 +3120,7 @@ gst_aggregator_pad_clip_buffer_unlocked (GstAggregatorPad * pad)
   while (pad->priv->clipped_buffer == NULL &&
       GST_IS_BUFFER (g_queue_peek_tail (&pad->priv->data))) {
     buffer = g_queue_pop_tail (&pad->priv->data);
+    pad->priv->queued_bytes -= gst_buffer_get_size (buffer);
 
     apply_buffer (pad, buffer, FALSE);
 
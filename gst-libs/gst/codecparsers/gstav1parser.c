@@ -0,0 +1,1505 @@
+/* gstav1parser.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:gstav1parser
+ * @title: GstAV1Parser
+ * @short_description: Convenience library for parsing AV1 video bitstream.
+ *
+ * The parser splits the bitstream into OBUs and parses the sequence header,
+ * the temporal delimiters, the frame header up to and including the tile
+ * info, and the tile group info. It keeps track of the reference slots so
+ * that frame sizes derived from references are known. Tile data is not
+ * parsed.
+ *
+ * For more details about the structures, you can refer to the
+ * specification: AV1 Bitstream & Decoding Process Specification,
+ * https://aomediacodec.github.io/av1-spec/
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/base/gstbitreader.h>
+#include "gstav1parser.h"
+
+#define MAX_TILE_WIDTH 4096
+#define MAX_TILE_AREA (4096 * 2304)
+
+#define ALL_FRAMES 0xff
+
+/* indices into ref_frame_idx, i.e. references minus LAST_FRAME */
+#define LAST_FRAME 0
+#define LAST2_FRAME 1
+#define LAST3_FRAME 2
+#define GOLDEN_FRAME 3
+#define BWDREF_FRAME 4
+#define ALTREF2_FRAME 5
+#define ALTREF_FRAME 6
+
+#define SWITCHABLE_FILTER 4
+
+GST_DEBUG_CATEGORY_STATIC (gst_av1_parser_debug);
+#define GST_CAT_DEFAULT gst_av1_parser_debug
+
+static gboolean initialized = FALSE;
+#define INITIALIZE_DEBUG_CATEGORY \
+  if (!initialized) { \
+    GST_DEBUG_CATEGORY_INIT (gst_av1_parser_debug, "codecparsers_av1", 0, \
+        "av1 parser library"); \
+    initialized = TRUE; \
+  }
+
+#define READ_BITS(br, val, nbits) G_STMT_START { \
+  guint32 _tmp; \
+  if (!gst_bit_reader_get_bits_uint32 (br, &_tmp, nbits)) { \
+    GST_WARNING ("failed to read %d bits for %s", nbits, #val); \
+    goto error; \
+  } \
+  val = _tmp; \
+} G_STMT_END
+
+#define READ_BIT(br, val) READ_BITS(br, val, 1)
+
+#define SKIP_BITS(br, nbits) G_STMT_START { \
+  if (!gst_bit_reader_skip (br, nbits)) { \
+    GST_WARNING ("failed to skip %d bits", nbits); \
+    goto error; \
+  } \
+} G_STMT_END
+
+#define GST_AV1_PARSER_GET_PRIVATE(parser) \
+    ((GstAV1ParserPrivate *)(parser->priv))
+
+typedef struct
+{
+  gboolean valid;
+  guint32 frame_id;
+  GstAV1FrameType frame_type;
+  guint32 order_hint;
+  guint32 upscaled_width;
+  guint32 frame_width;
+  guint32 frame_height;
+  guint32 render_width;
+  guint32 render_height;
+} GstAV1ReferenceSlot;
+
+typedef struct
+{
+  /* a frame header was parsed and its tile groups are not complete yet */
+  gboolean seen_frame_header;
+  GstAV1FrameHeaderOBU frame_header;
+
+  guint32 mi_cols;
+  guint32 mi_rows;
+
+  GstAV1ReferenceSlot ref[GST_AV1_NUM_REF_FRAMES];
+} GstAV1ParserPrivate;
+
+static guint
+tile_log2 (guint blk_size, guint target)
+{
+  guint k;
+
+  for (k = 0; (blk_size << k) < target; k++);
+  return k;
+}
+
+static gint
+get_relative_dist (const GstAV1SequenceHeaderOBU * seq_header, guint32 a,
+    guint32 b)
+{
+  gint diff, m;
+
+  if (!seq_header->enable_order_hint)
+    return 0;
+
+  diff = a - b;
+  m = 1 << seq_header->order_hint_bits_minus_1;
+  return (diff & (m - 1)) - (diff & m);
+}
+
+static gboolean
+read_uvlc (GstBitReader * br, guint32 * value)
+{
+  guint leading_zeros = 0;
+  guint8 done;
+  guint32 v;
+
+  while (TRUE) {
+    READ_BIT (br, done);
+    if (done)
+      break;
+    leading_zeros++;
+  }
+
+  if (leading_zeros >= 32) {
+    *value = G_MAXUINT32;
+    return TRUE;
+  }
+
+  READ_BITS (br, v, leading_zeros);
+  *value = v + (1U << leading_zeros) - 1;
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static gboolean
+read_ns (GstBitReader * br, guint32 n, guint32 * value)
+{
+  guint w;
+  guint32 m, v;
+  guint8 extra_bit;
+
+  w = g_bit_storage (n);
+  m = (1U << w) - n;
+  READ_BITS (br, v, w - 1);
+  if (v < m) {
+    *value = v;
+    return TRUE;
+  }
+  READ_BIT (br, extra_bit);
+  *value = (v << 1) - m + extra_bit;
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+/**
+ * gst_av1_parser_read_leb128:
+ * @data: the data to read from
+ * @size: the size of @data
+ * @value: (out): the decoded value
+ * @consumed: (out): the number of bytes of the encoded value
+ *
+ * Reads an unsigned LEB128 value, as used for the obu_size field and the
+ * length fields of the Annex B bitstream format.
+ *
+ * Returns: %GST_AV1_PARSER_OK, %GST_AV1_PARSER_NO_MORE_DATA if @data ends
+ * before the value does, or %GST_AV1_PARSER_BROKEN_DATA if the value does
+ * not fit in 32 bits
+ *
+ * Since: 1.14
+ */
+GstAV1ParserResult
+gst_av1_parser_read_leb128 (const guint8 * data, guint32 size,
+    guint64 * value, guint32 * consumed)
+{
+  guint64 v = 0;
+  guint i;
+
+  g_return_val_if_fail (data != NULL || size == 0, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (value != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (consumed != NULL, GST_AV1_PARSER_ERROR);
+
+  for (i = 0; i < 8; i++) {
+    if (i >= size)
+      return GST_AV1_PARSER_NO_MORE_DATA;
+
+    v |= ((guint64) (data[i] & 0x7f)) << (i * 7);
+    if (!(data[i] & 0x80))
+      break;
+  }
+
+  if (i == 8 || v > G_MAXUINT32)
+    return GST_AV1_PARSER_BROKEN_DATA;
+
+  *value = v;
+  *consumed = i + 1;
+  return GST_AV1_PARSER_OK;
+}
+
+/**
+ * gst_av1_parser_leb128_size:
+ * @value: the value to encode
+ *
+ * Returns: the number of bytes gst_av1_parser_write_leb128() needs for
+ * @value
+ *
+ * Since: 1.14
+ */
+guint32
+gst_av1_parser_leb128_size (guint64 value)
+{
+  guint32 n = 1;
+
+  while (value >= 0x80) {
+    value >>= 7;
+    n++;
+  }
+  return n;
+}
+
+/**
+ * gst_av1_parser_write_leb128:
+ * @value: the value to encode
+ * @data: where to write, at least gst_av1_parser_leb128_size() bytes
+ *
+ * Writes @value in the shortest unsigned LEB128 encoding.
+ *
+ * Returns: the number of bytes written
+ *
+ * Since: 1.14
+ */
+guint32
+gst_av1_parser_write_leb128 (guint64 value, guint8 * data)
+{
+  guint32 n = 0;
+
+  g_return_val_if_fail (data != NULL, 0);
+
+  do {
+    data[n] = value & 0x7f;
+    value >>= 7;
+    if (value)
+      data[n] |= 0x80;
+    n++;
+  } while (value);
+
+  return n;
+}
+
+/**
+ * gst_av1_parser_new:
+ *
+ * Creates a new #GstAV1Parser. It should be freed with
+ * gst_av1_parser_free() after use.
+ *
+ * Returns: a new #GstAV1Parser
+ *
+ * Since: 1.14
+ */
+GstAV1Parser *
+gst_av1_parser_new (void)
+{
+  GstAV1Parser *parser;
+
+  INITIALIZE_DEBUG_CATEGORY;
+  GST_DEBUG ("Create AV1 Parser");
+
+  parser = g_slice_new0 (GstAV1Parser);
+  parser->priv = g_slice_new0 (GstAV1ParserPrivate);
+
+  return parser;
+}
+
+/**
+ * gst_av1_parser_free:
+ * @parser: the #GstAV1Parser to free
+ *
+ * Frees @parser.
+ *
+ * Since: 1.14
+ */
+void
+gst_av1_parser_free (GstAV1Parser * parser)
+{
+  if (parser) {
+    if (parser->priv) {
+      g_slice_free (GstAV1ParserPrivate, parser->priv);
+      parser->priv = NULL;
+    }
+    g_slice_free (GstAV1Parser, parser);
+  }
+}
+
+/**
+ * gst_av1_parser_reset:
+ * @parser: the #GstAV1Parser
+ *
+ * Forgets the sequence header and the reference slots, for instance after
+ * a seek. The operating point is kept.
+ *
+ * Since: 1.14
+ */
+void
+gst_av1_parser_reset (GstAV1Parser * parser)
+{
+  g_return_if_fail (parser != NULL);
+
+  memset (&parser->seq_header, 0, sizeof (parser->seq_header));
+  parser->have_seq_header = FALSE;
+  memset (parser->priv, 0, sizeof (GstAV1ParserPrivate));
+}
+
+/**
+ * gst_av1_parser_identify_one_obu:
+ * @parser: the #GstAV1Parser
+ * @data: the data to parse
+ * @size: the size of @data
+ * @obu: (out): the #GstAV1OBU to fill
+ * @consumed: (out): the number of bytes the OBU takes in @data
+ *
+ * Parses the OBU header at the start of @data. OBUs without an obu_size
+ * field, as allowed by the Annex B format, are assumed to span the whole
+ * @size.
+ *
+ * When %GST_AV1_PARSER_DROP is returned, @obu and @consumed are set, so the
+ * caller can skip the OBU.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.14
+ */
+GstAV1ParserResult
+gst_av1_parser_identify_one_obu (GstAV1Parser * parser, const guint8 * data,
+    guint32 size, GstAV1OBU * obu, guint32 * consumed)
+{
+  GstAV1ParserResult res;
+  guint32 header_size, leb_size;
+  guint64 obu_size;
+  guint16 idc;
+
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (data != NULL || size == 0, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (consumed != NULL, GST_AV1_PARSER_ERROR);
+
+  memset (obu, 0, sizeof (*obu));
+  *consumed = 0;
+
+  if (size < 1)
+    return GST_AV1_PARSER_NO_MORE_DATA;
+
+  if (data[0] & 0x80) {
+    GST_WARNING ("forbidden bit set in OBU header");
+    return GST_AV1_PARSER_BROKEN_DATA;
+  }
+
+  obu->header.obu_type = (data[0] >> 3) & 0xf;
+  obu->header.obu_extension_flag = (data[0] >> 2) & 0x1;
+  obu->header.obu_has_size_field = (data[0] >> 1) & 0x1;
+  header_size = 1;
+
+  if (obu->header.obu_extension_flag) {
+    if (size < 2)
+      return GST_AV1_PARSER_NO_MORE_DATA;
+    obu->header.temporal_id = data[1] >> 5;
+    obu->header.spatial_id = (data[1] >> 3) & 0x3;
+    header_size++;
+  }
+
+  if (obu->header.obu_has_size_field) {
+    res = gst_av1_parser_read_leb128 (data + header_size, size - header_size,
+        &obu_size, &leb_size);
+    if (res != GST_AV1_PARSER_OK)
+      return res;
+    header_size += leb_size;
+
+    if (obu_size > size - header_size)
+      return GST_AV1_PARSER_NO_MORE_DATA;
+  } else {
+    obu_size = size - header_size;
+  }
+
+  obu->obu_type = obu->header.obu_type;
+  obu->data = data + header_size;
+  obu->obu_size = obu_size;
+  obu->header_size = header_size;
+  *consumed = header_size + obu_size;
+
+  GST_LOG ("OBU type %d, size %u", obu->obu_type, obu->obu_size);
+
+  if (obu->obu_type != GST_AV1_OBU_SEQUENCE_HEADER
+      && obu->obu_type != GST_AV1_OBU_TEMPORAL_DELIMITER
+      && obu->header.obu_extension_flag && parser->have_seq_header
+      && parser->operating_point <=
+      parser->seq_header.operating_points_cnt_minus_1) {
+    idc = parser->seq_header.operating_points[parser->operating_point].idc;
+    if (idc != 0 && (!((idc >> obu->header.temporal_id) & 1)
+            || !((idc >> (obu->header.spatial_id + 8)) & 1)))
+      return GST_AV1_PARSER_DROP;
+  }
+
+  return GST_AV1_PARSER_OK;
+}
+
+static gboolean
+parse_color_config (GstBitReader * br, GstAV1SequenceHeaderOBU * seq_header)
+{
+  GstAV1ColorConfig *cc = &seq_header->color_config;
+
+  READ_BIT (br, cc->high_bitdepth);
+  if (seq_header->seq_profile == GST_AV1_PROFILE_2 && cc->high_bitdepth) {
+    READ_BIT (br, cc->twelve_bit);
+    cc->bit_depth = cc->twelve_bit ? 12 : 10;
+  } else {
+    cc->bit_depth = cc->high_bitdepth ? 10 : 8;
+  }
+
+  if (seq_header->seq_profile == GST_AV1_PROFILE_1)
+    cc->mono_chrome = 0;
+  else
+    READ_BIT (br, cc->mono_chrome);
+
+  READ_BIT (br, cc->color_description_present_flag);
+  if (cc->color_description_present_flag) {
+    READ_BITS (br, cc->color_primaries, 8);
+    READ_BITS (br, cc->transfer_characteristics, 8);
+    READ_BITS (br, cc->matrix_coefficients, 8);
+  } else {
+    /* unspecified */
+    cc->color_primaries = 2;
+    cc->transfer_characteristics = 2;
+    cc->matrix_coefficients = 2;
+  }
+
+  if (cc->mono_chrome) {
+    READ_BIT (br, cc->color_range);
+    cc->subsampling_x = 1;
+    cc->subsampling_y = 1;
+    cc->chroma_sample_position = 0;
+    cc->separate_uv_delta_q = 0;
+    return TRUE;
+  }
+
+  if (cc->color_primaries == 1 && cc->transfer_characteristics == 13
+      && cc->matrix_coefficients == 0) {
+    /* sRGB */
+    cc->color_range = 1;
+    cc->subsampling_x = 0;
+    cc->subsampling_y = 0;
+  } else {
+    READ_BIT (br, cc->color_range);
+    if (seq_header->seq_profile == GST_AV1_PROFILE_0) {
+      cc->subsampling_x = 1;
+      cc->subsampling_y = 1;
+    } else if (seq_header->seq_profile == GST_AV1_PROFILE_1) {
+      cc->subsampling_x = 0;
+      cc->subsampling_y = 0;
+    } else if (cc->bit_depth == 12) {
+      READ_BIT (br, cc->subsampling_x);
+      if (cc->subsampling_x)
+        READ_BIT (br, cc->subsampling_y);
+      else
+        cc->subsampling_y = 0;
+    } else {
+      cc->subsampling_x = 1;
+      cc->subsampling_y = 0;
+    }
+
+    if (cc->subsampling_x && cc->subsampling_y)
+      READ_BITS (br, cc->chroma_sample_position, 2);
+  }
+
+  READ_BIT (br, cc->separate_uv_delta_q);
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static gboolean
+parse_operating_points (GstBitReader * br,
+    GstAV1SequenceHeaderOBU * seq_header)
+{
+  GstAV1OperatingPoint *op;
+  guint i, n;
+
+  READ_BIT (br, seq_header->timing_info_present_flag);
+  if (seq_header->timing_info_present_flag) {
+    GstAV1TimingInfo *ti = &seq_header->timing_info;
+
+    READ_BITS (br, ti->num_units_in_display_tick, 32);
+    READ_BITS (br, ti->time_scale, 32);
+    READ_BIT (br, ti->equal_picture_interval);
+    if (ti->equal_picture_interval) {
+      if (!read_uvlc (br, &ti->num_ticks_per_picture_minus_1))
+        goto error;
+    }
+
+    READ_BIT (br, seq_header->decoder_model_info_present_flag);
+    if (seq_header->decoder_model_info_present_flag) {
+      GstAV1DecoderModelInfo *dmi = &seq_header->decoder_model_info;
+
+      READ_BITS (br, dmi->buffer_delay_length_minus_1, 5);
+      READ_BITS (br, dmi->num_units_in_decoding_tick, 32);
+      READ_BITS (br, dmi->buffer_removal_time_length_minus_1, 5);
+      READ_BITS (br, dmi->frame_presentation_time_length_minus_1, 5);
+    }
+  }
+
+  READ_BIT (br, seq_header->initial_display_delay_present_flag);
+  READ_BITS (br, seq_header->operating_points_cnt_minus_1, 5);
+
+  for (i = 0; i <= seq_header->operating_points_cnt_minus_1; i++) {
+    op = &seq_header->operating_points[i];
+
+    READ_BITS (br, op->idc, 12);
+    READ_BITS (br, op->seq_level_idx, 5);
+    if (op->seq_level_idx > 7)
+      READ_BIT (br, op->seq_tier);
+
+    if (seq_header->decoder_model_info_present_flag) {
+      READ_BIT (br, op->decoder_model_present_for_this_op);
+      if (op->decoder_model_present_for_this_op) {
+        n = seq_header->decoder_model_info.buffer_delay_length_minus_1 + 1;
+        READ_BITS (br, op->decoder_buffer_delay, n);
+        READ_BITS (br, op->encoder_buffer_delay, n);
+        READ_BIT (br, op->low_delay_mode_flag);
+      }
+    }
+
+    if (seq_header->initial_display_delay_present_flag) {
+      READ_BIT (br, op->initial_display_delay_present_for_this_op);
+      if (op->initial_display_delay_present_for_this_op)
+        READ_BITS (br, op->initial_display_delay_minus_1, 4);
+    }
+  }
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+/**
+ * gst_av1_parser_parse_sequence_header_obu:
+ * @parser: the #GstAV1Parser
+ * @obu: a sequence header #GstAV1OBU
+ * @seq_header: (out): the #GstAV1SequenceHeaderOBU to fill
+ *
+ * Parses a sequence header OBU. On success it also becomes the active
+ * sequence header of @parser.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.14
+ */
+GstAV1ParserResult
+gst_av1_parser_parse_sequence_header_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1SequenceHeaderOBU * seq_header)
+{
+  GstBitReader br;
+  guint8 seq_profile;
+
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu->obu_type == GST_AV1_OBU_SEQUENCE_HEADER,
+      GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (seq_header != NULL, GST_AV1_PARSER_ERROR);
+
+  GST_DEBUG ("parsing sequence header");
+
+  memset (seq_header, 0, sizeof (*seq_header));
+  gst_bit_reader_init (&br, obu->data, obu->obu_size);
+
+  READ_BITS (&br, seq_profile, 3);
+  if (seq_profile > GST_AV1_PROFILE_2) {
+    GST_WARNING ("unsupported profile %d", seq_profile);
+    goto error;
+  }
+  seq_header->seq_profile = seq_profile;
+  READ_BIT (&br, seq_header->still_picture);
+  READ_BIT (&br, seq_header->reduced_still_picture_header);
+
+  if (seq_header->reduced_still_picture_header) {
+    seq_header->operating_points_cnt_minus_1 = 0;
+    READ_BITS (&br, seq_header->operating_points[0].seq_level_idx, 5);
+  } else if (!parse_operating_points (&br, seq_header)) {
+    goto error;
+  }
+
+  READ_BITS (&br, seq_header->frame_width_bits_minus_1, 4);
+  READ_BITS (&br, seq_header->frame_height_bits_minus_1, 4);
+  READ_BITS (&br, seq_header->max_frame_width_minus_1,
+      seq_header->frame_width_bits_minus_1 + 1);
+  READ_BITS (&br, seq_header->max_frame_height_minus_1,
+      seq_header->frame_height_bits_minus_1 + 1);
+
+  if (!seq_header->reduced_still_picture_header)
+    READ_BIT (&br, seq_header->frame_id_numbers_present_flag);
+  if (seq_header->frame_id_numbers_present_flag) {
+    READ_BITS (&br, seq_header->delta_frame_id_length_minus_2, 4);
+    READ_BITS (&br, seq_header->additional_frame_id_length_minus_1, 3);
+  }
+
+  READ_BIT (&br, seq_header->use_128x128_superblock);
+  READ_BIT (&br, seq_header->enable_filter_intra);
+  READ_BIT (&br, seq_header->enable_intra_edge_filter);
+
+  if (seq_header->reduced_still_picture_header) {
+    seq_header->seq_force_screen_content_tools =
+        GST_AV1_SELECT_SCREEN_CONTENT_TOOLS;
+    seq_header->seq_force_integer_mv = GST_AV1_SELECT_INTEGER_MV;
+  } else {
+    READ_BIT (&br, seq_header->enable_interintra_compound);
+    READ_BIT (&br, seq_header->enable_masked_compound);
+    READ_BIT (&br, seq_header->enable_warped_motion);
+    READ_BIT (&br, seq_header->enable_dual_filter);
+    READ_BIT (&br, seq_header->enable_order_hint);
+    if (seq_header->enable_order_hint) {
+      READ_BIT (&br, seq_header->enable_jnt_comp);
+      READ_BIT (&br, seq_header->enable_ref_frame_mvs);
+    }
+
+    READ_BIT (&br, seq_header->seq_choose_screen_content_tools);
+    if (seq_header->seq_choose_screen_content_tools)
+      seq_header->seq_force_screen_content_tools =
+          GST_AV1_SELECT_SCREEN_CONTENT_TOOLS;
+    else
+      READ_BIT (&br, seq_header->seq_force_screen_content_tools);
+
+    if (seq_header->seq_force_screen_content_tools > 0) {
+      READ_BIT (&br, seq_header->seq_choose_integer_mv);
+      if (seq_header->seq_choose_integer_mv)
+        seq_header->seq_force_integer_mv = GST_AV1_SELECT_INTEGER_MV;
+      else
+        READ_BIT (&br, seq_header->seq_force_integer_mv);
+    } else {
+      seq_header->seq_force_integer_mv = GST_AV1_SELECT_INTEGER_MV;
+    }
+
+    if (seq_header->enable_order_hint) {
+      READ_BITS (&br, seq_header->order_hint_bits_minus_1, 3);
+      seq_header->order_hint_bits = seq_header->order_hint_bits_minus_1 + 1;
+    }
+  }
+
+  READ_BIT (&br, seq_header->enable_superres);
+  READ_BIT (&br, seq_header->enable_cdef);
+  READ_BIT (&br, seq_header->enable_restoration);
+  if (!parse_color_config (&br, seq_header))
+    goto error;
+  READ_BIT (&br, seq_header->film_grain_params_present);
+
+  parser->seq_header = *seq_header;
+  parser->have_seq_header = TRUE;
+
+  return GST_AV1_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing sequence header");
+  return GST_AV1_PARSER_BROKEN_DATA;
+}
+
+/**
+ * gst_av1_parser_parse_temporal_delimiter_obu:
+ * @parser: the #GstAV1Parser
+ * @obu: a temporal delimiter #GstAV1OBU
+ *
+ * Handles a temporal delimiter, which starts a new temporal unit.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.14
+ */
+GstAV1ParserResult
+gst_av1_parser_parse_temporal_delimiter_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu)
+{
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu->obu_type == GST_AV1_OBU_TEMPORAL_DELIMITER,
+      GST_AV1_PARSER_ERROR);
+
+  GST_AV1_PARSER_GET_PRIVATE (parser)->seen_frame_header = FALSE;
+
+  return obu->obu_size == 0 ? GST_AV1_PARSER_OK : GST_AV1_PARSER_BROKEN_DATA;
+}
+
+static gboolean
+parse_superres_params (GstBitReader * br, GstAV1Parser * parser,
+    GstAV1FrameHeaderOBU * fh)
+{
+  guint8 coded_denom;
+
+  if (parser->seq_header.enable_superres)
+    READ_BIT (br, fh->use_superres);
+  else
+    fh->use_superres = 0;
+
+  if (fh->use_superres) {
+    READ_BITS (br, coded_denom, GST_AV1_SUPERRES_DENOM_BITS);
+    fh->superres_denom = coded_denom + GST_AV1_SUPERRES_DENOM_MIN;
+  } else {
+    fh->superres_denom = GST_AV1_SUPERRES_NUM;
+  }
+
+  fh->upscaled_width = fh->frame_width;
+  fh->frame_width = (fh->upscaled_width * GST_AV1_SUPERRES_NUM +
+      (fh->superres_denom / 2)) / fh->superres_denom;
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static void
+compute_image_size (GstAV1Parser * parser, GstAV1FrameHeaderOBU * fh)
+{
+  GstAV1ParserPrivate *priv = GST_AV1_PARSER_GET_PRIVATE (parser);
+
+  priv->mi_cols = 2 * ((fh->frame_width + 7) >> 3);
+  priv->mi_rows = 2 * ((fh->frame_height + 7) >> 3);
+}
+
+static gboolean
+parse_frame_size (GstBitReader * br, GstAV1Parser * parser,
+    GstAV1FrameHeaderOBU * fh)
+{
+  const GstAV1SequenceHeaderOBU *seq_header = &parser->seq_header;
+
+  if (fh->frame_size_override_flag) {
+    READ_BITS (br, fh->frame_width, seq_header->frame_width_bits_minus_1 + 1);
+    READ_BITS (br, fh->frame_height,
+        seq_header->frame_height_bits_minus_1 + 1);
+    fh->frame_width++;
+    fh->frame_height++;
+  } else {
+    fh->frame_width = seq_header->max_frame_width_minus_1 + 1;
+    fh->frame_height = seq_header->max_frame_height_minus_1 + 1;
+  }
+
+  if (!parse_superres_params (br, parser, fh))
+    goto error;
+  compute_image_size (parser, fh);
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static gboolean
+parse_render_size (GstBitReader * br, GstAV1FrameHeaderOBU * fh)
+{
+  guint8 render_and_frame_size_different;
+
+  READ_BIT (br, render_and_frame_size_different);
+  if (render_and_frame_size_different) {
+    READ_BITS (br, fh->render_width, 16);
+    READ_BITS (br, fh->render_height, 16);
+    fh->render_width++;
+    fh->render_height++;
+  } else {
+    fh->render_width = fh->upscaled_width;
+    fh->render_height = fh->frame_height;
+  }
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static gboolean
+parse_frame_size_with_refs (GstBitReader * br, GstAV1Parser * parser,
+    GstAV1FrameHeaderOBU * fh)
+{
+  GstAV1ParserPrivate *priv = GST_AV1_PARSER_GET_PRIVATE (parser);
+  GstAV1ReferenceSlot *ref;
+  guint8 found_ref = 0;
+  guint i;
+
+  for (i = 0; i < GST_AV1_REFS_PER_FRAME; i++) {
+    READ_BIT (br, found_ref);
+    if (found_ref) {
+      ref = &priv->ref[fh->ref_frame_idx[i]];
+      fh->upscaled_width = ref->upscaled_width;
+      fh->frame_width = fh->upscaled_width;
+      fh->frame_height = ref->frame_height;
+      fh->render_width = ref->render_width;
+      fh->render_height = ref->render_height;
+      break;
+    }
+  }
+
+  if (!found_ref) {
+    if (!parse_frame_size (br, parser, fh) || !parse_render_size (br, fh))
+      goto error;
+  } else {
+    if (!parse_superres_params (br, parser, fh))
+      goto error;
+    compute_image_size (parser, fh);
+  }
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static gint
+find_latest_backward (gint * shifted_order_hints, gboolean * used_frame,
+    gint cur_frame_hint)
+{
+  gint i, ref = -1, latest_order_hint = 0;
+
+  for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++) {
+    gint hint = shifted_order_hints[i];
+    if (!used_frame[i] && hint >= cur_frame_hint &&
+        (ref < 0 || hint >= latest_order_hint)) {
+      ref = i;
+      latest_order_hint = hint;
+    }
+  }
+  return ref;
+}
+
+static gint
+find_earliest_backward (gint * shifted_order_hints, gboolean * used_frame,
+    gint cur_frame_hint)
+{
+  gint i, ref = -1, earliest_order_hint = 0;
+
+  for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++) {
+    gint hint = shifted_order_hints[i];
+    if (!used_frame[i] && hint >= cur_frame_hint &&
+        (ref < 0 || hint < earliest_order_hint)) {
+      ref = i;
+      earliest_order_hint = hint;
+    }
+  }
+  return ref;
+}
+
+static gint
+find_latest_forward (gint * shifted_order_hints, gboolean * used_frame,
+    gint cur_frame_hint)
+{
+  gint i, ref = -1, latest_order_hint = 0;
+
+  for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++) {
+    gint hint = shifted_order_hints[i];
+    if (!used_frame[i] && hint < cur_frame_hint &&
+        (ref < 0 || hint >= latest_order_hint)) {
+      ref = i;
+      latest_order_hint = hint;
+    }
+  }
+  return ref;
+}
+
+/* 7.8: derives the references not signaled with frame_refs_short_signaling
+ * from ref_frame_idx[LAST_FRAME] and ref_frame_idx[GOLDEN_FRAME] */
+static void
+set_frame_refs (GstAV1Parser * parser, GstAV1FrameHeaderOBU * fh)
+{
+  static const gint ref_frame_list[] = { LAST2_FRAME, LAST3_FRAME,
+    BWDREF_FRAME, ALTREF2_FRAME, ALTREF_FRAME
+  };
+  GstAV1ParserPrivate *priv = GST_AV1_PARSER_GET_PRIVATE (parser);
+  gint ref_frame_idx[GST_AV1_REFS_PER_FRAME];
+  gint shifted_order_hints[GST_AV1_NUM_REF_FRAMES];
+  gboolean used_frame[GST_AV1_NUM_REF_FRAMES] = { FALSE, };
+  gint cur_frame_hint, earliest_order_hint = 0;
+  gint i, ref;
+
+  for (i = 0; i < GST_AV1_REFS_PER_FRAME; i++)
+    ref_frame_idx[i] = -1;
+  ref_frame_idx[LAST_FRAME] = fh->ref_frame_idx[LAST_FRAME];
+  ref_frame_idx[GOLDEN_FRAME] = fh->ref_frame_idx[GOLDEN_FRAME];
+  used_frame[fh->ref_frame_idx[LAST_FRAME]] = TRUE;
+  used_frame[fh->ref_frame_idx[GOLDEN_FRAME]] = TRUE;
+
+  cur_frame_hint = 1 << parser->seq_header.order_hint_bits_minus_1;
+  for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++)
+    shifted_order_hints[i] = cur_frame_hint +
+        get_relative_dist (&parser->seq_header, priv->ref[i].order_hint,
+        fh->order_hint);
+
+  ref = find_latest_backward (shifted_order_hints, used_frame,
+      cur_frame_hint);
+  if (ref >= 0) {
+    ref_frame_idx[ALTREF_FRAME] = ref;
+    used_frame[ref] = TRUE;
+  }
+
+  ref = find_earliest_backward (shifted_order_hints, used_frame,
+      cur_frame_hint);
+  if (ref >= 0) {
+    ref_frame_idx[BWDREF_FRAME] = ref;
+    used_frame[ref] = TRUE;
+  }
+
+  ref = find_earliest_backward (shifted_order_hints, used_frame,
+      cur_frame_hint);
+  if (ref >= 0) {
+    ref_frame_idx[ALTREF2_FRAME] = ref;
+    used_frame[ref] = TRUE;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (ref_frame_list); i++) {
+    if (ref_frame_idx[ref_frame_list[i]] < 0) {
+      ref = find_latest_forward (shifted_order_hints, used_frame,
+          cur_frame_hint);
+      if (ref >= 0) {
+        ref_frame_idx[ref_frame_list[i]] = ref;
+        used_frame[ref] = TRUE;
+      }
+    }
+  }
+
+  ref = -1;
+  for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++) {
+    if (ref < 0 || shifted_order_hints[i] < earliest_order_hint) {
+      ref = i;
+      earliest_order_hint = shifted_order_hints[i];
+    }
+  }
+
+  for (i = 0; i < GST_AV1_REFS_PER_FRAME; i++)
+    fh->ref_frame_idx[i] = ref_frame_idx[i] < 0 ? ref : ref_frame_idx[i];
+}
+
+static gboolean
+parse_tile_info (GstBitReader * br, GstAV1Parser * parser,
+    GstAV1FrameHeaderOBU * fh)
+{
+  GstAV1ParserPrivate *priv = GST_AV1_PARSER_GET_PRIVATE (parser);
+  GstAV1TileInfo *ti = &fh->tile_info;
+  guint sb_cols, sb_rows, sb_shift, sb_size;
+  guint max_tile_width_sb, max_tile_area_sb, max_tile_height_sb;
+  guint min_log2_tile_cols, max_log2_tile_cols, max_log2_tile_rows;
+  guint min_log2_tiles, min_log2_tile_rows;
+  guint tile_width_sb, tile_height_sb, widest_tile_sb, start_sb, size_sb;
+  guint32 size_minus_1;
+  guint8 increment;
+  guint i;
+
+  if (parser->seq_header.use_128x128_superblock) {
+    sb_cols = (priv->mi_cols + 31) >> 5;
+    sb_rows = (priv->mi_rows + 31) >> 5;
+    sb_shift = 5;
+  } else {
+    sb_cols = (priv->mi_cols + 15) >> 4;
+    sb_rows = (priv->mi_rows + 15) >> 4;
+    sb_shift = 4;
+  }
+  sb_size = sb_shift + 2;
+
+  max_tile_width_sb = MAX_TILE_WIDTH >> sb_size;
+  max_tile_area_sb = MAX_TILE_AREA >> (2 * sb_size);
+  min_log2_tile_cols = tile_log2 (max_tile_width_sb, sb_cols);
+  max_log2_tile_cols = tile_log2 (1, MIN (sb_cols, GST_AV1_MAX_TILE_COLS));
+  max_log2_tile_rows = tile_log2 (1, MIN (sb_rows, GST_AV1_MAX_TILE_ROWS));
+  min_log2_tiles = MAX (min_log2_tile_cols,
+      tile_log2 (max_tile_area_sb, sb_rows * sb_cols));
+
+  READ_BIT (br, ti->uniform_tile_spacing_flag);
+  if (ti->uniform_tile_spacing_flag) {
+    ti->tile_cols_log2 = min_log2_tile_cols;
+    while (ti->tile_cols_log2 < max_log2_tile_cols) {
+      READ_BIT (br, increment);
+      if (!increment)
+        break;
+      ti->tile_cols_log2++;
+    }
+
+    tile_width_sb = (sb_cols + (1 << ti->tile_cols_log2) - 1) >>
+        ti->tile_cols_log2;
+    i = 0;
+    for (start_sb = 0; start_sb < sb_cols; start_sb += tile_width_sb)
+      ti->mi_col_starts[i++] = start_sb << sb_shift;
+    ti->mi_col_starts[i] = priv->mi_cols;
+    ti->tile_cols = i;
+
+    min_log2_tile_rows = min_log2_tiles > ti->tile_cols_log2 ?
+        min_log2_tiles - ti->tile_cols_log2 : 0;
+    ti->tile_rows_log2 = min_log2_tile_rows;
+    while (ti->tile_rows_log2 < max_log2_tile_rows) {
+      READ_BIT (br, increment);
+      if (!increment)
+        break;
+      ti->tile_rows_log2++;
+    }
+
+    tile_height_sb = (sb_rows + (1 << ti->tile_rows_log2) - 1) >>
+        ti->tile_rows_log2;
+    i = 0;
+    for (start_sb = 0; start_sb < sb_rows; start_sb += tile_height_sb)
+      ti->mi_row_starts[i++] = start_sb << sb_shift;
+    ti->mi_row_starts[i] = priv->mi_rows;
+    ti->tile_rows = i;
+  } else {
+    widest_tile_sb = 0;
+    start_sb = 0;
+    for (i = 0; start_sb < sb_cols; i++) {
+      if (i >= GST_AV1_MAX_TILE_COLS)
+        goto error;
+      ti->mi_col_starts[i] = start_sb << sb_shift;
+      if (!read_ns (br, MIN (sb_cols - start_sb, max_tile_width_sb),
+              &size_minus_1))
+        goto error;
+      size_sb = size_minus_1 + 1;
+      widest_tile_sb = MAX (size_sb, widest_tile_sb);
+      start_sb += size_sb;
+    }
+    ti->mi_col_starts[i] = priv->mi_cols;
+    ti->tile_cols = i;
+    ti->tile_cols_log2 = tile_log2 (1, ti->tile_cols);
+
+    if (min_log2_tiles > 0)
+      max_tile_area_sb = (sb_rows * sb_cols) >> (min_log2_tiles + 1);
+    else
+      max_tile_area_sb = sb_rows * sb_cols;
+    max_tile_height_sb = MAX (max_tile_area_sb / widest_tile_sb, 1);
+
+    start_sb = 0;
+    for (i = 0; start_sb < sb_rows; i++) {
+      if (i >= GST_AV1_MAX_TILE_ROWS)
+        goto error;
+      ti->mi_row_starts[i] = start_sb << sb_shift;
+      if (!read_ns (br, MIN (sb_rows - start_sb, max_tile_height_sb),
+              &size_minus_1))
+        goto error;
+      start_sb += size_minus_1 + 1;
+    }
+    ti->mi_row_starts[i] = priv->mi_rows;
+    ti->tile_rows = i;
+    ti->tile_rows_log2 = tile_log2 (1, ti->tile_rows);
+  }
+
+  if (ti->tile_cols_log2 > 0 || ti->tile_rows_log2 > 0) {
+    READ_BITS (br, ti->context_update_tile_id,
+        ti->tile_rows_log2 + ti->tile_cols_log2);
+    READ_BITS (br, ti->tile_size_bytes_minus_1, 2);
+  } else {
+    ti->context_update_tile_id = 0;
+  }
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static void
+update_reference_slots (GstAV1Parser * parser, GstAV1FrameHeaderOBU * fh)
+{
+  GstAV1ParserPrivate *priv = GST_AV1_PARSER_GET_PRIVATE (parser);
+  guint i;
+
+  for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++) {
+    GstAV1ReferenceSlot *ref = &priv->ref[i];
+
+    if (!((fh->refresh_frame_flags >> i) & 1))
+      continue;
+
+    ref->valid = TRUE;
+    ref->frame_id = fh->current_frame_id;
+    ref->frame_type = fh->frame_type;
+    ref->order_hint = fh->order_hint;
+    ref->upscaled_width = fh->upscaled_width;
+    ref->frame_width = fh->frame_width;
+    ref->frame_height = fh->frame_height;
+    ref->render_width = fh->render_width;
+    ref->render_height = fh->render_height;
+  }
+}
+
+static gboolean
+parse_temporal_point_info (GstBitReader * br, GstAV1Parser * parser)
+{
+  SKIP_BITS (br, parser->seq_header.decoder_model_info.
+      frame_presentation_time_length_minus_1 + 1);
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static gboolean
+parse_uncompressed_header (GstBitReader * br, GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1FrameHeaderOBU * fh)
+{
+  GstAV1ParserPrivate *priv = GST_AV1_PARSER_GET_PRIVATE (parser);
+  const GstAV1SequenceHeaderOBU *seq_header = &parser->seq_header;
+  gboolean frame_is_intra, decoder_model;
+  guint id_len = 0, i, n;
+  guint8 frame_type, buffer_removal_time_present_flag;
+
+  if (seq_header->frame_id_numbers_present_flag)
+    id_len = seq_header->additional_frame_id_length_minus_1 +
+        seq_header->delta_frame_id_length_minus_2 + 3;
+
+  decoder_model = seq_header->decoder_model_info_present_flag &&
+      !seq_header->timing_info.equal_picture_interval;
+
+  if (seq_header->reduced_still_picture_header) {
+    fh->show_existing_frame = 0;
+    fh->frame_type = GST_AV1_KEY_FRAME;
+    fh->show_frame = 1;
+    fh->showable_frame = 0;
+    frame_is_intra = TRUE;
+  } else {
+    READ_BIT (br, fh->show_existing_frame);
+    if (fh->show_existing_frame) {
+      READ_BITS (br, fh->frame_to_show_map_idx, 3);
+      if (decoder_model && !parse_temporal_point_info (br, parser))
+        goto error;
+      fh->refresh_frame_flags = 0;
+      if (seq_header->frame_id_numbers_present_flag)
+        SKIP_BITS (br, id_len);
+
+      fh->frame_type = priv->ref[fh->frame_to_show_map_idx].frame_type;
+      if (fh->frame_type == GST_AV1_KEY_FRAME)
+        fh->refresh_frame_flags = ALL_FRAMES;
+
+      return TRUE;
+    }
+
+    READ_BITS (br, frame_type, 2);
+    fh->frame_type = frame_type;
+    frame_is_intra = (fh->frame_type == GST_AV1_INTRA_ONLY_FRAME
+        || fh->frame_type == GST_AV1_KEY_FRAME);
+    READ_BIT (br, fh->show_frame);
+    if (fh->show_frame && decoder_model
+        && !parse_temporal_point_info (br, parser))
+      goto error;
+    if (fh->show_frame)
+      fh->showable_frame = fh->frame_type != GST_AV1_KEY_FRAME;
+    else
+      READ_BIT (br, fh->showable_frame);
+
+    if (fh->frame_type == GST_AV1_SWITCH_FRAME
+        || (fh->frame_type == GST_AV1_KEY_FRAME && fh->show_frame))
+      fh->error_resilient_mode = 1;
+    else
+      READ_BIT (br, fh->error_resilient_mode);
+  }
+
+  if (fh->frame_type == GST_AV1_KEY_FRAME && fh->show_frame) {
+    for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++) {
+      priv->ref[i].valid = FALSE;
+      priv->ref[i].order_hint = 0;
+    }
+  }
+
+  READ_BIT (br, fh->disable_cdf_update);
+  if (seq_header->seq_force_screen_content_tools ==
+      GST_AV1_SELECT_SCREEN_CONTENT_TOOLS)
+    READ_BIT (br, fh->allow_screen_content_tools);
+  else
+    fh->allow_screen_content_tools =
+        seq_header->seq_force_screen_content_tools;
+
+  if (fh->allow_screen_content_tools) {
+    if (seq_header->seq_force_integer_mv == GST_AV1_SELECT_INTEGER_MV)
+      READ_BIT (br, fh->force_integer_mv);
+    else
+      fh->force_integer_mv = seq_header->seq_force_integer_mv;
+  } else {
+    fh->force_integer_mv = 0;
+  }
+  if (frame_is_intra)
+    fh->force_integer_mv = 1;
+
+  if (seq_header->frame_id_numbers_present_flag)
+    READ_BITS (br, fh->current_frame_id, id_len);
+  else
+    fh->current_frame_id = 0;
+
+  if (fh->frame_type == GST_AV1_SWITCH_FRAME)
+    fh->frame_size_override_flag = 1;
+  else if (seq_header->reduced_still_picture_header)
+    fh->frame_size_override_flag = 0;
+  else
+    READ_BIT (br, fh->frame_size_override_flag);
+
+  READ_BITS (br, fh->order_hint, seq_header->order_hint_bits);
+
+  if (frame_is_intra || fh->error_resilient_mode)
+    fh->primary_ref_frame = GST_AV1_PRIMARY_REF_NONE;
+  else
+    READ_BITS (br, fh->primary_ref_frame, 3);
+
+  if (seq_header->decoder_model_info_present_flag) {
+    READ_BIT (br, buffer_removal_time_present_flag);
+    if (buffer_removal_time_present_flag) {
+      for (i = 0; i <= seq_header->operating_points_cnt_minus_1; i++) {
+        const GstAV1OperatingPoint *op = &seq_header->operating_points[i];
+
+        if (!op->decoder_model_present_for_this_op)
+          continue;
+        if (op->idc == 0 || (((op->idc >> obu->header.temporal_id) & 1)
+                && ((op->idc >> (obu->header.spatial_id + 8)) & 1))) {
+          n = seq_header->decoder_model_info.
+              buffer_removal_time_length_minus_1 + 1;
+          SKIP_BITS (br, n);
+        }
+      }
+    }
+  }
+
+  if (fh->frame_type == GST_AV1_SWITCH_FRAME
+      || (fh->frame_type == GST_AV1_KEY_FRAME && fh->show_frame))
+    fh->refresh_frame_flags = ALL_FRAMES;
+  else
+    READ_BITS (br, fh->refresh_frame_flags, 8);
+
+  if ((!frame_is_intra || fh->refresh_frame_flags != ALL_FRAMES)
+      && fh->error_resilient_mode && seq_header->enable_order_hint) {
+    for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++) {
+      READ_BITS (br, fh->ref_order_hint[i], seq_header->order_hint_bits);
+      if (fh->ref_order_hint[i] != priv->ref[i].order_hint) {
+        priv->ref[i].valid = FALSE;
+        priv->ref[i].order_hint = fh->ref_order_hint[i];
+      }
+    }
+  }
+
+  if (frame_is_intra) {
+    if (!parse_frame_size (br, parser, fh) || !parse_render_size (br, fh))
+      goto error;
+    if (fh->allow_screen_content_tools
+        && fh->upscaled_width == fh->frame_width)
+      READ_BIT (br, fh->allow_intrabc);
+  } else {
+    if (seq_header->enable_order_hint)
+      READ_BIT (br, fh->frame_refs_short_signaling);
+    if (fh->frame_refs_short_signaling) {
+      READ_BITS (br, fh->ref_frame_idx[LAST_FRAME], 3);
+      READ_BITS (br, fh->ref_frame_idx[GOLDEN_FRAME], 3);
+      set_frame_refs (parser, fh);
+    }
+
+    for (i = 0; i < GST_AV1_REFS_PER_FRAME; i++) {
+      if (!fh->frame_refs_short_signaling)
+        READ_BITS (br, fh->ref_frame_idx[i], 3);
+      if (seq_header->frame_id_numbers_present_flag)
+        SKIP_BITS (br, seq_header->delta_frame_id_length_minus_2 + 2);
+    }
+
+    if (fh->frame_size_override_flag && !fh->error_resilient_mode) {
+      if (!parse_frame_size_with_refs (br, parser, fh))
+        goto error;
+    } else {
+      if (!parse_frame_size (br, parser, fh) || !parse_render_size (br, fh))
+        goto error;
+    }
+
+    if (fh->force_integer_mv)
+      fh->allow_high_precision_mv = 0;
+    else
+      READ_BIT (br, fh->allow_high_precision_mv);
+
+    READ_BIT (br, fh->is_filter_switchable);
+    if (fh->is_filter_switchable)
+      fh->interpolation_filter = SWITCHABLE_FILTER;
+    else
+      READ_BITS (br, fh->interpolation_filter, 2);
+
+    READ_BIT (br, fh->is_motion_mode_switchable);
+    if (fh->error_resilient_mode || !seq_header->enable_ref_frame_mvs)
+      fh->use_ref_frame_mvs = 0;
+    else
+      READ_BIT (br, fh->use_ref_frame_mvs);
+  }
+
+  if (seq_header->reduced_still_picture_header || fh->disable_cdf_update)
+    fh->disable_frame_end_update_cdf = 1;
+  else
+    READ_BIT (br, fh->disable_frame_end_update_cdf);
+
+  if (!parse_tile_info (br, parser, fh))
+    goto error;
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+static GstAV1ParserResult
+parse_frame_header (GstAV1Parser * parser, GstAV1OBU * obu,
+    GstAV1FrameHeaderOBU * frame_header)
+{
+  GstAV1ParserPrivate *priv = GST_AV1_PARSER_GET_PRIVATE (parser);
+  GstBitReader br;
+  guint i;
+
+  if (!parser->have_seq_header)
+    return GST_AV1_PARSER_MISSING_OBU_REFERENCE;
+
+  /* frame_header_copy(), nothing new in there */
+  if (priv->seen_frame_header) {
+    *frame_header = priv->frame_header;
+    return GST_AV1_PARSER_OK;
+  }
+
+  memset (frame_header, 0, sizeof (*frame_header));
+  gst_bit_reader_init (&br, obu->data, obu->obu_size);
+
+  if (!parse_uncompressed_header (&br, parser, obu, frame_header)) {
+    GST_WARNING ("error parsing frame header");
+    return GST_AV1_PARSER_BROKEN_DATA;
+  }
+
+  if (frame_header->show_existing_frame) {
+    /* showing a key frame loads it into all the reference slots */
+    if (frame_header->refresh_frame_flags == ALL_FRAMES) {
+      GstAV1ReferenceSlot ref = priv->ref[frame_header->frame_to_show_map_idx];
+
+      for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++)
+        priv->ref[i] = ref;
+    }
+    return GST_AV1_PARSER_OK;
+  }
+
+  update_reference_slots (parser, frame_header);
+  priv->frame_header = *frame_header;
+  priv->seen_frame_header = TRUE;
+
+  return GST_AV1_PARSER_OK;
+}
+
+/**
+ * gst_av1_parser_parse_frame_header_obu:
+ * @parser: the #GstAV1Parser
+ * @obu: a frame header or redundant frame header #GstAV1OBU
+ * @frame_header: (out): the #GstAV1FrameHeaderOBU to fill
+ *
+ * Parses a frame header OBU, up to and including the tile info, and updates
+ * the reference slots of @parser. Copies of the header of the current frame
+ * are not parsed again, @frame_header is filled from the first one.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.14
+ */
+GstAV1ParserResult
+gst_av1_parser_parse_frame_header_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1FrameHeaderOBU * frame_header)
+{
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu->obu_type == GST_AV1_OBU_FRAME_HEADER
+      || obu->obu_type == GST_AV1_OBU_REDUNDANT_FRAME_HEADER,
+      GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (frame_header != NULL, GST_AV1_PARSER_ERROR);
+
+  return parse_frame_header (parser, obu, frame_header);
+}
+
+/**
+ * gst_av1_parser_parse_tile_group_obu:
+ * @parser: the #GstAV1Parser
+ * @obu: a tile group #GstAV1OBU
+ * @tile_group: (out): the #GstAV1TileGroupOBU to fill
+ *
+ * Parses the tile group info of a tile group OBU. The frame is complete
+ * once the last tile was seen, a following frame header then starts a new
+ * frame.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.14
+ */
+GstAV1ParserResult
+gst_av1_parser_parse_tile_group_obu (GstAV1Parser * parser, GstAV1OBU * obu,
+    GstAV1TileGroupOBU * tile_group)
+{
+  GstAV1ParserPrivate *priv;
+  const GstAV1TileInfo *ti;
+  GstBitReader br;
+  guint tile_bits;
+
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu->obu_type == GST_AV1_OBU_TILE_GROUP,
+      GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (tile_group != NULL, GST_AV1_PARSER_ERROR);
+
+  priv = GST_AV1_PARSER_GET_PRIVATE (parser);
+  if (!priv->seen_frame_header)
+    return GST_AV1_PARSER_MISSING_OBU_REFERENCE;
+
+  ti = &priv->frame_header.tile_info;
+  memset (tile_group, 0, sizeof (*tile_group));
+  tile_group->num_tiles = ti->tile_cols * ti->tile_rows;
+  gst_bit_reader_init (&br, obu->data, obu->obu_size);
+
+  if (tile_group->num_tiles > 1)
+    READ_BIT (&br, tile_group->tile_start_and_end_present_flag);
+
+  if (tile_group->tile_start_and_end_present_flag) {
+    tile_bits = ti->tile_cols_log2 + ti->tile_rows_log2;
+    READ_BITS (&br, tile_group->tg_start, tile_bits);
+    READ_BITS (&br, tile_group->tg_end, tile_bits);
+    if (tile_group->tg_start > tile_group->tg_end
+        || tile_group->tg_end >= tile_group->num_tiles)
+      goto error;
+  } else {
+    tile_group->tg_start = 0;
+    tile_group->tg_end = tile_group->num_tiles - 1;
+  }
+
+  if (tile_group->tg_end == tile_group->num_tiles - 1)
+    priv->seen_frame_header = FALSE;
+
+  return GST_AV1_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing tile group");
+  return GST_AV1_PARSER_BROKEN_DATA;
+}
+
+/**
+ * gst_av1_parser_parse_frame_obu:
+ * @parser: the #GstAV1Parser
+ * @obu: a frame #GstAV1OBU
+ * @frame_header: (out): the #GstAV1FrameHeaderOBU to fill
+ * @tile_group: (out): the #GstAV1TileGroupOBU to fill
+ *
+ * Parses a frame OBU, a frame header followed by a tile group. The tile
+ * group of a frame OBU always covers all the tiles of the frame.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.14
+ */
+GstAV1ParserResult
+gst_av1_parser_parse_frame_obu (GstAV1Parser * parser, GstAV1OBU * obu,
+    GstAV1FrameHeaderOBU * frame_header, GstAV1TileGroupOBU * tile_group)
+{
+  GstAV1ParserResult res;
+  const GstAV1TileInfo *ti;
+
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu->obu_type == GST_AV1_OBU_FRAME,
+      GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (frame_header != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (tile_group != NULL, GST_AV1_PARSER_ERROR);
+
+  res = parse_frame_header (parser, obu, frame_header);
+  if (res != GST_AV1_PARSER_OK)
+    return res;
+
+  if (frame_header->show_existing_frame)
+    return GST_AV1_PARSER_BROKEN_DATA;
+
+  /* tile_start_and_end_present_flag must be 0 in frame OBUs */
+  ti = &frame_header->tile_info;
+  memset (tile_group, 0, sizeof (*tile_group));
+  tile_group->num_tiles = ti->tile_cols * ti->tile_rows;
+  tile_group->tg_start = 0;
+  tile_group->tg_end = tile_group->num_tiles - 1;
+
+  GST_AV1_PARSER_GET_PRIVATE (parser)->seen_frame_header = FALSE;
+
+  return GST_AV1_PARSER_OK;
+}
@@ -0,0 +1,595 @@
+/*
+ * gstav1parser.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GST_AV1_PARSER_H
+#define GST_AV1_PARSER_H
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The AV1 parsing library is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_AV1_MAX_OPERATING_POINTS 32
+#define GST_AV1_NUM_REF_FRAMES       8
+#define GST_AV1_REFS_PER_FRAME       7
+#define GST_AV1_PRIMARY_REF_NONE     7
+#define GST_AV1_SUPERRES_NUM         8
+#define GST_AV1_SUPERRES_DENOM_MIN   9
+#define GST_AV1_SUPERRES_DENOM_BITS  3
+#define GST_AV1_MAX_TILE_COLS        64
+#define GST_AV1_MAX_TILE_ROWS        64
+#define GST_AV1_SELECT_SCREEN_CONTENT_TOOLS 2
+#define GST_AV1_SELECT_INTEGER_MV    2
+
+typedef struct _GstAV1Parser               GstAV1Parser;
+typedef struct _GstAV1OBUHeader            GstAV1OBUHeader;
+typedef struct _GstAV1OBU                  GstAV1OBU;
+typedef struct _GstAV1TimingInfo           GstAV1TimingInfo;
+typedef struct _GstAV1DecoderModelInfo     GstAV1DecoderModelInfo;
+typedef struct _GstAV1OperatingPoint       GstAV1OperatingPoint;
+typedef struct _GstAV1ColorConfig          GstAV1ColorConfig;
+typedef struct _GstAV1SequenceHeaderOBU    GstAV1SequenceHeaderOBU;
+typedef struct _GstAV1TileInfo             GstAV1TileInfo;
+typedef struct _GstAV1FrameHeaderOBU       GstAV1FrameHeaderOBU;
+typedef struct _GstAV1TileGroupOBU         GstAV1TileGroupOBU;
+
+/**
+ * GstAV1ParserResult:
+ * @GST_AV1_PARSER_OK: The parsing went well
+ * @GST_AV1_PARSER_BROKEN_DATA: The data to parse is broken
+ * @GST_AV1_PARSER_NO_MORE_DATA: The OBU is not complete in the data
+ * @GST_AV1_PARSER_DROP: The OBU is not part of the selected operating
+ *   point and should be dropped
+ * @GST_AV1_PARSER_MISSING_OBU_REFERENCE: The OBU needs a sequence header
+ *   or a frame header which has not been parsed yet
+ * @GST_AV1_PARSER_ERROR: An error occured during the parsing
+ *
+ * Result type of any parsing function.
+ *
+ * Since: 1.14
+ */
+typedef enum
+{
+  GST_AV1_PARSER_OK,
+  GST_AV1_PARSER_BROKEN_DATA,
+  GST_AV1_PARSER_NO_MORE_DATA,
+  GST_AV1_PARSER_DROP,
+  GST_AV1_PARSER_MISSING_OBU_REFERENCE,
+  GST_AV1_PARSER_ERROR,
+} GstAV1ParserResult;
+
+/**
+ * GstAV1OBUType:
+ * @GST_AV1_OBU_SEQUENCE_HEADER: sequence header
+ * @GST_AV1_OBU_TEMPORAL_DELIMITER: temporal delimiter, starts a temporal unit
+ * @GST_AV1_OBU_FRAME_HEADER: frame header
+ * @GST_AV1_OBU_TILE_GROUP: tile group
+ * @GST_AV1_OBU_METADATA: metadata
+ * @GST_AV1_OBU_FRAME: frame header followed by a tile group
+ * @GST_AV1_OBU_REDUNDANT_FRAME_HEADER: copy of the frame header
+ * @GST_AV1_OBU_TILE_LIST: tile list, for large scale tile decoding
+ * @GST_AV1_OBU_PADDING: padding
+ *
+ * AV1 OBU types
+ *
+ * Since: 1.14
+ */
+typedef enum
+{
+  GST_AV1_OBU_SEQUENCE_HEADER = 1,
+  GST_AV1_OBU_TEMPORAL_DELIMITER = 2,
+  GST_AV1_OBU_FRAME_HEADER = 3,
+  GST_AV1_OBU_TILE_GROUP = 4,
+  GST_AV1_OBU_METADATA = 5,
+  GST_AV1_OBU_FRAME = 6,
+  GST_AV1_OBU_REDUNDANT_FRAME_HEADER = 7,
+  GST_AV1_OBU_TILE_LIST = 8,
+  GST_AV1_OBU_PADDING = 15,
+} GstAV1OBUType;
+
+/**
+ * GstAV1Profile:
+ * @GST_AV1_PROFILE_0: Main profile, 8 and 10 bits 4:2:0 and monochrome
+ * @GST_AV1_PROFILE_1: High profile, 8 and 10 bits up to 4:4:4
+ * @GST_AV1_PROFILE_2: Professional profile, all bit depths and subsamplings
+ *
+ * AV1 profiles
+ *
+ * Since: 1.14
+ */
+typedef enum
+{
+  GST_AV1_PROFILE_0 = 0,
+  GST_AV1_PROFILE_1 = 1,
+  GST_AV1_PROFILE_2 = 2,
+} GstAV1Profile;
+
+/**
+ * GstAV1FrameType:
+ * @GST_AV1_KEY_FRAME: key frame, resets the decoding process
+ * @GST_AV1_INTER_FRAME: inter frame
+ * @GST_AV1_INTRA_ONLY_FRAME: intra frame which is not a key frame
+ * @GST_AV1_SWITCH_FRAME: switch frame, for switching between streams
+ *
+ * AV1 frame types
+ *
+ * Since: 1.14
+ */
+typedef enum
+{
+  GST_AV1_KEY_FRAME = 0,
+  GST_AV1_INTER_FRAME = 1,
+  GST_AV1_INTRA_ONLY_FRAME = 2,
+  GST_AV1_SWITCH_FRAME = 3,
+} GstAV1FrameType;
+
+/**
+ * GstAV1OBUHeader:
+ * @obu_type: the #GstAV1OBUType
+ * @obu_extension_flag: whether the extension header is present
+ * @obu_has_size_field: whether the obu_size syntax element is present
+ * @temporal_id: temporal layer of the OBU
+ * @spatial_id: spatial layer of the OBU
+ *
+ * OBU header.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1OBUHeader
+{
+  GstAV1OBUType obu_type;
+  guint8 obu_extension_flag;
+  guint8 obu_has_size_field;
+  guint8 temporal_id;
+  guint8 spatial_id;
+};
+
+/**
+ * GstAV1OBU:
+ * @header: the #GstAV1OBUHeader
+ * @obu_type: the #GstAV1OBUType, same as in @header
+ * @data: the payload of the OBU, after the header and the obu_size field
+ * @obu_size: the size of the payload
+ * @header_size: the size of the OBU header including the obu_size field
+ *
+ * An OBU as found by gst_av1_parser_identify_one_obu().
+ *
+ * Since: 1.14
+ */
+struct _GstAV1OBU
+{
+  GstAV1OBUHeader header;
+  GstAV1OBUType obu_type;
+  const guint8 *data;
+  guint32 obu_size;
+  guint32 header_size;
+};
+
+/**
+ * GstAV1TimingInfo:
+ * @num_units_in_display_tick: time units of a display tick
+ * @time_scale: number of time units in a second
+ * @equal_picture_interval: whether pictures are displayed at a
+ *   constant rate
+ * @num_ticks_per_picture_minus_1: display ticks per picture, minus 1
+ *
+ * Timing info of the sequence header.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1TimingInfo
+{
+  guint32 num_units_in_display_tick;
+  guint32 time_scale;
+  guint8 equal_picture_interval;
+  guint32 num_ticks_per_picture_minus_1;
+};
+
+/**
+ * GstAV1DecoderModelInfo:
+ * @buffer_delay_length_minus_1: length of the buffer delay fields, minus 1
+ * @num_units_in_decoding_tick: time units of a decoding tick
+ * @buffer_removal_time_length_minus_1: length of the buffer_removal_time
+ *   fields, minus 1
+ * @frame_presentation_time_length_minus_1: length of the
+ *   frame_presentation_time field, minus 1
+ *
+ * Decoder model info of the sequence header.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1DecoderModelInfo
+{
+  guint8 buffer_delay_length_minus_1;
+  guint32 num_units_in_decoding_tick;
+  guint8 buffer_removal_time_length_minus_1;
+  guint8 frame_presentation_time_length_minus_1;
+};
+
+/**
+ * GstAV1OperatingPoint:
+ * @idc: the temporal and spatial layers of the operating point
+ * @seq_level_idx: the level of the operating point
+ * @seq_tier: the tier of the operating point
+ * @decoder_model_present_for_this_op: whether the decoder model parameters
+ *   are present
+ * @decoder_buffer_delay: decoder buffer delay
+ * @encoder_buffer_delay: encoder buffer delay
+ * @low_delay_mode_flag: whether the operating point uses low delay mode
+ * @initial_display_delay_present_for_this_op: whether
+ *   @initial_display_delay_minus_1 is present
+ * @initial_display_delay_minus_1: number of decoded frames before display,
+ *   minus 1
+ *
+ * An operating point of the sequence header.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1OperatingPoint
+{
+  guint16 idc;
+  guint8 seq_level_idx;
+  guint8 seq_tier;
+  guint8 decoder_model_present_for_this_op;
+  guint32 decoder_buffer_delay;
+  guint32 encoder_buffer_delay;
+  guint8 low_delay_mode_flag;
+  guint8 initial_display_delay_present_for_this_op;
+  guint8 initial_display_delay_minus_1;
+};
+
+/**
+ * GstAV1ColorConfig:
+ * @high_bitdepth: 10 or 12 bits per sample
+ * @twelve_bit: 12 bits per sample
+ * @bit_depth: the resulting bit depth
+ * @mono_chrome: whether there is only a luma plane
+ * @color_description_present_flag: whether the color description is present
+ * @color_primaries: color primaries, as in ISO/IEC 23091-4
+ * @transfer_characteristics: transfer characteristics, as in ISO/IEC 23091-4
+ * @matrix_coefficients: matrix coefficients, as in ISO/IEC 23091-4
+ * @color_range: full range when set, studio range otherwise
+ * @subsampling_x: horizontal chroma subsampling
+ * @subsampling_y: vertical chroma subsampling
+ * @chroma_sample_position: position of the chroma samples for 4:2:0
+ * @separate_uv_delta_q: whether U and V have separate delta quantizers
+ *
+ * Color configuration of the sequence header.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1ColorConfig
+{
+  guint8 high_bitdepth;
+  guint8 twelve_bit;
+  guint8 bit_depth;
+  guint8 mono_chrome;
+  guint8 color_description_present_flag;
+  guint8 color_primaries;
+  guint8 transfer_characteristics;
+  guint8 matrix_coefficients;
+  guint8 color_range;
+  guint8 subsampling_x;
+  guint8 subsampling_y;
+  guint8 chroma_sample_position;
+  guint8 separate_uv_delta_q;
+};
+
+/**
+ * GstAV1SequenceHeaderOBU:
+ * @seq_profile: the #GstAV1Profile
+ * @still_picture: the sequence contains a single picture
+ * @reduced_still_picture_header: the reduced syntax for still pictures is
+ *   used
+ * @timing_info_present_flag: whether @timing_info is present
+ * @timing_info: the #GstAV1TimingInfo
+ * @decoder_model_info_present_flag: whether @decoder_model_info is present
+ * @decoder_model_info: the #GstAV1DecoderModelInfo
+ * @initial_display_delay_present_flag: whether initial display delays are
+ *   present in the operating points
+ * @operating_points_cnt_minus_1: number of operating points, minus 1
+ * @operating_points: the #GstAV1OperatingPoint
+ * @frame_width_bits_minus_1: number of bits of frame_width_minus_1, minus 1
+ * @frame_height_bits_minus_1: number of bits of frame_height_minus_1, minus 1
+ * @max_frame_width_minus_1: maximum frame width, minus 1
+ * @max_frame_height_minus_1: maximum frame height, minus 1
+ * @frame_id_numbers_present_flag: whether frame ids are present
+ * @delta_frame_id_length_minus_2: length of delta_frame_id, minus 2
+ * @additional_frame_id_length_minus_1: used to compute the length of
+ *   frame ids, minus 1
+ * @use_128x128_superblock: superblocks are 128x128 instead of 64x64
+ * @enable_filter_intra: whether filter intra may be used
+ * @enable_intra_edge_filter: whether the intra edge filter may be used
+ * @enable_interintra_compound: whether inter-intra compound may be used
+ * @enable_masked_compound: whether masked compound may be used
+ * @enable_warped_motion: whether warped motion may be used
+ * @enable_dual_filter: whether dual filters may be used
+ * @enable_order_hint: whether order hints are present
+ * @enable_jnt_comp: whether distance weighted compound may be used
+ * @enable_ref_frame_mvs: whether reference frame motion vectors may be used
+ * @seq_choose_screen_content_tools: whether screen content tools are
+ *   signaled in the frame headers
+ * @seq_force_screen_content_tools: screen content tools setting, or
+ *   %GST_AV1_SELECT_SCREEN_CONTENT_TOOLS
+ * @seq_choose_integer_mv: whether integer motion vectors are signaled in the
+ *   frame headers
+ * @seq_force_integer_mv: integer motion vectors setting, or
+ *   %GST_AV1_SELECT_INTEGER_MV
+ * @order_hint_bits_minus_1: number of bits of order hints, minus 1
+ * @order_hint_bits: number of bits of order hints
+ * @enable_superres: whether super resolution may be used
+ * @enable_cdef: whether CDEF filtering may be used
+ * @enable_restoration: whether loop restoration may be used
+ * @color_config: the #GstAV1ColorConfig
+ * @film_grain_params_present: whether film grain parameters are present
+ *
+ * Sequence header OBU.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1SequenceHeaderOBU
+{
+  GstAV1Profile seq_profile;
+  guint8 still_picture;
+  guint8 reduced_still_picture_header;
+
+  guint8 timing_info_present_flag;
+  GstAV1TimingInfo timing_info;
+  guint8 decoder_model_info_present_flag;
+  GstAV1DecoderModelInfo decoder_model_info;
+  guint8 initial_display_delay_present_flag;
+  guint8 operating_points_cnt_minus_1;
+  GstAV1OperatingPoint operating_points[GST_AV1_MAX_OPERATING_POINTS];
+
+  guint8 frame_width_bits_minus_1;
+  guint8 frame_height_bits_minus_1;
+  guint16 max_frame_width_minus_1;
+  guint16 max_frame_height_minus_1;
+  guint8 frame_id_numbers_present_flag;
+  guint8 delta_frame_id_length_minus_2;
+  guint8 additional_frame_id_length_minus_1;
+
+  guint8 use_128x128_superblock;
+  guint8 enable_filter_intra;
+  guint8 enable_intra_edge_filter;
+  guint8 enable_interintra_compound;
+  guint8 enable_masked_compound;
+  guint8 enable_warped_motion;
+  guint8 enable_dual_filter;
+  guint8 enable_order_hint;
+  guint8 enable_jnt_comp;
+  guint8 enable_ref_frame_mvs;
+  guint8 seq_choose_screen_content_tools;
+  guint8 seq_force_screen_content_tools;
+  guint8 seq_choose_integer_mv;
+  guint8 seq_force_integer_mv;
+  guint8 order_hint_bits_minus_1;
+  guint8 order_hint_bits;
+
+  guint8 enable_superres;
+  guint8 enable_cdef;
+  guint8 enable_restoration;
+  GstAV1ColorConfig color_config;
+  guint8 film_grain_params_present;
+};
+
+/**
+ * GstAV1TileInfo:
+ * @uniform_tile_spacing_flag: tiles are uniformly spaced
+ * @tile_cols_log2: base 2 logarithm of @tile_cols, rounded up
+ * @tile_rows_log2: base 2 logarithm of @tile_rows, rounded up
+ * @tile_cols: number of tile columns
+ * @tile_rows: number of tile rows
+ * @mi_col_starts: start column of each tile, in units of 4x4 blocks
+ * @mi_row_starts: start row of each tile, in units of 4x4 blocks
+ * @context_update_tile_id: tile used for the CDF update
+ * @tile_size_bytes_minus_1: size of the tile size fields, minus 1
+ *
+ * Tile info of the frame header.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1TileInfo
+{
+  guint8 uniform_tile_spacing_flag;
+  guint8 tile_cols_log2;
+  guint8 tile_rows_log2;
+  guint8 tile_cols;
+  guint8 tile_rows;
+  guint32 mi_col_starts[GST_AV1_MAX_TILE_COLS + 1];
+  guint32 mi_row_starts[GST_AV1_MAX_TILE_ROWS + 1];
+  guint32 context_update_tile_id;
+  guint8 tile_size_bytes_minus_1;
+};
+
+/**
+ * GstAV1FrameHeaderOBU:
+ * @show_existing_frame: an already decoded frame is shown
+ * @frame_to_show_map_idx: reference slot of the frame to show
+ * @frame_type: the #GstAV1FrameType
+ * @show_frame: the frame is displayed
+ * @showable_frame: the frame may be shown later by a show_existing_frame
+ * @error_resilient_mode: error resilient mode is enabled
+ * @disable_cdf_update: CDF updates are disabled
+ * @allow_screen_content_tools: screen content tools are allowed
+ * @force_integer_mv: motion vectors are integer
+ * @current_frame_id: frame id of the frame
+ * @frame_size_override_flag: frame size is coded in the frame header
+ * @order_hint: order hint of the frame
+ * @primary_ref_frame: reference frame used for the context, or
+ *   %GST_AV1_PRIMARY_REF_NONE
+ * @refresh_frame_flags: reference slots updated with this frame
+ * @ref_order_hint: expected order hints of the reference slots, present in
+ *   error resilient mode
+ * @frame_refs_short_signaling: the reference frames are derived
+ *   from @ref_frame_idx[0] and [3]
+ * @ref_frame_idx: reference slot of each reference frame
+ * @allow_intrabc: intra block copy is allowed
+ * @frame_width: width of the frame before super resolution upscaling
+ * @frame_height: height of the frame
+ * @upscaled_width: width of the frame after super resolution upscaling
+ * @render_width: intended display width
+ * @render_height: intended display height
+ * @use_superres: super resolution is used
+ * @superres_denom: super resolution denominator
+ * @allow_high_precision_mv: motion vectors have 1/8 pel precision
+ * @is_filter_switchable: the interpolation filter is signaled per block
+ * @interpolation_filter: interpolation filter of the frame
+ * @is_motion_mode_switchable: the motion mode may be signaled
+ * @use_ref_frame_mvs: reference frame motion vectors are used
+ * @disable_frame_end_update_cdf: the end of frame CDF update is disabled
+ * @tile_info: the #GstAV1TileInfo
+ *
+ * Uncompressed frame header, up to and including the tile info. Enough to
+ * frame and seek in the stream, the remaining syntax elements are only
+ * needed for decoding.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1FrameHeaderOBU
+{
+  guint8 show_existing_frame;
+  guint8 frame_to_show_map_idx;
+  GstAV1FrameType frame_type;
+  guint8 show_frame;
+  guint8 showable_frame;
+  guint8 error_resilient_mode;
+  guint8 disable_cdf_update;
+  guint8 allow_screen_content_tools;
+  guint8 force_integer_mv;
+  guint32 current_frame_id;
+  guint8 frame_size_override_flag;
+  guint32 order_hint;
+  guint8 primary_ref_frame;
+  guint8 refresh_frame_flags;
+  guint32 ref_order_hint[GST_AV1_NUM_REF_FRAMES];
+  guint8 frame_refs_short_signaling;
+  guint8 ref_frame_idx[GST_AV1_REFS_PER_FRAME];
+  guint8 allow_intrabc;
+
+  guint32 frame_width;
+  guint32 frame_height;
+  guint32 upscaled_width;
+  guint32 render_width;
+  guint32 render_height;
+  guint8 use_superres;
+  guint8 superres_denom;
+
+  guint8 allow_high_precision_mv;
+  guint8 is_filter_switchable;
+  guint8 interpolation_filter;
+  guint8 is_motion_mode_switchable;
+  guint8 use_ref_frame_mvs;
+  guint8 disable_frame_end_update_cdf;
+
+  GstAV1TileInfo tile_info;
+};
+
+/**
+ * GstAV1TileGroupOBU:
+ * @tile_start_and_end_present_flag: @tg_start and @tg_end are coded
+ * @tg_start: index of the first tile of the tile group
+ * @tg_end: index of the last tile of the tile group
+ * @num_tiles: number of tiles of the frame
+ *
+ * Tile group info. The tile data itself is not parsed.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1TileGroupOBU
+{
+  guint8 tile_start_and_end_present_flag;
+  guint32 tg_start;
+  guint32 tg_end;
+  guint32 num_tiles;
+};
+
+/**
+ * GstAV1Parser:
+ * @operating_point: the operating point to decode, OBUs of other layers are
+ *   reported with %GST_AV1_PARSER_DROP
+ * @seq_header: the last parsed sequence header, if @have_seq_header
+ * @have_seq_header: whether a sequence header was parsed
+ *
+ * Parser state, tracking the sequence header, the reference slots and the
+ * frame header of the frame being parsed.
+ *
+ * Since: 1.14
+ */
+struct _GstAV1Parser
+{
+  guint operating_point;
+  GstAV1SequenceHeaderOBU seq_header;
+  gboolean have_seq_header;
+
+  /*< private >*/
+  void *priv;
+};
+
+GST_EXPORT
+GstAV1Parser *     gst_av1_parser_new (void);
+
+GST_EXPORT
+void               gst_av1_parser_free (GstAV1Parser * parser);
+
+GST_EXPORT
+void               gst_av1_parser_reset (GstAV1Parser * parser);
+
+GST_EXPORT
+GstAV1ParserResult gst_av1_parser_identify_one_obu (GstAV1Parser * parser,
+    const guint8 * data, guint32 size, GstAV1OBU * obu, guint32 * consumed);
+
+GST_EXPORT
+GstAV1ParserResult gst_av1_parser_parse_sequence_header_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1SequenceHeaderOBU * seq_header);
+
+GST_EXPORT
+GstAV1ParserResult gst_av1_parser_parse_temporal_delimiter_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu);
+
+GST_EXPORT
+GstAV1ParserResult gst_av1_parser_parse_frame_header_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1FrameHeaderOBU * frame_header);
+
+GST_EXPORT
+GstAV1ParserResult gst_av1_parser_parse_tile_group_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1TileGroupOBU * tile_group);
+
+GST_EXPORT
+GstAV1ParserResult gst_av1_parser_parse_frame_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1FrameHeaderOBU * frame_header,
+    GstAV1TileGroupOBU * tile_group);
+
+GST_EXPORT
+guint32            gst_av1_parser_leb128_size (guint64 value);
+
+GST_EXPORT
+guint32            gst_av1_parser_write_leb128 (guint64 value, guint8 * data);
+
+GST_EXPORT
+GstAV1ParserResult gst_av1_parser_read_leb128 (const guint8 * data,
+    guint32 size, guint64 * value, guint32 * consumed);
+
+G_END_DECLS
+
+#endif /* GST_AV1_PARSER_H */
@@ -2174,6 +2174,160 @@ error:
   return GST_H265_PARSER_ERROR;
 }
 
+typedef struct
+{
+  GstH265Parser *parser;
+  GstH265NalUnit *nalus;
+  GstH265SliceHdr *slices;
+  GstH265ParserResult *results;
+
+  GMutex lock;
+  GCond cond;
+  guint pending;
+} SliceHdrBatch;
+
+typedef struct
+{
+  SliceHdrBatch *batch;
+  guint index;
+} SliceHdrJob;
+
+static void
+parse_slice_hdr_job (SliceHdrBatch * batch, guint i)
+{
+  batch->results[i] = gst_h265_parser_parse_slice_hdr (batch->parser,
+      &batch->nalus[i], &batch->slices[i]);
+}
+
+static void
+slice_hdr_pool_func (gpointer data, gpointer user_data)
+{
+  SliceHdrJob *job = data;
+  SliceHdrBatch *batch = job->batch;
+
+  parse_slice_hdr_job (batch, job->index);
+
+  g_mutex_lock (&batch->lock);
+  if (--batch->pending == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->lock);
+}
+
+static GThreadPool *
+get_slice_hdr_pool (void)
+{
+  static gsize pool = 0;
+
+  if (g_once_init_enter (&pool)) {
+    GThreadPool *p;
+
+    p = g_thread_pool_new (slice_hdr_pool_func, NULL,
+        MAX (g_get_num_processors () - 1, 1), FALSE, NULL);
+    g_once_init_leave (&pool, (gsize) p);
+  }
+
+  return (GThreadPool *) pool;
+}
+
+/**
+ * gst_h265_parser_parse_slice_hdrs:
+ * @parser: a #GstH265Parser
+ * @nalus: (array length=n_nalus): the slice #GstH265NalUnit of an access unit,
+ *   in decoding order
+ * @n_nalus: the number of entries in @nalus
+ * @slices: (array length=n_nalus) (out caller-allocates): the
+ *   #GstH265SliceHdr to fill, one per entry of @nalus
+ * @results: (array length=n_nalus) (out caller-allocates) (allow-none): the
+ *   #GstH265ParserResult of each slice header, or %NULL
+ *
+ * Parses the headers of all the slice segments of an access unit, as
+ * gst_h265_parser_parse_slice_hdr() would for each of them, but spreads
+ * the work over a shared thread pool. @slices and @results are filled in
+ * the order of @nalus.
+ *
+ * The parameter sets referenced by the slices must have been parsed
+ * beforehand, and @parser must not be modified until this function
+ * returns. Headers of dependent slice segments only carry the fields
+ * that are coded for them; the others have to be taken from the
+ * preceding independent slice segment, as with
+ * gst_h265_parser_parse_slice_hdr().
+ *
+ * Every entry of @slices shall be deallocated with
+ * gst_h265_slice_hdr_free() when it is no longer needed.
+ *
+ * Returns: %GST_H265_PARSER_OK if all slice headers were parsed, otherwise
+ *   the first failing #GstH265ParserResult in decoding order
+ *
+ * Since: 1.14
+ */
+GstH265ParserResult
+gst_h265_parser_parse_slice_hdrs (GstH265Parser * parser,
+    GstH265NalUnit * nalus, guint n_nalus, GstH265SliceHdr * slices,
+    GstH265ParserResult * results)
+{
+  SliceHdrBatch batch;
+  SliceHdrJob *jobs = NULL;
+  GThreadPool *pool = NULL;
+  GstH265ParserResult res = GST_H265_PARSER_OK;
+  guint i, pushed = 0;
+
+  g_return_val_if_fail (parser != NULL, GST_H265_PARSER_ERROR);
+  g_return_val_if_fail (n_nalus == 0 || nalus != NULL, GST_H265_PARSER_ERROR);
+  g_return_val_if_fail (n_nalus == 0 || slices != NULL, GST_H265_PARSER_ERROR);
+
+  batch.parser = parser;
+  batch.nalus = nalus;
+  batch.slices = slices;
+  batch.results = results ? results : g_newa (GstH265ParserResult, n_nalus);
+  g_mutex_init (&batch.lock);
+  g_cond_init (&batch.cond);
+  batch.pending = 0;
+
+  /* parsing only reads from the parser, so the slice headers are
+   * independent of each other; the first one is parsed on this thread */
+  if (n_nalus > 1) {
+    pool = get_slice_hdr_pool ();
+    jobs = g_new (SliceHdrJob, n_nalus - 1);
+    batch.pending = n_nalus - 1;
+  }
+
+  for (i = 1; i < n_nalus && pool; i++) {
+    jobs[i - 1].batch = &batch;
+    jobs[i - 1].index = i;
+    if (!g_thread_pool_push (pool, &jobs[i - 1], NULL))
+      break;
+    pushed++;
+  }
+
+  if (n_nalus > 0)
+    parse_slice_hdr_job (&batch, 0);
+
+  /* whatever could not be queued is parsed here as well */
+  for (i = pushed + 1; i < n_nalus; i++)
+    parse_slice_hdr_job (&batch, i);
+
+  if (pushed > 0) {
+    g_mutex_lock (&batch.lock);
+    batch.pending -= (n_nalus - 1) - pushed;
+    while (batch.pending > 0)
+      g_cond_wait (&batch.cond, &batch.lock);
+    g_mutex_unlock (&batch.lock);
+  }
+
+  g_free (jobs);
+  g_mutex_clear (&batch.lock);
+  g_cond_clear (&batch.cond);
+
+  for (i = 0; i < n_nalus; i++) {
+    if (batch.results[i] != GST_H265_PARSER_OK) {
+      res = batch.results[i];
+      break;
+    }
+  }
+
+  return res;
+}
+
 static gboolean
 nal_reader_has_more_data_in_payload (NalReader * nr,
     guint32 payload_start_pos_bit, guint32 payloadSize)
@@ -155,6 +155,7 @@ typedef enum
  * GstH265SEIPayloadType:
  * @GST_H265_SEI_BUF_PERIOD: Buffering Period SEI Message
  * @GST_H265_SEI_PIC_TIMING: Picture Timing SEI Message
+ * @GST_H265_SEI_TIME_CODE: Time code SEI message (Since: 1.14)
  * ...
  *
  * The type of SEI message.
@@ -162,7 +163,8 @@ typedef enum
 typedef enum
 {
   GST_H265_SEI_BUF_PERIOD = 0,
-  GST_H265_SEI_PIC_TIMING = 1
+  GST_H265_SEI_PIC_TIMING = 1,
+  GST_H265_SEI_TIME_CODE = 136
       /* and more...  */
 } GstH265SEIPayloadType;
 
@@ -1031,6 +1033,13 @@ GstH265ParserResult gst_h265_parser_parse_slice_hdr (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
                                                      GstH265SliceHdr * slice);
 
+GST_EXPORT
+GstH265ParserResult gst_h265_parser_parse_slice_hdrs (GstH265Parser       * parser,
+                                                      GstH265NalUnit      * nalus,
+                                                      guint                 n_nalus,
+                                                      GstH265SliceHdr     * slices,
+                                                      GstH265ParserResult * results);
+
 GST_EXPORT
 GstH265ParserResult gst_h265_parser_parse_vps       (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
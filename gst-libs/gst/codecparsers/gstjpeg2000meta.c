@@ -0,0 +1,141 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstjpeg2000meta.h"
+
+static gboolean
+gst_jpeg2000_tile_part_meta_init (GstJPEG2000TilePartMeta * meta,
+    gpointer params, GstBuffer * buffer)
+{
+  meta->codestream_offset = 0;
+  meta->main_header_size = 0;
+  meta->num_tile_parts = 0;
+  meta->tile_parts = NULL;
+
+  return TRUE;
+}
+
+static void
+gst_jpeg2000_tile_part_meta_free (GstJPEG2000TilePartMeta * meta,
+    GstBuffer * buffer)
+{
+  g_free (meta->tile_parts);
+}
+
+static gboolean
+gst_jpeg2000_tile_part_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstJPEG2000TilePartMeta *smeta, *dmeta;
+
+  smeta = (GstJPEG2000TilePartMeta *) meta;
+
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    GstMetaTransformCopy *copy = data;
+
+    if (!copy->region) {
+      /* only copy if the complete data is copied as well */
+      dmeta = (GstJPEG2000TilePartMeta *) gst_buffer_add_meta (dest,
+          GST_JPEG2000_TILE_PART_META_INFO, NULL);
+      if (!dmeta)
+        return FALSE;
+
+      dmeta->codestream_offset = smeta->codestream_offset;
+      dmeta->main_header_size = smeta->main_header_size;
+      dmeta->num_tile_parts = smeta->num_tile_parts;
+      dmeta->tile_parts = g_memdup (smeta->tile_parts,
+          smeta->num_tile_parts * sizeof (GstJPEG2000TilePart));
+    }
+  } else {
+    /* return FALSE, if transform type is not supported */
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+GType
+gst_jpeg2000_tile_part_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { "memory", NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type =
+        gst_meta_api_type_register ("GstJPEG2000TilePartMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo *
+gst_jpeg2000_tile_part_meta_get_info (void)
+{
+  static const GstMetaInfo *tile_part_meta_info = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) & tile_part_meta_info)) {
+    const GstMetaInfo *meta =
+        gst_meta_register (GST_JPEG2000_TILE_PART_META_API_TYPE,
+        "GstJPEG2000TilePartMeta", sizeof (GstJPEG2000TilePartMeta),
+        (GstMetaInitFunction) gst_jpeg2000_tile_part_meta_init,
+        (GstMetaFreeFunction) gst_jpeg2000_tile_part_meta_free,
+        (GstMetaTransformFunction) gst_jpeg2000_tile_part_meta_transform);
+    g_once_init_leave ((GstMetaInfo **) & tile_part_meta_info,
+        (GstMetaInfo *) meta);
+  }
+
+  return tile_part_meta_info;
+}
+
+/**
+ * gst_buffer_add_jpeg2000_tile_part_meta:
+ * @buffer: a #GstBuffer
+ * @codestream_offset: offset of the code stream in @buffer
+ * @codestream: the #GstJPEG2000Codestream parsed from @buffer
+ *
+ * Creates and adds a #GstJPEG2000TilePartMeta indexing the tile-parts of
+ * @codestream to a @buffer. The tile-parts are copied.
+ *
+ * Returns: (transfer none): a newly created #GstJPEG2000TilePartMeta
+ *
+ * Since: 1.14
+ */
+GstJPEG2000TilePartMeta *
+gst_buffer_add_jpeg2000_tile_part_meta (GstBuffer * buffer,
+    guint codestream_offset, const GstJPEG2000Codestream * codestream)
+{
+  GstJPEG2000TilePartMeta *meta;
+
+  g_return_val_if_fail (codestream != NULL, NULL);
+  g_return_val_if_fail (codestream->tile_parts != NULL, NULL);
+
+  meta = (GstJPEG2000TilePartMeta *) gst_buffer_add_meta (buffer,
+      GST_JPEG2000_TILE_PART_META_INFO, NULL);
+
+  meta->codestream_offset = codestream_offset;
+  meta->main_header_size = codestream->main_header_size;
+  meta->num_tile_parts = codestream->tile_parts->len;
+  meta->tile_parts = g_memdup (codestream->tile_parts->data,
+      codestream->tile_parts->len * sizeof (GstJPEG2000TilePart));
+
+  return meta;
+}
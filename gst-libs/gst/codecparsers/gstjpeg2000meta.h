@@ -0,0 +1,77 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_JPEG2000_META_H__
+#define __GST_JPEG2000_META_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The JPEG 2000 parsing library is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+#include <gst/codecparsers/gstjpeg2000parser.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstJPEG2000TilePartMeta GstJPEG2000TilePartMeta;
+
+GST_EXPORT
+GType gst_jpeg2000_tile_part_meta_api_get_type (void);
+#define GST_JPEG2000_TILE_PART_META_API_TYPE  (gst_jpeg2000_tile_part_meta_api_get_type())
+#define GST_JPEG2000_TILE_PART_META_INFO  (gst_jpeg2000_tile_part_meta_get_info())
+GST_EXPORT
+const GstMetaInfo * gst_jpeg2000_tile_part_meta_get_info (void);
+
+/**
+ * GstJPEG2000TilePartMeta:
+ * @meta: parent #GstMeta
+ * @codestream_offset: offset of the SOC marker in the buffer
+ * @main_header_size: size of the main header of the code stream
+ * @num_tile_parts: number of entries in @tile_parts
+ * @tile_parts: the tile-parts of the code stream, their offsets are
+ *   relative to the SOC marker
+ *
+ * Extra buffer metadata indexing the tile-parts of a JPEG 2000 code stream.
+ *
+ * Can be used by elements (mainly decoders) to hand the tiles of a
+ * picture to several threads without having to parse the code stream
+ * first.
+ *
+ * Since: 1.14
+ */
+struct _GstJPEG2000TilePartMeta {
+  GstMeta meta;
+
+  guint codestream_offset;
+  guint32 main_header_size;
+  guint num_tile_parts;
+  GstJPEG2000TilePart *tile_parts;
+};
+
+#define gst_buffer_get_jpeg2000_tile_part_meta(b) ((GstJPEG2000TilePartMeta*)gst_buffer_get_meta((b),GST_JPEG2000_TILE_PART_META_API_TYPE))
+
+GST_EXPORT
+GstJPEG2000TilePartMeta *
+gst_buffer_add_jpeg2000_tile_part_meta (GstBuffer * buffer,
+                                        guint codestream_offset,
+                                        const GstJPEG2000Codestream * codestream);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,210 @@
+/* gstjpeg2000parser.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstjpeg2000parser
+ * @title: GstJPEG2000Parser
+ * @short_description: Convenience library for JPEG 2000 code stream parsing.
+ *
+ * Provides the layout of a JPEG 2000 code stream, i.e. its size and the
+ * location of its tile-parts. The tile-parts are found by following the
+ * Psot lengths of their SOT marker segments, so the entropy coded data is
+ * not scanned.
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstjpeg2000parser.h"
+
+#include <gst/base/gstbytereader.h>
+#include <string.h>
+
+#ifndef GST_DISABLE_GST_DEBUG
+#define GST_CAT_DEFAULT ensure_debug_category()
+static GstDebugCategory *
+ensure_debug_category (void)
+{
+  static gsize cat_gonce = 0;
+
+  if (g_once_init_enter (&cat_gonce)) {
+    gsize cat_done;
+
+    cat_done = (gsize) _gst_debug_category_new ("codecparsers_jpeg2000", 0,
+        "JPEG 2000 codec parsing library");
+
+    g_once_init_leave (&cat_gonce, cat_done);
+  }
+
+  return (GstDebugCategory *) cat_gonce;
+}
+#else
+#define ensure_debug_category()
+#endif /* GST_DISABLE_GST_DEBUG */
+
+/* SOT marker segment: SOT, Lsot, Isot, Psot, TPsot, TNsot */
+#define SOT_SEGMENT_SIZE 12
+
+/**
+ * gst_jpeg2000_parser_parse_codestream:
+ * @data: the data to parse, starting with the SOC marker
+ * @size: the size of @data
+ * @codestream: (out): the #GstJPEG2000Codestream to fill
+ *
+ * Finds the end of the code stream starting at @data and the tile-parts it
+ * is made of. Only the marker segment headers are read: the main header
+ * segments and tile-parts are skipped over as a whole using their lengths.
+ * Only a last tile-part that does not signal its length (Psot is 0) is
+ * scanned for the EOC marker.
+ *
+ * Returns: a #GstJPEG2000ParserResult, with %GST_JPEG2000_PARSER_NO_MORE_DATA
+ * if @data ends before the EOC marker
+ *
+ * Since: 1.14
+ */
+GstJPEG2000ParserResult
+gst_jpeg2000_parser_parse_codestream (const guint8 * data, gsize size,
+    GstJPEG2000Codestream * codestream)
+{
+  GstByteReader br;
+  GstJPEG2000TilePart tile_part;
+  guint16 marker, length;
+  guint32 psot;
+  gint eoc_offset;
+
+  g_return_val_if_fail (data != NULL, GST_JPEG2000_PARSER_ERROR);
+  g_return_val_if_fail (codestream != NULL, GST_JPEG2000_PARSER_ERROR);
+
+  if (codestream->tile_parts)
+    g_array_set_size (codestream->tile_parts, 0);
+  else
+    codestream->tile_parts =
+        g_array_new (FALSE, FALSE, sizeof (GstJPEG2000TilePart));
+  codestream->main_header_size = 0;
+  codestream->size = 0;
+
+  gst_byte_reader_init (&br, data, size);
+
+  if (!gst_byte_reader_get_uint16_be (&br, &marker))
+    return GST_JPEG2000_PARSER_NO_MORE_DATA;
+  if (marker != GST_JPEG2000_MARKER_SOC) {
+    GST_DEBUG ("no SOC marker");
+    return GST_JPEG2000_PARSER_BROKEN_DATA;
+  }
+
+  /* main header, marker segments up to the first SOT */
+  while (TRUE) {
+    if (!gst_byte_reader_peek_uint16_be (&br, &marker))
+      return GST_JPEG2000_PARSER_NO_MORE_DATA;
+    if (marker == GST_JPEG2000_MARKER_SOT)
+      break;
+    gst_byte_reader_skip_unchecked (&br, 2);
+    if ((marker & 0xff00) != 0xff00) {
+      GST_DEBUG ("invalid marker 0x%04x in main header", marker);
+      return GST_JPEG2000_PARSER_BROKEN_DATA;
+    }
+    if (!gst_byte_reader_get_uint16_be (&br, &length))
+      return GST_JPEG2000_PARSER_NO_MORE_DATA;
+    if (length < 2) {
+      GST_DEBUG ("invalid length %u of marker 0x%04x", length, marker);
+      return GST_JPEG2000_PARSER_BROKEN_DATA;
+    }
+    if (!gst_byte_reader_skip (&br, length - 2))
+      return GST_JPEG2000_PARSER_NO_MORE_DATA;
+  }
+  codestream->main_header_size = gst_byte_reader_get_pos (&br);
+
+  /* tile-parts, jumping from one SOT to the next */
+  while (TRUE) {
+    if (!gst_byte_reader_peek_uint16_be (&br, &marker))
+      return GST_JPEG2000_PARSER_NO_MORE_DATA;
+    if (marker == GST_JPEG2000_MARKER_EOC)
+      break;
+    if (marker != GST_JPEG2000_MARKER_SOT) {
+      GST_DEBUG ("expected SOT marker, got 0x%04x", marker);
+      return GST_JPEG2000_PARSER_BROKEN_DATA;
+    }
+
+    tile_part.offset = gst_byte_reader_get_pos (&br);
+    if (gst_byte_reader_get_remaining (&br) < SOT_SEGMENT_SIZE)
+      return GST_JPEG2000_PARSER_NO_MORE_DATA;
+    gst_byte_reader_skip_unchecked (&br, 2);
+    length = gst_byte_reader_get_uint16_be_unchecked (&br);
+    if (length != SOT_SEGMENT_SIZE - 2) {
+      GST_DEBUG ("invalid SOT length %u", length);
+      return GST_JPEG2000_PARSER_BROKEN_DATA;
+    }
+    tile_part.tile_index = gst_byte_reader_get_uint16_be_unchecked (&br);
+    psot = gst_byte_reader_get_uint32_be_unchecked (&br);
+    tile_part.part_index = gst_byte_reader_get_uint8_unchecked (&br);
+    tile_part.num_parts = gst_byte_reader_get_uint8_unchecked (&br);
+
+    if (psot == 0) {
+      /* the last tile-part of the code stream may run up to the EOC */
+      eoc_offset = gst_byte_reader_masked_scan_uint32 (&br, 0x0000ffff,
+          GST_JPEG2000_MARKER_EOC, 0, gst_byte_reader_get_remaining (&br));
+      if (eoc_offset == -1)
+        return GST_JPEG2000_PARSER_NO_MORE_DATA;
+      psot = gst_byte_reader_get_pos (&br) + eoc_offset + 2 - tile_part.offset;
+    } else if (psot < SOT_SEGMENT_SIZE + 2) {
+      GST_DEBUG ("invalid tile-part length %u", psot);
+      return GST_JPEG2000_PARSER_BROKEN_DATA;
+    }
+    tile_part.size = psot;
+
+    GST_LOG ("tile %u part %u/%u at offset %u, size %u", tile_part.tile_index,
+        tile_part.part_index, tile_part.num_parts, tile_part.offset,
+        tile_part.size);
+    g_array_append_val (codestream->tile_parts, tile_part);
+
+    if (tile_part.offset + (guint64) psot > size)
+      return GST_JPEG2000_PARSER_NO_MORE_DATA;
+    gst_byte_reader_set_pos (&br, tile_part.offset + psot);
+  }
+
+  if (codestream->tile_parts->len == 0) {
+    GST_DEBUG ("code stream without tile-parts");
+    return GST_JPEG2000_PARSER_BROKEN_DATA;
+  }
+
+  codestream->size = gst_byte_reader_get_pos (&br) + 2;
+
+  return GST_JPEG2000_PARSER_OK;
+}
+
+/**
+ * gst_jpeg2000_codestream_clear:
+ * @codestream: a #GstJPEG2000Codestream
+ *
+ * Frees the resources allocated by gst_jpeg2000_parser_parse_codestream().
+ * @codestream can be reused afterwards.
+ *
+ * Since: 1.14
+ */
+void
+gst_jpeg2000_codestream_clear (GstJPEG2000Codestream * codestream)
+{
+  g_return_if_fail (codestream != NULL);
+
+  if (codestream->tile_parts)
+    g_array_free (codestream->tile_parts, TRUE);
+  memset (codestream, 0, sizeof (GstJPEG2000Codestream));
+}
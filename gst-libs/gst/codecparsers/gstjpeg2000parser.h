@@ -0,0 +1,141 @@
+/* gstjpeg2000parser.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_JPEG2000_PARSER_H__
+#define __GST_JPEG2000_PARSER_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The JPEG 2000 parsing library is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GST_JPEG2000_MARKER_SOC:
+ *
+ * Start of code stream marker
+ *
+ * Since: 1.14
+ */
+#define GST_JPEG2000_MARKER_SOC 0xff4f
+
+/**
+ * GST_JPEG2000_MARKER_SOT:
+ *
+ * Start of tile-part marker
+ *
+ * Since: 1.14
+ */
+#define GST_JPEG2000_MARKER_SOT 0xff90
+
+/**
+ * GST_JPEG2000_MARKER_SOD:
+ *
+ * Start of data marker, ending a tile-part header
+ *
+ * Since: 1.14
+ */
+#define GST_JPEG2000_MARKER_SOD 0xff93
+
+/**
+ * GST_JPEG2000_MARKER_EOC:
+ *
+ * End of code stream marker
+ *
+ * Since: 1.14
+ */
+#define GST_JPEG2000_MARKER_EOC 0xffd9
+
+typedef struct _GstJPEG2000TilePart   GstJPEG2000TilePart;
+typedef struct _GstJPEG2000Codestream GstJPEG2000Codestream;
+
+/**
+ * GstJPEG2000ParserResult:
+ * @GST_JPEG2000_PARSER_OK: The parsing went well
+ * @GST_JPEG2000_PARSER_BROKEN_DATA: The data to parse is broken
+ * @GST_JPEG2000_PARSER_NO_MORE_DATA: The code stream is not complete in the
+ *   data
+ * @GST_JPEG2000_PARSER_ERROR: An error occured during the parsing
+ *
+ * Result type of any parsing function.
+ *
+ * Since: 1.14
+ */
+typedef enum
+{
+  GST_JPEG2000_PARSER_OK,
+  GST_JPEG2000_PARSER_BROKEN_DATA,
+  GST_JPEG2000_PARSER_NO_MORE_DATA,
+  GST_JPEG2000_PARSER_ERROR
+} GstJPEG2000ParserResult;
+
+/**
+ * GstJPEG2000TilePart:
+ * @tile_index: index of the tile the tile-part belongs to (Isot)
+ * @part_index: index of the tile-part within its tile (TPsot)
+ * @num_parts: number of tile-parts of the tile, 0 if not signalled (TNsot)
+ * @offset: offset of the SOT marker, from the SOC marker
+ * @size: size of the tile-part, SOT marker included (Psot)
+ *
+ * Location of a tile-part in a code stream.
+ *
+ * Since: 1.14
+ */
+struct _GstJPEG2000TilePart
+{
+  guint16 tile_index;
+  guint8 part_index;
+  guint8 num_parts;
+  guint32 offset;
+  guint32 size;
+};
+
+/**
+ * GstJPEG2000Codestream:
+ * @main_header_size: size of the main header, from the SOC marker to the
+ *   first SOT marker
+ * @size: size of the code stream, SOC and EOC markers included
+ * @tile_parts: (element-type GstJPEG2000TilePart): the tile-parts, in code
+ *   stream order
+ *
+ * Layout of a JPEG 2000 code stream (ISO/IEC 15444-1 Annex A). Must be
+ * zero-initialized before its first use, and released with
+ * gst_jpeg2000_codestream_clear().
+ *
+ * Since: 1.14
+ */
+struct _GstJPEG2000Codestream
+{
+  guint32 main_header_size;
+  guint32 size;
+  GArray *tile_parts;
+};
+
+GST_EXPORT
+GstJPEG2000ParserResult gst_jpeg2000_parser_parse_codestream (const guint8 * data,
+    gsize size, GstJPEG2000Codestream * codestream);
+
+GST_EXPORT
+void gst_jpeg2000_codestream_clear (GstJPEG2000Codestream * codestream);
+
+G_END_DECLS
+
+#endif /* __GST_JPEG2000_PARSER_H__ */
@@ -42,6 +42,10 @@
 #define MIN_TILE_WIDTH_B64 4
 #define MAX_TILE_WIDTH_B64 64
 
+/* the longest beginning of an uncompressed header read by
+ * gst_vp9_parser_parse_frame_header_fast(), for an intra-only frame */
+#define VP9_MAX_HEADER_PREFIX_SIZE 15
+
 /* order of sb64, where sb64 = 64x64 */
 #define ALIGN_SB64(w) ((w + 63) >> 6)
 
@@ -609,6 +613,98 @@ gst_vp9_parser_update (GstVp9Parser * parser, GstVp9FrameHdr * const frame_hdr)
   return GST_VP9_PARSER_OK;
 }
 
+/* parses the uncompressed header up to the frame size, which is all that is
+ * needed to split and describe a stream */
+static gboolean
+parse_frame_header_prefix (GstVp9Parser * parser, GstBitReader * br,
+    GstVp9FrameHdr * frame_hdr)
+{
+  if (!verify_frame_marker (br))
+    goto error;
+
+  frame_hdr->profile = parse_profile (br);
+  if (frame_hdr->profile > GST_VP9_PROFILE_UNDEFINED) {
+    GST_ERROR ("Stream has undefined VP9  profile !");
+    goto error;
+  }
+
+  frame_hdr->show_existing_frame = gst_vp9_read_bit (br);
+  if (frame_hdr->show_existing_frame) {
+    frame_hdr->frame_to_show = gst_vp9_read_bits (br, GST_VP9_REF_FRAMES_LOG2);
+    return TRUE;
+  }
+
+  frame_hdr->frame_type = gst_vp9_read_bit (br);
+  frame_hdr->show_frame = gst_vp9_read_bit (br);
+  frame_hdr->error_resilient_mode = gst_vp9_read_bit (br);
+
+  if (frame_hdr->frame_type == GST_VP9_KEY_FRAME) {
+
+    if (!verify_sync_code (br)) {
+      GST_ERROR ("Invalid VP9 Key-frame sync code !");
+      goto error;
+    }
+
+    if (!parse_bitdepth_colorspace_sampling (parser, br, frame_hdr)) {
+      GST_ERROR ("Failed to parse color_space/bit_depth info !");
+      goto error;
+    }
+
+    parse_frame_size (br, &frame_hdr->width, &frame_hdr->height);
+
+    parse_display_frame_size (br, frame_hdr);
+
+  } else {
+    frame_hdr->intra_only = frame_hdr->show_frame ? 0 : gst_vp9_read_bit (br);
+    frame_hdr->reset_frame_context = frame_hdr->error_resilient_mode ?
+        0 : gst_vp9_read_bits (br, 2);
+
+    if (frame_hdr->intra_only) {
+
+      if (!verify_sync_code (br)) {
+        GST_ERROR ("Invalid VP9 sync code in intra-only frame !");
+        goto error;
+      }
+
+      if (frame_hdr->profile > GST_VP9_PROFILE_0) {
+        if (!parse_bitdepth_colorspace_sampling (parser, br, frame_hdr)) {
+          GST_ERROR ("Failed to parse color_space/bit_depth info !");
+          goto error;
+        }
+      } else {
+        parser->color_space = GST_VP9_CS_BT_601;
+        parser->color_range = GST_VP9_CR_LIMITED;
+        parser->subsampling_y = parser->subsampling_x = 1;
+        parser->bit_depth = GST_VP9_BIT_DEPTH_8;
+      }
+
+      frame_hdr->refresh_frame_flags =
+          gst_vp9_read_bits (br, GST_VP9_REF_FRAMES);
+      parse_frame_size (br, &frame_hdr->width, &frame_hdr->height);
+      parse_display_frame_size (br, frame_hdr);
+
+    } else {
+      int i;
+      frame_hdr->refresh_frame_flags =
+          gst_vp9_read_bits (br, GST_VP9_REF_FRAMES);
+
+      for (i = 0; i < GST_VP9_REFS_PER_FRAME; i++) {
+        frame_hdr->ref_frame_indices[i] =
+            gst_vp9_read_bits (br, GST_VP9_REF_FRAMES_LOG2);
+        frame_hdr->ref_frame_sign_bias[i] = gst_vp9_read_bit (br);
+      }
+
+      parse_frame_size_from_refs (parser, frame_hdr, br);
+      parse_display_frame_size (br, frame_hdr);
+    }
+  }
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
 
 /******** API *************/
 
@@ -690,87 +786,15 @@ gst_vp9_parser_parse_frame_header (GstVp9Parser * parser,
 
   /* Parsing Uncompressed Data Chunk */
 
-  if (!verify_frame_marker (br))
-    goto error;
-
-  frame_hdr->profile = parse_profile (br);
-  if (frame_hdr->profile > GST_VP9_PROFILE_UNDEFINED) {
-    GST_ERROR ("Stream has undefined VP9  profile !");
+  if (!parse_frame_header_prefix (parser, br, frame_hdr))
     goto error;
-  }
 
-  frame_hdr->show_existing_frame = gst_vp9_read_bit (br);
-  if (frame_hdr->show_existing_frame) {
-    frame_hdr->frame_to_show = gst_vp9_read_bits (br, GST_VP9_REF_FRAMES_LOG2);
+  if (frame_hdr->show_existing_frame)
     return GST_VP9_PARSER_OK;
-  }
-
-  frame_hdr->frame_type = gst_vp9_read_bit (br);
-  frame_hdr->show_frame = gst_vp9_read_bit (br);
-  frame_hdr->error_resilient_mode = gst_vp9_read_bit (br);
-
-  if (frame_hdr->frame_type == GST_VP9_KEY_FRAME) {
-
-    if (!verify_sync_code (br)) {
-      GST_ERROR ("Invalid VP9 Key-frame sync code !");
-      goto error;
-    }
-
-    if (!parse_bitdepth_colorspace_sampling (parser, br, frame_hdr)) {
-      GST_ERROR ("Failed to parse color_space/bit_depth info !");
-      goto error;
-    }
-
-    parse_frame_size (br, &frame_hdr->width, &frame_hdr->height);
-
-    parse_display_frame_size (br, frame_hdr);
-
-  } else {
-    frame_hdr->intra_only = frame_hdr->show_frame ? 0 : gst_vp9_read_bit (br);
-    frame_hdr->reset_frame_context = frame_hdr->error_resilient_mode ?
-        0 : gst_vp9_read_bits (br, 2);
-
-    if (frame_hdr->intra_only) {
-
-      if (!verify_sync_code (br)) {
-        GST_ERROR ("Invalid VP9 sync code in intra-only frame !");
-        goto error;
-      }
-
-      if (frame_hdr->profile > GST_VP9_PROFILE_0) {
-        if (!parse_bitdepth_colorspace_sampling (parser, br, frame_hdr)) {
-          GST_ERROR ("Failed to parse color_space/bit_depth info !");
-          goto error;
-        }
-      } else {
-        parser->color_space = GST_VP9_CS_BT_601;
-        parser->color_range = GST_VP9_CR_LIMITED;
-        parser->subsampling_y = parser->subsampling_x = 1;
-        parser->bit_depth = GST_VP9_BIT_DEPTH_8;
-      }
 
-      frame_hdr->refresh_frame_flags =
-          gst_vp9_read_bits (br, GST_VP9_REF_FRAMES);
-      parse_frame_size (br, &frame_hdr->width, &frame_hdr->height);
-      parse_display_frame_size (br, frame_hdr);
-
-    } else {
-      int i;
-      frame_hdr->refresh_frame_flags =
-          gst_vp9_read_bits (br, GST_VP9_REF_FRAMES);
-
-      for (i = 0; i < GST_VP9_REFS_PER_FRAME; i++) {
-        frame_hdr->ref_frame_indices[i] =
-            gst_vp9_read_bits (br, GST_VP9_REF_FRAMES_LOG2);
-        frame_hdr->ref_frame_sign_bias[i] = gst_vp9_read_bit (br);
-      }
-
-      parse_frame_size_from_refs (parser, frame_hdr, br);
-      parse_display_frame_size (br, frame_hdr);
-
-      frame_hdr->allow_high_precision_mv = gst_vp9_read_bit (br);
-      frame_hdr->mcomp_filter_type = parse_interp_filter (br);
-    }
+  if (!frame_is_intra_only (frame_hdr)) {
+    frame_hdr->allow_high_precision_mv = gst_vp9_read_bit (br);
+    frame_hdr->mcomp_filter_type = parse_interp_filter (br);
   }
 
   frame_hdr->refresh_frame_context =
@@ -814,3 +838,139 @@ gst_vp9_parser_parse_frame_header (GstVp9Parser * parser,
 error:
   return GST_VP9_PARSER_ERROR;
 }
+
+/**
+ * gst_vp9_parser_parse_frame_header_fast:
+ * @parser: The #GstVp9Parser
+ * @frame_hdr: The #GstVp9FrameHdr to fill
+ * @data: The data to parse
+ * @size: The size of the @data to parse
+ *
+ * Parses the beginning of the uncompressed header of the VP9 frame in
+ * @data, up to and including the frame size. Only the frame type, the
+ * show flags, the profile, the reference indices, the refresh flags and
+ * the frame and display sizes of @frame_hdr are filled in, and the color
+ * information of @parser is updated. This is enough to split and describe
+ * a stream without the loop filter, quantization and segmentation state
+ * kept by gst_vp9_parser_parse_frame_header().
+ *
+ * The reference frame sizes are kept up to date, so that the sizes of
+ * inter frames can be found. For key frames the refresh flags are set to
+ * all references.
+ *
+ * Returns: a #GstVp9ParserResult
+ *
+ * Since: 1.14
+ */
+GstVp9ParserResult
+gst_vp9_parser_parse_frame_header_fast (GstVp9Parser * parser,
+    GstVp9FrameHdr * frame_hdr, const guint8 * data, gsize size)
+{
+  GstBitReader bit_reader;
+  GstBitReader *br = &bit_reader;
+  guint8 padded[VP9_MAX_HEADER_PREFIX_SIZE] = { 0, };
+
+  g_return_val_if_fail (parser != NULL, GST_VP9_PARSER_ERROR);
+  g_return_val_if_fail (frame_hdr != NULL, GST_VP9_PARSER_ERROR);
+
+  /* the reads are unchecked, so short frames are padded to the longest
+   * possible prefix and the position is checked afterwards */
+  if (size < sizeof (padded)) {
+    memcpy (padded, data, size);
+    gst_bit_reader_init (br, padded, sizeof (padded));
+  } else {
+    gst_bit_reader_init (br, data, size);
+  }
+  memset (frame_hdr, 0, sizeof (*frame_hdr));
+
+  if (!parse_frame_header_prefix (parser, br, frame_hdr))
+    return GST_VP9_PARSER_ERROR;
+
+  if (gst_bit_reader_get_pos (br) > size * 8) {
+    GST_WARNING ("frame too short for its header");
+    return GST_VP9_PARSER_BROKEN_DATA;
+  }
+
+  if (frame_hdr->show_existing_frame)
+    return GST_VP9_PARSER_OK;
+
+  if (frame_hdr->frame_type == GST_VP9_KEY_FRAME)
+    frame_hdr->refresh_frame_flags = 0xff;
+
+  reference_update (parser, frame_hdr);
+
+  return GST_VP9_PARSER_OK;
+}
+
+/**
+ * gst_vp9_parser_parse_superframe_info:
+ * @parser: The #GstVp9Parser
+ * @superframe_info: The #GstVp9SuperframeInfo to fill
+ * @data: The data to parse
+ * @size: The size of the @data to parse
+ *
+ * Parses the superframe index at the end of @data, if any, and fills in
+ * @superframe_info with the sizes of the frames it contains. Data without
+ * an index is reported as a single frame of @size bytes.
+ *
+ * Returns: a #GstVp9ParserResult
+ *
+ * Since: 1.14
+ */
+GstVp9ParserResult
+gst_vp9_parser_parse_superframe_info (GstVp9Parser * parser,
+    GstVp9SuperframeInfo * superframe_info, const guint8 * data, gsize size)
+{
+  guint8 marker;
+  guint32 bytes, frames, index_size, total = 0;
+  const guint8 *index;
+  guint i, j;
+
+  g_return_val_if_fail (parser != NULL, GST_VP9_PARSER_ERROR);
+  g_return_val_if_fail (superframe_info != NULL, GST_VP9_PARSER_ERROR);
+
+  memset (superframe_info, 0, sizeof (*superframe_info));
+
+  if (size == 0)
+    return GST_VP9_PARSER_BROKEN_DATA;
+
+  superframe_info->frames_in_superframe = 1;
+  superframe_info->frame_sizes[0] = size;
+
+  marker = data[size - 1];
+  if ((marker & 0xe0) != 0xc0)
+    return GST_VP9_PARSER_OK;
+
+  bytes = ((marker >> 3) & 0x3) + 1;
+  frames = (marker & 0x7) + 1;
+  index_size = 2 + bytes * frames;
+
+  /* the index starts and ends with the same marker byte */
+  if (size < index_size || data[size - index_size] != marker)
+    return GST_VP9_PARSER_OK;
+
+  index = data + size - index_size + 1;
+  for (i = 0; i < frames; i++) {
+    guint32 frame_size = 0;
+
+    for (j = 0; j < bytes; j++)
+      frame_size |= (guint32) (*index++) << (j * 8);
+
+    superframe_info->frame_sizes[i] = frame_size;
+    total += frame_size;
+  }
+
+  if (total > size - index_size) {
+    GST_WARNING ("superframe index exceeds the data, %u > %u", total,
+        (guint) (size - index_size));
+    memset (superframe_info->frame_sizes, 0,
+        sizeof (superframe_info->frame_sizes));
+    return GST_VP9_PARSER_BROKEN_DATA;
+  }
+
+  superframe_info->bytes_per_framesize = bytes;
+  superframe_info->frames_in_superframe = frames;
+  superframe_info->superframe_index_size = index_size;
+
+  return GST_VP9_PARSER_OK;
+}
@@ -60,6 +60,8 @@ G_BEGIN_DECLS
 
 #define GST_VP9_PREDICTION_PROBS   3
 
+#define GST_VP9_MAX_FRAMES_IN_SUPERFRAME 8
+
 typedef struct _GstVp9Parser               GstVp9Parser;
 typedef struct _GstVp9FrameHdr             GstVp9FrameHdr;
 typedef struct _GstVp9LoopFilter           GstVp9LoopFilter;
@@ -67,6 +69,7 @@ typedef struct _GstVp9QuantIndices         GstVp9QuantIndices;
 typedef struct _GstVp9Segmentation         GstVp9Segmentation;
 typedef struct _GstVp9SegmentationInfo     GstVp9SegmentationInfo;
 typedef struct _GstVp9SegmentationInfoData GstVp9SegmentationInfoData;
+typedef struct _GstVp9SuperframeInfo       GstVp9SuperframeInfo;
 
 /**
  * GstVp9ParseResult:
@@ -482,12 +485,39 @@ struct _GstVp9Parser
   GstVp9Segmentation segmentation[GST_VP9_MAX_SEGMENTS];
 };
 
+/**
+ * GstVp9SuperframeInfo:
+ * @bytes_per_framesize: the number of bytes of each frame size in the index
+ * @frames_in_superframe: the number of frames in the superframe, 1 if the
+ *   data is a single frame
+ * @frame_sizes: the size of each frame, in decoding order
+ * @superframe_index_size: the size of the superframe index at the end of
+ *   the data, 0 if there is none
+ *
+ * Layout of a superframe, as given by its index.
+ *
+ * Since: 1.14
+ */
+struct _GstVp9SuperframeInfo
+{
+  guint32 bytes_per_framesize;
+  guint32 frames_in_superframe;
+  guint32 frame_sizes[GST_VP9_MAX_FRAMES_IN_SUPERFRAME];
+  guint32 superframe_index_size;
+};
+
 GST_EXPORT
 GstVp9Parser *     gst_vp9_parser_new (void);
 
 GST_EXPORT
 GstVp9ParserResult gst_vp9_parser_parse_frame_header (GstVp9Parser* parser, GstVp9FrameHdr * frame_hdr, const guint8 * data, gsize size);
 
+GST_EXPORT
+GstVp9ParserResult gst_vp9_parser_parse_frame_header_fast (GstVp9Parser* parser, GstVp9FrameHdr * frame_hdr, const guint8 * data, gsize size);
+
+GST_EXPORT
+GstVp9ParserResult gst_vp9_parser_parse_superframe_info (GstVp9Parser* parser, GstVp9SuperframeInfo * superframe_info, const guint8 * data, gsize size);
+
 GST_EXPORT
 void               gst_vp9_parser_free (GstVp9Parser * parser);
 
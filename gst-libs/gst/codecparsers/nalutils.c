@@ -207,15 +207,36 @@ gboolean
 nal_reader_get_ue (NalReader * nr, guint32 * val)
 {
   guint i = 0;
-  guint8 bit;
+  guint64 bits;
   guint32 value;
 
-  if (G_UNLIKELY (!nal_reader_get_bits_uint8 (nr, &bit, 1)))
-    return FALSE;
+  /* Count the leading zero bits in the cache at once instead of reading
+   * them bit by bit. The unread bits are the lowest bits_in_cache bits of
+   * the cache followed by first_byte */
+  while (TRUE) {
+    if (nr->bits_in_cache == 0 && G_UNLIKELY (!nal_reader_read (nr, 1)))
+      return FALSE;
+
+    bits = ((nr->cache << 8) | nr->first_byte) &
+        ((G_GUINT64_CONSTANT (1) << nr->bits_in_cache) - 1);
+    if (bits) {
+      guint storage, zeros;
+
+      /* g_bit_storage() only takes a gulong */
+      storage = (bits >> 32) ? 32 + g_bit_storage ((guint32) (bits >> 32)) :
+          g_bit_storage ((guint32) bits);
+      zeros = nr->bits_in_cache - storage;
 
-  while (bit == 0) {
-    i++;
-    if (G_UNLIKELY (!nal_reader_get_bits_uint8 (nr, &bit, 1)))
+      i += zeros;
+      /* skip the zeros and the 1 bit after them */
+      nr->bits_in_cache -= zeros + 1;
+      break;
+    }
+
+    i += nr->bits_in_cache;
+    nr->bits_in_cache = 0;
+
+    if (G_UNLIKELY (i > 32))
       return FALSE;
   }
 
@@ -297,13 +318,48 @@ nal_reader_has_more_data (NalReader * nr)
 
 /***********  end of nal parser ***************/
 
+/* Word with the lowest bit of every byte set, and with the highest one */
+#define ONES G_GUINT64_CONSTANT (0x0101010101010101)
+#define HIGHS G_GUINT64_CONSTANT (0x8080808080808080)
+
+/* Non-zero if any byte of @v is zero */
+#define has_zero_byte(v) (((v) - ONES) & ~(v) & HIGHS)
+
+/* Returns the offset of the first 0x000001 start code in @data that is
+ * followed by at least one byte, or -1.
+ *
+ * Large parts of the input contain no zero bytes at all, so these are
+ * skipped 8 bytes at a time. Otherwise the byte at the end of the
+ * possible start code decides how far to skip: anything larger than 1
+ * there can't be part of a start code at any of the three positions. */
 gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
+  guint i = 0;
+  guint64 v;
 
   /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+  if (size < 4)
+    return -1;
+
+  while (i + 3 < size) {
+    if (i + 8 <= size) {
+      memcpy (&v, data + i, sizeof (v));
+      if (!has_zero_byte (v)) {
+        i += 8;
+        continue;
+      }
+    }
+
+    if (data[i + 2] > 1)
+      i += 3;
+    else if (data[i + 1])
+      i += 2;
+    else if (data[i] || data[i + 2] != 1)
+      i++;
+    else
+      return i;
+  }
+
+  return -1;
 }
@@ -32,6 +32,9 @@
  * A #GstEGLImage can be created from a dmabuf with gst_egl_image_from_dmabuf()
  * or #GstGLMemoryEGL provides a #GstAllocator to allocate #EGLImage's bound to
  * and OpenGL texture.
+ *
+ * The reverse, exporting a #GstEGLImage as a dmabuf, is done with
+ * gst_egl_image_export_dmabuf().
  */
 
 #ifdef HAVE_CONFIG_H
@@ -469,4 +472,95 @@ gst_egl_image_from_dmabuf (GstGLContext * context,
   return gst_egl_image_new_wrapped (context, img, format, NULL,
       (GstEGLImageDestroyNotify) _destroy_egl_image);
 }
+
+/**
+ * gst_egl_image_export_dmabuf:
+ * @image: a #GstEGLImage
+ * @fd: (out): the dmabuf file descriptor
+ * @stride: (out): the stride of the dmabuf
+ * @offset: (out): the offset of the image in the dmabuf
+ *
+ * Exports @image as a single plane dmabuf with
+ * EGL_MESA_image_dma_buf_export.  The caller owns the returned @fd and has to
+ * close it.
+ *
+ * Note: must be called in the GL thread of the context of @image
+ *
+ * Returns: whether @image could be exported
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_egl_image_export_dmabuf (GstEGLImage * image, gint * fd, gint * stride,
+    gsize * offset)
+{
+  EGLBoolean (*gst_eglExportDMABUFImageQueryMESA) (EGLDisplay dpy,
+      EGLImageKHR image, int *fourcc, int *num_planes,
+      guint64 * modifiers);
+  EGLBoolean (*gst_eglExportDMABUFImageMESA) (EGLDisplay dpy,
+      EGLImageKHR image, int *fds, EGLint * strides, EGLint * offsets);
+  GstGLDisplayEGL *display_egl;
+  EGLDisplay egl_display;
+  int fourcc, num_planes, egl_fd;
+  EGLint egl_stride, egl_offset;
+
+  g_return_val_if_fail (GST_IS_EGL_IMAGE (image), FALSE);
+  g_return_val_if_fail (fd != NULL, FALSE);
+
+  if (!gst_gl_context_check_feature (image->context,
+          "EGL_MESA_image_dma_buf_export")) {
+    GST_DEBUG_OBJECT (image->context, "EGL_MESA_image_dma_buf_export is not "
+        "supported");
+    return FALSE;
+  }
+
+  gst_eglExportDMABUFImageQueryMESA =
+      gst_gl_context_get_proc_address (image->context,
+      "eglExportDMABUFImageQueryMESA");
+  gst_eglExportDMABUFImageMESA =
+      gst_gl_context_get_proc_address (image->context,
+      "eglExportDMABUFImageMESA");
+  if (!gst_eglExportDMABUFImageQueryMESA || !gst_eglExportDMABUFImageMESA)
+    return FALSE;
+
+  display_egl = gst_gl_display_egl_from_gl_display (image->context->display);
+  if (!display_egl) {
+    GST_WARNING_OBJECT (image->context, "Failed to retrieve GstGLDisplayEGL "
+        "from %" GST_PTR_FORMAT, image->context->display);
+    return FALSE;
+  }
+  egl_display =
+      (EGLDisplay) gst_gl_display_get_handle (GST_GL_DISPLAY (display_egl));
+  gst_object_unref (display_egl);
+
+  if (!gst_eglExportDMABUFImageQueryMESA (egl_display, image->image, &fourcc,
+          &num_planes, NULL))
+    return FALSE;
+
+  /* the images of a GstGLMemory are always a single plane */
+  if (num_planes != 1) {
+    GST_FIXME_OBJECT (image->context, "Cannot export an image with %d "
+        "planes", num_planes);
+    return FALSE;
+  }
+
+  if (!gst_eglExportDMABUFImageMESA (egl_display, image->image, &egl_fd,
+          &egl_stride, &egl_offset)) {
+    GST_WARNING_OBJECT (image->context, "eglExportDMABUFImageMESA failed: %s",
+        gst_egl_get_error_string (eglGetError ()));
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (image->context, "exported image %p as fd %d fourcc %.4s "
+      "stride %d offset %d", image->image, egl_fd, (char *) &fourcc,
+      egl_stride, egl_offset);
+
+  *fd = egl_fd;
+  if (stride)
+    *stride = egl_stride;
+  if (offset)
+    *offset = egl_offset;
+
+  return TRUE;
+}
 #endif /* GST_GL_HAVE_DMABUF */
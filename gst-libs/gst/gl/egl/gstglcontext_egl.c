@@ -71,6 +71,8 @@ static gboolean gst_gl_context_egl_check_feature (GstGLContext * context,
     const gchar * feature);
 static void gst_gl_context_egl_get_gl_platform_version (GstGLContext * context,
     gint * major, gint * minor);
+static gboolean gst_gl_context_egl_set_swap_interval (GstGLContext * context,
+    gint interval);
 
 G_DEFINE_TYPE (GstGLContextEGL, gst_gl_context_egl, GST_TYPE_GL_CONTEXT);
 
@@ -102,6 +104,8 @@ gst_gl_context_egl_class_init (GstGLContextEGLClass * klass)
       GST_DEBUG_FUNCPTR (gst_gl_context_egl_get_current_context);
   context_class->get_gl_platform_version =
       GST_DEBUG_FUNCPTR (gst_gl_context_egl_get_gl_platform_version);
+  context_class->set_swap_interval =
+      GST_DEBUG_FUNCPTR (gst_gl_context_egl_set_swap_interval);
 }
 
 static void
@@ -686,6 +690,14 @@ gst_gl_context_egl_swap_buffers (GstGLContext * context)
   eglSwapBuffers (egl->egl_display, egl->egl_surface);
 }
 
+static gboolean
+gst_gl_context_egl_set_swap_interval (GstGLContext * context, gint interval)
+{
+  GstGLContextEGL *egl = GST_GL_CONTEXT_EGL (context);
+
+  return eglSwapInterval (egl->egl_display, interval) == EGL_TRUE;
+}
+
 static GstGLAPI
 gst_gl_context_egl_get_gl_api (GstGLContext * context)
 {
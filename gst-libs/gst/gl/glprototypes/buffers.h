@@ -46,3 +46,17 @@ GST_GL_EXT_FUNCTION (void, GetBufferSubData,
                       GLsizeiptr            size,
                       void *                data))
 GST_GL_EXT_END ()
+
+GST_GL_EXT_BEGIN (buffer_storage,
+                  GST_GL_API_OPENGL | GST_GL_API_OPENGL3 |
+                  GST_GL_API_GLES2,
+                  4, 4,
+                  255, 255,
+                  "ARB:\0EXT\0",
+                  "buffer_storage\0")
+GST_GL_EXT_FUNCTION (void, BufferStorage,
+                     (GLenum                target,
+                      GLsizeiptr            size,
+                      const void *          data,
+                      GLbitfield            flags))
+GST_GL_EXT_END ()
@@ -372,3 +372,45 @@ GST_GL_EXT_BEGIN (bind_frag_data,
 GST_GL_EXT_FUNCTION (void, BindFragDataLocation,
                      (GLuint program, GLuint index, const GLchar * name))
 GST_GL_EXT_END ()
+
+GST_GL_EXT_BEGIN (get_program_binary,
+                  GST_GL_API_OPENGL | GST_GL_API_OPENGL3 |
+                  GST_GL_API_GLES2,
+                  4, 1,
+                  3, 0,
+                  "ARB:\0OES\0",
+                  "get_program_binary\0")
+GST_GL_EXT_FUNCTION (void, GetProgramBinary,
+                     (GLuint program, GLsizei bufSize, GLsizei * length,
+                      GLenum * binaryFormat, void * binary))
+GST_GL_EXT_FUNCTION (void, ProgramBinary,
+                     (GLuint program, GLenum binaryFormat,
+                      const void * binary, GLsizei length))
+GST_GL_EXT_END ()
+
+GST_GL_EXT_BEGIN (compute_shader,
+                  GST_GL_API_OPENGL | GST_GL_API_OPENGL3 |
+                  GST_GL_API_GLES2,
+                  4, 3,
+                  3, 1,
+                  "ARB:\0",
+                  "compute_shader\0")
+GST_GL_EXT_FUNCTION (void, DispatchCompute,
+                     (GLuint num_groups_x, GLuint num_groups_y,
+                      GLuint num_groups_z))
+GST_GL_EXT_END ()
+
+GST_GL_EXT_BEGIN (shader_image_load_store,
+                  GST_GL_API_OPENGL | GST_GL_API_OPENGL3 |
+                  GST_GL_API_GLES2,
+                  4, 2,
+                  3, 1,
+                  "ARB:\0",
+                  "shader_image_load_store\0")
+GST_GL_EXT_FUNCTION (void, BindImageTexture,
+                     (GLuint unit, GLuint texture, GLint level,
+                      GLboolean layered, GLint layer, GLenum access,
+                      GLenum format))
+GST_GL_EXT_FUNCTION (void, MemoryBarrier,
+                     (GLbitfield barriers))
+GST_GL_EXT_END ()
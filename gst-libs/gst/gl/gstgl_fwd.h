@@ -99,8 +99,10 @@ typedef struct _GstGLViewConvertPrivate GstGLViewConvertPrivate;
 
 typedef struct _GstGLOverlayCompositor GstGLOverlayCompositor;
 typedef struct _GstGLOverlayCompositorClass GstGLOverlayCompositorClass;
+typedef struct _GstGLOverlayCompositorPrivate GstGLOverlayCompositorPrivate;
 
 typedef struct _GstGLQuery GstGLQuery;
+typedef struct _GstGLTimer GstGLTimer;
 
 typedef struct _GstGLFuncs GstGLFuncs;
 
@@ -37,6 +37,9 @@
  * context.  It also provided some wrappers around #GstBaseTransform's
  * start(), stop() and set_caps() virtual methods that ensure an OpenGL context
  * is available and current in the calling thread.
+ *
+ * The GPU time spent on each output buffer is measured with a #GstGLTimer
+ * and reported by the #GstGLBaseFilter:gpu-stats property.
  */
 
 #define GST_CAT_DEFAULT gst_gl_base_filter_debug
@@ -51,13 +54,17 @@ struct _GstGLBaseFilterPrivate
 
   gboolean gl_result;
   gboolean gl_started;
+
+  /* protected by the object lock outside of the GL thread */
+  GstGLTimer *timer;
 };
 
 /* Properties */
 enum
 {
   PROP_0,
-  PROP_CONTEXT
+  PROP_CONTEXT,
+  PROP_GPU_STATS
 };
 
 #define gst_gl_base_filter_parent_class parent_class
@@ -84,6 +91,8 @@ static gboolean gst_gl_base_filter_set_caps (GstBaseTransform * bt,
     GstCaps * incaps, GstCaps * outcaps);
 static gboolean gst_gl_base_filter_decide_allocation (GstBaseTransform * trans,
     GstQuery * query);
+static GstFlowReturn gst_gl_base_filter_generate_output (GstBaseTransform *
+    trans, GstBuffer ** outbuf);
 
 /* GstGLContextThreadFunc */
 static void gst_gl_base_filter_gl_start (GstGLContext * context, gpointer data);
@@ -113,6 +122,8 @@ gst_gl_base_filter_class_init (GstGLBaseFilterClass * klass)
   GST_BASE_TRANSFORM_CLASS (klass)->stop = gst_gl_base_filter_stop;
   GST_BASE_TRANSFORM_CLASS (klass)->decide_allocation =
       gst_gl_base_filter_decide_allocation;
+  GST_BASE_TRANSFORM_CLASS (klass)->generate_output =
+      gst_gl_base_filter_generate_output;
 
   element_class->set_context = gst_gl_base_filter_set_context;
   element_class->change_state = gst_gl_base_filter_change_state;
@@ -123,6 +134,19 @@ gst_gl_base_filter_class_init (GstGLBaseFilterClass * klass)
           "Get OpenGL context",
           GST_TYPE_GL_CONTEXT, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGLBaseFilter:gpu-stats:
+   *
+   * The GPU time spent producing the output buffers, as returned by
+   * gst_gl_timer_get_stats(), or %NULL without a started OpenGL context.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_GPU_STATS,
+      g_param_spec_boxed ("gpu-stats", "GPU statistics",
+          "GPU time statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   klass->supported_gl_api = GST_GL_API_ANY;
   klass->gl_start = gst_gl_base_filter_default_gl_start;
   klass->gl_stop = gst_gl_base_filter_default_gl_stop;
@@ -168,6 +192,15 @@ gst_gl_base_filter_get_property (GObject * object, guint prop_id,
     case PROP_CONTEXT:
       g_value_set_object (value, filter->context);
       break;
+    case PROP_GPU_STATS:
+      GST_OBJECT_LOCK (filter);
+      if (filter->priv->timer)
+        g_value_take_boxed (value,
+            gst_gl_timer_get_stats (filter->priv->timer));
+      else
+        g_value_set_boxed (value, NULL);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -281,6 +314,14 @@ gst_gl_base_filter_gl_start (GstGLContext * context, gpointer data)
       "starting element %s", GST_OBJECT_NAME (filter));
 
   filter->priv->gl_started = filter_class->gl_start (filter);
+
+  if (filter->priv->gl_started) {
+    GstGLTimer *timer = gst_gl_timer_new (context);
+
+    GST_OBJECT_LOCK (filter);
+    filter->priv->timer = timer;
+    GST_OBJECT_UNLOCK (filter);
+  }
 }
 
 static void
@@ -301,6 +342,58 @@ gst_gl_base_filter_gl_stop (GstGLContext * context, gpointer data)
     filter_class->gl_stop (filter);
 
   filter->priv->gl_started = FALSE;
+
+  if (filter->priv->timer) {
+    GstGLTimer *timer = filter->priv->timer;
+
+    GST_OBJECT_LOCK (filter);
+    filter->priv->timer = NULL;
+    GST_OBJECT_UNLOCK (filter);
+
+    gst_gl_timer_free (timer);
+  }
+}
+
+static void
+_timer_start (GstGLContext * context, GstGLBaseFilter * filter)
+{
+  if (filter->priv->timer)
+    gst_gl_timer_start (filter->priv->timer);
+}
+
+static void
+_timer_end (GstGLContext * context, GstGLBaseFilter * filter)
+{
+  if (filter->priv->timer)
+    gst_gl_timer_end (filter->priv->timer);
+}
+
+/* times all the GL work done for one output buffer, whatever the subclass
+ * does.  The timer calls are queued in the GL thread in order with the GL
+ * work, without waiting for them */
+static GstFlowReturn
+gst_gl_base_filter_generate_output (GstBaseTransform * trans,
+    GstBuffer ** outbuf)
+{
+  GstGLBaseFilter *filter = GST_GL_BASE_FILTER (trans);
+  gboolean timed = filter->context && filter->priv->gl_started
+      && trans->queued_buf;
+  GstFlowReturn ret;
+
+  if (timed)
+    gst_gl_context_thread_add_async (filter->context,
+        (GstGLContextThreadFunc) _timer_start, gst_object_ref (filter),
+        gst_object_unref);
+
+  ret = GST_BASE_TRANSFORM_CLASS (parent_class)->generate_output (trans,
+      outbuf);
+
+  if (timed)
+    gst_gl_context_thread_add_async (filter->context,
+        (GstGLContextThreadFunc) _timer_end, gst_object_ref (filter),
+        gst_object_unref);
+
+  return ret;
 }
 
 static void
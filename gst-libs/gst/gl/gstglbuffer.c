@@ -45,6 +45,13 @@
 /* Implementation notes:
  *
  * Currently does not take into account GLES2 differences (no mapbuffer)
+ *
+ * With GL_ARB_buffer_storage (GL 4.4), buffers with a streaming usage hint
+ * are allocated with immutable storage that stays mapped persistently and
+ * coherently for the lifetime of the buffer.  CPU maps then return that
+ * pointer directly instead of going through the staging mem.data and a
+ * memcpy.  A fence is placed after every GL access so that a following CPU
+ * map does not race the GPU still reading from or writing to the buffer.
  */
 
 #define USING_OPENGL(context) (gst_gl_context_check_gl_version (context, GST_GL_API_OPENGL, 1, 0))
@@ -66,26 +73,122 @@
 #ifndef GL_COPY_WRITE_BUFFER
 #define GL_COPY_WRITE_BUFFER 0x8F37
 #endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_STREAM_COPY
+#define GL_STREAM_COPY 0x88E2
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+
+#define PERSISTENT_MAP_FLAGS (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | \
+    GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
 
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_GL_BUFFER);
 #define GST_CAT_DEFUALT GST_CAT_GL_BUFFER
 
 static GstAllocator *_gl_buffer_allocator;
 
+/* All GstGLBuffer's are allocated with this layout */
+typedef struct
+{
+  GstGLBuffer buffer;
+
+  /* the persistent mapping of the buffer storage, or NULL */
+  gpointer persistent_data;
+  /* the GL commands last accessing the buffer */
+  GLsync fence;
+} GstGLBufferImpl;
+
+#define GL_BUFFER_IMPL(mem) ((GstGLBufferImpl *) (mem))
+
+static gboolean
+_gl_buffer_can_persist (GstGLBuffer * gl_mem)
+{
+  const GstGLFuncs *gl = gl_mem->mem.context->gl_vtable;
+
+  if (!gl->BufferStorage || !gl->MapBufferRange || !gl->FenceSync
+      || !gl->ClientWaitSync)
+    return FALSE;
+
+  /* only for buffers the CPU is expected to access every time they are
+   * used, anything else is better left in memory private to the GPU */
+  return gl_mem->usage_hints == GL_STREAM_DRAW
+      || gl_mem->usage_hints == GL_STREAM_READ
+      || gl_mem->usage_hints == GL_STREAM_COPY;
+}
+
 static gboolean
 _gl_buffer_create (GstGLBuffer * gl_mem, GError ** error)
 {
   const GstGLFuncs *gl = gl_mem->mem.context->gl_vtable;
+  GstGLBufferImpl *impl = GL_BUFFER_IMPL (gl_mem);
 
   gl->GenBuffers (1, &gl_mem->id);
   gl->BindBuffer (gl_mem->target, gl_mem->id);
-  gl->BufferData (gl_mem->target, gl_mem->mem.mem.maxsize, NULL,
-      gl_mem->usage_hints);
+  if (_gl_buffer_can_persist (gl_mem)) {
+    gl->BufferStorage (gl_mem->target, gl_mem->mem.mem.maxsize, NULL,
+        PERSISTENT_MAP_FLAGS);
+    impl->persistent_data = gl->MapBufferRange (gl_mem->target, 0,
+        gl_mem->mem.mem.maxsize, PERSISTENT_MAP_FLAGS);
+    if (!impl->persistent_data) {
+      /* immutable storage cannot be respecified, start over */
+      GST_CAT_WARNING (GST_CAT_GL_BUFFER, "failed to persistently map "
+          "buffer %u, falling back to copying", gl_mem->id);
+      gl->BindBuffer (gl_mem->target, 0);
+      gl->DeleteBuffers (1, &gl_mem->id);
+      gl->GenBuffers (1, &gl_mem->id);
+      gl->BindBuffer (gl_mem->target, gl_mem->id);
+    }
+  }
+  if (!impl->persistent_data)
+    gl->BufferData (gl_mem->target, gl_mem->mem.mem.maxsize, NULL,
+        gl_mem->usage_hints);
   gl->BindBuffer (gl_mem->target, 0);
 
+  GST_CAT_LOG (GST_CAT_GL_BUFFER, "created buffer %u persistent mapping %p",
+      gl_mem->id, impl->persistent_data);
+
   return TRUE;
 }
 
+/* Waits until the GPU does not access the buffer anymore */
+static void
+_gl_buffer_wait_fence (GstGLBuffer * mem)
+{
+  const GstGLFuncs *gl = mem->mem.context->gl_vtable;
+  GstGLBufferImpl *impl = GL_BUFFER_IMPL (mem);
+  GLenum res;
+
+  if (!impl->fence)
+    return;
+
+  do {
+    res = gl->ClientWaitSync (impl->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+        1000000000 /* 1s */ );
+  } while (res == GL_TIMEOUT_EXPIRED);
+
+  gl->DeleteSync (impl->fence);
+  impl->fence = NULL;
+}
+
 struct create_data
 {
   GstGLBuffer *mem;
@@ -112,7 +215,7 @@ _gl_buffer_new (GstAllocator * allocator, GstMemory * parent,
     GstGLContext * context, guint gl_target, guint gl_usage,
     GstAllocationParams * params, gsize size)
 {
-  GstGLBuffer *ret = g_new0 (GstGLBuffer, 1);
+  GstGLBuffer *ret = (GstGLBuffer *) g_new0 (GstGLBufferImpl, 1);
   _gl_buffer_init (ret, allocator, parent, context, gl_target, gl_usage,
       params, size);
 
@@ -125,6 +228,12 @@ gst_gl_buffer_cpu_access (GstGLBuffer * mem, GstMapInfo * info, gsize size)
   const GstGLFuncs *gl = mem->mem.context->gl_vtable;
   gpointer data, ret;
 
+  if (GL_BUFFER_IMPL (mem)->persistent_data) {
+    /* coherent, only the GPU may still be busy with it */
+    _gl_buffer_wait_fence (mem);
+    return GL_BUFFER_IMPL (mem)->persistent_data;
+  }
+
   if (!gst_gl_base_memory_alloc_data (GST_GL_BASE_MEMORY_CAST (mem)))
     return NULL;
 
@@ -227,6 +336,14 @@ _gl_buffer_unmap (GstGLBuffer * mem, GstMapInfo * info)
 
   if ((info->flags & GST_MAP_GL) != 0) {
     gl->BindBuffer (mem->target, 0);
+
+    if (GL_BUFFER_IMPL (mem)->persistent_data) {
+      GstGLBufferImpl *impl = GL_BUFFER_IMPL (mem);
+
+      if (impl->fence)
+        gl->DeleteSync (impl->fence);
+      impl->fence = gl->FenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
   }
   /* XXX: optimistically transfer data */
 }
@@ -326,7 +443,11 @@ static void
 _gl_buffer_destroy (GstGLBuffer * mem)
 {
   const GstGLFuncs *gl = mem->mem.context->gl_vtable;
+  GstGLBufferImpl *impl = GL_BUFFER_IMPL (mem);
 
+  if (impl->fence)
+    gl->DeleteSync (impl->fence);
+  /* deleting the buffer also unmaps the persistent mapping */
   gl->DeleteBuffers (1, &mem->id);
 }
 
@@ -42,6 +42,13 @@
  * %GST_BUFFER_POOL_OPTION_VIDEO_META, the VideoAligment buffer pool option
  * %GST_BUFFER_POOL_OPTION_VIDEO_ALIGNMENT as well as the OpenGL specific
  * %GST_BUFFER_POOL_OPTION_GL_SYNC_META buffer pool option.
+ *
+ * The textures of the freed buffers are kept by the #GstGLContext for a few
+ * seconds and reused for new #GstGLMemory of the same size and format, so
+ * recreating a pool, for example on a resolution change, does not always
+ * allocate new texture storage.  The cache is limited to 32 MiB of textures
+ * by default, the GST_GL_TEXTURE_CACHE_SIZE environment variable sets the
+ * limit in bytes, 0 disabling the cache.
  */
 
 /* bufferpool */
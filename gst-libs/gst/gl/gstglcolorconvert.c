@@ -46,6 +46,18 @@
  *
  * The glcolorconvertelement provides a GStreamer element that uses
  * #GstGLColorConvert to convert between video formats and color spaces.
+ *
+ * Converts performing the same conversion in the same #GstGLContext share
+ * their shader.  If the GST_GL_SHADER_CACHE_DIR environment variable names a
+ * directory and the context supports program binaries, the linked shaders
+ * are also stored there and loaded again instead of being compiled the next
+ * time.
+ *
+ * On OpenGL 4.3, the conversions between RGBA and NV12, NV21, I420 or YV12
+ * of the same size are performed by a compute shader writing all the planes
+ * at once, without intermediate textures for the subsampled planes.  Setting
+ * the GST_GL_COLOR_CONVERT_COMPUTE environment variable to 0 disables it;
+ * the fragment shaders are used whenever the compute shader cannot be.
  */
 
 #define USING_OPENGL(context) (gst_gl_context_check_gl_version (context, GST_GL_API_OPENGL, 1, 0))
@@ -63,6 +75,25 @@ static GstBuffer *_gst_gl_color_convert_perform_unlocked (GstGLColorConvert *
 static gboolean _do_convert_draw (GstGLContext * context,
     GstGLColorConvert * convert);
 
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+#ifndef GL_RG8
+#define GL_RG8 0x822B
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_ALL_BARRIER_BITS
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+#endif
+
 /* *INDENT-OFF* */
 
 #define YUV_TO_RGB_COEFFICIENTS \
@@ -374,6 +405,96 @@ static const struct shader_templ templ_RGB_to_YUY2_UYVY =
     GST_GL_TEXTURE_TARGET_2D
   };
 
+/* Compute kernels, one invocation per 2x2 block of pixels sharing a chroma
+ * sample, writing the planes as images */
+#define COMPUTE_HEADER \
+    "layout (local_size_x = 8, local_size_y = 8) in;\n" \
+    YUV_TO_RGB_COEFFICIENTS \
+    "uniform ivec2 size;\n"
+
+#define COMPUTE_BLOCK_BEGIN \
+    "void main () {\n" \
+    "  ivec2 chroma = ivec2 (gl_GlobalInvocationID.xy);\n" \
+    "  ivec2 pos = chroma * 2;\n" \
+    "  if (pos.x >= size.x || pos.y >= size.y)\n" \
+    "    return;\n"
+
+#define COMPUTE_FOREACH_PIXEL \
+    "  for (int j = 0; j < 2; j++) {\n" \
+    "    for (int i = 0; i < 2; i++) {\n" \
+    "      ivec2 p = min (pos + ivec2 (i, j), size - 1);\n"
+
+static const gchar compute_RGB_to_NV12_NV21[] =
+    COMPUTE_HEADER
+    "uniform sampler2D tex;\n"
+    "layout (r8) writeonly uniform image2D Yimage;\n"
+    "layout (rg8) writeonly uniform image2D UVimage;\n"
+    glsl_func_rgb_to_yuv
+    COMPUTE_BLOCK_BEGIN
+    "  vec3 sum = vec3 (0.0);\n"
+    COMPUTE_FOREACH_PIXEL
+    "      vec4 texel = texelFetch (tex, p, 0).%c%c%c%c;\n"
+    "      vec3 yuv = rgb_to_yuv (texel.rgb, offset, coeff1, coeff2, coeff3);\n"
+    "      imageStore (Yimage, p, vec4 (yuv.x));\n"
+    "      sum += texel.rgb;\n"
+    "    }\n"
+    "  }\n"
+    "  vec3 yuv = rgb_to_yuv (sum * 0.25, offset, coeff1, coeff2, coeff3);\n"
+    "  imageStore (UVimage, chroma, vec4 (yuv.%c, yuv.%c, 0.0, 0.0));\n"
+    "}\n";
+
+static const gchar compute_RGB_to_I420[] =
+    COMPUTE_HEADER
+    "uniform sampler2D tex;\n"
+    "layout (r8) writeonly uniform image2D Yimage;\n"
+    "layout (r8) writeonly uniform image2D Uimage;\n"
+    "layout (r8) writeonly uniform image2D Vimage;\n"
+    glsl_func_rgb_to_yuv
+    COMPUTE_BLOCK_BEGIN
+    "  vec3 sum = vec3 (0.0);\n"
+    COMPUTE_FOREACH_PIXEL
+    "      vec4 texel = texelFetch (tex, p, 0).%c%c%c%c;\n"
+    "      vec3 yuv = rgb_to_yuv (texel.rgb, offset, coeff1, coeff2, coeff3);\n"
+    "      imageStore (Yimage, p, vec4 (yuv.x));\n"
+    "      sum += texel.rgb;\n"
+    "    }\n"
+    "  }\n"
+    "  vec3 yuv = rgb_to_yuv (sum * 0.25, offset, coeff1, coeff2, coeff3);\n"
+    "  imageStore (Uimage, chroma, vec4 (yuv.y));\n"
+    "  imageStore (Vimage, chroma, vec4 (yuv.z));\n"
+    "}\n";
+
+static const gchar compute_NV12_NV21_to_RGB[] =
+    COMPUTE_HEADER
+    "uniform sampler2D Ytex, UVtex;\n"
+    "layout (rgba8) writeonly uniform image2D image;\n"
+    glsl_func_yuv_to_rgb
+    COMPUTE_BLOCK_BEGIN
+    "  vec2 uv = texelFetch (UVtex, chroma, 0).%c%c;\n"
+    COMPUTE_FOREACH_PIXEL
+    "      vec3 yuv = vec3 (texelFetch (Ytex, p, 0).r, uv);\n"
+    "      vec4 rgba = vec4 (yuv_to_rgb (yuv, offset, coeff1, coeff2, coeff3), 1.0);\n"
+    "      imageStore (image, p, vec4 (rgba.%c, rgba.%c, rgba.%c, rgba.%c));\n"
+    "    }\n"
+    "  }\n"
+    "}\n";
+
+static const gchar compute_I420_to_RGB[] =
+    COMPUTE_HEADER
+    "uniform sampler2D Ytex, Utex, Vtex;\n"
+    "layout (rgba8) writeonly uniform image2D image;\n"
+    glsl_func_yuv_to_rgb
+    COMPUTE_BLOCK_BEGIN
+    "  vec2 uv = vec2 (texelFetch (Utex, chroma, 0).r,\n"
+    "      texelFetch (Vtex, chroma, 0).r);\n"
+    COMPUTE_FOREACH_PIXEL
+    "      vec3 yuv = vec3 (texelFetch (Ytex, p, 0).r, uv);\n"
+    "      vec4 rgba = vec4 (yuv_to_rgb (yuv, offset, coeff1, coeff2, coeff3), 1.0);\n"
+    "      imageStore (image, p, vec4 (rgba.%c, rgba.%c, rgba.%c, rgba.%c));\n"
+    "    }\n"
+    "  }\n"
+    "}\n";
+
 static const gchar text_vertex_shader[] =
     "attribute vec4 a_position;   \n"
     "attribute vec2 a_texcoord;   \n"
@@ -435,6 +556,11 @@ struct _GstGLColorConvertPrivate
 
   GstBufferPool *pool;
   gboolean pool_started;
+
+  /* the compute shader path, if usable */
+  GstGLShader *compute_shader;
+  const gchar *image_names[GST_VIDEO_MAX_PLANES];
+  GstGLFormat image_formats[GST_VIDEO_MAX_PLANES];
 };
 
 GST_DEBUG_CATEGORY_STATIC (gst_gl_color_convert_debug);
@@ -551,6 +677,10 @@ gst_gl_color_convert_reset_shader (GstGLColorConvert * convert)
     gst_object_unref (convert->shader);
     convert->shader = NULL;
   }
+  if (convert->priv->compute_shader) {
+    gst_object_unref (convert->priv->compute_shader);
+    convert->priv->compute_shader = NULL;
+  }
 
   convert->initted = FALSE;
 }
@@ -1782,53 +1912,36 @@ _unbind_buffer (GstGLColorConvert * convert)
   gl->DisableVertexAttribArray (convert->priv->attr_texture);
 }
 
+/* Identical conversions share their shader.  Only the generated source is
+ * compared, everything else the convert needs is set as uniforms before
+ * drawing */
 static GstGLShader *
 _create_shader (GstGLColorConvert * convert)
 {
   struct ConvertInfo *info = &convert->priv->convert_info;
   GString *str = g_string_new (NULL);
-  GstGLShader *ret = NULL;
+  GstGLShader *ret = NULL, *cached;
   GstGLSLStage *stage;
-  GstGLSLVersion version;
-  GstGLSLProfile profile;
-  gchar *version_str, *tmp, *tmp1;
+  GstGLSLVersion version, vert_version;
+  GstGLSLProfile profile, vert_profile;
+  gchar *version_str, *vert_prog, *source, *tmp, *tmp1;
   const gchar *strings[2];
   GError *error = NULL;
   int i;
 
   ret = gst_gl_shader_new (convert->context);
 
-  tmp =
+  vert_prog =
       _gst_glsl_mangle_shader (text_vertex_shader, GL_VERTEX_SHADER,
       info->templ->target, convert->priv->from_texture_target, convert->context,
-      &version, &profile);
+      &vert_version, &vert_profile);
+  version = vert_version;
+  profile = vert_profile;
 
   tmp1 = gst_glsl_version_profile_to_string (version, profile);
   version_str = g_strdup_printf ("#version %s\n", tmp1);
   g_free (tmp1);
 
-  strings[0] = version_str;
-  strings[1] = tmp;
-  if (!(stage = gst_glsl_stage_new_with_strings (convert->context,
-              GL_VERTEX_SHADER, version, profile, 2, strings))) {
-    GST_ERROR_OBJECT (convert, "Failed to create vertex stage");
-    g_free (version_str);
-    g_free (tmp);
-    gst_object_unref (ret);
-    return NULL;
-  }
-  g_free (tmp);
-
-  if (!gst_gl_shader_compile_attach_stage (ret, stage, &error)) {
-    GST_ERROR_OBJECT (convert, "Failed to compile vertex shader %s",
-        error->message);
-    g_clear_error (&error);
-    g_free (version_str);
-    gst_object_unref (stage);
-    gst_object_unref (ret);
-    return NULL;
-  }
-
   if (info->templ->extensions)
     g_string_append (str, info->templ->extensions);
 
@@ -1912,38 +2025,261 @@ _create_shader (GstGLColorConvert * convert)
       &version, &profile);
   g_free (tmp);
 
+  source = g_strconcat (version_str, vert_prog, version_str, info->frag_prog,
+      NULL);
+
+  if ((cached = _gst_gl_shader_cache_lookup (convert->context, source))) {
+    gst_object_unref (ret);
+    ret = cached;
+    goto done;
+  }
+
+  if (_gst_gl_shader_load_binary (ret, source))
+    goto cache;
+
+  strings[0] = version_str;
+  strings[1] = vert_prog;
+  if (!(stage = gst_glsl_stage_new_with_strings (convert->context,
+              GL_VERTEX_SHADER, vert_version, vert_profile, 2, strings))) {
+    GST_ERROR_OBJECT (convert, "Failed to create vertex stage");
+    goto error;
+  }
+
+  if (!gst_gl_shader_compile_attach_stage (ret, stage, &error)) {
+    GST_ERROR_OBJECT (convert, "Failed to compile vertex shader %s",
+        error->message);
+    g_clear_error (&error);
+    gst_object_unref (stage);
+    goto error;
+  }
+
   strings[1] = info->frag_prog;
   if (!(stage = gst_glsl_stage_new_with_strings (convert->context,
               GL_FRAGMENT_SHADER, version, profile, 2, strings))) {
     GST_ERROR_OBJECT (convert, "Failed to create fragment stage");
-    g_free (info->frag_prog);
-    info->frag_prog = NULL;
-    g_free (version_str);
-    gst_object_unref (ret);
-    return NULL;
+    goto error;
   }
-  g_free (version_str);
   if (!gst_gl_shader_compile_attach_stage (ret, stage, &error)) {
     GST_ERROR_OBJECT (convert, "Failed to compile fragment shader %s",
         error->message);
     g_clear_error (&error);
-    g_free (info->frag_prog);
-    info->frag_prog = NULL;
     gst_object_unref (stage);
-    gst_object_unref (ret);
-    return NULL;
+    goto error;
   }
 
   if (!gst_gl_shader_link (ret, &error)) {
     GST_ERROR_OBJECT (convert, "Failed to link shader %s", error->message);
     g_clear_error (&error);
-    g_free (info->frag_prog);
-    info->frag_prog = NULL;
-    gst_object_unref (ret);
-    return NULL;
+    goto error;
   }
 
+  _gst_gl_shader_save_binary (ret, source);
+
+cache:
+  _gst_gl_shader_cache_add (convert->context, source, ret);
+
+done:
+  g_free (source);
+  g_free (version_str);
+  g_free (vert_prog);
+
   return ret;
+
+error:
+  g_free (info->frag_prog);
+  info->frag_prog = NULL;
+  g_free (source);
+  g_free (version_str);
+  g_free (vert_prog);
+  gst_object_unref (ret);
+  return NULL;
+}
+
+/* The shader may be shared with other converts, so the uniforms are set
+ * every time it is used. Called with the shader in use */
+static void
+_set_uniforms (GstGLColorConvert * convert)
+{
+  struct ConvertInfo *info = &convert->priv->convert_info;
+  gint i;
+
+  if (info->cms_offset && info->cms_coeff1
+      && info->cms_coeff2 && info->cms_coeff3) {
+    gst_gl_shader_set_uniform_3fv (convert->shader, "offset", 1,
+        info->cms_offset);
+    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff1", 1,
+        info->cms_coeff1);
+    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff2", 1,
+        info->cms_coeff2);
+    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff3", 1,
+        info->cms_coeff3);
+  }
+
+  for (i = info->in_n_textures; i >= 0; i--) {
+    if (info->shader_tex_names[i])
+      gst_gl_shader_set_uniform_1i (convert->shader, info->shader_tex_names[i],
+          i);
+  }
+
+  gst_gl_shader_set_uniform_1f (convert->shader, "width",
+      GST_VIDEO_INFO_WIDTH (&convert->in_info));
+  gst_gl_shader_set_uniform_1f (convert->shader, "height",
+      GST_VIDEO_INFO_HEIGHT (&convert->in_info));
+
+  if (convert->priv->from_texture_target == GST_GL_TEXTURE_TARGET_RECTANGLE) {
+    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_x", 1.);
+    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_y", 1.);
+  } else {
+    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_x",
+        1. / (gfloat) GST_VIDEO_INFO_WIDTH (&convert->in_info));
+    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_y",
+        1. / (gfloat) GST_VIDEO_INFO_HEIGHT (&convert->in_info));
+  }
+
+  if (info->chroma_sampling[0] > 0.0f && info->chroma_sampling[1] > 0.0f) {
+    gst_gl_shader_set_uniform_2fv (convert->shader, "chroma_sampling", 1,
+        info->chroma_sampling);
+  }
+}
+
+static gboolean
+_is_4_byte_rgb (GstVideoFormat v_format)
+{
+  switch (v_format) {
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_BGRA:
+    case GST_VIDEO_FORMAT_ARGB:
+    case GST_VIDEO_FORMAT_ABGR:
+    case GST_VIDEO_FORMAT_RGBx:
+    case GST_VIDEO_FORMAT_BGRx:
+    case GST_VIDEO_FORMAT_xRGB:
+    case GST_VIDEO_FORMAT_xBGR:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/* Builds the compute shader for the conversion if the context and the
+ * formats allow it.  Only desktop GL can store into the R8 and RG8 planes,
+ * GLES 3.1 images are limited to four components.  Called in the gl
+ * thread */
+static void
+_init_compute (GstGLColorConvert * convert)
+{
+  GstGLContext *context = convert->context;
+  const GstGLFuncs *gl = context->gl_vtable;
+  struct ConvertInfo *info = &convert->priv->convert_info;
+  GstVideoFormat in_format = GST_VIDEO_INFO_FORMAT (&convert->in_info);
+  GstVideoFormat out_format = GST_VIDEO_INFO_FORMAT (&convert->out_info);
+  const gchar *env = g_getenv ("GST_GL_COLOR_CONVERT_COMPUTE");
+  GstGLSLProfile profile;
+  GError *error = NULL;
+  gchar *pixel_order, *source = NULL;
+
+  if (env && g_strcmp0 (env, "0") == 0)
+    return;
+
+  if (!gl->DispatchCompute || !gl->BindImageTexture || !gl->MemoryBarrier
+      || !gst_gl_context_check_gl_version (context,
+          GST_GL_API_OPENGL | GST_GL_API_OPENGL3, 4, 3))
+    return;
+
+  if (convert->priv->from_texture_target != GST_GL_TEXTURE_TARGET_2D
+      || convert->priv->to_texture_target != GST_GL_TEXTURE_TARGET_2D
+      || GST_VIDEO_INFO_WIDTH (&convert->in_info) !=
+      GST_VIDEO_INFO_WIDTH (&convert->out_info)
+      || GST_VIDEO_INFO_HEIGHT (&convert->in_info) !=
+      GST_VIDEO_INFO_HEIGHT (&convert->out_info))
+    return;
+
+  if (GST_VIDEO_INFO_IS_RGB (&convert->in_info)) {
+    pixel_order = _RGB_pixel_order (gst_video_format_to_string (in_format),
+        "rgba");
+    if (!pixel_order)
+      return;
+
+    switch (out_format) {
+      case GST_VIDEO_FORMAT_NV12:
+      case GST_VIDEO_FORMAT_NV21:
+        source = g_strdup_printf (compute_RGB_to_NV12_NV21, pixel_order[0],
+            pixel_order[1], pixel_order[2], pixel_order[3],
+            out_format == GST_VIDEO_FORMAT_NV12 ? 'y' : 'z',
+            out_format == GST_VIDEO_FORMAT_NV12 ? 'z' : 'y');
+        convert->priv->image_names[0] = "Yimage";
+        convert->priv->image_formats[0] = GST_GL_RED;
+        convert->priv->image_names[1] = "UVimage";
+        convert->priv->image_formats[1] = GST_GL_RG;
+        break;
+      case GST_VIDEO_FORMAT_I420:
+      case GST_VIDEO_FORMAT_YV12:
+        /* the planes are written in the I420 order, see
+         * _do_convert_one_view() */
+        source = g_strdup_printf (compute_RGB_to_I420, pixel_order[0],
+            pixel_order[1], pixel_order[2], pixel_order[3]);
+        convert->priv->image_names[0] = "Yimage";
+        convert->priv->image_names[1] = "Uimage";
+        convert->priv->image_names[2] = "Vimage";
+        convert->priv->image_formats[0] = convert->priv->image_formats[1] =
+            convert->priv->image_formats[2] = GST_GL_RED;
+        break;
+      default:
+        break;
+    }
+  } else if (_is_4_byte_rgb (out_format)) {
+    pixel_order = _RGB_pixel_order ("rgba",
+        gst_video_format_to_string (out_format));
+    if (!pixel_order)
+      return;
+
+    switch (in_format) {
+      case GST_VIDEO_FORMAT_NV12:
+      case GST_VIDEO_FORMAT_NV21:
+      {
+        char val2 = convert->priv->in_tex_formats[1] == GST_GL_RG ? 'g' : 'a';
+
+        source = g_strdup_printf (compute_NV12_NV21_to_RGB,
+            in_format == GST_VIDEO_FORMAT_NV12 ? 'r' : val2,
+            in_format == GST_VIDEO_FORMAT_NV12 ? val2 : 'r', pixel_order[0],
+            pixel_order[1], pixel_order[2], pixel_order[3]);
+        break;
+      }
+      case GST_VIDEO_FORMAT_I420:
+      case GST_VIDEO_FORMAT_YV12:
+        /* the plane order is in info->shader_tex_names */
+        source = g_strdup_printf (compute_I420_to_RGB, pixel_order[0],
+            pixel_order[1], pixel_order[2], pixel_order[3]);
+        break;
+      default:
+        break;
+    }
+    convert->priv->image_names[0] = "image";
+    convert->priv->image_formats[0] = GST_GL_RGBA;
+  } else {
+    return;
+  }
+
+  g_free (pixel_order);
+  if (!source)
+    return;
+
+  profile = gst_gl_context_get_gl_api (context) & GST_GL_API_OPENGL3 ?
+      GST_GLSL_PROFILE_CORE : GST_GLSL_PROFILE_COMPATIBILITY;
+  convert->priv->compute_shader =
+      gst_gl_shader_new_link_with_stages (context, &error,
+      gst_glsl_stage_new_with_string (context, GL_COMPUTE_SHADER,
+          GST_GLSL_VERSION_430, profile, source), NULL);
+  g_free (source);
+
+  if (!convert->priv->compute_shader) {
+    GST_INFO_OBJECT (convert, "Failed to create the compute shader, using "
+        "the fragment shader instead: %s", error->message);
+    g_clear_error (&error);
+    return;
+  }
+
+  GST_INFO_OBJECT (convert, "Using a compute shader for %u output planes",
+      info->out_n_textures);
 }
 
 /* Called in the gl thread */
@@ -1952,7 +2288,6 @@ _init_convert (GstGLColorConvert * convert)
 {
   GstGLFuncs *gl;
   struct ConvertInfo *info = &convert->priv->convert_info;
-  gint i;
 
   gl = convert->context->gl_vtable;
 
@@ -2020,53 +2355,13 @@ _init_convert (GstGLColorConvert * convert)
   if (!(convert->shader = _create_shader (convert)))
     goto error;
 
+  _init_compute (convert);
+
   convert->priv->attr_position =
       gst_gl_shader_get_attribute_location (convert->shader, "a_position");
   convert->priv->attr_texture =
       gst_gl_shader_get_attribute_location (convert->shader, "a_texcoord");
 
-  gst_gl_shader_use (convert->shader);
-
-  if (info->cms_offset && info->cms_coeff1
-      && info->cms_coeff2 && info->cms_coeff3) {
-    gst_gl_shader_set_uniform_3fv (convert->shader, "offset", 1,
-        info->cms_offset);
-    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff1", 1,
-        info->cms_coeff1);
-    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff2", 1,
-        info->cms_coeff2);
-    gst_gl_shader_set_uniform_3fv (convert->shader, "coeff3", 1,
-        info->cms_coeff3);
-  }
-
-  for (i = info->in_n_textures; i >= 0; i--) {
-    if (info->shader_tex_names[i])
-      gst_gl_shader_set_uniform_1i (convert->shader, info->shader_tex_names[i],
-          i);
-  }
-
-  gst_gl_shader_set_uniform_1f (convert->shader, "width",
-      GST_VIDEO_INFO_WIDTH (&convert->in_info));
-  gst_gl_shader_set_uniform_1f (convert->shader, "height",
-      GST_VIDEO_INFO_HEIGHT (&convert->in_info));
-
-  if (convert->priv->from_texture_target == GST_GL_TEXTURE_TARGET_RECTANGLE) {
-    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_x", 1.);
-    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_y", 1.);
-  } else {
-    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_x",
-        1. / (gfloat) GST_VIDEO_INFO_WIDTH (&convert->in_info));
-    gst_gl_shader_set_uniform_1f (convert->shader, "poffset_y",
-        1. / (gfloat) GST_VIDEO_INFO_HEIGHT (&convert->in_info));
-  }
-
-  if (info->chroma_sampling[0] > 0.0f && info->chroma_sampling[1] > 0.0f) {
-    gst_gl_shader_set_uniform_2fv (convert->shader, "chroma_sampling", 1,
-        info->chroma_sampling);
-  }
-
-  gst_gl_context_clear_shader (convert->context);
-
   if (convert->fbo == NULL && !_init_convert_fbo (convert)) {
     goto error;
   }
@@ -2137,6 +2432,66 @@ _init_convert_fbo (GstGLColorConvert * convert)
   return convert->fbo != NULL;
 }
 
+static GLenum
+_image_format (GstGLFormat format)
+{
+  switch (format) {
+    case GST_GL_RED:
+      return GL_R8;
+    case GST_GL_RG:
+      return GL_RG8;
+    default:
+      return GL_RGBA8;
+  }
+}
+
+/* Called in the gl thread */
+static gboolean
+_do_convert_compute (GstGLContext * context, GstGLColorConvert * convert)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  struct ConvertInfo *c_info = &convert->priv->convert_info;
+  GstGLShader *shader = convert->priv->compute_shader;
+  gint width = GST_VIDEO_INFO_WIDTH (&convert->out_info);
+  gint height = GST_VIDEO_INFO_HEIGHT (&convert->out_info);
+  gint i;
+
+  gst_gl_shader_use (shader);
+
+  if (c_info->cms_offset && c_info->cms_coeff1
+      && c_info->cms_coeff2 && c_info->cms_coeff3) {
+    gst_gl_shader_set_uniform_3fv (shader, "offset", 1, c_info->cms_offset);
+    gst_gl_shader_set_uniform_3fv (shader, "coeff1", 1, c_info->cms_coeff1);
+    gst_gl_shader_set_uniform_3fv (shader, "coeff2", 1, c_info->cms_coeff2);
+    gst_gl_shader_set_uniform_3fv (shader, "coeff3", 1, c_info->cms_coeff3);
+  }
+  gst_gl_shader_set_uniform_2i (shader, "size", width, height);
+
+  for (i = c_info->in_n_textures - 1; i >= 0; i--) {
+    gl->ActiveTexture (GL_TEXTURE0 + i);
+    gl->BindTexture (GL_TEXTURE_2D, convert->priv->in_tex[i]->tex_id);
+    if (c_info->shader_tex_names[i])
+      gst_gl_shader_set_uniform_1i (shader, c_info->shader_tex_names[i], i);
+  }
+
+  for (i = 0; i < c_info->out_n_textures; i++) {
+    gl->BindImageTexture (i, convert->priv->out_tex[i]->tex_id, 0, GL_FALSE,
+        0, GL_WRITE_ONLY, _image_format (convert->priv->image_formats[i]));
+    gst_gl_shader_set_uniform_1i (shader, convert->priv->image_names[i], i);
+  }
+
+  /* 8x8 invocations per group, each covering 2x2 pixels */
+  gl->DispatchCompute ((width + 15) / 16, (height + 15) / 16, 1);
+  gl->MemoryBarrier (GL_ALL_BARRIER_BITS);
+
+  for (i = 0; i < c_info->out_n_textures; i++)
+    gl->BindImageTexture (i, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+  gst_gl_context_clear_shader (context);
+
+  return TRUE;
+}
+
 static gboolean
 _do_convert_one_view (GstGLContext * context, GstGLColorConvert * convert,
     guint view_num)
@@ -2148,6 +2503,7 @@ _do_convert_one_view (GstGLContext * context, GstGLColorConvert * convert,
   gint i, j = 0;
   const gint in_plane_offset = view_num * c_info->in_n_textures;
   const gint out_plane_offset = view_num * c_info->out_n_textures;
+  gboolean use_compute = convert->priv->compute_shader != NULL;
 
   out_width = GST_VIDEO_INFO_WIDTH (&convert->out_info);
   out_height = GST_VIDEO_INFO_HEIGHT (&convert->out_info);
@@ -2172,6 +2528,17 @@ _do_convert_one_view (GstGLContext * context, GstGLColorConvert * convert,
     }
   }
 
+  /* the compute shader writes the planes directly as images, which
+   * requires the formats it was built for */
+  for (j = 0; use_compute && j < c_info->out_n_textures; j++) {
+    GstMemory *mem = gst_buffer_peek_memory (convert->outbuf,
+        j + out_plane_offset);
+
+    if (!gst_is_gl_memory (mem)
+        || ((GstGLMemory *) mem)->tex_format != convert->priv->image_formats[j])
+      use_compute = FALSE;
+  }
+
   for (j = 0; j < c_info->out_n_textures; j++) {
     GstGLMemory *out_tex =
         (GstGLMemory *) gst_buffer_peek_memory (convert->outbuf,
@@ -2187,7 +2554,9 @@ _do_convert_one_view (GstGLContext * context, GstGLColorConvert * convert,
     mem_width = gst_gl_memory_get_texture_width (out_tex);
     mem_height = gst_gl_memory_get_texture_height (out_tex);
 
-    if (out_tex->tex_format == GST_GL_LUMINANCE
+    if (use_compute) {
+      convert->priv->out_tex[j] = out_tex;
+    } else if (out_tex->tex_format == GST_GL_LUMINANCE
         || out_tex->tex_format == GST_GL_LUMINANCE_ALPHA
         || out_width != mem_width || out_height != mem_height) {
       /* Luminance formats are not color renderable */
@@ -2234,8 +2603,12 @@ _do_convert_one_view (GstGLContext * context, GstGLColorConvert * convert,
       out_height, convert->priv->in_tex[0], convert->priv->in_tex[1],
       convert->priv->in_tex[2], convert->priv->in_tex[3], in_width, in_height);
 
-  if (!_do_convert_draw (context, convert))
+  if (use_compute) {
+    if (!_do_convert_compute (context, convert))
+      res = FALSE;
+  } else if (!_do_convert_draw (context, convert)) {
     res = FALSE;
+  }
 
 out:
   for (j--; j >= 0; j--) {
@@ -2249,9 +2622,9 @@ out:
     mem_width = gst_gl_memory_get_texture_width (out_tex);
     mem_height = gst_gl_memory_get_texture_height (out_tex);
 
-    if (out_tex->tex_format == GST_GL_LUMINANCE
-        || out_tex->tex_format == GST_GL_LUMINANCE_ALPHA
-        || out_width != mem_width || out_height != mem_height) {
+    if (!use_compute && (out_tex->tex_format == GST_GL_LUMINANCE
+            || out_tex->tex_format == GST_GL_LUMINANCE_ALPHA
+            || out_width != mem_width || out_height != mem_height)) {
       GstMapInfo to_info, from_info;
 
       if (!gst_memory_map ((GstMemory *) convert->priv->out_tex[j], &from_info,
@@ -2477,6 +2850,7 @@ _do_convert_draw (GstGLContext * context, GstGLColorConvert * convert)
   gl->Viewport (0, 0, out_width, out_height);
 
   gst_gl_shader_use (convert->shader);
+  _set_uniforms (convert);
 
   if (gl->BindVertexArray)
     gl->BindVertexArray (convert->priv->vao);
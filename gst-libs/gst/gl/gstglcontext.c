@@ -51,6 +51,7 @@
 #include "gstglfeature.h"
 #include "gstglfeature_private.h"
 #include "gstglfuncs.h"
+#include "gstglwindow_private.h"
 
 #ifndef GL_NUM_EXTENSIONS
 #define GL_NUM_EXTENSIONS 0x0000821d
@@ -221,8 +222,36 @@ struct _GstGLContextPrivate
   gint gl_minor;
 
   gchar *gl_exts;
+
+  volatile gint sync_waits;
+
+  /* GstGLCachedTexture's, most recently released first.  Only accessed from
+   * the GL thread */
+  GQueue cached_textures;
+  gsize cached_size;
+  gsize max_cached_size;
 };
 
+/* The released textures that can be reused by a new GstGLMemory of the same
+ * size and format, as allocating texture storage can be slow with some
+ * drivers */
+typedef struct
+{
+  guint tex_id;
+  guint target;
+  guint internal_format;
+  guint format;
+  guint type;
+  guint width;
+  guint height;
+  gsize size;
+  gint64 time;
+} GstGLCachedTexture;
+
+#define DEFAULT_TEXTURE_CACHE_SIZE (32 * 1024 * 1024)
+/* how long an unused texture is kept, in microseconds */
+#define TEXTURE_CACHE_MAX_AGE (5 * G_USEC_PER_SEC)
+
 typedef struct
 {
   GstGLContext parent;
@@ -284,6 +313,15 @@ gst_gl_context_init (GstGLContext * context)
   context->priv->created = FALSE;
 
   g_weak_ref_init (&context->priv->other_context_ref, NULL);
+
+  g_queue_init (&context->priv->cached_textures);
+  context->priv->max_cached_size = DEFAULT_TEXTURE_CACHE_SIZE;
+  {
+    const gchar *env = g_getenv ("GST_GL_TEXTURE_CACHE_SIZE");
+
+    if (env)
+      context->priv->max_cached_size = g_ascii_strtoull (env, NULL, 10);
+  }
 }
 
 static void
@@ -1313,6 +1351,8 @@ gst_gl_context_create_thread (GstGLContext * context)
   g_mutex_lock (&context->priv->render_lock);
   context->priv->alive = FALSE;
 
+  _gst_gl_context_clear_texture_cache (context);
+
   gst_gl_context_activate (context, FALSE);
 
   context_class->destroy_context (context);
@@ -1586,6 +1626,104 @@ gst_gl_context_thread_add (GstGLContext * context,
   gst_object_unref (window);
 }
 
+typedef struct
+{
+  RunGenericData run;
+  GDestroyNotify notify;
+} RunGenericAsyncData;
+
+static void
+_free_generic_async (RunGenericAsyncData * data)
+{
+  if (data->notify)
+    data->notify (data->run.data);
+
+  gst_object_unref (data->run.context);
+  g_slice_free (RunGenericAsyncData, data);
+}
+
+/**
+ * gst_gl_context_thread_add_async:
+ * @context: a #GstGLContext
+ * @func: (scope notified): a #GstGLContextThreadFunc
+ * @data: (closure): user data to call @func with
+ * @notify: (nullable): called with @data once @func has run
+ *
+ * Queue @func to be executed in the OpenGL thread of @context with @data
+ * without waiting for it.  The functions are executed in the order they
+ * were queued, also relative to gst_gl_context_thread_add(), and all the
+ * functions queued before the OpenGL thread wakes up are run at once.
+ * @notify can be used to know when @func has completed.
+ *
+ * MT-safe
+ *
+ * Since: 1.14
+ */
+void
+gst_gl_context_thread_add_async (GstGLContext * context,
+    GstGLContextThreadFunc func, gpointer data, GDestroyNotify notify)
+{
+  GstGLWindow *window;
+  RunGenericAsyncData *rdata;
+
+  g_return_if_fail (GST_IS_GL_CONTEXT (context));
+  g_return_if_fail (func != NULL);
+
+  if (GST_IS_GL_WRAPPED_CONTEXT (context))
+    g_return_if_fail (context->priv->active_thread == g_thread_self ());
+
+  if (context->priv->active_thread == g_thread_self ()) {
+    func (context, data);
+    if (notify)
+      notify (data);
+    return;
+  }
+
+  rdata = g_slice_new (RunGenericAsyncData);
+  rdata->run.context = gst_object_ref (context);
+  rdata->run.data = data;
+  rdata->run.func = func;
+  rdata->notify = notify;
+
+  window = gst_gl_context_get_window (context);
+
+  gst_gl_window_send_message_async (window,
+      GST_GL_WINDOW_CB (_gst_gl_context_thread_run_generic), rdata,
+      (GDestroyNotify) _free_generic_async);
+
+  gst_object_unref (window);
+}
+
+/**
+ * gst_gl_context_get_thread_message_count:
+ * @context: a #GstGLContext
+ *
+ * Retrieve how many functions were run in the OpenGL thread of @context
+ * through its #GstGLWindow, e.g. with gst_gl_context_thread_add().  Sampling
+ * it twice gives the rate of round trips into the OpenGL thread.
+ *
+ * Returns: the number of functions run so far
+ *
+ * Since: 1.14
+ */
+guint
+gst_gl_context_get_thread_message_count (GstGLContext * context)
+{
+  GstGLWindow *window;
+  guint ret;
+
+  g_return_val_if_fail (GST_IS_GL_CONTEXT (context), 0);
+
+  window = gst_gl_context_get_window (context);
+  if (!window)
+    return 0;
+
+  ret = _gst_gl_window_get_message_count (window);
+  gst_object_unref (window);
+
+  return ret;
+}
+
 /**
  * gst_gl_context_get_gl_version:
  * @context: a #GstGLContext
@@ -1741,6 +1879,134 @@ gst_gl_context_set_shared_with (GstGLContext * context, GstGLContext * share)
       _context_share_group_ref (share->priv->sharegroup);
 }
 
+/**
+ * gst_gl_context_get_sync_wait_count:
+ * @context: a #GstGLContext
+ *
+ * Retrieve how many times the CPU had to block while waiting on a
+ * #GstGLSyncMeta with @context, either because the sync point had not passed
+ * yet or because glFinish() was used for lack of fences.  This is meant to
+ * measure the stalls of a pipeline on the GPU.
+ *
+ * Returns: the number of blocking waits so far
+ *
+ * Since: 1.14
+ */
+guint
+gst_gl_context_get_sync_wait_count (GstGLContext * context)
+{
+  g_return_val_if_fail (GST_IS_GL_CONTEXT (context), 0);
+
+  return g_atomic_int_get (&context->priv->sync_waits);
+}
+
+void
+_gst_gl_context_add_sync_wait (GstGLContext * context)
+{
+  g_atomic_int_inc (&context->priv->sync_waits);
+}
+
+/* Deletes the cached textures from the oldest until the cache fits in
+ * @max_size, along with the ones unused for too long */
+static void
+_trim_texture_cache (GstGLContext * context, gsize max_size)
+{
+  GstGLContextPrivate *priv = context->priv;
+  const GstGLFuncs *gl = context->gl_vtable;
+  gint64 now = g_get_monotonic_time ();
+  GstGLCachedTexture *tex;
+
+  while ((tex = g_queue_peek_tail (&priv->cached_textures))) {
+    if (priv->cached_size <= max_size && now - tex->time < TEXTURE_CACHE_MAX_AGE)
+      break;
+
+    GST_TRACE_OBJECT (context, "deleting cached texture %u %ux%u",
+        tex->tex_id, tex->width, tex->height);
+
+    g_queue_pop_tail (&priv->cached_textures);
+    priv->cached_size -= tex->size;
+    gl->DeleteTextures (1, &tex->tex_id);
+    g_slice_free (GstGLCachedTexture, tex);
+  }
+}
+
+/* Returns a cached texture with the given parameters, or 0 if there is none.
+ * Must be called in the GL thread */
+guint
+_gst_gl_context_take_cached_texture (GstGLContext * context, guint target,
+    guint internal_format, guint format, guint type, guint width, guint height)
+{
+  GstGLContextPrivate *priv = context->priv;
+  GList *l;
+
+  _trim_texture_cache (context, priv->max_cached_size);
+
+  for (l = priv->cached_textures.head; l; l = l->next) {
+    GstGLCachedTexture *tex = l->data;
+    guint tex_id;
+
+    if (tex->target != target || tex->internal_format != internal_format
+        || tex->format != format || tex->type != type || tex->width != width
+        || tex->height != height)
+      continue;
+
+    tex_id = tex->tex_id;
+    GST_TRACE_OBJECT (context, "reusing cached texture %u %ux%u", tex_id,
+        width, height);
+
+    priv->cached_size -= tex->size;
+    g_queue_delete_link (&priv->cached_textures, l);
+    g_slice_free (GstGLCachedTexture, tex);
+
+    return tex_id;
+  }
+
+  return 0;
+}
+
+/* Keeps @tex_id for a later _gst_gl_context_take_cached_texture().  Returns
+ * %FALSE if the texture is not cached and must be deleted by the caller.
+ * Must be called in the GL thread */
+gboolean
+_gst_gl_context_cache_texture (GstGLContext * context, guint tex_id,
+    guint target, guint internal_format, guint format, guint type,
+    guint width, guint height, gsize size)
+{
+  GstGLContextPrivate *priv = context->priv;
+  GstGLCachedTexture *tex;
+
+  /* nothing would delete the textures of a wrapped context before it goes
+   * away */
+  if (GST_IS_GL_WRAPPED_CONTEXT (context) || !priv->alive
+      || size > priv->max_cached_size)
+    return FALSE;
+
+  tex = g_slice_new (GstGLCachedTexture);
+  tex->tex_id = tex_id;
+  tex->target = target;
+  tex->internal_format = internal_format;
+  tex->format = format;
+  tex->type = type;
+  tex->width = width;
+  tex->height = height;
+  tex->size = size;
+  tex->time = g_get_monotonic_time ();
+
+  g_queue_push_head (&priv->cached_textures, tex);
+  priv->cached_size += size;
+
+  _trim_texture_cache (context, priv->max_cached_size);
+
+  return TRUE;
+}
+
+/* Must be called in the GL thread */
+void
+_gst_gl_context_clear_texture_cache (GstGLContext * context)
+{
+  _trim_texture_cache (context, 0);
+}
+
 static void
 gst_gl_context_default_get_gl_platform_version (GstGLContext * context,
     gint * major, gint * minor)
@@ -1794,6 +2060,66 @@ gst_gl_context_swap_buffers (GstGLContext * context)
   context_class->swap_buffers (context);
 }
 
+/**
+ * gst_gl_context_set_swap_interval:
+ * @context: a #GstGLContext
+ * @interval: the number of vertical refreshes to wait for, 0 for none
+ *
+ * Sets the number of vertical refreshes gst_gl_context_swap_buffers() waits
+ * for before presenting the frame.  Must be called in @context's thread,
+ * with a window attached.
+ *
+ * Returns: whether the interval could be set
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_gl_context_set_swap_interval (GstGLContext * context, gint interval)
+{
+  GstGLContextClass *context_class;
+
+  g_return_val_if_fail (GST_IS_GL_CONTEXT (context), FALSE);
+  g_return_val_if_fail (interval >= 0, FALSE);
+  context_class = GST_GL_CONTEXT_GET_CLASS (context);
+
+  if (!context_class->set_swap_interval)
+    return FALSE;
+
+  return context_class->set_swap_interval (context, interval);
+}
+
+/**
+ * gst_gl_context_get_last_vsync:
+ * @context: a #GstGLContext
+ * @time: (out): the time of the last vertical refresh, in the
+ *     g_get_monotonic_time() timebase
+ * @count: (out) (allow-none): the number of vertical refreshes so far
+ *
+ * Retrieves when the display attached to the window of @context last
+ * refreshed, for scheduling the frames in phase with the display.  Must be
+ * called in @context's thread.
+ *
+ * Returns: whether the platform reports the vertical refreshes
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_gl_context_get_last_vsync (GstGLContext * context, gint64 * time,
+    guint64 * count)
+{
+  GstGLContextClass *context_class;
+  guint64 tmp;
+
+  g_return_val_if_fail (GST_IS_GL_CONTEXT (context), FALSE);
+  g_return_val_if_fail (time != NULL, FALSE);
+  context_class = GST_GL_CONTEXT_GET_CLASS (context);
+
+  if (!context_class->get_last_vsync)
+    return FALSE;
+
+  return context_class->get_last_vsync (context, time, count ? count : &tmp);
+}
+
 static GstGLAPI
 gst_gl_wrapped_context_get_gl_api (GstGLContext * context)
 {
@@ -120,6 +120,10 @@ struct _GstGLContext {
  * @create_context: create the OpenGL context
  * @destroy_context: destroy the OpenGL context
  * @swap_buffers: swap the default framebuffer's front/back buffers
+ * @set_swap_interval: set how many vertical refreshes a swap waits for.
+ *     Since: 1.14
+ * @get_last_vsync: retrieve the time and count of the last vertical
+ *     refresh.  Since: 1.14
  */
 struct _GstGLContextClass {
   GstObjectClass parent_class;
@@ -137,9 +141,11 @@ struct _GstGLContextClass {
   void          (*swap_buffers)       (GstGLContext *context);
   gboolean      (*check_feature)      (GstGLContext *context, const gchar *feature);
   void          (*get_gl_platform_version) (GstGLContext *context, gint *major, gint *minor);
+  gboolean      (*set_swap_interval)  (GstGLContext *context, gint interval);
+  gboolean      (*get_last_vsync)     (GstGLContext *context, gint64 *time, guint64 *count);
 
   /*< private >*/
-  gpointer _reserved[GST_PADDING];
+  gpointer _reserved[GST_PADDING - 2];
 };
 
 /* methods */
@@ -172,6 +178,10 @@ guintptr      gst_gl_context_get_gl_context   (GstGLContext *context);
 GST_EXPORT
 gboolean      gst_gl_context_can_share        (GstGLContext * context, GstGLContext *other_context);
 GST_EXPORT
+gboolean      gst_gl_context_set_swap_interval (GstGLContext * context, gint interval);
+GST_EXPORT
+gboolean      gst_gl_context_get_last_vsync (GstGLContext * context, gint64 * time, guint64 * count);
+GST_EXPORT
 void          gst_gl_context_swap_buffers     (GstGLContext * context);
 
 GST_EXPORT
@@ -207,6 +217,8 @@ GST_EXPORT
 gboolean      gst_gl_context_is_shared                  (GstGLContext * context);
 GST_EXPORT
 void          gst_gl_context_set_shared_with            (GstGLContext * context, GstGLContext * share);
+GST_EXPORT
+guint         gst_gl_context_get_sync_wait_count        (GstGLContext * context);
 
 GST_EXPORT
 gboolean gst_gl_context_fill_info (GstGLContext * context, GError ** error);
@@ -215,6 +227,11 @@ gboolean gst_gl_context_fill_info (GstGLContext * context, GError ** error);
 GST_EXPORT
 void gst_gl_context_thread_add (GstGLContext * context,
     GstGLContextThreadFunc func, gpointer data);
+GST_EXPORT
+void gst_gl_context_thread_add_async (GstGLContext * context,
+    GstGLContextThreadFunc func, gpointer data, GDestroyNotify notify);
+GST_EXPORT
+guint gst_gl_context_get_thread_message_count (GstGLContext * context);
 
 G_END_DECLS
 
@@ -21,11 +21,32 @@
 #define __GST_GL_CONTEXT_PRIVATE_H__
 
 #include <gst/gst.h>
+#include <gst/gl/gstgl_fwd.h>
 
 G_BEGIN_DECLS
 
 G_GNUC_INTERNAL extern GstDebugCategory *gst_gl_context_debug;
 
+G_GNUC_INTERNAL void _gst_gl_context_add_sync_wait (GstGLContext * context);
+
+G_GNUC_INTERNAL guint _gst_gl_context_take_cached_texture (GstGLContext * context,
+                                                          guint target,
+                                                          guint internal_format,
+                                                          guint format,
+                                                          guint type,
+                                                          guint width,
+                                                          guint height);
+G_GNUC_INTERNAL gboolean _gst_gl_context_cache_texture (GstGLContext * context,
+                                                       guint tex_id,
+                                                       guint target,
+                                                       guint internal_format,
+                                                       guint format,
+                                                       guint type,
+                                                       guint width,
+                                                       guint height,
+                                                       gsize size);
+G_GNUC_INTERNAL void _gst_gl_context_clear_texture_cache (GstGLContext * context);
+
 G_END_DECLS
 
 #endif /* __GST_GL_CONTEXT_PRIVATE_H__ */
@@ -28,6 +28,7 @@
 
 #include "gl.h"
 #include "gstglfuncs.h"
+#include "gstglcontext_private.h"
 
 /**
  * SECTION:gstglmemory
@@ -235,36 +236,65 @@ _new_texture (GstGLContext * context, guint target, guint internal_format,
   return tex_id;
 }
 
+static void
+_get_tex_format_type (GstGLMemory * gl_mem, GLenum * internal_format,
+    GLenum * tex_format, GLenum * tex_type)
+{
+  *tex_format = gl_mem->tex_format;
+  *tex_type = GL_UNSIGNED_BYTE;
+  if (gl_mem->tex_format == GST_GL_RGB565) {
+    *tex_format = GST_GL_RGB;
+    *tex_type = GL_UNSIGNED_SHORT_5_6_5;
+  }
+
+  *internal_format =
+      gst_gl_sized_gl_format_from_gl_format_type (gl_mem->mem.context,
+      *tex_format, *tex_type);
+}
+
 static gboolean
 _gl_tex_create (GstGLMemory * gl_mem, GError ** error)
 {
   GstGLContext *context = gl_mem->mem.context;
+  const GstGLFuncs *gl = context->gl_vtable;
   GLenum internal_format;
   GLenum tex_format;
   GLenum tex_type;
+  guint target;
 
-  tex_format = gl_mem->tex_format;
-  tex_type = GL_UNSIGNED_BYTE;
-  if (gl_mem->tex_format == GST_GL_RGB565) {
-    tex_format = GST_GL_RGB;
-    tex_type = GL_UNSIGNED_SHORT_5_6_5;
-  }
+  if (gl_mem->texture_wrapped)
+    return TRUE;
 
-  internal_format =
-      gst_gl_sized_gl_format_from_gl_format_type (context, tex_format,
-      tex_type);
+  _get_tex_format_type (gl_mem, &internal_format, &tex_format, &tex_type);
+  target = gst_gl_texture_target_to_gl (gl_mem->tex_target);
 
-  if (!gl_mem->texture_wrapped) {
-    gl_mem->tex_id =
-        _new_texture (context, gst_gl_texture_target_to_gl (gl_mem->tex_target),
-        internal_format, tex_format, tex_type, gl_mem->tex_width,
-        GL_MEM_HEIGHT (gl_mem));
+  /* a texture released with the same storage avoids the allocation, see
+   * _gl_tex_destroy() */
+  gl_mem->tex_id = _gst_gl_context_take_cached_texture (context, target,
+      internal_format, tex_format, tex_type, gl_mem->tex_width,
+      GL_MEM_HEIGHT (gl_mem));
+  if (gl_mem->tex_id) {
+    /* the previous user may have changed the sampling */
+    gl->BindTexture (target, gl_mem->tex_id);
+    gl->TexParameteri (target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl->TexParameteri (target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl->TexParameteri (target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->TexParameteri (target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->BindTexture (target, 0);
 
-    GST_TRACE ("Generating texture id:%u format:%u type:%u dimensions:%ux%u",
+    GST_TRACE ("Reusing texture id:%u format:%u type:%u dimensions:%ux%u",
         gl_mem->tex_id, tex_format, tex_type, gl_mem->tex_width,
         GL_MEM_HEIGHT (gl_mem));
+    return TRUE;
   }
 
+  gl_mem->tex_id = _new_texture (context, target, internal_format, tex_format,
+      tex_type, gl_mem->tex_width, GL_MEM_HEIGHT (gl_mem));
+
+  GST_TRACE ("Generating texture id:%u format:%u type:%u dimensions:%ux%u",
+      gl_mem->tex_id, tex_format, tex_type, gl_mem->tex_width,
+      GL_MEM_HEIGHT (gl_mem));
+
   return TRUE;
 }
 
@@ -895,9 +925,32 @@ _gl_tex_alloc (GstAllocator * allocator, gsize size,
 static void
 _gl_tex_destroy (GstGLMemory * gl_mem)
 {
-  const GstGLFuncs *gl = gl_mem->mem.context->gl_vtable;
+  GstGLContext *context = gl_mem->mem.context;
+  const GstGLFuncs *gl = context->gl_vtable;
+  GLenum internal_format, tex_format, tex_type;
+  guint target;
+  gsize size;
+
+  if (!gl_mem->tex_id || gl_mem->texture_wrapped)
+    return;
+
+  /* external textures have no storage of their own to reuse */
+  if (gl_mem->tex_target == GST_GL_TEXTURE_TARGET_EXTERNAL_OES) {
+    gl->DeleteTextures (1, &gl_mem->tex_id);
+    return;
+  }
 
-  if (gl_mem->tex_id && !gl_mem->texture_wrapped)
+  _get_tex_format_type (gl_mem, &internal_format, &tex_format, &tex_type);
+  target = gst_gl_texture_target_to_gl (gl_mem->tex_target);
+  size = (gsize) gst_gl_format_type_n_bytes (tex_format, tex_type) *
+      gl_mem->tex_width * GL_MEM_HEIGHT (gl_mem);
+
+  /* keep the storage around for the next allocation of the same size, e.g.
+   * when a buffer pool is recreated or switches back and forth between
+   * resolutions */
+  if (!_gst_gl_context_cache_texture (context, gl_mem->tex_id, target,
+          internal_format, tex_format, tex_type, gl_mem->tex_width,
+          GL_MEM_HEIGHT (gl_mem), size))
     gl->DeleteTextures (1, &gl_mem->tex_id);
 }
 
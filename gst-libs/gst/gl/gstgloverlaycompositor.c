@@ -23,6 +23,12 @@
  * @title: GstGLOverlayCompositor
  * @short_description: Composite multiple overlays using OpenGL
  * @see_also: #GstGLMemory, #GstGLContext
+ *
+ * #GstGLOverlayCompositor draws the #GstVideoOverlayComposition attached to
+ * buffers.  Each rectangle is uploaded once, as long as it keeps the same
+ * seqnum, into a texture atlas shared by all the rectangles, so that they
+ * are all drawn from one vertex buffer in a single draw call.  The
+ * rectangles too large for the atlas get a texture of their own.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -30,6 +36,7 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #include "gstgloverlaycompositor.h"
 
@@ -74,23 +81,35 @@ const gchar *fragment_shader =
   "}";
 /* *INDENT-ON* */
 
+/* the size of the texture the rectangles are packed into */
+#define ATLAS_SIZE 1024
+/* transparent pixels left around the rectangles in the atlas, so that linear
+ * filtering does not pick up the neighbours */
+#define ATLAS_PADDING 1
+/* x, y, z, w, s, t per vertex */
+#define VERTEX_SIZE 6
+
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+
 struct _GstGLCompositionOverlay
 {
   GstObject parent;
   GstGLContext *context;
 
-  GLuint vao;
-  GLuint index_buffer;
-  GLuint position_buffer;
-  GLuint texcoord_buffer;
-  GLint position_attrib;
-  GLint texcoord_attrib;
-
-  GLfloat positions[16];
-
-  GLuint texture_id;
-  GstGLMemory *gl_memory;
   GstVideoOverlayRectangle *rectangle;
+  guint seqnum;
+  guint width;
+  guint height;
+
+  /* where the pixels are, either the atlas or a texture of their own for
+   * the rectangles that don't fit */
+  gboolean uploaded;
+  gboolean in_atlas;
+  guint atlas_x;
+  guint atlas_y;
+  GLuint texture_id;
 };
 
 struct _GstGLCompositionOverlayClass
@@ -102,112 +121,19 @@ G_DEFINE_TYPE (GstGLCompositionOverlay, gst_gl_composition_overlay,
     GST_TYPE_OBJECT);
 
 static void
-gst_gl_composition_overlay_init_vertex_buffer (GstGLContext * context,
-    gpointer overlay_pointer)
-{
-  const GstGLFuncs *gl = context->gl_vtable;
-  GstGLCompositionOverlay *overlay =
-      (GstGLCompositionOverlay *) overlay_pointer;
-
-  /* *INDENT-OFF* */
-  static const GLfloat texcoords[] = {
-      1.0f, 0.0f,
-      0.0f, 0.0f,
-      0.0f, 1.0f,
-      1.0f, 1.0f
-  };
-
-  static const GLushort indices[] = {
-    0, 1, 2, 0, 2, 3
-  };
-  /* *INDENT-ON* */
-
-  if (gl->GenVertexArrays) {
-    gl->GenVertexArrays (1, &overlay->vao);
-    gl->BindVertexArray (overlay->vao);
-  }
-
-  gl->GenBuffers (1, &overlay->position_buffer);
-  gl->BindBuffer (GL_ARRAY_BUFFER, overlay->position_buffer);
-  gl->BufferData (GL_ARRAY_BUFFER, 4 * 4 * sizeof (GLfloat), overlay->positions,
-      GL_STATIC_DRAW);
-
-  /* Load the vertex position */
-  gl->VertexAttribPointer (overlay->position_attrib, 4, GL_FLOAT, GL_FALSE,
-      4 * sizeof (GLfloat), NULL);
-
-  gl->GenBuffers (1, &overlay->texcoord_buffer);
-  gl->BindBuffer (GL_ARRAY_BUFFER, overlay->texcoord_buffer);
-  gl->BufferData (GL_ARRAY_BUFFER, 4 * 2 * sizeof (GLfloat), texcoords,
-      GL_STATIC_DRAW);
-
-  /* Load the texture coordinate */
-  gl->VertexAttribPointer (overlay->texcoord_attrib, 2, GL_FLOAT, GL_FALSE,
-      2 * sizeof (GLfloat), NULL);
-
-  gl->GenBuffers (1, &overlay->index_buffer);
-  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, overlay->index_buffer);
-  gl->BufferData (GL_ELEMENT_ARRAY_BUFFER, sizeof (indices), indices,
-      GL_STATIC_DRAW);
-
-  gl->EnableVertexAttribArray (overlay->position_attrib);
-  gl->EnableVertexAttribArray (overlay->texcoord_attrib);
-
-  if (gl->GenVertexArrays) {
-    gl->BindVertexArray (0);
-  }
-
-  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
-  gl->BindBuffer (GL_ARRAY_BUFFER, 0);
-}
-
-static void
-gst_gl_composition_overlay_free_vertex_buffer (GstGLContext * context,
+gst_gl_composition_overlay_free_texture (GstGLContext * context,
     gpointer overlay_pointer)
 {
   const GstGLFuncs *gl = context->gl_vtable;
   GstGLCompositionOverlay *overlay =
       (GstGLCompositionOverlay *) overlay_pointer;
-  if (overlay->vao) {
-    gl->DeleteVertexArrays (1, &overlay->vao);
-    overlay->vao = 0;
-  }
-
-  if (overlay->position_buffer) {
-    gl->DeleteBuffers (1, &overlay->position_buffer);
-    overlay->position_buffer = 0;
-  }
-
-  if (overlay->texcoord_buffer) {
-    gl->DeleteBuffers (1, &overlay->position_buffer);
-    overlay->position_buffer = 0;
-  }
 
-  if (overlay->index_buffer) {
-    gl->DeleteBuffers (1, &overlay->index_buffer);
-    overlay->index_buffer = 0;
+  if (overlay->texture_id) {
+    gl->DeleteTextures (1, &overlay->texture_id);
+    overlay->texture_id = 0;
   }
 }
 
-static void
-gst_gl_composition_overlay_bind_vertex_buffer (GstGLCompositionOverlay *
-    overlay)
-{
-  const GstGLFuncs *gl = overlay->context->gl_vtable;
-  gl->BindBuffer (GL_ARRAY_BUFFER, overlay->position_buffer);
-  gl->VertexAttribPointer (overlay->position_attrib, 4, GL_FLOAT, GL_FALSE,
-      4 * sizeof (GLfloat), NULL);
-
-  gl->BindBuffer (GL_ARRAY_BUFFER, overlay->texcoord_buffer);
-  gl->VertexAttribPointer (overlay->texcoord_attrib, 2, GL_FLOAT, GL_FALSE,
-      2 * sizeof (GLfloat), NULL);
-
-  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, overlay->index_buffer);
-
-  gl->EnableVertexAttribArray (overlay->position_attrib);
-  gl->EnableVertexAttribArray (overlay->texcoord_attrib);
-}
-
 static void
 gst_gl_composition_overlay_finalize (GObject * object)
 {
@@ -215,15 +141,16 @@ gst_gl_composition_overlay_finalize (GObject * object)
 
   overlay = GST_GL_COMPOSITION_OVERLAY (object);
 
-  if (overlay->gl_memory)
-    gst_memory_unref ((GstMemory *) overlay->gl_memory);
-
   if (overlay->context) {
-    gst_gl_context_thread_add (overlay->context,
-        gst_gl_composition_overlay_free_vertex_buffer, overlay);
+    if (overlay->texture_id)
+      gst_gl_context_thread_add (overlay->context,
+          gst_gl_composition_overlay_free_texture, overlay);
     gst_object_unref (overlay->context);
   }
 
+  if (overlay->rectangle)
+    gst_video_overlay_rectangle_unref (overlay->rectangle);
+
   G_OBJECT_CLASS (gst_gl_composition_overlay_parent_class)->finalize (object);
 }
 
@@ -239,182 +166,139 @@ gst_gl_composition_overlay_init (GstGLCompositionOverlay * overlay)
 {
 }
 
-static void
-gst_gl_composition_overlay_add_transformation (GstGLCompositionOverlay *
-    overlay, GstBuffer * video_buffer)
-{
-  gint comp_x, comp_y;
-  guint comp_width, comp_height;
-  GstVideoMeta *meta;
-  guint width, height;
-
-  float rel_x, rel_y, rel_w, rel_h;
-
-  meta = gst_buffer_get_video_meta (video_buffer);
-
-  gst_video_overlay_rectangle_get_render_rectangle (overlay->rectangle,
-      &comp_x, &comp_y, &comp_width, &comp_height);
-
-  width = meta->width;
-  height = meta->height;
-
-  /* calculate relative position */
-  rel_x = (float) comp_x / (float) width;
-  rel_y = (float) comp_y / (float) height;
-
-  rel_w = (float) comp_width / (float) width;
-  rel_h = (float) comp_height / (float) height;
-
-  /* transform from [0,1] to [-1,1], invert y axis */
-  rel_x = rel_x * 2.0 - 1.0;
-  rel_y = (1.0 - rel_y) * 2.0 - 1.0;
-  rel_w = rel_w * 2.0;
-  rel_h = rel_h * 2.0;
-
-  /* initialize position array */
-  overlay->positions[0] = rel_x + rel_w;
-  overlay->positions[1] = rel_y;
-  overlay->positions[2] = 0.0;
-  overlay->positions[3] = 1.0;
-  overlay->positions[4] = rel_x;
-  overlay->positions[5] = rel_y;
-  overlay->positions[6] = 0.0;
-  overlay->positions[7] = 1.0;
-  overlay->positions[8] = rel_x;
-  overlay->positions[9] = rel_y - rel_h;
-  overlay->positions[10] = 0.0;
-  overlay->positions[11] = 1.0;
-  overlay->positions[12] = rel_x + rel_w;
-  overlay->positions[13] = rel_y - rel_h;
-  overlay->positions[14] = 0.0;
-  overlay->positions[15] = 1.0;
-
-  gst_gl_context_thread_add (overlay->context,
-      gst_gl_composition_overlay_free_vertex_buffer, overlay);
-
-  gst_gl_context_thread_add (overlay->context,
-      gst_gl_composition_overlay_init_vertex_buffer, overlay);
-
-  GST_DEBUG
-      ("overlay position: (%d,%d) size: %dx%d video size: %dx%d",
-      comp_x, comp_y, comp_width, comp_height, meta->width, meta->height);
-}
-
 /* helper object API functions */
 
 static GstGLCompositionOverlay *
 gst_gl_composition_overlay_new (GstGLContext * context,
-    GstVideoOverlayRectangle * rectangle,
-    GLint position_attrib, GLint texcoord_attrib)
+    GstVideoOverlayRectangle * rectangle)
 {
   GstGLCompositionOverlay *overlay =
       g_object_new (GST_TYPE_GL_COMPOSITION_OVERLAY, NULL);
+  GstBuffer *comp_buffer;
+  GstVideoMeta *vmeta;
 
-  overlay->gl_memory = NULL;
-  overlay->texture_id = -1;
-  overlay->rectangle = rectangle;
+  overlay->rectangle = gst_video_overlay_rectangle_ref (rectangle);
+  overlay->seqnum = gst_video_overlay_rectangle_get_seqnum (rectangle);
   overlay->context = gst_object_ref (context);
-  overlay->vao = 0;
-  overlay->position_attrib = position_attrib;
-  overlay->texcoord_attrib = texcoord_attrib;
+
+  comp_buffer =
+      gst_video_overlay_rectangle_get_pixels_unscaled_argb (rectangle,
+      GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
+  vmeta = gst_buffer_get_video_meta (comp_buffer);
+  overlay->width = vmeta->width;
+  overlay->height = vmeta->height;
 
   GST_DEBUG_OBJECT (overlay, "Created new GstGLCompositionOverlay");
 
   return overlay;
 }
 
-static void
-_video_frame_unmap_and_free (gpointer user_data)
-{
-  GstVideoFrame *frame = user_data;
-
-  gst_video_frame_unmap (frame);
-  g_slice_free (GstVideoFrame, frame);
-}
-
-static void
+/* Uploads the pixels of @overlay at @x,@y of the bound 2D texture */
+static gboolean
 gst_gl_composition_overlay_upload (GstGLCompositionOverlay * overlay,
-    GstBuffer * buf)
+    guint x, guint y)
 {
-  GstGLMemory *comp_gl_memory = NULL;
-  GstBuffer *comp_buffer = NULL;
-  GstBuffer *overlay_buffer = NULL;
-  GstVideoInfo vinfo;
+  const GstGLFuncs *gl = overlay->context->gl_vtable;
+  GstBuffer *comp_buffer;
   GstVideoMeta *vmeta;
-  GstVideoFrame *comp_frame;
-  GstVideoFrame gl_frame;
+  GstVideoInfo vinfo;
+  GstVideoFrame frame;
+  const guint8 *data;
+  gint stride;
 
   comp_buffer =
       gst_video_overlay_rectangle_get_pixels_unscaled_argb (overlay->rectangle,
       GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
 
-  comp_frame = g_slice_new (GstVideoFrame);
-
   vmeta = gst_buffer_get_video_meta (comp_buffer);
   gst_video_info_set_format (&vinfo, vmeta->format, vmeta->width,
       vmeta->height);
   vinfo.stride[0] = vmeta->stride[0];
 
-  if (gst_video_frame_map (comp_frame, &vinfo, comp_buffer, GST_MAP_READ)) {
-    GstGLVideoAllocationParams *params;
-    GstGLBaseMemoryAllocator *mem_allocator;
-    GstAllocator *allocator;
+  if (!gst_video_frame_map (&frame, &vinfo, comp_buffer, GST_MAP_READ)) {
+    GST_WARNING_OBJECT (overlay, "Cannot map overlay pixels");
+    return FALSE;
+  }
 
-    allocator =
-        GST_ALLOCATOR (gst_gl_memory_allocator_get_default (overlay->context));
-    mem_allocator = GST_GL_BASE_MEMORY_ALLOCATOR (allocator);
+  data = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+
+  gl->PixelStorei (GL_UNPACK_ALIGNMENT, 4);
+  if (stride == overlay->width * 4) {
+    gl->TexSubImage2D (GL_TEXTURE_2D, 0, x, y, overlay->width,
+        overlay->height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+  } else if (gst_gl_context_check_gl_version (overlay->context,
+          GST_GL_API_OPENGL | GST_GL_API_OPENGL3, 1, 0)
+      || gst_gl_context_check_gl_version (overlay->context,
+          GST_GL_API_GLES2, 3, 0)) {
+    gl->PixelStorei (GL_UNPACK_ROW_LENGTH, stride / 4);
+    gl->TexSubImage2D (GL_TEXTURE_2D, 0, x, y, overlay->width,
+        overlay->height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    gl->PixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+  } else {
+    guint i;
 
-    gst_gl_composition_overlay_add_transformation (overlay, buf);
+    for (i = 0; i < overlay->height; i++)
+      gl->TexSubImage2D (GL_TEXTURE_2D, 0, x, y + i, overlay->width, 1,
+          GL_RGBA, GL_UNSIGNED_BYTE, data + i * stride);
+  }
 
-    params = gst_gl_video_allocation_params_new_wrapped_data (overlay->context,
-        NULL, &comp_frame->info, 0, NULL, GST_GL_TEXTURE_TARGET_2D,
-        GST_GL_RGBA, comp_frame->data[0], comp_frame,
-        _video_frame_unmap_and_free);
+  gst_video_frame_unmap (&frame);
 
-    comp_gl_memory =
-        (GstGLMemory *) gst_gl_base_memory_alloc (mem_allocator,
-        (GstGLAllocationParams *) params);
+  GST_DEBUG ("uploaded overlay %u (%ux%u) at %u,%u", overlay->seqnum,
+      overlay->width, overlay->height, x, y);
 
-    gst_gl_allocation_params_free ((GstGLAllocationParams *) params);
-    gst_object_unref (allocator);
+  return TRUE;
+}
 
-    overlay_buffer = gst_buffer_new ();
-    gst_buffer_append_memory (overlay_buffer, (GstMemory *) comp_gl_memory);
+/* Fills the 4 vertices of the quad drawing @overlay over a @width x @height
+ * video, with the texture coordinates of its pixels */
+static void
+gst_gl_composition_overlay_get_vertices (GstGLCompositionOverlay * overlay,
+    guint width, guint height, guint atlas_size, GLfloat * vertices)
+{
+  gint comp_x, comp_y;
+  guint comp_width, comp_height;
+  float rel_x, rel_y, rel_w, rel_h;
+  float s0 = 0.0f, t0 = 0.0f, s1 = 1.0f, t1 = 1.0f;
+  gint i;
 
-    if (!gst_video_frame_map (&gl_frame, &comp_frame->info, overlay_buffer,
-            GST_MAP_READ | GST_MAP_GL)) {
-      gst_buffer_unref (overlay_buffer);
-      _video_frame_unmap_and_free (comp_frame);
-      GST_WARNING_OBJECT (overlay, "Cannot upload overlay texture");
-      return;
-    }
+  gst_video_overlay_rectangle_get_render_rectangle (overlay->rectangle,
+      &comp_x, &comp_y, &comp_width, &comp_height);
 
-    gst_memory_ref ((GstMemory *) comp_gl_memory);
-    overlay->gl_memory = comp_gl_memory;
-    overlay->texture_id = comp_gl_memory->tex_id;
+  /* calculate relative position */
+  rel_x = (float) comp_x / (float) width;
+  rel_y = (float) comp_y / (float) height;
 
-    gst_buffer_unref (overlay_buffer);
-    gst_video_frame_unmap (&gl_frame);
+  rel_w = (float) comp_width / (float) width;
+  rel_h = (float) comp_height / (float) height;
 
-    GST_DEBUG ("uploaded overlay texture %d", overlay->texture_id);
-  } else {
-    g_slice_free (GstVideoFrame, comp_frame);
+  /* transform from [0,1] to [-1,1], invert y axis */
+  rel_x = rel_x * 2.0 - 1.0;
+  rel_y = (1.0 - rel_y) * 2.0 - 1.0;
+  rel_w = rel_w * 2.0;
+  rel_h = rel_h * 2.0;
+
+  if (overlay->in_atlas) {
+    s0 = (float) overlay->atlas_x / atlas_size;
+    t0 = (float) overlay->atlas_y / atlas_size;
+    s1 = (float) (overlay->atlas_x + overlay->width) / atlas_size;
+    t1 = (float) (overlay->atlas_y + overlay->height) / atlas_size;
   }
-}
 
-static void
-gst_gl_composition_overlay_draw (GstGLCompositionOverlay * overlay,
-    GstGLShader * shader)
-{
-  const GstGLFuncs *gl = overlay->context->gl_vtable;
-  if (gl->GenVertexArrays)
-    gl->BindVertexArray (overlay->vao);
-  else
-    gst_gl_composition_overlay_bind_vertex_buffer (overlay);
+  /* *INDENT-OFF* */
+  {
+    const GLfloat quad[4 * VERTEX_SIZE] = {
+      rel_x + rel_w, rel_y,         0.0, 1.0, s1, t0,
+      rel_x,         rel_y,         0.0, 1.0, s0, t0,
+      rel_x,         rel_y - rel_h, 0.0, 1.0, s0, t1,
+      rel_x + rel_w, rel_y - rel_h, 0.0, 1.0, s1, t1,
+    };
+  /* *INDENT-ON* */
 
-  if (overlay->texture_id != -1)
-    gl->BindTexture (GL_TEXTURE_2D, overlay->texture_id);
-  gl->DrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+    for (i = 0; i < 4 * VERTEX_SIZE; i++)
+      vertices[i] = quad[i];
+  }
 }
 
 
@@ -427,24 +311,44 @@ gst_gl_composition_overlay_draw (GstGLCompositionOverlay * overlay,
   GST_DEBUG_CATEGORY_INIT (gst_gl_overlay_compositor_debug, \
       "gloverlaycompositor", 0, "overlaycompositor");
 
+#define GST_GL_OVERLAY_COMPOSITOR_GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE((o), GST_TYPE_GL_OVERLAY_COMPOSITOR, GstGLOverlayCompositorPrivate))
+
+struct _GstGLOverlayCompositorPrivate
+{
+  /* the rectangles are packed in rows ("shelves") of the atlas, from the
+   * top */
+  GLuint atlas;
+  guint shelf_x;
+  guint shelf_y;
+  guint shelf_height;
+
+  /* all the rectangles are drawn from one vertex buffer */
+  GLuint vao;
+  GLuint vertex_buffer;
+  GLuint index_buffer;
+  GLfloat *vertices;
+  guint n_quads;
+  gboolean vertices_changed;
+};
+
 G_DEFINE_TYPE_WITH_CODE (GstGLOverlayCompositor, gst_gl_overlay_compositor,
     GST_TYPE_OBJECT, DEBUG_INIT);
 
 static void gst_gl_overlay_compositor_finalize (GObject * object);
-static gboolean _is_rectangle_in_overlays (GList * overlays,
-    GstVideoOverlayRectangle * rectangle);
-static gboolean _is_overlay_in_rectangles (GstVideoOverlayComposition *
-    composition, GstGLCompositionOverlay * overlay);
 
 static void
 gst_gl_overlay_compositor_class_init (GstGLOverlayCompositorClass * klass)
 {
+  g_type_class_add_private (klass, sizeof (GstGLOverlayCompositorPrivate));
+
   G_OBJECT_CLASS (klass)->finalize = gst_gl_overlay_compositor_finalize;
 }
 
 static void
 gst_gl_overlay_compositor_init (GstGLOverlayCompositor * compositor)
 {
+  compositor->priv = GST_GL_OVERLAY_COMPOSITOR_GET_PRIVATE (compositor);
 }
 
 static void
@@ -473,6 +377,16 @@ gst_gl_overlay_compositor_init_gl (GstGLContext * context,
       gst_gl_shader_get_attribute_location (compositor->shader, "a_texcoord");
 }
 
+/**
+ * gst_gl_overlay_compositor_new:
+ * @context: a #GstGLContext
+ *
+ * The rectangles of the compositions are uploaded once, identified by their
+ * seqnum, into a shared texture atlas and drawn with as few draw calls as
+ * possible.
+ *
+ * Returns: (transfer full): a new #GstGLOverlayCompositor
+ */
 GstGLOverlayCompositor *
 gst_gl_overlay_compositor_new (GstGLContext * context)
 {
@@ -491,6 +405,36 @@ gst_gl_overlay_compositor_new (GstGLContext * context)
   return compositor;
 }
 
+static void
+gst_gl_overlay_compositor_free_gl (GstGLContext * context,
+    gpointer compositor_pointer)
+{
+  GstGLOverlayCompositor *compositor =
+      (GstGLOverlayCompositor *) compositor_pointer;
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  if (priv->atlas) {
+    gl->DeleteTextures (1, &priv->atlas);
+    priv->atlas = 0;
+  }
+
+  if (priv->vao) {
+    gl->DeleteVertexArrays (1, &priv->vao);
+    priv->vao = 0;
+  }
+
+  if (priv->vertex_buffer) {
+    gl->DeleteBuffers (1, &priv->vertex_buffer);
+    priv->vertex_buffer = 0;
+  }
+
+  if (priv->index_buffer) {
+    gl->DeleteBuffers (1, &priv->index_buffer);
+    priv->index_buffer = 0;
+  }
+}
+
 static void
 gst_gl_overlay_compositor_finalize (GObject * object)
 {
@@ -500,133 +444,440 @@ gst_gl_overlay_compositor_finalize (GObject * object)
 
   gst_gl_overlay_compositor_free_overlays (compositor);
 
-  if (compositor->context)
+  if (compositor->context) {
+    gst_gl_context_thread_add (compositor->context,
+        gst_gl_overlay_compositor_free_gl, compositor);
     gst_object_unref (compositor->context);
+  }
 
   if (compositor->shader) {
     gst_object_unref (compositor->shader);
     compositor->shader = NULL;
   }
 
+  g_free (compositor->priv->vertices);
+
   G_OBJECT_CLASS (gst_gl_overlay_compositor_parent_class)->finalize (object);
 }
 
-static gboolean
-_is_rectangle_in_overlays (GList * overlays,
-    GstVideoOverlayRectangle * rectangle)
+static GstGLCompositionOverlay *
+_find_overlay (GList * overlays, guint seqnum)
 {
   GList *l;
 
   for (l = overlays; l != NULL; l = l->next) {
     GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
-    if (overlay->rectangle == rectangle)
-      return TRUE;
+    if (overlay->seqnum == seqnum)
+      return overlay;
   }
-  return FALSE;
+  return NULL;
+}
+
+/**
+ * gst_gl_overlay_compositor_free_overlays:
+ * @compositor: a #GstGLOverlayCompositor
+ *
+ * Drops all the overlays.  Their room in the atlas is reclaimed when it gets
+ * full.
+ */
+void
+gst_gl_overlay_compositor_free_overlays (GstGLOverlayCompositor * compositor)
+{
+  g_list_free_full (compositor->overlays, gst_object_unref);
+  compositor->overlays = NULL;
+
+  compositor->priv->n_quads = 0;
 }
 
+/* Finds room for a @width x @height rectangle in the atlas */
 static gboolean
-_is_overlay_in_rectangles (GstVideoOverlayComposition * composition,
-    GstGLCompositionOverlay * overlay)
+_atlas_place (GstGLOverlayCompositorPrivate * priv, guint width,
+    guint height, guint * x, guint * y)
 {
-  guint i;
+  width += ATLAS_PADDING;
+  height += ATLAS_PADDING;
 
-  for (i = 0; i < gst_video_overlay_composition_n_rectangles (composition); i++) {
-    GstVideoOverlayRectangle *rectangle =
-        gst_video_overlay_composition_get_rectangle (composition, i);
-    if (overlay->rectangle == rectangle)
-      return TRUE;
+  if (width > ATLAS_SIZE || height > ATLAS_SIZE)
+    return FALSE;
+
+  if (priv->shelf_x + width > ATLAS_SIZE) {
+    priv->shelf_y += priv->shelf_height;
+    priv->shelf_x = 0;
+    priv->shelf_height = 0;
   }
-  return FALSE;
+
+  if (priv->shelf_y + height > ATLAS_SIZE)
+    return FALSE;
+
+  *x = priv->shelf_x;
+  *y = priv->shelf_y;
+  priv->shelf_x += width;
+  priv->shelf_height = MAX (priv->shelf_height, height);
+
+  return TRUE;
 }
 
+/* clears the atlas, also allocating it the first time */
+static void
+_atlas_clear (GstGLOverlayCompositor * compositor)
+{
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  const GstGLFuncs *gl = compositor->context->gl_vtable;
+  guint8 *zeroes = g_malloc0 (ATLAS_SIZE * ATLAS_SIZE * 4);
+
+  if (!priv->atlas) {
+    gl->GenTextures (1, &priv->atlas);
+    gl->BindTexture (GL_TEXTURE_2D, priv->atlas);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  } else {
+    gl->BindTexture (GL_TEXTURE_2D, priv->atlas);
+  }
+
+  gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_SIZE, ATLAS_SIZE, 0,
+      GL_RGBA, GL_UNSIGNED_BYTE, zeroes);
+  g_free (zeroes);
 
-void
-gst_gl_overlay_compositor_free_overlays (GstGLOverlayCompositor * compositor)
+  priv->shelf_x = priv->shelf_y = priv->shelf_height = 0;
+}
+
+/* Uploads @overlay into its own texture */
+static void
+_upload_separate (GstGLOverlayCompositor * compositor,
+    GstGLCompositionOverlay * overlay)
 {
-  GList *l = compositor->overlays;
-  while (l != NULL) {
-    GList *next = l->next;
-    GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
-    compositor->overlays = g_list_delete_link (compositor->overlays, l);
-    gst_object_unref (overlay);
-    l = next;
+  const GstGLFuncs *gl = compositor->context->gl_vtable;
+
+  if (!overlay->texture_id) {
+    gl->GenTextures (1, &overlay->texture_id);
+    gl->BindTexture (GL_TEXTURE_2D, overlay->texture_id);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, overlay->width,
+        overlay->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  } else {
+    gl->BindTexture (GL_TEXTURE_2D, overlay->texture_id);
   }
-  g_list_free (compositor->overlays);
-  compositor->overlays = NULL;
+
+  overlay->in_atlas = FALSE;
+  overlay->uploaded = gst_gl_composition_overlay_upload (overlay, 0, 0);
 }
 
-void
-gst_gl_overlay_compositor_upload_overlays (GstGLOverlayCompositor * compositor,
-    GstBuffer * buf)
+static gboolean
+_place_overlays (GstGLOverlayCompositor * compositor)
 {
-  GstVideoOverlayCompositionMeta *composition_meta;
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  const GstGLFuncs *gl = compositor->context->gl_vtable;
+  gboolean fits = TRUE;
+  GList *l;
 
-  composition_meta = gst_buffer_get_video_overlay_composition_meta (buf);
-  if (composition_meta) {
-    GstVideoOverlayComposition *composition = NULL;
-    guint num_overlays, i;
-    GList *l = compositor->overlays;
+  for (l = compositor->overlays; l != NULL; l = l->next) {
+    GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
+    guint x, y;
 
-    GST_DEBUG ("GstVideoOverlayCompositionMeta found.");
+    if (overlay->uploaded)
+      continue;
 
-    composition = composition_meta->overlay;
-    num_overlays = gst_video_overlay_composition_n_rectangles (composition);
+    if (!_atlas_place (priv, overlay->width, overlay->height, &x, &y)) {
+      fits = FALSE;
+      continue;
+    }
 
-    /* add new overlays to list */
-    for (i = 0; i < num_overlays; i++) {
-      GstVideoOverlayRectangle *rectangle =
-          gst_video_overlay_composition_get_rectangle (composition, i);
+    gl->BindTexture (GL_TEXTURE_2D, priv->atlas);
+    overlay->in_atlas = TRUE;
+    overlay->atlas_x = x;
+    overlay->atlas_y = y;
+    overlay->uploaded = gst_gl_composition_overlay_upload (overlay, x, y);
+  }
 
-      if (!_is_rectangle_in_overlays (compositor->overlays, rectangle)) {
-        GstGLCompositionOverlay *overlay =
-            gst_gl_composition_overlay_new (compositor->context, rectangle,
-            compositor->position_attrib, compositor->texcoord_attrib);
-        gst_object_ref_sink (overlay);
+  return fits;
+}
 
-        gst_gl_composition_overlay_upload (overlay, buf);
+static void
+gst_gl_overlay_compositor_upload_gl (GstGLContext * context,
+    gpointer compositor_pointer)
+{
+  GstGLOverlayCompositor *compositor =
+      (GstGLOverlayCompositor *) compositor_pointer;
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  const GstGLFuncs *gl = context->gl_vtable;
+  GList *l;
 
-        compositor->overlays = g_list_append (compositor->overlays, overlay);
-      }
-    }
+  if (!priv->atlas)
+    _atlas_clear (compositor);
+
+  if (!_place_overlays (compositor)) {
+    /* the atlas is full of old rectangles, pack the current ones again */
+    GST_DEBUG_OBJECT (compositor, "repacking the overlay atlas");
 
-    /* remove old overlays from list */
-    while (l != NULL) {
-      GList *next = l->next;
+    _atlas_clear (compositor);
+    for (l = compositor->overlays; l != NULL; l = l->next) {
       GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
-      if (!_is_overlay_in_rectangles (composition, overlay)) {
-        compositor->overlays = g_list_delete_link (compositor->overlays, l);
-        gst_object_unref (overlay);
+
+      if (overlay->in_atlas)
+        overlay->uploaded = FALSE;
+    }
+
+    /* the rest is too big for the atlas */
+    if (!_place_overlays (compositor)) {
+      for (l = compositor->overlays; l != NULL; l = l->next) {
+        GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
+
+        if (!overlay->uploaded)
+          _upload_separate (compositor, overlay);
       }
-      l = next;
     }
+  }
+
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+}
+
+static void
+_bind_vertex_buffer (GstGLOverlayCompositor * compositor)
+{
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  const GstGLFuncs *gl = compositor->context->gl_vtable;
+
+  gl->BindBuffer (GL_ARRAY_BUFFER, priv->vertex_buffer);
+  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, priv->index_buffer);
+
+  gl->VertexAttribPointer (compositor->position_attrib, 4, GL_FLOAT, GL_FALSE,
+      VERTEX_SIZE * sizeof (GLfloat), NULL);
+  gl->VertexAttribPointer (compositor->texcoord_attrib, 2, GL_FLOAT, GL_FALSE,
+      VERTEX_SIZE * sizeof (GLfloat), (gpointer) (4 * sizeof (GLfloat)));
+
+  gl->EnableVertexAttribArray (compositor->position_attrib);
+  gl->EnableVertexAttribArray (compositor->texcoord_attrib);
+}
+
+static void
+_unbind_vertex_buffer (GstGLOverlayCompositor * compositor)
+{
+  const GstGLFuncs *gl = compositor->context->gl_vtable;
+
+  gl->DisableVertexAttribArray (compositor->position_attrib);
+  gl->DisableVertexAttribArray (compositor->texcoord_attrib);
+
+  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+  gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
+/* uploads the vertices of all the overlays, called in the GL thread */
+static void
+_update_vertex_buffer (GstGLOverlayCompositor * compositor)
+{
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  const GstGLFuncs *gl = compositor->context->gl_vtable;
+  GLushort *indices;
+  guint i;
+
+  if (!priv->vertex_buffer) {
+    gl->GenBuffers (1, &priv->vertex_buffer);
+    gl->GenBuffers (1, &priv->index_buffer);
+
+    if (gl->GenVertexArrays) {
+      gl->GenVertexArrays (1, &priv->vao);
+      gl->BindVertexArray (priv->vao);
+      _bind_vertex_buffer (compositor);
+      gl->BindVertexArray (0);
+    }
+  }
+
+  indices = g_new (GLushort, priv->n_quads * 6);
+  for (i = 0; i < priv->n_quads; i++) {
+    indices[i * 6 + 0] = i * 4 + 0;
+    indices[i * 6 + 1] = i * 4 + 1;
+    indices[i * 6 + 2] = i * 4 + 2;
+    indices[i * 6 + 3] = i * 4 + 0;
+    indices[i * 6 + 4] = i * 4 + 2;
+    indices[i * 6 + 5] = i * 4 + 3;
+  }
+
+  gl->BindBuffer (GL_ARRAY_BUFFER, priv->vertex_buffer);
+  gl->BufferData (GL_ARRAY_BUFFER,
+      priv->n_quads * 4 * VERTEX_SIZE * sizeof (GLfloat), priv->vertices,
+      GL_DYNAMIC_DRAW);
+  gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+
+  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, priv->index_buffer);
+  gl->BufferData (GL_ELEMENT_ARRAY_BUFFER, priv->n_quads * 6 *
+      sizeof (GLushort), indices, GL_DYNAMIC_DRAW);
+  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  g_free (indices);
+  priv->vertices_changed = FALSE;
+}
+
+/* the vertices are only computed once the overlays are placed and compared
+ * with the previous ones, so that an unchanged composition costs no GL
+ * call */
+static void
+gst_gl_overlay_compositor_update_vertices (GstGLOverlayCompositor *
+    compositor, guint width, guint height)
+{
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  guint n_quads = g_list_length (compositor->overlays);
+  GLfloat *vertices;
+  GList *l;
+  guint i;
+
+  /* the indices are 16 bits */
+  n_quads = MIN (n_quads, G_MAXUINT16 / 4);
+  vertices = g_new (GLfloat, n_quads * 4 * VERTEX_SIZE);
+
+  for (l = compositor->overlays, i = 0; i < n_quads; l = l->next, i++)
+    gst_gl_composition_overlay_get_vertices (l->data, width, height,
+        ATLAS_SIZE, &vertices[i * 4 * VERTEX_SIZE]);
+
+  if (n_quads != priv->n_quads || !priv->vertices
+      || memcmp (vertices, priv->vertices,
+          n_quads * 4 * VERTEX_SIZE * sizeof (GLfloat)) != 0) {
+    g_free (priv->vertices);
+    priv->vertices = vertices;
+    priv->n_quads = n_quads;
+    priv->vertices_changed = TRUE;
   } else {
+    g_free (vertices);
+  }
+}
+
+/**
+ * gst_gl_overlay_compositor_upload_overlays:
+ * @compositor: a #GstGLOverlayCompositor
+ * @buf: a #GstBuffer with a #GstVideoOverlayCompositionMeta
+ *
+ * Prepares the overlays of @buf for gst_gl_overlay_compositor_draw_overlays().
+ * Only the rectangles not seen in the previous buffers are uploaded.
+ */
+void
+gst_gl_overlay_compositor_upload_overlays (GstGLOverlayCompositor * compositor,
+    GstBuffer * buf)
+{
+  GstVideoOverlayCompositionMeta *composition_meta;
+  GstVideoOverlayComposition *composition;
+  GstVideoMeta *meta;
+  GList *overlays = NULL;
+  gboolean need_upload = FALSE;
+  guint num_overlays, i;
+
+  composition_meta = gst_buffer_get_video_overlay_composition_meta (buf);
+  if (!composition_meta) {
     gst_gl_overlay_compositor_free_overlays (compositor);
+    return;
+  }
+
+  GST_DEBUG ("GstVideoOverlayCompositionMeta found.");
+
+  composition = composition_meta->overlay;
+  num_overlays = gst_video_overlay_composition_n_rectangles (composition);
+
+  /* keep the overlays already uploaded, in the order of the new
+   * composition */
+  for (i = 0; i < num_overlays; i++) {
+    GstVideoOverlayRectangle *rectangle =
+        gst_video_overlay_composition_get_rectangle (composition, i);
+    GstGLCompositionOverlay *overlay = _find_overlay (compositor->overlays,
+        gst_video_overlay_rectangle_get_seqnum (rectangle));
+
+    if (overlay) {
+      compositor->overlays = g_list_remove (compositor->overlays, overlay);
+    } else {
+      overlay = gst_gl_composition_overlay_new (compositor->context,
+          rectangle);
+      gst_object_ref_sink (overlay);
+      need_upload = TRUE;
+    }
+
+    overlays = g_list_prepend (overlays, overlay);
   }
+
+  /* the overlays left are not in the composition anymore */
+  g_list_free_full (compositor->overlays, gst_object_unref);
+  compositor->overlays = g_list_reverse (overlays);
+
+  if (need_upload)
+    gst_gl_context_thread_add (compositor->context,
+        gst_gl_overlay_compositor_upload_gl, compositor);
+
+  meta = gst_buffer_get_video_meta (buf);
+  gst_gl_overlay_compositor_update_vertices (compositor, meta->width,
+      meta->height);
 }
 
+static GLuint
+_overlay_texture (GstGLOverlayCompositor * compositor,
+    GstGLCompositionOverlay * overlay)
+{
+  if (!overlay->uploaded)
+    return 0;
+
+  return overlay->in_atlas ? compositor->priv->atlas : overlay->texture_id;
+}
+
+/**
+ * gst_gl_overlay_compositor_draw_overlays:
+ * @compositor: a #GstGLOverlayCompositor
+ *
+ * Draws the overlays uploaded last, must be called in the GL thread.  The
+ * rectangles sharing a texture are drawn together.
+ */
 void
 gst_gl_overlay_compositor_draw_overlays (GstGLOverlayCompositor * compositor)
 {
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
   const GstGLFuncs *gl = compositor->context->gl_vtable;
-  if (compositor->overlays != NULL) {
-    GList *l;
+  GList *l;
+  guint i;
 
-    gl->Enable (GL_BLEND);
-    gl->BlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  if (compositor->overlays == NULL || priv->n_quads == 0)
+    return;
 
-    gst_gl_shader_use (compositor->shader);
-    gl->ActiveTexture (GL_TEXTURE0);
-    gst_gl_shader_set_uniform_1i (compositor->shader, "tex", 0);
+  if (priv->vertices_changed)
+    _update_vertex_buffer (compositor);
 
-    for (l = compositor->overlays; l != NULL; l = l->next) {
-      GstGLCompositionOverlay *overlay = (GstGLCompositionOverlay *) l->data;
-      gst_gl_composition_overlay_draw (overlay, compositor->shader);
+  gl->Enable (GL_BLEND);
+  gl->BlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  gst_gl_shader_use (compositor->shader);
+  gl->ActiveTexture (GL_TEXTURE0);
+  gst_gl_shader_set_uniform_1i (compositor->shader, "tex", 0);
+
+  if (priv->vao)
+    gl->BindVertexArray (priv->vao);
+  else
+    _bind_vertex_buffer (compositor);
+
+  /* one draw call per run of overlays with the same texture */
+  l = compositor->overlays;
+  i = 0;
+  while (l != NULL && i < priv->n_quads) {
+    GLuint tex = _overlay_texture (compositor, l->data);
+    guint first = i;
+
+    for (l = l->next, i++; l != NULL && i < priv->n_quads; l = l->next, i++) {
+      if (_overlay_texture (compositor, l->data) != tex)
+        break;
     }
 
-    gl->BindTexture (GL_TEXTURE_2D, 0);
-    gl->Disable (GL_BLEND);
+    if (tex == 0)
+      continue;
+
+    gl->BindTexture (GL_TEXTURE_2D, tex);
+    gl->DrawElements (GL_TRIANGLES, (i - first) * 6, GL_UNSIGNED_SHORT,
+        (gpointer) (first * 6 * sizeof (GLushort)));
   }
+
+  if (priv->vao)
+    gl->BindVertexArray (0);
+  else
+    _unbind_vertex_buffer (compositor);
+
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+  gl->Disable (GL_BLEND);
 }
 
 GstCaps *
@@ -57,7 +57,9 @@ struct _GstGLOverlayCompositor
   gint  position_attrib;
   gint  texcoord_attrib;
 
-  gpointer _padding[GST_PADDING];
+  GstGLOverlayCompositorPrivate *priv;
+
+  gpointer _padding[GST_PADDING - 1];
 };
 
 /**
@@ -27,6 +27,10 @@
  * A #GstGLQuery represents and holds an OpenGL query object.  Various types of
  * queries can be run or counters retrieved.
  *
+ * A #GstGLTimer measures the GPU time spent between gst_gl_timer_start() and
+ * gst_gl_timer_end() over many frames.  The results are read back once the
+ * GPU is done with them, so the timer never waits for the GPU.
+ *
  * Since: 1.10
  */
 
@@ -53,6 +57,10 @@
 #define GL_QUERY_RESULT 0x8866
 #endif
 
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
 #define GST_CAT_DEFAULT gst_gl_query_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
@@ -352,3 +360,269 @@ gst_gl_query_result (GstGLQuery * query)
 
   return ret;
 }
+
+/**
+ * gst_gl_query_result_available:
+ * @query: a #GstGLQuery
+ *
+ * Checks whether the result of @query can be retrieved with
+ * gst_gl_query_result() without waiting for the GPU.
+ *
+ * Returns: whether the result is available
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_gl_query_result_available (GstGLQuery * query)
+{
+  const GstGLFuncs *gl;
+  guint available = 0;
+
+  g_return_val_if_fail (query != NULL, FALSE);
+  g_return_val_if_fail (!query->start_called, FALSE);
+
+  if (!query->supported)
+    return TRUE;
+
+  gl = query->context->gl_vtable;
+  gl->GetQueryObjectuiv (query->query_id, GL_QUERY_RESULT_AVAILABLE,
+      &available);
+
+  return available != 0;
+}
+
+/* the timestamps around one timed section */
+typedef struct
+{
+  GstGLQuery start;
+  GstGLQuery end;
+} GstGLTimerSample;
+
+/* how many sections may be in flight on the GPU before new ones are
+ * skipped */
+#define TIMER_MAX_PENDING 8
+
+/**
+ * GstGLTimer:
+ *
+ * Opaque #GstGLTimer struct
+ *
+ * Since: 1.14
+ */
+struct _GstGLTimer
+{
+  GstGLContext *context;
+
+  GstGLTimerSample *current;
+  /* samples waiting for their results, oldest first */
+  GQueue pending;
+  GQueue free_samples;
+
+  GMutex lock;
+  guint64 count;
+  guint64 skipped;
+  guint64 total;
+  guint64 max;
+  guint64 last;
+};
+
+static void
+_timer_sample_free (GstGLTimerSample * sample)
+{
+  gst_gl_query_unset (&sample->start);
+  gst_gl_query_unset (&sample->end);
+  g_free (sample);
+}
+
+/* retrieves the results of the samples the GPU is done with */
+static void
+_timer_collect (GstGLTimer * timer)
+{
+  GstGLTimerSample *sample;
+
+  while ((sample = g_queue_peek_head (&timer->pending))) {
+    guint64 start, end, elapsed;
+
+    if (!gst_gl_query_result_available (&sample->end))
+      break;
+
+    start = gst_gl_query_result (&sample->start);
+    end = gst_gl_query_result (&sample->end);
+    elapsed = end > start ? end - start : 0;
+
+    g_mutex_lock (&timer->lock);
+    timer->count++;
+    timer->total += elapsed;
+    timer->max = MAX (timer->max, elapsed);
+    timer->last = elapsed;
+    g_mutex_unlock (&timer->lock);
+
+    g_queue_pop_head (&timer->pending);
+    g_queue_push_tail (&timer->free_samples, sample);
+  }
+}
+
+/**
+ * gst_gl_timer_new:
+ * @context: a #GstGLContext
+ *
+ * Must be called in @context's thread.  If @context cannot record
+ * timestamps, the timer measures nothing.
+ *
+ * Returns: (transfer full): a new #GstGLTimer
+ *
+ * Since: 1.14
+ */
+GstGLTimer *
+gst_gl_timer_new (GstGLContext * context)
+{
+  GstGLTimer *timer;
+
+  g_return_val_if_fail (GST_IS_GL_CONTEXT (context), NULL);
+
+  _init_debug ();
+
+  timer = g_new0 (GstGLTimer, 1);
+  timer->context = gst_object_ref (context);
+  g_queue_init (&timer->pending);
+  g_queue_init (&timer->free_samples);
+  g_mutex_init (&timer->lock);
+
+  return timer;
+}
+
+/**
+ * gst_gl_timer_free:
+ * @timer: a #GstGLTimer
+ *
+ * Frees @timer and its queries, dropping the results that were not retrieved
+ * yet.  Must be called in the thread of the #GstGLContext of @timer.
+ *
+ * Since: 1.14
+ */
+void
+gst_gl_timer_free (GstGLTimer * timer)
+{
+  g_return_if_fail (timer != NULL);
+
+  if (timer->current)
+    _timer_sample_free (timer->current);
+  g_queue_foreach (&timer->pending, (GFunc) _timer_sample_free, NULL);
+  g_queue_clear (&timer->pending);
+  g_queue_foreach (&timer->free_samples, (GFunc) _timer_sample_free, NULL);
+  g_queue_clear (&timer->free_samples);
+
+  g_mutex_clear (&timer->lock);
+  gst_object_unref (timer->context);
+  g_free (timer);
+}
+
+/**
+ * gst_gl_timer_start:
+ * @timer: a #GstGLTimer
+ *
+ * Starts timing the GL commands issued from now on in the thread of the
+ * #GstGLContext of @timer, until gst_gl_timer_end().  The sections timed
+ * include the commands of anything else using the context in between.
+ *
+ * Since: 1.14
+ */
+void
+gst_gl_timer_start (GstGLTimer * timer)
+{
+  const GstGLFuncs *gl;
+
+  g_return_if_fail (timer != NULL);
+  g_return_if_fail (timer->current == NULL);
+
+  gl = timer->context->gl_vtable;
+  if (!gl->QueryCounter || !gl->GetQueryObjectuiv)
+    return;
+
+  _timer_collect (timer);
+
+  /* the GPU is far behind, don't add to its work */
+  if (g_queue_get_length (&timer->pending) >= TIMER_MAX_PENDING) {
+    g_mutex_lock (&timer->lock);
+    timer->skipped++;
+    g_mutex_unlock (&timer->lock);
+    return;
+  }
+
+  timer->current = g_queue_pop_head (&timer->free_samples);
+  if (!timer->current) {
+    timer->current = g_new0 (GstGLTimerSample, 1);
+    gst_gl_query_init (&timer->current->start, timer->context,
+        GST_GL_QUERY_TIMESTAMP);
+    gst_gl_query_init (&timer->current->end, timer->context,
+        GST_GL_QUERY_TIMESTAMP);
+  }
+
+  gst_gl_query_counter (&timer->current->start);
+}
+
+/**
+ * gst_gl_timer_end:
+ * @timer: a #GstGLTimer
+ *
+ * Ends the section started with gst_gl_timer_start().  Its duration is
+ * accounted for in the statistics once the GPU has executed it.
+ *
+ * Since: 1.14
+ */
+void
+gst_gl_timer_end (GstGLTimer * timer)
+{
+  g_return_if_fail (timer != NULL);
+
+  if (!timer->current)
+    return;
+
+  gst_gl_query_counter (&timer->current->end);
+  g_queue_push_tail (&timer->pending, timer->current);
+  timer->current = NULL;
+
+  _timer_collect (timer);
+}
+
+/**
+ * gst_gl_timer_get_stats:
+ * @timer: a #GstGLTimer
+ *
+ * Retrieves the statistics of @timer from any thread, as a structure with
+ * these fields:
+ *
+ * * "count" (#guint64): the number of timed sections with a result
+ * * "skipped" (#guint64): the sections not timed because too many results
+ *   were still pending
+ * * "total-time" (#guint64): the GPU time of all the sections
+ * * "average-time" (#guint64): the average GPU time of a section
+ * * "max-time" (#guint64): the longest section
+ * * "last-time" (#guint64): the last section with a result
+ *
+ * All times are in nanoseconds.
+ *
+ * Returns: (transfer full): the statistics of @timer
+ *
+ * Since: 1.14
+ */
+GstStructure *
+gst_gl_timer_get_stats (GstGLTimer * timer)
+{
+  GstStructure *s;
+
+  g_return_val_if_fail (timer != NULL, NULL);
+
+  g_mutex_lock (&timer->lock);
+  s = gst_structure_new ("application/x-gl-timer-stats",
+      "count", G_TYPE_UINT64, timer->count,
+      "skipped", G_TYPE_UINT64, timer->skipped,
+      "total-time", G_TYPE_UINT64, timer->total,
+      "average-time", G_TYPE_UINT64,
+      timer->count ? timer->total / timer->count : (guint64) 0,
+      "max-time", G_TYPE_UINT64, timer->max,
+      "last-time", G_TYPE_UINT64, timer->last, NULL);
+  g_mutex_unlock (&timer->lock);
+
+  return s;
+}
@@ -79,6 +79,19 @@ GST_EXPORT
 void                gst_gl_query_counter            (GstGLQuery * query);
 GST_EXPORT
 guint64             gst_gl_query_result             (GstGLQuery * query);
+GST_EXPORT
+gboolean            gst_gl_query_result_available   (GstGLQuery * query);
+
+GST_EXPORT
+GstGLTimer *        gst_gl_timer_new                (GstGLContext * context);
+GST_EXPORT
+void                gst_gl_timer_free               (GstGLTimer * timer);
+GST_EXPORT
+void                gst_gl_timer_start              (GstGLTimer * timer);
+GST_EXPORT
+void                gst_gl_timer_end                (GstGLTimer * timer);
+GST_EXPORT
+GstStructure *      gst_gl_timer_get_stats          (GstGLTimer * timer);
 
 #define gst_gl_query_start_log_valist(query,cat,level,object,format,varargs) \
   G_STMT_START {    \
@@ -23,6 +23,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "gl.h"
 #include "gstglshader.h"
 #include "gstglsl_private.h"
@@ -1587,3 +1589,207 @@ gst_gl_shader_bind_frag_data_location (GstGLShader * shader,
 
   gl->BindFragDataLocation (priv->program_handle, index, name);
 }
+
+/* Cache of linked shaders, keyed by their complete source.  The cache is kept
+ * per context and only holds weak references so that it does not keep the
+ * shaders, and with them the context, alive. */
+static GMutex shader_cache_lock;
+static GQuark shader_cache_quark;
+
+static void
+_shader_cache_entry_free (GWeakRef * ref)
+{
+  g_weak_ref_clear (ref);
+  g_free (ref);
+}
+
+static GHashTable *
+_shader_cache_get_unlocked (GstGLContext * context, gboolean create)
+{
+  GHashTable *cache;
+
+  if (!shader_cache_quark)
+    shader_cache_quark = g_quark_from_static_string ("GstGLShaderCache");
+
+  cache = g_object_get_qdata (G_OBJECT (context), shader_cache_quark);
+  if (!cache && create) {
+    cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) _shader_cache_entry_free);
+    g_object_set_qdata_full (G_OBJECT (context), shader_cache_quark, cache,
+        (GDestroyNotify) g_hash_table_unref);
+  }
+
+  return cache;
+}
+
+/* Returns: (transfer full): the linked shader previously added for @source
+ * or %NULL */
+GstGLShader *
+_gst_gl_shader_cache_lookup (GstGLContext * context, const gchar * source)
+{
+  GstGLShader *shader = NULL;
+  GHashTable *cache;
+  GWeakRef *ref;
+
+  g_mutex_lock (&shader_cache_lock);
+  cache = _shader_cache_get_unlocked (context, FALSE);
+  if (cache && (ref = g_hash_table_lookup (cache, source)))
+    shader = g_weak_ref_get (ref);
+  g_mutex_unlock (&shader_cache_lock);
+
+  if (shader)
+    GST_TRACE_OBJECT (shader, "found cached shader for context %"
+        GST_PTR_FORMAT, context);
+
+  return shader;
+}
+
+void
+_gst_gl_shader_cache_add (GstGLContext * context, const gchar * source,
+    GstGLShader * shader)
+{
+  GHashTable *cache;
+  GWeakRef *ref;
+
+  g_mutex_lock (&shader_cache_lock);
+  cache = _shader_cache_get_unlocked (context, TRUE);
+  if (!(ref = g_hash_table_lookup (cache, source))) {
+    ref = g_new0 (GWeakRef, 1);
+    g_weak_ref_init (ref, NULL);
+    g_hash_table_insert (cache, g_strdup (source), ref);
+  }
+  g_weak_ref_set (ref, shader);
+  g_mutex_unlock (&shader_cache_lock);
+}
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+/* Program binaries are only valid for the exact driver that produced them,
+ * so the file name also depends on the renderer and version strings */
+static gchar *
+_shader_binary_filename (GstGLShader * shader, const gchar * source)
+{
+  const GstGLFuncs *gl = shader->context->gl_vtable;
+  const gchar *dir = g_getenv ("GST_GL_SHADER_CACHE_DIR");
+  gchar *key, *checksum, *basename, *ret;
+
+  if (!dir || !*dir || !gl->GetProgramBinary || !gl->ProgramBinary)
+    return NULL;
+
+  key = g_strdup_printf ("%s\n%s\n%s", (const gchar *) gl->GetString
+      (GL_RENDERER), (const gchar *) gl->GetString (GL_VERSION), source);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+  basename = g_strconcat (checksum, ".bin", NULL);
+  ret = g_build_filename (dir, basename, NULL);
+  g_free (basename);
+  g_free (checksum);
+  g_free (key);
+
+  return ret;
+}
+
+/* Links @shader from the program binary stored for @source by
+ * _gst_gl_shader_save_binary(), replacing compiling and linking the stages */
+gboolean
+_gst_gl_shader_load_binary (GstGLShader * shader, const gchar * source)
+{
+  GstGLShaderPrivate *priv = shader->priv;
+  const GstGLFuncs *gl = shader->context->gl_vtable;
+  GLint status = GL_FALSE;
+  gchar *filename, *contents = NULL;
+  gsize length = 0;
+  guint32 format;
+
+  if (!(filename = _shader_binary_filename (shader, source)))
+    return FALSE;
+
+  if (!g_file_get_contents (filename, &contents, &length, NULL)
+      || length <= sizeof (format)) {
+    g_free (filename);
+    g_free (contents);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (shader);
+
+  if (priv->linked || !_gst_glsl_funcs_fill (&priv->vtable, shader->context)
+      || !_ensure_program (shader)) {
+    GST_OBJECT_UNLOCK (shader);
+    g_free (filename);
+    g_free (contents);
+    return FALSE;
+  }
+
+  memcpy (&format, contents, sizeof (format));
+  gl->ProgramBinary (priv->program_handle, format, contents + sizeof (format),
+      length - sizeof (format));
+  priv->vtable.GetProgramiv (priv->program_handle, GL_LINK_STATUS, &status);
+  g_free (contents);
+
+  if (status != GL_TRUE) {
+    /* e.g. after a driver update, the stages will be linked instead */
+    GST_INFO_OBJECT (shader, "rejected program binary %s", filename);
+    GST_OBJECT_UNLOCK (shader);
+    g_free (filename);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (shader, "linked program %u from binary %s",
+      priv->program_handle, filename);
+  g_free (filename);
+
+  priv->linked = TRUE;
+  GST_OBJECT_UNLOCK (shader);
+
+  g_object_notify (G_OBJECT (shader), "linked");
+
+  return TRUE;
+}
+
+/* Stores the program binary of the linked @shader for loading with
+ * _gst_gl_shader_load_binary() */
+void
+_gst_gl_shader_save_binary (GstGLShader * shader, const gchar * source)
+{
+  GstGLShaderPrivate *priv = shader->priv;
+  const GstGLFuncs *gl = shader->context->gl_vtable;
+  GError *error = NULL;
+  gchar *filename, *dirname, *contents;
+  GLint length = 0;
+  GLenum format = 0;
+  guint32 format32;
+
+  if (!priv->linked || !(filename = _shader_binary_filename (shader, source)))
+    return;
+
+  priv->vtable.GetProgramiv (priv->program_handle, GL_PROGRAM_BINARY_LENGTH,
+      &length);
+  if (length <= 0) {
+    g_free (filename);
+    return;
+  }
+
+  contents = g_malloc (length + sizeof (format32));
+  gl->GetProgramBinary (priv->program_handle, length, &length, &format,
+      contents + sizeof (format32));
+  format32 = format;
+  memcpy (contents, &format32, sizeof (format32));
+
+  dirname = g_path_get_dirname (filename);
+  g_mkdir_with_parents (dirname, 0755);
+  g_free (dirname);
+
+  if (!g_file_set_contents (filename, contents, length + sizeof (format32),
+          &error)) {
+    GST_WARNING_OBJECT (shader, "failed to store program binary: %s",
+        error->message);
+    g_clear_error (&error);
+  } else {
+    GST_DEBUG_OBJECT (shader, "stored program binary %s", filename);
+  }
+
+  g_free (contents);
+  g_free (filename);
+}
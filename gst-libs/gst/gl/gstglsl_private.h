@@ -63,6 +63,11 @@ G_GNUC_INTERNAL gchar *
 _gst_glsl_mangle_shader (const gchar * str, guint shader_type, GstGLTextureTarget from,
     GstGLTextureTarget to, GstGLContext * context, GstGLSLVersion * version, GstGLSLProfile * profile);
 
+G_GNUC_INTERNAL GstGLShader * _gst_gl_shader_cache_lookup (GstGLContext * context, const gchar * source);
+G_GNUC_INTERNAL void _gst_gl_shader_cache_add (GstGLContext * context, const gchar * source, GstGLShader * shader);
+G_GNUC_INTERNAL gboolean _gst_gl_shader_load_binary (GstGLShader * shader, const gchar * source);
+G_GNUC_INTERNAL void _gst_gl_shader_save_binary (GstGLShader * shader, const gchar * source);
+
 G_END_DECLS
 
 #endif /* __GST_GLSL_PRIVATE_H__ */
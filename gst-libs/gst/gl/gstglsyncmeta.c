@@ -26,6 +26,12 @@
  *
  * #GstGLSyncMeta provides the ability to synchronize the OpenGL command stream
  * with the CPU or with other OpenGL contexts.
+ *
+ * The default implementation uses fence syncs of the OpenGL API. Without
+ * them, like on OpenGL ES 2.0, EGL_KHR_fence_sync is used when the context
+ * is an EGL context, and glFinish() is used for the CPU waits otherwise.
+ * The CPU waits that actually block are counted with
+ * gst_gl_context_get_sync_wait_count().
  */
 
 #ifdef HAVE_CONFIG_H
@@ -35,8 +41,13 @@
 #include "gstglsyncmeta.h"
 
 #include "gstglcontext.h"
+#include "gstglcontext_private.h"
 #include "gstglfuncs.h"
 
+#if GST_GL_HAVE_PLATFORM_EGL
+#include "egl/gstegl.h"
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_gl_sync_meta_debug);
 #define GST_CAT_DEFAULT gst_gl_sync_meta_debug
 
@@ -46,6 +57,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_gl_sync_meta_debug);
 #ifndef GL_SYNC_FLUSH_COMMANDS_BIT
 #define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
 #endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
 #ifndef GL_TIMEOUT_EXPIRED
 #define GL_TIMEOUT_EXPIRED 0x911B
 #endif
@@ -90,6 +104,12 @@ _default_wait_cpu_gl (GstGLSyncMeta * sync_meta, GstGLContext * context)
   GLenum res;
 
   if (sync_meta->data && gl->ClientWaitSync) {
+    res = gl->ClientWaitSync ((GLsync) sync_meta->data,
+        GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (res != GL_TIMEOUT_EXPIRED)
+      return;
+
+    _gst_gl_context_add_sync_wait (context);
     do {
       GST_LOG ("waiting on sync object %p", sync_meta->data);
       res =
@@ -97,6 +117,7 @@ _default_wait_cpu_gl (GstGLSyncMeta * sync_meta, GstGLContext * context)
           GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 /* 1s */ );
     } while (res == GL_TIMEOUT_EXPIRED);
   } else {
+    _gst_gl_context_add_sync_wait (context);
     gl->Finish ();
   }
 }
@@ -124,6 +145,163 @@ _default_free_gl (GstGLSyncMeta * sync_meta, GstGLContext * context)
   }
 }
 
+#if GST_GL_HAVE_PLATFORM_EGL
+#ifndef EGL_SYNC_STATUS_KHR
+#define EGL_SYNC_STATUS_KHR 0x30F1
+#endif
+#ifndef EGL_SIGNALED_KHR
+#define EGL_SIGNALED_KHR 0x30F2
+#endif
+#ifndef EGL_TIMEOUT_EXPIRED_KHR
+#define EGL_TIMEOUT_EXPIRED_KHR 0x30F5
+#endif
+#ifndef EGL_SYNC_FENCE_KHR
+#define EGL_SYNC_FENCE_KHR 0x30F9
+#endif
+#ifndef EGL_SYNC_FLUSH_COMMANDS_BIT_KHR
+#define EGL_SYNC_FLUSH_COMMANDS_BIT_KHR 0x0001
+#endif
+
+/* EGL_KHR_fence_sync and EGL_KHR_wait_sync, the entry points are the same
+ * for every display */
+static struct
+{
+  gpointer (*CreateSync) (EGLDisplay dpy, EGLenum type,
+      const EGLint * attrib_list);
+  EGLBoolean (*DestroySync) (EGLDisplay dpy, gpointer sync);
+  EGLint (*ClientWaitSync) (EGLDisplay dpy, gpointer sync, EGLint flags,
+      guint64 timeout);
+  EGLBoolean (*GetSyncAttrib) (EGLDisplay dpy, gpointer sync,
+      EGLint attribute, EGLint * value);
+  EGLint (*WaitSync) (EGLDisplay dpy, gpointer sync, EGLint flags);
+} egl_sync;
+
+typedef struct
+{
+  EGLDisplay display;
+  gpointer sync;
+  /* only compared against, to know when a server wait is redundant */
+  GstGLContext *set_context;
+} GstGLSyncEGL;
+
+static gboolean
+_egl_sync_init (GstGLContext * context)
+{
+  static volatile gsize _init = 0;
+
+  if (gst_gl_context_get_gl_platform (context) != GST_GL_PLATFORM_EGL
+      || !gst_gl_context_check_feature (context, "EGL_KHR_fence_sync"))
+    return FALSE;
+
+  if (g_once_init_enter (&_init)) {
+    egl_sync.CreateSync =
+        gst_gl_context_get_proc_address (context, "eglCreateSyncKHR");
+    egl_sync.DestroySync =
+        gst_gl_context_get_proc_address (context, "eglDestroySyncKHR");
+    egl_sync.ClientWaitSync =
+        gst_gl_context_get_proc_address (context, "eglClientWaitSyncKHR");
+    egl_sync.GetSyncAttrib =
+        gst_gl_context_get_proc_address (context, "eglGetSyncAttribKHR");
+    if (gst_gl_context_check_feature (context, "EGL_KHR_wait_sync"))
+      egl_sync.WaitSync =
+          gst_gl_context_get_proc_address (context, "eglWaitSyncKHR");
+    g_once_init_leave (&_init, 1);
+  }
+
+  return egl_sync.CreateSync && egl_sync.DestroySync
+      && egl_sync.ClientWaitSync && egl_sync.GetSyncAttrib;
+}
+
+static void
+_egl_destroy_sync (GstGLSyncEGL * sync)
+{
+  if (sync->sync) {
+    GST_LOG ("deleting EGL sync object %p", sync->sync);
+    egl_sync.DestroySync (sync->display, sync->sync);
+    sync->sync = NULL;
+  }
+}
+
+static void
+_egl_set_sync_gl (GstGLSyncMeta * sync_meta, GstGLContext * context)
+{
+  GstGLSyncEGL *sync = sync_meta->data;
+
+  if (!sync)
+    sync_meta->data = sync = g_new0 (GstGLSyncEGL, 1);
+
+  _egl_destroy_sync (sync);
+  sync->display = eglGetCurrentDisplay ();
+  sync->sync = egl_sync.CreateSync (sync->display, EGL_SYNC_FENCE_KHR, NULL);
+  sync->set_context = context;
+  GST_LOG ("setting EGL sync object %p", sync->sync);
+
+  /* the flush bit of a wait only flushes the context current in the waiting
+   * thread, which is not this one for CPU waits */
+  context->gl_vtable->Flush ();
+}
+
+/* Returns whether the CPU had to block */
+static gboolean
+_egl_client_wait (GstGLSyncEGL * sync)
+{
+  EGLint status = 0, res;
+
+  if (egl_sync.GetSyncAttrib (sync->display, sync->sync, EGL_SYNC_STATUS_KHR,
+          &status) && status == EGL_SIGNALED_KHR)
+    return FALSE;
+
+  do {
+    GST_LOG ("waiting on EGL sync object %p", sync->sync);
+    res = egl_sync.ClientWaitSync (sync->display, sync->sync,
+        EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, 1000000000 /* 1s */ );
+  } while (res == EGL_TIMEOUT_EXPIRED_KHR);
+
+  return TRUE;
+}
+
+static void
+_egl_wait_gl (GstGLSyncMeta * sync_meta, GstGLContext * context)
+{
+  GstGLSyncEGL *sync = sync_meta->data;
+
+  if (!sync || !sync->sync)
+    return;
+
+  if (egl_sync.WaitSync) {
+    GST_LOG ("waiting on EGL sync object %p", sync->sync);
+    egl_sync.WaitSync (sync->display, sync->sync, 0);
+  } else if (context != sync->set_context) {
+    /* no server side waits, the commands of the same context are ordered
+     * anyway */
+    if (_egl_client_wait (sync))
+      _gst_gl_context_add_sync_wait (context);
+  }
+}
+
+/* unlike GLsync's, EGL syncs can be waited on without a current context */
+static void
+_egl_wait_cpu (GstGLSyncMeta * sync_meta, GstGLContext * context)
+{
+  GstGLSyncEGL *sync = sync_meta->data;
+
+  if (sync && sync->sync && _egl_client_wait (sync))
+    _gst_gl_context_add_sync_wait (context);
+}
+
+static void
+_egl_free (GstGLSyncMeta * sync_meta, GstGLContext * context)
+{
+  GstGLSyncEGL *sync = sync_meta->data;
+
+  if (sync) {
+    _egl_destroy_sync (sync);
+    g_free (sync);
+    sync_meta->data = NULL;
+  }
+}
+#endif
+
 /**
  * gst_buffer_add_gl_sync_meta_full:
  * @context: a #GstGLContext
@@ -171,6 +349,20 @@ gst_buffer_add_gl_sync_meta (GstGLContext * context, GstBuffer * buffer)
   if (!ret)
     return NULL;
 
+#if GST_GL_HAVE_PLATFORM_EGL
+  if (!context->gl_vtable->FenceSync && _egl_sync_init (context)) {
+    ret->set_sync_gl = _egl_set_sync_gl;
+    ret->wait_gl = _egl_wait_gl;
+    ret->wait_cpu = _egl_wait_cpu;
+    ret->wait_cpu_gl = _egl_wait_cpu;
+    ret->copy = _default_copy;
+    ret->free = _egl_free;
+    ret->free_gl = _egl_free;
+
+    return ret;
+  }
+#endif
+
   ret->set_sync_gl = _default_set_sync_gl;
   ret->wait_gl = _default_wait_gl;
   ret->wait_cpu_gl = _default_wait_cpu_gl;
@@ -317,14 +509,24 @@ _free_gl_sync_meta (GstGLContext * context, GstGLSyncMeta * sync_meta)
   sync_meta->free_gl (sync_meta, context);
 }
 
+static void
+_free_sync_meta_copy (GstGLSyncMeta * sync_meta)
+{
+  g_slice_free (GstGLSyncMeta, sync_meta);
+}
+
 static void
 _gst_gl_sync_meta_free (GstGLSyncMeta * sync_meta, GstBuffer * buffer)
 {
   if (sync_meta->free)
     sync_meta->free (sync_meta, sync_meta->context);
   else
-    gst_gl_context_thread_add (sync_meta->context,
-        (GstGLContextThreadFunc) _free_gl_sync_meta, sync_meta);
+    /* freeing a buffer doesn't need to wait for the GL thread, the copy
+     * outlives the meta */
+    gst_gl_context_thread_add_async (sync_meta->context,
+        (GstGLContextThreadFunc) _free_gl_sync_meta,
+        g_slice_dup (GstGLSyncMeta, sync_meta),
+        (GDestroyNotify) _free_sync_meta_copy);
 
   gst_object_unref (sync_meta->context);
 }
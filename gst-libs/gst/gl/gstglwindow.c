@@ -89,6 +89,24 @@ static void gst_gl_window_default_send_message (GstGLWindow * window,
 static void gst_gl_window_default_send_message_async (GstGLWindow * window,
     GstGLWindowCB callback, gpointer data, GDestroyNotify destroy);
 
+/* The asynchronous messages waiting for the window thread.  All the
+ * messages queued before the window thread wakes up are run from a single
+ * source.  It is refcounted as the source may outlive the window when the
+ * loop is not running anymore */
+typedef struct
+{
+  volatile gint refcount;
+
+  GMutex lock;
+  GQueue messages;
+
+  /* statistics */
+  volatile gint n_messages;
+  gint64 rate_start;
+  guint rate_messages;
+  guint rate_batches;
+} GstGLMessageQueue;
+
 struct _GstGLWindowPrivate
 {
   GMainLoop *loop;
@@ -100,9 +118,12 @@ struct _GstGLWindowPrivate
 
   GMutex sync_message_lock;
   GCond sync_message_cond;
+
+  GstGLMessageQueue *async_messages;
 };
 
 static void gst_gl_window_finalize (GObject * object);
+static void _message_queue_unref (GstGLMessageQueue * queue);
 
 typedef struct _GstGLDummyWindow
 {
@@ -171,6 +192,11 @@ gst_gl_window_init (GstGLWindow * window)
   g_mutex_init (&window->priv->sync_message_lock);
   g_cond_init (&window->priv->sync_message_cond);
 
+  priv->async_messages = g_new0 (GstGLMessageQueue, 1);
+  priv->async_messages->refcount = 1;
+  g_mutex_init (&priv->async_messages->lock);
+  g_queue_init (&priv->async_messages->messages);
+
   window->main_context = g_main_context_new ();
   priv->loop = g_main_loop_new (window->main_context, FALSE);
 }
@@ -311,6 +337,7 @@ gst_gl_window_finalize (GObject * object)
   g_mutex_clear (&window->lock);
   g_mutex_clear (&window->priv->sync_message_lock);
   g_cond_clear (&window->priv->sync_message_cond);
+  _message_queue_unref (priv->async_messages);
   gst_object_unref (window->display);
 
   G_OBJECT_CLASS (gst_gl_window_parent_class)->finalize (object);
@@ -630,32 +657,119 @@ typedef struct _GstGLAsyncMessage
   GDestroyNotify destroy;
 } GstGLAsyncMessage;
 
-static gboolean
+static void
+_free_message_async (GstGLAsyncMessage * message)
+{
+  if (message->destroy)
+    message->destroy (message->data);
+
+  g_slice_free (GstGLAsyncMessage, message);
+}
+
+static void
 _run_message_async (GstGLAsyncMessage * message)
 {
   if (message->callback)
     message->callback (message->data);
 
-  if (message->destroy)
-    message->destroy (message->data);
+  _free_message_async (message);
+}
 
-  g_slice_free (GstGLAsyncMessage, message);
+static GstGLMessageQueue *
+_message_queue_ref (GstGLMessageQueue * queue)
+{
+  g_atomic_int_inc (&queue->refcount);
 
-  return FALSE;
+  return queue;
+}
+
+static void
+_message_queue_unref (GstGLMessageQueue * queue)
+{
+  if (!g_atomic_int_dec_and_test (&queue->refcount))
+    return;
+
+  /* the loop is gone, nothing will run them anymore */
+  g_queue_foreach (&queue->messages, (GFunc) _free_message_async, NULL);
+  g_queue_clear (&queue->messages);
+  g_mutex_clear (&queue->lock);
+  g_free (queue);
+}
+
+static gboolean
+_run_messages_async (GstGLMessageQueue * queue)
+{
+  GQueue messages;
+  GstGLAsyncMessage *message;
+  gint64 now;
+
+  g_mutex_lock (&queue->lock);
+  messages = queue->messages;
+  g_queue_init (&queue->messages);
+  g_mutex_unlock (&queue->lock);
+
+  g_atomic_int_add (&queue->n_messages, messages.length);
+
+  /* only accessed from the window thread */
+  now = g_get_monotonic_time ();
+  queue->rate_messages += messages.length;
+  queue->rate_batches++;
+  if (queue->rate_start == 0) {
+    queue->rate_start = now;
+  } else if (now - queue->rate_start >= G_USEC_PER_SEC) {
+    GST_DEBUG ("%.1f messages per second in %.1f batches per second",
+        queue->rate_messages * (gdouble) G_USEC_PER_SEC /
+        (now - queue->rate_start),
+        queue->rate_batches * (gdouble) G_USEC_PER_SEC /
+        (now - queue->rate_start));
+    queue->rate_start = now;
+    queue->rate_messages = queue->rate_batches = 0;
+  }
+
+  while ((message = g_queue_pop_head (&messages)))
+    _run_message_async (message);
+
+  return G_SOURCE_REMOVE;
 }
 
 static void
 gst_gl_window_default_send_message_async (GstGLWindow * window,
     GstGLWindowCB callback, gpointer data, GDestroyNotify destroy)
 {
+  GstGLMessageQueue *queue = window->priv->async_messages;
   GstGLAsyncMessage *message = g_slice_new (GstGLAsyncMessage);
+  gboolean schedule;
+  GSource *source;
 
   message->callback = callback;
   message->data = data;
   message->destroy = destroy;
 
-  g_main_context_invoke (window->main_context, (GSourceFunc) _run_message_async,
-      message);
+  g_mutex_lock (&queue->lock);
+  /* a source is already pending for the queued messages otherwise */
+  schedule = g_queue_is_empty (&queue->messages);
+  g_queue_push_tail (&queue->messages, message);
+  g_mutex_unlock (&queue->lock);
+
+  /* like g_main_context_invoke(), run right away from the window thread or
+   * when nothing runs the loop */
+  if (g_main_context_acquire (window->main_context)) {
+    _run_messages_async (queue);
+    g_main_context_release (window->main_context);
+  } else if (schedule) {
+    source = g_idle_source_new ();
+    g_source_set_priority (source, G_PRIORITY_DEFAULT);
+    g_source_set_callback (source, (GSourceFunc) _run_messages_async,
+        _message_queue_ref (queue), (GDestroyNotify) _message_queue_unref);
+    g_source_attach (source, window->main_context);
+    g_source_unref (source);
+  }
+}
+
+guint
+_gst_gl_window_get_message_count (GstGLWindow * window)
+{
+  return g_atomic_int_get (&window->priv->async_messages->n_messages);
 }
 
 /**
@@ -666,7 +780,8 @@ gst_gl_window_default_send_message_async (GstGLWindow * window,
  * @destroy: called when @data is not needed anymore
  *
  * Invoke @callback with @data on the window thread.  The callback may not
- * have been executed when this function returns.
+ * have been executed when this function returns.  The messages sent before
+ * the window thread wakes up are run in one go, in the order they were sent.
  *
  * Since: 1.4
  */
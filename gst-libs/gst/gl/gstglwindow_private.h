@@ -21,11 +21,14 @@
 #define __GST_GL_WINDOW_PRIVATE_H__
 
 #include <gst/gst.h>
+#include <gst/gl/gstgl_fwd.h>
 
 G_BEGIN_DECLS
 
 G_GNUC_INTERNAL extern GstDebugCategory *gst_gl_window_debug;
 
+G_GNUC_INTERNAL guint _gst_gl_window_get_message_count (GstGLWindow * window);
+
 G_END_DECLS
 
 #endif /* __GST_GL_WINDOW_PRIVATE_H__ */
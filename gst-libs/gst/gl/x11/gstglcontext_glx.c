@@ -61,6 +61,10 @@ static GstGLPlatform gst_gl_context_glx_get_gl_platform (GstGLContext *
     context);
 static void gst_gl_context_glx_get_gl_platform_version (GstGLContext * context,
     gint * major, gint * minor);
+static gboolean gst_gl_context_glx_set_swap_interval (GstGLContext * context,
+    gint interval);
+static gboolean gst_gl_context_glx_get_last_vsync (GstGLContext * context,
+    gint64 * time, guint64 * count);
 
 struct _GstGLContextGLXPrivate
 {
@@ -72,6 +76,12 @@ struct _GstGLContextGLXPrivate
   GLXFBConfig *fbconfigs;
     GLXContext (*glXCreateContextAttribsARB) (Display *, GLXFBConfig,
       GLXContext, Bool, const int *);
+
+  void (*glXSwapIntervalEXT) (Display *, GLXDrawable, int);
+  int (*glXSwapIntervalMESA) (unsigned int);
+  int (*glXSwapIntervalSGI) (int);
+  Bool (*glXGetSyncValuesOML) (Display *, GLXDrawable, gint64 *, gint64 *,
+      gint64 *);
 };
 
 static void
@@ -102,6 +112,10 @@ gst_gl_context_glx_class_init (GstGLContextGLXClass * klass)
       GST_DEBUG_FUNCPTR (gst_gl_context_glx_get_current_context);
   context_class->get_gl_platform_version =
       GST_DEBUG_FUNCPTR (gst_gl_context_glx_get_gl_platform_version);
+  context_class->set_swap_interval =
+      GST_DEBUG_FUNCPTR (gst_gl_context_glx_set_swap_interval);
+  context_class->get_last_vsync =
+      GST_DEBUG_FUNCPTR (gst_gl_context_glx_get_last_vsync);
 }
 
 static void
@@ -244,6 +258,23 @@ gst_gl_context_glx_create_context (GstGLContext * context,
       (gpointer) glXGetProcAddressARB ((const GLubyte *)
       "glXCreateContextAttribsARB");
 
+  if (gst_gl_check_extension ("GLX_EXT_swap_control", glx_exts))
+    context_glx->priv->glXSwapIntervalEXT =
+        (gpointer) glXGetProcAddressARB ((const GLubyte *)
+        "glXSwapIntervalEXT");
+  if (gst_gl_check_extension ("GLX_MESA_swap_control", glx_exts))
+    context_glx->priv->glXSwapIntervalMESA =
+        (gpointer) glXGetProcAddressARB ((const GLubyte *)
+        "glXSwapIntervalMESA");
+  if (gst_gl_check_extension ("GLX_SGI_swap_control", glx_exts))
+    context_glx->priv->glXSwapIntervalSGI =
+        (gpointer) glXGetProcAddressARB ((const GLubyte *)
+        "glXSwapIntervalSGI");
+  if (gst_gl_check_extension ("GLX_OML_sync_control", glx_exts))
+    context_glx->priv->glXGetSyncValuesOML =
+        (gpointer) glXGetProcAddressARB ((const GLubyte *)
+        "glXGetSyncValuesOML");
+
   if (!context_glx->glx_context && gl_api & GST_GL_API_OPENGL3 && create_context
       && context_glx->priv->glXCreateContextAttribsARB) {
     gint i;
@@ -451,6 +482,62 @@ gst_gl_context_glx_swap_buffers (GstGLContext * context)
   gst_object_unref (window);
 }
 
+static gboolean
+gst_gl_context_glx_set_swap_interval (GstGLContext * context, gint interval)
+{
+  GstGLContextGLXPrivate *priv = GST_GL_CONTEXT_GLX (context)->priv;
+  GstGLWindow *window = gst_gl_context_get_window (context);
+  Display *device = (Display *) gst_gl_display_get_handle (window->display);
+  Window window_handle = (Window) gst_gl_window_get_window_handle (window);
+  gboolean ret = TRUE;
+
+  if (priv->glXSwapIntervalEXT)
+    priv->glXSwapIntervalEXT (device, window_handle, interval);
+  else if (priv->glXSwapIntervalMESA)
+    ret = priv->glXSwapIntervalMESA (interval) == 0;
+  /* SGI cannot disable the synchronisation */
+  else if (priv->glXSwapIntervalSGI && interval > 0)
+    ret = priv->glXSwapIntervalSGI (interval) == 0;
+  else
+    ret = FALSE;
+
+  gst_object_unref (window);
+
+  return ret;
+}
+
+/* The UST of GLX_OML_sync_control is CLOCK_MONOTONIC in microseconds with
+ * the Mesa and NVIDIA drivers, the timebase of g_get_monotonic_time() */
+static gboolean
+gst_gl_context_glx_get_last_vsync (GstGLContext * context, gint64 * time,
+    guint64 * count)
+{
+  GstGLContextGLXPrivate *priv = GST_GL_CONTEXT_GLX (context)->priv;
+  GstGLWindow *window;
+  Display *device;
+  Window window_handle;
+  gint64 ust, msc, sbc;
+  gboolean ret;
+
+  if (!priv->glXGetSyncValuesOML)
+    return FALSE;
+
+  window = gst_gl_context_get_window (context);
+  device = (Display *) gst_gl_display_get_handle (window->display);
+  window_handle = (Window) gst_gl_window_get_window_handle (window);
+
+  ret = priv->glXGetSyncValuesOML (device, window_handle, &ust, &msc, &sbc)
+      && ust > 0;
+  if (ret) {
+    *time = ust;
+    *count = msc;
+  }
+
+  gst_object_unref (window);
+
+  return ret;
+}
+
 static guintptr
 gst_gl_context_glx_get_gl_context (GstGLContext * context)
 {
@@ -556,6 +556,80 @@ gst_isoff_moof_box_free (GstMoofBox * moof)
   g_free (moof);
 }
 
+/* gst_isoff_parse_box_header_buffer:
+ * @buffer: buffer containing the box header at @offset
+ * @offset: offset of the box header in @buffer
+ * @type: type that was found at @offset
+ * @extended_type: (allow-none): extended type if type=='uuid'
+ * @header_size: (allow-none): size of the box header (type, extended type and size)
+ * @size: size of the complete box including type, extended type and size
+ *
+ * Same as gst_isoff_parse_box_header() but works on a buffer that can
+ * consist of multiple memories. Only the few header bytes are copied, the
+ * buffer is never merged.
+ *
+ * Returns: TRUE if a box header could be parsed, FALSE if more data is needed
+ */
+gboolean
+gst_isoff_parse_box_header_buffer (GstBuffer * buffer, gsize offset,
+    guint32 * type, guint8 extended_type[16], guint * header_size,
+    guint64 * size)
+{
+  GstByteReader reader;
+  guint8 header[32];
+  gsize header_len;
+
+  header_len = gst_buffer_extract (buffer, offset, header, sizeof (header));
+  gst_byte_reader_init (&reader, header, header_len);
+
+  return gst_isoff_parse_box_header (&reader, type, extended_type,
+      header_size, size);
+}
+
+/* gst_isoff_moof_box_parse_buffer:
+ * @buffer: buffer containing the complete moof box
+ * @offset: offset of the moof box content, after the box header
+ * @size: size of the moof box content
+ *
+ * Parses a moof box out of a buffer that can consist of multiple memories.
+ * If the box lies within a single memory it is parsed in place, otherwise
+ * only the memories spanned by the box are mapped together.
+ *
+ * Returns: (transfer full) (nullable): the parsed moof box, or %NULL on error
+ */
+GstMoofBox *
+gst_isoff_moof_box_parse_buffer (GstBuffer * buffer, gsize offset, gsize size)
+{
+  GstMoofBox *moof;
+  GstByteReader reader;
+  GstMemory *mem;
+  GstMapInfo info;
+  guint idx, length;
+  gsize skip;
+
+  INITIALIZE_DEBUG_CATEGORY;
+  if (size == 0 || !gst_buffer_find_memory (buffer, offset, size, &idx,
+          &length, &skip))
+    return NULL;
+
+  if (length == 1) {
+    mem = gst_buffer_peek_memory (buffer, idx);
+    if (!gst_memory_map (mem, &info, GST_MAP_READ))
+      return NULL;
+    gst_byte_reader_init (&reader, info.data + skip, size);
+    moof = gst_isoff_moof_box_parse (&reader);
+    gst_memory_unmap (mem, &info);
+  } else {
+    if (!gst_buffer_map_range (buffer, idx, length, &info, GST_MAP_READ))
+      return NULL;
+    gst_byte_reader_init (&reader, info.data + skip, size);
+    moof = gst_isoff_moof_box_parse (&reader);
+    gst_buffer_unmap (buffer, &info);
+  }
+
+  return moof;
+}
+
 static gboolean
 gst_isoff_mdhd_box_parse (GstMdhdBox * mdhd, GstByteReader * reader)
 {
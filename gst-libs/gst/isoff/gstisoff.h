@@ -40,6 +40,9 @@ typedef enum {
 GST_EXPORT
 gboolean gst_isoff_parse_box_header (GstByteReader * reader, guint32 * type, guint8 extended_type[16], guint * header_size, guint64 * size);
 
+GST_EXPORT
+gboolean gst_isoff_parse_box_header_buffer (GstBuffer * buffer, gsize offset, guint32 * type, guint8 extended_type[16], guint * header_size, guint64 * size);
+
 #define GST_ISOFF_FOURCC_UUID GST_MAKE_FOURCC('u','u','i','d')
 #define GST_ISOFF_FOURCC_MOOF GST_MAKE_FOURCC('m','o','o','f')
 #define GST_ISOFF_FOURCC_MFHD GST_MAKE_FOURCC('m','f','h','d')
@@ -185,6 +188,9 @@ typedef struct _GstMoofBox
 GST_EXPORT
 GstMoofBox * gst_isoff_moof_box_parse (GstByteReader *reader);
 
+GST_EXPORT
+GstMoofBox * gst_isoff_moof_box_parse_buffer (GstBuffer * buffer, gsize offset, gsize size);
+
 GST_EXPORT
 void gst_isoff_moof_box_free (GstMoofBox *moof);
 
@@ -0,0 +1,426 @@
+/*
+ * gst-dvb-epg.c -
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mpegts.h"
+#include "gstmpegts-private.h"
+
+/**
+ * SECTION:gst-dvb-epg
+ * @title: DVB Electronic Program Guide
+ * @short_description: Aggregation of EIT sections into event lists
+ * @include: gst/mpegts/mpegts.h
+ *
+ * #GstMpegtsEpgStore collects the EIT sections posted by the demuxer and
+ * keeps the events of each service up to date. Sections already seen for
+ * the current version of their table are detected from their header and
+ * dropped without being parsed, so all the sections of a stream can be fed
+ * to the store as they arrive.
+ *
+ * The #GstMpegtsEpgStore::service-changed signal notifies when the events
+ * of a service change, gst_mpegts_epg_store_get_events() then returns the
+ * merged list of events of that service.
+ */
+
+/* EIT table ids go from 0x4E (actual present/following) to 0x6F (last
+ * other schedule table) */
+#define EPG_FIRST_TABLE_ID 0x4E
+#define EPG_LAST_TABLE_ID 0x6F
+#define EPG_N_TABLES (EPG_LAST_TABLE_ID - EPG_FIRST_TABLE_ID + 1)
+
+typedef struct
+{
+  guint8 version_number;
+  GstMpegtsSection *sections[256];
+} EpgTable;
+
+typedef struct
+{
+  gint64 key;
+
+  guint16 original_network_id;
+  guint16 transport_stream_id;
+  guint16 service_id;
+
+  EpgTable *tables[EPG_N_TABLES];
+
+  /* merged events, rebuilt on demand after a change */
+  GPtrArray *events;
+} EpgService;
+
+struct _GstMpegtsEpgStore
+{
+  GObject parent;
+
+  /* protects services */
+  GMutex lock;
+  GHashTable *services;
+};
+
+struct _GstMpegtsEpgStoreClass
+{
+  GObjectClass parent_class;
+};
+
+enum
+{
+  SIGNAL_SERVICE_CHANGED,
+  LAST_SIGNAL
+};
+
+static guint epg_store_signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE (GstMpegtsEpgStore, gst_mpegts_epg_store, G_TYPE_OBJECT);
+
+static gint64
+_service_key (guint16 original_network_id, guint16 transport_stream_id,
+    guint16 service_id)
+{
+  return ((gint64) original_network_id << 32) |
+      ((gint64) transport_stream_id << 16) | service_id;
+}
+
+static void
+_epg_table_clear (EpgTable * table)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (table->sections); i++) {
+    if (table->sections[i]) {
+      gst_mpegts_section_unref (table->sections[i]);
+      table->sections[i] = NULL;
+    }
+  }
+}
+
+static void
+_epg_service_free (EpgService * service)
+{
+  guint i;
+
+  for (i = 0; i < EPG_N_TABLES; i++) {
+    if (service->tables[i]) {
+      _epg_table_clear (service->tables[i]);
+      g_slice_free (EpgTable, service->tables[i]);
+    }
+  }
+  if (service->events)
+    g_ptr_array_unref (service->events);
+  g_slice_free (EpgService, service);
+}
+
+static void
+_free_event (gpointer event)
+{
+  g_boxed_free (GST_TYPE_MPEGTS_EIT_EVENT, event);
+}
+
+static gint
+_compare_events (gconstpointer a, gconstpointer b)
+{
+  const GstMpegtsEITEvent *event_a = *(const GstMpegtsEITEvent **) a;
+  const GstMpegtsEITEvent *event_b = *(const GstMpegtsEITEvent **) b;
+  GstDateTime *time_a = event_a->start_time;
+  GstDateTime *time_b = event_b->start_time;
+  gint diff;
+
+  /* events without a start time go last */
+  if (time_a == NULL || time_b == NULL)
+    return (time_a == NULL) - (time_b == NULL);
+
+  if ((diff = gst_date_time_get_year (time_a) -
+          gst_date_time_get_year (time_b)))
+    return diff;
+  if ((diff = gst_date_time_get_month (time_a) -
+          gst_date_time_get_month (time_b)))
+    return diff;
+  if ((diff = gst_date_time_get_day (time_a) - gst_date_time_get_day (time_b)))
+    return diff;
+  if ((diff = gst_date_time_get_hour (time_a) -
+          gst_date_time_get_hour (time_b)))
+    return diff;
+  if ((diff = gst_date_time_get_minute (time_a) -
+          gst_date_time_get_minute (time_b)))
+    return diff;
+  if ((diff = gst_date_time_get_second (time_a) -
+          gst_date_time_get_second (time_b)))
+    return diff;
+
+  return event_a->event_id - event_b->event_id;
+}
+
+/* Merges the events of all the sections of @service, ordered by start time.
+ * Tables are walked by increasing table id, so that an event present in
+ * both the present/following and the schedule tables is taken from the
+ * former */
+static GPtrArray *
+_epg_service_merge_events (EpgService * service)
+{
+  GPtrArray *events;
+  GHashTable *seen;
+  guint i, j, k;
+
+  events = g_ptr_array_new_with_free_func (_free_event);
+  seen = g_hash_table_new (NULL, NULL);
+
+  for (i = 0; i < EPG_N_TABLES; i++) {
+    EpgTable *table = service->tables[i];
+
+    if (table == NULL)
+      continue;
+
+    for (j = 0; j < G_N_ELEMENTS (table->sections); j++) {
+      const GstMpegtsEIT *eit;
+
+      if (table->sections[j] == NULL)
+        continue;
+
+      /* parsed when added, this only returns the cached EIT */
+      eit = gst_mpegts_section_get_eit (table->sections[j]);
+      for (k = 0; k < eit->events->len; k++) {
+        GstMpegtsEITEvent *event = g_ptr_array_index (eit->events, k);
+
+        if (g_hash_table_contains (seen, GUINT_TO_POINTER (event->event_id)))
+          continue;
+        g_hash_table_add (seen, GUINT_TO_POINTER (event->event_id));
+        g_ptr_array_add (events,
+            g_boxed_copy (GST_TYPE_MPEGTS_EIT_EVENT, event));
+      }
+    }
+  }
+
+  g_hash_table_unref (seen);
+  g_ptr_array_sort (events, _compare_events);
+
+  return events;
+}
+
+static void
+gst_mpegts_epg_store_finalize (GObject * object)
+{
+  GstMpegtsEpgStore *store = GST_MPEGTS_EPG_STORE (object);
+
+  g_hash_table_unref (store->services);
+  g_mutex_clear (&store->lock);
+
+  G_OBJECT_CLASS (gst_mpegts_epg_store_parent_class)->finalize (object);
+}
+
+static void
+gst_mpegts_epg_store_class_init (GstMpegtsEpgStoreClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->finalize = gst_mpegts_epg_store_finalize;
+
+  /**
+   * GstMpegtsEpgStore::service-changed:
+   * @store: the #GstMpegtsEpgStore
+   * @original_network_id: the original network id of the service
+   * @transport_stream_id: the transport stream id of the service
+   * @service_id: the id of the service
+   *
+   * Emitted, without any lock held, after a section changing the events of
+   * a service was added to @store.
+   *
+   * Since: 1.14
+   */
+  epg_store_signals[SIGNAL_SERVICE_CHANGED] =
+      g_signal_new ("service-changed", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_NONE, 3, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT);
+}
+
+static void
+gst_mpegts_epg_store_init (GstMpegtsEpgStore * store)
+{
+  g_mutex_init (&store->lock);
+  store->services = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+      NULL, (GDestroyNotify) _epg_service_free);
+}
+
+/**
+ * gst_mpegts_epg_store_new:
+ *
+ * Creates a new, empty, #GstMpegtsEpgStore.
+ *
+ * Returns: (transfer full): a new #GstMpegtsEpgStore
+ *
+ * Since: 1.14
+ */
+GstMpegtsEpgStore *
+gst_mpegts_epg_store_new (void)
+{
+  return g_object_new (GST_TYPE_MPEGTS_EPG_STORE, NULL);
+}
+
+/**
+ * gst_mpegts_epg_store_add_section:
+ * @store: a #GstMpegtsEpgStore
+ * @section: (transfer none): a #GstMpegtsSection
+ *
+ * Adds @section to @store. Sections that are not EITs, not currently
+ * applicable, or already present for the current version of their table
+ * are ignored. A new version of a table replaces all the sections of the
+ * previous version.
+ *
+ * Returns: %TRUE if the events of the service of @section changed.
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_mpegts_epg_store_add_section (GstMpegtsEpgStore * store,
+    GstMpegtsSection * section)
+{
+  EpgService *service;
+  EpgTable *table;
+  guint16 original_network_id, transport_stream_id, service_id;
+  gint64 key;
+
+  g_return_val_if_fail (GST_IS_MPEGTS_EPG_STORE (store), FALSE);
+  g_return_val_if_fail (section != NULL, FALSE);
+
+  if (section->section_type != GST_MPEGTS_SECTION_EIT ||
+      section->data == NULL || section->section_length < 18 ||
+      !section->current_next_indicator)
+    return FALSE;
+
+  if (section->table_id < EPG_FIRST_TABLE_ID ||
+      section->table_id > EPG_LAST_TABLE_ID)
+    return FALSE;
+
+  service_id = section->subtable_extension;
+  transport_stream_id = GST_READ_UINT16_BE (section->data + 8);
+  original_network_id = GST_READ_UINT16_BE (section->data + 10);
+  key = _service_key (original_network_id, transport_stream_id, service_id);
+
+  g_mutex_lock (&store->lock);
+
+  service = g_hash_table_lookup (store->services, &key);
+  if (service == NULL) {
+    service = g_slice_new0 (EpgService);
+    service->key = key;
+    service->original_network_id = original_network_id;
+    service->transport_stream_id = transport_stream_id;
+    service->service_id = service_id;
+    g_hash_table_insert (store->services, &service->key, service);
+  }
+
+  table = service->tables[section->table_id - EPG_FIRST_TABLE_ID];
+  if (table == NULL) {
+    table = g_slice_new0 (EpgTable);
+    table->version_number = section->version_number;
+    service->tables[section->table_id - EPG_FIRST_TABLE_ID] = table;
+  } else if (table->version_number != section->version_number) {
+    GST_DEBUG ("service %d table 0x%02x version %d -> %d", service_id,
+        section->table_id, table->version_number, section->version_number);
+    _epg_table_clear (table);
+    table->version_number = section->version_number;
+  } else if (table->sections[section->section_number]) {
+    /* already have it, don't bother parsing */
+    g_mutex_unlock (&store->lock);
+    return FALSE;
+  }
+
+  if (gst_mpegts_section_get_eit (section) == NULL) {
+    g_mutex_unlock (&store->lock);
+    return FALSE;
+  }
+
+  GST_LOG ("service %d table 0x%02x version %d: new section %d", service_id,
+      section->table_id, section->version_number, section->section_number);
+
+  table->sections[section->section_number] =
+      gst_mpegts_section_ref (section);
+  if (service->events) {
+    g_ptr_array_unref (service->events);
+    service->events = NULL;
+  }
+
+  g_mutex_unlock (&store->lock);
+
+  g_signal_emit (store, epg_store_signals[SIGNAL_SERVICE_CHANGED], 0,
+      (guint) original_network_id, (guint) transport_stream_id,
+      (guint) service_id);
+
+  return TRUE;
+}
+
+/**
+ * gst_mpegts_epg_store_get_events:
+ * @store: a #GstMpegtsEpgStore
+ * @original_network_id: the original network id of the service
+ * @transport_stream_id: the transport stream id of the service
+ * @service_id: the id of the service
+ *
+ * Gets the events of a service, merged from all its EIT sections and
+ * ordered by start time. The list is only rebuilt after the events of the
+ * service changed, and must not be modified.
+ *
+ * Returns: (transfer full) (element-type GstMpegtsEITEvent) (nullable): the
+ * events of the service, or %NULL if no section of the service was added.
+ *
+ * Since: 1.14
+ */
+GPtrArray *
+gst_mpegts_epg_store_get_events (GstMpegtsEpgStore * store,
+    guint16 original_network_id, guint16 transport_stream_id,
+    guint16 service_id)
+{
+  EpgService *service;
+  GPtrArray *events = NULL;
+  gint64 key;
+
+  g_return_val_if_fail (GST_IS_MPEGTS_EPG_STORE (store), NULL);
+
+  key = _service_key (original_network_id, transport_stream_id, service_id);
+
+  g_mutex_lock (&store->lock);
+  service = g_hash_table_lookup (store->services, &key);
+  if (service) {
+    if (service->events == NULL)
+      service->events = _epg_service_merge_events (service);
+    events = g_ptr_array_ref (service->events);
+  }
+  g_mutex_unlock (&store->lock);
+
+  return events;
+}
+
+/**
+ * gst_mpegts_epg_store_clear:
+ * @store: a #GstMpegtsEpgStore
+ *
+ * Removes all the sections and events from @store, for example after
+ * tuning to another multiplex.
+ *
+ * Since: 1.14
+ */
+void
+gst_mpegts_epg_store_clear (GstMpegtsEpgStore * store)
+{
+  g_return_if_fail (GST_IS_MPEGTS_EPG_STORE (store));
+
+  g_mutex_lock (&store->lock);
+  g_hash_table_remove_all (store->services);
+  g_mutex_unlock (&store->lock);
+}
@@ -0,0 +1,63 @@
+/*
+ * gst-dvb-epg.h -
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GST_DVB_EPG_H
+#define GST_DVB_EPG_H
+
+#include <gst/gst.h>
+#include <gst/mpegts/gstmpegtssection.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_MPEGTS_EPG_STORE (gst_mpegts_epg_store_get_type())
+#define GST_MPEGTS_EPG_STORE(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_MPEGTS_EPG_STORE,GstMpegtsEpgStore))
+#define GST_IS_MPEGTS_EPG_STORE(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_MPEGTS_EPG_STORE))
+
+/**
+ * GstMpegtsEpgStore:
+ *
+ * Opaque store aggregating EIT sections into per-service event lists.
+ *
+ * Since: 1.14
+ */
+typedef struct _GstMpegtsEpgStore GstMpegtsEpgStore;
+typedef struct _GstMpegtsEpgStoreClass GstMpegtsEpgStoreClass;
+
+GST_EXPORT
+GType gst_mpegts_epg_store_get_type (void);
+
+GST_EXPORT
+GstMpegtsEpgStore *gst_mpegts_epg_store_new (void);
+
+GST_EXPORT
+gboolean gst_mpegts_epg_store_add_section (GstMpegtsEpgStore *store,
+					   GstMpegtsSection *section);
+
+GST_EXPORT
+GPtrArray *gst_mpegts_epg_store_get_events (GstMpegtsEpgStore *store,
+					    guint16 original_network_id,
+					    guint16 transport_stream_id,
+					    guint16 service_id);
+
+GST_EXPORT
+void gst_mpegts_epg_store_clear (GstMpegtsEpgStore *store);
+
+G_END_DECLS
+
+#endif
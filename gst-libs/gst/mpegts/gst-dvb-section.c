@@ -148,18 +148,168 @@ _gst_mpegts_eit_free (GstMpegtsEIT * eit)
 G_DEFINE_BOXED_TYPE (GstMpegtsEIT, gst_mpegts_eit,
     (GBoxedCopyFunc) _gst_mpegts_eit_copy, (GFreeFunc) _gst_mpegts_eit_free);
 
+/* Returns the 40 bit UTC time at @data (16 bit MJD + 24 bit BCD) in
+ * nanoseconds since the Unix epoch, or GST_CLOCK_TIME_NONE if undefined */
+static GstClockTime
+_parse_utc_time_ns (const guint8 * data)
+{
+  guint16 mjd;
+  guint hour, minute, second;
+
+  mjd = GST_READ_UINT16_BE (data);
+
+  /* 40587 is the MJD of 1970-01-01 */
+  if (mjd == G_MAXUINT16 || mjd < 40587)
+    return GST_CLOCK_TIME_NONE;
+
+  hour = ((data[2] & 0x30) >> 4) * 10 + (data[2] & 0x0F);
+  minute = ((data[3] & 0x70) >> 4) * 10 + (data[3] & 0x0F);
+  second = ((data[4] & 0x70) >> 4) * 10 + (data[4] & 0x0F);
+
+  if (hour >= 24 || minute >= 60 || second >= 60)
+    return GST_CLOCK_TIME_NONE;
+
+  return (((guint64) (mjd - 40587) * 24 + hour) * 3600 + minute * 60 +
+      second) * GST_SECOND;
+}
+
+/* Returns the 24 bit BCD duration at @data in seconds */
+static guint32
+_parse_duration (const guint8 * data)
+{
+  return (((data[0] & 0xF0) >> 4) * 10 + (data[0] & 0x0F)) * 60 * 60 +
+      (((data[1] & 0xF0) >> 4) * 10 + (data[1] & 0x0F)) * 60 +
+      ((data[2] & 0xF0) >> 4) * 10 + (data[2] & 0x0F);
+}
+
+/* Returns the next event entry of @iter and its descriptors, or %NULL at
+ * the end of the event loop or if the entry is invalid */
+static const guint8 *
+_eit_iter_next_entry (GstMpegtsEITIter * iter,
+    GstMpegtsDescriptorIter * descriptors)
+{
+  const guint8 *data = iter->data;
+  guint16 descriptors_loop_length;
+
+  if (data == iter->end)
+    return NULL;
+
+  /* 12 is the minimum entry size */
+  if (iter->end - data < 12) {
+    GST_WARNING ("PID %d invalid EIT entry length %d",
+        iter->pid, (gint) (iter->end - data));
+    return NULL;
+  }
+
+  descriptors_loop_length = GST_READ_UINT16_BE (data + 10) & 0x0FFF;
+  if (iter->end - data - 12 < descriptors_loop_length) {
+    GST_WARNING ("PID %d invalid EIT descriptors loop length %d left %d",
+        iter->pid, descriptors_loop_length, (gint) (iter->end - data - 12));
+    return NULL;
+  }
+
+  gst_mpegts_descriptor_iter_init (descriptors, data + 12,
+      descriptors_loop_length);
+  iter->data = data + 12 + descriptors_loop_length;
+
+  return data;
+}
+
+/**
+ * gst_mpegts_section_eit_iter_init:
+ * @section: a #GstMpegtsSection of type %GST_MPEGTS_SECTION_EIT
+ * @iter: (out caller-allocates): a #GstMpegtsEITIter
+ *
+ * Validates the EIT contained in @section and initializes @iter to walk
+ * its events with gst_mpegts_eit_iter_next(), directly over the section
+ * data. Contrary to gst_mpegts_section_get_eit() nothing is allocated,
+ * which is cheaper when scanning many sections for a few events.
+ *
+ * Returns: %TRUE if @iter was initialized, %FALSE if @section is invalid.
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_mpegts_section_eit_iter_init (GstMpegtsSection * section,
+    GstMpegtsEITIter * iter)
+{
+  g_return_val_if_fail (section != NULL, FALSE);
+  g_return_val_if_fail (section->section_type == GST_MPEGTS_SECTION_EIT,
+      FALSE);
+  g_return_val_if_fail (section->data, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  if (!__common_section_valid (section, 18))
+    return FALSE;
+
+  /* skip the section header and the fixed EIT fields */
+  iter->data = section->data + 14;
+  iter->end = section->data + section->section_length - 4;
+  iter->pid = section->pid;
+
+  return TRUE;
+}
+
+/**
+ * gst_mpegts_eit_iter_next:
+ * @iter: a #GstMpegtsEITIter
+ * @event_id: (out) (allow-none): the event id
+ * @start_time: (out) (allow-none): the start time of the event in
+ * nanoseconds since the Unix epoch, or %GST_CLOCK_TIME_NONE if undefined
+ * @duration: (out) (allow-none): the duration of the event in seconds
+ * @running_status: (out) (allow-none): the running status of the event
+ * @free_CA_mode: (out) (allow-none): whether the event is scrambled
+ * @descriptors: (out caller-allocates) (allow-none): iterator over the
+ * descriptors of the event
+ *
+ * Reads the next event of the EIT walked by @iter.
+ *
+ * Returns: %TRUE if an event was read, %FALSE at the end of the event loop
+ * or if the next event is invalid.
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_mpegts_eit_iter_next (GstMpegtsEITIter * iter, guint16 * event_id,
+    GstClockTime * start_time, guint32 * duration,
+    GstMpegtsRunningStatus * running_status, gboolean * free_CA_mode,
+    GstMpegtsDescriptorIter * descriptors)
+{
+  GstMpegtsDescriptorIter tmp;
+  const guint8 *data;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  data = _eit_iter_next_entry (iter, descriptors ? descriptors : &tmp);
+  if (data == NULL)
+    return FALSE;
+
+  if (event_id)
+    *event_id = GST_READ_UINT16_BE (data);
+  if (start_time)
+    *start_time = _parse_utc_time_ns (data + 2);
+  if (duration)
+    *duration = _parse_duration (data + 7);
+  if (running_status)
+    *running_status = data[10] >> 5;
+  if (free_CA_mode)
+    *free_CA_mode = (data[10] >> 4) & 0x01;
+
+  return TRUE;
+}
+
 static gpointer
 _parse_eit (GstMpegtsSection * section)
 {
   GstMpegtsEIT *eit = NULL;
-  guint i = 0, allocated_events = 12;
-  guint8 *data, *end, *duration_ptr;
-  guint16 descriptors_loop_length;
+  GstMpegtsEITIter iter;
+  GstMpegtsDescriptorIter descriptors;
+  guint allocated_events = 12;
+  guint8 *data;
 
   eit = g_slice_new0 (GstMpegtsEIT);
 
   data = section->data;
-  end = data + section->section_length;
 
   /* Skip already parsed data */
   data += 8;
@@ -180,49 +330,33 @@ _parse_eit (GstMpegtsSection * section)
       g_ptr_array_new_full (allocated_events,
       (GDestroyNotify) _gst_mpegts_eit_event_free);
 
-  while (data < end - 4) {
-    GstMpegtsEITEvent *event;
+  iter.data = data;
+  iter.end = section->data + section->section_length - 4;
+  iter.pid = section->pid;
 
-    /* 12 is the minimum entry size + CRC */
-    if (end - data < 12 + 4) {
-      GST_WARNING ("PID %d invalid EIT entry length %d",
-          section->pid, (gint) (end - 4 - data));
-      goto error;
-    }
+  while ((data = (guint8 *) _eit_iter_next_entry (&iter, &descriptors))) {
+    GstMpegtsEITEvent *event;
 
     event = g_slice_new0 (GstMpegtsEITEvent);
     g_ptr_array_add (eit->events, event);
 
     event->event_id = GST_READ_UINT16_BE (data);
-    data += 2;
-
-    event->start_time = _parse_utc_time (data);
-    duration_ptr = data + 5;
-    event->duration = (((duration_ptr[0] & 0xF0) >> 4) * 10 +
-        (duration_ptr[0] & 0x0F)) * 60 * 60 +
-        (((duration_ptr[1] & 0xF0) >> 4) * 10 +
-        (duration_ptr[1] & 0x0F)) * 60 +
-        ((duration_ptr[2] & 0xF0) >> 4) * 10 + (duration_ptr[2] & 0x0F);
-
-    data += 8;
-    event->running_status = *data >> 5;
-    event->free_CA_mode = (*data >> 4) & 0x01;
-
-    descriptors_loop_length = GST_READ_UINT16_BE (data) & 0x0FFF;
-    data += 2;
+    event->start_time = _parse_utc_time (data + 2);
+    event->duration = _parse_duration (data + 7);
+    event->running_status = data[10] >> 5;
+    event->free_CA_mode = (data[10] >> 4) & 0x01;
 
     event->descriptors =
-        gst_mpegts_parse_descriptors (data, descriptors_loop_length);
+        gst_mpegts_parse_descriptors ((guint8 *) descriptors.data,
+        descriptors.end - descriptors.data);
     if (event->descriptors == NULL)
       goto error;
-    data += descriptors_loop_length;
-
-    i += 1;
   }
 
-  if (data != end - 4) {
+  if (iter.data != iter.end) {
     GST_WARNING ("PID %d invalid EIT parsed %d length %d",
-        section->pid, (gint) (data - section->data), section->section_length);
+        section->pid, (gint) (iter.data - section->data),
+        section->section_length);
     goto error;
   }
 
@@ -342,6 +342,40 @@ GType gst_mpegts_eit_event_get_type (void);
 GST_EXPORT
 const GstMpegtsEIT *gst_mpegts_section_get_eit (GstMpegtsSection *section);
 
+/**
+ * GstMpegtsEITIter:
+ *
+ * Iterator over the events of an EIT section, reading them in place
+ * without allocating. Meant to be allocated on the stack and initialized
+ * with gst_mpegts_section_eit_iter_init().
+ *
+ * Since: 1.14
+ */
+typedef struct _GstMpegtsEITIter GstMpegtsEITIter;
+
+struct _GstMpegtsEITIter
+{
+  /*< private >*/
+  const guint8 *data;
+  const guint8 *end;
+  guint16       pid;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GST_EXPORT
+gboolean gst_mpegts_section_eit_iter_init (GstMpegtsSection *section,
+					   GstMpegtsEITIter *iter);
+
+GST_EXPORT
+gboolean gst_mpegts_eit_iter_next (GstMpegtsEITIter *iter,
+				   guint16 *event_id,
+				   GstClockTime *start_time,
+				   guint32 *duration,
+				   GstMpegtsRunningStatus *running_status,
+				   gboolean *free_CA_mode,
+				   GstMpegtsDescriptorIter *descriptors);
+
 /* TDT */
 
 GST_EXPORT
@@ -43,6 +43,8 @@ G_GNUC_INTERNAL GstMpegtsSection *_gst_mpegts_section_init (guint16 pid, guint8
 G_GNUC_INTERNAL void _packetize_common_section (GstMpegtsSection * section, gsize length);
 
 typedef gpointer (*GstMpegtsParseFunc) (GstMpegtsSection *section);
+G_GNUC_INTERNAL gboolean __common_section_valid (GstMpegtsSection *section,
+						 guint minsize);
 G_GNUC_INTERNAL gpointer __common_section_checks (GstMpegtsSection *section,
 						  guint minsize,
 						  GstMpegtsParseFunc parsefunc,
@@ -724,6 +724,79 @@ G_DEFINE_BOXED_TYPE (GstMpegtsDescriptor, gst_mpegts_descriptor,
     (GBoxedCopyFunc) _copy_descriptor,
     (GBoxedFreeFunc) gst_mpegts_descriptor_free);
 
+/**
+ * gst_mpegts_descriptor_iter_init:
+ * @iter: (out caller-allocates): a #GstMpegtsDescriptorIter
+ * @buffer: (transfer none): descriptors to iterate
+ * @buf_len: Size of @buffer
+ *
+ * Initializes @iter to walk the descriptor loop present in @buffer with
+ * gst_mpegts_descriptor_iter_next(). No memory is allocated and @buffer
+ * must remain valid for as long as @iter and the descriptors returned by it
+ * are used.
+ *
+ * Since: 1.14
+ */
+void
+gst_mpegts_descriptor_iter_init (GstMpegtsDescriptorIter * iter,
+    const guint8 * buffer, gsize buf_len)
+{
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (buffer != NULL || buf_len == 0);
+
+  iter->data = buffer;
+  iter->end = buffer + buf_len;
+}
+
+/**
+ * gst_mpegts_descriptor_iter_next:
+ * @iter: a #GstMpegtsDescriptorIter
+ * @descriptor: (out caller-allocates): a #GstMpegtsDescriptor to fill
+ *
+ * Fills @descriptor with the next descriptor of @iter. The descriptor
+ * points directly into the buffer @iter was initialized with, can be passed
+ * to all the gst_mpegts_descriptor_parse_*() functions and must not be
+ * freed with gst_mpegts_descriptor_free().
+ *
+ * Returns: %TRUE if @descriptor was filled, %FALSE at the end of the loop
+ * or if the next descriptor is truncated.
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_mpegts_descriptor_iter_next (GstMpegtsDescriptorIter * iter,
+    GstMpegtsDescriptor * descriptor)
+{
+  const guint8 *data;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (descriptor != NULL, FALSE);
+
+  data = iter->data;
+
+  if (data == iter->end)
+    return FALSE;
+
+  if (iter->end - data < 2 || iter->end - data - 2 < data[1]) {
+    GST_WARNING ("truncated descriptor, %d bytes left",
+        (gint) (iter->end - data));
+    return FALSE;
+  }
+
+  descriptor->tag = data[0];
+  descriptor->length = data[1];
+  descriptor->data = (guint8 *) data;
+  /* extended descriptors */
+  if (G_UNLIKELY (descriptor->tag == 0x7f && descriptor->length))
+    descriptor->tag_extension = data[2];
+  else
+    descriptor->tag_extension = 0;
+
+  iter->data = data + 2 + descriptor->length;
+
+  return TRUE;
+}
+
 /**
  * gst_mpegts_parse_descriptors:
  * @buffer: (transfer none): descriptors to parse
@@ -742,38 +815,26 @@ GPtrArray *
 gst_mpegts_parse_descriptors (guint8 * buffer, gsize buf_len)
 {
   GPtrArray *res;
-  guint8 length;
-  guint8 *data;
+  GstMpegtsDescriptorIter iter;
+  GstMpegtsDescriptor tmp;
   guint i, nb_desc = 0;
 
   /* fast-path */
   if (buf_len == 0)
     return g_ptr_array_new ();
 
-  data = buffer;
-
   GST_MEMDUMP ("Full descriptor array", buffer, buf_len);
 
-  while (data - buffer < buf_len) {
-    data++;                     /* skip tag */
-    length = *data++;
-
-    if (data - buffer > buf_len) {
-      GST_WARNING ("invalid descriptor length %d now at %d max %"
-          G_GSIZE_FORMAT, length, (gint) (data - buffer), buf_len);
-      return NULL;
-    }
-
-    data += length;
+  gst_mpegts_descriptor_iter_init (&iter, buffer, buf_len);
+  while (gst_mpegts_descriptor_iter_next (&iter, &tmp))
     nb_desc++;
-  }
 
   GST_DEBUG ("Saw %d descriptors, read %" G_GSIZE_FORMAT " bytes",
-      nb_desc, (gsize) (data - buffer));
+      nb_desc, (gsize) (iter.data - buffer));
 
-  if (data - buffer != buf_len) {
+  if (iter.data != iter.end) {
     GST_WARNING ("descriptors size %d expected %" G_GSIZE_FORMAT,
-        (gint) (data - buffer), buf_len);
+        (gint) (iter.data - buffer), buf_len);
     return NULL;
   }
 
@@ -781,23 +842,16 @@ gst_mpegts_parse_descriptors (guint8 * buffer, gsize buf_len)
       g_ptr_array_new_full (nb_desc + 1,
       (GDestroyNotify) gst_mpegts_descriptor_free);
 
-  data = buffer;
+  gst_mpegts_descriptor_iter_init (&iter, buffer, buf_len);
 
   for (i = 0; i < nb_desc; i++) {
     GstMpegtsDescriptor *desc = g_slice_new0 (GstMpegtsDescriptor);
 
-    desc->data = data;
-    desc->tag = *data++;
-    desc->length = *data++;
+    gst_mpegts_descriptor_iter_next (&iter, desc);
     /* Copy the data now that we known the size */
     desc->data = g_memdup (desc->data, desc->length + 2);
     GST_LOG ("descriptor 0x%02x length:%d", desc->tag, desc->length);
     GST_MEMDUMP ("descriptor", desc->data + 2, desc->length);
-    /* extended descriptors */
-    if (G_UNLIKELY (desc->tag == 0x7f))
-      desc->tag_extension = *data;
-
-    data += desc->length;
 
     /* Set the descriptor in the array */
     g_ptr_array_index (res, i) = desc;
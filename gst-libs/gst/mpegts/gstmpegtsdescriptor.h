@@ -273,6 +273,34 @@ GST_EXPORT
 const GstMpegtsDescriptor * gst_mpegts_find_descriptor (GPtrArray *descriptors,
 							guint8 tag);
 
+/**
+ * GstMpegtsDescriptorIter:
+ *
+ * Iterator over a descriptor loop, walking the descriptors in place without
+ * allocating them. Meant to be allocated on the stack and initialized with
+ * gst_mpegts_descriptor_iter_init().
+ *
+ * Since: 1.14
+ */
+typedef struct _GstMpegtsDescriptorIter GstMpegtsDescriptorIter;
+
+struct _GstMpegtsDescriptorIter
+{
+  /*< private >*/
+  const guint8 *data;
+  const guint8 *end;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GST_EXPORT
+void     gst_mpegts_descriptor_iter_init (GstMpegtsDescriptorIter *iter,
+					  const guint8 *buffer, gsize buf_len);
+
+GST_EXPORT
+gboolean gst_mpegts_descriptor_iter_next (GstMpegtsDescriptorIter *iter,
+					  GstMpegtsDescriptor *descriptor);
+
 /* GST_MTS_DESC_REGISTRATION (0x05) */
 
 GST_EXPORT
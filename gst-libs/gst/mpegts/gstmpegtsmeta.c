@@ -0,0 +1,130 @@
+/*
+ * gstmpegtsmeta.c -
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mpegts.h"
+
+/**
+ * SECTION:gstmpegtsmeta
+ * @title: Buffer metadata
+ * @short_description: Metadata attached to transport stream buffers
+ * @include: gst/mpegts/mpegts.h
+ *
+ * #GstMpegtsSegmentStartMeta is attached by muxers to the buffer starting
+ * a new segment, e.g. in response to a force key unit event, so that
+ * segmenters can split the stream without parsing it.
+ */
+
+static gboolean
+gst_mpegts_segment_start_meta_init (GstMpegtsSegmentStartMeta * meta,
+    gpointer params, GstBuffer * buffer)
+{
+  meta->running_time = GST_CLOCK_TIME_NONE;
+  meta->count = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_mpegts_segment_start_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstMpegtsSegmentStartMeta *smeta = (GstMpegtsSegmentStartMeta *) meta;
+
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    GstMetaTransformCopy *copy = data;
+
+    /* only keep it if the start of the buffer is kept */
+    if (!copy->region || copy->offset == 0) {
+      if (!gst_buffer_add_mpegts_segment_start_meta (dest,
+              smeta->running_time, smeta->count))
+        return FALSE;
+    }
+  } else {
+    /* return FALSE, if transform type is not supported */
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+GType
+gst_mpegts_segment_start_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type =
+        gst_meta_api_type_register ("GstMpegtsSegmentStartMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo *
+gst_mpegts_segment_start_meta_get_info (void)
+{
+  static const GstMetaInfo *segment_start_meta_info = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) & segment_start_meta_info)) {
+    const GstMetaInfo *meta =
+        gst_meta_register (GST_MPEGTS_SEGMENT_START_META_API_TYPE,
+        "GstMpegtsSegmentStartMeta", sizeof (GstMpegtsSegmentStartMeta),
+        (GstMetaInitFunction) gst_mpegts_segment_start_meta_init,
+        (GstMetaFreeFunction) NULL,
+        (GstMetaTransformFunction) gst_mpegts_segment_start_meta_transform);
+    g_once_init_leave ((GstMetaInfo **) & segment_start_meta_info,
+        (GstMetaInfo *) meta);
+  }
+
+  return segment_start_meta_info;
+}
+
+/**
+ * gst_buffer_add_mpegts_segment_start_meta:
+ * @buffer: a #GstBuffer
+ * @running_time: the running time of the key unit starting the segment
+ * @count: the count of the force key unit event that requested the segment
+ *
+ * Creates and adds a #GstMpegtsSegmentStartMeta to a @buffer.
+ *
+ * Returns: (transfer none): a newly created #GstMpegtsSegmentStartMeta
+ *
+ * Since: 1.14
+ */
+GstMpegtsSegmentStartMeta *
+gst_buffer_add_mpegts_segment_start_meta (GstBuffer * buffer,
+    GstClockTime running_time, guint count)
+{
+  GstMpegtsSegmentStartMeta *meta;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+
+  meta = (GstMpegtsSegmentStartMeta *) gst_buffer_add_meta (buffer,
+      GST_MPEGTS_SEGMENT_START_META_INFO, NULL);
+
+  meta->running_time = running_time;
+  meta->count = count;
+
+  return meta;
+}
@@ -0,0 +1,66 @@
+/*
+ * gstmpegtsmeta.h -
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GST_MPEGTS_META_H
+#define GST_MPEGTS_META_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstMpegtsSegmentStartMeta GstMpegtsSegmentStartMeta;
+
+GST_EXPORT
+GType gst_mpegts_segment_start_meta_api_get_type (void);
+#define GST_MPEGTS_SEGMENT_START_META_API_TYPE (gst_mpegts_segment_start_meta_api_get_type())
+#define GST_MPEGTS_SEGMENT_START_META_INFO (gst_mpegts_segment_start_meta_get_info())
+GST_EXPORT
+const GstMetaInfo * gst_mpegts_segment_start_meta_get_info (void);
+
+/**
+ * GstMpegtsSegmentStartMeta:
+ * @meta: parent #GstMeta
+ * @running_time: the running time of the key unit starting the segment
+ * @count: the count of the force key unit event the segment was started for
+ *
+ * Marks a buffer of transport stream as the start of a new segment. The
+ * buffer starts with a PAT and the PMTs, followed by the key unit the
+ * segment was requested for, so it is a safe place to split the stream
+ * without having to parse it.
+ *
+ * Since: 1.14
+ */
+struct _GstMpegtsSegmentStartMeta {
+  GstMeta      meta;
+
+  GstClockTime running_time;
+  guint        count;
+};
+
+#define gst_buffer_get_mpegts_segment_start_meta(b) ((GstMpegtsSegmentStartMeta*)gst_buffer_get_meta((b),GST_MPEGTS_SEGMENT_START_META_API_TYPE))
+
+GST_EXPORT
+GstMpegtsSegmentStartMeta *
+gst_buffer_add_mpegts_segment_start_meta (GstBuffer * buffer,
+                                          GstClockTime running_time,
+                                          guint count);
+
+G_END_DECLS
+
+#endif
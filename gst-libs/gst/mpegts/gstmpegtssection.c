@@ -127,31 +127,71 @@ static const guint32 crc_tab[256] = {
   0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
 
+/* Slice-by-8 tables: crc_tables[0] is crc_tab, and crc_tables[k][i] is the
+ * CRC of byte i followed by k zero bytes. They let _calc_crc32 process
+ * 8 bytes per iteration with independent table lookups. */
+static guint32 crc_tables[8][256];
+
+static void
+_init_crc_tables (void)
+{
+  static gsize tables_initialized = 0;
+  guint i, k;
+
+  if (!g_once_init_enter (&tables_initialized))
+    return;
+
+  for (i = 0; i < 256; i++)
+    crc_tables[0][i] = crc_tab[i];
+  for (k = 1; k < 8; k++) {
+    for (i = 0; i < 256; i++) {
+      guint32 crc = crc_tables[k - 1][i];
+      crc_tables[k][i] = (crc << 8) ^ crc_tab[crc >> 24];
+    }
+  }
+
+  g_once_init_leave (&tables_initialized, 1);
+}
+
 /* _calc_crc32 relicensed to LGPL from fluendo ts demuxer */
 guint32
 _calc_crc32 (const guint8 * data, guint datalen)
 {
-  gint i;
   guint32 crc = 0xffffffff;
 
-  for (i = 0; i < datalen; i++) {
-    crc = (crc << 8) ^ crc_tab[((crc >> 24) ^ *data++) & 0xff];
+  _init_crc_tables ();
+
+  while (datalen >= 8) {
+    guint32 one = crc ^ GST_READ_UINT32_BE (data);
+    guint32 two = GST_READ_UINT32_BE (data + 4);
+
+    crc = crc_tables[7][one >> 24] ^
+        crc_tables[6][(one >> 16) & 0xff] ^
+        crc_tables[5][(one >> 8) & 0xff] ^
+        crc_tables[4][one & 0xff] ^
+        crc_tables[3][two >> 24] ^
+        crc_tables[2][(two >> 16) & 0xff] ^
+        crc_tables[1][(two >> 8) & 0xff] ^ crc_tables[0][two & 0xff];
+
+    data += 8;
+    datalen -= 8;
   }
+
+  while (datalen--)
+    crc = (crc << 8) ^ crc_tab[((crc >> 24) ^ *data++) & 0xff];
+
   return crc;
 }
 
-gpointer
-__common_section_checks (GstMpegtsSection * section, guint min_size,
-    GstMpegtsParseFunc parsefunc, GDestroyNotify destroynotify)
+gboolean
+__common_section_valid (GstMpegtsSection * section, guint min_size)
 {
-  gpointer res;
-
   /* Check section is big enough */
   if (section->section_length < min_size) {
     GST_WARNING
         ("PID:0x%04x table_id:0x%02x, section too small (Got %d, need at least %d)",
         section->pid, section->table_id, section->section_length, min_size);
-    return NULL;
+    return FALSE;
   }
 
   /* If section has a CRC, check it */
@@ -159,9 +199,21 @@ __common_section_checks (GstMpegtsSection * section, guint min_size,
       && (_calc_crc32 (section->data, section->section_length) != 0)) {
     GST_WARNING ("PID:0x%04x table_id:0x%02x, Bad CRC on section", section->pid,
         section->table_id);
-    return NULL;
+    return FALSE;
   }
 
+  return TRUE;
+}
+
+gpointer
+__common_section_checks (GstMpegtsSection * section, guint min_size,
+    GstMpegtsParseFunc parsefunc, GDestroyNotify destroynotify)
+{
+  gpointer res;
+
+  if (!__common_section_valid (section, min_size))
+    return NULL;
+
   /* Finally parse and set the destroy notify */
   res = parsefunc (section);
   if (res == NULL)
@@ -641,87 +693,189 @@ G_DEFINE_BOXED_TYPE (GstMpegtsPMT, gst_mpegts_pmt,
     (GBoxedCopyFunc) _gst_mpegts_pmt_copy, (GFreeFunc) _gst_mpegts_pmt_free);
 
 
-static gpointer
-_parse_pmt (GstMpegtsSection * section)
+/* Sets up @iter on the stream loop of the PMT @section and returns the
+ * location of the program info descriptors, or %NULL if they overflow */
+static const guint8 *
+_pmt_iter_setup (GstMpegtsSection * section, GstMpegtsPMTIter * iter,
+    guint16 * pcr_pid, guint * program_info_length)
 {
-  GstMpegtsPMT *pmt = NULL;
-  guint i = 0, allocated_streams = 8;
-  guint8 *data, *end;
-  guint program_info_length;
-  guint stream_info_length;
-
-  pmt = g_slice_new0 (GstMpegtsPMT);
+  const guint8 *data, *end;
 
   data = section->data;
   end = data + section->section_length;
 
-  GST_DEBUG ("Parsing %d Program Map Table", section->subtable_extension);
-
-  /* Assign program number from subtable extension,
-     and skip already parsed data */
-  pmt->program_number = section->subtable_extension;
+  /* skip already parsed data */
   data += 8;
 
-  pmt->pcr_pid = GST_READ_UINT16_BE (data) & 0x1FFF;
+  *pcr_pid = GST_READ_UINT16_BE (data) & 0x1FFF;
   data += 2;
 
-  program_info_length = GST_READ_UINT16_BE (data) & 0x0FFF;
+  *program_info_length = GST_READ_UINT16_BE (data) & 0x0FFF;
   data += 2;
 
   /* check that the buffer is large enough to contain at least
    * program_info_length bytes + CRC */
-  if (program_info_length && (data + program_info_length + 4 > end)) {
+  if (*program_info_length && (data + *program_info_length + 4 > end)) {
     GST_WARNING ("PID %d invalid program info length %d left %d",
-        section->pid, program_info_length, (gint) (end - data));
-    goto error;
+        section->pid, *program_info_length, (gint) (end - data));
+    return NULL;
   }
-  pmt->descriptors = gst_mpegts_parse_descriptors (data, program_info_length);
+
+  iter->data = data + *program_info_length;
+  iter->end = end - 4;
+  iter->pid = section->pid;
+
+  return data;
+}
+
+/**
+ * gst_mpegts_section_pmt_iter_init:
+ * @section: a #GstMpegtsSection of type %GST_MPEGTS_SECTION_PMT
+ * @iter: (out caller-allocates): a #GstMpegtsPMTIter
+ * @pcr_pid: (out) (allow-none): PID of the stream containing PCR
+ * @descriptors: (out caller-allocates) (allow-none): iterator over the
+ * program info descriptors
+ *
+ * Validates the PMT contained in @section and initializes @iter to walk its
+ * elementary streams with gst_mpegts_pmt_iter_next(), directly over the
+ * section data. Contrary to gst_mpegts_section_get_pmt() nothing is
+ * allocated, which is cheaper when only a few fields are needed.
+ *
+ * Returns: %TRUE if @iter was initialized, %FALSE if @section is invalid.
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_mpegts_section_pmt_iter_init (GstMpegtsSection * section,
+    GstMpegtsPMTIter * iter, guint16 * pcr_pid,
+    GstMpegtsDescriptorIter * descriptors)
+{
+  const guint8 *info;
+  guint16 pid;
+  guint length;
+
+  g_return_val_if_fail (section != NULL, FALSE);
+  g_return_val_if_fail (section->section_type == GST_MPEGTS_SECTION_PMT,
+      FALSE);
+  g_return_val_if_fail (section->data, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  if (!__common_section_valid (section, 16))
+    return FALSE;
+
+  info = _pmt_iter_setup (section, iter, &pid, &length);
+  if (info == NULL)
+    return FALSE;
+
+  if (pcr_pid)
+    *pcr_pid = pid;
+  if (descriptors)
+    gst_mpegts_descriptor_iter_init (descriptors, info, length);
+
+  return TRUE;
+}
+
+/**
+ * gst_mpegts_pmt_iter_next:
+ * @iter: a #GstMpegtsPMTIter
+ * @stream_type: (out) (allow-none): the type of the stream
+ * @pid: (out) (allow-none): the PID of the stream
+ * @descriptors: (out caller-allocates) (allow-none): iterator over the
+ * descriptors of the stream
+ *
+ * Reads the next elementary stream entry of the PMT walked by @iter.
+ *
+ * Returns: %TRUE if an entry was read, %FALSE at the end of the stream loop
+ * or if the next entry is invalid.
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_mpegts_pmt_iter_next (GstMpegtsPMTIter * iter, guint8 * stream_type,
+    guint16 * pid, GstMpegtsDescriptorIter * descriptors)
+{
+  const guint8 *data;
+  guint stream_info_length;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  data = iter->data;
+
+  /* each entry is at least 5 bytes */
+  if (iter->end - data < 5)
+    return FALSE;
+
+  stream_info_length = GST_READ_UINT16_BE (data + 3) & 0x0FFF;
+  if (data + 5 + stream_info_length > iter->end) {
+    GST_WARNING ("PID %d invalid stream info length %d left %d", iter->pid,
+        stream_info_length, (gint) (iter->end - data - 5));
+    return FALSE;
+  }
+
+  if (stream_type)
+    *stream_type = data[0];
+  if (pid)
+    *pid = GST_READ_UINT16_BE (data + 1) & 0x1FFF;
+  if (descriptors)
+    gst_mpegts_descriptor_iter_init (descriptors, data + 5,
+        stream_info_length);
+
+  iter->data = data + 5 + stream_info_length;
+
+  return TRUE;
+}
+
+static gpointer
+_parse_pmt (GstMpegtsSection * section)
+{
+  GstMpegtsPMT *pmt = NULL;
+  GstMpegtsPMTIter iter;
+  GstMpegtsDescriptorIter descriptors;
+  guint i = 0, allocated_streams = 8;
+  const guint8 *info;
+  guint program_info_length;
+
+  pmt = g_slice_new0 (GstMpegtsPMT);
+
+  GST_DEBUG ("Parsing %d Program Map Table", section->subtable_extension);
+
+  /* Assign program number from subtable extension */
+  pmt->program_number = section->subtable_extension;
+
+  info = _pmt_iter_setup (section, &iter, &pmt->pcr_pid, &program_info_length);
+  if (info == NULL)
+    goto error;
+
+  pmt->descriptors =
+      gst_mpegts_parse_descriptors ((guint8 *) info, program_info_length);
   if (pmt->descriptors == NULL)
     goto error;
-  data += program_info_length;
 
   pmt->streams =
       g_ptr_array_new_full (allocated_streams,
       (GDestroyNotify) _gst_mpegts_pmt_stream_free);
 
-  /* parse entries, cycle until there's space for another entry (at least 5
-   * bytes) plus the CRC */
-  while (data <= end - 4 - 5) {
+  /* parse entries until the CRC, any leftover shorter than an entry means
+   * the section length was longer than the actual content of the PMT */
+  while (iter.data < iter.end) {
     GstMpegtsPMTStream *stream = g_slice_new0 (GstMpegtsPMTStream);
 
     g_ptr_array_add (pmt->streams, stream);
 
-    stream->stream_type = *data++;
-    GST_DEBUG ("[%d] Stream type 0x%02x found", i, stream->stream_type);
-
-    stream->pid = GST_READ_UINT16_BE (data) & 0x1FFF;
-    data += 2;
-
-    stream_info_length = GST_READ_UINT16_BE (data) & 0x0FFF;
-    data += 2;
-
-    if (data + stream_info_length + 4 > end) {
-      GST_WARNING ("PID %d invalid stream info length %d left %d", section->pid,
-          stream_info_length, (gint) (end - data));
+    if (!gst_mpegts_pmt_iter_next (&iter, &stream->stream_type, &stream->pid,
+            &descriptors))
       goto error;
-    }
+    GST_DEBUG ("[%d] Stream type 0x%02x found", i, stream->stream_type);
 
     stream->descriptors =
-        gst_mpegts_parse_descriptors (data, stream_info_length);
+        gst_mpegts_parse_descriptors ((guint8 *) descriptors.data,
+        descriptors.end - descriptors.data);
     if (stream->descriptors == NULL)
       goto error;
-    data += stream_info_length;
 
     i += 1;
   }
 
-  /* Section length was longer than the actual content of the PMT */
-  if (data < end - 4)
-    goto error;
-
-  /* Ensure we did not read after the end of our array */
-  g_assert (data == end - 4);
-
   return (gpointer) pmt;
 
 error:
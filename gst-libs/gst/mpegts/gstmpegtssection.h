@@ -395,6 +395,38 @@ const GstMpegtsPMT *gst_mpegts_section_get_pmt (GstMpegtsSection *section);
 GST_EXPORT
 GstMpegtsSection *gst_mpegts_section_from_pmt (GstMpegtsPMT *pmt, guint16 pid);
 
+/**
+ * GstMpegtsPMTIter:
+ *
+ * Iterator over the elementary streams of a PMT section, reading them in
+ * place without allocating. Meant to be allocated on the stack and
+ * initialized with gst_mpegts_section_pmt_iter_init().
+ *
+ * Since: 1.14
+ */
+typedef struct _GstMpegtsPMTIter GstMpegtsPMTIter;
+
+struct _GstMpegtsPMTIter
+{
+  /*< private >*/
+  const guint8 *data;
+  const guint8 *end;
+  guint16       pid;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GST_EXPORT
+gboolean gst_mpegts_section_pmt_iter_init (GstMpegtsSection *section,
+					   GstMpegtsPMTIter *iter,
+					   guint16 *pcr_pid,
+					   GstMpegtsDescriptorIter *descriptors);
+
+GST_EXPORT
+gboolean gst_mpegts_pmt_iter_next (GstMpegtsPMTIter *iter,
+				   guint8 *stream_type, guint16 *pid,
+				   GstMpegtsDescriptorIter *descriptors);
+
 /* TSDT */
 
 GST_EXPORT
@@ -34,7 +34,9 @@
 #include <gst/mpegts/gstmpegtssection.h>
 #include <gst/mpegts/gst-atsc-section.h>
 #include <gst/mpegts/gst-dvb-section.h>
+#include <gst/mpegts/gst-dvb-epg.h>
 #include <gst/mpegts/gst-scte-section.h>
+#include <gst/mpegts/gstmpegtsmeta.h>
 #include <gst/mpegts/gstmpegts-enumtypes.h>
 
 G_BEGIN_DECLS
@@ -51,6 +51,9 @@
 #include "gstopencvutils.h"
 
 #include <opencv2/core/core_c.h>
+#ifdef GST_OPENCV_HAVE_UMAT
+#include <opencv2/core/ocl.hpp>
+#endif
 
 GST_DEBUG_CATEGORY_STATIC (gst_opencv_video_filter_debug);
 #define GST_CAT_DEFAULT gst_opencv_video_filter_debug
@@ -64,9 +67,12 @@ enum
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_USE_OPENCL
 };
 
+#define DEFAULT_USE_OPENCL FALSE
+
 #define parent_class gst_opencv_video_filter_parent_class
 G_DEFINE_ABSTRACT_TYPE (GstOpencvVideoFilter, gst_opencv_video_filter,
     GST_TYPE_VIDEO_FILTER);
@@ -119,12 +125,44 @@ gst_opencv_video_filter_class_init (GstOpencvVideoFilterClass * klass)
   vfilter_class->transform_frame = gst_opencv_video_filter_transform_frame;
   vfilter_class->transform_frame_ip = gst_opencv_video_filter_transform_frame_ip;
   vfilter_class->set_info = gst_opencv_video_filter_set_info;
+
+  /**
+   * GstOpencvVideoFilter:use-opencl:
+   *
+   * Run subclasses that have a cv::UMat implementation through the OpenCV
+   * transparent API, which uses OpenCL if OpenCV has a device for it and
+   * falls back to the CPU otherwise.
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_OPENCL,
+      g_param_spec_boolean ("use-opencl", "Use OpenCL",
+          "Process on an OpenCL device if available and supported by the "
+          "element", DEFAULT_USE_OPENCL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 }
 
 static void
 gst_opencv_video_filter_init (GstOpencvVideoFilter * transform)
 {
+  transform->use_opencl = DEFAULT_USE_OPENCL;
+}
+
+/* header on the first plane of the mapped frame, the data is not copied */
+static cv::Mat
+gst_opencv_video_filter_wrap_frame (GstVideoFrame * frame, int cv_type)
+{
+  return cv::Mat (GST_VIDEO_FRAME_HEIGHT (frame), GST_VIDEO_FRAME_WIDTH (frame),
+      cv_type, GST_VIDEO_FRAME_PLANE_DATA (frame, 0),
+      GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0));
+}
+
+#ifdef GST_OPENCV_HAVE_UMAT
+static gboolean
+gst_opencv_video_filter_use_umat (GstOpencvVideoFilter * transform,
+    gboolean have_umat_func)
+{
+  return have_umat_func && transform->use_opencl && cv::ocl::useOpenCL ();
 }
+#endif
 
 static GstFlowReturn
 gst_opencv_video_filter_transform_frame (GstVideoFilter *trans,
@@ -137,6 +175,28 @@ gst_opencv_video_filter_transform_frame (GstVideoFilter *trans,
   transform = GST_OPENCV_VIDEO_FILTER (trans);
   fclass = GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
 
+  if (fclass->cv_trans_mat_func) {
+    cv::Mat img =
+        gst_opencv_video_filter_wrap_frame (inframe, transform->cv_type);
+    cv::Mat outimg =
+        gst_opencv_video_filter_wrap_frame (outframe, transform->out_cv_type);
+
+#ifdef GST_OPENCV_HAVE_UMAT
+    if (gst_opencv_video_filter_use_umat (transform,
+            fclass->cv_trans_umat_func != NULL)) {
+      /* the output is written back to the frame when uoutimg goes away */
+      cv::UMat uimg = img.getUMat (cv::ACCESS_READ);
+      cv::UMat uoutimg = outimg.getUMat (cv::ACCESS_WRITE);
+
+      return fclass->cv_trans_umat_func (transform, inframe->buffer, uimg,
+          outframe->buffer, uoutimg);
+    }
+#endif
+
+    return fclass->cv_trans_mat_func (transform, inframe->buffer, img,
+        outframe->buffer, outimg);
+  }
+
   g_return_val_if_fail (fclass->cv_trans_func != NULL, GST_FLOW_ERROR);
   g_return_val_if_fail (transform->cvImage != NULL, GST_FLOW_ERROR);
   g_return_val_if_fail (transform->out_cvImage != NULL, GST_FLOW_ERROR);
@@ -166,6 +226,21 @@ gst_opencv_video_filter_transform_frame_ip (GstVideoFilter * trans,
   transform = GST_OPENCV_VIDEO_FILTER (trans);
   fclass = GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
 
+  if (fclass->cv_trans_ip_mat_func) {
+    cv::Mat img = gst_opencv_video_filter_wrap_frame (frame, transform->cv_type);
+
+#ifdef GST_OPENCV_HAVE_UMAT
+    if (gst_opencv_video_filter_use_umat (transform,
+            fclass->cv_trans_ip_umat_func != NULL)) {
+      cv::UMat uimg = img.getUMat (cv::ACCESS_RW);
+
+      return fclass->cv_trans_ip_umat_func (transform, frame->buffer, uimg);
+    }
+#endif
+
+    return fclass->cv_trans_ip_mat_func (transform, frame->buffer, img);
+  }
+
   g_return_val_if_fail (fclass->cv_trans_ip_func != NULL, GST_FLOW_ERROR);
   g_return_val_if_fail (transform->cvImage != NULL, GST_FLOW_ERROR);
 
@@ -208,6 +283,12 @@ gst_opencv_video_filter_set_info (GstVideoFilter * trans, GstCaps * incaps,
     return FALSE;
   }
 
+  if (!gst_opencv_cv_image_type_from_video_format (GST_VIDEO_INFO_FORMAT
+          (in_info), &transform->cv_type, NULL)
+      || !gst_opencv_cv_image_type_from_video_format (GST_VIDEO_INFO_FORMAT
+          (out_info), &transform->out_cv_type, NULL))
+    return FALSE;
+
   if (klass->cv_set_caps) {
     if (!klass->cv_set_caps (transform, in_width, in_height, in_depth,
             in_channels, out_width, out_height, out_depth, out_channels))
@@ -236,7 +317,12 @@ static void
 gst_opencv_video_filter_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (object);
+
   switch (prop_id) {
+    case PROP_USE_OPENCL:
+      transform->use_opencl = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -247,7 +333,12 @@ static void
 gst_opencv_video_filter_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (object);
+
   switch (prop_id) {
+    case PROP_USE_OPENCL:
+      g_value_set_boolean (value, transform->use_opencl);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -46,6 +46,13 @@
 
 #include <gst/gst.h>
 #include <gst/video/gstvideofilter.h>
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/version.hpp>
+
+/* cv::UMat and the transparent OpenCL API are only in OpenCV 3 */
+#if CV_MAJOR_VERSION >= 3
+#define GST_OPENCV_HAVE_UMAT 1
+#endif
 
 G_BEGIN_DECLS
 
@@ -76,6 +83,22 @@ typedef GstFlowReturn (*GstOpencvVideoFilterTransformFunc)
     (GstOpencvVideoFilter * transform, GstBuffer * buffer, IplImage * img,
     GstBuffer * outbuf, IplImage * outimg);
 
+/* the cv::Mat and cv::UMat images wrap the mapped video frames, taking the
+ * strides into account, so subclasses work on the buffer memory directly */
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformIPMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::Mat & img);
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::Mat & img,
+    GstBuffer * outbuf, cv::Mat & outimg);
+
+#ifdef GST_OPENCV_HAVE_UMAT
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformIPUMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::UMat & img);
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformUMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::UMat & img,
+    GstBuffer * outbuf, cv::UMat & outimg);
+#endif
+
 typedef gboolean (*GstOpencvVideoFilterSetCaps)
     (GstOpencvVideoFilter * transform, gint in_width, gint in_height,
     gint in_depth, gint in_channels, gint out_width, gint out_height,
@@ -86,9 +109,13 @@ struct _GstOpencvVideoFilter
   GstVideoFilter trans;
 
   gboolean in_place;
+  gboolean use_opencl;
 
   IplImage *cvImage;
   IplImage *out_cvImage;
+
+  int cv_type;
+  int out_cv_type;
 };
 
 struct _GstOpencvVideoFilterClass
@@ -99,6 +126,19 @@ struct _GstOpencvVideoFilterClass
   GstOpencvVideoFilterTransformIPFunc cv_trans_ip_func;
 
   GstOpencvVideoFilterSetCaps cv_set_caps;
+
+  /* used instead of the IplImage functions above if set */
+  GstOpencvVideoFilterTransformMatFunc cv_trans_mat_func;
+  GstOpencvVideoFilterTransformIPMatFunc cv_trans_ip_mat_func;
+
+  /* used instead of the cv::Mat functions if set and OpenCL is enabled */
+#ifdef GST_OPENCV_HAVE_UMAT
+  GstOpencvVideoFilterTransformUMatFunc cv_trans_umat_func;
+  GstOpencvVideoFilterTransformIPUMatFunc cv_trans_ip_umat_func;
+#else
+  gpointer cv_trans_umat_func;
+  gpointer cv_trans_ip_umat_func;
+#endif
 };
 
 GST_EXPORT
@@ -53,6 +53,7 @@
 #include <gst/video/colorbalance.h>
 #include <gst/tag/tag.h>
 #include <gst/pbutils/descriptions.h>
+#include <gst/pbutils/gstdiscoverer.h>
 
 #include <string.h>
 
@@ -198,6 +199,11 @@ struct _GstPlayer
   gchar *audio_sid;
   gchar *subtitle_sid;
   gulong stream_notify_id;
+
+  /* Signals that are not yet emitted by the signal dispatcher, updated with
+   * the latest value instead of dispatching another one. Protected by lock */
+  gpointer pending_position_signal;
+  gpointer pending_buffering_signal;
 };
 
 struct _GstPlayerClass
@@ -910,13 +916,21 @@ static void
 position_updated_dispatch (gpointer user_data)
 {
   PositionUpdatedSignalData *data = user_data;
+  GstClockTime position;
+
+  /* from now on a new position needs a new dispatch */
+  g_mutex_lock (&data->player->lock);
+  if (data->player->pending_position_signal == data)
+    data->player->pending_position_signal = NULL;
+  position = data->position;
+  g_mutex_unlock (&data->player->lock);
 
   if (data->player->inhibit_sigs)
     return;
 
   if (data->player->target_state >= GST_STATE_PAUSED) {
     g_signal_emit (data->player, signals[SIGNAL_POSITION_UPDATED], 0,
-        data->position);
+        position);
     g_object_notify_by_pspec (G_OBJECT (data->player),
         param_specs[PROP_POSITION]);
   }
@@ -925,6 +939,11 @@ position_updated_dispatch (gpointer user_data)
 static void
 position_updated_signal_data_free (PositionUpdatedSignalData * data)
 {
+  g_mutex_lock (&data->player->lock);
+  if (data->player->pending_position_signal == data)
+    data->player->pending_position_signal = NULL;
+  g_mutex_unlock (&data->player->lock);
+
   g_object_unref (data->player);
   g_free (data);
 }
@@ -943,10 +962,24 @@ tick_cb (gpointer user_data)
 
     if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
             signals[SIGNAL_POSITION_UPDATED], 0, NULL, NULL, NULL) != 0) {
-      PositionUpdatedSignalData *data = g_new (PositionUpdatedSignalData, 1);
+      PositionUpdatedSignalData *data;
+
+      /* If the application did not get the previous position yet, e.g.
+       * because its main loop is busy, only update that one */
+      g_mutex_lock (&self->lock);
+      data = self->pending_position_signal;
+      if (data) {
+        data->position = position;
+        g_mutex_unlock (&self->lock);
+        return G_SOURCE_CONTINUE;
+      }
 
+      data = g_new (PositionUpdatedSignalData, 1);
       data->player = g_object_ref (self);
       data->position = position;
+      self->pending_position_signal = data;
+      g_mutex_unlock (&self->lock);
+
       gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
           position_updated_dispatch, data,
           (GDestroyNotify) position_updated_signal_data_free);
@@ -969,7 +1002,14 @@ add_tick_source (GstPlayer * self)
   if (!position_update_interval_ms)
     return;
 
-  self->tick_source = g_timeout_source_new (position_update_interval_ms);
+  /* Whole seconds use a seconds timeout, which GLib wakes up together with
+   * all other ones of the process, e.g. the ones of other players, instead
+   * of waking up separately for each */
+  if (position_update_interval_ms % 1000 == 0)
+    self->tick_source =
+        g_timeout_source_new_seconds (position_update_interval_ms / 1000);
+  else
+    self->tick_source = g_timeout_source_new (position_update_interval_ms);
   g_source_set_callback (self->tick_source, (GSourceFunc) tick_cb, self, NULL);
   g_source_attach (self->tick_source, self->context);
 }
@@ -1273,18 +1313,30 @@ static void
 buffering_dispatch (gpointer user_data)
 {
   BufferingSignalData *data = user_data;
+  gint percent;
+
+  g_mutex_lock (&data->player->lock);
+  if (data->player->pending_buffering_signal == data)
+    data->player->pending_buffering_signal = NULL;
+  percent = data->percent;
+  g_mutex_unlock (&data->player->lock);
 
   if (data->player->inhibit_sigs)
     return;
 
   if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_BUFFERING], 0, data->percent);
+    g_signal_emit (data->player, signals[SIGNAL_BUFFERING], 0, percent);
   }
 }
 
 static void
 buffering_signal_data_free (BufferingSignalData * data)
 {
+  g_mutex_lock (&data->player->lock);
+  if (data->player->pending_buffering_signal == data)
+    data->player->pending_buffering_signal = NULL;
+  g_mutex_unlock (&data->player->lock);
+
   g_object_unref (data->player);
   g_free (data);
 }
@@ -1321,13 +1373,25 @@ buffering_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg, gpointer user_data)
   if (self->buffering != percent) {
     if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
             signals[SIGNAL_BUFFERING], 0, NULL, NULL, NULL) != 0) {
-      BufferingSignalData *data = g_new (BufferingSignalData, 1);
+      BufferingSignalData *data;
 
-      data->player = g_object_ref (self);
-      data->percent = percent;
-      gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
-          buffering_dispatch, data,
-          (GDestroyNotify) buffering_signal_data_free);
+      /* same as for the position, only the latest percentage matters */
+      g_mutex_lock (&self->lock);
+      data = self->pending_buffering_signal;
+      if (data) {
+        data->percent = percent;
+        g_mutex_unlock (&self->lock);
+      } else {
+        data = g_new (BufferingSignalData, 1);
+        data->player = g_object_ref (self);
+        data->percent = percent;
+        self->pending_buffering_signal = data;
+        g_mutex_unlock (&self->lock);
+
+        gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+            buffering_dispatch, data,
+            (GDestroyNotify) buffering_signal_data_free);
+      }
     }
 
     self->buffering = percent;
@@ -3203,15 +3267,30 @@ gst_player_stop_internal (GstPlayer * self, gboolean transient)
   tick_cb (self);
   remove_tick_source (self);
 
+  /* restart the timeout, the pipeline stays warm in READY for another while
+   * after each stop */
+  remove_ready_timeout_source (self);
   add_ready_timeout_source (self);
 
+  /* A pipeline that already is idle in READY, e.g. when changing the URI
+   * of a stopped player, is kept as is. Otherwise it is brought to READY,
+   * which also gets it out of NULL after the timeout so that the next
+   * play starts from a warm pipeline. */
+  if (self->target_state > GST_STATE_READY
+      || self->current_state != GST_STATE_READY
+      || GST_STATE (self->playbin) != GST_STATE_READY
+      || GST_STATE_PENDING (self->playbin) != GST_STATE_VOID_PENDING) {
+    gst_bus_set_flushing (self->bus, TRUE);
+    gst_element_set_state (self->playbin, GST_STATE_READY);
+    gst_bus_set_flushing (self->bus, FALSE);
+  } else {
+    GST_DEBUG_OBJECT (self, "Pipeline already in READY");
+  }
+
   self->target_state = GST_STATE_NULL;
   self->current_state = GST_STATE_READY;
   self->is_live = FALSE;
   self->is_eos = FALSE;
-  gst_bus_set_flushing (self->bus, TRUE);
-  gst_element_set_state (self->playbin, GST_STATE_READY);
-  gst_bus_set_flushing (self->bus, FALSE);
   change_state (self, transient
       && self->app_state !=
       GST_PLAYER_STATE_STOPPED ? GST_PLAYER_STATE_BUFFERING :
@@ -3691,6 +3770,177 @@ gst_player_get_media_info (GstPlayer * self)
   return info;
 }
 
+static void
+discoverer_source_setup_cb (GstDiscoverer * discoverer, GstElement * source,
+    const gchar * user_agent)
+{
+  GParamSpec *prop;
+
+  prop = g_object_class_find_property (G_OBJECT_GET_CLASS (source),
+      "user-agent");
+  if (prop && prop->value_type == G_TYPE_STRING)
+    g_object_set (source, "user-agent", user_agent, NULL);
+}
+
+static void
+gst_player_discovered_streams_create (GstPlayer * self,
+    GstPlayerMediaInfo * media_info, GList * streams, GType type)
+{
+  GstPlayerStreamInfo *s;
+  const GstTagList *tags;
+  GList *l;
+  gint i;
+
+  for (l = streams, i = 0; l != NULL; l = l->next, i++) {
+    GstDiscovererStreamInfo *sinfo = l->data;
+
+    s = gst_player_stream_info_new (i, type);
+    s->stream_id = g_strdup (gst_discoverer_stream_info_get_stream_id (sinfo));
+    s->caps = gst_discoverer_stream_info_get_caps (sinfo);
+    tags = gst_discoverer_stream_info_get_tags (sinfo);
+    if (tags)
+      s->tags = gst_tag_list_copy (tags);
+    s->codec = stream_info_get_codec (s);
+
+    media_info->stream_list = g_list_append (media_info->stream_list, s);
+
+    if (GST_IS_PLAYER_AUDIO_INFO (s)) {
+      media_info->audio_stream_list = g_list_append
+          (media_info->audio_stream_list, s);
+      gst_player_audio_info_update (self, s);
+    } else if (GST_IS_PLAYER_VIDEO_INFO (s)) {
+      media_info->video_stream_list = g_list_append
+          (media_info->video_stream_list, s);
+      gst_player_video_info_update (self, s);
+    } else {
+      GstPlayerSubtitleInfo *info = (GstPlayerSubtitleInfo *) s;
+
+      media_info->subtitle_stream_list = g_list_append
+          (media_info->subtitle_stream_list, s);
+
+      /* the subtitle update of the playback path looks at the playbin for
+       * the current external subtitle, so only take the language from the
+       * tags here */
+      info->language = g_strdup (gst_discoverer_subtitle_info_get_language
+          ((GstDiscovererSubtitleInfo *) sinfo));
+    }
+
+    GST_DEBUG_OBJECT (self, "discovered %s stream stream_index: %d",
+        gst_player_stream_info_get_stream_type (s), i);
+  }
+}
+
+/**
+ * gst_player_discover_media_info:
+ * @player: #GstPlayer instance
+ * @uri: URI to probe
+ * @timeout: maximum time to spend on the URI, between one second and one
+ *   hour
+ * @error: return location for a #GError, or %NULL
+ *
+ * Gathers the media info of @uri without going through the playback
+ * pipeline of @player, so neither its current stream nor its state are
+ * affected. The URI is only demuxed and parsed as far as needed to know
+ * its streams, nothing is rendered, which makes this a lot cheaper than
+ * prerolling the stream with gst_player_pause().
+ *
+ * This blocks until the information is available. It can be called from
+ * any thread, and from several threads at once to probe many URIs in
+ * parallel. The user agent of the @player configuration is used.
+ *
+ * As the stream is not prerolled, the returned media info may miss
+ * information that is only known once the streams are decoded.
+ *
+ * Returns: (transfer full): the media info of @uri, or %NULL on error.
+ *
+ * The caller should free it with g_object_unref()
+ *
+ * Since: 1.14
+ */
+GstPlayerMediaInfo *
+gst_player_discover_media_info (GstPlayer * self, const gchar * uri,
+    GstClockTime timeout, GError ** error)
+{
+  GstPlayerMediaInfo *media_info;
+  GstDiscoverer *discoverer;
+  GstDiscovererInfo *info;
+  const GstTagList *tags;
+  gchar *user_agent;
+  GList *streams;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_return_val_if_fail (uri != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  /* the discoverer accepts timeouts between one second and one hour */
+  timeout = CLAMP (timeout, GST_SECOND, 3600 * GST_SECOND);
+
+  discoverer = gst_discoverer_new (timeout, error);
+  if (!discoverer)
+    return NULL;
+
+  g_mutex_lock (&self->lock);
+  user_agent = gst_player_config_get_user_agent (self->config);
+  g_mutex_unlock (&self->lock);
+  if (user_agent)
+    g_signal_connect (discoverer, "source-setup",
+        G_CALLBACK (discoverer_source_setup_cb), user_agent);
+
+  GST_DEBUG_OBJECT (self, "Discovering '%s'", uri);
+  info = gst_discoverer_discover_uri (discoverer, uri, error);
+  g_object_unref (discoverer);
+  g_free (user_agent);
+
+  if (!info)
+    return NULL;
+
+  if (gst_discoverer_info_get_result (info) != GST_DISCOVERER_OK) {
+    if (error && !*error)
+      *error = g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+          "Failed to discover '%s'", uri);
+    gst_discoverer_info_unref (info);
+    return NULL;
+  }
+
+  media_info = gst_player_media_info_new (uri);
+  media_info->duration = gst_discoverer_info_get_duration (info);
+  media_info->seekable = gst_discoverer_info_get_seekable (info);
+  media_info->is_live = gst_discoverer_info_get_live (info);
+  tags = gst_discoverer_info_get_tags (info);
+  if (tags)
+    media_info->tags = gst_tag_list_copy (tags);
+
+  streams = gst_discoverer_info_get_video_streams (info);
+  gst_player_discovered_streams_create (self, media_info, streams,
+      GST_TYPE_PLAYER_VIDEO_INFO);
+  gst_discoverer_stream_info_list_free (streams);
+
+  streams = gst_discoverer_info_get_audio_streams (info);
+  gst_player_discovered_streams_create (self, media_info, streams,
+      GST_TYPE_PLAYER_AUDIO_INFO);
+  gst_discoverer_stream_info_list_free (streams);
+
+  streams = gst_discoverer_info_get_subtitle_streams (info);
+  gst_player_discovered_streams_create (self, media_info, streams,
+      GST_TYPE_PLAYER_SUBTITLE_INFO);
+  gst_discoverer_stream_info_list_free (streams);
+
+  gst_discoverer_info_unref (info);
+
+  media_info->title = get_from_tags (self, media_info, get_title);
+  media_info->container =
+      get_from_tags (self, media_info, get_container_format);
+  media_info->image_sample = get_from_tags (self, media_info, get_cover_sample);
+
+  GST_DEBUG_OBJECT (self, "uri: %s title: %s duration: %" GST_TIME_FORMAT
+      " seekable: %s live: %s container: %s", media_info->uri,
+      media_info->title, GST_TIME_ARGS (media_info->duration),
+      media_info->seekable ? "yes" : "no", media_info->is_live ? "yes" : "no",
+      media_info->container);
+
+  return media_info;
+}
+
 /**
  * gst_player_get_current_audio_track:
  * @player: #GstPlayer instance
@@ -194,6 +194,12 @@ gboolean     gst_player_set_subtitle_track            (GstPlayer    *player,
 GST_EXPORT
 GstPlayerMediaInfo *    gst_player_get_media_info     (GstPlayer * player);
 
+GST_EXPORT
+GstPlayerMediaInfo *    gst_player_discover_media_info (GstPlayer * player,
+                                                        const gchar * uri,
+                                                        GstClockTime timeout,
+                                                        GError ** error);
+
 GST_EXPORT
 GstPlayerAudioInfo *    gst_player_get_current_audio_track (GstPlayer * player);
 
@@ -57,6 +57,8 @@ static GstFlowReturn gst_uri_downloader_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
 static gboolean gst_uri_downloader_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
+static gboolean gst_uri_downloader_sink_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
 static GstBusSyncReply gst_uri_downloader_bus_handler (GstBus * bus,
     GstMessage * message, gpointer data);
 
@@ -64,6 +66,20 @@ static gboolean gst_uri_downloader_ensure_src (GstUriDownloader * downloader,
     const gchar * uri);
 static void gst_uri_downloader_destroy_src (GstUriDownloader * downloader);
 
+/* Process-wide pool of the contexts HTTP sources share their connections
+ * through (the SoupSession of souphttpsrc), so that the playlist and
+ * fragment downloads of every demuxer reuse kept-alive connections instead
+ * of doing a new TCP and TLS handshake per request. */
+static const gchar *shareable_contexts[] = { "gst.soup.session", NULL };
+
+static GMutex pool_lock;
+static GHashTable *pool_contexts;       /* context type -> GstContext */
+static guint64 pool_requests;
+static guint64 pool_source_reuses;
+static guint64 pool_shared_hits;
+static guint64 pool_shared_misses;
+static guint64 pool_shared_sessions;
+
 static GstStaticPadTemplate sinkpadtemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -103,6 +119,8 @@ gst_uri_downloader_init (GstUriDownloader * downloader)
       GST_DEBUG_FUNCPTR (gst_uri_downloader_chain));
   gst_pad_set_event_function (downloader->priv->pad,
       GST_DEBUG_FUNCPTR (gst_uri_downloader_sink_event));
+  gst_pad_set_query_function (downloader->priv->pad,
+      GST_DEBUG_FUNCPTR (gst_uri_downloader_sink_query));
   gst_pad_set_element_private (downloader->priv->pad, downloader);
   gst_pad_set_active (downloader->priv->pad, TRUE);
 
@@ -178,6 +196,137 @@ gst_uri_downloader_set_parent (GstUriDownloader * downloader,
   g_weak_ref_set (&downloader->priv->parent, parent);
 }
 
+static gboolean
+gst_uri_downloader_connection_pool_is_shareable (const gchar * context_type)
+{
+  const gchar **type;
+
+  for (type = shareable_contexts; *type; type++) {
+    if (g_str_equal (*type, context_type))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+ * gst_uri_downloader_connection_pool_query:
+ * @param query: a #GstQuery
+ *
+ * Answers a context query from an HTTP source with the connection sharing
+ * context of the process-wide pool, if one was recorded for it.
+ *
+ * Returns: %TRUE if @query was answered
+ */
+gboolean
+gst_uri_downloader_connection_pool_query (GstQuery * query)
+{
+  const gchar *context_type;
+  GstContext *context = NULL;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_CONTEXT)
+    return FALSE;
+
+  gst_query_parse_context_type (query, &context_type);
+  if (!gst_uri_downloader_connection_pool_is_shareable (context_type))
+    return FALSE;
+
+  g_mutex_lock (&pool_lock);
+  if (pool_contexts)
+    context = g_hash_table_lookup (pool_contexts, context_type);
+  if (context) {
+    gst_query_set_context (query, context);
+    pool_shared_hits++;
+  } else {
+    pool_shared_misses++;
+  }
+  g_mutex_unlock (&pool_lock);
+
+  return context != NULL;
+}
+
+/**
+ * gst_uri_downloader_connection_pool_add:
+ * @param context: a #GstContext posted by an HTTP source
+ *
+ * Records @context in the process-wide pool if it carries shareable
+ * connections and the pool doesn't have one of its type yet.
+ */
+void
+gst_uri_downloader_connection_pool_add (GstContext * context)
+{
+  const gchar *context_type = gst_context_get_context_type (context);
+
+  if (!gst_uri_downloader_connection_pool_is_shareable (context_type))
+    return;
+
+  g_mutex_lock (&pool_lock);
+  if (pool_contexts == NULL)
+    pool_contexts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) gst_context_unref);
+  if (!g_hash_table_contains (pool_contexts, context_type)) {
+    GST_DEBUG ("Sharing %s context with all downloads", context_type);
+    g_hash_table_insert (pool_contexts, g_strdup (context_type),
+        gst_context_ref (context));
+    pool_shared_sessions++;
+  }
+  g_mutex_unlock (&pool_lock);
+}
+
+/**
+ * gst_uri_downloader_connection_pool_count_request:
+ * @param source_reused: whether an existing source element handles the request
+ *
+ * Accounts a request in the connection pool statistics.
+ */
+void
+gst_uri_downloader_connection_pool_count_request (gboolean source_reused)
+{
+  g_mutex_lock (&pool_lock);
+  pool_requests++;
+  if (source_reused)
+    pool_source_reuses++;
+  g_mutex_unlock (&pool_lock);
+}
+
+/**
+ * gst_uri_downloader_connection_pool_get_stats:
+ *
+ * Returns the process-wide connection reuse statistics: the number of
+ * "requests", how many of them reused their source element
+ * ("source-reuses"), how many sources got a shared connection context
+ * ("shared-hits") or had to set up their own ("shared-misses"), and the
+ * number of contexts in the pool ("shared-sessions").
+ *
+ * Returns: (transfer full): a new #GstStructure
+ */
+GstStructure *
+gst_uri_downloader_connection_pool_get_stats (void)
+{
+  GstStructure *stats;
+
+  g_mutex_lock (&pool_lock);
+  stats = gst_structure_new ("connection-stats",
+      "requests", G_TYPE_UINT64, pool_requests,
+      "source-reuses", G_TYPE_UINT64, pool_source_reuses,
+      "shared-hits", G_TYPE_UINT64, pool_shared_hits,
+      "shared-misses", G_TYPE_UINT64, pool_shared_misses,
+      "shared-sessions", G_TYPE_UINT64, pool_shared_sessions, NULL);
+  g_mutex_unlock (&pool_lock);
+
+  return stats;
+}
+
+static gboolean
+gst_uri_downloader_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  if (gst_uri_downloader_connection_pool_query (query))
+    return TRUE;
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
 static gboolean
 gst_uri_downloader_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event)
@@ -309,6 +458,12 @@ gst_uri_downloader_bus_handler (GstBus * bus,
     }
     if (parent)
       gst_object_unref (parent);
+  } else if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_HAVE_CONTEXT) {
+    GstContext *context;
+
+    gst_message_parse_have_context (message, &context);
+    gst_uri_downloader_connection_pool_add (context);
+    gst_context_unref (context);
   }
 
   gst_message_unref (message);
@@ -425,6 +580,8 @@ gst_uri_downloader_ensure_src (GstUriDownloader * downloader, const gchar * uri)
             "Failed to re-use old source element: %s", err->message);
         g_clear_error (&err);
         gst_uri_downloader_destroy_src (downloader);
+      } else {
+        gst_uri_downloader_connection_pool_count_request (TRUE);
       }
     }
     g_free (old_uri);
@@ -443,6 +600,7 @@ gst_uri_downloader_ensure_src (GstUriDownloader * downloader, const gchar * uri)
        * should take it.
        */
       gst_object_ref_sink (downloader->priv->urisrc);
+      gst_uri_downloader_connection_pool_count_request (FALSE);
     }
   }
 
@@ -79,5 +79,17 @@ void gst_uri_downloader_reset (GstUriDownloader *downloader);
 GST_EXPORT
 void gst_uri_downloader_cancel (GstUriDownloader *downloader);
 
+GST_EXPORT
+gboolean gst_uri_downloader_connection_pool_query (GstQuery * query);
+
+GST_EXPORT
+void gst_uri_downloader_connection_pool_add (GstContext * context);
+
+GST_EXPORT
+void gst_uri_downloader_connection_pool_count_request (gboolean source_reused);
+
+GST_EXPORT
+GstStructure * gst_uri_downloader_connection_pool_get_stats (void);
+
 G_END_DECLS
 #endif /* __GSTURIDOWNLOADER_H__ */
@@ -72,6 +72,8 @@ struct _GstVideoAggregatorPadPrivate
   /* caps used for conversion if needed */
   GstVideoInfo conversion_info;
   GstBuffer *converted_buffer;
+  /* input caps of the converter, to reuse it if they do not change */
+  GstVideoInfo convert_in_info;
 
   GstClockTime start_time;
   GstClockTime end_time;
@@ -164,11 +166,6 @@ gst_video_aggregator_pad_set_info (GstVideoAggregatorPad * pad,
   if (GST_VIDEO_INFO_FORMAT (current_info) == GST_VIDEO_FORMAT_UNKNOWN)
     return TRUE;
 
-  if (pad->priv->convert)
-    gst_video_converter_free (pad->priv->convert);
-
-  pad->priv->convert = NULL;
-
   colorimetry = gst_video_colorimetry_to_string (&(current_info->colorimetry));
   chroma = gst_video_chroma_to_string (current_info->chroma_site);
 
@@ -198,12 +195,27 @@ gst_video_aggregator_pad_set_info (GstVideoAggregatorPad * pad,
     tmp_info.flags = current_info->flags;
     tmp_info.interlace_mode = current_info->interlace_mode;
 
+    /* renegotiation of the output often keeps the conversion of this pad
+     * as it is, and creating a converter is not cheap */
+    if (pad->priv->convert
+        && gst_video_info_is_equal (&pad->priv->convert_in_info, current_info)
+        && gst_video_info_is_equal (&pad->priv->conversion_info, &tmp_info)) {
+      GST_DEBUG_OBJECT (pad, "Reusing converter");
+      g_free (colorimetry);
+      g_free (best_colorimetry);
+      return TRUE;
+    }
+
+    if (pad->priv->convert)
+      gst_video_converter_free (pad->priv->convert);
+
     GST_DEBUG_OBJECT (pad, "This pad will be converted from %d to %d",
         GST_VIDEO_INFO_FORMAT (current_info),
         GST_VIDEO_INFO_FORMAT (&tmp_info));
     pad->priv->convert =
         gst_video_converter_new (current_info, &tmp_info, NULL);
     pad->priv->conversion_info = tmp_info;
+    pad->priv->convert_in_info = *current_info;
     if (!pad->priv->convert) {
       g_free (colorimetry);
       g_free (best_colorimetry);
@@ -211,6 +223,10 @@ gst_video_aggregator_pad_set_info (GstVideoAggregatorPad * pad,
       return FALSE;
     }
   } else {
+    if (pad->priv->convert)
+      gst_video_converter_free (pad->priv->convert);
+    pad->priv->convert = NULL;
+
     GST_DEBUG_OBJECT (pad, "This pad will not need conversion");
   }
   g_free (colorimetry);
@@ -431,6 +447,16 @@ struct _GstVideoAggregatorPrivate
   GstCaps *current_caps;
 
   gboolean live;
+
+  /* running times of the output frame being produced */
+  GstClockTime output_start_running_time;
+  GstClockTime output_end_running_time;
+
+  /* frames of different pads are prepared concurrently */
+  GThreadPool *prepare_pool;
+  GMutex prepare_lock;
+  GCond prepare_cond;
+  guint prepares_pending;
 };
 
 /* Can't use the G_DEFINE_TYPE macros because we need the
@@ -1028,6 +1054,8 @@ gst_video_aggregator_reset (GstVideoAggregator * vagg)
   vagg->priv->ts_offset = 0;
   vagg->priv->nframes = 0;
   vagg->priv->live = FALSE;
+  vagg->priv->output_start_running_time = GST_CLOCK_TIME_NONE;
+  vagg->priv->output_end_running_time = GST_CLOCK_TIME_NONE;
 
   agg->segment.position = -1;
 
@@ -1284,17 +1312,77 @@ sync_pad_values (GstElement * vagg, GstPad * pad, gpointer user_data)
   return TRUE;
 }
 
-static gboolean
-prepare_frames (GstElement * agg, GstPad * pad, gpointer user_data)
+static void
+prepare_frame_func (gpointer data, gpointer user_data)
 {
-  GstVideoAggregatorPad *vpad = GST_VIDEO_AGGREGATOR_PAD_CAST (pad);
-  GstVideoAggregatorPadClass *vaggpad_class =
-      GST_VIDEO_AGGREGATOR_PAD_GET_CLASS (pad);
+  GstVideoAggregatorPad *vpad = data;
+  GstVideoAggregator *vagg = user_data;
 
-  if (vpad->buffer == NULL || !vaggpad_class->prepare_frame)
-    return TRUE;
+  GST_VIDEO_AGGREGATOR_PAD_GET_CLASS (vpad)->prepare_frame (vpad, vagg);
+
+  g_mutex_lock (&vagg->priv->prepare_lock);
+  if (--vagg->priv->prepares_pending == 0)
+    g_cond_signal (&vagg->priv->prepare_cond);
+  g_mutex_unlock (&vagg->priv->prepare_lock);
+}
+
+/* Prepares the frames of all pads that have a buffer. The pads only touch
+ * their own state there, so with more than one of them the conversions run
+ * concurrently on the prepare pool, and on the calling thread for the first
+ * pad. */
+static void
+gst_video_aggregator_prepare_frames (GstVideoAggregator * vagg)
+{
+  GList *pads = NULL, *l;
+  guint n_pads = 0, n_threads;
+
+  GST_OBJECT_LOCK (vagg);
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *vpad = l->data;
+
+    if (vpad->buffer == NULL
+        || !GST_VIDEO_AGGREGATOR_PAD_GET_CLASS (vpad)->prepare_frame)
+      continue;
+
+    pads = g_list_prepend (pads, gst_object_ref (vpad));
+    n_pads++;
+  }
+  GST_OBJECT_UNLOCK (vagg);
+
+  if (pads == NULL)
+    return;
+
+  pads = g_list_reverse (pads);
+  n_threads = MIN (g_get_num_processors (), n_pads);
+
+  if (n_threads > 1) {
+    if (!vagg->priv->prepare_pool) {
+      vagg->priv->prepare_pool = g_thread_pool_new (prepare_frame_func, vagg,
+          n_threads - 1, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (vagg->priv->prepare_pool) <
+        (gint) n_threads - 1) {
+      g_thread_pool_set_max_threads (vagg->priv->prepare_pool, n_threads - 1,
+          NULL);
+    }
+
+    vagg->priv->prepares_pending = n_pads - 1;
+    for (l = pads->next; l; l = l->next)
+      g_thread_pool_push (vagg->priv->prepare_pool, l->data, NULL);
+
+    GST_VIDEO_AGGREGATOR_PAD_GET_CLASS (pads->data)->prepare_frame (pads->data,
+        vagg);
+
+    g_mutex_lock (&vagg->priv->prepare_lock);
+    while (vagg->priv->prepares_pending > 0)
+      g_cond_wait (&vagg->priv->prepare_cond, &vagg->priv->prepare_lock);
+    g_mutex_unlock (&vagg->priv->prepare_lock);
+  } else {
+    for (l = pads; l; l = l->next)
+      GST_VIDEO_AGGREGATOR_PAD_GET_CLASS (l->data)->prepare_frame (l->data,
+          vagg);
+  }
 
-  return vaggpad_class->prepare_frame (vpad, GST_VIDEO_AGGREGATOR_CAST (agg));
+  g_list_free_full (pads, gst_object_unref);
 }
 
 static gboolean
@@ -1310,11 +1398,94 @@ clean_pad (GstElement * agg, GstPad * pad, gpointer user_data)
   return TRUE;
 }
 
+/**
+ * gst_video_aggregator_pad_take_buffer:
+ * @pad: a #GstVideoAggregatorPad
+ *
+ * Takes the current buffer of @pad so that it can be used as the output
+ * buffer. This only succeeds from the #GstVideoAggregatorClass.get_output_buffer
+ * vmethod, and only if nobody else holds a reference to the buffer and it will
+ * not be needed again for a later output frame: the buffer must end with the
+ * current output frame and the buffer following it must already be queued,
+ * or the pad must be EOS. Afterwards @pad has no buffer for the current
+ * output frame, the subclass is expected to have it in the output already.
+ *
+ * Returns: (transfer full) (nullable): the buffer of @pad or %NULL
+ *
+ * Since: 1.14
+ */
+GstBuffer *
+gst_video_aggregator_pad_take_buffer (GstVideoAggregatorPad * pad)
+{
+  GstAggregatorPad *bpad = GST_AGGREGATOR_PAD (pad);
+  GstVideoAggregator *vagg;
+  GstAggregator *agg;
+  GstClockTime output_end, next_output_end;
+  GstBuffer *buf;
+
+  g_return_val_if_fail (GST_IS_VIDEO_AGGREGATOR_PAD (pad), NULL);
+
+  vagg = GST_VIDEO_AGGREGATOR (GST_OBJECT_PARENT (pad));
+  agg = GST_AGGREGATOR (vagg);
+  output_end = vagg->priv->output_end_running_time;
+
+  /* Live timeouts and ignore-eos repeat the last buffer of a pad */
+  if (!pad->buffer || vagg->priv->live || pad->ignore_eos ||
+      !GST_CLOCK_TIME_IS_VALID (output_end) ||
+      !GST_CLOCK_TIME_IS_VALID (pad->priv->end_time) ||
+      pad->priv->end_time > output_end)
+    return NULL;
+
+  if (!gst_buffer_is_writable (pad->buffer) ||
+      !gst_buffer_is_all_memory_writable (pad->buffer))
+    return NULL;
+
+  if (!gst_aggregator_pad_is_eos (bpad)) {
+    GstClockTime start_time;
+    GstSegment segment;
+
+    /* The next buffer has to replace this one for the next output frame */
+    buf = gst_aggregator_pad_get_buffer (bpad);
+    if (!buf)
+      return NULL;
+
+    GST_OBJECT_LOCK (bpad);
+    segment = bpad->segment;
+    GST_OBJECT_UNLOCK (bpad);
+
+    start_time = GST_BUFFER_TIMESTAMP (buf);
+    gst_buffer_unref (buf);
+    if (start_time == -1)
+      return NULL;
+
+    start_time = MAX (start_time, segment.start);
+    start_time =
+        gst_segment_to_running_time (&segment, GST_FORMAT_TIME, start_time);
+    if (start_time == -1)
+      return NULL;
+    if (ABS (agg->segment.rate) != 1.0)
+      start_time *= ABS (agg->segment.rate);
+
+    next_output_end = output_end + (output_end -
+        vagg->priv->output_start_running_time);
+    if (start_time >= next_output_end)
+      return NULL;
+  }
+
+  buf = pad->buffer;
+  pad->buffer = NULL;
+
+  GST_LOG_OBJECT (pad, "Taking buffer %p for the output", buf);
+
+  return buf;
+}
+
 static GstFlowReturn
 gst_video_aggregator_do_aggregate (GstVideoAggregator * vagg,
     GstClockTime output_start_time, GstClockTime output_end_time,
     GstBuffer ** outbuf)
 {
+  GstAggregator *agg = GST_AGGREGATOR (vagg);
   GstFlowReturn ret = GST_FLOW_OK;
   GstElementClass *klass = GST_ELEMENT_GET_CLASS (vagg);
   GstVideoAggregatorClass *vagg_klass = (GstVideoAggregatorClass *) klass;
@@ -1324,7 +1495,19 @@ gst_video_aggregator_do_aggregate (GstVideoAggregator * vagg,
   g_assert (vagg_klass->aggregate_frames != NULL);
   g_assert (vagg_klass->get_output_buffer != NULL);
 
-  if ((ret = vagg_klass->get_output_buffer (vagg, outbuf)) != GST_FLOW_OK) {
+  vagg->priv->output_start_running_time =
+      gst_segment_to_running_time (&agg->segment, GST_FORMAT_TIME,
+      output_start_time);
+  vagg->priv->output_end_running_time =
+      gst_segment_to_running_time (&agg->segment, GST_FORMAT_TIME,
+      output_end_time);
+
+  ret = vagg_klass->get_output_buffer (vagg, outbuf);
+
+  vagg->priv->output_start_running_time = GST_CLOCK_TIME_NONE;
+  vagg->priv->output_end_running_time = GST_CLOCK_TIME_NONE;
+
+  if (ret != GST_FLOW_OK) {
     GST_WARNING_OBJECT (vagg, "Could not get an output buffer, reason: %s",
         gst_flow_get_name (ret));
     return ret;
@@ -1341,7 +1524,7 @@ gst_video_aggregator_do_aggregate (GstVideoAggregator * vagg,
   gst_element_foreach_sink_pad (GST_ELEMENT_CAST (vagg), sync_pad_values, NULL);
 
   /* Convert all the frames the subclass has before aggregating */
-  gst_element_foreach_sink_pad (GST_ELEMENT_CAST (vagg), prepare_frames, NULL);
+  gst_video_aggregator_prepare_frames (vagg);
 
   ret = vagg_klass->aggregate_frames (vagg, *outbuf);
 
@@ -2128,6 +2311,11 @@ gst_video_aggregator_finalize (GObject * o)
 
   g_mutex_clear (&vagg->priv->lock);
 
+  if (vagg->priv->prepare_pool)
+    g_thread_pool_free (vagg->priv->prepare_pool, FALSE, TRUE);
+  g_mutex_clear (&vagg->priv->prepare_lock);
+  g_cond_clear (&vagg->priv->prepare_cond);
+
   G_OBJECT_CLASS (gst_video_aggregator_parent_class)->finalize (o);
 }
 
@@ -2298,6 +2486,8 @@ gst_video_aggregator_init (GstVideoAggregator * vagg,
   vagg->priv->current_caps = NULL;
 
   g_mutex_init (&vagg->priv->lock);
+  g_mutex_init (&vagg->priv->prepare_lock);
+  g_cond_init (&vagg->priv->prepare_cond);
 
   /* initialize variables */
   g_mutex_lock (&sink_caps_mutex);
@@ -108,5 +108,8 @@ struct _GstVideoAggregatorPadClass
 GST_EXPORT
 GType gst_video_aggregator_pad_get_type (void);
 
+GST_EXPORT
+GstBuffer * gst_video_aggregator_pad_take_buffer (GstVideoAggregatorPad * pad);
+
 G_END_DECLS
 #endif /* __GST_VIDEO_AGGREGATOR_PAD_H__ */
@@ -0,0 +1,132 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstvideoscenechangemeta
+ * @title: GstVideoSceneChangeMeta
+ * @short_description: Scene change detection results
+ *
+ * #GstVideoSceneChangeMeta carries the score and decision of a scene change
+ * detector with each frame.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvideoscenechangemeta.h"
+
+static gboolean
+gst_video_scene_change_meta_init (GstVideoSceneChangeMeta * meta,
+    gpointer params, GstBuffer * buffer)
+{
+  meta->score = 0.0;
+  meta->threshold = 0.0;
+  meta->scene_change = FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_video_scene_change_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstVideoSceneChangeMeta *smeta = (GstVideoSceneChangeMeta *) meta;
+
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    GstMetaTransformCopy *copy = data;
+
+    if (!copy->region) {
+      /* only copy if the complete data is copied as well */
+      if (!gst_buffer_add_video_scene_change_meta (dest, smeta->score,
+              smeta->threshold, smeta->scene_change))
+        return FALSE;
+    }
+  } else {
+    /* return FALSE, if transform type is not supported */
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+GType
+gst_video_scene_change_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type =
+        gst_meta_api_type_register ("GstVideoSceneChangeMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo *
+gst_video_scene_change_meta_get_info (void)
+{
+  static const GstMetaInfo *scene_change_meta_info = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) & scene_change_meta_info)) {
+    const GstMetaInfo *meta =
+        gst_meta_register (GST_VIDEO_SCENE_CHANGE_META_API_TYPE,
+        "GstVideoSceneChangeMeta", sizeof (GstVideoSceneChangeMeta),
+        (GstMetaInitFunction) gst_video_scene_change_meta_init,
+        (GstMetaFreeFunction) NULL,
+        (GstMetaTransformFunction) gst_video_scene_change_meta_transform);
+    g_once_init_leave ((GstMetaInfo **) & scene_change_meta_info,
+        (GstMetaInfo *) meta);
+  }
+
+  return scene_change_meta_info;
+}
+
+/**
+ * gst_buffer_add_video_scene_change_meta:
+ * @buffer: a #GstBuffer
+ * @score: the difference of the frame with the previous one
+ * @threshold: the score above which a change was considered
+ * @scene_change: whether the frame starts a new scene
+ *
+ * Creates and adds a #GstVideoSceneChangeMeta to a @buffer.
+ *
+ * Returns: (transfer none): a newly created #GstVideoSceneChangeMeta
+ *
+ * Since: 1.14
+ */
+GstVideoSceneChangeMeta *
+gst_buffer_add_video_scene_change_meta (GstBuffer * buffer, gdouble score,
+    gdouble threshold, gboolean scene_change)
+{
+  GstVideoSceneChangeMeta *meta;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+
+  meta = (GstVideoSceneChangeMeta *) gst_buffer_add_meta (buffer,
+      GST_VIDEO_SCENE_CHANGE_META_INFO, NULL);
+  if (!meta)
+    return NULL;
+
+  meta->score = score;
+  meta->threshold = threshold;
+  meta->scene_change = scene_change;
+
+  return meta;
+}
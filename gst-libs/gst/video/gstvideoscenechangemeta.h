@@ -0,0 +1,76 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEO_SCENE_CHANGE_META_H__
+#define __GST_VIDEO_SCENE_CHANGE_META_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The Video library from gst-plugins-bad is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstVideoSceneChangeMeta GstVideoSceneChangeMeta;
+
+GST_EXPORT
+GType gst_video_scene_change_meta_api_get_type (void);
+#define GST_VIDEO_SCENE_CHANGE_META_API_TYPE  (gst_video_scene_change_meta_api_get_type())
+#define GST_VIDEO_SCENE_CHANGE_META_INFO  (gst_video_scene_change_meta_get_info())
+GST_EXPORT
+const GstMetaInfo * gst_video_scene_change_meta_get_info (void);
+
+/**
+ * GstVideoSceneChangeMeta:
+ * @meta: parent #GstMeta
+ * @score: difference between the frame and the previous one, from 0 for
+ *   identical frames to 255
+ * @threshold: the score above which the detector considered a change,
+ *   derived from the scores of the previous frames
+ * @scene_change: %TRUE if the frame starts a new scene
+ *
+ * Extra buffer metadata with the result of a scene change detection, as
+ * done by the scenechange element.
+ *
+ * Can be used by encoders or segmenters to place key frames or segment
+ * boundaries without analysing the frames again.
+ *
+ * Since: 1.14
+ */
+struct _GstVideoSceneChangeMeta {
+  GstMeta meta;
+
+  gdouble score;
+  gdouble threshold;
+  gboolean scene_change;
+};
+
+#define gst_buffer_get_video_scene_change_meta(b) ((GstVideoSceneChangeMeta*)gst_buffer_get_meta((b),GST_VIDEO_SCENE_CHANGE_META_API_TYPE))
+
+GST_EXPORT
+GstVideoSceneChangeMeta *
+gst_buffer_add_video_scene_change_meta (GstBuffer * buffer,
+                                        gdouble score,
+                                        gdouble threshold,
+                                        gboolean scene_change);
+
+G_END_DECLS
+
+#endif
@@ -46,6 +46,7 @@ enum
   PROP_ALIGNMENT_THRESHOLD,
   PROP_DISCONT_WAIT,
   PROP_STRICT_BUFFER_SIZE,
+  PROP_BUFFER_LIST,
   LAST_PROP
 };
 
@@ -54,6 +55,7 @@ enum
 #define DEFAULT_ALIGNMENT_THRESHOLD   (40 * GST_MSECOND)
 #define DEFAULT_DISCONT_WAIT (1 * GST_SECOND)
 #define DEFAULT_STRICT_BUFFER_SIZE (FALSE)
+#define DEFAULT_BUFFER_LIST (FALSE)
 
 #define parent_class gst_audio_buffer_split_parent_class
 G_DEFINE_TYPE (GstAudioBufferSplit, gst_audio_buffer_split, GST_TYPE_ELEMENT);
@@ -114,6 +116,13 @@ gst_audio_buffer_split_class_init (GstAudioBufferSplitClass * klass)
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
 
+  g_object_class_install_property (gobject_class, PROP_BUFFER_LIST,
+      g_param_spec_boolean ("buffer-list", "Buffer List",
+          "Push all buffers split from one input buffer in a buffer list",
+          DEFAULT_BUFFER_LIST,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "Audio Buffer Split", "Audio/Filter",
       "Splits raw audio buffers into equal sized chunks",
@@ -148,6 +157,7 @@ gst_audio_buffer_split_init (GstAudioBufferSplit * self)
   self->output_buffer_duration_n = DEFAULT_OUTPUT_BUFFER_DURATION_N;
   self->output_buffer_duration_d = DEFAULT_OUTPUT_BUFFER_DURATION_D;
   self->strict_buffer_size = DEFAULT_STRICT_BUFFER_SIZE;
+  self->buffer_list = DEFAULT_BUFFER_LIST;
 
   self->adapter = gst_adapter_new ();
 
@@ -240,6 +250,9 @@ gst_audio_buffer_split_set_property (GObject * object, guint property_id,
     case PROP_STRICT_BUFFER_SIZE:
       self->strict_buffer_size = g_value_get_boolean (value);
       break;
+    case PROP_BUFFER_LIST:
+      self->buffer_list = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -272,6 +285,9 @@ gst_audio_buffer_split_get_property (GObject * object, guint property_id,
     case PROP_STRICT_BUFFER_SIZE:
       g_value_set_boolean (value, self->strict_buffer_size);
       break;
+    case PROP_BUFFER_LIST:
+      g_value_set_boolean (value, self->buffer_list);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -327,27 +343,34 @@ gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
   gint size, avail;
   GstFlowReturn ret = GST_FLOW_OK;
   GstClockTime resync_time;
+  GstBufferList *list = NULL;
 
   GST_OBJECT_LOCK (self);
   resync_time =
       gst_audio_stream_align_get_timestamp_at_discont (self->stream_align);
   GST_OBJECT_UNLOCK (self);
 
-  size = samples_per_buffer * bpf;
-
-  /* If we accumulated enough error for one sample, include one
-   * more sample in this buffer. Accumulated error is updated below */
-  if (self->error_per_buffer + self->accumulated_error >=
-      self->output_buffer_duration_d)
-    size += bpf;
-
-  while ((avail = gst_adapter_available (self->adapter)) >= size || (force
-          && avail > 0)) {
+  for (;;) {
     GstBuffer *buffer;
     GstClockTime resync_time_diff;
 
+    size = samples_per_buffer * bpf;
+
+    /* If we accumulated enough error for one sample, include one
+     * more sample in this buffer. Accumulated error is updated below */
+    if (self->error_per_buffer + self->accumulated_error >=
+        self->output_buffer_duration_d)
+      size += bpf;
+
+    avail = gst_adapter_available (self->adapter);
+    if (avail < size && !(force && avail > 0))
+      break;
+
     size = MIN (size, avail);
-    buffer = gst_adapter_take_buffer (self->adapter, size);
+
+    /* Returns a sub-buffer if the chunk is in a single input buffer, and a
+     * buffer referencing the memories of the input buffers otherwise */
+    buffer = gst_adapter_take_buffer_fast (self->adapter, size);
 
     resync_time_diff =
         gst_util_uint64_scale (self->current_offset, GST_SECOND, rate);
@@ -382,11 +405,21 @@ gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
         GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)),
         GST_TIME_ARGS (GST_BUFFER_DURATION (buffer)), size / bpf);
 
+    if (self->buffer_list) {
+      if (!list)
+        list = gst_buffer_list_new_sized (avail / size + 1);
+      gst_buffer_list_add (list, buffer);
+      continue;
+    }
+
     ret = gst_pad_push (self->srcpad, buffer);
     if (ret != GST_FLOW_OK)
       break;
   }
 
+  if (list)
+    ret = gst_pad_push_list (self->srcpad, list);
+
   return ret;
 }
 
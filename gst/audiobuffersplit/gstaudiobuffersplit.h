@@ -60,6 +60,7 @@ struct _GstAudioBufferSplit {
   guint accumulated_error;
 
   gboolean strict_buffer_size;
+  gboolean buffer_list;
 };
 
 struct _GstAudioBufferSplitClass {
@@ -25,6 +25,10 @@
  * equal left/right channels on an input stream that has audio in only
  * one channel.
  *
+ * Both interleaved and non-interleaved 16 bit integer and 32 bit float
+ * samples are handled. Non-interleaved buffers hold the left samples
+ * followed by the right samples.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v audiotestsrc ! audiochannelmix ! autoaudiosink
@@ -41,6 +45,12 @@
 #include "gstaudiochannelmix.h"
 #include <math.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_audio_channel_mix_debug_category);
 #define GST_CAT_DEFAULT gst_audio_channel_mix_debug_category
 
@@ -72,16 +82,18 @@ static GstStaticPadTemplate gst_audio_channel_mix_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw,format=S16LE,rate=[1,max],"
-        "channels=2,layout=interleaved")
+    GST_STATIC_CAPS ("audio/x-raw,format={ " GST_AUDIO_NE (S16) ", "
+        GST_AUDIO_NE (F32) " },rate=[1,max],"
+        "channels=2,layout={ interleaved, non-interleaved }")
     );
 
 static GstStaticPadTemplate gst_audio_channel_mix_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw,format=S16LE,rate=[1,max],"
-        "channels=2,layout=interleaved")
+    GST_STATIC_CAPS ("audio/x-raw,format={ " GST_AUDIO_NE (S16) ", "
+        GST_AUDIO_NE (F32) " },rate=[1,max],"
+        "channels=2,layout={ interleaved, non-interleaved }")
     );
 
 
@@ -217,33 +229,169 @@ gst_audio_channel_mix_setup (GstAudioFilter * filter, const GstAudioInfo * info)
   return TRUE;
 }
 
+/* The gains are applied in double precision to 16 bit samples, the SSE2
+ * version gives the same results as the C loop */
+static void
+gst_audio_channel_mix_s16 (gint16 * left, gint16 * right, gint stride,
+    gint n, const gdouble gains[4])
+{
+  gdouble ll = gains[0], lr = gains[1], rl = gains[2], rr = gains[3];
+  gint i = 0;
+  gint l, r;
+
+#if defined(__SSE2__)
+  if (stride == 2) {
+    /* two frames per vector, as [l r] * [ll rr] + [r l] * [rl lr] */
+    __m128d a = _mm_set_pd (rr, ll);
+    __m128d b = _mm_set_pd (lr, rl);
+    __m128d min = _mm_set1_pd (-32768.0);
+    __m128d max = _mm_set1_pd (32767.0);
+    gint16 *data = left;
+
+    for (; i + 4 <= n; i += 4) {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (data + 2 * i));
+      __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16);
+      __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16);
+      __m128d f[4];
+      __m128i o[4];
+      gint j;
+
+      f[0] = _mm_cvtepi32_pd (lo);
+      f[1] = _mm_cvtepi32_pd (_mm_unpackhi_epi64 (lo, lo));
+      f[2] = _mm_cvtepi32_pd (hi);
+      f[3] = _mm_cvtepi32_pd (_mm_unpackhi_epi64 (hi, hi));
+
+      for (j = 0; j < 4; j++) {
+        __m128d x = _mm_add_pd (_mm_mul_pd (a, f[j]),
+            _mm_mul_pd (b, _mm_shuffle_pd (f[j], f[j], 1)));
+
+        x = _mm_min_pd (_mm_max_pd (x, min), max);
+        o[j] = _mm_cvtpd_epi32 (x);
+      }
+
+      _mm_storeu_si128 ((__m128i *) (data + 2 * i),
+          _mm_packs_epi32 (_mm_unpacklo_epi64 (o[0], o[1]),
+              _mm_unpacklo_epi64 (o[2], o[3])));
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    l = left[i * stride];
+    r = right[i * stride];
+    left[i * stride] = CLAMP (rint (ll * l + rl * r), -32768, 32767);
+    right[i * stride] = CLAMP (rint (lr * l + rr * r), -32768, 32767);
+  }
+}
+
+static void
+gst_audio_channel_mix_f32 (gfloat * left, gfloat * right, gint stride,
+    gint n, const gdouble gains[4])
+{
+  gfloat ll = gains[0], lr = gains[1], rl = gains[2], rr = gains[3];
+  gint i = 0;
+  gfloat l, r;
+
+#if defined(__SSE2__)
+  if (stride == 2) {
+    __m128 a = _mm_setr_ps (ll, rr, ll, rr);
+    __m128 b = _mm_setr_ps (rl, lr, rl, lr);
+
+    for (; i + 2 <= n; i += 2) {
+      __m128 v = _mm_loadu_ps (left + 2 * i);
+      __m128 s = _mm_shuffle_ps (v, v, _MM_SHUFFLE (2, 3, 0, 1));
+
+      _mm_storeu_ps (left + 2 * i, _mm_add_ps (_mm_mul_ps (a, v),
+              _mm_mul_ps (b, s)));
+    }
+  } else {
+    __m128 vll = _mm_set1_ps (ll), vlr = _mm_set1_ps (lr);
+    __m128 vrl = _mm_set1_ps (rl), vrr = _mm_set1_ps (rr);
+
+    for (; i + 4 <= n; i += 4) {
+      __m128 vl = _mm_loadu_ps (left + i);
+      __m128 vr = _mm_loadu_ps (right + i);
+
+      _mm_storeu_ps (left + i, _mm_add_ps (_mm_mul_ps (vll, vl),
+              _mm_mul_ps (vrl, vr)));
+      _mm_storeu_ps (right + i, _mm_add_ps (_mm_mul_ps (vlr, vl),
+              _mm_mul_ps (vrr, vr)));
+    }
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  if (stride == 2) {
+    for (; i + 4 <= n; i += 4) {
+      float32x4x2_t v = vld2q_f32 (left + 2 * i);
+      float32x4x2_t o;
+
+      o.val[0] = vaddq_f32 (vmulq_n_f32 (v.val[0], ll),
+          vmulq_n_f32 (v.val[1], rl));
+      o.val[1] = vaddq_f32 (vmulq_n_f32 (v.val[0], lr),
+          vmulq_n_f32 (v.val[1], rr));
+      vst2q_f32 (left + 2 * i, o);
+    }
+  } else {
+    for (; i + 4 <= n; i += 4) {
+      float32x4_t vl = vld1q_f32 (left + i);
+      float32x4_t vr = vld1q_f32 (right + i);
+
+      vst1q_f32 (left + i, vaddq_f32 (vmulq_n_f32 (vl, ll),
+              vmulq_n_f32 (vr, rl)));
+      vst1q_f32 (right + i, vaddq_f32 (vmulq_n_f32 (vl, lr),
+              vmulq_n_f32 (vr, rr)));
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    l = left[i * stride];
+    r = right[i * stride];
+    left[i * stride] = ll * l + rl * r;
+    right[i * stride] = lr * l + rr * r;
+  }
+}
+
 static GstFlowReturn
 gst_audio_channel_mix_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
 {
   GstAudioChannelMix *audiochannelmix = GST_AUDIO_CHANNEL_MIX (trans);
-  int n;
+  GstAudioInfo *info = GST_AUDIO_FILTER_INFO (trans);
+  gboolean interleaved;
+  gdouble gains[4];
   GstMapInfo map;
-  int i;
-  double ll = audiochannelmix->left_to_left;
-  double lr = audiochannelmix->left_to_right;
-  double rl = audiochannelmix->right_to_left;
-  double rr = audiochannelmix->right_to_right;
-  int l, r;
-  gint16 *data;
+  gint n, stride;
+  guint8 *left, *right;
 
   GST_DEBUG_OBJECT (audiochannelmix, "transform_ip");
 
+  gains[0] = audiochannelmix->left_to_left;
+  gains[1] = audiochannelmix->left_to_right;
+  gains[2] = audiochannelmix->right_to_left;
+  gains[3] = audiochannelmix->right_to_right;
+
   gst_buffer_map (buf, &map, GST_MAP_WRITE | GST_MAP_READ);
 
-  n = gst_buffer_get_size (buf) >> 2;
-  data = (gint16 *) map.data;
-  for (i = 0; i < n; i++) {
-    l = data[2 * i + 0];
-    r = data[2 * i + 1];
-    data[2 * i + 0] = CLAMP (rint (ll * l + rl * r), -32768, 32767);
-    data[2 * i + 1] = CLAMP (rint (lr * l + rr * r), -32768, 32767);
+  n = map.size / GST_AUDIO_INFO_BPF (info);
+  interleaved =
+      GST_AUDIO_INFO_LAYOUT (info) == GST_AUDIO_LAYOUT_INTERLEAVED;
+
+  /* non-interleaved buffers hold one plane per channel */
+  left = map.data;
+  if (interleaved) {
+    right = left + GST_AUDIO_INFO_BPS (info);
+    stride = 2;
+  } else {
+    right = left + n * GST_AUDIO_INFO_BPS (info);
+    stride = 1;
   }
 
+  if (GST_AUDIO_INFO_FORMAT (info) == GST_AUDIO_FORMAT_F32)
+    gst_audio_channel_mix_f32 ((gfloat *) left, (gfloat *) right, stride, n,
+        gains);
+  else
+    gst_audio_channel_mix_s16 ((gint16 *) left, (gint16 *) right, stride, n,
+        gains);
+
   gst_buffer_unmap (buf, &map);
 
   return GST_FLOW_OK;
@@ -29,6 +29,13 @@
  * SECTION:element-audiointerleave
  * @title: audiointerleave
  *
+ * Merges mono input streams into one multi-channel stream, with one channel
+ * per sink pad.
+ *
+ * The output is interleaved unless downstream only accepts non-interleaved
+ * audio. In that case every input buffer that covers a whole output buffer
+ * is passed on as one of its planes without copying the samples.
+ *
  */
 
 /* FIXME 0.11: suppress warnings for deprecated API such as GValueArray
@@ -131,7 +138,7 @@ GST_STATIC_PAD_TEMPLATE ("src",
         "rate = (int) [ 1, MAX ], "
         "channels = (int) [ 1, MAX ], "
         "format = (string) " GST_AUDIO_FORMATS_ALL ", "
-        "layout = (string) interleaved")
+        "layout = (string) { interleaved, non-interleaved }")
     );
 
 static void gst_audio_interleave_child_proxy_init (gpointer g_iface,
@@ -526,6 +533,11 @@ gst_audio_interleave_update_src_caps (GstAggregator * agg, GstCaps * caps,
       G_TYPE_STRING, "interleaved", "channel-mask", GST_TYPE_BITMASK,
       gst_audio_interleave_get_channel_mask (self), NULL);
 
+  /* prefer interleaved output, but if downstream only handles
+   * non-interleaved audio the inputs can be passed on as planes */
+  if (caps && !gst_caps_can_intersect (*ret, caps))
+    gst_structure_set (s, "layout", G_TYPE_STRING, "non-interleaved", NULL);
+
   GST_OBJECT_UNLOCK (self);
 
   return GST_FLOW_OK;
@@ -810,6 +822,60 @@ gst_audio_interleave_release_pad (GstElement * element, GstPad * pad)
 }
 
 
+/* Copies @num_frames frames of @inbuf into the plane of @channel in the
+ * non-interleaved @outbuf. If the input covers the whole plane, its memory
+ * is used as the plane instead of copying it. */
+static void
+gst_audio_interleave_copy_plane (GstAudioInterleave * self,
+    GstAudioInfo * info, GstBuffer * inbuf, guint in_offset,
+    GstBuffer * outbuf, guint out_offset, guint num_frames, gint channel)
+{
+  gint bps, out_channels;
+  gsize plane_size;
+  guint out_frames;
+  GstMapInfo inmap, outmap;
+
+  bps = GST_AUDIO_INFO_BPS (info);
+  out_channels = GST_AUDIO_INFO_CHANNELS (info);
+  out_frames = gst_buffer_get_size (outbuf) / GST_AUDIO_INFO_BPF (info);
+  plane_size = out_frames * bps;
+
+  if (in_offset == 0 && out_offset == 0 && num_frames == out_frames &&
+      gst_buffer_get_size (inbuf) == plane_size &&
+      out_channels <= gst_buffer_get_max_memory ()) {
+    /* give every plane its own memory, so that single planes can be
+     * replaced */
+    if (gst_buffer_n_memory (outbuf) != out_channels) {
+      GstMemory *mem = gst_buffer_get_all_memory (outbuf);
+      gint i;
+
+      gst_buffer_remove_all_memory (outbuf);
+      for (i = 0; i < out_channels; i++)
+        gst_buffer_append_memory (outbuf,
+            gst_memory_share (mem, i * plane_size, plane_size));
+      gst_memory_unref (mem);
+    }
+
+    GST_LOG_OBJECT (self, "using input memory as plane %d", channel);
+    gst_buffer_replace_memory (outbuf, channel,
+        gst_buffer_get_all_memory (inbuf));
+    return;
+  }
+
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  if (gst_buffer_n_memory (outbuf) == out_channels && out_channels > 1) {
+    gst_buffer_map_range (outbuf, channel, 1, &outmap, GST_MAP_WRITE);
+    memcpy (outmap.data + out_offset * bps, inmap.data + in_offset * bps,
+        num_frames * bps);
+  } else {
+    gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
+    memcpy (outmap.data + channel * plane_size + out_offset * bps,
+        inmap.data + in_offset * bps, num_frames * bps);
+  }
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unmap (inbuf, &inmap);
+}
+
 /* Called with object lock and pad object lock held */
 static gboolean
 gst_audio_interleave_aggregate_one_buffer (GstAudioAggregator * aagg,
@@ -831,18 +897,29 @@ gst_audio_interleave_aggregate_one_buffer (GstAudioAggregator * aagg,
   out_bpf = GST_AUDIO_INFO_BPF (&aagg->info);
   out_channels = GST_AUDIO_INFO_CHANNELS (&aagg->info);
 
-  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
-  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
-  GST_LOG_OBJECT (pad, "interleaves %u frames on channel %d/%d at offset %u"
-      " from offset %u", num_frames, pad->channel, out_channels,
-      out_offset * out_bpf, in_offset * in_bpf);
-
   if (self->channels > 64) {
     channel = pad->channel;
   } else {
     channel = self->default_channels_ordering_map[pad->channel];
   }
 
+  if (GST_AUDIO_INFO_LAYOUT (&aagg->info) == GST_AUDIO_LAYOUT_NON_INTERLEAVED) {
+    GST_LOG_OBJECT (pad, "copying %u frames to plane %d/%d at offset %u"
+        " from offset %u", num_frames, channel, out_channels, out_offset,
+        in_offset);
+    gst_audio_interleave_copy_plane (self, &aagg->info, inbuf, in_offset,
+        outbuf, out_offset, num_frames, channel);
+    GST_OBJECT_UNLOCK (aaggpad);
+    GST_OBJECT_UNLOCK (aagg);
+    return TRUE;
+  }
+
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  GST_LOG_OBJECT (pad, "interleaves %u frames on channel %d/%d at offset %u"
+      " from offset %u", num_frames, pad->channel, out_channels,
+      out_offset * out_bpf, in_offset * in_bpf);
+
   outdata = outmap.data + (out_offset * out_bpf) + (out_width * channel);
 
 
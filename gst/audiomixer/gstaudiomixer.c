@@ -44,6 +44,14 @@
  * * "mute": Whether to mute the pad or not (#gboolean)
  * * "volume": The volume of the pad, between 0.0 and 10.0 (#gdouble)
  *
+ * By default all inputs have to be in the same format. With the
+ * "convert-inputs" property set, inputs may use any sample format and channel
+ * layout, and are converted to the output format while mixing.
+ *
+ * When the volume is controlled with a #GstControlSource, it is interpolated
+ * linearly between the values at the start and the end of every mixed chunk
+ * for the S16, S32, F32 and F64 formats, which avoids audible steps.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 audiotestsrc freq=100 ! audiomixer name=mix ! audioconvert ! alsasink audiotestsrc freq=500 ! mix.
@@ -136,6 +144,18 @@ gst_audiomixer_pad_set_property (GObject * object, guint prop_id,
   }
 }
 
+static void
+gst_audiomixer_pad_finalize (GObject * object)
+{
+  GstAudioMixerPad *pad = GST_AUDIO_MIXER_PAD (object);
+
+  if (pad->converter)
+    gst_audio_converter_free (pad->converter);
+  g_free (pad->convert_data);
+
+  G_OBJECT_CLASS (gst_audiomixer_pad_parent_class)->finalize (object);
+}
+
 static void
 gst_audiomixer_pad_class_init (GstAudioMixerPadClass * klass)
 {
@@ -143,6 +163,7 @@ gst_audiomixer_pad_class_init (GstAudioMixerPadClass * klass)
 
   gobject_class->set_property = gst_audiomixer_pad_set_property;
   gobject_class->get_property = gst_audiomixer_pad_get_property;
+  gobject_class->finalize = gst_audiomixer_pad_finalize;
 
   g_object_class_install_property (gobject_class, PROP_PAD_VOLUME,
       g_param_spec_double ("volume", "Volume", "Volume of this pad",
@@ -161,10 +182,13 @@ gst_audiomixer_pad_init (GstAudioMixerPad * pad)
   pad->mute = DEFAULT_PAD_MUTE;
 }
 
+#define DEFAULT_CONVERT_INPUTS FALSE
+
 enum
 {
   PROP_0,
-  PROP_FILTER_CAPS
+  PROP_FILTER_CAPS,
+  PROP_CONVERT_INPUTS
 };
 
 /* elementfactory information */
@@ -230,6 +254,7 @@ gst_audiomixer_sink_getcaps (GstAggregator * agg, GstPad * pad,
   GstAudioMixer *audiomixer;
   GstCaps *result, *peercaps, *current_caps, *filter_caps;
   GstStructure *s;
+  gboolean convert_inputs;
   gint i, n;
 
   audiomixer = GST_AUDIO_MIXER (agg);
@@ -291,6 +316,36 @@ gst_audiomixer_sink_getcaps (GstAggregator * agg, GstPad * pad,
     }
   }
 
+  GST_OBJECT_LOCK (audiomixer);
+  convert_inputs = audiomixer->convert_inputs && aagg->current_caps != NULL;
+  GST_OBJECT_UNLOCK (audiomixer);
+
+  if (convert_inputs) {
+    GstCaps *tmp, *templ_caps;
+
+    /* once the output format is decided, other inputs get converted while
+     * mixing and only the rate and the layout have to match */
+    result = gst_caps_make_writable (result);
+    n = gst_caps_get_size (result);
+    for (i = 0; i < n; i++) {
+      s = gst_caps_get_structure (result, i);
+      gst_structure_remove_fields (s, "format", "channels", "channel-mask",
+          NULL);
+    }
+
+    templ_caps = gst_pad_get_pad_template_caps (pad);
+    tmp = gst_caps_intersect (result, templ_caps);
+    gst_caps_unref (templ_caps);
+    gst_caps_unref (result);
+    result = tmp;
+
+    if (filter) {
+      tmp = gst_caps_intersect_full (filter, result, GST_CAPS_INTERSECT_FIRST);
+      gst_caps_unref (result);
+      result = tmp;
+    }
+  }
+
   result = gst_caps_make_writable (result);
 
   n = gst_caps_get_size (result);
@@ -343,8 +398,24 @@ gst_audiomixer_sink_query (GstAggregator * agg, GstAggregatorPad * aggpad,
   return res;
 }
 
+static void
+gst_audiomixer_pad_set_converter (GstAudioMixerPad * pad,
+    GstAudioConverter * converter)
+{
+  GstAudioConverter *old;
+
+  GST_OBJECT_LOCK (pad);
+  old = pad->converter;
+  pad->converter = converter;
+  GST_OBJECT_UNLOCK (pad);
+
+  if (old)
+    gst_audio_converter_free (old);
+}
+
 /* the first caps we receive on any of the sinkpads will define the caps for all
- * the other sinkpads because we can only mix streams with the same caps.
+ * the other sinkpads because we can only mix streams with the same caps,
+ * unless inputs are converted while mixing.
  */
 static gboolean
 gst_audiomixer_setcaps (GstAudioMixer * audiomixer, GstPad * pad,
@@ -401,6 +472,30 @@ gst_audiomixer_setcaps (GstAudioMixer * audiomixer, GstPad * pad,
     if (gst_audio_info_is_equal (&info, &aagg->info)) {
       GST_OBJECT_UNLOCK (audiomixer);
       gst_caps_unref (caps);
+      gst_audiomixer_pad_set_converter (GST_AUDIO_MIXER_PAD (pad), NULL);
+      gst_audio_aggregator_set_sink_caps (aagg, GST_AUDIO_AGGREGATOR_PAD (pad),
+          orig_caps);
+      return TRUE;
+    } else if (audiomixer->convert_inputs &&
+        GST_AUDIO_INFO_RATE (&info) == GST_AUDIO_INFO_RATE (&aagg->info) &&
+        GST_AUDIO_INFO_LAYOUT (&info) == GST_AUDIO_LAYOUT_INTERLEAVED &&
+        GST_AUDIO_INFO_LAYOUT (&aagg->info) == GST_AUDIO_LAYOUT_INTERLEAVED) {
+      GstAudioConverter *converter;
+
+      converter = gst_audio_converter_new (GST_AUDIO_CONVERTER_FLAG_NONE,
+          &info, &aagg->info, NULL);
+      GST_OBJECT_UNLOCK (audiomixer);
+      gst_caps_unref (caps);
+
+      if (converter == NULL) {
+        GST_WARNING_OBJECT (pad, "can't convert input caps %" GST_PTR_FORMAT,
+            orig_caps);
+        return FALSE;
+      }
+
+      GST_INFO_OBJECT (pad, "converting input caps %" GST_PTR_FORMAT
+          " while mixing", orig_caps);
+      gst_audiomixer_pad_set_converter (GST_AUDIO_MIXER_PAD (pad), converter);
       gst_audio_aggregator_set_sink_caps (aagg, GST_AUDIO_AGGREGATOR_PAD (pad),
           orig_caps);
       return TRUE;
@@ -500,6 +595,23 @@ gst_audiomixer_class_init (GstAudioMixerClass * klass)
           "Setting this property takes a reference to the supplied GstCaps "
           "object", GST_TYPE_CAPS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAudioMixer:convert-inputs:
+   *
+   * Accept inputs with a sample format or channel layout that differs from
+   * the output and convert them while mixing, instead of requiring an
+   * audioconvert element in front of every sink pad. The first input still
+   * decides the output format. The sample rate and the layout have to match,
+   * and only interleaved audio is converted.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_CONVERT_INPUTS,
+      g_param_spec_boolean ("convert-inputs", "Convert inputs",
+          "Convert the sample format and channel layout of inputs while mixing",
+          DEFAULT_CONVERT_INPUTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class,
       &gst_audiomixer_src_template);
   gst_element_class_add_static_pad_template (gstelement_class,
@@ -527,6 +639,7 @@ static void
 gst_audiomixer_init (GstAudioMixer * audiomixer)
 {
   audiomixer->filter_caps = NULL;
+  audiomixer->convert_inputs = DEFAULT_CONVERT_INPUTS;
 }
 
 static void
@@ -567,6 +680,11 @@ gst_audiomixer_set_property (GObject * object, guint prop_id,
       GST_DEBUG_OBJECT (audiomixer, "set new caps %" GST_PTR_FORMAT, new_caps);
       break;
     }
+    case PROP_CONVERT_INPUTS:
+      GST_OBJECT_LOCK (audiomixer);
+      audiomixer->convert_inputs = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (audiomixer);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -585,6 +703,11 @@ gst_audiomixer_get_property (GObject * object, guint prop_id, GValue * value,
       gst_value_set_caps (value, audiomixer->filter_caps);
       GST_OBJECT_UNLOCK (audiomixer);
       break;
+    case PROP_CONVERT_INPUTS:
+      GST_OBJECT_LOCK (audiomixer);
+      g_value_set_boolean (value, audiomixer->convert_inputs);
+      GST_OBJECT_UNLOCK (audiomixer);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -632,127 +755,333 @@ gst_audiomixer_release_pad (GstElement * element, GstPad * pad)
 }
 
 
+/* Mixing kernels for volume ramps: the gain goes linearly from @start by
+ * @step per frame, so a controlled volume changes smoothly over a buffer
+ * instead of once per input buffer */
+#define MAKE_FLOAT_RAMP_FUNC(name, type)                                  \
+static void                                                               \
+audiomixer_add_volume_ramp_##name (type * dest, const type * src,         \
+    gdouble start, gdouble step, guint n_frames, guint channels)          \
+{                                                                         \
+  guint i, c;                                                             \
+                                                                          \
+  for (i = 0; i < n_frames; i++) {                                        \
+    type v = start + step * i;                                            \
+                                                                          \
+    for (c = 0; c < channels; c++)                                        \
+      dest[c] += src[c] * v;                                              \
+    dest += channels;                                                     \
+    src += channels;                                                      \
+  }                                                                       \
+}
+
+MAKE_FLOAT_RAMP_FUNC (f32, gfloat)
+MAKE_FLOAT_RAMP_FUNC (f64, gdouble)
+
+static void
+audiomixer_add_volume_ramp_s16 (gint16 * dest, const gint16 * src,
+    gdouble start, gdouble step, guint n_frames, guint channels)
+{
+  guint i, c;
+
+  for (i = 0; i < n_frames; i++) {
+    gint32 v = (start + step * i) * VOLUME_UNITY_INT16;
+
+    for (c = 0; c < channels; c++) {
+      gint32 t = (src[c] * v) >> VOLUME_UNITY_INT16_BIT_SHIFT;
+
+      t = CLAMP (t, G_MININT16, G_MAXINT16);
+      dest[c] = CLAMP (dest[c] + t, G_MININT16, G_MAXINT16);
+    }
+    dest += channels;
+    src += channels;
+  }
+}
+
+static void
+audiomixer_add_volume_ramp_s32 (gint32 * dest, const gint32 * src,
+    gdouble start, gdouble step, guint n_frames, guint channels)
+{
+  guint i, c;
+
+  for (i = 0; i < n_frames; i++) {
+    gint64 v = (start + step * i) * VOLUME_UNITY_INT32;
+
+    for (c = 0; c < channels; c++) {
+      gint64 t = (src[c] * v) >> VOLUME_UNITY_INT32_BIT_SHIFT;
+
+      t = CLAMP (t, G_MININT32, G_MAXINT32);
+      dest[c] = CLAMP (dest[c] + t, G_MININT32, G_MAXINT32);
+    }
+    dest += channels;
+    src += channels;
+  }
+}
+
 static gboolean
-gst_audiomixer_aggregate_one_buffer (GstAudioAggregator * aagg,
-    GstAudioAggregatorPad * aaggpad, GstBuffer * inbuf, guint in_offset,
-    GstBuffer * outbuf, guint out_offset, guint num_frames)
+gst_audiomixer_format_can_ramp (GstAudioFormat format)
 {
-  GstAudioMixerPad *pad = GST_AUDIO_MIXER_PAD (aaggpad);
-  GstMapInfo inmap;
-  GstMapInfo outmap;
-  gint bpf;
+  switch (format) {
+    case GST_AUDIO_FORMAT_S16:
+    case GST_AUDIO_FORMAT_S32:
+    case GST_AUDIO_FORMAT_F32:
+    case GST_AUDIO_FORMAT_F64:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
 
-  GST_OBJECT_LOCK (aagg);
-  GST_OBJECT_LOCK (aaggpad);
+/* Looks up the controlled volume of @pad at the start and end of the
+ * @num_frames frames of @inbuf that are mixed. Returns %FALSE if the volume
+ * is not controlled or does not change over them. */
+static gboolean
+gst_audiomixer_pad_get_volume_ramp (GstAudioMixerPad * pad, gint rate,
+    GstBuffer * inbuf, guint in_offset, guint num_frames,
+    gdouble * start_volume, gdouble * end_volume)
+{
+  GstAggregatorPad *bpad = GST_AGGREGATOR_PAD (pad);
+  GstClockTime start, end;
+  GValue *start_value, *end_value;
 
-  if (pad->mute || pad->volume < G_MINDOUBLE) {
-    GST_DEBUG_OBJECT (pad, "Skipping muted pad");
-    GST_OBJECT_UNLOCK (aaggpad);
-    GST_OBJECT_UNLOCK (aagg);
+  if (!GST_BUFFER_PTS_IS_VALID (inbuf) || num_frames < 2)
+    return FALSE;
+
+  if (!gst_object_has_active_control_bindings (GST_OBJECT_CAST (pad)))
+    return FALSE;
+
+  start = GST_BUFFER_PTS (inbuf) +
+      gst_util_uint64_scale_int (in_offset, GST_SECOND, rate);
+  end = start + gst_util_uint64_scale_int (num_frames, GST_SECOND, rate);
+
+  GST_OBJECT_LOCK (pad);
+  start = gst_segment_to_stream_time (&bpad->segment, GST_FORMAT_TIME, start);
+  end = gst_segment_to_stream_time (&bpad->segment, GST_FORMAT_TIME, end);
+  GST_OBJECT_UNLOCK (pad);
+
+  if (!GST_CLOCK_TIME_IS_VALID (start) || !GST_CLOCK_TIME_IS_VALID (end))
+    return FALSE;
+
+  start_value = gst_object_get_value (GST_OBJECT_CAST (pad), "volume", start);
+  if (start_value == NULL)
+    return FALSE;
+  end_value = gst_object_get_value (GST_OBJECT_CAST (pad), "volume", end);
+  if (end_value == NULL) {
+    g_value_unset (start_value);
+    g_free (start_value);
     return FALSE;
   }
 
-  bpf = GST_AUDIO_INFO_BPF (&aagg->info);
+  *start_volume = CLAMP (g_value_get_double (start_value), 0.0, 10.0);
+  *end_volume = CLAMP (g_value_get_double (end_value), 0.0, 10.0);
 
-  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
-  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
-  GST_LOG_OBJECT (pad, "mixing %u bytes at offset %u from offset %u",
-      num_frames * bpf, out_offset * bpf, in_offset * bpf);
+  g_value_unset (start_value);
+  g_free (start_value);
+  g_value_unset (end_value);
+  g_free (end_value);
+
+  return *start_volume != *end_volume;
+}
+
+/* Adds @n_frames frames of @channels interleaved samples from @in to @out,
+ * applying the current volume of @pad */
+static void
+gst_audiomixer_mix_samples (GstAudioMixerPad * pad, GstAudioFormat format,
+    gpointer out, gpointer in, guint n_frames, guint channels)
+{
+  guint n_samples = n_frames * channels;
 
-  /* further buffers, need to add them */
   if (pad->volume == 1.0) {
-    switch (aagg->info.finfo->format) {
+    switch (format) {
       case GST_AUDIO_FORMAT_U8:
-        audiomixer_orc_add_u8 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * aagg->info.channels);
+        audiomixer_orc_add_u8 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_S8:
-        audiomixer_orc_add_s8 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * aagg->info.channels);
+        audiomixer_orc_add_s8 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_U16:
-        audiomixer_orc_add_u16 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * aagg->info.channels);
+        audiomixer_orc_add_u16 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_S16:
-        audiomixer_orc_add_s16 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * aagg->info.channels);
+        audiomixer_orc_add_s16 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_U32:
-        audiomixer_orc_add_u32 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * aagg->info.channels);
+        audiomixer_orc_add_u32 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_S32:
-        audiomixer_orc_add_s32 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * aagg->info.channels);
+        audiomixer_orc_add_s32 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_F32:
-        audiomixer_orc_add_f32 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * aagg->info.channels);
+        audiomixer_orc_add_f32 (out, in, n_samples);
         break;
       case GST_AUDIO_FORMAT_F64:
-        audiomixer_orc_add_f64 ((gpointer) (outmap.data + out_offset * bpf),
-            (gpointer) (inmap.data + in_offset * bpf),
-            num_frames * aagg->info.channels);
+        audiomixer_orc_add_f64 (out, in, n_samples);
         break;
       default:
         g_assert_not_reached ();
         break;
     }
   } else {
-    switch (aagg->info.finfo->format) {
+    switch (format) {
       case GST_AUDIO_FORMAT_U8:
-        audiomixer_orc_add_volume_u8 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i8, num_frames * aagg->info.channels);
+        audiomixer_orc_add_volume_u8 (out, in, pad->volume_i8, n_samples);
         break;
       case GST_AUDIO_FORMAT_S8:
-        audiomixer_orc_add_volume_s8 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i8, num_frames * aagg->info.channels);
+        audiomixer_orc_add_volume_s8 (out, in, pad->volume_i8, n_samples);
         break;
       case GST_AUDIO_FORMAT_U16:
-        audiomixer_orc_add_volume_u16 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i16, num_frames * aagg->info.channels);
+        audiomixer_orc_add_volume_u16 (out, in, pad->volume_i16, n_samples);
         break;
       case GST_AUDIO_FORMAT_S16:
-        audiomixer_orc_add_volume_s16 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i16, num_frames * aagg->info.channels);
+        audiomixer_orc_add_volume_s16 (out, in, pad->volume_i16, n_samples);
         break;
       case GST_AUDIO_FORMAT_U32:
-        audiomixer_orc_add_volume_u32 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i32, num_frames * aagg->info.channels);
+        audiomixer_orc_add_volume_u32 (out, in, pad->volume_i32, n_samples);
         break;
       case GST_AUDIO_FORMAT_S32:
-        audiomixer_orc_add_volume_s32 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume_i32, num_frames * aagg->info.channels);
+        audiomixer_orc_add_volume_s32 (out, in, pad->volume_i32, n_samples);
         break;
       case GST_AUDIO_FORMAT_F32:
-        audiomixer_orc_add_volume_f32 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume, num_frames * aagg->info.channels);
+        audiomixer_orc_add_volume_f32 (out, in, pad->volume, n_samples);
         break;
       case GST_AUDIO_FORMAT_F64:
-        audiomixer_orc_add_volume_f64 ((gpointer) (outmap.data +
-                out_offset * bpf), (gpointer) (inmap.data + in_offset * bpf),
-            pad->volume, num_frames * aagg->info.channels);
+        audiomixer_orc_add_volume_f64 (out, in, pad->volume, n_samples);
         break;
       default:
         g_assert_not_reached ();
         break;
     }
   }
+}
+
+/* Same as gst_audiomixer_mix_samples() but with the volume going linearly
+ * from @start_volume to @end_volume */
+static void
+gst_audiomixer_mix_samples_ramp (GstAudioFormat format, gpointer out,
+    gpointer in, guint n_frames, guint channels, gdouble start_volume,
+    gdouble end_volume)
+{
+  gdouble step = (end_volume - start_volume) / n_frames;
+
+  switch (format) {
+    case GST_AUDIO_FORMAT_S16:
+      audiomixer_add_volume_ramp_s16 (out, in, start_volume, step, n_frames,
+          channels);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      audiomixer_add_volume_ramp_s32 (out, in, start_volume, step, n_frames,
+          channels);
+      break;
+    case GST_AUDIO_FORMAT_F32:
+      audiomixer_add_volume_ramp_f32 (out, in, start_volume, step, n_frames,
+          channels);
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      audiomixer_add_volume_ramp_f64 (out, in, start_volume, step, n_frames,
+          channels);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+}
+
+static gboolean
+gst_audiomixer_aggregate_one_buffer (GstAudioAggregator * aagg,
+    GstAudioAggregatorPad * aaggpad, GstBuffer * inbuf, guint in_offset,
+    GstBuffer * outbuf, guint out_offset, guint num_frames)
+{
+  GstAudioMixerPad *pad = GST_AUDIO_MIXER_PAD (aaggpad);
+  GstAudioFormat format;
+  GstMapInfo inmap;
+  GstMapInfo outmap;
+  gint bpf, bps, channels, rate;
+  guint n_planes, plane, in_frames, out_frames;
+  guint8 *in_data;
+  gboolean ramp;
+  gdouble start_volume, end_volume;
+
+  GST_OBJECT_LOCK (aagg);
+  format = GST_AUDIO_INFO_FORMAT (&aagg->info);
+  rate = GST_AUDIO_INFO_RATE (&aagg->info);
+  GST_OBJECT_UNLOCK (aagg);
+
+  /* this takes the pad's object lock, so must happen before we lock it */
+  ramp = gst_audiomixer_format_can_ramp (format) &&
+      gst_audiomixer_pad_get_volume_ramp (pad, rate, inbuf, in_offset,
+      num_frames, &start_volume, &end_volume);
+
+  GST_OBJECT_LOCK (aagg);
+  GST_OBJECT_LOCK (aaggpad);
+
+  if (!ramp)
+    start_volume = end_volume = pad->volume;
+
+  if (pad->mute || MAX (start_volume, end_volume) < G_MINDOUBLE) {
+    GST_DEBUG_OBJECT (pad, "Skipping muted pad");
+    GST_OBJECT_UNLOCK (aaggpad);
+    GST_OBJECT_UNLOCK (aagg);
+    return FALSE;
+  }
+
+  bpf = GST_AUDIO_INFO_BPF (&aagg->info);
+  bps = GST_AUDIO_INFO_BPS (&aagg->info);
+  channels = GST_AUDIO_INFO_CHANNELS (&aagg->info);
+
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  GST_LOG_OBJECT (pad, "mixing %u bytes at offset %u from offset %u",
+      num_frames * bpf, out_offset * bpf, in_offset * bpf);
+
+  /* non-interleaved buffers store the samples of each channel after each
+   * other, so mix one plane after another */
+  if (GST_AUDIO_INFO_LAYOUT (&aagg->info) == GST_AUDIO_LAYOUT_NON_INTERLEAVED) {
+    n_planes = channels;
+    channels = 1;
+  } else {
+    n_planes = 1;
+  }
+  out_frames = outmap.size / bpf;
+
+  if (pad->converter) {
+    gpointer in[1], out[1];
+
+    if (pad->convert_size < num_frames * bpf) {
+      pad->convert_size = num_frames * bpf;
+      pad->convert_data = g_realloc (pad->convert_data, pad->convert_size);
+    }
+
+    in[0] = inmap.data + in_offset * GST_AUDIO_INFO_BPF (&aaggpad->info);
+    out[0] = pad->convert_data;
+    gst_audio_converter_samples (pad->converter,
+        GST_AUDIO_CONVERTER_FLAG_NONE, in, num_frames, out, num_frames);
+
+    in_data = pad->convert_data;
+    in_frames = num_frames;
+    in_offset = 0;
+  } else {
+    in_data = inmap.data;
+    in_frames = inmap.size / bpf;
+  }
+
+  for (plane = 0; plane < n_planes; plane++) {
+    guint8 *out, *in;
+
+    if (n_planes > 1) {
+      out = outmap.data + (plane * out_frames + out_offset) * bps;
+      in = in_data + (plane * in_frames + in_offset) * bps;
+    } else {
+      out = outmap.data + out_offset * bpf;
+      in = in_data + in_offset * bpf;
+    }
+
+    if (ramp)
+      gst_audiomixer_mix_samples_ramp (format, out, in, num_frames, channels,
+          start_volume, end_volume);
+    else
+      gst_audiomixer_mix_samples (pad, format, out, in, num_frames, channels);
+  }
+
   gst_buffer_unmap (inbuf, &inmap);
   gst_buffer_unmap (outbuf, &outmap);
 
@@ -53,6 +53,9 @@ struct _GstAudioMixer {
 
   /* target caps (set via property) */
   GstCaps *filter_caps;
+
+  /* accept inputs in other formats and channel layouts */
+  gboolean convert_inputs;
 };
 
 struct _GstAudioMixerClass {
@@ -76,6 +79,12 @@ struct _GstAudioMixerPad {
   gint volume_i16;
   gint volume_i8;
   gboolean mute;
+
+  /* converts the input to the output format while mixing, NULL if the input
+   * is in the output format already */
+  GstAudioConverter *converter;
+  gpointer convert_data;
+  gsize convert_size;
 };
 
 struct _GstAudioMixerPadClass {
@@ -60,6 +60,11 @@
  * gst-launch-1.0 audiotestsrc ! audio/x-raw,channels=4 ! audiomixmatrix in-channels=4 out-channels=2 channel-mask=-1 matrix="<<(double)1, (double)0, (double)0, (double)0>, <0.0, 1.0, 0.0, 0.0>>" ! audio/x-raw,channels=2 ! autoaudiosink
  * ]|
  *
+ * The matrix is precompiled for the negotiated format: matrices with few
+ * nonzero coefficients, like routing matrices, only go through those, and
+ * the others use vectorized kernels. Setting a new matrix while playing
+ * interpolates the coefficients over #GstAudioMixMatrix:ramp-time.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -73,6 +78,12 @@
 #include <string.h>
 #include <math.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (audiomixmatrix_debug);
 #define GST_CAT_DEFAULT audiomixmatrix_debug
 
@@ -84,9 +95,19 @@ enum
   PROP_OUT_CHANNELS,
   PROP_MATRIX,
   PROP_CHANNEL_MASK,
-  PROP_MODE
+  PROP_MODE,
+  PROP_RAMP_TIME
 };
 
+#define DEFAULT_RAMP_TIME (10 * GST_MSECOND)
+
+/* The sparse kernels are used if at most 1 / SPARSE_DENSITY of the
+ * coefficients are nonzero */
+#define SPARSE_DENSITY 4
+
+/* The dense kernels accumulate a whole output frame on the stack */
+#define MAX_DENSE_CHANNELS 64
+
 GType
 gst_audio_mix_matrix_mode_get_type (void)
 {
@@ -200,6 +221,18 @@ gst_audio_mix_matrix_class_init (GstAudioMixMatrixClass * klass)
           GST_AUDIO_MIX_MATRIX_MODE_MANUAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAudioMixMatrix:ramp-time:
+   *
+   * Time over which the coefficients are interpolated when the matrix
+   * changes during playback, 0 to switch them at once.
+   */
+  g_object_class_install_property (gobject_class, PROP_RAMP_TIME,
+      g_param_spec_uint64 ("ramp-time", "Ramp time",
+          "Time in nanoseconds to interpolate to a new matrix during playback",
+          0, G_MAXUINT64, DEFAULT_RAMP_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&gst_audio_mix_matrix_sink_template));
   gst_element_class_add_pad_template (element_class,
@@ -228,6 +261,32 @@ gst_audio_mix_matrix_init (GstAudioMixMatrix * self)
   self->s16_conv_matrix = NULL;
   self->s32_conv_matrix = NULL;
   self->mode = GST_AUDIO_MIX_MATRIX_MODE_MANUAL;
+  self->ramp_time = DEFAULT_RAMP_TIME;
+  self->format = GST_AUDIO_FORMAT_UNKNOWN;
+}
+
+static void
+gst_audio_mix_matrix_clear_ramp (GstAudioMixMatrix * self)
+{
+  g_free (self->ramp_matrix);
+  self->ramp_matrix = NULL;
+  g_free (self->ramp_in);
+  self->ramp_in = NULL;
+  g_free (self->ramp_start);
+  self->ramp_start = NULL;
+  self->ramp_pos = self->ramp_length = 0;
+}
+
+static void
+gst_audio_mix_matrix_clear_kernels (GstAudioMixMatrix * self)
+{
+  g_free (self->sparse_in);
+  self->sparse_in = NULL;
+  g_free (self->sparse_start);
+  self->sparse_start = NULL;
+  g_free (self->dense_matrix);
+  self->dense_matrix = NULL;
+  self->sparse = FALSE;
 }
 
 static void
@@ -240,6 +299,13 @@ gst_audio_mix_matrix_dispose (GObject * object)
     self->matrix = NULL;
   }
 
+  g_free (self->s16_conv_matrix);
+  self->s16_conv_matrix = NULL;
+  g_free (self->s32_conv_matrix);
+  self->s32_conv_matrix = NULL;
+  gst_audio_mix_matrix_clear_kernels (self);
+  gst_audio_mix_matrix_clear_ramp (self);
+
   G_OBJECT_CLASS (gst_audio_mix_matrix_parent_class)->dispose (object);
 }
 
@@ -279,6 +345,200 @@ gst_audio_mix_matrix_convert_s32_matrix (GstAudioMixMatrix * self)
   }
 }
 
+/* Lists the input channels of the coefficients of each output channel that
+ * are nonzero in @matrix or @matrix2, returns the number of them */
+static guint
+gst_audio_mix_matrix_list_nonzero (GstAudioMixMatrix * self,
+    const gdouble * matrix, const gdouble * matrix2, guint ** in_list,
+    guint ** start_list)
+{
+  guint in, out, n = 0;
+  guint *list = g_new (guint, self->in_channels * self->out_channels + 1);
+  guint *start = g_new (guint, self->out_channels + 1);
+
+  for (out = 0; out < self->out_channels; out++) {
+    start[out] = n;
+    for (in = 0; in < self->in_channels; in++) {
+      guint i = out * self->in_channels + in;
+
+      if (matrix[i] != 0 || (matrix2 && matrix2[i] != 0))
+        list[n++] = in;
+    }
+  }
+  start[self->out_channels] = n;
+
+  *in_list = list;
+  *start_list = start;
+  return n;
+}
+
+/* must be called with the object lock, prepares the kernels for the
+ * matrix and the negotiated format */
+static void
+gst_audio_mix_matrix_update_kernels (GstAudioMixMatrix * self)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  guint stride = GST_ROUND_UP_4 (outchannels);
+  guint in, out, n;
+
+  gst_audio_mix_matrix_clear_kernels (self);
+
+  if (self->matrix == NULL || inchannels == 0 || outchannels == 0)
+    return;
+
+  n = gst_audio_mix_matrix_list_nonzero (self, self->matrix, NULL,
+      &self->sparse_in, &self->sparse_start);
+  self->sparse = n * SPARSE_DENSITY <= inchannels * outchannels
+      || stride > MAX_DENSE_CHANNELS;
+
+  GST_DEBUG_OBJECT (self, "%u of %u coefficients nonzero, using %s kernels",
+      n, inchannels * outchannels, self->sparse ? "sparse" : "dense");
+
+  switch (self->format) {
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:{
+      gfloat *dense = g_new0 (gfloat, inchannels * stride);
+
+      for (in = 0; in < inchannels; in++)
+        for (out = 0; out < outchannels; out++)
+          dense[in * stride + out] = self->matrix[out * inchannels + in];
+      self->dense_matrix = dense;
+      break;
+    }
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:{
+      gdouble *dense = g_new0 (gdouble, inchannels * stride);
+
+      for (in = 0; in < inchannels; in++)
+        for (out = 0; out < outchannels; out++)
+          dense[in * stride + out] = self->matrix[out * inchannels + in];
+      self->dense_matrix = dense;
+      break;
+    }
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:{
+      gint16 *dense;
+
+      gst_audio_mix_matrix_convert_s16_matrix (self);
+
+      /* a coefficient of exactly 1 with a single input channel needs 17
+       * bits */
+      for (n = 0; n < inchannels * outchannels; n++)
+        if (self->s16_conv_matrix[n] > G_MAXINT16)
+          return;
+
+      /* pairs of input channels, each output channel holding the two
+       * coefficients next to each other */
+      dense = g_new0 (gint16, (inchannels + 1) / 2 * stride * 2);
+      for (in = 0; in < inchannels; in++)
+        for (out = 0; out < outchannels; out++)
+          dense[(in / 2) * stride * 2 + out * 2 + (in & 1)] =
+              self->s16_conv_matrix[out * inchannels + in];
+      self->dense_matrix = dense;
+      break;
+    }
+    case GST_AUDIO_FORMAT_S32LE:
+    case GST_AUDIO_FORMAT_S32BE:{
+      gint64 *dense;
+
+      gst_audio_mix_matrix_convert_s32_matrix (self);
+
+      dense = g_new0 (gint64, inchannels * stride);
+      for (in = 0; in < inchannels; in++)
+        for (out = 0; out < outchannels; out++)
+          dense[in * stride + out] =
+              self->s32_conv_matrix[out * inchannels + in];
+      self->dense_matrix = dense;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+
+/* Reads the rows of the matrix property, NULL if they don't match the
+ * channels */
+static gdouble *
+gst_audio_mix_matrix_parse_matrix (GstAudioMixMatrix * self,
+    const GValue * value)
+{
+  gdouble *matrix;
+  gint in, out;
+
+  if (gst_value_array_get_size (value) != self->out_channels)
+    goto wrong_size;
+
+  matrix = g_new (gdouble, self->in_channels * self->out_channels);
+  for (out = 0; out < self->out_channels; out++) {
+    const GValue *row = gst_value_array_get_value (value, out);
+
+    if (gst_value_array_get_size (row) != self->in_channels) {
+      g_free (matrix);
+      goto wrong_size;
+    }
+    for (in = 0; in < self->in_channels; in++) {
+      const GValue *itm;
+      gdouble coefficient;
+
+      itm = gst_value_array_get_value (row, in);
+      if (!G_VALUE_HOLDS_DOUBLE (itm)) {
+        g_free (matrix);
+        g_return_val_if_reached (NULL);
+      }
+      coefficient = g_value_get_double (itm);
+      matrix[out * self->in_channels + in] = coefficient;
+    }
+  }
+
+  return matrix;
+
+wrong_size:
+  GST_ERROR_OBJECT (self, "The matrix needs %u rows of %u coefficients",
+      self->out_channels, self->in_channels);
+  return NULL;
+}
+
+/* must be called with the object lock, takes ownership of @matrix. During
+ * playback the coefficients are interpolated from the current ones. */
+static void
+gst_audio_mix_matrix_set_matrix (GstAudioMixMatrix * self, gdouble * matrix)
+{
+  gdouble *from = NULL;
+  guint64 length = 0;
+
+  if (self->matrix && self->sparse_start && self->rate > 0)
+    length = gst_util_uint64_scale_int (self->ramp_time, self->rate,
+        GST_SECOND);
+
+  if (length > 0) {
+    from = self->matrix;
+    /* continue from where an unfinished ramp is now */
+    if (self->ramp_matrix) {
+      gdouble t = (gdouble) self->ramp_pos / self->ramp_length;
+      guint i;
+
+      for (i = 0; i < self->in_channels * self->out_channels; i++)
+        from[i] = self->ramp_matrix[i] + (from[i] - self->ramp_matrix[i]) * t;
+    }
+  } else {
+    g_free (self->matrix);
+  }
+
+  gst_audio_mix_matrix_clear_ramp (self);
+  self->matrix = matrix;
+
+  if (from) {
+    self->ramp_matrix = from;
+    self->ramp_length = MIN (length, G_MAXUINT);
+    gst_audio_mix_matrix_list_nonzero (self, self->ramp_matrix, self->matrix,
+        &self->ramp_in, &self->ramp_start);
+  }
+
+  if (self->format != GST_AUDIO_FORMAT_UNKNOWN)
+    gst_audio_mix_matrix_update_kernels (self);
+}
 
 static void
 gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
@@ -288,42 +548,28 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_IN_CHANNELS:
+      GST_OBJECT_LOCK (self);
       self->in_channels = g_value_get_uint (value);
-      if (self->matrix) {
-        gst_audio_mix_matrix_convert_s16_matrix (self);
-        gst_audio_mix_matrix_convert_s32_matrix (self);
-      }
+      /* the matrix has to be set again for the new channels */
+      gst_audio_mix_matrix_clear_kernels (self);
+      gst_audio_mix_matrix_clear_ramp (self);
+      GST_OBJECT_UNLOCK (self);
       break;
     case PROP_OUT_CHANNELS:
+      GST_OBJECT_LOCK (self);
       self->out_channels = g_value_get_uint (value);
-      if (self->matrix) {
-        gst_audio_mix_matrix_convert_s16_matrix (self);
-        gst_audio_mix_matrix_convert_s32_matrix (self);
-      }
+      gst_audio_mix_matrix_clear_kernels (self);
+      gst_audio_mix_matrix_clear_ramp (self);
+      GST_OBJECT_UNLOCK (self);
       break;
     case PROP_MATRIX:{
-      gint in, out;
-
-      if (self->matrix)
-        g_free (self->matrix);
-      self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
+      gdouble *matrix;
 
-      g_return_if_fail (gst_value_array_get_size (value) == self->out_channels);
-      for (out = 0; out < self->out_channels; out++) {
-        const GValue *row = gst_value_array_get_value (value, out);
-        g_return_if_fail (gst_value_array_get_size (row) == self->in_channels);
-        for (in = 0; in < self->in_channels; in++) {
-          const GValue *itm;
-          gdouble coefficient;
-
-          itm = gst_value_array_get_value (row, in);
-          g_return_if_fail (G_VALUE_HOLDS_DOUBLE (itm));
-          coefficient = g_value_get_double (itm);
-          self->matrix[out * self->in_channels + in] = coefficient;
-        }
-      }
-      gst_audio_mix_matrix_convert_s16_matrix (self);
-      gst_audio_mix_matrix_convert_s32_matrix (self);
+      GST_OBJECT_LOCK (self);
+      matrix = gst_audio_mix_matrix_parse_matrix (self, value);
+      if (matrix)
+        gst_audio_mix_matrix_set_matrix (self, matrix);
+      GST_OBJECT_UNLOCK (self);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -332,6 +578,11 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
     case PROP_MODE:
       self->mode = g_value_get_enum (value);
       break;
+    case PROP_RAMP_TIME:
+      GST_OBJECT_LOCK (self);
+      self->ramp_time = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -354,8 +605,11 @@ gst_audio_mix_matrix_get_property (GObject * object, guint prop_id,
     case PROP_MATRIX:{
       gint in, out;
 
-      if (self->matrix == NULL)
+      GST_OBJECT_LOCK (self);
+      if (self->matrix == NULL) {
+        GST_OBJECT_UNLOCK (self);
         break;
+      }
 
       for (out = 0; out < self->out_channels; out++) {
         GValue row = G_VALUE_INIT;
@@ -370,6 +624,7 @@ gst_audio_mix_matrix_get_property (GObject * object, guint prop_id,
         gst_value_array_append_value (value, &row);
         g_value_unset (&row);
       }
+      GST_OBJECT_UNLOCK (self);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -378,6 +633,11 @@ gst_audio_mix_matrix_get_property (GObject * object, guint prop_id,
     case PROP_MODE:
       g_value_set_enum (value, self->mode);
       break;
+    case PROP_RAMP_TIME:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->ramp_time);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -404,22 +664,322 @@ gst_audio_mix_matrix_change_state (GstElement * element,
       g_free (self->s32_conv_matrix);
       self->s32_conv_matrix = NULL;
     }
+
+    GST_OBJECT_LOCK (self);
+    gst_audio_mix_matrix_clear_kernels (self);
+    gst_audio_mix_matrix_clear_ramp (self);
+    self->format = GST_AUDIO_FORMAT_UNKNOWN;
+    self->rate = 0;
+    GST_OBJECT_UNLOCK (self);
   }
 
   return s;
 }
 
 
+/* The kernels write @n_samples frames, the dense ones accumulate all the
+ * output channels of a frame at once from one input channel after the
+ * other, which sums the products in the same order as the sparse ones */
+
+static void
+gst_audio_mix_matrix_mix_f32 (GstAudioMixMatrix * self, const gfloat * inarray,
+    gfloat * outarray, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  guint stride = GST_ROUND_UP_4 (outchannels);
+  const gfloat *dense = self->dense_matrix;
+  guint sample, in, out, i;
+
+  if (self->sparse) {
+    for (sample = 0; sample < n_samples; sample++) {
+      for (out = 0; out < outchannels; out++) {
+        gfloat outval = 0;
+
+        for (i = self->sparse_start[out]; i < self->sparse_start[out + 1];
+            i++) {
+          in = self->sparse_in[i];
+          outval += inarray[in] * dense[in * stride + out];
+        }
+        outarray[out] = outval;
+      }
+      inarray += inchannels;
+      outarray += outchannels;
+    }
+    return;
+  }
+
+  for (sample = 0; sample < n_samples; sample++) {
+    gfloat acc[MAX_DENSE_CHANNELS];
+
+    memset (acc, 0, stride * sizeof (gfloat));
+    for (in = 0; in < inchannels; in++) {
+      const gfloat *row = dense + in * stride;
+#if defined(__SSE2__)
+      __m128 v = _mm_set1_ps (inarray[in]);
+
+      for (out = 0; out < stride; out += 4)
+        _mm_storeu_ps (acc + out, _mm_add_ps (_mm_loadu_ps (acc + out),
+                _mm_mul_ps (v, _mm_loadu_ps (row + out))));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+      gfloat v = inarray[in];
+
+      for (out = 0; out < stride; out += 4)
+        vst1q_f32 (acc + out, vmlaq_n_f32 (vld1q_f32 (acc + out),
+                vld1q_f32 (row + out), v));
+#else
+      gfloat v = inarray[in];
+
+      for (out = 0; out < stride; out++)
+        acc[out] += v * row[out];
+#endif
+    }
+    memcpy (outarray, acc, outchannels * sizeof (gfloat));
+    inarray += inchannels;
+    outarray += outchannels;
+  }
+}
+
+static void
+gst_audio_mix_matrix_mix_f64 (GstAudioMixMatrix * self,
+    const gdouble * inarray, gdouble * outarray, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  guint stride = GST_ROUND_UP_4 (outchannels);
+  const gdouble *dense = self->dense_matrix;
+  guint sample, in, out, i;
+
+  if (self->sparse) {
+    for (sample = 0; sample < n_samples; sample++) {
+      for (out = 0; out < outchannels; out++) {
+        gdouble outval = 0;
+
+        for (i = self->sparse_start[out]; i < self->sparse_start[out + 1];
+            i++) {
+          in = self->sparse_in[i];
+          outval += inarray[in] * dense[in * stride + out];
+        }
+        outarray[out] = outval;
+      }
+      inarray += inchannels;
+      outarray += outchannels;
+    }
+    return;
+  }
+
+  for (sample = 0; sample < n_samples; sample++) {
+    gdouble acc[MAX_DENSE_CHANNELS];
+
+    memset (acc, 0, stride * sizeof (gdouble));
+    for (in = 0; in < inchannels; in++) {
+      const gdouble *row = dense + in * stride;
+#if defined(__SSE2__)
+      __m128d v = _mm_set1_pd (inarray[in]);
+
+      for (out = 0; out < stride; out += 2)
+        _mm_storeu_pd (acc + out, _mm_add_pd (_mm_loadu_pd (acc + out),
+                _mm_mul_pd (v, _mm_loadu_pd (row + out))));
+#else
+      gdouble v = inarray[in];
+
+      for (out = 0; out < stride; out++)
+        acc[out] += v * row[out];
+#endif
+    }
+    memcpy (outarray, acc, outchannels * sizeof (gdouble));
+    inarray += inchannels;
+    outarray += outchannels;
+  }
+}
+
+static void
+gst_audio_mix_matrix_mix_s16 (GstAudioMixMatrix * self,
+    const gint16 * inarray, gint16 * outarray, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  guint stride = GST_ROUND_UP_4 (outchannels);
+  guint n = self->shift_bytes;
+  const gint32 *conv_matrix = self->s16_conv_matrix;
+  const gint16 *dense = self->dense_matrix;
+  guint sample, in, out, i;
+
+  if (self->sparse || dense == NULL) {
+    for (sample = 0; sample < n_samples; sample++) {
+      for (out = 0; out < outchannels; out++) {
+        gint32 outval = 0;
+
+        for (i = self->sparse_start[out]; i < self->sparse_start[out + 1];
+            i++) {
+          in = self->sparse_in[i];
+          outval += (gint32) (inarray[in] * conv_matrix[out * inchannels + in]);
+        }
+        outarray[out] = (gint16) (outval >> n);
+      }
+      inarray += inchannels;
+      outarray += outchannels;
+    }
+    return;
+  }
+
+  for (sample = 0; sample < n_samples; sample++) {
+    gint32 acc[MAX_DENSE_CHANNELS];
+
+    memset (acc, 0, stride * sizeof (gint32));
+    /* two input channels at a time, multiplied by the interleaved
+     * coefficients of both and added */
+    for (in = 0; in < inchannels; in += 2) {
+      const gint16 *row = dense + (in / 2) * stride * 2;
+      gint16 a = inarray[in];
+      gint16 b = in + 1 < inchannels ? inarray[in + 1] : 0;
+#if defined(__SSE2__)
+      __m128i v = _mm_set1_epi32 ((guint16) a | ((guint32) (guint16) b << 16));
+
+      for (out = 0; out < stride; out += 4)
+        _mm_storeu_si128 ((__m128i *) (acc + out),
+            _mm_add_epi32 (_mm_loadu_si128 ((__m128i *) (acc + out)),
+                _mm_madd_epi16 (v, _mm_loadu_si128 ((__m128i *) (row +
+                            out * 2)))));
+#else
+      for (out = 0; out < stride; out++)
+        acc[out] += a * row[out * 2] + b * row[out * 2 + 1];
+#endif
+    }
+    for (out = 0; out < outchannels; out++)
+      outarray[out] = (gint16) (acc[out] >> n);
+    inarray += inchannels;
+    outarray += outchannels;
+  }
+}
+
+static void
+gst_audio_mix_matrix_mix_s32 (GstAudioMixMatrix * self,
+    const gint32 * inarray, gint32 * outarray, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  guint stride = GST_ROUND_UP_4 (outchannels);
+  guint n = self->shift_bytes;
+  const gint64 *dense = self->dense_matrix;
+  guint sample, in, out, i;
+
+  if (self->sparse) {
+    for (sample = 0; sample < n_samples; sample++) {
+      for (out = 0; out < outchannels; out++) {
+        gint64 outval = 0;
+
+        for (i = self->sparse_start[out]; i < self->sparse_start[out + 1];
+            i++) {
+          in = self->sparse_in[i];
+          outval += (gint64) (inarray[in] * dense[in * stride + out]);
+        }
+        outarray[out] = (gint32) (outval >> n);
+      }
+      inarray += inchannels;
+      outarray += outchannels;
+    }
+    return;
+  }
+
+  /* SSE2 has no 64 bit multiplication, this is left to the compiler */
+  for (sample = 0; sample < n_samples; sample++) {
+    gint64 acc[MAX_DENSE_CHANNELS];
+
+    memset (acc, 0, stride * sizeof (gint64));
+    for (in = 0; in < inchannels; in++) {
+      const gint64 *row = dense + in * stride;
+      gint64 v = inarray[in];
+
+      for (out = 0; out < stride; out++)
+        acc[out] += v * row[out];
+    }
+    for (out = 0; out < outchannels; out++)
+      outarray[out] = (gint32) (acc[out] >> n);
+    inarray += inchannels;
+    outarray += outchannels;
+  }
+}
+
+/* Mixes @n_samples frames while interpolating the coefficients, in double
+ * precision for all formats */
+static void
+gst_audio_mix_matrix_mix_ramp (GstAudioMixMatrix * self, gconstpointer indata,
+    gpointer outdata, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  const gdouble *from = self->ramp_matrix;
+  const gdouble *to = self->matrix;
+  guint sample, in, out, i;
+
+  for (sample = 0; sample < n_samples; sample++) {
+    gdouble t = (gdouble) (self->ramp_pos + 1) / self->ramp_length;
+    guint frame_in = sample * inchannels;
+    guint frame_out = sample * outchannels;
+
+    for (out = 0; out < outchannels; out++) {
+      gdouble outval = 0;
+
+      for (i = self->ramp_start[out]; i < self->ramp_start[out + 1]; i++) {
+        guint c;
+        gdouble x;
+
+        in = self->ramp_in[i];
+        c = out * inchannels + in;
+        switch (self->format) {
+          case GST_AUDIO_FORMAT_F32LE:
+          case GST_AUDIO_FORMAT_F32BE:
+            x = ((const gfloat *) indata)[frame_in + in];
+            break;
+          case GST_AUDIO_FORMAT_F64LE:
+          case GST_AUDIO_FORMAT_F64BE:
+            x = ((const gdouble *) indata)[frame_in + in];
+            break;
+          case GST_AUDIO_FORMAT_S16LE:
+          case GST_AUDIO_FORMAT_S16BE:
+            x = ((const gint16 *) indata)[frame_in + in];
+            break;
+          default:
+            x = ((const gint32 *) indata)[frame_in + in];
+            break;
+        }
+        outval += x * (from[c] + (to[c] - from[c]) * t);
+      }
+
+      switch (self->format) {
+        case GST_AUDIO_FORMAT_F32LE:
+        case GST_AUDIO_FORMAT_F32BE:
+          ((gfloat *) outdata)[frame_out + out] = outval;
+          break;
+        case GST_AUDIO_FORMAT_F64LE:
+        case GST_AUDIO_FORMAT_F64BE:
+          ((gdouble *) outdata)[frame_out + out] = outval;
+          break;
+        case GST_AUDIO_FORMAT_S16LE:
+        case GST_AUDIO_FORMAT_S16BE:
+          ((gint16 *) outdata)[frame_out + out] =
+              CLAMP (outval, G_MININT16, G_MAXINT16);
+          break;
+        default:
+          ((gint32 *) outdata)[frame_out + out] =
+              CLAMP (outval, G_MININT32, G_MAXINT32);
+          break;
+      }
+    }
+    self->ramp_pos++;
+  }
+}
+
 static GstFlowReturn
 gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     GstBuffer * inbuf, GstBuffer * outbuf)
 {
   GstMapInfo inmap, outmap;
   GstAudioMixMatrix *self = GST_AUDIO_MIX_MATRIX (vfilter);
-  gint in, out, sample;
-  guint inchannels = self->in_channels;
-  guint outchannels = self->out_channels;
-  gdouble *matrix = self->matrix;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint8 *indata, *outdata;
+  guint n_samples, n_ramp, bps;
 
   if (!gst_buffer_map (inbuf, &inmap, GST_MAP_READ)) {
     return GST_FLOW_ERROR;
@@ -429,107 +989,80 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     return GST_FLOW_ERROR;
   }
 
+  GST_OBJECT_LOCK (self);
+  if (self->sparse_start == NULL) {
+    GST_OBJECT_UNLOCK (self);
+    GST_ELEMENT_ERROR (self, CORE, NEGOTIATION, (NULL),
+        ("No matrix for the negotiated channels"));
+    ret = GST_FLOW_NOT_NEGOTIATED;
+    goto done;
+  }
+
   switch (self->format) {
     case GST_AUDIO_FORMAT_F32LE:
-    case GST_AUDIO_FORMAT_F32BE:{
-      const gfloat *inarray;
-      gfloat *outarray;
-      guint n_samples = outmap.size / (sizeof (gfloat) * outchannels);
-
-      inarray = (gfloat *) inmap.data;
-      outarray = (gfloat *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gfloat outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
+    case GST_AUDIO_FORMAT_F32BE:
+      bps = sizeof (gfloat);
       break;
-    }
     case GST_AUDIO_FORMAT_F64LE:
-    case GST_AUDIO_FORMAT_F64BE:{
-      const gdouble *inarray;
-      gdouble *outarray;
-      guint n_samples = outmap.size / (sizeof (gdouble) * outchannels);
-
-      inarray = (gdouble *) inmap.data;
-      outarray = (gdouble *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gdouble outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
+    case GST_AUDIO_FORMAT_F64BE:
+      bps = sizeof (gdouble);
       break;
-    }
     case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      const gint16 *inarray;
-      gint16 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint16) * outchannels);
-      guint n = self->shift_bytes;
-      gint32 *conv_matrix = self->s16_conv_matrix;
-
-      inarray = (gint16 *) inmap.data;
-      outarray = (gint16 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint32 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint32) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint16) (outval >> n);
-        }
-      }
+    case GST_AUDIO_FORMAT_S16BE:
+      bps = sizeof (gint16);
       break;
-    }
     case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      const gint32 *inarray;
-      gint32 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint32) * outchannels);
-      guint n = self->shift_bytes;
-      gint64 *conv_matrix = self->s32_conv_matrix;
-
-      inarray = (gint32 *) inmap.data;
-      outarray = (gint32 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint64 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint64) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint32) (outval >> n);
-        }
-      }
+    case GST_AUDIO_FORMAT_S32BE:
+      bps = sizeof (gint32);
       break;
-    }
     default:
-      gst_buffer_unmap (inbuf, &inmap);
-      gst_buffer_unmap (outbuf, &outmap);
-      return GST_FLOW_NOT_SUPPORTED;
+      GST_OBJECT_UNLOCK (self);
+      ret = GST_FLOW_NOT_SUPPORTED;
+      goto done;
+  }
+
+  indata = inmap.data;
+  outdata = outmap.data;
+  n_samples = outmap.size / (bps * self->out_channels);
 
+  if (self->ramp_matrix) {
+    n_ramp = MIN (n_samples, self->ramp_length - self->ramp_pos);
+    gst_audio_mix_matrix_mix_ramp (self, indata, outdata, n_ramp);
+    if (self->ramp_pos >= self->ramp_length)
+      gst_audio_mix_matrix_clear_ramp (self);
+
+    indata += n_ramp * bps * self->in_channels;
+    outdata += n_ramp * bps * self->out_channels;
+    n_samples -= n_ramp;
   }
 
+  switch (self->format) {
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:
+      gst_audio_mix_matrix_mix_f32 (self, (const gfloat *) indata,
+          (gfloat *) outdata, n_samples);
+      break;
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:
+      gst_audio_mix_matrix_mix_f64 (self, (const gdouble *) indata,
+          (gdouble *) outdata, n_samples);
+      break;
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:
+      gst_audio_mix_matrix_mix_s16 (self, (const gint16 *) indata,
+          (gint16 *) outdata, n_samples);
+      break;
+    default:
+      gst_audio_mix_matrix_mix_s32 (self, (const gint32 *) indata,
+          (gint32 *) outdata, n_samples);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+done:
   gst_buffer_unmap (inbuf, &inmap);
   gst_buffer_unmap (outbuf, &outmap);
-  return GST_FLOW_OK;
+  return ret;
 }
 
 static gboolean
@@ -559,7 +1092,10 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
   if (!gst_audio_info_from_caps (&out_info, outcaps))
     return FALSE;
 
+  GST_OBJECT_LOCK (self);
   self->format = info.finfo->format;
+  self->rate = info.rate;
+  gst_audio_mix_matrix_clear_ramp (self);
 
   if (self->mode == GST_AUDIO_MIX_MATRIX_MODE_FIRST_CHANNELS) {
     gint in, out;
@@ -567,6 +1103,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     self->in_channels = info.channels;
     self->out_channels = out_info.channels;
 
+    g_free (self->matrix);
     self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
 
     for (out = 0; out < self->out_channels; out++) {
@@ -576,26 +1113,16 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     }
   } else if (!self->matrix || info.channels != self->in_channels ||
       out_info.channels != self->out_channels) {
+    GST_OBJECT_UNLOCK (self);
     GST_ELEMENT_ERROR (self, LIBRARY, SETTINGS,
         ("Erroneous matrix detected"),
         ("Please enter a matrix with the correct input and output channels"));
     return FALSE;
   }
 
-  switch (self->format) {
-    case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      gst_audio_mix_matrix_convert_s16_matrix (self);
-      break;
-    }
-    case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      gst_audio_mix_matrix_convert_s32_matrix (self);
-      break;
-    }
-    default:
-      break;
-  }
+  gst_audio_mix_matrix_update_kernels (self);
+  GST_OBJECT_UNLOCK (self);
+
   return TRUE;
 }
 
@@ -61,8 +61,29 @@ struct _GstAudioMixMatrix
   gint32 *s16_conv_matrix;
   gint64 *s32_conv_matrix;
   gint shift_bytes;
+  GstClockTime ramp_time;
 
   GstAudioFormat format;
+  gint rate;
+
+  /* input channels of the nonzero coefficients of each output channel,
+   * those of output channel i start at sparse_in[sparse_start[i]] */
+  guint *sparse_in;
+  guint *sparse_start;
+  gboolean sparse;
+
+  /* coefficients of the format transposed to one row per input channel,
+   * padded to a multiple of 4 output channels. For S16 the rows of two
+   * input channels are interleaved, NULL if they don't fit 16 bits. */
+  gpointer dense_matrix;
+
+  /* the coefficients are being interpolated from ramp_matrix to matrix,
+   * going through the nonzero coefficients of either */
+  gdouble *ramp_matrix;
+  guint ramp_pos;
+  guint ramp_length;
+  guint *ramp_in;
+  guint *ramp_start;
 };
 
 struct _GstAudioMixMatrixClass
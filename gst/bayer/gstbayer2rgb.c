@@ -26,6 +26,12 @@
  * @title: bayer2rgb
  *
  * Decodes raw camera bayer (fourcc BA81) to RGB.
+ *
+ * Besides the packed RGB formats, the decoded frames can be written directly
+ * as I420 or NV12, which converts each pair of rows while they are still in
+ * the cache instead of needing another pass over the whole frame. Bayer
+ * input with 10, 12 or 16 bits per sample is reduced to 8 bits one row at a
+ * time before the interpolation.
  */
 
 /*
@@ -81,6 +87,7 @@
 #include <gst/video/video.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 
 #ifdef HAVE_STDINT_H
 #include <stdint.h>
@@ -88,6 +95,10 @@
 
 #include "gstbayerorc.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define GST_CAT_DEFAULT gst_bayer2rgb_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
@@ -123,6 +134,22 @@ struct _GstBayer2RGB
   int g_off;                    /* offset for green */
   int b_off;                    /* offset for blue */
   int format;
+  int bits;                     /* bits per input sample */
+  gboolean big_endian;          /* byte order of > 8 bit samples */
+  gboolean yuv;                 /* I420 or NV12 output */
+
+  /* 16.16 fixed point RGB to YUV coefficients of the output colorimetry,
+   * the chroma ones applying to the sum of 2x2 pixels */
+  int y_coeffs[3], u_coeffs[3], v_coeffs[3];
+  int y_offset;
+
+  /* properties */
+  guint n_threads;
+
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  gint pending;
 };
 
 struct _GstBayer2RGBClass
@@ -131,14 +158,23 @@ struct _GstBayer2RGBClass
 };
 
 #define	SRC_CAPS                                 \
-  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR }")
+  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR, " \
+      "I420, NV12 }")
 
-#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb}," \
+#define BAYER_FORMATS(p) \
+  p "," p "10le," p "10be," p "12le," p "12be," p "16le," p "16be"
+
+#define SINK_CAPS "video/x-bayer,format=(string){" BAYER_FORMATS ("bggr") "," \
+  BAYER_FORMATS ("grbg") "," BAYER_FORMATS ("gbrg") "," \
+  BAYER_FORMATS ("rggb") "}," \
   "width=(int)[1,MAX],height=(int)[1,MAX],framerate=(fraction)[0/1,MAX]"
 
+#define DEFAULT_N_THREADS 1
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_N_THREADS
 };
 
 GType gst_bayer2rgb_get_type (void);
@@ -150,6 +186,7 @@ static void gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static void gst_bayer2rgb_finalize (GObject * object);
 
 static gboolean gst_bayer2rgb_set_caps (GstBaseTransform * filter,
     GstCaps * incaps, GstCaps * outcaps);
@@ -173,6 +210,7 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 
   gobject_class->set_property = gst_bayer2rgb_set_property;
   gobject_class->get_property = gst_bayer2rgb_get_property;
+  gobject_class->finalize = gst_bayer2rgb_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Bayer to RGB decoder for cameras", "Filter/Converter/Video",
@@ -195,6 +233,18 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
   GST_BASE_TRANSFORM_CLASS (klass)->transform =
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_transform);
 
+  /**
+   * GstBayer2RGB:n-threads:
+   *
+   * Number of threads decoding horizontal stripes of each frame, 0 for one
+   * per processor.
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads processing each frame (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (gst_bayer2rgb_debug, "bayer2rgb", 0,
       "bayer2rgb element");
 }
@@ -202,17 +252,39 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 static void
 gst_bayer2rgb_init (GstBayer2RGB * filter)
 {
+  filter->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&filter->lock);
+  g_cond_init (&filter->cond);
+
   gst_bayer2rgb_reset (filter);
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (filter), TRUE);
 }
 
-/* No properties are implemented, so only a warning is produced */
+static void
+gst_bayer2rgb_finalize (GObject * object)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
+
+  if (filter->pool)
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+  g_mutex_clear (&filter->lock);
+  g_cond_clear (&filter->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -223,14 +295,89 @@ static void
 gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* Parses a bayer format like "bggr" or "rggb12le" */
+static gboolean
+gst_bayer2rgb_parse_format (const char *format, int *pattern, int *bits,
+    gboolean * big_endian)
+{
+  static const char *patterns[] = { "bggr", "gbrg", "grbg", "rggb" };
+  guint i;
+
+  if (format == NULL || strlen (format) < 4)
+    return FALSE;
+
+  /* the order of the patterns is the one of the enum */
+  for (i = 0; i < G_N_ELEMENTS (patterns); i++)
+    if (strncmp (format, patterns[i], 4) == 0)
+      break;
+  if (i == G_N_ELEMENTS (patterns))
+    return FALSE;
+  *pattern = GST_BAYER_2_RGB_FORMAT_BGGR + i;
+
+  format += 4;
+  if (*format == '\0') {
+    *bits = 8;
+    *big_endian = FALSE;
+  } else if (g_str_equal (format, "10le") || g_str_equal (format, "10be")
+      || g_str_equal (format, "12le") || g_str_equal (format, "12be")
+      || g_str_equal (format, "16le") || g_str_equal (format, "16be")) {
+    *bits = atoi (format);
+    *big_endian = format[2] == 'b';
+  } else {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Sets up the fixed point conversion to the YUV colorimetry of @info */
+static void
+gst_bayer2rgb_setup_yuv (GstBayer2RGB * bayer2rgb, GstVideoInfo * info)
+{
+  gdouble Kr, Kb, Kg;
+  gint offset[GST_VIDEO_MAX_COMPONENTS], scale[GST_VIDEO_MAX_COMPONENTS];
+  gdouble ys, us, vs;
+
+  if (!gst_video_color_matrix_get_Kr_Kb (info->colorimetry.matrix, &Kr, &Kb)) {
+    Kr = 0.299;
+    Kb = 0.114;
+  }
+  Kg = 1.0 - Kr - Kb;
+
+  gst_video_color_range_offsets (info->colorimetry.range, info->finfo,
+      offset, scale);
+
+  ys = 65536.0 * scale[0] / 255.0;
+  /* the chroma is computed from the sum of 4 pixels */
+  us = 65536.0 * scale[1] / 255.0 / (2.0 * (1.0 - Kb)) / 4.0;
+  vs = 65536.0 * scale[2] / 255.0 / (2.0 * (1.0 - Kr)) / 4.0;
+
+  bayer2rgb->y_coeffs[0] = (int) floor (ys * Kr + 0.5);
+  bayer2rgb->y_coeffs[1] = (int) floor (ys * Kg + 0.5);
+  bayer2rgb->y_coeffs[2] = (int) floor (ys * Kb + 0.5);
+  bayer2rgb->u_coeffs[0] = (int) floor (-us * Kr + 0.5);
+  bayer2rgb->u_coeffs[1] = (int) floor (-us * Kg + 0.5);
+  bayer2rgb->u_coeffs[2] = (int) floor (us * (1.0 - Kb) + 0.5);
+  bayer2rgb->v_coeffs[0] = (int) floor (vs * (1.0 - Kr) + 0.5);
+  bayer2rgb->v_coeffs[1] = (int) floor (-vs * Kg + 0.5);
+  bayer2rgb->v_coeffs[2] = (int) floor (-vs * Kb + 0.5);
+  bayer2rgb->y_offset = offset[0];
+}
+
 static gboolean
 gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
     GstCaps * outcaps)
@@ -249,23 +396,27 @@ gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
   gst_structure_get_int (structure, "height", &bayer2rgb->height);
 
   format = gst_structure_get_string (structure, "format");
-  if (g_str_equal (format, "bggr")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_BGGR;
-  } else if (g_str_equal (format, "gbrg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GBRG;
-  } else if (g_str_equal (format, "grbg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GRBG;
-  } else if (g_str_equal (format, "rggb")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_RGGB;
-  } else {
+  if (!gst_bayer2rgb_parse_format (format, &bayer2rgb->format,
+          &bayer2rgb->bits, &bayer2rgb->big_endian))
     return FALSE;
-  }
 
   /* To cater for different RGB formats, we need to set params for later */
-  gst_video_info_from_caps (&info, outcaps);
-  bayer2rgb->r_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 0);
-  bayer2rgb->g_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 1);
-  bayer2rgb->b_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 2);
+  if (!gst_video_info_from_caps (&info, outcaps))
+    return FALSE;
+
+  if (GST_VIDEO_INFO_IS_YUV (&info)) {
+    /* the rows are interpolated into BGRA before converting them */
+    bayer2rgb->yuv = TRUE;
+    bayer2rgb->r_off = 2;
+    bayer2rgb->g_off = 1;
+    bayer2rgb->b_off = 0;
+    gst_bayer2rgb_setup_yuv (bayer2rgb, &info);
+  } else {
+    bayer2rgb->yuv = FALSE;
+    bayer2rgb->r_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 0);
+    bayer2rgb->g_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 1);
+    bayer2rgb->b_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 2);
+  }
 
   bayer2rgb->info = info;
 
@@ -280,6 +431,9 @@ gst_bayer2rgb_reset (GstBayer2RGB * filter)
   filter->r_off = 0;
   filter->g_off = 0;
   filter->b_off = 0;
+  filter->bits = 8;
+  filter->big_endian = FALSE;
+  filter->yuv = FALSE;
   gst_video_info_init (&filter->info);
 }
 
@@ -334,12 +488,21 @@ gst_bayer2rgb_get_unit_size (GstBaseTransform * base, GstCaps * caps,
     name = gst_structure_get_name (structure);
     /* Our name must be either video/x-bayer video/x-raw */
     if (strcmp (name, "video/x-raw")) {
-      *size = GST_ROUND_UP_4 (width) * height;
+      int pattern, bits = 8;
+      gboolean big_endian;
+
+      gst_bayer2rgb_parse_format (gst_structure_get_string (structure,
+              "format"), &pattern, &bits, &big_endian);
+      *size = GST_ROUND_UP_4 (width * (bits > 8 ? 2 : 1)) * height;
       return TRUE;
     } else {
-      /* For output, calculate according to format (always 32 bits) */
-      *size = width * height * 4;
-      return TRUE;
+      GstVideoInfo info;
+
+      /* For output, calculate according to format */
+      if (gst_video_info_from_caps (&info, caps)) {
+        *size = GST_VIDEO_INFO_SIZE (&info);
+        return TRUE;
+      }
     }
 
   }
@@ -377,16 +540,97 @@ gst_bayer2rgb_split_and_upsample_horiz (guint8 * dest0, guint8 * dest1,
   }
 }
 
+/* Reduces a row of > 8 bit samples to their 8 most significant bits */
+static void
+gst_bayer2rgb_reduce_row (guint8 * dest, const guint8 * src, int n,
+    int bits, gboolean big_endian)
+{
+  int shift = bits - 8;
+  int i = 0;
+
+#if defined(__SSE2__)
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (src + i * 2));
+
+    if (big_endian)
+      v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+    v = _mm_srl_epi16 (v, _mm_cvtsi32_si128 (shift));
+    _mm_storel_epi64 ((__m128i *) (dest + i), _mm_packus_epi16 (v, v));
+  }
+#endif
+
+  for (; i < n; i++) {
+    guint v = big_endian ? GST_READ_UINT16_BE (src + i * 2) :
+        GST_READ_UINT16_LE (src + i * 2);
+
+    dest[i] = MIN (v >> shift, 255);
+  }
+}
+
+/* Converts two rows of BGRA into I420 or NV12, @y1 being NULL for the
+ * last row of frames with an odd height */
+static void
+gst_bayer2rgb_convert_yuv (GstBayer2RGB * bayer2rgb, guint8 * y0, guint8 * y1,
+    guint8 * u, guint8 * v, int uv_pstride, const guint8 * rgb0,
+    const guint8 * rgb1, int width)
+{
+  const int *yc = bayer2rgb->y_coeffs;
+  const int *uc = bayer2rgb->u_coeffs;
+  const int *vc = bayer2rgb->v_coeffs;
+  int y_offset = (bayer2rgb->y_offset << 16) + (1 << 15);
+  int i, x;
+
+  for (i = 0; i < width; i++) {
+    const guint8 *p0 = rgb0 + i * 4;
+    const guint8 *p1 = rgb1 + i * 4;
+
+    y0[i] = CLAMP ((yc[0] * p0[2] + yc[1] * p0[1] + yc[2] * p0[0] +
+            y_offset) >> 16, 0, 255);
+    if (y1)
+      y1[i] = CLAMP ((yc[0] * p1[2] + yc[1] * p1[1] + yc[2] * p1[0] +
+              y_offset) >> 16, 0, 255);
+  }
+
+  for (x = 0; x < (width + 1) / 2; x++) {
+    const guint8 *p0 = rgb0 + x * 8;
+    const guint8 *p1 = rgb1 + x * 8;
+    /* the right column of an odd width is the left one again */
+    int dx = (x * 2 + 1 < width) ? 4 : 0;
+    int r = p0[2] + p0[2 + dx] + p1[2] + p1[2 + dx];
+    int g = p0[1] + p0[1 + dx] + p1[1] + p1[1 + dx];
+    int b = p0[0] + p0[0 + dx] + p1[0] + p1[0 + dx];
+
+    u[x * uv_pstride] = CLAMP (((uc[0] * r + uc[1] * g + uc[2] * b +
+                (1 << 15)) >> 16) + 128, 0, 255);
+    v[x * uv_pstride] = CLAMP (((vc[0] * r + vc[1] * g + vc[2] * b +
+                (1 << 15)) >> 16) + 128, 0, 255);
+  }
+}
+
 typedef void (*process_func) (guint8 * d0, const guint8 * s0, const guint8 * s1,
     const guint8 * s2, const guint8 * s3, const guint8 * s4, const guint8 * s5,
     int n);
 
+/* The rows [y_start, y_end) of a frame one thread decodes, y_start being
+ * even for the YUV outputs */
+typedef struct
+{
+  GstBayer2RGB *bayer2rgb;
+  GstVideoFrame *frame;
+  const guint8 *src;
+  int src_stride;
+  int y_start, y_end;
+} GstBayer2RGBStripe;
+
 static void
-gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
-    int dest_stride, uint8_t * src, int src_stride)
+gst_bayer2rgb_process (GstBayer2RGBStripe * stripe)
 {
+  GstBayer2RGB *bayer2rgb = stripe->bayer2rgb;
+  GstVideoFrame *frame = stripe->frame;
+  int width = bayer2rgb->width;
+  int height = bayer2rgb->height;
   int j;
-  guint8 *tmp;
+  guint8 *tmp, *rgb = NULL, *row = NULL;
   process_func merge[2] = { NULL, NULL };
   int r_off, g_off, b_off;
 
@@ -423,32 +667,98 @@ gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
     merge[1] = tmp;
   }
 
-  tmp = g_malloc (2 * 4 * bayer2rgb->width);
-#define LINE(x) (tmp + ((x)&7) * bayer2rgb->width)
-
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (3 * 2 + 0), LINE (3 * 2 + 1),
-      src + 1 * src_stride, bayer2rgb->width);
-  j = 0;
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
-      src + j * src_stride, bayer2rgb->width);
-
-  for (j = 0; j < bayer2rgb->height; j++) {
-    if (j < bayer2rgb->height - 1) {
-      gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
-          LINE ((j + 1) * 2 + 1), src + (j + 1) * src_stride, bayer2rgb->width);
-    }
-
-    merge[j & 1] (dest + j * dest_stride,
+  tmp = g_malloc (2 * 4 * width);
+  /* two interpolated rows waiting for their conversion to YUV */
+  if (bayer2rgb->yuv)
+    rgb = g_malloc0 (2 * 4 * width);
+  if (bayer2rgb->bits > 8)
+    row = g_malloc (width);
+
+#define LINE(x) (tmp + ((x)&7) * width)
+  /* the rows above and below the frame are mirrored, like row -1 always
+   * was row 1 */
+#define UPSAMPLE(y) G_STMT_START { \
+    int r = (y) < 0 ? MIN (1, height - 1) : \
+        (y) >= height ? MAX (height - 2, 0) : (y); \
+    const guint8 *s = stripe->src + r * stripe->src_stride; \
+    if (row) { \
+      gst_bayer2rgb_reduce_row (row, s, width, bayer2rgb->bits, \
+          bayer2rgb->big_endian); \
+      s = row; \
+    } \
+    gst_bayer2rgb_split_and_upsample_horiz (LINE ((y) * 2 + 0), \
+        LINE ((y) * 2 + 1), s, width); \
+  } G_STMT_END
+
+  UPSAMPLE (stripe->y_start - 1);
+  UPSAMPLE (stripe->y_start);
+
+  for (j = stripe->y_start; j < stripe->y_end; j++) {
+    guint8 *dest;
+
+    UPSAMPLE (j + 1);
+
+    if (rgb)
+      dest = rgb + (j & 1) * 4 * width;
+    else
+      dest = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0) +
+          j * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+
+    merge[j & 1] (dest,
         LINE (j * 2 - 2), LINE (j * 2 - 1),
         LINE (j * 2 + 0), LINE (j * 2 + 1),
-        LINE (j * 2 + 2), LINE (j * 2 + 3), bayer2rgb->width >> 1);
+        LINE (j * 2 + 2), LINE (j * 2 + 3), width >> 1);
+
+    if (rgb && ((j & 1) || j == height - 1)) {
+      int y = j & ~1;
+      guint8 *y0 = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0) +
+          y * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+      guint8 *u, *v;
+      int uv_pstride;
+
+      if (GST_VIDEO_FRAME_FORMAT (frame) == GST_VIDEO_FORMAT_NV12) {
+        u = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 1) +
+            (y / 2) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
+        v = u + 1;
+        uv_pstride = 2;
+      } else {
+        u = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 1) +
+            (y / 2) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
+        v = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 2) +
+            (y / 2) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 2);
+        uv_pstride = 1;
+      }
+
+      if (j & 1)
+        gst_bayer2rgb_convert_yuv (bayer2rgb, y0,
+            y0 + GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0), u, v, uv_pstride,
+            rgb, rgb + 4 * width, width);
+      else
+        gst_bayer2rgb_convert_yuv (bayer2rgb, y0, NULL, u, v, uv_pstride,
+            rgb, rgb, width);
+    }
   }
+#undef UPSAMPLE
+#undef LINE
 
+  g_free (row);
+  g_free (rgb);
   g_free (tmp);
 }
 
+static void
+gst_bayer2rgb_worker_func (gpointer data, gpointer user_data)
+{
+  GstBayer2RGBStripe *stripe = data;
+  GstBayer2RGB *bayer2rgb = stripe->bayer2rgb;
 
+  gst_bayer2rgb_process (stripe);
 
+  g_mutex_lock (&bayer2rgb->lock);
+  if (--bayer2rgb->pending == 0)
+    g_cond_signal (&bayer2rgb->cond);
+  g_mutex_unlock (&bayer2rgb->lock);
+}
 
 static GstFlowReturn
 gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
@@ -456,8 +766,10 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
 {
   GstBayer2RGB *filter = GST_BAYER2RGB (base);
   GstMapInfo map;
-  uint8_t *output;
   GstVideoFrame frame;
+  GstBayer2RGBStripe *stripes;
+  guint n_threads;
+  int n_stripes, src_stride, i;
 
   GST_DEBUG ("transforming buffer");
 
@@ -469,9 +781,51 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
     goto map_failed;
   }
 
-  output = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
-  gst_bayer2rgb_process (filter, output, frame.info.stride[0],
-      map.data, GST_ROUND_UP_4 (filter->width));
+  GST_OBJECT_LOCK (filter);
+  n_threads = filter->n_threads;
+  GST_OBJECT_UNLOCK (filter);
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  /* the YUV outputs are converted in pairs of rows */
+  n_stripes = CLAMP ((int) MIN (n_threads, G_MAXINT), 1,
+      MAX ((filter->height + 1) / 2, 1));
+
+  src_stride = GST_ROUND_UP_4 (filter->width * (filter->bits > 8 ? 2 : 1));
+
+  stripes = g_new (GstBayer2RGBStripe, n_stripes);
+  for (i = 0; i < n_stripes; i++) {
+    stripes[i].bayer2rgb = filter;
+    stripes[i].frame = &frame;
+    stripes[i].src = map.data;
+    stripes[i].src_stride = src_stride;
+    stripes[i].y_start = (filter->height * i / n_stripes) & ~1;
+    stripes[i].y_end = (filter->height * (i + 1) / n_stripes) & ~1;
+  }
+  stripes[n_stripes - 1].y_end = filter->height;
+
+  if (n_stripes > 1) {
+    if (!filter->pool) {
+      filter->pool = g_thread_pool_new (gst_bayer2rgb_worker_func, NULL,
+          n_stripes - 1, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (filter->pool) < n_stripes - 1) {
+      g_thread_pool_set_max_threads (filter->pool, n_stripes - 1, NULL);
+    }
+
+    filter->pending = n_stripes - 1;
+    for (i = 1; i < n_stripes; i++)
+      g_thread_pool_push (filter->pool, &stripes[i], NULL);
+  }
+
+  gst_bayer2rgb_process (&stripes[0]);
+
+  if (n_stripes > 1) {
+    g_mutex_lock (&filter->lock);
+    while (filter->pending > 0)
+      g_cond_wait (&filter->cond, &filter->lock);
+    g_mutex_unlock (&filter->lock);
+  }
+
+  g_free (stripes);
 
   gst_video_frame_unmap (&frame);
   gst_buffer_unmap (inbuf, &map);
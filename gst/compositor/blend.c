@@ -964,6 +964,162 @@ PACKED_422_FILL_COLOR (yuy2, 24, 16, 8, 0);
 PACKED_422_FILL_COLOR (yvyu, 24, 0, 8, 16);
 PACKED_422_FILL_COLOR (uyvy, 16, 24, 0, 8);
 
+/* Bilinear scaling fused with blending, for pads whose size differs from
+ * their input. Every output pixel is interpolated from the input and blended
+ * into the destination right away, without an intermediate scaled frame. */
+
+/* Position of the center of output sample @i in the input, in 8.8 fixed
+ * point, split into the integer sample and the fraction */
+static inline void
+_scale_pos (gint i, gint src_size, gint dest_size, gint * pos, guint * frac)
+{
+  gint64 p;
+
+  p = ((gint64) (2 * i + 1) * src_size * 256) / (2 * dest_size) - 128;
+  if (p < 0)
+    p = 0;
+
+  *pos = p >> 8;
+  *frac = p & 0xff;
+  if (*pos >= src_size - 1) {
+    *pos = src_size - 1;
+    *frac = 0;
+  }
+}
+
+/* Scales a @src_width x @src_height plane to @width x @height and blends it
+ * at @xpos, @ypos into @dest. Pixels are @pstride bytes apart and the first
+ * @n_channels of them are interpolated. If @alpha_channel is not -1, the
+ * plane has an alpha channel that is combined with @s_alpha. */
+static void
+_scale_blend_plane (const guint8 * src, gint src_stride, gint src_width,
+    gint src_height, guint8 * dest, gint dest_stride, gint dest_width,
+    gint dest_height, gint xpos, gint ypos, gint width, gint height,
+    gint pstride, gint n_channels, gint alpha_channel, guint s_alpha)
+{
+  gint x_start = MAX (xpos, 0), x_end = MIN (xpos + width, dest_width);
+  gint y_start = MAX (ypos, 0), y_end = MIN (ypos + height, dest_height);
+  gint *x_pos;
+  guint *x_frac;
+  gint i, j, k;
+
+  if (x_start >= x_end || y_start >= y_end || src_width <= 0
+      || src_height <= 0)
+    return;
+
+  x_pos = g_new (gint, x_end - x_start);
+  x_frac = g_new (guint, x_end - x_start);
+  for (i = x_start; i < x_end; i++)
+    _scale_pos (i - xpos, src_width, width, &x_pos[i - x_start],
+        &x_frac[i - x_start]);
+
+  for (j = y_start; j < y_end; j++) {
+    const guint8 *s0, *s1;
+    guint8 *d = dest + j * dest_stride + x_start * pstride;
+    gint y_pos;
+    guint y_frac;
+
+    _scale_pos (j - ypos, src_height, height, &y_pos, &y_frac);
+    s0 = src + y_pos * src_stride;
+    s1 = src + MIN (y_pos + 1, src_height - 1) * src_stride;
+
+    for (i = 0; i < x_end - x_start; i++, d += pstride) {
+      gint l = x_pos[i] * pstride;
+      gint r = MIN (x_pos[i] + 1, src_width - 1) * pstride;
+      guint xf = x_frac[i];
+      guint p[4];
+      guint a;
+
+      for (k = 0; k < n_channels; k++) {
+        guint top = s0[l + k] * (256 - xf) + s0[r + k] * xf;
+        guint bottom = s1[l + k] * (256 - xf) + s1[r + k] * xf;
+
+        p[k] = (top * (256 - y_frac) + bottom * y_frac + 32768) >> 16;
+      }
+
+      if (alpha_channel < 0) {
+        for (k = 0; k < n_channels; k++)
+          d[k] = (p[k] * s_alpha + d[k] * (256 - s_alpha)) >> 8;
+      } else {
+        a = (p[alpha_channel] * s_alpha) >> 8;
+        for (k = 0; k < n_channels; k++) {
+          if (k == alpha_channel)
+            d[k] = 0xff;
+          else
+            d[k] = (p[k] * a + d[k] * (255 - a)) / 255;
+        }
+      }
+    }
+  }
+
+  g_free (x_pos);
+  g_free (x_frac);
+}
+
+#define SCALE_BLEND_A32(name, A) \
+static void \
+scale_blend_##name (GstVideoFrame * srcframe, gint xpos, gint ypos, \
+    gint width, gint height, gdouble src_alpha, GstVideoFrame * destframe) \
+{ \
+  guint s_alpha = CLAMP ((gint) (src_alpha * 256), 0, 256); \
+  \
+  if (G_UNLIKELY (s_alpha == 0)) \
+    return; \
+  \
+  _scale_blend_plane (GST_VIDEO_FRAME_PLANE_DATA (srcframe, 0), \
+      GST_VIDEO_FRAME_PLANE_STRIDE (srcframe, 0), \
+      GST_VIDEO_FRAME_WIDTH (srcframe), GST_VIDEO_FRAME_HEIGHT (srcframe), \
+      GST_VIDEO_FRAME_PLANE_DATA (destframe, 0), \
+      GST_VIDEO_FRAME_PLANE_STRIDE (destframe, 0), \
+      GST_VIDEO_FRAME_WIDTH (destframe), GST_VIDEO_FRAME_HEIGHT (destframe), \
+      xpos, ypos, width, height, 4, 4, A, s_alpha); \
+}
+
+SCALE_BLEND_A32 (argb, 0);
+SCALE_BLEND_A32 (bgra, 3);
+
+/* Y444, Y42B, I420, YV12, and NV12, NV21 where the chroma plane is blended as
+ * one plane with two channels */
+static void
+scale_blend_yuv (GstVideoFrame * srcframe, gint xpos, gint ypos,
+    gint width, gint height, gdouble src_alpha, GstVideoFrame * destframe)
+{
+  const GstVideoFormatInfo *info = destframe->info.finfo;
+  guint s_alpha = CLAMP ((gint) (src_alpha * 256), 0, 256);
+  gint plane, comp;
+
+  if (G_UNLIKELY (s_alpha == 0))
+    return;
+
+  /* like the unscaled blend functions, keep the chroma sited */
+  xpos = GST_ROUND_UP_N (xpos, 1 << GST_VIDEO_FORMAT_INFO_W_SUB (info, 1));
+  ypos = GST_ROUND_UP_N (ypos, 1 << GST_VIDEO_FORMAT_INFO_H_SUB (info, 1));
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (destframe); plane++) {
+    gint pstride;
+
+    for (comp = 0; comp < GST_VIDEO_FRAME_N_COMPONENTS (destframe); comp++) {
+      if (GST_VIDEO_FORMAT_INFO_PLANE (info, comp) == plane)
+        break;
+    }
+    pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (destframe, comp);
+
+    _scale_blend_plane (GST_VIDEO_FRAME_PLANE_DATA (srcframe, plane),
+        GST_VIDEO_FRAME_PLANE_STRIDE (srcframe, plane),
+        GST_VIDEO_FRAME_COMP_WIDTH (srcframe, comp),
+        GST_VIDEO_FRAME_COMP_HEIGHT (srcframe, comp),
+        GST_VIDEO_FRAME_PLANE_DATA (destframe, plane),
+        GST_VIDEO_FRAME_PLANE_STRIDE (destframe, plane),
+        GST_VIDEO_FRAME_COMP_WIDTH (destframe, comp),
+        GST_VIDEO_FRAME_COMP_HEIGHT (destframe, comp),
+        GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (info, comp, xpos),
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (info, comp, ypos),
+        GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (info, comp, width),
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (info, comp, height),
+        pstride, pstride, -1, s_alpha);
+  }
+}
+
 /* Init function */
 BlendFunction gst_compositor_blend_argb;
 BlendFunction gst_compositor_blend_bgra;
@@ -984,6 +1140,11 @@ BlendFunction gst_compositor_blend_rgbx;
 BlendFunction gst_compositor_blend_yuy2;
 /* YVYU and UYVY are equal to YUY2 */
 
+ScaleBlendFunction gst_compositor_scale_blend_argb;
+ScaleBlendFunction gst_compositor_scale_blend_bgra;
+/* AYUV/ABGR is equal to ARGB, RGBA is equal to BGRA */
+ScaleBlendFunction gst_compositor_scale_blend_yuv;
+
 FillCheckerFunction gst_compositor_fill_checker_argb;
 FillCheckerFunction gst_compositor_fill_checker_bgra;
 /* ABGR is equal to ARGB, RGBA is equal to BGRA */
@@ -1045,6 +1206,10 @@ gst_compositor_init_blend (void)
   gst_compositor_blend_xrgb = GST_DEBUG_FUNCPTR (blend_xrgb);
   gst_compositor_blend_yuy2 = GST_DEBUG_FUNCPTR (blend_yuy2);
 
+  gst_compositor_scale_blend_argb = GST_DEBUG_FUNCPTR (scale_blend_argb);
+  gst_compositor_scale_blend_bgra = GST_DEBUG_FUNCPTR (scale_blend_bgra);
+  gst_compositor_scale_blend_yuv = GST_DEBUG_FUNCPTR (scale_blend_yuv);
+
   gst_compositor_fill_checker_argb = GST_DEBUG_FUNCPTR (fill_checker_argb_c);
   gst_compositor_fill_checker_bgra = GST_DEBUG_FUNCPTR (fill_checker_bgra_c);
   gst_compositor_fill_checker_ayuv = GST_DEBUG_FUNCPTR (fill_checker_ayuv_c);
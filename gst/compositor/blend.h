@@ -38,6 +38,8 @@ typedef enum
 
 typedef void (*BlendFunction) (GstVideoFrame *srcframe, gint xpos, gint ypos, gdouble src_alpha, GstVideoFrame * destframe,
     GstCompositorBlendMode mode);
+typedef void (*ScaleBlendFunction) (GstVideoFrame *srcframe, gint xpos, gint ypos, gint width, gint height,
+    gdouble src_alpha, GstVideoFrame * destframe);
 typedef void (*FillCheckerFunction) (GstVideoFrame * frame);
 typedef void (*FillColorFunction) (GstVideoFrame * frame, gint c1, gint c2, gint c3);
 
@@ -74,6 +76,19 @@ extern BlendFunction gst_compositor_blend_yuy2;
 #define gst_compositor_blend_uyvy gst_compositor_blend_yuy2;
 #define gst_compositor_blend_yvyu gst_compositor_blend_yuy2;
 
+extern ScaleBlendFunction gst_compositor_scale_blend_argb;
+extern ScaleBlendFunction gst_compositor_scale_blend_bgra;
+#define gst_compositor_scale_blend_ayuv gst_compositor_scale_blend_argb
+#define gst_compositor_scale_blend_abgr gst_compositor_scale_blend_argb
+#define gst_compositor_scale_blend_rgba gst_compositor_scale_blend_bgra
+extern ScaleBlendFunction gst_compositor_scale_blend_yuv;
+#define gst_compositor_scale_blend_i420 gst_compositor_scale_blend_yuv
+#define gst_compositor_scale_blend_yv12 gst_compositor_scale_blend_yuv
+#define gst_compositor_scale_blend_nv12 gst_compositor_scale_blend_yuv
+#define gst_compositor_scale_blend_nv21 gst_compositor_scale_blend_yuv
+#define gst_compositor_scale_blend_y444 gst_compositor_scale_blend_yuv
+#define gst_compositor_scale_blend_y42b gst_compositor_scale_blend_yuv
+
 extern FillCheckerFunction gst_compositor_fill_checker_argb;
 #define gst_compositor_fill_checker_abgr gst_compositor_fill_checker_argb
 extern FillCheckerFunction gst_compositor_fill_checker_bgra;
@@ -41,6 +41,10 @@
  * * "alpha": The transparency of the picture; between 0.0 and 1.0. The blending
  *   is a simple copy when fully-transparent (0.0) and fully-opaque (1.0). (#gdouble)
  * * "zorder": The z-order position of the picture in the composition (#guint)
+ * * "crossfade-ratio": The ratio of this picture while crossfading with the
+ *   following pad, a value below 0 means no crossfading (#gdouble)
+ * * "transition": How to transition to the following pad while crossfading:
+ *   crossfade, or wipe or slide in a direction (#GstCompositorTransition)
  *
  * ## Sample pipelines
  * |[
@@ -94,6 +98,7 @@
 
 #include "compositor.h"
 #include "compositorpad.h"
+#include "transition.h"
 
 #ifdef DISABLE_ORC
 #define orc_memset memset
@@ -126,6 +131,7 @@ static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink_%u",
 #define DEFAULT_PAD_HEIGHT 0
 #define DEFAULT_PAD_ALPHA  1.0
 #define DEFAULT_PAD_CROSSFADE_RATIO  -1.0
+#define DEFAULT_PAD_TRANSITION COMPOSITOR_TRANSITION_CROSSFADE
 enum
 {
   PROP_PAD_0,
@@ -135,8 +141,45 @@ enum
   PROP_PAD_HEIGHT,
   PROP_PAD_ALPHA,
   PROP_PAD_CROSSFADE_RATIO,
+  PROP_PAD_TRANSITION,
 };
 
+#define GST_TYPE_COMPOSITOR_TRANSITION (gst_compositor_transition_get_type())
+static GType
+gst_compositor_transition_get_type (void)
+{
+  static GType compositor_transition_type = 0;
+
+  static const GEnumValue compositor_transition[] = {
+    {COMPOSITOR_TRANSITION_CROSSFADE, "Crossfade", "crossfade"},
+    {COMPOSITOR_TRANSITION_WIPE_LEFT, "Wipe to the left", "wipe-left"},
+    {COMPOSITOR_TRANSITION_WIPE_RIGHT, "Wipe to the right", "wipe-right"},
+    {COMPOSITOR_TRANSITION_WIPE_UP, "Wipe up", "wipe-up"},
+    {COMPOSITOR_TRANSITION_WIPE_DOWN, "Wipe down", "wipe-down"},
+    {COMPOSITOR_TRANSITION_SLIDE_LEFT, "Slide to the left", "slide-left"},
+    {COMPOSITOR_TRANSITION_SLIDE_RIGHT, "Slide to the right", "slide-right"},
+    {COMPOSITOR_TRANSITION_SLIDE_UP, "Slide up", "slide-up"},
+    {COMPOSITOR_TRANSITION_SLIDE_DOWN, "Slide down", "slide-down"},
+    {0, NULL, NULL},
+  };
+
+  if (!compositor_transition_type) {
+    compositor_transition_type =
+        g_enum_register_static ("GstCompositorTransition",
+        compositor_transition);
+  }
+  return compositor_transition_type;
+}
+
+/* Only the crossfade needs an alpha channel, the other transitions are
+ * mixed before blending */
+static void
+gst_compositor_pad_update_needs_alpha (GstCompositorPad * pad)
+{
+  GST_VIDEO_AGGREGATOR_PAD (pad)->needs_alpha = pad->crossfade >= 0.0f &&
+      pad->transition == COMPOSITOR_TRANSITION_CROSSFADE;
+}
+
 G_DEFINE_TYPE (GstCompositorPad, gst_compositor_pad,
     GST_TYPE_VIDEO_AGGREGATOR_PAD);
 
@@ -165,6 +208,9 @@ gst_compositor_pad_get_property (GObject * object, guint prop_id,
     case PROP_PAD_CROSSFADE_RATIO:
       g_value_set_double (value, pad->crossfade);
       break;
+    case PROP_PAD_TRANSITION:
+      g_value_set_enum (value, pad->transition);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -195,7 +241,11 @@ gst_compositor_pad_set_property (GObject * object, guint prop_id,
       break;
     case PROP_PAD_CROSSFADE_RATIO:
       pad->crossfade = g_value_get_double (value);
-      GST_VIDEO_AGGREGATOR_PAD (pad)->needs_alpha = pad->crossfade >= 0.0f;
+      gst_compositor_pad_update_needs_alpha (pad);
+      break;
+    case PROP_PAD_TRANSITION:
+      pad->transition = g_value_get_enum (value);
+      gst_compositor_pad_update_needs_alpha (pad);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -268,11 +318,6 @@ gst_compositor_pad_set_info (GstVideoAggregatorPad * pad,
   if (GST_VIDEO_INFO_FORMAT (current_info) == GST_VIDEO_FORMAT_UNKNOWN)
     return TRUE;
 
-  if (cpad->convert)
-    gst_video_converter_free (cpad->convert);
-
-  cpad->convert = NULL;
-
   if (GST_VIDEO_INFO_MULTIVIEW_MODE (current_info) !=
       GST_VIDEO_MULTIVIEW_MODE_NONE
       && GST_VIDEO_INFO_MULTIVIEW_MODE (current_info) !=
@@ -314,6 +359,20 @@ gst_compositor_pad_set_info (GstVideoAggregatorPad * pad,
     tmp_info.flags = current_info->flags;
     tmp_info.interlace_mode = current_info->interlace_mode;
 
+    /* renegotiation of the output often keeps the conversion of this pad
+     * as it is, and creating a converter is not cheap */
+    if (cpad->convert
+        && gst_video_info_is_equal (&cpad->convert_in_info, current_info)
+        && gst_video_info_is_equal (&cpad->conversion_info, &tmp_info)) {
+      GST_DEBUG_OBJECT (pad, "Reusing converter");
+      g_free (colorimetry);
+      g_free (best_colorimetry);
+      return TRUE;
+    }
+
+    if (cpad->convert)
+      gst_video_converter_free (cpad->convert);
+
     GST_DEBUG_OBJECT (pad, "This pad will be converted from format %s to %s, "
         "colorimetry %s to %s, chroma-site %s to %s, "
         "width/height %d/%d to %d/%d",
@@ -324,6 +383,7 @@ gst_compositor_pad_set_info (GstVideoAggregatorPad * pad,
 
     cpad->convert = gst_video_converter_new (current_info, &tmp_info, NULL);
     cpad->conversion_info = tmp_info;
+    cpad->convert_in_info = *current_info;
     if (!cpad->convert) {
       g_free (colorimetry);
       g_free (best_colorimetry);
@@ -331,6 +391,10 @@ gst_compositor_pad_set_info (GstVideoAggregatorPad * pad,
       return FALSE;
     }
   } else {
+    if (cpad->convert)
+      gst_video_converter_free (cpad->convert);
+    cpad->convert = NULL;
+
     cpad->conversion_info = *current_info;
     GST_DEBUG_OBJECT (pad, "This pad will not need conversion");
   }
@@ -371,6 +435,24 @@ clamp_rectangle (gint x, gint y, gint w, gint h, gint outer_width,
   return clamped;
 }
 
+/* Whether scaling is the only conversion the pad needs, so that the blend
+ * function can do it while blending */
+static gboolean
+gst_compositor_pad_can_scale_blend (GstCompositor * comp,
+    GstCompositorPad * cpad)
+{
+  GstVideoInfo *in_info = &GST_VIDEO_AGGREGATOR_PAD (cpad)->info;
+  GstVideoInfo *out_info = &cpad->conversion_info;
+
+  return comp->scale_blend != NULL &&
+      comp->background != COMPOSITOR_BACKGROUND_TRANSPARENT &&
+      GST_VIDEO_INFO_FORMAT (in_info) == GST_VIDEO_INFO_FORMAT (out_info) &&
+      gst_video_colorimetry_is_equal (&in_info->colorimetry,
+      &out_info->colorimetry) &&
+      in_info->chroma_site == out_info->chroma_site &&
+      !GST_VIDEO_INFO_IS_INTERLACED (in_info);
+}
+
 static gboolean
 gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
     GstVideoAggregator * vagg)
@@ -384,11 +466,14 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
   static GstAllocationParams params = { 0, 15, 0, 0, };
   gint width, height;
   gboolean frame_obscured = FALSE;
+  gboolean crossfading = FALSE;
   GList *l;
   /* The rectangle representing this frame, clamped to the video's boundaries.
    * Due to the clamping, this is different from the frame width/height above. */
   GstVideoRectangle frame_rect;
 
+  cpad->scaled = FALSE;
+
   if (!pad->buffer)
     return TRUE;
 
@@ -455,6 +540,7 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
 
       cpad->convert = gst_video_converter_new (&pad->info, &tmp_info, NULL);
       cpad->conversion_info = tmp_info;
+      cpad->convert_in_info = pad->info;
 
       if (!cpad->convert) {
         GST_WARNING_OBJECT (pad, "No path found for conversion");
@@ -493,6 +579,7 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
   if ((l->prev && GST_COMPOSITOR_PAD (l->prev->data)->crossfade >= 0.0) ||
       (GST_COMPOSITOR_PAD (pad)->crossfade >= 0.0)) {
     GST_DEBUG_OBJECT (pad, "Is being crossfaded with previous pad");
+    crossfading = TRUE;
     l = NULL;
   } else {
     l = l->next;
@@ -547,7 +634,13 @@ gst_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
     return FALSE;
   }
 
-  if (cpad->convert) {
+  /* Crossfading works on frames of the output size */
+  if (cpad->convert && !crossfading
+      && gst_compositor_pad_can_scale_blend (comp, cpad)) {
+    GST_LOG_OBJECT (pad, "Scaling while blending");
+    cpad->scaled = TRUE;
+    converted_frame = frame;
+  } else if (cpad->convert) {
     gint converted_size;
 
     converted_frame = g_slice_new0 (GstVideoFrame);
@@ -649,6 +742,20 @@ gst_compositor_pad_class_init (GstCompositorPadClass * klass)
           "A value inferior to 0 means no crossfading.",
           -1.0, 1.0, DEFAULT_PAD_CROSSFADE_RATIO,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstCompositorPad:transition:
+   *
+   * How to transition to the following pad while crossfading. Except for
+   * the crossfade, the transitions only apply to pads with the same position
+   * and size and an alpha of 1.0, other pads are crossfaded.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_TRANSITION,
+      g_param_spec_enum ("transition", "Transition",
+          "How to transition to the following pad while crossfading",
+          GST_TYPE_COMPOSITOR_TRANSITION, DEFAULT_PAD_TRANSITION,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   vaggpadclass->set_info = GST_DEBUG_FUNCPTR (gst_compositor_pad_set_info);
   vaggpadclass->prepare_frame =
@@ -664,15 +771,20 @@ gst_compositor_pad_init (GstCompositorPad * compo_pad)
   compo_pad->ypos = DEFAULT_PAD_YPOS;
   compo_pad->alpha = DEFAULT_PAD_ALPHA;
   compo_pad->crossfade = DEFAULT_PAD_CROSSFADE_RATIO;
+  compo_pad->transition = DEFAULT_PAD_TRANSITION;
 }
 
 
 /* GstCompositor */
 #define DEFAULT_BACKGROUND COMPOSITOR_BACKGROUND_CHECKER
+#define DEFAULT_N_THREADS 1
+#define DEFAULT_INCREMENTAL FALSE
 enum
 {
   PROP_0,
   PROP_BACKGROUND,
+  PROP_N_THREADS,
+  PROP_INCREMENTAL,
 };
 
 #define GST_TYPE_COMPOSITOR_BACKGROUND (gst_compositor_background_get_type())
@@ -698,6 +810,29 @@ gst_compositor_background_get_type (void)
   return compositor_background_type;
 }
 
+typedef struct
+{
+  GstVideoAggregatorPad *pad;
+  GstBuffer *buffer;
+  gint xpos, ypos;
+  gint width, height;
+  gdouble alpha;
+} GstCompositorLastInput;
+
+static void
+gst_compositor_last_input_clear (GstCompositorLastInput * last)
+{
+  gst_buffer_replace (&last->buffer, NULL);
+}
+
+/* Forgets the previous output so the next one is composited completely */
+static void
+gst_compositor_clear_last_output (GstCompositor * self)
+{
+  gst_buffer_replace (&self->last_outbuf, NULL);
+  g_array_set_size (self->last_inputs, 0);
+}
+
 static void
 gst_compositor_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec)
@@ -708,6 +843,16 @@ gst_compositor_get_property (GObject * object,
     case PROP_BACKGROUND:
       g_value_set_enum (value, self->background);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->n_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_INCREMENTAL:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->incremental);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -722,7 +867,21 @@ gst_compositor_set_property (GObject * object,
 
   switch (prop_id) {
     case PROP_BACKGROUND:
+      GST_OBJECT_LOCK (self);
       self->background = g_value_get_enum (value);
+      gst_compositor_clear_last_output (self);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_INCREMENTAL:
+      GST_OBJECT_LOCK (self);
+      self->incremental = g_value_get_boolean (value);
+      gst_compositor_clear_last_output (self);
+      GST_OBJECT_UNLOCK (self);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -742,6 +901,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
   self->overlay = NULL;
   self->fill_checker = NULL;
   self->fill_color = NULL;
+  self->scale_blend = NULL;
 
   switch (GST_VIDEO_INFO_FORMAT (info)) {
     case GST_VIDEO_FORMAT_AYUV:
@@ -749,6 +909,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = gst_compositor_overlay_ayuv;
       self->fill_checker = gst_compositor_fill_checker_ayuv;
       self->fill_color = gst_compositor_fill_color_ayuv;
+      self->scale_blend = gst_compositor_scale_blend_ayuv;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_ARGB:
@@ -756,6 +917,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = gst_compositor_overlay_argb;
       self->fill_checker = gst_compositor_fill_checker_argb;
       self->fill_color = gst_compositor_fill_color_argb;
+      self->scale_blend = gst_compositor_scale_blend_argb;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_BGRA:
@@ -763,6 +925,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = gst_compositor_overlay_bgra;
       self->fill_checker = gst_compositor_fill_checker_bgra;
       self->fill_color = gst_compositor_fill_color_bgra;
+      self->scale_blend = gst_compositor_scale_blend_bgra;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_ABGR:
@@ -770,6 +933,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = gst_compositor_overlay_abgr;
       self->fill_checker = gst_compositor_fill_checker_abgr;
       self->fill_color = gst_compositor_fill_color_abgr;
+      self->scale_blend = gst_compositor_scale_blend_abgr;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_RGBA:
@@ -777,6 +941,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = gst_compositor_overlay_rgba;
       self->fill_checker = gst_compositor_fill_checker_rgba;
       self->fill_color = gst_compositor_fill_color_rgba;
+      self->scale_blend = gst_compositor_scale_blend_rgba;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_Y444:
@@ -784,6 +949,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = self->blend;
       self->fill_checker = gst_compositor_fill_checker_y444;
       self->fill_color = gst_compositor_fill_color_y444;
+      self->scale_blend = gst_compositor_scale_blend_y444;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_Y42B:
@@ -791,6 +957,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = self->blend;
       self->fill_checker = gst_compositor_fill_checker_y42b;
       self->fill_color = gst_compositor_fill_color_y42b;
+      self->scale_blend = gst_compositor_scale_blend_y42b;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_YUY2:
@@ -819,6 +986,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = self->blend;
       self->fill_checker = gst_compositor_fill_checker_i420;
       self->fill_color = gst_compositor_fill_color_i420;
+      self->scale_blend = gst_compositor_scale_blend_i420;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_YV12:
@@ -826,6 +994,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = self->blend;
       self->fill_checker = gst_compositor_fill_checker_yv12;
       self->fill_color = gst_compositor_fill_color_yv12;
+      self->scale_blend = gst_compositor_scale_blend_yv12;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_NV12:
@@ -833,6 +1002,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = self->blend;
       self->fill_checker = gst_compositor_fill_checker_nv12;
       self->fill_color = gst_compositor_fill_color_nv12;
+      self->scale_blend = gst_compositor_scale_blend_nv12;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_NV21:
@@ -840,6 +1010,7 @@ set_functions (GstCompositor * self, GstVideoInfo * info)
       self->overlay = self->blend;
       self->fill_checker = gst_compositor_fill_checker_nv21;
       self->fill_color = gst_compositor_fill_color_nv21;
+      self->scale_blend = gst_compositor_scale_blend_nv21;
       ret = TRUE;
       break;
     case GST_VIDEO_FORMAT_Y41B:
@@ -989,6 +1160,10 @@ _negotiated_caps (GstAggregator * agg, GstCaps * caps)
     return FALSE;
   }
 
+  GST_OBJECT_LOCK (agg);
+  gst_compositor_clear_last_output (GST_COMPOSITOR (agg));
+  GST_OBJECT_UNLOCK (agg);
+
   return GST_AGGREGATOR_CLASS (parent_class)->negotiated_src_caps (agg, caps);
 }
 
@@ -1030,6 +1205,72 @@ gst_compositor_fill_transparent (GstCompositor * self, GstVideoFrame * frame,
   return GST_FLOW_OK;
 }
 
+/* Whether the pads can use the transition kernels, which need frames of the
+ * same size at the same position, without scaling nor transparency */
+static gboolean
+gst_compositor_pads_can_transition (GstVideoAggregatorPad * pad,
+    GstVideoAggregatorPad * npad)
+{
+  GstCompositorPad *compo_pad = GST_COMPOSITOR_PAD (pad);
+  GstCompositorPad *next_compo_pad = GST_COMPOSITOR_PAD (npad);
+  GstVideoFrame *frame = pad->aggregated_frame;
+  GstVideoFrame *nframe = npad->aggregated_frame;
+
+  return !compo_pad->scaled && !next_compo_pad->scaled &&
+      compo_pad->alpha == 1.0 && next_compo_pad->alpha == 1.0 &&
+      (compo_pad->crossfaded ? 0 : compo_pad->xpos) == next_compo_pad->xpos &&
+      (compo_pad->crossfaded ? 0 : compo_pad->ypos) == next_compo_pad->ypos &&
+      GST_VIDEO_FRAME_FORMAT (frame) == GST_VIDEO_FRAME_FORMAT (nframe) &&
+      GST_VIDEO_FRAME_WIDTH (frame) == GST_VIDEO_FRAME_WIDTH (nframe) &&
+      GST_VIDEO_FRAME_HEIGHT (frame) == GST_VIDEO_FRAME_HEIGHT (nframe) &&
+      gst_compositor_transition_supports_format (GST_VIDEO_FRAME_FORMAT
+      (frame));
+}
+
+/* Mixes the frames of @pad and @npad with the transition of @pad. The result
+ * is composited on @outframe if given, or replaces the frame of @npad */
+static void
+gst_compositor_transition_pads (GstCompositor * self,
+    GstVideoAggregatorPad * pad, GstVideoAggregatorPad * npad,
+    GstVideoFrame * outframe)
+{
+  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (self);
+  GstCompositorPad *compo_pad = GST_COMPOSITOR_PAD (pad);
+  GstCompositorPad *next_compo_pad = GST_COMPOSITOR_PAD (npad);
+  GstVideoFrame *frame;
+  GstBuffer *buf;
+
+  frame = g_slice_new0 (GstVideoFrame);
+  buf = gst_buffer_new_allocate (NULL,
+      GST_VIDEO_INFO_SIZE (&pad->aggregated_frame->info), NULL);
+  if (!gst_video_frame_map (frame, &pad->aggregated_frame->info, buf,
+          GST_MAP_READWRITE)) {
+    GST_WARNING_OBJECT (self, "Could not map transition buffer");
+    gst_buffer_unref (buf);
+    g_slice_free (GstVideoFrame, frame);
+    return;
+  }
+  gst_buffer_unref (buf);
+
+  gst_compositor_transition_frames (compo_pad->transition,
+      1.0 - compo_pad->crossfade, pad->aggregated_frame,
+      npad->aggregated_frame, frame);
+
+  gst_compositor_pad_clean_frame (pad, vagg);
+  gst_compositor_pad_clean_frame (npad, vagg);
+
+  if (outframe) {
+    self->overlay (frame, next_compo_pad->xpos, next_compo_pad->ypos, 1.0,
+        outframe, COMPOSITOR_BLEND_MODE_ADDITIVE);
+    gst_video_frame_unmap (frame);
+    g_slice_free (GstVideoFrame, frame);
+  } else {
+    /* blended at the position of the next pad, which is the same */
+    npad->aggregated_frame = frame;
+    next_compo_pad->crossfaded = FALSE;
+  }
+}
+
 /* WITH GST_OBJECT_LOCK !!
  * Returns: %TRUE if outframe is allready ready to be used as we are using
  * a transparent background and all pads have already been crossfaded
@@ -1066,6 +1307,15 @@ gst_compositor_crossfade_frames (GstCompositor * self, GstVideoFrame * outframe)
       GstVideoAggregatorPad *npad = l->next ? l->next->data : NULL;
       GstVideoFrame *nframe;
 
+      if (npad && npad->aggregated_frame &&
+          gst_compositor_pads_can_transition (pad, npad)) {
+        gst_compositor_transition_pads (self, pad, npad,
+            all_crossfading ? outframe : NULL);
+        continue;
+      } else if (compo_pad->transition != COMPOSITOR_TRANSITION_CROSSFADE) {
+        GST_LOG_OBJECT (pad, "Can't transition, crossfading instead");
+      }
+
       if (!all_crossfading) {
         nframe = g_slice_new0 (GstVideoFrame);
         gst_compositor_fill_transparent (self, outframe, nframe);
@@ -1110,6 +1360,356 @@ gst_compositor_crossfade_frames (GstCompositor * self, GstVideoFrame * outframe)
   return all_crossfading;
 }
 
+static void
+gst_compositor_fill_background (GstCompositor * self, GstVideoFrame * frame)
+{
+  /* TODO: If the frames to be composited completely obscure the background,
+   * don't bother drawing the background at all. */
+  switch (self->background) {
+    case COMPOSITOR_BACKGROUND_CHECKER:
+      self->fill_checker (frame);
+      break;
+    case COMPOSITOR_BACKGROUND_BLACK:
+      self->fill_color (frame, 16, 128, 128);
+      break;
+    case COMPOSITOR_BACKGROUND_WHITE:
+      self->fill_color (frame, 240, 128, 128);
+      break;
+    case COMPOSITOR_BACKGROUND_TRANSPARENT:
+      gst_compositor_fill_transparent (self, frame, NULL);
+      break;
+  }
+}
+
+typedef struct
+{
+  GstVideoAggregatorPad *pad;
+  GstVideoFrame *frame;
+  gint xpos, ypos;
+  /* size in the output, the frame is scaled while blending if it differs */
+  gint width, height;
+  gboolean scaled;
+  gdouble alpha;
+  /* fully hides whatever is below it */
+  gboolean opaque;
+} GstCompositorBlendInput;
+
+typedef struct
+{
+  GstCompositor *self;
+  GstVideoFrame *outframe;
+  BlendFunction composite;
+  gboolean fill_background;
+  const GstCompositorBlendInput *inputs;
+  guint n_inputs;
+  gint y_start, y_end;
+} GstCompositorStripe;
+
+/* Makes @stripe a view of the rows [@y_start, @y_end) of @frame. @y_start
+ * must be a multiple of the vertical subsampling of all components, and of
+ * the checker pattern size so that the background stays continuous. The view
+ * must not be unmapped. */
+static void
+gst_compositor_stripe_frame (GstVideoFrame * frame, gint y_start, gint y_end,
+    GstVideoFrame * stripe)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  gint plane, comp;
+
+  *stripe = *frame;
+  stripe->info.height = y_end - y_start;
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (frame); plane++) {
+    for (comp = 0; comp < GST_VIDEO_FRAME_N_COMPONENTS (frame); comp++) {
+      if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, comp) == plane)
+        break;
+    }
+    stripe->data[plane] = (guint8 *) frame->data[plane] +
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, comp, y_start) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (frame, plane);
+  }
+}
+
+static void
+gst_compositor_blend_stripe (GstCompositorStripe * stripe)
+{
+  GstCompositor *self = stripe->self;
+  GstVideoFrame frame;
+  gint width = GST_VIDEO_FRAME_WIDTH (stripe->outframe);
+  guint i, first = 0;
+  gboolean covered = FALSE;
+
+  gst_compositor_stripe_frame (stripe->outframe, stripe->y_start,
+      stripe->y_end, &frame);
+
+  /* Start at the topmost opaque input covering the whole stripe, nothing
+   * below it is visible. The blend functions round positions up to the
+   * chroma subsampling, so only count fully covered rows and columns. */
+  if (stripe->fill_background) {
+    for (i = stripe->n_inputs; i > 0; i--) {
+      const GstCompositorBlendInput *input = &stripe->inputs[i - 1];
+
+      if (input->opaque && GST_ROUND_UP_4 (input->xpos) <= 0 &&
+          input->xpos + input->width >= width &&
+          GST_ROUND_UP_4 (input->ypos) <= stripe->y_start &&
+          input->ypos + input->height >= stripe->y_end) {
+        first = i - 1;
+        covered = TRUE;
+        break;
+      }
+    }
+
+    if (!covered)
+      gst_compositor_fill_background (self, &frame);
+  }
+
+  /* inputs are in z-order, so each stripe is composited exactly like the
+   * same rows of the whole frame would be */
+  for (i = first; i < stripe->n_inputs; i++) {
+    const GstCompositorBlendInput *input = &stripe->inputs[i];
+
+    if (input->ypos >= stripe->y_end ||
+        input->ypos + input->height <= stripe->y_start)
+      continue;
+
+    if (input->scaled)
+      self->scale_blend (input->frame, input->xpos,
+          input->ypos - stripe->y_start, input->width, input->height,
+          input->alpha, &frame);
+    else
+      stripe->composite (input->frame, input->xpos,
+          input->ypos - stripe->y_start, input->alpha, &frame,
+          COMPOSITOR_BLEND_MODE_NORMAL);
+  }
+}
+
+static void
+gst_compositor_stripe_func (gpointer data, gpointer user_data)
+{
+  GstCompositor *self = user_data;
+
+  gst_compositor_blend_stripe (data);
+
+  g_mutex_lock (&self->stripe_lock);
+  if (--self->stripes_pending == 0)
+    g_cond_signal (&self->stripe_cond);
+  g_mutex_unlock (&self->stripe_lock);
+}
+
+/* WITH GST_OBJECT_LOCK !!
+ * Splits the rows [@y_start, @y_end) of @outframe in up to n-threads
+ * horizontal stripes and composites all @inputs into each of them, the first
+ * stripe on the calling thread and the others on the stripe pool. @y_start
+ * must be a multiple of 16. Returns once all stripes are done. */
+static void
+gst_compositor_blend_stripes (GstCompositor * self, GstVideoFrame * outframe,
+    gint y_start, gint y_end, BlendFunction composite,
+    gboolean fill_background, const GstCompositorBlendInput * inputs,
+    guint n_inputs)
+{
+  GstCompositorStripe *stripes;
+  gint height = y_end - y_start;
+  guint n_threads, n_stripes, i;
+  gint stripe_height;
+
+  if (height <= 0)
+    return;
+
+  n_threads = self->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_threads = MAX (MIN (n_threads, (height + 15) / 16), 1);
+
+  stripe_height = GST_ROUND_UP_16 ((height + n_threads - 1) / n_threads);
+  n_stripes = (height + stripe_height - 1) / stripe_height;
+
+  stripes = g_new (GstCompositorStripe, n_stripes);
+  for (i = 0; i < n_stripes; i++) {
+    stripes[i].self = self;
+    stripes[i].outframe = outframe;
+    stripes[i].composite = composite;
+    stripes[i].fill_background = fill_background;
+    stripes[i].inputs = inputs;
+    stripes[i].n_inputs = n_inputs;
+    stripes[i].y_start = y_start + i * stripe_height;
+    stripes[i].y_end = MIN (y_start + (i + 1) * stripe_height, y_end);
+  }
+
+  if (n_stripes > 1) {
+    if (!self->stripe_pool) {
+      self->stripe_pool = g_thread_pool_new (gst_compositor_stripe_func, self,
+          n_stripes - 1, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (self->stripe_pool) <
+        n_stripes - 1) {
+      g_thread_pool_set_max_threads (self->stripe_pool, n_stripes - 1, NULL);
+    }
+
+    self->stripes_pending = n_stripes - 1;
+    for (i = 1; i < n_stripes; i++)
+      g_thread_pool_push (self->stripe_pool, &stripes[i], NULL);
+  }
+
+  gst_compositor_blend_stripe (&stripes[0]);
+
+  if (n_stripes > 1) {
+    g_mutex_lock (&self->stripe_lock);
+    while (self->stripes_pending > 0)
+      g_cond_wait (&self->stripe_cond, &self->stripe_lock);
+    g_mutex_unlock (&self->stripe_lock);
+  }
+
+  g_free (stripes);
+}
+
+/* Copies the rows [@y_start, @y_end) of @src to @dest */
+static void
+gst_compositor_copy_rows (GstVideoFrame * dest, GstVideoFrame * src,
+    gint y_start, gint y_end)
+{
+  GstVideoFrame dest_rows, src_rows;
+
+  if (y_start >= y_end)
+    return;
+
+  gst_compositor_stripe_frame (dest, y_start, y_end, &dest_rows);
+  gst_compositor_stripe_frame (src, y_start, y_end, &src_rows);
+  gst_video_frame_copy (&dest_rows, &src_rows);
+}
+
+/* WITH GST_OBJECT_LOCK !!
+ * Finds the rows that changed since the last output: the old and the new
+ * rows of every input that got a new buffer or was moved, resized or faded.
+ * Returns %FALSE if the set of inputs changed and everything has to be
+ * composited again. */
+static gboolean
+gst_compositor_get_dirty_rows (GstCompositor * self,
+    const GstCompositorBlendInput * inputs, guint n_inputs, gint height,
+    gint * y_start, gint * y_end)
+{
+  gint dirty_start = height, dirty_end = 0;
+  guint i;
+
+  if (self->last_inputs->len != n_inputs)
+    return FALSE;
+
+  for (i = 0; i < n_inputs; i++) {
+    const GstCompositorBlendInput *input = &inputs[i];
+    GstCompositorLastInput *last =
+        &g_array_index (self->last_inputs, GstCompositorLastInput, i);
+    gint input_height = input->height;
+
+    if (last->pad != input->pad)
+      return FALSE;
+
+    if (last->buffer == input->pad->buffer && last->xpos == input->xpos &&
+        last->ypos == input->ypos &&
+        last->width == input->width &&
+        last->height == input_height && last->alpha == input->alpha)
+      continue;
+
+    dirty_start = MIN (dirty_start, MIN (last->ypos, input->ypos));
+    dirty_end = MAX (dirty_end, MAX (last->ypos + last->height,
+            input->ypos + input_height));
+  }
+
+  /* leave room for the rounding of the positions to the chroma subsampling
+   * and keep the stripes aligned */
+  dirty_start = MAX (dirty_start - 4, 0) & ~15;
+  dirty_end = MIN (GST_ROUND_UP_16 (dirty_end + 4), height);
+
+  *y_start = dirty_start;
+  *y_end = MAX (dirty_start, dirty_end);
+
+  return TRUE;
+}
+
+/* WITH GST_OBJECT_LOCK !! */
+static void
+gst_compositor_store_last_output (GstCompositor * self, GstBuffer * outbuf,
+    const GstCompositorBlendInput * inputs, guint n_inputs)
+{
+  guint i;
+
+  gst_compositor_clear_last_output (self);
+
+  gst_buffer_replace (&self->last_outbuf, outbuf);
+  g_array_set_size (self->last_inputs, n_inputs);
+  for (i = 0; i < n_inputs; i++) {
+    GstCompositorLastInput *last =
+        &g_array_index (self->last_inputs, GstCompositorLastInput, i);
+
+    last->pad = inputs[i].pad;
+    last->buffer = gst_buffer_ref (inputs[i].pad->buffer);
+    last->xpos = inputs[i].xpos;
+    last->ypos = inputs[i].ypos;
+    last->width = inputs[i].width;
+    last->height = inputs[i].height;
+    last->alpha = inputs[i].alpha;
+  }
+}
+
+/* Uses the buffer of the bottom pad as the output buffer if it covers the
+ * whole output unchanged and opaque, so that the other pads are blended on
+ * top of it in place */
+static GstFlowReturn
+gst_compositor_get_output_buffer (GstVideoAggregator * vagg,
+    GstBuffer ** outbuf)
+{
+  GstCompositor *self = GST_COMPOSITOR (vagg);
+  GstVideoAggregatorPad *bottom = NULL;
+  GstCompositorPad *cpad;
+  GstBuffer *buf = NULL;
+  gint width, height;
+  GList *l;
+
+  self->output_has_bottom = FALSE;
+
+  GST_OBJECT_LOCK (vagg);
+  if (self->incremental)
+    goto done;
+
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+
+    if (GST_COMPOSITOR_PAD (pad)->crossfade >= 0.0)
+      goto done;
+    if (!bottom && pad->buffer)
+      bottom = pad;
+  }
+
+  if (!bottom)
+    goto done;
+
+  cpad = GST_COMPOSITOR_PAD (bottom);
+  if (cpad->alpha != 1.0 || cpad->xpos != 0 || cpad->ypos != 0 ||
+      GST_VIDEO_INFO_HAS_ALPHA (&bottom->info) ||
+      !gst_video_info_is_equal (&bottom->info, &vagg->info))
+    goto done;
+
+  _mixer_pad_get_output_size (self, cpad, GST_VIDEO_INFO_PAR_N (&vagg->info),
+      GST_VIDEO_INFO_PAR_D (&vagg->info), &width, &height);
+  if (width != GST_VIDEO_INFO_WIDTH (&vagg->info) ||
+      height != GST_VIDEO_INFO_HEIGHT (&vagg->info))
+    goto done;
+
+  buf = gst_video_aggregator_pad_take_buffer (bottom);
+
+done:
+  GST_OBJECT_UNLOCK (vagg);
+
+  if (!buf)
+    return GST_VIDEO_AGGREGATOR_CLASS (parent_class)->get_output_buffer (vagg,
+        outbuf);
+
+  GST_LOG_OBJECT (bottom, "Compositing on top of the input buffer");
+  GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DISCONT | GST_BUFFER_FLAG_GAP |
+      GST_BUFFER_FLAG_CORRUPTED | GST_BUFFER_FLAG_DROPPABLE);
+  self->output_has_bottom = TRUE;
+  *outbuf = buf;
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
 {
@@ -1117,6 +1717,11 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
   GstCompositor *self = GST_COMPOSITOR (vagg);
   BlendFunction composite;
   GstVideoFrame out_frame, *outframe;
+  GstCompositorBlendInput *inputs;
+  guint n_inputs;
+  gboolean crossfading = FALSE;
+  gint height, dirty_start, dirty_end;
+  GstVideoFrame last_frame;
 
   if (!gst_video_frame_map (&out_frame, &vagg->info, outbuf, GST_MAP_WRITE)) {
     GST_WARNING_OBJECT (vagg, "Could not map output buffer");
@@ -1124,43 +1729,89 @@ gst_compositor_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
   }
 
   outframe = &out_frame;
-  /* default to blending */
-  composite = self->blend;
-  /* TODO: If the frames to be composited completely obscure the background,
-   * don't bother drawing the background at all. */
-  switch (self->background) {
-    case COMPOSITOR_BACKGROUND_CHECKER:
-      self->fill_checker (outframe);
-      break;
-    case COMPOSITOR_BACKGROUND_BLACK:
-      self->fill_color (outframe, 16, 128, 128);
-      break;
-    case COMPOSITOR_BACKGROUND_WHITE:
-      self->fill_color (outframe, 240, 128, 128);
-      break;
-    case COMPOSITOR_BACKGROUND_TRANSPARENT:
-      gst_compositor_fill_transparent (self, outframe, NULL);
-      /* use overlay to keep background transparent */
-      composite = self->overlay;
+  height = GST_VIDEO_FRAME_HEIGHT (outframe);
+  /* default to blending, use overlay to keep background transparent */
+  if (self->background == COMPOSITOR_BACKGROUND_TRANSPARENT)
+    composite = self->overlay;
+  else
+    composite = self->blend;
+
+  GST_OBJECT_LOCK (vagg);
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+
+    if (GST_COMPOSITOR_PAD (pad)->crossfade >= 0.0 && pad->aggregated_frame) {
+      crossfading = TRUE;
       break;
+    }
   }
 
-  GST_OBJECT_LOCK (vagg);
-  /* First mix the crossfade frames as required */
-  if (!gst_compositor_crossfade_frames (self, outframe)) {
-    for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
-      GstVideoAggregatorPad *pad = l->data;
-      GstCompositorPad *compo_pad = GST_COMPOSITOR_PAD (pad);
-
-      if (pad->aggregated_frame != NULL) {
-        composite (pad->aggregated_frame,
-            compo_pad->crossfaded ? 0 : compo_pad->xpos,
-            compo_pad->crossfaded ? 0 : compo_pad->ypos, compo_pad->alpha,
-            outframe, COMPOSITOR_BLEND_MODE_NORMAL);
-        compo_pad->crossfaded = FALSE;
+  /* First mix the crossfade frames as required, this works on whole frames
+   * so the background is filled up front */
+  if (crossfading) {
+    gst_compositor_clear_last_output (self);
+    gst_compositor_fill_background (self, outframe);
+    if (gst_compositor_crossfade_frames (self, outframe))
+      goto done;
+  }
+
+  inputs = g_new (GstCompositorBlendInput,
+      g_list_length (GST_ELEMENT (vagg)->sinkpads));
+  n_inputs = 0;
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+    GstCompositorPad *compo_pad = GST_COMPOSITOR_PAD (pad);
+
+    if (pad->aggregated_frame != NULL) {
+      inputs[n_inputs].pad = pad;
+      inputs[n_inputs].frame = pad->aggregated_frame;
+      inputs[n_inputs].xpos = compo_pad->crossfaded ? 0 : compo_pad->xpos;
+      inputs[n_inputs].ypos = compo_pad->crossfaded ? 0 : compo_pad->ypos;
+      inputs[n_inputs].scaled = compo_pad->scaled;
+      if (compo_pad->scaled) {
+        inputs[n_inputs].width =
+            GST_VIDEO_INFO_WIDTH (&compo_pad->conversion_info);
+        inputs[n_inputs].height =
+            GST_VIDEO_INFO_HEIGHT (&compo_pad->conversion_info);
+      } else {
+        inputs[n_inputs].width = GST_VIDEO_FRAME_WIDTH (pad->aggregated_frame);
+        inputs[n_inputs].height =
+            GST_VIDEO_FRAME_HEIGHT (pad->aggregated_frame);
       }
+      inputs[n_inputs].alpha = compo_pad->alpha;
+      inputs[n_inputs].opaque = !crossfading && compo_pad->alpha == 1.0 &&
+          !GST_VIDEO_INFO_HAS_ALPHA (&pad->info);
+      n_inputs++;
+      compo_pad->crossfaded = FALSE;
     }
   }
+
+  /* Only composite the rows that changed since the last output and copy
+   * the others over from it */
+  if (self->incremental && !crossfading && self->last_outbuf &&
+      gst_compositor_get_dirty_rows (self, inputs, n_inputs, height,
+          &dirty_start, &dirty_end) &&
+      gst_video_frame_map (&last_frame, &vagg->info, self->last_outbuf,
+          GST_MAP_READ)) {
+    GST_LOG_OBJECT (self, "Compositing rows %d to %d", dirty_start,
+        dirty_end);
+
+    gst_compositor_copy_rows (outframe, &last_frame, 0, dirty_start);
+    gst_compositor_blend_stripes (self, outframe, dirty_start, dirty_end,
+        composite, TRUE, inputs, n_inputs);
+    gst_compositor_copy_rows (outframe, &last_frame, dirty_end, height);
+    gst_video_frame_unmap (&last_frame);
+  } else {
+    gst_compositor_blend_stripes (self, outframe, 0, height, composite,
+        !crossfading && !self->output_has_bottom, inputs, n_inputs);
+  }
+
+  if (self->incremental && !crossfading)
+    gst_compositor_store_last_output (self, outbuf, inputs, n_inputs);
+
+  g_free (inputs);
+
+done:
   GST_OBJECT_UNLOCK (vagg);
 
   gst_video_frame_unmap (outframe);
@@ -1210,6 +1861,21 @@ _sink_query (GstAggregator * agg, GstAggregatorPad * bpad, GstQuery * query)
   }
 }
 
+static void
+gst_compositor_finalize (GObject * object)
+{
+  GstCompositor *self = GST_COMPOSITOR (object);
+
+  if (self->stripe_pool)
+    g_thread_pool_free (self->stripe_pool, FALSE, TRUE);
+  gst_buffer_replace (&self->last_outbuf, NULL);
+  g_array_free (self->last_inputs, TRUE);
+  g_mutex_clear (&self->stripe_lock);
+  g_cond_clear (&self->stripe_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 /* GObject boilerplate */
 static void
 gst_compositor_class_init (GstCompositorClass * klass)
@@ -1222,18 +1888,50 @@ gst_compositor_class_init (GstCompositorClass * klass)
 
   gobject_class->get_property = gst_compositor_get_property;
   gobject_class->set_property = gst_compositor_set_property;
+  gobject_class->finalize = gst_compositor_finalize;
 
   agg_class->sinkpads_type = GST_TYPE_COMPOSITOR_PAD;
   agg_class->sink_query = _sink_query;
   agg_class->fixate_src_caps = _fixate_caps;
   agg_class->negotiated_src_caps = _negotiated_caps;
   videoaggregator_class->aggregate_frames = gst_compositor_aggregate_frames;
+  videoaggregator_class->get_output_buffer = gst_compositor_get_output_buffer;
 
   g_object_class_install_property (gobject_class, PROP_BACKGROUND,
       g_param_spec_enum ("background", "Background", "Background type",
           GST_TYPE_COMPOSITOR_BACKGROUND,
           DEFAULT_BACKGROUND, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstCompositor:n-threads:
+   *
+   * Number of threads the output frame is composited with. The frame is
+   * split in horizontal stripes that are filled and blended independently,
+   * 0 uses one thread per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads to composite with (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstCompositor:incremental:
+   *
+   * Reuse the previous output and only composite again the rows where a
+   * pad got a new buffer, or was moved, resized or faded. This saves most
+   * of the work when inputs repeat frames, at the cost of copying the
+   * unchanged rows and of keeping the previous output buffer around.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_INCREMENTAL,
+      g_param_spec_boolean ("incremental", "Incremental",
+          "Only composite the rows of the output that changed",
+          DEFAULT_INCREMENTAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_factory);
 
@@ -1248,6 +1946,14 @@ gst_compositor_init (GstCompositor * self)
 {
   /* initialize variables */
   self->background = DEFAULT_BACKGROUND;
+  self->n_threads = DEFAULT_N_THREADS;
+  self->incremental = DEFAULT_INCREMENTAL;
+  self->last_inputs = g_array_new (FALSE, TRUE,
+      sizeof (GstCompositorLastInput));
+  g_array_set_clear_func (self->last_inputs,
+      (GDestroyNotify) gst_compositor_last_input_clear);
+  g_mutex_init (&self->stripe_lock);
+  g_cond_init (&self->stripe_cond);
 }
 
 /* Element registration */
@@ -72,6 +72,22 @@ struct _GstCompositor
   BlendFunction blend, overlay;
   FillCheckerFunction fill_checker;
   FillColorFunction fill_color;
+  ScaleBlendFunction scale_blend;
+
+  /* horizontal stripes blended in parallel */
+  guint n_threads;
+  GThreadPool *stripe_pool;
+  GMutex stripe_lock;
+  GCond stripe_cond;
+  guint stripes_pending;
+
+  /* previous output, for incremental compositing */
+  gboolean incremental;
+  GstBuffer *last_outbuf;
+  GArray *last_inputs;
+
+  /* the output buffer is the buffer of the bottom pad */
+  gboolean output_has_bottom;
 };
 
 struct _GstCompositorClass
@@ -24,6 +24,8 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 
+#include "transition.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_COMPOSITOR_PAD (gst_compositor_pad_get_type())
@@ -53,12 +55,17 @@ struct _GstCompositorPad
   gint width, height;
   gdouble alpha;
   gdouble crossfade;
+  GstCompositorTransition transition;
 
   GstVideoConverter *convert;
   GstVideoInfo conversion_info;
   GstBuffer *converted_buffer;
+  /* input caps of the converter, to reuse it if they do not change */
+  GstVideoInfo convert_in_info;
 
   gboolean crossfaded;
+  /* aggregated_frame has the input size and is scaled while blending */
+  gboolean scaled;
 };
 
 struct _GstCompositorPadClass
@@ -0,0 +1,235 @@
+/* GStreamer compositor transitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Transitions between two frames of the same format and size. All supported
+ * formats have 8 bit components, so the transitions work on the planes as
+ * rows of bytes: wipes and slides are row copies and the crossfade uses the
+ * ORC blend kernel on every plane. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "transition.h"
+#include "compositororc.h"
+
+#include <string.h>
+
+gboolean
+gst_compositor_transition_supports_format (GstVideoFormat format)
+{
+  switch (format) {
+    case GST_VIDEO_FORMAT_I420:
+    case GST_VIDEO_FORMAT_YV12:
+    case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_NV21:
+    case GST_VIDEO_FORMAT_Y41B:
+    case GST_VIDEO_FORMAT_Y42B:
+    case GST_VIDEO_FORMAT_Y444:
+    case GST_VIDEO_FORMAT_AYUV:
+    case GST_VIDEO_FORMAT_ARGB:
+    case GST_VIDEO_FORMAT_BGRA:
+    case GST_VIDEO_FORMAT_ABGR:
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_xRGB:
+    case GST_VIDEO_FORMAT_xBGR:
+    case GST_VIDEO_FORMAT_RGBx:
+    case GST_VIDEO_FORMAT_BGRx:
+    case GST_VIDEO_FORMAT_RGB:
+    case GST_VIDEO_FORMAT_BGR:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/* The first component stored in @plane */
+static guint
+plane_component (GstVideoFrame * frame, guint plane)
+{
+  guint i;
+
+  for (i = 0; i < GST_VIDEO_FRAME_N_COMPONENTS (frame); i++)
+    if (GST_VIDEO_FRAME_COMP_PLANE (frame, i) == plane)
+      return i;
+
+  return 0;
+}
+
+/* Copies the rectangle at @sx,@sy of @src to @dx,@dy of @dest, all in pixels
+ * of the frame. The coordinates must be multiples of the subsampling */
+static void
+copy_rect (GstVideoFrame * dest, gint dx, gint dy, GstVideoFrame * src,
+    gint sx, gint sy, gint width, gint height)
+{
+  const GstVideoFormatInfo *finfo = dest->info.finfo;
+  guint plane;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (dest); plane++) {
+    guint comp = plane_component (dest, plane);
+    gint pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (dest, comp);
+    gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (dest, plane);
+    gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (src, plane);
+    gint x0, y0, row_bytes, rows, i;
+    guint8 *d;
+    const guint8 *s;
+
+    row_bytes = (GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, comp, dx + width) -
+        GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, comp, dx)) * pstride;
+    rows = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, comp, dy + height) -
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, comp, dy);
+
+    x0 = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, comp, dx);
+    y0 = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, comp, dy);
+    d = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (dest, plane) + y0 * dstride +
+        x0 * pstride;
+
+    x0 = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, comp, sx);
+    y0 = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, comp, sy);
+    s = (const guint8 *) GST_VIDEO_FRAME_PLANE_DATA (src, plane) +
+        y0 * sstride + x0 * pstride;
+
+    for (i = 0; i < rows; i++) {
+      memcpy (d, s, row_bytes);
+      d += dstride;
+      s += sstride;
+    }
+  }
+}
+
+static void
+crossfade (gdouble progress, GstVideoFrame * from, GstVideoFrame * to,
+    GstVideoFrame * dest)
+{
+  gint alpha = CLAMP ((gint) (progress * 256.0 + 0.5), 0, 256);
+  guint plane;
+
+  copy_rect (dest, 0, 0, from, 0, 0, GST_VIDEO_FRAME_WIDTH (dest),
+      GST_VIDEO_FRAME_HEIGHT (dest));
+  if (alpha == 0)
+    return;
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (dest); plane++) {
+    guint comp = plane_component (dest, plane);
+
+    compositor_orc_blend_u8 (GST_VIDEO_FRAME_PLANE_DATA (dest, plane),
+        GST_VIDEO_FRAME_PLANE_STRIDE (dest, plane),
+        GST_VIDEO_FRAME_PLANE_DATA (to, plane),
+        GST_VIDEO_FRAME_PLANE_STRIDE (to, plane), alpha,
+        GST_VIDEO_FRAME_COMP_WIDTH (dest, comp) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (dest, comp),
+        GST_VIDEO_FRAME_COMP_HEIGHT (dest, comp));
+  }
+}
+
+/* Rounds @pos to a multiple of the subsampling in that direction */
+static gint
+align_position (const GstVideoFormatInfo * finfo, gint pos, gboolean vertical)
+{
+  guint i, sub = 0;
+
+  for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (finfo); i++)
+    sub = MAX (sub, vertical ? GST_VIDEO_FORMAT_INFO_H_SUB (finfo, i) :
+        GST_VIDEO_FORMAT_INFO_W_SUB (finfo, i));
+
+  return pos & ~((1 << sub) - 1);
+}
+
+/**
+ * gst_compositor_transition_frames:
+ * @transition: the transition
+ * @progress: how far the transition is, from 0.0 for all of @from to 1.0 for
+ *   all of @to
+ * @from: the frame transitioned from
+ * @to: the frame transitioned to
+ * @dest: the output frame
+ *
+ * All frames must have the same format, one supported by
+ * gst_compositor_transition_supports_format(), and the same size.
+ */
+void
+gst_compositor_transition_frames (GstCompositorTransition transition,
+    gdouble progress, GstVideoFrame * from, GstVideoFrame * to,
+    GstVideoFrame * dest)
+{
+  const GstVideoFormatInfo *finfo = dest->info.finfo;
+  gint width = GST_VIDEO_FRAME_WIDTH (dest);
+  gint height = GST_VIDEO_FRAME_HEIGHT (dest);
+  gint x, y;
+
+  g_return_if_fail (GST_VIDEO_FRAME_FORMAT (from) ==
+      GST_VIDEO_FRAME_FORMAT (dest)
+      && GST_VIDEO_FRAME_FORMAT (to) == GST_VIDEO_FRAME_FORMAT (dest));
+  g_return_if_fail (GST_VIDEO_FRAME_WIDTH (from) == width &&
+      GST_VIDEO_FRAME_WIDTH (to) == width);
+  g_return_if_fail (GST_VIDEO_FRAME_HEIGHT (from) == height &&
+      GST_VIDEO_FRAME_HEIGHT (to) == height);
+
+  progress = CLAMP (progress, 0.0, 1.0);
+  x = align_position (finfo, (gint) (width * progress + 0.5), FALSE);
+  y = align_position (finfo, (gint) (height * progress + 0.5), TRUE);
+
+  switch (transition) {
+    case COMPOSITOR_TRANSITION_CROSSFADE:
+      crossfade (progress, from, to, dest);
+      break;
+    case COMPOSITOR_TRANSITION_WIPE_LEFT:
+      x = align_position (finfo, width - x, FALSE);
+      copy_rect (dest, 0, 0, from, 0, 0, x, height);
+      copy_rect (dest, x, 0, to, x, 0, width - x, height);
+      break;
+    case COMPOSITOR_TRANSITION_WIPE_RIGHT:
+      copy_rect (dest, 0, 0, to, 0, 0, x, height);
+      copy_rect (dest, x, 0, from, x, 0, width - x, height);
+      break;
+    case COMPOSITOR_TRANSITION_WIPE_UP:
+      y = align_position (finfo, height - y, TRUE);
+      copy_rect (dest, 0, 0, from, 0, 0, width, y);
+      copy_rect (dest, 0, y, to, 0, y, width, height - y);
+      break;
+    case COMPOSITOR_TRANSITION_WIPE_DOWN:
+      copy_rect (dest, 0, 0, to, 0, 0, width, y);
+      copy_rect (dest, 0, y, from, 0, y, width, height - y);
+      break;
+    case COMPOSITOR_TRANSITION_SLIDE_LEFT:
+      /* the frames are copied at the other end, which needs the remaining
+       * size to be aligned as well */
+      x = width - align_position (finfo, width - x, FALSE);
+      copy_rect (dest, 0, 0, from, x, 0, width - x, height);
+      copy_rect (dest, width - x, 0, to, 0, 0, x, height);
+      break;
+    case COMPOSITOR_TRANSITION_SLIDE_RIGHT:
+      x = width - align_position (finfo, width - x, FALSE);
+      copy_rect (dest, 0, 0, to, width - x, 0, x, height);
+      copy_rect (dest, x, 0, from, 0, 0, width - x, height);
+      break;
+    case COMPOSITOR_TRANSITION_SLIDE_UP:
+      y = height - align_position (finfo, height - y, TRUE);
+      copy_rect (dest, 0, 0, from, 0, y, width, height - y);
+      copy_rect (dest, 0, height - y, to, 0, 0, width, y);
+      break;
+    case COMPOSITOR_TRANSITION_SLIDE_DOWN:
+      y = height - align_position (finfo, height - y, TRUE);
+      copy_rect (dest, 0, 0, to, 0, height - y, width, y);
+      copy_rect (dest, 0, y, from, 0, 0, width, height - y);
+      break;
+  }
+}
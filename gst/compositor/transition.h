@@ -0,0 +1,62 @@
+/* GStreamer compositor transitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TRANSITION_H__
+#define __TRANSITION_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+/**
+ * GstCompositorTransition:
+ * @COMPOSITOR_TRANSITION_CROSSFADE: Fade from one pad to the next
+ * @COMPOSITOR_TRANSITION_WIPE_LEFT: The next pad is uncovered from the right
+ *   to the left
+ * @COMPOSITOR_TRANSITION_WIPE_RIGHT: The next pad is uncovered from the left
+ *   to the right
+ * @COMPOSITOR_TRANSITION_WIPE_UP: The next pad is uncovered from the bottom
+ *   to the top
+ * @COMPOSITOR_TRANSITION_WIPE_DOWN: The next pad is uncovered from the top
+ *   to the bottom
+ * @COMPOSITOR_TRANSITION_SLIDE_LEFT: Both pads slide to the left
+ * @COMPOSITOR_TRANSITION_SLIDE_RIGHT: Both pads slide to the right
+ * @COMPOSITOR_TRANSITION_SLIDE_UP: Both pads slide up
+ * @COMPOSITOR_TRANSITION_SLIDE_DOWN: Both pads slide down
+ *
+ * How a pad with a crossfade-ratio transitions to the following pad.
+ */
+typedef enum
+{
+  COMPOSITOR_TRANSITION_CROSSFADE,
+  COMPOSITOR_TRANSITION_WIPE_LEFT,
+  COMPOSITOR_TRANSITION_WIPE_RIGHT,
+  COMPOSITOR_TRANSITION_WIPE_UP,
+  COMPOSITOR_TRANSITION_WIPE_DOWN,
+  COMPOSITOR_TRANSITION_SLIDE_LEFT,
+  COMPOSITOR_TRANSITION_SLIDE_RIGHT,
+  COMPOSITOR_TRANSITION_SLIDE_UP,
+  COMPOSITOR_TRANSITION_SLIDE_DOWN,
+} GstCompositorTransition;
+
+gboolean gst_compositor_transition_supports_format (GstVideoFormat format);
+
+void gst_compositor_transition_frames (GstCompositorTransition transition,
+    gdouble progress, GstVideoFrame * from, GstVideoFrame * to,
+    GstVideoFrame * dest);
+
+#endif /* __TRANSITION_H__ */
@@ -29,6 +29,7 @@ GType gst_chop_my_data_get_type (void);
 GType gst_compare_get_type (void);
 GType gst_debug_spy_get_type (void);
 GType gst_error_ignore_get_type (void);
+GType gst_latency_probe_get_type (void);
 GType gst_watchdog_get_type (void);
 
 static gboolean
@@ -48,6 +49,8 @@ plugin_init (GstPlugin * plugin)
       gst_watchdog_get_type ());
   gst_element_register (plugin, "errorignore", GST_RANK_NONE,
       gst_error_ignore_get_type ());
+  gst_element_register (plugin, "latencyprobe", GST_RANK_NONE,
+      gst_latency_probe_get_type ());
 
   return TRUE;
 }
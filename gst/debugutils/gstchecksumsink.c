@@ -25,6 +25,19 @@
 #include <gst/base/gstbasesink.h>
 #include "gstchecksumsink.h"
 
+#include <string.h>
+
+#if HAVE_CPU_X86_64 && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || \
+    defined(__clang__))
+#define HAVE_SSE42_CRC32 1
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define HAVE_ARM_CRC32 1
+#endif
+
 static void gst_checksum_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_checksum_sink_get_property (GObject * object, guint prop_id,
@@ -34,6 +47,10 @@ static void gst_checksum_sink_finalize (GObject * object);
 
 static gboolean gst_checksum_sink_start (GstBaseSink * sink);
 static gboolean gst_checksum_sink_stop (GstBaseSink * sink);
+static gboolean gst_checksum_sink_set_caps (GstBaseSink * sink,
+    GstCaps * caps);
+static gboolean gst_checksum_sink_event (GstBaseSink * sink,
+    GstEvent * event);
 static GstFlowReturn
 gst_checksum_sink_render (GstBaseSink * sink, GstBuffer * buffer);
 
@@ -41,8 +58,18 @@ enum
 {
   PROP_0,
   PROP_HASH,
+  PROP_PLANE_CHECKSUMS,
+  PROP_THREADS
 };
 
+#define DEFAULT_HASH G_CHECKSUM_SHA1
+#define DEFAULT_PLANE_CHECKSUMS FALSE
+#define DEFAULT_THREADS 1
+
+/* the hashes that are not from GChecksum, after the GChecksumType values */
+#define HASH_CRC32C 0x100
+#define HASH_XXH64 0x101
+
 static GstStaticPadTemplate gst_checksum_sink_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -69,6 +96,8 @@ gst_checksum_sink_hash_get_type (void)
       {G_CHECKSUM_SHA1, "SHA-1", "sha1"},
       {G_CHECKSUM_SHA256, "SHA-256", "sha256"},
       {G_CHECKSUM_SHA512, "SHA-512", "sha512"},
+      {HASH_CRC32C, "CRC-32C (not cryptographic, fast)", "crc32c"},
+      {HASH_XXH64, "xxHash64 (not cryptographic, fast)", "xxh64"},
       {0, NULL, NULL},
     };
 
@@ -77,6 +106,307 @@ gst_checksum_sink_hash_get_type (void)
   return gtype;
 }
 
+/* CRC-32C (Castagnoli), with the CRC instructions of the CPU if there are
+ * some and slicing-by-8 otherwise */
+
+static guint32 crc32c_table[8][256];
+
+static void
+crc32c_init_table (void)
+{
+  guint32 crc;
+  guint i, j;
+
+  for (i = 0; i < 256; i++) {
+    crc = i;
+    for (j = 0; j < 8; j++)
+      crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+    crc32c_table[0][i] = crc;
+  }
+  for (i = 0; i < 256; i++) {
+    crc = crc32c_table[0][i];
+    for (j = 1; j < 8; j++) {
+      crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+      crc32c_table[j][i] = crc;
+    }
+  }
+}
+
+static guint32
+crc32c_update_table (guint32 crc, const guint8 * data, gsize size)
+{
+  while (size && ((guintptr) data & 7)) {
+    crc = crc32c_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    size--;
+  }
+  while (size >= 8) {
+    guint64 v = GUINT64_FROM_LE (*(const guint64 *) data) ^ crc;
+
+    crc = crc32c_table[7][v & 0xff] ^ crc32c_table[6][(v >> 8) & 0xff] ^
+        crc32c_table[5][(v >> 16) & 0xff] ^ crc32c_table[4][(v >> 24) & 0xff]
+        ^ crc32c_table[3][(v >> 32) & 0xff] ^
+        crc32c_table[2][(v >> 40) & 0xff] ^ crc32c_table[1][(v >> 48) & 0xff]
+        ^ crc32c_table[0][v >> 56];
+    data += 8;
+    size -= 8;
+  }
+  while (size--)
+    crc = crc32c_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+
+  return crc;
+}
+
+#ifdef HAVE_SSE42_CRC32
+__attribute__ ((target ("sse4.2")))
+static guint32
+crc32c_update_sse42 (guint32 crc, const guint8 * data, gsize size)
+{
+  guint64 crc64;
+
+  while (size && ((guintptr) data & 7)) {
+    crc = __builtin_ia32_crc32qi (crc, *data++);
+    size--;
+  }
+  crc64 = crc;
+  while (size >= 8) {
+    crc64 = __builtin_ia32_crc32di (crc64, *(const guint64 *) data);
+    data += 8;
+    size -= 8;
+  }
+  crc = crc64;
+  while (size--)
+    crc = __builtin_ia32_crc32qi (crc, *data++);
+
+  return crc;
+}
+#endif
+
+#ifdef HAVE_ARM_CRC32
+static guint32
+crc32c_update_arm (guint32 crc, const guint8 * data, gsize size)
+{
+  while (size && ((guintptr) data & 7)) {
+    crc = __crc32cb (crc, *data++);
+    size--;
+  }
+  while (size >= 8) {
+    crc = __crc32cd (crc, *(const guint64 *) data);
+    data += 8;
+    size -= 8;
+  }
+  while (size--)
+    crc = __crc32cb (crc, *data++);
+
+  return crc;
+}
+#endif
+
+static guint32 (*crc32c_update) (guint32 crc, const guint8 * data,
+    gsize size) = crc32c_update_table;
+
+/* xxHash64 with seed 0, see https://github.com/Cyan4973/xxHash */
+
+#define XXH_PRIME64_1 G_GUINT64_CONSTANT (0x9E3779B185EBCA87)
+#define XXH_PRIME64_2 G_GUINT64_CONSTANT (0xC2B2AE3D27D4EB4F)
+#define XXH_PRIME64_3 G_GUINT64_CONSTANT (0x165667B19E3779F9)
+#define XXH_PRIME64_4 G_GUINT64_CONSTANT (0x85EBCA77C2B2AE63)
+#define XXH_PRIME64_5 G_GUINT64_CONSTANT (0x27D4EB2F165667C5)
+#define XXH_ROTL64(x,r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+typedef struct
+{
+  guint64 total_len;
+  guint64 v[4];
+  guint8 mem[32];
+  guint memsize;
+} Xxh64State;
+
+static inline guint64
+xxh64_read64 (const guint8 * p)
+{
+  guint64 v;
+
+  memcpy (&v, p, 8);
+  return GUINT64_FROM_LE (v);
+}
+
+static inline guint32
+xxh64_read32 (const guint8 * p)
+{
+  guint32 v;
+
+  memcpy (&v, p, 4);
+  return GUINT32_FROM_LE (v);
+}
+
+static inline guint64
+xxh64_round (guint64 acc, guint64 input)
+{
+  acc += input * XXH_PRIME64_2;
+  acc = XXH_ROTL64 (acc, 31);
+  return acc * XXH_PRIME64_1;
+}
+
+static inline guint64
+xxh64_merge_round (guint64 acc, guint64 val)
+{
+  acc ^= xxh64_round (0, val);
+  return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void
+xxh64_init (Xxh64State * state)
+{
+  memset (state, 0, sizeof (Xxh64State));
+  state->v[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+  state->v[1] = XXH_PRIME64_2;
+  state->v[2] = 0;
+  state->v[3] = -XXH_PRIME64_1;
+}
+
+static inline void
+xxh64_stripe (Xxh64State * state, const guint8 * p)
+{
+  state->v[0] = xxh64_round (state->v[0], xxh64_read64 (p));
+  state->v[1] = xxh64_round (state->v[1], xxh64_read64 (p + 8));
+  state->v[2] = xxh64_round (state->v[2], xxh64_read64 (p + 16));
+  state->v[3] = xxh64_round (state->v[3], xxh64_read64 (p + 24));
+}
+
+static void
+xxh64_update (Xxh64State * state, const guint8 * data, gsize size)
+{
+  state->total_len += size;
+
+  if (state->memsize + size < 32) {
+    memcpy (state->mem + state->memsize, data, size);
+    state->memsize += size;
+    return;
+  }
+
+  if (state->memsize) {
+    guint fill = 32 - state->memsize;
+
+    memcpy (state->mem + state->memsize, data, fill);
+    xxh64_stripe (state, state->mem);
+    data += fill;
+    size -= fill;
+    state->memsize = 0;
+  }
+
+  while (size >= 32) {
+    xxh64_stripe (state, data);
+    data += 32;
+    size -= 32;
+  }
+
+  if (size) {
+    memcpy (state->mem, data, size);
+    state->memsize = size;
+  }
+}
+
+static guint64
+xxh64_digest (const Xxh64State * state)
+{
+  const guint8 *p = state->mem;
+  guint remaining = state->memsize;
+  guint64 h;
+
+  if (state->total_len >= 32) {
+    h = XXH_ROTL64 (state->v[0], 1) + XXH_ROTL64 (state->v[1], 7) +
+        XXH_ROTL64 (state->v[2], 12) + XXH_ROTL64 (state->v[3], 18);
+    h = xxh64_merge_round (h, state->v[0]);
+    h = xxh64_merge_round (h, state->v[1]);
+    h = xxh64_merge_round (h, state->v[2]);
+    h = xxh64_merge_round (h, state->v[3]);
+  } else {
+    h = state->v[2] + XXH_PRIME64_5;
+  }
+
+  h += state->total_len;
+
+  while (remaining >= 8) {
+    h ^= xxh64_round (0, xxh64_read64 (p));
+    h = XXH_ROTL64 (h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    p += 8;
+    remaining -= 8;
+  }
+  if (remaining >= 4) {
+    h ^= (guint64) xxh64_read32 (p) * XXH_PRIME64_1;
+    h = XXH_ROTL64 (h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+    p += 4;
+    remaining -= 4;
+  }
+  while (remaining--) {
+    h ^= (*p++) * XXH_PRIME64_5;
+    h = XXH_ROTL64 (h, 11) * XXH_PRIME64_1;
+  }
+
+  h ^= h >> 33;
+  h *= XXH_PRIME64_2;
+  h ^= h >> 29;
+  h *= XXH_PRIME64_3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+/* incremental hashing with any of the hash types */
+
+typedef struct
+{
+  gint type;
+  GChecksum *checksum;
+  guint32 crc;
+  Xxh64State xxh;
+} ChecksumState;
+
+static void
+checksum_state_init (ChecksumState * state, gint type)
+{
+  state->type = type;
+  state->checksum = NULL;
+
+  if (type == HASH_CRC32C)
+    state->crc = 0xffffffff;
+  else if (type == HASH_XXH64)
+    xxh64_init (&state->xxh);
+  else
+    state->checksum = g_checksum_new (type);
+}
+
+static void
+checksum_state_update (ChecksumState * state, const guint8 * data,
+    gsize size)
+{
+  if (state->type == HASH_CRC32C)
+    state->crc = crc32c_update (state->crc, data, size);
+  else if (state->type == HASH_XXH64)
+    xxh64_update (&state->xxh, data, size);
+  else
+    g_checksum_update (state->checksum, data, size);
+}
+
+/* returns the hash in hexadecimal and frees the state */
+static gchar *
+checksum_state_finish (ChecksumState * state)
+{
+  gchar *s;
+
+  if (state->type == HASH_CRC32C) {
+    s = g_strdup_printf ("%08x", ~state->crc);
+  } else if (state->type == HASH_XXH64) {
+    s = g_strdup_printf ("%016" G_GINT64_MODIFIER "x",
+        xxh64_digest (&state->xxh));
+  } else {
+    s = g_strdup (g_checksum_get_string (state->checksum));
+    g_checksum_free (state->checksum);
+  }
+
+  return s;
+}
+
 #define gst_checksum_sink_parent_class parent_class
 G_DEFINE_TYPE (GstChecksumSink, gst_checksum_sink, GST_TYPE_BASE_SINK);
 
@@ -93,6 +423,8 @@ gst_checksum_sink_class_init (GstChecksumSinkClass * klass)
   gobject_class->finalize = gst_checksum_sink_finalize;
   base_sink_class->start = GST_DEBUG_FUNCPTR (gst_checksum_sink_start);
   base_sink_class->stop = GST_DEBUG_FUNCPTR (gst_checksum_sink_stop);
+  base_sink_class->set_caps = GST_DEBUG_FUNCPTR (gst_checksum_sink_set_caps);
+  base_sink_class->event = GST_DEBUG_FUNCPTR (gst_checksum_sink_event);
   base_sink_class->render = GST_DEBUG_FUNCPTR (gst_checksum_sink_render);
 
   gst_element_class_add_static_pad_template (element_class,
@@ -102,8 +434,28 @@ gst_checksum_sink_class_init (GstChecksumSinkClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_HASH,
       g_param_spec_enum ("hash", "Hash", "Checksum type",
-          gst_checksum_sink_hash_get_type (), G_CHECKSUM_SHA1,
+          gst_checksum_sink_hash_get_type (), DEFAULT_HASH,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PLANE_CHECKSUMS,
+      g_param_spec_boolean ("plane-checksums", "Plane checksums",
+          "For raw video, print one checksum per plane, computed over the "
+          "visible pixels only so that the row padding does not matter",
+          DEFAULT_PLANE_CHECKSUMS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads hashing buffers in parallel, the checksums are "
+          "still printed in order (0 = number of processors)", 0, G_MAXINT,
+          DEFAULT_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  crc32c_init_table ();
+#ifdef HAVE_SSE42_CRC32
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("sse4.2"))
+    crc32c_update = crc32c_update_sse42;
+#endif
+#ifdef HAVE_ARM_CRC32
+  crc32c_update = crc32c_update_arm;
+#endif
 
   gst_element_class_set_static_metadata (element_class, "Checksum sink",
       "Debug/Sink", "Calculates a checksum for buffers",
@@ -114,7 +466,12 @@ static void
 gst_checksum_sink_init (GstChecksumSink * checksumsink)
 {
   gst_base_sink_set_sync (GST_BASE_SINK (checksumsink), FALSE);
-  checksumsink->hash = G_CHECKSUM_SHA1;
+  checksumsink->hash = DEFAULT_HASH;
+  checksumsink->plane_checksums = DEFAULT_PLANE_CHECKSUMS;
+  checksumsink->threads = DEFAULT_THREADS;
+  g_queue_init (&checksumsink->pending);
+  g_mutex_init (&checksumsink->lock);
+  g_cond_init (&checksumsink->cond);
 }
 
 static void
@@ -127,6 +484,12 @@ gst_checksum_sink_set_property (GObject * object, guint prop_id,
     case PROP_HASH:
       checksumsink->hash = g_value_get_enum (value);
       break;
+    case PROP_PLANE_CHECKSUMS:
+      checksumsink->plane_checksums = g_value_get_boolean (value);
+      break;
+    case PROP_THREADS:
+      checksumsink->threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -143,6 +506,12 @@ gst_checksum_sink_get_property (GObject * object, guint prop_id,
     case PROP_HASH:
       g_value_set_enum (value, checksumsink->hash);
       break;
+    case PROP_PLANE_CHECKSUMS:
+      g_value_set_boolean (value, checksumsink->plane_checksums);
+      break;
+    case PROP_THREADS:
+      g_value_set_uint (value, checksumsink->threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -158,36 +527,251 @@ gst_checksum_sink_dispose (GObject * object)
 static void
 gst_checksum_sink_finalize (GObject * object)
 {
+  GstChecksumSink *checksumsink = GST_CHECKSUM_SINK (object);
+
+  g_mutex_clear (&checksumsink->lock);
+  g_cond_clear (&checksumsink->cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+typedef struct
+{
+  GstBuffer *buffer;
+  gint hash;
+  gboolean planes;
+  GstVideoInfo vinfo;
+
+  gchar *result;
+  gboolean done;
+} ChecksumJob;
+
+/* The visible bytes of each row of @plane, or 0 if the format has no pixel
+ * stride to know them */
+static gsize
+gst_checksum_sink_plane_row_size (GstVideoFrame * frame, guint plane,
+    guint * rows)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  guint i;
+
+  for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (finfo); i++) {
+    if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, i) != plane)
+      continue;
+
+    *rows = GST_VIDEO_FRAME_COMP_HEIGHT (frame, i);
+    if (GST_VIDEO_FORMAT_INFO_PSTRIDE (finfo, i) <= 0
+        || GST_VIDEO_FORMAT_INFO_IS_TILED (finfo) || finfo->pack_lines != 1)
+      return 0;
+
+    return GST_VIDEO_FRAME_COMP_WIDTH (frame, i) *
+        GST_VIDEO_FORMAT_INFO_PSTRIDE (finfo, i);
+  }
+
+  return 0;
+}
+
+static gchar *
+gst_checksum_sink_compute_planes (ChecksumJob * job)
+{
+  GstVideoFrame frame;
+  ChecksumState state;
+  GString *s;
+  guint plane, rows, row;
+  gsize row_size;
+  gint stride;
+  guint8 *data;
+  gchar *hash;
+
+  if (!gst_video_frame_map (&frame, &job->vinfo, job->buffer, GST_MAP_READ))
+    return NULL;
+
+  s = g_string_new (NULL);
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (&frame); plane++) {
+    row_size = gst_checksum_sink_plane_row_size (&frame, plane, &rows);
+    if (!row_size) {
+      /* can't tell the padding apart from the pixels */
+      gst_video_frame_unmap (&frame);
+      g_string_free (s, TRUE);
+      return NULL;
+    }
+
+    data = GST_VIDEO_FRAME_PLANE_DATA (&frame, plane);
+    stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, plane);
+    checksum_state_init (&state, job->hash);
+    if (stride == (gint) row_size) {
+      checksum_state_update (&state, data, row_size * rows);
+    } else {
+      for (row = 0; row < rows; row++)
+        checksum_state_update (&state, data + row * stride, row_size);
+    }
+
+    hash = checksum_state_finish (&state);
+    g_string_append_printf (s, "%s%s", plane ? " " : "", hash);
+    g_free (hash);
+  }
+  gst_video_frame_unmap (&frame);
+
+  return g_string_free (s, FALSE);
+}
+
+static void
+gst_checksum_sink_compute (ChecksumJob * job)
+{
+  ChecksumState state;
+  GstMapInfo map;
+
+  if (job->planes)
+    job->result = gst_checksum_sink_compute_planes (job);
+
+  if (!job->result) {
+    gst_buffer_map (job->buffer, &map, GST_MAP_READ);
+    checksum_state_init (&state, job->hash);
+    checksum_state_update (&state, map.data, map.size);
+    job->result = checksum_state_finish (&state);
+    gst_buffer_unmap (job->buffer, &map);
+  }
+}
+
+static void
+gst_checksum_sink_print_job (ChecksumJob * job)
+{
+  g_print ("%" GST_TIME_FORMAT " %s\n",
+      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (job->buffer)), job->result);
+
+  gst_buffer_unref (job->buffer);
+  g_free (job->result);
+  g_free (job);
+}
+
+static void
+gst_checksum_sink_job_func (ChecksumJob * job, GstChecksumSink * checksumsink)
+{
+  gst_checksum_sink_compute (job);
+
+  g_mutex_lock (&checksumsink->lock);
+  job->done = TRUE;
+  g_cond_broadcast (&checksumsink->cond);
+  g_mutex_unlock (&checksumsink->lock);
+}
+
+/* Prints the checksums of the jobs that are done, in order, waiting for the
+ * oldest ones until at most @max_pending are left */
+static void
+gst_checksum_sink_finish_jobs (GstChecksumSink * checksumsink,
+    guint max_pending)
+{
+  ChecksumJob *job;
+
+  g_mutex_lock (&checksumsink->lock);
+  while ((job = g_queue_peek_head (&checksumsink->pending))) {
+    if (!job->done) {
+      if (g_queue_get_length (&checksumsink->pending) <= max_pending)
+        break;
+      g_cond_wait (&checksumsink->cond, &checksumsink->lock);
+      continue;
+    }
+
+    g_queue_pop_head (&checksumsink->pending);
+    g_mutex_unlock (&checksumsink->lock);
+    gst_checksum_sink_print_job (job);
+    g_mutex_lock (&checksumsink->lock);
+  }
+  g_mutex_unlock (&checksumsink->lock);
+}
+
 static gboolean
 gst_checksum_sink_start (GstBaseSink * sink)
 {
+  GstChecksumSink *checksumsink = GST_CHECKSUM_SINK (sink);
+
+  checksumsink->is_video = FALSE;
+  checksumsink->n_threads = checksumsink->threads;
+  if (checksumsink->n_threads == 0)
+    checksumsink->n_threads = g_get_num_processors ();
+
+  if (checksumsink->n_threads > 1) {
+    checksumsink->pool =
+        g_thread_pool_new ((GFunc) gst_checksum_sink_job_func, checksumsink,
+        checksumsink->n_threads, FALSE, NULL);
+    if (!checksumsink->pool)
+      checksumsink->n_threads = 1;
+  }
+
   return TRUE;
 }
 
 static gboolean
 gst_checksum_sink_stop (GstBaseSink * sink)
 {
+  GstChecksumSink *checksumsink = GST_CHECKSUM_SINK (sink);
+
+  if (checksumsink->pool) {
+    gst_checksum_sink_finish_jobs (checksumsink, 0);
+    g_thread_pool_free (checksumsink->pool, FALSE, TRUE);
+    checksumsink->pool = NULL;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_checksum_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
+{
+  GstChecksumSink *checksumsink = GST_CHECKSUM_SINK (sink);
+
+  /* the pending buffers are hashed with the info they were queued with, this
+   * only keeps the output in order */
+  if (checksumsink->pool)
+    gst_checksum_sink_finish_jobs (checksumsink, 0);
+
+  checksumsink->is_video = gst_video_info_from_caps (&checksumsink->vinfo,
+      caps);
+
   return TRUE;
 }
 
+static gboolean
+gst_checksum_sink_event (GstBaseSink * sink, GstEvent * event)
+{
+  GstChecksumSink *checksumsink = GST_CHECKSUM_SINK (sink);
+
+  if (checksumsink->pool && (GST_EVENT_TYPE (event) == GST_EVENT_EOS
+          || GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP))
+    gst_checksum_sink_finish_jobs (checksumsink, 0);
+
+  return GST_BASE_SINK_CLASS (parent_class)->event (sink, event);
+}
+
 static GstFlowReturn
 gst_checksum_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
-  gchar *s;
-  GstMapInfo map;
   GstChecksumSink *checksumsink;
+  ChecksumJob *job;
 
   checksumsink = GST_CHECKSUM_SINK (sink);
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  s = g_compute_checksum_for_data (checksumsink->hash, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
-  g_print ("%" GST_TIME_FORMAT " %s\n",
-      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)), s);
 
-  g_free (s);
+  job = g_new0 (ChecksumJob, 1);
+  job->buffer = gst_buffer_ref (buffer);
+  job->hash = checksumsink->hash;
+  job->planes = checksumsink->plane_checksums && checksumsink->is_video;
+  if (job->planes)
+    job->vinfo = checksumsink->vinfo;
+
+  if (!checksumsink->pool) {
+    gst_checksum_sink_compute (job);
+    gst_checksum_sink_print_job (job);
+    return GST_FLOW_OK;
+  }
+
+  /* keep one buffer per thread in flight, they are held from upstream
+   * until hashed */
+  g_mutex_lock (&checksumsink->lock);
+  g_queue_push_tail (&checksumsink->pending, job);
+  g_mutex_unlock (&checksumsink->lock);
+  g_thread_pool_push (checksumsink->pool, job, NULL);
+
+  gst_checksum_sink_finish_jobs (checksumsink, checksumsink->n_threads);
 
   return GST_FLOW_OK;
 }
@@ -22,6 +22,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
+#include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
@@ -37,7 +38,21 @@ typedef struct _GstChecksumSinkClass GstChecksumSinkClass;
 struct _GstChecksumSink
 {
   GstBaseSink base_checksumsink;
-  GChecksumType hash;
+
+  /* properties */
+  gint hash;
+  gboolean plane_checksums;
+  guint threads;
+
+  gboolean is_video;
+  GstVideoInfo vinfo;
+
+  /* buffers hashed by the pool, printed in order by the streaming thread */
+  GThreadPool *pool;
+  guint n_threads;
+  GQueue pending;
+  GMutex lock;
+  GCond cond;
 };
 
 struct _GstChecksumSinkClass
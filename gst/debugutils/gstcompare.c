@@ -91,7 +91,8 @@ enum
   PROP_OFFSET_TS,
   PROP_METHOD,
   PROP_THRESHOLD,
-  PROP_UPPER
+  PROP_UPPER,
+  PROP_SAMPLE_INTERVAL
 };
 
 #define DEFAULT_META             GST_BUFFER_COPY_ALL
@@ -99,6 +100,7 @@ enum
 #define DEFAULT_METHOD           GST_COMPARE_METHOD_MEM
 #define DEFAULT_THRESHOLD        0
 #define DEFAULT_UPPER            TRUE
+#define DEFAULT_SAMPLE_INTERVAL  1
 
 static void gst_compare_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
@@ -168,6 +170,11 @@ gst_compare_class_init (GstCompareClass * klass)
       g_param_spec_boolean ("upper", "Threshold Upper Bound",
           "Whether threshold value is upper bound or lower bound for difference measure",
           DEFAULT_UPPER, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SAMPLE_INTERVAL,
+      g_param_spec_uint ("sample-interval", "Sample Interval",
+          "Only compare every Nth pair of buffers, the others are passed "
+          "through unchecked", 1, G_MAXUINT, DEFAULT_SAMPLE_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_factory);
@@ -210,6 +217,7 @@ gst_compare_init (GstCompare * comp)
   comp->method = DEFAULT_METHOD;
   comp->threshold = DEFAULT_THRESHOLD;
   comp->upper = DEFAULT_UPPER;
+  comp->sample_interval = DEFAULT_SAMPLE_INTERVAL;
 
   gst_compare_reset (comp);
 }
@@ -217,6 +225,7 @@ gst_compare_init (GstCompare * comp)
 static void
 gst_compare_reset (GstCompare * comp)
 {
+  comp->n_pairs = 0;
 }
 
 static gboolean
@@ -308,7 +317,11 @@ gst_compare_mem (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   gst_buffer_map (buf1, &map1, GST_MAP_READ);
   gst_buffer_map (buf2, &map2, GST_MAP_READ);
 
-  c = memcmp (map1.data, map2.data, map1.size);
+  /* both branches of a tee usually carry the very same memory */
+  if (map1.data == map2.data)
+    c = 0;
+  else
+    c = memcmp (map1.data, map2.data, map1.size);
 
   gst_buffer_unmap (buf1, &map1);
   gst_buffer_unmap (buf2, &map2);
@@ -518,7 +531,7 @@ gst_compare_buffers (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   gst_compare_meta (comp, buf1, caps1, buf2, caps2);
 
   size1 = gst_buffer_get_size (buf1);
-  size2 = gst_buffer_get_size (buf1);
+  size2 = gst_buffer_get_size (buf2);
 
   /* check content according to method */
   /* but at least size should match */
@@ -527,12 +540,15 @@ gst_compare_buffers (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   } else {
     GstMapInfo map1, map2;
 
-    gst_buffer_map (buf1, &map1, GST_MAP_READ);
-    gst_buffer_map (buf2, &map2, GST_MAP_READ);
-    GST_MEMDUMP_OBJECT (comp, "buffer 1", map1.data, map2.size);
-    GST_MEMDUMP_OBJECT (comp, "buffer 2", map2.data, map2.size);
-    gst_buffer_unmap (buf1, &map1);
-    gst_buffer_unmap (buf2, &map2);
+    if (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
+        GST_LEVEL_MEMDUMP) {
+      gst_buffer_map (buf1, &map1, GST_MAP_READ);
+      gst_buffer_map (buf2, &map2, GST_MAP_READ);
+      GST_MEMDUMP_OBJECT (comp, "buffer 1", map1.data, map2.size);
+      GST_MEMDUMP_OBJECT (comp, "buffer 2", map2.data, map2.size);
+      gst_buffer_unmap (buf1, &map1);
+      gst_buffer_unmap (buf2, &map2);
+    }
     switch (comp->method) {
       case GST_COMPARE_METHOD_MEM:
         delta = gst_compare_mem (comp, buf1, caps1, buf2, caps2);
@@ -579,7 +595,8 @@ gst_compare_collect_pads (GstCollectPads * cpads, GstCompare * comp)
     gst_pad_push_event (comp->srcpad, gst_event_new_eos ());
     return GST_FLOW_EOS;
   } else if (buf1 && buf2) {
-    gst_compare_buffers (comp, buf1, caps1, buf2, caps2);
+    if (comp->n_pairs++ % comp->sample_interval == 0)
+      gst_compare_buffers (comp, buf1, caps1, buf2, caps2);
   } else {
     GST_WARNING_OBJECT (comp, "buffer %p != NULL", buf1 ? buf1 : buf2);
 
@@ -627,6 +644,9 @@ gst_compare_set_property (GObject * object, guint prop_id,
     case PROP_UPPER:
       comp->upper = g_value_get_boolean (value);
       break;
+    case PROP_SAMPLE_INTERVAL:
+      comp->sample_interval = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -655,6 +675,9 @@ gst_compare_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_UPPER:
       g_value_set_boolean (value, comp->upper);
       break;
+    case PROP_SAMPLE_INTERVAL:
+      g_value_set_uint (value, comp->sample_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
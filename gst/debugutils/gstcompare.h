@@ -55,6 +55,7 @@ struct _GstCompare {
   GstCollectPads *cpads;
 
   gint count;
+  guint n_pairs;
 
   /* properties */
   GstBufferCopyFlags meta;
@@ -62,6 +63,7 @@ struct _GstCompare {
   gint method;
   gdouble threshold;
   gboolean upper;
+  guint sample_interval;
 };
 
 struct _GstCompareClass {
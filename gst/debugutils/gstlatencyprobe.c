@@ -0,0 +1,460 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:element-latencyprobe
+ * @title: latencyprobe
+ *
+ * The latencyprobe element measures how long buffers take to get from one
+ * point of a pipeline to another. Insert it like an identity element at
+ * each point of interest.
+ *
+ * The first probe a buffer goes through, or any probe with the stamp
+ * property set, attaches a meta with the current time to the buffer. Each
+ * following probe then records the time since that stamp as end-to-end
+ * latency, and the time since the previous probe as the latency of the
+ * segment between both, which is the latency of the elements in between.
+ * The meta is copied along by the elements that keep the metadata of
+ * their input, which includes most decoders and encoders.
+ *
+ * The results are available as count, minimum, maximum, average and a
+ * histogram of log2 buckets of microseconds in the stats property. They
+ * are not posted to the bus nor rendered, so the probes can stay in a
+ * pipeline at little cost. Adding or updating the meta needs a writable
+ * buffer, and a probe makes a shallow copy of buffers that are not.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 videotestsrc num-buffers=100 ! latencyprobe name=in ! x264enc ! latencyprobe name=out ! fakesink
+ * ]|
+ * The stats property of out then holds the latency of x264enc.
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <string.h>
+#include "gstlatencyprobe.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_latency_probe_debug_category);
+#define GST_CAT_DEFAULT gst_latency_probe_debug_category
+
+/* meta carrying the timing of a buffer from probe to probe */
+
+typedef struct
+{
+  GstMeta meta;
+
+  GstClockTime origin;
+  GstClockTime last;
+  const gchar *last_probe;
+} GstLatencyProbeMeta;
+
+#define GST_LATENCY_PROBE_META_API_TYPE \
+    (gst_latency_probe_meta_api_get_type ())
+#define GST_LATENCY_PROBE_META_INFO (gst_latency_probe_meta_get_info ())
+
+static const GstMetaInfo *gst_latency_probe_meta_get_info (void);
+
+static GType
+gst_latency_probe_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type =
+        gst_meta_api_type_register ("GstLatencyProbeMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+static gboolean
+gst_latency_probe_meta_init (GstMeta * meta, G_GNUC_UNUSED gpointer params,
+    G_GNUC_UNUSED GstBuffer * buffer)
+{
+  GstLatencyProbeMeta *lmeta = (GstLatencyProbeMeta *) meta;
+
+  lmeta->origin = GST_CLOCK_TIME_NONE;
+  lmeta->last = GST_CLOCK_TIME_NONE;
+  lmeta->last_probe = NULL;
+
+  return TRUE;
+}
+
+static gboolean
+gst_latency_probe_meta_transform (GstBuffer * dest, GstMeta * meta,
+    G_GNUC_UNUSED GstBuffer * buffer, G_GNUC_UNUSED GQuark type,
+    G_GNUC_UNUSED gpointer data)
+{
+  GstLatencyProbeMeta *smeta = (GstLatencyProbeMeta *) meta;
+  GstLatencyProbeMeta *dmeta;
+
+  /* the timing stays valid for whatever the buffer is turned into. When
+   * several buffers end up in one, keep the one waiting the longest */
+  dmeta = (GstLatencyProbeMeta *) gst_buffer_get_meta (dest,
+      GST_LATENCY_PROBE_META_API_TYPE);
+  if (dmeta) {
+    if (dmeta->origin <= smeta->origin)
+      return TRUE;
+  } else {
+    dmeta = (GstLatencyProbeMeta *) gst_buffer_add_meta (dest,
+        GST_LATENCY_PROBE_META_INFO, NULL);
+    if (!dmeta)
+      return FALSE;
+  }
+
+  dmeta->origin = smeta->origin;
+  dmeta->last = smeta->last;
+  dmeta->last_probe = smeta->last_probe;
+
+  return TRUE;
+}
+
+static const GstMetaInfo *
+gst_latency_probe_meta_get_info (void)
+{
+  static const GstMetaInfo *meta_info = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) & meta_info)) {
+    const GstMetaInfo *mi =
+        gst_meta_register (GST_LATENCY_PROBE_META_API_TYPE,
+        "GstLatencyProbeMeta", sizeof (GstLatencyProbeMeta),
+        gst_latency_probe_meta_init, NULL, gst_latency_probe_meta_transform);
+    g_once_init_leave ((GstMetaInfo **) & meta_info, (GstMetaInfo *) mi);
+  }
+  return meta_info;
+}
+
+/* prototypes */
+
+static void gst_latency_probe_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_latency_probe_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_latency_probe_finalize (GObject * object);
+
+static gboolean gst_latency_probe_start (GstBaseTransform * trans);
+static gboolean gst_latency_probe_stop (GstBaseTransform * trans);
+static GstFlowReturn gst_latency_probe_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf);
+
+enum
+{
+  PROP_0,
+  PROP_STAMP,
+  PROP_STATS
+};
+
+#define DEFAULT_STAMP FALSE
+
+/* class initialization */
+
+G_DEFINE_TYPE_WITH_CODE (GstLatencyProbe, gst_latency_probe,
+    GST_TYPE_BASE_TRANSFORM,
+    GST_DEBUG_CATEGORY_INIT (gst_latency_probe_debug_category, "latencyprobe",
+        0, "debug category for latencyprobe element"));
+
+static void
+gst_latency_probe_class_init (GstLatencyProbeClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
+
+  gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
+      gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+          gst_caps_new_any ()));
+  gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
+      gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+          gst_caps_new_any ()));
+
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "Latency probe", "Generic",
+      "Measures the latency of buffers between probes",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+
+  gobject_class->set_property = gst_latency_probe_set_property;
+  gobject_class->get_property = gst_latency_probe_get_property;
+  gobject_class->finalize = gst_latency_probe_finalize;
+  base_transform_class->start = GST_DEBUG_FUNCPTR (gst_latency_probe_start);
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_latency_probe_stop);
+  base_transform_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gst_latency_probe_transform_ip);
+
+  /**
+   * GstLatencyProbe:stamp:
+   *
+   * Restart the measurement at this probe, even if the buffers were already
+   * stamped upstream.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_STAMP,
+      g_param_spec_boolean ("stamp", "Stamp",
+          "Start the end-to-end measurement at this probe instead of "
+          "measuring from an upstream probe", DEFAULT_STAMP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLatencyProbe:stats:
+   *
+   * The latencies measured since the element was started. The
+   * "end-to-end" field holds the latency since the buffers were stamped,
+   * the "segments" array the latency since each previous probe, with
+   * the name of that probe in its "from" field. Each holds the "count",
+   * "min", "max" and "average" of the latencies in nanoseconds and a
+   * "histogram" array with the number of latencies in each bucket.
+   * Bucket i counts the latencies from 2^i to 2^(i+1) microseconds, the
+   * first one also the ones below and the last one also the ones above.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "End-to-end and per-segment latency statistics and histograms",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_latency_probe_stats_reset (GstLatencyProbeStats * stats,
+    const gchar * from)
+{
+  memset (stats, 0, sizeof (GstLatencyProbeStats));
+  stats->from = from;
+  stats->min = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_latency_probe_init (GstLatencyProbe * probe)
+{
+  probe->stamp = DEFAULT_STAMP;
+  gst_latency_probe_stats_reset (&probe->end_to_end, NULL);
+  probe->segments = g_ptr_array_new_with_free_func (g_free);
+}
+
+static void
+gst_latency_probe_finalize (GObject * object)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  g_ptr_array_unref (probe->segments);
+
+  G_OBJECT_CLASS (gst_latency_probe_parent_class)->finalize (object);
+}
+
+static void
+gst_latency_probe_stats_add (GstLatencyProbeStats * stats,
+    GstClockTime latency)
+{
+  guint64 us = latency / GST_USECOND;
+  guint bucket = us ? g_bit_storage (us) - 1 : 0;
+
+  stats->count++;
+  stats->total += latency;
+  if (latency < stats->min)
+    stats->min = latency;
+  if (latency > stats->max)
+    stats->max = latency;
+  stats->histogram[MIN (bucket, GST_LATENCY_PROBE_N_BUCKETS - 1)]++;
+}
+
+static GstStructure *
+gst_latency_probe_stats_to_structure (const GstLatencyProbeStats * stats)
+{
+  GValue histogram = G_VALUE_INIT;
+  GstStructure *s;
+  guint i;
+
+  g_value_init (&histogram, GST_TYPE_ARRAY);
+  for (i = 0; i < GST_LATENCY_PROBE_N_BUCKETS; i++) {
+    GValue v = G_VALUE_INIT;
+
+    g_value_init (&v, G_TYPE_UINT64);
+    g_value_set_uint64 (&v, stats->histogram[i]);
+    gst_value_array_append_and_take_value (&histogram, &v);
+  }
+
+  s = gst_structure_new ("latencyprobe-latency",
+      "count", G_TYPE_UINT64, stats->count,
+      "min", G_TYPE_UINT64, stats->min,
+      "max", G_TYPE_UINT64, stats->count ? stats->max : GST_CLOCK_TIME_NONE,
+      "average", G_TYPE_UINT64, stats->count ?
+      stats->total / stats->count : GST_CLOCK_TIME_NONE, NULL);
+  if (stats->from)
+    gst_structure_set (s, "from", G_TYPE_STRING, stats->from, NULL);
+  gst_structure_take_value (s, "histogram", &histogram);
+
+  return s;
+}
+
+static GstStructure *
+gst_latency_probe_get_stats (GstLatencyProbe * probe)
+{
+  GstStructure *res;
+  GValue segments = G_VALUE_INIT;
+  guint i;
+
+  g_value_init (&segments, GST_TYPE_ARRAY);
+
+  GST_OBJECT_LOCK (probe);
+  res = gst_structure_new_empty ("latencyprobe-stats");
+  gst_structure_take (res, "end-to-end", GST_TYPE_STRUCTURE,
+      gst_latency_probe_stats_to_structure (&probe->end_to_end));
+  for (i = 0; i < probe->segments->len; i++) {
+    GValue v = G_VALUE_INIT;
+
+    g_value_init (&v, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&v,
+        gst_latency_probe_stats_to_structure (g_ptr_array_index
+            (probe->segments, i)));
+    gst_value_array_append_and_take_value (&segments, &v);
+  }
+  GST_OBJECT_UNLOCK (probe);
+
+  gst_structure_take_value (res, "segments", &segments);
+
+  return res;
+}
+
+void
+gst_latency_probe_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  switch (property_id) {
+    case PROP_STAMP:
+      probe->stamp = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+void
+gst_latency_probe_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  switch (property_id) {
+    case PROP_STAMP:
+      g_value_set_boolean (value, probe->stamp);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_latency_probe_get_stats (probe));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static gboolean
+gst_latency_probe_start (GstBaseTransform * trans)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (trans);
+
+  GST_OBJECT_LOCK (probe);
+  probe->probe_name = g_intern_string (GST_OBJECT_NAME (probe));
+  gst_latency_probe_stats_reset (&probe->end_to_end, NULL);
+  g_ptr_array_set_size (probe->segments, 0);
+  GST_OBJECT_UNLOCK (probe);
+
+  return TRUE;
+}
+
+static gboolean
+gst_latency_probe_stop (GstBaseTransform * trans)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (trans);
+
+  /* the statistics are kept until the next start, so that they can still
+   * be read after the pipeline is shut down */
+  GST_OBJECT_LOCK (probe);
+  GST_INFO_OBJECT (probe, "%" G_GUINT64_FORMAT " buffers, end-to-end latency "
+      "min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT, probe->end_to_end.count,
+      GST_TIME_ARGS (probe->end_to_end.min),
+      GST_TIME_ARGS (probe->end_to_end.max));
+  GST_OBJECT_UNLOCK (probe);
+
+  return TRUE;
+}
+
+static GstLatencyProbeStats *
+gst_latency_probe_get_segment (GstLatencyProbe * probe, const gchar * from)
+{
+  GstLatencyProbeStats *stats;
+  guint i;
+
+  /* there are as many segments as paths from upstream probes, so a few */
+  for (i = 0; i < probe->segments->len; i++) {
+    stats = g_ptr_array_index (probe->segments, i);
+    if (stats->from == from)
+      return stats;
+  }
+
+  stats = g_new (GstLatencyProbeStats, 1);
+  gst_latency_probe_stats_reset (stats, from);
+  g_ptr_array_add (probe->segments, stats);
+
+  return stats;
+}
+
+static GstFlowReturn
+gst_latency_probe_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (trans);
+  GstLatencyProbeMeta *meta;
+  GstClockTime now = gst_util_get_timestamp ();
+
+  meta = (GstLatencyProbeMeta *) gst_buffer_get_meta (buf,
+      GST_LATENCY_PROBE_META_API_TYPE);
+
+  if (!meta || probe->stamp) {
+    if (!meta)
+      meta = (GstLatencyProbeMeta *) gst_buffer_add_meta (buf,
+          GST_LATENCY_PROBE_META_INFO, NULL);
+    meta->origin = now;
+  } else {
+    GST_OBJECT_LOCK (probe);
+    if (GST_CLOCK_TIME_IS_VALID (meta->origin) && now >= meta->origin)
+      gst_latency_probe_stats_add (&probe->end_to_end, now - meta->origin);
+    if (meta->last_probe && GST_CLOCK_TIME_IS_VALID (meta->last)
+        && now >= meta->last)
+      gst_latency_probe_stats_add (gst_latency_probe_get_segment (probe,
+              meta->last_probe), now - meta->last);
+    GST_OBJECT_UNLOCK (probe);
+
+    GST_LOG_OBJECT (probe, "latency %" GST_TIME_FORMAT " from %s %"
+        GST_TIME_FORMAT, GST_TIME_ARGS (now - meta->origin),
+        GST_STR_NULL (meta->last_probe), GST_TIME_ARGS (now - meta->last));
+  }
+
+  meta->last = now;
+  meta->last_probe = probe->probe_name;
+
+  return GST_FLOW_OK;
+}
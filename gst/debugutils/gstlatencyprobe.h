@@ -0,0 +1,72 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_LATENCY_PROBE_H_
+#define _GST_LATENCY_PROBE_H_
+
+#include <gst/base/gstbasetransform.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_LATENCY_PROBE   (gst_latency_probe_get_type())
+#define GST_LATENCY_PROBE(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_LATENCY_PROBE,GstLatencyProbe))
+#define GST_LATENCY_PROBE_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_LATENCY_PROBE,GstLatencyProbeClass))
+#define GST_IS_LATENCY_PROBE(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_LATENCY_PROBE))
+#define GST_IS_LATENCY_PROBE_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_LATENCY_PROBE))
+
+typedef struct _GstLatencyProbe GstLatencyProbe;
+typedef struct _GstLatencyProbeClass GstLatencyProbeClass;
+
+/* log2 buckets of microseconds, the last one takes everything above */
+#define GST_LATENCY_PROBE_N_BUCKETS 32
+
+typedef struct
+{
+  /* interned name of the previous probe, NULL for end-to-end */
+  const gchar *from;
+
+  guint64 count;
+  GstClockTime min, max, total;
+  guint64 histogram[GST_LATENCY_PROBE_N_BUCKETS];
+} GstLatencyProbeStats;
+
+struct _GstLatencyProbe
+{
+  GstBaseTransform base_latency_probe;
+
+  /* properties */
+  gboolean stamp;
+
+  /* interned name of this element, taken in start */
+  const gchar *probe_name;
+
+  /* protected by the object lock */
+  GstLatencyProbeStats end_to_end;
+  GPtrArray *segments;
+};
+
+struct _GstLatencyProbeClass
+{
+  GstBaseTransformClass base_latency_probe_class;
+};
+
+GType gst_latency_probe_get_type (void);
+
+G_END_DECLS
+
+#endif
@@ -174,6 +174,26 @@ gst_dvbsub_overlay_class_init (GstDVBSubOverlayClass * klass)
       "Renders DVB subtitles", "Mart Raudsepp <mart.raudsepp@collabora.co.uk>");
 }
 
+/* A converted subtitle rectangle, along with a copy of the palette indices
+ * and colours it was converted from, to recognise it in a later display set */
+typedef struct
+{
+  gint x, y, w, h;
+  guint8 *data;
+  guint32 *palette;
+  guint n_colors;
+  GstVideoOverlayRectangle *rect;
+} GstDVBSubOverlayCachedRect;
+
+static void
+gst_dvbsub_overlay_cached_rect_free (GstDVBSubOverlayCachedRect * cached)
+{
+  g_free (cached->data);
+  g_free (cached->palette);
+  gst_video_overlay_rectangle_unref (cached->rect);
+  g_slice_free (GstDVBSubOverlayCachedRect, cached);
+}
+
 static void
 gst_dvbsub_overlay_flush_subtitles (GstDVBSubOverlay * render)
 {
@@ -192,6 +212,8 @@ gst_dvbsub_overlay_flush_subtitles (GstDVBSubOverlay * render)
     gst_video_overlay_composition_unref (render->current_comp);
   render->current_comp = NULL;
 
+  g_ptr_array_set_size (render->rect_cache, 0);
+
   if (render->dvb_sub)
     dvb_sub_free (render->dvb_sub);
 
@@ -246,6 +268,8 @@ gst_dvbsub_overlay_init (GstDVBSubOverlay * render)
 
   render->current_subtitle = NULL;
   render->pending_subtitles = g_queue_new ();
+  render->rect_cache = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_dvbsub_overlay_cached_rect_free);
 
   render->enable = DEFAULT_ENABLE;
   render->max_page_timeout = DEFAULT_MAX_PAGE_TIMEOUT;
@@ -279,6 +303,8 @@ gst_dvbsub_overlay_finalize (GObject * object)
     gst_video_overlay_composition_unref (overlay->current_comp);
   overlay->current_comp = NULL;
 
+  g_ptr_array_free (overlay->rect_cache, TRUE);
+
   if (overlay->dvb_sub)
     dvb_sub_free (overlay->dvb_sub);
 
@@ -898,14 +924,106 @@ gst_dvbsub_overlay_chain_text (GstPad * pad, GstObject * parent,
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_dvbsub_overlay_cached_rect_matches (GstDVBSubOverlayCachedRect * cached,
+    DVBSubtitleRect * srect)
+{
+  gint k;
+
+  /* already taken over by an identical region of the new display set */
+  if (cached->data == NULL)
+    return FALSE;
+
+  if (cached->x != srect->x || cached->y != srect->y ||
+      cached->w != srect->w || cached->h != srect->h ||
+      cached->n_colors != (1 << srect->pict.palette_bits_count))
+    return FALSE;
+
+  if (memcmp (cached->palette, srect->pict.palette,
+          cached->n_colors * sizeof (guint32)) != 0)
+    return FALSE;
+
+  for (k = 0; k < srect->h; k++) {
+    if (memcmp (cached->data + k * srect->w,
+            srect->pict.data + k * srect->pict.rowstride, srect->w) != 0)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstDVBSubOverlayCachedRect *
+gst_dvbsub_overlay_lookup_cached_rect (GstDVBSubOverlay * overlay,
+    DVBSubtitleRect * srect)
+{
+  guint i;
+
+  for (i = 0; i < overlay->rect_cache->len; i++) {
+    GstDVBSubOverlayCachedRect *cached =
+        g_ptr_array_index (overlay->rect_cache, i);
+
+    if (gst_dvbsub_overlay_cached_rect_matches (cached, srect))
+      return cached;
+  }
+
+  return NULL;
+}
+
+static GstBuffer *
+gst_dvbsub_overlay_convert_rect (DVBSubtitleRect * srect)
+{
+  GstBuffer *buf;
+  gint w, h;
+  guint8 *in_data;
+  guint32 *palette, *data;
+  gint stride;
+  gint k, l;
+  GstMapInfo map;
+
+  w = srect->w;
+  h = srect->h;
+
+  buf = gst_buffer_new_and_alloc (w * h * 4);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  data = (guint32 *) map.data;
+  in_data = srect->pict.data;
+  palette = srect->pict.palette;
+  stride = srect->pict.rowstride;
+  for (k = 0; k < h; k++) {
+    for (l = 0; l < w; l++) {
+      guint32 ayuv;
+
+      ayuv = palette[*in_data];
+      GST_WRITE_UINT32_BE (data, ayuv);
+      in_data++;
+      data++;
+    }
+    in_data += stride - w;
+  }
+  gst_buffer_unmap (buf, &map);
+
+  gst_buffer_add_video_meta (buf, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, w, h);
+
+  return buf;
+}
+
+/* Subtitle streams commonly repeat the same regions over several display
+ * sets, e.g. for random access or when only one line of a page changes, so
+ * the rectangles converted for the previous display set are kept and reused
+ * for regions whose content did not change. If all of them are reused, the
+ * previous composition itself is returned, which lets renderers downstream
+ * keep their own copy of it as well. */
 static GstVideoOverlayComposition *
 gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
     DVBSubtitles * subs)
 {
   GstVideoOverlayComposition *comp = NULL;
   GstVideoOverlayRectangle *rect;
+  GPtrArray *cache;
   gint width, height, dw, dh, wx, wy;
   gint i;
+  gboolean all_reused;
 
   g_return_val_if_fail (subs != NULL && subs->num_rects > 0, NULL);
 
@@ -930,41 +1048,20 @@ gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
     wy = 0;
   }
 
+  cache = g_ptr_array_new_full (subs->num_rects,
+      (GDestroyNotify) gst_dvbsub_overlay_cached_rect_free);
+  all_reused = overlay->current_comp != NULL &&
+      gst_video_overlay_composition_n_rectangles (overlay->current_comp) ==
+      subs->num_rects;
+
   for (i = 0; i < subs->num_rects; i++) {
     DVBSubtitleRect *srect = &subs->rects[i];
-    GstBuffer *buf;
-    gint w, h;
-    guint8 *in_data;
-    guint32 *palette, *data;
-    gint rx, ry, rw, rh, stride;
-    gint k, l;
-    GstMapInfo map;
+    GstDVBSubOverlayCachedRect *cached, *prev;
+    gint rx, ry, rw, rh;
 
     GST_LOG_OBJECT (overlay, "rectangle %d: %dx%d @ (%d, %d)", i,
         srect->w, srect->h, srect->x, srect->y);
 
-    w = srect->w;
-    h = srect->h;
-
-    buf = gst_buffer_new_and_alloc (w * h * 4);
-    gst_buffer_map (buf, &map, GST_MAP_WRITE);
-    data = (guint32 *) map.data;
-    in_data = srect->pict.data;
-    palette = srect->pict.palette;
-    stride = srect->pict.rowstride;
-    for (k = 0; k < h; k++) {
-      for (l = 0; l < w; l++) {
-        guint32 ayuv;
-
-        ayuv = palette[*in_data];
-        GST_WRITE_UINT32_BE (data, ayuv);
-        in_data++;
-        data++;
-      }
-      in_data += stride - w;
-    }
-    gst_buffer_unmap (buf, &map);
-
     /* this is assuming the subtitle rectangle coordinates are relative
      * to the window (if there is one) within a display of specified dimension.
      * Coordinate wrt the latter is then scaled to the actual dimension of
@@ -977,17 +1074,81 @@ gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
     GST_LOG_OBJECT (overlay, "rectangle %d rendered: %dx%d @ (%d, %d)", i,
         rw, rh, rx, ry);
 
-    gst_buffer_add_video_meta (buf, GST_VIDEO_FRAME_FLAG_NONE,
-        GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, w, h);
-    rect = gst_video_overlay_rectangle_new_raw (buf, rx, ry, rw, rh, 0);
+    cached = g_slice_new0 (GstDVBSubOverlayCachedRect);
+    cached->x = srect->x;
+    cached->y = srect->y;
+    cached->w = srect->w;
+    cached->h = srect->h;
+
+    prev = gst_dvbsub_overlay_lookup_cached_rect (overlay, srect);
+    if (prev) {
+      gint px, py;
+      guint pw, ph;
+
+      /* steal the copies of the source, they are identical anyway */
+      cached->data = prev->data;
+      cached->palette = prev->palette;
+      cached->n_colors = prev->n_colors;
+      prev->data = NULL;
+      prev->palette = NULL;
+      prev->n_colors = 0;
+
+      gst_video_overlay_rectangle_get_render_rectangle (prev->rect, &px, &py,
+          &pw, &ph);
+      if (px == rx && py == ry && pw == rw && ph == rh) {
+        rect = gst_video_overlay_rectangle_ref (prev->rect);
+      } else {
+        GstBuffer *buf;
+
+        buf = gst_video_overlay_rectangle_get_pixels_raw (prev->rect,
+            GST_VIDEO_OVERLAY_FORMAT_FLAG_NONE);
+        rect = gst_video_overlay_rectangle_new_raw (buf, rx, ry, rw, rh, 0);
+        all_reused = FALSE;
+      }
+      GST_LOG_OBJECT (overlay, "rectangle %d unchanged, reusing it", i);
+    } else {
+      GstBuffer *buf;
+      gsize data_size = srect->w * srect->h;
+      gint k;
+
+      cached->n_colors = 1 << srect->pict.palette_bits_count;
+      cached->palette = g_memdup (srect->pict.palette,
+          cached->n_colors * sizeof (guint32));
+      cached->data = g_malloc (data_size);
+      for (k = 0; k < srect->h; k++)
+        memcpy (cached->data + k * srect->w,
+            srect->pict.data + k * srect->pict.rowstride, srect->w);
+
+      buf = gst_dvbsub_overlay_convert_rect (srect);
+      rect = gst_video_overlay_rectangle_new_raw (buf, rx, ry, rw, rh, 0);
+      gst_buffer_unref (buf);
+      all_reused = FALSE;
+    }
     g_assert (rect);
+
+    if (all_reused &&
+        gst_video_overlay_composition_get_rectangle (overlay->current_comp,
+            i) != rect)
+      all_reused = FALSE;
+
+    cached->rect = gst_video_overlay_rectangle_ref (rect);
+    g_ptr_array_add (cache, cached);
+
     if (comp) {
       gst_video_overlay_composition_add_rectangle (comp, rect);
     } else {
       comp = gst_video_overlay_composition_new (rect);
     }
     gst_video_overlay_rectangle_unref (rect);
-    gst_buffer_unref (buf);
+  }
+
+  g_ptr_array_free (overlay->rect_cache, TRUE);
+  overlay->rect_cache = cache;
+
+  if (all_reused) {
+    GST_DEBUG_OBJECT (overlay, "display set unchanged, reusing composition");
+    gst_video_overlay_composition_unref (comp);
+    comp = gst_video_overlay_composition_ref (overlay->current_comp);
   }
 
   return comp;
@@ -1057,6 +1218,7 @@ gst_dvbsub_overlay_chain_video (GstPad * pad, GstObject * parent,
   g_mutex_lock (&overlay->dvbsub_mutex);
   if (!g_queue_is_empty (overlay->pending_subtitles)) {
     DVBSubtitles *tmp, *candidate = NULL;
+    GstVideoOverlayComposition *comp;
 
     while (!g_queue_is_empty (overlay->pending_subtitles)) {
       tmp = g_queue_peek_head (overlay->pending_subtitles);
@@ -1097,10 +1259,11 @@ gst_dvbsub_overlay_chain_video (GstPad * pad, GstObject * parent,
           candidate->num_rects);
       dvb_subtitles_free (overlay->current_subtitle);
       overlay->current_subtitle = candidate;
+      comp =
+          gst_dvbsub_overlay_subs_to_comp (overlay, overlay->current_subtitle);
       if (overlay->current_comp)
         gst_video_overlay_composition_unref (overlay->current_comp);
-      overlay->current_comp =
-          gst_dvbsub_overlay_subs_to_comp (overlay, overlay->current_subtitle);
+      overlay->current_comp = comp;
     }
   }
 
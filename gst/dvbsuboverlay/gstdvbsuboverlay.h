@@ -56,6 +56,8 @@ struct _GstDVBSubOverlay
 
   DVBSubtitles *current_subtitle; /* The currently active set of subtitle regions, if any */
   GstVideoOverlayComposition *current_comp;
+  GPtrArray *rect_cache; /* converted rectangles of the last display set,
+			  * reused if the next one repeats a region */
   GQueue *pending_subtitles; /* A queue of raw subtitle region sets with
 			      * metadata that are waiting their running time */
 
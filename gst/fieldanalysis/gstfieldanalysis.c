@@ -82,6 +82,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_field_analysis_debug);
 #define DEFAULT_BLOCK_HEIGHT 16
 #define DEFAULT_BLOCK_THRESH 80
 #define DEFAULT_IGNORED_LINES 2
+#define DEFAULT_N_THREADS 1
 
 enum
 {
@@ -96,7 +97,8 @@ enum
   PROP_BLOCK_WIDTH,
   PROP_BLOCK_HEIGHT,
   PROP_BLOCK_THRESH,
-  PROP_IGNORED_LINES
+  PROP_IGNORED_LINES,
+  PROP_N_THREADS
 };
 
 static GstStaticPadTemplate sink_factory =
@@ -274,6 +276,20 @@ gst_field_analysis_class_init (GstFieldAnalysisClass * klass)
           "Ignore this many lines from the top and bottom for windowed comb detection",
           2, G_MAXUINT64, DEFAULT_IGNORED_LINES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstFieldAnalysis:n-threads:
+   *
+   * Number of threads computing the field and frame metrics of each frame,
+   * 0 uses one thread per processor. Up to five metrics are computed per
+   * frame, so more threads than that are not used.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads computing the metrics of each frame "
+          "(0 = number of processors)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_field_analysis_change_state);
@@ -298,11 +314,14 @@ static gfloat same_parity_3_tap (GstFieldAnalysis * filter,
 static gfloat opposite_parity_5_tap (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2]);
 static guint64 block_score_for_row_32detect (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores);
 static guint64 block_score_for_row_iscombed (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores);
 static guint64 block_score_for_row_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores);
 static gfloat opposite_parity_windowed_comb (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2]);
 
@@ -325,10 +344,6 @@ gst_field_analysis_reset (GstFieldAnalysis * filter)
   filter->is_telecine = FALSE;
   filter->first_buffer = TRUE;
   gst_video_info_init (&filter->vinfo);
-  g_free (filter->comb_mask);
-  filter->comb_mask = NULL;
-  g_free (filter->block_scores);
-  filter->block_scores = NULL;
 }
 
 static void
@@ -358,6 +373,9 @@ gst_field_analysis_init (GstFieldAnalysis * filter)
   filter->block_height = DEFAULT_BLOCK_HEIGHT;
   filter->block_thresh = DEFAULT_BLOCK_THRESH;
   filter->ignored_lines = DEFAULT_IGNORED_LINES;
+  filter->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&filter->metrics_lock);
+  g_cond_init (&filter->metrics_cond);
 }
 
 static void
@@ -423,18 +441,6 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
       break;
     case PROP_BLOCK_WIDTH:
       filter->block_width = g_value_get_uint64 (value);
-      if (GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame)) {
-        const gint frame_width =
-            GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame);
-        if (filter->block_scores) {
-          gsize nbytes = (frame_width / filter->block_width) * sizeof (guint);
-          filter->block_scores = g_realloc (filter->block_scores, nbytes);
-          memset (filter->block_scores, 0, nbytes);
-        } else {
-          filter->block_scores =
-              g_malloc0 ((frame_width / filter->block_width) * sizeof (guint));
-        }
-      }
       break;
     case PROP_BLOCK_HEIGHT:
       filter->block_height = g_value_get_uint64 (value);
@@ -445,6 +451,11 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       filter->ignored_lines = g_value_get_uint64 (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -519,6 +530,11 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       g_value_set_uint64 (value, filter->ignored_lines);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -528,7 +544,6 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
 static void
 gst_field_analysis_update_format (GstFieldAnalysis * filter, GstCaps * caps)
 {
-  gint width;
   GQueue *outbufs;
   GstVideoInfo vinfo;
 
@@ -565,22 +580,6 @@ gst_field_analysis_update_format (GstFieldAnalysis * filter, GstCaps * caps)
   filter->flushing = FALSE;
 
   filter->vinfo = vinfo;
-  width = GST_VIDEO_INFO_WIDTH (&filter->vinfo);
-
-  /* update allocations for metric scores */
-  if (filter->comb_mask) {
-    filter->comb_mask = g_realloc (filter->comb_mask, width);
-  } else {
-    filter->comb_mask = g_malloc (width);
-  }
-  if (filter->block_scores) {
-    gsize nbytes = (width / filter->block_width) * sizeof (guint);
-    filter->block_scores = g_realloc (filter->block_scores, nbytes);
-    memset (filter->block_scores, 0, nbytes);
-  } else {
-    filter->block_scores =
-        g_malloc0 ((width / filter->block_width) * sizeof (guint));
-  }
 
   GST_OBJECT_UNLOCK (filter);
   return;
@@ -1037,11 +1036,10 @@ opposite_parity_5_tap (GstFieldAnalysis * filter,
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_32detect (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
   guint64 block_score;
   guint8 *fjm2, *fjm1, *fj, *fjp1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1114,8 +1112,6 @@ block_score_for_row_32detect (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
@@ -1124,11 +1120,10 @@ block_score_for_row_32detect (GstFieldAnalysis * filter,
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_iscombed (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
   guint64 block_score;
   guint8 *fjm1, *fj, *fjp1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1202,8 +1197,6 @@ block_score_for_row_iscombed (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
@@ -1212,11 +1205,10 @@ block_score_for_row_iscombed (GstFieldAnalysis * filter,
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
   guint64 block_score;
   guint8 *fjm2, *fjm1, *fj, *fjp1, *fjp2;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1313,8 +1305,6 @@ block_score_for_row_5_tap (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
@@ -1338,7 +1328,12 @@ opposite_parity_windowed_comb (GstFieldAnalysis * filter,
   const gint stride = GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
   const guint64 block_thresh = filter->block_thresh;
   const guint64 block_height = filter->block_height;
+  const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
+  const gsize n_blocks = width / filter->block_width;
   guint8 *base_fj, *base_fjp1;
+  guint8 *comb_mask;
+  guint *block_scores;
+  gfloat ret = 0.0f;
 
   if ((*history)[0].parity == TOP_FIELD) {
     base_fj =
@@ -1358,14 +1353,22 @@ opposite_parity_windowed_comb (GstFieldAnalysis * filter,
         0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
   }
 
+  /* the scratch space is per call so that the metrics of a frame can be
+   * computed in parallel */
+  comb_mask = g_malloc (width);
+  block_scores = g_malloc (MAX (n_blocks, 1) * sizeof (guint));
+
   /* we operate on a row of blocks of height block_height through each iteration */
   slightly_combed = FALSE;
   for (j = 0; j <= height - filter->ignored_lines - block_height;
       j += block_height) {
     guint64 line_offset = (filter->ignored_lines + j) * stride;
-    guint block_score =
+    guint block_score;
+
+    memset (block_scores, 0, n_blocks * sizeof (guint));
+    block_score =
         filter->block_score_for_row (filter, history, base_fj + line_offset,
-        base_fjp1 + line_offset);
+        base_fjp1 + line_offset, comb_mask, block_scores);
 
     if (block_score > (block_thresh >> 1)
         && block_score <= block_thresh) {
@@ -1374,14 +1377,108 @@ opposite_parity_windowed_comb (GstFieldAnalysis * filter,
     } else if (block_score > block_thresh) {
       if (GST_VIDEO_INFO_INTERLACE_MODE (&(*history)[0].frame.info) ==
           GST_VIDEO_INTERLACE_MODE_INTERLEAVED) {
-        return 1.0f;            /* blend */
+        ret = 1.0f;             /* blend */
       } else {
-        return 2.0f;            /* deinterlace */
+        ret = 2.0f;             /* deinterlace */
       }
+      goto done;
     }
   }
 
-  return (gfloat) slightly_combed;      /* TRUE means blend, else don't */
+  ret = (gfloat) slightly_combed;       /* TRUE means blend, else don't */
+
+done:
+  g_free (block_scores);
+  g_free (comb_mask);
+
+  return ret;
+}
+
+static void
+gst_field_analysis_add_metric (FieldAnalysisMetric * metrics, gint * n_metrics,
+    gfloat (*func) (GstFieldAnalysis *, FieldAnalysisFields (*)[2]),
+    GstVideoFrame * frame0, gboolean parity0, GstVideoFrame * frame1,
+    gboolean parity1, gfloat * result)
+{
+  FieldAnalysisMetric *metric = &metrics[(*n_metrics)++];
+
+  metric->func = func;
+  metric->history[0].frame = *frame0;
+  metric->history[0].parity = parity0;
+  metric->history[1].frame = *frame1;
+  metric->history[1].parity = parity1;
+  metric->result = result;
+}
+
+/* computes metrics until all of them are taken */
+static void
+gst_field_analysis_run_metrics (GstFieldAnalysis * filter)
+{
+  gint i;
+
+  while ((i = g_atomic_int_add (&filter->next_metric, 1)) < filter->n_metrics) {
+    FieldAnalysisMetric *metric = &filter->metrics[i];
+
+    *metric->result = metric->func (filter, &metric->history);
+  }
+}
+
+static void
+gst_field_analysis_worker_func (gpointer data, gpointer user_data)
+{
+  GstFieldAnalysis *filter = user_data;
+
+  gst_field_analysis_run_metrics (filter);
+
+  g_mutex_lock (&filter->metrics_lock);
+  if (--filter->workers_pending == 0)
+    g_cond_signal (&filter->metrics_cond);
+  g_mutex_unlock (&filter->metrics_lock);
+}
+
+/* WITH OBJECT LOCK
+ * The metrics of a frame only read the frames and the properties, so they
+ * are shared between the streaming thread and up to n-threads - 1 workers.
+ * Returns once all of them are computed. */
+static void
+gst_field_analysis_compute_metrics (GstFieldAnalysis * filter,
+    FieldAnalysisMetric * metrics, gint n_metrics)
+{
+  guint n_threads = filter->n_threads;
+  gint n_workers, i;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_workers = MIN ((gint) n_threads, n_metrics) - 1;
+
+  filter->metrics = metrics;
+  filter->n_metrics = n_metrics;
+  filter->next_metric = 0;
+
+  if (n_workers > 0) {
+    if (!filter->pool) {
+      filter->pool = g_thread_pool_new (gst_field_analysis_worker_func, filter,
+          n_workers, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (filter->pool) < n_workers) {
+      g_thread_pool_set_max_threads (filter->pool, n_workers, NULL);
+    }
+
+    filter->workers_pending = n_workers;
+    for (i = 0; i < n_workers; i++)
+      g_thread_pool_push (filter->pool, filter, NULL);
+  }
+
+  gst_field_analysis_run_metrics (filter);
+
+  if (n_workers > 0) {
+    g_mutex_lock (&filter->metrics_lock);
+    while (filter->workers_pending > 0)
+      g_cond_wait (&filter->metrics_cond, &filter->metrics_lock);
+    g_mutex_unlock (&filter->metrics_lock);
+  }
+
+  filter->metrics = NULL;
+  filter->n_metrics = 0;
 }
 
 /* this is where the magic happens
@@ -1413,7 +1510,9 @@ gst_field_analysis_process_buffer (GstFieldAnalysis * filter,
 {
   /* res0/1 correspond to f0/1 */
   FieldAnalysis *res0, *res1;
-  FieldAnalysisFields history[2];
+  FieldAnalysisMetric metrics[5];
+  gint n_metrics;
+  gfloat score_f, score_t, score_b, score_t_b, score_b_t;
   GstBuffer *outbuf = NULL;
 
   /* move previous result to index 1 */
@@ -1432,16 +1531,35 @@ gst_field_analysis_process_buffer (GstFieldAnalysis * filter,
   res0 = &filter->frames[0].results;    /* results for current frame */
   res1 = &filter->frames[1].results;    /* results for previous frame */
 
-  history[0].frame = filter->frames[0].frame;
+  /* compare the fields within the buffer, if the buffer exhibits combing it
+   * could be interlaced or a mixed telecine frame */
+  n_metrics = 0;
+  gst_field_analysis_add_metric (metrics, &n_metrics, filter->same_frame,
+      &filter->frames[0].frame, TOP_FIELD, &filter->frames[0].frame,
+      BOTTOM_FIELD, &score_f);
+  if (filter->nframes >= 2) {
+    /* compare the top and bottom fields to the previous frame */
+    gst_field_analysis_add_metric (metrics, &n_metrics, filter->same_field,
+        &filter->frames[0].frame, TOP_FIELD, &filter->frames[1].frame,
+        TOP_FIELD, &score_t);
+    gst_field_analysis_add_metric (metrics, &n_metrics, filter->same_field,
+        &filter->frames[0].frame, BOTTOM_FIELD, &filter->frames[1].frame,
+        BOTTOM_FIELD, &score_b);
+    /* compare the top field from this frame to the bottom of the previous for
+     * for combing (and vice versa) */
+    gst_field_analysis_add_metric (metrics, &n_metrics, filter->same_frame,
+        &filter->frames[0].frame, TOP_FIELD, &filter->frames[1].frame,
+        BOTTOM_FIELD, &score_t_b);
+    gst_field_analysis_add_metric (metrics, &n_metrics, filter->same_frame,
+        &filter->frames[0].frame, BOTTOM_FIELD, &filter->frames[1].frame,
+        TOP_FIELD, &score_b_t);
+  }
+  gst_field_analysis_compute_metrics (filter, metrics, n_metrics);
+
   /* we do it like this because the first frame has no predecessor so this is
    * the only result we can get for it */
   if (filter->nframes >= 1) {
-    history[1].frame = filter->frames[0].frame;
-    history[0].parity = TOP_FIELD;
-    history[1].parity = BOTTOM_FIELD;
-    /* compare the fields within the buffer, if the buffer exhibits combing it
-     * could be interlaced or a mixed telecine frame */
-    res0->f = filter->same_frame (filter, &history);
+    res0->f = score_f;
     res0->t = res0->b = res0->t_b = res0->b_t = G_MAXFLOAT;
     if (filter->nframes == 1)
       GST_DEBUG_OBJECT (filter, "Scores: f %f, t , b , t_b , b_t ", res0->f);
@@ -1459,24 +1577,10 @@ gst_field_analysis_process_buffer (GstFieldAnalysis * filter,
 
     filter->first_buffer = FALSE;
 
-    history[1].frame = filter->frames[1].frame;
-
-    /* compare the top and bottom fields to the previous frame */
-    history[0].parity = TOP_FIELD;
-    history[1].parity = TOP_FIELD;
-    res0->t = filter->same_field (filter, &history);
-    history[0].parity = BOTTOM_FIELD;
-    history[1].parity = BOTTOM_FIELD;
-    res0->b = filter->same_field (filter, &history);
-
-    /* compare the top field from this frame to the bottom of the previous for
-     * for combing (and vice versa) */
-    history[0].parity = TOP_FIELD;
-    history[1].parity = BOTTOM_FIELD;
-    res0->t_b = filter->same_frame (filter, &history);
-    history[0].parity = BOTTOM_FIELD;
-    history[1].parity = TOP_FIELD;
-    res0->b_t = filter->same_frame (filter, &history);
+    res0->t = score_t;
+    res0->b = score_b;
+    res0->t_b = score_t_b;
+    res0->b_t = score_b_t;
 
     GST_DEBUG_OBJECT (filter,
         "Scores: f %f, t %f, b %f, t_b %f, b_t %f", res0->f,
@@ -1832,6 +1936,11 @@ gst_field_analysis_finalize (GObject * object)
 
   gst_field_analysis_reset (filter);
 
+  if (filter->pool)
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+  g_mutex_clear (&filter->metrics_lock);
+  g_cond_clear (&filter->metrics_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -63,6 +63,7 @@ typedef struct _GstFieldAnalysisClass GstFieldAnalysisClass;
 typedef struct _FieldAnalysisFields FieldAnalysisFields;
 typedef struct _FieldAnalysisHistory FieldAnalysisHistory;
 typedef struct _FieldAnalysis FieldAnalysis;
+typedef struct _FieldAnalysisMetric FieldAnalysisMetric;
 
 typedef enum
 {
@@ -101,6 +102,14 @@ struct _FieldAnalysisHistory
   FieldAnalysis results;
 };
 
+/* one metric to compute for a pair of fields */
+struct _FieldAnalysisMetric
+{
+  gfloat (*func) (GstFieldAnalysis *, FieldAnalysisFields (*)[2]);
+  FieldAnalysisFields history[2];
+  gfloat *result;
+};
+
 typedef enum
 {
   METHOD_32DETECT,
@@ -119,12 +128,10 @@ struct _GstFieldAnalysis
   GstVideoInfo vinfo;
   gfloat (*same_field) (GstFieldAnalysis *, FieldAnalysisFields (*)[2]);
   gfloat (*same_frame) (GstFieldAnalysis *, FieldAnalysisFields (*)[2]);
-  guint64 (*block_score_for_row) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], guint8 *, guint8 *);
+  guint64 (*block_score_for_row) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], guint8 *, guint8 *, guint8 *, guint *);
   gboolean is_telecine;
   gboolean first_buffer; /* indicates the first buffer for which a buffer will be output
                           * after a discont or flushing seek */
-  guint8 *comb_mask;
-  guint *block_scores;
   gboolean flushing;     /* indicates whether we are flushing or not */
 
   /* properties */
@@ -135,6 +142,17 @@ struct _GstFieldAnalysis
   guint64 block_width, block_height; /* width/height of window used for comb clusted detection */
   guint64 block_thresh;
   guint64 ignored_lines;
+  guint n_threads;
+
+  /* the metrics of the current frame, computed by the streaming thread and
+   * the workers of the pool */
+  GThreadPool *pool;
+  GMutex metrics_lock;
+  GCond metrics_cond;
+  gint workers_pending;
+  FieldAnalysisMetric *metrics;
+  gint n_metrics;
+  gint next_metric;
 };
 
 struct _GstFieldAnalysisClass
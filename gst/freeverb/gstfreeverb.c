@@ -59,6 +59,12 @@
 
 #include "gstfreeverb.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #define GST_CAT_DEFAULT gst_freeverb_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
@@ -150,6 +156,9 @@ static const GstFreeverbProcessFunc process_functions[2][2] = {
 #define DC_OFFSET 1e-8
 //#define DC_OFFSET 0.001f
 
+/* The filters run over blocks of planar samples of at most this size */
+#define FREEVERB_BLOCK_SIZE 256
+
 /* all pass filter */
 
 typedef struct _freeverb_allpass
@@ -198,17 +207,54 @@ freeverb_allpass_getfeedback(freeverb_allpass* allpass)
   return allpass->feedback;
 }*/
 
-#define freeverb_allpass_process(_allpass, _input_1) \
-{ \
-  gfloat output; \
-  gfloat bufout; \
-  bufout = _allpass.buffer[_allpass.bufidx]; \
-  output = bufout-_input_1; \
-  _allpass.buffer[_allpass.bufidx] = _input_1 + (bufout * _allpass.feedback); \
-  if (++_allpass.bufidx >= _allpass.bufsize) { \
-    _allpass.bufidx = 0; \
-  } \
-  _input_1 = output; \
+/* Runs the allpass in place over a block of samples. The block is split at
+ * the end of the delay line, and every slot of a part is read once before
+ * being written, so the samples of a part are independent. */
+static void
+freeverb_allpass_process (freeverb_allpass * allpass, gfloat * data, gint len)
+{
+  while (len > 0) {
+    gfloat *buf = allpass->buffer + allpass->bufidx;
+    gint n = MIN (len, allpass->bufsize - allpass->bufidx);
+    gint k = 0;
+
+#if defined(__SSE2__)
+    __m128 feedback = _mm_set1_ps (allpass->feedback);
+
+    for (; k + 4 <= n; k += 4) {
+      __m128 bufout = _mm_loadu_ps (buf + k);
+      __m128 input = _mm_loadu_ps (data + k);
+
+      _mm_storeu_ps (buf + k, _mm_add_ps (input, _mm_mul_ps (bufout,
+                  feedback)));
+      _mm_storeu_ps (data + k, _mm_sub_ps (bufout, input));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t feedback = vdupq_n_f32 (allpass->feedback);
+
+    for (; k + 4 <= n; k += 4) {
+      float32x4_t bufout = vld1q_f32 (buf + k);
+      float32x4_t input = vld1q_f32 (data + k);
+
+      vst1q_f32 (buf + k, vaddq_f32 (input, vmulq_f32 (bufout, feedback)));
+      vst1q_f32 (data + k, vsubq_f32 (bufout, input));
+    }
+#endif
+
+    for (; k < n; k++) {
+      gfloat bufout = buf[k];
+      gfloat input = data[k];
+
+      buf[k] = input + (bufout * allpass->feedback);
+      data[k] = bufout - input;
+    }
+
+    data += n;
+    len -= n;
+    allpass->bufidx += n;
+    if (allpass->bufidx >= allpass->bufsize)
+      allpass->bufidx = 0;
+  }
 }
 
 /* comb filter */
@@ -277,19 +323,92 @@ freeverb_comb_getfeedback(freeverb_comb* comb)
   return comb->feedback;
 }*/
 
-#define freeverb_comb_process(_comb, _input_1, _output) \
-{ \
-  gfloat _tmp = _comb.buffer[_comb.bufidx]; \
-  _comb.filterstore = (_tmp * _comb.damp2) + (_comb.filterstore * _comb.damp1); \
-  _comb.buffer[_comb.bufidx] = _input_1 + (_comb.filterstore * _comb.feedback); \
-  if (++_comb.bufidx >= _comb.bufsize) { \
-    _comb.bufidx = 0; \
-  } \
-  _output += _tmp; \
-}
-
 #define numcombs 8
 #define numallpasses 4
+
+/* Runs the combs of one channel over a block of samples and sums their
+ * outputs into @output. The block is split where a delay line wraps, and
+ * every slot of a part is read once before being written. Only the lowpass
+ * in the feedback path is recursive: it runs sample by sample, with the
+ * independent combs interleaved, and the rest of each part is vectorized. */
+static void
+freeverb_combs_process (freeverb_comb * combs, const gfloat * input,
+    gfloat * output, gint len)
+{
+  gfloat store[numcombs][FREEVERB_BLOCK_SIZE];
+  gfloat filterstore[numcombs], damp1[numcombs], damp2[numcombs];
+  gfloat *buffer[numcombs];
+  gint i, k;
+
+  for (i = 0; i < numcombs; i++) {
+    damp1[i] = combs[i].damp1;
+    damp2[i] = combs[i].damp2;
+  }
+
+  while (len > 0) {
+    gint n = len;
+
+    for (i = 0; i < numcombs; i++) {
+      n = MIN (n, combs[i].bufsize - combs[i].bufidx);
+      buffer[i] = combs[i].buffer + combs[i].bufidx;
+      filterstore[i] = combs[i].filterstore;
+    }
+
+    for (k = 0; k < n; k++) {
+      for (i = 0; i < numcombs; i++) {
+        filterstore[i] = (buffer[i][k] * damp2[i]) +
+            (filterstore[i] * damp1[i]);
+        store[i][k] = filterstore[i];
+      }
+    }
+
+    for (i = 0; i < numcombs; i++) {
+      gfloat *buf = buffer[i];
+
+      k = 0;
+#if defined(__SSE2__)
+      {
+        __m128 feedback = _mm_set1_ps (combs[i].feedback);
+
+        for (; k + 4 <= n; k += 4) {
+          __m128 tmp = _mm_loadu_ps (buf + k);
+
+          _mm_storeu_ps (output + k, _mm_add_ps (_mm_loadu_ps (output + k),
+                  tmp));
+          _mm_storeu_ps (buf + k, _mm_add_ps (_mm_loadu_ps (input + k),
+                  _mm_mul_ps (_mm_loadu_ps (store[i] + k), feedback)));
+        }
+      }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+      {
+        float32x4_t feedback = vdupq_n_f32 (combs[i].feedback);
+
+        for (; k + 4 <= n; k += 4) {
+          float32x4_t tmp = vld1q_f32 (buf + k);
+
+          vst1q_f32 (output + k, vaddq_f32 (vld1q_f32 (output + k), tmp));
+          vst1q_f32 (buf + k, vaddq_f32 (vld1q_f32 (input + k),
+                  vmulq_f32 (vld1q_f32 (store[i] + k), feedback)));
+        }
+      }
+#endif
+
+      for (; k < n; k++) {
+        output[k] += buf[k];
+        buf[k] = input[k] + (store[i][k] * combs[i].feedback);
+      }
+
+      combs[i].filterstore = filterstore[i];
+      combs[i].bufidx += n;
+      if (combs[i].bufidx >= combs[i].bufsize)
+        combs[i].bufidx = 0;
+    }
+
+    input += n;
+    output += n;
+    len -= n;
+  }
+}
 #define	fixedgain 0.015f
 #define scalewet 1.0f
 #define scaledry 1.0f
@@ -688,192 +807,156 @@ no_format:
   }
 }
 
-static gboolean
-gst_freeverb_transform_m2s_int (GstFreeverb * filter,
-    gint16 * idata, gint16 * odata, guint num_samples)
+/* Runs the filters over one block of planar input. @in_l and @in_r are the
+ * scaled filter inputs, the wet signal is written to @out_l and @out_r */
+static void
+freeverb_revmodel_process (GstFreeverbPrivate * priv, const gfloat * in_l,
+    const gfloat * in_r, gfloat * out_l, gfloat * out_r, gint len)
 {
-  GstFreeverbPrivate *priv = filter->priv;
   gint i, k;
-  gfloat out_l1, out_r1, input_1;
-  gfloat out_l2, out_r2, input_2;
-  gboolean drained = TRUE;
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  memset (out_l, 0, len * sizeof (gfloat));
+  memset (out_r, 0, len * sizeof (gfloat));
 
-    /* The original Freeverb code expects a stereo signal and 'input_1'
-     * is set to the sum of the left and right input_1 sample. Since
-     * this code works on a mono signal, 'input_1' is set to twice the
-     * input_1 sample. */
-    input_2 = (gfloat) * idata++;
-    input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
-
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
-    }
+  /* Accumulate comb filters in parallel */
+  freeverb_combs_process (priv->combL, in_l, out_l, len);
+  freeverb_combs_process (priv->combR, in_r, out_r, len);
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
+  /* Feed through allpasses in series */
+  for (i = 0; i < numallpasses; i++) {
+    freeverb_allpass_process (&priv->allpassL[i], out_l, len);
+    freeverb_allpass_process (&priv->allpassR[i], out_r, len);
+  }
 
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2 * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2 * priv->dry;
-    out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
-    out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
-    *odata++ = (gint16) out_l2;
-    *odata++ = (gint16) out_r2;
-
-    if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
-      drained = FALSE;
+  /* Remove the DC offset */
+  for (k = 0; k < len; k++) {
+    out_l[k] -= (gfloat) DC_OFFSET;
+    out_r[k] -= (gfloat) DC_OFFSET;
   }
-  return drained;
 }
 
-static gboolean
-gst_freeverb_transform_s2s_int (GstFreeverb * filter,
-    gint16 * idata, gint16 * odata, guint num_samples)
+/* Deinterleaves and scales the input of one block, @dry_l and @dry_r get the
+ * input samples and @in_l and @in_r the inputs of the filters */
+static void
+freeverb_revmodel_input (GstFreeverbPrivate * priv, const guint8 * idata,
+    gboolean is_float, gint channels, gfloat * dry_l, gfloat * dry_r,
+    gfloat * in_l, gfloat * in_r, gint len)
 {
-  GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1l, input_1r;
-  gfloat out_l2, out_r2, input_2l, input_2r;
-  gboolean drained = TRUE;
-
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  gint k;
 
-    input_2l = (gfloat) * idata++;
-    input_2r = (gfloat) * idata++;
-    input_1l = (input_2l + DC_OFFSET) * priv->gain;
-    input_1r = (input_2r + DC_OFFSET) * priv->gain;
+  /* For mono, both dry channels get the same samples */
+  if (is_float) {
+    const gfloat *in = (const gfloat *) idata;
 
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (k = 0; k < len; k++) {
+      dry_l[k] = in[k * channels];
+      dry_r[k] = in[k * channels + channels - 1];
     }
+  } else {
+    const gint16 *in = (const gint16 *) idata;
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
-
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
-    out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
-    out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
-    *odata++ = (gint16) out_l2;
-    *odata++ = (gint16) out_r2;
-
-    if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
-      drained = FALSE;
+    for (k = 0; k < len; k++) {
+      dry_l[k] = (gfloat) in[k * channels];
+      dry_r[k] = (gfloat) in[k * channels + channels - 1];
+    }
   }
-  return drained;
-}
-
-static gboolean
-gst_freeverb_transform_m2s_float (GstFreeverb * filter,
-    gfloat * idata, gfloat * odata, guint num_samples)
-{
-  GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1;
-  gfloat out_l2, out_r2, input_2;
-  gboolean drained = TRUE;
-
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
 
+  if (channels == 1) {
     /* The original Freeverb code expects a stereo signal and 'input_1'
      * is set to the sum of the left and right input_1 sample. Since
      * this code works on a mono signal, 'input_1' is set to twice the
      * input_1 sample. */
-    input_2 = *idata++;
-    input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
-
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (k = 0; k < len; k++)
+      in_l[k] = in_r[k] = (2.0f * dry_l[k] + DC_OFFSET) * priv->gain;
+  } else {
+    for (k = 0; k < len; k++) {
+      in_l[k] = (dry_l[k] + DC_OFFSET) * priv->gain;
+      in_r[k] = (dry_r[k] + DC_OFFSET) * priv->gain;
     }
-
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
-
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2 * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2 * priv->dry;
-    *odata++ = out_l2;
-    *odata++ = out_r2;
-
-    if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
-      drained = FALSE;
   }
-  return drained;
 }
 
 static gboolean
-gst_freeverb_transform_s2s_float (GstFreeverb * filter,
-    gfloat * idata, gfloat * odata, guint num_samples)
+gst_freeverb_process (GstFreeverb * filter, const guint8 * idata,
+    guint8 * odata, guint num_samples, gboolean is_float, gint channels)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1l, input_1r;
-  gfloat out_l2, out_r2, input_2l, input_2r;
+  gfloat dry_l[FREEVERB_BLOCK_SIZE], dry_r[FREEVERB_BLOCK_SIZE];
+  gfloat in_l[FREEVERB_BLOCK_SIZE], in_r[FREEVERB_BLOCK_SIZE];
+  gfloat out_l[FREEVERB_BLOCK_SIZE], out_r[FREEVERB_BLOCK_SIZE];
+  gint bps = is_float ? sizeof (gfloat) : sizeof (gint16);
   gboolean drained = TRUE;
+  gint n, k;
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  for (; num_samples > 0; num_samples -= n) {
+    n = MIN (num_samples, FREEVERB_BLOCK_SIZE);
 
-    input_2l = *idata++;
-    input_2r = *idata++;
-    input_1l = (input_2l + DC_OFFSET) * priv->gain;
-    input_1r = (input_2r + DC_OFFSET) * priv->gain;
+    freeverb_revmodel_input (priv, idata, is_float, channels, dry_l, dry_r,
+        in_l, in_r, n);
+    freeverb_revmodel_process (priv, in_l, in_r, out_l, out_r, n);
+    idata += n * channels * bps;
 
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    /* Calculate output */
+    for (k = 0; k < n; k++) {
+      gfloat out_l2, out_r2;
+
+      out_l2 = out_l[k] * priv->wet1 + out_r[k] * priv->wet2 +
+          dry_l[k] * priv->dry;
+      out_r2 = out_r[k] * priv->wet1 + out_l[k] * priv->wet2 +
+          dry_r[k] * priv->dry;
+
+      if (is_float) {
+        ((gfloat *) odata)[2 * k] = out_l2;
+        ((gfloat *) odata)[2 * k + 1] = out_r2;
+
+        if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
+          drained = FALSE;
+      } else {
+        out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
+        out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
+        ((gint16 *) odata)[2 * k] = (gint16) out_l2;
+        ((gint16 *) odata)[2 * k + 1] = (gint16) out_r2;
+
+        if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
+          drained = FALSE;
+      }
     }
+    odata += n * 2 * bps;
+  }
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
+  return drained;
+}
 
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
-    *odata++ = out_l2;
-    *odata++ = out_r2;
+static gboolean
+gst_freeverb_transform_m2s_int (GstFreeverb * filter,
+    gint16 * idata, gint16 * odata, guint num_samples)
+{
+  return gst_freeverb_process (filter, (const guint8 *) idata,
+      (guint8 *) odata, num_samples, FALSE, 1);
+}
 
-    if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
-      drained = FALSE;
-  }
-  return drained;
+static gboolean
+gst_freeverb_transform_s2s_int (GstFreeverb * filter,
+    gint16 * idata, gint16 * odata, guint num_samples)
+{
+  return gst_freeverb_process (filter, (const guint8 *) idata,
+      (guint8 *) odata, num_samples, FALSE, 2);
+}
+
+static gboolean
+gst_freeverb_transform_m2s_float (GstFreeverb * filter,
+    gfloat * idata, gfloat * odata, guint num_samples)
+{
+  return gst_freeverb_process (filter, (const guint8 *) idata,
+      (guint8 *) odata, num_samples, TRUE, 1);
+}
+
+static gboolean
+gst_freeverb_transform_s2s_float (GstFreeverb * filter,
+    gfloat * idata, gfloat * odata, guint num_samples)
+{
+  return gst_freeverb_process (filter, (const guint8 *) idata,
+      (guint8 *) odata, num_samples, TRUE, 2);
 }
 
 /* this function does the actual processing
@@ -0,0 +1,227 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Line kernels sampling the input frame through a fixed point remap table.
+ *
+ * The bilinear interpolation first blends the top and bottom rows of each of
+ * the two source columns and then the two columns, rounding after each step,
+ * so that the vector versions give exactly the same result as the scalar one.
+ * The vector versions handle the packed formats with 4 bytes per pixel. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "geometricsample.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#define BLEND(a,b,f) (((a) * (256 - (f)) + (b) * (f) + 128) >> 8)
+
+void
+gst_gm_sample_line_nearest (guint8 * out, const guint8 * in,
+    const GstGMSample * samples, gint width, gint pixel_stride)
+{
+  gint x;
+
+  switch (pixel_stride) {
+    case 1:
+      for (x = 0; x < width; x++)
+        if (samples[x].offset >= 0)
+          out[x] = in[samples[x].offset];
+      break;
+    case 4:
+      for (x = 0; x < width; x++)
+        if (samples[x].offset >= 0)
+          memcpy (out + x * 4, in + samples[x].offset, 4);
+      break;
+    default:
+      for (x = 0; x < width; x++)
+        if (samples[x].offset >= 0)
+          memcpy (out + x * pixel_stride, in + samples[x].offset,
+              pixel_stride);
+      break;
+  }
+}
+
+static inline void
+sample_pixel_bilinear (guint8 * out, const guint8 * in,
+    const GstGMSample * s, gint pixel_stride)
+{
+  const guint8 *p00 = in + s->offset;
+  const guint8 *p01 = p00 + s->dx;
+  const guint8 *p10 = p00 + s->dy;
+  const guint8 *p11 = p10 + s->dx;
+  guint left, right;
+  gint c;
+
+  for (c = 0; c < pixel_stride; c++) {
+    left = BLEND (p00[c], p10[c], s->fy);
+    right = BLEND (p01[c], p11[c], s->fy);
+    out[c] = BLEND (left, right, s->fx);
+  }
+}
+
+#if defined(__SSE2__)
+static inline __m128i
+load_pair (const guint8 * p0, const guint8 * p1)
+{
+  guint32 a, b;
+
+  memcpy (&a, p0, 4);
+  memcpy (&b, p1, 4);
+
+  return _mm_unpacklo_epi32 (_mm_cvtsi32_si128 (a), _mm_cvtsi32_si128 (b));
+}
+
+/* blends the 4 source pixels of @s into 8 words, the left column in the low
+ * half and the right one in the high half, weighted for the horizontal
+ * step */
+static inline __m128i
+blend_vertical_sse2 (const guint8 * in, const GstGMSample * s)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i round = _mm_set1_epi16 (128);
+  const guint8 *p = in + s->offset;
+  __m128i top, bottom, v, wx;
+
+  top = _mm_unpacklo_epi8 (load_pair (p, p + s->dx), zero);
+  bottom = _mm_unpacklo_epi8 (load_pair (p + s->dy, p + s->dy + s->dx), zero);
+
+  /* the weights add up to 256, so the sums fit in unsigned words */
+  v = _mm_add_epi16 (_mm_mullo_epi16 (top, _mm_set1_epi16 (256 - s->fy)),
+      _mm_mullo_epi16 (bottom, _mm_set1_epi16 (s->fy)));
+  v = _mm_srli_epi16 (_mm_add_epi16 (v, round), 8);
+
+  wx = _mm_unpacklo_epi64 (_mm_set1_epi16 (256 - s->fx),
+      _mm_set1_epi16 (s->fx));
+
+  return _mm_mullo_epi16 (v, wx);
+}
+#endif
+
+void
+gst_gm_sample_line_bilinear (guint8 * out, const guint8 * in,
+    const GstGMSample * samples, gint width, gint pixel_stride)
+{
+  gint x = 0;
+
+#if defined(__SSE2__)
+  if (pixel_stride == 4) {
+    const __m128i round = _mm_set1_epi16 (128);
+
+    for (; x + 2 <= width; x += 2) {
+      const GstGMSample *s = samples + x;
+      __m128i m0, m1, sum;
+
+      if (s[0].offset < 0 || s[1].offset < 0) {
+        if (s[0].offset >= 0)
+          sample_pixel_bilinear (out + x * 4, in, s, 4);
+        if (s[1].offset >= 0)
+          sample_pixel_bilinear (out + x * 4 + 4, in, s + 1, 4);
+        continue;
+      }
+
+      m0 = blend_vertical_sse2 (in, s);
+      m1 = blend_vertical_sse2 (in, s + 1);
+      sum = _mm_add_epi16 (_mm_unpacklo_epi64 (m0, m1),
+          _mm_unpackhi_epi64 (m0, m1));
+      sum = _mm_srli_epi16 (_mm_add_epi16 (sum, round), 8);
+      _mm_storel_epi64 ((__m128i *) (out + x * 4), _mm_packus_epi16 (sum,
+              sum));
+    }
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  if (pixel_stride == 4) {
+    for (; x < width; x++) {
+      const GstGMSample *s = samples + x;
+      const guint8 *p = in + s->offset;
+      guint32 p00, p01, p10, p11;
+      uint16x8_t top, bottom, v;
+      uint16x4_t sum;
+      uint8x8_t res;
+
+      if (s->offset < 0)
+        continue;
+
+      memcpy (&p00, p, 4);
+      memcpy (&p01, p + s->dx, 4);
+      memcpy (&p10, p + s->dy, 4);
+      memcpy (&p11, p + s->dy + s->dx, 4);
+
+      top = vmovl_u8 (vreinterpret_u8_u32 (vset_lane_u32 (p01,
+                  vdup_n_u32 (p00), 1)));
+      bottom = vmovl_u8 (vreinterpret_u8_u32 (vset_lane_u32 (p11,
+                  vdup_n_u32 (p10), 1)));
+
+      v = vmlaq_n_u16 (vmulq_n_u16 (top, 256 - s->fy), bottom, s->fy);
+      v = vrshrq_n_u16 (v, 8);
+      v = vmulq_u16 (v, vcombine_u16 (vdup_n_u16 (256 - s->fx),
+              vdup_n_u16 (s->fx)));
+      sum = vrshr_n_u16 (vadd_u16 (vget_low_u16 (v), vget_high_u16 (v)), 8);
+      res = vmovn_u16 (vcombine_u16 (sum, sum));
+      vst1_lane_u32 ((uint32_t *) (out + x * 4), vreinterpret_u32_u8 (res), 0);
+    }
+  }
+#endif
+
+  for (; x < width; x++)
+    if (samples[x].offset >= 0)
+      sample_pixel_bilinear (out + x * pixel_stride, in, samples + x,
+          pixel_stride);
+}
+
+static inline guint
+read_16 (const guint8 * p, gboolean big_endian)
+{
+  guint16 v;
+
+  memcpy (&v, p, 2);
+  return big_endian ? GUINT16_FROM_BE (v) : GUINT16_FROM_LE (v);
+}
+
+void
+gst_gm_sample_line_bilinear_16 (guint8 * out, const guint8 * in,
+    const GstGMSample * samples, gint width, gboolean big_endian)
+{
+  gint x;
+
+  for (x = 0; x < width; x++) {
+    const GstGMSample *s = samples + x;
+    const guint8 *p;
+    guint left, right;
+    guint16 v;
+
+    if (s->offset < 0)
+      continue;
+
+    p = in + s->offset;
+    left = BLEND (read_16 (p, big_endian), read_16 (p + s->dy, big_endian),
+        s->fy);
+    right = BLEND (read_16 (p + s->dx, big_endian),
+        read_16 (p + s->dy + s->dx, big_endian), s->fy);
+    v = BLEND (left, right, s->fx);
+    v = big_endian ? GUINT16_TO_BE (v) : GUINT16_TO_LE (v);
+    memcpy (out + x * 2, &v, 2);
+  }
+}
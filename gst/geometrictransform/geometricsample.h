@@ -0,0 +1,51 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GEOMETRIC_SAMPLE_H__
+#define __GEOMETRIC_SAMPLE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* One output pixel of a fixed point remap table.
+ *
+ * @offset is the byte offset of the top left source pixel, or -1 if the output
+ * pixel has no source and keeps the background. @dx and @dy are the byte
+ * offsets from it to its right and bottom neighbours, with the clamping or
+ * wrapping at the edges already applied, and @fx and @fy the position between
+ * them in 1/256th of a pixel. */
+typedef struct
+{
+  gint32 offset;
+  gint32 dx;
+  gint32 dy;
+  guint8 fx;
+  guint8 fy;
+} GstGMSample;
+
+void gst_gm_sample_line_nearest (guint8 * out, const guint8 * in,
+    const GstGMSample * samples, gint width, gint pixel_stride);
+void gst_gm_sample_line_bilinear (guint8 * out, const guint8 * in,
+    const GstGMSample * samples, gint width, gint pixel_stride);
+void gst_gm_sample_line_bilinear_16 (guint8 * out, const guint8 * in,
+    const GstGMSample * samples, gint width, gboolean big_endian);
+
+G_END_DECLS
+
+#endif /* __GEOMETRIC_SAMPLE_H__ */
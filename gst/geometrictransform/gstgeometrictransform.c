@@ -23,6 +23,7 @@
 
 #include "gstgeometrictransform.h"
 #include "geometricmath.h"
+#include <math.h>
 #include <string.h>
 
 GST_DEBUG_CATEGORY_STATIC (geometric_transform_debug);
@@ -49,7 +50,9 @@ static GstVideoFilterClass *parent_class = NULL;
 enum
 {
   PROP_0,
-  PROP_OFF_EDGE_PIXELS
+  PROP_OFF_EDGE_PIXELS,
+  PROP_INTERPOLATION,
+  PROP_N_THREADS
 };
 
 #define GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE ( \
@@ -74,7 +77,41 @@ gst_geometric_transform_off_edges_pixels_method_get_type (void)
   return method_type;
 }
 
+#define GST_GT_INTERPOLATION_TYPE ( \
+    gst_geometric_transform_interpolation_get_type())
+static GType
+gst_geometric_transform_interpolation_get_type (void)
+{
+  static GType interpolation_type = 0;
+
+  static const GEnumValue interpolation_types[] = {
+    {GST_GT_INTERPOLATION_NEAREST, "Nearest neighbour", "nearest"},
+    {GST_GT_INTERPOLATION_BILINEAR, "Bilinear", "bilinear"},
+    {0, NULL, NULL}
+  };
+
+  if (!interpolation_type) {
+    interpolation_type =
+        g_enum_register_static ("GstGeometricTransformInterpolation",
+        interpolation_types);
+  }
+  return interpolation_type;
+}
+
 #define DEFAULT_OFF_EDGE_PIXELS GST_GT_OFF_EDGES_PIXELS_IGNORE
+#define DEFAULT_INTERPOLATION GST_GT_INTERPOLATION_NEAREST
+#define DEFAULT_N_THREADS 1
+
+/* The rows of the output frame one thread fills */
+typedef struct
+{
+  GstGeometricTransform *gt;
+  const guint8 *in_data;
+  guint8 *out_data;
+  gint out_stride;
+  gboolean build_samples;
+  gint y_start, y_end;
+} GstGeometricTransformSlice;
 
 /* must be called with the object lock */
 static gboolean
@@ -88,10 +125,6 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
 
   GST_INFO_OBJECT (gt, "Generating new transform map");
 
-  /* cleanup old map */
-  g_free (gt->map);
-  gt->map = NULL;
-
   klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
 
   /* subclass must have defined the map_func */
@@ -100,7 +133,8 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
   /*
    * (x,y) pairs of the inverse mapping
    */
-  gt->map = g_malloc0 (sizeof (gdouble) * gt->width * gt->height * 2);
+  if (gt->map == NULL)
+    gt->map = g_malloc0 (sizeof (gdouble) * gt->width * gt->height * 2);
   ptr = gt->map;
 
   for (y = 0; y < gt->height; y++) {
@@ -122,8 +156,10 @@ end:
     GST_WARNING_OBJECT (gt, "Generating transform map failed");
     g_free (gt->map);
     gt->map = NULL;
-  } else
+  } else {
     gt->needs_remap = FALSE;
+    gt->needs_samples = TRUE;
+  }
   return ret;
 }
 
@@ -147,11 +183,18 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   gt->height = in_info->height;
   gt->row_stride = in_info->stride[0];
   gt->pixel_stride = GST_VIDEO_INFO_COMP_PSTRIDE (in_info, 0);
+  gt->format = GST_VIDEO_INFO_FORMAT (in_info);
 
   /* regenerate the map */
   GST_OBJECT_LOCK (gt);
+  /* the strides are part of the samples */
+  gt->needs_samples = TRUE;
   if (gt->map == NULL || old_width == 0 || old_height == 0
       || gt->width != old_width || gt->height != old_height) {
+    g_free (gt->map);
+    gt->map = NULL;
+    g_free (gt->samples);
+    gt->samples = NULL;
     if (klass->prepare_func)
       if (!klass->prepare_func (gt)) {
         GST_OBJECT_UNLOCK (gt);
@@ -164,14 +207,14 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   return ret;
 }
 
+/* Converts the input position of one output pixel to its entry in the fixed
+ * point table. Positions in (-1, 0) are truncated to the first row or column
+ * like the nearest neighbour mapping always did. */
 static void
-gst_geometric_transform_do_map (GstGeometricTransform * gt, guint8 * in_data,
-    guint8 * out_data, gint x, gint y, gdouble in_x, gdouble in_y)
+gst_geometric_transform_build_sample (GstGeometricTransform * gt,
+    gdouble in_x, gdouble in_y, GstGMSample * sample)
 {
-  gint in_offset;
-  gint out_offset;
-
-  out_offset = y * gt->row_stride + x * gt->pixel_stride;
+  gint x, y, fx = 0, fy = 0;
 
   /* operate on out of edge pixels */
   switch (gt->off_edge_pixels) {
@@ -193,17 +236,163 @@ gst_geometric_transform_do_map (GstGeometricTransform * gt, guint8 * in_data,
       break;
   }
 
-  {
-    gint trunc_x = (gint) in_x;
-    gint trunc_y = (gint) in_y;
-    /* only set the values if the values are valid */
-    if (trunc_x >= 0 && trunc_x < gt->width && trunc_y >= 0 &&
-        trunc_y < gt->height) {
-      in_offset = trunc_y * gt->row_stride + trunc_x * gt->pixel_stride;
+  /* only use the values if they are valid, which also rejects NaN */
+  if (!(in_x > -1 && in_x < gt->width && in_y > -1 && in_y < gt->height)) {
+    sample->offset = -1;
+    return;
+  }
+
+  if (gt->interpolation == GST_GT_INTERPOLATION_BILINEAR) {
+    gint pos_x = MAX ((gint) floor (in_x * 256 + 0.5), 0);
+    gint pos_y = MAX ((gint) floor (in_y * 256 + 0.5), 0);
+
+    x = pos_x >> 8;
+    y = pos_y >> 8;
+    fx = pos_x & 0xff;
+    fy = pos_y & 0xff;
+
+    /* rounded up onto the position of the missing last neighbour */
+    if (x >= gt->width) {
+      x = gt->width - 1;
+      fx = 0;
+    }
+    if (y >= gt->height) {
+      y = gt->height - 1;
+      fy = 0;
+    }
+  } else {
+    x = (gint) in_x;
+    y = (gint) in_y;
+  }
+
+  sample->offset = y * gt->row_stride + x * gt->pixel_stride;
+  sample->fx = fx;
+  sample->fy = fy;
+
+  if (fx == 0)
+    sample->dx = 0;
+  else if (x + 1 < gt->width)
+    sample->dx = gt->pixel_stride;
+  else if (gt->off_edge_pixels == GST_GT_OFF_EDGES_PIXELS_WRAP)
+    sample->dx = -x * gt->pixel_stride;
+  else
+    sample->dx = 0;
+
+  if (fy == 0)
+    sample->dy = 0;
+  else if (y + 1 < gt->height)
+    sample->dy = gt->row_stride;
+  else if (gt->off_edge_pixels == GST_GT_OFF_EDGES_PIXELS_WRAP)
+    sample->dy = -y * gt->row_stride;
+  else
+    sample->dy = 0;
+}
+
+static void
+gst_geometric_transform_process_rows (GstGeometricTransformSlice * slice)
+{
+  GstGeometricTransform *gt = slice->gt;
+  gint x, y;
+
+  for (y = slice->y_start; y < slice->y_end; y++) {
+    GstGMSample *samples = gt->samples + y * gt->width;
+    guint8 *out = slice->out_data + y * slice->out_stride;
+
+    if (slice->build_samples) {
+      const gdouble *ptr = gt->map + y * gt->width * 2;
+
+      for (x = 0; x < gt->width; x++, ptr += 2)
+        gst_geometric_transform_build_sample (gt, ptr[0], ptr[1],
+            samples + x);
+    }
+
+    if (gt->format == GST_VIDEO_FORMAT_AYUV) {
+      /* in AYUV black is not just all zeros:
+       * 0x10 is black for Y,
+       * 0x80 is black for Cr and Cb */
+      for (x = 0; x < gt->width; x++)
+        GST_WRITE_UINT32_BE (out + x * 4, 0xff108080);
+    } else {
+      memset (out, 0, gt->width * gt->pixel_stride);
+    }
+
+    if (gt->interpolation != GST_GT_INTERPOLATION_BILINEAR)
+      gst_gm_sample_line_nearest (out, slice->in_data, samples, gt->width,
+          gt->pixel_stride);
+    else if (gt->format == GST_VIDEO_FORMAT_GRAY16_LE)
+      gst_gm_sample_line_bilinear_16 (out, slice->in_data, samples,
+          gt->width, FALSE);
+    else if (gt->format == GST_VIDEO_FORMAT_GRAY16_BE)
+      gst_gm_sample_line_bilinear_16 (out, slice->in_data, samples,
+          gt->width, TRUE);
+    else
+      gst_gm_sample_line_bilinear (out, slice->in_data, samples, gt->width,
+          gt->pixel_stride);
+  }
+}
+
+static void
+gst_geometric_transform_worker_func (gpointer data, gpointer user_data)
+{
+  GstGeometricTransformSlice *slice = data;
+  GstGeometricTransform *gt = slice->gt;
+
+  gst_geometric_transform_process_rows (slice);
+
+  g_mutex_lock (&gt->lock);
+  if (--gt->pending == 0)
+    g_cond_signal (&gt->cond);
+  g_mutex_unlock (&gt->lock);
+}
+
+/* must be called with the object lock, fills the output frame with the
+ * rows split between n-threads threads, the first slice on this thread */
+static void
+gst_geometric_transform_run_slices (GstGeometricTransform * gt,
+    const guint8 * in_data, GstVideoFrame * out_frame, gboolean build_samples)
+{
+  GstGeometricTransformSlice *slices;
+  guint n_threads = gt->n_threads;
+  gint n_slices, i;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_slices = CLAMP ((gint) MIN (n_threads, G_MAXINT), 1, MAX (gt->height, 1));
+
+  slices = g_new (GstGeometricTransformSlice, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    slices[i].gt = gt;
+    slices[i].in_data = in_data;
+    slices[i].out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+    slices[i].out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+    slices[i].build_samples = build_samples;
+    slices[i].y_start = gt->height * i / n_slices;
+    slices[i].y_end = gt->height * (i + 1) / n_slices;
+  }
 
-      memcpy (out_data + out_offset, in_data + in_offset, gt->pixel_stride);
+  if (n_slices > 1) {
+    if (!gt->pool) {
+      gt->pool = g_thread_pool_new (gst_geometric_transform_worker_func, NULL,
+          n_slices - 1, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (gt->pool) < n_slices - 1) {
+      g_thread_pool_set_max_threads (gt->pool, n_slices - 1, NULL);
     }
+
+    gt->pending = n_slices - 1;
+    for (i = 1; i < n_slices; i++)
+      g_thread_pool_push (gt->pool, &slices[i], NULL);
+  }
+
+  gst_geometric_transform_process_rows (&slices[0]);
+
+  if (n_slices > 1) {
+    g_mutex_lock (&gt->lock);
+    while (gt->pending > 0)
+      g_cond_wait (&gt->cond, &gt->lock);
+    g_mutex_unlock (&gt->lock);
   }
+
+  g_free (slices);
 }
 
 static void
@@ -229,64 +418,42 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
 {
   GstGeometricTransform *gt;
   GstGeometricTransformClass *klass;
-  gint x, y, i;
   GstFlowReturn ret = GST_FLOW_OK;
-  gdouble *ptr;
-  guint8 *in_data;
-  guint8 *out_data;
 
   gt = GST_GEOMETRIC_TRANSFORM_CAST (vfilter);
   klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
 
-  in_data = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
-  if (GST_VIDEO_FRAME_FORMAT (out_frame) == GST_VIDEO_FORMAT_AYUV) {
-    /* in AYUV black is not just all zeros:
-     * 0x10 is black for Y,
-     * 0x80 is black for Cr and Cb */
-    for (i = 0; i < out_frame->map[0].size; i += 4)
-      GST_WRITE_UINT32_BE (out_data + i, 0xff108080);
-  } else {
-    memset (out_data, 0, out_frame->map[0].size);
-  }
-
   GST_OBJECT_LOCK (gt);
   if (gt->precalc_map) {
     if (gt->needs_remap) {
       if (klass->prepare_func)
         if (!klass->prepare_func (gt)) {
-          ret = FALSE;
+          ret = GST_FLOW_ERROR;
           goto end;
         }
       gst_geometric_transform_generate_map (gt);
     }
-    g_return_val_if_fail (gt->map, GST_FLOW_ERROR);
-    ptr = gt->map;
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        /* do the mapping */
-        gst_geometric_transform_do_map (gt, in_data, out_data, x, y, ptr[0],
-            ptr[1]);
-        ptr += 2;
-      }
-    }
   } else {
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        gdouble in_x, in_y;
-
-        if (klass->map_func (gt, x, y, &in_x, &in_y)) {
-          gst_geometric_transform_do_map (gt, in_data, out_data, x, y, in_x,
-              in_y);
-        } else {
-          GST_WARNING_OBJECT (gt, "Failed to do mapping for %d %d", x, y);
-          ret = GST_FLOW_ERROR;
-          goto end;
-        }
-      }
-    }
+    /* the mapping changes with every frame */
+    gst_geometric_transform_generate_map (gt);
+  }
+
+  if (gt->map == NULL) {
+    GST_WARNING_OBJECT (gt, "No transform map to do the mapping");
+    ret = GST_FLOW_ERROR;
+    goto end;
+  }
+
+  if (gt->samples == NULL) {
+    gt->samples = g_new (GstGMSample, gt->width * gt->height);
+    gt->needs_samples = TRUE;
   }
+
+  gst_geometric_transform_run_slices (gt,
+      GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0), out_frame,
+      gt->needs_samples);
+  gt->needs_samples = FALSE;
+
 end:
   GST_OBJECT_UNLOCK (gt);
   return ret;
@@ -304,6 +471,18 @@ gst_geometric_transform_set_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       GST_OBJECT_LOCK (gt);
       gt->off_edge_pixels = g_value_get_enum (value);
+      gt->needs_samples = TRUE;
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_INTERPOLATION:
+      GST_OBJECT_LOCK (gt);
+      gt->interpolation = g_value_get_enum (value);
+      gt->needs_samples = TRUE;
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gt);
+      gt->n_threads = g_value_get_uint (value);
       GST_OBJECT_UNLOCK (gt);
       break;
     default:
@@ -324,6 +503,16 @@ gst_geometric_transform_get_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       g_value_set_enum (value, gt->off_edge_pixels);
       break;
+    case PROP_INTERPOLATION:
+      GST_OBJECT_LOCK (gt);
+      g_value_set_enum (value, gt->interpolation);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gt);
+      g_value_set_uint (value, gt->n_threads);
+      GST_OBJECT_UNLOCK (gt);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -343,10 +532,28 @@ gst_geometric_transform_stop (GstBaseTransform * trans)
 
   g_free (gt->map);
   gt->map = NULL;
+  g_free (gt->samples);
+  gt->samples = NULL;
 
   return TRUE;
 }
 
+static void
+gst_geometric_transform_finalize (GObject * object)
+{
+  GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (object);
+
+  if (gt->pool)
+    g_thread_pool_free (gt->pool, FALSE, TRUE);
+  g_mutex_clear (&gt->lock);
+  g_cond_clear (&gt->cond);
+
+  g_free (gt->map);
+  g_free (gt->samples);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_geometric_transform_base_init (gpointer g_class)
 {
@@ -373,6 +580,7 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
 
   obj_class->set_property = gst_geometric_transform_set_property;
   obj_class->get_property = gst_geometric_transform_get_property;
+  obj_class->finalize = gst_geometric_transform_finalize;
 
   trans_class->stop = GST_DEBUG_FUNCPTR (gst_geometric_transform_stop);
   trans_class->before_transform =
@@ -388,6 +596,18 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
           "What to do with off edge pixels",
           GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, DEFAULT_OFF_EDGE_PIXELS,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "How to sample the input pixels at the mapped positions",
+          GST_GT_INTERPOLATION_TYPE, DEFAULT_INTERPOLATION,
+          GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads processing each frame (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -396,6 +616,11 @@ gst_geometric_transform_init (GTypeInstance * instance, gpointer g_class)
   GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (instance);
 
   gt->off_edge_pixels = DEFAULT_OFF_EDGE_PIXELS;
+  gt->interpolation = DEFAULT_INTERPOLATION;
+  gt->n_threads = DEFAULT_N_THREADS;
+  gt->needs_samples = TRUE;
+  g_mutex_init (&gt->lock);
+  g_cond_init (&gt->cond);
   gt->precalc_map = TRUE;
   gt->needs_remap = TRUE;
 }
@@ -23,6 +23,8 @@
 #include <gst/video/gstvideofilter.h>
 #include <gst/video/video.h>
 
+#include "geometricsample.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_GEOMETRIC_TRANSFORM \
@@ -46,6 +48,12 @@ enum
   GST_GT_OFF_EDGES_PIXELS_WRAP
 };
 
+enum
+{
+  GST_GT_INTERPOLATION_NEAREST = 0,
+  GST_GT_INTERPOLATION_BILINEAR
+};
+
 typedef struct _GstGeometricTransform GstGeometricTransform;
 typedef struct _GstGeometricTransformClass GstGeometricTransformClass;
 
@@ -99,8 +107,20 @@ struct _GstGeometricTransform {
 
   /* properties */
   gint off_edge_pixels;
+  gint interpolation;
+  guint n_threads;
 
   gdouble *map;
+
+  /* fixed point version of the map for the current off edge pixels and
+   * interpolation methods, rebuilt from it when one of them changes */
+  GstGMSample *samples;
+  gboolean needs_samples;
+
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  gint pending;
 };
 
 struct _GstGeometricTransformClass {
@@ -63,8 +63,6 @@ static gboolean gst_inter_audio_sink_start (GstBaseSink * sink);
 static gboolean gst_inter_audio_sink_stop (GstBaseSink * sink);
 static gboolean gst_inter_audio_sink_set_caps (GstBaseSink * sink,
     GstCaps * caps);
-static gboolean gst_inter_audio_sink_event (GstBaseSink * sink,
-    GstEvent * event);
 static GstFlowReturn gst_inter_audio_sink_render (GstBaseSink * sink,
     GstBuffer * buffer);
 static gboolean gst_inter_audio_sink_query (GstBaseSink * sink,
@@ -115,7 +113,6 @@ gst_inter_audio_sink_class_init (GstInterAudioSinkClass * klass)
       GST_DEBUG_FUNCPTR (gst_inter_audio_sink_get_times);
   base_sink_class->start = GST_DEBUG_FUNCPTR (gst_inter_audio_sink_start);
   base_sink_class->stop = GST_DEBUG_FUNCPTR (gst_inter_audio_sink_stop);
-  base_sink_class->event = GST_DEBUG_FUNCPTR (gst_inter_audio_sink_event);
   base_sink_class->set_caps = GST_DEBUG_FUNCPTR (gst_inter_audio_sink_set_caps);
   base_sink_class->render = GST_DEBUG_FUNCPTR (gst_inter_audio_sink_render);
   base_sink_class->query = GST_DEBUG_FUNCPTR (gst_inter_audio_sink_query);
@@ -130,7 +127,6 @@ static void
 gst_inter_audio_sink_init (GstInterAudioSink * interaudiosink)
 {
   interaudiosink->channel = g_strdup (DEFAULT_CHANNEL);
-  interaudiosink->input_adapter = gst_adapter_new ();
 }
 
 void
@@ -173,7 +169,6 @@ gst_inter_audio_sink_finalize (GObject * object)
 
   /* clean up object here */
   g_free (interaudiosink->channel);
-  gst_object_unref (interaudiosink->input_adapter);
 
   G_OBJECT_CLASS (gst_inter_audio_sink_parent_class)->finalize (object);
 }
@@ -226,14 +221,21 @@ gst_inter_audio_sink_stop (GstBaseSink * sink)
   GST_DEBUG_OBJECT (interaudiosink, "stop");
 
   g_mutex_lock (&interaudiosink->surface->mutex);
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
+  if (interaudiosink->surface->audio_ring == interaudiosink->ring) {
+    g_atomic_pointer_set (&interaudiosink->surface->audio_ring, NULL);
+    if (interaudiosink->ring)
+      gst_inter_audio_ring_unref (interaudiosink->ring);
+  }
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
   gst_inter_surface_unref (interaudiosink->surface);
   interaudiosink->surface = NULL;
 
-  gst_adapter_clear (interaudiosink->input_adapter);
+  if (interaudiosink->ring) {
+    gst_inter_audio_ring_unref (interaudiosink->ring);
+    interaudiosink->ring = NULL;
+  }
 
   return TRUE;
 }
@@ -242,7 +244,10 @@ static gboolean
 gst_inter_audio_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
 {
   GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
+  GstInterAudioRing *ring, *old_ring;
   GstAudioInfo info;
+  guint64 buffer_time, period_time;
+  guint n_frames;
 
   if (!gst_audio_info_from_caps (&info, caps)) {
     GST_ERROR_OBJECT (sink, "Failed to parse caps %" GST_PTR_FORMAT, caps);
@@ -250,96 +255,72 @@ gst_inter_audio_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   }
 
   g_mutex_lock (&interaudiosink->surface->mutex);
+  buffer_time = interaudiosink->surface->audio_buffer_time;
+  period_time = interaudiosink->surface->audio_period_time;
+
+  if (buffer_time < period_time) {
+    GST_ERROR_OBJECT (interaudiosink,
+        "Buffer time smaller than period time (%" GST_TIME_FORMAT " < %"
+        GST_TIME_FORMAT ")", GST_TIME_ARGS (buffer_time),
+        GST_TIME_ARGS (period_time));
+    g_mutex_unlock (&interaudiosink->surface->mutex);
+    return FALSE;
+  }
+
+  /* The source keeps at most buffer-time queued, the rest of the ring is
+   * room for what arrives before it reads again */
+  n_frames = MIN (gst_util_uint64_scale (buffer_time + 2 * period_time,
+          info.rate, GST_SECOND), G_MAXINT / 2 / info.bpf);
+  n_frames = MAX (n_frames, 1);
+  ring = gst_inter_audio_ring_new (&info, n_frames);
+
+  /* A new ring drops what the source did not read yet in the old format,
+   * TODO: Ideally we would drain the source here */
+  old_ring = interaudiosink->surface->audio_ring;
+  g_atomic_pointer_set (&interaudiosink->surface->audio_ring,
+      gst_inter_audio_ring_ref (ring));
   interaudiosink->surface->audio_info = info;
   interaudiosink->info = info;
-  /* TODO: Ideally we would drain the source here */
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
-  return TRUE;
-}
-
-static gboolean
-gst_inter_audio_sink_event (GstBaseSink * sink, GstEvent * event)
-{
-  GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
-
-  switch (GST_EVENT_TYPE (event)) {
-    case GST_EVENT_EOS:{
-      GstBuffer *tmp;
-      guint n;
-
-      if ((n = gst_adapter_available (interaudiosink->input_adapter)) > 0) {
-        g_mutex_lock (&interaudiosink->surface->mutex);
-        tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-        gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
-        g_mutex_unlock (&interaudiosink->surface->mutex);
-      }
-      break;
-    }
-    default:
-      break;
-  }
+  if (old_ring)
+    gst_inter_audio_ring_unref (old_ring);
+  if (interaudiosink->ring)
+    gst_inter_audio_ring_unref (interaudiosink->ring);
+  interaudiosink->ring = ring;
 
-  return GST_BASE_SINK_CLASS (parent_class)->event (sink, event);
+  return TRUE;
 }
 
 static GstFlowReturn
 gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
-  guint n, bpf;
-  guint64 period_time, buffer_time;
-  guint64 period_samples, buffer_samples;
+  GstMapInfo map;
+  guint n_frames, written;
 
   GST_DEBUG_OBJECT (interaudiosink, "render %" G_GSIZE_FORMAT,
       gst_buffer_get_size (buffer));
-  bpf = interaudiosink->info.bpf;
 
-  g_mutex_lock (&interaudiosink->surface->mutex);
-
-  buffer_time = interaudiosink->surface->audio_buffer_time;
-  period_time = interaudiosink->surface->audio_period_time;
+  if (!interaudiosink->ring)
+    return GST_FLOW_NOT_NEGOTIATED;
 
-  if (buffer_time < period_time) {
-    GST_ERROR_OBJECT (interaudiosink,
-        "Buffer time smaller than period time (%" GST_TIME_FORMAT " < %"
-        GST_TIME_FORMAT ")", GST_TIME_ARGS (buffer_time),
-        GST_TIME_ARGS (period_time));
-    g_mutex_unlock (&interaudiosink->surface->mutex);
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (interaudiosink, RESOURCE, READ, (NULL),
+        ("Failed to map buffer"));
     return GST_FLOW_ERROR;
   }
 
-  buffer_samples =
-      gst_util_uint64_scale (buffer_time, interaudiosink->info.rate,
-      GST_SECOND);
-  period_samples =
-      gst_util_uint64_scale (period_time, interaudiosink->info.rate,
-      GST_SECOND);
+  /* Written straight to the source, which fills periods with silence when
+   * it runs out of data, instead of holding back partial periods here */
+  n_frames = map.size / interaudiosink->info.bpf;
+  written = gst_inter_audio_ring_write (interaudiosink->ring, map.data,
+      n_frames);
+  gst_buffer_unmap (buffer, &map);
 
-  n = gst_adapter_available (interaudiosink->surface->audio_adapter) / bpf;
-  while (n > buffer_samples) {
-    GST_DEBUG_OBJECT (interaudiosink, "flushing %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (period_time));
-    gst_adapter_flush (interaudiosink->surface->audio_adapter,
-        period_samples * bpf);
-    n -= period_samples;
-  }
-
-  n = gst_adapter_available (interaudiosink->input_adapter);
-  if (period_samples * bpf > gst_buffer_get_size (buffer) + n) {
-    gst_adapter_push (interaudiosink->input_adapter, gst_buffer_ref (buffer));
-  } else {
-    GstBuffer *tmp;
-
-    if (n > 0) {
-      tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-      gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
-    }
-    gst_adapter_push (interaudiosink->surface->audio_adapter,
-        gst_buffer_ref (buffer));
-  }
-  g_mutex_unlock (&interaudiosink->surface->mutex);
+  if (written < n_frames)
+    GST_DEBUG_OBJECT (interaudiosink, "ring full, dropped %u frames",
+        n_frames - written);
 
   return GST_FLOW_OK;
 }
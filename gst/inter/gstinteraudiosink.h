@@ -41,7 +41,7 @@ struct _GstInterAudioSink
   GstInterSurface *surface;
   char *channel;
 
-  GstAdapter *input_adapter;
+  GstInterAudioRing *ring;
   GstAudioInfo info;
 };
 
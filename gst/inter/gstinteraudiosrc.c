@@ -77,10 +77,12 @@ enum
   PROP_CHANNEL,
   PROP_BUFFER_TIME,
   PROP_LATENCY_TIME,
-  PROP_PERIOD_TIME
+  PROP_PERIOD_TIME,
+  PROP_DRIFT_COMPENSATION
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_DRIFT_COMPENSATION FALSE
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_audio_src_src_template =
@@ -148,6 +150,13 @@ gst_inter_audio_src_class_init (GstInterAudioSrcClass * klass)
           "The minimum amount of data to read in each iteration",
           1, G_MAXUINT64, DEFAULT_AUDIO_PERIOD_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DRIFT_COMPENSATION,
+      g_param_spec_boolean ("drift-compensation", "Drift Compensation",
+          "Resample to keep latency-time queued when the sink pipeline runs "
+          "on a different clock (S16, S32, F32 and F64 only, applied when "
+          "negotiating)", DEFAULT_DRIFT_COMPENSATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -161,6 +170,7 @@ gst_inter_audio_src_init (GstInterAudioSrc * interaudiosrc)
   interaudiosrc->buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   interaudiosrc->latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   interaudiosrc->period_time = DEFAULT_AUDIO_PERIOD_TIME;
+  interaudiosrc->drift_compensation = DEFAULT_DRIFT_COMPENSATION;
 }
 
 void
@@ -183,6 +193,9 @@ gst_inter_audio_src_set_property (GObject * object, guint property_id,
     case PROP_PERIOD_TIME:
       interaudiosrc->period_time = g_value_get_uint64 (value);
       break;
+    case PROP_DRIFT_COMPENSATION:
+      interaudiosrc->drift_compensation = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -208,6 +221,9 @@ gst_inter_audio_src_get_property (GObject * object, guint property_id,
     case PROP_PERIOD_TIME:
       g_value_set_uint64 (value, interaudiosrc->period_time);
       break;
+    case PROP_DRIFT_COMPENSATION:
+      g_value_set_boolean (value, interaudiosrc->drift_compensation);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -257,18 +273,56 @@ gst_inter_audio_src_get_caps (GstBaseSrc * src, GstCaps * filter)
     return GST_BASE_SRC_CLASS (parent_class)->get_caps (src, filter);
 }
 
+static void
+gst_inter_audio_src_free_resampler (GstInterAudioSrc * interaudiosrc)
+{
+  if (interaudiosrc->resampler) {
+    gst_audio_resampler_free (interaudiosrc->resampler);
+    interaudiosrc->resampler = NULL;
+  }
+  g_free (interaudiosrc->in_data);
+  interaudiosrc->in_data = NULL;
+  interaudiosrc->in_size = 0;
+}
+
 static gboolean
 gst_inter_audio_src_set_caps (GstBaseSrc * src, GstCaps * caps)
 {
   GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (src);
+  GstAudioInfo *info = &interaudiosrc->info;
 
   GST_DEBUG_OBJECT (interaudiosrc, "set_caps");
 
-  if (!gst_audio_info_from_caps (&interaudiosrc->info, caps)) {
+  if (!gst_audio_info_from_caps (info, caps)) {
     GST_ERROR_OBJECT (src, "Failed to parse caps %" GST_PTR_FORMAT, caps);
     return FALSE;
   }
 
+  gst_inter_audio_src_free_resampler (interaudiosrc);
+  if (!interaudiosrc->drift_compensation)
+    return TRUE;
+
+  switch (GST_AUDIO_INFO_FORMAT (info)) {
+    case GST_AUDIO_FORMAT_S16:
+    case GST_AUDIO_FORMAT_S32:
+    case GST_AUDIO_FORMAT_F32:
+    case GST_AUDIO_FORMAT_F64:
+      interaudiosrc->resampler =
+          gst_audio_resampler_new (GST_AUDIO_RESAMPLER_METHOD_KAISER,
+          GST_AUDIO_RESAMPLER_FLAG_VARIABLE_RATE, GST_AUDIO_INFO_FORMAT (info),
+          GST_AUDIO_INFO_CHANNELS (info), GST_AUDIO_INFO_RATE (info),
+          GST_AUDIO_INFO_RATE (info), NULL);
+      interaudiosrc->resampler_in_rate = GST_AUDIO_INFO_RATE (info);
+      interaudiosrc->fill_avg =
+          gst_util_uint64_scale (interaudiosrc->latency_time,
+          GST_AUDIO_INFO_RATE (info), GST_SECOND);
+      break;
+    default:
+      GST_WARNING_OBJECT (src, "No drift compensation for format %s",
+          GST_AUDIO_INFO_NAME (info));
+      break;
+  }
+
   return TRUE;
 }
 
@@ -302,6 +356,12 @@ gst_inter_audio_src_stop (GstBaseSrc * src)
   gst_inter_surface_unref (interaudiosrc->surface);
   interaudiosrc->surface = NULL;
 
+  if (interaudiosrc->ring) {
+    gst_inter_audio_ring_unref (interaudiosrc->ring);
+    interaudiosrc->ring = NULL;
+  }
+  gst_inter_audio_src_free_resampler (interaudiosrc);
+
   return TRUE;
 }
 
@@ -330,84 +390,152 @@ gst_inter_audio_src_get_times (GstBaseSrc * src, GstBuffer * buffer,
   }
 }
 
+/* Reads the frames for @out_frames output frames from @ring through the
+ * resampler. The ring fills up when the sink runs on a faster clock than
+ * ours and drains when it runs slower, so the input rate is adjusted to keep
+ * latency-time queued. The fill level is averaged as the sink writes in
+ * bursts. Returns the number of frames read */
+static guint
+gst_inter_audio_src_read_resampled (GstInterAudioSrc * interaudiosrc,
+    GstInterAudioRing * ring, guint available, guint8 * out, guint out_frames)
+{
+  gint rate = GST_AUDIO_INFO_RATE (&interaudiosrc->info);
+  guint bpf = GST_AUDIO_INFO_BPF (&interaudiosrc->info);
+  gdouble target;
+  gint in_rate;
+  gsize in_frames;
+  gpointer in_planes[1], out_planes[1];
+  guint n;
+
+  target = gst_util_uint64_scale (interaudiosrc->latency_time, rate,
+      GST_SECOND);
+  interaudiosrc->fill_avg += (available - interaudiosrc->fill_avg) / 16.0;
+
+  /* at most 0.5% faster or slower */
+  in_rate = rate + CLAMP ((gint) ((interaudiosrc->fill_avg - target) / 4),
+      -rate / 200, rate / 200);
+  if (in_rate != interaudiosrc->resampler_in_rate) {
+    GST_LOG_OBJECT (interaudiosrc, "fill level %.0f frames, resampling "
+        "from %d Hz", interaudiosrc->fill_avg, in_rate);
+    gst_audio_resampler_update (interaudiosrc->resampler, in_rate, rate, NULL);
+    interaudiosrc->resampler_in_rate = in_rate;
+  }
+
+  in_frames = gst_audio_resampler_get_in_frames (interaudiosrc->resampler,
+      out_frames);
+  if (interaudiosrc->in_size < in_frames * bpf) {
+    g_free (interaudiosrc->in_data);
+    interaudiosrc->in_size = in_frames * bpf;
+    interaudiosrc->in_data = g_malloc (interaudiosrc->in_size);
+  }
+
+  /* silence for what is missing, before the data like without resampling */
+  n = MIN (in_frames, available);
+  gst_audio_format_fill_silence (interaudiosrc->info.finfo,
+      interaudiosrc->in_data, (in_frames - n) * bpf);
+  n = gst_inter_audio_ring_read (ring,
+      interaudiosrc->in_data + (in_frames - n) * bpf, n);
+
+  in_planes[0] = interaudiosrc->in_data;
+  out_planes[0] = out;
+  gst_audio_resampler_resample (interaudiosrc->resampler, in_planes, in_frames,
+      out_planes, out_frames);
+
+  return n;
+}
+
 static GstFlowReturn
 gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (src);
-  GstCaps *caps;
+  GstInterAudioRing *ring;
   GstBuffer *buffer;
+  GstMapInfo map;
   guint n, bpf;
-  guint64 period_time;
   guint64 period_samples;
 
   GST_DEBUG_OBJECT (interaudiosrc, "create");
 
-  buffer = NULL;
-  caps = NULL;
-
-  g_mutex_lock (&interaudiosrc->surface->mutex);
-  if (interaudiosrc->surface->audio_info.finfo) {
-    if (!gst_audio_info_is_equal (&interaudiosrc->surface->audio_info,
-            &interaudiosrc->info)) {
-      caps = gst_audio_info_to_caps (&interaudiosrc->surface->audio_info);
-      interaudiosrc->timestamp_offset +=
-          gst_util_uint64_scale (interaudiosrc->n_samples, GST_SECOND,
-          interaudiosrc->info.rate);
-      interaudiosrc->n_samples = 0;
-    }
+  /* The lock is only taken when the sink replaced the ring, the samples
+   * themselves are passed without locking */
+  ring = g_atomic_pointer_get (&interaudiosrc->surface->audio_ring);
+  if (ring != interaudiosrc->ring) {
+    g_mutex_lock (&interaudiosrc->surface->mutex);
+    ring = interaudiosrc->surface->audio_ring;
+    if (ring)
+      gst_inter_audio_ring_ref (ring);
+    g_mutex_unlock (&interaudiosrc->surface->mutex);
+
+    if (interaudiosrc->ring)
+      gst_inter_audio_ring_unref (interaudiosrc->ring);
+    interaudiosrc->ring = ring;
   }
 
-  bpf = interaudiosrc->surface->audio_info.bpf;
-  period_time = interaudiosrc->surface->audio_period_time;
-  period_samples =
-      gst_util_uint64_scale (period_time, interaudiosrc->info.rate, GST_SECOND);
-
-  if (bpf > 0)
-    n = gst_adapter_available (interaudiosrc->surface->audio_adapter) / bpf;
-  else
-    n = 0;
+  if (ring && !gst_audio_info_is_equal (&ring->info, &interaudiosrc->info)) {
+    GstCaps *caps = gst_audio_info_to_caps (&ring->info);
+    gboolean ret;
 
-  if (n > period_samples)
-    n = period_samples;
-  if (n > 0) {
-    buffer = gst_adapter_take_buffer (interaudiosrc->surface->audio_adapter,
-        n * bpf);
-  } else {
-    buffer = gst_buffer_new ();
-    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
-  }
-  g_mutex_unlock (&interaudiosrc->surface->mutex);
+    interaudiosrc->timestamp_offset +=
+        gst_util_uint64_scale (interaudiosrc->n_samples, GST_SECOND,
+        interaudiosrc->info.rate);
+    interaudiosrc->n_samples = 0;
 
-  if (caps) {
-    gboolean ret = gst_base_src_set_caps (src, caps);
-    gst_caps_unref (caps);
+    ret = gst_base_src_set_caps (src, caps);
     if (!ret) {
       GST_ERROR_OBJECT (src, "Failed to set caps %" GST_PTR_FORMAT, caps);
-      if (buffer)
-        gst_buffer_unref (buffer);
+      gst_caps_unref (caps);
       return GST_FLOW_NOT_NEGOTIATED;
     }
+    gst_caps_unref (caps);
   }
 
-  buffer = gst_buffer_make_writable (buffer);
-
   bpf = interaudiosrc->info.bpf;
-  if (n < period_samples) {
-    GstMapInfo map;
-    GstMemory *mem;
+  period_samples = gst_util_uint64_scale (interaudiosrc->period_time,
+      interaudiosrc->info.rate, GST_SECOND);
+
+  buffer = gst_buffer_new_allocate (NULL, period_samples * bpf, NULL);
+  if (!gst_buffer_map (buffer, &map, GST_MAP_WRITE)) {
+    gst_buffer_unref (buffer);
+    GST_ELEMENT_ERROR (src, RESOURCE, WRITE, (NULL), ("Failed to map buffer"));
+    return GST_FLOW_ERROR;
+  }
+
+  n = 0;
+  if (ring) {
+    guint available, buffer_samples;
+
+    available = gst_inter_audio_ring_available (ring);
+    buffer_samples = gst_util_uint64_scale (interaudiosrc->buffer_time,
+        interaudiosrc->info.rate, GST_SECOND);
+    if (available > buffer_samples) {
+      GST_DEBUG_OBJECT (interaudiosrc, "dropping %u frames",
+          available - buffer_samples);
+      gst_inter_audio_ring_skip (ring, available - buffer_samples);
+      available = buffer_samples;
+    }
 
+    if (interaudiosrc->resampler) {
+      n = gst_inter_audio_src_read_resampled (interaudiosrc, ring, available,
+          map.data, period_samples);
+    } else {
+      n = MIN (available, period_samples);
+      n = gst_inter_audio_ring_read (ring,
+          map.data + (period_samples - n) * bpf, n);
+    }
+  }
+
+  if (n < period_samples && !interaudiosrc->resampler) {
     GST_DEBUG_OBJECT (interaudiosrc,
         "creating %" G_GUINT64_FORMAT " samples of silence",
         period_samples - n);
-    mem = gst_allocator_alloc (NULL, (period_samples - n) * bpf, NULL);
-    if (gst_memory_map (mem, &map, GST_MAP_WRITE)) {
-      gst_audio_format_fill_silence (interaudiosrc->info.finfo, map.data,
-          map.size);
-      gst_memory_unmap (mem, &map);
-    }
-    gst_buffer_prepend_memory (buffer, mem);
+    gst_audio_format_fill_silence (interaudiosrc->info.finfo, map.data,
+        (period_samples - n) * bpf);
   }
+  gst_buffer_unmap (buffer, &map);
+
+  if (n == 0)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
   n = period_samples;
 
   GST_BUFFER_OFFSET (buffer) = interaudiosrc->n_samples;
@@ -46,6 +46,15 @@ struct _GstInterAudioSrc
   GstClockTime timestamp_offset;
   GstAudioInfo info;
   guint64 buffer_time, latency_time, period_time;
+  gboolean drift_compensation;
+
+  GstInterAudioRing *ring;
+
+  GstAudioResampler *resampler;
+  gint resampler_in_rate;
+  gdouble fill_avg;
+  guint8 *in_data;
+  gsize in_size;
 };
 
 struct _GstInterAudioSrcClass
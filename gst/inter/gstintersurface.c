@@ -48,7 +48,7 @@ gst_inter_surface_get (const char *name)
   surface->ref_count = 1;
   surface->name = g_strdup (name);
   g_mutex_init (&surface->mutex);
-  surface->audio_adapter = gst_adapter_new ();
+  g_queue_init (&surface->video_queue);
   surface->audio_buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   surface->audio_latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   surface->audio_period_time = DEFAULT_AUDIO_PERIOD_TIME;
@@ -79,10 +79,141 @@ gst_inter_surface_unref (GstInterSurface * surface)
 
     g_mutex_clear (&surface->mutex);
     gst_buffer_replace (&surface->video_buffer, NULL);
+    g_queue_foreach (&surface->video_queue, (GFunc) gst_buffer_unref, NULL);
+    g_queue_clear (&surface->video_queue);
     gst_buffer_replace (&surface->sub_buffer, NULL);
-    gst_object_unref (surface->audio_adapter);
+    if (surface->audio_ring)
+      gst_inter_audio_ring_unref (surface->audio_ring);
     g_free (surface->name);
     g_free (surface);
   }
   g_mutex_unlock (&mutex);
 }
+
+GstInterAudioRing *
+gst_inter_audio_ring_new (const GstAudioInfo * info, guint n_frames)
+{
+  GstInterAudioRing *ring;
+
+  g_return_val_if_fail (n_frames > 0 && n_frames <= G_MAXINT / 2, NULL);
+
+  ring = g_new0 (GstInterAudioRing, 1);
+  ring->ref_count = 1;
+  ring->info = *info;
+  ring->size = n_frames;
+  ring->data = g_malloc (n_frames * GST_AUDIO_INFO_BPF (info));
+
+  return ring;
+}
+
+GstInterAudioRing *
+gst_inter_audio_ring_ref (GstInterAudioRing * ring)
+{
+  g_atomic_int_inc (&ring->ref_count);
+
+  return ring;
+}
+
+void
+gst_inter_audio_ring_unref (GstInterAudioRing * ring)
+{
+  if (g_atomic_int_dec_and_test (&ring->ref_count)) {
+    g_free (ring->data);
+    g_free (ring);
+  }
+}
+
+/* Number of frames from ring position @from to @to */
+static guint
+ring_distance (GstInterAudioRing * ring, gint from, gint to)
+{
+  return ((guint) to + 2 * ring->size - (guint) from) % (2 * ring->size);
+}
+
+static gint
+ring_advance (GstInterAudioRing * ring, gint pos, guint n_frames)
+{
+  return ((guint) pos + n_frames) % (2 * ring->size);
+}
+
+/* Copies @n_frames between @data and the ring at position @pos, wrapping
+ * around the end of the ring */
+static void
+ring_copy (GstInterAudioRing * ring, gint pos, guint8 * data, guint n_frames,
+    gboolean to_ring)
+{
+  guint bpf = GST_AUDIO_INFO_BPF (&ring->info);
+  guint offset = (guint) pos % ring->size;
+  guint n = MIN (n_frames, ring->size - offset);
+
+  if (to_ring) {
+    memcpy (ring->data + offset * bpf, data, n * bpf);
+    memcpy (ring->data, data + n * bpf, (n_frames - n) * bpf);
+  } else {
+    memcpy (data, ring->data + offset * bpf, n * bpf);
+    memcpy (data + n * bpf, ring->data, (n_frames - n) * bpf);
+  }
+}
+
+/* Frames that can be read, for the reader; the writer sees at least that
+ * many */
+guint
+gst_inter_audio_ring_available (GstInterAudioRing * ring)
+{
+  return ring_distance (ring, g_atomic_int_get (&ring->read_pos),
+      g_atomic_int_get (&ring->write_pos));
+}
+
+/* Only called by the writer. Returns the number of frames written, which is
+ * less than @n_frames when the ring is full */
+guint
+gst_inter_audio_ring_write (GstInterAudioRing * ring, const guint8 * data,
+    guint n_frames)
+{
+  gint write_pos = g_atomic_int_get (&ring->write_pos);
+  guint n;
+
+  n = ring->size - ring_distance (ring, g_atomic_int_get (&ring->read_pos),
+      write_pos);
+  n = MIN (n, n_frames);
+  if (n == 0)
+    return 0;
+
+  ring_copy (ring, write_pos, (guint8 *) data, n, TRUE);
+  /* publishes the frames to the reader, after they were copied */
+  g_atomic_int_set (&ring->write_pos, ring_advance (ring, write_pos, n));
+
+  return n;
+}
+
+/* Only called by the reader. Returns the number of frames read */
+guint
+gst_inter_audio_ring_read (GstInterAudioRing * ring, guint8 * data,
+    guint n_frames)
+{
+  gint read_pos = g_atomic_int_get (&ring->read_pos);
+  guint n;
+
+  n = ring_distance (ring, read_pos, g_atomic_int_get (&ring->write_pos));
+  n = MIN (n, n_frames);
+  if (n == 0)
+    return 0;
+
+  ring_copy (ring, read_pos, data, n, FALSE);
+  /* hands the space back to the writer, after the frames were copied */
+  g_atomic_int_set (&ring->read_pos, ring_advance (ring, read_pos, n));
+
+  return n;
+}
+
+/* Only called by the reader, drops up to @n_frames of the oldest frames */
+void
+gst_inter_audio_ring_skip (GstInterAudioRing * ring, guint n_frames)
+{
+  gint read_pos = g_atomic_int_get (&ring->read_pos);
+  guint n;
+
+  n = ring_distance (ring, read_pos, g_atomic_int_get (&ring->write_pos));
+  n = MIN (n, n_frames);
+  g_atomic_int_set (&ring->read_pos, ring_advance (ring, read_pos, n));
+}
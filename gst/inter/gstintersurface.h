@@ -20,13 +20,30 @@
 #ifndef _GST_INTER_SURFACE_H_
 #define _GST_INTER_SURFACE_H_
 
-#include <gst/base/gstadapter.h>
 #include <gst/audio/audio.h>
 #include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterAudioRing GstInterAudioRing;
+
+/* Ring of interleaved audio frames between one interaudiosink writing and
+ * one interaudiosrc reading. Neither side takes a lock: each only advances
+ * its own position, and the positions run over twice the size so a full
+ * ring can be told from an empty one. The format never changes, a new ring
+ * is created instead. */
+struct _GstInterAudioRing
+{
+  gint ref_count;
+
+  GstAudioInfo info;
+  guint8 *data;
+  guint size;
+
+  gint read_pos;
+  gint write_pos;
+};
 
 struct _GstInterSurface
 {
@@ -45,9 +62,15 @@ struct _GstInterSurface
   guint64 audio_latency_time;
   guint64 audio_period_time;
 
+  /* frame repeated by the video sources, and the frames queued for them by
+   * the video sink. Buffers are only referenced, never copied */
   GstBuffer *video_buffer;
+  GQueue video_queue;
   GstBuffer *sub_buffer;
-  GstAdapter *audio_adapter;
+
+  /* replaced with g_atomic_pointer_set() while holding the mutex, so the
+   * source can check it for changes without locking */
+  GstInterAudioRing *audio_ring;
 };
 
 #define DEFAULT_AUDIO_BUFFER_TIME  (GST_SECOND)
@@ -58,6 +81,17 @@ struct _GstInterSurface
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
 
+GstInterAudioRing * gst_inter_audio_ring_new (const GstAudioInfo *info,
+    guint n_frames);
+GstInterAudioRing * gst_inter_audio_ring_ref (GstInterAudioRing *ring);
+void gst_inter_audio_ring_unref (GstInterAudioRing *ring);
+guint gst_inter_audio_ring_available (GstInterAudioRing *ring);
+guint gst_inter_audio_ring_write (GstInterAudioRing *ring,
+    const guint8 *data, guint n_frames);
+guint gst_inter_audio_ring_read (GstInterAudioRing *ring, guint8 *data,
+    guint n_frames);
+void gst_inter_audio_ring_skip (GstInterAudioRing *ring, guint n_frames);
+
 
 G_END_DECLS
 
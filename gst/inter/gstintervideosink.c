@@ -66,10 +66,12 @@ static GstFlowReturn gst_inter_video_sink_show_frame (GstVideoSink * sink,
 enum
 {
   PROP_0,
-  PROP_CHANNEL
+  PROP_CHANNEL,
+  PROP_QUEUE_SIZE
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_QUEUE_SIZE 1
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_sink_sink_template =
@@ -118,12 +120,20 @@ gst_inter_video_sink_class_init (GstInterVideoSinkClass * klass)
       g_param_spec_string ("channel", "Channel",
           "Channel name to match inter src and sink elements",
           DEFAULT_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
+      g_param_spec_uint ("queue-size", "Queue size",
+          "Number of frames queued for the inter src elements, the oldest "
+          "are dropped when they do not keep up (1 = only the latest frame)",
+          1, G_MAXUINT, DEFAULT_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_inter_video_sink_init (GstInterVideoSink * intervideosink)
 {
   intervideosink->channel = g_strdup (DEFAULT_CHANNEL);
+  intervideosink->queue_size = DEFAULT_QUEUE_SIZE;
 }
 
 void
@@ -137,6 +147,11 @@ gst_inter_video_sink_set_property (GObject * object, guint property_id,
       g_free (intervideosink->channel);
       intervideosink->channel = g_value_dup_string (value);
       break;
+    case PROP_QUEUE_SIZE:
+      GST_OBJECT_LOCK (intervideosink);
+      intervideosink->queue_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (intervideosink);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -153,6 +168,11 @@ gst_inter_video_sink_get_property (GObject * object, guint property_id,
     case PROP_CHANNEL:
       g_value_set_string (value, intervideosink->channel);
       break;
+    case PROP_QUEUE_SIZE:
+      GST_OBJECT_LOCK (intervideosink);
+      g_value_set_uint (value, intervideosink->queue_size);
+      GST_OBJECT_UNLOCK (intervideosink);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -208,15 +228,22 @@ static gboolean
 gst_inter_video_sink_stop (GstBaseSink * sink)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
+  GstBuffer *old_buffer;
+  GQueue old_queue;
 
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
+  old_buffer = intervideosink->surface->video_buffer;
   intervideosink->surface->video_buffer = NULL;
+  old_queue = intervideosink->surface->video_queue;
+  g_queue_init (&intervideosink->surface->video_queue);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
   g_mutex_unlock (&intervideosink->surface->mutex);
 
+  if (old_buffer)
+    gst_buffer_unref (old_buffer);
+  g_queue_foreach (&old_queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&old_queue);
+
   gst_inter_surface_unref (intervideosink->surface);
   intervideosink->surface = NULL;
 
@@ -246,17 +273,35 @@ static GstFlowReturn
 gst_inter_video_sink_show_frame (GstVideoSink * sink, GstBuffer * buffer)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
+  GQueue *queue = &intervideosink->surface->video_queue;
+  GQueue dropped = G_QUEUE_INIT;
+  guint queue_size;
 
   GST_DEBUG_OBJECT (intervideosink, "render ts %" GST_TIME_FORMAT,
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
+  GST_OBJECT_LOCK (intervideosink);
+  queue_size = intervideosink->queue_size;
+  GST_OBJECT_UNLOCK (intervideosink);
+
+  /* Only pointers are moved while holding the surface lock, dropped frames
+   * are released afterwards as that might return them to a pool */
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
-  intervideosink->surface->video_buffer_count = 0;
+  /* the preroll frame is shown again when rendered, it is still referenced
+   * by the surface so the pointer can't have been reused meanwhile */
+  if (g_queue_peek_tail (queue) != buffer &&
+      intervideosink->surface->video_buffer != buffer)
+    g_queue_push_tail (queue, gst_buffer_ref (buffer));
+  while (g_queue_get_length (queue) > queue_size)
+    g_queue_push_tail (&dropped, g_queue_pop_head (queue));
   g_mutex_unlock (&intervideosink->surface->mutex);
 
+  if (dropped.length > 0) {
+    GST_LOG_OBJECT (intervideosink, "dropping %u queued frames",
+        dropped.length);
+    g_queue_foreach (&dropped, (GFunc) gst_buffer_unref, NULL);
+    g_queue_clear (&dropped);
+  }
+
   return GST_FLOW_OK;
 }
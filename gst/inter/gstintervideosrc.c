@@ -227,6 +227,16 @@ gst_inter_video_src_get_caps (GstBaseSrc * src, GstCaps * filter)
     return GST_BASE_SRC_CLASS (parent_class)->get_caps (src, filter);
 }
 
+static gboolean
+same_frame_layout (const GstVideoInfo * a, const GstVideoInfo * b)
+{
+  return GST_VIDEO_INFO_FORMAT (a) == GST_VIDEO_INFO_FORMAT (b) &&
+      GST_VIDEO_INFO_WIDTH (a) == GST_VIDEO_INFO_WIDTH (b) &&
+      GST_VIDEO_INFO_HEIGHT (a) == GST_VIDEO_INFO_HEIGHT (b) &&
+      GST_VIDEO_INFO_SIZE (a) == GST_VIDEO_INFO_SIZE (b) &&
+      gst_video_colorimetry_is_equal (&a->colorimetry, &b->colorimetry);
+}
+
 static gboolean
 gst_inter_video_src_set_caps (GstBaseSrc * base, GstCaps * caps)
 {
@@ -234,16 +244,26 @@ gst_inter_video_src_set_caps (GstBaseSrc * base, GstCaps * caps)
   GstVideoConverter *converter;
   GstVideoFrame src_frame, dest_frame;
   GstBuffer *src, *dest;
-  GstVideoInfo black_info;
+  GstVideoInfo black_info, info;
 
   GST_DEBUG_OBJECT (intervideosrc, "set_caps");
 
-  if (!gst_video_info_from_caps (&intervideosrc->info, caps)) {
+  if (!gst_video_info_from_caps (&info, caps)) {
     GST_ERROR_OBJECT (intervideosrc, "Failed to parse caps %" GST_PTR_FORMAT,
         caps);
     return FALSE;
   }
 
+  /* The black frame only depends on the frame layout, not on the framerate
+   * that is renegotiated whenever the sink changes */
+  if (intervideosrc->black_frame &&
+      same_frame_layout (&info, &intervideosrc->info)) {
+    GST_DEBUG_OBJECT (intervideosrc, "reusing black frame");
+    intervideosrc->info = info;
+    return TRUE;
+  }
+  intervideosrc->info = info;
+
   /* Create a black frame */
   gst_buffer_replace (&intervideosrc->black_frame, NULL);
   gst_video_info_set_format (&black_info, GST_VIDEO_FORMAT_ARGB,
@@ -325,7 +345,7 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
 {
   GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
   GstCaps *caps;
-  GstBuffer *buffer;
+  GstBuffer *buffer, *old_buffer = NULL;
   guint64 frames;
   gboolean is_gap = FALSE;
 
@@ -360,6 +380,14 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
+  /* Take the next queued frame, if any, as the one to push and repeat */
+  if (!g_queue_is_empty (&intervideosrc->surface->video_queue)) {
+    old_buffer = intervideosrc->surface->video_buffer;
+    intervideosrc->surface->video_buffer =
+        g_queue_pop_head (&intervideosrc->surface->video_queue);
+    intervideosrc->surface->video_buffer_count = 0;
+  }
+
   if (intervideosrc->surface->video_buffer) {
     /* We have a buffer to push */
     buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
@@ -380,6 +408,9 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
   intervideosrc->surface->video_buffer_count++;
   g_mutex_unlock (&intervideosrc->surface->mutex);
 
+  if (old_buffer)
+    gst_buffer_unref (old_buffer);
+
   if (caps) {
     gboolean ret;
     GstStructure *s;
@@ -443,9 +474,11 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
 
   if (buffer == NULL) {
     GST_DEBUG_OBJECT (intervideosrc, "Creating black frame");
-    buffer = gst_buffer_copy (intervideosrc->black_frame);
+    buffer = gst_buffer_ref (intervideosrc->black_frame);
   }
 
+  /* Only the metadata is copied, the memory stays shared with the surface
+   * or the black frame */
   buffer = gst_buffer_make_writable (buffer);
 
   if (is_gap)
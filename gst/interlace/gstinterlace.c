@@ -168,12 +168,16 @@ gst_interlace_pattern_get_type (void)
   return interlace_pattern_type;
 }
 
+#define INTERLACE_FORMATS "{AYUV,YUY2,UYVY,I420,YV12,Y42B,Y444,NV12,NV21," \
+    GST_VIDEO_NE (I420_10) "," GST_VIDEO_NE (I422_10) "," \
+    GST_VIDEO_NE (Y444_10) "," GST_VIDEO_NE (P010_10) "}"
+
 static GstStaticPadTemplate gst_interlace_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE
-        ("{AYUV,YUY2,UYVY,I420,YV12,Y42B,Y444,NV12,NV21}")
+        (INTERLACE_FORMATS)
         ",interlace-mode={interleaved,mixed}")
     );
 
@@ -182,7 +186,7 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE
-        ("{AYUV,YUY2,UYVY,I420,YV12,Y42B,Y444,NV12,NV21}")
+        (INTERLACE_FORMATS)
     )
     );
 
@@ -815,8 +819,12 @@ copy_field (GstInterlace * interlace, GstBuffer * dest, GstBuffer * src,
     d += field_index * ds;
     s += field_index * ss;
 
+    /* the planes of the formats handled here hold the component with the
+     * same index, and the padding at the end of the lines is not copied */
     cheight = GST_VIDEO_FRAME_COMP_HEIGHT (&dframe, i);
-    cwidth = MIN (ABS (ss), ABS (ds));
+    cwidth = GST_VIDEO_FRAME_COMP_WIDTH (&dframe, i) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (&dframe, i);
+    cwidth = MIN (cwidth, MIN (ABS (ss), ABS (ds)));
 
     for (j = field_index; j < cheight; j += 2) {
       memcpy (d, s, cwidth);
@@ -842,6 +850,23 @@ src_map_failed:
   }
 }
 
+/* a buffer whose memory can be written without being copied first */
+static gboolean
+gst_interlace_buffer_is_reusable (GstBuffer * buffer)
+{
+  return gst_buffer_is_writable (buffer) &&
+      gst_buffer_is_all_memory_writable (buffer);
+}
+
+/* a woven frame only gets the flags set by gst_interlace_decorate_buffer(),
+ * like a newly allocated one */
+static void
+gst_interlace_clear_field_flags (GstBuffer * buffer)
+{
+  GST_BUFFER_FLAG_UNSET (buffer, GST_VIDEO_BUFFER_FLAG_TFF |
+      GST_VIDEO_BUFFER_FLAG_RFF | GST_VIDEO_BUFFER_FLAG_ONEFIELD |
+      GST_VIDEO_BUFFER_FLAG_INTERLACED);
+}
 
 static GstFlowReturn
 gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
@@ -852,6 +877,7 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   int current_fields;
   const PulldownFormat *format;
   GstClockTime timestamp;
+  gboolean buffer_reused = FALSE;
 
   timestamp = GST_BUFFER_TIMESTAMP (buffer);
 
@@ -920,14 +946,41 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     if (interlace->stored_fields > 0) {
       GST_DEBUG ("1 field from stored, 1 from current");
 
-      output_buffer = gst_buffer_new_and_alloc (gst_buffer_get_size (buffer));
-      /* take the first field from the stored frame */
-      copy_field (interlace, output_buffer, interlace->stored_frame,
-          interlace->field_index);
       interlace->stored_fields--;
-      /* take the second field from the incoming buffer */
-      copy_field (interlace, output_buffer, buffer, interlace->field_index ^ 1);
       current_fields--;
+
+      /* The stored frame is not needed after this, and neither is the
+       * incoming buffer if this was its last field. If nobody else uses
+       * one of them, the output is woven into it in place, which only copies
+       * one field instead of two into a new buffer. */
+      if (interlace->stored_fields == 0
+          && gst_interlace_buffer_is_reusable (interlace->stored_frame)) {
+        GST_DEBUG ("weaving the current field into the stored frame");
+        output_buffer = interlace->stored_frame;
+        interlace->stored_frame = NULL;
+        /* its discont was on the output of its previous fields */
+        GST_BUFFER_FLAG_UNSET (output_buffer, GST_BUFFER_FLAG_DISCONT);
+        gst_interlace_clear_field_flags (output_buffer);
+        copy_field (interlace, output_buffer, buffer,
+            interlace->field_index ^ 1);
+      } else if (current_fields == 0 && !buffer_reused
+          && gst_interlace_buffer_is_reusable (buffer)) {
+        GST_DEBUG ("weaving the stored field into the current frame");
+        output_buffer = buffer;
+        buffer_reused = TRUE;
+        gst_interlace_clear_field_flags (output_buffer);
+        copy_field (interlace, output_buffer, interlace->stored_frame,
+            interlace->field_index);
+      } else {
+        output_buffer =
+            gst_buffer_new_and_alloc (gst_buffer_get_size (buffer));
+        /* take the first field from the stored frame */
+        copy_field (interlace, output_buffer, interlace->stored_frame,
+            interlace->field_index);
+        /* take the second field from the incoming buffer */
+        copy_field (interlace, output_buffer, buffer,
+            interlace->field_index ^ 1);
+      }
       n_output_fields = 2;
       interlaced = TRUE;
     } else {
@@ -981,7 +1034,7 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (current_fields > 0) {
     interlace->stored_frame = buffer;
     interlace->stored_fields = current_fields;
-  } else {
+  } else if (!buffer_reused) {
     gst_buffer_unref (buffer);
   }
   return ret;
@@ -40,6 +40,7 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include "gstcombdetect.h"
+#include "gstcombline.h"
 
 #include <string.h>
 
@@ -234,22 +235,18 @@ gst_comb_detect_transform_frame (GstVideoFilter * filter,
         guint8 *src1 = GET_LINE (inframe, 0, j - 1);
         guint8 *src2 = GET_LINE (inframe, 0, j);
         guint8 *src3 = GET_LINE (inframe, 0, j + 1);
+        int line_score;
 
+        line_score = comb_line_accumulate (thisline, src1, src2, src3, width);
+        score += line_score;
+
+        if (line_score == 0) {
+          memcpy (dest, src2, width);
+          continue;
+        }
         for (i = 0; i < width; i++) {
-          if (src2[i] < MIN (src1[i], src3[i]) - 5 ||
-              src2[i] > MAX (src1[i], src3[i]) + 5) {
-            if (i > 0) {
-              thisline[i] += thisline[i - 1];
-            }
-            thisline[i]++;
-            if (thisline[i] > 1000)
-              thisline[i] = 1000;
-          } else {
-            thisline[i] = 0;
-          }
-          if (thisline[i] > 100) {
+          if (thisline[i] > COMB_LINE_SCORE_MIN) {
             dest[i] = ((i + j + z) & 0x4) ? 235 : 16;
-            score++;
           } else {
             dest[i] = src2[i];
           }
@@ -0,0 +1,123 @@
+/* GStreamer
+ * Copyright (C) 2013 David Schleef <ds@schleef.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* The comb metric shared by ivtc and combdetect. A pixel is combed if it is
+ * more than 5 outside of the range of the pixels above and below it.
+ * thisline[] holds the size of the run of combed pixels ending at each
+ * column, counting the runs of the previous lines, and pixels in runs
+ * longer than COMB_LINE_SCORE_MIN add to the score.
+ *
+ * The runs depend on the column before, so only the test for combed pixels
+ * is vectorized. Most blocks have no combed pixel at all, and their runs
+ * are simply reset. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcombline.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define COMB_LINE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define COMB_LINE_NEON
+#endif
+
+static inline int
+comb_line_c (int *thisline, const guint8 * src1, const guint8 * src2,
+    const guint8 * src3, int start, int end)
+{
+  int score = 0;
+  int i;
+
+  for (i = start; i < end; i++) {
+    if (src2[i] < MIN (src1[i], src3[i]) - 5 ||
+        src2[i] > MAX (src1[i], src3[i]) + 5) {
+      if (i > 0) {
+        thisline[i] += thisline[i - 1];
+      }
+      thisline[i]++;
+      if (thisline[i] > 1000)
+        thisline[i] = 1000;
+    } else {
+      thisline[i] = 0;
+    }
+    if (thisline[i] > COMB_LINE_SCORE_MIN) {
+      score++;
+    }
+  }
+
+  return score;
+}
+
+/* Updates @thisline for the line @src2 between @src1 and @src3 and returns
+ * the number of pixels of the line that are part of a long run */
+int
+comb_line_accumulate (int *thisline, const guint8 * src1,
+    const guint8 * src2, const guint8 * src3, int width)
+{
+  int score = 0;
+  int i = 0;
+
+#if defined(COMB_LINE_SSE2)
+  const __m128i five = _mm_set1_epi8 (5);
+  const __m128i zero = _mm_setzero_si128 ();
+
+  for (; i + 16 <= width; i += 16) {
+    __m128i a = _mm_loadu_si128 ((const __m128i *) (src1 + i));
+    __m128i b = _mm_loadu_si128 ((const __m128i *) (src2 + i));
+    __m128i c = _mm_loadu_si128 ((const __m128i *) (src3 + i));
+    /* the saturating operations give the same result as the int compares
+     * of the C version */
+    __m128i below = _mm_subs_epu8 (_mm_min_epu8 (a, c),
+        _mm_adds_epu8 (b, five));
+    __m128i above = _mm_subs_epu8 (_mm_subs_epu8 (b, five),
+        _mm_max_epu8 (a, c));
+    __m128i comb = _mm_or_si128 (below, above);
+
+    if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (comb, zero)) == 0xffff)
+      memset (thisline + i, 0, 16 * sizeof (int));
+    else
+      score += comb_line_c (thisline, src1, src2, src3, i, i + 16);
+  }
+#elif defined(COMB_LINE_NEON)
+  const uint8x16_t five = vdupq_n_u8 (5);
+
+  for (; i + 16 <= width; i += 16) {
+    uint8x16_t a = vld1q_u8 (src1 + i);
+    uint8x16_t b = vld1q_u8 (src2 + i);
+    uint8x16_t c = vld1q_u8 (src3 + i);
+    uint8x16_t comb = vorrq_u8 (vcltq_u8 (vqaddq_u8 (b, five),
+            vminq_u8 (a, c)), vcgtq_u8 (vqsubq_u8 (b, five), vmaxq_u8 (a, c)));
+    uint64x2_t comb64 = vreinterpretq_u64_u8 (comb);
+
+    if ((vgetq_lane_u64 (comb64, 0) | vgetq_lane_u64 (comb64, 1)) == 0)
+      memset (thisline + i, 0, 16 * sizeof (int));
+    else
+      score += comb_line_c (thisline, src1, src2, src3, i, i + 16);
+  }
+#endif
+
+  score += comb_line_c (thisline, src1, src2, src3, i, width);
+
+  return score;
+}
@@ -37,6 +37,10 @@
  * stream is inversed telecine'd back to 24 fps, yielding approximately
  * the original videotestsrc content.
  *
+ * The comb scores of the candidate field pairings are computed in parallel
+ * and frames rebuilt from a single field are interpolated in bands of rows
+ * when #GstIvtc:n-threads is larger than 1.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -47,6 +51,7 @@
 #include <gst/base/gstbasetransform.h>
 #include <gst/video/video.h>
 #include "gstivtc.h"
+#include "gstcombline.h"
 #include <string.h>
 #include <math.h>
 
@@ -58,6 +63,11 @@ GST_DEBUG_CATEGORY_STATIC (gst_ivtc_debug_category);
 
 /* prototypes */
 
+static void gst_ivtc_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_ivtc_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_ivtc_finalize (GObject * object);
 
 static GstCaps *gst_ivtc_transform_caps (GstBaseTransform * trans,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
@@ -77,9 +87,12 @@ static int get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_N_THREADS 1
+
 /* pad templates */
 
 #define MAX_WIDTH 2048
@@ -114,9 +127,28 @@ G_DEFINE_TYPE_WITH_CODE (GstIvtc, gst_ivtc, GST_TYPE_BASE_TRANSFORM,
 static void
 gst_ivtc_class_init (GstIvtcClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstBaseTransformClass *base_transform_class =
       GST_BASE_TRANSFORM_CLASS (klass);
 
+  gobject_class->set_property = gst_ivtc_set_property;
+  gobject_class->get_property = gst_ivtc_get_property;
+  gobject_class->finalize = gst_ivtc_finalize;
+
+  /**
+   * GstIvtc:n-threads:
+   *
+   * Number of threads used to score the candidate field pairings and to
+   * interpolate single fields, 0 uses one thread per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads used for each output frame (0 = number of "
+          "processors)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Setting up pads and setting metadata should be moved to
      base_class_init if you intend to subclass this class. */
   gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
@@ -139,6 +171,132 @@ gst_ivtc_class_init (GstIvtcClass * klass)
 static void
 gst_ivtc_init (GstIvtc * ivtc)
 {
+  ivtc->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&ivtc->task_lock);
+  g_cond_init (&ivtc->task_cond);
+}
+
+static void
+gst_ivtc_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstIvtc *ivtc = GST_IVTC (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (ivtc);
+      ivtc->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (ivtc);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ivtc_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstIvtc *ivtc = GST_IVTC (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (ivtc);
+      g_value_set_uint (value, ivtc->n_threads);
+      GST_OBJECT_UNLOCK (ivtc);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ivtc_finalize (GObject * object)
+{
+  GstIvtc *ivtc = GST_IVTC (object);
+
+  if (ivtc->pool)
+    g_thread_pool_free (ivtc->pool, FALSE, TRUE);
+  g_mutex_clear (&ivtc->task_lock);
+  g_cond_clear (&ivtc->task_cond);
+
+  G_OBJECT_CLASS (gst_ivtc_parent_class)->finalize (object);
+}
+
+typedef struct _GstIvtcTask GstIvtcTask;
+typedef void (*GstIvtcTaskFunc) (GstIvtc * ivtc, GstIvtcTask * task);
+
+struct _GstIvtcTask
+{
+  GstIvtcTaskFunc func;
+
+  /* pair of fields to score */
+  int i1, i2;
+
+  /* band of rows to reconstruct */
+  GstVideoFrame *dest_frame;
+  int band, n_bands;
+};
+
+static guint
+gst_ivtc_get_n_threads (GstIvtc * ivtc)
+{
+  guint n_threads;
+
+  GST_OBJECT_LOCK (ivtc);
+  n_threads = ivtc->n_threads;
+  GST_OBJECT_UNLOCK (ivtc);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  return n_threads;
+}
+
+static void
+gst_ivtc_task_func (gpointer data, gpointer user_data)
+{
+  GstIvtcTask *task = data;
+  GstIvtc *ivtc = user_data;
+
+  task->func (ivtc, task);
+
+  g_mutex_lock (&ivtc->task_lock);
+  if (--ivtc->tasks_pending == 0)
+    g_cond_signal (&ivtc->task_cond);
+  g_mutex_unlock (&ivtc->task_lock);
+}
+
+/* Runs the first task on the streaming thread and the others on the pool,
+ * and returns once all of them are done */
+static void
+gst_ivtc_run_tasks (GstIvtc * ivtc, GstIvtcTask * tasks, int n_tasks)
+{
+  int i;
+
+  if (n_tasks > 1) {
+    if (!ivtc->pool) {
+      ivtc->pool = g_thread_pool_new (gst_ivtc_task_func, ivtc, n_tasks - 1,
+          FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (ivtc->pool) < n_tasks - 1) {
+      g_thread_pool_set_max_threads (ivtc->pool, n_tasks - 1, NULL);
+    }
+
+    ivtc->tasks_pending = n_tasks - 1;
+    for (i = 1; i < n_tasks; i++)
+      g_thread_pool_push (ivtc->pool, &tasks[i], NULL);
+  }
+
+  tasks[0].func (ivtc, &tasks[0]);
+
+  if (n_tasks > 1) {
+    g_mutex_lock (&ivtc->task_lock);
+    while (ivtc->tasks_pending > 0)
+      g_cond_wait (&ivtc->task_cond, &ivtc->task_lock);
+    g_mutex_unlock (&ivtc->task_lock);
+  }
 }
 
 static GstCaps *
@@ -299,6 +457,7 @@ add_field (GstIvtc * ivtc, GstBuffer * buffer, int parity, int index)
   field->buffer = gst_buffer_ref (buffer);
   field->parity = parity;
   field->ts = ts;
+  field->next_score = -1;
 
   gst_video_frame_map (&ivtc->fields[i].frame, &ivtc->sink_video_info,
       buffer, GST_MAP_READ);
@@ -306,6 +465,9 @@ add_field (GstIvtc * ivtc, GstBuffer * buffer, int parity, int index)
   ivtc->n_fields++;
 }
 
+/* The score of neighbouring fields is kept with the first field, fields are
+ * only removed from the start so the two stay neighbours and the pairing is
+ * reused by the next frames */
 static int
 similarity (GstIvtc * ivtc, int i1, int i2)
 {
@@ -318,6 +480,9 @@ similarity (GstIvtc * ivtc, int i1, int i2)
   f1 = &ivtc->fields[i1];
   f2 = &ivtc->fields[i2];
 
+  if (i2 == i1 + 1 && f1->next_score >= 0)
+    return f1->next_score;
+
   if (f1->parity == TOP_FIELD) {
     score = get_comb_score (&f1->frame, &f2->frame);
   } else {
@@ -326,9 +491,18 @@ similarity (GstIvtc * ivtc, int i1, int i2)
 
   GST_DEBUG ("score %d", score);
 
+  if (i2 == i1 + 1)
+    f1->next_score = score;
+
   return score;
 }
 
+static void
+similarity_task (GstIvtc * ivtc, GstIvtcTask * task)
+{
+  similarity (ivtc, task->i1, task->i2);
+}
+
 #define GET_LINE(frame,comp,line) (((unsigned char *)(frame)->data[k]) + \
       (line) * GST_VIDEO_FRAME_COMP_STRIDE((frame), (comp)))
 #define GET_LINE_IL(top,bottom,comp,line) \
@@ -384,8 +558,12 @@ reconstruct_line (guint8 * line1, guint8 * line2, int i, int a, int b, int c,
 }
 
 
+/* Interpolates the rows of band @band out of @n_bands of every component of
+ * @dest_frame from the field @i1, the bands only read the field so they can
+ * be reconstructed in parallel */
 static void
-reconstruct_single (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1)
+reconstruct_single_band (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1,
+    int band, int n_bands)
 {
   int j;
   int k;
@@ -396,7 +574,7 @@ reconstruct_single (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1)
   for (k = 0; k < 1; k++) {
     height = GST_VIDEO_FRAME_COMP_HEIGHT (dest_frame, k);
     width = GST_VIDEO_FRAME_COMP_WIDTH (dest_frame, k);
-    for (j = 0; j < height; j++) {
+    for (j = height * band / n_bands; j < height * (band + 1) / n_bands; j++) {
       if ((j & 1) == field->parity) {
         memcpy (GET_LINE (dest_frame, k, j),
             GET_LINE (&field->frame, k, j), width);
@@ -466,7 +644,7 @@ reconstruct_single (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1)
   for (k = 1; k < 3; k++) {
     height = GST_VIDEO_FRAME_COMP_HEIGHT (dest_frame, k);
     width = GST_VIDEO_FRAME_COMP_WIDTH (dest_frame, k);
-    for (j = 0; j < height; j++) {
+    for (j = height * band / n_bands; j < height * (band + 1) / n_bands; j++) {
       if ((j & 1) == field->parity) {
         memcpy (GET_LINE (dest_frame, k, j),
             GET_LINE (&field->frame, k, j), width);
@@ -488,6 +666,35 @@ reconstruct_single (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1)
   }
 }
 
+static void
+reconstruct_single_task (GstIvtc * ivtc, GstIvtcTask * task)
+{
+  reconstruct_single_band (ivtc, task->dest_frame, task->i1, task->band,
+      task->n_bands);
+}
+
+static void
+reconstruct_single (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1)
+{
+  GstIvtcTask *tasks;
+  int height = GST_VIDEO_FRAME_HEIGHT (dest_frame);
+  int n_bands, i;
+
+  /* a band should have a few rows of every plane */
+  n_bands = MAX (MIN ((int) gst_ivtc_get_n_threads (ivtc), height / 16), 1);
+
+  tasks = g_new0 (GstIvtcTask, n_bands);
+  for (i = 0; i < n_bands; i++) {
+    tasks[i].func = reconstruct_single_task;
+    tasks[i].i1 = i1;
+    tasks[i].dest_frame = dest_frame;
+    tasks[i].band = i;
+    tasks[i].n_bands = n_bands;
+  }
+  gst_ivtc_run_tasks (ivtc, tasks, n_bands);
+  g_free (tasks);
+}
+
 static void
 gst_ivtc_retire_fields (GstIvtc * ivtc, int n_fields)
 {
@@ -576,6 +783,23 @@ gst_ivtc_construct_frame (GstIvtc * ivtc, GstBuffer * outbuf)
     forward_ok = FALSE;
   }
 
+  /* score both pairings at once if neither is known from the previous
+   * frame */
+  if (ivtc->fields[anchor_index - 1].next_score < 0 &&
+      ivtc->fields[anchor_index].next_score < 0 &&
+      gst_ivtc_get_n_threads (ivtc) > 1) {
+    GstIvtcTask tasks[2];
+
+    memset (tasks, 0, sizeof (tasks));
+    tasks[0].func = similarity_task;
+    tasks[0].i1 = anchor_index - 1;
+    tasks[0].i2 = anchor_index;
+    tasks[1].func = similarity_task;
+    tasks[1].i1 = anchor_index;
+    tasks[1].i2 = anchor_index + 1;
+    gst_ivtc_run_tasks (ivtc, tasks, 2);
+  }
+
   prev_score = similarity (ivtc, anchor_index - 1, anchor_index);
   next_score = similarity (ivtc, anchor_index, anchor_index + 1);
 
@@ -651,24 +875,8 @@ get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom)
     guint8 *src1 = GET_LINE_IL (top, bottom, 0, j - 1);
     guint8 *src2 = GET_LINE_IL (top, bottom, 0, j);
     guint8 *src3 = GET_LINE_IL (top, bottom, 0, j + 1);
-    int i;
 
-    for (i = 0; i < width; i++) {
-      if (src2[i] < MIN (src1[i], src3[i]) - 5 ||
-          src2[i] > MAX (src1[i], src3[i]) + 5) {
-        if (i > 0) {
-          thisline[i] += thisline[i - 1];
-        }
-        thisline[i]++;
-        if (thisline[i] > 1000)
-          thisline[i] = 1000;
-      } else {
-        thisline[i] = 0;
-      }
-      if (thisline[i] > 100) {
-        score++;
-      }
-    }
+    score += comb_line_accumulate (thisline, src1, src2, src3, width);
   }
 
   GST_DEBUG ("score %d", score);
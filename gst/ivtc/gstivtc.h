@@ -41,6 +41,8 @@ struct _GstIvtcField
   int parity;
   GstVideoFrame frame;
   GstClockTime ts;
+  /* comb score of this field with the next one, -1 if not computed yet */
+  int next_score;
 };
 
 #define GST_IVTC_MAX_FIELDS 10
@@ -58,6 +60,12 @@ struct _GstIvtc
 
   int n_fields;
   GstIvtcField fields[GST_IVTC_MAX_FIELDS];
+
+  guint n_threads;
+  GThreadPool *pool;
+  GMutex task_lock;
+  GCond task_cond;
+  gint tasks_pending;
 };
 
 struct _GstIvtcClass
@@ -63,9 +63,29 @@ enum
 {
   PROP_0,
   PROP_PARSE_PRIVATE_SECTIONS,
+  PROP_CLOCK_RECOVERY,
   /* FILL ME */
 };
 
+#define MPEGTS_TYPE_CLOCK_RECOVERY (mpegts_clock_recovery_get_type ())
+static GType
+mpegts_clock_recovery_get_type (void)
+{
+  static GType type = 0;
+  static const GEnumValue values[] = {
+    {MPEGTS_CLOCK_RECOVERY_SKEW, "Low point of the arrival delays", "skew"},
+    {MPEGTS_CLOCK_RECOVERY_REGRESSION,
+        "Drift estimation over the arrival delays (uses receive timestamp "
+          "metas if present)", "regression"},
+    {0, NULL, NULL},
+  };
+
+  if (!type)
+    type = g_enum_register_static ("MpegTSClockRecovery", values);
+
+  return type;
+}
+
 static void mpegts_base_dispose (GObject * object);
 static void mpegts_base_finalize (GObject * object);
 static void mpegts_base_set_property (GObject * object, guint prop_id,
@@ -138,6 +158,12 @@ mpegts_base_class_init (MpegTSBaseClass * klass)
           "Parse private sections", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_CLOCK_RECOVERY,
+      g_param_spec_enum ("clock-recovery", "Clock recovery",
+          "Algorithm used to recover the sender clock from PCRs on live "
+          "input", MPEGTS_TYPE_CLOCK_RECOVERY, MPEGTS_CLOCK_RECOVERY_SKEW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
 }
 
 static void
@@ -150,6 +176,9 @@ mpegts_base_set_property (GObject * object, guint prop_id,
     case PROP_PARSE_PRIVATE_SECTIONS:
       base->parse_private_sections = g_value_get_boolean (value);
       break;
+    case PROP_CLOCK_RECOVERY:
+      base->packetizer->clock_recovery = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -165,12 +194,28 @@ mpegts_base_get_property (GObject * object, guint prop_id,
     case PROP_PARSE_PRIVATE_SECTIONS:
       g_value_set_boolean (value, base->parse_private_sections);
       break;
+    case PROP_CLOCK_RECOVERY:
+      g_value_set_enum (value, base->packetizer->clock_recovery);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
 }
 
 
+/* Fills the packetizer PID filter from the known PSI and active PES PIDs */
+static void
+mpegts_base_update_pid_filter (MpegTSBase * base)
+{
+  MpegTSPacketizer2 *packetizer = base->packetizer;
+  guint i;
+
+  for (i = 0; i < 1024; i++)
+    packetizer->pid_filter[i] = base->known_psi[i] | base->is_pes[i];
+
+  packetizer->filter_pids = base->filter_pids;
+}
+
 static void
 mpegts_base_reset (MpegTSBase * base)
 {
@@ -217,6 +262,8 @@ mpegts_base_reset (MpegTSBase * base)
 
   if (klass->reset)
     klass->reset (base);
+
+  mpegts_base_update_pid_filter (base);
 }
 
 static void
@@ -1174,6 +1221,9 @@ mpegts_base_handle_psi (MpegTSBase * base, GstMpegtsSection * section)
       break;
   }
 
+  /* The set of PIDs we handle might have changed */
+  mpegts_base_update_pid_filter (base);
+
   /* Finally post message (if it wasn't corrupted) */
   if (post_message)
     gst_element_post_message (GST_ELEMENT_CAST (base),
@@ -1404,6 +1454,10 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
       goto next;
     }
 
+    /* PID we don't handle, dropped by the packetizer */
+    if (pret == PACKET_SKIPPED)
+      goto next;
+
     if (klass->inspect_packet)
       klass->inspect_packet (base, &packet);
 
@@ -1463,6 +1517,9 @@ mpegts_base_scan (MpegTSBase * base)
 
   GST_DEBUG ("Scanning for initial sync point");
 
+  /* PCR can be on any PID, we need to see all packets while scanning */
+  base->packetizer->filter_pids = FALSE;
+
   /* Find initial sync point and at least 5 PCR values */
   for (i = 0; i < 20 && !done; i++) {
     GST_DEBUG ("Grabbing %d => %d", i * 65536, (i + 1) * 65536);
@@ -1549,10 +1606,12 @@ mpegts_base_scan (MpegTSBase * base)
 
 beach:
   mpegts_packetizer_clear (base->packetizer);
+  mpegts_base_update_pid_filter (base);
   return ret;
 
 no_initial_pcr:
   mpegts_packetizer_clear (base->packetizer);
+  mpegts_base_update_pid_filter (base);
   GST_WARNING_OBJECT (base, "Couldn't find any PCR within the first %d bytes",
       10 * 65536);
   return GST_FLOW_OK;
@@ -158,6 +158,10 @@ struct _MpegTSBase {
   gboolean push_data;
   gboolean push_section;
 
+  /* Whether packets on PIDs which are neither known PSI nor PES can be
+   * dropped by the packetizer without being parsed */
+  gboolean filter_pids;
+
   /* Whether the parent bin is streams-aware, meaning we can
    * add/remove streams at any point in time */
   gboolean streams_aware;
@@ -33,6 +33,9 @@
 #define PCR_GST_MAX_VALUE (PCR_MAX_VALUE * GST_MSECOND / (PCR_MSECOND))
 #define PTS_DTS_MAX_VALUE (((guint64)1) << 33)
 
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
+
 #include "mpegtspacketizer.h"
 #include "gstmpegdesc.h"
 
@@ -48,7 +51,13 @@ G_DEFINE_TYPE_EXTENDED (MpegTSPacketizer2, mpegts_packetizer, G_TYPE_OBJECT, 0,
 #define PACKETIZER_GROUP_LOCK(p) g_mutex_lock(&((p)->group_lock))
 #define PACKETIZER_GROUP_UNLOCK(p) g_mutex_unlock(&((p)->group_lock))
 
+/* Minimum span of the regression window before the drift is used */
+#define MIN_REGRESSION_TIME GST_SECOND
+
+static GstStaticCaps unix_timestamp_caps = GST_STATIC_CAPS ("timestamp/x-unix");
+
 static void mpegts_packetizer_dispose (GObject * object);
+static void mpegts_packetizer_unmap (MpegTSPacketizer2 * packetizer);
 static void mpegts_packetizer_finalize (GObject * object);
 static GstClockTime calculate_skew (MpegTSPacketizer2 * packetizer,
     MpegTSPCR * pcr, guint64 pcrtime, GstClockTime time);
@@ -82,6 +91,7 @@ get_pcr_table (MpegTSPacketizer2 * packetizer, guint16 pid)
     res->pid = pid;
     res->base_time = GST_CLOCK_TIME_NONE;
     res->base_pcrtime = GST_CLOCK_TIME_NONE;
+    res->base_ref_time = GST_CLOCK_TIME_NONE;
     res->last_pcrtime = GST_CLOCK_TIME_NONE;
     res->window_pos = 0;
     res->window_filling = TRUE;
@@ -178,6 +188,75 @@ seen_section_before (MpegTSPacketizerStream * stream, guint8 table_id,
   return MPEGTS_BIT_IS_SET (subtable->seen_section, section_number);
 }
 
+static inline MpegTSPacketizerSectionCacheEntry *
+section_cache_entry (MpegTSPacketizerStream * stream, guint8 section_number,
+    guint32 crc)
+{
+  return &stream->section_cache[(crc ^ section_number) %
+      SECTION_CACHE_SIZE];
+}
+
+/* Returns TRUE if the complete long section with the given header and
+ * CRC was already handled. This is a stricter (and cheaper) version of
+ * seen_section_before() for sections that fit in the current packet */
+static gboolean
+seen_section_cached (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerStream * stream, guint8 table_id,
+    guint16 subtable_extension, guint8 version_number, guint8 section_number,
+    guint8 last_section_number, guint section_length, guint32 crc)
+{
+  MpegTSPacketizerSectionCacheEntry *entry;
+
+  if (stream->section_cache == NULL)
+    goto miss;
+
+  entry = section_cache_entry (stream, section_number, crc);
+  if (entry->subtable == NULL || entry->crc != crc
+      || entry->table_id != table_id
+      || entry->subtable_extension != subtable_extension
+      || entry->version_number != version_number
+      || entry->section_number != section_number
+      || entry->last_section_number != last_section_number
+      || entry->section_length != section_length)
+    goto miss;
+
+  /* The subtable might have moved to another version since */
+  if (entry->subtable->version_number != version_number
+      || entry->subtable->last_section_number != last_section_number
+      || !MPEGTS_BIT_IS_SET (entry->subtable->seen_section, section_number))
+    goto miss;
+
+  packetizer->section_cache_hits++;
+  return TRUE;
+
+miss:
+  packetizer->section_cache_misses++;
+  return FALSE;
+}
+
+static void
+section_cache_add (MpegTSPacketizerStream * stream,
+    MpegTSPacketizerStreamSubtable * subtable)
+{
+  MpegTSPacketizerSectionCacheEntry *entry;
+  guint32 crc;
+
+  if (G_UNLIKELY (stream->section_cache == NULL))
+    stream->section_cache =
+        g_new0 (MpegTSPacketizerSectionCacheEntry, SECTION_CACHE_SIZE);
+
+  crc = GST_READ_UINT32_BE (stream->section_data + stream->section_length - 4);
+  entry = section_cache_entry (stream, stream->section_number, crc);
+  entry->crc = crc;
+  entry->table_id = stream->table_id;
+  entry->subtable_extension = stream->subtable_extension;
+  entry->version_number = stream->version_number;
+  entry->section_number = stream->section_number;
+  entry->last_section_number = stream->last_section_number;
+  entry->section_length = stream->section_length;
+  entry->subtable = subtable;
+}
+
 static MpegTSPacketizerStreamSubtable *
 mpegts_packetizer_stream_subtable_new (guint8 table_id,
     guint16 subtable_extension, guint8 last_section_number)
@@ -230,6 +309,7 @@ mpegts_packetizer_stream_free (MpegTSPacketizerStream * stream)
   g_slist_foreach (stream->subtables,
       (GFunc) mpegts_packetizer_stream_subtable_free, NULL);
   g_slist_free (stream->subtables);
+  g_free (stream->section_cache);
   g_free (stream);
 }
 
@@ -255,11 +335,15 @@ mpegts_packetizer_init (MpegTSPacketizer2 * packetizer)
   packetizer->streams = g_new0 (MpegTSPacketizerStream *, 8192);
   packetizer->packet_size = 0;
   packetizer->calculate_skew = FALSE;
+  packetizer->clock_recovery = MPEGTS_CLOCK_RECOVERY_SKEW;
+  packetizer->last_in_ref_time = GST_CLOCK_TIME_NONE;
   packetizer->calculate_offset = FALSE;
 
+  packetizer->map_buffer = NULL;
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->map_checked = 0;
   packetizer->need_sync = FALSE;
 
   memset (packetizer->pcrtablelut, 0xff, 0x2000);
@@ -270,6 +354,9 @@ mpegts_packetizer_init (MpegTSPacketizer2 * packetizer)
   packetizer->refoffset = -1;
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
   packetizer->pcr_discont_threshold = GST_SECOND;
+
+  packetizer->filter_pids = FALSE;
+  memset (packetizer->pid_filter, 0xff, sizeof (packetizer->pid_filter));
 }
 
 static void
@@ -278,6 +365,9 @@ mpegts_packetizer_dispose (GObject * object)
   MpegTSPacketizer2 *packetizer = GST_MPEGTS_PACKETIZER (object);
 
   if (!packetizer->disposed) {
+    GST_DEBUG ("Section cache: %" G_GUINT64_FORMAT " hits, %"
+        G_GUINT64_FORMAT " misses", packetizer->section_cache_hits,
+        packetizer->section_cache_misses);
     if (packetizer->packet_size)
       packetizer->packet_size = 0;
     if (packetizer->streams) {
@@ -289,6 +379,7 @@ mpegts_packetizer_dispose (GObject * object)
       g_free (packetizer->streams);
     }
 
+    mpegts_packetizer_unmap (packetizer);
     gst_adapter_clear (packetizer->adapter);
     g_object_unref (packetizer->adapter);
     g_mutex_clear (&packetizer->group_lock);
@@ -467,6 +558,11 @@ mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
   packet->pid = GST_READ_UINT16_BE (data) & 0x1FFF;
   data += 2;
 
+  /* Skip PIDs nobody is interested in before doing any further work */
+  if (packetizer->filter_pids
+      && !MPEGTS_BIT_IS_SET (packetizer->pid_filter, packet->pid))
+    return PACKET_SKIPPED;
+
   packet->scram_afc_cc = tmp = *data++;
   /* transport_scrambling_control 2 */
   if (G_UNLIKELY (tmp & 0xc0))
@@ -521,6 +617,9 @@ mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
 
   GST_MEMDUMP ("Full section data", stream->section_data,
       stream->section_length);
+  /* Only long sections end with a CRC */
+  if ((stream->section_data[1] & 0x80) && stream->section_length >= 12)
+    section_cache_add (stream, subtable);
   /* TODO ? : Replace this by an efficient version (where we provide all
    * pre-parsed header data) */
   res =
@@ -571,13 +670,11 @@ mpegts_packetizer_clear (MpegTSPacketizer2 * packetizer)
     memset (packetizer->streams, 0, 8192 * sizeof (MpegTSPacketizerStream *));
   }
 
+  mpegts_packetizer_unmap (packetizer);
   gst_adapter_clear (packetizer->adapter);
   packetizer->offset = 0;
   packetizer->empty = TRUE;
   packetizer->need_sync = FALSE;
-  packetizer->map_data = NULL;
-  packetizer->map_size = 0;
-  packetizer->map_offset = 0;
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
 
   pcrtable = packetizer->observations[packetizer->pcrtablelut[0x1fff]];
@@ -610,14 +707,12 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer, gboolean hard)
       }
     }
   }
+  mpegts_packetizer_unmap (packetizer);
   gst_adapter_clear (packetizer->adapter);
 
   packetizer->offset = 0;
   packetizer->empty = TRUE;
   packetizer->need_sync = FALSE;
-  packetizer->map_data = NULL;
-  packetizer->map_size = 0;
-  packetizer->map_offset = 0;
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
 
   pcrtable = packetizer->observations[packetizer->pcrtablelut[0x1fff]];
@@ -675,21 +770,44 @@ mpegts_packetizer_push (MpegTSPacketizer2 * packetizer, GstBuffer * buffer)
       GST_BUFFER_OFFSET (buffer));
   gst_adapter_push (packetizer->adapter, buffer);
   /* If buffer timestamp is valid, store it */
-  if (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_TIMESTAMP (buffer)))
+  if (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_TIMESTAMP (buffer))) {
     packetizer->last_in_time = GST_BUFFER_TIMESTAMP (buffer);
+
+    if (packetizer->clock_recovery == MPEGTS_CLOCK_RECOVERY_REGRESSION) {
+      GstReferenceTimestampMeta *meta =
+          gst_buffer_get_reference_timestamp_meta (buffer,
+          gst_static_caps_get (&unix_timestamp_caps));
+
+      packetizer->last_in_ref_time =
+          meta ? meta->timestamp : GST_CLOCK_TIME_NONE;
+    }
+  }
 }
 
 static void
-mpegts_packetizer_flush_bytes (MpegTSPacketizer2 * packetizer, gsize size)
+mpegts_packetizer_unmap (MpegTSPacketizer2 * packetizer)
 {
-  if (size > 0) {
-    GST_LOG ("flushing %" G_GSIZE_FORMAT " bytes from adapter", size);
-    gst_adapter_flush (packetizer->adapter, size);
+  if (packetizer->map_buffer) {
+    gst_buffer_unmap (packetizer->map_buffer, &packetizer->map_info);
+    gst_buffer_unref (packetizer->map_buffer);
+    packetizer->map_buffer = NULL;
   }
 
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->map_checked = 0;
+}
+
+static void
+mpegts_packetizer_flush_bytes (MpegTSPacketizer2 * packetizer, gsize size)
+{
+  mpegts_packetizer_unmap (packetizer);
+
+  if (size > 0) {
+    GST_LOG ("flushing %" G_GSIZE_FORMAT " bytes from adapter", size);
+    gst_adapter_flush (packetizer->adapter, size);
+  }
 }
 
 static gboolean
@@ -706,19 +824,71 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   if (available < size)
     return FALSE;
 
-  packetizer->map_data =
-      (guint8 *) gst_adapter_map (packetizer->adapter, available);
-  if (!packetizer->map_data)
+  /* Keep a reference to the mapped buffer so that payloads can be handed
+   * out without copying (see mpegts_packetizer_get_payload_buffer()) */
+  packetizer->map_buffer =
+      gst_adapter_get_buffer (packetizer->adapter, available);
+  if (!packetizer->map_buffer)
+    return FALSE;
+
+  if (!gst_buffer_map (packetizer->map_buffer, &packetizer->map_info,
+          GST_MAP_READ)) {
+    gst_buffer_unref (packetizer->map_buffer);
+    packetizer->map_buffer = NULL;
     return FALSE;
+  }
 
+  packetizer->map_data = packetizer->map_info.data;
   packetizer->map_size = available;
   packetizer->map_offset = 0;
+  packetizer->map_checked = 0;
 
   GST_LOG ("mapped %" G_GSIZE_FORMAT " bytes from adapter", available);
 
   return TRUE;
 }
 
+/* Returns the position of the first sync byte in data[from..end[, or end if
+ * there is none. memchr() is vectorized in all C libraries we care about,
+ * which makes this considerably faster than a byte-by-byte loop when
+ * skipping over garbage */
+static inline gsize
+mpegts_packetizer_find_sync_byte (const guint8 * data, gsize from, gsize end)
+{
+  const guint8 *found;
+
+  if (from >= end)
+    return end;
+
+  found = memchr (data + from, PACKET_SYNC_BYTE, end - from);
+  if (found == NULL)
+    return end;
+
+  return found - data;
+}
+
+/* Validates in one pass the sync bytes of all complete packets available in
+ * the currently mapped region, starting from map_offset. Packets up to
+ * map_checked can then be handed out without any further checking */
+static void
+mpegts_packetizer_check_sync (MpegTSPacketizer2 * packetizer,
+    gsize sync_offset)
+{
+  const guint8 *data = packetizer->map_data;
+  guint packet_size = packetizer->packet_size;
+  gsize pos = packetizer->map_offset;
+  gsize end = packetizer->map_size;
+
+  while (pos + packet_size <= end
+      && data[pos + sync_offset] == PACKET_SYNC_BYTE)
+    pos += packet_size;
+
+  packetizer->map_checked = pos;
+
+  GST_LOG ("validated %" G_GSIZE_FORMAT " packets",
+      (pos - packetizer->map_offset) / packet_size);
+}
+
 static gboolean
 mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 {
@@ -740,8 +910,12 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 
   for (i = 0; i + 3 * MPEGTS_MAX_PACKETSIZE < size; i++) {
     /* find a sync byte */
-    if (data[i] != PACKET_SYNC_BYTE)
-      continue;
+    if (data[i] != PACKET_SYNC_BYTE) {
+      i = mpegts_packetizer_find_sync_byte (data, i,
+          size - 3 * MPEGTS_MAX_PACKETSIZE);
+      if (i + 3 * MPEGTS_MAX_PACKETSIZE >= size)
+        break;
+    }
 
     /* check for 4 consecutive sync bytes with each possible packet size */
     for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
@@ -797,6 +971,11 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
     sync_offset = 0;
 
   for (i = sync_offset; i + 2 * packet_size < size; i++) {
+    if (data[i] != PACKET_SYNC_BYTE) {
+      i = mpegts_packetizer_find_sync_byte (data, i, size - 2 * packet_size);
+      if (i + 2 * packet_size >= size)
+        break;
+    }
     if (data[i] == PACKET_SYNC_BYTE &&
         data[i + packet_size] == PACKET_SYNC_BYTE &&
         data[i + 2 * packet_size] == PACKET_SYNC_BYTE) {
@@ -846,8 +1025,11 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
 
     packet_data = &packetizer->map_data[packetizer->map_offset + sync_offset];
 
-    /* Check sync byte */
-    if (G_UNLIKELY (*packet_data != PACKET_SYNC_BYTE)) {
+    /* Check sync bytes of all packets in the mapped region at once */
+    if (packetizer->map_offset >= packetizer->map_checked)
+      mpegts_packetizer_check_sync (packetizer, sync_offset);
+
+    if (G_UNLIKELY (packetizer->map_offset >= packetizer->map_checked)) {
       GST_DEBUG ("lost sync");
       packetizer->need_sync = TRUE;
     } else {
@@ -892,6 +1074,21 @@ mpegts_packetizer_clear_packet (MpegTSPacketizer2 * packetizer,
   }
 }
 
+/* Returns a new buffer sharing the input memory for the @size bytes at
+ * @data, which must be within the packet currently handed out. No data is
+ * copied. */
+GstBuffer *
+mpegts_packetizer_get_payload_buffer (MpegTSPacketizer2 * packetizer,
+    const guint8 * data, gsize size)
+{
+  g_return_val_if_fail (packetizer->map_buffer != NULL, NULL);
+  g_return_val_if_fail (data >= packetizer->map_data &&
+      data + size <= packetizer->map_data + packetizer->map_size, NULL);
+
+  return gst_buffer_copy_region (packetizer->map_buffer,
+      GST_BUFFER_COPY_MEMORY, data - packetizer->map_data, size);
+}
+
 gboolean
 mpegts_packetizer_has_packets (MpegTSPacketizer2 * packetizer)
 {
@@ -1166,7 +1363,13 @@ section_start:
    * * same last_section_number
    * * same section_number was seen
    */
-  if (seen_section_before (stream, table_id, subtable_extension,
+  if ((long_packet && section_length >= 12
+          && section_length <= packet->data_end - data_start
+          && seen_section_cached (packetizer, stream, table_id,
+              subtable_extension, version_number, section_number,
+              last_section_number, section_length,
+              GST_READ_UINT32_BE (data_start + section_length - 4)))
+      || seen_section_before (stream, table_id, subtable_extension,
           version_number, section_number, last_section_number)) {
     GST_DEBUG
         ("PID 0x%04x Already processed table_id:0x%02x subtable_extension:0x%04x, version_number:%d, section_number:%d",
@@ -1233,10 +1436,72 @@ mpegts_packetizer_resync (MpegTSPCR * pcr, GstClockTime time,
     pcr->window_min = 0;
     pcr->window_size = 0;
     pcr->skew = 0;
+    pcr->drift = 0;
   }
 }
 
 
+/* Alternative to the low point averaging of calculate_skew(). The drift
+ * between the sender and receiver clocks is estimated by a least squares
+ * fit of the delays over the window. Each delay is then projected to the
+ * current time using that drift, and the skew is the lowest of the
+ * projected delays. Compared to averaging the low point, this follows
+ * clock drift without lagging behind and is less sensitive to bursts. */
+static void
+calculate_skew_regression (MpegTSPCR * pcr, guint64 send_diff, gint64 delta)
+{
+  gdouble mean_x = 0, mean_y = 0, sxx = 0, sxy = 0, slope = 0;
+  gint64 skew = G_MAXINT64, span = 0;
+  guint i, n;
+
+  pcr->window[pcr->window_pos] = delta;
+  pcr->window_send[pcr->window_pos] = send_diff;
+  pcr->window_pos = (pcr->window_pos + 1) % MAX_WINDOW;
+  if (pcr->window_size < MAX_WINDOW)
+    pcr->window_size++;
+  n = pcr->window_size;
+
+  /* Use times relative to the current one to keep the precision */
+  for (i = 0; i < n; i++) {
+    gint64 x = pcr->window_send[i] - (gint64) send_diff;
+
+    mean_x += x;
+    mean_y += pcr->window[i];
+    span = MAX (span, -x);
+  }
+  mean_x /= n;
+  mean_y /= n;
+
+  if (span >= MIN_REGRESSION_TIME) {
+    for (i = 0; i < n; i++) {
+      gdouble dx = (pcr->window_send[i] - (gint64) send_diff) - mean_x;
+
+      sxx += dx * dx;
+      sxy += dx * (pcr->window[i] - mean_y);
+    }
+    if (sxx > 0)
+      slope = sxy / sxx;
+  }
+
+  for (i = 0; i < n; i++) {
+    gint64 x = pcr->window_send[i] - (gint64) send_diff;
+    gint64 projected = pcr->window[i] - (gint64) (slope * x);
+
+    if (projected < skew)
+      skew = projected;
+  }
+
+  /* Smooth out the steps caused by low points leaving the window */
+  if (n < MAX_WINDOW)
+    pcr->skew = skew;
+  else
+    pcr->skew = (skew + 15 * pcr->skew) / 16;
+  pcr->drift = slope * 1000000.0;
+
+  GST_DEBUG ("delta %" G_GINT64_FORMAT ", skew %" G_GINT64_FORMAT
+      ", drift %f ppm", delta, pcr->skew, pcr->drift);
+}
+
 /* Code mostly copied from -good/gst/rtpmanager/rtpjitterbuffer.c */
 
 /* For the clock skew we use a windowed low point averaging algorithm as can be
@@ -1319,6 +1584,7 @@ calculate_skew (MpegTSPacketizer2 * packetizer,
   /* first time, lock on to time and gstpcrtime */
   if (G_UNLIKELY (!GST_CLOCK_TIME_IS_VALID (pcr->base_time))) {
     pcr->base_time = time;
+    pcr->base_ref_time = packetizer->last_in_ref_time;
     pcr->prev_out_time = GST_CLOCK_TIME_NONE;
     GST_DEBUG ("Taking new base time %" GST_TIME_FORMAT, GST_TIME_ARGS (time));
   }
@@ -1404,7 +1670,12 @@ calculate_skew (MpegTSPacketizer2 * packetizer,
     goto no_skew;
 
   /* elapsed time at receiver, includes the jitter */
-  recv_diff = time - pcr->base_time;
+  if (packetizer->clock_recovery == MPEGTS_CLOCK_RECOVERY_REGRESSION
+      && GST_CLOCK_TIME_IS_VALID (packetizer->last_in_ref_time)
+      && GST_CLOCK_TIME_IS_VALID (pcr->base_ref_time))
+    recv_diff = packetizer->last_in_ref_time - pcr->base_ref_time;
+  else
+    recv_diff = time - pcr->base_time;
 
   /* Ignore packets received at 100% the same time (i.e. from the same input buffer) */
   if (G_UNLIKELY (time == pcr->prev_in_time
@@ -1433,10 +1704,16 @@ calculate_skew (MpegTSPacketizer2 * packetizer,
     GST_WARNING ("delta - skew: %" GST_TIME_FORMAT " too big, reset skew",
         GST_TIME_ARGS (delta - pcr->skew));
     mpegts_packetizer_resync (pcr, time, gstpcrtime, TRUE);
+    pcr->base_ref_time = packetizer->last_in_ref_time;
     send_diff = 0;
     delta = 0;
   }
 
+  if (packetizer->clock_recovery == MPEGTS_CLOCK_RECOVERY_REGRESSION) {
+    calculate_skew_regression (pcr, send_diff, delta);
+    goto no_skew;
+  }
+
   pos = pcr->window_pos;
 
   if (G_UNLIKELY (pcr->window_filling)) {
@@ -2474,6 +2751,29 @@ mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
   PACKETIZER_GROUP_UNLOCK (packetizer);
 }
 
+/* Returns the drift of the @pcr_pid clock measured by
+ * MPEGTS_CLOCK_RECOVERY_REGRESSION, in ppm */
+gboolean
+mpegts_packetizer_get_clock_drift (MpegTSPacketizer2 * packetizer,
+    guint16 pcr_pid, gdouble * drift)
+{
+  MpegTSPCR *pcrtable;
+  gboolean res = FALSE;
+
+  PACKETIZER_GROUP_LOCK (packetizer);
+  pcrtable = packetizer->observations[packetizer->pcrtablelut[pcr_pid]];
+  if (packetizer->calculate_skew
+      && packetizer->clock_recovery == MPEGTS_CLOCK_RECOVERY_REGRESSION
+      && pcrtable && pcrtable->pid == pcr_pid
+      && GST_CLOCK_TIME_IS_VALID (pcrtable->base_time)) {
+    *drift = pcrtable->drift;
+    res = TRUE;
+  }
+  PACKETIZER_GROUP_UNLOCK (packetizer);
+
+  return res;
+}
+
 void
 mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
     GstClockTime offset, guint16 pcr_pid)
@@ -2539,3 +2839,158 @@ mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
   }
   PACKETIZER_GROUP_UNLOCK (packetizer);
 }
+
+/* PCR/offset index persistence.
+ *
+ * The observations of all PCR PIDs are serialized (big-endian) as:
+ *   magic "TSIX", version, reference offset, number of PCR tables
+ *   for each table: pid, number of groups
+ *     for each group: flags, first_pcr, first_offset, pcr_offset,
+ *                     number of values, values (pcr, offset)
+ */
+#define PCR_INDEX_MAGIC 0x54534958
+#define PCR_INDEX_VERSION 1
+
+GBytes *
+mpegts_packetizer_save_pcr_index (MpegTSPacketizer2 * packetizer)
+{
+  GstByteWriter bw;
+  guint i, j;
+  gsize size;
+
+  gst_byte_writer_init (&bw);
+
+  gst_byte_writer_put_uint32_be (&bw, PCR_INDEX_MAGIC);
+  gst_byte_writer_put_uint32_be (&bw, PCR_INDEX_VERSION);
+  gst_byte_writer_put_uint64_be (&bw, packetizer->refoffset);
+
+  PACKETIZER_GROUP_LOCK (packetizer);
+  gst_byte_writer_put_uint32_be (&bw, packetizer->lastobsid);
+  for (i = 0; i < packetizer->lastobsid; i++) {
+    MpegTSPCR *pcrtable = packetizer->observations[i];
+    GList *tmp;
+
+    gst_byte_writer_put_uint16_be (&bw, pcrtable->pid);
+    gst_byte_writer_put_uint32_be (&bw, g_list_length (pcrtable->groups));
+    for (tmp = pcrtable->groups; tmp; tmp = tmp->next) {
+      PCROffsetGroup *group = (PCROffsetGroup *) tmp->data;
+
+      if (group->flags & PCR_GROUP_FLAG_ESTIMATED)
+        _reevaluate_group_pcr_offset (pcrtable, group);
+
+      gst_byte_writer_put_uint32_be (&bw, group->flags);
+      gst_byte_writer_put_uint64_be (&bw, group->first_pcr);
+      gst_byte_writer_put_uint64_be (&bw, group->first_offset);
+      gst_byte_writer_put_uint64_be (&bw, group->pcr_offset);
+      gst_byte_writer_put_uint32_be (&bw, group->last_value + 1);
+      for (j = 0; j <= group->last_value; j++) {
+        gst_byte_writer_put_uint64_be (&bw, group->values[j].pcr);
+        gst_byte_writer_put_uint64_be (&bw, group->values[j].offset);
+      }
+    }
+  }
+  PACKETIZER_GROUP_UNLOCK (packetizer);
+
+  size = gst_byte_writer_get_size (&bw);
+  return g_bytes_new_take (gst_byte_writer_reset_and_get_data (&bw), size);
+}
+
+/* Replaces the PCR/offset observations with the ones from @index (as
+ * created by mpegts_packetizer_save_pcr_index()). Returns FALSE if @index
+ * is invalid, in which case the observations are left untouched */
+gboolean
+mpegts_packetizer_load_pcr_index (MpegTSPacketizer2 * packetizer,
+    GBytes * index)
+{
+  GstByteReader br;
+  guint32 magic, version, nb_tables, nb_groups, nb_values;
+  guint64 refoffset;
+  GList *tables = NULL, *groups;
+  guint16 pid;
+  guint i, j, k;
+
+  gst_byte_reader_init (&br, g_bytes_get_data (index, NULL),
+      g_bytes_get_size (index));
+
+  if (!gst_byte_reader_get_uint32_be (&br, &magic) || magic != PCR_INDEX_MAGIC
+      || !gst_byte_reader_get_uint32_be (&br, &version)
+      || version != PCR_INDEX_VERSION
+      || !gst_byte_reader_get_uint64_be (&br, &refoffset)
+      || !gst_byte_reader_get_uint32_be (&br, &nb_tables)
+      || nb_tables > MAX_PCR_OBS_CHANNELS)
+    goto invalid;
+
+  /* Parse everything first, only apply once we know the index is valid */
+  for (i = 0; i < nb_tables; i++) {
+    if (!gst_byte_reader_get_uint16_be (&br, &pid) || pid > 0x1fff
+        || !gst_byte_reader_get_uint32_be (&br, &nb_groups))
+      goto invalid_free;
+
+    groups = NULL;
+    for (j = 0; j < nb_groups; j++) {
+      PCROffsetGroup *group;
+      guint32 flags;
+      guint64 first_pcr, first_offset, pcr_offset;
+
+      if (!gst_byte_reader_get_uint32_be (&br, &flags)
+          || !gst_byte_reader_get_uint64_be (&br, &first_pcr)
+          || !gst_byte_reader_get_uint64_be (&br, &first_offset)
+          || !gst_byte_reader_get_uint64_be (&br, &pcr_offset)
+          || !gst_byte_reader_get_uint32_be (&br, &nb_values)
+          || nb_values == 0
+          || gst_byte_reader_get_remaining (&br) / 16 < nb_values) {
+        g_list_free_full (groups, (GDestroyNotify) pcr_offset_group_free);
+        goto invalid_free;
+      }
+
+      group = _new_group (first_pcr, first_offset, pcr_offset, flags);
+      group->nb_allocated = nb_values;
+      group->values = g_renew (PCROffset, group->values, nb_values);
+      for (k = 0; k < nb_values; k++) {
+        group->values[k].pcr = gst_byte_reader_get_uint64_be_unchecked (&br);
+        group->values[k].offset =
+            gst_byte_reader_get_uint64_be_unchecked (&br);
+      }
+      group->last_value = nb_values - 1;
+      groups = g_list_prepend (groups, group);
+    }
+    groups = g_list_reverse (groups);
+    tables = g_list_append (tables, GUINT_TO_POINTER ((guint) pid));
+    tables = g_list_append (tables, groups);
+  }
+
+  PACKETIZER_GROUP_LOCK (packetizer);
+  while (tables) {
+    MpegTSPCR *pcrtable;
+
+    pid = GPOINTER_TO_UINT (tables->data);
+    tables = g_list_delete_link (tables, tables);
+    groups = tables->data;
+    tables = g_list_delete_link (tables, tables);
+
+    pcrtable = get_pcr_table (packetizer, pid);
+    g_list_free_full (pcrtable->groups,
+        (GDestroyNotify) pcr_offset_group_free);
+    memset (pcrtable->current, 0, sizeof (PCROffsetCurrent));
+    pcrtable->groups = groups;
+    packetizer->nb_seen_offsets += g_list_length (groups);
+  }
+  PACKETIZER_GROUP_UNLOCK (packetizer);
+
+  if (packetizer->refoffset == -1)
+    packetizer->refoffset = refoffset;
+
+  GST_DEBUG ("Loaded PCR index for %u PCR PIDs", nb_tables);
+
+  return TRUE;
+
+invalid_free:
+  while (tables) {
+    tables = g_list_delete_link (tables, tables);
+    g_list_free_full (tables->data, (GDestroyNotify) pcr_offset_group_free);
+    tables = g_list_delete_link (tables, tables);
+  }
+invalid:
+  GST_WARNING ("Invalid PCR index");
+  return FALSE;
+}
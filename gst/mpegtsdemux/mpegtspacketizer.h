@@ -65,6 +65,7 @@ G_BEGIN_DECLS
 
 typedef struct _MpegTSPacketizer2 MpegTSPacketizer2;
 typedef struct _MpegTSPacketizer2Class MpegTSPacketizer2Class;
+typedef struct _MpegTSPacketizerSectionCacheEntry MpegTSPacketizerSectionCacheEntry;
 
 typedef struct
 {
@@ -87,6 +88,10 @@ typedef struct
 
   GSList *subtables;
 
+  /* Recently seen complete sections, allocated on first use
+   * (SECTION_CACHE_SIZE entries) */
+  MpegTSPacketizerSectionCacheEntry *section_cache;
+
   /* Upstream offset of the data contained in the section */
   guint64 offset;
 } MpegTSPacketizerStream;
@@ -211,6 +216,18 @@ typedef struct _PCROffsetCurrent
   guint64 prev_bitrate;
 } PCROffsetCurrent;
 
+/* Clock recovery algorithms used when calculate_skew is TRUE */
+typedef enum
+{
+  /* Low point of the arrival delay over a window (see calculate_skew) */
+  MPEGTS_CLOCK_RECOVERY_SKEW = 0,
+  /* Drift estimated by linear regression over the window, the skew being
+   * the low point of the drift-compensated arrival delays. Uses the
+   * "timestamp/x-unix" GstReferenceTimestampMeta of input buffers (for
+   * example kernel receive timestamps) as arrival time if present */
+  MPEGTS_CLOCK_RECOVERY_REGRESSION
+} MpegTSClockRecovery;
+
 typedef struct _MpegTSPCR
 {
   guint16 pid;
@@ -230,6 +247,13 @@ typedef struct _MpegTSPCR
   gint64 skew;
   gint64 prev_send_diff;
 
+  /* MPEGTS_CLOCK_RECOVERY_REGRESSION: reference arrival time matching
+   * base_time, send_diff of each window value, and measured drift of the
+   * sender clock compared to the arrival times (in ppm) */
+  GstClockTime base_ref_time;
+  gint64 window_send[MAX_WINDOW];
+  gdouble drift;
+
   /* Offset to apply to PCR to handle wraparounds */
   guint64 pcroffset;
 
@@ -259,14 +283,19 @@ struct _MpegTSPacketizer2 {
 
   /* clock skew calculation */
   gboolean       calculate_skew;
+  MpegTSClockRecovery clock_recovery;
 
   /* offset/bitrate calculator */
   gboolean       calculate_offset;
 
   /* Shortcuts for adapter usage */
+  GstBuffer *map_buffer;
+  GstMapInfo map_info;
   guint8 *map_data;
   gsize map_offset;
   gsize map_size;
+  /* Offset in the mapped data up to which sync bytes were validated */
+  gsize map_checked;
   gboolean need_sync;
 
   /* Reference offset */
@@ -283,6 +312,20 @@ struct _MpegTSPacketizer2 {
   MpegTSPCR *observations[MAX_PCR_OBS_CHANNELS];
   guint8 lastobsid;
   GstClockTime pcr_discont_threshold;
+
+  /* Reference arrival time of the last input buffer, see
+   * MPEGTS_CLOCK_RECOVERY_REGRESSION */
+  GstClockTime last_in_ref_time;
+
+  /* PID filter. If filter_pids is TRUE only packets whose PID is set in
+   * pid_filter are parsed, the others are skipped right after the header.
+   * Use MPEGTS_BIT_* macros to set/unset/check the values */
+  gboolean filter_pids;
+  guint8 pid_filter[1024];
+
+  /* Section cache statistics */
+  guint64 section_cache_hits;
+  guint64 section_cache_misses;
 };
 
 struct _MpegTSPacketizer2Class {
@@ -325,6 +368,25 @@ typedef struct
   guint8   seen_section[32];
 } MpegTSPacketizerStreamSubtable;
 
+/* Number of entries of the per-PID section cache */
+#define SECTION_CACHE_SIZE 64
+
+/* Identifies a section by its header and its last 4 bytes (the CRC for
+ * long sections), so that repeats can be recognized without looking up the
+ * subtable or accumulating the data again */
+struct _MpegTSPacketizerSectionCacheEntry
+{
+  guint32 crc;
+  guint16 subtable_extension;
+  guint8  table_id;
+  guint8  version_number;
+  guint8  section_number;
+  guint8  last_section_number;
+  guint16 section_length;
+  /* NULL if the entry is unused */
+  MpegTSPacketizerStreamSubtable *subtable;
+};
+
 #define MPEGTS_BIT_SET(field, offs)    ((field)[(offs) >> 3] |=  (1 << ((offs) & 0x7)))
 #define MPEGTS_BIT_UNSET(field, offs)  ((field)[(offs) >> 3] &= ~(1 << ((offs) & 0x7)))
 #define MPEGTS_BIT_IS_SET(field, offs) ((field)[(offs) >> 3] &   (1 << ((offs) & 0x7)))
@@ -332,7 +394,9 @@ typedef struct
 typedef enum {
   PACKET_BAD       = FALSE,
   PACKET_OK        = TRUE,
-  PACKET_NEED_MORE
+  PACKET_NEED_MORE,
+  /* Packet was dropped by the PID filter */
+  PACKET_SKIPPED
 } MpegTSPacketizerPacketReturn;
 
 G_GNUC_INTERNAL GType mpegts_packetizer_get_type(void);
@@ -351,6 +415,9 @@ G_GNUC_INTERNAL void mpegts_packetizer_clear_packet (MpegTSPacketizer2 *packetiz
 G_GNUC_INTERNAL void mpegts_packetizer_remove_stream(MpegTSPacketizer2 *packetizer,
   gint16 pid);
 
+G_GNUC_INTERNAL GstBuffer *mpegts_packetizer_get_payload_buffer (MpegTSPacketizer2 *packetizer,
+  const guint8 *data, gsize size);
+
 G_GNUC_INTERNAL GstMpegtsSection *mpegts_packetizer_push_section (MpegTSPacketizer2 *packetzer,
 								  MpegTSPacketizerPacket *packet, GList **remaining);
 
@@ -376,6 +443,14 @@ mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
 G_GNUC_INTERNAL void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
 					GstClockTime threshold);
+G_GNUC_INTERNAL gboolean
+mpegts_packetizer_get_clock_drift (MpegTSPacketizer2 * packetizer,
+					guint16 pcr_pid, gdouble * drift);
+G_GNUC_INTERNAL GBytes *
+mpegts_packetizer_save_pcr_index (MpegTSPacketizer2 * packetizer);
+G_GNUC_INTERNAL gboolean
+mpegts_packetizer_load_pcr_index (MpegTSPacketizer2 * packetizer,
+				  GBytes * index);
 G_END_DECLS
 
 #endif /* GST_MPEGTS_PACKETIZER_H */
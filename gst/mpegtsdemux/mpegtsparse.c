@@ -64,6 +64,14 @@ struct _MpegTSParsePad
 
   /* the return of the latest push */
   GstFlowReturn flow_return;
+
+  /* Packets waiting to be pushed when batching (see batch-packets). Each
+   * buffer of the list holds up to GST_BUFFER_MEM_MAX memories sharing the
+   * input data */
+  GstBufferList *batch;
+  guint batch_packets;
+  /* Input timestamp of the first packet of the batch */
+  GstClockTime batch_start;
 };
 
 static GstStaticPadTemplate src_template =
@@ -84,6 +92,8 @@ enum
   PROP_SET_TIMESTAMPS,
   PROP_SMOOTHING_LATENCY,
   PROP_PCR_PID,
+  PROP_BATCH_PACKETS,
+  PROP_BATCH_LATENCY,
   /* FILL ME */
 };
 
@@ -105,6 +115,7 @@ static void mpegts_parse_inspect_packet (MpegTSBase * base,
 
 static MpegTSParsePad *mpegts_parse_create_tspad (MpegTSParse2 * parse,
     const gchar * name);
+static void mpegts_parse_tspad_clear_batch (MpegTSParsePad * tspad);
 static void mpegts_parse_destroy_tspad (MpegTSParse2 * parse,
     MpegTSParsePad * tspad);
 
@@ -159,6 +170,17 @@ mpegts_parse_class_init (MpegTSParse2Class * klass)
       g_param_spec_int ("pcr-pid", "PID containing PCR",
           "Set the PID to use for PCR values (-1 for auto)",
           -1, G_MAXINT, -1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BATCH_PACKETS,
+      g_param_spec_uint ("batch-packets", "Packets per push on program pads",
+          "Number of packets pushed at once on program pads, as a buffer "
+          "list sharing the input memory (0 or 1 = push every packet)",
+          0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BATCH_LATENCY,
+      g_param_spec_uint ("batch-latency", "Batch latency",
+          "Maximum time in microseconds packets are held back on program "
+          "pads when batching, based on input timestamps (0 = push at the "
+          "end of each input buffer)",
+          0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   element_class = GST_ELEMENT_CLASS (klass);
   element_class->pad_removed = mpegts_parse_pad_removed;
@@ -193,6 +215,9 @@ mpegts_parse_init (MpegTSParse2 * parse)
   /* We will only need to handle data/section if we have request pads */
   base->push_data = FALSE;
   base->push_section = FALSE;
+  /* The full stream goes out of the src pad untouched, only request pads
+   * need the parsed packets */
+  base->filter_pids = TRUE;
 
   parse->user_pcr_pid = parse->pcr_pid = -1;
 
@@ -213,6 +238,7 @@ static void
 mpegts_parse_reset (MpegTSBase * base)
 {
   MpegTSParse2 *parse = (MpegTSParse2 *) base;
+  GList *tmp;
 
   /* Set the various know PIDs we are interested in */
 
@@ -244,6 +270,9 @@ mpegts_parse_reset (MpegTSBase * base)
   g_list_free_full (parse->pending_buffers, (GDestroyNotify) gst_buffer_unref);
   parse->pending_buffers = NULL;
 
+  for (tmp = parse->srcpads; tmp; tmp = tmp->next)
+    mpegts_parse_tspad_clear_batch (gst_pad_get_element_private (tmp->data));
+
   parse->current_pcr = GST_CLOCK_TIME_NONE;
   parse->previous_pcr = GST_CLOCK_TIME_NONE;
   parse->base_pcr = GST_CLOCK_TIME_NONE;
@@ -261,6 +290,8 @@ mpegts_parse_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_SET_TIMESTAMPS:
       parse->set_timestamps = g_value_get_boolean (value);
+      /* PCR auto-selection needs to inspect all packets */
+      GST_MPEGTS_BASE (parse)->filter_pids = !parse->set_timestamps;
       break;
     case PROP_SMOOTHING_LATENCY:
       parse->smoothing_latency = GST_USECOND * g_value_get_uint (value);
@@ -270,6 +301,12 @@ mpegts_parse_set_property (GObject * object, guint prop_id,
     case PROP_PCR_PID:
       parse->pcr_pid = parse->user_pcr_pid = g_value_get_int (value);
       break;
+    case PROP_BATCH_PACKETS:
+      parse->batch_packets = g_value_get_uint (value);
+      break;
+    case PROP_BATCH_LATENCY:
+      parse->batch_latency = GST_USECOND * g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -291,6 +328,12 @@ mpegts_parse_get_property (GObject * object, guint prop_id,
     case PROP_PCR_PID:
       g_value_set_int (value, parse->pcr_pid);
       break;
+    case PROP_BATCH_PACKETS:
+      g_value_set_uint (value, parse->batch_packets);
+      break;
+    case PROP_BATCH_LATENCY:
+      g_value_set_uint (value, parse->batch_latency / GST_USECOND);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -380,6 +423,13 @@ push_event (MpegTSBase * base, GstEvent * event)
   for (tmp = parse->srcpads; tmp; tmp = tmp->next) {
     GstPad *pad = (GstPad *) tmp->data;
     if (pad) {
+      MpegTSParsePad *tspad = gst_pad_get_element_private (pad);
+
+      /* Keep batched packets ordered with serialized events */
+      if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+        mpegts_parse_tspad_clear_batch (tspad);
+      else if (GST_EVENT_IS_SERIALIZED (event))
+        mpegts_parse_tspad_push_batch (parse, tspad);
       gst_event_ref (event);
       gst_pad_push_event (pad, event);
     }
@@ -407,6 +457,7 @@ mpegts_parse_create_tspad (MpegTSParse2 * parse, const gchar * pad_name)
   tspad->program = NULL;
   tspad->pushed = FALSE;
   tspad->flow_return = GST_FLOW_NOT_LINKED;
+  tspad->batch_start = GST_CLOCK_TIME_NONE;
   gst_pad_set_element_private (pad, tspad);
   gst_flow_combiner_add_pad (parse->flowcombiner, pad);
 
@@ -416,6 +467,7 @@ mpegts_parse_create_tspad (MpegTSParse2 * parse, const gchar * pad_name)
 static void
 mpegts_parse_destroy_tspad (MpegTSParse2 * parse, MpegTSParsePad * tspad)
 {
+  mpegts_parse_tspad_clear_batch (tspad);
   /* free the wrapper */
   g_free (tspad);
 }
@@ -525,6 +577,94 @@ mpegts_parse_release_pad (GstElement * element, GstPad * pad)
   gst_element_remove_pad (element, pad);
 }
 
+static void
+mpegts_parse_tspad_clear_batch (MpegTSParsePad * tspad)
+{
+  if (tspad->batch) {
+    gst_buffer_list_unref (tspad->batch);
+    tspad->batch = NULL;
+  }
+  tspad->batch_packets = 0;
+  tspad->batch_start = GST_CLOCK_TIME_NONE;
+}
+
+static GstFlowReturn
+mpegts_parse_tspad_push_batch (MpegTSParse2 * parse, MpegTSParsePad * tspad)
+{
+  GstBufferList *list = tspad->batch;
+  GstFlowReturn ret;
+
+  if (list == NULL)
+    return GST_FLOW_OK;
+
+  tspad->batch = NULL;
+  GST_LOG_OBJECT (tspad->pad, "Pushing %u packets", tspad->batch_packets);
+  tspad->batch_packets = 0;
+  tspad->batch_start = GST_CLOCK_TIME_NONE;
+
+  if (gst_buffer_list_length (list) == 1) {
+    GstBuffer *buf = gst_buffer_ref (gst_buffer_list_get (list, 0));
+    gst_buffer_list_unref (list);
+    ret = gst_pad_push (tspad->pad, buf);
+  } else {
+    ret = gst_pad_push_list (tspad->pad, list);
+  }
+
+  return gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+}
+
+/* Pushes the packet on the pad, or adds it to the pending batch. The
+ * packet data is shared with the input and not copied */
+static GstFlowReturn
+mpegts_parse_tspad_push_packet (MpegTSParse2 * parse, MpegTSParsePad * tspad,
+    MpegTSPacketizerPacket * packet)
+{
+  MpegTSBase *base = (MpegTSBase *) parse;
+  GstBuffer *buf, *last;
+  GstMemory *mem, *prev;
+  gsize offset;
+  guint len, n;
+
+  buf = mpegts_packetizer_get_payload_buffer (base->packetizer,
+      packet->data_start, packet->data_end - packet->data_start);
+
+  if (parse->batch_packets <= 1) {
+    GstFlowReturn ret = gst_pad_push (tspad->pad, buf);
+    return gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+  }
+
+  if (tspad->batch == NULL) {
+    tspad->batch = gst_buffer_list_new_sized (1);
+    tspad->batch_start = base->packetizer->last_in_time;
+  }
+
+  len = gst_buffer_list_length (tspad->batch);
+  last = len ? gst_buffer_list_get (tspad->batch, len - 1) : NULL;
+  mem = gst_buffer_n_memory (buf) == 1 ? gst_buffer_peek_memory (buf, 0) :
+      NULL;
+  n = last ? gst_buffer_n_memory (last) : 0;
+  prev = n ? gst_buffer_peek_memory (last, n - 1) : NULL;
+
+  if (mem && prev && gst_memory_is_span (prev, mem, &offset)) {
+    /* Contiguous with the previous packet, extend its memory */
+    last = gst_buffer_list_get_writable (tspad->batch, len - 1);
+    gst_buffer_replace_memory (last, n - 1, gst_memory_share (prev->parent,
+            offset, prev->size + mem->size));
+    gst_buffer_unref (buf);
+  } else if (mem && n && n < GST_BUFFER_MEM_MAX) {
+    last = gst_buffer_list_get_writable (tspad->batch, len - 1);
+    gst_buffer_append_memory (last, gst_memory_ref (mem));
+    gst_buffer_unref (buf);
+  } else {
+    gst_buffer_list_add (tspad->batch, buf);
+  }
+
+  if (++tspad->batch_packets >= parse->batch_packets)
+    return mpegts_parse_tspad_push_batch (parse, tspad);
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 mpegts_parse_tspad_push_section (MpegTSParse2 * parse, MpegTSParsePad * tspad,
     GstMpegtsSection * section, MpegTSPacketizerPacket * packet)
@@ -553,14 +693,8 @@ mpegts_parse_tspad_push_section (MpegTSParse2 * parse, MpegTSParsePad * tspad,
       "pushing section: %d program number: %d table_id: %d", to_push,
       tspad->program_number, section->table_id);
 
-  if (to_push) {
-    GstBuffer *buf =
-        gst_buffer_new_and_alloc (packet->data_end - packet->data_start);
-    gst_buffer_fill (buf, 0, packet->data_start,
-        packet->data_end - packet->data_start);
-    ret = gst_pad_push (tspad->pad, buf);
-    ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
-  }
+  if (to_push)
+    ret = mpegts_parse_tspad_push_packet (parse, tspad, packet);
 
   GST_LOG_OBJECT (parse, "Returning %s", gst_flow_get_name (ret));
   return ret;
@@ -584,13 +718,8 @@ mpegts_parse_tspad_push (MpegTSParse2 * parse, MpegTSParsePad * tspad,
   if (bp) {
     if (packet->pid == bp->pmt_pid || bp->streams == NULL
         || bp->streams[packet->pid]) {
-      GstBuffer *buf =
-          gst_buffer_new_and_alloc (packet->data_end - packet->data_start);
-      gst_buffer_fill (buf, 0, packet->data_start,
-          packet->data_end - packet->data_start);
       /* push if there's no filter or if the pid is in the filter */
-      ret = gst_pad_push (tspad->pad, buf);
-      ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+      ret = mpegts_parse_tspad_push_packet (parse, tspad, packet);
     }
   }
   GST_DEBUG_OBJECT (parse, "Returning %s", gst_flow_get_name (ret));
@@ -857,6 +986,33 @@ drain_pending_buffers (MpegTSParse2 * parse, gboolean drain_all)
   return ret;
 }
 
+/* Pushes the batches that are due at the end of an input buffer */
+static GstFlowReturn
+mpegts_parse_push_batches (MpegTSParse2 * parse, GstClockTime in_time)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GList *tmp;
+
+  for (tmp = parse->srcpads; tmp; tmp = tmp->next) {
+    MpegTSParsePad *tspad = gst_pad_get_element_private (tmp->data);
+
+    if (tspad->batch == NULL)
+      continue;
+
+    if (parse->batch_latency == 0
+        || (GST_CLOCK_TIME_IS_VALID (in_time)
+            && GST_CLOCK_TIME_IS_VALID (tspad->batch_start)
+            && in_time >= tspad->batch_start + parse->batch_latency)) {
+      ret = mpegts_parse_tspad_push_batch (parse, tspad);
+      if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)
+        break;
+      ret = GST_FLOW_OK;
+    }
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 mpegts_parse_input_done (MpegTSBase * base, GstBuffer * buffer)
 {
@@ -872,6 +1028,14 @@ mpegts_parse_input_done (MpegTSBase * base, GstBuffer * buffer)
         GST_TIME_ARGS (parse->current_pcr));
   }
 
+  if (parse->batch_packets > 1) {
+    ret = mpegts_parse_push_batches (parse, GST_BUFFER_PTS (buffer));
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      return ret;
+    }
+  }
+
   if (parse->set_timestamps || parse->first) {
     parse->pending_buffers = g_list_prepend (parse->pending_buffers, buffer);
     parse->bytes_since_pcr += gst_buffer_get_size (buffer);
@@ -59,6 +59,10 @@ struct _MpegTSParse2 {
   gint user_pcr_pid;
   gint pcr_pid;
 
+  /* Batching on program pads */
+  guint batch_packets;
+  GstClockTime batch_latency;
+
   /* Always present source pad */
   GstPad *srcpad;
 
@@ -47,6 +47,7 @@
 #include "mpegtspacketizer.h"
 #include "pesparse.h"
 #include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
 #include <gst/codecparsers/gstmpegvideoparser.h>
 #include <gst/video/video-color.h>
 
@@ -112,7 +113,28 @@ typedef struct
 
 typedef struct _TSDemuxStream TSDemuxStream;
 
+/* Per-stream counters reported by the stats property. They are only
+ * written from the streaming thread */
+typedef struct
+{
+  GstClockTime start;
+  guint64 packets;
+  guint64 bytes;
+  guint64 cc_errors;
+  /* Number of PES pushed, and total time spent between the PES header
+   * and the push */
+  guint64 pes;
+  GstClockTime assembly_time;
+  /* Number of pushes and time spent in them */
+  guint64 pushes;
+  GstClockTime push_time;
+  GstClockTime max_push_time;
+  /* Buffers waiting for a valid timestamp */
+  guint pending;
+} TSDemuxStreamStats;
+
 typedef struct _TSDemuxH264ParsingInfos TSDemuxH264ParsingInfos;
+typedef struct _TSDemuxH265ParsingInfos TSDemuxH265ParsingInfos;
 typedef struct _TSDemuxJP2KParsingInfos TSDemuxJP2KParsingInfos;
 
 /* Returns TRUE if a keyframe was found */
@@ -135,6 +157,12 @@ struct _TSDemuxH264ParsingInfos
   SimpleBuffer framedata;
 };
 
+struct _TSDemuxH265ParsingInfos
+{
+  /* H265 parsing data */
+  GstH265Parser *parser;
+};
+
 struct _TSDemuxJP2KParsingInfos
 {
   /* J2K parsing data */
@@ -169,10 +197,21 @@ struct _TSDemuxStream
   /* Size of ->data */
   guint allocated_size;
 
+  /* Payload being reconstructed without copies (zero-copy mode). Contains
+   * buffers referencing the input memory, ->data is then unused */
+  GstAdapter *payload;
+  /* Number of buffers in ->payload */
+  guint payload_chunks;
+
   /* Current PTS/DTS for this stream (in running time) */
   GstClockTime pts;
   GstClockTime dts;
 
+  /* Statistics (see stats property) */
+  TSDemuxStreamStats stats;
+  /* Time at which the header of the current PES was parsed */
+  GstClockTime pes_start;
+
   /* Reference PTS used to detect gaps */
   GstClockTime gap_ref_pts;
   /* Number of outputted buffers */
@@ -207,9 +246,43 @@ struct _TSDemuxStream
 
   GstTsDemuxKeyFrameScanFunction scan_function;
   TSDemuxH264ParsingInfos h264infos;
+  TSDemuxH265ParsingInfos h265infos;
   TSDemuxJP2KParsingInfos jp2kInfos;
+
+  /* Threaded output: buffers and serialized events are queued in out_queue
+   * and pushed from the pad task. Protected by out_lock */
+  gboolean threaded;
+  GMutex out_lock;
+  GCond out_cond;
+  GQueue out_queue;
+  gboolean out_flushing;
+  /* TRUE while the pad task is pushing an item */
+  gboolean out_pushing;
+  /* Last flow return from downstream */
+  GstFlowReturn out_ret;
 };
 
+/* Keyframe index entry */
+typedef struct
+{
+  /* Stream time of the keyframe */
+  GstClockTime ts;
+  /* Offset from which reading yields that keyframe first */
+  guint64 offset;
+} TSDemuxIndexEntry;
+
+/* Index sidecar file */
+#define INDEX_FILE_MAGIC 0x54534449   /* "TSDI" */
+#define INDEX_FILE_VERSION 1
+
+/* Keyframes from the index are only used if they are at most this far
+ * before the seek target, otherwise it's cheaper to scan from the PCR
+ * estimate */
+#define INDEX_MAX_KEYFRAME_DISTANCE (5 * GST_SECOND)
+
+/* Maximum number of buffers/events queued per stream in threaded mode */
+#define MAX_OUTPUT_QUEUE_ITEMS 64
+
 #define VIDEO_CAPS \
   GST_STATIC_CAPS (\
     "video/mpeg, " \
@@ -282,6 +355,11 @@ enum
   PROP_0,
   PROP_PROGRAM_NUMBER,
   PROP_EMIT_STATS,
+  PROP_ZERO_COPY,
+  PROP_BYTES_COPIED,
+  PROP_THREADED_OUTPUT,
+  PROP_INDEX_LOCATION,
+  PROP_STATS,
   /* FILL ME */
 };
 
@@ -299,6 +377,9 @@ static gboolean
 gst_ts_demux_can_remove_program (MpegTSBase * base,
     MpegTSBaseProgram * program);
 static void gst_ts_demux_reset (MpegTSBase * base);
+static void gst_ts_demux_save_index (GstTSDemux * demux);
+static const TSDemuxIndexEntry *gst_ts_demux_index_find_keyframe (GstTSDemux *
+    demux, GstClockTime ts);
 static GstFlowReturn
 gst_ts_demux_push (MpegTSBase * base, MpegTSPacketizerPacket * packet,
     GstMpegtsSection * section);
@@ -320,6 +401,16 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
     MpegTSBaseProgram * program);
 static void gst_ts_demux_stream_flush (TSDemuxStream * stream,
     GstTSDemux * demux, gboolean hard);
+static void gst_ts_demux_stream_clear_payload (TSDemuxStream * stream);
+static GstFlowReturn gst_ts_demux_stream_push (TSDemuxStream * stream,
+    GstMiniObject * obj);
+static gboolean gst_ts_demux_stream_push_event (TSDemuxStream * stream,
+    GstEvent * event);
+static void gst_ts_demux_stream_drain_output (TSDemuxStream * stream);
+static gboolean gst_ts_demux_srcpad_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+static void gst_ts_demux_stream_append_payload (GstTSDemux * demux,
+    TSDemuxStream * stream, const guint8 * data, guint size);
 
 static gboolean push_event (MpegTSBase * base, GstEvent * event);
 static void gst_ts_demux_check_and_sync_streams (GstTSDemux * demux,
@@ -348,6 +439,16 @@ gst_ts_demux_dispose (GObject * object)
 
   gst_flow_combiner_free (demux->flowcombiner);
 
+  g_list_free (demux->stats_streams);
+  demux->stats_streams = NULL;
+
+  g_free (demux->index_location);
+  demux->index_location = NULL;
+  if (demux->keyframe_index) {
+    g_array_free (demux->keyframe_index, TRUE);
+    demux->keyframe_index = NULL;
+  }
+
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
 
@@ -373,6 +474,38 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
           "Emit messages for every pcr/opcr/pts/dts", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero copy",
+          "Assemble PES packets from references to the input memory instead "
+          "of copying the payload (only flattened when tsdemux itself needs "
+          "to inspect it)", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BYTES_COPIED,
+      g_param_spec_uint64 ("bytes-copied", "Bytes copied",
+          "Total amount of payload bytes copied while assembling PES packets",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_THREADED_OUTPUT,
+      g_param_spec_boolean ("threaded-output", "Threaded output",
+          "Push the data of each stream from its own streaming thread, so "
+          "that a slow downstream element only stalls its own stream. Only "
+          "applies to streams created after the property is set", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "File used to load and store a PCR and keyframe offset index of "
+          "the stream, to speed up seeking in pull mode (NULL = none)",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Per-PID statistics of the active program: packets and bytes "
+          "(total and per second), continuity errors, PES assembly latency, "
+          "pending and queued buffers and push timings",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   element_class = GST_ELEMENT_CLASS (klass);
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&video_template));
@@ -410,6 +543,12 @@ gst_ts_demux_reset (MpegTSBase * base)
 {
   GstTSDemux *demux = (GstTSDemux *) base;
 
+  if (demux->index_loaded || base->packetizer->nb_seen_offsets)
+    gst_ts_demux_save_index (demux);
+  if (demux->keyframe_index)
+    g_array_set_size (demux->keyframe_index, 0);
+  demux->index_loaded = FALSE;
+
   demux->rate = 1.0;
   gst_segment_init (&demux->segment, GST_FORMAT_UNDEFINED);
   if (demux->segment_event) {
@@ -443,14 +582,79 @@ gst_ts_demux_init (GstTSDemux * demux)
   base->parse_private_sections = TRUE;
   /* We are not interested in sections (all handled by mpegtsbase) */
   base->push_section = FALSE;
+  /* Only the active program and PSI need to be parsed */
+  base->filter_pids = TRUE;
 
   demux->flowcombiner = gst_flow_combiner_new ();
+  demux->keyframe_index = g_array_new (FALSE, FALSE,
+      sizeof (TSDemuxIndexEntry));
   demux->requested_program_number = -1;
   demux->program_number = -1;
   gst_ts_demux_reset (base);
 }
 
 
+static GstStructure *
+gst_ts_demux_stream_get_stats (TSDemuxStream * stream, GstClockTime now)
+{
+  TSDemuxStreamStats *stats = &stream->stats;
+  GstClockTime elapsed = now - stats->start;
+  guint queued = 0;
+
+  if (stream->threaded) {
+    g_mutex_lock (&stream->out_lock);
+    queued = g_queue_get_length (&stream->out_queue);
+    g_mutex_unlock (&stream->out_lock);
+  }
+
+  return gst_structure_new ("tsdemux-pid-stats",
+      "pid", G_TYPE_UINT, stream->stream.pid,
+      "stream-type", G_TYPE_UINT, stream->stream.stream_type,
+      "packets", G_TYPE_UINT64, stats->packets,
+      "bytes", G_TYPE_UINT64, stats->bytes,
+      "packets-per-sec", G_TYPE_UINT64, elapsed ?
+      gst_util_uint64_scale (stats->packets, GST_SECOND, elapsed) : 0,
+      "bytes-per-sec", G_TYPE_UINT64, elapsed ?
+      gst_util_uint64_scale (stats->bytes, GST_SECOND, elapsed) : 0,
+      "continuity-errors", G_TYPE_UINT64, stats->cc_errors,
+      "pes", G_TYPE_UINT64, stats->pes,
+      "avg-assembly-latency", G_TYPE_UINT64, stats->pes ?
+      stats->assembly_time / stats->pes : 0,
+      "pending-buffers", G_TYPE_UINT, stats->pending,
+      "queued-items", G_TYPE_UINT, queued,
+      "pushes", G_TYPE_UINT64, stats->pushes,
+      "avg-push-time", G_TYPE_UINT64, stats->pushes ?
+      stats->push_time / stats->pushes : 0,
+      "max-push-time", G_TYPE_UINT64, stats->max_push_time, NULL);
+}
+
+static GstStructure *
+gst_ts_demux_get_stats (GstTSDemux * demux)
+{
+  GstStructure *res;
+  GValue streams = G_VALUE_INIT;
+  GstClockTime now = gst_util_get_timestamp ();
+  GList *tmp;
+
+  g_value_init (&streams, GST_TYPE_ARRAY);
+
+  GST_OBJECT_LOCK (demux);
+  for (tmp = demux->stats_streams; tmp; tmp = tmp->next) {
+    GValue v = G_VALUE_INIT;
+
+    g_value_init (&v, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&v, gst_ts_demux_stream_get_stats (tmp->data, now));
+    gst_value_array_append_and_take_value (&streams, &v);
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  res = gst_structure_new ("tsdemux-stats",
+      "bytes-copied", G_TYPE_UINT64, demux->bytes_copied, NULL);
+  gst_structure_take_value (res, "streams", &streams);
+
+  return res;
+}
+
 static void
 gst_ts_demux_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -466,6 +670,18 @@ gst_ts_demux_set_property (GObject * object, guint prop_id,
     case PROP_EMIT_STATS:
       demux->emit_statistics = g_value_get_boolean (value);
       break;
+    case PROP_ZERO_COPY:
+      demux->zero_copy = g_value_get_boolean (value);
+      break;
+    case PROP_THREADED_OUTPUT:
+      demux->threaded_output = g_value_get_boolean (value);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (demux);
+      g_free (demux->index_location);
+      demux->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -484,6 +700,23 @@ gst_ts_demux_get_property (GObject * object, guint prop_id,
     case PROP_EMIT_STATS:
       g_value_set_boolean (value, demux->emit_statistics);
       break;
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, demux->zero_copy);
+      break;
+    case PROP_BYTES_COPIED:
+      g_value_set_uint64 (value, demux->bytes_copied);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_ts_demux_get_stats (demux));
+      break;
+    case PROP_THREADED_OUTPUT:
+      g_value_set_boolean (value, demux->threaded_output);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_string (value, demux->index_location);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -605,6 +838,37 @@ gst_ts_demux_srcpad_query (GstPad * pad, GstObject * parent, GstQuery * query)
       res = TRUE;
       break;
     }
+    case GST_QUERY_CUSTOM:
+    {
+      GstStructure *s = gst_query_writable_structure (query);
+
+      /* "tsdemux-index" query: reports the number of indexed keyframes and,
+       * if a "time" field is given, the byte offset a seek to that time
+       * would start reading from */
+      if (s && gst_structure_has_name (s, "tsdemux-index")) {
+        const TSDemuxIndexEntry *entry;
+        guint64 ts, offset;
+
+        gst_structure_set (s, "keyframes", G_TYPE_UINT,
+            demux->keyframe_index->len, NULL);
+        if (gst_structure_get_uint64 (s, "time", &ts)) {
+          entry = gst_ts_demux_index_find_keyframe (demux, ts);
+          if (entry && ts - entry->ts <= INDEX_MAX_KEYFRAME_DISTANCE)
+            offset = entry->offset;
+          else if (demux->program)
+            offset = mpegts_packetizer_ts_to_offset (base->packetizer, ts,
+                demux->program->pcr_pid);
+          else
+            offset = -1;
+          res = offset != -1;
+          if (res)
+            gst_structure_set (s, "offset", G_TYPE_UINT64, offset, NULL);
+        }
+      } else {
+        res = gst_pad_query_default (pad, parent, query);
+      }
+      break;
+    }
     default:
       res = gst_pad_query_default (pad, parent, query);
   }
@@ -788,6 +1052,130 @@ scan_keyframe_h264 (TSDemuxStream * stream, const guint8 * data,
   return FALSE;
 }
 
+/* PES packets carry one access unit each, so for H.265 the parameter sets
+ * come along with the IRAP picture and the PES can be pushed as-is */
+static gboolean
+scan_keyframe_h265 (TSDemuxStream * stream, const guint8 * data,
+    const gsize data_size, const gsize max_frame_offset)
+{
+  gint offset = 0;
+  GstH265NalUnit unit;
+  GstH265ParserResult res = GST_H265_PARSER_OK;
+  TSDemuxH265ParsingInfos *h265infos = &stream->h265infos;
+
+  if (G_UNLIKELY (h265infos->parser == NULL))
+    h265infos->parser = gst_h265_parser_new ();
+
+  while (res == GST_H265_PARSER_OK) {
+    res = gst_h265_parser_identify_nalu (h265infos->parser, data, offset,
+        data_size, &unit);
+
+    if (res != GST_H265_PARSER_OK && res != GST_H265_PARSER_NO_NAL_END) {
+      GST_INFO_OBJECT (stream->pad, "Error identifying nalu: %i", res);
+      break;
+    }
+
+    /* IRAP pictures (BLA, IDR, CRA) of the base layer. The MSB of the byte
+     * following the NAL header is first_slice_segment_in_pic_flag */
+    if (unit.type >= GST_H265_NAL_SLICE_BLA_W_LP
+        && unit.type <= RESERVED_IRAP_NAL_TYPE_MAX && unit.layer_id == 0
+        && unit.size > unit.header_bytes
+        && (unit.data[unit.offset + unit.header_bytes] & 0x80)) {
+      GST_DEBUG_OBJECT (stream->pad, "Found IRAP picture (type %u) at: %u",
+          unit.type, unit.sc_offset);
+      return TRUE;
+    }
+
+    if (offset == unit.sc_offset + unit.size)
+      break;
+
+    offset = unit.sc_offset + unit.size;
+  }
+
+  return FALSE;
+}
+
+/* MPEG-1/2 video: a sequence header followed by an I picture */
+static gboolean
+scan_keyframe_mpeg_video (TSDemuxStream * stream, const guint8 * data,
+    const gsize data_size, const gsize max_frame_offset)
+{
+  GstMpegVideoPacket packet;
+  gboolean have_seqhdr = FALSE;
+  guint offset = 0;
+
+  while (gst_mpeg_video_parse (&packet, data, data_size, offset)) {
+    switch (packet.type) {
+      case GST_MPEG_VIDEO_PACKET_SEQUENCE:
+        have_seqhdr = TRUE;
+        break;
+      case GST_MPEG_VIDEO_PACKET_PICTURE:
+      {
+        GstMpegVideoPictureHdr pichdr;
+
+        if (packet.size < 0)
+          packet.size = data_size - packet.offset;
+        /* Only the first picture of the PES matters */
+        if (!gst_mpeg_video_packet_parse_picture_header (&packet, &pichdr))
+          return FALSE;
+        if (have_seqhdr && pichdr.pic_type == GST_MPEG_VIDEO_PICTURE_TYPE_I) {
+          GST_DEBUG_OBJECT (stream->pad, "Found I picture at: %u",
+              packet.offset - 4);
+          return TRUE;
+        }
+        return FALSE;
+      }
+      default:
+        break;
+    }
+
+    if (packet.size < 0)
+      break;
+    offset = packet.offset + packet.size;
+  }
+
+  return FALSE;
+}
+
+/* Every access unit of intra-only codecs is a keyframe */
+static gboolean
+scan_keyframe_intra (TSDemuxStream * stream, const guint8 * data,
+    const gsize data_size, const gsize max_frame_offset)
+{
+  return TRUE;
+}
+
+/* Keyframe scanners used for accurate seeking in pull mode */
+static const struct
+{
+  guint8 stream_type;
+  GstTsDemuxKeyFrameScanFunction scan_function;
+} keyframe_scanners[] = {
+  {GST_MPEGTS_STREAM_TYPE_VIDEO_H264,
+      (GstTsDemuxKeyFrameScanFunction) scan_keyframe_h264},
+  {GST_MPEGTS_STREAM_TYPE_VIDEO_HEVC,
+      (GstTsDemuxKeyFrameScanFunction) scan_keyframe_h265},
+  {GST_MPEGTS_STREAM_TYPE_VIDEO_MPEG1,
+      (GstTsDemuxKeyFrameScanFunction) scan_keyframe_mpeg_video},
+  {GST_MPEGTS_STREAM_TYPE_VIDEO_MPEG2,
+      (GstTsDemuxKeyFrameScanFunction) scan_keyframe_mpeg_video},
+  {GST_MPEGTS_STREAM_TYPE_VIDEO_JP2K,
+      (GstTsDemuxKeyFrameScanFunction) scan_keyframe_intra},
+};
+
+static GstTsDemuxKeyFrameScanFunction
+gst_ts_demux_get_scan_function (guint8 stream_type)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (keyframe_scanners); i++) {
+    if (keyframe_scanners[i].stream_type == stream_type)
+      return keyframe_scanners[i].scan_function;
+  }
+
+  return NULL;
+}
+
 /* We merge data from TS packets so that the scanning methods get a continuous chunk,
  however the scanning method will return keyframe offset which needs to be translated
  back to actual offset in file */
@@ -815,6 +1203,193 @@ gst_ts_demux_adjust_seek_offset_for_keyframe (TSDemuxStream * stream,
   return TRUE;
 }
 
+static gint
+compare_index_entry (const TSDemuxIndexEntry * a, const TSDemuxIndexEntry * b)
+{
+  if (a->ts < b->ts)
+    return -1;
+  if (a->ts > b->ts)
+    return 1;
+  return 0;
+}
+
+static void
+gst_ts_demux_index_add_keyframe (GstTSDemux * demux, GstClockTime ts,
+    guint64 offset)
+{
+  TSDemuxIndexEntry entry = { ts, offset };
+  TSDemuxIndexEntry *next;
+  guint idx;
+
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    return;
+
+  next = gst_array_binary_search (demux->keyframe_index->data,
+      demux->keyframe_index->len, sizeof (TSDemuxIndexEntry),
+      (GCompareDataFunc) compare_index_entry, GST_SEARCH_MODE_AFTER, &entry,
+      NULL);
+  if (next) {
+    if (next->ts == ts)
+      return;
+    idx = next - (TSDemuxIndexEntry *) demux->keyframe_index->data;
+  } else {
+    idx = demux->keyframe_index->len;
+  }
+
+  GST_DEBUG_OBJECT (demux, "Adding keyframe %" GST_TIME_FORMAT " at offset %"
+      G_GUINT64_FORMAT " to index", GST_TIME_ARGS (ts), offset);
+  g_array_insert_val (demux->keyframe_index, idx, entry);
+}
+
+/* Returns the index entry of the closest keyframe before @ts, or NULL */
+static const TSDemuxIndexEntry *
+gst_ts_demux_index_find_keyframe (GstTSDemux * demux, GstClockTime ts)
+{
+  TSDemuxIndexEntry entry = { ts, 0 };
+
+  return gst_array_binary_search (demux->keyframe_index->data,
+      demux->keyframe_index->len, sizeof (TSDemuxIndexEntry),
+      (GCompareDataFunc) compare_index_entry, GST_SEARCH_MODE_BEFORE,
+      &entry, NULL);
+}
+
+static gint64
+gst_ts_demux_get_upstream_size (GstTSDemux * demux)
+{
+  gint64 size;
+
+  if (!gst_pad_peer_query_duration (((MpegTSBase *) demux)->sinkpad,
+          GST_FORMAT_BYTES, &size))
+    return -1;
+
+  return size;
+}
+
+static void
+gst_ts_demux_load_index (GstTSDemux * demux)
+{
+  MpegTSBase *base = (MpegTSBase *) demux;
+  GstByteReader br;
+  gchar *location, *contents = NULL;
+  gsize length;
+  guint32 magic, version, pcr_size, nb_keyframes, i;
+  guint64 upstream_size;
+  const guint8 *pcr_data;
+  GBytes *pcr_index;
+  GError *err = NULL;
+
+  demux->index_loaded = TRUE;
+
+  GST_OBJECT_LOCK (demux);
+  location = g_strdup (demux->index_location);
+  GST_OBJECT_UNLOCK (demux);
+
+  if (location == NULL || !base->packetizer->calculate_offset)
+    goto done;
+
+  if (!g_file_get_contents (location, &contents, &length, &err)) {
+    GST_DEBUG_OBJECT (demux, "Couldn't read index file: %s", err->message);
+    g_clear_error (&err);
+    goto done;
+  }
+
+  gst_byte_reader_init (&br, (const guint8 *) contents, length);
+  if (!gst_byte_reader_get_uint32_be (&br, &magic) || magic != INDEX_FILE_MAGIC
+      || !gst_byte_reader_get_uint32_be (&br, &version)
+      || version != INDEX_FILE_VERSION
+      || !gst_byte_reader_get_uint64_be (&br, &upstream_size)
+      || !gst_byte_reader_get_uint32_be (&br, &pcr_size)
+      || !gst_byte_reader_get_data (&br, pcr_size, &pcr_data)
+      || !gst_byte_reader_get_uint32_be (&br, &nb_keyframes)
+      || gst_byte_reader_get_remaining (&br) / 16 < nb_keyframes) {
+    GST_WARNING_OBJECT (demux, "Invalid index file %s", location);
+    goto done;
+  }
+
+  if (upstream_size != gst_ts_demux_get_upstream_size (demux)) {
+    GST_WARNING_OBJECT (demux, "Index file %s doesn't match the stream",
+        location);
+    goto done;
+  }
+
+  pcr_index = g_bytes_new_static (pcr_data, pcr_size);
+  if (mpegts_packetizer_load_pcr_index (base->packetizer, pcr_index)) {
+    g_array_set_size (demux->keyframe_index, 0);
+    for (i = 0; i < nb_keyframes; i++) {
+      TSDemuxIndexEntry entry;
+
+      entry.ts = gst_byte_reader_get_uint64_be_unchecked (&br);
+      entry.offset = gst_byte_reader_get_uint64_be_unchecked (&br);
+      /* Stored sorted */
+      g_array_append_val (demux->keyframe_index, entry);
+    }
+    GST_INFO_OBJECT (demux, "Loaded index from %s (%u keyframes)", location,
+        nb_keyframes);
+  }
+  g_bytes_unref (pcr_index);
+
+done:
+  g_free (contents);
+  g_free (location);
+}
+
+static void
+gst_ts_demux_save_index (GstTSDemux * demux)
+{
+  MpegTSBase *base = (MpegTSBase *) demux;
+  GstByteWriter bw;
+  GBytes *pcr_index;
+  gchar *location;
+  gint64 upstream_size;
+  gsize size, length;
+  const guint8 *data;
+  guint8 *contents;
+  GError *err = NULL;
+  guint i;
+
+  GST_OBJECT_LOCK (demux);
+  location = g_strdup (demux->index_location);
+  GST_OBJECT_UNLOCK (demux);
+
+  if (location == NULL || !base->packetizer->calculate_offset)
+    goto done;
+
+  upstream_size = gst_ts_demux_get_upstream_size (demux);
+  if (upstream_size <= 0)
+    goto done;
+
+  pcr_index = mpegts_packetizer_save_pcr_index (base->packetizer);
+  data = g_bytes_get_data (pcr_index, &size);
+
+  gst_byte_writer_init (&bw);
+  gst_byte_writer_put_uint32_be (&bw, INDEX_FILE_MAGIC);
+  gst_byte_writer_put_uint32_be (&bw, INDEX_FILE_VERSION);
+  gst_byte_writer_put_uint64_be (&bw, upstream_size);
+  gst_byte_writer_put_uint32_be (&bw, size);
+  gst_byte_writer_put_data (&bw, data, size);
+  gst_byte_writer_put_uint32_be (&bw, demux->keyframe_index->len);
+  for (i = 0; i < demux->keyframe_index->len; i++) {
+    TSDemuxIndexEntry *entry =
+        &g_array_index (demux->keyframe_index, TSDemuxIndexEntry, i);
+    gst_byte_writer_put_uint64_be (&bw, entry->ts);
+    gst_byte_writer_put_uint64_be (&bw, entry->offset);
+  }
+  g_bytes_unref (pcr_index);
+
+  length = gst_byte_writer_get_size (&bw);
+  contents = gst_byte_writer_reset_and_get_data (&bw);
+  if (!g_file_set_contents (location, (const gchar *) contents, length, &err)) {
+    GST_WARNING_OBJECT (demux, "Couldn't write index file: %s", err->message);
+    g_clear_error (&err);
+  } else {
+    GST_INFO_OBJECT (demux, "Saved index to %s", location);
+  }
+  g_free (contents);
+
+done:
+  g_free (location);
+}
+
 static GstFlowReturn
 gst_ts_demux_do_seek (MpegTSBase * base, GstEvent * event)
 {
@@ -849,10 +1424,24 @@ gst_ts_demux_do_seek (MpegTSBase * base, GstEvent * event)
   /* configure the segment with the seek variables */
   GST_DEBUG_OBJECT (demux, "configuring seek");
 
+  if (!demux->index_loaded)
+    gst_ts_demux_load_index (demux);
+
   if (start_type != GST_SEEK_TYPE_NONE) {
-    start_offset =
-        mpegts_packetizer_ts_to_offset (base->packetizer, MAX (0,
-            start - SEEK_TIMESTAMP_OFFSET), demux->program->pcr_pid);
+    const TSDemuxIndexEntry *entry = NULL;
+
+    if (flags & GST_SEEK_FLAG_ACCURATE)
+      entry = gst_ts_demux_index_find_keyframe (demux, start);
+
+    if (entry && start - entry->ts <= INDEX_MAX_KEYFRAME_DISTANCE) {
+      GST_DEBUG_OBJECT (demux, "Using indexed keyframe %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (entry->ts));
+      start_offset = entry->offset;
+    } else {
+      start_offset =
+          mpegts_packetizer_ts_to_offset (base->packetizer, MAX (0,
+              start - SEEK_TIMESTAMP_OFFSET), demux->program->pcr_pid);
+    }
 
     if (G_UNLIKELY (start_offset == -1)) {
       GST_WARNING ("Couldn't convert start position to an offset");
@@ -988,7 +1577,7 @@ push_event (MpegTSBase * base, GstEvent * event)
         gst_ts_demux_push_pending_data (demux, stream, NULL);
 
       gst_event_ref (event);
-      gst_pad_push_event (stream->pad, event);
+      gst_ts_demux_stream_push_event (stream, event);
     }
   }
 
@@ -1679,6 +2268,18 @@ done:
     GST_LOG ("stream:%p creating pad with name %s and caps %" GST_PTR_FORMAT,
         stream, name, caps);
     pad = gst_pad_new_from_template (template, name);
+    if (demux->threaded_output) {
+      g_mutex_init (&stream->out_lock);
+      g_cond_init (&stream->out_cond);
+      g_queue_init (&stream->out_queue);
+      stream->out_flushing = TRUE;
+      stream->out_pushing = FALSE;
+      stream->out_ret = GST_FLOW_OK;
+      stream->threaded = TRUE;
+      gst_pad_set_element_private (pad, stream);
+      gst_pad_set_activatemode_function (pad,
+          gst_ts_demux_srcpad_activate_mode);
+    }
     gst_pad_set_active (pad, TRUE);
     gst_pad_use_fixed_caps (pad);
     stream_id = gst_stream_get_stream_id (bstream->stream_object);
@@ -1741,10 +2342,9 @@ gst_ts_demux_stream_added (MpegTSBase * base, MpegTSBaseStream * bstream,
         gst_flow_combiner_add_pad (demux->flowcombiner, stream->pad);
     }
 
-    if (base->mode != BASE_MODE_PUSHING
-        && bstream->stream_type == GST_MPEGTS_STREAM_TYPE_VIDEO_H264) {
+    if (base->mode != BASE_MODE_PUSHING) {
       stream->scan_function =
-          (GstTsDemuxKeyFrameScanFunction) scan_keyframe_h264;
+          gst_ts_demux_get_scan_function (bstream->stream_type);
     } else {
       stream->scan_function = NULL;
     }
@@ -1765,6 +2365,13 @@ gst_ts_demux_stream_added (MpegTSBase * base, MpegTSBaseStream * bstream,
     stream->nb_out_buffers = 0;
     stream->gap_ref_buffers = 0;
     stream->gap_ref_pts = GST_CLOCK_TIME_NONE;
+    stream->pes_start = GST_CLOCK_TIME_NONE;
+    memset (&stream->stats, 0, sizeof (TSDemuxStreamStats));
+    stream->stats.start = gst_util_get_timestamp ();
+
+    GST_OBJECT_LOCK (demux);
+    demux->stats_streams = g_list_append (demux->stats_streams, stream);
+    GST_OBJECT_UNLOCK (demux);
     /* Only wait for a valid timestamp if we have a PCR_PID */
     stream->pending_ts = program->pcr_pid < 0x1fff;
     stream->continuity_counter = CONTINUITY_UNSET;
@@ -1786,11 +2393,25 @@ tsdemux_h264_parsing_info_clear (TSDemuxH264ParsingInfos * h264infos)
   }
 }
 
+static void
+tsdemux_h265_parsing_info_clear (TSDemuxH265ParsingInfos * h265infos)
+{
+  if (h265infos->parser) {
+    gst_h265_parser_free (h265infos->parser);
+    h265infos->parser = NULL;
+  }
+}
+
 static void
 gst_ts_demux_stream_removed (MpegTSBase * base, MpegTSBaseStream * bstream)
 {
   TSDemuxStream *stream = (TSDemuxStream *) bstream;
 
+  GST_OBJECT_LOCK (base);
+  GST_TS_DEMUX_CAST (base)->stats_streams =
+      g_list_remove (GST_TS_DEMUX_CAST (base)->stats_streams, stream);
+  GST_OBJECT_UNLOCK (base);
+
   if (stream->pad) {
     gst_flow_combiner_remove_pad (GST_TS_DEMUX_CAST (base)->flowcombiner,
         stream->pad);
@@ -1802,7 +2423,8 @@ gst_ts_demux_stream_removed (MpegTSBase * base, MpegTSBaseStream * bstream)
         gst_ts_demux_push_pending_data ((GstTSDemux *) base, stream, NULL);
 
         GST_DEBUG_OBJECT (stream->pad, "Pushing out EOS");
-        gst_pad_push_event (stream->pad, gst_event_new_eos ());
+        gst_ts_demux_stream_push_event (stream, gst_event_new_eos ());
+        gst_ts_demux_stream_drain_output (stream);
         gst_pad_set_active (stream->pad, FALSE);
       }
 
@@ -1810,11 +2432,20 @@ gst_ts_demux_stream_removed (MpegTSBase * base, MpegTSBaseStream * bstream)
       gst_element_remove_pad (GST_ELEMENT_CAST (base), stream->pad);
       stream->active = FALSE;
     } else {
+      /* Make sure the pad task is stopped */
+      if (stream->threaded)
+        gst_pad_set_active (stream->pad, FALSE);
       gst_object_unref (stream->pad);
     }
     stream->pad = NULL;
   }
 
+  if (stream->threaded) {
+    g_mutex_clear (&stream->out_lock);
+    g_cond_clear (&stream->out_cond);
+    stream->threaded = FALSE;
+  }
+
   gst_ts_demux_stream_flush (stream, GST_TS_DEMUX_CAST (base), TRUE);
 
   if (stream->taglist != NULL) {
@@ -1823,6 +2454,12 @@ gst_ts_demux_stream_removed (MpegTSBase * base, MpegTSBaseStream * bstream)
   }
 
   tsdemux_h264_parsing_info_clear (&stream->h264infos);
+  tsdemux_h265_parsing_info_clear (&stream->h265infos);
+
+  if (stream->payload) {
+    g_object_unref (stream->payload);
+    stream->payload = NULL;
+  }
 }
 
 static void
@@ -1842,6 +2479,182 @@ activate_pad_for_stream (GstTSDemux * tsdemux, TSDemuxStream * stream)
   }
 }
 
+static void
+gst_ts_demux_stream_clear_output (TSDemuxStream * stream)
+{
+  GstMiniObject *obj;
+
+  while ((obj = g_queue_pop_head (&stream->out_queue)))
+    gst_mini_object_unref (obj);
+}
+
+static void
+gst_ts_demux_stream_output_loop (GstPad * pad)
+{
+  TSDemuxStream *stream = gst_pad_get_element_private (pad);
+  GstMiniObject *obj;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&stream->out_lock);
+  while (g_queue_is_empty (&stream->out_queue) && !stream->out_flushing)
+    g_cond_wait (&stream->out_cond, &stream->out_lock);
+  if (stream->out_flushing)
+    goto flushing;
+  obj = g_queue_pop_head (&stream->out_queue);
+  stream->out_pushing = TRUE;
+  g_cond_broadcast (&stream->out_cond);
+  g_mutex_unlock (&stream->out_lock);
+
+  if (GST_IS_BUFFER (obj)) {
+    ret = gst_pad_push (pad, GST_BUFFER_CAST (obj));
+  } else if (GST_IS_BUFFER_LIST (obj)) {
+    ret = gst_pad_push_list (pad, GST_BUFFER_LIST_CAST (obj));
+  } else {
+    gst_pad_push_event (pad, GST_EVENT_CAST (obj));
+  }
+
+  g_mutex_lock (&stream->out_lock);
+  stream->out_pushing = FALSE;
+  stream->out_ret = ret;
+  if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED) {
+    GST_DEBUG_OBJECT (pad, "pausing task, reason %s", gst_flow_get_name (ret));
+    /* Don't accept any more data, the upstream thread will get the flow
+     * return the next time it pushes */
+    stream->out_flushing = TRUE;
+    gst_ts_demux_stream_clear_output (stream);
+    g_cond_broadcast (&stream->out_cond);
+    g_mutex_unlock (&stream->out_lock);
+    gst_pad_pause_task (pad);
+    return;
+  }
+  g_cond_broadcast (&stream->out_cond);
+  g_mutex_unlock (&stream->out_lock);
+  return;
+
+flushing:
+  {
+    GST_DEBUG_OBJECT (pad, "flushing, pausing task");
+    g_mutex_unlock (&stream->out_lock);
+    gst_pad_pause_task (pad);
+    return;
+  }
+}
+
+static gboolean
+gst_ts_demux_srcpad_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  TSDemuxStream *stream = gst_pad_get_element_private (pad);
+
+  if (mode != GST_PAD_MODE_PUSH)
+    return FALSE;
+
+  g_mutex_lock (&stream->out_lock);
+  stream->out_flushing = !active;
+  stream->out_ret = active ? GST_FLOW_OK : GST_FLOW_FLUSHING;
+  if (!active)
+    gst_ts_demux_stream_clear_output (stream);
+  g_cond_broadcast (&stream->out_cond);
+  g_mutex_unlock (&stream->out_lock);
+
+  if (active)
+    return gst_pad_start_task (pad,
+        (GstTaskFunction) gst_ts_demux_stream_output_loop, pad, NULL);
+
+  return gst_pad_stop_task (pad);
+}
+
+/* Pushes a buffer or buffer list on the stream pad, or queues it for the pad
+ * task in threaded mode. Takes ownership of @obj */
+static GstFlowReturn
+gst_ts_demux_stream_push (TSDemuxStream * stream, GstMiniObject * obj)
+{
+  GstFlowReturn ret;
+
+  if (!stream->threaded) {
+    if (GST_IS_BUFFER_LIST (obj))
+      return gst_pad_push_list (stream->pad, GST_BUFFER_LIST_CAST (obj));
+    return gst_pad_push (stream->pad, GST_BUFFER_CAST (obj));
+  }
+
+  g_mutex_lock (&stream->out_lock);
+  while (stream->out_queue.length >= MAX_OUTPUT_QUEUE_ITEMS
+      && !stream->out_flushing)
+    g_cond_wait (&stream->out_cond, &stream->out_lock);
+  if (stream->out_flushing) {
+    ret = stream->out_ret;
+    g_mutex_unlock (&stream->out_lock);
+    gst_mini_object_unref (obj);
+    return ret;
+  }
+  g_queue_push_tail (&stream->out_queue, obj);
+  g_cond_broadcast (&stream->out_cond);
+  ret = stream->out_ret;
+  g_mutex_unlock (&stream->out_lock);
+
+  return ret;
+}
+
+/* Pushes an event on the stream pad. In threaded mode serialized events are
+ * queued to keep them ordered with the data, and flushing events are
+ * handled like queue does. Takes ownership of @event */
+static gboolean
+gst_ts_demux_stream_push_event (TSDemuxStream * stream, GstEvent * event)
+{
+  GstPad *pad = stream->pad;
+  gboolean res;
+
+  if (!stream->threaded)
+    return gst_pad_push_event (pad, event);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      g_mutex_lock (&stream->out_lock);
+      stream->out_flushing = TRUE;
+      stream->out_ret = GST_FLOW_FLUSHING;
+      gst_ts_demux_stream_clear_output (stream);
+      g_cond_broadcast (&stream->out_cond);
+      g_mutex_unlock (&stream->out_lock);
+      /* Unblocks downstream, then wait for the task to be paused */
+      res = gst_pad_push_event (pad, event);
+      gst_pad_pause_task (pad);
+      return res;
+    case GST_EVENT_FLUSH_STOP:
+      res = gst_pad_push_event (pad, event);
+      g_mutex_lock (&stream->out_lock);
+      stream->out_flushing = FALSE;
+      stream->out_ret = GST_FLOW_OK;
+      g_mutex_unlock (&stream->out_lock);
+      if (gst_pad_is_active (pad))
+        gst_pad_start_task (pad,
+            (GstTaskFunction) gst_ts_demux_stream_output_loop, pad, NULL);
+      return res;
+    default:
+      break;
+  }
+
+  if (!GST_EVENT_IS_SERIALIZED (event))
+    return gst_pad_push_event (pad, event);
+
+  gst_ts_demux_stream_push (stream, GST_MINI_OBJECT_CAST (event));
+
+  return TRUE;
+}
+
+/* Waits until everything queued in threaded mode was pushed downstream */
+static void
+gst_ts_demux_stream_drain_output (TSDemuxStream * stream)
+{
+  if (!stream->threaded)
+    return;
+
+  g_mutex_lock (&stream->out_lock);
+  while ((!g_queue_is_empty (&stream->out_queue) || stream->out_pushing)
+      && !stream->out_flushing)
+    g_cond_wait (&stream->out_cond, &stream->out_lock);
+  g_mutex_unlock (&stream->out_lock);
+}
+
 static void
 gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
     gboolean hard)
@@ -1850,6 +2663,7 @@ gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
 
   g_free (stream->data);
   stream->data = NULL;
+  gst_ts_demux_stream_clear_payload (stream);
   stream->state = PENDING_PACKET_EMPTY;
   stream->expected_size = 0;
   stream->allocated_size = 0;
@@ -1876,6 +2690,7 @@ gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
     }
     g_list_free (stream->pending);
     stream->pending = NULL;
+    stream->stats.pending = 0;
   }
 
   if (hard) {
@@ -1935,7 +2750,7 @@ gst_ts_demux_update_program (MpegTSBase * base, MpegTSBaseProgram * program)
          * or serialized event (which means very late in case of subtitle streams),
          * and playsink waits for stream-start or another serialized event */
         GST_DEBUG_OBJECT (stream->pad, "sparse stream, pushing GAP event");
-        gst_pad_push_event (stream->pad, gst_event_new_gap (0, 0));
+        gst_ts_demux_stream_push_event (stream, gst_event_new_gap (0, 0));
       }
     }
   }
@@ -2023,7 +2838,7 @@ gst_ts_demux_program_started (MpegTSBase * base, MpegTSBaseProgram * program)
          * or serialized event (which means very late in case of subtitle streams),
          * and playsink waits for stream-start or another serialized event */
         GST_DEBUG_OBJECT (stream->pad, "sparse stream, pushing GAP event");
-        gst_pad_push_event (stream->pad, gst_event_new_gap (0, 0));
+        gst_ts_demux_stream_push_event (stream, gst_event_new_gap (0, 0));
       }
     }
 
@@ -2260,6 +3075,8 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
     goto discont;
   }
 
+  stream->pes_start = gst_util_get_timestamp ();
+
   gst_ts_demux_record_dts (demux, stream, header.DTS, bufferoffset);
   gst_ts_demux_record_pts (demux, stream, header.PTS, bufferoffset);
   if (G_UNLIKELY (stream->pending_ts &&
@@ -2301,8 +3118,13 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
     stream->allocated_size = MAX (8192, length);
 
   g_assert (stream->data == NULL);
-  stream->data = g_malloc (stream->allocated_size);
-  memcpy (stream->data, data, length);
+  if (demux->zero_copy) {
+    gst_ts_demux_stream_append_payload (demux, stream, data, length);
+  } else {
+    stream->data = g_malloc (stream->allocated_size);
+    memcpy (stream->data, data, length);
+    demux->bytes_copied += length;
+  }
   stream->current_size = length;
 
   stream->state = PENDING_PACKET_BUFFER;
@@ -2314,6 +3136,68 @@ discont:
   return;
 }
 
+static void
+gst_ts_demux_stream_clear_payload (TSDemuxStream * stream)
+{
+  if (stream->payload)
+    gst_adapter_clear (stream->payload);
+  stream->payload_chunks = 0;
+}
+
+/* Zero-copy mode: store a reference to the input memory */
+static void
+gst_ts_demux_stream_append_payload (GstTSDemux * demux, TSDemuxStream * stream,
+    const guint8 * data, guint size)
+{
+  GstBuffer *buf;
+
+  if (size == 0)
+    return;
+
+  buf = mpegts_packetizer_get_payload_buffer (MPEG_TS_BASE_PACKETIZER (demux),
+      data, size);
+  if (G_UNLIKELY (buf == NULL))
+    return;
+
+  if (G_UNLIKELY (stream->payload == NULL))
+    stream->payload = gst_adapter_new ();
+  gst_adapter_push (stream->payload, buf);
+  stream->payload_chunks++;
+}
+
+/* Zero-copy mode: copy the pending payload into ->data, for the code paths
+ * which need to inspect it */
+static void
+gst_ts_demux_stream_flatten_payload (GstTSDemux * demux, TSDemuxStream * stream)
+{
+  gsize size = gst_adapter_available (stream->payload);
+
+  stream->data = gst_adapter_take (stream->payload, size);
+  stream->current_size = stream->allocated_size = size;
+  stream->payload_chunks = 0;
+  demux->bytes_copied += size;
+}
+
+/* Zero-copy mode: create the output buffer from the pending payload. Up to
+ * GST_BUFFER_MEM_MAX chunks can be referenced as-is, beyond that GstBuffer
+ * would merge the memories anyway so do it once, in one allocation. */
+static GstBuffer *
+gst_ts_demux_stream_take_payload (GstTSDemux * demux, TSDemuxStream * stream)
+{
+  gsize size = gst_adapter_available (stream->payload);
+  GstBuffer *buffer;
+
+  if (stream->payload_chunks <= GST_BUFFER_MEM_MAX) {
+    buffer = gst_adapter_take_buffer_fast (stream->payload, size);
+  } else {
+    buffer = gst_adapter_take_buffer (stream->payload, size);
+    demux->bytes_copied += size;
+  }
+  stream->payload_chunks = 0;
+
+  return buffer;
+}
+
  /* ONLY CALL THIS:
   * * WITH packet->payload != NULL
   * * WITH pending/current flushed out if beginning of new PES packet
@@ -2339,6 +3223,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
   } else {
     GST_WARNING ("CONTINUITY: Mismatch packet %d, stream %d",
         cc, stream->continuity_counter);
+    stream->stats.cc_errors++;
     if (stream->state != PENDING_PACKET_EMPTY)
       stream->state = PENDING_PACKET_DISCONT;
   }
@@ -2366,15 +3251,23 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
     case PENDING_PACKET_BUFFER:
     {
       GST_LOG ("BUFFER: appending data");
+      if (demux->zero_copy) {
+        gst_ts_demux_stream_append_payload (demux, stream, data, size);
+        stream->current_size += size;
+        break;
+      }
       if (G_UNLIKELY (stream->current_size + size > stream->allocated_size)) {
         GST_LOG ("resizing buffer");
         do {
           stream->allocated_size *= 2;
         } while (stream->current_size + size > stream->allocated_size);
         stream->data = g_realloc (stream->data, stream->allocated_size);
+        /* Worst case, realloc had to move the data */
+        demux->bytes_copied += stream->current_size;
       }
       memcpy (stream->data + stream->current_size, data, size);
       stream->current_size += size;
+      demux->bytes_copied += size;
       break;
     }
     case PENDING_PACKET_DISCONT:
@@ -2384,6 +3277,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
         g_free (stream->data);
         stream->data = NULL;
       }
+      gst_ts_demux_stream_clear_payload (stream);
       stream->continuity_counter = CONTINUITY_UNSET;
       break;
     }
@@ -2470,11 +3364,11 @@ push_new_segment:
     if (demux->segment_event) {
       GST_DEBUG_OBJECT (stream->pad, "Pushing newsegment event");
       gst_event_ref (demux->segment_event);
-      gst_pad_push_event (stream->pad, demux->segment_event);
+      gst_ts_demux_stream_push_event (stream, demux->segment_event);
     }
 
     if (demux->global_tags) {
-      gst_pad_push_event (stream->pad,
+      gst_ts_demux_stream_push_event (stream,
           gst_event_new_tag (gst_tag_list_ref (demux->global_tags)));
     }
 
@@ -2482,7 +3376,8 @@ push_new_segment:
     if (stream->taglist) {
       GST_DEBUG_OBJECT (stream->pad, "Sending tags %" GST_PTR_FORMAT,
           stream->taglist);
-      gst_pad_push_event (stream->pad, gst_event_new_tag (stream->taglist));
+      gst_ts_demux_stream_push_event (stream,
+          gst_event_new_tag (stream->taglist));
       stream->taglist = NULL;
     }
 
@@ -2540,7 +3435,7 @@ gst_ts_demux_check_and_sync_streams (GstTSDemux * demux, GstClockTime time)
         calculate_and_push_newsegment (demux, ps, NULL);
 
       /* Now send gap event */
-      gst_pad_push_event (ps->pad, gst_event_new_gap (time, 0));
+      gst_ts_demux_stream_push_event (ps, gst_event_new_gap (time, 0));
     }
 
     /* Update GAP tracking vars so we don't re-check this stream for a while */
@@ -2798,14 +3693,15 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
   GstFlowReturn res = GST_FLOW_OK;
   MpegTSBaseStream *bs = (MpegTSBaseStream *) stream;
   GstBuffer *buffer = NULL;
+  GstBuffer *payload_buffer = NULL;
   GstBufferList *buffer_list = NULL;
-
+  GstClockTime push_start, push_time;
 
   GST_DEBUG_OBJECT (stream->pad,
       "stream:%p, pid:0x%04x stream_type:%d state:%d", stream, bs->pid,
       bs->stream_type, stream->state);
 
-  if (G_UNLIKELY (stream->data == NULL)) {
+  if (G_UNLIKELY (stream->data == NULL && stream->payload_chunks == 0)) {
     GST_LOG ("stream->data == NULL");
     goto beach;
   }
@@ -2826,6 +3722,17 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
     goto beach;
   }
 
+  if (stream->payload_chunks) {
+    /* Keyframe scanning and the access unit parsers need contiguous data */
+    if (stream->needs_keyframe
+        || bs->stream_type == GST_MPEGTS_STREAM_TYPE_VIDEO_JP2K
+        || (bs->stream_type == GST_MPEGTS_STREAM_TYPE_PRIVATE_PES_PACKETS
+            && bs->registration_id == DRF_ID_OPUS))
+      gst_ts_demux_stream_flatten_payload (demux, stream);
+    else
+      payload_buffer = gst_ts_demux_stream_take_payload (demux, stream);
+  }
+
   if (stream->needs_keyframe) {
     MpegTSBase *base = (MpegTSBase *) demux;
 
@@ -2835,6 +3742,10 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
           "Got Keyframe, ready to go at %" GST_TIME_FORMAT,
           GST_TIME_ARGS (stream->pts));
 
+      if (stream->scan_function)
+        gst_ts_demux_index_add_keyframe (demux, stream->pts,
+            demux->last_seek_offset);
+
       if (bs->stream_type == GST_MPEGTS_STREAM_TYPE_PRIVATE_PES_PACKETS &&
           bs->registration_id == DRF_ID_OPUS) {
         buffer_list = parse_opus_access_unit (stream);
@@ -2894,6 +3805,8 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         res = GST_FLOW_ERROR;
         goto beach;
       }
+    } else if (payload_buffer) {
+      buffer = payload_buffer;
     } else {
       buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
     }
@@ -2906,6 +3819,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         pend->pts = stream->raw_pts;
         pend->dts = stream->raw_dts;
         stream->pending = g_list_append (stream->pending, pend);
+        stream->stats.pending++;
       } else {
         guint i, n;
 
@@ -2918,6 +3832,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
           pend->dts = i == 0 ? stream->raw_dts : -1;
           stream->pending = g_list_append (stream->pending, pend);
         }
+        stream->stats.pending += n;
         gst_buffer_list_unref (buffer_list);
       }
       GST_DEBUG ("Not enough information to push buffers yet, storing buffer");
@@ -2943,12 +3858,14 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         GST_BUFFER_FLAG_SET (pend->buffer, GST_BUFFER_FLAG_DISCONT);
       stream->discont = FALSE;
 
-      res = gst_pad_push (stream->pad, pend->buffer);
+      res = gst_ts_demux_stream_push (stream,
+          GST_MINI_OBJECT_CAST (pend->buffer));
       stream->nb_out_buffers += 1;
       g_slice_free (PendingBuffer, pend);
     }
     g_list_free (stream->pending);
     stream->pending = NULL;
+    stream->stats.pending = 0;
   }
 
   if ((GST_CLOCK_TIME_IS_VALID (stream->seeked_pts)
@@ -2997,16 +3914,30 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
   else if (GST_CLOCK_TIME_IS_VALID (stream->pts))
     demux->segment.position = stream->pts;
 
+  push_start = gst_util_get_timestamp ();
+  if (GST_CLOCK_TIME_IS_VALID (stream->pes_start)) {
+    stream->stats.assembly_time += push_start - stream->pes_start;
+    stream->stats.pes++;
+    stream->pes_start = GST_CLOCK_TIME_NONE;
+  }
+
   if (buffer) {
-    res = gst_pad_push (stream->pad, buffer);
+    res = gst_ts_demux_stream_push (stream, GST_MINI_OBJECT_CAST (buffer));
     /* Record that a buffer was pushed */
     stream->nb_out_buffers += 1;
   } else {
     guint n = gst_buffer_list_length (buffer_list);
-    res = gst_pad_push_list (stream->pad, buffer_list);
+    res = gst_ts_demux_stream_push (stream,
+        GST_MINI_OBJECT_CAST (buffer_list));
     /* Record that a buffer was pushed */
     stream->nb_out_buffers += n;
   }
+
+  push_time = gst_util_get_timestamp () - push_start;
+  stream->stats.pushes++;
+  stream->stats.push_time += push_time;
+  if (push_time > stream->stats.max_push_time)
+    stream->stats.max_push_time = push_time;
   GST_DEBUG_OBJECT (stream->pad, "Returned %s", gst_flow_get_name (res));
   res = gst_flow_combiner_update_flow (demux->flowcombiner, res);
   GST_DEBUG_OBJECT (stream->pad, "combined %s", gst_flow_get_name (res));
@@ -3041,6 +3972,7 @@ beach:
   GST_LOG ("Resetting to EMPTY, returning %s", gst_flow_get_name (res));
   stream->state = PENDING_PACKET_EMPTY;
   stream->data = NULL;
+  gst_ts_demux_stream_clear_payload (stream);
   stream->expected_size = 0;
   stream->current_size = 0;
 
@@ -3053,6 +3985,9 @@ gst_ts_demux_handle_packet (GstTSDemux * demux, TSDemuxStream * stream,
 {
   GstFlowReturn res = GST_FLOW_OK;
 
+  stream->stats.packets++;
+  stream->stats.bytes += packet->data_end - packet->data_start;
+
   GST_LOG ("pid 0x%04x pusi:%d, afc:%d, cont:%d, payload:%p", packet->pid,
       packet->payload_unit_start_indicator, packet->scram_afc_cc & 0x30,
       FLAGS_CONTINUITY_COUNTER (packet->scram_afc_cc), packet->payload);
@@ -3135,6 +4070,23 @@ gst_ts_demux_push (MpegTSBase * base, MpegTSPacketizerPacket * packet,
   TSDemuxStream *stream = NULL;
   GstFlowReturn res = GST_FLOW_OK;
 
+  if (G_UNLIKELY (demux->emit_statistics) && packet->pcr != G_MAXUINT64
+      && demux->program && packet->pid == demux->program->pcr_pid) {
+    GstStructure *st;
+    gdouble drift;
+
+    st = gst_structure_new_id_empty (QUARK_TSDEMUX);
+    gst_structure_id_set (st,
+        QUARK_PID, G_TYPE_UINT, packet->pid,
+        QUARK_OFFSET, G_TYPE_UINT64, packet->offset,
+        QUARK_PCR, G_TYPE_UINT64, packet->pcr, NULL);
+    if (mpegts_packetizer_get_clock_drift (base->packetizer, packet->pid,
+            &drift))
+      gst_structure_set (st, "drift", G_TYPE_DOUBLE, drift, NULL);
+    gst_element_post_message (GST_ELEMENT_CAST (demux),
+        gst_message_new_element (GST_OBJECT (demux), st));
+  }
+
   if (G_LIKELY (demux->program)) {
     stream = (TSDemuxStream *) demux->program->streams[packet->pid];
 
@@ -76,6 +76,11 @@ struct _GstTSDemux
   gint requested_program_number; /* Required program number (ignore:-1) */
   guint program_number;
   gboolean emit_statistics;
+  gboolean zero_copy;
+  gboolean threaded_output;
+
+  /* Amount of payload bytes copied while assembling PES packets */
+  guint64 bytes_copied;
 
   /*< private >*/
   gint program_generation; /* Incremented each time we switch program 0..15 */
@@ -101,6 +106,15 @@ struct _GstTSDemux
 
   /* Used when seeking for a keyframe to go backward in the stream */
   guint64 last_seek_offset;
+
+  /* Seek index (see index-location property) */
+  gchar *index_location;
+  gboolean index_loaded;
+  /* Array of TSDemuxIndexEntry, sorted by time */
+  GArray *keyframe_index;
+
+  /* Streams reported by the stats property. Protected by the object lock */
+  GList *stats_streams;
 };
 
 struct _GstTSDemuxClass
@@ -113,11 +113,22 @@ enum
   PROP_PAT_INTERVAL,
   PROP_PMT_INTERVAL,
   PROP_ALIGNMENT,
-  PROP_SI_INTERVAL
+  PROP_SI_INTERVAL,
+  PROP_BITRATE,
+  PROP_ZERO_COPY,
+  PROP_PROG_BITRATES,
+  PROP_PROG_STATS,
+  PROP_LOW_LATENCY
 };
 
 #define MPEGTSMUX_DEFAULT_ALIGNMENT    -1
 #define MPEGTSMUX_DEFAULT_M2TS         FALSE
+#define MPEGTSMUX_DEFAULT_BITRATE      0
+#define MPEGTSMUX_DEFAULT_ZERO_COPY    FALSE
+#define MPEGTSMUX_DEFAULT_LOW_LATENCY  FALSE
+
+/* maximum TS recording rate of BDAV streams, in bits per second */
+#define MPEGTSMUX_M2TS_MAX_RATE        48000000
 
 static GstStaticPadTemplate mpegtsmux_sink_factory =
     GST_STATIC_PAD_TEMPLATE ("sink_%d",
@@ -178,6 +189,7 @@ static void release_buffer_cb (guint8 * data, void *user_data);
 static GstFlowReturn mpegtsmux_collect_packet (MpegTsMux * mux,
     GstBuffer * buf);
 static GstFlowReturn mpegtsmux_push_packets (MpegTsMux * mux, gboolean force);
+static void mpegtsmux_clear_pool (GstBufferPool ** pool);
 static gboolean new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf,
     gint64 new_pcr);
 
@@ -303,6 +315,41 @@ mpegtsmux_class_init (MpegTsMuxClass * klass)
           "Set the interval (in ticks of the 90kHz clock) for writing out the Service"
           "Information tables", 1, G_MAXUINT, TSMUX_DEFAULT_SI_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_BITRATE,
+      g_param_spec_uint64 ("bitrate", "Bitrate (in bits per second)",
+          "Set the target bitrate, the output is padded with null packets and "
+          "PCRs are paced to produce a constant bitrate stream "
+          "(0 = variable bitrate)", 0, G_MAXUINT64, MPEGTSMUX_DEFAULT_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero copy",
+          "Output packets as a header memory followed by memory referencing "
+          "the input data instead of copying the payload. Most useful with "
+          "sinks that write out buffers memory by memory",
+          MPEGTSMUX_DEFAULT_ZERO_COPY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_PROG_BITRATES,
+      g_param_spec_boxed ("prog-bitrates", "Program bitrates",
+          "A GstStructure specifying the maximum bitrate (guint64, in bits per "
+          "second) of programs, with fields named program-<prog_id>",
+          GST_TYPE_STRUCTURE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_PROG_STATS,
+      g_param_spec_boxed ("prog-stats", "Program statistics",
+          "A GstStructure with the bitrate budget and buffer occupancy of "
+          "each program", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Don't wait for data on subtitle, teletext and KLV inputs before "
+          "muxing, their buffers are inserted whenever they arrive so a "
+          "stalled sparse input can't delay audio and video",
+          MPEGTSMUX_DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -326,7 +373,6 @@ mpegtsmux_init (MpegTsMux * mux)
   gst_collect_pads_set_clip_function (mux->collect, (GstCollectPadsClipFunction)
       GST_DEBUG_FUNCPTR (mpegtsmux_clip_inc_running_time), mux);
 
-  mux->adapter = gst_adapter_new ();
   mux->out_adapter = gst_adapter_new ();
 
   /* properties */
@@ -335,7 +381,11 @@ mpegtsmux_init (MpegTsMux * mux)
   mux->pmt_interval = TSMUX_DEFAULT_PMT_INTERVAL;
   mux->si_interval = TSMUX_DEFAULT_SI_INTERVAL;
   mux->prog_map = NULL;
+  mux->prog_bitrates = NULL;
   mux->alignment = MPEGTSMUX_DEFAULT_ALIGNMENT;
+  mux->bitrate = MPEGTSMUX_DEFAULT_BITRATE;
+  mux->zero_copy = MPEGTSMUX_DEFAULT_ZERO_COPY;
+  mux->low_latency = MPEGTSMUX_DEFAULT_LOW_LATENCY;
 
   /* initial state */
   mpegtsmux_reset (mux, TRUE);
@@ -379,8 +429,8 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
 
   mux->first = TRUE;
   mux->last_flow_ret = GST_FLOW_OK;
-  mux->previous_pcr = -1;
-  mux->pcr_rate_num = mux->pcr_rate_den = 1;
+  mux->segment_start_pending = FALSE;
+  mux->last_ats = -1;
   mux->last_ts = 0;
   mux->is_delta = TRUE;
 
@@ -394,8 +444,6 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
     mux->element_index = NULL;
   }
 #endif
-  if (mux->adapter)
-    gst_adapter_clear (mux->adapter);
   if (mux->out_adapter)
     gst_adapter_clear (mux->out_adapter);
 
@@ -404,6 +452,9 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
     mux->tsmux = NULL;
   }
 
+  mpegtsmux_clear_pool (&mux->packet_pool);
+  mpegtsmux_clear_pool (&mux->out_pool);
+
   if (mux->programs) {
     g_hash_table_destroy (mux->programs);
   }
@@ -426,6 +477,9 @@ mpegtsmux_reset (MpegTsMux * mux, gboolean alloc)
     mux->tsmux = tsmux_new ();
     tsmux_set_write_func (mux->tsmux, new_packet_cb, mux);
     tsmux_set_alloc_func (mux->tsmux, alloc_packet_cb, mux);
+    tsmux_set_bitrate (mux->tsmux, mux->bitrate);
+    /* m2ts mode prefixes each packet in place */
+    tsmux_set_zero_copy (mux->tsmux, mux->zero_copy && !mux->m2ts_mode);
   }
 }
 
@@ -436,10 +490,6 @@ mpegtsmux_dispose (GObject * object)
 
   mpegtsmux_reset (mux, FALSE);
 
-  if (mux->adapter) {
-    g_object_unref (mux->adapter);
-    mux->adapter = NULL;
-  }
   if (mux->out_adapter) {
     g_object_unref (mux->out_adapter);
     mux->out_adapter = NULL;
@@ -452,6 +502,10 @@ mpegtsmux_dispose (GObject * object)
     gst_structure_free (mux->prog_map);
     mux->prog_map = NULL;
   }
+  if (mux->prog_bitrates) {
+    gst_structure_free (mux->prog_bitrates);
+    mux->prog_bitrates = NULL;
+  }
   if (mux->programs) {
     g_hash_table_destroy (mux->programs);
     mux->programs = NULL;
@@ -459,6 +513,42 @@ mpegtsmux_dispose (GObject * object)
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
 
+static GstStructure *
+mpegtsmux_get_prog_stats (MpegTsMux * mux)
+{
+  GValue programs = G_VALUE_INIT;
+  GstStructure *stats;
+
+  g_value_init (&programs, GST_TYPE_ARRAY);
+
+  /* programs are only modified from the streaming thread */
+  GST_COLLECT_PADS_STREAM_LOCK (mux->collect);
+  if (mux->tsmux) {
+    GList *cur;
+
+    for (cur = mux->tsmux->programs; cur; cur = cur->next) {
+      TsMuxProgram *program = (TsMuxProgram *) cur->data;
+      GValue v = G_VALUE_INIT;
+
+      g_value_init (&v, GST_TYPE_STRUCTURE);
+      g_value_take_boxed (&v, gst_structure_new ("mpegtsmux-prog-stats",
+              "program-number", G_TYPE_UINT, (guint) program->pgm_number,
+              "max-bitrate", G_TYPE_UINT64, program->max_bitrate,
+              "buffer-size", G_TYPE_UINT, program->buffer_size,
+              "buffer-fullness", G_TYPE_UINT, program->buffer_fullness,
+              "bytes-written", G_TYPE_UINT64, program->bytes_written,
+              "deferred", G_TYPE_UINT64, program->deferred, NULL));
+      gst_value_array_append_and_take_value (&programs, &v);
+    }
+  }
+  GST_COLLECT_PADS_STREAM_UNLOCK (mux->collect);
+
+  stats = gst_structure_new_empty ("mpegtsmux-stats");
+  gst_structure_take_value (stats, "programs", &programs);
+
+  return stats;
+}
+
 static void
 gst_mpegtsmux_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -470,6 +560,8 @@ gst_mpegtsmux_set_property (GObject * object, guint prop_id,
     case PROP_M2TS_MODE:
       /*set incase if the output stream need to be of 192 bytes */
       mux->m2ts_mode = g_value_get_boolean (value);
+      if (mux->tsmux)
+        tsmux_set_zero_copy (mux->tsmux, mux->zero_copy && !mux->m2ts_mode);
       break;
     case PROP_PROG_MAP:
     {
@@ -496,6 +588,14 @@ gst_mpegtsmux_set_property (GObject * object, guint prop_id,
         MpegTsPadData *ts_data = (MpegTsPadData *) walk->data;
 
         tsmux_set_pmt_interval (ts_data->prog, mux->pmt_interval);
+      if (mux->prog_bitrates) {
+        gchar *field = g_strdup_printf ("program-%d", ts_data->prog_id);
+        guint64 bitrate;
+
+        if (gst_structure_get_uint64 (mux->prog_bitrates, field, &bitrate))
+          tsmux_program_set_max_bitrate (ts_data->prog, bitrate);
+        g_free (field);
+      }
         walk = g_slist_next (walk);
       }
       break;
@@ -506,6 +606,27 @@ gst_mpegtsmux_set_property (GObject * object, guint prop_id,
       mux->si_interval = g_value_get_uint (value);
       tsmux_set_si_interval (mux->tsmux, mux->si_interval);
       break;
+    case PROP_BITRATE:
+      mux->bitrate = g_value_get_uint64 (value);
+      if (mux->tsmux)
+        tsmux_set_bitrate (mux->tsmux, mux->bitrate);
+      break;
+    case PROP_LOW_LATENCY:
+      mux->low_latency = g_value_get_boolean (value);
+      break;
+    case PROP_PROG_BITRATES:
+    {
+      const GstStructure *s = gst_value_get_structure (value);
+      if (mux->prog_bitrates)
+        gst_structure_free (mux->prog_bitrates);
+      mux->prog_bitrates = s ? gst_structure_copy (s) : NULL;
+      break;
+    }
+    case PROP_ZERO_COPY:
+      mux->zero_copy = g_value_get_boolean (value);
+      if (mux->tsmux)
+        tsmux_set_zero_copy (mux->tsmux, mux->zero_copy && !mux->m2ts_mode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -537,6 +658,21 @@ gst_mpegtsmux_get_property (GObject * object, guint prop_id,
     case PROP_SI_INTERVAL:
       g_value_set_uint (value, mux->si_interval);
       break;
+    case PROP_BITRATE:
+      g_value_set_uint64 (value, mux->bitrate);
+      break;
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, mux->zero_copy);
+      break;
+    case PROP_PROG_BITRATES:
+      gst_value_set_structure (value, mux->prog_bitrates);
+      break;
+    case PROP_PROG_STATS:
+      g_value_take_boxed (value, mpegtsmux_get_prog_stats (mux));
+      break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, mux->low_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -989,6 +1125,33 @@ no_stream:
 
 #define COLLECT_DATA_PAD(collect_data) (((GstCollectData *)(collect_data))->pad)
 
+/* Don't wait for data on sparse inputs, they are muxed in whenever they
+ * have a buffer queued */
+static void
+mpegtsmux_set_pad_sparse (GstCollectPads * pads, GstCollectData * data)
+{
+  GST_DEBUG_OBJECT (data->pad, "not waiting for data on sparse input");
+
+  GST_COLLECT_PADS_STATE_UNSET (data, GST_COLLECT_PADS_STATE_LOCKED);
+  gst_collect_pads_set_waiting (pads, data, FALSE);
+  GST_COLLECT_PADS_STATE_SET (data, GST_COLLECT_PADS_STATE_LOCKED);
+}
+
+static gboolean
+mpegtsmux_caps_are_sparse (GstCaps * caps)
+{
+  GstStructure *s;
+
+  if (gst_caps_get_size (caps) == 0)
+    return FALSE;
+
+  s = gst_caps_get_structure (caps, 0);
+
+  return gst_structure_has_name (s, "subpicture/x-dvb") ||
+      gst_structure_has_name (s, "application/x-teletext") ||
+      gst_structure_has_name (s, "meta/x-klv");
+}
+
 static gboolean
 mpegtsmux_sink_event (GstCollectPads * pads, GstCollectData * data,
     GstEvent * event, gpointer user_data)
@@ -1070,11 +1233,18 @@ mpegtsmux_sink_event (GstCollectPads * pads, GstCollectData * data,
       gst_event_parse_stream_flags (event, &flags);
 
       /* Don't wait for data on sparse inputs like metadata streams */
-      if ((flags & GST_STREAM_FLAG_SPARSE)) {
-        GST_COLLECT_PADS_STATE_UNSET (data, GST_COLLECT_PADS_STATE_LOCKED);
-        gst_collect_pads_set_waiting (pads, data, FALSE);
-        GST_COLLECT_PADS_STATE_SET (data, GST_COLLECT_PADS_STATE_LOCKED);
-      }
+      if ((flags & GST_STREAM_FLAG_SPARSE))
+        mpegtsmux_set_pad_sparse (pads, data);
+      break;
+    }
+    case GST_EVENT_CAPS:{
+      GstCaps *caps;
+
+      /* In low latency mode, also treat inputs that are sparse by nature
+       * as such even if upstream did not flag them */
+      gst_event_parse_caps (event, &caps);
+      if (mux->low_latency && mpegtsmux_caps_are_sparse (caps))
+        mpegtsmux_set_pad_sparse (pads, data);
       break;
     }
     default:
@@ -1321,8 +1491,9 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
   if (G_UNLIKELY (best == NULL)) {
     /* EOS */
     GST_INFO_OBJECT (mux, "EOS");
-    /* drain some possibly cached data */
-    new_packet_m2ts (mux, NULL, -1);
+    /* write out data held back by the program bitrates */
+    if (!tsmux_write_scheduled (mux->tsmux, GST_CLOCK_STIME_NONE, TRUE))
+      GST_WARNING_OBJECT (mux, "Failed to write pending data packets");
     mpegtsmux_push_packets (mux, TRUE);
     gst_pad_push_event (mux->srcpad, gst_event_new_eos ());
 
@@ -1369,6 +1540,11 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
           GST_TIME_ARGS (running_time), count);
       gst_pad_push_event (mux->srcpad, event);
 
+      /* the next PAT starts a new segment */
+      mux->segment_start_pending = TRUE;
+      mux->segment_start_running_time = running_time;
+      mux->segment_start_count = count;
+
       /* output PAT */
       mux->tsmux->last_pat_ts = -1;
 
@@ -1438,8 +1614,9 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
   GST_DEBUG_OBJECT (mux, "delta: %d", delta);
 
   stream_data = stream_data_new (buf);
-  tsmux_stream_add_data (best->stream, stream_data->map_info.data,
-      stream_data->map_info.size, stream_data, pts, dts, !delta);
+  tsmux_stream_add_buffer (best->stream, stream_data->buffer,
+      stream_data->map_info.data, stream_data->map_info.size, stream_data,
+      pts, dts, !delta);
 
   /* outgoing ts follows ts of PCR program stream */
   if (prog->pcr_stream == best->stream) {
@@ -1451,15 +1628,16 @@ mpegtsmux_collected_buffer (GstCollectPads * pads, GstCollectData * data,
 
   mux->is_delta = delta;
   mux->is_header = header;
-  while (tsmux_stream_bytes_in_buffer (best->stream) > 0) {
-    if (!tsmux_write_stream_packet (mux->tsmux, best->stream)) {
-      /* Failed writing data for some reason. Set appropriate error */
-      GST_DEBUG_OBJECT (mux, "Failed to write data packet");
-      GST_ELEMENT_ERROR (mux, STREAM, MUX,
-          ("Failed writing output data to stream %04x", best->stream->id),
-          (NULL));
-      goto write_fail;
-    }
+  /* write out the pending data of all programs by deadline, holding back
+   * programs that exceed their bitrate at the time of this buffer */
+  if (!tsmux_write_scheduled (mux->tsmux,
+          GST_CLOCK_STIME_IS_VALID (dts) ? dts : pts, FALSE)) {
+    /* Failed writing data for some reason. Set appropriate error */
+    GST_DEBUG_OBJECT (mux, "Failed to write data packet");
+    GST_ELEMENT_ERROR (mux, STREAM, MUX,
+        ("Failed writing output data to stream %04x", best->stream->id),
+        (NULL));
+    goto write_fail;
   }
   /* flush packet cache */
   return mpegtsmux_push_packets (mux, FALSE);
@@ -1599,6 +1777,66 @@ new_packet_common_init (MpegTsMux * mux, GstBuffer * buf, guint8 * data,
   }
 }
 
+static GstBufferPool *
+mpegtsmux_create_pool (MpegTsMux * mux, guint size)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+
+  if (!gst_buffer_pool_set_config (pool, config) ||
+      !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (mux, "failed to set up buffer pool of size %u", size);
+    gst_object_unref (pool);
+    return NULL;
+  }
+
+  GST_DEBUG_OBJECT (mux, "created buffer pool of size %u", size);
+
+  return pool;
+}
+
+static void
+mpegtsmux_clear_pool (GstBufferPool ** pool)
+{
+  if (*pool) {
+    gst_buffer_pool_set_active (*pool, FALSE);
+    gst_object_unref (*pool);
+    *pool = NULL;
+  }
+}
+
+/* Allocate a buffer of @size bytes from @pool, (re)creating the pool if
+ * needed so that steady state output does not allocate any memory */
+static GstBuffer *
+mpegtsmux_acquire_buffer (MpegTsMux * mux, GstBufferPool ** pool, guint size)
+{
+  GstBuffer *buf = NULL;
+
+  if (*pool) {
+    GstStructure *config = gst_buffer_pool_get_config (*pool);
+    guint pool_size;
+
+    gst_buffer_pool_config_get_params (config, NULL, &pool_size, NULL, NULL);
+    gst_structure_free (config);
+
+    if (pool_size != size)
+      mpegtsmux_clear_pool (pool);
+  }
+
+  if (*pool == NULL)
+    *pool = mpegtsmux_create_pool (mux, size);
+
+  if (*pool == NULL ||
+      gst_buffer_pool_acquire_buffer (*pool, &buf, NULL) != GST_FLOW_OK)
+    buf = gst_buffer_new_and_alloc (size);
+
+  return buf;
+}
+
 static GstFlowReturn
 mpegtsmux_push_packets (MpegTsMux * mux, gboolean force)
 {
@@ -1637,13 +1875,39 @@ mpegtsmux_push_packets (MpegTsMux * mux, gboolean force)
 
   GST_LOG_OBJECT (mux, "aligning to %d bytes", align);
   while (align <= av) {
-    GstBuffer *buf;
+    GstBuffer *buf, *segment_start_buf = NULL;
+    GstMpegtsSegmentStartMeta *segment_start;
     GstClockTime pts;
+    GstMapInfo map;
 
+    /* Gather the packets into one pooled buffer rather than letting the
+     * adapter allocate a new one for each chunk */
     pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_adapter_take_buffer (mux->out_adapter, align);
+    /* keep the segment start marker of the first packet */
+    segment_start_buf = gst_adapter_get_buffer (mux->out_adapter,
+        packet_size);
+    segment_start = gst_buffer_get_mpegts_segment_start_meta
+        (segment_start_buf);
+    if (mux->zero_copy) {
+      /* keep referencing the packet memories */
+      buf = gst_adapter_take_buffer_fast (mux->out_adapter, align);
+    } else {
+      buf = mpegtsmux_acquire_buffer (mux, &mux->out_pool, align);
+
+      gst_buffer_map (buf, &map, GST_MAP_WRITE);
+      gst_adapter_copy (mux->out_adapter, map.data, 0, align);
+      gst_buffer_unmap (buf, &map);
+      gst_adapter_flush (mux->out_adapter, align);
+    }
 
     GST_BUFFER_PTS (buf) = pts;
+    if (segment_start) {
+      GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+      if (!gst_buffer_get_mpegts_segment_start_meta (buf))
+        gst_buffer_add_mpegts_segment_start_meta (buf,
+            segment_start->running_time, segment_start->count);
+    }
+    gst_buffer_unref (segment_start_buf);
 
     gst_buffer_list_add (buffer_list, buf);
     av -= align;
@@ -1660,11 +1924,11 @@ mpegtsmux_push_packets (MpegTsMux * mux, gboolean force)
     GST_LOG_OBJECT (mux, "handling %d leftover bytes", av);
 
     pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_buffer_new_and_alloc (align);
+    buf = mpegtsmux_acquire_buffer (mux, &mux->out_pool, align);
 
     GST_BUFFER_PTS (buf) = pts;
 
-    gst_buffer_map (buf, &map, GST_MAP_READ);
+    gst_buffer_map (buf, &map, GST_MAP_WRITE);
     data = map.data;
 
     gst_adapter_copy (mux->out_adapter, data, 0, av);
@@ -1714,115 +1978,75 @@ mpegtsmux_collect_packet (MpegTsMux * mux, GstBuffer * buf)
   return GST_FLOW_OK;
 }
 
+/* The 4 byte arrival timestamp of each packet follows a virtual clock
+ * running on the 27 MHz PCR timeline. A packet carrying a PCR arrives at
+ * that PCR, any other packet arrives one packet time after the previous
+ * one, as if sent at the output bitrate (or the maximum M2TS recording
+ * rate for variable bitrate streams). This keeps the timestamps
+ * increasing and lets every packet go out as soon as it is produced. */
 static gboolean
 new_packet_m2ts (MpegTsMux * mux, GstBuffer * buf, gint64 new_pcr)
 {
-  GstBuffer *out_buf;
-  int chunk_bytes;
   GstMapInfo map;
+  guint64 packet_time;
+  gint64 ats;
 
   GST_LOG_OBJECT (mux, "Have buffer %p with new_pcr=%" G_GINT64_FORMAT,
       buf, new_pcr);
 
-  chunk_bytes = gst_adapter_available (mux->adapter);
-
-  if (G_LIKELY (buf)) {
-    if (new_pcr < 0) {
-      /* If there is no pcr in current ts packet then just add the packet
-         to the adapter for later output when we see a PCR */
-      GST_LOG_OBJECT (mux, "Accumulating non-PCR packet");
-      gst_adapter_push (mux->adapter, buf);
-      goto exit;
-    }
+  packet_time = gst_util_uint64_scale (NORMAL_TS_PACKET_LENGTH * 8,
+      TSMUX_SYS_CLOCK_FREQ,
+      mux->bitrate ? mux->bitrate : MPEGTSMUX_M2TS_MAX_RATE);
 
-    /* no first interpolation point yet, then this is the one,
-     * otherwise it is the second interpolation point */
-    if (mux->previous_pcr < 0 && chunk_bytes) {
-      mux->previous_pcr = new_pcr;
-      mux->previous_offset = chunk_bytes;
-      GST_LOG_OBJECT (mux, "Accumulating non-PCR packet");
-      gst_adapter_push (mux->adapter, buf);
-      goto exit;
-    }
-  } else {
-    g_assert (new_pcr == -1);
-  }
-
-  /* interpolate if needed, and 2 points available */
-  if (chunk_bytes && (new_pcr != mux->previous_pcr)) {
-    gint64 offset = 0;
+  if (mux->last_ats < 0)
+    ats = new_pcr >= 0 ? new_pcr : 0;
+  else
+    ats = MAX (new_pcr, mux->last_ats + (gint64) packet_time);
 
-    GST_LOG_OBJECT (mux, "Processing pending packets; "
-        "previous pcr %" G_GINT64_FORMAT ", previous offset %d, "
-        "current pcr %" G_GINT64_FORMAT ", current offset %d",
-        mux->previous_pcr, (gint) mux->previous_offset,
-        new_pcr, (gint) chunk_bytes);
+  if (G_UNLIKELY (new_pcr >= 0 && ats != new_pcr))
+    GST_DEBUG_OBJECT (mux, "PCR %" G_GINT64_FORMAT " behind virtual clock %"
+        G_GINT64_FORMAT ", output exceeds the recording rate", new_pcr, ats);
 
-    g_assert (chunk_bytes > mux->previous_offset);
-    /* if draining, use previous rate */
-    if (G_LIKELY (new_pcr > 0)) {
-      mux->pcr_rate_num = new_pcr - mux->previous_pcr;
-      mux->pcr_rate_den = chunk_bytes - mux->previous_offset;
-    }
+  mux->last_ats = ats;
 
-    while (offset < chunk_bytes) {
-      guint64 cur_pcr, ts;
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
 
-      /* Loop, pulling packets of the adapter, updating their 4 byte
-       * timestamp header and pushing */
+  /* The header is the bottom 30 bits of the arrival time, apparently not
+   * encoded into base + ext as in the PCR of the packets themselves */
+  GST_WRITE_UINT32_BE (map.data, ats & 0x3FFFFFFF);
 
-      /* interpolate PCR */
-      if (G_LIKELY (offset >= mux->previous_offset))
-        cur_pcr = mux->previous_pcr +
-            gst_util_uint64_scale (offset - mux->previous_offset,
-            mux->pcr_rate_num, mux->pcr_rate_den);
-      else
-        cur_pcr = mux->previous_pcr -
-            gst_util_uint64_scale (mux->previous_offset - offset,
-            mux->pcr_rate_num, mux->pcr_rate_den);
+  gst_buffer_unmap (buf, &map);
 
-      /* FIXME: what about DTS here? */
-      ts = gst_adapter_prev_pts (mux->adapter, NULL);
-      out_buf = gst_adapter_take_buffer (mux->adapter, M2TS_PACKET_LENGTH);
-      g_assert (out_buf);
-      offset += M2TS_PACKET_LENGTH;
+  GST_LOG_OBJECT (mux, "Outputting a packet of length %d ATS %"
+      G_GINT64_FORMAT, M2TS_PACKET_LENGTH, ats);
+  mpegtsmux_collect_packet (mux, buf);
 
-      GST_BUFFER_PTS (out_buf) = ts;
+  return TRUE;
+}
 
-      gst_buffer_map (out_buf, &map, GST_MAP_WRITE);
+/* Mark @buf, the PAT preceding a forced key unit, as the start of a new
+ * segment. Packets collected so far are pushed out first so that @buf
+ * starts an output buffer. */
+static gboolean
+mpegtsmux_start_segment (MpegTsMux * mux, GstBuffer * buf)
+{
+  GstFlowReturn ret;
 
-      /* The header is the bottom 30 bits of the PCR, apparently not
-       * encoded into base + ext as in the packets themselves */
-      GST_WRITE_UINT32_BE (map.data, cur_pcr & 0x3FFFFFFF);
-      gst_buffer_unmap (out_buf, &map);
+  mux->segment_start_pending = FALSE;
 
-      GST_LOG_OBJECT (mux, "Outputting a packet of length %d PCR %"
-          G_GUINT64_FORMAT, M2TS_PACKET_LENGTH, cur_pcr);
-      mpegtsmux_collect_packet (mux, out_buf);
-    }
+  ret = mpegtsmux_push_packets (mux, TRUE);
+  if (ret != GST_FLOW_OK) {
+    mux->last_flow_ret = ret;
+    return FALSE;
   }
 
-  if (G_UNLIKELY (!buf))
-    goto exit;
+  GST_DEBUG_OBJECT (mux, "Starting segment for key unit at %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (mux->segment_start_running_time));
 
-  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  gst_buffer_add_mpegts_segment_start_meta (buf,
+      mux->segment_start_running_time, mux->segment_start_count);
 
-  /* Finally, output the passed in packet */
-  /* Only write the bottom 30 bits of the PCR */
-  GST_WRITE_UINT32_BE (map.data, new_pcr & 0x3FFFFFFF);
-
-  gst_buffer_unmap (buf, &map);
-
-  GST_LOG_OBJECT (mux, "Outputting a packet of length %d PCR %"
-      G_GUINT64_FORMAT, M2TS_PACKET_LENGTH, new_pcr);
-  mpegtsmux_collect_packet (mux, buf);
-
-  if (new_pcr != mux->previous_pcr) {
-    mux->previous_pcr = new_pcr;
-    mux->previous_offset = -M2TS_PACKET_LENGTH;
-  }
-
-exit:
   return TRUE;
 }
 
@@ -1843,10 +2067,12 @@ new_packet_cb (GstBuffer * buf, void *user_data, gint64 new_pcr)
   if (mux->m2ts_mode) {
     offset = 4;
     gst_buffer_set_size (buf, NORMAL_TS_PACKET_LENGTH + offset);
+    gst_buffer_map (buf, &map, GST_MAP_READWRITE);
+  } else {
+    /* only the header is needed, avoid merging zero-copy payload memory */
+    gst_buffer_map_range (buf, 0, 1, &map, GST_MAP_READ);
   }
 
-  gst_buffer_map (buf, &map, GST_MAP_READWRITE);
-
   if (offset) {
     /* there should be a better way to do this */
     memmove (map.data + offset, map.data, map.size - offset);
@@ -1856,7 +2082,16 @@ new_packet_cb (GstBuffer * buf, void *user_data, gint64 new_pcr)
   /* do common init (flags and streamheaders) */
   new_packet_common_init (mux, buf, map.data + offset, map.size);
 
-  gst_buffer_unmap (buf, &map);
+  if (G_UNLIKELY (mux->segment_start_pending) && !offset &&
+      (((map.data[1] & 0x1f) << 8) | map.data[2]) == 0x00) {
+    gst_buffer_unmap (buf, &map);
+    if (!mpegtsmux_start_segment (mux, buf)) {
+      gst_buffer_unref (buf);
+      return FALSE;
+    }
+  } else {
+    gst_buffer_unmap (buf, &map);
+  }
 
   /* all is meant for downstream, including any prefix */
   if (offset)
@@ -1878,7 +2113,10 @@ alloc_packet_cb (GstBuffer ** _buf, void *user_data)
   if (mux->m2ts_mode == TRUE)
     offset = 4;
 
-  buf = gst_buffer_new_and_alloc (NORMAL_TS_PACKET_LENGTH + offset);
+  /* Packets are carved out of a pool so that no memory is allocated per
+   * packet once downstream releases the buffers it was given */
+  buf = mpegtsmux_acquire_buffer (mux, &mux->packet_pool,
+      NORMAL_TS_PACKET_LENGTH + offset);
   gst_buffer_set_size (buf, NORMAL_TS_PACKET_LENGTH);
 
   *_buf = buf;
@@ -1990,17 +2228,32 @@ mpegtsmux_send_event (GstElement * element, GstEvent * event)
   MpegTsMux *mux = GST_MPEG_TSMUX (element);
 
   section = gst_event_parse_mpegts_section (event);
-  gst_event_unref (event);
 
   if (section) {
+    const GstStructure *s = gst_event_get_structure (event);
+    GstClockTime running_time;
+
     GST_DEBUG ("Received event with mpegts section");
 
-    /* TODO: Check that the section type is supported */
-    tsmux_add_mpegts_si_section (mux->tsmux, section);
+    /* A section with a running time, like a SCTE-35 splice command, is
+     * written once when the output reaches that time instead of being
+     * repeated */
+    GST_COLLECT_PADS_STREAM_LOCK (mux->collect);
+    if (gst_structure_get_clock_time (s, "running-time", &running_time) &&
+        GST_CLOCK_TIME_IS_VALID (running_time)) {
+      tsmux_add_mpegts_si_section_at (mux->tsmux, section,
+          GSTTIME_TO_MPEGTIME (running_time));
+    } else {
+      /* TODO: Check that the section type is supported */
+      tsmux_add_mpegts_si_section (mux->tsmux, section);
+    }
+    GST_COLLECT_PADS_STREAM_UNLOCK (mux->collect);
 
+    gst_event_unref (event);
     return TRUE;
   }
 
+  gst_event_unref (event);
   return FALSE;
 }
 
@@ -135,16 +135,25 @@ struct MpegTsMux {
   /* properties */
   gboolean m2ts_mode;
   GstStructure *prog_map;
+  GstStructure *prog_bitrates;
   guint pat_interval;
   guint pmt_interval;
   gint alignment;
   guint si_interval;
+  guint64 bitrate;
+  gboolean zero_copy;
+  gboolean low_latency;
 
   /* state */
   gboolean first;
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
 
+  /* mark the next PAT as segment start */
+  gboolean segment_start_pending;
+  GstClockTime segment_start_running_time;
+  guint segment_start_count;
+
   /* write callback handling/state */
   GstFlowReturn last_flow_ret;
   GQueue streamheader;
@@ -154,16 +163,16 @@ struct MpegTsMux {
   GstClockTime last_ts;
 
   /* m2ts specific */
-  gint64 previous_pcr;
-  gint64 previous_offset;
-  gint64 pcr_rate_num;
-  gint64 pcr_rate_den;
-  GstAdapter *adapter;
+  gint64 last_ats;
 
   /* output buffer aggregation */
   GstAdapter *out_adapter;
   GstBuffer *out_buffer;
 
+  /* pools for packet and aligned output buffers */
+  GstBufferPool *packet_pool;
+  GstBufferPool *out_pool;
+
 #if 0
   /* SPN/PTS index handling */
   GstIndex *element_index;
@@ -109,16 +109,34 @@
 /* Times per second to write PCR */
 #define TSMUX_DEFAULT_PCR_FREQ (25)
 
+/* Maximum gap in the input that is filled with null packets in constant
+ * bitrate mode, beyond that the output timeline is restarted */
+#define TSMUX_MAX_STUFFING_TIME (TSMUX_SYS_CLOCK_FREQ)
+
+/* Amount of data, in MPEG PTS clock time at the program bitrate, that a
+ * bitrate limited program may send ahead of its budget */
+#define TSMUX_PROGRAM_BUFFER_TIME (TSMUX_CLOCK_FREQ / 10)
+
 /* Base for all written PCR and DTS/PTS,
  * so we have some slack to go backwards */
 #define CLOCK_BASE (TSMUX_CLOCK_FREQ * 10 * 360)
 
 static gboolean tsmux_write_pat (TsMux * mux);
 static gboolean tsmux_write_pmt (TsMux * mux, TsMuxProgram * program);
+static void
+tsmux_section_clear_packets (TsMuxSection * section)
+{
+  if (section->packets) {
+    g_byte_array_unref (section->packets);
+    section->packets = NULL;
+  }
+}
+
 static void
 tsmux_section_free (TsMuxSection * section)
 {
   gst_mpegts_section_unref (section->section);
+  tsmux_section_clear_packets (section);
   g_slice_free (TsMuxSection, section);
 }
 
@@ -152,6 +170,9 @@ tsmux_new (void)
 
   mux->si_sections = g_hash_table_new_full (g_direct_hash, g_direct_equal,
       NULL, (GDestroyNotify) tsmux_section_free);
+  mux->oneshot_cc = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  mux->first_pcr = -1;
 
   return mux;
 }
@@ -260,6 +281,78 @@ tsmux_get_si_interval (TsMux * mux)
   return mux->si_interval;
 }
 
+/**
+ * tsmux_set_bitrate:
+ * @mux: a #TsMux
+ * @bitrate: the output bitrate in bits per second, or 0
+ *
+ * Set the constant output bitrate of @mux. When @bitrate is non-zero, packets
+ * are scheduled on a fixed rate timeline: null packets are inserted whenever
+ * no stream has data due, and PCR values are derived from the position of
+ * the packet in the output rather than from the input timestamps.
+ *
+ * Setting @bitrate to 0 disables stuffing and produces variable bitrate
+ * output.
+ */
+void
+tsmux_set_bitrate (TsMux * mux, guint64 bitrate)
+{
+  g_return_if_fail (mux != NULL);
+
+  mux->bitrate = bitrate;
+}
+
+/**
+ * tsmux_get_bitrate:
+ * @mux: a #TsMux
+ *
+ * Get the configured output bitrate. See also tsmux_set_bitrate().
+ *
+ * Returns: the configured bitrate in bits per second, or 0 for VBR output
+ */
+guint64
+tsmux_get_bitrate (TsMux * mux)
+{
+  g_return_val_if_fail (mux != NULL, 0);
+
+  return mux->bitrate;
+}
+
+/**
+ * tsmux_set_zero_copy:
+ * @mux: a #TsMux
+ * @zero_copy: whether to reference the elementary stream data
+ *
+ * When @zero_copy is TRUE, stream packets are output as a buffer made of a
+ * small memory holding the TS and PES headers followed by memory referencing
+ * the elementary stream data, instead of a 188 byte copy. Such packets are
+ * not allocated through the alloc function.
+ */
+void
+tsmux_set_zero_copy (TsMux * mux, gboolean zero_copy)
+{
+  g_return_if_fail (mux != NULL);
+
+  mux->zero_copy = zero_copy;
+}
+
+/**
+ * tsmux_get_zero_copy:
+ * @mux: a #TsMux
+ *
+ * Get whether zero-copy packet output is enabled. See also
+ * tsmux_set_zero_copy().
+ *
+ * Returns: TRUE if stream payload is referenced rather than copied
+ */
+gboolean
+tsmux_get_zero_copy (TsMux * mux)
+{
+  g_return_val_if_fail (mux != NULL, FALSE);
+
+  return mux->zero_copy;
+}
+
 /**
  * tsmux_add_mpegts_si_section:
  * @mux: a #TsMux
@@ -294,6 +387,50 @@ tsmux_add_mpegts_si_section (TsMux * mux, GstMpegtsSection * section)
   return TRUE;
 }
 
+static gint
+tsmux_section_compare_ts (const TsMuxSection * a, const TsMuxSection * b)
+{
+  if (a->ts < b->ts)
+    return -1;
+  return a->ts > b->ts;
+}
+
+/**
+ * tsmux_add_mpegts_si_section_at:
+ * @mux: a #TsMux
+ * @section: (transfer full): a #GstMpegtsSection to add
+ * @ts: time at which to write the section, in MPEG PTS clock time
+ *
+ * Schedule @section to be written out once, on its own PID, as soon as
+ * the PCR stream reaches @ts. This is meant for sections that are not
+ * repeated, like SCTE-35 splice commands.
+ *
+ * Returns: %TRUE if the section was successfully added, else %FALSE.
+ */
+gboolean
+tsmux_add_mpegts_si_section_at (TsMux * mux, GstMpegtsSection * section,
+    gint64 ts)
+{
+  TsMuxSection *tsmux_section;
+
+  g_return_val_if_fail (mux != NULL, FALSE);
+  g_return_val_if_fail (section != NULL, FALSE);
+
+  tsmux_section = g_slice_new0 (TsMuxSection);
+
+  GST_DEBUG ("Scheduling mpegts section with type %d at %" G_GINT64_FORMAT,
+      section->section_type, ts);
+
+  tsmux_section->section = section;
+  tsmux_section->pi.pid = section->pid;
+  tsmux_section->ts = ts;
+
+  mux->oneshot_sections = g_list_insert_sorted (mux->oneshot_sections,
+      tsmux_section, (GCompareFunc) tsmux_section_compare_ts);
+
+  return TRUE;
+}
+
 /**
  * tsmux_free:
  * @mux: a #TsMux
@@ -311,6 +448,7 @@ tsmux_free (TsMux * mux)
   /* Free PAT section */
   if (mux->pat.section)
     gst_mpegts_section_unref (mux->pat.section);
+  tsmux_section_clear_packets (&mux->pat);
 
   /* Free all programs */
   for (cur = mux->programs; cur; cur = cur->next) {
@@ -330,6 +468,9 @@ tsmux_free (TsMux * mux)
 
   /* Free SI table sections */
   g_hash_table_destroy (mux->si_sections);
+  g_list_free_full (mux->oneshot_sections,
+      (GDestroyNotify) tsmux_section_free);
+  g_hash_table_destroy (mux->oneshot_cc);
 
   g_slice_free (TsMux, mux);
 }
@@ -383,6 +524,8 @@ tsmux_program_new (TsMux * mux, gint prog_id)
   program->pmt_pid = mux->next_pmt_pid++;
   program->pcr_stream = NULL;
 
+  program->last_drain_ts = G_MININT64;
+
   program->streams = g_array_sized_new (FALSE, TRUE, sizeof (TsMuxStream *), 1);
 
   mux->programs = g_list_prepend (mux->programs, program);
@@ -427,6 +570,46 @@ tsmux_get_pmt_interval (TsMuxProgram * program)
   return program->pmt_interval;
 }
 
+/**
+ * tsmux_program_set_max_bitrate:
+ * @program: a #TsMuxProgram
+ * @bitrate: the maximum bitrate in bits per second, or 0
+ *
+ * Limit the rate at which packets of @program are written out by
+ * tsmux_write_scheduled(). The program buffer is modeled as a leaky bucket
+ * drained at @bitrate holding 100ms worth of data, packets of the program
+ * are held back while that buffer is full.
+ */
+void
+tsmux_program_set_max_bitrate (TsMuxProgram * program, guint64 bitrate)
+{
+  g_return_if_fail (program != NULL);
+
+  program->max_bitrate = bitrate;
+  program->buffer_size = MAX (TSMUX_PACKET_LENGTH,
+      gst_util_uint64_scale (bitrate / 8, TSMUX_PROGRAM_BUFFER_TIME,
+          TSMUX_CLOCK_FREQ));
+  program->buffer_fullness = 0;
+  program->last_drain_ts = G_MININT64;
+}
+
+/**
+ * tsmux_program_get_max_bitrate:
+ * @program: a #TsMuxProgram
+ *
+ * Get the configured maximum bitrate. See also
+ * tsmux_program_set_max_bitrate().
+ *
+ * Returns: the maximum bitrate of @program, or 0 if it is not limited
+ */
+guint64
+tsmux_program_get_max_bitrate (TsMuxProgram * program)
+{
+  g_return_val_if_fail (program != NULL, 0);
+
+  return program->max_bitrate;
+}
+
 /**
  * tsmux_program_add_stream:
  * @program: a #TsMuxProgram
@@ -591,6 +774,8 @@ tsmux_packet_out (TsMux * mux, GstBuffer * buf, gint64 pcr)
     return TRUE;
   }
 
+  mux->n_bytes += TSMUX_PACKET_LENGTH;
+
   return mux->write_func (buf, mux->write_func_data, pcr);
 }
 
@@ -841,6 +1026,183 @@ tsmux_write_ts_header (guint8 * buf, TsMuxPacketInfo * pi,
   return TRUE;
 }
 
+/* Returns the PCR matching the position of the next packet in the output
+ * when running at a constant bitrate */
+static gint64
+tsmux_get_output_pcr (TsMux * mux)
+{
+  g_assert (mux->bitrate > 0 && mux->first_pcr != -1);
+
+  return mux->first_pcr + gst_util_uint64_scale (mux->n_bytes * 8,
+      TSMUX_SYS_CLOCK_FREQ, mux->bitrate);
+}
+
+/* Returns the PCR to write in the next packet of a PCR stream whose current
+ * timestamp is @cur_ts (including CLOCK_BASE) */
+static gint64
+tsmux_get_current_pcr (TsMux * mux, gint64 cur_ts)
+{
+  if (mux->bitrate == 0) {
+    if (cur_ts == G_MININT64)
+      return 0;
+    /* FIXME: The current PCR needs more careful calculation than just
+     * writing a fixed offset */
+    return (cur_ts - TSMUX_PCR_OFFSET) *
+        (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
+  }
+
+  if (mux->first_pcr == -1) {
+    if (cur_ts == G_MININT64)
+      return 0;
+    /* Start the output timeline at the first known PCR stream timestamp */
+    mux->first_pcr = (cur_ts - TSMUX_PCR_OFFSET) *
+        (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
+    mux->n_bytes = 0;
+  }
+
+  return tsmux_get_output_pcr (mux);
+}
+
+static gboolean
+tsmux_write_null_packet (TsMux * mux)
+{
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+
+  if (!tsmux_get_buffer (mux, &buf))
+    return FALSE;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  map.data[0] = TSMUX_SYNC_BYTE;
+  map.data[1] = (TSMUX_NULL_PID >> 8) & 0x1f;
+  map.data[2] = TSMUX_NULL_PID & 0xff;
+  /* payload only, continuity counter is undefined for null packets */
+  map.data[3] = 0x10;
+  memset (map.data + TSMUX_HEADER_LENGTH, 0xff, TSMUX_PAYLOAD_LENGTH);
+  gst_buffer_unmap (buf, &map);
+
+  return tsmux_packet_out (mux, buf, -1);
+}
+
+/* Write a packet on the PID of @stream carrying only an adaptation field
+ * with @pcr. Such a packet has no payload, so the continuity counter of the
+ * stream is left untouched. */
+static gboolean
+tsmux_write_pcr_packet (TsMux * mux, TsMuxStream * stream, gint64 pcr)
+{
+  TsMuxPacketInfo pi;
+  guint payload_len, payload_offs;
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+
+  pi = stream->pi;
+  pi.flags = TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
+  pi.pcr = pcr;
+  pi.packet_start_unit_indicator = FALSE;
+  pi.stream_avail = 0;
+  pi.private_data_len = 0;
+
+  if (!tsmux_get_buffer (mux, &buf))
+    return FALSE;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  if (!tsmux_write_ts_header (map.data, &pi, &payload_len, &payload_offs)) {
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+    return FALSE;
+  }
+  gst_buffer_unmap (buf, &map);
+
+  stream->last_pcr = pcr;
+
+  TS_DEBUG ("Writing PCR only packet on PID 0x%04x", pi.pid);
+
+  return tsmux_packet_out (mux, buf, pcr);
+}
+
+/* In constant bitrate mode, fill the output with null packets until the
+ * output timeline reaches the point where data with timestamp @cur_ts is
+ * due, while making sure the PCR of every program keeps being repeated. */
+static gboolean
+tsmux_pad_stream (TsMux * mux, gint64 cur_ts)
+{
+  gint64 target = -1;
+
+  if (mux->bitrate == 0 || mux->first_pcr == -1)
+    return TRUE;
+
+  if (cur_ts != G_MININT64) {
+    target = (cur_ts + CLOCK_BASE - TSMUX_PCR_OFFSET) *
+        (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
+
+    if (target - tsmux_get_output_pcr (mux) > TSMUX_MAX_STUFFING_TIME) {
+      TS_DEBUG ("Gap in input too large, restarting output timeline");
+      mux->first_pcr = target;
+      mux->n_bytes = 0;
+    }
+  }
+
+  while (TRUE) {
+    gint64 cur_pcr = tsmux_get_output_pcr (mux);
+    gboolean wrote_pcr = FALSE;
+    GList *cur;
+
+    for (cur = mux->programs; cur; cur = cur->next) {
+      TsMuxProgram *program = (TsMuxProgram *) cur->data;
+      TsMuxStream *pcr_stream = program->pcr_stream;
+
+      if (pcr_stream == NULL || pcr_stream->last_pcr == -1)
+        continue;
+
+      if (cur_pcr - pcr_stream->last_pcr >
+          (TSMUX_SYS_CLOCK_FREQ / TSMUX_DEFAULT_PCR_FREQ)) {
+        if (!tsmux_write_pcr_packet (mux, pcr_stream, cur_pcr))
+          return FALSE;
+        wrote_pcr = TRUE;
+        break;
+      }
+    }
+
+    if (wrote_pcr)
+      continue;
+
+    if (cur_pcr >= target)
+      break;
+
+    if (!tsmux_write_null_packet (mux))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Write out the cached packets of a section that was written before */
+static gboolean
+tsmux_section_write_cached (TsMuxSection * section, TsMux * mux)
+{
+  guint i;
+
+  for (i = 0; i < section->packets->len; i += TSMUX_PACKET_LENGTH) {
+    guint8 *data = section->packets->data + i;
+    GstBuffer *buf = NULL;
+
+    if (!tsmux_get_buffer (mux, &buf))
+      return FALSE;
+
+    /* All section packets carry payload, only the continuity counter
+     * changes between repeats */
+    data[3] = (data[3] & 0xf0) | (section->pi.packet_count & 0x0f);
+    section->pi.packet_count++;
+
+    gst_buffer_fill (buf, 0, data, TSMUX_PACKET_LENGTH);
+
+    if (G_UNLIKELY (!tsmux_packet_out (mux, buf, -1)))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 tsmux_section_write_packet (GstMpegtsSectionType * type,
     TsMuxSection * section, TsMux * mux)
@@ -858,6 +1220,9 @@ tsmux_section_write_packet (GstMpegtsSectionType * type,
   g_return_val_if_fail (section != NULL, FALSE);
   g_return_val_if_fail (mux != NULL, FALSE);
 
+  if (section->packets)
+    return tsmux_section_write_cached (section, mux);
+
   /* Mark the start of new PES unit */
   section->pi.packet_start_unit_indicator = TRUE;
 
@@ -880,6 +1245,10 @@ tsmux_section_write_packet (GstMpegtsSectionType * type,
   TS_DEBUG ("Section buffer with size %" G_GSIZE_FORMAT " created",
       gst_buffer_get_size (section_buffer));
 
+  section->packets = g_byte_array_sized_new (((data_size + 1 +
+              TSMUX_PAYLOAD_LENGTH - 1) / TSMUX_PAYLOAD_LENGTH) *
+      TSMUX_PACKET_LENGTH);
+
   while (section->pi.stream_avail > 0) {
 
     packet = g_malloc (TSMUX_PACKET_LENGTH);
@@ -940,6 +1309,12 @@ tsmux_section_write_packet (GstMpegtsSectionType * type,
     TS_DEBUG ("Writing %d bytes to section. %d bytes remaining",
         len, section->pi.stream_avail - len);
 
+    /* Keep the packet for repeats */
+    g_byte_array_set_size (section->packets,
+        section->packets->len + TSMUX_PACKET_LENGTH);
+    gst_buffer_extract (packet_buffer, 0, section->packets->data +
+        section->packets->len - TSMUX_PACKET_LENGTH, TSMUX_PACKET_LENGTH);
+
     /* Push the packet without PCR */
     if (G_UNLIKELY (!tsmux_packet_out (mux, packet_buffer, -1))) {
       /* Buffer given away */
@@ -961,9 +1336,40 @@ fail:
   g_free (packet);
   if (section_buffer)
     gst_buffer_unref (section_buffer);
+  tsmux_section_clear_packets (section);
   return FALSE;
 }
 
+/* Write out the one-shot sections that are due at @cur_ts */
+static gboolean
+tsmux_write_oneshot_sections (TsMux * mux, gint64 cur_ts)
+{
+  while (mux->oneshot_sections) {
+    TsMuxSection *section = (TsMuxSection *) mux->oneshot_sections->data;
+    gpointer pid = GUINT_TO_POINTER (section->pi.pid);
+    gboolean res;
+
+    if (section->ts != G_MININT64 && section->ts + CLOCK_BASE > cur_ts)
+      break;
+
+    mux->oneshot_sections = g_list_delete_link (mux->oneshot_sections,
+        mux->oneshot_sections);
+
+    /* Continue the continuity counter of previous sections on the PID */
+    section->pi.packet_count =
+        GPOINTER_TO_UINT (g_hash_table_lookup (mux->oneshot_cc, pid));
+    res = tsmux_section_write_packet (NULL, section, mux);
+    g_hash_table_insert (mux->oneshot_cc, pid,
+        GUINT_TO_POINTER (section->pi.packet_count & 0x0f));
+
+    tsmux_section_free (section);
+    if (!res)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 tsmux_write_si (TsMux * mux)
 {
@@ -976,6 +1382,46 @@ tsmux_write_si (TsMux * mux)
 
 }
 
+/* Write a packet of @stream whose payload references the elementary stream
+ * data instead of copying it */
+static gboolean
+tsmux_write_stream_packet_ref (TsMux * mux, TsMuxStream * stream,
+    gint64 cur_pcr)
+{
+  guint8 hdr[TSMUX_PACKET_LENGTH];
+  guint payload_len, payload_offs, pes_hdr_len;
+  TsMuxPacketInfo *pi = &stream->pi;
+  GstMemory *mem;
+  GstBuffer *buf;
+  GstMapInfo map;
+  gboolean res;
+
+  if (!tsmux_write_ts_header (hdr, pi, &payload_len, &payload_offs))
+    return FALSE;
+
+  buf = gst_buffer_new ();
+  if (!tsmux_stream_get_data_buffer (stream, hdr + payload_offs, payload_len,
+          &pes_hdr_len, buf)) {
+    gst_buffer_unref (buf);
+    return FALSE;
+  }
+
+  mem = gst_allocator_alloc (NULL, payload_offs + pes_hdr_len, NULL);
+  gst_memory_map (mem, &map, GST_MAP_WRITE);
+  memcpy (map.data, hdr, payload_offs + pes_hdr_len);
+  gst_memory_unmap (mem, &map);
+  gst_buffer_prepend_memory (buf, mem);
+
+  GST_DEBUG_OBJECT (mux, "Writing PES of size %d in %u memories",
+      (int) gst_buffer_get_size (buf), gst_buffer_n_memory (buf));
+  res = tsmux_packet_out (mux, buf, cur_pcr);
+
+  /* Reset all dynamic flags */
+  stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
+
+  return res;
+}
+
 /**
  * tsmux_write_stream_packet:
  * @mux: a #TsMux
@@ -998,37 +1444,21 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
 
+  /* Pace the output on the timestamp the data of the stream is due at */
+  if (!tsmux_pad_stream (mux, stream->last_dts != G_MININT64 ?
+          stream->last_dts : stream->last_pts))
+    return FALSE;
+
   if (tsmux_stream_is_pcr (stream)) {
     gint64 cur_pts = tsmux_stream_get_pts (stream);
     gboolean write_pat;
     gboolean write_si;
     GList *cur;
 
-    cur_pcr = 0;
     if (cur_pts != G_MININT64) {
       TS_DEBUG ("TS for PCR stream is %" G_GINT64_FORMAT, cur_pts);
-    }
-
-    /* FIXME: The current PCR needs more careful calculation than just
-     * writing a fixed offset */
-    if (cur_pts != G_MININT64) {
       /* CLOCK_BASE >= TSMUX_PCR_OFFSET */
       cur_pts += CLOCK_BASE;
-      cur_pcr = (cur_pts - TSMUX_PCR_OFFSET) *
-          (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
-    }
-
-    /* Need to decide whether to write a new PCR in this packet */
-    if (stream->last_pcr == -1 ||
-        (cur_pcr - stream->last_pcr >
-            (TSMUX_SYS_CLOCK_FREQ / TSMUX_DEFAULT_PCR_FREQ))) {
-
-      stream->pi.flags |=
-          TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
-      stream->pi.pcr = cur_pcr;
-      stream->last_pcr = cur_pcr;
-    } else {
-      cur_pcr = -1;
     }
 
     /* check if we need to rewrite pat */
@@ -1059,6 +1489,9 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
         return FALSE;
     }
 
+    if (cur_pts != G_MININT64 && !tsmux_write_oneshot_sections (mux, cur_pts))
+      return FALSE;
+
     /* check if we need to rewrite any of the current pmts */
     for (cur = mux->programs; cur; cur = cur->next) {
       TsMuxProgram *program = (TsMuxProgram *) cur->data;
@@ -1077,6 +1510,22 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
           return FALSE;
       }
     }
+
+    /* Decide whether to write a new PCR in this packet. This is done after
+     * the tables have been written out so that in constant bitrate mode the
+     * PCR matches the actual position of the packet */
+    cur_pcr = tsmux_get_current_pcr (mux, cur_pts);
+    if (stream->last_pcr == -1 ||
+        (cur_pcr - stream->last_pcr >
+            (TSMUX_SYS_CLOCK_FREQ / TSMUX_DEFAULT_PCR_FREQ))) {
+
+      stream->pi.flags |=
+          TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
+      stream->pi.pcr = cur_pcr;
+      stream->last_pcr = cur_pcr;
+    } else {
+      cur_pcr = -1;
+    }
   }
 
   pi->packet_start_unit_indicator = tsmux_stream_at_pes_start (stream);
@@ -1089,6 +1538,9 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   }
   pi->stream_avail = tsmux_stream_bytes_avail (stream);
 
+  if (mux->zero_copy)
+    return tsmux_write_stream_packet_ref (mux, stream, cur_pcr);
+
   /* obtain buffer */
   if (!tsmux_get_buffer (mux, &buf))
     return FALSE;
@@ -1138,6 +1590,7 @@ tsmux_program_free (TsMuxProgram * program)
   /* Free PMT section */
   if (program->pmt.section)
     gst_mpegts_section_unref (program->pmt.section);
+  tsmux_section_clear_packets (&program->pmt);
 
   g_array_free (program->streams, TRUE);
   g_slice_free (TsMuxProgram, program);
@@ -1174,6 +1627,7 @@ tsmux_write_pat (TsMux * mux)
 
     if (mux->pat.section)
       gst_mpegts_section_unref (mux->pat.section);
+    tsmux_section_clear_packets (&mux->pat);
 
     mux->pat.section = gst_mpegts_section_from_pat (pat, mux->transport_id);
 
@@ -1255,6 +1709,7 @@ tsmux_write_pmt (TsMux * mux, TsMuxProgram * program)
 
     if (program->pmt.section)
       gst_mpegts_section_unref (program->pmt.section);
+    tsmux_section_clear_packets (&program->pmt);
 
     program->pmt.section = gst_mpegts_section_from_pmt (pmt, program->pmt_pid);
     program->pmt.section->version_number = program->pmt_version++;
@@ -1263,3 +1718,101 @@ tsmux_write_pmt (TsMux * mux, TsMuxProgram * program)
   return tsmux_section_write_packet (GINT_TO_POINTER (GST_MPEGTS_SECTION_PMT),
       &program->pmt, mux);
 }
+
+/* Drain the program buffer model up to @now and check whether one more
+ * packet fits in it */
+static gboolean
+tsmux_program_has_room (TsMuxProgram * program, gint64 now)
+{
+  if (program->max_bitrate == 0 || now == G_MININT64)
+    return TRUE;
+
+  if (program->last_drain_ts != G_MININT64 && now > program->last_drain_ts) {
+    guint64 drained = gst_util_uint64_scale (now - program->last_drain_ts,
+        program->max_bitrate / 8, TSMUX_CLOCK_FREQ);
+
+    program->buffer_fullness -= MIN (drained, program->buffer_fullness);
+  }
+  if (program->last_drain_ts == G_MININT64 || now > program->last_drain_ts)
+    program->last_drain_ts = now;
+
+  return program->buffer_fullness + TSMUX_PACKET_LENGTH <=
+      program->buffer_size;
+}
+
+/**
+ * tsmux_write_scheduled:
+ * @mux: a #TsMux
+ * @now: the current time in MPEG PTS clock time
+ * @drain: write out all pending data regardless of the program bitrates
+ *
+ * Write out pending packets of all streams, most urgent deadline first.
+ * Packets of programs that have a maximum bitrate configured with
+ * tsmux_program_set_max_bitrate() are held back while the program buffer is
+ * full at time @now, until a later call drains it.
+ *
+ * Returns: TRUE if the packets could be written.
+ */
+gboolean
+tsmux_write_scheduled (TsMux * mux, gint64 now, gboolean drain)
+{
+  GList *cur;
+
+  g_return_val_if_fail (mux != NULL, FALSE);
+
+  while (TRUE) {
+    TsMuxProgram *best_program = NULL;
+    TsMuxStream *best = NULL;
+    gint64 best_dts = G_MAXINT64;
+
+    for (cur = mux->programs; cur; cur = cur->next) {
+      TsMuxProgram *program = (TsMuxProgram *) cur->data;
+      guint i;
+
+      if (!drain && !tsmux_program_has_room (program, now))
+        continue;
+
+      for (i = 0; i < program->streams->len; i++) {
+        TsMuxStream *stream = g_array_index (program->streams,
+            TsMuxStream *, i);
+        gint64 dts;
+
+        if (tsmux_stream_bytes_in_buffer (stream) == 0)
+          continue;
+
+        /* Data without timestamp is sent as soon as possible */
+        dts = tsmux_stream_get_next_dts (stream);
+        if (best == NULL || dts < best_dts) {
+          best = stream;
+          best_program = program;
+          best_dts = dts;
+        }
+      }
+    }
+
+    if (best == NULL)
+      break;
+
+    if (!tsmux_write_stream_packet (mux, best))
+      return FALSE;
+
+    best_program->buffer_fullness += TSMUX_PACKET_LENGTH;
+    best_program->bytes_written += TSMUX_PACKET_LENGTH;
+  }
+
+  /* Whatever is still pending was held back by the program bitrate */
+  for (cur = mux->programs; cur; cur = cur->next) {
+    TsMuxProgram *program = (TsMuxProgram *) cur->data;
+    guint i;
+
+    for (i = 0; i < program->streams->len; i++) {
+      if (tsmux_stream_bytes_in_buffer (g_array_index (program->streams,
+                  TsMuxStream *, i)) > 0) {
+        program->deferred++;
+        break;
+      }
+    }
+  }
+
+  return TRUE;
+}
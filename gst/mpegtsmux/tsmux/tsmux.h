@@ -92,6 +92,7 @@ G_BEGIN_DECLS
 #define TSMUX_MAX_ES_INFO_LENGTH ((1 << 12) - 1)
 
 #define TSMUX_PID_AUTO ((guint16)-1)
+#define TSMUX_NULL_PID 0x1fff
 
 #define TSMUX_START_PROGRAM_ID 0x0001
 #define TSMUX_START_PMT_PID 0x0020
@@ -106,6 +107,13 @@ typedef void (*TsMuxAllocFunc) (GstBuffer ** buf, void *user_data);
 struct TsMuxSection {
   TsMuxPacketInfo pi;
   GstMpegtsSection *section;
+
+  /* packetized form of @section, written out again on repeats with only
+   * the continuity counters patched */
+  GByteArray *packets;
+
+  /* for one-shot sections, when to write it in MPEG PTS clock time */
+  gint64 ts;
 };
 
 /* Information for the streams associated with one program */
@@ -131,6 +139,19 @@ struct TsMuxProgram {
 
   /* programs TsMuxStream's */
   GArray *streams;
+
+  /* maximum bitrate of the program in bits per second, 0 for unlimited */
+  guint64 max_bitrate;
+  /* leaky bucket model of the program buffer: bytes it can hold, current
+   * fullness and the MPEG PTS clock time it was last drained at */
+  guint    buffer_size;
+  guint    buffer_fullness;
+  gint64   last_drain_ts;
+
+  /* bytes written for this program and number of times its data had to
+   * be held back to stay within max_bitrate */
+  guint64  bytes_written;
+  guint64  deferred;
 };
 
 struct TsMux {
@@ -169,6 +190,21 @@ struct TsMux {
   /* last time SIT written in MPEG PTS clock time */
   gint64   last_si_ts;
 
+  /* TsMuxSection* to write once, sorted by time */
+  GList *oneshot_sections;
+  /* continuity counters of the PIDs one-shot sections are written on */
+  GHashTable *oneshot_cc;
+
+  /* output bitrate in bits per second, 0 for VBR output */
+  guint64  bitrate;
+  /* number of bytes output since first_pcr */
+  guint64  n_bytes;
+  /* PCR of the first packet of the constant bitrate timeline */
+  gint64   first_pcr;
+
+  /* reference stream payload instead of copying it into packets */
+  gboolean zero_copy;
+
   /* callback to write finished packet */
   TsMuxWriteFunc write_func;
   void *write_func_data;
@@ -189,6 +225,10 @@ void 		tsmux_set_write_func 		(TsMux *mux, TsMuxWriteFunc func, void *user_data)
 void 		tsmux_set_alloc_func 		(TsMux *mux, TsMuxAllocFunc func, void *user_data);
 void 		tsmux_set_pat_interval          (TsMux *mux, guint interval);
 guint 		tsmux_get_pat_interval          (TsMux *mux);
+void 		tsmux_set_bitrate 		(TsMux *mux, guint64 bitrate);
+guint64 	tsmux_get_bitrate 		(TsMux *mux);
+void 		tsmux_set_zero_copy 		(TsMux *mux, gboolean zero_copy);
+gboolean 	tsmux_get_zero_copy 		(TsMux *mux);
 guint16		tsmux_get_new_pid 		(TsMux *mux);
 
 /* pid/program management */
@@ -196,11 +236,15 @@ TsMuxProgram *	tsmux_program_new 		(TsMux *mux, gint prog_id);
 void 		tsmux_program_free 		(TsMuxProgram *program);
 void 		tsmux_set_pmt_interval          (TsMuxProgram *program, guint interval);
 guint 		tsmux_get_pmt_interval   	(TsMuxProgram *program);
+void 		tsmux_program_set_max_bitrate   (TsMuxProgram *program, guint64 bitrate);
+guint64 	tsmux_program_get_max_bitrate   (TsMuxProgram *program);
 
 /* SI table management */
 void            tsmux_set_si_interval           (TsMux *mux, guint interval);
 guint           tsmux_get_si_interval           (TsMux *mux);
 gboolean        tsmux_add_mpegts_si_section     (TsMux * mux, GstMpegtsSection * section);
+gboolean        tsmux_add_mpegts_si_section_at  (TsMux * mux, GstMpegtsSection * section,
+                                                 gint64 ts);
 
 /* stream management */
 TsMuxStream *	tsmux_create_stream 		(TsMux *mux, TsMuxStreamType stream_type, guint16 pid, gchar *language);
@@ -211,6 +255,7 @@ void 		tsmux_program_set_pcr_stream 	(TsMuxProgram *program, TsMuxStream *stream
 
 /* writing stuff */
 gboolean 	tsmux_write_stream_packet 	(TsMux *mux, TsMuxStream *stream);
+gboolean 	tsmux_write_scheduled 		(TsMux *mux, gint64 now, gboolean drain);
 
 G_END_DECLS
 
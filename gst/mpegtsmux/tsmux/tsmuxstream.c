@@ -108,6 +108,10 @@ struct TsMuxStreamBuffer
   /* data represents random access point */
   gboolean random_access;
 
+  /* buffer @data was mapped from, if known, used to reference the
+   * payload instead of copying it */
+  GstBuffer *buffer;
+
   /* user_data for release function */
   void *user_data;
 };
@@ -541,6 +545,98 @@ tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
   return TRUE;
 }
 
+/**
+ * tsmux_stream_get_data_buffer:
+ * @stream: a #TsMuxStream
+ * @hdr: memory to write the PES header into
+ * @len: the amount of payload, including PES header, to retrieve
+ * @hdr_len: (out): the amount of bytes written into @hdr
+ * @outbuf: buffer to append the payload memory to
+ *
+ * Like tsmux_stream_get_data(), but instead of copying the elementary stream
+ * data, append memory referencing it to @outbuf. The PES header, if any, is
+ * written into @hdr, which must have room for at least @len bytes. Data added
+ * without a #GstBuffer with tsmux_stream_add_data() is copied into newly
+ * allocated memory.
+ *
+ * Returns: TRUE if @len bytes could be retrieved.
+ */
+gboolean
+tsmux_stream_get_data_buffer (TsMuxStream * stream, guint8 * hdr, guint len,
+    guint * hdr_len, GstBuffer * outbuf)
+{
+  g_return_val_if_fail (stream != NULL, FALSE);
+  g_return_val_if_fail (hdr != NULL, FALSE);
+  g_return_val_if_fail (hdr_len != NULL, FALSE);
+  g_return_val_if_fail (outbuf != NULL, FALSE);
+
+  *hdr_len = 0;
+
+  if (stream->state == TSMUX_STREAM_STATE_HEADER) {
+    guint8 pes_hdr_length;
+
+    pes_hdr_length = tsmux_stream_pes_header_length (stream);
+
+    /* Submitted buffer must be at least as large as the PES header */
+    if (len < pes_hdr_length)
+      return FALSE;
+
+    TS_DEBUG ("Writing PES header of length %u and payload %d",
+        pes_hdr_length, stream->cur_pes_payload_size);
+    tsmux_stream_write_pes_header (stream, hdr);
+
+    len -= pes_hdr_length;
+    *hdr_len = pes_hdr_length;
+
+    stream->state = TSMUX_STREAM_STATE_PACKET;
+  }
+
+  if (len > (guint) _tsmux_stream_bytes_avail (stream))
+    return FALSE;
+
+  stream->pes_bytes_written += len;
+
+  if (stream->cur_pes_payload_size != 0 &&
+      stream->pes_bytes_written == stream->cur_pes_payload_size) {
+    TS_DEBUG ("Finished PES packet");
+    stream->state = TSMUX_STREAM_STATE_HEADER;
+    stream->pes_bytes_written = 0;
+  }
+
+  while (len > 0) {
+    guint32 avail;
+
+    if (stream->cur_buffer == NULL) {
+      /* Start next packet */
+      if (stream->buffers == NULL)
+        return FALSE;
+      stream->cur_buffer = (TsMuxStreamBuffer *) (stream->buffers->data);
+      stream->cur_buffer_consumed = 0;
+    }
+
+    /* Take as much as we can from the current buffer */
+    avail = stream->cur_buffer->size - stream->cur_buffer_consumed;
+    avail = MIN (avail, len);
+
+    /* Reference the memory before consuming, which may release the buffer */
+    if (stream->cur_buffer->buffer) {
+      gst_buffer_copy_into (outbuf, stream->cur_buffer->buffer,
+          GST_BUFFER_COPY_MEMORY, stream->cur_buffer_consumed, avail);
+    } else {
+      gst_buffer_append_memory (outbuf,
+          gst_memory_new_wrapped (0,
+              g_memdup (stream->cur_buffer->data +
+                  stream->cur_buffer_consumed, avail), avail, 0, avail,
+              NULL, NULL));
+    }
+    tsmux_stream_consume (stream, avail);
+
+    len -= avail;
+  }
+
+  return TRUE;
+}
+
 static guint8
 tsmux_stream_pes_header_length (TsMuxStream * stream)
 {
@@ -702,6 +798,33 @@ tsmux_stream_write_pes_header (TsMuxStream * stream, guint8 * data)
 void
 tsmux_stream_add_data (TsMuxStream * stream, guint8 * data, guint len,
     void *user_data, gint64 pts, gint64 dts, gboolean random_access)
+{
+  g_return_if_fail (stream != NULL);
+
+  tsmux_stream_add_buffer (stream, NULL, data, len, user_data, pts, dts,
+      random_access);
+}
+
+/**
+ * tsmux_stream_add_buffer:
+ * @stream: a #TsMuxStream
+ * @buffer: (allow-none): the #GstBuffer @data is mapped from
+ * @data: data to add
+ * @len: length of @data
+ * @user_data: user data to pass to release func
+ * @pts: PTS of access unit in @data
+ * @dts: DTS of access unit in @data
+ * @random_access: TRUE if random access point (keyframe)
+ *
+ * Like tsmux_stream_add_data(), but also passes the @buffer that @data is
+ * the mapped content of, so that the payload can be referenced rather than
+ * copied by tsmux_stream_get_data_buffer(). No reference is taken on
+ * @buffer, it must stay valid until the release function is called.
+ */
+void
+tsmux_stream_add_buffer (TsMuxStream * stream, GstBuffer * buffer,
+    guint8 * data, guint len, void *user_data, gint64 pts, gint64 dts,
+    gboolean random_access)
 {
   TsMuxStreamBuffer *packet;
 
@@ -709,6 +832,7 @@ tsmux_stream_add_data (TsMuxStream * stream, guint8 * data, guint len,
 
   packet = g_slice_new (TsMuxStreamBuffer);
   packet->data = data;
+  packet->buffer = buffer;
   packet->size = len;
   packet->user_data = user_data;
   packet->random_access = random_access;
@@ -1074,6 +1198,37 @@ tsmux_stream_is_pcr (TsMuxStream * stream)
   return stream->pcr_ref != 0;
 }
 
+/**
+ * tsmux_stream_get_next_dts:
+ * @stream: a #TsMuxStream
+ *
+ * Return the DTS, or PTS if it has no DTS, of the buffer the next bytes
+ * written out of @stream belong to. This is the deadline by which the data
+ * has to be delivered.
+ *
+ * Returns: the DTS of the next buffer in @stream, or GST_CLOCK_STIME_NONE if
+ * unknown.
+ */
+gint64
+tsmux_stream_get_next_dts (TsMuxStream * stream)
+{
+  TsMuxStreamBuffer *buffer;
+
+  g_return_val_if_fail (stream != NULL, GST_CLOCK_STIME_NONE);
+
+  buffer = stream->cur_buffer;
+  if (buffer == NULL) {
+    if (stream->buffers == NULL)
+      return GST_CLOCK_STIME_NONE;
+    buffer = (TsMuxStreamBuffer *) stream->buffers->data;
+  }
+
+  if (GST_CLOCK_STIME_IS_VALID (buffer->dts))
+    return buffer->dts;
+
+  return buffer->pts;
+}
+
 /**
  * tsmux_stream_get_pts:
  * @stream: a #TsMuxStream
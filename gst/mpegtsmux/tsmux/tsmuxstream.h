@@ -243,6 +243,10 @@ void 		tsmux_stream_set_buffer_release_func 	(TsMuxStream *stream,
 void 		tsmux_stream_add_data 		(TsMuxStream *stream, guint8 *data, guint len, 
        						 void *user_data, gint64 pts, gint64 dts,
                                                  gboolean random_access);
+void 		tsmux_stream_add_buffer 	(TsMuxStream *stream, GstBuffer *buffer,
+       						 guint8 *data, guint len,
+       						 void *user_data, gint64 pts, gint64 dts,
+                                                 gboolean random_access);
 
 void 		tsmux_stream_pcr_ref 		(TsMuxStream *stream);
 void 		tsmux_stream_pcr_unref  	(TsMuxStream *stream);
@@ -255,8 +259,11 @@ gint 		tsmux_stream_bytes_in_buffer 	(TsMuxStream *stream);
 gint 		tsmux_stream_bytes_avail 	(TsMuxStream *stream);
 gboolean 	tsmux_stream_initialize_pes_packet (TsMuxStream *stream);
 gboolean 	tsmux_stream_get_data 		(TsMuxStream *stream, guint8 *buf, guint len);
+gboolean 	tsmux_stream_get_data_buffer 	(TsMuxStream *stream, guint8 *hdr, guint len,
+       						 guint *hdr_len, GstBuffer *outbuf);
 
 guint64 	tsmux_stream_get_pts 		(TsMuxStream *stream);
+gint64 		tsmux_stream_get_next_dts 	(TsMuxStream *stream);
 
 G_END_DECLS
 
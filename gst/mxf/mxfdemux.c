@@ -55,6 +55,9 @@
 #include "mxfessence.h"
 
 #include <string.h>
+#include <glib/gstdio.h>
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
 
 static GstStaticPadTemplate mxf_sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -79,6 +82,11 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, guint64 offset);
 
 static void collect_index_table_segments (GstMXFDemux * demux);
+static void gst_mxf_demux_merge_index_table_segments (GstMXFDemux * demux);
+
+/* TRUE while more data is expected at the end of the file */
+#define gst_mxf_demux_is_growing(demux) \
+    ((demux)->growing_file && !(demux)->growing_finished)
 
 GType gst_mxf_demux_pad_get_type (void);
 G_DEFINE_TYPE (GstMXFDemuxPad, gst_mxf_demux_pad, GST_TYPE_PAD);
@@ -116,9 +124,27 @@ enum
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_READ_AHEAD_SIZE,
+  PROP_READ_AHEAD_ASYNC,
+  PROP_STATS,
+  PROP_FAST_OPEN,
+  PROP_GROWING_FILE,
+  PROP_INDEX_CACHE_DIR
 };
 
+#define DEFAULT_READ_AHEAD_SIZE 0
+#define DEFAULT_READ_AHEAD_ASYNC FALSE
+#define DEFAULT_FAST_OPEN FALSE
+#define DEFAULT_GROWING_FILE FALSE
+#define DEFAULT_INDEX_CACHE_DIR NULL
+
+/* how often the end of a growing file is checked for new data */
+#define GROWING_FILE_POLL_INTERVAL (500 * G_TIME_SPAN_MILLISECOND)
+
+/* read-ahead blocks start at multiples of this */
+#define READ_AHEAD_ALIGN 4096
+
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_mxf_demux_src_event (GstPad * pad, GstObject * parent,
@@ -218,6 +244,7 @@ gst_mxf_demux_reset_metadata (GstMXFDemux * demux)
 
   demux->update_metadata = TRUE;
   demux->metadata_resolved = FALSE;
+  demux->metadata_deferred = FALSE;
 
   gst_mxf_demux_reset_linked_metadata (demux);
 
@@ -236,6 +263,8 @@ gst_mxf_demux_reset_metadata (GstMXFDemux * demux)
   g_rw_lock_writer_unlock (&demux->metadata_lock);
 }
 
+static void gst_mxf_demux_clear_read_ahead (GstMXFDemux * demux);
+
 static void
 gst_mxf_demux_reset (GstMXFDemux * demux)
 {
@@ -245,6 +274,8 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   demux->footer_partition_pack_offset = 0;
   demux->offset = 0;
+  demux->growing_finished = FALSE;
+  demux->growing_wakeup = FALSE;
 
   demux->pull_footer_metadata = TRUE;
 
@@ -261,6 +292,10 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   gst_adapter_clear (demux->adapter);
 
+  GST_OBJECT_LOCK (demux);
+  demux->copied_bytes = 0;
+  GST_OBJECT_UNLOCK (demux);
+
   gst_mxf_demux_remove_pads (demux);
 
   if (demux->random_index_pack) {
@@ -293,6 +328,9 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
   }
 
   demux->index_table_segments_collected = FALSE;
+  demux->index_cache_loaded = FALSE;
+
+  gst_mxf_demux_clear_read_ahead (demux);
 
   gst_mxf_demux_reset_mxf_state (demux);
   gst_mxf_demux_reset_metadata (demux);
@@ -301,12 +339,170 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
   demux->group_id = G_MAXUINT;
 }
 
+static gboolean
+gst_mxf_demux_block_covers (GstBuffer * block, guint64 block_offset,
+    guint64 offset, guint size)
+{
+  return block && offset >= block_offset
+      && offset + size <= block_offset + gst_buffer_get_size (block);
+}
+
+static void
+gst_mxf_demux_prefetch_func (gpointer data, gpointer user_data)
+{
+  GstMXFDemux *demux = data;
+  GstBuffer *buffer = NULL;
+  guint64 offset;
+  guint size;
+
+  g_mutex_lock (&demux->prefetch_lock);
+  offset = demux->prefetch_offset;
+  size = demux->prefetch_size;
+  g_mutex_unlock (&demux->prefetch_lock);
+
+  if (gst_pad_pull_range (demux->sinkpad, offset, size,
+          &buffer) != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (demux, "Failed prefetching %u bytes at offset %"
+        G_GUINT64_FORMAT, size, offset);
+    buffer = NULL;
+  }
+
+  g_mutex_lock (&demux->prefetch_lock);
+  demux->prefetch = buffer;
+  demux->prefetch_pending = FALSE;
+  g_cond_signal (&demux->prefetch_cond);
+  g_mutex_unlock (&demux->prefetch_lock);
+}
+
+/* Waits for a running prefetch and returns its data, if any */
+static GstBuffer *
+gst_mxf_demux_take_prefetch (GstMXFDemux * demux, guint64 * offset)
+{
+  GstBuffer *buffer;
+
+  g_mutex_lock (&demux->prefetch_lock);
+  while (demux->prefetch_pending)
+    g_cond_wait (&demux->prefetch_cond, &demux->prefetch_lock);
+  buffer = demux->prefetch;
+  demux->prefetch = NULL;
+  *offset = demux->prefetch_offset;
+  g_mutex_unlock (&demux->prefetch_lock);
+
+  return buffer;
+}
+
+static void
+gst_mxf_demux_start_prefetch (GstMXFDemux * demux, guint64 offset, guint size)
+{
+  GError *err = NULL;
+
+  if (!demux->prefetch_pool) {
+    demux->prefetch_pool =
+        g_thread_pool_new (gst_mxf_demux_prefetch_func, NULL, 1, FALSE, &err);
+    if (!demux->prefetch_pool) {
+      GST_WARNING_OBJECT (demux, "Can't create prefetch thread: %s",
+          err->message);
+      g_clear_error (&err);
+      return;
+    }
+  }
+
+  g_mutex_lock (&demux->prefetch_lock);
+  demux->prefetch_pending = TRUE;
+  demux->prefetch_offset = offset;
+  demux->prefetch_size = size;
+  g_mutex_unlock (&demux->prefetch_lock);
+
+  if (!g_thread_pool_push (demux->prefetch_pool, demux, &err)) {
+    GST_WARNING_OBJECT (demux, "Can't start prefetch: %s", err->message);
+    g_clear_error (&err);
+    g_mutex_lock (&demux->prefetch_lock);
+    demux->prefetch_pending = FALSE;
+    g_mutex_unlock (&demux->prefetch_lock);
+  }
+}
+
+static void
+gst_mxf_demux_clear_read_ahead (GstMXFDemux * demux)
+{
+  GstBuffer *prefetch;
+  guint64 prefetch_offset;
+
+  prefetch = gst_mxf_demux_take_prefetch (demux, &prefetch_offset);
+  if (prefetch)
+    gst_buffer_unref (prefetch);
+
+  gst_buffer_replace (&demux->read_ahead, NULL);
+  demux->read_ahead_offset = 0;
+}
+
+/* Serves a pull from the read-ahead block, reading the block around @offset
+ * first if needed. Returns NULL if the range can't be served from a
+ * block, the caller then pulls it directly */
+static GstBuffer *
+gst_mxf_demux_read_ahead (GstMXFDemux * demux, guint64 offset, guint size)
+{
+  guint block_size = demux->read_ahead_size;
+  guint64 block_offset;
+  GstBuffer *block = NULL;
+
+  if (!gst_mxf_demux_block_covers (demux->read_ahead,
+          demux->read_ahead_offset, offset, size)) {
+    gst_buffer_replace (&demux->read_ahead, NULL);
+
+    block_offset = offset - offset % READ_AHEAD_ALIGN;
+    if (offset + size > block_offset + block_size)
+      return NULL;
+
+    /* Sequential reading continues in the prefetched block */
+    block = gst_mxf_demux_take_prefetch (demux, &demux->read_ahead_offset);
+    if (!gst_mxf_demux_block_covers (block, demux->read_ahead_offset, offset,
+            size)) {
+      if (block)
+        gst_buffer_unref (block);
+      block = NULL;
+
+      if (gst_pad_pull_range (demux->sinkpad, block_offset, block_size,
+              &block) != GST_FLOW_OK)
+        return NULL;
+      demux->read_ahead_offset = block_offset;
+
+      /* Short block at the end of the file */
+      if (!gst_mxf_demux_block_covers (block, block_offset, offset, size)) {
+        gst_buffer_unref (block);
+        return NULL;
+      }
+    }
+
+    GST_LOG_OBJECT (demux, "Reading ahead %" G_GSIZE_FORMAT " bytes at offset %"
+        G_GUINT64_FORMAT, gst_buffer_get_size (block),
+        demux->read_ahead_offset);
+    demux->read_ahead = block;
+
+    if (demux->read_ahead_async && gst_buffer_get_size (block) == block_size)
+      gst_mxf_demux_start_prefetch (demux,
+          demux->read_ahead_offset + block_size, block_size);
+  }
+
+  return gst_buffer_copy_region (demux->read_ahead, GST_BUFFER_COPY_ALL,
+      offset - demux->read_ahead_offset, size);
+}
+
 static GstFlowReturn
 gst_mxf_demux_pull_range (GstMXFDemux * demux, guint64 offset,
     guint size, GstBuffer ** buffer)
 {
   GstFlowReturn ret;
 
+  /* Once the index tables are known playback mostly walks the essence
+   * containers, read several edit units at once instead of every key,
+   * length and value on its own */
+  if (demux->read_ahead_size > 0 && demux->index_table_segments_collected) {
+    *buffer = gst_mxf_demux_read_ahead (demux, offset, size);
+    if (*buffer)
+      return GST_FLOW_OK;
+  }
+
   ret = gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_WARNING_OBJECT (demux,
@@ -424,6 +620,8 @@ gst_mxf_demux_handle_partition_pack (GstMXFDemux * demux, const MXFUL * key,
 
   if (partition.type == MXF_PARTITION_PACK_HEADER)
     demux->footer_partition_pack_offset = partition.footer_partition;
+  else if (partition.type == MXF_PARTITION_PACK_FOOTER)
+    demux->growing_finished = TRUE;
 
   for (l = demux->partitions; l; l = l->next) {
     GstMXFDemuxPartition *tmp = l->data;
@@ -519,11 +717,27 @@ gst_mxf_demux_resolve_references (GstMXFDemux * demux)
 
   g_hash_table_iter_init (&iter, demux->metadata);
   while (g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
-    m->resolved = MXF_METADATA_BASE_RESOLVE_STATE_NONE;
+    if (demux->fast_open && MXF_IS_DESCRIPTIVE_METADATA_FRAMEWORK (m))
+      m->resolved = MXF_METADATA_BASE_RESOLVE_STATE_DEFERRED;
+    else
+      m->resolved = MXF_METADATA_BASE_RESOLVE_STATE_NONE;
+  }
+
+  if (demux->fast_open) {
+    /* Only what the preface references is needed for playback, everything
+     * else is resolved in gst_mxf_demux_resolve_deferred() on demand */
+    if (!demux->preface
+        || !mxf_metadata_base_resolve (MXF_METADATA_BASE (demux->preface),
+            demux->metadata)) {
+      ret = GST_FLOW_ERROR;
+      goto error;
+    }
+    demux->metadata_deferred = TRUE;
   }
 
   g_hash_table_iter_init (&iter, demux->metadata);
-  while (g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
+  while (!demux->fast_open
+      && g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
     gboolean resolved;
 
     resolved = mxf_metadata_base_resolve (m, demux->metadata);
@@ -559,6 +773,32 @@ error:
   return ret;
 }
 
+/* Resolves the metadata skipped by fast-open.
+ * call with the metadata lock held for writing */
+static void
+gst_mxf_demux_resolve_deferred (GstMXFDemux * demux)
+{
+  GHashTableIter iter;
+  MXFMetadataBase *m = NULL;
+
+  if (!demux->metadata_deferred)
+    return;
+
+  GST_DEBUG_OBJECT (demux, "Resolve deferred metadata references");
+  demux->metadata_deferred = FALSE;
+
+  g_hash_table_iter_init (&iter, demux->metadata);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
+    if (m->resolved == MXF_METADATA_BASE_RESOLVE_STATE_DEFERRED)
+      m->resolved = MXF_METADATA_BASE_RESOLVE_STATE_NONE;
+  }
+
+  g_hash_table_iter_init (&iter, demux->metadata);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
+    mxf_metadata_base_resolve (m, demux->metadata);
+  }
+}
+
 static MXFMetadataGenericPackage *
 gst_mxf_demux_find_package (GstMXFDemux * demux, const MXFUMID * umid)
 {
@@ -2025,7 +2265,12 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
 
     pad->current_essence_track_position++;
 
-    if (pad->current_component) {
+    if (gst_mxf_demux_is_growing (demux)
+        && pad->current_component_index + 1 >=
+        pad->material_track->parent.sequence->n_structural_components) {
+      /* The last component and the essence track get longer as the file
+       * grows, the end is only known once the footer partition is there */
+    } else if (pad->current_component) {
       if (pad->current_component_duration > 0 &&
           pad->current_essence_track_position - pad->current_component_start
           >= pad->current_component_duration) {
@@ -2072,6 +2317,8 @@ out:
     gst_buffer_unref (outbuf);
 
   etrack->position++;
+  if (demux->growing_file && etrack->position > etrack->duration)
+    etrack->duration = etrack->position;
 
   return ret;
 }
@@ -2368,6 +2615,319 @@ beach:
   return ret;
 }
 
+#define INDEX_CACHE_MAGIC "GSTMXFIC"
+#define INDEX_CACHE_VERSION 1
+
+/* Returns the cache file for the upstream file and the size and
+ * modification time it is only valid for, or NULL if there is none */
+static gchar *
+gst_mxf_demux_index_cache_location (GstMXFDemux * demux, guint64 * size,
+    gint64 * mtime)
+{
+  GstQuery *query;
+  gchar *uri = NULL, *filename, *checksum, *name, *location = NULL;
+  GStatBuf st;
+
+  if (!demux->index_cache_dir)
+    return NULL;
+
+  query = gst_query_new_uri ();
+  if (gst_pad_peer_query (demux->sinkpad, query))
+    gst_query_parse_uri (query, &uri);
+  gst_query_unref (query);
+
+  if (!uri)
+    return NULL;
+
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  if (filename && g_stat (filename, &st) == 0) {
+    *size = st.st_size;
+    *mtime = st.st_mtime;
+
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+    name = g_strconcat (checksum, ".mxfindex", NULL);
+    location = g_build_filename (demux->index_cache_dir, name, NULL);
+    g_free (name);
+    g_free (checksum);
+  }
+
+  g_free (filename);
+  g_free (uri);
+
+  return location;
+}
+
+/* Writes the random index pack, the partition packs and the index tables
+ * after they were collected from a complete file */
+static void
+gst_mxf_demux_save_index_cache (GstMXFDemux * demux)
+{
+  GstByteWriter writer;
+  GError *err = NULL;
+  gchar *location;
+  guint64 size;
+  gint64 mtime;
+  GList *l;
+  guint i, slen;
+  gsize len;
+  guint8 *data;
+
+  if (demux->index_cache_loaded)
+    return;
+
+  location = gst_mxf_demux_index_cache_location (demux, &size, &mtime);
+  if (!location)
+    return;
+
+  gst_byte_writer_init (&writer);
+  gst_byte_writer_put_data (&writer, (const guint8 *) INDEX_CACHE_MAGIC, 8);
+  gst_byte_writer_put_uint32_le (&writer, INDEX_CACHE_VERSION);
+  gst_byte_writer_put_uint64_le (&writer, size);
+  gst_byte_writer_put_int64_le (&writer, mtime);
+  gst_byte_writer_put_uint64_le (&writer, demux->run_in);
+
+  gst_byte_writer_put_uint32_le (&writer, demux->random_index_pack->len);
+  for (i = 0; i < demux->random_index_pack->len; i++) {
+    MXFRandomIndexPackEntry *e =
+        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+
+    gst_byte_writer_put_uint64_le (&writer, e->offset);
+    gst_byte_writer_put_uint32_le (&writer, e->body_sid);
+  }
+
+  gst_byte_writer_put_uint32_le (&writer, g_list_length (demux->partitions));
+  for (l = demux->partitions; l; l = l->next) {
+    GstMXFDemuxPartition *p = l->data;
+    GstBuffer *buf;
+    GstMapInfo map;
+
+    buf = mxf_partition_pack_to_buffer (&p->partition);
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    slen = (map.data[16] & 0x80) ? 1 + (map.data[16] & 0x7f) : 1;
+
+    gst_byte_writer_put_uint64_le (&writer, p->partition.this_partition);
+    gst_byte_writer_put_uint64_le (&writer, p->essence_container_offset);
+    gst_byte_writer_put_data (&writer, map.data, 16);
+    gst_byte_writer_put_uint32_le (&writer, map.size - 16 - slen);
+    gst_byte_writer_put_data (&writer, map.data + 16 + slen,
+        map.size - 16 - slen);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+  }
+
+  gst_byte_writer_put_uint32_le (&writer, g_list_length (demux->index_tables));
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *t = l->data;
+
+    gst_byte_writer_put_uint32_le (&writer, t->body_sid);
+    gst_byte_writer_put_uint32_le (&writer, t->index_sid);
+    gst_byte_writer_put_uint32_le (&writer, t->offsets->len);
+    for (i = 0; i < t->offsets->len; i++) {
+      GstMXFDemuxIndex *idx = &g_array_index (t->offsets, GstMXFDemuxIndex, i);
+
+      gst_byte_writer_put_uint64_le (&writer, idx->offset);
+      gst_byte_writer_put_uint64_le (&writer, idx->pts);
+      gst_byte_writer_put_uint64_le (&writer, idx->dts);
+      gst_byte_writer_put_uint8 (&writer,
+          (idx->keyframe ? 0x01 : 0x00) | (idx->initialized ? 0x02 : 0x00));
+    }
+  }
+
+  len = gst_byte_writer_get_size (&writer);
+  data = gst_byte_writer_reset_and_get_data (&writer);
+
+  g_mkdir_with_parents (demux->index_cache_dir, 0755);
+  if (!g_file_set_contents (location, (const gchar *) data, len, &err)) {
+    GST_WARNING_OBJECT (demux, "Failed to write index cache %s: %s",
+        location, err->message);
+    g_clear_error (&err);
+  } else {
+    GST_DEBUG_OBJECT (demux, "Wrote index cache %s", location);
+  }
+
+  g_free (data);
+  g_free (location);
+}
+
+typedef struct
+{
+  guint64 offset;
+  guint64 essence_container_offset;
+  MXFUL key;
+  GstBuffer *buffer;
+} GstMXFDemuxCachedPartition;
+
+static void
+gst_mxf_demux_cached_partition_free (GstMXFDemuxCachedPartition * p)
+{
+  gst_buffer_unref (p->buffer);
+  g_free (p);
+}
+
+static void
+gst_mxf_demux_index_table_free (GstMXFDemuxIndexTable * t)
+{
+  g_array_free (t->offsets, TRUE);
+  g_free (t);
+}
+
+/* Restores what gst_mxf_demux_save_index_cache() wrote if it is still
+ * valid for the upstream file, instead of pulling the random index pack
+ * and all partition headers */
+static gboolean
+gst_mxf_demux_load_index_cache (GstMXFDemux * demux)
+{
+  GstByteReader reader;
+  gchar *location, *contents = NULL;
+  gsize len;
+  guint64 size, cached_size, run_in;
+  gint64 mtime, cached_mtime;
+  const guint8 *magic;
+  guint32 version, n, i;
+  GArray *rip = NULL;
+  GList *partitions = NULL, *tables = NULL, *l;
+  guint64 old_offset = demux->offset;
+  GstMXFDemuxPartition *old_partition = demux->current_partition;
+
+  location = gst_mxf_demux_index_cache_location (demux, &size, &mtime);
+  if (!location)
+    return FALSE;
+
+  if (!g_file_get_contents (location, &contents, &len, NULL)) {
+    GST_DEBUG_OBJECT (demux, "No index cache %s", location);
+    g_free (location);
+    return FALSE;
+  }
+
+  gst_byte_reader_init (&reader, (const guint8 *) contents, len);
+
+  if (!gst_byte_reader_get_data (&reader, 8, &magic)
+      || memcmp (magic, INDEX_CACHE_MAGIC, 8) != 0
+      || !gst_byte_reader_get_uint32_le (&reader, &version)
+      || version != INDEX_CACHE_VERSION
+      || !gst_byte_reader_get_uint64_le (&reader, &cached_size)
+      || !gst_byte_reader_get_int64_le (&reader, &cached_mtime)
+      || !gst_byte_reader_get_uint64_le (&reader, &run_in))
+    goto invalid;
+
+  if (cached_size != size || cached_mtime != mtime || run_in != demux->run_in) {
+    GST_DEBUG_OBJECT (demux, "Index cache %s is outdated", location);
+    goto invalid;
+  }
+
+  if (!gst_byte_reader_get_uint32_le (&reader, &n)
+      || n > gst_byte_reader_get_remaining (&reader) / 12)
+    goto invalid;
+  rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), n);
+  for (i = 0; i < n; i++) {
+    MXFRandomIndexPackEntry e;
+
+    if (!gst_byte_reader_get_uint64_le (&reader, &e.offset)
+        || !gst_byte_reader_get_uint32_le (&reader, &e.body_sid))
+      goto invalid;
+    g_array_append_val (rip, e);
+  }
+
+  if (!gst_byte_reader_get_uint32_le (&reader, &n))
+    goto invalid;
+  for (i = 0; i < n; i++) {
+    GstMXFDemuxCachedPartition *p;
+    const guint8 *key, *value;
+    guint32 value_size;
+
+    p = g_new0 (GstMXFDemuxCachedPartition, 1);
+    if (!gst_byte_reader_get_uint64_le (&reader, &p->offset)
+        || !gst_byte_reader_get_uint64_le (&reader,
+            &p->essence_container_offset)
+        || !gst_byte_reader_get_data (&reader, 16, &key)
+        || !gst_byte_reader_get_uint32_le (&reader, &value_size)
+        || !gst_byte_reader_get_data (&reader, value_size, &value)
+        || !mxf_is_partition_pack ((const MXFUL *) key)) {
+      g_free (p);
+      goto invalid;
+    }
+    memcpy (&p->key, key, 16);
+    p->buffer = gst_buffer_new_wrapped (g_memdup (value, value_size),
+        value_size);
+    partitions = g_list_append (partitions, p);
+  }
+
+  if (!gst_byte_reader_get_uint32_le (&reader, &n))
+    goto invalid;
+  for (i = 0; i < n; i++) {
+    GstMXFDemuxIndexTable *t;
+    guint32 j, n_offsets;
+
+    t = g_new0 (GstMXFDemuxIndexTable, 1);
+    t->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+    tables = g_list_append (tables, t);
+
+    if (!gst_byte_reader_get_uint32_le (&reader, &t->body_sid)
+        || !gst_byte_reader_get_uint32_le (&reader, &t->index_sid)
+        || !gst_byte_reader_get_uint32_le (&reader, &n_offsets)
+        || n_offsets > gst_byte_reader_get_remaining (&reader) / 25)
+      goto invalid;
+
+    g_array_set_size (t->offsets, n_offsets);
+    for (j = 0; j < n_offsets; j++) {
+      GstMXFDemuxIndex *idx = &g_array_index (t->offsets, GstMXFDemuxIndex, j);
+      guint8 flags;
+
+      gst_byte_reader_get_uint64_le (&reader, &idx->offset);
+      gst_byte_reader_get_uint64_le (&reader, &idx->pts);
+      gst_byte_reader_get_uint64_le (&reader, &idx->dts);
+      gst_byte_reader_get_uint8 (&reader, &flags);
+      idx->keyframe = ! !(flags & 0x01);
+      idx->initialized = ! !(flags & 0x02);
+    }
+  }
+
+  /* Everything is valid, take it over */
+  for (l = partitions; l; l = l->next) {
+    GstMXFDemuxCachedPartition *p = l->data;
+
+    demux->offset = p->offset;
+    if (gst_mxf_demux_handle_partition_pack (demux, &p->key,
+            p->buffer) == GST_FLOW_OK
+        && demux->current_partition->essence_container_offset == 0)
+      demux->current_partition->essence_container_offset =
+          p->essence_container_offset;
+  }
+  demux->offset = old_offset;
+  demux->current_partition = old_partition;
+
+  if (demux->random_index_pack)
+    g_array_free (demux->random_index_pack, TRUE);
+  demux->random_index_pack = rip;
+
+  g_list_free_full (demux->index_tables,
+      (GDestroyNotify) gst_mxf_demux_index_table_free);
+  demux->index_tables = tables;
+  demux->index_table_segments_collected = TRUE;
+  demux->index_cache_loaded = TRUE;
+
+  g_list_free_full (partitions,
+      (GDestroyNotify) gst_mxf_demux_cached_partition_free);
+  g_free (contents);
+
+  GST_DEBUG_OBJECT (demux, "Loaded index cache %s", location);
+  g_free (location);
+
+  return TRUE;
+
+invalid:
+  GST_DEBUG_OBJECT (demux, "Not using index cache %s", location);
+  if (rip)
+    g_array_free (rip, TRUE);
+  g_list_free_full (partitions,
+      (GDestroyNotify) gst_mxf_demux_cached_partition_free);
+  g_list_free_full (tables, (GDestroyNotify) gst_mxf_demux_index_table_free);
+  g_free (contents);
+  g_free (location);
+
+  return FALSE;
+}
+
 static void
 gst_mxf_demux_pull_random_index_pack (GstMXFDemux * demux)
 {
@@ -2992,6 +3552,57 @@ from_index:
   return -1;
 }
 
+/* Extends the essence track durations to what the index tables cover.
+ * Returns TRUE if any of them changed */
+static gboolean
+gst_mxf_demux_update_growing_durations (GstMXFDemux * demux)
+{
+  gboolean changed = FALSE;
+  GList *l;
+  guint i;
+
+  for (i = 0; i < demux->essence_tracks->len; i++) {
+    GstMXFDemuxEssenceTrack *etrack =
+        &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
+
+    for (l = demux->index_tables; l; l = l->next) {
+      GstMXFDemuxIndexTable *t = l->data;
+
+      if (t->body_sid == etrack->body_sid && t->index_sid == etrack->index_sid
+          && t->offsets->len > etrack->duration) {
+        etrack->duration = t->offsets->len;
+        changed = TRUE;
+      }
+    }
+  }
+
+  return changed;
+}
+
+/* Waits until it is time to look for new data at the end of a growing file,
+ * or until woken up by a seek or a state change */
+static void
+gst_mxf_demux_wait_for_growth (GstMXFDemux * demux)
+{
+  gint64 end_time = g_get_monotonic_time () + GROWING_FILE_POLL_INTERVAL;
+
+  g_mutex_lock (&demux->growing_lock);
+  while (!demux->growing_wakeup
+      && g_cond_wait_until (&demux->growing_cond, &demux->growing_lock,
+          end_time));
+  demux->growing_wakeup = FALSE;
+  g_mutex_unlock (&demux->growing_lock);
+}
+
+static void
+gst_mxf_demux_wake_up_growth (GstMXFDemux * demux)
+{
+  g_mutex_lock (&demux->growing_lock);
+  demux->growing_wakeup = TRUE;
+  g_cond_signal (&demux->growing_cond);
+  g_mutex_unlock (&demux->growing_lock);
+}
+
 static GstFlowReturn
 gst_mxf_demux_pull_and_handle_klv_packet (GstMXFDemux * demux)
 {
@@ -3012,6 +3623,21 @@ gst_mxf_demux_pull_and_handle_klv_packet (GstMXFDemux * demux)
       gst_mxf_demux_pull_klv_packet (demux, demux->offset, &key, &buffer,
       &read);
 
+  if (ret == GST_FLOW_EOS && gst_mxf_demux_is_growing (demux)) {
+    /* Pick up the index table segments written since the last time and
+     * try again at the same offset later */
+    gst_mxf_demux_merge_index_table_segments (demux);
+    if (gst_mxf_demux_update_growing_durations (demux))
+      gst_element_post_message (GST_ELEMENT_CAST (demux),
+          gst_message_new_duration_changed (GST_OBJECT_CAST (demux)));
+
+    GST_LOG_OBJECT (demux, "Waiting for more data at offset %"
+        G_GUINT64_FORMAT, demux->offset);
+    gst_mxf_demux_wait_for_growth (demux);
+    ret = GST_FLOW_OK;
+    goto beach;
+  }
+
   if (ret == GST_FLOW_EOS && demux->src->len > 0) {
     guint i;
     GstMXFDemuxPad *p = NULL;
@@ -3172,8 +3798,10 @@ gst_mxf_demux_loop (GstPad * pad)
       goto pause;
     }
 
-    /* First of all pull&parse the random index pack at EOF */
-    gst_mxf_demux_pull_random_index_pack (demux);
+    /* First of all pull&parse the random index pack at EOF, unless the
+     * index cache has everything from a previous open already */
+    if (!gst_mxf_demux_load_index_cache (demux))
+      gst_mxf_demux_pull_random_index_pack (demux);
   }
 
   /* Now actually do something */
@@ -3429,7 +4057,20 @@ gst_mxf_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
     gst_adapter_flush (demux->adapter, offset);
 
     if (length > 0) {
-      buffer = gst_adapter_take_buffer (demux->adapter, length);
+      if (mxf_is_generic_container_essence_element (&key) ||
+          mxf_is_avid_essence_container_essence_element (&key)) {
+        /* Essence elements are passed on as they are, keep the memories of
+         * the input buffers instead of merging them */
+        buffer = gst_adapter_take_buffer_fast (demux->adapter, length);
+      } else {
+        /* Everything else is parsed from a single mapping anyway */
+        if (gst_adapter_available_fast (demux->adapter) < length) {
+          GST_OBJECT_LOCK (demux);
+          demux->copied_bytes += length;
+          GST_OBJECT_UNLOCK (demux);
+        }
+        buffer = gst_adapter_take_buffer (demux->adapter, length);
+      }
 
       ret = gst_mxf_demux_handle_klv_packet (demux, &key, buffer, FALSE);
       gst_buffer_unref (buffer);
@@ -3669,13 +4310,17 @@ no_new_offset:
 static void
 collect_index_table_segments (GstMXFDemux * demux)
 {
-  GList *l;
   guint i;
   guint64 old_offset = demux->offset;
   GstMXFDemuxPartition *old_partition = demux->current_partition;
 
-  if (!demux->random_index_pack)
+  if (!demux->random_index_pack) {
+    /* Files that are still being written don't have one yet, use what
+     * was read so far */
+    if (demux->growing_file)
+      gst_mxf_demux_merge_index_table_segments (demux);
     return;
+  }
 
   for (i = 0; i < demux->random_index_pack->len; i++) {
     MXFRandomIndexPackEntry *e =
@@ -3693,6 +4338,19 @@ collect_index_table_segments (GstMXFDemux * demux)
   demux->offset = old_offset;
   demux->current_partition = old_partition;
 
+  gst_mxf_demux_merge_index_table_segments (demux);
+
+  if (!gst_mxf_demux_is_growing (demux))
+    gst_mxf_demux_save_index_cache (demux);
+}
+
+/* Adds the pending index table segments to the index tables */
+static void
+gst_mxf_demux_merge_index_table_segments (GstMXFDemux * demux)
+{
+  GList *l;
+  guint i;
+
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *segment = l->data;
     GstMXFDemuxIndexTable *t = NULL;
@@ -3860,6 +4518,8 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
     gst_pad_pause_task (demux->sinkpad);
   }
 
+  gst_mxf_demux_wake_up_growth (demux);
+
   /* Take the stream lock */
   GST_PAD_STREAM_LOCK (demux->sinkpad);
 
@@ -4110,6 +4770,21 @@ gst_mxf_demux_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
       }
 
       duration = mxfpad->material_track->parent.sequence->duration;
+      if (demux->growing_file && mxfpad->current_essence_track
+          && mxfpad->current_essence_track->source_track) {
+        GstMXFDemuxEssenceTrack *etrack = mxfpad->current_essence_track;
+        MXFFraction *rate = &etrack->source_track->edit_rate;
+        gint64 grown;
+
+        /* The metadata of a growing file lags behind the essence */
+        if (rate->n != 0 && rate->d != 0) {
+          grown = gst_util_uint64_scale (etrack->duration,
+              mxfpad->material_track->edit_rate.n * rate->d,
+              mxfpad->material_track->edit_rate.d * rate->n);
+          if (grown > duration)
+            duration = grown;
+        }
+      }
       if (duration <= -1)
         duration = -1;
 
@@ -4519,6 +5194,9 @@ gst_mxf_demux_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       demux->seqnum = gst_util_seqnum_next ();
       break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_mxf_demux_wake_up_growth (demux);
+      break;
     default:
       break;
   }
@@ -4552,6 +5230,22 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_READ_AHEAD_SIZE:
+      demux->read_ahead_size = g_value_get_uint (value);
+      break;
+    case PROP_READ_AHEAD_ASYNC:
+      demux->read_ahead_async = g_value_get_boolean (value);
+      break;
+    case PROP_FAST_OPEN:
+      demux->fast_open = g_value_get_boolean (value);
+      break;
+    case PROP_GROWING_FILE:
+      demux->growing_file = g_value_get_boolean (value);
+      break;
+    case PROP_INDEX_CACHE_DIR:
+      g_free (demux->index_cache_dir);
+      demux->index_cache_dir = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4571,10 +5265,37 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       g_value_set_uint64 (value, demux->max_drift);
       break;
+    case PROP_READ_AHEAD_SIZE:
+      g_value_set_uint (value, demux->read_ahead_size);
+      break;
+    case PROP_READ_AHEAD_ASYNC:
+      g_value_set_boolean (value, demux->read_ahead_async);
+      break;
+    case PROP_FAST_OPEN:
+      g_value_set_boolean (value, demux->fast_open);
+      break;
+    case PROP_GROWING_FILE:
+      g_value_set_boolean (value, demux->growing_file);
+      break;
+    case PROP_INDEX_CACHE_DIR:
+      g_value_set_string (value, demux->index_cache_dir);
+      break;
+    case PROP_STATS:{
+      GstStructure *s;
+
+      GST_OBJECT_LOCK (demux);
+      s = gst_structure_new ("mxfdemux-stats",
+          "copied-bytes", G_TYPE_UINT64, demux->copied_bytes, NULL);
+      GST_OBJECT_UNLOCK (demux);
+
+      g_value_take_boxed (value, s);
+      break;
+    }
     case PROP_STRUCTURE:{
       GstStructure *s;
 
-      g_rw_lock_reader_lock (&demux->metadata_lock);
+      g_rw_lock_writer_lock (&demux->metadata_lock);
+      gst_mxf_demux_resolve_deferred (demux);
       if (demux->preface &&
           MXF_METADATA_BASE (demux->preface)->resolved ==
           MXF_METADATA_BASE_RESOLVE_STATE_SUCCESS)
@@ -4587,7 +5308,7 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
       if (s)
         gst_structure_free (s);
 
-      g_rw_lock_reader_unlock (&demux->metadata_lock);
+      g_rw_lock_writer_unlock (&demux->metadata_lock);
       break;
     }
     default:
@@ -4603,6 +5324,15 @@ gst_mxf_demux_finalize (GObject * object)
 
   gst_mxf_demux_reset (demux);
 
+  if (demux->prefetch_pool) {
+    g_thread_pool_free (demux->prefetch_pool, FALSE, TRUE);
+    demux->prefetch_pool = NULL;
+  }
+  g_mutex_clear (&demux->prefetch_lock);
+  g_cond_clear (&demux->prefetch_cond);
+  g_mutex_clear (&demux->growing_lock);
+  g_cond_clear (&demux->growing_cond);
+
   if (demux->adapter) {
     g_object_unref (demux->adapter);
     demux->adapter = NULL;
@@ -4622,6 +5352,8 @@ gst_mxf_demux_finalize (GObject * object)
   demux->current_package_string = NULL;
   g_free (demux->requested_package_string);
   demux->requested_package_string = NULL;
+  g_free (demux->index_cache_dir);
+  demux->index_cache_dir = NULL;
 
   g_ptr_array_free (demux->src, TRUE);
   demux->src = NULL;
@@ -4665,6 +5397,47 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD_SIZE,
+      g_param_spec_uint ("read-ahead-size", "Read-ahead size",
+          "In pull mode, once the index tables are known, read blocks of this "
+          "many bytes and demux them from memory (0 = read every KLV packet "
+          "on its own). Should cover several edit units",
+          0, G_MAXINT, DEFAULT_READ_AHEAD_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD_ASYNC,
+      g_param_spec_boolean ("read-ahead-async", "Asynchronous read-ahead",
+          "Read the next read-ahead block in a separate thread while the "
+          "current one is demuxed", DEFAULT_READ_AHEAD_ASYNC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Demuxer statistics: \"copied-bytes\" is the number of bytes of "
+          "KLV values that had to be merged from several input buffers in "
+          "push mode", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FAST_OPEN,
+      g_param_spec_boolean ("fast-open", "Fast open",
+          "Only resolve the metadata needed for playback when opening, "
+          "descriptive and unreferenced metadata is resolved when the "
+          "structure is queried", DEFAULT_FAST_OPEN,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GROWING_FILE,
+      g_param_spec_boolean ("growing-file", "Growing file",
+          "In pull mode, wait for more data at the end of the file until a "
+          "footer partition was read, for files that are still being written",
+          DEFAULT_GROWING_FILE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INDEX_CACHE_DIR,
+      g_param_spec_string ("index-cache-dir", "Index cache directory",
+          "Directory where the partitions and index tables of local files are "
+          "cached, so that opening the same unchanged file again does not "
+          "need to read them from all over the file (NULL = disabled)",
+          DEFAULT_INDEX_CACHE_DIR, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
@@ -4696,6 +5469,16 @@ gst_mxf_demux_init (GstMXFDemux * demux)
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 
   demux->max_drift = 500 * GST_MSECOND;
+  demux->read_ahead_size = DEFAULT_READ_AHEAD_SIZE;
+  demux->read_ahead_async = DEFAULT_READ_AHEAD_ASYNC;
+  demux->fast_open = DEFAULT_FAST_OPEN;
+  demux->growing_file = DEFAULT_GROWING_FILE;
+  demux->index_cache_dir = g_strdup (DEFAULT_INDEX_CACHE_DIR);
+
+  g_mutex_init (&demux->prefetch_lock);
+  g_cond_init (&demux->prefetch_cond);
+  g_mutex_init (&demux->growing_lock);
+  g_cond_init (&demux->growing_cond);
 
   demux->adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
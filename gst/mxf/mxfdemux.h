@@ -187,15 +187,41 @@ struct _GstMXFDemux
   GList *pending_index_table_segments;
   GList *index_tables; /* one per BodySID / IndexSID */
   gboolean index_table_segments_collected;
+  /* the above came from the index cache */
+  gboolean index_cache_loaded;
 
   GArray *random_index_pack;
 
+  /* Read-ahead in pull mode once the index tables are collected, the
+   * streaming thread serves small pulls from read_ahead */
+  GstBuffer *read_ahead;
+  guint64 read_ahead_offset;
+
+  /* Asynchronous read of the block after read_ahead, protected by
+   * prefetch_lock */
+  GThreadPool *prefetch_pool;
+  GMutex prefetch_lock;
+  GCond prefetch_cond;
+  gboolean prefetch_pending;
+  GstBuffer *prefetch;
+  guint64 prefetch_offset;
+  guint prefetch_size;
+
   /* Metadata */
   GRWLock metadata_lock;
   gboolean update_metadata;
   gboolean pull_footer_metadata;
 
   gboolean metadata_resolved;
+  /* fast-open left parts of the metadata unresolved */
+  gboolean metadata_deferred;
+
+  /* Growing file state: a footer partition was read, or the end of the
+   * file is waited for and can be woken up */
+  gboolean growing_finished;
+  GMutex growing_lock;
+  GCond growing_cond;
+  gboolean growing_wakeup;
   MXFMetadataPreface *preface;
   GHashTable *metadata;
 
@@ -205,9 +231,17 @@ struct _GstMXFDemux
 
   GstTagList *tags;
 
+  /* Statistics, protected by the object lock */
+  guint64 copied_bytes;
+
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  guint read_ahead_size;
+  gboolean read_ahead_async;
+  gboolean fast_open;
+  gboolean growing_file;
+  gchar *index_cache_dir;
 };
 
 struct _GstMXFDemuxClass
@@ -3788,7 +3788,10 @@ mxf_metadata_dm_segment_resolve (MXFMetadataBase * m, GHashTable * metadata)
 
   current = g_hash_table_lookup (metadata, &self->dm_framework_uid);
   if (current && MXF_IS_DESCRIPTIVE_METADATA_FRAMEWORK (current)) {
-    if (mxf_metadata_base_resolve (current, metadata)) {
+    if (current->resolved == MXF_METADATA_BASE_RESOLVE_STATE_DEFERRED) {
+      /* Resolved later by whoever deferred it */
+      self->dm_framework = MXF_DESCRIPTIVE_METADATA_FRAMEWORK (current);
+    } else if (mxf_metadata_base_resolve (current, metadata)) {
       self->dm_framework = MXF_DESCRIPTIVE_METADATA_FRAMEWORK (current);
     } else {
       GST_ERROR ("Couldn't resolve DM framework %s",
@@ -375,7 +375,9 @@ typedef enum {
   MXF_METADATA_BASE_RESOLVE_STATE_NONE = 0,
   MXF_METADATA_BASE_RESOLVE_STATE_SUCCESS,
   MXF_METADATA_BASE_RESOLVE_STATE_FAILURE,
-  MXF_METADATA_BASE_RESOLVE_STATE_RUNNING
+  MXF_METADATA_BASE_RESOLVE_STATE_RUNNING,
+  /* Not resolved on purpose, only referencing objects may point to it */
+  MXF_METADATA_BASE_RESOLVE_STATE_DEFERRED
 } MXFMetadataBaseResolveState;
 
 struct _MXFMetadataBase {
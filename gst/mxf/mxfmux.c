@@ -114,13 +114,29 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_KAG_SIZE,
+  PROP_PARTITION_INTERVAL,
+  PROP_HEADER_RESERVE
 };
 
+#define DEFAULT_KAG_SIZE 1
+#define DEFAULT_PARTITION_INTERVAL 0
+#define DEFAULT_HEADER_RESERVE 0
+
+/* smallest possible fill KLV: key and a 1 byte length */
+#define MIN_FILL_SIZE 17
+
+#define MAX_INDEX_SEGMENT_ENTRIES (G_MAXUINT16 / 11)
+
 #define gst_mxf_mux_parent_class parent_class
 G_DEFINE_TYPE (GstMXFMux, gst_mxf_mux, GST_TYPE_AGGREGATOR);
 
 static void gst_mxf_mux_finalize (GObject * object);
+static void gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_mxf_mux_aggregate (GstAggregator * aggregator,
     gboolean timeout);
@@ -134,6 +150,22 @@ static GstAggregatorPad *gst_mxf_mux_create_new_pad (GstAggregator * aggregator,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 
 static void gst_mxf_mux_reset (GstMXFMux * mux);
+static GstFlowReturn gst_mxf_mux_write_body_partition (GstMXFMux * mux);
+
+static GstFlowReturn
+gst_mxf_mux_push_content_package (GstMXFMux * mux)
+{
+  GstBufferList *list = mux->content_package;
+
+  if (!list)
+    return GST_FLOW_OK;
+
+  mux->content_package = NULL;
+
+  /* The header partition went through gst_aggregator_finish_buffer()
+   * already, so caps and segment are out */
+  return gst_pad_push_list (GST_AGGREGATOR_SRC_PAD (mux), list);
+}
 
 static GstFlowReturn
 gst_mxf_mux_push (GstMXFMux * mux, GstBuffer * buf)
@@ -141,12 +173,82 @@ gst_mxf_mux_push (GstMXFMux * mux, GstBuffer * buf)
   guint size = gst_buffer_get_size (buf);
   GstFlowReturn ret;
 
+  if ((ret = gst_mxf_mux_push_content_package (mux)) != GST_FLOW_OK) {
+    gst_buffer_unref (buf);
+    return ret;
+  }
+
   ret = gst_aggregator_finish_buffer (GST_AGGREGATOR (mux), buf);
   mux->offset += size;
 
   return ret;
 }
 
+/* Adds @buf to the current content package, which is pushed as a single
+ * buffer list once the next one starts or anything else is written */
+static void
+gst_mxf_mux_queue (GstMXFMux * mux, GstBuffer * buf)
+{
+  if (!mux->content_package)
+    mux->content_package = gst_buffer_list_new ();
+
+  mux->offset += gst_buffer_get_size (buf);
+  gst_buffer_list_add (mux->content_package, buf);
+}
+
+/* Returns the size of the fill needed after @size bytes of a partition so
+ * that the next KLV starts on the KAG */
+static guint64
+gst_mxf_mux_kag_fill_size (GstMXFMux * mux, guint64 size)
+{
+  guint64 fill;
+
+  if (mux->kag_size <= 1)
+    return 0;
+
+  fill = (mux->kag_size - size % mux->kag_size) % mux->kag_size;
+  while (fill > 0 && fill < MIN_FILL_SIZE)
+    fill += mux->kag_size;
+
+  return fill;
+}
+
+/* Creates a fill KLV of exactly @size bytes, at least MIN_FILL_SIZE */
+static GstBuffer *
+gst_mxf_mux_fill_buffer (guint64 size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = gst_buffer_new_and_alloc (size);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, size);
+  memcpy (map.data, MXF_UL (FILL), 16);
+  /* Use a 4 byte length where it fits, so any size can be filled */
+  if (size >= 20) {
+    map.data[16] = 0x83;
+    GST_WRITE_UINT24_BE (map.data + 17, size - 20);
+  } else {
+    map.data[16] = size - 17;
+  }
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+/* Pushes a fill KLV of exactly @size bytes, @size must be 0 or at least
+ * MIN_FILL_SIZE */
+static GstFlowReturn
+gst_mxf_mux_push_fill (GstMXFMux * mux, guint64 size)
+{
+  if (size == 0)
+    return GST_FLOW_OK;
+
+  g_return_val_if_fail (size >= MIN_FILL_SIZE, GST_FLOW_ERROR);
+
+  return gst_mxf_mux_push (mux, gst_mxf_mux_fill_buffer (size));
+}
+
 static void
 gst_mxf_mux_class_init (GstMXFMuxClass * klass)
 {
@@ -162,6 +264,30 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gstaggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_mxf_mux_finalize;
+  gobject_class->set_property = gst_mxf_mux_set_property;
+  gobject_class->get_property = gst_mxf_mux_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_KAG_SIZE,
+      g_param_spec_uint ("kag-size", "KAG size",
+          "KLV Alignment Grid, partitions, header metadata, index tables and "
+          "essence elements start at multiples of this many bytes",
+          1, G_MAXINT32, DEFAULT_KAG_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PARTITION_INTERVAL,
+      g_param_spec_uint64 ("partition-interval", "Partition interval",
+          "Start a new body partition with an index table segment for the "
+          "previous one at the first keyframe after this much time "
+          "(0 = a single body partition)", 0, G_MAXUINT64,
+          DEFAULT_PARTITION_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HEADER_RESERVE,
+      g_param_spec_uint ("header-reserve", "Header reserve",
+          "Bytes of fill reserved after the header metadata, so the header "
+          "can be rewritten in place even if the metadata grows",
+          0, G_MAXINT32, DEFAULT_HEADER_RESERVE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstaggregator_class->create_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_create_new_pad);
@@ -190,9 +316,60 @@ static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
   mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->body_partitions =
+      g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+
+  mux->kag_size = DEFAULT_KAG_SIZE;
+  mux->partition_interval = DEFAULT_PARTITION_INTERVAL;
+  mux->header_reserve = DEFAULT_HEADER_RESERVE;
+
   gst_mxf_mux_reset (mux);
 }
 
+static void
+gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_KAG_SIZE:
+      mux->kag_size = g_value_get_uint (value);
+      break;
+    case PROP_PARTITION_INTERVAL:
+      mux->partition_interval = g_value_get_uint64 (value);
+      break;
+    case PROP_HEADER_RESERVE:
+      mux->header_reserve = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_KAG_SIZE:
+      g_value_set_uint (value, mux->kag_size);
+      break;
+    case PROP_PARTITION_INTERVAL:
+      g_value_set_uint64 (value, mux->partition_interval);
+      break;
+    case PROP_HEADER_RESERVE:
+      g_value_set_uint (value, mux->header_reserve);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_mxf_mux_finalize (GObject * object)
 {
@@ -216,6 +393,11 @@ gst_mxf_mux_finalize (GObject * object)
     mux->index_table = NULL;
   }
 
+  if (mux->body_partitions) {
+    g_array_free (mux->body_partitions, TRUE);
+    mux->body_partitions = NULL;
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -267,6 +449,17 @@ gst_mxf_mux_reset (GstMXFMux * mux)
   g_array_set_size (mux->index_table, 0);
   mux->current_index_pos = 0;
   mux->last_keyframe_pos = 0;
+
+  if (mux->content_package) {
+    gst_buffer_list_unref (mux->content_package);
+    mux->content_package = NULL;
+  }
+
+  mux->header_byte_count = 0;
+  if (mux->body_partitions)
+    g_array_set_size (mux->body_partitions, 0);
+  mux->last_indexed_pos = 0;
+  mux->next_partition_time = mux->partition_interval;
 }
 
 static gboolean
@@ -1107,7 +1300,7 @@ gst_mxf_mux_init_partition_pack (GstMXFMux * mux)
   mux->partition.closed = mux->partition.complete = FALSE;
   mux->partition.major_version = 0x0001;
   mux->partition.minor_version = 0x0002;
-  mux->partition.kag_size = 1;
+  mux->partition.kag_size = mux->kag_size;
   mux->partition.this_partition = 0;
   mux->partition.prev_partition = 0;
   mux->partition.footer_partition = 0;
@@ -1151,31 +1344,68 @@ gst_mxf_mux_init_partition_pack (GstMXFMux * mux)
   return GST_FLOW_OK;
 }
 
+/* Writes the partition pack and a copy of the header metadata. If
+ * @header_byte_count is 0 the metadata is followed by @reserve bytes of
+ * fill and the resulting size is stored there, otherwise the metadata is
+ * filled up to exactly that size */
 static GstFlowReturn
-gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
+gst_mxf_mux_write_header_metadata (GstMXFMux * mux, guint reserve,
+    guint64 * header_byte_count)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   GstBuffer *buf;
   GList *buffers = NULL;
   GList *l;
   MXFMetadataBase *m;
-  guint64 header_byte_count = 0;
+  guint64 metadata_size = 0;
+  guint64 pack_size, pack_fill, fill;
 
   for (l = mux->metadata_list; l; l = l->next) {
     m = l->data;
     buf = mxf_metadata_base_to_buffer (m, &mux->primer);
-    header_byte_count += gst_buffer_get_size (buf);
+    metadata_size += gst_buffer_get_size (buf);
     buffers = g_list_prepend (buffers, buf);
   }
 
   buffers = g_list_reverse (buffers);
   buf = mxf_primer_pack_to_buffer (&mux->primer);
-  header_byte_count += gst_buffer_get_size (buf);
+  metadata_size += gst_buffer_get_size (buf);
   buffers = g_list_prepend (buffers, buf);
 
-  mux->partition.header_byte_count = header_byte_count;
+  /* The size of the partition pack doesn't depend on its values */
   buf = mxf_partition_pack_to_buffer (&mux->partition);
-  if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+  pack_size = gst_buffer_get_size (buf);
+  gst_buffer_unref (buf);
+  pack_fill = gst_mxf_mux_kag_fill_size (mux, pack_size);
+
+  if (*header_byte_count == 0) {
+    fill = reserve;
+    if (fill > 0 && fill < MIN_FILL_SIZE)
+      fill = MIN_FILL_SIZE;
+    if (fill > 0 && mux->kag_size > 1)
+      fill += (mux->kag_size - (pack_size + pack_fill + metadata_size +
+              fill) % mux->kag_size) % mux->kag_size;
+    else if (fill == 0)
+      fill = gst_mxf_mux_kag_fill_size (mux, pack_size + pack_fill +
+          metadata_size);
+    *header_byte_count = metadata_size + fill;
+  } else if (*header_byte_count < metadata_size
+      || (*header_byte_count > metadata_size
+          && *header_byte_count - metadata_size < MIN_FILL_SIZE)) {
+    GST_ERROR_OBJECT (mux, "Header metadata of %" G_GUINT64_FORMAT
+        " bytes doesn't fit into %" G_GUINT64_FORMAT " bytes", metadata_size,
+        *header_byte_count);
+    g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+    g_list_free (buffers);
+    return GST_FLOW_ERROR;
+  } else {
+    fill = *header_byte_count - metadata_size;
+  }
+
+  mux->partition.header_byte_count = *header_byte_count;
+  buf = mxf_partition_pack_to_buffer (&mux->partition);
+  if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK ||
+      (ret = gst_mxf_mux_push_fill (mux, pack_fill)) != GST_FLOW_OK) {
     GST_ERROR_OBJECT (mux, "Failed pushing partition: %s",
         gst_flow_get_name (ret));
     g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
@@ -1197,9 +1427,56 @@ gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
 
   g_list_free (buffers);
 
+  if ((ret = gst_mxf_mux_push_fill (mux, fill)) != GST_FLOW_OK)
+    GST_ERROR_OBJECT (mux, "Failed pushing fill: %s", gst_flow_get_name (ret));
+
   return ret;
 }
 
+/* Creates index table segments for the edit units from the last body
+ * partition index up to @end. They repeat entries of the complete index
+ * table, which is written to the footer */
+static GList *
+gst_mxf_mux_index_table_since_last (GstMXFMux * mux, guint64 end,
+    guint64 * size)
+{
+  GList *buffers = NULL;
+  guint64 pos = mux->last_indexed_pos;
+
+  while (pos < end) {
+    guint segment_index = pos / MAX_INDEX_SEGMENT_ENTRIES;
+    guint entry = pos % MAX_INDEX_SEGMENT_ENTRIES;
+    MXFIndexTableSegment *segment, s;
+    GstBuffer *buf;
+    guint n;
+
+    if (segment_index >= mux->index_table->len)
+      break;
+    segment =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, segment_index);
+    if (entry >= segment->n_index_entries)
+      break;
+
+    n = MIN (end - pos, segment->n_index_entries - entry);
+
+    s = *segment;
+    mxf_uuid_init (&s.instance_id, mux->metadata);
+    s.index_start_position = pos;
+    s.index_duration = n;
+    s.n_index_entries = n;
+    s.index_entries = segment->index_entries + entry;
+
+    buf = mxf_index_table_segment_to_buffer (&s);
+    *size += gst_buffer_get_size (buf);
+    buffers = g_list_prepend (buffers, buf);
+    pos += n;
+  }
+
+  mux->last_indexed_pos = pos;
+
+  return g_list_reverse (buffers);
+}
+
 static const guint8 _gc_essence_element_ul[] = {
   0x06, 0x0e, 0x2b, 0x34, 0x01, 0x02, 0x01, 0x01,
   0x0d, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00
@@ -1212,6 +1489,7 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   GstBuffer *outbuf = NULL;
   GstMapInfo map;
   gsize buf_size;
+  guint64 fill;
   GstFlowReturn ret = GST_FLOW_OK;
   guint8 slen, ber[9];
   gboolean flush = gst_aggregator_pad_is_eos (GST_AGGREGATOR_PAD (pad))
@@ -1265,10 +1543,32 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   if (buf == NULL)
     return ret;
 
+  /* Content packages start with the first essence stream */
+  if (pad == (GstMXFMuxPad *) GST_ELEMENT_CAST (mux)->sinkpads->data
+      && (ret = gst_mxf_mux_push_content_package (mux)) != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (mux, "Failed pushing content package, reason %s",
+        gst_flow_get_name (ret));
+    gst_buffer_unref (buf);
+    return ret;
+  }
+
+  /* New body partitions are started right before keyframes of the first
+   * essence stream */
+  if (pad == (GstMXFMuxPad *) GST_ELEMENT_CAST (mux)->sinkpads->data
+      && mux->partition_interval > 0 && is_keyframe
+      && pad->last_timestamp >= mux->next_partition_time) {
+    if ((ret = gst_mxf_mux_write_body_partition (mux)) != GST_FLOW_OK) {
+      GST_ERROR_OBJECT (mux, "Failed writing body partition");
+      gst_buffer_unref (buf);
+      return ret;
+    }
+    mux->next_partition_time = pad->last_timestamp + mux->partition_interval;
+  }
+
   /* We currently only index the first essence stream */
   if (pad == (GstMXFMuxPad *) GST_ELEMENT_CAST (mux)->sinkpads->data) {
     MXFIndexTableSegment *segment;
-    const gint max_segment_size = G_MAXUINT16 / 11;
+    const gint max_segment_size = MAX_INDEX_SEGMENT_ENTRIES;
 
     if (mux->index_table->len == 0 ||
         g_array_index (mux->index_table, MXFIndexTableSegment,
@@ -1280,7 +1580,7 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
       if (mux->index_table->len <= mux->current_index_pos) {
         MXFIndexTableSegment s;
 
-        memset (&segment, 0, sizeof (segment));
+        memset (&s, 0, sizeof (s));
 
         mxf_uuid_init (&s.instance_id, mux->metadata);
         memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
@@ -1288,7 +1588,8 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
         if (mux->index_table->len > 0)
           s.index_start_position =
               g_array_index (mux->index_table, MXFIndexTableSegment,
-              mux->index_table->len - 1).index_start_position;
+              mux->index_table->len - 1).index_start_position +
+              max_segment_size;
         else
           s.index_start_position = 0;
         s.index_duration = 0;
@@ -1335,7 +1636,7 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
           if (pts_index_pos >= mux->index_table->len) {
             MXFIndexTableSegment s;
 
-            memset (&segment, 0, sizeof (segment));
+            memset (&s, 0, sizeof (s));
 
             mxf_uuid_init (&s.instance_id, mux->metadata);
             memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
@@ -1343,7 +1644,8 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
             if (mux->index_table->len > 0)
               s.index_start_position =
                   g_array_index (mux->index_table, MXFIndexTableSegment,
-                  mux->index_table->len - 1).index_start_position;
+                  mux->index_table->len - 1).index_start_position +
+                  max_segment_size;
             else
               s.index_start_position = 0;
             s.index_duration = 0;
@@ -1409,15 +1711,17 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   outbuf = gst_buffer_append (outbuf, buf);
 
   GST_DEBUG_OBJECT (pad,
-      "Pushing buffer of size %" G_GSIZE_FORMAT " for track %u",
+      "Queueing buffer of size %" G_GSIZE_FORMAT " for track %u",
       gst_buffer_get_size (outbuf), pad->source_track->parent.track_id);
 
   mux->partition.body_offset += gst_buffer_get_size (outbuf);
-  if ((ret = gst_mxf_mux_push (mux, outbuf)) != GST_FLOW_OK) {
-    GST_ERROR_OBJECT (pad,
-        "Failed pushing buffer for track %u, reason %s",
-        pad->source_track->parent.track_id, gst_flow_get_name (ret));
-    return ret;
+  gst_mxf_mux_queue (mux, outbuf);
+
+  fill = gst_mxf_mux_kag_fill_size (mux,
+      mux->offset - mux->partition.this_partition);
+  if (fill > 0) {
+    mux->partition.body_offset += fill;
+    gst_mxf_mux_queue (mux, gst_mxf_mux_fill_buffer (fill));
   }
 
   pad->pos++;
@@ -1431,23 +1735,68 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
 static GstFlowReturn
 gst_mxf_mux_write_body_partition (GstMXFMux * mux)
 {
+  GstMXFMuxPad *pad = GST_ELEMENT_CAST (mux)->sinkpads->data;
+  guint64 prev_partition = mux->partition.this_partition;
+  guint64 index_byte_count = 0;
+  guint64 pack_fill;
+  MXFRandomIndexPackEntry entry;
+  GList *index, *l;
   GstBuffer *buf;
+  GstFlowReturn ret;
+
+  /* Index everything written since the previous body partition */
+  index = gst_mxf_mux_index_table_since_last (mux, pad->pos, &index_byte_count);
 
   mux->partition.type = MXF_PARTITION_PACK_BODY;
   mux->partition.closed = TRUE;
   mux->partition.complete = TRUE;
   mux->partition.this_partition = mux->offset;
-  mux->partition.prev_partition = 0;
+  mux->partition.prev_partition = prev_partition;
   mux->partition.footer_partition = 0;
   mux->partition.header_byte_count = 0;
   mux->partition.index_byte_count = 0;
   mux->partition.index_sid = 0;
-  mux->partition.body_offset = 0;
+  /* body_offset keeps counting the bytes of the essence container */
   mux->partition.body_sid =
       mux->preface->content_storage->essence_container_data[0]->body_sid;
 
+  if (index) {
+    index_byte_count += gst_mxf_mux_kag_fill_size (mux, index_byte_count);
+    mux->partition.index_byte_count = index_byte_count;
+    mux->partition.index_sid =
+        mux->preface->content_storage->essence_container_data[0]->index_sid;
+  }
+
   buf = mxf_partition_pack_to_buffer (&mux->partition);
-  return gst_mxf_mux_push (mux, buf);
+  pack_fill = gst_mxf_mux_kag_fill_size (mux, gst_buffer_get_size (buf));
+
+  entry.offset = mux->partition.this_partition;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->body_partitions, entry);
+
+  if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK ||
+      (ret = gst_mxf_mux_push_fill (mux, pack_fill)) != GST_FLOW_OK)
+    goto out;
+
+  for (l = index; l; l = l->next) {
+    buf = l->data;
+    l->data = NULL;
+    index_byte_count -= gst_buffer_get_size (buf);
+    if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK)
+      goto out;
+  }
+
+  /* What is left of the index byte count is the fill up to the KAG */
+  ret = gst_mxf_mux_push_fill (mux, index_byte_count);
+
+out:
+  for (l = index; l; l = l->next) {
+    if (l->data)
+      gst_buffer_unref (l->data);
+  }
+  g_list_free (index);
+
+  return ret;
 }
 
 static GstFlowReturn
@@ -1565,8 +1914,12 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
 
   {
     guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
+    guint64 first_body_partition =
+        g_array_index (mux->body_partitions, MXFRandomIndexPackEntry,
+        0).offset;
     guint64 footer_partition = mux->offset;
+    guint64 footer_header_byte_count = 0;
+    guint64 index_fill;
     GArray *rip;
     GstFlowReturn ret;
     GstSegment segment;
@@ -1585,6 +1938,10 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
       index_entries = g_list_prepend (index_entries, segment_buffer);
     }
 
+    /* The header metadata ends on the KAG, so does the index then */
+    index_fill = gst_mxf_mux_kag_fill_size (mux, index_byte_count);
+    index_byte_count += index_fill;
+
     mux->partition.type = MXF_PARTITION_PACK_FOOTER;
     mux->partition.closed = TRUE;
     mux->partition.complete = TRUE;
@@ -1598,7 +1955,7 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     mux->partition.body_offset = 0;
     mux->partition.body_sid = 0;
 
-    gst_mxf_mux_write_header_metadata (mux);
+    gst_mxf_mux_write_header_metadata (mux, 0, &footer_header_byte_count);
 
     index_entries = g_list_reverse (index_entries);
     for (l = index_entries; l; l = l->next) {
@@ -1607,14 +1964,16 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
       }
     }
     g_list_free (index_entries);
+    if ((ret = gst_mxf_mux_push_fill (mux, index_fill)) != GST_FLOW_OK)
+      GST_ERROR_OBJECT (mux, "Failed pushing index fill");
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
+    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry),
+        mux->body_partitions->len + 2);
     entry.offset = 0;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
+    g_array_append_vals (rip, mux->body_partitions->data,
+        mux->body_partitions->len);
     entry.offset = footer_partition;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
@@ -1642,13 +2001,15 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
       mux->partition.body_offset = 0;
       mux->partition.body_sid = 0;
 
-      ret = gst_mxf_mux_write_header_metadata (mux);
+      /* In place, into the space taken by the initial header metadata */
+      ret = gst_mxf_mux_write_header_metadata (mux, 0,
+          &mux->header_byte_count);
       if (ret != GST_FLOW_OK) {
         GST_ERROR_OBJECT (mux, "Rewriting header partition failed");
         return ret;
       }
 
-      g_assert (mux->offset == body_partition);
+      g_assert (mux->offset == first_body_partition);
 
       mux->partition.type = MXF_PARTITION_PACK_BODY;
       mux->partition.closed = TRUE;
@@ -1748,7 +2109,9 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     if ((ret = gst_mxf_mux_init_partition_pack (mux)) != GST_FLOW_OK)
       goto error;
 
-    if ((ret = gst_mxf_mux_write_header_metadata (mux)) != GST_FLOW_OK)
+    if ((ret =
+            gst_mxf_mux_write_header_metadata (mux, mux->header_reserve,
+                &mux->header_byte_count)) != GST_FLOW_OK)
       goto error;
 
     /* Sort pads, we will always write in that order */
@@ -1761,6 +2124,7 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     ret = gst_mxf_mux_write_body_partition (mux);
     if (ret != GST_FLOW_OK)
       goto error;
+    mux->next_partition_time = mux->partition_interval;
     mux->state = GST_MXF_MUX_STATE_DATA;
   }
 
@@ -72,6 +72,22 @@ typedef struct _GstMXFMux {
   GArray *index_table;
   guint current_index_pos;
   guint64 last_keyframe_pos;
+
+  /* Header metadata size including the reserved fill, fixed once the
+   * header was written so it can be rewritten in place */
+  guint64 header_byte_count;
+  /* RIP entries of the body partitions written so far */
+  GArray *body_partitions;
+  /* first edit unit not written to a body partition index yet */
+  guint64 last_indexed_pos;
+  GstClockTime next_partition_time;
+  /* essence elements of the current edit unit, not pushed yet */
+  GstBufferList *content_package;
+
+  /* Properties */
+  guint kag_size;
+  GstClockTime partition_interval;
+  guint header_reserve;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
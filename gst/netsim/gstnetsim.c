@@ -42,18 +42,27 @@ enum
   ARG_DELAY_PROBABILITY,
   ARG_DROP_PROBABILITY,
   ARG_DUPLICATE_PROBABILITY,
-  ARG_DROP_PACKETS
+  ARG_DROP_PACKETS,
+  ARG_MAX_KBPS,
+  ARG_MAX_BUCKET_SIZE,
+  ARG_MAX_QUEUE_SIZE,
+  ARG_SEED
 };
 
 struct _GstNetSimPrivate
 {
   GstPad *sinkpad, *srcpad;
 
-  GMutex loop_mutex;
-  GCond start_cond;
-  GMainLoop *main_loop;
+  /* buffers waiting to be pushed, sorted by push time */
+  GMutex lock;
+  GCond cond;
+  GQueue queue;
   gboolean running;
 
+  /* token bucket state, in bits */
+  gint64 bucket_time;
+  gint64 tokens;
+
   GRand *rand_seed;
   gint min_delay;
   gint max_delay;
@@ -61,6 +70,10 @@ struct _GstNetSimPrivate
   gfloat drop_probability;
   gfloat duplicate_probability;
   guint drop_packets;
+  gint max_kbps;
+  gint max_bucket_size;
+  gint max_queue_size;
+  guint seed;
 };
 
 /* these numbers are nothing but wild guesses and dont reflect any reality */
@@ -70,6 +83,10 @@ struct _GstNetSimPrivate
 #define DEFAULT_DROP_PROBABILITY 0.0
 #define DEFAULT_DUPLICATE_PROBABILITY 0.0
 #define DEFAULT_DROP_PACKETS 0
+#define DEFAULT_MAX_KBPS -1
+#define DEFAULT_MAX_BUCKET_SIZE -1
+#define DEFAULT_MAX_QUEUE_SIZE -1
+#define DEFAULT_SEED 0
 
 #define GST_NET_SIM_GET_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), GST_TYPE_NET_SIM, \
@@ -89,42 +106,63 @@ GST_STATIC_PAD_TEMPLATE ("src",
 
 G_DEFINE_TYPE (GstNetSim, gst_net_sim, GST_TYPE_ELEMENT);
 
-static void
-gst_net_sim_loop (GstNetSim * netsim)
+typedef struct
 {
-  GMainLoop *loop;
-
-  GST_TRACE_OBJECT (netsim, "TASK: begin");
-
-  g_mutex_lock (&netsim->priv->loop_mutex);
-  loop = g_main_loop_ref (netsim->priv->main_loop);
-  netsim->priv->running = TRUE;
-  GST_TRACE_OBJECT (netsim, "TASK: signal start");
-  g_cond_signal (&netsim->priv->start_cond);
-  g_mutex_unlock (&netsim->priv->loop_mutex);
+  GstBuffer *buf;
+  gint64 push_time;
+} PushBufferCtx;
 
-  GST_TRACE_OBJECT (netsim, "TASK: run");
-  g_main_loop_run (loop);
-  g_main_loop_unref (loop);
+G_INLINE_FUNC PushBufferCtx *
+push_buffer_ctx_new (GstBuffer * buf, gint64 push_time)
+{
+  PushBufferCtx *ctx = g_slice_new (PushBufferCtx);
+  ctx->buf = gst_buffer_ref (buf);
+  ctx->push_time = push_time;
+  return ctx;
+}
 
-  g_mutex_lock (&netsim->priv->loop_mutex);
-  GST_TRACE_OBJECT (netsim, "TASK: pause");
-  gst_pad_pause_task (netsim->priv->srcpad);
-  netsim->priv->running = FALSE;
-  GST_TRACE_OBJECT (netsim, "TASK: signal end");
-  g_cond_signal (&netsim->priv->start_cond);
-  g_mutex_unlock (&netsim->priv->loop_mutex);
-  GST_TRACE_OBJECT (netsim, "TASK: end");
+G_INLINE_FUNC void
+push_buffer_ctx_free (PushBufferCtx * ctx)
+{
+  if (G_LIKELY (ctx != NULL)) {
+    gst_buffer_unref (ctx->buf);
+    g_slice_free (PushBufferCtx, ctx);
+  }
 }
 
-static gboolean
-_main_loop_quit_and_remove_source (gpointer user_data)
+/* All delayed buffers are handled by this single task, which sleeps until the
+ * push time of the first queued buffer instead of having a timer per
+ * buffer */
+static void
+gst_net_sim_loop (GstNetSim * netsim)
 {
-  GMainLoop *main_loop = user_data;
-  GST_DEBUG ("MAINLOOP: Quit %p", main_loop);
-  g_main_loop_quit (main_loop);
-  g_assert (!g_main_loop_is_running (main_loop));
-  return FALSE;                 /* Remove source */
+  GstNetSimPrivate *priv = netsim->priv;
+  PushBufferCtx *ctx;
+
+  g_mutex_lock (&priv->lock);
+  while (priv->running) {
+    ctx = g_queue_peek_head (&priv->queue);
+    if (ctx == NULL)
+      g_cond_wait (&priv->cond, &priv->lock);
+    else if (ctx->push_time > g_get_monotonic_time ())
+      g_cond_wait_until (&priv->cond, &priv->lock, ctx->push_time);
+    else
+      break;
+  }
+
+  if (!priv->running) {
+    GST_TRACE_OBJECT (netsim, "TASK: pause");
+    gst_pad_pause_task (priv->srcpad);
+    g_mutex_unlock (&priv->lock);
+    return;
+  }
+
+  ctx = g_queue_pop_head (&priv->queue);
+  g_mutex_unlock (&priv->lock);
+
+  GST_DEBUG_OBJECT (netsim, "Pushing buffer now");
+  gst_pad_push (priv->srcpad, gst_buffer_ref (ctx->buf));
+  push_buffer_ctx_free (ctx);
 }
 
 static gboolean
@@ -132,118 +170,138 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
     GstPadMode mode, gboolean active)
 {
   GstNetSim *netsim = GST_NET_SIM (parent);
-  gboolean result = FALSE;
+  GstNetSimPrivate *priv = netsim->priv;
+  gboolean result;
 
   (void) pad;
   (void) mode;
 
-  g_mutex_lock (&netsim->priv->loop_mutex);
   if (active) {
-    if (netsim->priv->main_loop == NULL) {
-      GMainContext *main_context = g_main_context_new ();
-      netsim->priv->main_loop = g_main_loop_new (main_context, FALSE);
-      g_main_context_unref (main_context);
-
-      GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
-      result = gst_pad_start_task (netsim->priv->srcpad,
-          (GstTaskFunction) gst_net_sim_loop, netsim, NULL);
-
-      GST_TRACE_OBJECT (netsim, "ACT: Wait for task to start");
-      g_assert (!netsim->priv->running);
-      while (!netsim->priv->running)
-        g_cond_wait (&netsim->priv->start_cond, &netsim->priv->loop_mutex);
-      GST_TRACE_OBJECT (netsim, "ACT: Task on srcpad started");
-    }
+    g_mutex_lock (&priv->lock);
+    /* a fixed seed repeats the same drops and delays on every run */
+    if (priv->seed != 0)
+      g_rand_set_seed (priv->rand_seed, priv->seed);
+    priv->bucket_time = -1;
+    priv->tokens = 0;
+    priv->running = TRUE;
+    g_mutex_unlock (&priv->lock);
+
+    GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
+    result = gst_pad_start_task (priv->srcpad,
+        (GstTaskFunction) gst_net_sim_loop, netsim, NULL);
   } else {
-    if (netsim->priv->main_loop != NULL) {
-      GSource *source;
-      guint id;
-
-      /* Adds an Idle Source which quits the main loop from within.
-       * This removes the possibility for run/quit race conditions. */
-      GST_TRACE_OBJECT (netsim, "DEACT: Stopping main loop on deactivate");
-      source = g_idle_source_new ();
-      g_source_set_callback (source, _main_loop_quit_and_remove_source,
-          g_main_loop_ref (netsim->priv->main_loop),
-          (GDestroyNotify) g_main_loop_unref);
-      id = g_source_attach (source,
-          g_main_loop_get_context (netsim->priv->main_loop));
-      g_source_unref (source);
-      g_assert_cmpuint (id, >, 0);
-      g_main_loop_unref (netsim->priv->main_loop);
-      netsim->priv->main_loop = NULL;
-
-      GST_TRACE_OBJECT (netsim, "DEACT: Wait for mainloop and task to pause");
-      g_assert (netsim->priv->running);
-      while (netsim->priv->running)
-        g_cond_wait (&netsim->priv->start_cond, &netsim->priv->loop_mutex);
-
-      GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
-      result = gst_pad_stop_task (netsim->priv->srcpad);
-      GST_TRACE_OBJECT (netsim, "DEACT: Mainloop and GstTask stopped");
-    }
+    g_mutex_lock (&priv->lock);
+    priv->running = FALSE;
+    g_cond_signal (&priv->cond);
+    g_mutex_unlock (&priv->lock);
+
+    GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
+    result = gst_pad_stop_task (priv->srcpad);
+
+    g_mutex_lock (&priv->lock);
+    g_queue_foreach (&priv->queue, (GFunc) push_buffer_ctx_free, NULL);
+    g_queue_clear (&priv->queue);
+    g_mutex_unlock (&priv->lock);
   }
-  g_mutex_unlock (&netsim->priv->loop_mutex);
 
   return result;
 }
 
-typedef struct
+/* Token bucket with a backlog: returns how long @buf has to wait for the link
+ * to be free in microseconds, or -1 if it does not fit into the queue */
+static gint64
+gst_net_sim_shape_buffer_unlocked (GstNetSim * netsim, GstBuffer * buf,
+    gint64 now)
 {
-  GstPad *pad;
-  GstBuffer *buf;
-} PushBufferCtx;
+  GstNetSimPrivate *priv = netsim->priv;
+  gint64 bits = gst_buffer_get_size (buf) * 8;
+  gint64 bucket, tokens;
 
-G_INLINE_FUNC PushBufferCtx *
-push_buffer_ctx_new (GstPad * pad, GstBuffer * buf)
-{
-  PushBufferCtx *ctx = g_slice_new (PushBufferCtx);
-  ctx->pad = gst_object_ref (pad);
-  ctx->buf = gst_buffer_ref (buf);
-  return ctx;
-}
+  if (priv->max_kbps <= 0)
+    return 0;
 
-G_INLINE_FUNC void
-push_buffer_ctx_free (PushBufferCtx * ctx)
-{
-  if (G_LIKELY (ctx != NULL)) {
-    gst_buffer_unref (ctx->buf);
-    gst_object_unref (ctx->pad);
-    g_slice_free (PushBufferCtx, ctx);
+  /* without a bucket size the link allows bursts of a single buffer */
+  bucket = priv->max_bucket_size > 0 ? (gint64) priv->max_bucket_size * 8 :
+      bits;
+
+  if (priv->bucket_time < 0) {
+    priv->tokens = bucket;
+  } else {
+    priv->tokens += (now - priv->bucket_time) * priv->max_kbps / 1000;
+    priv->tokens = MIN (priv->tokens, bucket);
+  }
+  priv->bucket_time = now;
+
+  /* negative tokens are the backlog of the link */
+  tokens = priv->tokens - bits;
+  if (tokens < 0 && priv->max_queue_size >= 0 &&
+      -tokens > (gint64) priv->max_queue_size * 8) {
+    GST_DEBUG_OBJECT (netsim, "Queue full, dropping packet");
+    return -1;
   }
+  priv->tokens = tokens;
+
+  return tokens < 0 ? -tokens * 1000 / priv->max_kbps : 0;
 }
 
-static gboolean
-push_buffer_ctx_push (PushBufferCtx * ctx)
+static void
+gst_net_sim_queue_buffer_unlocked (GstNetSim * netsim, GstBuffer * buf,
+    gint64 push_time)
 {
-  GST_DEBUG_OBJECT (ctx->pad, "Pushing buffer now");
-  gst_pad_push (ctx->pad, gst_buffer_ref (ctx->buf));
-  return FALSE;
+  GstNetSimPrivate *priv = netsim->priv;
+  PushBufferCtx *ctx = push_buffer_ctx_new (buf, push_time);
+  GList *l;
+
+  /* delays are bounded, so the position is found near the tail */
+  for (l = priv->queue.tail; l; l = l->prev) {
+    if (((PushBufferCtx *) l->data)->push_time <= push_time)
+      break;
+  }
+
+  if (l) {
+    g_queue_insert_after (&priv->queue, l, ctx);
+  } else {
+    g_queue_push_head (&priv->queue, ctx);
+    /* new first buffer, the task has to wake up earlier */
+    g_cond_signal (&priv->cond);
+  }
 }
 
 static GstFlowReturn
 gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
 {
+  GstNetSimPrivate *priv = netsim->priv;
   GstFlowReturn ret = GST_FLOW_OK;
+  gint64 now, wait, delay = 0;
+
+  g_mutex_lock (&priv->lock);
+  if (!priv->running) {
+    g_mutex_unlock (&priv->lock);
+    return gst_pad_push (priv->srcpad, gst_buffer_ref (buf));
+  }
+
+  now = g_get_monotonic_time ();
+  wait = gst_net_sim_shape_buffer_unlocked (netsim, buf, now);
+  if (wait < 0) {
+    g_mutex_unlock (&priv->lock);
+    return GST_FLOW_OK;
+  }
+
+  if (priv->delay_probability > 0 &&
+      g_rand_double (priv->rand_seed) < priv->delay_probability) {
+    delay = g_rand_int_range (priv->rand_seed, priv->min_delay,
+        priv->max_delay);
+    GST_DEBUG_OBJECT (netsim, "Delaying packet by %" G_GINT64_FORMAT, delay);
+  }
 
-  g_mutex_lock (&netsim->priv->loop_mutex);
-  if (netsim->priv->main_loop != NULL && netsim->priv->delay_probability > 0 &&
-      g_rand_double (netsim->priv->rand_seed) < netsim->priv->delay_probability)
-  {
-    PushBufferCtx *ctx = push_buffer_ctx_new (netsim->priv->srcpad, buf);
-    gint delay = g_rand_int_range (netsim->priv->rand_seed,
-        netsim->priv->min_delay, netsim->priv->max_delay);
-    GSource *source = g_timeout_source_new (delay);
-
-    GST_DEBUG_OBJECT (netsim, "Delaying packet by %d", delay);
-    g_source_set_callback (source, (GSourceFunc) push_buffer_ctx_push,
-        ctx, (GDestroyNotify) push_buffer_ctx_free);
-    g_source_attach (source, g_main_loop_get_context (netsim->priv->main_loop));
-    g_source_unref (source);
+  if (wait > 0 || delay > 0) {
+    gst_net_sim_queue_buffer_unlocked (netsim, buf,
+        now + wait + delay * G_TIME_SPAN_MILLISECOND);
+    g_mutex_unlock (&priv->lock);
   } else {
-    ret = gst_pad_push (netsim->priv->srcpad, gst_buffer_ref (buf));
+    g_mutex_unlock (&priv->lock);
+    ret = gst_pad_push (priv->srcpad, gst_buffer_ref (buf));
   }
-  g_mutex_unlock (&netsim->priv->loop_mutex);
 
   return ret;
 }
@@ -308,6 +366,20 @@ gst_net_sim_set_property (GObject * object,
     case ARG_DROP_PACKETS:
       netsim->priv->drop_packets = g_value_get_uint (value);
       break;
+    case ARG_MAX_KBPS:
+      netsim->priv->max_kbps = g_value_get_int (value);
+      break;
+    case ARG_MAX_BUCKET_SIZE:
+      netsim->priv->max_bucket_size = g_value_get_int (value);
+      break;
+    case ARG_MAX_QUEUE_SIZE:
+      netsim->priv->max_queue_size = g_value_get_int (value);
+      break;
+    case ARG_SEED:
+      netsim->priv->seed = g_value_get_uint (value);
+      if (netsim->priv->seed != 0)
+        g_rand_set_seed (netsim->priv->rand_seed, netsim->priv->seed);
+      break;
   }
 }
 
@@ -339,6 +411,18 @@ gst_net_sim_get_property (GObject * object,
     case ARG_DROP_PACKETS:
       g_value_set_uint (value, netsim->priv->drop_packets);
       break;
+    case ARG_MAX_KBPS:
+      g_value_set_int (value, netsim->priv->max_kbps);
+      break;
+    case ARG_MAX_BUCKET_SIZE:
+      g_value_set_int (value, netsim->priv->max_bucket_size);
+      break;
+    case ARG_MAX_QUEUE_SIZE:
+      g_value_set_int (value, netsim->priv->max_queue_size);
+      break;
+    case ARG_SEED:
+      g_value_set_uint (value, netsim->priv->seed);
+      break;
   }
 }
 
@@ -356,10 +440,11 @@ gst_net_sim_init (GstNetSim * netsim)
   gst_element_add_pad (GST_ELEMENT (netsim), netsim->priv->srcpad);
   gst_element_add_pad (GST_ELEMENT (netsim), netsim->priv->sinkpad);
 
-  g_mutex_init (&netsim->priv->loop_mutex);
-  g_cond_init (&netsim->priv->start_cond);
+  g_mutex_init (&netsim->priv->lock);
+  g_cond_init (&netsim->priv->cond);
+  g_queue_init (&netsim->priv->queue);
   netsim->priv->rand_seed = g_rand_new ();
-  netsim->priv->main_loop = NULL;
+  netsim->priv->running = FALSE;
 
   GST_OBJECT_FLAG_SET (netsim->priv->sinkpad,
       GST_PAD_FLAG_PROXY_CAPS | GST_PAD_FLAG_PROXY_ALLOCATION);
@@ -376,8 +461,8 @@ gst_net_sim_finalize (GObject * object)
   GstNetSim *netsim = GST_NET_SIM (object);
 
   g_rand_free (netsim->priv->rand_seed);
-  g_mutex_clear (&netsim->priv->loop_mutex);
-  g_cond_clear (&netsim->priv->start_cond);
+  g_mutex_clear (&netsim->priv->lock);
+  g_cond_clear (&netsim->priv->cond);
 
   G_OBJECT_CLASS (gst_net_sim_parent_class)->finalize (object);
 }
@@ -387,7 +472,7 @@ gst_net_sim_dispose (GObject * object)
 {
   GstNetSim *netsim = GST_NET_SIM (object);
 
-  g_assert (netsim->priv->main_loop == NULL);
+  g_assert (g_queue_is_empty (&netsim->priv->queue));
 
   G_OBJECT_CLASS (gst_net_sim_parent_class)->dispose (object);
 }
@@ -409,7 +494,7 @@ gst_net_sim_class_init (GstNetSimClass * klass)
       "Network Simulator",
       "Filter/Network",
       "An element that simulates network jitter, "
-      "packet loss and packet duplication",
+      "packet loss, packet duplication and limited bandwidth",
       "Philippe Kalaf <philippe.kalaf@collabora.co.uk>");
 
   gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_net_sim_dispose);
@@ -454,6 +539,63 @@ gst_net_sim_class_init (GstNetSimClass * klass)
           0, G_MAXUINT, DEFAULT_DROP_PACKETS,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstNetSim:max-kbps:
+   *
+   * The maximum number of kilobits to let through per second. Buffers that
+   * exceed the rate wait in a queue, like they would in a router.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, ARG_MAX_KBPS,
+      g_param_spec_int ("max-kbps", "Maximum Kbps",
+          "The maximum number of kilobits to let through per second "
+          "(-1 = unlimited)", -1, G_MAXINT, DEFAULT_MAX_KBPS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:max-bucket-size:
+   *
+   * The size of the token bucket of the rate limit in bytes, which is the
+   * largest burst sent at full speed.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, ARG_MAX_BUCKET_SIZE,
+      g_param_spec_int ("max-bucket-size", "Maximum Bucket Size (bytes)",
+          "The size of the token bucket, related to burstiness resilience "
+          "(-1 = the size of one buffer)", -1, G_MAXINT,
+          DEFAULT_MAX_BUCKET_SIZE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:max-queue-size:
+   *
+   * The number of bytes that may wait for the rate limit before buffers are
+   * dropped.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, ARG_MAX_QUEUE_SIZE,
+      g_param_spec_int ("max-queue-size", "Maximum Queue Size (bytes)",
+          "The number of bytes waiting for the rate limit before dropping "
+          "(-1 = unlimited)", -1, G_MAXINT, DEFAULT_MAX_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:seed:
+   *
+   * Seed of the random number generator. With a non-zero seed every run
+   * drops, duplicates and delays the same buffers.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, ARG_SEED,
+      g_param_spec_uint ("seed", "Seed",
+          "Seed for the random decisions (0 = random seed)",
+          0, G_MAXUINT, DEFAULT_SEED,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (netsim_debug, "netsim", 0, "Network simulator");
 }
 
@@ -24,7 +24,12 @@
  * Extracts payloads from Ethernet-encapsulated IP packets.
  * Use #GstPcapParse:src-ip, #GstPcapParse:dst-ip,
  * #GstPcapParse:src-port and #GstPcapParse:dst-port to restrict which packets
- * should be included.
+ * should be included. Both the classic libpcap format and pcapng are
+ * understood.
+ *
+ * With #GstPcapParse:ts-offset set, the packets are timestamped relative to
+ * the first one and a sink synchronising to the clock replays them at the
+ * pace they were captured, or faster or slower with #GstPcapParse:rate.
  *
  * ## Example pipelines
  * |[
@@ -61,6 +66,14 @@ const guint GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN = 0xa1b23c4d;
 const guint GST_PCAPPARSE_MAGIC_MILLISECOND_SWAP_ENDIAN = 0xd4c3b2a1;
 const guint GST_PCAPPARSE_MAGIC_NANOSECOND_SWAP_ENDIAN = 0x4d3cb2a1;
 
+/* pcapng block types and the section byte-order magic */
+#define PCAPNG_SECTION_HEADER_BLOCK     0x0a0d0d0a
+#define PCAPNG_INTERFACE_BLOCK          0x00000001
+#define PCAPNG_SIMPLE_PACKET_BLOCK      0x00000003
+#define PCAPNG_ENHANCED_PACKET_BLOCK    0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC         0x1a2b3c4d
+#define PCAPNG_OPTION_IF_TSRESOL        9
+
 
 enum
 {
@@ -70,7 +83,8 @@ enum
   PROP_SRC_PORT,
   PROP_DST_PORT,
   PROP_CAPS,
-  PROP_TS_OFFSET
+  PROP_TS_OFFSET,
+  PROP_RATE
 };
 
 GST_DEBUG_CATEGORY_STATIC (gst_pcap_parse_debug);
@@ -145,6 +159,20 @@ gst_pcap_parse_class_init (GstPcapParseClass * klass)
           "Relative timestamp offset (ns) to apply (-1 = use absolute packet time)",
           -1, G_MAXINT64, -1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstPcapParse:rate:
+   *
+   * Factor by which the intervals between the packet timestamps are divided,
+   * to replay a capture faster (> 1.0) or slower (< 1.0) than it was
+   * recorded.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_RATE,
+      g_param_spec_double ("rate", "Rate",
+          "Replay rate of the packet timestamps (1.0 = as captured)",
+          0.001, 1000.0, 1.0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &sink_template);
   gst_element_class_add_static_pad_template (element_class, &src_template);
 
@@ -178,8 +206,11 @@ gst_pcap_parse_init (GstPcapParse * self)
   self->src_port = -1;
   self->dst_port = -1;
   self->offset = -1;
+  self->rate = 1.0;
 
   self->adapter = gst_adapter_new ();
+  self->interfaces = g_array_new (FALSE, FALSE,
+      sizeof (GstPcapParseInterface));
 
   gst_pcap_parse_reset (self);
 }
@@ -190,6 +221,7 @@ gst_pcap_parse_finalize (GObject * object)
   GstPcapParse *self = GST_PCAP_PARSE (object);
 
   g_object_unref (self->adapter);
+  g_array_free (self->interfaces, TRUE);
   if (self->caps)
     gst_caps_unref (self->caps);
 
@@ -251,6 +283,10 @@ gst_pcap_parse_get_property (GObject * object, guint prop_id,
       g_value_set_int64 (value, self->offset);
       break;
 
+    case PROP_RATE:
+      g_value_set_double (value, self->rate);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -305,6 +341,10 @@ gst_pcap_parse_set_property (GObject * object, guint prop_id,
       self->offset = g_value_get_int64 (value);
       break;
 
+    case PROP_RATE:
+      self->rate = g_value_get_double (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -318,10 +358,13 @@ gst_pcap_parse_reset (GstPcapParse * self)
   self->swap_endian = FALSE;
   self->nanosecond_timestamp = FALSE;
   self->cur_packet_size = -1;
+  self->cur_packet_pad = 0;
   self->cur_ts = GST_CLOCK_TIME_NONE;
   self->base_ts = GST_CLOCK_TIME_NONE;
   self->newsegment_sent = FALSE;
+  self->pcapng = FALSE;
 
+  g_array_set_size (self->interfaces, 0);
   gst_adapter_clear (self->adapter);
 }
 
@@ -341,6 +384,202 @@ gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
   }
 }
 
+static guint16
+gst_pcap_parse_read_uint16 (GstPcapParse * self, const guint8 * p)
+{
+  guint16 val = *((guint16 *) p);
+
+  return self->swap_endian ? GUINT16_SWAP_LE_BE (val) : val;
+}
+
+/* Converts a pcapng timestamp in units of if_tsresol to nanoseconds */
+static GstClockTime
+gst_pcap_parse_ng_timestamp (guint64 ts, guint8 tsresol)
+{
+  guint64 units_per_second = 1;
+  guint i;
+
+  if (tsresol & 0x80) {
+    if ((tsresol & 0x7f) > 63)
+      return GST_CLOCK_TIME_NONE;
+    units_per_second <<= tsresol & 0x7f;
+  } else {
+    if (tsresol > 19)
+      return GST_CLOCK_TIME_NONE;
+    for (i = 0; i < tsresol; i++)
+      units_per_second *= 10;
+  }
+
+  return gst_util_uint64_scale (ts, GST_SECOND, units_per_second);
+}
+
+/* Reads the next pcapng block header and sets up cur_packet_size for the
+ * packet blocks, returns FALSE if more data is needed */
+static gboolean
+gst_pcap_parse_ng_block (GstPcapParse * self, gint avail, GstFlowReturn * ret)
+{
+  const guint8 *data;
+  guint32 block_type, block_len;
+
+  if (avail < 12)
+    return FALSE;
+
+  data = gst_adapter_map (self->adapter, 12);
+  block_type = gst_pcap_parse_read_uint32 (self, data);
+
+  /* each section can have a different byte order */
+  if (block_type == PCAPNG_SECTION_HEADER_BLOCK) {
+    guint32 bom = *((guint32 *) (data + 8));
+
+    if (bom == PCAPNG_BYTE_ORDER_MAGIC) {
+      self->swap_endian = FALSE;
+    } else if (GUINT32_SWAP_LE_BE (bom) == PCAPNG_BYTE_ORDER_MAGIC) {
+      self->swap_endian = TRUE;
+    } else {
+      gst_adapter_unmap (self->adapter);
+      GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+          ("Invalid pcapng byte-order magic %X", bom));
+      *ret = GST_FLOW_ERROR;
+      return FALSE;
+    }
+  }
+
+  block_len = gst_pcap_parse_read_uint32 (self, data + 4);
+  gst_adapter_unmap (self->adapter);
+
+  if (block_len < 12 || block_len % 4 != 0) {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+        ("Invalid pcapng block length %u", block_len));
+    *ret = GST_FLOW_ERROR;
+    return FALSE;
+  }
+
+  switch (block_type) {
+    case PCAPNG_ENHANCED_PACKET_BLOCK:{
+      guint32 interface_id, ts_high, ts_low, incl_len;
+      GstPcapParseInterface *iface = NULL;
+
+      if (avail < 28)
+        return FALSE;
+
+      data = gst_adapter_map (self->adapter, 28);
+      interface_id = gst_pcap_parse_read_uint32 (self, data + 8);
+      ts_high = gst_pcap_parse_read_uint32 (self, data + 12);
+      ts_low = gst_pcap_parse_read_uint32 (self, data + 16);
+      incl_len = gst_pcap_parse_read_uint32 (self, data + 20);
+      gst_adapter_unmap (self->adapter);
+
+      if (block_len < 32 || incl_len > block_len - 32) {
+        GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+            ("Invalid pcapng packet length %u", incl_len));
+        *ret = GST_FLOW_ERROR;
+        return FALSE;
+      }
+      gst_adapter_flush (self->adapter, 28);
+
+      if (interface_id < self->interfaces->len)
+        iface = &g_array_index (self->interfaces, GstPcapParseInterface,
+            interface_id);
+
+      if (iface) {
+        self->linktype = iface->linktype;
+        self->cur_ts = gst_pcap_parse_ng_timestamp (((guint64) ts_high << 32)
+            | ts_low, iface->tsresol);
+      } else {
+        GST_WARNING_OBJECT (self, "packet for unknown interface %u",
+            interface_id);
+        self->linktype = 0;
+        self->cur_ts = GST_CLOCK_TIME_NONE;
+      }
+      self->cur_packet_size = incl_len;
+      self->cur_packet_pad = block_len - 28 - incl_len;
+      break;
+    }
+    case PCAPNG_SIMPLE_PACKET_BLOCK:{
+      guint32 orig_len;
+
+      if (block_len < 16) {
+        GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+            ("Invalid pcapng simple packet block length %u", block_len));
+        *ret = GST_FLOW_ERROR;
+        return FALSE;
+      }
+
+      data = gst_adapter_map (self->adapter, 12);
+      orig_len = gst_pcap_parse_read_uint32 (self, data + 8);
+      gst_adapter_unmap (self->adapter);
+      gst_adapter_flush (self->adapter, 12);
+
+      /* no timestamp and always on the first interface */
+      if (self->interfaces->len > 0)
+        self->linktype = g_array_index (self->interfaces,
+            GstPcapParseInterface, 0).linktype;
+      else
+        self->linktype = 0;
+      self->cur_ts = GST_CLOCK_TIME_NONE;
+      self->cur_packet_size = MIN (orig_len, block_len - 16);
+      self->cur_packet_pad = block_len - 12 - self->cur_packet_size;
+      break;
+    }
+    case PCAPNG_INTERFACE_BLOCK:{
+      GstPcapParseInterface iface;
+      guint32 pos;
+
+      if (avail < block_len)
+        return FALSE;
+      if (block_len < 20) {
+        GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+            ("Invalid pcapng interface block length %u", block_len));
+        *ret = GST_FLOW_ERROR;
+        return FALSE;
+      }
+
+      data = gst_adapter_map (self->adapter, block_len);
+      iface.linktype = gst_pcap_parse_read_uint16 (self, data + 8);
+      iface.tsresol = 6;
+
+      /* options, up to the trailing block length */
+      pos = 16;
+      while (pos + 4 <= block_len - 4) {
+        guint16 code = gst_pcap_parse_read_uint16 (self, data + pos);
+        guint16 len = gst_pcap_parse_read_uint16 (self, data + pos + 2);
+
+        if (code == 0 || pos + 4 + len > block_len - 4)
+          break;
+        if (code == PCAPNG_OPTION_IF_TSRESOL && len >= 1)
+          iface.tsresol = data[pos + 4];
+        pos += 4 + GST_ROUND_UP_4 (len);
+      }
+      gst_adapter_unmap (self->adapter);
+      gst_adapter_flush (self->adapter, block_len);
+
+      if (iface.linktype != LINKTYPE_ETHER && iface.linktype != LINKTYPE_SLL &&
+          iface.linktype != LINKTYPE_RAW)
+        GST_WARNING_OBJECT (self, "interface %u has unsupported link type %d, "
+            "ignoring its packets", self->interfaces->len, iface.linktype);
+
+      GST_DEBUG_OBJECT (self, "interface %u: linktype %u, tsresol 0x%02x",
+          self->interfaces->len, iface.linktype, iface.tsresol);
+      g_array_append_val (self->interfaces, iface);
+      break;
+    }
+    case PCAPNG_SECTION_HEADER_BLOCK:
+      /* interface ids are per section */
+      g_array_set_size (self->interfaces, 0);
+      /* fall through */
+    default:
+      if (avail < block_len)
+        return FALSE;
+
+      GST_LOG_OBJECT (self, "skipping block type 0x%08x of %u bytes",
+          block_type, block_len);
+      gst_adapter_flush (self->adapter, block_len);
+      break;
+  }
+
+  return TRUE;
+}
+
 #define ETH_MAC_ADDRESSES_LEN    12
 #define ETH_HEADER_LEN    14
 #define ETH_VLAN_HEADER_LEN    4
@@ -490,7 +729,7 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
     if (self->initialized) {
       if (self->cur_packet_size >= 0) {
-        if (avail < self->cur_packet_size)
+        if (avail < self->cur_packet_size + self->cur_packet_pad)
           break;
 
         if (self->cur_packet_size > 0) {
@@ -524,9 +763,14 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
             if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
               if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
                 self->base_ts = self->cur_ts;
-              if (self->offset >= 0) {
-                self->cur_ts -= self->base_ts;
-                self->cur_ts += self->offset;
+              if (self->offset >= 0 || self->rate != 1.0) {
+                GstClockTime ts = self->cur_ts > self->base_ts ?
+                    self->cur_ts - self->base_ts : 0;
+
+                if (self->rate != 1.0)
+                  ts /= self->rate;
+                self->cur_ts = ts + (self->offset >= 0 ?
+                    self->offset : self->base_ts);
               }
             }
             GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
@@ -541,7 +785,16 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
           }
         }
 
+        if (self->cur_packet_pad > 0)
+          gst_adapter_flush (self->adapter, self->cur_packet_pad);
         self->cur_packet_size = -1;
+        self->cur_packet_pad = 0;
+      } else if (self->pcapng) {
+        if (!gst_pcap_parse_ng_block (self, avail, &ret)) {
+          if (ret != GST_FLOW_OK)
+            goto out;
+          break;
+        }
       } else {
         guint32 ts_sec;
         guint32 ts_usec;
@@ -580,6 +833,14 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       linktype = *((guint32 *) (data + 20));
       gst_adapter_unmap (self->adapter);
 
+      /* the section header block is read like the other pcapng blocks */
+      if (magic == PCAPNG_SECTION_HEADER_BLOCK) {
+        GST_DEBUG_OBJECT (self, "pcapng file");
+        self->pcapng = TRUE;
+        self->initialized = TRUE;
+        continue;
+      }
+
       if (magic == GST_PCAPPARSE_MAGIC_MILLISECOND_NO_SWAP_ENDIAN ||
           magic == GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN) {
         self->swap_endian = FALSE;
@@ -594,7 +855,8 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         linktype = GUINT32_SWAP_LE_BE (linktype);
       } else {
         GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
-            ("File is not a libpcap file, magic is %X", magic));
+            ("File is neither a libpcap nor a pcapng file, magic is %X",
+                magic));
         ret = GST_FLOW_ERROR;
         goto out;
       }
@@ -630,7 +892,10 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       if (self->caps)
         gst_pad_set_caps (self->src_pad, self->caps);
       gst_segment_init (&segment, GST_FORMAT_TIME);
-      segment.start = self->base_ts;
+      /* the first timestamp, which is the offset if they are relative */
+      segment.start = GST_BUFFER_TIMESTAMP (gst_buffer_list_get (list, 0));
+      if (!GST_CLOCK_TIME_IS_VALID (segment.start))
+        segment.start = self->base_ts;
       gst_pad_push_event (self->src_pad, gst_event_new_segment (&segment));
       self->newsegment_sent = TRUE;
     }
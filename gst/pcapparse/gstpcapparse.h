@@ -52,6 +52,16 @@ typedef enum
   LINKTYPE_SLL = 113
 } GstPcapParseLinktype;
 
+typedef struct
+{
+  GstPcapParseLinktype linktype;
+
+  /* pcapng */
+  gboolean pcapng;
+  GArray *interfaces;
+  guint8 tsresol;
+} GstPcapParseInterface;
+
 /**
  * GstPcapParse:
  *
@@ -73,6 +83,7 @@ struct _GstPcapParse
   gint32 dst_port;
   GstCaps *caps;
   gint64 offset;
+  gdouble rate;
 
   /* state */
   GstAdapter * adapter;
@@ -80,6 +91,7 @@ struct _GstPcapParse
   gboolean swap_endian;
   gboolean nanosecond_timestamp;
   gint64 cur_packet_size;
+  gint64 cur_packet_pad;
   GstClockTime cur_ts;
   GstClockTime base_ts;
   GstPcapParseLinktype linktype;
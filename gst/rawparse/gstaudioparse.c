@@ -84,6 +84,8 @@ static void gst_audio_parse_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_audio_parse_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static GstStateChangeReturn gst_audio_parse_change_state (GstElement * element,
+    GstStateChange transition);
 
 GST_DEBUG_CATEGORY_STATIC (gst_audio_parse_debug);
 #define GST_CAT_DEFAULT gst_audio_parse_debug
@@ -97,7 +99,8 @@ enum
   PROP_CHANNELS,
   PROP_INTERLEAVED,
   PROP_CHANNEL_POSITIONS,
-  PROP_USE_SINK_CAPS
+  PROP_USE_SINK_CAPS,
+  PROP_READAHEAD
 };
 
 #define GST_AUDIO_PARSE_FORMAT (gst_audio_parse_format_get_type ())
@@ -132,6 +135,9 @@ gst_audio_parse_class_init (GstAudioParseClass * klass)
   gobject_class->set_property = gst_audio_parse_set_property;
   gobject_class->get_property = gst_audio_parse_get_property;
 
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_audio_parse_change_state);
+
   g_object_class_install_property (gobject_class, PROP_FORMAT,
       g_param_spec_enum ("format", "Format",
           "Format of audio samples in raw stream", GST_AUDIO_PARSE_FORMAT,
@@ -172,6 +178,12 @@ gst_audio_parse_class_init (GstAudioParseClass * klass)
           "Use the sink caps for the format, only performing timestamping",
           FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_READAHEAD,
+      g_param_spec_uint ("readahead", "Readahead",
+          "Number of buffers after the current one that the operating system "
+          "is asked to read ahead when parsing a local file (0 = disabled)",
+          0, G_MAXINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Audio Parse",
       "Filter/Audio",
       "Converts stream into audio frames (deprecated: use rawaudioparse instead)",
@@ -211,6 +223,8 @@ gst_audio_parse_init (GstAudioParse * ap)
       gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (ap), "src"));
   gst_element_add_pad (GST_ELEMENT (ap), ghostpad);
   gst_object_unref (GST_OBJECT (inner_pad));
+
+  gst_raw_readahead_init (&ap->readahead, ap->rawaudioparse);
 }
 
 static void
@@ -277,6 +291,10 @@ gst_audio_parse_set_property (GObject * object, guint prop_id,
           g_value_get_boolean (value), NULL);
       break;
 
+    case PROP_READAHEAD:
+      g_atomic_int_set (&ap->readahead.frames, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -367,8 +385,31 @@ gst_audio_parse_get_property (GObject * object, guint prop_id, GValue * value,
       break;
     }
 
+    case PROP_READAHEAD:
+      g_value_set_uint (value, g_atomic_int_get (&ap->readahead.frames));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
+
+static GstStateChangeReturn
+gst_audio_parse_change_state (GstElement * element, GstStateChange transition)
+{
+  GstAudioParse *ap = GST_AUDIO_PARSE (element);
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_raw_readahead_reset (&ap->readahead);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
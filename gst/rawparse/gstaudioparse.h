@@ -23,6 +23,7 @@
 #define __GST_AUDIO_PARSE_H__
 
 #include <gst/gst.h>
+#include "gstrawreadahead.h"
 
 #define GST_TYPE_AUDIO_PARSE \
   (gst_audio_parse_get_type())
@@ -42,6 +43,8 @@ struct _GstAudioParse
 {
   GstBin parent;
   GstElement *rawaudioparse;
+
+  GstRawReadahead readahead;
 };
 
 struct _GstAudioParseClass
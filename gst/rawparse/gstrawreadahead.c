@@ -0,0 +1,148 @@
+/* GStreamer
+ *
+ * gstrawreadahead.c:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include "gstrawreadahead.h"
+
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#endif
+
+GST_DEBUG_CATEGORY_STATIC (raw_readahead_debug);
+#define GST_CAT_DEFAULT raw_readahead_debug
+
+#ifdef HAVE_POSIX_FADVISE
+/* Opens the file upstream reads from, if it is a local one. The page cache is
+ * shared, so what is read ahead through this fd is what upstream reads. */
+static gint
+gst_raw_readahead_open (GstPad * pad)
+{
+  GstQuery *query;
+  gchar *uri = NULL, *filename = NULL;
+  gint fd = -1;
+
+  query = gst_query_new_uri ();
+  if (gst_pad_peer_query (pad, query))
+    gst_query_parse_uri (query, &uri);
+  gst_query_unref (query);
+
+  if (uri && gst_uri_has_protocol (uri, "file"))
+    filename = g_filename_from_uri (uri, NULL, NULL);
+
+  if (filename) {
+    fd = g_open (filename, O_RDONLY, 0);
+    if (fd < 0)
+      GST_DEBUG_OBJECT (pad, "could not open %s", filename);
+    else
+      GST_DEBUG_OBJECT (pad, "reading ahead from %s", filename);
+  } else {
+    GST_DEBUG_OBJECT (pad, "upstream is not a local file, no readahead");
+  }
+
+  g_free (filename);
+  g_free (uri);
+
+  return fd;
+}
+
+static GstPadProbeReturn
+gst_raw_readahead_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstRawReadahead * ra)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  guint frames = g_atomic_int_get (&ra->frames);
+  guint64 start, end;
+  gsize size;
+
+  /* pull probes are also called before the pull, without a buffer */
+  if (!frames || !buffer || !GST_BUFFER_OFFSET_IS_VALID (buffer))
+    return GST_PAD_PROBE_OK;
+
+  if (!ra->checked) {
+    ra->checked = TRUE;
+    ra->fd = gst_raw_readahead_open (pad);
+  }
+  if (ra->fd < 0)
+    return GST_PAD_PROBE_OK;
+
+  /* the parser pulls or gets one frame per buffer from filesrc, so the
+   * buffer size is the frame size */
+  size = gst_buffer_get_size (buffer);
+  start = GST_BUFFER_OFFSET (buffer) + size;
+  end = start + (guint64) frames * size;
+
+  /* after a seek, start a new window */
+  if (ra->advised_end < start || ra->advised_end > end)
+    ra->advised_end = start;
+
+  /* only advise the frames that were not advised yet, usually one */
+  if (end > ra->advised_end) {
+    posix_fadvise (ra->fd, ra->advised_end, end - ra->advised_end,
+        POSIX_FADV_WILLNEED);
+    ra->advised_end = end;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+#endif
+
+/* Installs the readahead on the sink pad of @parse */
+void
+gst_raw_readahead_init (GstRawReadahead * ra, GstElement * parse)
+{
+#ifdef HAVE_POSIX_FADVISE
+  GstPad *pad;
+#endif
+
+  if (!raw_readahead_debug)
+    GST_DEBUG_CATEGORY_INIT (raw_readahead_debug, "rawreadahead", 0,
+        "raw parser readahead");
+
+  ra->frames = 0;
+  ra->checked = FALSE;
+  ra->fd = -1;
+  ra->advised_end = 0;
+
+#ifdef HAVE_POSIX_FADVISE
+  pad = gst_element_get_static_pad (parse, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_PULL,
+      (GstPadProbeCallback) gst_raw_readahead_probe, ra, NULL);
+  gst_object_unref (pad);
+#endif
+}
+
+/* Forgets the file, to be called when streaming stopped */
+void
+gst_raw_readahead_reset (GstRawReadahead * ra)
+{
+#ifdef HAVE_POSIX_FADVISE
+  if (ra->fd >= 0)
+    g_close (ra->fd, NULL);
+#endif
+
+  ra->checked = FALSE;
+  ra->fd = -1;
+  ra->advised_end = 0;
+}
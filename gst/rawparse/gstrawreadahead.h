@@ -0,0 +1,44 @@
+/* GStreamer
+ *
+ * gstrawreadahead.h:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RAW_READAHEAD_H__
+#define __GST_RAW_READAHEAD_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstRawReadahead GstRawReadahead;
+
+/* Asks the kernel to read the next frames of a local file ahead of the
+ * parser, from the file offsets of the buffers going into its sink pad */
+struct _GstRawReadahead
+{
+  /* number of frames to read ahead, 0 disables it; set from any thread */
+  gint frames;
+
+  /* streaming thread only */
+  gboolean checked;
+  gint fd;
+  guint64 advised_end;
+};
+
+void gst_raw_readahead_init (GstRawReadahead * ra, GstElement * parse);
+void gst_raw_readahead_reset (GstRawReadahead * ra);
+
+#endif /* __GST_RAW_READAHEAD_H__ */
@@ -57,6 +57,8 @@ static void gst_video_parse_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_video_parse_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static GstStateChangeReturn gst_video_parse_change_state (GstElement * element,
+    GstStateChange transition);
 
 static gboolean gst_video_parse_int_valarray_from_string (const gchar *
     str, GValue * valarray);
@@ -77,7 +79,8 @@ enum
   PROP_TOP_FIELD_FIRST,
   PROP_STRIDES,
   PROP_OFFSETS,
-  PROP_FRAMESIZE
+  PROP_FRAMESIZE,
+  PROP_READAHEAD
 };
 
 #define gst_video_parse_parent_class parent_class
@@ -92,6 +95,9 @@ gst_video_parse_class_init (GstVideoParseClass * klass)
   gobject_class->set_property = gst_video_parse_set_property;
   gobject_class->get_property = gst_video_parse_get_property;
 
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_video_parse_change_state);
+
   g_object_class_install_property (gobject_class, PROP_FORMAT,
       g_param_spec_enum ("format", "Format", "Format of images in raw stream",
           GST_TYPE_VIDEO_FORMAT, GST_VIDEO_FORMAT_I420,
@@ -131,6 +137,12 @@ gst_video_parse_class_init (GstVideoParseClass * klass)
           "Size of an image in raw stream (0: default)", 0, G_MAXUINT, 0,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_READAHEAD,
+      g_param_spec_uint ("readahead", "Readahead",
+          "Number of frames after the current one that the operating system "
+          "is asked to read ahead when parsing a local file (0 = disabled)",
+          0, G_MAXINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Video Parse",
       "Filter/Video",
       "Converts stream into video frames (deprecated: use rawvideoparse instead)",
@@ -171,6 +183,8 @@ gst_video_parse_init (GstVideoParse * vp)
       gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (vp), "src"));
   gst_element_add_pad (GST_ELEMENT (vp), ghostpad);
   gst_object_unref (GST_OBJECT (inner_pad));
+
+  gst_raw_readahead_init (&vp->readahead, vp->rawvideoparse);
 }
 
 static void
@@ -252,6 +266,10 @@ gst_video_parse_set_property (GObject * object, guint prop_id,
           g_value_get_uint (value), NULL);
       break;
 
+    case PROP_READAHEAD:
+      g_atomic_int_set (&vp->readahead.frames, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -348,12 +366,35 @@ gst_video_parse_get_property (GObject * object, guint prop_id, GValue * value,
       break;
     }
 
+    case PROP_READAHEAD:
+      g_value_set_uint (value, g_atomic_int_get (&vp->readahead.frames));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static GstStateChangeReturn
+gst_video_parse_change_state (GstElement * element, GstStateChange transition)
+{
+  GstVideoParse *vp = GST_VIDEO_PARSE (element);
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_raw_readahead_reset (&vp->readahead);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
 static gboolean
 gst_video_parse_int_valarray_from_string (const gchar * str, GValue * valarray)
 {
@@ -24,6 +24,7 @@
 #define __GST_VIDEO_PARSE_H__
 
 #include <gst/gst.h>
+#include "gstrawreadahead.h"
 
 #define GST_TYPE_VIDEO_PARSE \
   (gst_video_parse_get_type())
@@ -43,6 +44,8 @@ struct _GstVideoParse
 {
   GstBin parent;
   GstElement *rawvideoparse;
+
+  GstRawReadahead readahead;
 };
 
 struct _GstVideoParseClass
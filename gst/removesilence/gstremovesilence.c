@@ -23,6 +23,12 @@
  * @title: removesilence
  *
  * Removes all silence periods from an audio stream, dropping silence buffers.
+ * Multichannel streams are mixed down for the voice activity detection, the
+ * decision applies to all channels.
+ *
+ * Instead of dropping the silent buffers, #GstRemoveSilence:mark-gap sets
+ * the GAP flag on them, so downstream elements can skip them without
+ * analysing the audio again.
  *
  * ## Example launch line
  * |[
@@ -57,7 +63,8 @@ enum
 {
   PROP_0,
   PROP_REMOVE,
-  PROP_HYSTERESIS
+  PROP_HYSTERESIS,
+  PROP_MARK_GAP
 };
 
 
@@ -65,17 +72,19 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
+        "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32)
+        " }, "
         "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1"));
+        "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"));
 
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
+        "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32)
+        " }, "
         "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1"));
+        "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"));
 
 
 #define DEBUG_INIT(bla) \
@@ -90,6 +99,8 @@ static void gst_remove_silence_set_property (GObject * object, guint prop_id,
 static void gst_remove_silence_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
+static gboolean gst_remove_silence_set_caps (GstBaseTransform * trans,
+    GstCaps * incaps, GstCaps * outcaps);
 static GstFlowReturn gst_remove_silence_transform_ip (GstBaseTransform * base,
     GstBuffer * buf);
 static void gst_remove_silence_finalize (GObject * obj);
@@ -121,6 +132,11 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
           "Set the hysteresis (on samples) used on the internal VAD",
           1, G_MAXUINT64, DEFAULT_VAD_HYSTERESIS, G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_MARK_GAP,
+      g_param_spec_boolean ("mark-gap", "Mark gap",
+          "Set the GAP flag on silent buffers that are not removed",
+          FALSE, G_PARAM_READWRITE));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "RemoveSilence",
       "Filter/Effect/Audio",
@@ -131,6 +147,8 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
 
+  GST_BASE_TRANSFORM_CLASS (klass)->set_caps =
+      GST_DEBUG_FUNCPTR (gst_remove_silence_set_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->transform_ip =
       GST_DEBUG_FUNCPTR (gst_remove_silence_transform_ip);
 }
@@ -145,6 +163,8 @@ gst_remove_silence_init (GstRemoveSilence * filter)
 {
   filter->vad = vad_new (DEFAULT_VAD_HYSTERESIS);
   filter->remove = FALSE;
+  filter->mark_gap = FALSE;
+  gst_audio_info_init (&filter->info);
 
   if (!filter->vad) {
     GST_DEBUG ("Error initializing VAD !!");
@@ -160,6 +180,8 @@ gst_remove_silence_finalize (GObject * obj)
   vad_destroy (filter->vad);
   filter->vad = NULL;
   GST_DEBUG ("VAD Destroyed");
+  g_free (filter->mix);
+  filter->mix = NULL;
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
@@ -176,6 +198,9 @@ gst_remove_silence_set_property (GObject * object, guint prop_id,
     case PROP_HYSTERESIS:
       vad_set_hysteresis (filter->vad, g_value_get_uint64 (value));
       break;
+    case PROP_MARK_GAP:
+      filter->mark_gap = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -195,24 +220,88 @@ gst_remove_silence_get_property (GObject * object, guint prop_id,
     case PROP_HYSTERESIS:
       g_value_set_uint64 (value, vad_get_hysteresis (filter->vad));
       break;
+    case PROP_MARK_GAP:
+      g_value_set_boolean (value, filter->mark_gap);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static gboolean
+gst_remove_silence_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstRemoveSilence *filter = GST_REMOVE_SILENCE (trans);
+
+  return gst_audio_info_from_caps (&filter->info, incaps);
+}
+
+/* Mixes the channels down to the mono 16 bit samples the VAD works on */
+static void
+gst_remove_silence_downmix (GstRemoveSilence * filter, gint16 * out,
+    const guint8 * in, guint n_samples)
+{
+  gint channels = GST_AUDIO_INFO_CHANNELS (&filter->info);
+  guint i;
+  gint c;
+
+  if (GST_AUDIO_INFO_FORMAT (&filter->info) == GST_AUDIO_FORMAT_F32) {
+    const gfloat *src = (const gfloat *) in;
+    gfloat scale = 32767.0f / channels;
+
+    for (i = 0; i < n_samples; i++) {
+      gfloat sum = 0.0f;
+
+      for (c = 0; c < channels; c++)
+        sum += *src++;
+      out[i] = (gint16) CLAMP (sum * scale, -32768.0f, 32767.0f);
+    }
+  } else {
+    const gint16 *src = (const gint16 *) in;
+
+    for (i = 0; i < n_samples; i++) {
+      gint sum = 0;
+
+      for (c = 0; c < channels; c++)
+        sum += *src++;
+      out[i] = sum / channels;
+    }
+  }
+}
+
 static GstFlowReturn
 gst_remove_silence_transform_ip (GstBaseTransform * trans, GstBuffer * inbuf)
 {
   GstRemoveSilence *filter = NULL;
   int frame_type;
   GstMapInfo map;
+  gint16 *data;
+  guint n_samples;
 
   filter = GST_REMOVE_SILENCE (trans);
 
+  if (!GST_AUDIO_INFO_IS_VALID (&filter->info))
+    return GST_FLOW_NOT_NEGOTIATED;
+
   gst_buffer_map (inbuf, &map, GST_MAP_READ);
-  frame_type =
-      vad_update (filter->vad, (gint16 *) map.data, map.size / sizeof (gint16));
+  n_samples = map.size / GST_AUDIO_INFO_BPF (&filter->info);
+
+  /* Mono 16 bit samples are analysed in place */
+  if (GST_AUDIO_INFO_FORMAT (&filter->info) == GST_AUDIO_FORMAT_S16 &&
+      GST_AUDIO_INFO_CHANNELS (&filter->info) == 1) {
+    data = (gint16 *) map.data;
+  } else {
+    if (filter->mix_size < n_samples) {
+      filter->mix = g_renew (gint16, filter->mix, n_samples);
+      filter->mix_size = n_samples;
+    }
+    gst_remove_silence_downmix (filter, filter->mix, map.data, n_samples);
+    data = filter->mix;
+  }
+
+  frame_type = vad_update (filter->vad, data, n_samples);
   gst_buffer_unmap (inbuf, &map);
 
   if (frame_type == VAD_SILENCE) {
@@ -223,6 +312,8 @@ gst_remove_silence_transform_ip (GstBaseTransform * trans, GstBuffer * inbuf)
       return GST_BASE_TRANSFORM_FLOW_DROPPED;
     }
 
+    if (filter->mark_gap)
+      GST_BUFFER_FLAG_SET (inbuf, GST_BUFFER_FLAG_GAP);
   }
 
   return GST_FLOW_OK;
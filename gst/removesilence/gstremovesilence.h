@@ -24,6 +24,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
 #include "vad_private.h"
 
 G_BEGIN_DECLS
@@ -43,6 +44,11 @@ typedef struct _GstRemoveSilence {
   GstBaseTransform parent;
   VADFilter* vad;
   gboolean remove;
+  gboolean mark_gap;
+
+  GstAudioInfo info;
+  gint16 *mix;
+  guint mix_size;
 } GstRemoveSilence;
 
 typedef struct _GstRemoveSilenceClass {
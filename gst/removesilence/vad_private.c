@@ -25,36 +25,24 @@
 #include <glib.h>
 #include "vad_private.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #define VAD_POWER_ALPHA     0x0800      /* Q16 */
 #define VAD_POWER_THRESHOLD 0x000010C7  /* -60 dB (square wave) */
 #define VAD_ZCR_THRESHOLD   0
 #define VAD_BUFFER_SIZE     256
 
-
-union pgen
-{
-  guint64 a;
-  gpointer v;
-  guint64 *l;
-  guchar *b;
-  guint16 *w;
-  gint16 *s;
-};
-
-struct _cqueue_s
-{
-  union pgen base;
-  union pgen tail;
-  union pgen head;
-  gint size;
-};
-
-typedef struct _cqueue_s cqueue_t;
+/* Number of past samples the zero crossing rate is computed on */
+#define VAD_HISTORY_SIZE    (VAD_BUFFER_SIZE - 1)
 
 struct _vad_s
 {
-  gint16 vad_buffer[VAD_BUFFER_SIZE];
-  cqueue_t cqueue;
+  gint16 history[VAD_HISTORY_SIZE];
+  gint history_len;
   gint vad_state;
   guint64 hysteresis;
   guint64 vad_samples;
@@ -75,9 +63,6 @@ void
 vad_reset (VADFilter * vad)
 {
   memset (vad, 0, sizeof (*vad));
-  vad->cqueue.base.s = vad->vad_buffer;
-  vad->cqueue.tail.a = vad->cqueue.head.a = 0;
-  vad->cqueue.size = VAD_BUFFER_SIZE;
   vad->vad_state = VAD_SILENCE;
 }
 
@@ -99,35 +84,121 @@ vad_get_hysteresis (struct _vad_s *p)
   return p->hysteresis;
 }
 
+/* Computes ((x * x) >> 14) & 0xFFFF, the energy fed to the power
+ * estimator, for a block of samples */
+static void
+vad_energy (guint16 * energy, const gint16 * data, gint len)
+{
+  gint i = 0;
+
+#if defined(__SSE2__)
+  for (; i + 8 <= len; i += 8) {
+    __m128i x = _mm_loadu_si128 ((const __m128i *) (data + i));
+    __m128i lo = _mm_mullo_epi16 (x, x);
+    __m128i hi = _mm_mulhi_epi16 (x, x);
+
+    _mm_storeu_si128 ((__m128i *) (energy + i),
+        _mm_or_si128 (_mm_slli_epi16 (hi, 2), _mm_srli_epi16 (lo, 14)));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  for (; i + 8 <= len; i += 8) {
+    int16x8_t x = vld1q_s16 (data + i);
+    int32x4_t lo = vmull_s16 (vget_low_s16 (x), vget_low_s16 (x));
+    int32x4_t hi = vmull_s16 (vget_high_s16 (x), vget_high_s16 (x));
+
+    vst1q_u16 (energy + i,
+        vcombine_u16 (vmovn_u32 (vreinterpretq_u32_s32 (vshrq_n_s32 (lo,
+                        14))), vmovn_u32 (vreinterpretq_u32_s32 (vshrq_n_s32
+                    (hi, 14)))));
+  }
+#endif
+
+  for (; i < len; i++)
+    energy[i] = (data[i] * data[i] >> 14) & 0xFFFF;
+}
+
+/* Counts the sign changes between consecutive samples */
+static gint
+vad_sign_changes (const gint16 * data, gint len)
+{
+  gint i = 0, changes = 0;
+
+#if defined(__SSE2__)
+  __m128i acc = _mm_setzero_si128 ();
+  gint16 lanes[8];
+
+  /* Each lane counts at most VAD_HISTORY_SIZE / 8 changes */
+  for (; i + 9 <= len; i += 8) {
+    __m128i a = _mm_loadu_si128 ((const __m128i *) (data + i));
+    __m128i b = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+
+    acc = _mm_sub_epi16 (acc, _mm_srai_epi16 (_mm_xor_si128 (a, b), 15));
+  }
+  _mm_storeu_si128 ((__m128i *) lanes, acc);
+  changes = lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] +
+      lanes[6] + lanes[7];
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  int16x8_t acc = vdupq_n_s16 (0);
+  gint16 lanes[8];
+
+  for (; i + 9 <= len; i += 8) {
+    int16x8_t a = vld1q_s16 (data + i);
+    int16x8_t b = vld1q_s16 (data + i + 1);
+
+    acc = vsubq_s16 (acc, vshrq_n_s16 (veorq_s16 (a, b), 15));
+  }
+  vst1q_s16 (lanes, acc);
+  changes = lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] +
+      lanes[6] + lanes[7];
+#endif
+
+  for (; i + 1 < len; i++)
+    changes += (data[i] ^ data[i + 1]) < 0;
+
+  return changes;
+}
+
+static void
+vad_update_history (struct _vad_s *p, const gint16 * data, gint len)
+{
+  if (len >= VAD_HISTORY_SIZE) {
+    memcpy (p->history, data + len - VAD_HISTORY_SIZE,
+        VAD_HISTORY_SIZE * sizeof (gint16));
+    p->history_len = VAD_HISTORY_SIZE;
+  } else {
+    gint keep = MIN (p->history_len, VAD_HISTORY_SIZE - len);
+
+    memmove (p->history, p->history + p->history_len - keep,
+        keep * sizeof (gint16));
+    memcpy (p->history + keep, data, len * sizeof (gint16));
+    p->history_len = keep + len;
+  }
+}
+
 gint
 vad_update (struct _vad_s * p, gint16 * data, gint len)
 {
-  guint64 tail;
+  guint16 energy[VAD_BUFFER_SIZE];
   gint frame_type;
-  gint16 sample;
-  gint i;
-
-  for (i = 0; i < len; i++) {
-    p->vad_power = VAD_POWER_ALPHA * ((data[i] * data[i] >> 14) & 0xFFFF) +
-        (0xFFFF - VAD_POWER_ALPHA) * (p->vad_power >> 16) +
-        ((0xFFFF - VAD_POWER_ALPHA) * (p->vad_power & 0xFFFF) >> 16);
-    /* Update VAD buffer */
-    p->cqueue.base.s[p->cqueue.head.a] = data[i];
-    p->cqueue.head.a = (p->cqueue.head.a + 1) & (p->cqueue.size - 1);
-    if (p->cqueue.head.a == p->cqueue.tail.a)
-      p->cqueue.tail.a = (p->cqueue.tail.a + 1) & (p->cqueue.size - 1);
+  gint i, j, n, pairs;
+
+  /* The energies are computed per block, only the recursive power estimator
+   * goes sample by sample */
+  for (i = 0; i < len; i += n) {
+    n = MIN (len - i, VAD_BUFFER_SIZE);
+    vad_energy (energy, data + i, n);
+
+    for (j = 0; j < n; j++)
+      p->vad_power = VAD_POWER_ALPHA * energy[j] +
+          (0xFFFF - VAD_POWER_ALPHA) * (p->vad_power >> 16) +
+          ((0xFFFF - VAD_POWER_ALPHA) * (p->vad_power & 0xFFFF) >> 16);
   }
 
-  tail = p->cqueue.tail.a;
-  p->vad_zcr = 0;
-  for (;;) {
-    sample = p->cqueue.base.s[tail];
-    tail = (tail + 1) & (p->cqueue.size - 1);
-    if (tail == p->cqueue.head.a)
-      break;
-    p->vad_zcr +=
-        ((sample & 0x8000) != (p->cqueue.base.s[tail] & 0x8000)) ? 1 : -1;
-  }
+  vad_update_history (p, data, len);
+
+  /* +1 for each sign change in the history, -1 otherwise */
+  pairs = MAX (p->history_len - 1, 0);
+  p->vad_zcr = 2 * vad_sign_changes (p->history, p->history_len) - pairs;
 
   frame_type = (p->vad_power > VAD_POWER_THRESHOLD
       && p->vad_zcr < VAD_ZCR_THRESHOLD) ? VAD_VOICE : VAD_SILENCE;
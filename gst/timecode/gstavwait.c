@@ -612,19 +612,24 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
       if (tc_meta)
         tc = &tc_meta->tc;
       if (self->tc != NULL && tc != NULL) {
-        if (gst_video_time_code_compare (tc, self->tc) < 0
-            && self->running_time_to_wait_for == GST_CLOCK_TIME_NONE) {
-          GST_DEBUG_OBJECT (self, "Timecode not yet reached, ignoring frame");
-          gst_buffer_unref (inbuf);
-          inbuf = NULL;
-        } else if (self->running_time_to_wait_for == GST_CLOCK_TIME_NONE) {
-          GST_INFO_OBJECT (self, "Target timecode reached at %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (self->vsegment.position));
-          self->running_time_to_wait_for =
-              gst_segment_to_running_time (&self->vsegment, GST_FORMAT_TIME,
-              self->vsegment.position);
+        /* once the target is reached, only the end timecode is compared */
+        if (self->running_time_to_wait_for == GST_CLOCK_TIME_NONE) {
+          if (gst_video_time_code_compare (tc, self->tc) < 0) {
+            GST_DEBUG_OBJECT (self, "Timecode not yet reached, ignoring frame");
+            gst_buffer_unref (inbuf);
+            inbuf = NULL;
+          } else {
+            GST_INFO_OBJECT (self, "Target timecode reached at %"
+                GST_TIME_FORMAT, GST_TIME_ARGS (self->vsegment.position));
+            self->running_time_to_wait_for =
+                gst_segment_to_running_time (&self->vsegment, GST_FORMAT_TIME,
+                self->vsegment.position);
+          }
         }
-        if (self->end_tc && gst_video_time_code_compare (tc, self->end_tc) >= 0) {
+        /* the end timecode is after the target, a frame before the target
+         * can't be after the end */
+        if (inbuf && self->end_tc
+            && gst_video_time_code_compare (tc, self->end_tc) >= 0) {
           if (self->running_time_to_end_at == GST_CLOCK_TIME_NONE) {
             GST_INFO_OBJECT (self, "End timecode reached at %" GST_TIME_FORMAT,
                 GST_TIME_ARGS (self->vsegment.position));
@@ -258,17 +258,70 @@ gst_timecodestamper_get_property (GObject * object, guint prop_id,
   }
 }
 
+/* Works out once per configuration how to count frames, so that
+ * incrementing the timecode is a few comparisons instead of converting to
+ * and from the number of frames since midnight */
+static void
+gst_timecodestamper_update_increment (GstTimeCodeStamper * timecodestamper)
+{
+  const GstVideoTimeCodeConfig *config =
+      &timecodestamper->current_tc->config;
+
+  timecodestamper->tc_fps = 0;
+  timecodestamper->tc_dropped = 0;
+
+  if (config->fps_d == 1 && config->fps_n > 0) {
+    timecodestamper->tc_fps = config->fps_n;
+  } else if (config->fps_d == 1001 && config->fps_n % 1000 == 0) {
+    timecodestamper->tc_fps = config->fps_n / 1000;
+    /* 2 frame numbers at 29.97, 4 at 59.94 */
+    if (config->flags & GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME)
+      timecodestamper->tc_dropped = timecodestamper->tc_fps / 15;
+  }
+}
+
+/* Must be called with object lock */
+static void
+gst_timecodestamper_increment_frame (GstTimeCodeStamper * timecodestamper)
+{
+  GstVideoTimeCode *tc = timecodestamper->current_tc;
+
+  if (timecodestamper->tc_fps == 0) {
+    gst_video_time_code_increment_frame (tc);
+    return;
+  }
+
+  if (++tc->frames < timecodestamper->tc_fps)
+    return;
+  tc->frames = 0;
+  if (++tc->seconds < 60)
+    return;
+  tc->seconds = 0;
+  if (++tc->minutes < 60) {
+    /* drop-frame skips the first frame numbers of every minute but the
+     * tenth ones */
+    if (tc->minutes % 10 != 0)
+      tc->frames = timecodestamper->tc_dropped;
+    return;
+  }
+  tc->minutes = 0;
+  if (++tc->hours >= 24)
+    tc->hours = 0;
+}
+
 static void
 gst_timecodestamper_set_drop_frame (GstTimeCodeStamper * timecodestamper)
 {
   if (timecodestamper->drop_frame && timecodestamper->vinfo.fps_d == 1001 &&
       (timecodestamper->vinfo.fps_n == 30000 ||
-          timecodestamper->vinfo.fps_d == 60000))
+          timecodestamper->vinfo.fps_n == 60000))
     timecodestamper->current_tc->config.flags |=
         GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME;
   else
     timecodestamper->current_tc->config.flags &=
         ~GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME;
+
+  gst_timecodestamper_update_increment (timecodestamper);
 }
 
 static gboolean
@@ -401,41 +454,44 @@ gst_timecodestamper_sink_event (GstBaseTransform * trans, GstEvent * event)
   return ret;
 }
 
-static gboolean
-remove_timecode_meta (GstBuffer * buffer, GstMeta ** meta, gpointer user_data)
-{
-  if (meta && *meta && (*meta)->info->api == GST_VIDEO_TIME_CODE_META_API_TYPE) {
-    *meta = NULL;
-  }
-
-  return TRUE;
-}
-
 static GstFlowReturn
 gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
     GstBuffer * buffer)
 {
   GstTimeCodeStamper *timecodestamper = GST_TIME_CODE_STAMPER (vfilter);
   GstVideoTimeCodeMeta *tc_meta;
-  GstVideoTimeCode *tc;
+  GstVideoTimeCode *tc = NULL;
+  gboolean post_messages;
 
   GST_OBJECT_LOCK (timecodestamper);
+  post_messages = timecodestamper->post_messages;
   tc_meta = gst_buffer_get_video_time_code_meta (buffer);
   if (tc_meta && !timecodestamper->override_existing) {
     GST_OBJECT_UNLOCK (timecodestamper);
-    tc = gst_video_time_code_copy (&tc_meta->tc);
+    if (post_messages)
+      tc = gst_video_time_code_copy (&tc_meta->tc);
     goto beach;
-  } else if (timecodestamper->override_existing) {
-    gst_buffer_foreach_meta (buffer, remove_timecode_meta, NULL);
   }
 
-  gst_buffer_add_video_time_code_meta (buffer, timecodestamper->current_tc);
-  tc = gst_video_time_code_copy (timecodestamper->current_tc);
-  gst_video_time_code_increment_frame (timecodestamper->current_tc);
+  if (tc_meta) {
+    GstVideoTimeCode *current_tc = timecodestamper->current_tc;
+
+    /* overwrite the existing meta instead of replacing it by a new one */
+    gst_video_time_code_clear (&tc_meta->tc);
+    gst_video_time_code_init (&tc_meta->tc, current_tc->config.fps_n,
+        current_tc->config.fps_d, current_tc->config.latest_daily_jam,
+        current_tc->config.flags, current_tc->hours, current_tc->minutes,
+        current_tc->seconds, current_tc->frames, current_tc->field_count);
+  } else {
+    gst_buffer_add_video_time_code_meta (buffer, timecodestamper->current_tc);
+  }
+  if (post_messages)
+    tc = gst_video_time_code_copy (timecodestamper->current_tc);
+  gst_timecodestamper_increment_frame (timecodestamper);
   GST_OBJECT_UNLOCK (timecodestamper);
 
 beach:
-  if (timecodestamper->post_messages) {
+  if (tc) {
     GstClockTime stream_time, running_time, duration;
     GstStructure *s;
     GstMessage *msg;
@@ -455,7 +511,7 @@ beach:
         duration, "timecode", GST_TYPE_VIDEO_TIME_CODE, tc, NULL);
     msg = gst_message_new_element (GST_OBJECT (timecodestamper), s);
     gst_element_post_message (GST_ELEMENT (timecodestamper), msg);
+    gst_video_time_code_free (tc);
   }
-  gst_video_time_code_free (tc);
   return GST_FLOW_OK;
 }
@@ -53,6 +53,11 @@ struct _GstTimeCodeStamper
   GstVideoInfo vinfo;
   gboolean post_messages;
   gboolean first_tc_now;
+
+  /* frames per second and frame numbers dropped each minute when counting
+   * current_tc up, or 0 to let GstVideoTimeCode do it */
+  guint tc_fps;
+  guint tc_dropped;
 };
 
 struct _GstTimeCodeStamperClass
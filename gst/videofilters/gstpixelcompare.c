@@ -0,0 +1,191 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* SSE2 and NEON versions of the per-pixel compare and threshold operations
+ * of videodiff, zebrastripe and scenechange, with a C tail. The stripes
+ * repeat every 8 pixels, so for the pixel strides supported their pattern
+ * repeats every 32 bytes, and the byte masks of a line are computed once in
+ * 32 byte tables that the 16 byte blocks index at their offset. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstpixelcompare.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#define PATTERN_SIZE 32
+
+static inline gboolean
+in_stripe (gint byte, gint pstride, gint phase)
+{
+  return ((byte / pstride + phase) & 0x4) != 0;
+}
+
+guint64
+pixel_compare_line_sad (const guint8 * s1, const guint8 * s2, gint width)
+{
+  guint64 sad = 0;
+  gint i = 0;
+
+#if defined(__SSE2__)
+  __m128i acc = _mm_setzero_si128 ();
+
+  /* the two 64 bit sums can't overflow for any line width */
+  for (; i + 16 <= width; i += 16) {
+    __m128i a = _mm_loadu_si128 ((const __m128i *) (s1 + i));
+    __m128i b = _mm_loadu_si128 ((const __m128i *) (s2 + i));
+
+    acc = _mm_add_epi64 (acc, _mm_sad_epu8 (a, b));
+  }
+  sad = _mm_cvtsi128_si32 (acc) +
+      _mm_cvtsi128_si32 (_mm_unpackhi_epi64 (acc, acc));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  uint32x4_t acc = vdupq_n_u32 (0);
+
+  for (; i + 16 <= width; i += 16) {
+    uint8x16_t d = vabdq_u8 (vld1q_u8 (s1 + i), vld1q_u8 (s2 + i));
+
+    acc = vpadalq_u16 (acc, vpaddlq_u8 (d));
+  }
+  sad = vgetq_lane_u32 (acc, 0) + vgetq_lane_u32 (acc, 1) +
+      vgetq_lane_u32 (acc, 2) + vgetq_lane_u32 (acc, 3);
+#endif
+
+  for (; i < width; i++)
+    sad += ABS (s1[i] - s2[i]);
+
+  return sad;
+}
+
+/* the luma samples of @s2 that differ from @s1 by more than @threshold are
+ * replaced by black and white stripes, everything else is copied */
+void
+pixel_compare_line_diff (guint8 * dest, const guint8 * s1, const guint8 * s2,
+    gint width, gint pstride, gint offset, gint threshold, gint phase)
+{
+  guint8 luma[PATTERN_SIZE], stripes[PATTERN_SIZE];
+  gint n = width * pstride;
+  gint i = 0;
+
+  for (i = 0; i < PATTERN_SIZE; i++) {
+    luma[i] = (i % pstride == offset) ? 0xff : 0;
+    stripes[i] = in_stripe (i, pstride, phase) ? 16 : 240;
+  }
+
+  i = 0;
+#if defined(__SSE2__)
+  {
+    const __m128i t = _mm_set1_epi8 ((gint8) MIN (threshold, 255));
+    const __m128i zero = _mm_setzero_si128 ();
+
+    for (; i + 16 <= n; i += 16) {
+      __m128i a = _mm_loadu_si128 ((const __m128i *) (s1 + i));
+      __m128i b = _mm_loadu_si128 ((const __m128i *) (s2 + i));
+      __m128i ad = _mm_or_si128 (_mm_subs_epu8 (a, b), _mm_subs_epu8 (b, a));
+      /* ad > t where the saturated difference is not zero */
+      __m128i m = _mm_andnot_si128 (_mm_cmpeq_epi8 (_mm_subs_epu8 (ad, t),
+              zero), _mm_loadu_si128 ((const __m128i *) (luma +
+                  i % PATTERN_SIZE)));
+      __m128i s = _mm_loadu_si128 ((const __m128i *) (stripes +
+              i % PATTERN_SIZE));
+
+      _mm_storeu_si128 ((__m128i *) (dest + i),
+          _mm_or_si128 (_mm_and_si128 (m, s), _mm_andnot_si128 (m, b)));
+    }
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  {
+    const uint8x16_t t = vdupq_n_u8 (MIN (threshold, 255));
+
+    for (; i + 16 <= n; i += 16) {
+      uint8x16_t b = vld1q_u8 (s2 + i);
+      uint8x16_t m = vandq_u8 (vcgtq_u8 (vabdq_u8 (vld1q_u8 (s1 + i), b), t),
+          vld1q_u8 (luma + i % PATTERN_SIZE));
+
+      vst1q_u8 (dest + i, vbslq_u8 (m, vld1q_u8 (stripes + i % PATTERN_SIZE),
+              b));
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    if (luma[i % PATTERN_SIZE] && ABS (s2[i] - s1[i]) > threshold)
+      dest[i] = stripes[i % PATTERN_SIZE];
+    else
+      dest[i] = s2[i];
+  }
+}
+
+/* the luma samples of at least @threshold that are in a stripe are set
+ * to black */
+void
+pixel_compare_line_zebra (guint8 * data, gint width, gint pstride,
+    gint offset, gint threshold, gint phase)
+{
+  guint8 mask[PATTERN_SIZE];
+  gint n = width * pstride;
+  gint i;
+
+  for (i = 0; i < PATTERN_SIZE; i++)
+    mask[i] = (i % pstride == offset && in_stripe (i, pstride, phase)) ?
+        0xff : 0;
+
+  i = 0;
+  if (threshold > 255)
+    return;
+
+#if defined(__SSE2__)
+  {
+    const __m128i t = _mm_set1_epi8 ((gint8) MAX (threshold, 0));
+    const __m128i black = _mm_set1_epi8 (16);
+
+    for (; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (data + i));
+      /* v >= t where max (v, t) is v */
+      __m128i m = _mm_and_si128 (_mm_cmpeq_epi8 (_mm_max_epu8 (v, t), v),
+          _mm_loadu_si128 ((const __m128i *) (mask + i % PATTERN_SIZE)));
+
+      _mm_storeu_si128 ((__m128i *) (data + i),
+          _mm_or_si128 (_mm_and_si128 (m, black), _mm_andnot_si128 (m, v)));
+    }
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  {
+    const uint8x16_t t = vdupq_n_u8 (MAX (threshold, 0));
+
+    for (; i + 16 <= n; i += 16) {
+      uint8x16_t v = vld1q_u8 (data + i);
+      uint8x16_t m = vandq_u8 (vcgeq_u8 (v, t),
+          vld1q_u8 (mask + i % PATTERN_SIZE));
+
+      vst1q_u8 (data + i, vbslq_u8 (m, vdupq_n_u8 (16), v));
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    if (mask[i % PATTERN_SIZE] && data[i] >= threshold)
+      data[i] = 16;
+  }
+}
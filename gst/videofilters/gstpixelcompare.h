@@ -0,0 +1,43 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_PIXEL_COMPARE_H_
+#define _GST_PIXEL_COMPARE_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Line operations shared by the filters of this plugin. The lines are
+ * @width pixels of @pstride bytes, the luma being at byte @offset of each
+ * pixel, and @pstride must be 1, 2 or 4. The stripes are 4 pixels wide and
+ * start at pixel -@phase. */
+
+guint64 pixel_compare_line_sad (const guint8 * s1, const guint8 * s2,
+    gint width);
+
+void pixel_compare_line_diff (guint8 * dest, const guint8 * s1,
+    const guint8 * s2, gint width, gint pstride, gint offset, gint threshold,
+    gint phase);
+
+void pixel_compare_line_zebra (guint8 * data, gint width, gint pstride,
+    gint offset, gint threshold, gint phase);
+
+G_END_DECLS
+
+#endif
@@ -31,6 +31,15 @@
  * can be used to align the synchronization points among multiple
  * video encoders, which is useful for segmented streaming.
  *
+ * Each frame also gets a #GstVideoSceneChangeMeta with its score, so
+ * downstream elements can reuse the analysis.
+ *
+ * The difference between two pictures is computed on the luma plane,
+ * either as the sum of absolute differences or as the difference of
+ * their luma histograms. #GstSceneChange:subsample only looks at every Nth
+ * pixel of every Nth line, which makes the detection much cheaper on large
+ * pictures.
+ *
  * The scenechange element does not work with compressed video.
  *
  * ## Example launch line
@@ -80,14 +89,20 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video/gstvideoscenechangemeta.h>
 #include <string.h>
 #include "gstscenechange.h"
+#include "gstpixelcompare.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
 #define GST_CAT_DEFAULT gst_scene_change_debug_category
 
 /* prototypes */
 
+static void gst_scene_change_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_scene_change_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_scene_change_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
@@ -99,9 +114,32 @@ static gboolean is_shot_change (int frame_number);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD,
+  PROP_SUBSAMPLE
 };
 
+#define DEFAULT_METHOD GST_SCENE_CHANGE_METHOD_SAD
+#define DEFAULT_SUBSAMPLE 1
+
+#define GST_TYPE_SCENE_CHANGE_METHOD (gst_scene_change_method_get_type ())
+static GType
+gst_scene_change_method_get_type (void)
+{
+  static GType method_type = 0;
+  static const GEnumValue methods[] = {
+    {GST_SCENE_CHANGE_METHOD_SAD, "Sum of absolute luma differences", "sad"},
+    {GST_SCENE_CHANGE_METHOD_HISTOGRAM, "Difference of the luma histograms",
+        "histogram"},
+    {0, NULL, NULL},
+  };
+
+  if (!method_type) {
+    method_type = g_enum_register_static ("GstSceneChangeMethod", methods);
+  }
+  return method_type;
+}
+
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, Y42B, Y41B, Y444 }")
 
@@ -115,8 +153,22 @@ G_DEFINE_TYPE_WITH_CODE (GstSceneChange, gst_scene_change,
 static void
 gst_scene_change_class_init (GstSceneChangeClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
+  gobject_class->set_property = gst_scene_change_set_property;
+  gobject_class->get_property = gst_scene_change_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method",
+          "How the difference between two pictures is measured",
+          GST_TYPE_SCENE_CHANGE_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SUBSAMPLE,
+      g_param_spec_uint ("subsample", "Subsample",
+          "Only use every Nth pixel of every Nth line", 1, 16,
+          DEFAULT_SUBSAMPLE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
       gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
           gst_caps_from_string (VIDEO_CAPS)));
@@ -137,15 +189,62 @@ gst_scene_change_class_init (GstSceneChangeClass * klass)
 static void
 gst_scene_change_init (GstSceneChange * scenechange)
 {
+  scenechange->method = DEFAULT_METHOD;
+  scenechange->subsample = DEFAULT_SUBSAMPLE;
+}
+
+static void
+gst_scene_change_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_METHOD:
+      scenechange->method = g_value_get_enum (value);
+      scenechange->have_hist = FALSE;
+      break;
+    case PROP_SUBSAMPLE:
+      scenechange->subsample = g_value_get_uint (value);
+      scenechange->have_hist = FALSE;
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
 }
 
+static void
+gst_scene_change_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_METHOD:
+      g_value_set_enum (value, scenechange->method);
+      break;
+    case PROP_SUBSAMPLE:
+      g_value_set_uint (value, scenechange->subsample);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
+}
 
+/* mean absolute difference of the luma samples, from 0 to 255 */
 static double
-get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
+get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2, guint subsample)
 {
   int i;
   int j;
-  int score = 0;
+  guint64 score = 0;
+  guint64 n_samples = 0;
   int width, height;
   guint8 *s1;
   guint8 *s2;
@@ -153,15 +252,56 @@ get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
   width = f1->info.width;
   height = f1->info.height;
 
-  for (j = 0; j < height; j++) {
+  for (j = 0; j < height; j += subsample) {
     s1 = (guint8 *) f1->data[0] + f1->info.stride[0] * j;
     s2 = (guint8 *) f2->data[0] + f2->info.stride[0] * j;
-    for (i = 0; i < width; i++) {
-      score += ABS (s1[i] - s2[i]);
+    if (subsample == 1) {
+      score += pixel_compare_line_sad (s1, s2, width);
+      n_samples += width;
+    } else {
+      for (i = 0; i < width; i += subsample) {
+        score += ABS (s1[i] - s2[i]);
+        n_samples++;
+      }
     }
   }
 
-  return ((double) score) / (width * height);
+  return n_samples ? ((double) score) / n_samples : 0.0;
+}
+
+static void
+get_frame_histogram (GstVideoFrame * frame, guint subsample,
+    guint32 hist[SC_N_BINS])
+{
+  int i, j;
+  int width = frame->info.width;
+  int height = frame->info.height;
+
+  memset (hist, 0, SC_N_BINS * sizeof (guint32));
+
+  for (j = 0; j < height; j += subsample) {
+    guint8 *s = (guint8 *) frame->data[0] + frame->info.stride[0] * j;
+
+    for (i = 0; i < width; i += subsample)
+      hist[s[i] * SC_N_BINS / 256]++;
+  }
+}
+
+/* half the sum of the bin differences relative to the number of samples,
+ * scaled to the 0 to 255 range of the SAD score */
+static double
+get_histogram_score (const guint32 h1[SC_N_BINS],
+    const guint32 h2[SC_N_BINS])
+{
+  guint64 diff = 0, n_samples = 0;
+  int k;
+
+  for (k = 0; k < SC_N_BINS; k++) {
+    diff += ABS ((gint64) h1[k] - (gint64) h2[k]);
+    n_samples += h1[k];
+  }
+
+  return n_samples ? 255.0 * diff / (2.0 * n_samples) : 0.0;
 }
 
 static GstFlowReturn
@@ -177,28 +317,68 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
   gboolean change;
   gboolean ret;
   int i;
+  GstSceneChangeMethod method;
+  guint subsample;
+  guint32 hist[SC_N_BINS];
+  gboolean had_hist;
 
   GST_DEBUG_OBJECT (scenechange, "transform_frame_ip");
 
+  GST_OBJECT_LOCK (scenechange);
+  method = scenechange->method;
+  subsample = scenechange->subsample;
+  had_hist = scenechange->have_hist;
+  GST_OBJECT_UNLOCK (scenechange);
+
+  if (method == GST_SCENE_CHANGE_METHOD_HISTOGRAM)
+    get_frame_histogram (frame, subsample, hist);
+
   if (!scenechange->oldbuf) {
     scenechange->n_diffs = 0;
     memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
     scenechange->oldbuf = gst_buffer_ref (frame->buffer);
     memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+    if (method == GST_SCENE_CHANGE_METHOD_HISTOGRAM) {
+      memcpy (scenechange->hist, hist, sizeof (hist));
+      scenechange->have_hist = TRUE;
+    }
+    gst_buffer_add_video_scene_change_meta (frame->buffer, 0.0, 0.0, FALSE);
     return GST_FLOW_OK;
   }
 
-  ret =
-      gst_video_frame_map (&oldframe, &scenechange->oldinfo,
-      scenechange->oldbuf, GST_MAP_READ);
-  if (!ret) {
-    GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
-    return GST_FLOW_ERROR;
-  }
+  if (method == GST_SCENE_CHANGE_METHOD_HISTOGRAM && had_hist) {
+    /* the histogram of the previous frame is kept, so the old frame does
+     * not need to be looked at again */
+    score = get_histogram_score (scenechange->hist, hist);
+  } else {
+    ret =
+        gst_video_frame_map (&oldframe, &scenechange->oldinfo,
+        scenechange->oldbuf, GST_MAP_READ);
+    if (!ret) {
+      GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
+      return GST_FLOW_ERROR;
+    }
 
-  score = get_frame_score (&oldframe, frame);
+    if (method == GST_SCENE_CHANGE_METHOD_HISTOGRAM) {
+      guint32 oldhist[SC_N_BINS];
 
-  gst_video_frame_unmap (&oldframe);
+      get_frame_histogram (&oldframe, subsample, oldhist);
+      score = get_histogram_score (oldhist, hist);
+    } else {
+      score = get_frame_score (&oldframe, frame, subsample);
+    }
+
+    gst_video_frame_unmap (&oldframe);
+  }
+
+  if (method == GST_SCENE_CHANGE_METHOD_HISTOGRAM) {
+    memcpy (scenechange->hist, hist, sizeof (hist));
+    GST_OBJECT_LOCK (scenechange);
+    /* unless the properties changed in the meantime */
+    scenechange->have_hist = method == scenechange->method &&
+        subsample == scenechange->subsample;
+    GST_OBJECT_UNLOCK (scenechange);
+  }
 
   gst_buffer_unref (scenechange->oldbuf);
   scenechange->oldbuf = gst_buffer_ref (frame->buffer);
@@ -234,6 +414,9 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
     change = FALSE;
   }
 
+  gst_buffer_add_video_scene_change_meta (frame->buffer, score, threshold,
+      change);
+
 #ifdef TESTING
   if (change != is_shot_change (scenechange->n_diffs)) {
     g_print ("%d %g %g %g %d\n", scenechange->n_diffs, score / threshold,
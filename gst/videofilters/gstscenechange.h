@@ -35,6 +35,13 @@ typedef struct _GstSceneChange GstSceneChange;
 typedef struct _GstSceneChangeClass GstSceneChangeClass;
 
 #define SC_N_DIFFS 5
+#define SC_N_BINS 64
+
+typedef enum
+{
+  GST_SCENE_CHANGE_METHOD_SAD,
+  GST_SCENE_CHANGE_METHOD_HISTOGRAM
+} GstSceneChangeMethod;
 
 struct _GstSceneChange
 {
@@ -45,6 +52,14 @@ struct _GstSceneChange
   GstBuffer *oldbuf;
   GstVideoInfo oldinfo;
   int count;
+
+  /* properties */
+  GstSceneChangeMethod method;
+  guint subsample;
+
+  /* luma histogram of the previous frame, for the histogram method */
+  guint32 hist[SC_N_BINS];
+  gboolean have_hist;
 };
 
 struct _GstSceneChangeClass
@@ -23,6 +23,9 @@
  * The videodiff element highlights the difference between a frame and its
  * previous on the luma plane.
  *
+ * The frames are processed in horizontal slices by #GstVideoDiff:n-threads
+ * threads.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v videotestsrc pattern=ball ! videodiff ! videoconvert ! autovideosink
@@ -38,20 +41,35 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include "gstvideodiff.h"
+#include "gstpixelcompare.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_video_diff_debug_category);
 #define GST_CAT_DEFAULT gst_video_diff_debug_category
 
 /* prototypes */
 
+static void gst_video_diff_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_video_diff_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_video_diff_finalize (GObject * object);
+
 static GstFlowReturn gst_video_diff_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * inframe, GstVideoFrame * outframe);
 
+enum
+{
+  PROP_0,
+  PROP_N_THREADS
+};
+
+#define DEFAULT_N_THREADS 1
+
 #define VIDEO_SRC_CAPS \
-    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B }")
+    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B, NV12, NV21, AYUV }")
 
 #define VIDEO_SINK_CAPS \
-    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B }")
+    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B, NV12, NV21, AYUV }")
 
 
 G_DEFINE_TYPE_WITH_CODE (GstVideoDiff, gst_video_diff, GST_TYPE_VIDEO_FILTER,
@@ -61,8 +79,13 @@ G_DEFINE_TYPE_WITH_CODE (GstVideoDiff, gst_video_diff, GST_TYPE_VIDEO_FILTER,
 static void
 gst_video_diff_class_init (GstVideoDiffClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
+  gobject_class->set_property = gst_video_diff_set_property;
+  gobject_class->get_property = gst_video_diff_get_property;
+  gobject_class->finalize = gst_video_diff_finalize;
+
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
       gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
           gst_caps_from_string (VIDEO_SRC_CAPS)));
@@ -77,50 +100,130 @@ gst_video_diff_class_init (GstVideoDiffClass * klass)
 
   video_filter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_video_diff_transform_frame);
+
+  /**
+   * GstVideoDiff:n-threads:
+   *
+   * Number of threads processing slices of each frame, 0 uses one thread
+   * per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads processing each frame (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_video_diff_init (GstVideoDiff * videodiff)
 {
   videodiff->threshold = 10;
+  videodiff->n_threads = DEFAULT_N_THREADS;
+  gst_video_slices_init (&videodiff->slices);
 }
 
-static GstFlowReturn
-gst_video_diff_transform_frame_ip_planarY (GstVideoDiff * videodiff,
-    GstVideoFrame * outframe, GstVideoFrame * inframe, GstVideoFrame * oldframe)
+static void
+gst_video_diff_finalize (GObject * object)
 {
-  int width = inframe->info.width;
-  int height = inframe->info.height;
-  int i, j;
-  int threshold = videodiff->threshold;
-  int t = videodiff->t;
-
-  for (j = 0; j < height; j++) {
-    guint8 *d = (guint8 *) outframe->data[0] + outframe->info.stride[0] * j;
-    guint8 *s1 = (guint8 *) oldframe->data[0] + oldframe->info.stride[0] * j;
-    guint8 *s2 = (guint8 *) inframe->data[0] + inframe->info.stride[0] * j;
-    for (i = 0; i < width; i++) {
-      if ((s2[i] < s1[i] - threshold) || (s2[i] > s1[i] + threshold)) {
-        if ((i + j + t) & 0x4) {
-          d[i] = 16;
-        } else {
-          d[i] = 240;
-        }
-      } else {
-        d[i] = s2[i];
-      }
-    }
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  gst_buffer_replace (&videodiff->previous_buffer, NULL);
+  gst_video_slices_clear (&videodiff->slices);
+
+  G_OBJECT_CLASS (gst_video_diff_parent_class)->finalize (object);
+}
+
+static void
+gst_video_diff_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (videodiff);
+      videodiff->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videodiff);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
   }
-  for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 1); j++) {
-    guint8 *d = (guint8 *) outframe->data[1] + outframe->info.stride[1] * j;
-    guint8 *s = (guint8 *) inframe->data[1] + inframe->info.stride[1] * j;
-    memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, 1));
+}
+
+static void
+gst_video_diff_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (videodiff);
+      g_value_set_uint (value, videodiff->n_threads);
+      GST_OBJECT_UNLOCK (videodiff);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
   }
-  for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 2); j++) {
-    guint8 *d = (guint8 *) outframe->data[2] + outframe->info.stride[2] * j;
-    guint8 *s = (guint8 *) inframe->data[2] + inframe->info.stride[2] * j;
-    memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, 2));
+}
+
+typedef struct
+{
+  GstVideoDiff *videodiff;
+  GstVideoFrame *outframe;
+  GstVideoFrame *inframe;
+  GstVideoFrame *oldframe;
+} GstVideoDiffSlice;
+
+/* stripes the luma of the lines [y_start, y_end) that changed since the
+ * previous frame, the other components of packed formats are copied */
+static void
+gst_video_diff_slice_luma (gpointer user_data, gint y_start, gint y_end)
+{
+  GstVideoDiffSlice *slice = user_data;
+  GstVideoFrame *inframe = slice->inframe;
+  int width = GST_VIDEO_FRAME_WIDTH (inframe);
+  int pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (inframe, 0);
+  int offset = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 0);
+  int threshold = slice->videodiff->threshold;
+  int t = slice->videodiff->t;
+  int j;
+
+  for (j = y_start; j < y_end; j++) {
+    guint8 *d = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (slice->outframe, 0) +
+        GST_VIDEO_FRAME_PLANE_STRIDE (slice->outframe, 0) * j;
+    guint8 *s1 = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (slice->oldframe, 0) +
+        GST_VIDEO_FRAME_PLANE_STRIDE (slice->oldframe, 0) * j;
+    guint8 *s2 = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (inframe, 0) +
+        GST_VIDEO_FRAME_PLANE_STRIDE (inframe, 0) * j;
+
+    pixel_compare_line_diff (d, s1, s2, width, pstride, offset, threshold,
+        j + t);
   }
+}
+
+static GstFlowReturn
+gst_video_diff_transform_frame_luma (GstVideoDiff * videodiff,
+    GstVideoFrame * outframe, GstVideoFrame * inframe, GstVideoFrame * oldframe)
+{
+  GstVideoDiffSlice slice = { videodiff, outframe, inframe, oldframe };
+  guint n_threads;
+  guint i;
+
+  GST_OBJECT_LOCK (videodiff);
+  n_threads = videodiff->n_threads;
+  GST_OBJECT_UNLOCK (videodiff);
+
+  gst_video_slices_run (&videodiff->slices, n_threads,
+      GST_VIDEO_FRAME_HEIGHT (inframe), gst_video_diff_slice_luma, &slice);
+
+  for (i = 1; i < GST_VIDEO_FRAME_N_PLANES (inframe); i++)
+    gst_video_frame_copy_plane (outframe, inframe, i);
+
   return GST_FLOW_OK;
 }
 
@@ -143,7 +246,10 @@ gst_video_diff_transform_frame (GstVideoFilter * filter,
       case GST_VIDEO_FORMAT_Y41B:
       case GST_VIDEO_FORMAT_Y444:
       case GST_VIDEO_FORMAT_Y42B:
-        gst_video_diff_transform_frame_ip_planarY (videodiff, outframe,
+      case GST_VIDEO_FORMAT_NV12:
+      case GST_VIDEO_FORMAT_NV21:
+      case GST_VIDEO_FORMAT_AYUV:
+        gst_video_diff_transform_frame_luma (videodiff, outframe,
             inframe, &oldframe);
         break;
       default:
@@ -153,15 +259,7 @@ gst_video_diff_transform_frame (GstVideoFilter * filter,
     gst_video_frame_unmap (&oldframe);
     gst_buffer_unref (videodiff->previous_buffer);
   } else {
-    int k;
-    int j;
-    for (k = 0; k < 3; k++) {
-      for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, k); j++) {
-        guint8 *d = (guint8 *) outframe->data[k] + outframe->info.stride[k] * j;
-        guint8 *s = (guint8 *) inframe->data[k] + inframe->info.stride[k] * j;
-        memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, k));
-      }
-    }
+    gst_video_frame_copy (outframe, inframe);
   }
 
   videodiff->previous_buffer = gst_buffer_ref (inframe->buffer);
@@ -24,6 +24,8 @@
 #include <gst/video/gstvideofilter.h>
 #include <string.h>
 
+#include "gstvideoslices.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_VIDEO_DIFF   (gst_video_diff_get_type())
@@ -44,6 +46,9 @@ struct _GstVideoDiff
 
   int threshold;
   int t;
+
+  guint n_threads;
+  GstVideoSlices slices;
 };
 
 struct _GstVideoDiffClass
@@ -0,0 +1,112 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvideoslices.h"
+
+typedef struct
+{
+  GstVideoSlices *slices;
+  GstVideoSliceFunc func;
+  gpointer user_data;
+  gint y_start, y_end;
+} GstVideoSlice;
+
+static void
+gst_video_slices_worker_func (gpointer data, gpointer user_data)
+{
+  GstVideoSlice *slice = data;
+  GstVideoSlices *slices = slice->slices;
+
+  slice->func (slice->user_data, slice->y_start, slice->y_end);
+
+  g_mutex_lock (&slices->lock);
+  if (--slices->pending == 0)
+    g_cond_signal (&slices->cond);
+  g_mutex_unlock (&slices->lock);
+}
+
+void
+gst_video_slices_init (GstVideoSlices * slices)
+{
+  slices->pool = NULL;
+  slices->pending = 0;
+  g_mutex_init (&slices->lock);
+  g_cond_init (&slices->cond);
+}
+
+void
+gst_video_slices_clear (GstVideoSlices * slices)
+{
+  if (slices->pool)
+    g_thread_pool_free (slices->pool, FALSE, TRUE);
+  slices->pool = NULL;
+  g_mutex_clear (&slices->lock);
+  g_cond_clear (&slices->cond);
+}
+
+/* Calls @func on @n_threads slices of the lines [0, @height), 0 threads
+ * meaning one per processor, and returns once all of them are done */
+void
+gst_video_slices_run (GstVideoSlices * slices, guint n_threads, gint height,
+    GstVideoSliceFunc func, gpointer user_data)
+{
+  GstVideoSlice *tasks;
+  gint n_slices, i;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_slices = CLAMP ((gint) MIN (n_threads, G_MAXINT), 1, MAX (height, 1));
+
+  if (n_slices == 1) {
+    func (user_data, 0, height);
+    return;
+  }
+
+  tasks = g_new (GstVideoSlice, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    tasks[i].slices = slices;
+    tasks[i].func = func;
+    tasks[i].user_data = user_data;
+    tasks[i].y_start = height * i / n_slices;
+    tasks[i].y_end = height * (i + 1) / n_slices;
+  }
+
+  if (!slices->pool) {
+    slices->pool = g_thread_pool_new (gst_video_slices_worker_func, NULL,
+        n_slices - 1, FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (slices->pool) < n_slices - 1) {
+    g_thread_pool_set_max_threads (slices->pool, n_slices - 1, NULL);
+  }
+
+  slices->pending = n_slices - 1;
+  for (i = 1; i < n_slices; i++)
+    g_thread_pool_push (slices->pool, &tasks[i], NULL);
+
+  func (user_data, tasks[0].y_start, tasks[0].y_end);
+
+  g_mutex_lock (&slices->lock);
+  while (slices->pending > 0)
+    g_cond_wait (&slices->cond, &slices->lock);
+  g_mutex_unlock (&slices->lock);
+
+  g_free (tasks);
+}
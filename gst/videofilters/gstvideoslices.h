@@ -0,0 +1,46 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_VIDEO_SLICES_H_
+#define _GST_VIDEO_SLICES_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef void (*GstVideoSliceFunc) (gpointer user_data, gint y_start,
+    gint y_end);
+
+/* Runs a function on horizontal slices of a frame, the first slice in the
+ * calling thread and the others in a pool owned by the filter */
+typedef struct
+{
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  gint pending;
+} GstVideoSlices;
+
+void gst_video_slices_init (GstVideoSlices * slices);
+void gst_video_slices_clear (GstVideoSlices * slices);
+void gst_video_slices_run (GstVideoSlices * slices, guint n_threads,
+    gint height, GstVideoSliceFunc func, gpointer user_data);
+
+G_END_DECLS
+
+#endif
@@ -50,6 +50,7 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include "gstzebrastripe.h"
+#include "gstpixelcompare.h"
 #include <math.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_zebra_stripe_debug_category);
@@ -64,6 +65,7 @@ static void gst_zebra_stripe_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
 static gboolean gst_zebra_stripe_start (GstBaseTransform * trans);
 static gboolean gst_zebra_stripe_stop (GstBaseTransform * trans);
+static void gst_zebra_stripe_finalize (GObject * object);
 
 static GstFlowReturn gst_zebra_stripe_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
@@ -71,10 +73,12 @@ static GstFlowReturn gst_zebra_stripe_transform_frame_ip (GstVideoFilter *
 enum
 {
   PROP_0,
-  PROP_THRESHOLD
+  PROP_THRESHOLD,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_THRESHOLD 90
+#define DEFAULT_N_THREADS 1
 
 /* pad templates */
 
@@ -114,6 +118,7 @@ gst_zebra_stripe_class_init (GstZebraStripeClass * klass)
 
   gobject_class->set_property = gst_zebra_stripe_set_property;
   gobject_class->get_property = gst_zebra_stripe_get_property;
+  gobject_class->finalize = gst_zebra_stripe_finalize;
   base_transform_class->start = GST_DEBUG_FUNCPTR (gst_zebra_stripe_start);
   base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_zebra_stripe_stop);
   video_filter_class->transform_frame_ip =
@@ -124,11 +129,37 @@ gst_zebra_stripe_class_init (GstZebraStripeClass * klass)
           "Threshold above which the video is striped", 0, 100,
           DEFAULT_THRESHOLD,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstZebraStripe:n-threads:
+   *
+   * Number of threads processing slices of each frame, 0 uses one thread
+   * per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads processing each frame (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_zebra_stripe_init (GstZebraStripe * zebrastripe)
 {
+  zebrastripe->n_threads = DEFAULT_N_THREADS;
+  gst_video_slices_init (&zebrastripe->slices);
+}
+
+static void
+gst_zebra_stripe_finalize (GObject * object)
+{
+  GstZebraStripe *zebrastripe = GST_ZEBRA_STRIPE (object);
+
+  gst_video_slices_clear (&zebrastripe->slices);
+
+  G_OBJECT_CLASS (gst_zebra_stripe_parent_class)->finalize (object);
 }
 
 void
@@ -145,6 +176,11 @@ gst_zebra_stripe_set_property (GObject * object, guint property_id,
       zebrastripe->y_threshold =
           16 + floor (0.5 + 2.19 * zebrastripe->threshold);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (zebrastripe);
+      zebrastripe->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (zebrastripe);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -163,6 +199,11 @@ gst_zebra_stripe_get_property (GObject * object, guint property_id,
     case PROP_THRESHOLD:
       g_value_set_int (value, zebrastripe->threshold);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (zebrastripe);
+      g_value_set_uint (value, zebrastripe->n_threads);
+      GST_OBJECT_UNLOCK (zebrastripe);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -199,22 +240,46 @@ gst_zebra_stripe_stop (GstBaseTransform * trans)
   return TRUE;
 }
 
+typedef struct
+{
+  GstVideoFrame *frame;
+  int threshold;
+  int t;
+  int offset;
+} GstZebraStripeSlice;
+
+static void
+gst_zebra_stripe_slice (gpointer user_data, gint y_start, gint y_end)
+{
+  GstZebraStripeSlice *slice = user_data;
+  GstVideoFrame *frame = slice->frame;
+  int width = frame->info.width;
+  int pixel_stride = GST_VIDEO_FORMAT_INFO_PSTRIDE (frame->info.finfo, 0);
+  int j;
+
+  for (j = y_start; j < y_end; j++) {
+    guint8 *data = (guint8 *) frame->data[0] + frame->info.stride[0] * j;
+
+    pixel_compare_line_zebra (data, width, pixel_stride, slice->offset,
+        slice->threshold, j + slice->t);
+  }
+}
+
 static GstFlowReturn
 gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
 {
   GstZebraStripe *zebrastripe = GST_ZEBRA_STRIPE (filter);
-  int width = frame->info.width;
-  int height = frame->info.height;
-  int i, j;
-  int threshold = zebrastripe->y_threshold;
-  int t = zebrastripe->t;
-  int offset = 0;
-  int pixel_stride = 0, y_position = 0;
+  GstZebraStripeSlice slice;
+  guint n_threads;
 
   GST_DEBUG_OBJECT (zebrastripe, "transform_frame_ip");
+
+  slice.frame = frame;
+  slice.threshold = zebrastripe->y_threshold;
+  slice.t = zebrastripe->t;
+  slice.offset = 0;
   zebrastripe->t++;
-  pixel_stride = GST_VIDEO_FORMAT_INFO_PSTRIDE (frame->info.finfo, 0);
 
   switch (frame->info.finfo->format) {
     case GST_VIDEO_FORMAT_I420:
@@ -227,25 +292,20 @@ gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
     case GST_VIDEO_FORMAT_YV12:
       break;
     case GST_VIDEO_FORMAT_UYVY:
-      offset = 1;
-      break;
     case GST_VIDEO_FORMAT_AYUV:
-      y_position = 1;
+      /* byte of the luma in each pixel */
+      slice.offset = 1;
       break;
     default:
       g_assert_not_reached ();
   }
 
-  for (j = 0; j < height; j++) {
-    guint8 *data =
-        (guint8 *) frame->data[0] + frame->info.stride[0] * j + offset;
-    for (i = 0; i < width; i++) {
-      if (data[pixel_stride * i + y_position] >= threshold) {
-        if ((i + j + t) & 0x4)
-          data[pixel_stride * i + y_position] = 16;
-      }
-    }
-  }
+  GST_OBJECT_LOCK (zebrastripe);
+  n_threads = zebrastripe->n_threads;
+  GST_OBJECT_UNLOCK (zebrastripe);
+
+  gst_video_slices_run (&zebrastripe->slices, n_threads, frame->info.height,
+      gst_zebra_stripe_slice, &slice);
 
   return GST_FLOW_OK;
 }
@@ -23,6 +23,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gstvideoslices.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_ZEBRA_STRIPE   (gst_zebra_stripe_get_type())
@@ -40,10 +42,12 @@ struct _GstZebraStripe
 
   /* properties */
   int threshold;
+  guint n_threads;
 
   /* state */
   int t;
   int y_threshold;
+  GstVideoSlices slices;
 };
 
 struct _GstZebraStripeClass
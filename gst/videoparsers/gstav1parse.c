@@ -0,0 +1,1057 @@
+/* GStreamer AV1 parser
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-av1parse
+ * @title: av1parse
+ *
+ * Parses AV1 streams, frames them in temporal units or OBUs, flags
+ * keyframes and converts between the low overhead "obu-stream" format and
+ * the length delimited "annexb" format.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=video.obu ! av1parse ! matroskamux ! filesink location=video.mkv
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/base/base.h>
+#include "gstav1parse.h"
+
+GST_DEBUG_CATEGORY (av1_parse_debug);
+#define GST_CAT_DEFAULT av1_parse_debug
+
+enum
+{
+  GST_AV1_PARSE_FORMAT_NONE,
+  GST_AV1_PARSE_FORMAT_OBU_STREAM,
+  GST_AV1_PARSE_FORMAT_ANNEXB
+};
+
+enum
+{
+  GST_AV1_PARSE_ALIGN_NONE = 0,
+  GST_AV1_PARSE_ALIGN_OBU,
+  GST_AV1_PARSE_ALIGN_TU
+};
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-av1"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-av1, parsed = (boolean) true, "
+        "stream-format = (string) obu-stream, "
+        "alignment = (string) { tu, obu }; "
+        "video/x-av1, parsed = (boolean) true, "
+        "stream-format = (string) annexb, alignment = (string) tu"));
+
+/* a temporal delimiter OBU, with an empty payload */
+static const guint8 temporal_delimiter[] = { 0x12, 0x00 };
+
+#define parent_class gst_av1_parse_parent_class
+G_DEFINE_TYPE (GstAV1Parse, gst_av1_parse, GST_TYPE_BASE_PARSE);
+
+static void gst_av1_parse_finalize (GObject * object);
+
+static gboolean gst_av1_parse_start (GstBaseParse * parse);
+static gboolean gst_av1_parse_stop (GstBaseParse * parse);
+static GstFlowReturn gst_av1_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize);
+static gboolean gst_av1_parse_set_caps (GstBaseParse * parse, GstCaps * caps);
+static GstCaps *gst_av1_parse_get_caps (GstBaseParse * parse,
+    GstCaps * filter);
+static gboolean gst_av1_parse_event (GstBaseParse * parse, GstEvent * event);
+
+static void
+gst_av1_parse_class_init (GstAV1ParseClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (av1_parse_debug, "av1parse", 0, "av1 parser");
+
+  gobject_class->finalize = gst_av1_parse_finalize;
+
+  /* Override BaseParse vfuncs */
+  parse_class->start = GST_DEBUG_FUNCPTR (gst_av1_parse_start);
+  parse_class->stop = GST_DEBUG_FUNCPTR (gst_av1_parse_stop);
+  parse_class->handle_frame = GST_DEBUG_FUNCPTR (gst_av1_parse_handle_frame);
+  parse_class->set_sink_caps = GST_DEBUG_FUNCPTR (gst_av1_parse_set_caps);
+  parse_class->get_sink_caps = GST_DEBUG_FUNCPTR (gst_av1_parse_get_caps);
+  parse_class->sink_event = GST_DEBUG_FUNCPTR (gst_av1_parse_event);
+
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+
+  gst_element_class_set_static_metadata (gstelement_class, "AV1 parser",
+      "Codec/Parser/Converter/Video",
+      "Parses AV1 streams", "GStreamer maintainers "
+      "<gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_av1_parse_init (GstAV1Parse * av1parse)
+{
+  av1parse->frame_out = gst_adapter_new ();
+  av1parse->frame_unit = gst_adapter_new ();
+  gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (av1parse), FALSE);
+  GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (av1parse));
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (av1parse));
+}
+
+static void
+gst_av1_parse_finalize (GObject * object)
+{
+  GstAV1Parse *av1parse = GST_AV1_PARSE (object);
+
+  g_object_unref (av1parse->frame_out);
+  g_object_unref (av1parse->frame_unit);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_av1_parse_reset_frame (GstAV1Parse * av1parse)
+{
+  GST_LOG_OBJECT (av1parse, "reset frame");
+
+  av1parse->last_parsed_offset = 0;
+  av1parse->tu_started = FALSE;
+  av1parse->header = FALSE;
+  /* with OBU alignment the keyframe flag lasts for the temporal unit */
+  if (av1parse->align != GST_AV1_PARSE_ALIGN_OBU)
+    av1parse->keyframe = FALSE;
+  gst_adapter_clear (av1parse->frame_out);
+  gst_adapter_clear (av1parse->frame_unit);
+  av1parse->frame_unit_has_frame = FALSE;
+}
+
+static void
+gst_av1_parse_reset (GstAV1Parse * av1parse)
+{
+  av1parse->width = 0;
+  av1parse->height = 0;
+  av1parse->fps_num = 0;
+  av1parse->fps_den = 0;
+  av1parse->upstream_fps_num = 0;
+  av1parse->upstream_fps_den = 0;
+  av1parse->update_caps = TRUE;
+
+  av1parse->in_format = GST_AV1_PARSE_FORMAT_NONE;
+  av1parse->in_align = GST_AV1_PARSE_ALIGN_NONE;
+  av1parse->format = GST_AV1_PARSE_FORMAT_NONE;
+  av1parse->align = GST_AV1_PARSE_ALIGN_NONE;
+  av1parse->packetized = FALSE;
+
+  av1parse->in_frame = FALSE;
+  av1parse->keyframe = FALSE;
+
+  gst_av1_parse_reset_frame (av1parse);
+}
+
+static gboolean
+gst_av1_parse_start (GstBaseParse * parse)
+{
+  GstAV1Parse *av1parse = GST_AV1_PARSE (parse);
+
+  GST_DEBUG_OBJECT (parse, "start");
+  gst_av1_parse_reset (av1parse);
+
+  av1parse->parser = gst_av1_parser_new ();
+
+  return TRUE;
+}
+
+static gboolean
+gst_av1_parse_stop (GstBaseParse * parse)
+{
+  GstAV1Parse *av1parse = GST_AV1_PARSE (parse);
+
+  GST_DEBUG_OBJECT (parse, "stop");
+  gst_av1_parse_reset (av1parse);
+
+  gst_av1_parser_free (av1parse->parser);
+  av1parse->parser = NULL;
+
+  return TRUE;
+}
+
+static const gchar *
+gst_av1_parse_get_string (GstAV1Parse * parse, gboolean format, gint code)
+{
+  if (format) {
+    switch (code) {
+      case GST_AV1_PARSE_FORMAT_OBU_STREAM:
+        return "obu-stream";
+      case GST_AV1_PARSE_FORMAT_ANNEXB:
+        return "annexb";
+      default:
+        return "none";
+    }
+  } else {
+    switch (code) {
+      case GST_AV1_PARSE_ALIGN_OBU:
+        return "obu";
+      case GST_AV1_PARSE_ALIGN_TU:
+        return "tu";
+      default:
+        return "none";
+    }
+  }
+}
+
+static void
+gst_av1_parse_format_from_caps (GstCaps * caps, guint * format, guint * align)
+{
+  g_return_if_fail (gst_caps_is_fixed (caps));
+
+  GST_DEBUG ("parsing caps: %" GST_PTR_FORMAT, caps);
+
+  if (format)
+    *format = GST_AV1_PARSE_FORMAT_NONE;
+
+  if (align)
+    *align = GST_AV1_PARSE_ALIGN_NONE;
+
+  if (caps && gst_caps_get_size (caps) > 0) {
+    GstStructure *s = gst_caps_get_structure (caps, 0);
+    const gchar *str = NULL;
+
+    if (format) {
+      if ((str = gst_structure_get_string (s, "stream-format"))) {
+        if (strcmp (str, "obu-stream") == 0)
+          *format = GST_AV1_PARSE_FORMAT_OBU_STREAM;
+        else if (strcmp (str, "annexb") == 0)
+          *format = GST_AV1_PARSE_FORMAT_ANNEXB;
+      }
+    }
+
+    if (align) {
+      if ((str = gst_structure_get_string (s, "alignment"))) {
+        /* a frame aligned stream has one shown frame per buffer, so that
+         * is a temporal unit too */
+        if (strcmp (str, "tu") == 0 || strcmp (str, "frame") == 0)
+          *align = GST_AV1_PARSE_ALIGN_TU;
+        else if (strcmp (str, "obu") == 0)
+          *align = GST_AV1_PARSE_ALIGN_OBU;
+      }
+    }
+  }
+}
+
+/* check downstream caps to configure format and alignment */
+static void
+gst_av1_parse_negotiate (GstAV1Parse * av1parse, GstCaps * in_caps)
+{
+  GstCaps *caps;
+  guint format = GST_AV1_PARSE_FORMAT_NONE;
+  guint align = GST_AV1_PARSE_ALIGN_NONE;
+
+  g_return_if_fail ((in_caps == NULL) || gst_caps_is_fixed (in_caps));
+
+  caps = gst_pad_get_allowed_caps (GST_BASE_PARSE_SRC_PAD (av1parse));
+  GST_DEBUG_OBJECT (av1parse, "allowed caps: %" GST_PTR_FORMAT, caps);
+
+  /* concentrate on leading structure, since decodebin parser
+   * capsfilter always includes parser template caps */
+  if (caps) {
+    caps = gst_caps_truncate (caps);
+    GST_DEBUG_OBJECT (av1parse, "negotiating with caps: %" GST_PTR_FORMAT,
+        caps);
+  }
+
+  if (in_caps && caps) {
+    if (gst_caps_can_intersect (in_caps, caps)) {
+      GST_DEBUG_OBJECT (av1parse, "downstream accepts upstream caps");
+      gst_av1_parse_format_from_caps (in_caps, &format, &align);
+      gst_caps_unref (caps);
+      caps = NULL;
+    }
+  }
+
+  if (caps && !gst_caps_is_empty (caps)) {
+    /* fixate to avoid ambiguity with lists when parsing */
+    caps = gst_caps_fixate (caps);
+    gst_av1_parse_format_from_caps (caps, &format, &align);
+  }
+
+  /* default */
+  if (!format)
+    format = GST_AV1_PARSE_FORMAT_OBU_STREAM;
+  if (!align || format == GST_AV1_PARSE_FORMAT_ANNEXB)
+    align = GST_AV1_PARSE_ALIGN_TU;
+
+  GST_DEBUG_OBJECT (av1parse, "selected format %s, alignment %s",
+      gst_av1_parse_get_string (av1parse, TRUE, format),
+      gst_av1_parse_get_string (av1parse, FALSE, align));
+
+  av1parse->format = format;
+  av1parse->align = align;
+
+  if (caps)
+    gst_caps_unref (caps);
+}
+
+static GstBuffer *
+gst_av1_parse_leb128_buffer (guint64 value)
+{
+  GstBuffer *buf;
+  guint8 data[8];
+  guint32 n;
+
+  n = gst_av1_parser_write_leb128 (value, data);
+  buf = gst_buffer_new_allocate (NULL, n, NULL);
+  gst_buffer_fill (buf, 0, data, n);
+
+  return buf;
+}
+
+/* moves the OBUs of the current Annex B frame unit to the output, with the
+ * frame_unit_size in front */
+static void
+gst_av1_parse_close_frame_unit (GstAV1Parse * av1parse)
+{
+  gsize avail = gst_adapter_available (av1parse->frame_unit);
+
+  if (avail > 0) {
+    gst_adapter_push (av1parse->frame_out,
+        gst_av1_parse_leb128_buffer (avail));
+    gst_adapter_push (av1parse->frame_out,
+        gst_adapter_take_buffer_fast (av1parse->frame_unit, avail));
+  }
+  av1parse->frame_unit_has_frame = FALSE;
+}
+
+/* appends a complete OBU to the output of the current frame, @new_frame is
+ * set on the first OBU of each frame */
+static void
+gst_av1_parse_push_data (GstAV1Parse * av1parse, GstBuffer * buf,
+    gboolean new_frame)
+{
+  if (av1parse->format == GST_AV1_PARSE_FORMAT_ANNEXB) {
+    if (new_frame) {
+      if (av1parse->frame_unit_has_frame)
+        gst_av1_parse_close_frame_unit (av1parse);
+      av1parse->frame_unit_has_frame = TRUE;
+    }
+    gst_adapter_push (av1parse->frame_unit,
+        gst_av1_parse_leb128_buffer (gst_buffer_get_size (buf)));
+    gst_adapter_push (av1parse->frame_unit, buf);
+  } else {
+    gst_adapter_push (av1parse->frame_out, buf);
+  }
+}
+
+static void
+gst_av1_parse_push_obu (GstAV1Parse * av1parse, GstAV1OBU * obu,
+    GstBuffer * buffer, guint offset, guint size, gboolean new_frame)
+{
+  GstBuffer *buf;
+
+  /* every temporal unit starts with a temporal delimiter, which containers
+   * strip */
+  if (av1parse->align == GST_AV1_PARSE_ALIGN_TU && !av1parse->tu_started) {
+    av1parse->tu_started = TRUE;
+    if (obu->obu_type != GST_AV1_OBU_TEMPORAL_DELIMITER) {
+      GST_LOG_OBJECT (av1parse, "inserting temporal delimiter");
+      buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+          (gpointer) temporal_delimiter, sizeof (temporal_delimiter), 0,
+          sizeof (temporal_delimiter), NULL, NULL);
+      gst_av1_parse_push_data (av1parse, buf, FALSE);
+    }
+  }
+
+  if (av1parse->format == GST_AV1_PARSE_FORMAT_OBU_STREAM
+      && !obu->header.obu_has_size_field) {
+    guint8 header[2 + 8];
+    guint n;
+
+    /* the low overhead format needs the obu_size field */
+    gst_buffer_extract (buffer, offset, header, obu->header_size);
+    header[0] |= 0x02;
+    n = obu->header_size;
+    n += gst_av1_parser_write_leb128 (obu->obu_size, header + n);
+
+    buf = gst_buffer_new_allocate (NULL, n, NULL);
+    gst_buffer_fill (buf, 0, header, n);
+    buf = gst_buffer_append_region (buf, gst_buffer_ref (buffer),
+        offset + obu->header_size, obu->obu_size);
+  } else {
+    buf = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, offset,
+        size);
+  }
+
+  gst_av1_parse_push_data (av1parse, buf, new_frame);
+}
+
+static void
+gst_av1_parse_process_frame_header (GstAV1Parse * av1parse,
+    GstAV1FrameHeaderOBU * frame_header)
+{
+  if (frame_header->show_existing_frame) {
+    /* showing a key frame which was not shown before */
+    if (frame_header->frame_type == GST_AV1_KEY_FRAME)
+      av1parse->keyframe = TRUE;
+    return;
+  }
+
+  if (frame_header->frame_type != GST_AV1_KEY_FRAME
+      || !frame_header->show_frame)
+    return;
+
+  av1parse->keyframe = TRUE;
+  if (G_UNLIKELY (av1parse->width != frame_header->upscaled_width
+          || av1parse->height != frame_header->frame_height)) {
+    GST_INFO_OBJECT (av1parse, "resolution changed %ux%u",
+        frame_header->upscaled_width, frame_header->frame_height);
+    av1parse->width = frame_header->upscaled_width;
+    av1parse->height = frame_header->frame_height;
+    av1parse->update_caps = TRUE;
+  }
+}
+
+/* parses @obu, found at @offset in @buffer and @size bytes long, and adds
+ * it to the output */
+static GstAV1ParserResult
+gst_av1_parse_process_obu (GstAV1Parse * av1parse, GstAV1OBU * obu,
+    GstBuffer * buffer, guint offset, guint size)
+{
+  GstAV1SequenceHeaderOBU seq_header;
+  GstAV1FrameHeaderOBU frame_header;
+  GstAV1TileGroupOBU tile_group;
+  GstAV1ParserResult res = GST_AV1_PARSER_OK;
+  gboolean new_frame = FALSE;
+
+  switch (obu->obu_type) {
+    case GST_AV1_OBU_SEQUENCE_HEADER:
+      res = gst_av1_parser_parse_sequence_header_obu (av1parse->parser, obu,
+          &seq_header);
+      if (res == GST_AV1_PARSER_OK) {
+        av1parse->header = TRUE;
+        av1parse->update_caps = TRUE;
+      }
+      break;
+    case GST_AV1_OBU_TEMPORAL_DELIMITER:
+      res = gst_av1_parser_parse_temporal_delimiter_obu (av1parse->parser,
+          obu);
+      av1parse->in_frame = FALSE;
+      if (av1parse->align == GST_AV1_PARSE_ALIGN_OBU)
+        av1parse->keyframe = FALSE;
+      break;
+    case GST_AV1_OBU_FRAME_HEADER:
+    case GST_AV1_OBU_REDUNDANT_FRAME_HEADER:
+      new_frame = !av1parse->in_frame;
+      res = gst_av1_parser_parse_frame_header_obu (av1parse->parser, obu,
+          &frame_header);
+      if (res == GST_AV1_PARSER_OK) {
+        gst_av1_parse_process_frame_header (av1parse, &frame_header);
+        av1parse->in_frame = !frame_header.show_existing_frame;
+      }
+      break;
+    case GST_AV1_OBU_FRAME:
+      new_frame = !av1parse->in_frame;
+      res = gst_av1_parser_parse_frame_obu (av1parse->parser, obu,
+          &frame_header, &tile_group);
+      if (res == GST_AV1_PARSER_OK)
+        gst_av1_parse_process_frame_header (av1parse, &frame_header);
+      av1parse->in_frame = FALSE;
+      break;
+    case GST_AV1_OBU_TILE_GROUP:
+      res = gst_av1_parser_parse_tile_group_obu (av1parse->parser, obu,
+          &tile_group);
+      if (res == GST_AV1_PARSER_OK
+          && tile_group.tg_end == tile_group.num_tiles - 1)
+        av1parse->in_frame = FALSE;
+      break;
+    default:
+      break;
+  }
+
+  if (res != GST_AV1_PARSER_OK) {
+    GST_WARNING_OBJECT (av1parse, "dropping OBU of type %d: %d",
+        obu->obu_type, res);
+    return res;
+  }
+
+  gst_av1_parse_push_obu (av1parse, obu, buffer, offset, size, new_frame);
+
+  return res;
+}
+
+static void
+gst_av1_parse_update_src_caps (GstAV1Parse * av1parse)
+{
+  const GstAV1SequenceHeaderOBU *seq_header = &av1parse->parser->seq_header;
+  GstCaps *caps, *sink_caps, *src_caps;
+  gint width = av1parse->width, height = av1parse->height;
+
+  if (!av1parse->update_caps
+      && gst_pad_has_current_caps (GST_BASE_PARSE_SRC_PAD (av1parse)))
+    return;
+  av1parse->update_caps = FALSE;
+
+  sink_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SINK_PAD (av1parse));
+  if (sink_caps) {
+    caps = gst_caps_copy (sink_caps);
+    gst_caps_unref (sink_caps);
+  } else {
+    caps = gst_caps_new_empty_simple ("video/x-av1");
+  }
+
+  gst_caps_set_simple (caps, "parsed", G_TYPE_BOOLEAN, TRUE,
+      "stream-format", G_TYPE_STRING,
+      gst_av1_parse_get_string (av1parse, TRUE, av1parse->format),
+      "alignment", G_TYPE_STRING,
+      gst_av1_parse_get_string (av1parse, FALSE, av1parse->align), NULL);
+
+  if (av1parse->parser->have_seq_header) {
+    static const gchar *profiles[] = { "main", "high", "professional" };
+    const GstAV1ColorConfig *cc = &seq_header->color_config;
+    const gchar *chroma_format;
+
+    if (width == 0 || height == 0) {
+      width = seq_header->max_frame_width_minus_1 + 1;
+      height = seq_header->max_frame_height_minus_1 + 1;
+    }
+
+    if (cc->mono_chrome)
+      chroma_format = "4:0:0";
+    else if (cc->subsampling_x && cc->subsampling_y)
+      chroma_format = "4:2:0";
+    else if (cc->subsampling_x)
+      chroma_format = "4:2:2";
+    else
+      chroma_format = "4:4:4";
+
+    gst_caps_set_simple (caps, "profile", G_TYPE_STRING,
+        profiles[seq_header->seq_profile], "chroma-format", G_TYPE_STRING,
+        chroma_format, "bit-depth-luma", G_TYPE_UINT, cc->bit_depth,
+        "bit-depth-chroma", G_TYPE_UINT, cc->bit_depth, NULL);
+
+    if (seq_header->timing_info_present_flag
+        && seq_header->timing_info.equal_picture_interval) {
+      const GstAV1TimingInfo *ti = &seq_header->timing_info;
+      guint64 den = (guint64) ti->num_units_in_display_tick *
+          ((guint64) ti->num_ticks_per_picture_minus_1 + 1);
+
+      if (ti->time_scale <= G_MAXINT && den > 0 && den <= G_MAXINT) {
+        av1parse->fps_num = ti->time_scale;
+        av1parse->fps_den = den;
+      }
+    }
+  }
+
+  if (width > 0 && height > 0)
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, width,
+        "height", G_TYPE_INT, height, NULL);
+
+  /* upstream overrides */
+  if (av1parse->upstream_fps_num > 0 && av1parse->upstream_fps_den > 0) {
+    av1parse->fps_num = av1parse->upstream_fps_num;
+    av1parse->fps_den = av1parse->upstream_fps_den;
+  }
+  if (av1parse->fps_num > 0 && av1parse->fps_den > 0) {
+    gst_caps_set_simple (caps, "framerate", GST_TYPE_FRACTION,
+        av1parse->fps_num, av1parse->fps_den, NULL);
+    gst_base_parse_set_frame_rate (GST_BASE_PARSE (av1parse),
+        av1parse->fps_num, av1parse->fps_den, 0, 0);
+  }
+
+  /* the av1C configuration only describes the low overhead format */
+  if (av1parse->format == GST_AV1_PARSE_FORMAT_ANNEXB)
+    gst_structure_remove_field (gst_caps_get_structure (caps, 0),
+        "codec_data");
+
+  src_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SRC_PAD (av1parse));
+  if (!src_caps || !gst_caps_is_strictly_equal (src_caps, caps)) {
+    GST_DEBUG_OBJECT (av1parse, "setting caps %" GST_PTR_FORMAT, caps);
+    gst_pad_set_caps (GST_BASE_PARSE_SRC_PAD (av1parse), caps);
+  }
+
+  if (src_caps)
+    gst_caps_unref (src_caps);
+  gst_caps_unref (caps);
+}
+
+static GstFlowReturn
+gst_av1_parse_finish_frame (GstAV1Parse * av1parse, GstBaseParseFrame * frame,
+    gint size)
+{
+  GstBuffer *buffer = NULL;
+  GstFlowReturn ret;
+  gsize avail;
+
+  if (av1parse->format == GST_AV1_PARSE_FORMAT_ANNEXB)
+    gst_av1_parse_close_frame_unit (av1parse);
+
+  avail = gst_adapter_available (av1parse->frame_out);
+  if (avail > 0) {
+    buffer = gst_adapter_take_buffer_fast (av1parse->frame_out, avail);
+    if (av1parse->format == GST_AV1_PARSE_FORMAT_ANNEXB)
+      buffer = gst_buffer_append (gst_av1_parse_leb128_buffer (avail),
+          buffer);
+  }
+
+  if (buffer) {
+    gst_buffer_copy_into (buffer, frame->buffer, GST_BUFFER_COPY_METADATA, 0,
+        -1);
+
+    if (av1parse->keyframe || av1parse->header)
+      GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    else
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    if (av1parse->header)
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_HEADER);
+    else
+      GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_HEADER);
+
+    if (frame->out_buffer)
+      gst_buffer_unref (frame->out_buffer);
+    frame->out_buffer = buffer;
+  } else {
+    /* nothing left of the input */
+    frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
+  }
+
+  gst_av1_parse_update_src_caps (av1parse);
+
+  ret = gst_base_parse_finish_frame (GST_BASE_PARSE (av1parse), frame, size);
+  gst_av1_parse_reset_frame (av1parse);
+
+  return ret;
+}
+
+/* with OBU alignment, pushes the OBU between @start and @end of @buffer,
+ * which is a copy of the input of @frame */
+static GstFlowReturn
+gst_av1_parse_finish_obu (GstAV1Parse * av1parse, GstBaseParseFrame * frame,
+    GstBuffer * buffer, guint start, guint end)
+{
+  GstBaseParseFrame tmp_frame;
+
+  gst_base_parse_frame_init (&tmp_frame);
+  tmp_frame.flags |= frame->flags;
+  tmp_frame.offset = frame->offset;
+  tmp_frame.overhead = frame->overhead;
+  tmp_frame.buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
+      start, end - start);
+
+  return gst_av1_parse_finish_frame (av1parse, &tmp_frame, end - start);
+}
+
+/* input buffers are complete temporal units in the low overhead format */
+static GstFlowReturn
+gst_av1_parse_handle_packetized (GstAV1Parse * av1parse,
+    GstBaseParseFrame * frame)
+{
+  GstBuffer *buffer = frame->buffer;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstAV1ParserResult res;
+  GstAV1OBU obu;
+  GstMapInfo map;
+  guint offset = 0, last = 0, consumed;
+  gboolean split = av1parse->align == GST_AV1_PARSE_ALIGN_OBU;
+
+  /* need to save buffer from invalidation upon _finish_frame */
+  if (split)
+    buffer = gst_buffer_copy (frame->buffer);
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+
+  while (offset < map.size) {
+    res = gst_av1_parser_identify_one_obu (av1parse->parser,
+        map.data + offset, map.size - offset, &obu, &consumed);
+    if (res == GST_AV1_PARSER_OK) {
+      gst_av1_parse_process_obu (av1parse, &obu, buffer, offset, consumed);
+    } else if (res != GST_AV1_PARSER_DROP) {
+      GST_WARNING_OBJECT (av1parse, "invalid OBU at offset %u", offset);
+      break;
+    }
+    offset += consumed;
+
+    if (split && gst_adapter_available (av1parse->frame_out) > 0) {
+      ret = gst_av1_parse_finish_obu (av1parse, frame, buffer, last, offset);
+      last = offset;
+    }
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  if (!split) {
+    ret = gst_av1_parse_finish_frame (av1parse, frame, map.size);
+  } else {
+    gst_buffer_unref (buffer);
+    if (last < map.size) {
+      gst_adapter_clear (av1parse->frame_out);
+      ret = gst_av1_parse_finish_frame (av1parse, frame, map.size - last);
+    }
+  }
+
+  return ret;
+}
+
+/* input is a sequence of temporal units with a length prefix each */
+static GstFlowReturn
+gst_av1_parse_handle_annexb (GstAV1Parse * av1parse,
+    GstBaseParseFrame * frame, gint * skipsize)
+{
+  GstBaseParse *parse = GST_BASE_PARSE (av1parse);
+  GstBuffer *buffer = frame->buffer;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstAV1ParserResult res;
+  GstAV1OBU obu;
+  GstMapInfo map;
+  guint64 tu_size, fu_size, obu_length;
+  guint32 n, consumed;
+  guint offset, last = 0, tu_end, fu_end, obu_end;
+  gboolean split = av1parse->align == GST_AV1_PARSE_ALIGN_OBU;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+
+  res = gst_av1_parser_read_leb128 (map.data, map.size, &tu_size, &n);
+  if (res == GST_AV1_PARSER_NO_MORE_DATA)
+    goto more;
+  if (res != GST_AV1_PARSER_OK || tu_size == 0) {
+    gst_buffer_unmap (buffer, &map);
+    *skipsize = 1;
+    return GST_FLOW_OK;
+  }
+
+  if (tu_size > map.size - n) {
+    if (GST_BASE_PARSE_DRAINING (parse)) {
+      gst_buffer_unmap (buffer, &map);
+      *skipsize = map.size;
+      return GST_FLOW_OK;
+    }
+    gst_base_parse_set_min_frame_size (parse, n + tu_size);
+    goto more;
+  }
+  gst_base_parse_set_min_frame_size (parse, 1);
+
+  gst_buffer_unmap (buffer, &map);
+  /* need to save buffer from invalidation upon _finish_frame */
+  if (split)
+    buffer = gst_buffer_copy (frame->buffer);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+
+  tu_end = n + tu_size;
+  offset = n;
+  while (offset < tu_end) {
+    res = gst_av1_parser_read_leb128 (map.data + offset, tu_end - offset,
+        &fu_size, &n);
+    if (res != GST_AV1_PARSER_OK || fu_size > tu_end - offset - n)
+      goto broken;
+    offset += n;
+    fu_end = offset + fu_size;
+
+    while (offset < fu_end) {
+      res = gst_av1_parser_read_leb128 (map.data + offset, fu_end - offset,
+          &obu_length, &n);
+      if (res != GST_AV1_PARSER_OK || obu_length > fu_end - offset - n)
+        goto broken;
+      offset += n;
+      obu_end = offset + obu_length;
+
+      res = gst_av1_parser_identify_one_obu (av1parse->parser,
+          map.data + offset, obu_length, &obu, &consumed);
+      if (res == GST_AV1_PARSER_OK)
+        gst_av1_parse_process_obu (av1parse, &obu, buffer, offset, consumed);
+      else if (res != GST_AV1_PARSER_DROP)
+        GST_WARNING_OBJECT (av1parse, "invalid OBU at offset %u", offset);
+      offset = obu_end;
+
+      if (split && gst_adapter_available (av1parse->frame_out) > 0) {
+        ret = gst_av1_parse_finish_obu (av1parse, frame, buffer, last, offset);
+        last = offset;
+      }
+    }
+  }
+
+done:
+  gst_buffer_unmap (buffer, &map);
+
+  if (!split) {
+    ret = gst_av1_parse_finish_frame (av1parse, frame, tu_end);
+  } else {
+    gst_buffer_unref (buffer);
+    if (last < tu_end) {
+      gst_adapter_clear (av1parse->frame_out);
+      ret = gst_av1_parse_finish_frame (av1parse, frame, tu_end - last);
+    }
+  }
+
+  return ret;
+
+broken:
+  GST_WARNING_OBJECT (av1parse, "invalid temporal unit, dropping the rest");
+  goto done;
+
+more:
+  gst_buffer_unmap (buffer, &map);
+  return GST_FLOW_OK;
+}
+
+/* input is a sequence of OBUs in the low overhead format, temporal units
+ * start at temporal delimiters */
+static GstFlowReturn
+gst_av1_parse_handle_obu_stream (GstAV1Parse * av1parse,
+    GstBaseParseFrame * frame, gint * skipsize)
+{
+  GstBuffer *buffer = frame->buffer;
+  GstAV1ParserResult res;
+  GstAV1OBU obu;
+  GstMapInfo map;
+  guint offset, consumed;
+  gboolean drain;
+
+  drain = GST_BASE_PARSE_DRAINING (GST_BASE_PARSE (av1parse));
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+
+  /* the OBUs up to there were seen already, waiting for the end of the
+   * temporal unit */
+  offset = av1parse->last_parsed_offset;
+
+  while (TRUE) {
+    res = gst_av1_parser_identify_one_obu (av1parse->parser,
+        map.data + offset, map.size - offset, &obu, &consumed);
+
+    if (res == GST_AV1_PARSER_NO_MORE_DATA) {
+      if (!drain)
+        goto more;
+      if (offset == 0) {
+        GST_DEBUG_OBJECT (av1parse, "dropping incomplete OBU at the end");
+        *skipsize = map.size;
+        goto skip;
+      }
+      break;
+    }
+
+    if (res != GST_AV1_PARSER_OK && res != GST_AV1_PARSER_DROP) {
+      if (offset == 0) {
+        *skipsize = 1;
+        goto skip;
+      }
+      /* push what we have, the next round skips the broken data */
+      break;
+    }
+
+    /* the next temporal unit starts here */
+    if (av1parse->align == GST_AV1_PARSE_ALIGN_TU
+        && obu.obu_type == GST_AV1_OBU_TEMPORAL_DELIMITER && offset > 0)
+      break;
+
+    if (res == GST_AV1_PARSER_OK)
+      gst_av1_parse_process_obu (av1parse, &obu, buffer, offset, consumed);
+    offset += consumed;
+
+    if (av1parse->align == GST_AV1_PARSE_ALIGN_OBU)
+      break;
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  return gst_av1_parse_finish_frame (av1parse, frame, offset);
+
+more:
+  av1parse->last_parsed_offset = offset;
+  gst_buffer_unmap (buffer, &map);
+  return GST_FLOW_OK;
+
+skip:
+  gst_buffer_unmap (buffer, &map);
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_av1_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize)
+{
+  GstAV1Parse *av1parse = GST_AV1_PARSE (parse);
+
+  /* need to configure aggregation */
+  if (G_UNLIKELY (av1parse->format == GST_AV1_PARSE_FORMAT_NONE))
+    gst_av1_parse_negotiate (av1parse, NULL);
+
+  if (av1parse->in_format == GST_AV1_PARSE_FORMAT_ANNEXB)
+    return gst_av1_parse_handle_annexb (av1parse, frame, skipsize);
+
+  if (av1parse->packetized)
+    return gst_av1_parse_handle_packetized (av1parse, frame);
+
+  return gst_av1_parse_handle_obu_stream (av1parse, frame, skipsize);
+}
+
+static gboolean
+gst_av1_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
+{
+  GstAV1Parse *av1parse = GST_AV1_PARSE (parse);
+  GstStructure *str;
+  const GValue *value;
+  guint format, align;
+
+  str = gst_caps_get_structure (caps, 0);
+
+  /* accept upstream info if provided */
+  gst_structure_get_fraction (str, "framerate", &av1parse->upstream_fps_num,
+      &av1parse->upstream_fps_den);
+
+  /* get upstream format and align from caps */
+  gst_av1_parse_format_from_caps (caps, &format, &align);
+  if (format == GST_AV1_PARSE_FORMAT_NONE)
+    format = GST_AV1_PARSE_FORMAT_OBU_STREAM;
+
+  /* the av1C configuration record carries the sequence header */
+  if ((value = gst_structure_get_value (str, "codec_data"))) {
+    GstBuffer *codec_data = gst_value_get_buffer (value);
+    GstAV1OBU obu;
+    GstAV1SequenceHeaderOBU seq_header;
+    GstMapInfo map;
+    guint offset = 4, consumed;
+
+    if (!codec_data) {
+      GST_WARNING_OBJECT (av1parse, "wrong codec-data type");
+      return FALSE;
+    }
+
+    gst_buffer_map (codec_data, &map, GST_MAP_READ);
+    if (map.size < 4 || !(map.data[0] & 0x80)) {
+      GST_WARNING_OBJECT (av1parse, "invalid av1C codec-data");
+      gst_buffer_unmap (codec_data, &map);
+      return FALSE;
+    }
+
+    while (offset < map.size
+        && gst_av1_parser_identify_one_obu (av1parse->parser,
+            map.data + offset, map.size - offset, &obu,
+            &consumed) == GST_AV1_PARSER_OK) {
+      if (obu.obu_type == GST_AV1_OBU_SEQUENCE_HEADER)
+        gst_av1_parser_parse_sequence_header_obu (av1parse->parser, &obu,
+            &seq_header);
+      offset += consumed;
+    }
+    gst_buffer_unmap (codec_data, &map);
+  }
+
+  /* demuxers give us one temporal unit per buffer */
+  av1parse->packetized = (format == GST_AV1_PARSE_FORMAT_OBU_STREAM
+      && align == GST_AV1_PARSE_ALIGN_TU);
+  av1parse->in_format = format;
+  av1parse->in_align = align;
+
+  {
+    GstCaps *in_caps;
+
+    /* prefer input type determined above */
+    in_caps = gst_caps_new_simple ("video/x-av1",
+        "parsed", G_TYPE_BOOLEAN, TRUE,
+        "stream-format", G_TYPE_STRING,
+        gst_av1_parse_get_string (av1parse, TRUE, format),
+        "alignment", G_TYPE_STRING,
+        gst_av1_parse_get_string (av1parse, FALSE,
+            align ? align : GST_AV1_PARSE_ALIGN_TU), NULL);
+    /* negotiate with downstream, sets ->format and ->align */
+    gst_av1_parse_negotiate (av1parse, in_caps);
+    gst_caps_unref (in_caps);
+  }
+
+  av1parse->update_caps = TRUE;
+
+  return TRUE;
+}
+
+static void
+remove_fields (GstCaps * caps)
+{
+  guint i, n;
+
+  n = gst_caps_get_size (caps);
+  for (i = 0; i < n; i++) {
+    GstStructure *s = gst_caps_get_structure (caps, i);
+
+    gst_structure_remove_field (s, "alignment");
+    gst_structure_remove_field (s, "stream-format");
+    gst_structure_remove_field (s, "parsed");
+  }
+}
+
+static GstCaps *
+gst_av1_parse_get_caps (GstBaseParse * parse, GstCaps * filter)
+{
+  GstCaps *peercaps, *templ;
+  GstCaps *res;
+
+  templ = gst_pad_get_pad_template_caps (GST_BASE_PARSE_SINK_PAD (parse));
+  if (filter) {
+    GstCaps *fcopy = gst_caps_copy (filter);
+    /* Remove the fields we convert */
+    remove_fields (fcopy);
+    peercaps = gst_pad_peer_query_caps (GST_BASE_PARSE_SRC_PAD (parse), fcopy);
+    gst_caps_unref (fcopy);
+  } else
+    peercaps = gst_pad_peer_query_caps (GST_BASE_PARSE_SRC_PAD (parse), NULL);
+
+  if (peercaps) {
+    peercaps = gst_caps_make_writable (peercaps);
+    remove_fields (peercaps);
+
+    res = gst_caps_intersect_full (peercaps, templ, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (peercaps);
+    gst_caps_unref (templ);
+  } else {
+    res = templ;
+  }
+
+  if (filter) {
+    GstCaps *tmp = gst_caps_intersect_full (res, filter,
+        GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (res);
+    res = tmp;
+  }
+
+  return res;
+}
+
+static gboolean
+gst_av1_parse_event (GstBaseParse * parse, GstEvent * event)
+{
+  GstAV1Parse *av1parse = GST_AV1_PARSE (parse);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_STOP:
+      av1parse->in_frame = FALSE;
+      av1parse->keyframe = FALSE;
+      gst_av1_parse_reset_frame (av1parse);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_PARSE_CLASS (parent_class)->sink_event (parse, event);
+}
@@ -30,6 +30,7 @@
 #include <gst/pbutils/pbutils.h>
 #include <gst/video/video.h>
 #include "gsth264parse.h"
+#include "gstvideoparseutils.h"
 
 #include <string.h>
 
@@ -37,11 +38,15 @@ GST_DEBUG_CATEGORY (h264_parse_debug);
 #define GST_CAT_DEFAULT h264_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_FAST_SLICE_PARSE     FALSE
+#define DEFAULT_INSERT_TIMECODE      FALSE
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_FAST_SLICE_PARSE,
+  PROP_INSERT_TIMECODE
 };
 
 enum
@@ -137,6 +142,20 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
           -1, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_FAST_SLICE_PARSE,
+      g_param_spec_boolean ("fast-slice-parse", "Fast slice parse",
+          "Only read the start of the slice headers as needed for access unit "
+          "framing and keyframe detection, e.g. when only remuxing",
+          DEFAULT_FAST_SLICE_PARSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INSERT_TIMECODE,
+      g_param_spec_boolean ("insert-timecode", "Insert timecode",
+          "Insert a picture timing SEI carrying the time code of the buffer's "
+          "GstVideoTimeCodeMeta into access units that have none",
+          DEFAULT_INSERT_TIMECODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h264_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h264_parse_stop);
@@ -167,6 +186,8 @@ gst_h264_parse_init (GstH264Parse * h264parse)
 
   h264parse->aud_needed = TRUE;
   h264parse->aud_insert = TRUE;
+  h264parse->fast_slice_parse = DEFAULT_FAST_SLICE_PARSE;
+  h264parse->insert_timecode = DEFAULT_INSERT_TIMECODE;
 }
 
 
@@ -192,8 +213,11 @@ gst_h264_parse_reset_frame (GstH264Parse * h264parse)
   h264parse->update_caps = FALSE;
   h264parse->idr_pos = -1;
   h264parse->sei_pos = -1;
+  h264parse->vcl_pos = -1;
+  h264parse->have_pic_timing = FALSE;
   h264parse->keyframe = FALSE;
   h264parse->header = FALSE;
+  h264parse->reference = FALSE;
   h264parse->frame_start = FALSE;
   h264parse->aud_insert = TRUE;
   gst_adapter_clear (h264parse->frame_out);
@@ -253,6 +277,7 @@ gst_h264_parse_reset (GstH264Parse * h264parse)
   gst_event_replace (&h264parse->force_key_unit_event, NULL);
 
   h264parse->discont = FALSE;
+  h264parse->segment_flags = 0;
 
   gst_h264_parse_reset_stream_info (h264parse);
 }
@@ -417,28 +442,41 @@ gst_h264_parse_negotiate (GstH264Parse * h264parse, gint in_format,
     gst_caps_unref (caps);
 }
 
-static GstBuffer *
-gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
-    guint size)
+/* Stores the length prefix or start code for a NAL of @size bytes in @format
+ * in the first bytes of @prefix, and returns how many there are */
+static guint
+gst_h264_parse_nal_prefix (GstH264Parse * h264parse, guint format, guint size,
+    guint32 * prefix)
 {
-  GstBuffer *buf;
   guint nl = h264parse->nal_length_size;
-  guint32 tmp;
 
   GST_DEBUG_OBJECT (h264parse, "nal length %d", size);
 
-  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
   if (format == GST_H264_PARSE_FORMAT_AVC
       || format == GST_H264_PARSE_FORMAT_AVC3) {
-    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+    *prefix = GUINT32_TO_BE (size << (32 - 8 * nl));
   } else {
     /* HACK: nl should always be 4 here, otherwise this won't work. 
      * There are legit cases where nl in avc stream is 2, but byte-stream
      * SC is still always 4 bytes. */
     nl = 4;
-    tmp = GUINT32_TO_BE (1);
+    *prefix = GUINT32_TO_BE (1);
   }
 
+  return nl;
+}
+
+static GstBuffer *
+gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
+    guint size)
+{
+  GstBuffer *buf;
+  guint nl;
+  guint32 tmp;
+
+  nl = gst_h264_parse_nal_prefix (h264parse, format, size, &tmp);
+
+  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
   gst_buffer_fill (buf, 0, &tmp, sizeof (guint32));
   gst_buffer_fill (buf, nl, data, size);
   gst_buffer_set_size (buf, size + nl);
@@ -446,6 +484,24 @@ gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
   return buf;
 }
 
+/* Like gst_h264_parse_wrap_nal(), but shares the memory of the NAL at
+ * @offset in @buffer instead of copying it */
+static GstBuffer *
+gst_h264_parse_wrap_nal_region (GstH264Parse * h264parse, guint format,
+    GstBuffer * buffer, guint offset, guint size)
+{
+  GstBuffer *buf;
+  guint nl;
+  guint32 tmp;
+
+  nl = gst_h264_parse_nal_prefix (h264parse, format, size, &tmp);
+
+  buf = gst_buffer_new_allocate (NULL, nl, NULL);
+  gst_buffer_fill (buf, 0, &tmp, nl);
+
+  return gst_buffer_append_region (buf, gst_buffer_ref (buffer), offset, size);
+}
+
 static void
 gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     GstH264NalUnitType naltype, GstH264NalUnit * nalu)
@@ -482,6 +538,34 @@ gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
   store[id] = buf;
 }
 
+/* Returns the id of the stored SPS or PPS NAL that is byte-identical to
+ * @nalu, or -1 */
+static gint
+gst_h264_parser_find_stored_nal (GstH264Parse * h264parse,
+    GstH264NalUnitType naltype, GstH264NalUnit * nalu)
+{
+  GstBuffer **store;
+  guint i, store_size;
+
+  if (naltype == GST_H264_NAL_SPS) {
+    store_size = GST_H264_MAX_SPS_COUNT;
+    store = h264parse->sps_nals;
+  } else if (naltype == GST_H264_NAL_PPS) {
+    store_size = GST_H264_MAX_PPS_COUNT;
+    store = h264parse->pps_nals;
+  } else
+    return -1;
+
+  for (i = 0; i < store_size; i++) {
+    if (store[i] && gst_buffer_get_size (store[i]) == nalu->size
+        && gst_buffer_memcmp (store[i], 0, nalu->data + nalu->offset,
+            nalu->size) == 0)
+      return i;
+  }
+
+  return -1;
+}
+
 #ifndef GST_DISABLE_GST_DEBUG
 static const gchar *nal_names[] = {
   "Unknown",
@@ -542,6 +626,7 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
             sei.payload.pic_timing.cpb_removal_delay;
         if (h264parse->sei_pic_struct_pres_flag)
           h264parse->sei_pic_struct = sei.payload.pic_timing.pic_struct;
+        h264parse->have_pic_timing = TRUE;
         GST_LOG_OBJECT (h264parse, "pic timing updated");
         break;
       case GST_H264_SEI_BUF_PERIOD:
@@ -698,6 +783,83 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   g_array_free (messages, TRUE);
 }
 
+/* Reads an Exp-Golomb coded unsigned value */
+static gboolean
+gst_h264_parse_read_ue (GstBitReader * br, guint32 * val)
+{
+  guint zeros = 0;
+  guint32 value = 0;
+  guint8 bit;
+
+  while (TRUE) {
+    if (!gst_bit_reader_get_bits_uint8 (br, &bit, 1))
+      return FALSE;
+    if (bit)
+      break;
+    if (++zeros > 31)
+      return FALSE;
+  }
+
+  if (zeros > 0 && !gst_bit_reader_get_bits_uint32 (br, &value, zeros))
+    return FALSE;
+
+  *val = (1 << zeros) - 1 + value;
+
+  return TRUE;
+}
+
+/* Reads only the beginning of the slice header, up to the field_pic_flag,
+ * without the reference picture list modifications and everything after */
+static gboolean
+gst_h264_parse_read_slice_start (GstH264Parse * h264parse,
+    GstH264NalUnit * nalu, guint32 * slice_type, guint8 * field_pic_flag)
+{
+  const guint8 *src = nalu->data + nalu->offset + nalu->header_bytes;
+  guint src_size = nalu->size - nalu->header_bytes;
+  guint8 data[32];
+  guint i, n = 0, zeros = 0;
+  GstBitReader br;
+  guint32 first_mb_in_slice, pps_id;
+  GstH264PPS *pps;
+  GstH264SPS *sps;
+
+  /* more than enough for these fields, without the emulation prevention
+   * bytes */
+  for (i = 0; i < src_size && n < sizeof (data); i++) {
+    if (zeros >= 2 && src[i] == 0x03) {
+      zeros = 0;
+      continue;
+    }
+    zeros = src[i] == 0x00 ? zeros + 1 : 0;
+    data[n++] = src[i];
+  }
+
+  gst_bit_reader_init (&br, data, n);
+
+  if (!gst_h264_parse_read_ue (&br, &first_mb_in_slice)
+      || !gst_h264_parse_read_ue (&br, slice_type)
+      || !gst_h264_parse_read_ue (&br, &pps_id)
+      || pps_id >= GST_H264_MAX_PPS_COUNT)
+    return FALSE;
+
+  pps = &h264parse->nalparser->pps[pps_id];
+  sps = pps->sequence;
+  if (!pps->valid || !sps || !sps->valid)
+    return FALSE;
+
+  if (sps->separate_colour_plane_flag && !gst_bit_reader_skip (&br, 2))
+    return FALSE;
+  if (!gst_bit_reader_skip (&br, sps->log2_max_frame_num_minus4 + 4))
+    return FALSE;
+
+  *field_pic_flag = 0;
+  if (!sps->frame_mbs_only_flag
+      && !gst_bit_reader_get_bits_uint8 (&br, field_pic_flag, 1))
+    return FALSE;
+
+  return TRUE;
+}
+
 /* caller guarantees 2 bytes of nal payload */
 static gboolean
 gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
@@ -707,6 +869,8 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   GstH264SPS sps = { 0, };
   GstH264NalParser *nalparser = h264parse->nalparser;
   GstH264ParserResult pres;
+  gboolean repeated = FALSE;
+  gint id;
 
   /* nothing to do for broken input */
   if (G_UNLIKELY (nalu->size < 2)) {
@@ -730,7 +894,18 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     case GST_H264_NAL_SPS:
       /* reset state, everything else is obsolete */
       h264parse->state = 0;
-      pres = gst_h264_parser_parse_sps (nalparser, nalu, &sps, TRUE);
+
+      /* usually the same SPS is repeated with every keyframe, nothing needs
+       * to be parsed or updated then */
+      id = gst_h264_parser_find_stored_nal (h264parse, nal_type, nalu);
+      if (id >= 0 && nalparser->sps[id].valid) {
+        GST_LOG_OBJECT (h264parse, "SPS %d unchanged", id);
+        nalparser->last_sps = &nalparser->sps[id];
+        repeated = TRUE;
+        pres = GST_H264_PARSER_OK;
+      } else {
+        pres = gst_h264_parser_parse_sps (nalparser, nalu, &sps, TRUE);
+      }
 
     process_sps:
       /* arranged for a fallback sps.id, so use that one and only warn */
@@ -739,8 +914,12 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         return FALSE;
       }
 
-      GST_DEBUG_OBJECT (h264parse, "triggering src caps check");
-      h264parse->update_caps = TRUE;
+      if (!repeated) {
+        GST_DEBUG_OBJECT (h264parse, "triggering src caps check");
+        h264parse->update_caps = TRUE;
+        /* the PPS depend on it */
+        h264parse->sps_generation++;
+      }
       h264parse->have_sps = TRUE;
       if (h264parse->push_codec && h264parse->have_pps) {
         /* SPS and PPS found in stream before the first pre_push_frame, no need
@@ -751,7 +930,8 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
+      if (!repeated)
+        gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
       gst_h264_sps_clear (&sps);
       h264parse->state |= GST_H264_PARSE_STATE_GOT_SPS;
       h264parse->header |= TRUE;
@@ -762,7 +942,16 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       if (!GST_H264_PARSE_STATE_VALID (h264parse, GST_H264_PARSE_STATE_GOT_SPS))
         return FALSE;
 
-      pres = gst_h264_parser_parse_pps (nalparser, nalu, &pps);
+      id = gst_h264_parser_find_stored_nal (h264parse, nal_type, nalu);
+      if (id >= 0 && nalparser->pps[id].valid
+          && h264parse->pps_generation[id] == h264parse->sps_generation) {
+        GST_LOG_OBJECT (h264parse, "PPS %d unchanged", id);
+        nalparser->last_pps = &nalparser->pps[id];
+        repeated = TRUE;
+        pres = GST_H264_PARSER_OK;
+      } else {
+        pres = gst_h264_parser_parse_pps (nalparser, nalu, &pps);
+      }
       /* arranged for a fallback pps.id, so use that one and only warn */
       if (pres != GST_H264_PARSER_OK) {
         GST_WARNING_OBJECT (h264parse, "failed to parse PPS:");
@@ -771,7 +960,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       }
 
       /* parameters might have changed, force caps check */
-      if (!h264parse->have_pps) {
+      if (!h264parse->have_pps && !repeated) {
         GST_DEBUG_OBJECT (h264parse, "triggering src caps check");
         h264parse->update_caps = TRUE;
       }
@@ -785,7 +974,11 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
+      if (!repeated) {
+        gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
+        if (pps.id < GST_H264_MAX_PPS_COUNT)
+          h264parse->pps_generation[pps.id] = h264parse->sps_generation;
+      }
       gst_h264_pps_clear (&pps);
       h264parse->state |= GST_H264_PARSE_STATE_GOT_PPS;
       h264parse->header |= TRUE;
@@ -820,6 +1013,14 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
               GST_H264_PARSE_STATE_VALID_PICTURE_HEADERS))
         return FALSE;
 
+      /* mark where an inserted SEI needs to go */
+      if (h264parse->vcl_pos == -1) {
+        if (h264parse->transform)
+          h264parse->vcl_pos = gst_adapter_available (h264parse->frame_out);
+        else
+          h264parse->vcl_pos = nalu->sc_offset;
+      }
+
       /* don't need to parse the whole slice (header) here */
       if (*(nalu->data + nalu->offset + nalu->header_bytes) & 0x80) {
         /* means first_mb_in_slice == 0 */
@@ -830,7 +1031,22 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       GST_DEBUG_OBJECT (h264parse, "frame start: %i", h264parse->frame_start);
       if (nal_type == GST_H264_NAL_SLICE_EXT && !GST_H264_IS_MVC_NALU (nalu))
         break;
-      {
+      h264parse->reference |= nalu->ref_idc != 0;
+      if (h264parse->fast_slice_parse) {
+        guint32 slice_type;
+        guint8 field_pic_flag;
+
+        if (gst_h264_parse_read_slice_start (h264parse, nalu, &slice_type,
+                &field_pic_flag)) {
+          GST_DEBUG_OBJECT (h264parse, "slice type: %u", slice_type);
+          if (slice_type % 5 == GST_H264_I_SLICE
+              || slice_type % 5 == GST_H264_SI_SLICE)
+            h264parse->keyframe |= TRUE;
+
+          h264parse->state |= GST_H264_PARSE_STATE_GOT_SLICE;
+          h264parse->field_pic_flag = field_pic_flag;
+        }
+      } else {
         GstH264SliceHdr slice;
 
         pres = gst_h264_parser_parse_slice_hdr (nalparser, nalu, &slice,
@@ -893,8 +1109,12 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h264parse, "collecting NAL in AVC frame");
-    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    if (h264parse->nal_buffer)
+      buf = gst_h264_parse_wrap_nal_region (h264parse, h264parse->format,
+          h264parse->nal_buffer, nalu->offset, nalu->size);
+    else
+      buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
+          nalu->data + nalu->offset, nalu->size);
     gst_adapter_push (h264parse->frame_out, buf);
   }
   return TRUE;
@@ -992,7 +1212,9 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h264parse, "AVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
+    h264parse->nal_buffer = buffer;
     gst_h264_parse_process_nal (h264parse, &nalu);
+    h264parse->nal_buffer = NULL;
 
     /* dispatch per NALU if needed */
     if (h264parse->split_packetized) {
@@ -1066,7 +1288,7 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
   GstH264ParserResult pres;
   gint framesize;
   GstFlowReturn ret;
-  gboolean au_complete;
+  gboolean au_complete, processed;
 
   if (G_UNLIKELY (GST_BUFFER_FLAG_IS_SET (frame->buffer,
               GST_BUFFER_FLAG_DISCONT))) {
@@ -1230,7 +1452,12 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
       }
     }
 
-    if (!gst_h264_parse_process_nal (h264parse, &nalu)) {
+    /* the converted NALs can share the memory of the input */
+    h264parse->nal_buffer = buffer;
+    processed = gst_h264_parse_process_nal (h264parse, &nalu);
+    h264parse->nal_buffer = NULL;
+
+    if (!processed) {
       GST_WARNING_OBJECT (h264parse,
           "broken/invalid nal Type: %d %s, Size: %u will be dropped",
           nalu.type, _nal_name (nalu.type), nalu.size);
@@ -2106,6 +2333,25 @@ exit:
     h264parse->dts += *out_dur;
 }
 
+/* in trick modes, pictures which are not needed to decode the ones shown
+ * are dropped: key unit trick modes only keep keyframes, others drop
+ * non-reference pictures */
+static gboolean
+gst_h264_parse_skip_picture (GstH264Parse * h264parse)
+{
+  /* only whole pictures can be dropped, and never the configuration */
+  if (h264parse->align != GST_H264_PARSE_ALIGN_AU || h264parse->header)
+    return FALSE;
+
+  if (h264parse->segment_flags & GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS)
+    return !h264parse->keyframe;
+
+  if (h264parse->segment_flags & GST_SEGMENT_FLAG_TRICKMODE)
+    return !h264parse->reference;
+
+  return FALSE;
+}
+
 static GstFlowReturn
 gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
@@ -2135,6 +2381,13 @@ gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   else
     GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_HEADER);
 
+  if (G_UNLIKELY (h264parse->segment_flags)
+      && gst_h264_parse_skip_picture (h264parse)) {
+    GST_LOG_OBJECT (h264parse, "dropping %s picture in trick mode",
+        h264parse->reference ? "reference" : "non-reference");
+    frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
+  }
+
   if (h264parse->discont) {
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
     h264parse->discont = FALSE;
@@ -2145,7 +2398,7 @@ gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h264parse->frame_out, av);
+    buf = gst_adapter_take_buffer_fast (h264parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2295,65 +2548,126 @@ gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
       }
     }
   } else {
-    /* insert config NALs into AU */
-    GstByteWriter bw;
+    /* insert config NALs into AU, the rest of it is shared with @buffer */
     GstBuffer *new_buf;
-    const gboolean bs = h264parse->format == GST_H264_PARSE_FORMAT_BYTE;
-    const gint nls = 4 - h264parse->nal_length_size;
-    gboolean ok;
 
-    gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer), FALSE);
-    ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h264parse->idr_pos);
+    new_buf = gst_buffer_append_region (gst_buffer_new (),
+        gst_buffer_ref (buffer), 0, h264parse->idr_pos);
     GST_DEBUG_OBJECT (h264parse, "- inserting SPS/PPS");
     for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
       if ((codec_nal = h264parse->sps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
         GST_DEBUG_OBJECT (h264parse, "inserting SPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+        new_buf = gst_buffer_append (new_buf,
+            gst_h264_parse_wrap_nal_region (h264parse, h264parse->format,
+                codec_nal, 0, gst_buffer_get_size (codec_nal)));
         send_done = TRUE;
       }
     }
     for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
       if ((codec_nal = h264parse->pps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
         GST_DEBUG_OBJECT (h264parse, "inserting PPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+        new_buf = gst_buffer_append (new_buf,
+            gst_h264_parse_wrap_nal_region (h264parse, h264parse->format,
+                codec_nal, 0, gst_buffer_get_size (codec_nal)));
         send_done = TRUE;
       }
     }
-    ok &= gst_byte_writer_put_buffer (&bw, buffer, h264parse->idr_pos, -1);
-    /* collect result and push */
-    new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
+    new_buf = gst_buffer_append_region (new_buf, gst_buffer_ref (buffer),
+        h264parse->idr_pos, -1);
     gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     /* should already be keyframe/IDR, but it may not have been,
      * so mark it as such to avoid being discarded by picky decoder */
     GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
     gst_buffer_replace (&frame->out_buffer, new_buf);
     gst_buffer_unref (new_buf);
-    /* some result checking seems to make some compilers happy */
-    if (G_UNLIKELY (!ok)) {
-      GST_ERROR_OBJECT (h264parse, "failed to insert SPS/PPS");
-    }
   }
 
   return send_done;
 }
 
+/* inserts a picture timing SEI carrying the time code of the buffer's meta
+ * in front of the first slice, sharing the rest of the AU with @buffer */
+static void
+gst_h264_parse_insert_timecode (GstH264Parse * h264parse,
+    GstBaseParseFrame * frame)
+{
+  static const guint8 sei_header[] = { GST_H264_NAL_SEI };
+  GstVideoTimeCodeMeta *tc_meta;
+  GstVideoTimeCode *tc;
+  GstH264SPS *sps;
+  GstVideoParseSeiPayload payload;
+  GstBuffer *buffer, *new_buf;
+  GstMemory *mem;
+  guint size;
+
+  if (h264parse->have_pic_timing || h264parse->vcl_pos < 0)
+    return;
+
+  tc_meta = gst_buffer_get_video_time_code_meta (frame->buffer);
+  if (!tc_meta)
+    return;
+
+  /* without HRD parameters pic_timing () only holds pic_struct and the
+   * clock timestamps, which is all we know how to fill in */
+  sps = h264parse->nalparser->last_sps;
+  if (!sps || !sps->vui_parameters_present_flag
+      || !sps->vui_parameters.pic_struct_present_flag
+      || sps->vui_parameters.nal_hrd_parameters_present_flag
+      || sps->vui_parameters.vcl_hrd_parameters_present_flag
+      || h264parse->field_pic_flag) {
+    GST_LOG_OBJECT (h264parse, "stream can't carry a time code");
+    return;
+  }
+
+  tc = &tc_meta->tc;
+  GST_LOG_OBJECT (h264parse, "inserting time code %02u:%02u:%02u:%02u",
+      tc->hours, tc->minutes, tc->seconds, tc->frames);
+
+  gst_video_parse_sei_payload_init (&payload);
+  /* pic_struct: frame */
+  gst_video_parse_sei_payload_put_bits (&payload, 0, 4);
+  /* clock_timestamp_flag */
+  gst_video_parse_sei_payload_put_bits (&payload, 1, 1);
+  /* ct_type: progressive or interlaced */
+  gst_video_parse_sei_payload_put_bits (&payload,
+      tc->config.flags & GST_VIDEO_TIME_CODE_FLAGS_INTERLACED ? 1 : 0, 2);
+  /* nuit_field_based_flag */
+  gst_video_parse_sei_payload_put_bits (&payload, 0, 1);
+  /* counting_type: no dropping, or NTSC drop-frame */
+  gst_video_parse_sei_payload_put_bits (&payload,
+      tc->config.flags & GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME ? 4 : 0, 5);
+  /* full_timestamp_flag, discontinuity_flag, cnt_dropped_flag */
+  gst_video_parse_sei_payload_put_bits (&payload, 1, 1);
+  gst_video_parse_sei_payload_put_bits (&payload, 0, 1);
+  gst_video_parse_sei_payload_put_bits (&payload, 0, 1);
+  gst_video_parse_sei_payload_put_bits (&payload, tc->frames, 8);
+  gst_video_parse_sei_payload_put_bits (&payload, tc->seconds, 6);
+  gst_video_parse_sei_payload_put_bits (&payload, tc->minutes, 6);
+  gst_video_parse_sei_payload_put_bits (&payload, tc->hours, 5);
+  /* time_offset_length is 0 without HRD parameters */
+  size = gst_video_parse_sei_payload_finish (&payload);
+
+  mem = gst_video_parse_create_sei_nal (sei_header, sizeof (sei_header),
+      GST_H264_SEI_PIC_TIMING, payload.data, size,
+      h264parse->format == GST_H264_PARSE_FORMAT_BYTE ? 0 :
+      h264parse->nal_length_size);
+
+  buffer = frame->out_buffer ? frame->out_buffer : frame->buffer;
+  new_buf = gst_buffer_append_region (gst_buffer_new (),
+      gst_buffer_ref (buffer), 0, h264parse->vcl_pos);
+  gst_buffer_append_memory (new_buf, mem);
+  new_buf = gst_buffer_append_region (new_buf, gst_buffer_ref (buffer),
+      h264parse->vcl_pos, -1);
+  gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_replace (&frame->out_buffer, new_buf);
+  gst_buffer_unref (new_buf);
+
+  /* config goes in front of the SEI if it was to go in front of the slice */
+  if (h264parse->idr_pos > h264parse->vcl_pos)
+    h264parse->idr_pos += gst_buffer_get_size (frame->out_buffer) -
+        gst_buffer_get_size (buffer);
+}
+
 static GstFlowReturn
 gst_h264_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
@@ -2391,6 +2705,16 @@ gst_h264_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     h264parse->sent_codec_tag = TRUE;
   }
 
+  /* index keyframes, for keyframe stepping in trick modes */
+  if (h264parse->align == GST_H264_PARSE_ALIGN_AU
+      && !GST_BUFFER_FLAG_IS_SET (frame->buffer, GST_BUFFER_FLAG_DELTA_UNIT)
+      && frame->offset != -1 && GST_BUFFER_PTS_IS_VALID (frame->buffer))
+    gst_base_parse_add_index_entry (parse, frame->offset,
+        GST_BUFFER_PTS (frame->buffer), TRUE, FALSE);
+
+  if (h264parse->insert_timecode && h264parse->align == GST_H264_PARSE_ALIGN_AU)
+    gst_h264_parse_insert_timecode (h264parse, frame);
+
   /* In case of byte-stream, insert au delimeter by default
    * if it doesn't exist */
   if (h264parse->aud_insert && h264parse->format == GST_H264_PARSE_FORMAT_BYTE) {
@@ -2399,8 +2723,12 @@ gst_h264_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
           gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, (guint8 *) au_delim,
           sizeof (au_delim), 0, sizeof (au_delim), NULL, NULL);
 
-      frame->out_buffer = gst_buffer_copy (frame->buffer);
-      gst_buffer_prepend_memory (frame->out_buffer, mem);
+      /* shallow copy, the AU itself is shared */
+      buffer = gst_buffer_copy (frame->out_buffer ? frame->out_buffer :
+          frame->buffer);
+      gst_buffer_prepend_memory (buffer, mem);
+      gst_buffer_replace (&frame->out_buffer, buffer);
+      gst_buffer_unref (buffer);
       if (h264parse->idr_pos >= 0)
         h264parse->idr_pos += sizeof (au_delim);
 
@@ -2415,7 +2743,7 @@ gst_h264_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
       gst_buffer_unref (aud_buffer);
     }
   } else {
-    buffer = frame->buffer;
+    buffer = frame->out_buffer ? frame->out_buffer : frame->buffer;
   }
 
   if ((event = check_pending_key_unit_event (h264parse->force_key_unit_event,
@@ -2860,6 +3188,11 @@ gst_h264_parse_event (GstBaseParse * parse, GstEvent * event)
 
       h264parse->last_report = GST_CLOCK_TIME_NONE;
 
+      h264parse->segment_flags = segment->flags &
+          (GST_SEGMENT_FLAG_TRICKMODE | GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS);
+      GST_DEBUG_OBJECT (h264parse, "trick mode flags 0x%x",
+          h264parse->segment_flags);
+
       res = GST_BASE_PARSE_CLASS (parent_class)->sink_event (parse, event);
       break;
     }
@@ -2920,6 +3253,12 @@ gst_h264_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_int (value);
       break;
+    case PROP_FAST_SLICE_PARSE:
+      parse->fast_slice_parse = g_value_get_boolean (value);
+      break;
+    case PROP_INSERT_TIMECODE:
+      parse->insert_timecode = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2938,6 +3277,12 @@ gst_h264_parse_get_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       g_value_set_int (value, parse->interval);
       break;
+    case PROP_FAST_SLICE_PARSE:
+      g_value_set_boolean (value, parse->fast_slice_parse);
+      break;
+    case PROP_INSERT_TIMECODE:
+      g_value_set_boolean (value, parse->insert_timecode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
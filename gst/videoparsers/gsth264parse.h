@@ -90,6 +90,10 @@ struct _GstH264Parse
   /* collected SPS and PPS NALUs */
   GstBuffer *sps_nals[GST_H264_MAX_SPS_COUNT];
   GstBuffer *pps_nals[GST_H264_MAX_PPS_COUNT];
+  /* sps_generation when each PPS was parsed, a PPS is parsed again after
+   * any SPS changed */
+  guint sps_generation;
+  guint pps_generation[GST_H264_MAX_PPS_COUNT];
 
   /* Infos we need to keep track of */
   guint32 sei_cpb_removal_delay;
@@ -110,16 +114,25 @@ struct _GstH264Parse
   /*guint last_nal_pos;*/
   /*guint next_sc_pos;*/
   gint idr_pos, sei_pos;
+  /* position of the first slice NAL */
+  gint vcl_pos;
+  gboolean have_pic_timing;
   gboolean update_caps;
   GstAdapter *frame_out;
+  /* the input buffer the NAL being processed is in, if any */
+  GstBuffer *nal_buffer;
   gboolean keyframe;
   gboolean header;
+  /* the picture is used for reference */
+  gboolean reference;
   gboolean frame_start;
   /* AU state */
   gboolean picture_start;
 
   /* props */
   gint interval;
+  gboolean fast_slice_parse;
+  gboolean insert_timecode;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
@@ -132,6 +145,9 @@ struct _GstH264Parse
   /* For insertion of AU Delimiter */
   gboolean aud_needed;
   gboolean aud_insert;
+
+  /* trick mode flags of the current segment */
+  GstSegmentFlags segment_flags;
 };
 
 struct _GstH264ParseClass
@@ -26,6 +26,7 @@
 #include <gst/pbutils/pbutils.h>
 #include <gst/video/video.h>
 #include "gsth265parse.h"
+#include "gstvideoparseutils.h"
 
 #include <string.h>
 
@@ -33,11 +34,15 @@ GST_DEBUG_CATEGORY (h265_parse_debug);
 #define GST_CAT_DEFAULT h265_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_FAST_SLICE_PARSE     FALSE
+#define DEFAULT_INSERT_TIMECODE      FALSE
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_FAST_SLICE_PARSE,
+  PROP_INSERT_TIMECODE
 };
 
 enum
@@ -113,6 +118,21 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
           "will be multiplexed in the data stream when detected.) (0 = disabled)",
           0, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FAST_SLICE_PARSE,
+      g_param_spec_boolean ("fast-slice-parse", "Fast slice parse",
+          "Only read the start of the slice segment headers as needed for "
+          "access unit framing and keyframe detection, e.g. when only "
+          "remuxing", DEFAULT_FAST_SLICE_PARSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INSERT_TIMECODE,
+      g_param_spec_boolean ("insert-timecode", "Insert timecode",
+          "Insert a time code SEI carrying the time code of the buffer's "
+          "GstVideoTimeCodeMeta into access units that have none",
+          DEFAULT_INSERT_TIMECODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h265_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h265_parse_stop);
@@ -140,6 +160,10 @@ gst_h265_parse_init (GstH265Parse * h265parse)
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (h265parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h265parse));
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (h265parse));
+
+  h265parse->fast_slice_parse = DEFAULT_FAST_SLICE_PARSE;
+  h265parse->insert_timecode = DEFAULT_INSERT_TIMECODE;
+  h265parse->aud_insert = TRUE;
 }
 
 
@@ -165,8 +189,12 @@ gst_h265_parse_reset_frame (GstH265Parse * h265parse)
   h265parse->update_caps = FALSE;
   h265parse->idr_pos = -1;
   h265parse->sei_pos = -1;
+  h265parse->vcl_pos = -1;
+  h265parse->have_time_code = FALSE;
+  h265parse->aud_insert = TRUE;
   h265parse->keyframe = FALSE;
   h265parse->header = FALSE;
+  h265parse->reference = FALSE;
   gst_adapter_clear (h265parse->frame_out);
 }
 
@@ -200,6 +228,7 @@ gst_h265_parse_reset (GstH265Parse * h265parse)
 
   h265parse->pending_key_unit_ts = GST_CLOCK_TIME_NONE;
   h265parse->force_key_unit_event = NULL;
+  h265parse->segment_flags = 0;
 
   gst_h265_parse_reset_frame (h265parse);
 }
@@ -362,28 +391,41 @@ gst_h265_parse_negotiate (GstH265Parse * h265parse, gint in_format,
     gst_caps_unref (caps);
 }
 
-static GstBuffer *
-gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
-    guint size)
+/* Stores the length prefix or start code for a NAL of @size bytes in @format
+ * in the first bytes of @prefix, and returns how many there are */
+static guint
+gst_h265_parse_nal_prefix (GstH265Parse * h265parse, guint format, guint size,
+    guint32 * prefix)
 {
-  GstBuffer *buf;
   guint nl = h265parse->nal_length_size;
-  guint32 tmp;
 
   GST_DEBUG_OBJECT (h265parse, "nal length %d", size);
 
-  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
   if (format == GST_H265_PARSE_FORMAT_HVC1
       || format == GST_H265_PARSE_FORMAT_HEV1) {
-    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+    *prefix = GUINT32_TO_BE (size << (32 - 8 * nl));
   } else {
     /* HACK: nl should always be 4 here, otherwise this won't work.
      * There are legit cases where nl in hevc stream is 2, but byte-stream
      * SC is still always 4 bytes. */
     nl = 4;
-    tmp = GUINT32_TO_BE (1);
+    *prefix = GUINT32_TO_BE (1);
   }
 
+  return nl;
+}
+
+static GstBuffer *
+gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
+    guint size)
+{
+  GstBuffer *buf;
+  guint nl;
+  guint32 tmp;
+
+  nl = gst_h265_parse_nal_prefix (h265parse, format, size, &tmp);
+
+  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
   gst_buffer_fill (buf, 0, &tmp, sizeof (guint32));
   gst_buffer_fill (buf, nl, data, size);
   gst_buffer_set_size (buf, size + nl);
@@ -391,6 +433,24 @@ gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
   return buf;
 }
 
+/* Like gst_h265_parse_wrap_nal(), but shares the memory of the NAL at
+ * @offset in @buffer instead of copying it */
+static GstBuffer *
+gst_h265_parse_wrap_nal_region (GstH265Parse * h265parse, guint format,
+    GstBuffer * buffer, guint offset, guint size)
+{
+  GstBuffer *buf;
+  guint nl;
+  guint32 tmp;
+
+  nl = gst_h265_parse_nal_prefix (h265parse, format, size, &tmp);
+
+  buf = gst_buffer_new_allocate (NULL, nl, NULL);
+  gst_buffer_fill (buf, 0, &tmp, nl);
+
+  return gst_buffer_append_region (buf, gst_buffer_ref (buffer), offset, size);
+}
+
 static void
 gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     GstH265NalUnitType naltype, GstH265NalUnit * nalu)
@@ -485,6 +545,99 @@ _nal_name (GstH265NalUnitType nal_type)
 }
 #endif
 
+/* Reads an Exp-Golomb coded unsigned value */
+static gboolean
+gst_h265_parse_read_ue (GstBitReader * br, guint32 * val)
+{
+  guint zeros = 0;
+  guint32 value = 0;
+  guint8 bit;
+
+  while (TRUE) {
+    if (!gst_bit_reader_get_bits_uint8 (br, &bit, 1))
+      return FALSE;
+    if (bit)
+      break;
+    if (++zeros > 31)
+      return FALSE;
+  }
+
+  if (zeros > 0 && !gst_bit_reader_get_bits_uint32 (br, &value, zeros))
+    return FALSE;
+
+  *val = (1 << zeros) - 1 + value;
+
+  return TRUE;
+}
+
+/* Reads only the beginning of the slice segment header, up to the slice
+ * type. Dependent slice segments have none and return FALSE */
+static gboolean
+gst_h265_parse_read_slice_start (GstH265Parse * h265parse,
+    GstH265NalUnit * nalu, guint32 * slice_type)
+{
+  const guint8 *src = nalu->data + nalu->offset + nalu->header_bytes;
+  guint src_size = nalu->size - nalu->header_bytes;
+  guint8 data[32];
+  guint i, n = 0, zeros = 0;
+  GstBitReader br;
+  guint8 first_slice_segment_in_pic_flag, dependent_slice_segment_flag = 0;
+  guint32 pps_id;
+  GstH265PPS *pps;
+
+  /* more than enough for these fields, without the emulation prevention
+   * bytes */
+  for (i = 0; i < src_size && n < sizeof (data); i++) {
+    if (zeros >= 2 && src[i] == 0x03) {
+      zeros = 0;
+      continue;
+    }
+    zeros = src[i] == 0x00 ? zeros + 1 : 0;
+    data[n++] = src[i];
+  }
+
+  gst_bit_reader_init (&br, data, n);
+
+  if (!gst_bit_reader_get_bits_uint8 (&br, &first_slice_segment_in_pic_flag,
+          1))
+    return FALSE;
+  /* no_output_of_prior_pics_flag */
+  if (nalu->type >= GST_H265_NAL_SLICE_BLA_W_LP
+      && nalu->type <= RESERVED_IRAP_NAL_TYPE_MAX
+      && !gst_bit_reader_skip (&br, 1))
+    return FALSE;
+  if (!gst_h265_parse_read_ue (&br, &pps_id)
+      || pps_id >= GST_H265_MAX_PPS_COUNT)
+    return FALSE;
+
+  pps = &h265parse->nalparser->pps[pps_id];
+  if (!pps->valid || !pps->sps || !pps->sps->valid)
+    return FALSE;
+
+  if (!first_slice_segment_in_pic_flag) {
+    guint32 size = pps->PicWidthInCtbsY * pps->PicHeightInCtbsY;
+    guint address_bits = 0;
+
+    while ((1U << address_bits) < size)
+      address_bits++;
+
+    if (pps->dependent_slice_segments_enabled_flag
+        && !gst_bit_reader_get_bits_uint8 (&br,
+            &dependent_slice_segment_flag, 1))
+      return FALSE;
+    if (!gst_bit_reader_skip (&br, address_bits))
+      return FALSE;
+  }
+
+  if (dependent_slice_segment_flag)
+    return FALSE;
+
+  if (!gst_bit_reader_skip (&br, pps->num_extra_slice_header_bits))
+    return FALSE;
+
+  return gst_h265_parse_read_ue (&br, slice_type);
+}
+
 /* caller guarantees 2 bytes of nal payload */
 static void
 gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
@@ -593,6 +746,15 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         GST_DEBUG_OBJECT (h265parse, "marking SEI in frame at offset %d",
             h265parse->sei_pos);
       }
+      if (h265parse->insert_timecode && nal_type == GST_H265_NAL_PREFIX_SEI
+          && gst_video_parse_sei_has_payload_type (nalu->data + nalu->offset +
+              nalu->header_bytes, nalu->size - nalu->header_bytes,
+              GST_H265_SEI_TIME_CODE))
+        h265parse->have_time_code = TRUE;
+      break;
+    case GST_H265_NAL_AUD:
+      gst_h265_parser_parse_nal (nalparser, nalu);
+      h265parse->aud_insert = FALSE;
       break;
 
     case GST_H265_NAL_SLICE_TRAIL_N:
@@ -611,25 +773,46 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     case GST_H265_NAL_SLICE_IDR_W_RADL:
     case GST_H265_NAL_SLICE_IDR_N_LP:
     case GST_H265_NAL_SLICE_CRA_NUT:
-    {
-      GstH265SliceHdr slice;
+      /* mark where an inserted SEI needs to go */
+      if (h265parse->vcl_pos == -1) {
+        if (h265parse->transform)
+          h265parse->vcl_pos = gst_adapter_available (h265parse->frame_out);
+        else
+          h265parse->vcl_pos = nalu->sc_offset;
+      }
+      /* sub-layer non-reference pictures of the highest sub-layer are not
+       * used by any other picture */
+      if (nal_type > GST_H265_NAL_SLICE_RASL_R || nal_type % 2 == 1
+          || !nalparser->last_sps || nalu->temporal_id_plus1 - 1 <
+          nalparser->last_sps->max_sub_layers_minus1)
+        h265parse->reference = TRUE;
+      if (h265parse->fast_slice_parse) {
+        guint32 slice_type;
+
+        if (gst_h265_parse_read_slice_start (h265parse, nalu, &slice_type)) {
+          GST_DEBUG_OBJECT (h265parse, "slice type: %u", slice_type);
+          if (slice_type == GST_H265_I_SLICE)
+            h265parse->keyframe |= TRUE;
+        }
+      } else {
+        GstH265SliceHdr slice;
 
-      pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
+        pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
 
-      if (pres == GST_H265_PARSER_OK) {
-        if (GST_H265_IS_I_SLICE (&slice))
-          h265parse->keyframe |= TRUE;
-      }
-      if (slice.first_slice_segment_in_pic_flag == 1)
-        GST_DEBUG_OBJECT (h265parse,
-            "frame start, first_slice_segment_in_pic_flag = 1");
+        if (pres == GST_H265_PARSER_OK) {
+          if (GST_H265_IS_I_SLICE (&slice))
+            h265parse->keyframe |= TRUE;
+        }
+        if (slice.first_slice_segment_in_pic_flag == 1)
+          GST_DEBUG_OBJECT (h265parse,
+              "frame start, first_slice_segment_in_pic_flag = 1");
 
-      GST_DEBUG_OBJECT (h265parse,
-          "parse result %d, first slice_segment: %u, slice type: %u",
-          pres, slice.first_slice_segment_in_pic_flag, slice.type);
+        GST_DEBUG_OBJECT (h265parse,
+            "parse result %d, first slice_segment: %u, slice type: %u",
+            pres, slice.first_slice_segment_in_pic_flag, slice.type);
 
-      gst_h265_slice_hdr_free (&slice);
-    }
+        gst_h265_slice_hdr_free (&slice);
+      }
 
       is_irap = ((nal_type >= GST_H265_NAL_SLICE_BLA_W_LP)
           && (nal_type <= GST_H265_NAL_SLICE_CRA_NUT)) ? TRUE : FALSE;
@@ -666,8 +849,12 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h265parse, "collecting NAL in HEVC frame");
-    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    if (h265parse->nal_buffer)
+      buf = gst_h265_parse_wrap_nal_region (h265parse, h265parse->format,
+          h265parse->nal_buffer, nalu->offset, nalu->size);
+    else
+      buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
+          nalu->data + nalu->offset, nalu->size);
     gst_adapter_push (h265parse->frame_out, buf);
   }
 }
@@ -758,7 +945,9 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h265parse, "HEVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
+    h265parse->nal_buffer = buffer;
     gst_h265_parse_process_nal (h265parse, &nalu);
+    h265parse->nal_buffer = NULL;
 
     /* dispatch per NALU if needed */
     if (h265parse->split_packetized) {
@@ -976,7 +1165,10 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
         nalu.type == GST_H265_NAL_SPS ||
         nalu.type == GST_H265_NAL_PPS ||
         (h265parse->have_sps && h265parse->have_pps)) {
+      /* the converted NALs can share the memory of the input */
+      h265parse->nal_buffer = buffer;
       gst_h265_parse_process_nal (h265parse, &nalu);
+      h265parse->nal_buffer = NULL;
     } else {
       GST_WARNING_OBJECT (h265parse,
           "no SPS/PPS yet, nal Type: %d %s, Size: %u will be dropped",
@@ -1623,6 +1815,25 @@ gst_h265_parse_update_src_caps (GstH265Parse * h265parse, GstCaps * caps)
 
 }
 
+/* in trick modes, pictures which are not needed to decode the ones shown
+ * are dropped: key unit trick modes only keep keyframes, others drop
+ * non-reference pictures */
+static gboolean
+gst_h265_parse_skip_picture (GstH265Parse * h265parse)
+{
+  /* only whole pictures can be dropped, and never the configuration */
+  if (h265parse->align != GST_H265_PARSE_ALIGN_AU || h265parse->header)
+    return FALSE;
+
+  if (h265parse->segment_flags & GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS)
+    return !h265parse->keyframe;
+
+  if (h265parse->segment_flags & GST_SEGMENT_FLAG_TRICKMODE)
+    return !h265parse->reference;
+
+  return FALSE;
+}
+
 static GstFlowReturn
 gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
@@ -1649,12 +1860,19 @@ gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   else
     GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_HEADER);
 
+  if (G_UNLIKELY (h265parse->segment_flags)
+      && gst_h265_parse_skip_picture (h265parse)) {
+    GST_LOG_OBJECT (h265parse, "dropping %s picture in trick mode",
+        h265parse->reference ? "reference" : "non-reference");
+    frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
+  }
+
   /* replace with transformed HEVC output if applicable */
   av = gst_adapter_available (h265parse->frame_out);
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h265parse->frame_out, av);
+    buf = gst_adapter_take_buffer_fast (h265parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -1783,6 +2001,81 @@ gst_h265_parse_prepare_key_unit (GstH265Parse * parse, GstEvent * event)
   parse->push_codec = TRUE;
 }
 
+/* AU delimiter NAL, for pic_type 2 (I, P or B slices) */
+static const guint8 au_delim[7] = {
+  0x00, 0x00, 0x00, 0x01,       /* nal prefix */
+  0x46, 0x01,                   /* nal unit type = access unit delimiter */
+  0x50                          /* pic_type, rbsp stop bit */
+};
+
+/* inserts a time code SEI carrying the time code of the buffer's meta in
+ * front of the first slice segment, sharing the rest of the AU with @buffer */
+static void
+gst_h265_parse_insert_timecode (GstH265Parse * h265parse,
+    GstBaseParseFrame * frame)
+{
+  /* prefix SEI, nuh_layer_id 0, nuh_temporal_id_plus1 1 */
+  static const guint8 sei_header[] = { GST_H265_NAL_PREFIX_SEI << 1, 0x01 };
+  GstVideoTimeCodeMeta *tc_meta;
+  GstVideoTimeCode *tc;
+  GstVideoParseSeiPayload payload;
+  GstBuffer *buffer, *new_buf;
+  GstMemory *mem;
+  guint size;
+
+  if (h265parse->have_time_code || h265parse->vcl_pos < 0)
+    return;
+
+  tc_meta = gst_buffer_get_video_time_code_meta (frame->buffer);
+  if (!tc_meta)
+    return;
+
+  tc = &tc_meta->tc;
+  GST_LOG_OBJECT (h265parse, "inserting time code %02u:%02u:%02u:%02u",
+      tc->hours, tc->minutes, tc->seconds, tc->frames);
+
+  gst_video_parse_sei_payload_init (&payload);
+  /* num_clock_ts, clock_timestamp_flag[0] */
+  gst_video_parse_sei_payload_put_bits (&payload, 1, 2);
+  gst_video_parse_sei_payload_put_bits (&payload, 1, 1);
+  /* units_field_based_flag */
+  gst_video_parse_sei_payload_put_bits (&payload, 0, 1);
+  /* counting_type: no dropping, or NTSC drop-frame */
+  gst_video_parse_sei_payload_put_bits (&payload,
+      tc->config.flags & GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME ? 4 : 0, 5);
+  /* full_timestamp_flag, discontinuity_flag, cnt_dropped_flag */
+  gst_video_parse_sei_payload_put_bits (&payload, 1, 1);
+  gst_video_parse_sei_payload_put_bits (&payload, 0, 1);
+  gst_video_parse_sei_payload_put_bits (&payload, 0, 1);
+  gst_video_parse_sei_payload_put_bits (&payload, tc->frames, 9);
+  gst_video_parse_sei_payload_put_bits (&payload, tc->seconds, 6);
+  gst_video_parse_sei_payload_put_bits (&payload, tc->minutes, 6);
+  gst_video_parse_sei_payload_put_bits (&payload, tc->hours, 5);
+  /* time_offset_length */
+  gst_video_parse_sei_payload_put_bits (&payload, 0, 5);
+  size = gst_video_parse_sei_payload_finish (&payload);
+
+  mem = gst_video_parse_create_sei_nal (sei_header, sizeof (sei_header),
+      GST_H265_SEI_TIME_CODE, payload.data, size,
+      h265parse->format == GST_H265_PARSE_FORMAT_BYTE ? 0 :
+      h265parse->nal_length_size);
+
+  buffer = frame->out_buffer ? frame->out_buffer : frame->buffer;
+  new_buf = gst_buffer_append_region (gst_buffer_new (),
+      gst_buffer_ref (buffer), 0, h265parse->vcl_pos);
+  gst_buffer_append_memory (new_buf, mem);
+  new_buf = gst_buffer_append_region (new_buf, gst_buffer_ref (buffer),
+      h265parse->vcl_pos, -1);
+  gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_replace (&frame->out_buffer, new_buf);
+  gst_buffer_unref (new_buf);
+
+  /* config goes in front of the SEI if it was to go in front of the slice */
+  if (h265parse->idr_pos > h265parse->vcl_pos)
+    h265parse->idr_pos += gst_buffer_get_size (frame->out_buffer) -
+        gst_buffer_get_size (buffer);
+}
+
 static GstFlowReturn
 gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
@@ -1820,7 +2113,37 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     h265parse->sent_codec_tag = TRUE;
   }
 
-  buffer = frame->buffer;
+  /* index keyframes, for keyframe stepping in trick modes */
+  if (h265parse->align == GST_H265_PARSE_ALIGN_AU
+      && !GST_BUFFER_FLAG_IS_SET (frame->buffer, GST_BUFFER_FLAG_DELTA_UNIT)
+      && frame->offset != -1 && GST_BUFFER_PTS_IS_VALID (frame->buffer))
+    gst_base_parse_add_index_entry (parse, frame->offset,
+        GST_BUFFER_PTS (frame->buffer), TRUE, FALSE);
+
+  if (h265parse->align == GST_H265_PARSE_ALIGN_AU) {
+    if (h265parse->insert_timecode)
+      gst_h265_parse_insert_timecode (h265parse, frame);
+
+    /* In case of byte-stream, insert au delimiter by default
+     * if it doesn't exist */
+    if (h265parse->aud_insert
+        && h265parse->format == GST_H265_PARSE_FORMAT_BYTE) {
+      GstMemory *mem =
+          gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, (guint8 *) au_delim,
+          sizeof (au_delim), 0, sizeof (au_delim), NULL, NULL);
+
+      /* shallow copy, the AU itself is shared */
+      buffer = gst_buffer_copy (frame->out_buffer ? frame->out_buffer :
+          frame->buffer);
+      gst_buffer_prepend_memory (buffer, mem);
+      gst_buffer_replace (&frame->out_buffer, buffer);
+      gst_buffer_unref (buffer);
+      if (h265parse->idr_pos >= 0)
+        h265parse->idr_pos += sizeof (au_delim);
+    }
+  }
+
+  buffer = frame->out_buffer ? frame->out_buffer : frame->buffer;
 
   if ((event = check_pending_key_unit_event (h265parse->force_key_unit_event,
               &parse->segment, GST_BUFFER_TIMESTAMP (buffer),
@@ -1892,71 +2215,35 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
             }
           }
         } else {
-          /* insert config NALs into AU */
-          GstByteWriter bw;
+          /* insert config NALs into AU, the rest of it is shared with
+           * @buffer */
           GstBuffer *new_buf;
-          const gboolean bs = h265parse->format == GST_H265_PARSE_FORMAT_BYTE;
-          const gint nls = 4 - h265parse->nal_length_size;
-          gboolean ok;
-
-          gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer),
-              FALSE);
-          ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h265parse->idr_pos);
+          GstBuffer **codec_nals[] = { h265parse->vps_nals,
+            h265parse->sps_nals, h265parse->pps_nals
+          };
+          const gint n_codec_nals[] = { GST_H265_MAX_VPS_COUNT,
+            GST_H265_MAX_SPS_COUNT, GST_H265_MAX_PPS_COUNT
+          };
+          guint j;
+
+          new_buf = gst_buffer_append_region (gst_buffer_new (),
+              gst_buffer_ref (buffer), 0, h265parse->idr_pos);
           GST_DEBUG_OBJECT (h265parse, "- inserting VPS/SPS/PPS");
-          for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
-            if ((codec_nal = h265parse->vps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
-              GST_DEBUG_OBJECT (h265parse, "inserting VPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
+          for (j = 0; j < G_N_ELEMENTS (codec_nals); j++) {
+            for (i = 0; i < n_codec_nals[j]; i++) {
+              if ((codec_nal = codec_nals[j][i])) {
+                GST_DEBUG_OBJECT (h265parse, "inserting %s nal",
+                    j == 0 ? "VPS" : (j == 1 ? "SPS" : "PPS"));
+                new_buf = gst_buffer_append (new_buf,
+                    gst_h265_parse_wrap_nal_region (h265parse,
+                        h265parse->format, codec_nal, 0,
+                        gst_buffer_get_size (codec_nal)));
+                h265parse->last_report = new_ts;
               }
-
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-              h265parse->last_report = new_ts;
             }
           }
-          for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
-            if ((codec_nal = h265parse->sps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
-              GST_DEBUG_OBJECT (h265parse, "inserting SPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-              h265parse->last_report = new_ts;
-            }
-          }
-          for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
-            if ((codec_nal = h265parse->pps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
-              GST_DEBUG_OBJECT (h265parse, "inserting PPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-              h265parse->last_report = new_ts;
-            }
-          }
-          ok &=
-              gst_byte_writer_put_buffer (&bw, buffer, h265parse->idr_pos, -1);
-          /* collect result and push */
-          new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
+          new_buf = gst_buffer_append_region (new_buf, gst_buffer_ref (buffer),
+              h265parse->idr_pos, -1);
           gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0,
               -1);
           /* should already be keyframe/IDR, but it may not have been,
@@ -1964,10 +2251,6 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
           GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
           gst_buffer_replace (&frame->out_buffer, new_buf);
           gst_buffer_unref (new_buf);
-          /* some result checking seems to make some compilers happy */
-          if (G_UNLIKELY (!ok)) {
-            GST_ERROR_OBJECT (h265parse, "failed to insert SPS/PPS");
-          }
         }
       }
       /* we pushed whatever we had */
@@ -2242,6 +2525,14 @@ gst_h265_parse_event (GstBaseParse * parse, GstEvent * event)
       break;
     case GST_EVENT_SEGMENT:
     {
+      const GstSegment *segment;
+
+      gst_event_parse_segment (event, &segment);
+      h265parse->segment_flags = segment->flags &
+          (GST_SEGMENT_FLAG_TRICKMODE | GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS);
+      GST_DEBUG_OBJECT (h265parse, "trick mode flags 0x%x",
+          h265parse->segment_flags);
+
       res = GST_BASE_PARSE_CLASS (parent_class)->sink_event (parse, event);
       break;
     }
@@ -2301,6 +2592,12 @@ gst_h265_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_uint (value);
       break;
+    case PROP_FAST_SLICE_PARSE:
+      parse->fast_slice_parse = g_value_get_boolean (value);
+      break;
+    case PROP_INSERT_TIMECODE:
+      parse->insert_timecode = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2318,6 +2615,12 @@ gst_h265_parse_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CONFIG_INTERVAL:
       g_value_set_uint (value, parse->interval);
       break;
+    case PROP_FAST_SLICE_PARSE:
+      g_value_set_boolean (value, parse->fast_slice_parse);
+      break;
+    case PROP_INSERT_TIMECODE:
+      g_value_set_boolean (value, parse->insert_timecode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -80,20 +80,33 @@ struct _GstH265Parse
 
   /* frame parsing */
   gint idr_pos, sei_pos;
+  /* position of the first slice segment NAL */
+  gint vcl_pos;
+  gboolean have_time_code;
+  gboolean aud_insert;
   gboolean update_caps;
   GstAdapter *frame_out;
+  /* the input buffer the NAL being processed is in, if any */
+  GstBuffer *nal_buffer;
   gboolean keyframe;
   gboolean header;
+  /* the picture is used for reference */
+  gboolean reference;
   /* AU state */
   gboolean picture_start;
 
   /* props */
   guint interval;
+  gboolean fast_slice_parse;
+  gboolean insert_timecode;
 
   gboolean sent_codec_tag;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
+
+  /* trick mode flags of the current segment */
+  GstSegmentFlags segment_flags;
 };
 
 struct _GstH265ParseClass
@@ -23,6 +23,7 @@
 #endif
 
 #include "gstjpeg2000parse.h"
+#include <gst/codecparsers/gstjpeg2000meta.h>
 #include <gst/base/base.h>
 
 /* Not used at the moment
@@ -114,12 +115,17 @@ static GstStaticPadTemplate sinktemplate =
 G_DEFINE_TYPE (GstJPEG2000Parse, gst_jpeg2000_parse, GST_TYPE_BASE_PARSE);
 
 static gboolean gst_jpeg2000_parse_start (GstBaseParse * parse);
+static gboolean gst_jpeg2000_parse_stop (GstBaseParse * parse);
 static gboolean gst_jpeg2000_parse_event (GstBaseParse * parse,
     GstEvent * event);
 static GstFlowReturn gst_jpeg2000_parse_handle_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame, gint * skipsize);
 static gboolean gst_jpeg2000_parse_set_sink_caps (GstBaseParse * parse,
     GstCaps * caps);
+static gboolean gst_jpeg2000_parse_sink_query (GstBaseParse * parse,
+    GstQuery * query);
+static GstFlowReturn gst_jpeg2000_parse_pre_push_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame);
 
 static void
 gst_jpeg2000_parse_class_init (GstJPEG2000ParseClass * klass)
@@ -140,6 +146,10 @@ gst_jpeg2000_parse_class_init (GstJPEG2000ParseClass * klass)
   parse_class->set_sink_caps =
       GST_DEBUG_FUNCPTR (gst_jpeg2000_parse_set_sink_caps);
   parse_class->start = GST_DEBUG_FUNCPTR (gst_jpeg2000_parse_start);
+  parse_class->stop = GST_DEBUG_FUNCPTR (gst_jpeg2000_parse_stop);
+  parse_class->sink_query = GST_DEBUG_FUNCPTR (gst_jpeg2000_parse_sink_query);
+  parse_class->pre_push_frame =
+      GST_DEBUG_FUNCPTR (gst_jpeg2000_parse_pre_push_frame);
   parse_class->sink_event = GST_DEBUG_FUNCPTR (gst_jpeg2000_parse_event);
   parse_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_jpeg2000_parse_handle_frame);
@@ -158,9 +168,60 @@ gst_jpeg2000_parse_start (GstBaseParse * parse)
   jpeg2000parse->sampling = GST_JPEG2000_SAMPLING_NONE;
   jpeg2000parse->colorspace = GST_JPEG2000_COLORSPACE_NONE;
   jpeg2000parse->codec_format = GST_JPEG2000_PARSE_NO_CODEC;
+  jpeg2000parse->have_codestream = FALSE;
+  jpeg2000parse->send_tile_part_meta = FALSE;
   return TRUE;
 }
 
+static gboolean
+gst_jpeg2000_parse_stop (GstBaseParse * parse)
+{
+  GstJPEG2000Parse *jpeg2000parse = GST_JPEG2000_PARSE (parse);
+
+  gst_jpeg2000_codestream_clear (&jpeg2000parse->codestream);
+
+  return TRUE;
+}
+
+static gboolean
+gst_jpeg2000_parse_sink_query (GstBaseParse * parse, GstQuery * query)
+{
+  gboolean res;
+  GstJPEG2000Parse *jpeg2000parse = GST_JPEG2000_PARSE (parse);
+
+  res = GST_BASE_PARSE_CLASS (parent_class)->sink_query (parse, query);
+
+  if (res && GST_QUERY_TYPE (query) == GST_QUERY_ALLOCATION) {
+    jpeg2000parse->send_tile_part_meta =
+        gst_query_find_allocation_meta (query,
+        GST_JPEG2000_TILE_PART_META_API_TYPE, NULL);
+
+    GST_DEBUG_OBJECT (parse, "Downstream can handle GstJPEG2000TilePartMeta: "
+        "%d", jpeg2000parse->send_tile_part_meta);
+  }
+
+  return res;
+}
+
+static GstFlowReturn
+gst_jpeg2000_parse_pre_push_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame)
+{
+  GstJPEG2000Parse *jpeg2000parse = GST_JPEG2000_PARSE (parse);
+
+  if (jpeg2000parse->send_tile_part_meta && jpeg2000parse->have_codestream) {
+    GST_DEBUG_OBJECT (jpeg2000parse, "Adding GstJPEG2000TilePartMeta with %u "
+        "tile-parts", jpeg2000parse->codestream.tile_parts->len);
+
+    frame->buffer = gst_buffer_make_writable (frame->buffer);
+    gst_buffer_add_jpeg2000_tile_part_meta (frame->buffer,
+        jpeg2000parse->codestream_offset, &jpeg2000parse->codestream);
+  }
+  jpeg2000parse->have_codestream = FALSE;
+
+  return GST_FLOW_OK;
+}
+
 
 static void
 gst_jpeg2000_parse_init (GstJPEG2000Parse * jpeg2000parse)
@@ -307,6 +368,7 @@ gst_jpeg2000_parse_handle_frame (GstBaseParse * parse,
   guint frame_size = 0;
   gboolean is_j2c;
   gboolean parsed_j2c_4cc = FALSE;
+  GstJPEG2000ParserResult cs_res;
 
   if (!gst_buffer_map (frame->buffer, &map, GST_MAP_READ)) {
     GST_ERROR_OBJECT (jpeg2000parse, "Unable to map buffer");
@@ -728,8 +790,34 @@ gst_jpeg2000_parse_handle_frame (GstBaseParse * parse,
   }
   /*************************************************/
 
+  /* jump from tile-part to tile-part to find the frame end */
+  jpeg2000parse->have_codestream = FALSE;
+  cs_res = gst_jpeg2000_parser_parse_codestream (map.data + magic_offset,
+      map.size - magic_offset, &jpeg2000parse->codestream);
+  if (cs_res == GST_JPEG2000_PARSER_NO_MORE_DATA)
+    goto beach;
+
+  if (cs_res == GST_JPEG2000_PARSER_OK) {
+    guint cs_frame_size = magic_offset + jpeg2000parse->codestream.size;
+    GST_DEBUG_OBJECT (jpeg2000parse,
+        "Found %u tile-parts, frame size = %d",
+        jpeg2000parse->codestream.tile_parts->len, cs_frame_size);
+
+    if (frame_size && frame_size != cs_frame_size) {
+      GST_WARNING_OBJECT (jpeg2000parse,
+          "Frame size %d from contiguous code size does not equal frame size %d of the code stream",
+          frame_size, cs_frame_size);
+    }
+    frame_size = cs_frame_size;
+    jpeg2000parse->codestream_offset = magic_offset;
+    jpeg2000parse->have_codestream = TRUE;
+    goto finish;
+  }
+
   /* look for EOC to mark frame end */
   /* look for EOC end of codestream marker  */
+  GST_WARNING_OBJECT (jpeg2000parse,
+      "Invalid tile-part structure, scanning for EOC");
   eoc_offset = gst_byte_reader_masked_scan_uint32 (&reader, 0x0000ffff,
       0xFFD9, 0, gst_byte_reader_get_remaining (&reader));
 
@@ -754,6 +842,7 @@ gst_jpeg2000_parse_handle_frame (GstBaseParse * parse,
     goto beach;
   }
 
+finish:
   /* clean up and finish frame */
   if (current_caps)
     gst_caps_unref (current_caps);
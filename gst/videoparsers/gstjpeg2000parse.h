@@ -25,6 +25,7 @@
 #include <gst/base/gstadapter.h>
 #include <gst/base/gstbaseparse.h>
 #include <gst/codecparsers/gstjpeg2000sampling.h>
+#include <gst/codecparsers/gstjpeg2000parser.h>
 
 G_BEGIN_DECLS
 #define GST_TYPE_JPEG2000_PARSE \
@@ -122,6 +123,13 @@ struct _GstJPEG2000Parse
   GstJPEG2000Sampling sampling;
   GstJPEG2000Colorspace colorspace;
   GstJPEG2000ParseFormats codec_format;
+
+  /* layout of the code stream of the current frame */
+  GstJPEG2000Codestream codestream;
+  guint codestream_offset;
+  gboolean have_codestream;
+  /* downstream can handle GstJPEG2000TilePartMeta */
+  gboolean send_tile_part_meta;
 };
 
 struct _GstJPEG2000ParseClass
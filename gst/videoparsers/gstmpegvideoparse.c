@@ -76,6 +76,8 @@ static GstCaps *gst_mpegv_parse_get_caps (GstBaseParse * parse,
     GstCaps * filter);
 static GstFlowReturn gst_mpegv_parse_pre_push_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame);
+static gboolean gst_mpegv_parse_sink_event (GstBaseParse * parse,
+    GstEvent * event);
 static gboolean gst_mpegv_parse_sink_query (GstBaseParse * parse,
     GstQuery * query);
 
@@ -165,6 +167,7 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
   parse_class->get_sink_caps = GST_DEBUG_FUNCPTR (gst_mpegv_parse_get_caps);
   parse_class->pre_push_frame =
       GST_DEBUG_FUNCPTR (gst_mpegv_parse_pre_push_frame);
+  parse_class->sink_event = GST_DEBUG_FUNCPTR (gst_mpegv_parse_sink_event);
   parse_class->sink_query = GST_DEBUG_FUNCPTR (gst_mpegv_parse_sink_query);
 }
 
@@ -191,6 +194,7 @@ gst_mpegv_parse_reset_frame (GstMpegvParse * mpvparse)
   mpvparse->ext_count = 0;
   mpvparse->slice_count = 0;
   mpvparse->slice_offset = 0;
+  mpvparse->gop_start = FALSE;
 }
 
 static void
@@ -201,6 +205,7 @@ gst_mpegv_parse_reset (GstMpegvParse * mpvparse)
   mpvparse->update_caps = TRUE;
   mpvparse->send_codec_tag = TRUE;
   mpvparse->send_mpeg_meta = TRUE;
+  mpvparse->segment_flags = 0;
 
   gst_buffer_replace (&mpvparse->config, NULL);
   memset (&mpvparse->sequencehdr, 0, sizeof (mpvparse->sequencehdr));
@@ -216,6 +221,24 @@ gst_mpegv_parse_reset (GstMpegvParse * mpvparse)
   mpvparse->quantmatrext_updated = FALSE;
 }
 
+static gboolean
+gst_mpegv_parse_sink_event (GstBaseParse * parse, GstEvent * event)
+{
+  GstMpegvParse *mpvparse = GST_MPEGVIDEO_PARSE (parse);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+    const GstSegment *segment;
+
+    gst_event_parse_segment (event, &segment);
+    mpvparse->segment_flags = segment->flags &
+        (GST_SEGMENT_FLAG_TRICKMODE | GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS);
+    GST_DEBUG_OBJECT (mpvparse, "trick mode flags 0x%x",
+        mpvparse->segment_flags);
+  }
+
+  return GST_BASE_PARSE_CLASS (parent_class)->sink_event (parse, event);
+}
+
 static gboolean
 gst_mpegv_parse_sink_query (GstBaseParse * parse, GstQuery * query)
 {
@@ -501,6 +524,9 @@ gst_mpegv_parse_process_sc (GstMpegvParse * mpvparse,
         ret = mpvparse->gop_split;
       else
         ret = TRUE;
+      /* unless it terminates the preceding frame */
+      if (off == 4 || !ret)
+        mpvparse->gop_start = TRUE;
       break;
     case GST_MPEG_VIDEO_PACKET_EXTENSION:
       mpvparse->config_flags |= FLAG_MPEG2;
@@ -888,6 +914,27 @@ gst_mpegv_parse_update_src_caps (GstMpegvParse * mpvparse)
   mpvparse->update_caps = FALSE;
 }
 
+/* in trick modes, pictures which are not needed to decode the ones shown
+ * are dropped: key unit trick modes only keep I pictures, others drop
+ * B pictures, which are never referenced */
+static gboolean
+gst_mpegv_parse_skip_picture (GstMpegvParse * mpvparse)
+{
+  guint8 pic_type = mpvparse->pichdr.pic_type;
+
+  /* keep the configuration */
+  if (mpvparse->pic_offset < 0 || mpvparse->seq_offset >= 0)
+    return FALSE;
+
+  if (mpvparse->segment_flags & GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS)
+    return pic_type != GST_MPEG_VIDEO_PICTURE_TYPE_I;
+
+  if (mpvparse->segment_flags & GST_SEGMENT_FLAG_TRICKMODE)
+    return pic_type == GST_MPEG_VIDEO_PICTURE_TYPE_B;
+
+  return FALSE;
+}
+
 static GstFlowReturn
 gst_mpegv_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
@@ -922,6 +969,13 @@ gst_mpegv_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     return GST_BASE_PARSE_FLOW_DROPPED;
   }
 
+  if (G_UNLIKELY (mpvparse->segment_flags)
+      && gst_mpegv_parse_skip_picture (mpvparse)) {
+    GST_LOG_OBJECT (mpvparse, "dropping %s picture in trick mode",
+        picture_type_name (mpvparse->pichdr.pic_type));
+    return GST_BASE_PARSE_FLOW_DROPPED;
+  }
+
   gst_mpegv_parse_update_src_caps (mpvparse);
   return GST_FLOW_OK;
 }
@@ -971,6 +1025,17 @@ gst_mpegv_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   /* usual clipping applies */
   frame->flags |= GST_BASE_PARSE_FRAME_FLAG_CLIP;
 
+  /* index the start of each GOP, for keyframe stepping in trick modes */
+  if (mpvparse->pic_offset >= 0
+      && mpvparse->pichdr.pic_type == GST_MPEG_VIDEO_PICTURE_TYPE_I
+      && (mpvparse->gop_start || mpvparse->seq_offset >= 0)
+      && frame->offset != -1 && GST_BUFFER_PTS_IS_VALID (frame->buffer)) {
+    GST_LOG_OBJECT (mpvparse, "GOP at offset %" G_GUINT64_FORMAT,
+        frame->offset);
+    gst_base_parse_add_index_entry (parse, frame->offset,
+        GST_BUFFER_PTS (frame->buffer), TRUE, FALSE);
+  }
+
   if (mpvparse->send_mpeg_meta) {
     GstBuffer *buf;
 
@@ -67,6 +67,7 @@ struct _GstMpegvParse {
   gint pic_offset;
   guint slice_count;
   guint slice_offset;
+  gboolean gop_start;
   gboolean update_caps;
   gboolean send_codec_tag;
   gboolean send_mpeg_meta;
@@ -94,6 +95,9 @@ struct _GstMpegvParse {
   int fps_num;
   int fps_den;
   int frame_repeat_count;
+
+  /* trick mode flags of the current segment */
+  GstSegmentFlags segment_flags;
 };
 
 struct _GstMpegvParseClass {
@@ -0,0 +1,161 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstvideoparseutils.h"
+
+#include <string.h>
+
+void
+gst_video_parse_sei_payload_init (GstVideoParseSeiPayload * payload)
+{
+  memset (payload, 0, sizeof (GstVideoParseSeiPayload));
+}
+
+void
+gst_video_parse_sei_payload_put_bits (GstVideoParseSeiPayload * payload,
+    guint32 value, guint nbits)
+{
+  g_return_if_fail (nbits <= 32);
+  g_return_if_fail (payload->pos + nbits <=
+      GST_VIDEO_PARSE_SEI_MAX_PAYLOAD_SIZE * 8);
+
+  while (nbits--) {
+    if (value & (1U << nbits))
+      payload->data[payload->pos / 8] |= 0x80 >> (payload->pos % 8);
+    payload->pos++;
+  }
+}
+
+/* Appends the payload alignment bits, returns the payload size in bytes */
+guint
+gst_video_parse_sei_payload_finish (GstVideoParseSeiPayload * payload)
+{
+  if (payload->pos % 8) {
+    gst_video_parse_sei_payload_put_bits (payload, 1, 1);
+    payload->pos = GST_ROUND_UP_8 (payload->pos);
+  }
+
+  return payload->pos / 8;
+}
+
+/* Creates a NAL holding a single SEI message, prefixed by a 4 byte start code
+ * if @nal_length_size is 0, by its big-endian size otherwise. Only the new
+ * NAL is escaped, so it can be inserted into an access unit as a memory of
+ * its own. */
+GstMemory *
+gst_video_parse_create_sei_nal (const guint8 * nal_header,
+    guint nal_header_size, guint payload_type, const guint8 * payload,
+    guint payload_size, guint nal_length_size)
+{
+  guint8 rbsp[GST_VIDEO_PARSE_SEI_MAX_PAYLOAD_SIZE * 2 + 2];
+  guint8 *data;
+  guint rbsp_size = 0, prefix_size, size, i, n, zeros;
+  guint val;
+
+  g_return_val_if_fail (payload_size <= GST_VIDEO_PARSE_SEI_MAX_PAYLOAD_SIZE,
+      NULL);
+  g_return_val_if_fail (nal_length_size <= 4, NULL);
+
+  /* sei_message (), then rbsp_trailing_bits () */
+  for (val = payload_type; val >= 0xff; val -= 0xff)
+    rbsp[rbsp_size++] = 0xff;
+  rbsp[rbsp_size++] = val;
+  rbsp[rbsp_size++] = payload_size;
+  memcpy (rbsp + rbsp_size, payload, payload_size);
+  rbsp_size += payload_size;
+  rbsp[rbsp_size++] = 0x80;
+
+  prefix_size = nal_length_size ? nal_length_size : 4;
+  /* worst case, one emulation prevention byte every two bytes */
+  data = g_malloc (prefix_size + nal_header_size + rbsp_size * 3 / 2 + 1);
+  memcpy (data + prefix_size, nal_header, nal_header_size);
+
+  size = prefix_size + nal_header_size;
+  for (i = 0, zeros = 0; i < rbsp_size; i++) {
+    if (zeros == 2 && rbsp[i] <= 0x03) {
+      data[size++] = 0x03;
+      zeros = 0;
+    }
+    data[size++] = rbsp[i];
+    zeros = rbsp[i] ? 0 : zeros + 1;
+  }
+
+  if (nal_length_size) {
+    n = size - prefix_size;
+    for (i = 0; i < nal_length_size; i++)
+      data[i] = n >> (8 * (nal_length_size - 1 - i));
+  } else {
+    data[0] = data[1] = data[2] = 0;
+    data[3] = 1;
+  }
+
+  return gst_memory_new_wrapped (0, data, size, 0, size, data, g_free);
+}
+
+/* Checks whether the escaped SEI RBSP in @data, following the NAL header,
+ * carries a message of @payload_type */
+gboolean
+gst_video_parse_sei_has_payload_type (const guint8 * data, gsize size,
+    guint payload_type)
+{
+  gsize i = 0, skip;
+  guint zeros = 0, type, payload_size;
+  gboolean in_size = FALSE;
+
+  type = payload_size = 0;
+  skip = 0;
+  while (i < size) {
+    guint8 byte = data[i++];
+
+    /* drop emulation prevention bytes */
+    if (zeros == 2 && byte == 0x03) {
+      zeros = 0;
+      continue;
+    }
+    zeros = byte ? 0 : zeros + 1;
+
+    if (skip) {
+      skip--;
+      continue;
+    }
+
+    /* the rbsp_trailing_bits () byte ends the loop without a match, as
+     * nothing follows it */
+    if (!in_size) {
+      type += byte;
+      if (byte == 0xff)
+        continue;
+      if (type == payload_type)
+        return TRUE;
+      in_size = TRUE;
+    } else {
+      payload_size += byte;
+      if (byte == 0xff)
+        continue;
+      skip = payload_size;
+      type = payload_size = 0;
+      in_size = FALSE;
+    }
+  }
+
+  return FALSE;
+}
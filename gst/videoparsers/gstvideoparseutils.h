@@ -0,0 +1,54 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEO_PARSE_UTILS_H__
+#define __GST_VIDEO_PARSE_UTILS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* big enough for the small SEI payloads the parsers generate themselves */
+#define GST_VIDEO_PARSE_SEI_MAX_PAYLOAD_SIZE 32
+
+typedef struct _GstVideoParseSeiPayload GstVideoParseSeiPayload;
+
+/* Minimal MSB-first bit writer for SEI payloads */
+struct _GstVideoParseSeiPayload
+{
+  guint8 data[GST_VIDEO_PARSE_SEI_MAX_PAYLOAD_SIZE];
+  /* write position, in bits */
+  guint pos;
+};
+
+void gst_video_parse_sei_payload_init (GstVideoParseSeiPayload * payload);
+
+void gst_video_parse_sei_payload_put_bits (GstVideoParseSeiPayload * payload,
+    guint32 value, guint nbits);
+
+guint gst_video_parse_sei_payload_finish (GstVideoParseSeiPayload * payload);
+
+GstMemory *gst_video_parse_create_sei_nal (const guint8 * nal_header,
+    guint nal_header_size, guint payload_type, const guint8 * payload,
+    guint payload_size, guint nal_length_size);
+
+gboolean gst_video_parse_sei_has_payload_type (const guint8 * data,
+    gsize size, guint payload_type);
+
+G_END_DECLS
+#endif /* __GST_VIDEO_PARSE_UTILS_H__ */
@@ -0,0 +1,529 @@
+/* GStreamer VP9 parser
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vp9parse
+ * @title: vp9parse
+ *
+ * Parses VP9 streams coming from a demuxer, flags keyframes, fills in the
+ * resolution, profile and bit depth in the caps and optionally splits
+ * superframes into their frames. Only the beginning of the uncompressed
+ * header of each frame is looked at, so no decoder is needed.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=video.webm ! matroskademux ! vp9parse ! fakesink
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/base/base.h>
+#include "gstvp9parse.h"
+
+GST_DEBUG_CATEGORY (vp9_parse_debug);
+#define GST_CAT_DEFAULT vp9_parse_debug
+
+enum
+{
+  GST_VP9_PARSE_ALIGN_NONE = 0,
+  GST_VP9_PARSE_ALIGN_SUPER_FRAME,
+  GST_VP9_PARSE_ALIGN_FRAME
+};
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9, parsed = (boolean) true, "
+        "alignment = (string) { super-frame, frame }"));
+
+#define parent_class gst_vp9_parse_parent_class
+G_DEFINE_TYPE (GstVp9Parse, gst_vp9_parse, GST_TYPE_BASE_PARSE);
+
+static gboolean gst_vp9_parse_start (GstBaseParse * parse);
+static gboolean gst_vp9_parse_stop (GstBaseParse * parse);
+static GstFlowReturn gst_vp9_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize);
+static gboolean gst_vp9_parse_set_caps (GstBaseParse * parse, GstCaps * caps);
+static GstCaps *gst_vp9_parse_get_caps (GstBaseParse * parse,
+    GstCaps * filter);
+
+static void
+gst_vp9_parse_class_init (GstVp9ParseClass * klass)
+{
+  GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (vp9_parse_debug, "vp9parse", 0, "vp9 parser");
+
+  /* Override BaseParse vfuncs */
+  parse_class->start = GST_DEBUG_FUNCPTR (gst_vp9_parse_start);
+  parse_class->stop = GST_DEBUG_FUNCPTR (gst_vp9_parse_stop);
+  parse_class->handle_frame = GST_DEBUG_FUNCPTR (gst_vp9_parse_handle_frame);
+  parse_class->set_sink_caps = GST_DEBUG_FUNCPTR (gst_vp9_parse_set_caps);
+  parse_class->get_sink_caps = GST_DEBUG_FUNCPTR (gst_vp9_parse_get_caps);
+
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+
+  gst_element_class_set_static_metadata (gstelement_class, "VP9 parser",
+      "Codec/Parser/Converter/Video",
+      "Parses VP9 streams", "GStreamer maintainers "
+      "<gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_vp9_parse_init (GstVp9Parse * vp9parse)
+{
+  gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (vp9parse), FALSE);
+  GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (vp9parse));
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (vp9parse));
+}
+
+static void
+gst_vp9_parse_reset (GstVp9Parse * vp9parse)
+{
+  vp9parse->width = 0;
+  vp9parse->height = 0;
+  vp9parse->profile = GST_VP9_PROFILE_UNDEFINED;
+  vp9parse->bit_depth = 0;
+  vp9parse->subsampling_x = -1;
+  vp9parse->subsampling_y = -1;
+  vp9parse->upstream_fps_num = 0;
+  vp9parse->upstream_fps_den = 0;
+  vp9parse->update_caps = TRUE;
+
+  vp9parse->in_align = GST_VP9_PARSE_ALIGN_NONE;
+  vp9parse->align = GST_VP9_PARSE_ALIGN_NONE;
+}
+
+static gboolean
+gst_vp9_parse_start (GstBaseParse * parse)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (parse, "start");
+  gst_vp9_parse_reset (vp9parse);
+
+  vp9parse->parser = gst_vp9_parser_new ();
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp9_parse_stop (GstBaseParse * parse)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (parse, "stop");
+  gst_vp9_parse_reset (vp9parse);
+
+  gst_vp9_parser_free (vp9parse->parser);
+  vp9parse->parser = NULL;
+
+  return TRUE;
+}
+
+static const gchar *
+gst_vp9_parse_get_string (GstVp9Parse * parse, guint align)
+{
+  switch (align) {
+    case GST_VP9_PARSE_ALIGN_SUPER_FRAME:
+      return "super-frame";
+    case GST_VP9_PARSE_ALIGN_FRAME:
+      return "frame";
+    default:
+      return "none";
+  }
+}
+
+static void
+gst_vp9_parse_align_from_caps (GstCaps * caps, guint * align)
+{
+  g_return_if_fail (gst_caps_is_fixed (caps));
+
+  GST_DEBUG ("parsing caps: %" GST_PTR_FORMAT, caps);
+
+  *align = GST_VP9_PARSE_ALIGN_NONE;
+
+  if (caps && gst_caps_get_size (caps) > 0) {
+    GstStructure *s = gst_caps_get_structure (caps, 0);
+    const gchar *str = NULL;
+
+    if ((str = gst_structure_get_string (s, "alignment"))) {
+      if (strcmp (str, "super-frame") == 0)
+        *align = GST_VP9_PARSE_ALIGN_SUPER_FRAME;
+      else if (strcmp (str, "frame") == 0)
+        *align = GST_VP9_PARSE_ALIGN_FRAME;
+    }
+  }
+}
+
+/* check downstream caps to configure alignment */
+static void
+gst_vp9_parse_negotiate (GstVp9Parse * vp9parse, GstCaps * in_caps)
+{
+  GstCaps *caps;
+  guint align = GST_VP9_PARSE_ALIGN_NONE;
+
+  g_return_if_fail ((in_caps == NULL) || gst_caps_is_fixed (in_caps));
+
+  caps = gst_pad_get_allowed_caps (GST_BASE_PARSE_SRC_PAD (vp9parse));
+  GST_DEBUG_OBJECT (vp9parse, "allowed caps: %" GST_PTR_FORMAT, caps);
+
+  /* concentrate on leading structure, since decodebin parser
+   * capsfilter always includes parser template caps */
+  if (caps) {
+    caps = gst_caps_truncate (caps);
+    GST_DEBUG_OBJECT (vp9parse, "negotiating with caps: %" GST_PTR_FORMAT,
+        caps);
+  }
+
+  if (in_caps && caps) {
+    if (gst_caps_can_intersect (in_caps, caps)) {
+      GST_DEBUG_OBJECT (vp9parse, "downstream accepts upstream caps");
+      gst_vp9_parse_align_from_caps (in_caps, &align);
+      gst_caps_unref (caps);
+      caps = NULL;
+    }
+  }
+
+  if (caps && !gst_caps_is_empty (caps)) {
+    /* fixate to avoid ambiguity with lists when parsing */
+    caps = gst_caps_fixate (caps);
+    gst_vp9_parse_align_from_caps (caps, &align);
+  }
+
+  /* default */
+  if (!align)
+    align = GST_VP9_PARSE_ALIGN_SUPER_FRAME;
+
+  /* frames are not merged back into superframes */
+  if (vp9parse->in_align == GST_VP9_PARSE_ALIGN_FRAME
+      && align == GST_VP9_PARSE_ALIGN_SUPER_FRAME) {
+    GST_WARNING_OBJECT (vp9parse, "can't convert frames to superframes");
+    align = GST_VP9_PARSE_ALIGN_FRAME;
+  }
+
+  GST_DEBUG_OBJECT (vp9parse, "selected alignment %s",
+      gst_vp9_parse_get_string (vp9parse, align));
+
+  vp9parse->align = align;
+
+  if (caps)
+    gst_caps_unref (caps);
+}
+
+/* parses the frame of @size bytes at @data, returns TRUE if it is a key
+ * frame, sets @shown if it is displayed */
+static gboolean
+gst_vp9_parse_process_frame (GstVp9Parse * vp9parse, const guint8 * data,
+    gsize size, gboolean * shown)
+{
+  GstVp9Parser *parser = vp9parse->parser;
+  GstVp9FrameHdr frame_hdr;
+
+  *shown = TRUE;
+
+  if (gst_vp9_parser_parse_frame_header_fast (parser, &frame_hdr, data,
+          size) != GST_VP9_PARSER_OK) {
+    GST_WARNING_OBJECT (vp9parse, "failed to parse frame header");
+    return FALSE;
+  }
+
+  if (frame_hdr.show_existing_frame)
+    return FALSE;
+
+  *shown = frame_hdr.show_frame;
+
+  if (frame_hdr.frame_type == GST_VP9_KEY_FRAME || frame_hdr.intra_only) {
+    if (vp9parse->profile != frame_hdr.profile
+        || vp9parse->bit_depth != parser->bit_depth
+        || vp9parse->subsampling_x != parser->subsampling_x
+        || vp9parse->subsampling_y != parser->subsampling_y) {
+      GST_INFO_OBJECT (vp9parse, "profile %u, bit depth %u, subsampling "
+          "%d:%d", frame_hdr.profile, parser->bit_depth,
+          parser->subsampling_x, parser->subsampling_y);
+      vp9parse->profile = frame_hdr.profile;
+      vp9parse->bit_depth = parser->bit_depth;
+      vp9parse->subsampling_x = parser->subsampling_x;
+      vp9parse->subsampling_y = parser->subsampling_y;
+      vp9parse->update_caps = TRUE;
+    }
+  }
+
+  if (frame_hdr.show_frame && (vp9parse->width != frame_hdr.width
+          || vp9parse->height != frame_hdr.height)) {
+    GST_INFO_OBJECT (vp9parse, "resolution changed %ux%u", frame_hdr.width,
+        frame_hdr.height);
+    vp9parse->width = frame_hdr.width;
+    vp9parse->height = frame_hdr.height;
+    vp9parse->update_caps = TRUE;
+  }
+
+  return frame_hdr.frame_type == GST_VP9_KEY_FRAME;
+}
+
+static void
+gst_vp9_parse_update_src_caps (GstVp9Parse * vp9parse)
+{
+  GstCaps *caps, *sink_caps, *src_caps;
+
+  if (!vp9parse->update_caps
+      && gst_pad_has_current_caps (GST_BASE_PARSE_SRC_PAD (vp9parse)))
+    return;
+  vp9parse->update_caps = FALSE;
+
+  sink_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SINK_PAD (vp9parse));
+  if (sink_caps) {
+    caps = gst_caps_copy (sink_caps);
+    gst_caps_unref (sink_caps);
+  } else {
+    caps = gst_caps_new_empty_simple ("video/x-vp9");
+  }
+
+  gst_caps_set_simple (caps, "parsed", G_TYPE_BOOLEAN, TRUE,
+      "alignment", G_TYPE_STRING,
+      gst_vp9_parse_get_string (vp9parse, vp9parse->align), NULL);
+
+  if (vp9parse->width > 0 && vp9parse->height > 0)
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, vp9parse->width,
+        "height", G_TYPE_INT, vp9parse->height, NULL);
+
+  if (vp9parse->profile < GST_VP9_PROFILE_UNDEFINED) {
+    static const gchar *profiles[] = { "0", "1", "2", "3" };
+    const gchar *chroma_format;
+
+    if (vp9parse->subsampling_x && vp9parse->subsampling_y)
+      chroma_format = "4:2:0";
+    else if (vp9parse->subsampling_x)
+      chroma_format = "4:2:2";
+    else if (vp9parse->subsampling_y)
+      chroma_format = "4:4:0";
+    else
+      chroma_format = "4:4:4";
+
+    gst_caps_set_simple (caps, "profile", G_TYPE_STRING,
+        profiles[vp9parse->profile], "chroma-format", G_TYPE_STRING,
+        chroma_format, "bit-depth-luma", G_TYPE_UINT, vp9parse->bit_depth,
+        "bit-depth-chroma", G_TYPE_UINT, vp9parse->bit_depth, NULL);
+  }
+
+  if (vp9parse->upstream_fps_num > 0 && vp9parse->upstream_fps_den > 0)
+    gst_base_parse_set_frame_rate (GST_BASE_PARSE (vp9parse),
+        vp9parse->upstream_fps_num, vp9parse->upstream_fps_den, 0, 0);
+
+  src_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SRC_PAD (vp9parse));
+  if (!src_caps || !gst_caps_is_strictly_equal (src_caps, caps)) {
+    GST_DEBUG_OBJECT (vp9parse, "setting caps %" GST_PTR_FORMAT, caps);
+    gst_pad_set_caps (GST_BASE_PARSE_SRC_PAD (vp9parse), caps);
+  }
+
+  if (src_caps)
+    gst_caps_unref (src_caps);
+  gst_caps_unref (caps);
+}
+
+static GstFlowReturn
+gst_vp9_parse_finish_frame (GstVp9Parse * vp9parse, GstBaseParseFrame * frame,
+    gint size, gboolean keyframe, gboolean shown)
+{
+  GstBuffer *buffer;
+
+  gst_vp9_parse_update_src_caps (vp9parse);
+
+  buffer = frame->buffer;
+
+  if (keyframe)
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  if (shown)
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DECODE_ONLY);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DECODE_ONLY);
+
+  return gst_base_parse_finish_frame (GST_BASE_PARSE (vp9parse), frame, size);
+}
+
+/* input buffers are complete superframes, as demuxers output them */
+static GstFlowReturn
+gst_vp9_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
+    gint * skipsize)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+  GstBuffer *buffer = frame->buffer;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstVp9SuperframeInfo info;
+  GstMapInfo map;
+  gboolean keyframe = FALSE, shown = FALSE, frame_shown;
+  guint i, offset = 0;
+
+  if (G_UNLIKELY (vp9parse->align == GST_VP9_PARSE_ALIGN_NONE))
+    gst_vp9_parse_negotiate (vp9parse, NULL);
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+
+  if (gst_vp9_parser_parse_superframe_info (vp9parse->parser, &info,
+          map.data, map.size) != GST_VP9_PARSER_OK) {
+    GST_WARNING_OBJECT (vp9parse, "invalid superframe index");
+    gst_buffer_unmap (buffer, &map);
+    return gst_vp9_parse_finish_frame (vp9parse, frame, map.size, FALSE,
+        TRUE);
+  }
+
+  if (vp9parse->align == GST_VP9_PARSE_ALIGN_SUPER_FRAME
+      || info.frames_in_superframe == 1) {
+    for (i = 0; i < info.frames_in_superframe; i++) {
+      if (gst_vp9_parse_process_frame (vp9parse, map.data + offset,
+              info.frame_sizes[i], &frame_shown) && i == 0)
+        keyframe = TRUE;
+      shown |= frame_shown;
+      offset += info.frame_sizes[i];
+    }
+    gst_buffer_unmap (buffer, &map);
+
+    return gst_vp9_parse_finish_frame (vp9parse, frame, map.size, keyframe,
+        shown);
+  }
+
+  /* need to save buffer from invalidation upon _finish_frame */
+  buffer = gst_buffer_ref (buffer);
+
+  for (i = 0; i < info.frames_in_superframe && ret == GST_FLOW_OK; i++) {
+    GstBaseParseFrame tmp_frame;
+    guint size = info.frame_sizes[i];
+
+    keyframe = gst_vp9_parse_process_frame (vp9parse, map.data + offset,
+        size, &frame_shown);
+
+    gst_base_parse_frame_init (&tmp_frame);
+    tmp_frame.flags |= frame->flags;
+    tmp_frame.offset = frame->offset;
+    tmp_frame.overhead = frame->overhead;
+    tmp_frame.buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
+        offset, size);
+    offset += size;
+
+    /* the superframe index is consumed along with the last frame */
+    if (i == info.frames_in_superframe - 1)
+      size += info.superframe_index_size;
+
+    ret = gst_vp9_parse_finish_frame (vp9parse, &tmp_frame, size, keyframe,
+        frame_shown);
+  }
+
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  return ret;
+}
+
+static gboolean
+gst_vp9_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+  GstStructure *str;
+  GstCaps *in_caps;
+  guint align;
+
+  str = gst_caps_get_structure (caps, 0);
+
+  /* accept upstream info if provided */
+  gst_structure_get_fraction (str, "framerate", &vp9parse->upstream_fps_num,
+      &vp9parse->upstream_fps_den);
+
+  /* demuxers give us one superframe per buffer */
+  gst_vp9_parse_align_from_caps (caps, &align);
+  if (align == GST_VP9_PARSE_ALIGN_NONE)
+    align = GST_VP9_PARSE_ALIGN_SUPER_FRAME;
+  vp9parse->in_align = align;
+
+  /* prefer input type determined above */
+  in_caps = gst_caps_new_simple ("video/x-vp9",
+      "parsed", G_TYPE_BOOLEAN, TRUE,
+      "alignment", G_TYPE_STRING,
+      gst_vp9_parse_get_string (vp9parse, align), NULL);
+  /* negotiate with downstream, sets ->align */
+  gst_vp9_parse_negotiate (vp9parse, in_caps);
+  gst_caps_unref (in_caps);
+
+  vp9parse->update_caps = TRUE;
+
+  return TRUE;
+}
+
+static void
+remove_fields (GstCaps * caps)
+{
+  guint i, n;
+
+  n = gst_caps_get_size (caps);
+  for (i = 0; i < n; i++) {
+    GstStructure *s = gst_caps_get_structure (caps, i);
+
+    gst_structure_remove_field (s, "alignment");
+    gst_structure_remove_field (s, "parsed");
+  }
+}
+
+static GstCaps *
+gst_vp9_parse_get_caps (GstBaseParse * parse, GstCaps * filter)
+{
+  GstCaps *peercaps, *templ;
+  GstCaps *res;
+
+  templ = gst_pad_get_pad_template_caps (GST_BASE_PARSE_SINK_PAD (parse));
+  if (filter) {
+    GstCaps *fcopy = gst_caps_copy (filter);
+    /* Remove the fields we convert */
+    remove_fields (fcopy);
+    peercaps = gst_pad_peer_query_caps (GST_BASE_PARSE_SRC_PAD (parse), fcopy);
+    gst_caps_unref (fcopy);
+  } else
+    peercaps = gst_pad_peer_query_caps (GST_BASE_PARSE_SRC_PAD (parse), NULL);
+
+  if (peercaps) {
+    peercaps = gst_caps_make_writable (peercaps);
+    remove_fields (peercaps);
+
+    res = gst_caps_intersect_full (peercaps, templ, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (peercaps);
+    gst_caps_unref (templ);
+  } else {
+    res = templ;
+  }
+
+  if (filter) {
+    GstCaps *tmp = gst_caps_intersect_full (res, filter,
+        GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (res);
+    res = tmp;
+  }
+
+  return res;
+}
@@ -47,6 +47,7 @@ struct _GstSimpleVideoMarkDetect
   gdouble pattern_sensitivity;
   gint left_offset;
   gint bottom_offset;
+  gint sample_step;
 
   gboolean in_pattern;
 };
@@ -38,6 +38,17 @@
  *
  * * #gdouble`luma-variance`: the brightness variance of the frame.
  *
+ * * #gboolean`interpolated`: %TRUE if the frame was not analysed and the
+ *   statistics were interpolated from the analysed frames around it.
+ *
+ * The statistics can be restricted to a region of the frame with the roi-x,
+ * roi-y, roi-width and roi-height properties, and computed on a sparse grid
+ * of one pixel out of #GstVideoAnalyse:sample-step in each direction. If
+ * #GstVideoAnalyse:interval is bigger than one, only one frame out of
+ * interval is analysed. The messages of the frames in between are then
+ * posted when the next frame has been analysed, with the statistics
+ * linearly interpolated between the two analysed frames.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -m videotestsrc ! videoanalyse ! videoconvert ! ximagesink
@@ -53,6 +64,7 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include "gstvideoanalyse.h"
+#include "gstvideosignalstats.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_video_analyse_debug_category);
 #define GST_CAT_DEFAULT gst_video_analyse_debug_category
@@ -65,6 +77,7 @@ static void gst_video_analyse_set_property (GObject * object,
 static void gst_video_analyse_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
 static void gst_video_analyse_finalize (GObject * object);
+static gboolean gst_video_analyse_start (GstBaseTransform * trans);
 
 static GstFlowReturn gst_video_analyse_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
@@ -72,10 +85,22 @@ static GstFlowReturn gst_video_analyse_transform_frame_ip (GstVideoFilter *
 enum
 {
   PROP_0,
-  PROP_MESSAGE
+  PROP_MESSAGE,
+  PROP_ROI_X,
+  PROP_ROI_Y,
+  PROP_ROI_WIDTH,
+  PROP_ROI_HEIGHT,
+  PROP_SAMPLE_STEP,
+  PROP_INTERVAL
 };
 
 #define DEFAULT_MESSAGE TRUE
+#define DEFAULT_ROI_X 0
+#define DEFAULT_ROI_Y 0
+#define DEFAULT_ROI_WIDTH 0
+#define DEFAULT_ROI_HEIGHT 0
+#define DEFAULT_SAMPLE_STEP 1
+#define DEFAULT_INTERVAL 1
 
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, YV12, Y444, Y42B, Y41B }")
@@ -92,6 +117,8 @@ static void
 gst_video_analyse_class_init (GstVideoAnalyseClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
@@ -108,6 +135,7 @@ gst_video_analyse_class_init (GstVideoAnalyseClass * klass)
   gobject_class->set_property = gst_video_analyse_set_property;
   gobject_class->get_property = gst_video_analyse_get_property;
   gobject_class->finalize = gst_video_analyse_finalize;
+  base_transform_class->start = GST_DEBUG_FUNCPTR (gst_video_analyse_start);
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_video_analyse_transform_frame_ip);
 
@@ -116,12 +144,47 @@ gst_video_analyse_class_init (GstVideoAnalyseClass * klass)
           "Post statics messages",
           DEFAULT_MESSAGE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_ROI_X,
+      g_param_spec_uint ("roi-x", "ROI x",
+          "Left edge of the analysed region", 0, G_MAXINT, DEFAULT_ROI_X,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_ROI_Y,
+      g_param_spec_uint ("roi-y", "ROI y",
+          "Top edge of the analysed region", 0, G_MAXINT, DEFAULT_ROI_Y,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_ROI_WIDTH,
+      g_param_spec_uint ("roi-width", "ROI width",
+          "Width of the analysed region (0 = up to the right edge)", 0,
+          G_MAXINT, DEFAULT_ROI_WIDTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_ROI_HEIGHT,
+      g_param_spec_uint ("roi-height", "ROI height",
+          "Height of the analysed region (0 = up to the bottom edge)", 0,
+          G_MAXINT, DEFAULT_ROI_HEIGHT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SAMPLE_STEP,
+      g_param_spec_uint ("sample-step", "Sample step",
+          "Only analyse one pixel out of this many in each direction", 1, 64,
+          DEFAULT_SAMPLE_STEP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_INTERVAL,
+      g_param_spec_uint ("interval", "Interval",
+          "Only analyse one frame out of this many, the statistics of the "
+          "others are interpolated", 1, G_MAXINT, DEFAULT_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   //trans_class->passthrough_on_same_caps = TRUE;
 }
 
 static void
 gst_video_analyse_init (GstVideoAnalyse * videoanalyse)
 {
+  videoanalyse->roi_x = DEFAULT_ROI_X;
+  videoanalyse->roi_y = DEFAULT_ROI_Y;
+  videoanalyse->roi_width = DEFAULT_ROI_WIDTH;
+  videoanalyse->roi_height = DEFAULT_ROI_HEIGHT;
+  videoanalyse->sample_step = DEFAULT_SAMPLE_STEP;
+  videoanalyse->interval = DEFAULT_INTERVAL;
+  videoanalyse->pending =
+      g_array_new (FALSE, FALSE, sizeof (GstVideoAnalyseTiming));
 }
 
 void
@@ -136,6 +199,36 @@ gst_video_analyse_set_property (GObject * object, guint property_id,
     case PROP_MESSAGE:
       videoanalyse->message = g_value_get_boolean (value);
       break;
+    case PROP_ROI_X:
+      GST_OBJECT_LOCK (videoanalyse);
+      videoanalyse->roi_x = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_ROI_Y:
+      GST_OBJECT_LOCK (videoanalyse);
+      videoanalyse->roi_y = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_ROI_WIDTH:
+      GST_OBJECT_LOCK (videoanalyse);
+      videoanalyse->roi_width = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_ROI_HEIGHT:
+      GST_OBJECT_LOCK (videoanalyse);
+      videoanalyse->roi_height = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_SAMPLE_STEP:
+      GST_OBJECT_LOCK (videoanalyse);
+      videoanalyse->sample_step = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_INTERVAL:
+      GST_OBJECT_LOCK (videoanalyse);
+      videoanalyse->interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -154,6 +247,36 @@ gst_video_analyse_get_property (GObject * object, guint property_id,
     case PROP_MESSAGE:
       g_value_set_boolean (value, videoanalyse->message);
       break;
+    case PROP_ROI_X:
+      GST_OBJECT_LOCK (videoanalyse);
+      g_value_set_uint (value, videoanalyse->roi_x);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_ROI_Y:
+      GST_OBJECT_LOCK (videoanalyse);
+      g_value_set_uint (value, videoanalyse->roi_y);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_ROI_WIDTH:
+      GST_OBJECT_LOCK (videoanalyse);
+      g_value_set_uint (value, videoanalyse->roi_width);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_ROI_HEIGHT:
+      GST_OBJECT_LOCK (videoanalyse);
+      g_value_set_uint (value, videoanalyse->roi_height);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_SAMPLE_STEP:
+      GST_OBJECT_LOCK (videoanalyse);
+      g_value_set_uint (value, videoanalyse->sample_step);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
+    case PROP_INTERVAL:
+      GST_OBJECT_LOCK (videoanalyse);
+      g_value_set_uint (value, videoanalyse->interval);
+      GST_OBJECT_UNLOCK (videoanalyse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -168,76 +291,124 @@ gst_video_analyse_finalize (GObject * object)
   GST_DEBUG_OBJECT (videoanalyse, "finalize");
 
   /* clean up object here */
+  g_array_free (videoanalyse->pending, TRUE);
 
   G_OBJECT_CLASS (gst_video_analyse_parent_class)->finalize (object);
 }
 
+static gboolean
+gst_video_analyse_start (GstBaseTransform * trans)
+{
+  GstVideoAnalyse *videoanalyse = GST_VIDEO_ANALYSE (trans);
+
+  videoanalyse->frame_count = 0;
+  videoanalyse->have_previous = FALSE;
+  g_array_set_size (videoanalyse->pending, 0);
+
+  return TRUE;
+}
+
+static void
+gst_video_analyse_get_timing (GstVideoAnalyse * videoanalyse,
+    GstBuffer * buffer, GstVideoAnalyseTiming * timing)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (videoanalyse);
+
+  timing->timestamp = GST_BUFFER_TIMESTAMP (buffer);
+  timing->duration = GST_BUFFER_DURATION (buffer);
+  timing->running_time = gst_segment_to_running_time (&trans->segment,
+      GST_FORMAT_TIME, timing->timestamp);
+  timing->stream_time = gst_segment_to_stream_time (&trans->segment,
+      GST_FORMAT_TIME, timing->timestamp);
+}
+
 static void
 gst_video_analyse_post_message (GstVideoAnalyse * videoanalyse,
-    GstVideoFrame * frame)
+    const GstVideoAnalyseTiming * timing, gdouble luma_average,
+    gdouble luma_variance, gboolean interpolated)
 {
-  GstBaseTransform *trans;
   GstMessage *m;
-  guint64 duration, timestamp, running_time, stream_time;
-
-  trans = GST_BASE_TRANSFORM_CAST (videoanalyse);
-
-  /* get timestamps */
-  timestamp = GST_BUFFER_TIMESTAMP (frame->buffer);
-  duration = GST_BUFFER_DURATION (frame->buffer);
-  running_time = gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
-      timestamp);
-  stream_time = gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME,
-      timestamp);
 
   m = gst_message_new_element (GST_OBJECT_CAST (videoanalyse),
       gst_structure_new ("GstVideoAnalyse",
-          "timestamp", G_TYPE_UINT64, timestamp,
-          "stream-time", G_TYPE_UINT64, stream_time,
-          "running-time", G_TYPE_UINT64, running_time,
-          "duration", G_TYPE_UINT64, duration,
-          "luma-average", G_TYPE_DOUBLE, videoanalyse->luma_average,
-          "luma-variance", G_TYPE_DOUBLE, videoanalyse->luma_variance, NULL));
+          "timestamp", G_TYPE_UINT64, timing->timestamp,
+          "stream-time", G_TYPE_UINT64, timing->stream_time,
+          "running-time", G_TYPE_UINT64, timing->running_time,
+          "duration", G_TYPE_UINT64, timing->duration,
+          "luma-average", G_TYPE_DOUBLE, luma_average,
+          "luma-variance", G_TYPE_DOUBLE, luma_variance,
+          "interpolated", G_TYPE_BOOLEAN, interpolated, NULL));
 
   gst_element_post_message (GST_ELEMENT_CAST (videoanalyse), m);
 }
 
+/* posts the messages of the frames skipped since the previous analysed
+ * frame, interpolating between it and the current one */
+static void
+gst_video_analyse_post_pending (GstVideoAnalyse * videoanalyse)
+{
+  guint n = videoanalyse->pending->len;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    GstVideoAnalyseTiming *timing =
+        &g_array_index (videoanalyse->pending, GstVideoAnalyseTiming, i);
+    gdouble pos = (i + 1.0) / (n + 1.0);
+    gdouble average = videoanalyse->luma_average;
+    gdouble variance = videoanalyse->luma_variance;
+
+    if (videoanalyse->have_previous) {
+      average = videoanalyse->previous_average +
+          pos * (average - videoanalyse->previous_average);
+      variance = videoanalyse->previous_variance +
+          pos * (variance - videoanalyse->previous_variance);
+    }
+
+    gst_video_analyse_post_message (videoanalyse, timing, average, variance,
+        TRUE);
+  }
+
+  g_array_set_size (videoanalyse->pending, 0);
+}
+
+/* one pass over the samples of the region, the variance is still computed
+ * around the truncated average like it always was */
 static void
-gst_video_analyse_planar (GstVideoAnalyse * videoanalyse, GstVideoFrame * frame)
+gst_video_analyse_planar (GstVideoAnalyse * videoanalyse, GstVideoFrame * frame,
+    guint roi_x, guint roi_y, guint roi_width, guint roi_height, guint step)
 {
-  guint64 sum;
-  gint avg, diff;
-  gint i, j;
+  guint64 sum = 0, sum_sq = 0, n = 0;
+  guint64 avg;
   guint8 *d;
   gint width = frame->info.width;
   gint height = frame->info.height;
-  gint stride;
-
-  d = frame->data[0];
-  stride = frame->info.stride[0];
-  sum = 0;
-  /* do brightness as average of pixel brightness in 0.0 to 1.0 */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      sum += d[j];
-    }
-    d += stride;
+  gint stride = frame->info.stride[0];
+  gint x, y, w, h, i;
+
+  x = MIN (roi_x, (guint) width);
+  y = MIN (roi_y, (guint) height);
+  w = roi_width ? MIN (roi_width, (guint) (width - x)) : width - x;
+  h = roi_height ? MIN (roi_height, (guint) (height - y)) : height - y;
+
+  if (w == 0 || h == 0) {
+    videoanalyse->luma_average = 0.0;
+    videoanalyse->luma_variance = 0.0;
+    return;
   }
-  avg = sum / (width * height);
-  videoanalyse->luma_average = sum / (255.0 * width * height);
-
-  d = frame->data[0];
-  stride = frame->info.stride[0];
-  sum = 0;
-  /* do variance */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      diff = (avg - d[j]);
-      sum += diff * diff;
-    }
-    d += stride;
+
+  d = (guint8 *) frame->data[0] + y * stride + x;
+  for (i = 0; i < h; i += step) {
+    n += video_signal_line_stats (d, w, 1, step, &sum, &sum_sq);
+    d += stride * step;
   }
-  videoanalyse->luma_variance = sum / (255.0 * 255.0 * width * height);
+
+  /* do brightness as average of pixel brightness in 0.0 to 1.0 */
+  avg = sum / n;
+  videoanalyse->luma_average = sum / (255.0 * n);
+
+  /* do variance, as the sum of (avg - d)^2 */
+  videoanalyse->luma_variance =
+      (sum_sq + n * avg * avg - 2 * avg * sum) / (255.0 * 255.0 * n);
 }
 
 static GstFlowReturn
@@ -245,13 +416,45 @@ gst_video_analyse_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
 {
   GstVideoAnalyse *videoanalyse = GST_VIDEO_ANALYSE (filter);
+  GstVideoAnalyseTiming timing;
+  guint roi_x, roi_y, roi_width, roi_height, step, interval;
 
   GST_DEBUG_OBJECT (videoanalyse, "transform_frame_ip");
 
-  gst_video_analyse_planar (videoanalyse, frame);
+  GST_OBJECT_LOCK (videoanalyse);
+  roi_x = videoanalyse->roi_x;
+  roi_y = videoanalyse->roi_y;
+  roi_width = videoanalyse->roi_width;
+  roi_height = videoanalyse->roi_height;
+  step = videoanalyse->sample_step;
+  interval = videoanalyse->interval;
+  GST_OBJECT_UNLOCK (videoanalyse);
 
   if (videoanalyse->message)
-    gst_video_analyse_post_message (videoanalyse, frame);
+    gst_video_analyse_get_timing (videoanalyse, frame->buffer, &timing);
+
+  if (videoanalyse->frame_count++ % interval != 0) {
+    /* posted once the next analysed frame gives the end of the
+     * interpolation */
+    if (videoanalyse->message)
+      g_array_append_val (videoanalyse->pending, timing);
+    return GST_FLOW_OK;
+  }
+
+  gst_video_analyse_planar (videoanalyse, frame, roi_x, roi_y, roi_width,
+      roi_height, step);
+
+  if (videoanalyse->message) {
+    gst_video_analyse_post_pending (videoanalyse);
+    gst_video_analyse_post_message (videoanalyse, &timing,
+        videoanalyse->luma_average, videoanalyse->luma_variance, FALSE);
+  } else {
+    g_array_set_size (videoanalyse->pending, 0);
+  }
+
+  videoanalyse->have_previous = TRUE;
+  videoanalyse->previous_average = videoanalyse->luma_average;
+  videoanalyse->previous_variance = videoanalyse->luma_variance;
 
   return GST_FLOW_OK;
 }
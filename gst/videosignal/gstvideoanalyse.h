@@ -34,15 +34,35 @@ G_BEGIN_DECLS
 typedef struct _GstVideoAnalyse GstVideoAnalyse;
 typedef struct _GstVideoAnalyseClass GstVideoAnalyseClass;
 
+/* times of a frame, as posted in its message */
+typedef struct
+{
+  GstClockTime timestamp;
+  GstClockTime stream_time;
+  GstClockTime running_time;
+  GstClockTime duration;
+} GstVideoAnalyseTiming;
+
 struct _GstVideoAnalyse
 {
   GstVideoFilter base_videoanalyse;
 
   /* properties */
   gboolean message;
-  guint64 interval;
+  guint roi_x, roi_y;
+  guint roi_width, roi_height;
+  guint sample_step;
+  guint interval;
   gdouble luma_average;
   gdouble luma_variance;
+
+  /* frames since start, the statistics of the last analysed frame and the
+   * frames skipped since then, whose messages are not posted yet */
+  guint64 frame_count;
+  gboolean have_previous;
+  gdouble previous_average;
+  gdouble previous_variance;
+  GArray *pending;
 };
 
 struct _GstVideoAnalyseClass
@@ -0,0 +1,102 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvideosignalstats.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* pixels per block of the vector loops, the 32 bit sums of squares of a
+ * block can't overflow */
+#define BLOCK_SIZE 4096
+
+/* adds the samples of one in @step of the @width pixels at @data, and their
+ * squares, to @sum and @sum_sq. Returns the number of samples. Contiguous
+ * samples use SSE2 or NEON. */
+guint
+video_signal_line_stats (const guint8 * data, gint width, gint pixel_stride,
+    gint step, guint64 * sum, guint64 * sum_sq)
+{
+  guint64 s = 0, sq = 0;
+  gint i = 0;
+
+  if (pixel_stride * step == 1) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128 ();
+
+    while (i + 16 <= width) {
+      gint end = MIN (width, i + BLOCK_SIZE);
+      __m128i vs = _mm_setzero_si128 ();
+      __m128i vsq = _mm_setzero_si128 ();
+      guint32 lanes[4];
+
+      for (; i + 16 <= end; i += 16) {
+        __m128i v = _mm_loadu_si128 ((const __m128i *) (data + i));
+        __m128i lo = _mm_unpacklo_epi8 (v, zero);
+        __m128i hi = _mm_unpackhi_epi8 (v, zero);
+
+        vs = _mm_add_epi64 (vs, _mm_sad_epu8 (v, zero));
+        vsq = _mm_add_epi32 (vsq, _mm_add_epi32 (_mm_madd_epi16 (lo, lo),
+                _mm_madd_epi16 (hi, hi)));
+      }
+      s += _mm_cvtsi128_si32 (vs) +
+          _mm_cvtsi128_si32 (_mm_unpackhi_epi64 (vs, vs));
+      _mm_storeu_si128 ((__m128i *) lanes, vsq);
+      sq += (guint64) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    while (i + 16 <= width) {
+      gint end = MIN (width, i + BLOCK_SIZE);
+      uint32x4_t vs = vdupq_n_u32 (0);
+      uint32x4_t vsq = vdupq_n_u32 (0);
+
+      for (; i + 16 <= end; i += 16) {
+        uint8x16_t v = vld1q_u8 (data + i);
+        uint16x8_t lo = vmull_u8 (vget_low_u8 (v), vget_low_u8 (v));
+        uint16x8_t hi = vmull_u8 (vget_high_u8 (v), vget_high_u8 (v));
+
+        vs = vpadalq_u16 (vs, vpaddlq_u8 (v));
+        vsq = vpadalq_u16 (vpadalq_u16 (vsq, lo), hi);
+      }
+      s += (guint64) vgetq_lane_u32 (vs, 0) + vgetq_lane_u32 (vs, 1) +
+          vgetq_lane_u32 (vs, 2) + vgetq_lane_u32 (vs, 3);
+      sq += (guint64) vgetq_lane_u32 (vsq, 0) + vgetq_lane_u32 (vsq, 1) +
+          vgetq_lane_u32 (vsq, 2) + vgetq_lane_u32 (vsq, 3);
+    }
+#endif
+  }
+
+  for (; i < width; i += step) {
+    guint v = data[i * pixel_stride];
+
+    s += v;
+    sq += v * v;
+  }
+
+  *sum += s;
+  *sum_sq += sq;
+
+  return (width + step - 1) / step;
+}
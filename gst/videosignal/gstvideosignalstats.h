@@ -0,0 +1,31 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_VIDEO_SIGNAL_STATS_H_
+#define _GST_VIDEO_SIGNAL_STATS_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+guint video_signal_line_stats (const guint8 * data, gint width,
+    gint pixel_stride, gint step, guint64 * sum, guint64 * sum_sq);
+
+G_END_DECLS
+
+#endif
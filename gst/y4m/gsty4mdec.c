@@ -666,7 +666,10 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
     gst_adapter_flush (y4mdec->adapter, len + 1);
 
-    buffer = gst_adapter_take_buffer (y4mdec->adapter, y4mdec->info.size);
+    /* a frame straddling upstream buffers keeps their memories instead of
+     * being merged here; a sink writing it out never needs them merged, and
+     * the planes are only copied by whoever maps them across a boundary */
+    buffer = gst_adapter_take_buffer_fast (y4mdec->adapter, y4mdec->info.size);
 
     GST_BUFFER_TIMESTAMP (buffer) =
         gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
@@ -700,7 +703,7 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
       gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
 
-      for (i = 0; i < 3; i++) {
+      for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&iframe); i++) {
         w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
         h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
         istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
@@ -708,6 +711,13 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
         dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
 
+        /* usually only the chroma planes need padding, copy the others in
+         * one go */
+        if (istride == ostride && h > 0) {
+          memcpy (dest, src, (h - 1) * istride + w);
+          continue;
+        }
+
         for (j = 0; j < h; j++) {
           memcpy (dest, src, w);
 
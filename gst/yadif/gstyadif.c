@@ -34,6 +34,9 @@
  * This pipeline creates an interlaced test pattern, and then deinterlaces
  * it using the yadif filter.
  *
+ * With #GstYadif:n-threads the frame is split in bands of rows that are
+ * filtered in parallel.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -72,10 +75,19 @@ static GstFlowReturn gst_yadif_transform (GstBaseTransform * trans,
 enum
 {
   PROP_0,
-  PROP_MODE
+  PROP_MODE,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_MODE GST_DEINTERLACE_MODE_AUTO
+#define DEFAULT_N_THREADS 1
+
+/* the 10 bit formats are filtered as native endian 16 bit samples */
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define YADIF_FORMATS "{Y42B,I420,Y444,I420_10LE,I422_10LE,Y444_10LE}"
+#else
+#define YADIF_FORMATS "{Y42B,I420,Y444,I420_10BE,I422_10BE,Y444_10BE}"
+#endif
 
 /* pad templates */
 
@@ -83,7 +95,7 @@ static GstStaticPadTemplate gst_yadif_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{Y42B,I420,Y444}")
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (YADIF_FORMATS)
         ",interlace-mode=(string){interleaved,mixed,progressive}")
     );
 
@@ -91,7 +103,7 @@ static GstStaticPadTemplate gst_yadif_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{Y42B,I420,Y444}")
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (YADIF_FORMATS)
         ",interlace-mode=(string)progressive")
     );
 
@@ -160,11 +172,27 @@ gst_yadif_class_init (GstYadifClass * klass)
           DEFAULT_MODE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstYadif:n-threads:
+   *
+   * Number of threads filtering bands of rows of each frame, 0 uses one
+   * thread per processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads to filter each frame with (0 = number of "
+          "processors)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_yadif_init (GstYadif * yadif)
 {
+  yadif->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&yadif->band_lock);
+  g_cond_init (&yadif->band_cond);
 }
 
 void
@@ -177,6 +205,11 @@ gst_yadif_set_property (GObject * object, guint property_id,
     case PROP_MODE:
       yadif->mode = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (yadif);
+      yadif->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (yadif);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -193,6 +226,11 @@ gst_yadif_get_property (GObject * object, guint property_id,
     case PROP_MODE:
       g_value_set_enum (value, yadif->mode);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (yadif);
+      g_value_set_uint (value, yadif->n_threads);
+      GST_OBJECT_UNLOCK (yadif);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -212,9 +250,10 @@ gst_yadif_dispose (GObject * object)
 void
 gst_yadif_finalize (GObject * object)
 {
-  /* GstYadif *yadif = GST_YADIF (object); */
+  GstYadif *yadif = GST_YADIF (object);
 
-  /* clean up object here */
+  g_mutex_clear (&yadif->band_lock);
+  g_cond_clear (&yadif->band_cond);
 
   G_OBJECT_CLASS (gst_yadif_parent_class)->finalize (object);
 }
@@ -287,11 +326,93 @@ gst_yadif_start (GstBaseTransform * trans)
 static gboolean
 gst_yadif_stop (GstBaseTransform * trans)
 {
+  GstYadif *yadif = GST_YADIF (trans);
+
+  if (yadif->band_pool) {
+    g_thread_pool_free (yadif->band_pool, FALSE, TRUE);
+    yadif->band_pool = NULL;
+  }
 
   return TRUE;
 }
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
+void yadif_filter_band (GstYadif * yadif, int parity, int tff, int band,
+    int n_bands);
+
+typedef struct
+{
+  GstYadif *yadif;
+  int parity, tff;
+  int band, n_bands;
+} GstYadifBand;
+
+static void
+gst_yadif_band_func (gpointer data, gpointer user_data)
+{
+  GstYadifBand *band = data;
+  GstYadif *yadif = user_data;
+
+  yadif_filter_band (yadif, band->parity, band->tff, band->band,
+      band->n_bands);
+
+  g_mutex_lock (&yadif->band_lock);
+  if (--yadif->bands_pending == 0)
+    g_cond_signal (&yadif->band_cond);
+  g_mutex_unlock (&yadif->band_lock);
+}
+
+/* Filters the frame in up to n-threads bands of rows, the first band on the
+ * streaming thread and the others on the band pool */
+static void
+gst_yadif_filter (GstYadif * yadif, int parity, int tff)
+{
+  GstYadifBand *bands;
+  guint n_threads;
+  int n_bands, i;
+
+  GST_OBJECT_LOCK (yadif);
+  n_threads = yadif->n_threads;
+  GST_OBJECT_UNLOCK (yadif);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  /* a band should have a few rows of every plane */
+  n_bands = MAX (MIN (n_threads, GST_VIDEO_INFO_HEIGHT (&yadif->video_info) /
+          16), 1);
+
+  if (n_bands == 1) {
+    yadif_filter_band (yadif, parity, tff, 0, 1);
+    return;
+  }
+
+  if (!yadif->band_pool) {
+    yadif->band_pool = g_thread_pool_new (gst_yadif_band_func, yadif,
+        n_bands - 1, FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (yadif->band_pool) < n_bands - 1) {
+    g_thread_pool_set_max_threads (yadif->band_pool, n_bands - 1, NULL);
+  }
+
+  bands = g_new (GstYadifBand, n_bands);
+  yadif->bands_pending = n_bands - 1;
+  for (i = 0; i < n_bands; i++) {
+    bands[i].yadif = yadif;
+    bands[i].parity = parity;
+    bands[i].tff = tff;
+    bands[i].band = i;
+    bands[i].n_bands = n_bands;
+    if (i > 0)
+      g_thread_pool_push (yadif->band_pool, &bands[i], NULL);
+  }
+
+  yadif_filter_band (yadif, parity, tff, 0, n_bands);
+
+  g_mutex_lock (&yadif->band_lock);
+  while (yadif->bands_pending > 0)
+    g_cond_wait (&yadif->band_cond, &yadif->band_lock);
+  g_mutex_unlock (&yadif->band_lock);
+
+  g_free (bands);
+}
 
 static GstFlowReturn
 gst_yadif_transform (GstBaseTransform * trans, GstBuffer * inbuf,
@@ -315,7 +436,7 @@ gst_yadif_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   yadif->next_frame = yadif->cur_frame;
   yadif->prev_frame = yadif->cur_frame;
 
-  yadif_filter (yadif, parity, tff);
+  gst_yadif_filter (yadif, parity, tff);
 
   gst_video_frame_unmap (&yadif->dest_frame);
   gst_video_frame_unmap (&yadif->cur_frame);
@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include <gstyadif.h>
+#include "yadif_simd.h"
 #include <string.h>
 
 #undef NDEBUG
@@ -100,64 +101,103 @@ filter_line_c (guint8 * dst,
 
 FILTER}
 
-#if 0
 static void
-filter_line_c_16bit (guint16 * dst,
-    guint16 * prev, guint16 * cur, guint16 * next,
+filter_line_c_16bit (guint8 * dst8,
+    guint8 * prev8, guint8 * cur8, guint8 * next8,
     int w, int prefs, int mrefs, int parity, int mode)
 {
   int x;
+  guint16 *dst = (guint16 *) dst8;
+  guint16 *prev = (guint16 *) prev8;
+  guint16 *cur = (guint16 *) cur8;
+  guint16 *next = (guint16 *) next8;
   guint16 *prev2 = parity ? prev : cur;
   guint16 *next2 = parity ? cur : next;
   mrefs /= 2;
   prefs /= 2;
 
 FILTER}
-#endif
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
+typedef void (*YadifLineFunc) (guint8 * dst, guint8 * prev, guint8 * cur,
+    guint8 * next, int w, int prefs, int mrefs, int parity, int mode);
+
+void yadif_filter_band (GstYadif * yadif, int parity, int tff, int band,
+    int n_bands);
 #ifdef HAVE_CPU_X86_64
 void filter_line_x86_64 (guint8 * dst,
     guint8 * prev, guint8 * cur, guint8 * next,
     int w, int prefs, int mrefs, int parity, int mode);
 #endif
 
+/* Filters the columns at the edges in C and the rest with @simd */
+static void
+filter_line_simd (YadifSimdLineFunc simd, YadifLineFunc line_c, int bpp,
+    guint8 * dst, guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  int x = MIN (w, 3);
+
+  line_c (dst, prev, cur, next, x, prefs, mrefs, parity, mode);
+  if (w > 6)
+    x = simd (dst, prev, cur, next, w, prefs, mrefs, parity, mode);
+  line_c (dst + x * bpp, prev + x * bpp, cur + x * bpp, next + x * bpp,
+      w - x, prefs, mrefs, parity, mode);
+}
+
+/* Filters the rows of band @band out of @n_bands of every component, so the
+ * bands can be processed in parallel */
 void
-yadif_filter (GstYadif * yadif, int parity, int tff)
+yadif_filter_band (GstYadif * yadif, int parity, int tff, int band,
+    int n_bands)
 {
   int y, i;
   const GstVideoInfo *vi = &yadif->video_info;
   const GstVideoFormatInfo *vfi = vi->finfo;
+  gboolean is_16bit = GST_VIDEO_FORMAT_INFO_DEPTH (vfi, 0) > 8;
+  int bpp = is_16bit ? 2 : 1;
+  YadifLineFunc line_c = is_16bit ? filter_line_c_16bit : filter_line_c;
+  YadifLineFunc line = line_c;
+  YadifSimdLineFunc simd = NULL;
+
+#ifdef HAVE_AVX2_INTRINSICS
+  if (yadif_have_avx2 ())
+    simd = is_16bit ? yadif_filter_line_16bit_avx2 : yadif_filter_line_avx2;
+#endif
+#ifdef HAVE_NEON_INTRINSICS
+  simd = is_16bit ? yadif_filter_line_16bit_neon : yadif_filter_line_neon;
+#endif
+#if HAVE_CPU_X86_64
+  if (!is_16bit)
+    line = filter_line_x86_64;
+#endif
 
   for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (vfi); i++) {
     int w = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (vfi, i, vi->width);
     int h = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (vfi, i, vi->height);
     int refs = GST_VIDEO_INFO_COMP_STRIDE (vi, i);
     int df = GST_VIDEO_INFO_COMP_PSTRIDE (vi, i);
+    int y_start = h * band / n_bands;
+    int y_end = h * (band + 1) / n_bands;
     guint8 *prev_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->prev_frame, i);
     guint8 *cur_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->cur_frame, i);
     guint8 *next_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->next_frame, i);
     guint8 *dest_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->dest_frame, i);
 
-    for (y = 0; y < h; y++) {
+    for (y = y_start; y < y_end; y++) {
       if ((y ^ parity) & 1) {
         guint8 *prev = prev_data + y * refs;
         guint8 *cur = cur_data + y * refs;
         guint8 *next = next_data + y * refs;
         guint8 *dst = dest_data + y * refs;
         int mode = ((y == 1) || (y + 2 == h)) ? 2 : yadif->mode;
-#if HAVE_CPU_X86_64
-        if (0) {
-          filter_line_c (dst, prev, cur, next, w,
-              y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-        } else {
-          filter_line_x86_64 (dst, prev, cur, next, w,
-              y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-        }
-#else
-        filter_line_c (dst, prev, cur, next, w,
-            y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-#endif
+        int prefs = y + 1 < h ? refs : -refs;
+        int mrefs = y ? -refs : refs;
+
+        if (simd)
+          filter_line_simd (simd, line_c, bpp, dst, prev, cur, next, w,
+              prefs, mrefs, parity ^ tff, mode);
+        else
+          line (dst, prev, cur, next, w, prefs, mrefs, parity ^ tff, mode);
       } else {
         guint8 *dst = dest_data + y * refs;
         guint8 *cur = cur_data + y * refs;
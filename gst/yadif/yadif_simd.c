@@ -0,0 +1,153 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* AVX2 and NEON versions of the line filter, for 8 bit and 10 bit samples.
+ * Both work on 16 bit lanes, which hold every intermediate value of the
+ * filter for up to 10 bit samples. The AVX2 functions are compiled with a
+ * target attribute and only called if the CPU supports AVX2. */
+
+#include "config.h"
+
+#include "yadif_simd.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+
+gboolean
+yadif_have_avx2 (void)
+{
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("avx2");
+}
+
+#undef MAX
+#undef MIN
+
+#define VECTOR __m256i
+#define MASK __m256i
+#define STEP 16
+#define FUNC_ATTR __attribute__ ((target ("avx2")))
+#define ADD(a,b) _mm256_add_epi16 (a, b)
+#define SUB(a,b) _mm256_sub_epi16 (a, b)
+#define ABSDIFF(a,b) _mm256_abs_epi16 (_mm256_sub_epi16 (a, b))
+#define SHR1(a) _mm256_srai_epi16 (a, 1)
+#define MAX(a,b) _mm256_max_epi16 (a, b)
+#define MIN(a,b) _mm256_min_epi16 (a, b)
+#define NEG(a) _mm256_sub_epi16 (_mm256_setzero_si256 (), a)
+#define GT(a,b) _mm256_cmpgt_epi16 (a, b)
+#define AND(a,b) _mm256_and_si256 (a, b)
+#define SELECT(m,a,b) _mm256_blendv_epi8 (b, a, m)
+#define ONE _mm256_set1_epi16 (1)
+
+#define PIXEL guint8
+#define LOAD(p) _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (p)))
+#define STORE(p,v) _mm_storeu_si128 ((__m128i *) (p), \
+    _mm_packus_epi16 (_mm256_castsi256_si128 (v), \
+        _mm256_extracti128_si256 (v, 1)))
+#define RENAME(a) a ## _avx2
+#include "yadif_simd_template.c"
+#undef PIXEL
+#undef LOAD
+#undef STORE
+#undef RENAME
+
+#define PIXEL guint16
+#define LOAD(p) _mm256_loadu_si256 ((const __m256i *) (p))
+#define STORE(p,v) _mm256_storeu_si256 ((__m256i *) (p), v)
+#define RENAME(a) a ## _16bit_avx2
+#include "yadif_simd_template.c"
+#undef PIXEL
+#undef LOAD
+#undef STORE
+#undef RENAME
+
+#undef VECTOR
+#undef MASK
+#undef STEP
+#undef FUNC_ATTR
+#undef ADD
+#undef SUB
+#undef ABSDIFF
+#undef SHR1
+#undef MAX
+#undef MIN
+#undef NEG
+#undef GT
+#undef AND
+#undef SELECT
+#undef ONE
+#endif /* HAVE_AVX2_INTRINSICS */
+
+#ifdef HAVE_NEON_INTRINSICS
+#include <arm_neon.h>
+
+#undef MAX
+#undef MIN
+
+#define VECTOR int16x8_t
+#define MASK uint16x8_t
+#define STEP 8
+#define FUNC_ATTR
+#define ADD(a,b) vaddq_s16 (a, b)
+#define SUB(a,b) vsubq_s16 (a, b)
+#define ABSDIFF(a,b) vabdq_s16 (a, b)
+#define SHR1(a) vshrq_n_s16 (a, 1)
+#define MAX(a,b) vmaxq_s16 (a, b)
+#define MIN(a,b) vminq_s16 (a, b)
+#define NEG(a) vnegq_s16 (a)
+#define GT(a,b) vcgtq_s16 (a, b)
+#define AND(a,b) vandq_u16 (a, b)
+#define SELECT(m,a,b) vbslq_s16 (m, a, b)
+#define ONE vdupq_n_s16 (1)
+
+#define PIXEL guint8
+#define LOAD(p) vreinterpretq_s16_u16 (vmovl_u8 (vld1_u8 (p)))
+#define STORE(p,v) vst1_u8 (p, vqmovun_s16 (v))
+#define RENAME(a) a ## _neon
+#include "yadif_simd_template.c"
+#undef PIXEL
+#undef LOAD
+#undef STORE
+#undef RENAME
+
+#define PIXEL guint16
+#define LOAD(p) vreinterpretq_s16_u16 (vld1q_u16 (p))
+#define STORE(p,v) vst1q_u16 (p, vreinterpretq_u16_s16 (v))
+#define RENAME(a) a ## _16bit_neon
+#include "yadif_simd_template.c"
+#undef PIXEL
+#undef LOAD
+#undef STORE
+#undef RENAME
+
+#undef VECTOR
+#undef MASK
+#undef STEP
+#undef FUNC_ATTR
+#undef ADD
+#undef SUB
+#undef ABSDIFF
+#undef SHR1
+#undef MAX
+#undef MIN
+#undef NEG
+#undef GT
+#undef AND
+#undef SELECT
+#undef ONE
+#endif /* HAVE_NEON_INTRINSICS */
@@ -0,0 +1,58 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef __YADIF_SIMD_H__
+#define __YADIF_SIMD_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#if HAVE_CPU_X86_64 && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || \
+    defined(__clang__))
+#define HAVE_AVX2_INTRINSICS 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_NEON_INTRINSICS 1
+#endif
+
+/* The vector line filters return the column up to which they filtered,
+ * starting at column 3 */
+typedef int (*YadifSimdLineFunc) (guint8 * dst, guint8 * prev, guint8 * cur,
+    guint8 * next, int w, int prefs, int mrefs, int parity, int mode);
+
+#ifdef HAVE_AVX2_INTRINSICS
+gboolean yadif_have_avx2 (void);
+int yadif_filter_line_avx2 (guint8 * dst, guint8 * prev, guint8 * cur,
+    guint8 * next, int w, int prefs, int mrefs, int parity, int mode);
+int yadif_filter_line_16bit_avx2 (guint8 * dst, guint8 * prev, guint8 * cur,
+    guint8 * next, int w, int prefs, int mrefs, int parity, int mode);
+#endif
+
+#ifdef HAVE_NEON_INTRINSICS
+int yadif_filter_line_neon (guint8 * dst, guint8 * prev, guint8 * cur,
+    guint8 * next, int w, int prefs, int mrefs, int parity, int mode);
+int yadif_filter_line_16bit_neon (guint8 * dst, guint8 * prev, guint8 * cur,
+    guint8 * next, int w, int prefs, int mrefs, int parity, int mode);
+#endif
+
+G_END_DECLS
+
+#endif /* __YADIF_SIMD_H__ */
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2006 Michael Niedermayer <michaelni@gmx.at>
+ *
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* The YADIF line filter on vectors of 16 bit lanes, included by yadif_simd.c
+ * once per instruction set and sample size. The including file defines
+ * PIXEL, STEP, FUNC_ATTR, RENAME and the vector operations.
+ *
+ * Pixels [3, returned x) are filtered, the caller handles the columns at the
+ * edges whose neighbours are outside of the line. */
+
+#define CUR(o) LOAD (cur + x + (o))
+
+#define SCORE(j) \
+    ADD (ADD (ABSDIFF (CUR (mrefs - 1 + (j)), CUR (prefs - 1 - (j))), \
+            ABSDIFF (CUR (mrefs + (j)), CUR (prefs - (j)))), \
+        ABSDIFF (CUR (mrefs + 1 + (j)), CUR (prefs + 1 - (j))))
+
+#define PRED(j) SHR1 (ADD (CUR (mrefs + (j)), CUR (prefs - (j))))
+
+/* the second direction is only tried if the first one was better, which
+ * matches the nesting of the C version */
+#define CHECK(j1, j2) \
+    score = SCORE (j1); \
+    mask = GT (spatial_score, score); \
+    spatial_score = SELECT (mask, score, spatial_score); \
+    spatial_pred = SELECT (mask, PRED (j1), spatial_pred); \
+    score = SCORE (j2); \
+    mask = AND (mask, GT (spatial_score, score)); \
+    spatial_score = SELECT (mask, score, spatial_score); \
+    spatial_pred = SELECT (mask, PRED (j2), spatial_pred);
+
+FUNC_ATTR int
+RENAME (yadif_filter_line) (guint8 * dst8, guint8 * prev8, guint8 * cur8,
+    guint8 * next8, int w, int prefs, int mrefs, int parity, int mode)
+{
+  PIXEL *dst = (PIXEL *) dst8;
+  PIXEL *prev = (PIXEL *) prev8;
+  PIXEL *cur = (PIXEL *) cur8;
+  PIXEL *next = (PIXEL *) next8;
+  PIXEL *prev2 = parity ? prev : cur;
+  PIXEL *next2 = parity ? cur : next;
+  int x;
+
+  prefs /= (int) sizeof (PIXEL);
+  mrefs /= (int) sizeof (PIXEL);
+
+  for (x = 3; x + STEP + 3 <= w; x += STEP) {
+    VECTOR c = CUR (mrefs);
+    VECTOR e = CUR (prefs);
+    VECTOR p2 = LOAD (prev2 + x);
+    VECTOR n2 = LOAD (next2 + x);
+    VECTOR d = SHR1 (ADD (p2, n2));
+    VECTOR temporal_diff0 = ABSDIFF (p2, n2);
+    VECTOR temporal_diff1 =
+        SHR1 (ADD (ABSDIFF (LOAD (prev + x + mrefs), c),
+            ABSDIFF (LOAD (prev + x + prefs), e)));
+    VECTOR temporal_diff2 =
+        SHR1 (ADD (ABSDIFF (LOAD (next + x + mrefs), c),
+            ABSDIFF (LOAD (next + x + prefs), e)));
+    VECTOR diff = MAX (MAX (SHR1 (temporal_diff0), temporal_diff1),
+        temporal_diff2);
+    VECTOR spatial_pred = SHR1 (ADD (c, e));
+    VECTOR spatial_score =
+        SUB (ADD (ADD (ABSDIFF (CUR (mrefs - 1), CUR (prefs - 1)),
+                ABSDIFF (c, e)), ABSDIFF (CUR (mrefs + 1), CUR (prefs + 1))),
+        ONE);
+    VECTOR score;
+    MASK mask;
+
+    CHECK (-1, -2);
+    CHECK (1, 2);
+
+    if (mode < 2) {
+      VECTOR b = SHR1 (ADD (LOAD (prev2 + x + 2 * mrefs),
+              LOAD (next2 + x + 2 * mrefs)));
+      VECTOR f = SHR1 (ADD (LOAD (prev2 + x + 2 * prefs),
+              LOAD (next2 + x + 2 * prefs)));
+      VECTOR max = MAX (MAX (SUB (d, e), SUB (d, c)),
+          MIN (SUB (b, c), SUB (f, e)));
+      VECTOR min = MIN (MIN (SUB (d, e), SUB (d, c)),
+          MAX (SUB (b, c), SUB (f, e)));
+
+      diff = MAX (MAX (diff, min), NEG (max));
+    }
+
+    spatial_pred = MIN (MAX (spatial_pred, SUB (d, diff)), ADD (d, diff));
+
+    STORE (dst + x, spatial_pred);
+  }
+
+  return x;
+}
+
+#undef CUR
+#undef SCORE
+#undef PRED
+#undef CHECK
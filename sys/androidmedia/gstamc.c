@@ -71,6 +71,7 @@ static struct
   jclass klass;
   jmethodID configure;
   jmethodID create_by_codec_name;
+  jmethodID create_input_surface;
   jmethodID dequeue_input_buffer;
   jmethodID dequeue_output_buffer;
   jmethodID flush;
@@ -82,10 +83,18 @@ static struct
   jmethodID queue_input_buffer;
   jmethodID release;
   jmethodID release_output_buffer;
+  jmethodID signal_end_of_input_stream;
   jmethodID start;
   jmethodID stop;
 } media_codec;
 static struct
+{
+  jclass klass;
+  jmethodID constructor;
+  jmethodID set_callback;
+  jmethodID release;
+} codec_callback;
+static struct
 {
   jclass klass;
   jmethodID constructor;
@@ -116,6 +125,27 @@ static GstAmcBuffer *gst_amc_codec_get_input_buffers (GstAmcCodec * codec,
 static GstAmcBuffer *gst_amc_codec_get_output_buffers (GstAmcCodec * codec,
     gsize * n_buffers, GError ** err);
 
+#if GLIB_SIZEOF_VOID_P == 8
+#define JLONG_TO_GST_AMC_CODEC(value) (GstAmcCodec *)(value)
+#define GST_AMC_CODEC_TO_JLONG(value) (jlong)(value)
+#else
+#define JLONG_TO_GST_AMC_CODEC(value) (GstAmcCodec *)(jint)(value)
+#define GST_AMC_CODEC_TO_JLONG(value) (jlong)(jint)(value)
+#endif
+
+/* An output buffer or format change reported by the callbacks */
+typedef struct
+{
+  gint index;
+  GstAmcBufferInfo info;
+} GstAmcCodecOutput;
+
+static void
+gst_amc_codec_output_free (GstAmcCodecOutput * output)
+{
+  g_slice_free (GstAmcCodecOutput, output);
+}
+
 GstAmcCodec *
 gst_amc_codec_new (const gchar * name, GError ** err)
 {
@@ -134,6 +164,8 @@ gst_amc_codec_new (const gchar * name, GError ** err)
   }
 
   codec = g_slice_new0 (GstAmcCodec);
+  g_mutex_init (&codec->lock);
+  g_cond_init (&codec->cond);
 
   if (!gst_amc_jni_call_static_object_method (env, err, media_codec.klass,
           media_codec.create_by_codec_name, &object, name_str))
@@ -156,12 +188,255 @@ done:
   return codec;
 
 error:
-  if (codec)
+  if (codec) {
+    g_mutex_clear (&codec->lock);
+    g_cond_clear (&codec->cond);
     g_slice_free (GstAmcCodec, codec);
+  }
   codec = NULL;
   goto done;
 }
 
+/* Drops whatever the callbacks reported, the indices are invalid after
+ * flushing or stopping the codec */
+static void
+gst_amc_codec_clear_async_queues (GstAmcCodec * codec)
+{
+  g_mutex_lock (&codec->lock);
+  g_queue_clear (&codec->input_indices);
+  while (!g_queue_is_empty (&codec->outputs))
+    gst_amc_codec_output_free (g_queue_pop_head (&codec->outputs));
+  g_cond_broadcast (&codec->cond);
+  g_mutex_unlock (&codec->lock);
+}
+
+static void
+gst_amc_codec_on_input_buffer_available (JNIEnv * env, jobject thiz,
+    jlong context, jint index)
+{
+  GstAmcCodec *codec = JLONG_TO_GST_AMC_CODEC (context);
+
+  if (!codec)
+    return;
+
+  g_mutex_lock (&codec->lock);
+  g_queue_push_tail (&codec->input_indices, GINT_TO_POINTER (index));
+  g_cond_broadcast (&codec->cond);
+  g_mutex_unlock (&codec->lock);
+}
+
+static void
+gst_amc_codec_on_output_buffer_available (JNIEnv * env, jobject thiz,
+    jlong context, jint index, jint offset, jint size,
+    jlong presentation_time_us, jint flags)
+{
+  GstAmcCodec *codec = JLONG_TO_GST_AMC_CODEC (context);
+  GstAmcCodecOutput *output;
+
+  if (!codec)
+    return;
+
+  output = g_slice_new (GstAmcCodecOutput);
+  output->index = index;
+  output->info.offset = offset;
+  output->info.size = size;
+  output->info.presentation_time_us = presentation_time_us;
+  output->info.flags = flags;
+
+  g_mutex_lock (&codec->lock);
+  g_queue_push_tail (&codec->outputs, output);
+  g_cond_broadcast (&codec->cond);
+  g_mutex_unlock (&codec->lock);
+}
+
+static void
+gst_amc_codec_on_output_format_changed (JNIEnv * env, jobject thiz,
+    jlong context)
+{
+  GstAmcCodec *codec = JLONG_TO_GST_AMC_CODEC (context);
+  GstAmcCodecOutput *output;
+
+  if (!codec)
+    return;
+
+  /* queued with the buffers, those before the change use the old format */
+  output = g_slice_new0 (GstAmcCodecOutput);
+  output->index = INFO_OUTPUT_FORMAT_CHANGED;
+
+  g_mutex_lock (&codec->lock);
+  g_queue_push_tail (&codec->outputs, output);
+  g_cond_broadcast (&codec->cond);
+  g_mutex_unlock (&codec->lock);
+}
+
+static void
+gst_amc_codec_on_error (JNIEnv * env, jobject thiz, jlong context,
+    jstring message)
+{
+  GstAmcCodec *codec = JLONG_TO_GST_AMC_CODEC (context);
+  gchar *str;
+
+  if (!codec)
+    return;
+
+  str = gst_amc_jni_string_to_gchar (env, message, FALSE);
+  GST_ERROR ("Codec error: %s", GST_STR_NULL (str));
+
+  g_mutex_lock (&codec->lock);
+  if (!codec->async_error)
+    g_set_error (&codec->async_error, GST_LIBRARY_ERROR,
+        GST_LIBRARY_ERROR_FAILED, "Codec error: %s", GST_STR_NULL (str));
+  g_cond_broadcast (&codec->cond);
+  g_mutex_unlock (&codec->lock);
+
+  g_free (str);
+}
+
+static JNINativeMethod codec_callback_native_methods[] = {
+  {(gchar *) "native_onInputBufferAvailable", (gchar *) "(JI)V",
+      (void *) gst_amc_codec_on_input_buffer_available},
+  {(gchar *) "native_onOutputBufferAvailable", (gchar *) "(JIIIJI)V",
+      (void *) gst_amc_codec_on_output_buffer_available},
+  {(gchar *) "native_onOutputFormatChanged", (gchar *) "(J)V",
+      (void *) gst_amc_codec_on_output_format_changed},
+  {(gchar *) "native_onError", (gchar *) "(JLjava/lang/String;)V",
+      (void *) gst_amc_codec_on_error},
+};
+
+static gpointer
+get_codec_callback_class (gpointer data)
+{
+  JNIEnv *env = gst_amc_jni_get_env ();
+  GError *err = NULL;
+
+  codec_callback.klass = gst_amc_jni_get_application_class (env,
+      "org/freedesktop/gstreamer/androidmedia/GstAmcCodecCallback", &err);
+  if (!codec_callback.klass)
+    goto failed;
+
+  codec_callback.constructor =
+      gst_amc_jni_get_method_id (env, &err, codec_callback.klass, "<init>",
+      "(J)V");
+  if (!codec_callback.constructor)
+    goto failed;
+
+  codec_callback.set_callback =
+      gst_amc_jni_get_method_id (env, &err, codec_callback.klass,
+      "setCallback", "(Landroid/media/MediaCodec;)V");
+  if (!codec_callback.set_callback)
+    goto failed;
+
+  codec_callback.release =
+      gst_amc_jni_get_method_id (env, &err, codec_callback.klass, "release",
+      "()V");
+  if (!codec_callback.release)
+    goto failed;
+
+  if ((*env)->RegisterNatives (env, codec_callback.klass,
+          codec_callback_native_methods,
+          G_N_ELEMENTS (codec_callback_native_methods))) {
+    GST_ERROR ("Failed to register native methods for GstAmcCodecCallback");
+    if ((*env)->ExceptionCheck (env))
+      (*env)->ExceptionClear (env);
+    goto failed;
+  }
+
+  return GINT_TO_POINTER (TRUE);
+
+failed:
+  if (err) {
+    GST_INFO ("No codec callback class: %s", err->message);
+    g_clear_error (&err);
+  }
+  return GINT_TO_POINTER (FALSE);
+}
+
+/**
+ * gst_amc_codec_enable_async:
+ * @codec: a #GstAmcCodec that is not configured yet
+ * @err: return location for a #GError
+ *
+ * Switches @codec to the asynchronous mode of Android 5.0, in which the codec
+ * reports available buffers through callbacks instead of being polled.
+ * gst_amc_codec_dequeue_input_buffer() and
+ * gst_amc_codec_dequeue_output_buffer() then wait for these callbacks and
+ * behave as before otherwise.
+ *
+ * Returns: %TRUE if the codec is in asynchronous mode now
+ */
+gboolean
+gst_amc_codec_enable_async (GstAmcCodec * codec, GError ** err)
+{
+  static GOnce once = G_ONCE_INIT;
+  JNIEnv *env;
+  jobject callback;
+
+  g_return_val_if_fail (codec != NULL, FALSE);
+  g_return_val_if_fail (codec->callback == NULL, FALSE);
+
+  if (!GPOINTER_TO_INT (g_once (&once, get_codec_callback_class, NULL))) {
+    g_set_error (err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_INIT,
+        "Codec callback class not available");
+    return FALSE;
+  }
+
+  env = gst_amc_jni_get_env ();
+  callback = gst_amc_jni_new_object (env, err, TRUE, codec_callback.klass,
+      codec_callback.constructor, GST_AMC_CODEC_TO_JLONG (codec));
+  if (!callback)
+    return FALSE;
+
+  /* fails before Android 5.0 */
+  if (!gst_amc_jni_call_void_method (env, err, callback,
+          codec_callback.set_callback, codec->object)) {
+    gst_amc_jni_call_void_method (env, NULL, callback, codec_callback.release);
+    gst_amc_jni_object_unref (env, callback);
+    return FALSE;
+  }
+
+  codec->callback = callback;
+
+  return TRUE;
+}
+
+/* Pops what the callbacks queued, waiting at most @timeout_us or forever if
+ * negative. Returns the index, INFO_TRY_AGAIN_LATER or G_MININT on errors */
+static gint
+gst_amc_codec_async_dequeue (GstAmcCodec * codec, GQueue * queue,
+    GstAmcBufferInfo * info, gint64 timeout_us, GError ** err)
+{
+  gint64 end_time = g_get_monotonic_time () + timeout_us;
+  gint ret = INFO_TRY_AGAIN_LATER;
+
+  g_mutex_lock (&codec->lock);
+  while (g_queue_is_empty (queue) && !codec->async_error) {
+    if (timeout_us == 0)
+      break;
+    else if (timeout_us < 0)
+      g_cond_wait (&codec->cond, &codec->lock);
+    else if (!g_cond_wait_until (&codec->cond, &codec->lock, end_time))
+      break;
+  }
+
+  if (codec->async_error) {
+    g_propagate_error (err, g_error_copy (codec->async_error));
+    ret = G_MININT;
+  } else if (queue == &codec->input_indices) {
+    if (!g_queue_is_empty (queue))
+      ret = GPOINTER_TO_INT (g_queue_pop_head (queue));
+  } else if (!g_queue_is_empty (queue)) {
+    GstAmcCodecOutput *output = g_queue_pop_head (queue);
+
+    ret = output->index;
+    if (ret >= 0)
+      *info = output->info;
+    gst_amc_codec_output_free (output);
+  }
+  g_mutex_unlock (&codec->lock);
+
+  return ret;
+}
+
 void
 gst_amc_codec_free (GstAmcCodec * codec)
 {
@@ -183,6 +458,18 @@ gst_amc_codec_free (GstAmcCodec * codec)
   codec->output_buffers = NULL;
   codec->n_output_buffers = 0;
 
+  if (codec->callback) {
+    /* waits for running callbacks, none are called afterwards */
+    gst_amc_jni_call_void_method (env, NULL, codec->callback,
+        codec_callback.release);
+    gst_amc_jni_object_unref (env, codec->callback);
+    codec->callback = NULL;
+  }
+  gst_amc_codec_clear_async_queues (codec);
+  g_clear_error (&codec->async_error);
+  g_mutex_clear (&codec->lock);
+  g_cond_clear (&codec->cond);
+
   gst_amc_jni_object_unref (env, codec->object);
   g_slice_free (GstAmcCodec, codec);
 }
@@ -281,8 +568,14 @@ gst_amc_codec_stop (GstAmcCodec * codec, GError ** err)
   codec->output_buffers = NULL;
   codec->n_output_buffers = 0;
 
-  return gst_amc_jni_call_void_method (env, err, codec->object,
-      media_codec.stop);
+  if (!gst_amc_jni_call_void_method (env, err, codec->object,
+          media_codec.stop))
+    return FALSE;
+
+  if (codec->callback)
+    gst_amc_codec_clear_async_queues (codec);
+
+  return TRUE;
 }
 
 gboolean
@@ -293,8 +586,18 @@ gst_amc_codec_flush (GstAmcCodec * codec, GError ** err)
   g_return_val_if_fail (codec != NULL, FALSE);
 
   env = gst_amc_jni_get_env ();
+  if (!gst_amc_jni_call_void_method (env, err, codec->object,
+          media_codec.flush))
+    return FALSE;
+
+  if (!codec->callback)
+    return TRUE;
+
+  /* in asynchronous mode the codec stays paused after flushing until it
+   * is started again, and reports all input buffers anew */
+  gst_amc_codec_clear_async_queues (codec);
   return gst_amc_jni_call_void_method (env, err, codec->object,
-      media_codec.flush);
+      media_codec.start);
 }
 
 gboolean
@@ -493,6 +796,10 @@ gst_amc_codec_dequeue_input_buffer (GstAmcCodec * codec, gint64 timeoutUs,
 
   g_return_val_if_fail (codec != NULL, G_MININT);
 
+  if (codec->callback)
+    return gst_amc_codec_async_dequeue (codec, &codec->input_indices, NULL,
+        timeoutUs, err);
+
   env = gst_amc_jni_get_env ();
   if (!gst_amc_jni_call_int_method (env, err, codec->object,
           media_codec.dequeue_input_buffer, &ret, timeoutUs))
@@ -537,6 +844,12 @@ gst_amc_codec_dequeue_output_buffer (GstAmcCodec * codec,
 
   g_return_val_if_fail (codec != NULL, G_MININT);
 
+  /* there are no buffer arrays to update in asynchronous mode, it needs
+   * getOutputBuffer() just like the callbacks */
+  if (codec->callback)
+    return gst_amc_codec_async_dequeue (codec, &codec->outputs, info,
+        timeoutUs, err);
+
   env = gst_amc_jni_get_env ();
 
   info_o =
@@ -615,6 +928,58 @@ gst_amc_codec_release_output_buffer (GstAmcCodec * codec, gint index,
       media_codec.release_output_buffer, index, render);
 }
 
+/* Surface input needs both halves, added together in Android 4.3 */
+gboolean
+gst_amc_codec_supports_input_surface (void)
+{
+  return media_codec.create_input_surface != NULL
+      && media_codec.signal_end_of_input_stream != NULL;
+}
+
+/**
+ * gst_amc_codec_create_input_surface:
+ * @codec: a configured, not yet started encoder #GstAmcCodec
+ * @err: return location for a #GError
+ *
+ * Returns: (transfer full): a global reference to the android.view.Surface
+ * that the frames to encode are drawn into, or %NULL before Android 4.3
+ */
+jobject
+gst_amc_codec_create_input_surface (GstAmcCodec * codec, GError ** err)
+{
+  JNIEnv *env;
+  jobject surface = NULL;
+
+  g_return_val_if_fail (codec != NULL, NULL);
+
+  if (!media_codec.create_input_surface) {
+    g_set_error (err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_SETTINGS,
+        "Surface input not supported");
+    return NULL;
+  }
+
+  env = gst_amc_jni_get_env ();
+  if (!gst_amc_jni_call_object_method (env, err, codec->object,
+          media_codec.create_input_surface, &surface))
+    return NULL;
+
+  return gst_amc_jni_object_make_global (env, surface);
+}
+
+gboolean
+gst_amc_codec_signal_end_of_input_stream (GstAmcCodec * codec, GError ** err)
+{
+  JNIEnv *env;
+
+  g_return_val_if_fail (codec != NULL, FALSE);
+  g_return_val_if_fail (media_codec.signal_end_of_input_stream != NULL,
+      FALSE);
+
+  env = gst_amc_jni_get_env ();
+  return gst_amc_jni_call_void_method (env, err, codec->object,
+      media_codec.signal_end_of_input_stream);
+}
+
 GstAmcFormat *
 gst_amc_format_new_audio (const gchar * mime, gint sample_rate, gint channels,
     GError ** err)
@@ -1176,6 +1541,20 @@ get_java_classes (void)
     goto done;
   }
 
+  /* Android >= 18 */
+  media_codec.create_input_surface =
+      (*env)->GetMethodID (env, media_codec.klass, "createInputSurface",
+      "()Landroid/view/Surface;");
+  if ((*env)->ExceptionCheck (env))
+    (*env)->ExceptionClear (env);
+
+  /* Android >= 18 */
+  media_codec.signal_end_of_input_stream =
+      (*env)->GetMethodID (env, media_codec.klass, "signalEndOfInputStream",
+      "()V");
+  if ((*env)->ExceptionCheck (env))
+    (*env)->ExceptionClear (env);
+
   /* Android >= 21 */
   media_codec.get_output_buffer =
       (*env)->GetMethodID (env, media_codec.klass, "getOutputBuffer",
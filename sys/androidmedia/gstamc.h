@@ -69,6 +69,14 @@ struct _GstAmcCodec {
 
   GstAmcBuffer *input_buffers, *output_buffers;
   gsize n_input_buffers, n_output_buffers;
+
+  /* asynchronous mode, filled by the callbacks */
+  jobject callback; /* global reference */
+  GMutex lock;
+  GCond cond;
+  GQueue input_indices;
+  GQueue outputs;
+  GError *async_error;
 };
 
 struct _GstAmcBufferInfo {
@@ -83,6 +91,8 @@ extern GQuark gst_amc_codec_info_quark;
 GstAmcCodec * gst_amc_codec_new (const gchar *name, GError **err);
 void gst_amc_codec_free (GstAmcCodec * codec);
 
+gboolean gst_amc_codec_enable_async (GstAmcCodec * codec, GError **err);
+
 gboolean gst_amc_codec_configure (GstAmcCodec * codec, GstAmcFormat * format, jobject surface, gint flags, GError **err);
 GstAmcFormat * gst_amc_codec_get_output_format (GstAmcCodec * codec, GError **err);
 
@@ -100,6 +110,10 @@ gint gst_amc_codec_dequeue_output_buffer (GstAmcCodec * codec, GstAmcBufferInfo
 gboolean gst_amc_codec_queue_input_buffer (GstAmcCodec * codec, gint index, const GstAmcBufferInfo *info, GError **err);
 gboolean gst_amc_codec_release_output_buffer (GstAmcCodec * codec, gint index, gboolean render, GError **err);
 
+gboolean gst_amc_codec_supports_input_surface (void);
+jobject gst_amc_codec_create_input_surface (GstAmcCodec * codec, GError **err);
+gboolean gst_amc_codec_signal_end_of_input_stream (GstAmcCodec * codec, GError **err);
+
 
 GstAmcFormat * gst_amc_format_new_audio (const gchar *mime, gint sample_rate, gint channels, GError **err);
 GstAmcFormat * gst_amc_format_new_video (const gchar *mime, gint width, gint height, GError **err);
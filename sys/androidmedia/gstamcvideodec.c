@@ -445,6 +445,13 @@ gst_amc_video_dec_open (GstVideoDecoder * decoder)
     GST_ELEMENT_ERROR_FROM_ERROR (self, err);
     return FALSE;
   }
+
+  /* let the codec report its buffers instead of polling it */
+  if (!gst_amc_codec_enable_async (self->codec, &err)) {
+    GST_DEBUG_OBJECT (self, "Using the codec synchronously: %s",
+        err->message);
+    g_clear_error (&err);
+  }
   self->codec_config = AMC_CODEC_CONFIG_NONE;
 
   self->started = FALSE;
@@ -33,8 +33,13 @@
 #endif
 
 #include <gst/gst.h>
+#include <gst/gl/gstglfuncs.h>
 #include <string.h>
 
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <android/native_window_jni.h>
+
 #ifdef HAVE_ORC
 #include <orc/orc.h>
 #else
@@ -226,11 +231,16 @@ create_amc_format (GstAmcVideoEnc * encoder, GstVideoCodecState * input_state,
     return NULL;
   }
 
-  color_format =
-      gst_amc_video_format_to_color_format (klass->codec_info,
-      mime, info->finfo->format);
-  if (color_format == -1)
-    goto video_format_failed_to_convert;
+  if (encoder->surface_input) {
+    /* COLOR_FormatSurface, the frames are drawn into the input surface */
+    color_format = COLOR_FormatAndroidOpaque;
+  } else {
+    color_format =
+        gst_amc_video_format_to_color_format (klass->codec_info,
+        mime, info->finfo->format);
+    if (color_format == -1)
+      goto video_format_failed_to_convert;
+  }
 
   gst_amc_format_set_int (format, "bitrate", encoder->bitrate, &err);
   if (err)
@@ -238,14 +248,17 @@ create_amc_format (GstAmcVideoEnc * encoder, GstVideoCodecState * input_state,
   gst_amc_format_set_int (format, "color-format", color_format, &err);
   if (err)
     GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
+
   stride = GST_ROUND_UP_4 (info->width);        /* safe (?) */
-  gst_amc_format_set_int (format, "stride", stride, &err);
-  if (err)
-    GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
   slice_height = info->height;
-  gst_amc_format_set_int (format, "slice-height", slice_height, &err);
-  if (err)
-    GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
+  if (!encoder->surface_input) {
+    gst_amc_format_set_int (format, "stride", stride, &err);
+    if (err)
+      GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
+    gst_amc_format_set_int (format, "slice-height", slice_height, &err);
+    if (err)
+      GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
+  }
 
   if (profile_string) {
     if (amc_profile.id == -1)
@@ -275,6 +288,16 @@ create_amc_format (GstAmcVideoEnc * encoder, GstVideoCodecState * input_state,
     GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
 
   encoder->format = info->finfo->format;
+  if (encoder->surface_input) {
+    /* only used to detect format changes */
+    memset (&encoder->color_format_info, 0,
+        sizeof (encoder->color_format_info));
+    encoder->color_format_info.color_format = color_format;
+    encoder->color_format_info.width = info->width;
+    encoder->color_format_info.height = info->height;
+    return format;
+  }
+
   if (!gst_amc_color_format_info_set (&encoder->color_format_info,
           klass->codec_info, mime, color_format, info->width, info->height,
           stride, slice_height, 0, 0, 0, 0))
@@ -442,6 +465,18 @@ gst_amc_video_enc_base_init (gpointer g_class)
   videoenc_class->codec_info = codec_info;
 
   gst_amc_codec_info_to_caps (codec_info, &sink_caps, &src_caps);
+  if (gst_amc_codec_supports_input_surface ()) {
+    GstCaps *gl_caps;
+
+    /* preferred, GL frames are drawn into the input surface of the codec
+     * without leaving the GPU */
+    gl_caps =
+        gst_caps_from_string (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_GL_MEMORY, "RGBA") ", texture-target = "
+        "(string) 2D");
+    gst_caps_append (gl_caps, sink_caps);
+    sink_caps = gl_caps;
+  }
   /* Add pad templates */
   templ =
       gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS, sink_caps);
@@ -583,6 +618,13 @@ gst_amc_video_enc_open (GstVideoEncoder * encoder)
     GST_ELEMENT_ERROR_FROM_ERROR (self, err);
     return FALSE;
   }
+
+  /* let the codec report its buffers instead of polling it */
+  if (!gst_amc_codec_enable_async (self->codec, &err)) {
+    GST_DEBUG_OBJECT (self, "Using the codec synchronously: %s",
+        err->message);
+    g_clear_error (&err);
+  }
   self->started = FALSE;
   self->flushing = TRUE;
 
@@ -827,6 +869,175 @@ gst_amc_video_enc_fill_buffer (GstAmcVideoEnc * self, GstBuffer * inbuf,
       buffer_info, info, inbuf, COLOR_FORMAT_COPY_IN);
 }
 
+typedef struct
+{
+  GstAmcVideoEnc *self;
+  GstGLMemory *mem;
+  GstClockTime pts;
+  gboolean ret;
+} DrawFrameData;
+
+/* Runs in the GL thread. The window surface has to use the same config as
+ * the context of the upstream GL memory to be made current with it */
+static void
+_create_egl_surface (GstGLContext * context, DrawFrameData * data)
+{
+  GstAmcVideoEnc *self = data->self;
+  EGLDisplay display;
+  EGLContext egl_context;
+  EGLConfig config;
+  EGLint config_id, n_configs = 0;
+  EGLint attribs[] = { EGL_CONFIG_ID, 0, EGL_NONE };
+  EGLSurface surface;
+  GError *error = NULL;
+
+  data->ret = FALSE;
+
+  display = (EGLDisplay) gst_gl_display_get_handle (context->display);
+  egl_context = (EGLContext) gst_gl_context_get_gl_context (context);
+
+  if (!eglQueryContext (display, egl_context, EGL_CONFIG_ID, &config_id)) {
+    GST_ERROR_OBJECT (self, "Failed to query EGL config: 0x%x",
+        eglGetError ());
+    return;
+  }
+  attribs[1] = config_id;
+  if (!eglChooseConfig (display, attribs, &config, 1, &n_configs)
+      || n_configs < 1) {
+    GST_ERROR_OBJECT (self, "Failed to choose EGL config: 0x%x",
+        eglGetError ());
+    return;
+  }
+
+  surface = eglCreateWindowSurface (display, config, self->input_window,
+      NULL);
+  if (surface == EGL_NO_SURFACE) {
+    GST_ERROR_OBJECT (self, "Failed to create EGL window surface: 0x%x",
+        eglGetError ());
+    return;
+  }
+
+  self->shader = gst_gl_shader_new_default (context, &error);
+  if (!self->shader) {
+    GST_ERROR_OBJECT (self, "Failed to create shader: %s", error->message);
+    g_clear_error (&error);
+    eglDestroySurface (display, surface);
+    return;
+  }
+
+  self->egl_surface = surface;
+  data->ret = TRUE;
+}
+
+static void
+_destroy_egl_surface (GstGLContext * context, GstAmcVideoEnc * self)
+{
+  EGLDisplay display;
+
+  display = (EGLDisplay) gst_gl_display_get_handle (context->display);
+  if (self->shader)
+    gst_object_unref (self->shader);
+  self->shader = NULL;
+  if (self->egl_surface)
+    eglDestroySurface (display, (EGLSurface) self->egl_surface);
+  self->egl_surface = NULL;
+}
+
+/* Runs in the GL thread: draws the texture into the input surface of the
+ * codec and swaps it with the frame timestamp, which is what the codec uses
+ * as presentation time of the frame */
+static void
+_draw_frame (GstGLContext * context, DrawFrameData * data)
+{
+  static const GLfloat vertices[] = {
+    -1.0f, -1.0f, 0.0f, 1.0f,
+    1.0f, -1.0f, 1.0f, 1.0f,
+    -1.0f, 1.0f, 0.0f, 0.0f,
+    1.0f, 1.0f, 1.0f, 0.0f
+  };
+  GstAmcVideoEnc *self = data->self;
+  const GstGLFuncs *gl = context->gl_vtable;
+  PFNEGLPRESENTATIONTIMEANDROIDPROC presentation_time;
+  EGLDisplay display;
+  EGLContext egl_context;
+  EGLSurface draw, read;
+  GLint position, texcoord;
+
+  data->ret = FALSE;
+
+  display = (EGLDisplay) gst_gl_display_get_handle (context->display);
+  egl_context = (EGLContext) gst_gl_context_get_gl_context (context);
+  draw = eglGetCurrentSurface (EGL_DRAW);
+  read = eglGetCurrentSurface (EGL_READ);
+
+  if (!eglMakeCurrent (display, (EGLSurface) self->egl_surface,
+          (EGLSurface) self->egl_surface, egl_context)) {
+    GST_ERROR_OBJECT (self, "Failed to make input surface current: 0x%x",
+        eglGetError ());
+    return;
+  }
+
+  gl->Viewport (0, 0, GST_VIDEO_INFO_WIDTH (&self->input_state->info),
+      GST_VIDEO_INFO_HEIGHT (&self->input_state->info));
+
+  gst_gl_shader_use (self->shader);
+  position = gst_gl_shader_get_attribute_location (self->shader,
+      "a_position");
+  texcoord = gst_gl_shader_get_attribute_location (self->shader,
+      "a_texcoord");
+  gl->VertexAttribPointer (position, 2, GL_FLOAT, GL_FALSE,
+      4 * sizeof (GLfloat), vertices);
+  gl->VertexAttribPointer (texcoord, 2, GL_FLOAT, GL_FALSE,
+      4 * sizeof (GLfloat), vertices + 2);
+  gl->EnableVertexAttribArray (position);
+  gl->EnableVertexAttribArray (texcoord);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, gst_gl_memory_get_texture_id (data->mem));
+  gst_gl_shader_set_uniform_1i (self->shader, "tex", 0);
+
+  gl->DrawArrays (GL_TRIANGLE_STRIP, 0, 4);
+
+  gl->DisableVertexAttribArray (position);
+  gl->DisableVertexAttribArray (texcoord);
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+  gst_gl_context_clear_shader (context);
+
+  presentation_time = (PFNEGLPRESENTATIONTIMEANDROIDPROC)
+      eglGetProcAddress ("eglPresentationTimeANDROID");
+  if (presentation_time && GST_CLOCK_TIME_IS_VALID (data->pts))
+    presentation_time (display, (EGLSurface) self->egl_surface, data->pts);
+
+  if (eglSwapBuffers (display, (EGLSurface) self->egl_surface))
+    data->ret = TRUE;
+  else
+    GST_ERROR_OBJECT (self, "Failed to swap input surface: 0x%x",
+        eglGetError ());
+
+  eglMakeCurrent (display, draw, read, egl_context);
+}
+
+static void
+gst_amc_video_enc_release_input_surface (GstAmcVideoEnc * self)
+{
+  if (self->gl_context) {
+    gst_gl_context_thread_add (self->gl_context,
+        (GstGLContextThreadFunc) _destroy_egl_surface, self);
+    gst_object_unref (self->gl_context);
+    self->gl_context = NULL;
+  }
+
+  if (self->input_window) {
+    ANativeWindow_release (self->input_window);
+    self->input_window = NULL;
+  }
+
+  if (self->input_surface) {
+    gst_amc_jni_object_unref (gst_amc_jni_get_env (), self->input_surface);
+    self->input_surface = NULL;
+  }
+}
+
 static GstFlowReturn
 gst_amc_video_enc_handle_output_frame (GstAmcVideoEnc * self,
     GstAmcBuffer * buf, const GstAmcBufferInfo * buffer_info,
@@ -1228,6 +1439,8 @@ gst_amc_video_enc_stop (GstVideoEncoder * encoder)
     self->amc_format = NULL;
   }
 
+  gst_amc_video_enc_release_input_surface (self);
+
   GST_DEBUG_OBJECT (self, "Stopped encoder");
   return TRUE;
 }
@@ -1301,6 +1514,10 @@ gst_amc_video_enc_set_format (GstVideoEncoder * encoder,
   GST_DEBUG_OBJECT (self, "chose caps %" GST_PTR_FORMAT, allowed_caps);
   allowed_caps = gst_caps_truncate (allowed_caps);
 
+  self->surface_input =
+      gst_caps_features_contains (gst_caps_get_features (state->caps, 0),
+      GST_CAPS_FEATURE_MEMORY_GL_MEMORY);
+
   format = create_amc_format (self, state, allowed_caps);
   if (!format)
     goto quit;
@@ -1318,6 +1535,25 @@ gst_amc_video_enc_set_format (GstVideoEncoder * encoder,
     goto quit;
   }
 
+  /* The input surface has to be created between configure() and start() */
+  if (self->surface_input) {
+    self->input_surface =
+        gst_amc_codec_create_input_surface (self->codec, &err);
+    if (!self->input_surface) {
+      GST_ERROR_OBJECT (self, "Failed to create input surface");
+      GST_ELEMENT_ERROR_FROM_ERROR (self, err);
+      goto quit;
+    }
+
+    self->input_window = ANativeWindow_fromSurface (gst_amc_jni_get_env (),
+        self->input_surface);
+    if (!self->input_window) {
+      GST_ELEMENT_ERROR (self, LIBRARY, SETTINGS, (NULL),
+          ("Failed to get a native window for the input surface"));
+      goto quit;
+    }
+  }
+
   if (!gst_amc_codec_start (self->codec, &err)) {
     GST_ERROR_OBJECT (self, "Failed to start codec");
     GST_ELEMENT_ERROR_FROM_ERROR (self, err);
@@ -1390,6 +1626,93 @@ gst_amc_video_enc_flush (GstVideoEncoder * encoder)
   return TRUE;
 }
 
+/* Upstream GL memory is drawn into the input surface of the codec instead
+ * of being copied into an input buffer */
+static GstFlowReturn
+gst_amc_video_enc_handle_gl_frame (GstAmcVideoEnc * self,
+    GstVideoCodecFrame * frame)
+{
+  DrawFrameData data;
+  GstMemory *mem;
+  GstMapInfo map_info;
+  BufferIdentification *id;
+
+  mem = gst_buffer_peek_memory (frame->input_buffer, 0);
+  if (!gst_is_gl_memory (mem)) {
+    GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+        ("Input buffer has no GL memory"));
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
+  }
+
+  data.self = self;
+  data.mem = (GstGLMemory *) mem;
+  data.pts = frame->pts;
+  data.ret = FALSE;
+
+  if (!self->gl_context) {
+    GstGLContext *context = ((GstGLBaseMemory *) mem)->context;
+
+    if (gst_gl_context_get_gl_platform (context) != GST_GL_PLATFORM_EGL) {
+      GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+          ("Input GL memory is not from an EGL context"));
+      gst_video_codec_frame_unref (frame);
+      return GST_FLOW_ERROR;
+    }
+
+    self->gl_context = gst_object_ref (context);
+    gst_gl_context_thread_add (context,
+        (GstGLContextThreadFunc) _create_egl_surface, &data);
+    if (!data.ret) {
+      GST_ELEMENT_ERROR (self, LIBRARY, INIT, (NULL),
+          ("Failed to create EGL surface for the input surface"));
+      gst_video_codec_frame_unref (frame);
+      return GST_FLOW_ERROR;
+    }
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (frame->pts)) {
+    self->last_upstream_ts = frame->pts;
+    if (GST_CLOCK_TIME_IS_VALID (frame->duration))
+      self->last_upstream_ts += frame->duration;
+  }
+
+  id = buffer_identification_new (frame->pts);
+  gst_video_codec_frame_set_user_data (frame, id,
+      (GDestroyNotify) buffer_identification_free);
+
+  /* Drawing blocks when the codec did not consume the previous frames yet,
+   * _loop() needs the stream lock to finish frames in the meantime */
+  if (!gst_memory_map (mem, &map_info, GST_MAP_READ | GST_MAP_GL)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+        ("Failed to map input GL memory"));
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
+  }
+  GST_VIDEO_ENCODER_STREAM_UNLOCK (self);
+  gst_gl_context_thread_add (self->gl_context,
+      (GstGLContextThreadFunc) _draw_frame, &data);
+  GST_VIDEO_ENCODER_STREAM_LOCK (self);
+  gst_memory_unmap (mem, &map_info);
+
+  if (!data.ret) {
+    if (self->flushing) {
+      gst_video_codec_frame_unref (frame);
+      return GST_FLOW_FLUSHING;
+    }
+    GST_ELEMENT_ERROR (self, LIBRARY, FAILED, (NULL),
+        ("Failed to draw frame into the input surface"));
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
+  }
+
+  self->drained = FALSE;
+
+  gst_video_codec_frame_unref (frame);
+
+  return self->downstream_flow_ret;
+}
+
 static GstFlowReturn
 gst_amc_video_enc_handle_frame (GstVideoEncoder * encoder,
     GstVideoCodecFrame * frame)
@@ -1421,6 +1744,9 @@ gst_amc_video_enc_handle_frame (GstVideoEncoder * encoder,
   timestamp = frame->pts;
   duration = frame->duration;
 
+  if (self->surface_input)
+    return gst_amc_video_enc_handle_gl_frame (self, frame);
+
 again:
   /* Make sure to release the base class stream lock, otherwise
    * _loop() can't call _finish_frame() and we might block forever
@@ -1610,6 +1936,35 @@ gst_amc_video_enc_drain (GstAmcVideoEnc * self)
     return GST_FLOW_OK;
   }
 
+  /* There are no input buffers to send an EOS buffer with when the codec
+   * reads from its input surface */
+  if (self->surface_input) {
+    GST_VIDEO_ENCODER_STREAM_UNLOCK (self);
+    g_mutex_lock (&self->drain_lock);
+    self->draining = TRUE;
+    if (gst_amc_codec_signal_end_of_input_stream (self->codec, &err)) {
+      GST_DEBUG_OBJECT (self, "Waiting until codec is drained");
+      g_cond_wait (&self->drain_cond, &self->drain_lock);
+      GST_DEBUG_OBJECT (self, "Drained codec");
+      ret = GST_FLOW_OK;
+    } else {
+      GST_ERROR_OBJECT (self, "Failed to signal end of input stream");
+      if (self->flushing) {
+        g_clear_error (&err);
+        ret = GST_FLOW_FLUSHING;
+      } else {
+        GST_ELEMENT_WARNING_FROM_ERROR (self, err);
+        ret = GST_FLOW_ERROR;
+      }
+    }
+    self->drained = TRUE;
+    self->draining = FALSE;
+    g_mutex_unlock (&self->drain_lock);
+    GST_VIDEO_ENCODER_STREAM_LOCK (self);
+
+    return ret;
+  }
+
   /* Make sure to release the base class stream lock, otherwise
    * _loop() can't call _finish_frame() and we might block forever
    * because no input buffers are released */
@@ -27,6 +27,9 @@
 #include <gst/gst.h>
 
 #include <gst/video/gstvideoencoder.h>
+#include <gst/gl/gl.h>
+
+#include <android/native_window.h>
 
 #include "gstamc.h"
 
@@ -64,6 +67,14 @@ struct _GstAmcVideoEnc
   guint bitrate;
   guint i_frame_int;
 
+  /* GL memory input, drawn into the input surface of the codec */
+  gboolean surface_input;
+  jobject input_surface;
+  ANativeWindow *input_window;
+  GstGLContext *gl_context;
+  gpointer egl_surface;
+  GstGLShader *shader;
+
   /* TRUE if the component is configured and saw
    * the first buffer */
   gboolean started;
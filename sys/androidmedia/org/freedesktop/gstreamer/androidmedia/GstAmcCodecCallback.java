@@ -0,0 +1,79 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ */
+
+package org.freedesktop.gstreamer.androidmedia;
+
+import android.media.MediaCodec;
+import android.media.MediaFormat;
+import android.os.Build;
+import android.os.Handler;
+import android.os.HandlerThread;
+
+public class GstAmcCodecCallback extends MediaCodec.Callback
+{
+    private long context = 0;
+    private HandlerThread thread = null;
+
+    public GstAmcCodecCallback (long c) {
+        context = c;
+    }
+
+    public synchronized void setCallback (MediaCodec codec) {
+        /* Without a handler the callbacks run on the main looper, which the
+         * application might be blocking */
+        if (Build.VERSION.SDK_INT >= 23) {
+            thread = new HandlerThread ("GstAmcCodecCallback");
+            thread.start ();
+            codec.setCallback (this, new Handler (thread.getLooper ()));
+        } else {
+            codec.setCallback (this);
+        }
+    }
+
+    public synchronized void release () {
+        context = 0;
+        if (thread != null) {
+            thread.quit ();
+            thread = null;
+        }
+    }
+
+    @Override
+    public synchronized void onInputBufferAvailable (MediaCodec codec, int index) {
+        native_onInputBufferAvailable (context, index);
+    }
+
+    @Override
+    public synchronized void onOutputBufferAvailable (MediaCodec codec, int index, MediaCodec.BufferInfo info) {
+        native_onOutputBufferAvailable (context, index, info.offset, info.size, info.presentationTimeUs, info.flags);
+    }
+
+    @Override
+    public synchronized void onOutputFormatChanged (MediaCodec codec, MediaFormat format) {
+        native_onOutputFormatChanged (context);
+    }
+
+    @Override
+    public synchronized void onError (MediaCodec codec, MediaCodec.CodecException e) {
+        native_onError (context, e.toString ());
+    }
+
+    private native void native_onInputBufferAvailable (long context, int index);
+    private native void native_onOutputBufferAvailable (long context, int index, int offset, int size, long presentationTimeUs, int flags);
+    private native void native_onOutputFormatChanged (long context);
+    private native void native_onError (long context, String message);
+}
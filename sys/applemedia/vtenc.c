@@ -35,6 +35,7 @@
 #define VTENC_DEFAULT_QUALITY 0.5
 #define VTENC_DEFAULT_MAX_KEYFRAME_INTERVAL 0
 #define VTENC_DEFAULT_MAX_KEYFRAME_INTERVAL_DURATION 0
+#define VTENC_DEFAULT_LOW_LATENCY FALSE
 
 GST_DEBUG_CATEGORY (gst_vtenc_debug);
 #define GST_CAT_DEFAULT (gst_vtenc_debug)
@@ -60,6 +61,11 @@ CFSTR ("H264_Baseline_AutoLevel");
 const CFStringRef kVTCompressionPropertyKey_Quality = CFSTR ("Quality");
 #endif
 
+/* kVTVideoEncoderSpecification_EnableLowLatencyRateControl, only declared
+ * by the macOS 11.3 and iOS 14.5 SDKs. Older systems ignore it */
+#define VTENC_ENABLE_LOW_LATENCY_RATE_CONTROL \
+    CFSTR ("EnableLowLatencyRateControl")
+
 #ifdef HAVE_VIDEOTOOLBOX_10_9_6
 extern OSStatus
 VTCompressionSessionPrepareToEncodeFrames (VTCompressionSessionRef session)
@@ -75,7 +81,8 @@ enum
   PROP_REALTIME,
   PROP_QUALITY,
   PROP_MAX_KEYFRAME_INTERVAL,
-  PROP_MAX_KEYFRAME_INTERVAL_DURATION
+  PROP_MAX_KEYFRAME_INTERVAL_DURATION,
+  PROP_LOW_LATENCY
 };
 
 typedef struct _GstVTEncFrame GstVTEncFrame;
@@ -86,6 +93,27 @@ struct _GstVTEncFrame
   GstVideoFrame videoframe;
 };
 
+/* Buffer pool proposed upstream. Every buffer wraps a new CVPixelBuffer from
+ * the pixel buffer pool of the compression session, which recycles the
+ * IOSurfaces once both upstream and the encoder released them, so the
+ * buffers are freed instead of being kept in this pool */
+typedef struct
+{
+  GstBufferPool parent;
+
+  CVPixelBufferPoolRef cv_pool;
+  GstVideoInfo info;
+} GstVTEncBufferPool;
+
+typedef struct
+{
+  GstBufferPoolClass parent_class;
+} GstVTEncBufferPoolClass;
+
+static GType gst_vtenc_buffer_pool_get_type (void);
+G_DEFINE_TYPE (GstVTEncBufferPool, gst_vtenc_buffer_pool,
+    GST_TYPE_BUFFER_POOL);
+
 static GstElementClass *parent_class = NULL;
 
 static void gst_vtenc_get_property (GObject * obj, guint prop_id,
@@ -102,6 +130,8 @@ static GstFlowReturn gst_vtenc_handle_frame (GstVideoEncoder * enc,
     GstVideoCodecFrame * frame);
 static GstFlowReturn gst_vtenc_finish (GstVideoEncoder * enc);
 static gboolean gst_vtenc_flush (GstVideoEncoder * enc);
+static gboolean gst_vtenc_propose_allocation (GstVideoEncoder * enc,
+    GstQuery * query);
 
 static void gst_vtenc_clear_cached_caps_downstream (GstVTEnc * self);
 
@@ -219,6 +249,7 @@ gst_vtenc_class_init (GstVTEncClass * klass)
   gstvideoencoder_class->handle_frame = gst_vtenc_handle_frame;
   gstvideoencoder_class->finish = gst_vtenc_finish;
   gstvideoencoder_class->flush = gst_vtenc_flush;
+  gstvideoencoder_class->propose_allocation = gst_vtenc_propose_allocation;
 
   g_object_class_install_property (gobject_class, PROP_BITRATE,
       g_param_spec_uint ("bitrate", "Bitrate",
@@ -257,6 +288,14 @@ gst_vtenc_class_init (GstVTEncClass * klass)
           "Maximum number of nanoseconds between keyframes (0 = no limit)", 0,
           G_MAXUINT64, VTENC_DEFAULT_MAX_KEYFRAME_INTERVAL_DURATION,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low Latency",
+          "Use the low latency rate control of the encoder, which does not "
+          "reorder frames (macOS 11.3 / iOS 14.5 and newer)",
+          VTENC_DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static void
@@ -274,6 +313,7 @@ gst_vtenc_init (GstVTEnc * self)
   self->latency_frames = -1;
   self->session = NULL;
   self->profile_level = NULL;
+  self->low_latency = VTENC_DEFAULT_LOW_LATENCY;
 
   self->keyframe_props =
       CFDictionaryCreate (NULL, (const void **) keyframe_props_keys,
@@ -463,6 +503,11 @@ gst_vtenc_get_property (GObject * obj, guint prop_id, GValue * value,
       g_value_set_uint64 (value,
           gst_vtenc_get_max_keyframe_interval_duration (self));
       break;
+    case PROP_LOW_LATENCY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->low_latency);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -495,6 +540,12 @@ gst_vtenc_set_property (GObject * obj, guint prop_id, const GValue * value,
       gst_vtenc_set_max_keyframe_interval_duration (self,
           g_value_get_uint64 (value));
       break;
+    case PROP_LOW_LATENCY:
+      /* Part of the encoder specification, used for the next session */
+      GST_OBJECT_LOCK (self);
+      self->low_latency = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -821,20 +872,186 @@ gst_vtenc_flush (GstVideoEncoder * enc)
   return (ret == GST_FLOW_OK);
 }
 
+static OSType
+gst_vtenc_get_pixel_format_type (GstVideoFormat format)
+{
+  switch (format) {
+    case GST_VIDEO_FORMAT_I420:
+      return kCVPixelFormatType_420YpCbCr8Planar;
+    case GST_VIDEO_FORMAT_NV12:
+      return kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange;
+    case GST_VIDEO_FORMAT_UYVY:
+      return kCVPixelFormatType_422YpCbCr8;
+    default:
+      return 0;
+  }
+}
+
+static gboolean
+gst_vtenc_buffer_pool_set_config (GstBufferPool * pool, GstStructure * config)
+{
+  GstVTEncBufferPool *self = (GstVTEncBufferPool *) pool;
+  GstCaps *caps = NULL;
+
+  if (!gst_buffer_pool_config_get_params (config, &caps, NULL, NULL, NULL)
+      || !caps || !gst_video_info_from_caps (&self->info, caps)) {
+    GST_WARNING_OBJECT (pool, "invalid caps in config");
+    return FALSE;
+  }
+
+  return
+      GST_BUFFER_POOL_CLASS (gst_vtenc_buffer_pool_parent_class)->set_config
+      (pool, config);
+}
+
+static gboolean
+gst_vtenc_buffer_pool_start (GstBufferPool * pool)
+{
+  /* Nothing to preallocate, the pixel buffer pool does that */
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_vtenc_buffer_pool_acquire_buffer (GstBufferPool * pool,
+    GstBuffer ** buffer, GstBufferPoolAcquireParams * params)
+{
+  GstVTEncBufferPool *self = (GstVTEncBufferPool *) pool;
+  CVPixelBufferRef pbuf = NULL;
+  CVReturn cv_ret;
+
+  cv_ret = CVPixelBufferPoolCreatePixelBuffer (NULL, self->cv_pool, &pbuf);
+  if (cv_ret != kCVReturnSuccess) {
+    GST_ERROR_OBJECT (pool, "CVPixelBufferPoolCreatePixelBuffer() returned: %d",
+        (int) cv_ret);
+    return GST_FLOW_ERROR;
+  }
+
+  *buffer = gst_core_video_buffer_new ((CVBufferRef) pbuf, &self->info, NULL);
+  CVPixelBufferRelease (pbuf);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_vtenc_buffer_pool_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  /* Gives the pixel buffer back to the pixel buffer pool, unless the
+   * encoder still holds it */
+  gst_buffer_unref (buffer);
+}
+
+static void
+gst_vtenc_buffer_pool_finalize (GObject * object)
+{
+  GstVTEncBufferPool *self = (GstVTEncBufferPool *) object;
+
+  CVPixelBufferPoolRelease (self->cv_pool);
+
+  G_OBJECT_CLASS (gst_vtenc_buffer_pool_parent_class)->finalize (object);
+}
+
+static void
+gst_vtenc_buffer_pool_class_init (GstVTEncBufferPoolClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstBufferPoolClass *pool_class = (GstBufferPoolClass *) klass;
+
+  gobject_class->finalize = gst_vtenc_buffer_pool_finalize;
+
+  pool_class->set_config = gst_vtenc_buffer_pool_set_config;
+  pool_class->start = gst_vtenc_buffer_pool_start;
+  pool_class->acquire_buffer = gst_vtenc_buffer_pool_acquire_buffer;
+  pool_class->release_buffer = gst_vtenc_buffer_pool_release_buffer;
+}
+
+static void
+gst_vtenc_buffer_pool_init (GstVTEncBufferPool * self)
+{
+}
+
+static GstBufferPool *
+gst_vtenc_buffer_pool_new (CVPixelBufferPoolRef cv_pool)
+{
+  GstVTEncBufferPool *pool;
+
+  pool = g_object_new (gst_vtenc_buffer_pool_get_type (), NULL);
+  gst_object_ref_sink (pool);
+  pool->cv_pool = CVPixelBufferPoolRetain (cv_pool);
+
+  return GST_BUFFER_POOL_CAST (pool);
+}
+
+static gboolean
+gst_vtenc_propose_allocation (GstVideoEncoder * enc, GstQuery * query)
+{
+  GstVTEnc *self = GST_VTENC_CAST (enc);
+  CVPixelBufferPoolRef cv_pool = NULL;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstCaps *caps;
+  gboolean need_pool;
+
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+  if (!caps || !need_pool)
+    goto done;
+
+  GST_OBJECT_LOCK (self);
+  if (self->session)
+    cv_pool = VTCompressionSessionGetPixelBufferPool (self->session);
+  if (cv_pool)
+    CVPixelBufferPoolRetain (cv_pool);
+  GST_OBJECT_UNLOCK (self);
+
+  if (!cv_pool) {
+    GST_DEBUG_OBJECT (self, "no pixel buffer pool to propose");
+    goto done;
+  }
+
+  pool = gst_vtenc_buffer_pool_new (cv_pool);
+  CVPixelBufferPoolRelease (cv_pool);
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps,
+      GST_VIDEO_INFO_SIZE (&self->video_info), 0, 0);
+  gst_buffer_pool_config_add_option (config,
+      GST_BUFFER_POOL_OPTION_VIDEO_META);
+  if (gst_buffer_pool_set_config (pool, config)) {
+    GST_DEBUG_OBJECT (self, "proposing the pixel buffer pool of the session");
+    gst_query_add_allocation_pool (query, pool,
+        GST_VIDEO_INFO_SIZE (&self->video_info), 0, 0);
+  } else {
+    GST_WARNING_OBJECT (self, "failed to configure the buffer pool");
+  }
+  gst_object_unref (pool);
+
+done:
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->propose_allocation (enc,
+      query);
+}
+
 static VTCompressionSessionRef
 gst_vtenc_create_session (GstVTEnc * self)
 {
   VTCompressionSessionRef session = NULL;
-  CFMutableDictionaryRef encoder_spec = NULL, pb_attrs;
+  CFMutableDictionaryRef encoder_spec, pb_attrs, io_surface_props;
+  OSType pixel_format_type;
+  gboolean low_latency;
   OSStatus status;
-
 #if !HAVE_IOS
   const GstVTEncoderDetails *codec_details =
       GST_VTENC_CLASS_GET_CODEC_DETAILS (G_OBJECT_GET_CLASS (self));
+#endif
+
+  GST_OBJECT_LOCK (self);
+  low_latency = self->low_latency;
+  GST_OBJECT_UNLOCK (self);
 
   encoder_spec =
       CFDictionaryCreateMutable (NULL, 0, &kCFTypeDictionaryKeyCallBacks,
       &kCFTypeDictionaryValueCallBacks);
+#if !HAVE_IOS
   gst_vtutil_dict_set_boolean (encoder_spec,
       kVTVideoEncoderSpecification_EnableHardwareAcceleratedVideoEncoder, true);
   if (codec_details->require_hardware)
@@ -842,13 +1059,28 @@ gst_vtenc_create_session (GstVTEnc * self)
         kVTVideoEncoderSpecification_RequireHardwareAcceleratedVideoEncoder,
         TRUE);
 #endif
+  if (low_latency)
+    gst_vtutil_dict_set_boolean (encoder_spec,
+        VTENC_ENABLE_LOW_LATENCY_RATE_CONTROL, TRUE);
 
+  /* The pixel buffer pool of the session, proposed upstream, only hands out
+   * IOSurface backed buffers in the input format */
   pb_attrs = CFDictionaryCreateMutable (NULL, 0, &kCFTypeDictionaryKeyCallBacks,
       &kCFTypeDictionaryValueCallBacks);
   gst_vtutil_dict_set_i32 (pb_attrs, kCVPixelBufferWidthKey,
       self->negotiated_width);
   gst_vtutil_dict_set_i32 (pb_attrs, kCVPixelBufferHeightKey,
       self->negotiated_height);
+  pixel_format_type =
+      gst_vtenc_get_pixel_format_type (GST_VIDEO_INFO_FORMAT
+      (&self->video_info));
+  if (pixel_format_type)
+    gst_vtutil_dict_set_i32 (pb_attrs, kCVPixelBufferPixelFormatTypeKey,
+        pixel_format_type);
+  io_surface_props = CFDictionaryCreateMutable (NULL, 0,
+      &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+  gst_vtutil_dict_set_object (pb_attrs, kCVPixelBufferIOSurfacePropertiesKey,
+      (CFTypeRef *) io_surface_props);
 
   status = VTCompressionSessionCreate (NULL,
       self->negotiated_width, self->negotiated_height,
@@ -884,8 +1116,9 @@ gst_vtenc_create_session (GstVTEnc * self)
       gst_vtenc_get_bitrate (self));
   gst_vtenc_session_configure_realtime (self, session,
       gst_vtenc_get_realtime (self));
+  /* The low latency rate control does not support frame reordering */
   gst_vtenc_session_configure_allow_frame_reordering (self, session,
-      gst_vtenc_get_allow_frame_reordering (self));
+      gst_vtenc_get_allow_frame_reordering (self) && !low_latency);
   gst_vtenc_set_quality (self, self->quality);
 
   if (self->dump_properties) {
@@ -904,8 +1137,7 @@ gst_vtenc_create_session (GstVTEnc * self)
 #endif
 
 beach:
-  if (encoder_spec)
-    CFRelease (encoder_spec);
+  CFRelease (encoder_spec);
   CFRelease (pb_attrs);
 
   return session;
@@ -1136,6 +1368,13 @@ gst_vtenc_encode_frame (GstVTEnc * self, GstVideoCodecFrame * frame)
   meta = gst_buffer_get_core_media_meta (frame->input_buffer);
   if (meta != NULL) {
     pbuf = gst_core_media_buffer_get_pixel_buffer (frame->input_buffer);
+  } else {
+    GstCoreVideoMeta *cv_meta;
+
+    /* Buffers from our own pool, or any other CVPixelBuffer */
+    cv_meta = gst_buffer_get_core_video_meta (frame->input_buffer);
+    if (cv_meta != NULL && cv_meta->pixbuf != NULL)
+      pbuf = CVPixelBufferRetain (cv_meta->pixbuf);
   }
 #ifdef HAVE_IOS
   if (pbuf == NULL) {
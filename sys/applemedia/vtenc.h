@@ -65,6 +65,7 @@ struct _GstVTEnc
   gdouble quality;
   gint max_keyframe_interval;
   GstClockTime max_keyframe_interval_duration;
+  gboolean low_latency;
   gint latency_frames;
 
   gboolean dump_properties;
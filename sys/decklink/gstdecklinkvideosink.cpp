@@ -114,6 +114,232 @@ private:
   gint m_refcount;
 };
 
+class GStreamerTimecode:public IDeckLinkTimecode
+{
+public:
+  GStreamerTimecode (const GstVideoTimeCode * tc)
+  :IDeckLinkTimecode (), m_refcount (1)
+  {
+    gst_video_time_code_init (&m_tc, tc->config.fps_n, tc->config.fps_d,
+        tc->config.latest_daily_jam, tc->config.flags, tc->hours, tc->minutes,
+        tc->seconds, tc->frames, tc->field_count);
+    m_str = gst_video_time_code_to_string (&m_tc);
+  }
+
+  virtual HRESULT WINAPI QueryInterface (REFIID, LPVOID *)
+  {
+    return E_NOINTERFACE;
+  }
+
+  virtual ULONG WINAPI AddRef (void)
+  {
+    return g_atomic_int_add (&m_refcount, 1) + 1;
+  }
+
+  virtual ULONG WINAPI Release (void)
+  {
+    if (g_atomic_int_dec_and_test (&m_refcount)) {
+      delete this;
+      return 0;
+    }
+
+    return 1;
+  }
+
+  virtual BMDTimecodeBCD WINAPI GetBCD (void)
+  {
+    return (to_bcd (m_tc.hours) << 24) | (to_bcd (m_tc.minutes) << 16) |
+        (to_bcd (m_tc.seconds) << 8) | to_bcd (m_tc.frames);
+  }
+
+  virtual HRESULT WINAPI GetComponents (uint8_t * hours, uint8_t * minutes,
+      uint8_t * seconds, uint8_t * frames)
+  {
+    *hours = m_tc.hours;
+    *minutes = m_tc.minutes;
+    *seconds = m_tc.seconds;
+    *frames = m_tc.frames;
+
+    return S_OK;
+  }
+
+  virtual HRESULT WINAPI GetString (COMSTR_T * timecode)
+  {
+#ifdef G_OS_WIN32
+    /* the driver uses the components, not the string */
+    return E_NOTIMPL;
+#else
+    *timecode = m_str;
+
+    return S_OK;
+#endif
+  }
+
+  virtual BMDTimecodeFlags WINAPI GetFlags (void)
+  {
+    BMDTimecodeFlags flags = bmdTimecodeFlagDefault;
+
+    if (m_tc.config.flags & GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME)
+      flags = (BMDTimecodeFlags) (flags | bmdTimecodeIsDropFrame);
+    if (m_tc.field_count == 2)
+      flags = (BMDTimecodeFlags) (flags | bmdTimecodeFieldMark);
+
+    return flags;
+  }
+
+  virtual HRESULT WINAPI GetTimecodeUserBits (BMDTimecodeUserBits * userBits)
+  {
+    *userBits = 0;
+
+    return S_OK;
+  }
+
+  virtual ~ GStreamerTimecode () {
+    g_free (m_str);
+    gst_video_time_code_clear (&m_tc);
+  }
+
+private:
+  static guint32 to_bcd (guint value)
+  {
+    return ((value / 10) << 4) | (value % 10);
+  }
+
+  GstVideoTimeCode m_tc;
+  gchar *m_str;
+  gint m_refcount;
+};
+
+/* A video frame playing out straight from the memory of a GstBuffer, which
+ * stays mapped until the driver releases the frame */
+class GStreamerVideoFrame:public IDeckLinkVideoFrame
+{
+public:
+  static GStreamerVideoFrame *wrap (GstBuffer * buffer, GstVideoInfo * info,
+      BMDPixelFormat format, BMDTimecodeFormat timecode_format)
+  {
+    GStreamerVideoFrame *frame = new GStreamerVideoFrame (format);
+    GstVideoTimeCodeMeta *tc_meta;
+
+    if (!gst_video_frame_map (&frame->m_vframe, info, buffer, GST_MAP_READ)) {
+      delete frame;
+      return NULL;
+    }
+    frame->m_mapped = TRUE;
+
+    /* the driver takes the row size of the negotiated format */
+    if (GST_VIDEO_FRAME_PLANE_STRIDE (&frame->m_vframe, 0) !=
+        GST_VIDEO_INFO_PLANE_STRIDE (info, 0)) {
+      delete frame;
+      return NULL;
+    }
+
+    tc_meta = gst_buffer_get_video_time_code_meta (buffer);
+    if (tc_meta) {
+      frame->m_timecode = new GStreamerTimecode (&tc_meta->tc);
+      frame->m_timecode_format = timecode_format;
+    }
+
+    return frame;
+  }
+
+  virtual HRESULT WINAPI QueryInterface (REFIID, LPVOID *)
+  {
+    return E_NOINTERFACE;
+  }
+
+  virtual ULONG WINAPI AddRef (void)
+  {
+    return g_atomic_int_add (&m_refcount, 1) + 1;
+  }
+
+  virtual ULONG WINAPI Release (void)
+  {
+    if (g_atomic_int_dec_and_test (&m_refcount)) {
+      delete this;
+      return 0;
+    }
+
+    return 1;
+  }
+
+  virtual long WINAPI GetWidth (void)
+  {
+    return GST_VIDEO_FRAME_WIDTH (&m_vframe);
+  }
+
+  virtual long WINAPI GetHeight (void)
+  {
+    return GST_VIDEO_FRAME_HEIGHT (&m_vframe);
+  }
+
+  virtual long WINAPI GetRowBytes (void)
+  {
+    return GST_VIDEO_FRAME_PLANE_STRIDE (&m_vframe, 0);
+  }
+
+  virtual BMDPixelFormat WINAPI GetPixelFormat (void)
+  {
+    return m_format;
+  }
+
+  virtual BMDFrameFlags WINAPI GetFlags (void)
+  {
+    return bmdFrameFlagDefault;
+  }
+
+  virtual HRESULT WINAPI GetBytes (void **buffer)
+  {
+    *buffer = GST_VIDEO_FRAME_PLANE_DATA (&m_vframe, 0);
+
+    return S_OK;
+  }
+
+  virtual HRESULT WINAPI GetTimecode (BMDTimecodeFormat format,
+      IDeckLinkTimecode ** timecode)
+  {
+    if (!m_timecode || format != m_timecode_format) {
+      *timecode = NULL;
+      return S_FALSE;
+    }
+
+    m_timecode->AddRef ();
+    *timecode = m_timecode;
+
+    return S_OK;
+  }
+
+  virtual HRESULT WINAPI GetAncillaryData (IDeckLinkVideoFrameAncillary **
+      ancillary)
+  {
+    *ancillary = NULL;
+
+    return S_FALSE;
+  }
+
+private:
+  GStreamerVideoFrame (BMDPixelFormat format)
+  :IDeckLinkVideoFrame (), m_format (format), m_mapped (FALSE),
+      m_timecode (NULL), m_timecode_format (bmdTimecodeRP188Any),
+      m_refcount (1)
+  {
+  }
+
+  virtual ~ GStreamerVideoFrame () {
+    if (m_timecode)
+      m_timecode->Release ();
+    if (m_mapped)
+      gst_video_frame_unmap (&m_vframe);
+  }
+
+  GstVideoFrame m_vframe;
+  BMDPixelFormat m_format;
+  gboolean m_mapped;
+  GStreamerTimecode *m_timecode;
+  BMDTimecodeFormat m_timecode_format;
+  gint m_refcount;
+};
+
 enum
 {
   PROP_0,
@@ -607,7 +833,8 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
 {
   GstDecklinkVideoSink *self = GST_DECKLINK_VIDEO_SINK_CAST (bsink);
   GstVideoFrame vframe;
-  IDeckLinkMutableVideoFrame *frame;
+  IDeckLinkVideoFrame *frame;
+  IDeckLinkMutableVideoFrame *mutable_frame;
   guint8 *outdata, *indata;
   GstFlowReturn flow_ret;
   HRESULT ret;
@@ -667,14 +894,24 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
   else
     running_time = 0;
 
+  /* buffers with the row size of the negotiated format are played out from
+   * their own memory */
+  frame = GStreamerVideoFrame::wrap (buffer, &self->info, format,
+      self->timecode_format);
+  if (frame) {
+    GST_LOG_OBJECT (self, "Playing out buffer %p without a copy", buffer);
+    goto schedule;
+  }
+
   ret = self->output->output->CreateVideoFrame (self->info.width,
       self->info.height, self->info.stride[0], format, bmdFrameFlagDefault,
-      &frame);
+      &mutable_frame);
   if (ret != S_OK) {
     GST_ELEMENT_ERROR (self, STREAM, FAILED,
         (NULL), ("Failed to create video frame: 0x%08lx", (unsigned long) ret));
     return GST_FLOW_ERROR;
   }
+  frame = mutable_frame;
 
   if (!gst_video_frame_map (&vframe, &self->info, buffer, GST_MAP_READ)) {
     GST_ERROR_OBJECT (self, "Failed to map video frame");
@@ -682,14 +919,14 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
     goto out;
   }
 
-  frame->GetBytes ((void **) &outdata);
+  mutable_frame->GetBytes ((void **) &outdata);
   indata = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0);
-  stride =
-      MIN (GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0), frame->GetRowBytes ());
+  stride = MIN (GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0),
+      mutable_frame->GetRowBytes ());
   for (i = 0; i < self->info.height; i++) {
     memcpy (outdata, indata, stride);
     indata += GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0);
-    outdata += frame->GetRowBytes ();
+    outdata += mutable_frame->GetRowBytes ();
   }
   gst_video_frame_unmap (&vframe);
 
@@ -707,7 +944,7 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
       bflags = (BMDTimecodeFlags) (bflags | bmdTimecodeFieldMark);
 
     tc_str = gst_video_time_code_to_string (&tc_meta->tc);
-    ret = frame->SetTimecodeFromComponents (self->timecode_format,
+    ret = mutable_frame->SetTimecodeFromComponents (self->timecode_format,
         (uint8_t) tc_meta->tc.hours,
         (uint8_t) tc_meta->tc.minutes,
         (uint8_t) tc_meta->tc.seconds, (uint8_t) tc_meta->tc.frames, bflags);
@@ -723,6 +960,7 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
     g_free (tc_str);
   }
 
+schedule:
   convert_to_internal_clock (self, &running_time, &running_time_duration);
 
   if (!self->output->started) {
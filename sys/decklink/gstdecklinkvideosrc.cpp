@@ -35,6 +35,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_decklink_video_src_debug);
 #define DEFAULT_OUTPUT_STREAM_TIME (FALSE)
 #define DEFAULT_SKIP_FIRST_TIME (0)
 #define DEFAULT_DROP_NO_SIGNAL_FRAMES (FALSE)
+#define DEFAULT_TIME_MAPPING_WINDOW (64)
 
 enum
 {
@@ -49,7 +50,9 @@ enum
   PROP_SKIP_FIRST_TIME,
   PROP_DROP_NO_SIGNAL_FRAMES,
   PROP_SIGNAL,
-  PROP_HW_SERIAL_NUMBER
+  PROP_HW_SERIAL_NUMBER,
+  PROP_TIME_MAPPING_WINDOW,
+  PROP_STATS
 };
 
 typedef struct
@@ -217,6 +220,24 @@ gst_decklink_video_src_class_init (GstDecklinkVideoSrcClass * klass)
           "The serial number (hardware ID) of the Decklink card",
           NULL, (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 
+  g_object_class_install_property (gobject_class, PROP_TIME_MAPPING_WINDOW,
+      g_param_spec_uint ("time-mapping-window", "Time mapping window",
+          "Number of frames the mapping of the hardware times to the "
+          "pipeline clock is calculated over. Larger windows filter more "
+          "of the capture jitter when the pipeline clock is a stable "
+          "network clock such as a GstPtpClock",
+          16, 4096, DEFAULT_TIME_MAPPING_WINDOW,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Time mapping statistics: \"skew\" of the hardware clock against "
+          "the pipeline clock in ppm, the smoothed \"jitter\" and the "
+          "\"max-jitter\" in nanoseconds of the capture times around the "
+          "mapping, and the \"r-squared\" of the last regression",
+          GST_TYPE_STRUCTURE,
+          (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+
   templ_caps = gst_decklink_mode_get_template_caps (TRUE);
   gst_element_class_add_pad_template (element_class,
       gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS, templ_caps));
@@ -246,7 +267,8 @@ gst_decklink_video_src_init (GstDecklinkVideoSrc * self)
   self->skip_first_time = DEFAULT_SKIP_FIRST_TIME;
   self->drop_no_signal_frames = DEFAULT_DROP_NO_SIGNAL_FRAMES;
 
-  self->window_size = 64;
+  self->time_mapping_window = DEFAULT_TIME_MAPPING_WINDOW;
+  self->window_size = self->time_mapping_window;
   self->times = g_new (GstClockTime, 4 * self->window_size);
   self->times_temp = self->times + 2 * self->window_size;
   self->window_fill = 0;
@@ -321,6 +343,12 @@ gst_decklink_video_src_set_property (GObject * object, guint property_id,
     case PROP_DROP_NO_SIGNAL_FRAMES:
       self->drop_no_signal_frames = g_value_get_boolean (value);
       break;
+    case PROP_TIME_MAPPING_WINDOW:
+      /* takes effect when the streams are started next */
+      g_mutex_lock (&self->lock);
+      self->time_mapping_window = g_value_get_uint (value);
+      g_mutex_unlock (&self->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -371,6 +399,22 @@ gst_decklink_video_src_get_property (GObject * object, guint property_id,
       else
         g_value_set_string (value, NULL);
       break;
+    case PROP_TIME_MAPPING_WINDOW:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->time_mapping_window);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_STATS:
+      g_mutex_lock (&self->lock);
+      g_value_take_boxed (value, gst_structure_new ("stats",
+              "skew", G_TYPE_DOUBLE,
+              (((gdouble) self->current_time_mapping.num) /
+                  self->current_time_mapping.den - 1.0) * 1e6,
+              "jitter", G_TYPE_UINT64, self->jitter,
+              "max-jitter", G_TYPE_UINT64, self->max_jitter,
+              "r-squared", G_TYPE_DOUBLE, self->r_squared, NULL));
+      g_mutex_unlock (&self->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -582,6 +626,7 @@ gst_decklink_video_src_update_time_mapping (GstDecklinkVideoSrc * self,
       self->next_time_mapping.num = num;
       self->next_time_mapping.den = den;
       self->next_time_mapping_pending = TRUE;
+      self->r_squared = r_squared;
     }
   } else {
     self->window_skip_count++;
@@ -636,6 +681,30 @@ gst_decklink_video_src_update_time_mapping (GstDecklinkVideoSrc * self,
   }
 }
 
+/* How far the capture times are from the mapping, smoothed like the RTP
+ * interarrival jitter */
+static void
+gst_decklink_video_src_update_jitter (GstDecklinkVideoSrc * self,
+    GstClockTime capture_time, GstClockTime mapped_time)
+{
+  GstClockTime deviation;
+
+  /* the first mapping is only a rough start */
+  if (!self->window_filled)
+    return;
+
+  if (capture_time > mapped_time)
+    deviation = capture_time - mapped_time;
+  else
+    deviation = mapped_time - capture_time;
+
+  if (deviation > self->jitter)
+    self->jitter += (deviation - self->jitter) / 16;
+  else
+    self->jitter -= (self->jitter - deviation) / 16;
+  self->max_jitter = MAX (self->max_jitter, deviation);
+}
+
 static void
 gst_decklink_video_src_got_frame (GstElement * element,
     IDeckLinkVideoInputFrame * frame, GstDecklinkModeEnum mode,
@@ -669,14 +738,15 @@ gst_decklink_video_src_got_frame (GstElement * element,
   }
 
   gst_decklink_video_src_update_time_mapping (self, capture_time, stream_time);
+  timestamp =
+      gst_clock_adjust_with_calibration (NULL, stream_time,
+      self->current_time_mapping.xbase, self->current_time_mapping.b,
+      self->current_time_mapping.num, self->current_time_mapping.den);
+  gst_decklink_video_src_update_jitter (self, capture_time, timestamp);
   if (self->output_stream_time) {
     timestamp = stream_time;
     duration = stream_duration;
   } else {
-    timestamp =
-        gst_clock_adjust_with_calibration (NULL, stream_time,
-        self->current_time_mapping.xbase, self->current_time_mapping.b,
-        self->current_time_mapping.num, self->current_time_mapping.den);
     duration =
         gst_util_uint64_scale (stream_duration, self->current_time_mapping.num,
         self->current_time_mapping.den);
@@ -1047,6 +1117,15 @@ gst_decklink_video_src_start_streams (GstElement * element)
 
     g_mutex_lock (&self->lock);
     self->first_time = GST_CLOCK_TIME_NONE;
+    if (self->window_size != self->time_mapping_window) {
+      self->window_size = self->time_mapping_window;
+      g_free (self->times);
+      self->times = g_new (GstClockTime, 4 * self->window_size);
+      self->times_temp = self->times + 2 * self->window_size;
+    }
+    self->jitter = 0;
+    self->max_jitter = 0;
+    self->r_squared = 0.0;
     self->window_fill = 0;
     self->window_filled = FALSE;
     self->window_skip = 1;
@@ -90,6 +90,11 @@ struct _GstDecklinkVideoSrc
     GstClockTime num, den;
   } next_time_mapping;
   gboolean next_time_mapping_pending;
+
+  guint time_mapping_window;
+  /* statistics of the time mapping */
+  GstClockTime jitter, max_jitter;
+  gdouble r_squared;
 };
 
 struct _GstDecklinkVideoSrcClass
@@ -42,6 +42,9 @@
  * |[
  *  gst-launch-1.0 dvbsrc frequency=503000000 delsys="atsc" modulation="8vsb" pids=48:49:52 ! decodebin name=dec dec. ! videoconvert ! autovideosink dec. ! audioconvert ! autoaudiosink
  * ]| Captures and renders KOFY-HD in San Jose, California. This is an ATSC broadcast, PMT ID 48, Audio/Video elementary stream PIDs 49 and 52 respectively.
+ * |[
+ * gst-launch-1.0 dvbsrc frequency=514000000 demux-tap=true pids=100:256:257 ! queue ! filesink location=prog1.ts  dvbsrc frequency=514000000 demux-tap=true pids=200:356:357 ! queue ! filesink location=prog2.ts
+ * ]| Records two programs of the same multiplex from a single DVB card. With #GstDvbSrc:demux-tap each element reads only its own PIDs, filtered by the demux hardware, and the second element shares the frontend tuned by the first one.
  *
  */
 
@@ -98,6 +101,7 @@
 #include <gst/glib-compat-private.h>
 #include <sys/ioctl.h>
 #include <sys/poll.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <stdio.h>
@@ -110,6 +114,11 @@
 #include <linux/dvb/frontend.h>
 #include <linux/dvb/dmx.h>
 
+/* memory mapped DVR buffers, since Linux 4.16 */
+#ifdef DMX_REQBUFS
+#define HAVE_DVB_MMAP 1
+#endif
+
 #include <gst/gst-i18n-plugin.h>
 
 /* Before 5.6 we map A to AC */
@@ -198,7 +207,11 @@ enum
   ARG_DVBSRC_LNB_SLOF,
   ARG_DVBSRC_LNB_LOF1,
   ARG_DVBSRC_LNB_LOF2,
-  ARG_DVBSRC_INTERLEAVING
+  ARG_DVBSRC_INTERLEAVING,
+  ARG_DVBSRC_DEMUX_TAP,
+  ARG_DVBSRC_OVERFLOWS,
+  ARG_DVBSRC_MAX_READ_LATENCY,
+  ARG_DVBSRC_MMAP
 };
 
 #define DEFAULT_ADAPTER 0
@@ -221,7 +234,11 @@ enum
 #define DEFAULT_TIMEOUT 1000000 /* 1 second */
 #define DEFAULT_TUNING_TIMEOUT 10 * GST_SECOND  /* 10 seconds */
 #define DEFAULT_DVB_BUFFER_SIZE (10*188*1024)   /* kernel default is 8192 */
-#define DEFAULT_BUFFER_SIZE 8192        /* not a property */
+#define DEFAULT_DEMUX_TAP FALSE
+#define DEFAULT_BUFFER_SIZE (TS_SIZE * 512)     /* not a property */
+#define MIN_READ_SIZE (TS_SIZE * 7)
+#define DEFAULT_MAX_READ_LATENCY 10000  /* 10 milliseconds */
+#define DEFAULT_MMAP FALSE
 #define DEFAULT_DELSYS SYS_UNDEFINED
 #define DEFAULT_PILOT PILOT_AUTO
 #define DEFAULT_ROLLOFF ROLLOFF_AUTO
@@ -255,6 +272,10 @@ enum
 
 static gboolean gst_dvbsrc_output_frontend_stats (GstDvbSrc * src,
     fe_status_t * status);
+#ifdef HAVE_DVB_MMAP
+static gboolean gst_dvbsrc_mmap_start (GstDvbSrc * object);
+static void gst_dvbsrc_mmap_stop (GstDvbSrc * object);
+#endif
 
 #define GST_TYPE_DVBSRC_CODE_RATE (gst_dvbsrc_code_rate_get_type ())
 static GType
@@ -969,6 +990,60 @@ gst_dvbsrc_class_init (GstDvbSrcClass * klass)
           GST_TYPE_INTERLEAVING, DEFAULT_INTERLEAVING,
           GST_PARAM_MUTABLE_PLAYING | G_PARAM_READWRITE));
 
+  /**
+   * GstDvbSrc:demux-tap:
+   *
+   * Read the selected PIDs from a demux device instead of the DVR device.
+   * The PIDs are filtered by the demux hardware into a stream of their own,
+   * so several elements can each capture different programs of the
+   * multiplex. If the frontend is already tuned by another element, it is
+   * shared instead of tuned again.
+   */
+  g_object_class_install_property (gobject_class, ARG_DVBSRC_DEMUX_TAP,
+      g_param_spec_boolean ("demux-tap", "Demux tap",
+          "Read the filtered PIDs from a demux device instead of the DVR "
+          "device", DEFAULT_DEMUX_TAP, G_PARAM_READWRITE));
+
+  /**
+   * GstDvbSrc:overflows:
+   *
+   * The number of times the kernel buffer of the device the stream is read
+   * from overflowed and packets were lost. Increasing
+   * #GstDvbSrc:dvb-buffer-size usually helps. Every overflow is also posted
+   * as a "dvb-overflow" element message with the current count in its
+   * "overflows" field.
+   */
+  g_object_class_install_property (gobject_class, ARG_DVBSRC_OVERFLOWS,
+      g_param_spec_uint ("overflows", "Overflows",
+          "Number of kernel buffer overflows of the device read from",
+          0, G_MAXUINT, 0, G_PARAM_READABLE));
+
+  /**
+   * GstDvbSrc:max-read-latency:
+   *
+   * The longest time in microseconds to wait for a buffer to fill up. The
+   * size of the reads follows the bitrate of the stream so that buffers are
+   * as large as possible within this bound.
+   */
+  g_object_class_install_property (gobject_class,
+      ARG_DVBSRC_MAX_READ_LATENCY,
+      g_param_spec_uint64 ("max-read-latency", "Maximum read latency",
+          "Microseconds a buffer may take to fill up", 0, G_MAXUINT64,
+          DEFAULT_MAX_READ_LATENCY,
+          GST_PARAM_MUTABLE_PLAYING | G_PARAM_READWRITE));
+
+  /**
+   * GstDvbSrc:mmap:
+   *
+   * Receive the stream in buffers memory mapped from the DVR device, which
+   * are pushed without copying them. This needs kernel support, when it is
+   * not available the device is read as usual.
+   */
+  g_object_class_install_property (gobject_class, ARG_DVBSRC_MMAP,
+      g_param_spec_boolean ("mmap", "mmap",
+          "Use memory mapped buffers of the DVR device", DEFAULT_MMAP,
+          G_PARAM_READWRITE));
+
   /**
    * GstDvbSrc::tuning-start:
    * @gstdvbsrc: the element on which the signal is emitted
@@ -1046,6 +1121,9 @@ gst_dvbsrc_init (GstDvbSrc * object)
   object->pids[0] = 8192;
   object->pids[1] = G_MAXUINT16;
   object->dvb_buffer_size = DEFAULT_DVB_BUFFER_SIZE;
+  object->demux_tap = DEFAULT_DEMUX_TAP;
+  object->max_read_latency = DEFAULT_MAX_READ_LATENCY;
+  object->mmap = DEFAULT_MMAP;
 
   adapter = g_getenv ("GST_DVB_ADAPTER");
   if (adapter)
@@ -1352,6 +1430,18 @@ gst_dvbsrc_set_property (GObject * _object, guint prop_id,
     case ARG_DVBSRC_INTERLEAVING:
       object->interleaving = g_value_get_enum (value);
       break;
+    case ARG_DVBSRC_DEMUX_TAP:
+      object->demux_tap = g_value_get_boolean (value);
+      break;
+    case ARG_DVBSRC_OVERFLOWS:
+      /* read-only */
+      break;
+    case ARG_DVBSRC_MAX_READ_LATENCY:
+      object->max_read_latency = g_value_get_uint64 (value);
+      break;
+    case ARG_DVBSRC_MMAP:
+      object->mmap = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -1524,6 +1614,18 @@ gst_dvbsrc_get_property (GObject * _object, guint prop_id,
     case ARG_DVBSRC_INTERLEAVING:
       g_value_set_enum (value, object->interleaving);
       break;
+    case ARG_DVBSRC_DEMUX_TAP:
+      g_value_set_boolean (value, object->demux_tap);
+      break;
+    case ARG_DVBSRC_OVERFLOWS:
+      g_value_set_uint (value, g_atomic_int_get (&object->overflows));
+      break;
+    case ARG_DVBSRC_MAX_READ_LATENCY:
+      g_value_set_uint64 (value, object->max_read_latency);
+      break;
+    case ARG_DVBSRC_MMAP:
+      g_value_set_boolean (value, object->mmap);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -1534,10 +1636,14 @@ gst_dvbsrc_close_devices (GstDvbSrc * object)
 {
   gst_dvbsrc_unset_pes_filters (object);
 
+#ifdef HAVE_DVB_MMAP
+  gst_dvbsrc_mmap_stop (object);
+#endif
   close (object->fd_dvr);
   object->fd_dvr = -1;
   close (object->fd_frontend);
   object->fd_frontend = -1;
+  object->shared_frontend = FALSE;
 
   return TRUE;
 }
@@ -1573,6 +1679,13 @@ gst_dvbsrc_open_frontend (GstDvbSrc * object, gboolean writable)
   /* open frontend */
   LOOP_WHILE_EINTR (object->fd_frontend,
       open (frontend_dev, writable ? O_RDWR : O_RDONLY));
+  if (object->fd_frontend < 0 && errno == EBUSY && writable &&
+      object->demux_tap) {
+    /* another reader owns the tuner, receive what it is tuned to */
+    GST_INFO_OBJECT (object, "Frontend busy, sharing it read-only");
+    LOOP_WHILE_EINTR (object->fd_frontend, open (frontend_dev, O_RDONLY));
+    object->shared_frontend = (object->fd_frontend >= 0);
+  }
   if (object->fd_frontend < 0) {
     switch (errno) {
       case ENOENT:
@@ -1782,12 +1895,16 @@ gst_dvbsrc_open_dvr (GstDvbSrc * object)
   gchar *dvr_dev;
   gint err;
 
-  dvr_dev = g_strdup_printf ("/dev/dvb/adapter%d/dvr%d",
-      object->adapter_number, object->frontend_number);
+  /* in demux tap mode the filtered stream is read from the demux device
+   * the PES filter is set on */
+  dvr_dev = g_strdup_printf (object->demux_tap ? "/dev/dvb/adapter%d/demux%d"
+      : "/dev/dvb/adapter%d/dvr%d", object->adapter_number,
+      object->frontend_number);
   GST_INFO_OBJECT (object, "Using DVR device: %s", dvr_dev);
 
   /* open DVR */
-  if ((object->fd_dvr = open (dvr_dev, O_RDONLY | O_NONBLOCK)) < 0) {
+  if ((object->fd_dvr = open (dvr_dev,
+              (object->demux_tap ? O_RDWR : O_RDONLY) | O_NONBLOCK)) < 0) {
     switch (errno) {
       case ENOENT:
         GST_ELEMENT_ERROR (object, RESOURCE, NOT_FOUND,
@@ -1812,6 +1929,10 @@ gst_dvbsrc_open_dvr (GstDvbSrc * object)
     GST_INFO_OBJECT (object, "ioctl DMX_SET_BUFFER_SIZE failed (%d)", errno);
     return FALSE;
   }
+
+  if (object->demux_tap)
+    gst_dvbsrc_set_pes_filters (object);
+
   return TRUE;
 }
 
@@ -1857,22 +1978,65 @@ gst_dvbsrc_plugin_init (GstPlugin * plugin)
       GST_TYPE_DVBSRC);
 }
 
+static void
+gst_dvbsrc_post_overflow (GstDvbSrc * object)
+{
+  guint overflows = g_atomic_int_add (&object->overflows, 1) + 1;
+
+  GST_WARNING_OBJECT (object, "Kernel buffer overflow, lost packets (%u)",
+      overflows);
+  gst_element_post_message (GST_ELEMENT_CAST (object),
+      gst_message_new_element (GST_OBJECT (object),
+          gst_structure_new ("dvb-overflow", "overflows", G_TYPE_UINT,
+              overflows, NULL)));
+}
+
+/* Sizes the next read to what arrives within max-read-latency at the rate
+ * the previous reads filled in */
+static void
+gst_dvbsrc_update_read_size (GstDvbSrc * object, gsize count,
+    GstClockTime elapsed)
+{
+  guint64 rate, size;
+
+  if (count == 0 || elapsed == 0)
+    return;
+
+  rate = gst_util_uint64_scale (count, GST_SECOND, elapsed);
+  if (object->byte_rate)
+    rate = (object->byte_rate * 7 + rate) / 8;
+  object->byte_rate = rate;
+
+  size = gst_util_uint64_scale (rate, object->max_read_latency,
+      G_USEC_PER_SEC);
+  size = CLAMP (size, MIN_READ_SIZE, DEFAULT_BUFFER_SIZE);
+  object->read_size = size - size % TS_SIZE;
+
+  GST_LOG_OBJECT (object, "%" G_GUINT64_FORMAT " bytes/s, reading %u bytes",
+      rate, object->read_size);
+}
+
 static GstFlowReturn
-gst_dvbsrc_read_device (GstDvbSrc * object, int size, GstBuffer ** buffer)
+gst_dvbsrc_read_device (GstDvbSrc * object, GstBuffer ** buffer)
 {
   gint count = 0;
   gint ret_val = 0;
-  GstBuffer *buf = gst_buffer_new_and_alloc (size);
+  GstBuffer *buf = NULL;
   GstClockTime timeout = object->timeout * GST_USECOND;
+  GstClockTime start;
+  GstFlowReturn flow_ret;
   GstMapInfo map;
 
-  g_return_val_if_fail (GST_IS_BUFFER (buf), GST_FLOW_ERROR);
-
   if (object->fd_dvr < 0)
     return GST_FLOW_ERROR;
 
+  flow_ret = gst_buffer_pool_acquire_buffer (object->pool, &buf, NULL);
+  if (G_UNLIKELY (flow_ret != GST_FLOW_OK))
+    return flow_ret;
+
+  start = gst_util_get_timestamp ();
   gst_buffer_map (buf, &map, GST_MAP_WRITE);
-  while (count < size) {
+  while (count < object->read_size) {
     ret_val = gst_poll_wait (object->poll, timeout);
     GST_LOG_OBJECT (object, "select returned %d", ret_val);
     if (G_UNLIKELY (ret_val < 0)) {
@@ -1888,9 +2052,13 @@ gst_dvbsrc_read_device (GstDvbSrc * object, int size, GstBuffer ** buffer)
           gst_message_new_element (GST_OBJECT (object),
               gst_structure_new_empty ("dvb-read-failure")));
     } else {
-      int nread = read (object->fd_dvr, map.data + count, size - count);
+      int nread = read (object->fd_dvr, map.data + count, map.size - count);
 
-      if (G_UNLIKELY (nread < 0)) {
+      if (G_UNLIKELY (nread < 0 && errno == EOVERFLOW)) {
+        /* the kernel buffer overflowed and packets were dropped, the next
+         * read returns the data that follows */
+        gst_dvbsrc_post_overflow (object);
+      } else if (G_UNLIKELY (nread < 0)) {
         GST_WARNING_OBJECT
             (object,
             "Unable to read from device: /dev/dvb/adapter%d/dvr%d (%d)",
@@ -1905,6 +2073,9 @@ gst_dvbsrc_read_device (GstDvbSrc * object, int size, GstBuffer ** buffer)
   gst_buffer_unmap (buf, &map);
   gst_buffer_resize (buf, 0, count);
 
+  gst_dvbsrc_update_read_size (object, count,
+      gst_util_get_timestamp () - start);
+
   *buffer = buf;
 
   return GST_FLOW_OK;
@@ -1926,10 +2097,223 @@ select_error:
   }
 }
 
+#ifdef HAVE_DVB_MMAP
+/* The buffers mapped from the device. They stay mapped until the last
+ * buffer pushed out of them is released, which can be after stop */
+struct _GstDvbSrcMmap
+{
+  gint refcount;
+  gint fd;
+  gint streaming;
+
+  guint n_buffers;
+  gpointer *data;
+  gsize *length;
+};
+
+typedef struct
+{
+  GstDvbSrcMmap *dvb_mmap;
+  guint index;
+} GstDvbSrcMmapBuffer;
+
+static void
+gst_dvbsrc_mmap_unref (GstDvbSrcMmap * dvb_mmap)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&dvb_mmap->refcount))
+    return;
+
+  for (i = 0; i < dvb_mmap->n_buffers; i++) {
+    if (dvb_mmap->data[i])
+      munmap (dvb_mmap->data[i], dvb_mmap->length[i]);
+  }
+  close (dvb_mmap->fd);
+  g_free (dvb_mmap->data);
+  g_free (dvb_mmap->length);
+  g_slice_free (GstDvbSrcMmap, dvb_mmap);
+}
+
+static gboolean
+gst_dvbsrc_mmap_queue (GstDvbSrcMmap * dvb_mmap, guint index)
+{
+  struct dmx_buffer dmx_buf = { 0, };
+  gint err;
+
+  dmx_buf.index = index;
+  LOOP_WHILE_EINTR (err, ioctl (dvb_mmap->fd, DMX_QBUF, &dmx_buf));
+
+  return err == 0;
+}
+
+/* Gives the memory of a pushed buffer back to the device */
+static void
+gst_dvbsrc_mmap_buffer_release (gpointer user_data)
+{
+  GstDvbSrcMmapBuffer *mmap_buf = user_data;
+
+  if (g_atomic_int_get (&mmap_buf->dvb_mmap->streaming))
+    gst_dvbsrc_mmap_queue (mmap_buf->dvb_mmap, mmap_buf->index);
+  gst_dvbsrc_mmap_unref (mmap_buf->dvb_mmap);
+  g_slice_free (GstDvbSrcMmapBuffer, mmap_buf);
+}
+
+static gboolean
+gst_dvbsrc_mmap_start (GstDvbSrc * object)
+{
+  struct dmx_requestbuffers req = { 0, };
+  GstDvbSrcMmap *dvb_mmap;
+  guint i;
+  gint err;
+
+  req.count = MAX (object->dvb_buffer_size / DEFAULT_BUFFER_SIZE, 2);
+  req.size = DEFAULT_BUFFER_SIZE;
+  LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_REQBUFS, &req));
+  if (err || req.count == 0) {
+    GST_INFO_OBJECT (object, "No memory mapped buffers (%d), reading the "
+        "device instead", errno);
+    return FALSE;
+  }
+
+  dvb_mmap = g_slice_new0 (GstDvbSrcMmap);
+  dvb_mmap->refcount = 1;
+  dvb_mmap->fd = dup (object->fd_dvr);
+  dvb_mmap->streaming = TRUE;
+  dvb_mmap->n_buffers = req.count;
+  dvb_mmap->data = g_new0 (gpointer, req.count);
+  dvb_mmap->length = g_new0 (gsize, req.count);
+
+  for (i = 0; i < req.count; i++) {
+    struct dmx_buffer dmx_buf = { 0, };
+    gpointer data;
+
+    dmx_buf.index = i;
+    LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_QUERYBUF, &dmx_buf));
+    if (err)
+      goto failed;
+
+    data = mmap (NULL, dmx_buf.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+        object->fd_dvr, dmx_buf.offset);
+    if (data == MAP_FAILED)
+      goto failed;
+    dvb_mmap->data[i] = data;
+    dvb_mmap->length[i] = dmx_buf.length;
+
+    if (!gst_dvbsrc_mmap_queue (dvb_mmap, i))
+      goto failed;
+  }
+
+  GST_INFO_OBJECT (object, "Using %u memory mapped buffers of %u bytes",
+      req.count, req.size);
+  object->dvb_mmap = dvb_mmap;
+  object->mmap_count_valid = FALSE;
+
+  return TRUE;
+
+failed:
+  {
+    GST_WARNING_OBJECT (object, "Could not map DVR buffer %u: %s", i,
+        g_strerror (errno));
+    dvb_mmap->streaming = FALSE;
+    gst_dvbsrc_mmap_unref (dvb_mmap);
+    return FALSE;
+  }
+}
+
+static void
+gst_dvbsrc_mmap_stop (GstDvbSrc * object)
+{
+  if (!object->dvb_mmap)
+    return;
+
+  g_atomic_int_set (&object->dvb_mmap->streaming, FALSE);
+  gst_dvbsrc_mmap_unref (object->dvb_mmap);
+  object->dvb_mmap = NULL;
+}
+
+static GstFlowReturn
+gst_dvbsrc_read_mmap (GstDvbSrc * object, GstBuffer ** buffer)
+{
+  GstDvbSrcMmap *dvb_mmap = object->dvb_mmap;
+  GstClockTime timeout = object->timeout * GST_USECOND;
+  GstDvbSrcMmapBuffer *mmap_buf;
+  struct dmx_buffer dmx_buf;
+  gint ret_val, err;
+
+  while (TRUE) {
+    ret_val = gst_poll_wait (object->poll, timeout);
+    GST_LOG_OBJECT (object, "select returned %d", ret_val);
+    if (G_UNLIKELY (ret_val < 0)) {
+      if (errno == EBUSY)
+        goto stopped;
+      else if (errno == EINTR)
+        continue;
+      else
+        goto select_error;
+    } else if (G_UNLIKELY (!ret_val)) {
+      /* timeout, post element message */
+      gst_element_post_message (GST_ELEMENT_CAST (object),
+          gst_message_new_element (GST_OBJECT (object),
+              gst_structure_new_empty ("dvb-read-failure")));
+      continue;
+    }
+
+    memset (&dmx_buf, 0, sizeof (dmx_buf));
+    LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_DQBUF, &dmx_buf));
+    if (G_UNLIKELY (err && errno == EAGAIN))
+      continue;
+    else if (G_UNLIKELY (err))
+      goto dequeue_error;
+
+    /* the kernel counts the buffers it filled, also the ones it had to drop
+     * because all buffers were still downstream */
+    if (object->mmap_count_valid && dmx_buf.count != object->mmap_count + 1)
+      gst_dvbsrc_post_overflow (object);
+    object->mmap_count = dmx_buf.count;
+    object->mmap_count_valid = TRUE;
+
+    if (dmx_buf.index < dvb_mmap->n_buffers && dmx_buf.bytesused > 0)
+      break;
+
+    gst_dvbsrc_mmap_queue (dvb_mmap, dmx_buf.index);
+  }
+
+  mmap_buf = g_slice_new (GstDvbSrcMmapBuffer);
+  mmap_buf->dvb_mmap = dvb_mmap;
+  mmap_buf->index = dmx_buf.index;
+  g_atomic_int_inc (&dvb_mmap->refcount);
+
+  *buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      dvb_mmap->data[dmx_buf.index], dvb_mmap->length[dmx_buf.index], 0,
+      MIN (dmx_buf.bytesused, dvb_mmap->length[dmx_buf.index]), mmap_buf,
+      gst_dvbsrc_mmap_buffer_release);
+
+  return GST_FLOW_OK;
+
+stopped:
+  {
+    GST_DEBUG_OBJECT (object, "stop called");
+    return GST_FLOW_FLUSHING;
+  }
+select_error:
+  {
+    GST_ELEMENT_ERROR (object, RESOURCE, READ, (NULL),
+        ("select error %d: %s (%d)", ret_val, g_strerror (errno), errno));
+    return GST_FLOW_ERROR;
+  }
+dequeue_error:
+  {
+    GST_ELEMENT_ERROR (object, RESOURCE, READ, (NULL),
+        ("Could not dequeue DVR buffer: %s (%d)", g_strerror (errno), errno));
+    return GST_FLOW_ERROR;
+  }
+}
+#endif
+
 static GstFlowReturn
 gst_dvbsrc_create (GstPushSrc * element, GstBuffer ** buf)
 {
-  gint buffer_size;
   GstFlowReturn retval = GST_FLOW_ERROR;
   GstDvbSrc *object;
   fe_status_t status;
@@ -1937,8 +2321,6 @@ gst_dvbsrc_create (GstPushSrc * element, GstBuffer ** buf)
   object = GST_DVBSRC (element);
   GST_LOG ("fd_dvr: %d", object->fd_dvr);
 
-  buffer_size = DEFAULT_BUFFER_SIZE;
-
   /* device can not be tuned during read */
   g_mutex_lock (&object->tune_mutex);
 
@@ -1946,7 +2328,12 @@ gst_dvbsrc_create (GstPushSrc * element, GstBuffer ** buf)
   if (object->fd_dvr > -1) {
     /* --- Read TS from DVR device --- */
     GST_DEBUG_OBJECT (object, "Reading from DVR device");
-    retval = gst_dvbsrc_read_device (object, buffer_size, buf);
+#ifdef HAVE_DVB_MMAP
+    if (object->dvb_mmap)
+      retval = gst_dvbsrc_read_mmap (object, buf);
+    else
+#endif
+      retval = gst_dvbsrc_read_device (object, buf);
 
     if (object->stats_interval &&
         ++object->stats_counter == object->stats_interval) {
@@ -1993,6 +2380,11 @@ static gboolean
 gst_dvbsrc_start (GstBaseSrc * bsrc)
 {
   GstDvbSrc *src = GST_DVBSRC (bsrc);
+  GstStructure *config;
+
+  g_atomic_int_set (&src->overflows, 0);
+  src->read_size = MIN_READ_SIZE;
+  src->byte_rate = 0;
 
   if (!gst_dvbsrc_open_frontend (src, TRUE)) {
     GST_ERROR_OBJECT (src, "Could not open frontend device");
@@ -2017,11 +2409,30 @@ gst_dvbsrc_start (GstBaseSrc * bsrc)
   gst_poll_add_fd (src->poll, &src->poll_fd_dvr);
   gst_poll_fd_ctl_read (src->poll, &src->poll_fd_dvr, TRUE);
 
+#ifdef HAVE_DVB_MMAP
+  if (src->mmap && gst_dvbsrc_mmap_start (src))
+    return TRUE;
+#endif
+
+  /* buffers of whole packets, recycled once downstream is done with them */
+  src->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (src->pool);
+  gst_buffer_pool_config_set_params (config, NULL, DEFAULT_BUFFER_SIZE, 0, 0);
+  if (!gst_buffer_pool_set_config (src->pool, config) ||
+      !gst_buffer_pool_set_active (src->pool, TRUE)) {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("Could not activate the buffer pool"));
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+    goto fail;
+  }
+
   return TRUE;
 
 fail:
   gst_dvbsrc_unset_pes_filters (src);
   close (src->fd_frontend);
+  src->shared_frontend = FALSE;
   return FALSE;
 }
 
@@ -2031,6 +2442,11 @@ gst_dvbsrc_stop (GstBaseSrc * bsrc)
   GstDvbSrc *src = GST_DVBSRC (bsrc);
 
   gst_dvbsrc_close_devices (src);
+  if (src->pool) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+  }
   g_list_free (src->supported_delsys);
   src->supported_delsys = NULL;
   if (src->poll) {
@@ -2734,7 +3150,9 @@ gst_dvbsrc_tune (GstDvbSrc * object)
    * - then tell the MPEG decoder to start
    * - before tuning: first stop the MPEG decoder, then stop all filters
    */
-  if (!gst_dvbsrc_tune_fe (object)) {
+  if (object->shared_frontend) {
+    GST_INFO_OBJECT (object, "Frontend tuned by another reader");
+  } else if (!gst_dvbsrc_tune_fe (object)) {
     GST_WARNING_OBJECT (object, "Unable to tune frontend");
     return FALSE;
   }
@@ -2760,6 +3178,55 @@ gst_dvbsrc_unset_pes_filters (GstDvbSrc * object)
   }
 }
 
+/* Sets one filter for all the PIDs on the demux device the stream is read
+ * from, so that only these packets end up in its buffer */
+static void
+gst_dvbsrc_set_demux_tap_filter (GstDvbSrc * object)
+{
+  struct dmx_pes_filter_params pes_filter;
+  guint16 pid;
+  gint i, err;
+
+  /* the demux device is opened after tuning */
+  if (object->fd_dvr < 0)
+    return;
+
+  GST_INFO_OBJECT (object, "Setting demux tap filter");
+
+  LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_STOP));
+
+  pes_filter.input = DMX_IN_FRONTEND;
+  pes_filter.output = DMX_OUT_TSDEMUX_TAP;
+  pes_filter.pes_type = DMX_PES_OTHER;
+  pes_filter.flags = 0;
+  pes_filter.pid = object->pids[0];
+
+  GST_INFO_OBJECT (object, "Setting demux tap filter: pid = %d",
+      pes_filter.pid);
+  LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_SET_PES_FILTER,
+          &pes_filter));
+  if (err) {
+    GST_WARNING_OBJECT (object, "Error setting demux tap filter: %s",
+        g_strerror (errno));
+    return;
+  }
+
+  for (i = 1; i < MAX_FILTERS && object->pids[i] != G_MAXUINT16; i++) {
+    pid = object->pids[i];
+
+    GST_INFO_OBJECT (object, "Adding pid %d to demux tap filter", pid);
+    LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_ADD_PID, &pid));
+    if (err)
+      GST_WARNING_OBJECT (object, "Error adding pid %d to demux tap filter: "
+          "%s", pid, g_strerror (errno));
+  }
+
+  LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_START));
+  if (err)
+    GST_WARNING_OBJECT (object, "Error starting demux tap filter: %s",
+        g_strerror (errno));
+}
+
 static void
 gst_dvbsrc_set_pes_filters (GstDvbSrc * object)
 {
@@ -2767,7 +3234,14 @@ gst_dvbsrc_set_pes_filters (GstDvbSrc * object)
   int pid, i;
   struct dmx_pes_filter_params pes_filter;
   gint err;
-  gchar *demux_dev = g_strdup_printf ("/dev/dvb/adapter%d/demux%d",
+  gchar *demux_dev;
+
+  if (object->demux_tap) {
+    gst_dvbsrc_set_demux_tap_filter (object);
+    return;
+  }
+
+  demux_dev = g_strdup_printf ("/dev/dvb/adapter%d/demux%d",
       object->adapter_number, object->frontend_number);
 
   GST_INFO_OBJECT (object, "Setting PES filter");
@@ -56,6 +56,7 @@ G_BEGIN_DECLS
 typedef struct _GstDvbSrc GstDvbSrc;
 typedef struct _GstDvbSrcClass GstDvbSrcClass;
 typedef struct _GstDvbSrcParam GstDvbSrcParam;
+typedef struct _GstDvbSrcMmap GstDvbSrcMmap;
 
 struct _GstDvbSrc
 {
@@ -104,6 +105,20 @@ struct _GstDvbSrc
 
   guint dvb_buffer_size;
 
+  gboolean demux_tap;
+  gboolean shared_frontend;
+  gint overflows;
+
+  guint64 max_read_latency;
+  guint read_size;
+  guint64 byte_rate;
+  GstBufferPool *pool;
+
+  gboolean mmap;
+  GstDvbSrcMmap *dvb_mmap;
+  guint32 mmap_count;
+  gboolean mmap_count_valid;
+
   unsigned int isdbt_layer_enabled;
   int isdbt_partial_reception;
   int isdbt_sound_broadcasting;
@@ -27,6 +27,12 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include <gst/base/gstbytewriter.h>
 #include <gst/gstprotection.h>
 #include "gstipcpipelinecomm.h"
@@ -36,6 +42,17 @@ GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
 
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
 
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+/* descriptors that can come with a single read */
+#define MAX_RECEIVED_FDS 16
+
+/* Set in the ids of requests the sender does not wait for. The peer only
+ * replies to those when they failed, so the failure can be logged */
+#define REQUEST_ID_NO_REPLY 0x80000000
+
 GQuark QUARK_ID;
 
 typedef enum
@@ -63,11 +80,21 @@ typedef struct
   GstQuery *query;
   CommRequestType type;
   GCond cond;
+  gint64 start_time;
 } CommRequest;
 
+static const gchar *comm_request_type_names[] = {
+  "buffer", "event", "query", "state-change", "message"
+};
+
+G_STATIC_ASSERT (G_N_ELEMENTS (comm_request_type_names) ==
+    GST_IPC_PIPELINE_COMM_N_REQUEST_TYPES);
+
 static const gchar *comm_request_ret_get_name (CommRequestType type,
     guint32 ret);
 static guint32 comm_request_ret_get_failure_value (CommRequestType type);
+static gboolean comm_request_ret_is_success (CommRequestType type,
+    guint32 ret);
 
 static CommRequest *
 comm_request_new (guint32 id, CommRequestType type, GstQuery * query)
@@ -82,6 +109,7 @@ comm_request_new (guint32 id, CommRequestType type, GstQuery * query)
   req->query = query;
   req->ret = comm_request_ret_get_failure_value (type);
   req->type = type;
+  req->start_time = g_get_monotonic_time ();
 
   return req;
 }
@@ -163,6 +191,23 @@ comm_request_ret_get_failure_value (CommRequestType type)
   }
 }
 
+static gboolean
+comm_request_ret_is_success (CommRequestType type, guint32 ret)
+{
+  switch (type) {
+    case COMM_REQUEST_TYPE_BUFFER:
+      return ret == GST_FLOW_OK;
+    case COMM_REQUEST_TYPE_EVENT:
+    case COMM_REQUEST_TYPE_MESSAGE:
+    case COMM_REQUEST_TYPE_QUERY:
+      return ret != FALSE;
+    case COMM_REQUEST_TYPE_STATE_CHANGE:
+      return ret != GST_STATE_CHANGE_FAILURE;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
 static const gchar *
 gst_ipc_pipeline_comm_data_type_get_name (GstIpcPipelineCommDataType type)
 {
@@ -187,11 +232,23 @@ gst_ipc_pipeline_comm_data_type_get_name (GstIpcPipelineCommDataType type)
       return "MESSAGE";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
       return "GERROR_MESSAGE";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD:
+      return "BUFFER_FD";
     default:
       return "UNKNOWN";
   }
 }
 
+/* Picks the id of the next request, telling the peer whether we wait for
+ * its reply */
+static void
+comm_request_next_id (GstIpcPipelineComm * comm, AckType ack_type)
+{
+  comm->send_id = (comm->send_id + 1) & ~REQUEST_ID_NO_REPLY;
+  if (ack_type == ACK_TYPE_NONE)
+    comm->send_id |= REQUEST_ID_NO_REPLY;
+}
+
 static gboolean
 gst_ipc_pipeline_comm_sync_fd (GstIpcPipelineComm * comm, guint32 id,
     GstQuery * query, guint32 * ret, AckType ack_type, CommRequestType type)
@@ -200,8 +257,10 @@ gst_ipc_pipeline_comm_sync_fd (GstIpcPipelineComm * comm, guint32 id,
   gboolean comm_error;
   GHashTable *waiting_ids;
 
-  if (ack_type == ACK_TYPE_NONE)
+  if (ack_type == ACK_TYPE_NONE) {
+    comm->rtt_stats[type].pipelined++;
     return TRUE;
+  }
 
   req = comm_request_new (id, type, query);
   waiting_ids = g_hash_table_ref (comm->waiting_ids);
@@ -240,6 +299,66 @@ done:
   return ret;
 }
 
+/* Writes all of @iov with as few system calls as possible. When @fd is not
+ * -1, it is passed along with the first bytes, which needs fdout to be a
+ * Unix socket */
+static gboolean
+write_vectors_to_fd (GstIpcPipelineComm * comm, struct iovec *iov, gint n_iov,
+    gint fd)
+{
+  gboolean ret = TRUE;
+
+  while (n_iov > 0) {
+    ssize_t written;
+
+    if (fd >= 0) {
+      struct msghdr msg;
+      struct cmsghdr *cmsg;
+      char cmsg_buf[CMSG_SPACE (sizeof (int))];
+
+      memset (&msg, 0, sizeof (msg));
+      memset (cmsg_buf, 0, sizeof (cmsg_buf));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = n_iov;
+      msg.msg_control = cmsg_buf;
+      msg.msg_controllen = sizeof (cmsg_buf);
+      cmsg = CMSG_FIRSTHDR (&msg);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+      memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+      written = sendmsg (comm->fdout, &msg, 0);
+    } else {
+      written = writev (comm->fdout, iov, n_iov);
+    }
+
+    if (written < 0) {
+      if (errno == EAGAIN || errno == EINTR)
+        continue;
+      GST_ERROR_OBJECT (comm->element, "Failed to write to fd: %s",
+          strerror (errno));
+      ret = FALSE;
+      break;
+    }
+    GST_TRACE_OBJECT (comm->element, "Wrote %zd bytes to fdout", written);
+
+    /* the descriptor went along with these bytes */
+    fd = -1;
+    while (n_iov > 0 && (size_t) written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      n_iov--;
+    }
+    if (n_iov > 0) {
+      iov->iov_base = (guint8 *) iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+
+  return ret;
+}
+
 static gboolean
 write_byte_writer_to_fd (GstIpcPipelineComm * comm, GstByteWriter * bw)
 {
@@ -264,6 +383,13 @@ gst_ipc_pipeline_comm_write_ack_to_fd (GstIpcPipelineComm * comm, guint32 id,
   guint32 size;
   GstByteWriter bw;
 
+  /* the sender is not waiting, and only wants to hear about failures */
+  if ((id & REQUEST_ID_NO_REPLY) && comm_request_ret_is_success (type, ret)) {
+    GST_TRACE_OBJECT (comm->element, "Not writing ACK for %u: %s (%d)", id,
+        comm_request_ret_get_name (type, ret), ret);
+    return;
+  }
+
   g_mutex_lock (&comm->mutex);
 
   GST_TRACE_OBJECT (comm->element, "Writing ACK for %u: %s (%d)", id,
@@ -497,26 +623,90 @@ typedef struct
   guint64 flags;
 } CommBufferMetadata;
 
+/* Copies the data of @buffer to a new memfd, so the reader can map it
+ * instead of reading it from the pipe. Returns -1 if that is not possible */
+static gint
+copy_buffer_to_memfd (GstIpcPipelineComm * comm, GstBuffer * buffer)
+{
+#ifdef SYS_memfd_create
+  GstMapInfo map;
+  guint n, n_mem = gst_buffer_n_memory (buffer);
+  struct stat st;
+  gint fd;
+
+  /* descriptors can only be passed over Unix sockets */
+  if (fstat (comm->fdout, &st) < 0 || !S_ISSOCK (st.st_mode))
+    return -1;
+
+  fd = syscall (SYS_memfd_create, "ipcpipeline", MFD_CLOEXEC);
+  if (fd < 0) {
+    GST_WARNING_OBJECT (comm->element, "Failed to create memfd: %s",
+        strerror (errno));
+    return -1;
+  }
+
+  for (n = 0; n < n_mem; n++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, n);
+    gsize offset = 0;
+
+    if (!gst_memory_map (mem, &map, GST_MAP_READ))
+      goto failed;
+    while (offset < map.size) {
+      ssize_t written = write (fd, map.data + offset, map.size - offset);
+
+      if (written < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+          continue;
+        GST_WARNING_OBJECT (comm->element, "Failed to write to memfd: %s",
+            strerror (errno));
+        gst_memory_unmap (mem, &map);
+        goto failed;
+      }
+      offset += written;
+    }
+    gst_memory_unmap (mem, &map);
+  }
+
+  return fd;
+
+failed:
+  close (fd);
+  return -1;
+#else
+  return -1;
+#endif
+}
+
 GstFlowReturn
 gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
     GstBuffer * buffer)
 {
-  const unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
-  GstMapInfo map;
+  unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
   guint32 ret32 = GST_FLOW_OK;
   guint32 size, n;
   CommBufferMetadata meta;
   GstFlowReturn ret;
   MetaListRepresentation repr = { comm, 0, 4, NULL };   /* starts a 4 for n_meta */
-  GstByteWriter bw;
+  GstByteWriter bw, meta_bw;
+  guint8 *header_data = NULL, *meta_data = NULL;
+  guint header_size, meta_size;
+  GstMapInfo *maps;
+  struct iovec *iov;
+  guint n_mem, n_mapped = 0, n_iov = 0;
+  gint memfd = -1;
 
   g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+  comm_request_next_id (comm, ACK_TYPE_BLOCKING);
 
   GST_TRACE_OBJECT (comm->element, "Writing buffer %u: %" GST_PTR_FORMAT,
       comm->send_id, buffer);
 
   gst_byte_writer_init (&bw);
+  gst_byte_writer_init (&meta_bw);
+
+  n_mem = gst_buffer_n_memory (buffer);
+  maps = g_newa (GstMapInfo, n_mem);
+  iov = g_newa (struct iovec, n_mem + 2);
 
   meta.pts = GST_BUFFER_PTS (buffer);
   meta.dts = GST_BUFFER_DTS (buffer);
@@ -528,13 +718,21 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   /* work out meta size */
   gst_buffer_foreach_meta (buffer, build_meta, &repr);
 
+  /* large payloads are handed over in a memfd instead of through fdout */
+  if (comm->memfd_threshold > 0 &&
+      gst_buffer_get_size (buffer) >= comm->memfd_threshold) {
+    memfd = copy_buffer_to_memfd (comm, buffer);
+    if (memfd >= 0)
+      payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD;
+  }
+
   if (!gst_byte_writer_put_uint8 (&bw, payload_type))
     goto write_failed;
   if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
     goto write_failed;
-  size =
-      gst_buffer_get_size (buffer) + sizeof (guint32) +
-      sizeof (CommBufferMetadata) + repr.total_bytes;
+  size = sizeof (guint32) + sizeof (CommBufferMetadata) + repr.total_bytes;
+  if (memfd < 0)
+    size += gst_buffer_get_size (buffer);
   if (!gst_byte_writer_put_uint32_le (&bw, size))
     goto write_failed;
   if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
@@ -542,51 +740,61 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   size = gst_buffer_get_size (buffer);
   if (!gst_byte_writer_put_uint32_le (&bw, size))
     goto write_failed;
-  if (!write_byte_writer_to_fd (comm, &bw))
-    goto write_failed;
-
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
-    goto map_failed;
-  ret = write_to_fd_raw (comm, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
-  if (!ret)
-    goto write_failed;
 
   /* meta */
-  gst_byte_writer_init (&bw);
-  if (!gst_byte_writer_put_uint32_le (&bw, repr.n_meta))
+  if (!gst_byte_writer_put_uint32_le (&meta_bw, repr.n_meta))
     goto write_failed;
   for (n = 0; n < repr.n_meta; ++n) {
     const MetaBuildInfo *info = repr.info + n;
     guint32 len;
     const char *s;
 
-    if (!gst_byte_writer_put_uint32_le (&bw, info->bytes))
+    if (!gst_byte_writer_put_uint32_le (&meta_bw, info->bytes))
       goto write_failed;
 
-    if (!gst_byte_writer_put_uint32_le (&bw, info->flags))
+    if (!gst_byte_writer_put_uint32_le (&meta_bw, info->flags))
       goto write_failed;
 
     s = g_type_name (info->api);
     len = strlen (s) + 1;
-    if (!gst_byte_writer_put_uint32_le (&bw, len))
+    if (!gst_byte_writer_put_uint32_le (&meta_bw, len))
       goto write_failed;
-    if (!gst_byte_writer_put_data (&bw, (const guint8 *) s, len))
+    if (!gst_byte_writer_put_data (&meta_bw, (const guint8 *) s, len))
       goto write_failed;
 
-    if (!gst_byte_writer_put_uint64_le (&bw, info->size))
+    if (!gst_byte_writer_put_uint64_le (&meta_bw, info->size))
       goto write_failed;
 
     s = info->str;
     len = s ? (strlen (s) + 1) : 0;
-    if (!gst_byte_writer_put_uint32_le (&bw, len))
+    if (!gst_byte_writer_put_uint32_le (&meta_bw, len))
       goto write_failed;
     if (len)
-      if (!gst_byte_writer_put_data (&bw, (const guint8 *) s, len))
+      if (!gst_byte_writer_put_data (&meta_bw, (const guint8 *) s, len))
         goto write_failed;
   }
 
-  if (!write_byte_writer_to_fd (comm, &bw))
+  header_size = gst_byte_writer_get_size (&bw);
+  header_data = gst_byte_writer_reset_and_get_data (&bw);
+  meta_size = gst_byte_writer_get_size (&meta_bw);
+  meta_data = gst_byte_writer_reset_and_get_data (&meta_bw);
+
+  /* header, each memory as it is and the metas, in one go */
+  iov[n_iov].iov_base = header_data;
+  iov[n_iov++].iov_len = header_size;
+  if (memfd < 0) {
+    for (n_mapped = 0; n_mapped < n_mem; n_mapped++) {
+      if (!gst_memory_map (gst_buffer_peek_memory (buffer, n_mapped),
+              &maps[n_mapped], GST_MAP_READ))
+        goto map_failed;
+      iov[n_iov].iov_base = maps[n_mapped].data;
+      iov[n_iov++].iov_len = maps[n_mapped].size;
+    }
+  }
+  iov[n_iov].iov_base = meta_data;
+  iov[n_iov++].iov_len = meta_size;
+
+  if (!write_vectors_to_fd (comm, iov, n_iov, memfd))
     goto write_failed;
 
   if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
@@ -596,7 +804,14 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
 
 done:
   g_mutex_unlock (&comm->mutex);
+  for (n = 0; n < n_mapped; ++n)
+    gst_memory_unmap (gst_buffer_peek_memory (buffer, n), &maps[n]);
+  if (memfd >= 0)
+    close (memfd);
   gst_byte_writer_reset (&bw);
+  gst_byte_writer_reset (&meta_bw);
+  g_free (header_data);
+  g_free (meta_data);
   for (n = 0; n < repr.n_meta; ++n)
     g_free (repr.info[n].str);
   g_free (repr.info);
@@ -622,7 +837,8 @@ map_failed:
 }
 
 static GstBuffer *
-gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size,
+    gboolean with_fd)
 {
   GstBuffer *buffer;
   CommBufferMetadata meta;
@@ -645,13 +861,30 @@ gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
   gst_adapter_unmap (comm->adapter);
   gst_adapter_flush (comm->adapter, mapped_size);
 
-  if (buffer_data_size == 0) {
+  if (with_fd) {
+    gint fd;
+
+    /* the descriptor came with the first bytes of this chunk */
+    if (g_queue_is_empty (&comm->fds)) {
+      GST_ERROR_OBJECT (comm->element, "No memfd received for buffer");
+      return NULL;
+    }
+    fd = GPOINTER_TO_INT (g_queue_pop_head (&comm->fds));
+    buffer = gst_buffer_new ();
+    if (buffer_data_size > 0)
+      gst_buffer_append_memory (buffer,
+          gst_fd_allocator_alloc (comm->fd_allocator, fd, buffer_data_size,
+              GST_FD_MEMORY_FLAG_NONE));
+    else
+      close (fd);
+  } else if (buffer_data_size == 0) {
     buffer = gst_buffer_new ();
   } else {
     buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
     gst_adapter_flush (comm->adapter, buffer_data_size);
   }
-  size -= buffer_data_size;
+  if (!with_fd)
+    size -= buffer_data_size;
 
   GST_BUFFER_PTS (buffer) = meta.pts;
   GST_BUFFER_DTS (buffer) = meta.dts;
@@ -737,7 +970,8 @@ gst_ipc_pipeline_comm_write_sink_message_event_to_fd (GstIpcPipelineComm * comm,
       FALSE);
 
   g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+  comm_request_next_id (comm,
+      GST_EVENT_IS_SERIALIZED (event) ? ACK_TYPE_BLOCKING : ACK_TYPE_TIMED);
 
   GST_TRACE_OBJECT (comm->element,
       "Writing sink message event %u: %" GST_PTR_FORMAT, comm->send_id, event);
@@ -901,13 +1135,25 @@ gst_ipc_pipeline_comm_write_event_to_fd (GstIpcPipelineComm * comm,
   char *str = NULL;
   const GstStructure *structure;
   GstByteWriter bw;
+  AckType ack_type;
 
   /* we special case sink-message event as gst can't serialize/de-serialize it */
   if (GST_EVENT_TYPE (event) == GST_EVENT_SINK_MESSAGE)
     return gst_ipc_pipeline_comm_write_sink_message_event_to_fd (comm, event);
 
+  /* Upstream events get serialized, this is required to send seeks only
+   * one at a time. The sticky downstream events are followed by a buffer or
+   * EOS that waits for them to be handled, so they can be pipelined. */
+  if (!GST_EVENT_IS_SERIALIZED (event) && !GST_EVENT_IS_UPSTREAM (event))
+    ack_type = ACK_TYPE_NONE;
+  else if (comm->pipelined_events && !upstream &&
+      GST_EVENT_IS_STICKY (event) && GST_EVENT_TYPE (event) != GST_EVENT_EOS)
+    ack_type = ACK_TYPE_NONE;
+  else
+    ack_type = ACK_TYPE_BLOCKING;
+
   g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+  comm_request_next_id (comm, ack_type);
 
   GST_TRACE_OBJECT (comm->element, "Writing event %u: %" GST_PTR_FORMAT,
       comm->send_id, event);
@@ -960,11 +1206,8 @@ gst_ipc_pipeline_comm_write_event_to_fd (GstIpcPipelineComm * comm,
   if (!write_byte_writer_to_fd (comm, &bw))
     goto write_failed;
 
-  /* Upstream events get serialized, this is required to send seeks only
-   * one at a time. */
   if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
-          (GST_EVENT_IS_SERIALIZED (event) || GST_EVENT_IS_UPSTREAM (event)) ?
-          ACK_TYPE_BLOCKING : ACK_TYPE_NONE, COMM_REQUEST_TYPE_EVENT))
+          ack_type, COMM_REQUEST_TYPE_EVENT))
     goto write_failed;
   ret = ret32;
 
@@ -1047,7 +1290,8 @@ gst_ipc_pipeline_comm_write_query_to_fd (GstIpcPipelineComm * comm,
   GstByteWriter bw;
 
   g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+  comm_request_next_id (comm,
+      GST_QUERY_IS_SERIALIZED (query) ? ACK_TYPE_BLOCKING : ACK_TYPE_TIMED);
 
   GST_TRACE_OBJECT (comm->element, "Writing query %u: %" GST_PTR_FORMAT,
       comm->send_id, query);
@@ -1183,7 +1427,7 @@ gst_ipc_pipeline_comm_write_state_change_to_fd (GstIpcPipelineComm * comm,
   GstByteWriter bw;
 
   g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+  comm_request_next_id (comm, ACK_TYPE_TIMED);
 
   GST_TRACE_OBJECT (comm->element, "Writing state change %u: %s -> %s",
       comm->send_id,
@@ -1270,7 +1514,7 @@ gst_ipc_pipeline_comm_write_state_lost_to_fd (GstIpcPipelineComm * comm)
   GstByteWriter bw;
 
   g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+  comm_request_next_id (comm, ACK_TYPE_NONE);
 
   GST_TRACE_OBJECT (comm->element, "Writing state-lost %u", comm->send_id);
   gst_byte_writer_init (&bw);
@@ -1319,7 +1563,7 @@ gst_ipc_pipeline_comm_write_gerror_message_to_fd (GstIpcPipelineComm * comm,
   GstByteWriter bw;
 
   g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+  comm_request_next_id (comm, ACK_TYPE_NONE);
 
   if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR) {
     gst_message_parse_error (message, &error, &extra_message);
@@ -1496,7 +1740,7 @@ gst_ipc_pipeline_comm_write_message_to_fd (GstIpcPipelineComm * comm,
     return gst_ipc_pipeline_comm_write_gerror_message_to_fd (comm, message);
 
   g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+  comm_request_next_id (comm, ACK_TYPE_NONE);
 
   GST_TRACE_OBJECT (comm->element, "Writing message %u: %" GST_PTR_FORMAT,
       comm->send_id, message);
@@ -1606,6 +1850,8 @@ gst_ipc_pipeline_comm_init (GstIpcPipelineComm * comm, GstElement * element)
   comm->adapter = gst_adapter_new ();
   comm->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&comm->pollFDin);
+  g_queue_init (&comm->fds);
+  comm->fd_allocator = gst_fd_allocator_new ();
 }
 
 void
@@ -1613,6 +1859,9 @@ gst_ipc_pipeline_comm_clear (GstIpcPipelineComm * comm)
 {
   g_hash_table_destroy (comm->waiting_ids);
   gst_object_unref (comm->adapter);
+  while (!g_queue_is_empty (&comm->fds))
+    close (GPOINTER_TO_INT (g_queue_pop_head (&comm->fds)));
+  gst_object_unref (comm->fd_allocator);
   gst_poll_free (comm->poll);
   g_mutex_clear (&comm->mutex);
 }
@@ -1655,6 +1904,35 @@ gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm, gboolean cleanup)
   g_mutex_unlock (&comm->mutex);
 }
 
+/* Returns the round-trip times of the requests sent to the peer, in
+ * microseconds, with one structure per type of request */
+GstStructure *
+gst_ipc_pipeline_comm_get_stats (GstIpcPipelineComm * comm)
+{
+  GstStructure *s, *type_stats;
+  guint i;
+
+  s = gst_structure_new_empty ("application/x-ipc-pipeline-stats");
+
+  g_mutex_lock (&comm->mutex);
+  for (i = 0; i < GST_IPC_PIPELINE_COMM_N_REQUEST_TYPES; i++) {
+    GstIpcPipelineCommRttStats *stats = &comm->rtt_stats[i];
+
+    type_stats = gst_structure_new (comm_request_type_names[i],
+        "count", G_TYPE_UINT64, stats->count,
+        "average-rtt", G_TYPE_UINT64,
+        stats->count ? stats->total_rtt / stats->count : 0,
+        "max-rtt", G_TYPE_UINT64, stats->max_rtt,
+        "pipelined", G_TYPE_UINT64, stats->pipelined, NULL);
+    gst_structure_set (s, comm_request_type_names[i], GST_TYPE_STRUCTURE,
+        type_stats, NULL);
+    gst_structure_free (type_stats);
+  }
+  g_mutex_unlock (&comm->mutex);
+
+  return s;
+}
+
 static gboolean
 set_field (GQuark field_id, const GValue * value, gpointer user_data)
 {
@@ -1670,6 +1948,15 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
     GstFlowReturn ret, GstQuery * query)
 {
   CommRequest *req;
+  GstIpcPipelineCommRttStats *stats;
+  guint64 rtt;
+
+  if (id & REQUEST_ID_NO_REPLY) {
+    /* only failures are replied to, nobody is waiting for them */
+    GST_INFO_OBJECT (comm->element, "Pipelined request %u failed: %d", id,
+        ret);
+    return TRUE;
+  }
 
   req = g_hash_table_lookup (comm->waiting_ids, GINT_TO_POINTER (id));
   if (!req) {
@@ -1679,6 +1966,13 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
 
   GST_TRACE_OBJECT (comm->element, "Got reply %d (%s) for request %u", ret,
       comm_request_ret_get_name (req->type, ret), req->id);
+
+  rtt = g_get_monotonic_time () - req->start_time;
+  stats = &comm->rtt_stats[req->type];
+  stats->count++;
+  stats->total_rtt += rtt;
+  stats->max_rtt = MAX (stats->max_rtt, rtt);
+
   req->replied = TRUE;
   req->ret = ret;
   if (query) {
@@ -1698,6 +1992,63 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
   return TRUE;
 }
 
+/* Reads from fdin, and queues the descriptors that came with the data when
+ * it is a Unix socket */
+static ssize_t
+read_with_fds (GstIpcPipelineComm * comm, guint8 * data, gsize size)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  char cmsg_buf[CMSG_SPACE (sizeof (int) * MAX_RECEIVED_FDS)];
+  gint flags = 0;
+  ssize_t sz;
+
+  if (!comm->fdin_is_socket)
+    return read (comm->pollFDin.fd, data, size);
+
+  memset (&msg, 0, sizeof (msg));
+  iov.iov_base = data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsg_buf;
+  msg.msg_controllen = sizeof (cmsg_buf);
+#ifdef MSG_CMSG_CLOEXEC
+  flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+  sz = recvmsg (comm->pollFDin.fd, &msg, flags);
+  if (sz < 0 && errno == ENOTSOCK) {
+    GST_DEBUG_OBJECT (comm->element, "fd %d is not a socket",
+        comm->pollFDin.fd);
+    comm->fdin_is_socket = FALSE;
+    return read (comm->pollFDin.fd, data, size);
+  }
+  if (sz < 0)
+    return sz;
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    guint i, n_fds;
+
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+
+    n_fds = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+    for (i = 0; i < n_fds; i++) {
+      gint fd;
+
+      memcpy (&fd, CMSG_DATA (cmsg) + i * sizeof (int), sizeof (int));
+      GST_TRACE_OBJECT (comm->element, "Received fd %d", fd);
+      g_queue_push_tail (&comm->fds, GINT_TO_POINTER (fd));
+    }
+  }
+  if (msg.msg_flags & MSG_CTRUNC)
+    GST_WARNING_OBJECT (comm->element, "Lost file descriptors sent with data");
+
+  return sz;
+}
+
 static gint
 update_adapter (GstIpcPipelineComm * comm)
 {
@@ -1723,6 +2074,7 @@ again:
     if (comm->fdin != -1 && GST_OBJECT_PARENT (comm->element)) {
       GST_DEBUG_OBJECT (comm->element, "Start watching fd %d", comm->fdin);
       comm->pollFDin.fd = comm->fdin;
+      comm->fdin_is_socket = TRUE;
       gst_poll_add_fd (comm->poll, &comm->pollFDin);
       gst_poll_fd_ctl_read (comm->poll, &comm->pollFDin, TRUE);
     }
@@ -1744,7 +2096,7 @@ again:
       mem = gst_allocator_alloc (NULL, comm->read_chunk_size, NULL);
 
     gst_memory_map (mem, &map, GST_MAP_WRITE);
-    sz = read (comm->pollFDin.fd, map.data, map.size);
+    sz = read_with_fds (comm, map.data, map.size);
     gst_memory_unmap (mem, &map);
 
     if (sz <= 0) {
@@ -1809,6 +2161,7 @@ read_many (GstIpcPipelineComm * comm)
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD:
             GST_TRACE_OBJECT (comm->element, "switching to state %s",
                 gst_ipc_pipeline_comm_data_type_get_name (type));
             comm->state = type;
@@ -1873,6 +2226,7 @@ read_many (GstIpcPipelineComm * comm)
         break;
       }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER:
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD:
       {
         GstBuffer *buf;
 
@@ -1880,7 +2234,8 @@ read_many (GstIpcPipelineComm * comm)
         if (available < comm->payload_length)
           goto done;
 
-        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
+        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length,
+            comm->state == GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD);
         if (!buf)
           goto buffer_failed;
 
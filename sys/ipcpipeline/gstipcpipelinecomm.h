@@ -26,6 +26,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
+#include <gst/allocators/allocators.h>
 
 G_BEGIN_DECLS
 
@@ -51,8 +52,22 @@ typedef enum {
   GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD,
 } GstIpcPipelineCommDataType;
 
+/* buffer, event, query, state change and message requests */
+#define GST_IPC_PIPELINE_COMM_N_REQUEST_TYPES 5
+
+typedef struct
+{
+  /* replies received, and the time they took to arrive, in microseconds */
+  guint64 count;
+  guint64 total_rtt;
+  guint64 max_rtt;
+  /* requests sent without waiting for a reply */
+  guint64 pipelined;
+} GstIpcPipelineCommRttStats;
+
 typedef struct
 {
   GstElement *element;
@@ -76,6 +91,19 @@ typedef struct
   guint read_chunk_size;
   GstClockTime ack_time;
 
+  /* buffers of at least that size are passed in a memfd, 0 to disable */
+  guint memfd_threshold;
+  /* descriptors received with the data, for the BUFFER_FD chunks */
+  gboolean fdin_is_socket;
+  GQueue fds;
+  GstAllocator *fd_allocator;
+
+  /* send the sticky downstream events other than EOS without waiting for
+   * the peer to handle them */
+  gboolean pipelined_events;
+  /* protected by mutex */
+  GstIpcPipelineCommRttStats rtt_stats[GST_IPC_PIPELINE_COMM_N_REQUEST_TYPES];
+
   void (*on_buffer) (guint32, GstBuffer *, gpointer);
   void (*on_event) (guint32, GstEvent *, gboolean, gpointer);
   void (*on_query) (guint32, GstQuery *, gboolean, gpointer);
@@ -92,6 +120,7 @@ void gst_ipc_pipeline_comm_init (GstIpcPipelineComm *comm, GstElement *e);
 void gst_ipc_pipeline_comm_clear (GstIpcPipelineComm *comm);
 void gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm,
     gboolean flushing);
+GstStructure * gst_ipc_pipeline_comm_get_stats (GstIpcPipelineComm * comm);
 
 void gst_ipc_pipeline_comm_write_flow_ack_to_fd (GstIpcPipelineComm * comm,
     guint32 id, GstFlowReturn ret);
@@ -98,11 +98,16 @@ enum
   PROP_FDOUT,
   PROP_READ_CHUNK_SIZE,
   PROP_ACK_TIME,
+  PROP_MEMFD_THRESHOLD,
+  PROP_PIPELINED_EVENTS,
+  PROP_STATS,
 };
 
 
 #define DEFAULT_READ_CHUNK_SIZE 4096
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
+#define DEFAULT_MEMFD_THRESHOLD 0
+#define DEFAULT_PIPELINED_EVENTS FALSE
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_sink_debug, "ipcpipelinesink", 0, "ipcpipelinesink element");
@@ -174,6 +179,23 @@ gst_ipc_pipeline_sink_class_init (GstIpcPipelineSinkClass * klass)
           "Maximum time to wait for a response to a message",
           0, G_MAXUINT64, DEFAULT_ACK_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MEMFD_THRESHOLD,
+      g_param_spec_uint ("memfd-threshold", "Memfd threshold",
+          "Pass buffers of at least this size in a memfd rather than through "
+          "fdout, when it is a Unix socket (0 = never)",
+          0, G_MAXUINT, DEFAULT_MEMFD_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PIPELINED_EVENTS,
+      g_param_spec_boolean ("pipelined-events", "Pipelined events",
+          "Send the sticky events other than EOS without waiting for "
+          "ipcpipelinesrc to handle them, only failures are reported back",
+          DEFAULT_PIPELINED_EVENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Round-trip times of the requests sent to ipcpipelinesrc, in "
+          "microseconds", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   gst_ipc_pipeline_sink_signals[SIGNAL_DISCONNECT] =
       g_signal_new ("disconnect",
@@ -210,6 +232,8 @@ gst_ipc_pipeline_sink_init (GstIpcPipelineSink * sink)
   gst_ipc_pipeline_comm_init (&sink->comm, GST_ELEMENT (sink));
   sink->comm.read_chunk_size = DEFAULT_READ_CHUNK_SIZE;
   sink->comm.ack_time = DEFAULT_ACK_TIME;
+  sink->comm.memfd_threshold = DEFAULT_MEMFD_THRESHOLD;
+  sink->comm.pipelined_events = DEFAULT_PIPELINED_EVENTS;
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
   sink->threads = g_thread_pool_new (pusher, sink, -1, FALSE, NULL);
@@ -271,6 +295,12 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       sink->comm.ack_time = g_value_get_uint64 (value);
       break;
+    case PROP_MEMFD_THRESHOLD:
+      sink->comm.memfd_threshold = g_value_get_uint (value);
+      break;
+    case PROP_PIPELINED_EVENTS:
+      sink->comm.pipelined_events = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -296,6 +326,15 @@ gst_ipc_pipeline_sink_get_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       g_value_set_uint64 (value, sink->comm.ack_time);
       break;
+    case PROP_MEMFD_THRESHOLD:
+      g_value_set_uint (value, sink->comm.memfd_threshold);
+      break;
+    case PROP_PIPELINED_EVENTS:
+      g_value_set_boolean (value, sink->comm.pipelined_events);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_ipc_pipeline_comm_get_stats (&sink->comm));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -66,6 +66,7 @@ enum
   PROP_FDOUT,
   PROP_READ_CHUNK_SIZE,
   PROP_ACK_TIME,
+  PROP_STATS,
   PROP_LAST,
 };
 
@@ -158,6 +159,11 @@ gst_ipc_pipeline_src_class_init (GstIpcPipelineSrcClass * klass)
           "Maximum time to wait for a response to a message",
           0, G_MAXUINT64, DEFAULT_ACK_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Round-trip times of the requests sent to ipcpipelinesink, in "
+          "microseconds", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   gst_ipc_pipeline_src_signals[SIGNAL_FORWARD_MESSAGE] =
       g_signal_new ("forward-message", G_TYPE_FROM_CLASS (klass),
@@ -272,6 +278,9 @@ gst_ipc_pipeline_src_get_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       g_value_set_uint64 (value, src->comm.ack_time);
       break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_ipc_pipeline_comm_get_stats (&src->comm));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
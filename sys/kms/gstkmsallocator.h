@@ -28,9 +28,14 @@
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
+#include <drm_fourcc.h>
 
 G_BEGIN_DECLS
 
+#ifndef DRM_FORMAT_MOD_LINEAR
+#define DRM_FORMAT_MOD_LINEAR 0
+#endif
+
 #define GST_TYPE_KMS_ALLOCATOR	\
    (gst_kms_allocator_get_type())
 #define GST_IS_KMS_ALLOCATOR(obj)				\
@@ -84,7 +89,8 @@ GstKMSMemory* gst_kms_allocator_dmabuf_import (GstAllocator *allocator,
 					       gint *prime_fds,
 					       gint n_planes,
 					       gsize offsets[GST_VIDEO_MAX_PLANES],
-					       GstVideoInfo *vinfo);
+					       GstVideoInfo *vinfo,
+					       guint64 modifier);
 
 GstMemory*    gst_kms_allocator_dmabuf_export (GstAllocator *allocator,
                                                GstMemory *kmsmem);
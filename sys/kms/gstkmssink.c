@@ -31,6 +31,15 @@
  * kmssink is a simple video sink that renders video frames directly
  * in a plane of a DRM device.
  *
+ * Tiled or compressed dmabufs are imported without a copy when their caps
+ * carry the DRM format modifier in a "drm-modifier" (guint64) field and the
+ * driver supports framebuffer modifiers.
+ *
+ * When the driver supports atomic modesetting, each frame is committed to
+ * the plane without blocking, and only the next frame waits for it to be
+ * on screen. Several kmssinks can then show video on different planes of
+ * the same crtc.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 videotestsrc ! kmssink
@@ -57,6 +66,10 @@
 #include "gstkmsbufferpool.h"
 #include "gstkmsallocator.h"
 
+#ifndef DRM_CAP_ADDFB2_MODIFIERS
+#define DRM_CAP_ADDFB2_MODIFIERS 0x10
+#endif
+
 #define GST_PLUGIN_NAME "kmssink"
 #define GST_PLUGIN_DESC "Video sink using the Linux kernel mode setting API"
 
@@ -71,6 +84,7 @@ G_DEFINE_TYPE_WITH_CODE (GstKMSSink, gst_kms_sink, GST_TYPE_VIDEO_SINK,
     GST_DEBUG_CATEGORY_GET (CAT_PERFORMANCE, "GST_PERFORMANCE"));
 
 static void gst_kms_sink_drain (GstKMSSink * self);
+static gboolean gst_kms_sink_wait_flip (GstKMSSink * self);
 
 enum
 {
@@ -124,6 +138,15 @@ find_plane_for_crtc (int fd, drmModeRes * res, drmModePlaneRes * pres,
   if (pipe == -1)
     return NULL;
 
+  /* prefer a plane that nothing is shown on, so that several sinks can
+   * share the crtc with a plane each */
+  for (i = 0; i < pres->count_planes; i++) {
+    plane = drmModeGetPlane (fd, pres->planes[i]);
+    if (plane->possible_crtcs & (1 << pipe) && !plane->crtc_id)
+      return plane;
+    drmModeFreePlane (plane);
+  }
+
   for (i = 0; i < pres->count_planes; i++) {
     plane = drmModeGetPlane (fd, pres->planes[i]);
     if (plane->possible_crtcs & (1 << pipe))
@@ -292,6 +315,7 @@ get_drm_caps (GstKMSSink * self)
   gint ret;
   guint64 has_dumb_buffer;
   guint64 has_prime;
+  guint64 has_addfb2_modifiers;
   guint64 has_async_page_flip;
 
   has_dumb_buffer = 0;
@@ -312,6 +336,13 @@ get_drm_caps (GstKMSSink * self)
     self->has_prime_export = (gboolean) (has_prime & DRM_PRIME_CAP_EXPORT);
   }
 
+  has_addfb2_modifiers = 0;
+  ret = drmGetCap (self->fd, DRM_CAP_ADDFB2_MODIFIERS, &has_addfb2_modifiers);
+  if (ret)
+    GST_WARNING_OBJECT (self, "could not get framebuffer modifiers capability");
+  else
+    self->has_addfb2_modifiers = (gboolean) has_addfb2_modifiers;
+
   has_async_page_flip = 0;
   ret = drmGetCap (self->fd, DRM_CAP_ASYNC_PAGE_FLIP, &has_async_page_flip);
   if (ret)
@@ -320,9 +351,11 @@ get_drm_caps (GstKMSSink * self)
     self->has_async_page_flip = (gboolean) has_async_page_flip;
 
   GST_INFO_OBJECT (self,
-      "prime import (%s) / prime export (%s) / async page flip (%s)",
+      "prime import (%s) / prime export (%s) / fb modifiers (%s) / "
+      "async page flip (%s)",
       self->has_prime_import ? "✓" : "✗",
       self->has_prime_export ? "✓" : "✗",
+      self->has_addfb2_modifiers ? "✓" : "✗",
       self->has_async_page_flip ? "✓" : "✗");
 
   return TRUE;
@@ -421,6 +454,67 @@ modesetting_failed:
   }
 }
 
+static guint32
+get_property_id (gint fd, guint32 obj_id, guint32 obj_type, const gchar * name)
+{
+  drmModeObjectPropertiesPtr props;
+  drmModePropertyPtr prop;
+  guint32 i, prop_id = 0;
+
+  props = drmModeObjectGetProperties (fd, obj_id, obj_type);
+  if (!props)
+    return 0;
+
+  for (i = 0; !prop_id && i < props->count_props; i++) {
+    prop = drmModeGetProperty (fd, props->props[i]);
+    if (!prop)
+      continue;
+    if (!strcmp (prop->name, name))
+      prop_id = prop->prop_id;
+    drmModeFreeProperty (prop);
+  }
+  drmModeFreeObjectProperties (props);
+
+  return prop_id;
+}
+
+/* Switches to the atomic API if the driver has it and we can find all the
+ * plane properties we set */
+static gboolean
+ensure_atomic (GstKMSSink * self)
+{
+  static const gchar *names[] = { "FB_ID", "CRTC_ID", "SRC_X", "SRC_Y",
+    "SRC_W", "SRC_H", "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"
+  };
+  guint32 *ids[] = { &self->plane_props.fb_id, &self->plane_props.crtc_id,
+    &self->plane_props.src_x, &self->plane_props.src_y,
+    &self->plane_props.src_w, &self->plane_props.src_h,
+    &self->plane_props.crtc_x, &self->plane_props.crtc_y,
+    &self->plane_props.crtc_w, &self->plane_props.crtc_h
+  };
+  guint i;
+
+  G_STATIC_ASSERT (G_N_ELEMENTS (names) == G_N_ELEMENTS (ids));
+
+  if (drmSetClientCap (self->fd, DRM_CLIENT_CAP_ATOMIC, 1)) {
+    GST_INFO_OBJECT (self, "driver does not support atomic modesetting");
+    return FALSE;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++) {
+    *ids[i] = get_property_id (self->fd, self->plane_id,
+        DRM_MODE_OBJECT_PLANE, names[i]);
+    if (!*ids[i]) {
+      GST_INFO_OBJECT (self, "plane %d has no %s property", self->plane_id,
+          names[i]);
+      drmSetClientCap (self->fd, DRM_CLIENT_CAP_ATOMIC, 0);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
 static gboolean
 ensure_allowed_caps (GstKMSSink * self, drmModeConnector * conn,
     drmModePlane * plane, drmModeRes * res)
@@ -574,6 +668,11 @@ retry_find_plane:
   GST_INFO_OBJECT (self, "connector id = %d / crtc id = %d / plane id = %d",
       self->conn_id, self->crtc_id, self->plane_id);
 
+  /* modesetting keeps using the legacy API, it sets the whole crtc */
+  self->has_atomic = !self->modesetting_enabled && ensure_atomic (self);
+  GST_INFO_OBJECT (self, "atomic modesetting (%s)",
+      self->has_atomic ? "✓" : "✗");
+
   self->hdisplay = crtc->mode.hdisplay;
   self->vdisplay = crtc->mode.vdisplay;
   self->buffer_id = crtc->buffer_id;
@@ -683,9 +782,12 @@ gst_kms_sink_stop (GstBaseSink * bsink)
 
   self = GST_KMS_SINK (bsink);
 
+  gst_kms_sink_wait_flip (self);
+
   if (self->allocator)
     gst_kms_allocator_clear_cache (self->allocator);
 
+  gst_buffer_replace (&self->previous_buffer, NULL);
   gst_buffer_replace (&self->last_buffer, NULL);
   gst_caps_replace (&self->allowed_caps, NULL);
   gst_object_replace ((GstObject **) & self->pool, NULL);
@@ -832,6 +934,7 @@ gst_kms_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
   GstKMSSink *self;
   GstVideoInfo vinfo;
   GstBufferPool *newpool, *oldpool;
+  guint64 modifier;
 
   self = GST_KMS_SINK (bsink);
 
@@ -843,6 +946,14 @@ gst_kms_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
   if (!gst_video_info_from_caps (&vinfo, caps))
     goto invalid_format;
 
+  /* tiled or compressed dmabufs are described by their DRM format modifier,
+   * which the framebuffer needs */
+  modifier = DRM_FORMAT_MOD_LINEAR;
+  gst_structure_get_uint64 (gst_caps_get_structure (caps, 0), "drm-modifier",
+      &modifier);
+  if (modifier != DRM_FORMAT_MOD_LINEAR && !self->has_addfb2_modifiers)
+    goto modifier_unsupported;
+
   if (!gst_kms_sink_calculate_display_ratio (self, &vinfo))
     goto no_disp_ratio;
 
@@ -868,6 +979,7 @@ gst_kms_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
     goto modesetting_failed;
 
   self->vinfo = vinfo;
+  self->modifier = modifier;
 
   GST_DEBUG_OBJECT (self, "negotiated caps = %" GST_PTR_FORMAT, caps);
 
@@ -887,6 +999,14 @@ invalid_size:
     return FALSE;
   }
 
+modifier_unsupported:
+  {
+    GST_ELEMENT_ERROR (self, CORE, NEGOTIATION, (NULL),
+        ("driver cannot display buffers with DRM format modifier 0x%"
+            G_GINT64_MODIFIER "x", modifier));
+    return FALSE;
+  }
+
 no_disp_ratio:
   {
     GST_ELEMENT_ERROR (self, CORE, NEGOTIATION, (NULL),
@@ -981,15 +1101,36 @@ sync_handler (gint fd, guint frame, guint sec, guint usec, gpointer data)
 }
 
 static gboolean
-gst_kms_sink_sync (GstKMSSink * self)
+wait_for_events (GstKMSSink * self, gboolean * waiting)
 {
   gint ret;
-  gboolean waiting;
   drmEventContext evctxt = {
     .version = DRM_EVENT_CONTEXT_VERSION,
     .page_flip_handler = sync_handler,
     .vblank_handler = sync_handler,
   };
+
+  while (*waiting) {
+    do {
+      ret = gst_poll_wait (self->poll, 3 * GST_SECOND);
+    } while (ret == -1 && (errno == EAGAIN || errno == EINTR));
+
+    ret = drmHandleEvent (self->fd, &evctxt);
+    if (ret) {
+      GST_ERROR_OBJECT (self, "drmHandleEvent failed: %s (%d)",
+          strerror (-ret), ret);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static gboolean
+wait_vblank (GstKMSSink * self)
+{
+  gint ret;
+  gboolean waiting;
   drmVBlank vbl = {
     .request = {
           .type = DRM_VBLANK_RELATIVE | DRM_VBLANK_EVENT,
@@ -1004,48 +1145,98 @@ gst_kms_sink_sync (GstKMSSink * self)
     vbl.request.type |= self->pipe << DRM_VBLANK_HIGH_CRTC_SHIFT;
 
   waiting = TRUE;
-  if (!self->has_async_page_flip && !self->modesetting_enabled) {
-    ret = drmWaitVBlank (self->fd, &vbl);
-    if (ret)
-      goto vblank_failed;
-  } else {
-    ret = drmModePageFlip (self->fd, self->crtc_id, self->buffer_id,
-        DRM_MODE_PAGE_FLIP_EVENT, &waiting);
-    if (ret)
-      goto pageflip_failed;
+  ret = drmWaitVBlank (self->fd, &vbl);
+  if (ret) {
+    GST_WARNING_OBJECT (self, "drmWaitVBlank failed: %s (%d)", strerror (-ret),
+        ret);
+    return FALSE;
   }
 
-  while (waiting) {
-    do {
-      ret = gst_poll_wait (self->poll, 3 * GST_SECOND);
-    } while (ret == -1 && (errno == EAGAIN || errno == EINTR));
+  return wait_for_events (self, &waiting);
+}
 
-    ret = drmHandleEvent (self->fd, &evctxt);
-    if (ret)
-      goto event_failed;
-  }
+static gboolean
+gst_kms_sink_sync (GstKMSSink * self)
+{
+  gint ret;
+  gboolean waiting;
 
-  return TRUE;
+  if (!self->has_async_page_flip && !self->modesetting_enabled)
+    return wait_vblank (self);
 
-  /* ERRORS */
-vblank_failed:
-  {
-    GST_WARNING_OBJECT (self, "drmWaitVBlank failed: %s (%d)", strerror (-ret),
-        ret);
-    return FALSE;
-  }
-pageflip_failed:
-  {
+  waiting = TRUE;
+  ret = drmModePageFlip (self->fd, self->crtc_id, self->buffer_id,
+      DRM_MODE_PAGE_FLIP_EVENT, &waiting);
+  if (ret) {
     GST_WARNING_OBJECT (self, "drmModePageFlip failed: %s (%d)",
         strerror (-ret), ret);
     return FALSE;
   }
-event_failed:
-  {
-    GST_ERROR_OBJECT (self, "drmHandleEvent failed: %s (%d)", strerror (-ret),
-        ret);
-    return FALSE;
+
+  return wait_for_events (self, &waiting);
+}
+
+/* Waits until the last atomic commit is on screen, and releases the buffer
+ * it replaced */
+static gboolean
+gst_kms_sink_wait_flip (GstKMSSink * self)
+{
+  gboolean ret = TRUE;
+
+  if (self->flip_pending) {
+    ret = wait_for_events (self, &self->flip_pending);
+    self->flip_pending = FALSE;
+  }
+  gst_buffer_replace (&self->previous_buffer, NULL);
+
+  return ret;
+}
+
+/* Queues @fb_id on the plane for the next vblank, without waiting for it */
+static gint
+gst_kms_sink_commit_plane (GstKMSSink * self, guint32 fb_id,
+    GstVideoRectangle * dst, GstVideoRectangle * src)
+{
+  drmModeAtomicReqPtr req;
+  guint32 plane = self->plane_id;
+  gint ret, tries;
+
+  req = drmModeAtomicAlloc ();
+  if (!req)
+    return -ENOMEM;
+
+  drmModeAtomicAddProperty (req, plane, self->plane_props.fb_id, fb_id);
+  drmModeAtomicAddProperty (req, plane, self->plane_props.crtc_id,
+      self->crtc_id);
+  drmModeAtomicAddProperty (req, plane, self->plane_props.crtc_x, dst->x);
+  drmModeAtomicAddProperty (req, plane, self->plane_props.crtc_y, dst->y);
+  drmModeAtomicAddProperty (req, plane, self->plane_props.crtc_w, dst->w);
+  drmModeAtomicAddProperty (req, plane, self->plane_props.crtc_h, dst->h);
+  /* source/cropping coordinates are given in Q16 */
+  drmModeAtomicAddProperty (req, plane, self->plane_props.src_x, src->x << 16);
+  drmModeAtomicAddProperty (req, plane, self->plane_props.src_y, src->y << 16);
+  drmModeAtomicAddProperty (req, plane, self->plane_props.src_w, src->w << 16);
+  drmModeAtomicAddProperty (req, plane, self->plane_props.src_h, src->h << 16);
+
+  /* a commit of another sink on the same crtc can still be pending, in
+   * which case it is done by the next vblank */
+  for (tries = 0; tries < 3; tries++) {
+    self->flip_pending = TRUE;
+    ret = drmModeAtomicCommit (self->fd, req,
+        DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT,
+        &self->flip_pending);
+    if (ret != -EBUSY)
+      break;
+    GST_DEBUG_OBJECT (self, "crtc busy, retrying on the next vblank");
+    if (!wait_vblank (self))
+      break;
   }
+  if (ret)
+    self->flip_pending = FALSE;
+
+  drmModeAtomicFree (req);
+
+  return ret;
 }
 
 static gboolean
@@ -1124,7 +1315,7 @@ gst_kms_sink_import_dmabuf (GstKMSSink * self, GstBuffer * inbuf,
       prime_fds[1], prime_fds[2], prime_fds[3]);
 
   kmsmem = gst_kms_allocator_dmabuf_import (self->allocator,
-      prime_fds, n_planes, mems_skip, &self->vinfo);
+      prime_fds, n_planes, mems_skip, &self->vinfo, self->modifier);
   if (!kmsmem)
     return FALSE;
 
@@ -1224,6 +1415,14 @@ gst_kms_sink_get_input_buffer (GstKMSSink * self, GstBuffer * inbuf)
   if (gst_kms_sink_import_dmabuf (self, inbuf, &buf))
     return buf;
 
+  /* a copy of the mapped memory would show the layout as if it were
+   * linear */
+  if (self->modifier != DRM_FORMAT_MOD_LINEAR) {
+    GST_ERROR_OBJECT (self, "could not import buffer with modifier 0x%"
+        G_GINT64_MODIFIER "x", self->modifier);
+    return NULL;
+  }
+
   GST_CAT_INFO_OBJECT (CAT_PERFORMANCE, self, "frame copy");
 
   return gst_kms_sink_copy_to_dumb_buffer (self, inbuf);
@@ -1278,6 +1477,11 @@ gst_kms_sink_show_frame (GstVideoSink * vsink, GstBuffer * buf)
   dst.w = self->hdisplay;
   dst.h = self->vdisplay;
 
+  /* only one commit can be pending at a time, so this waits for the vblank
+   * of the previous frame, not of this one */
+  if (self->has_atomic && !gst_kms_sink_wait_flip (self))
+    goto bail;
+
 retry_set_plane:
   gst_video_sink_center_rect (src, dst, &result, self->can_scale);
 
@@ -1293,10 +1497,13 @@ retry_set_plane:
       "drmModeSetPlane at (%i,%i) %ix%i sourcing at (%i,%i) %ix%i",
       result.x, result.y, result.w, result.h, src.x, src.y, src.w, src.h);
 
-  ret = drmModeSetPlane (self->fd, self->plane_id, self->crtc_id, fb_id, 0,
-      result.x, result.y, result.w, result.h,
-      /* source/cropping coordinates are given in Q16 */
-      src.x << 16, src.y << 16, src.w << 16, src.h << 16);
+  if (self->has_atomic)
+    ret = gst_kms_sink_commit_plane (self, fb_id, &result, &src);
+  else
+    ret = drmModeSetPlane (self->fd, self->plane_id, self->crtc_id, fb_id, 0,
+        result.x, result.y, result.w, result.h,
+        /* source/cropping coordinates are given in Q16 */
+        src.x << 16, src.y << 16, src.w << 16, src.h << 16);
   if (ret) {
     if (self->can_scale) {
       self->can_scale = FALSE;
@@ -1305,6 +1512,14 @@ retry_set_plane:
     goto set_plane_failed;
   }
 
+  if (self->has_atomic) {
+    /* the current buffer stays on screen until the commit completes */
+    self->previous_buffer = self->last_buffer;
+    self->last_buffer = gst_buffer_ref (buffer);
+    res = GST_FLOW_OK;
+    goto bail;
+  }
+
 sync_frame:
   /* Wait for the previous frame to complete redraw */
   if (!gst_kms_sink_sync (self))
@@ -1332,7 +1547,8 @@ set_plane_failed:
         result.w, result.h, src.x, src.y, src.w, src.h, dst.x, dst.y, dst.w,
         dst.h);
     GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
-        (NULL), ("drmModeSetPlane failed: %s (%d)", strerror (-ret), ret));
+        (NULL), ("%s failed: %s (%d)", self->has_atomic ?
+            "drmModeAtomicCommit" : "drmModeSetPlane", strerror (-ret), ret));
     goto bail;
   }
 no_disp_ratio:
@@ -1350,6 +1566,8 @@ gst_kms_sink_drain (GstKMSSink * self)
 
   GST_DEBUG_OBJECT (self, "draining");
 
+  gst_kms_sink_wait_flip (self);
+
   if (!self->last_buffer)
     return;
 
@@ -61,12 +61,15 @@ struct _GstKMSSink {
   /* capabilities */
   gboolean has_prime_import;
   gboolean has_prime_export;
+  gboolean has_addfb2_modifiers;
   gboolean has_async_page_flip;
   gboolean can_scale;
 
   gboolean modesetting_enabled;
 
   GstVideoInfo vinfo;
+  /* DRM format modifier of the negotiated dmabufs */
+  guint64 modifier;
   GstCaps *allowed_caps;
   GstBufferPool *pool;
   GstAllocator *allocator;
@@ -80,6 +83,17 @@ struct _GstKMSSink {
 
   GstPoll *poll;
   GstPollFD pollfd;
+
+  /* atomic modesetting */
+  gboolean has_atomic;
+  struct {
+    guint32 fb_id, crtc_id;
+    guint32 src_x, src_y, src_w, src_h;
+    guint32 crtc_x, crtc_y, crtc_w, crtc_h;
+  } plane_props;
+  gboolean flip_pending;
+  /* the buffer on screen until the pending commit completes */
+  GstBuffer *previous_buffer;
 };
 
 struct _GstKMSSinkClass {
@@ -237,7 +237,13 @@ gst_msdkdec_init_decoder (GstMsdkDec * thiz)
   /* make sure that the decoder is closed */
   gst_msdkdec_close_decoder (thiz);
 
-  thiz->context = msdk_open_context (thiz->hardware);
+  if (thiz->hardware && thiz->shared_context) {
+    thiz->context = msdk_open_joined_context (thiz->shared_context);
+    if (!thiz->context)
+      GST_WARNING_OBJECT (thiz, "Failed to join the shared session");
+  }
+  if (!thiz->context)
+    thiz->context = msdk_open_context (thiz->hardware);
   if (!thiz->context) {
     GST_ERROR_OBJECT (thiz, "Context creation failed");
     return FALSE;
@@ -446,10 +452,30 @@ gst_msdkdec_close (GstVideoDecoder * decoder)
   return TRUE;
 }
 
+static gboolean
+gst_msdkdec_start (GstVideoDecoder * decoder)
+{
+  GstMsdkDec *thiz = GST_MSDKDEC (decoder);
+
+  /* Join the session of the other elements on the device, or share one
+   * for them to join */
+  if (thiz->hardware
+      && !msdk_context_find (GST_ELEMENT_CAST (thiz), &thiz->shared_context)) {
+    thiz->shared_context = msdk_open_context (TRUE);
+    if (thiz->shared_context)
+      msdk_context_propagate (GST_ELEMENT_CAST (thiz), thiz->shared_context);
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_msdkdec_stop (GstVideoDecoder * decoder)
 {
   GstMsdkDec *thiz = GST_MSDKDEC (decoder);
+
+  msdk_close_context (thiz->shared_context);
+  thiz->shared_context = NULL;
   if (thiz->input_state) {
     gst_video_codec_state_unref (thiz->input_state);
     thiz->input_state = NULL;
@@ -805,6 +831,41 @@ gst_msdkdec_finalize (GObject * object)
   g_array_unref (thiz->surfaces);
   g_array_unref (thiz->tasks);
   g_ptr_array_unref (thiz->extra_params);
+  msdk_close_context (thiz->shared_context);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gboolean
+gst_msdkdec_src_query (GstVideoDecoder * decoder, GstQuery * query)
+{
+  GstMsdkDec *thiz = GST_MSDKDEC (decoder);
+
+  if (msdk_context_handle_query (query, thiz->shared_context))
+    return TRUE;
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->src_query (decoder, query);
+}
+
+static gboolean
+gst_msdkdec_sink_query (GstVideoDecoder * decoder, GstQuery * query)
+{
+  GstMsdkDec *thiz = GST_MSDKDEC (decoder);
+
+  if (msdk_context_handle_query (query, thiz->shared_context))
+    return TRUE;
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->sink_query (decoder, query);
+}
+
+static void
+gst_msdkdec_set_context (GstElement * element, GstContext * context)
+{
+  GstMsdkDec *thiz = GST_MSDKDEC (element);
+
+  msdk_context_set (context, &thiz->shared_context);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
 }
 
 static void
@@ -822,7 +883,10 @@ gst_msdkdec_class_init (GstMsdkDecClass * klass)
   gobject_class->get_property = gst_msdkdec_get_property;
   gobject_class->finalize = gst_msdkdec_finalize;
 
+  element_class->set_context = GST_DEBUG_FUNCPTR (gst_msdkdec_set_context);
+
   decoder_class->close = GST_DEBUG_FUNCPTR (gst_msdkdec_close);
+  decoder_class->start = GST_DEBUG_FUNCPTR (gst_msdkdec_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_msdkdec_stop);
   decoder_class->set_format = GST_DEBUG_FUNCPTR (gst_msdkdec_set_format);
   decoder_class->finish = GST_DEBUG_FUNCPTR (gst_msdkdec_finish);
@@ -831,6 +895,8 @@ gst_msdkdec_class_init (GstMsdkDecClass * klass)
       GST_DEBUG_FUNCPTR (gst_msdkdec_decide_allocation);
   decoder_class->flush = GST_DEBUG_FUNCPTR (gst_msdkdec_flush);
   decoder_class->drain = GST_DEBUG_FUNCPTR (gst_msdkdec_drain);
+  decoder_class->src_query = GST_DEBUG_FUNCPTR (gst_msdkdec_src_query);
+  decoder_class->sink_query = GST_DEBUG_FUNCPTR (gst_msdkdec_sink_query);
 
   g_object_class_install_property (gobject_class, PROP_HARDWARE,
       g_param_spec_boolean ("hardware", "Hardware", "Enable hardware decoders",
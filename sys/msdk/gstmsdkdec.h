@@ -67,6 +67,8 @@ struct _GstMsdkDec
 
   /* MFX context */
   MsdkContext *context;
+  /* context shared with the other elements, joined by this one */
+  MsdkContext *shared_context;
   mfxVideoParam param;
   GPtrArray *extra_params;
   GArray *surfaces;
@@ -92,7 +92,9 @@ enum
   PROP_GOP_SIZE,
   PROP_REF_FRAMES,
   PROP_I_FRAMES,
-  PROP_B_FRAMES
+  PROP_B_FRAMES,
+  PROP_LOOKAHEAD_DEPTH,
+  PROP_ICQ_QUALITY
 };
 
 #define PROP_HARDWARE_DEFAULT            TRUE
@@ -107,6 +109,8 @@ enum
 #define PROP_REF_FRAMES_DEFAULT          1
 #define PROP_I_FRAMES_DEFAULT            0
 #define PROP_B_FRAMES_DEFAULT            0
+#define PROP_LOOKAHEAD_DEPTH_DEFAULT     0
+#define PROP_ICQ_QUALITY_DEFAULT         23
 
 #define GST_MSDKENC_RATE_CONTROL_TYPE (gst_msdkenc_rate_control_get_type())
 static GType
@@ -119,6 +123,9 @@ gst_msdkenc_rate_control_get_type (void)
     {MFX_RATECONTROL_VBR, "Variable Bitrate", "vbr"},
     {MFX_RATECONTROL_CQP, "Constant Quantizer", "cqp"},
     {MFX_RATECONTROL_AVBR, "Average Bitrate", "avbr"},
+    {MFX_RATECONTROL_LA, "VBR with look ahead (Non HRD compliant)", "la_vbr"},
+    {MFX_RATECONTROL_ICQ, "Intelligent CQP", "icq"},
+    {MFX_RATECONTROL_LA_ICQ, "Intelligent CQP with look ahead", "la_icq"},
     {0, NULL, NULL}
   };
 
@@ -159,7 +166,13 @@ gst_msdkenc_init_encoder (GstMsdkEnc * thiz)
   /* make sure that the encoder is closed */
   gst_msdkenc_close_encoder (thiz);
 
-  thiz->context = msdk_open_context (thiz->hardware);
+  if (thiz->hardware && thiz->shared_context) {
+    thiz->context = msdk_open_joined_context (thiz->shared_context);
+    if (!thiz->context)
+      GST_WARNING_OBJECT (thiz, "Failed to join the shared session");
+  }
+  if (!thiz->context)
+    thiz->context = msdk_open_context (thiz->hardware);
   if (!thiz->context) {
     GST_ERROR_OBJECT (thiz, "Context creation failed");
     return FALSE;
@@ -183,6 +196,9 @@ gst_msdkenc_init_encoder (GstMsdkEnc * thiz)
     thiz->param.mfx.QPI = thiz->qpi;
     thiz->param.mfx.QPP = thiz->qpp;
     thiz->param.mfx.QPB = thiz->qpb;
+  } else if (thiz->rate_control == MFX_RATECONTROL_ICQ ||
+      thiz->rate_control == MFX_RATECONTROL_LA_ICQ) {
+    thiz->param.mfx.ICQQuality = thiz->icq_quality;
   }
 
   thiz->param.mfx.FrameInfo.Width = GST_ROUND_UP_32 (info->width);
@@ -204,6 +220,15 @@ gst_msdkenc_init_encoder (GstMsdkEnc * thiz)
       goto failed;
   }
 
+  memset (&thiz->option2, 0, sizeof (thiz->option2));
+  if (thiz->rate_control == MFX_RATECONTROL_LA ||
+      thiz->rate_control == MFX_RATECONTROL_LA_ICQ) {
+    thiz->option2.Header.BufferId = MFX_EXTBUFF_CODING_OPTION2;
+    thiz->option2.Header.BufferSz = sizeof (thiz->option2);
+    thiz->option2.LookAheadDepth = thiz->lookahead_depth;
+    gst_msdkenc_add_extra_param (thiz, (mfxExtBuffer *) & thiz->option2);
+  }
+
   if (thiz->num_extra_params) {
     thiz->param.NumExtParam = thiz->num_extra_params;
     thiz->param.ExtParam = thiz->extra_params;
@@ -263,8 +288,8 @@ gst_msdkenc_init_encoder (GstMsdkEnc * thiz)
       surface->Data.UV = data + Y_size;
     }
 
-    GST_DEBUG_OBJECT (thiz,
-        "Allocated aligned memory, pixel data will be copied");
+    GST_DEBUG_OBJECT (thiz, "Allocated aligned memory, pixel data will be "
+        "copied unless the frames are padded");
   }
 
   GST_DEBUG_OBJECT (thiz, "Required %d surfaces (%d suggested), allocated %d",
@@ -302,6 +327,8 @@ gst_msdkenc_init_encoder (GstMsdkEnc * thiz)
         thiz->param.mfx.BufferSizeInKB * 1024;
   }
   thiz->next_task = 0;
+  thiz->oldest_task = 0;
+  gst_msdkenc_start_sync_thread (thiz);
 
   thiz->reconfig = FALSE;
 
@@ -327,6 +354,8 @@ gst_msdkenc_close_encoder (GstMsdkEnc * thiz)
 
   GST_DEBUG_OBJECT (thiz, "Closing encoder 0x%p", thiz->context);
 
+  gst_msdkenc_stop_sync_thread (thiz);
+
   status = MFXVideoENCODE_Close (msdk_context_get_session (thiz->context));
   if (status != MFX_ERR_NONE && status != MFX_ERR_NOT_INITIALIZED) {
     GST_WARNING_OBJECT (thiz, "Encoder close failed (%s)",
@@ -419,30 +448,99 @@ gst_msdkenc_dequeue_all_frames (GstMsdkEnc * thiz)
   thiz->pending_frames = NULL;
 }
 
-static MsdkEncTask *
-gst_msdkenc_get_free_task (GstMsdkEnc * thiz)
+static gpointer
+gst_msdkenc_sync_thread (GstMsdkEnc * thiz)
 {
-  MsdkEncTask *tasks = thiz->tasks;
-  guint size = thiz->num_tasks;
-  guint start = thiz->next_task;
-  guint i;
+  mfxSession session = msdk_context_get_session (thiz->context);
+  mfxSyncPoint sync_point;
+  mfxStatus status;
+  MsdkEncTask *task;
 
-  if (tasks) {
-    for (i = 0; i < size; i++) {
-      guint t = (start + i) % size;
-      if (tasks[t].sync_point == NULL)
-        return &tasks[t];
+  g_mutex_lock (&thiz->task_lock);
+  while (thiz->sync_running) {
+    task = &thiz->tasks[thiz->sync_task];
+    if (!task->sync_point || task->synced) {
+      g_cond_wait (&thiz->task_cond, &thiz->task_lock);
+      continue;
     }
+    sync_point = task->sync_point;
+    g_mutex_unlock (&thiz->task_lock);
+
+    /* Wait for encoding operation to complete */
+    status = MFXVideoCORE_SyncOperation (session, sync_point, 10000);
+    if (status != MFX_ERR_NONE)
+      GST_WARNING_OBJECT (thiz, "Sync operation failed (%s)",
+          msdk_status_to_string (status));
+
+    g_mutex_lock (&thiz->task_lock);
+    task->synced = TRUE;
+    thiz->sync_task = (thiz->sync_task + 1) % thiz->num_tasks;
+    g_cond_broadcast (&thiz->task_cond);
   }
+  g_mutex_unlock (&thiz->task_lock);
+
   return NULL;
 }
 
+static void
+gst_msdkenc_start_sync_thread (GstMsdkEnc * thiz)
+{
+  thiz->sync_task = 0;
+  thiz->sync_running = TRUE;
+  thiz->sync_thread = g_thread_new ("msdkenc-sync",
+      (GThreadFunc) gst_msdkenc_sync_thread, thiz);
+}
+
+static void
+gst_msdkenc_stop_sync_thread (GstMsdkEnc * thiz)
+{
+  if (!thiz->sync_thread)
+    return;
+
+  g_mutex_lock (&thiz->task_lock);
+  thiz->sync_running = FALSE;
+  g_cond_broadcast (&thiz->task_cond);
+  g_mutex_unlock (&thiz->task_lock);
+
+  g_thread_join (thiz->sync_thread);
+  thiz->sync_thread = NULL;
+}
+
+static guint
+gst_msdkenc_count_busy_tasks (GstMsdkEnc * thiz)
+{
+  guint i, n = 0;
+
+  for (i = 0; i < thiz->num_tasks; i++)
+    if (thiz->tasks[i].sync_point)
+      n++;
+
+  return n;
+}
+
+/* The outputs come in the order the frames were submitted, so a new one
+ * belongs to the oldest frame that has no task yet. Frames kept by the
+ * encoder for lookahead or reordering don't have one */
+static GstVideoCodecFrame *
+gst_msdkenc_get_unassigned_frame (GstMsdkEnc * thiz)
+{
+  GstVideoCodecFrame *frame;
+  GList *frames;
+
+  frames = gst_video_encoder_get_frames (GST_VIDEO_ENCODER (thiz));
+  frame = g_list_nth_data (frames, gst_msdkenc_count_busy_tasks (thiz));
+  g_list_free_full (frames, (GDestroyNotify) gst_video_codec_frame_unref);
+
+  return frame;
+}
+
 static void
 gst_msdkenc_reset_task (MsdkEncTask * task)
 {
   task->input_frame = NULL;
   task->output_bitstream.DataLength = 0;
   task->sync_point = NULL;
+  task->synced = FALSE;
 }
 
 static GstFlowReturn
@@ -455,9 +553,16 @@ gst_msdkenc_finish_frame (GstMsdkEnc * thiz, MsdkEncTask * task,
     return GST_FLOW_OK;
   }
 
-  /* Wait for encoding operation to complete */
-  MFXVideoCORE_SyncOperation (msdk_context_get_session (thiz->context),
-      task->sync_point, 10000);
+  if (G_UNLIKELY (!frame)) {
+    GST_WARNING_OBJECT (thiz, "Dropping an output without input frame");
+    discard = TRUE;
+  }
+
+  g_mutex_lock (&thiz->task_lock);
+  while (!task->synced && thiz->sync_running)
+    g_cond_wait (&thiz->task_cond, &thiz->task_lock);
+  g_mutex_unlock (&thiz->task_lock);
+
   if (!discard && task->output_bitstream.DataLength) {
     GstBuffer *out_buf = NULL;
     guint8 *data =
@@ -477,46 +582,97 @@ gst_msdkenc_finish_frame (GstMsdkEnc * thiz, MsdkEncTask * task,
         (task->output_bitstream.FrameType & MFX_FRAMETYPE_xIDR) != 0) {
       GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
     }
-
-    /* Mark task as available */
-    gst_msdkenc_reset_task (task);
   }
 
+  /* Mark task as available */
+  g_mutex_lock (&thiz->task_lock);
+  gst_msdkenc_reset_task (task);
+  thiz->oldest_task = ((task - thiz->tasks) + 1) % thiz->num_tasks;
+  g_mutex_unlock (&thiz->task_lock);
+
+  if (G_UNLIKELY (!frame))
+    return GST_FLOW_OK;
+
   gst_msdkenc_dequeue_frame (thiz, frame);
   return gst_video_encoder_finish_frame (GST_VIDEO_ENCODER (thiz), frame);
 }
 
+/* Pushes the frames the sync thread is done with, without waiting */
 static GstFlowReturn
-gst_msdkenc_encode_frame (GstMsdkEnc * thiz, mfxFrameSurface1 * surface,
-    GstVideoCodecFrame * input_frame)
+gst_msdkenc_finish_ready_frames (GstMsdkEnc * thiz)
 {
-  mfxSession session;
+  GstFlowReturn ret = GST_FLOW_OK;
   MsdkEncTask *task;
-  mfxStatus status;
+  gboolean ready;
 
-  if (G_UNLIKELY (thiz->context == NULL)) {
-    gst_msdkenc_dequeue_frame (thiz, input_frame);
-    gst_video_encoder_finish_frame (GST_VIDEO_ENCODER (thiz), input_frame);
-    return GST_FLOW_NOT_NEGOTIATED;
+  while (ret == GST_FLOW_OK) {
+    task = &thiz->tasks[thiz->oldest_task];
+
+    g_mutex_lock (&thiz->task_lock);
+    ready = task->sync_point && task->synced;
+    g_mutex_unlock (&thiz->task_lock);
+    if (!ready)
+      break;
+
+    ret = gst_msdkenc_finish_frame (thiz, task, FALSE);
   }
-  session = msdk_context_get_session (thiz->context);
 
-  task = gst_msdkenc_get_free_task (thiz);
+  return ret;
+}
+
+/* Submits @surface, or drains the encoder when it is NULL. Returns
+ * MFX_ERR_MORE_DATA when no output is ready yet */
+static mfxStatus
+gst_msdkenc_submit_surface (GstMsdkEnc * thiz, mfxFrameSurface1 * surface,
+    GstFlowReturn * ret)
+{
+  mfxSession session = msdk_context_get_session (thiz->context);
+  mfxSyncPoint sync_point = NULL;
+  MsdkEncTask *task;
+  mfxStatus status;
+
+  /* all the tasks are in use, wait for the oldest one */
+  task = &thiz->tasks[thiz->next_task];
+  if (task->sync_point)
+    *ret = gst_msdkenc_finish_frame (thiz, task, FALSE);
 
   for (;;) {
     status = MFXVideoENCODE_EncodeFrameAsync (session, NULL, surface,
-        &task->output_bitstream, &task->sync_point);
+        &task->output_bitstream, &sync_point);
     if (status != MFX_WRN_DEVICE_BUSY)
       break;
     /* If device is busy, wait 1ms and retry, as per MSDK's recomendation */
     g_usleep (1000);
   };
 
-  if (task->sync_point) {
-    task->input_frame = input_frame;
+  if (sync_point) {
+    GstVideoCodecFrame *frame = gst_msdkenc_get_unassigned_frame (thiz);
+
+    g_mutex_lock (&thiz->task_lock);
+    task->input_frame = frame;
+    task->sync_point = sync_point;
+    g_cond_broadcast (&thiz->task_cond);
+    g_mutex_unlock (&thiz->task_lock);
     thiz->next_task = ((task - thiz->tasks) + 1) % thiz->num_tasks;
   }
 
+  return status;
+}
+
+static GstFlowReturn
+gst_msdkenc_encode_frame (GstMsdkEnc * thiz, mfxFrameSurface1 * surface,
+    GstVideoCodecFrame * input_frame)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  mfxStatus status;
+
+  if (G_UNLIKELY (thiz->context == NULL)) {
+    gst_msdkenc_dequeue_frame (thiz, input_frame);
+    gst_video_encoder_finish_frame (GST_VIDEO_ENCODER (thiz), input_frame);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  status = gst_msdkenc_submit_surface (thiz, surface, &ret);
   if (status != MFX_ERR_NONE && status != MFX_ERR_MORE_DATA) {
     GST_ELEMENT_ERROR (thiz, STREAM, ENCODE, ("Encode frame failed."),
         ("MSDK encode return code=%d", status));
@@ -525,15 +681,16 @@ gst_msdkenc_encode_frame (GstMsdkEnc * thiz, mfxFrameSurface1 * surface,
     return GST_FLOW_ERROR;
   }
 
-  /* Ensure that next task is available */
-  task = thiz->tasks + thiz->next_task;
-  return gst_msdkenc_finish_frame (thiz, task, FALSE);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  return gst_msdkenc_finish_ready_frames (thiz);
 }
 
 static guint
 gst_msdkenc_maximum_delayed_frames (GstMsdkEnc * thiz)
 {
-  return thiz->num_tasks;
+  return thiz->num_tasks + thiz->option2.LookAheadDepth;
 }
 
 static void
@@ -566,15 +723,22 @@ gst_msdkenc_set_latency (GstMsdkEnc * thiz)
 static void
 gst_msdkenc_flush_frames (GstMsdkEnc * thiz, gboolean discard)
 {
-  guint i, t = thiz->next_task;
+  GstFlowReturn ret = GST_FLOW_OK;
+  mfxStatus status;
+  guint i;
 
   if (!thiz->tasks)
     return;
 
-  for (i = 0; i < thiz->num_tasks; i++) {
-    gst_msdkenc_finish_frame (thiz, &thiz->tasks[t], discard);
-    t = (t + 1) % thiz->num_tasks;
+  /* get the frames kept for lookahead and reordering out of the encoder */
+  if (!discard) {
+    do {
+      status = gst_msdkenc_submit_surface (thiz, NULL, &ret);
+    } while (status == MFX_ERR_NONE);
   }
+
+  for (i = 0; i < thiz->num_tasks; i++)
+    gst_msdkenc_finish_frame (thiz, &thiz->tasks[thiz->oldest_task], discard);
 }
 
 static gboolean
@@ -693,6 +857,17 @@ invalid_frame:
 static gboolean
 gst_msdkenc_start (GstVideoEncoder * encoder)
 {
+  GstMsdkEnc *thiz = GST_MSDKENC (encoder);
+
+  /* Join the session of the other elements on the device, or share one
+   * for them to join */
+  if (thiz->hardware
+      && !msdk_context_find (GST_ELEMENT_CAST (thiz), &thiz->shared_context)) {
+    thiz->shared_context = msdk_open_context (TRUE);
+    if (thiz->shared_context)
+      msdk_context_propagate (GST_ELEMENT_CAST (thiz), thiz->shared_context);
+  }
+
   /* Set the minimum pts to some huge value (1000 hours). This keeps
      the dts at the start of the stream from needing to be
      negative. */
@@ -714,6 +889,9 @@ gst_msdkenc_stop (GstVideoEncoder * encoder)
     gst_video_codec_state_unref (thiz->input_state);
   thiz->input_state = NULL;
 
+  msdk_close_context (thiz->shared_context);
+  thiz->shared_context = NULL;
+
   return TRUE;
 }
 
@@ -745,23 +923,86 @@ static gboolean
 gst_msdkenc_propose_allocation (GstVideoEncoder * encoder, GstQuery * query)
 {
   GstMsdkEnc *thiz = GST_MSDKENC (encoder);
-  GstVideoInfo *info;
-  guint num_buffers;
+  GstVideoInfo info;
+  GstVideoAlignment align;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstCaps *caps;
+  guint num_buffers, i;
 
   gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
 
   if (!thiz->input_state)
     return FALSE;
 
-  info = &thiz->input_state->info;
+  info = thiz->input_state->info;
   num_buffers = gst_msdkenc_maximum_delayed_frames (thiz) + 1;
 
-  gst_query_add_allocation_pool (query, NULL, info->size, num_buffers, 0);
+  /* Pad the frames to the surface size, so that the encoder can read them
+   * in place instead of copying them to its own surfaces */
+  gst_video_alignment_reset (&align);
+  align.padding_right = GST_ROUND_UP_32 (info.width) - info.width;
+  align.padding_bottom = GST_ROUND_UP_32 (info.height) - info.height;
+  for (i = 0; i < GST_VIDEO_MAX_PLANES; i++)
+    align.stride_align[i] = 31;
+  gst_video_info_align (&info, &align);
+
+  caps = gst_video_info_to_caps (&thiz->input_state->info);
+  pool = gst_video_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, info.size, num_buffers, 0);
+  gst_buffer_pool_config_add_option (config,
+      GST_BUFFER_POOL_OPTION_VIDEO_META);
+  gst_buffer_pool_config_add_option (config,
+      GST_BUFFER_POOL_OPTION_VIDEO_ALIGNMENT);
+  gst_buffer_pool_config_set_video_alignment (config, &align);
+  gst_caps_unref (caps);
+
+  if (gst_buffer_pool_set_config (pool, config)) {
+    gst_query_add_allocation_pool (query, pool, info.size, num_buffers, 0);
+  } else {
+    GST_WARNING_OBJECT (thiz, "Failed to configure the padded buffer pool");
+    gst_query_add_allocation_pool (query, NULL,
+        thiz->input_state->info.size, num_buffers, 0);
+  }
+  gst_object_unref (pool);
 
   return GST_VIDEO_ENCODER_CLASS (parent_class)->propose_allocation (encoder,
       query);
 }
 
+static gboolean
+gst_msdkenc_src_query (GstVideoEncoder * encoder, GstQuery * query)
+{
+  GstMsdkEnc *thiz = GST_MSDKENC (encoder);
+
+  if (msdk_context_handle_query (query, thiz->shared_context))
+    return TRUE;
+
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->src_query (encoder, query);
+}
+
+static gboolean
+gst_msdkenc_sink_query (GstVideoEncoder * encoder, GstQuery * query)
+{
+  GstMsdkEnc *thiz = GST_MSDKENC (encoder);
+
+  if (msdk_context_handle_query (query, thiz->shared_context))
+    return TRUE;
+
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->sink_query (encoder, query);
+}
+
+static void
+gst_msdkenc_set_context (GstElement * element, GstContext * context)
+{
+  GstMsdkEnc *thiz = GST_MSDKENC (element);
+
+  msdk_context_set (context, &thiz->shared_context);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
 static void
 gst_msdkenc_set_property (GObject * object, guint prop_id, const GValue * value,
     GParamSpec * pspec)
@@ -814,6 +1055,12 @@ gst_msdkenc_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_B_FRAMES:
       thiz->b_frames = g_value_get_uint (value);
       break;
+    case PROP_LOOKAHEAD_DEPTH:
+      thiz->lookahead_depth = g_value_get_uint (value);
+      break;
+    case PROP_ICQ_QUALITY:
+      thiz->icq_quality = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -873,6 +1120,12 @@ gst_msdkenc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_B_FRAMES:
       g_value_set_uint (value, thiz->b_frames);
       break;
+    case PROP_LOOKAHEAD_DEPTH:
+      g_value_set_uint (value, thiz->lookahead_depth);
+      break;
+    case PROP_ICQ_QUALITY:
+      g_value_set_uint (value, thiz->icq_quality);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -889,6 +1142,12 @@ gst_msdkenc_finalize (GObject * object)
     gst_video_codec_state_unref (thiz->input_state);
   thiz->input_state = NULL;
 
+  msdk_close_context (thiz->shared_context);
+  thiz->shared_context = NULL;
+
+  g_mutex_clear (&thiz->task_lock);
+  g_cond_clear (&thiz->task_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -907,12 +1166,16 @@ gst_msdkenc_class_init (GstMsdkEncClass * klass)
   gobject_class->get_property = gst_msdkenc_get_property;
   gobject_class->finalize = gst_msdkenc_finalize;
 
+  element_class->set_context = GST_DEBUG_FUNCPTR (gst_msdkenc_set_context);
+
   gstencoder_class->set_format = GST_DEBUG_FUNCPTR (gst_msdkenc_set_format);
   gstencoder_class->handle_frame = GST_DEBUG_FUNCPTR (gst_msdkenc_handle_frame);
   gstencoder_class->start = GST_DEBUG_FUNCPTR (gst_msdkenc_start);
   gstencoder_class->stop = GST_DEBUG_FUNCPTR (gst_msdkenc_stop);
   gstencoder_class->flush = GST_DEBUG_FUNCPTR (gst_msdkenc_flush);
   gstencoder_class->finish = GST_DEBUG_FUNCPTR (gst_msdkenc_finish);
+  gstencoder_class->src_query = GST_DEBUG_FUNCPTR (gst_msdkenc_src_query);
+  gstencoder_class->sink_query = GST_DEBUG_FUNCPTR (gst_msdkenc_sink_query);
   gstencoder_class->propose_allocation =
       GST_DEBUG_FUNCPTR (gst_msdkenc_propose_allocation);
 
@@ -982,6 +1245,18 @@ gst_msdkenc_class_init (GstMsdkEncClass * klass)
           0, G_MAXINT, PROP_B_FRAMES_DEFAULT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_LOOKAHEAD_DEPTH,
+      g_param_spec_uint ("lookahead-depth", "Lookahead Depth",
+          "Number of frames to look ahead with the la_vbr and la_icq rate "
+          "controls (0 = let the SDK choose)",
+          0, 100, PROP_LOOKAHEAD_DEPTH_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ICQ_QUALITY,
+      g_param_spec_uint ("icq-quality", "ICQ Quality",
+          "Quality factor of the icq and la_icq rate controls, lower is better",
+          1, 51, PROP_ICQ_QUALITY_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_static_pad_template (element_class, &sink_factory);
 }
@@ -1001,4 +1276,8 @@ gst_msdkenc_init (GstMsdkEnc * thiz)
   thiz->ref_frames = PROP_REF_FRAMES_DEFAULT;
   thiz->i_frames = PROP_I_FRAMES_DEFAULT;
   thiz->b_frames = PROP_B_FRAMES_DEFAULT;
+  thiz->lookahead_depth = PROP_LOOKAHEAD_DEPTH_DEFAULT;
+  thiz->icq_quality = PROP_ICQ_QUALITY_DEFAULT;
+  g_mutex_init (&thiz->task_lock);
+  g_cond_init (&thiz->task_cond);
 }
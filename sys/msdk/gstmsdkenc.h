@@ -70,12 +70,26 @@ struct _GstMsdkEnc
 
   /* MFX context */
   MsdkContext *context;
+  /* context shared with the other elements, joined by this one */
+  MsdkContext *shared_context;
   mfxVideoParam param;
   guint num_surfaces;
   mfxFrameSurface1 *surfaces;
   guint num_tasks;
   MsdkEncTask *tasks;
   guint next_task;
+  /* the task of the first frame to finish */
+  guint oldest_task;
+
+  /* waits for the submitted tasks to complete, so that the streaming thread
+   * only waits for the device when all the tasks are in use */
+  GThread *sync_thread;
+  GMutex task_lock;
+  GCond task_cond;
+  gboolean sync_running;
+  guint sync_task;
+
+  mfxExtCodingOption2 option2;
 
   mfxExtBuffer *extra_params[MAX_EXTRA_PARAMS];
   guint num_extra_params;
@@ -94,6 +108,8 @@ struct _GstMsdkEnc
   guint ref_frames;
   guint i_frames;
   guint b_frames;
+  guint lookahead_depth;
+  guint icq_quality;
 
   gboolean reconfig;
 };
@@ -112,6 +128,9 @@ struct _MsdkEncTask
   GstVideoCodecFrame *input_frame;
   mfxSyncPoint sync_point;
   mfxBitstream output_bitstream;
+  /* set by the sync thread once the encoding completed, protected by the
+   * task_lock like sync_point */
+  gboolean synced;
 };
 
 GType gst_msdkenc_get_type (void);
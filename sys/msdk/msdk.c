@@ -70,6 +70,35 @@ msdk_get_free_surface (mfxFrameSurface1 * surfaces, guint size)
   return (idx == INVALID_INDEX ? NULL : &surfaces[idx]);
 }
 
+/* Whether the encoder can read the NV12 @frame in place: both planes must
+ * share the stride and hold the rows up to the aligned height of the
+ * surface, which the pool proposed by the encoder pads them to */
+static gboolean
+msdk_frame_fits_surface (GstVideoFrame * frame, mfxFrameSurface1 * surface)
+{
+  gsize y_size, uv_size;
+  guint8 *y, *uv;
+  gint stride;
+  GstMapInfo *map;
+
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  if (stride != GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1) ||
+      stride < surface->Info.Width)
+    return FALSE;
+
+  /* the planes have to be in the same memory to bound them */
+  if (gst_buffer_n_memory (frame->buffer) != 1)
+    return FALSE;
+
+  y = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  uv = GST_VIDEO_FRAME_PLANE_DATA (frame, 1);
+  y_size = stride * (gsize) surface->Info.Height;
+  uv_size = stride * (gsize) (surface->Info.Height / 2);
+  map = &frame->map[0];
+
+  return uv >= y + y_size && uv + uv_size <= map->data + map->size;
+}
+
 /* FIXME: Only NV12 is supported by now, add other YUV formats */
 void
 msdk_frame_to_surface (GstVideoFrame * frame, mfxFrameSurface1 * surface)
@@ -79,13 +108,19 @@ msdk_frame_to_surface (GstVideoFrame * frame, mfxFrameSurface1 * surface)
   guint width, height;
   guint i;
 
-  if (!surface->Data.MemId) {
+  if (!surface->Data.MemId || msdk_frame_fits_surface (frame, surface)) {
     surface->Data.Y = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
     surface->Data.UV = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
     surface->Data.Pitch = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
     return;
   }
 
+  /* the surface may have pointed to a frame before */
+  surface->Data.Y = (mfxU8 *) surface->Data.MemId;
+  surface->Data.UV = surface->Data.Y + surface->Info.Width *
+      surface->Info.Height;
+  surface->Data.Pitch = surface->Info.Width;
+
   /* Y Plane */
   width = GST_VIDEO_FRAME_COMP_WIDTH (frame, 0);
   height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 0);
@@ -257,3 +292,134 @@ msdk_is_available (void)
   msdk_close_session (session);
   return TRUE;
 }
+
+G_DEFINE_BOXED_TYPE (MsdkContext, msdk_context, msdk_context_ref,
+    msdk_close_context);
+
+static gboolean
+context_pad_query (const GValue * item, GValue * value, gpointer user_data)
+{
+  GstPad *pad = g_value_get_object (item);
+  GstQuery *query = user_data;
+
+  if (gst_pad_peer_query (pad, query)) {
+    g_value_set_boolean (value, TRUE);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+context_run_query (GstElement * element, GstQuery * query,
+    GstPadDirection direction)
+{
+  GstIterator *it;
+  GValue res = G_VALUE_INIT;
+
+  g_value_init (&res, G_TYPE_BOOLEAN);
+  g_value_set_boolean (&res, FALSE);
+
+  if (direction == GST_PAD_SRC)
+    it = gst_element_iterate_src_pads (element);
+  else
+    it = gst_element_iterate_sink_pads (element);
+
+  while (gst_iterator_fold (it, context_pad_query, &res, query) ==
+      GST_ITERATOR_RESYNC)
+    gst_iterator_resync (it);
+
+  gst_iterator_free (it);
+
+  return g_value_get_boolean (&res);
+}
+
+void
+msdk_context_set (GstContext * gst_context, MsdkContext ** context)
+{
+  const GstStructure *s;
+  MsdkContext *shared = NULL;
+
+  if (!gst_context || g_strcmp0 (gst_context_get_context_type (gst_context),
+          MSDK_CONTEXT_TYPE_NAME) != 0)
+    return;
+
+  s = gst_context_get_structure (gst_context);
+  if (!gst_structure_get (s, "context", MSDK_TYPE_CONTEXT, &shared, NULL))
+    return;
+
+  msdk_close_context (*context);
+  *context = shared;
+}
+
+/* Looks for a context shared by the neighbouring elements or the
+ * application, following the GstContext negotiation */
+gboolean
+msdk_context_find (GstElement * element, MsdkContext ** context)
+{
+  GstQuery *query;
+  GstContext *gst_context = NULL;
+  GstMessage *msg;
+
+  if (*context)
+    return TRUE;
+
+  query = gst_query_new_context (MSDK_CONTEXT_TYPE_NAME);
+  if (context_run_query (element, query, GST_PAD_SRC) ||
+      context_run_query (element, query, GST_PAD_SINK)) {
+    gst_query_parse_context (query, &gst_context);
+    GST_INFO_OBJECT (element, "found a shared context in a query");
+    gst_element_set_context (element, gst_context);
+  }
+  gst_query_unref (query);
+
+  if (!*context) {
+    /* the application can answer synchronously from the bus */
+    msg = gst_message_new_need_context (GST_OBJECT_CAST (element),
+        MSDK_CONTEXT_TYPE_NAME);
+    gst_element_post_message (element, msg);
+  }
+
+  return *context != NULL;
+}
+
+void
+msdk_context_propagate (GstElement * element, MsdkContext * context)
+{
+  GstContext *gst_context;
+  GstStructure *s;
+  GstMessage *msg;
+
+  gst_context = gst_context_new (MSDK_CONTEXT_TYPE_NAME, TRUE);
+  s = gst_context_writable_structure (gst_context);
+  gst_structure_set (s, "context", MSDK_TYPE_CONTEXT, context, NULL);
+
+  gst_element_set_context (element, gst_context);
+
+  GST_INFO_OBJECT (element, "posting have context message");
+  msg = gst_message_new_have_context (GST_OBJECT_CAST (element), gst_context);
+  gst_element_post_message (element, msg);
+}
+
+gboolean
+msdk_context_handle_query (GstQuery * query, MsdkContext * context)
+{
+  GstContext *gst_context;
+  const gchar *type;
+  GstStructure *s;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_CONTEXT || !context)
+    return FALSE;
+
+  if (!gst_query_parse_context_type (query, &type) ||
+      g_strcmp0 (type, MSDK_CONTEXT_TYPE_NAME) != 0)
+    return FALSE;
+
+  gst_context = gst_context_new (MSDK_CONTEXT_TYPE_NAME, TRUE);
+  s = gst_context_writable_structure (gst_context);
+  gst_structure_set (s, "context", MSDK_TYPE_CONTEXT, context, NULL);
+  gst_query_set_context (query, gst_context);
+  gst_context_unref (gst_context);
+
+  return TRUE;
+}
@@ -57,9 +57,22 @@ void msdk_close_session (mfxSession session);
 gboolean msdk_is_available (void);
 
 MsdkContext *msdk_open_context (gboolean hardware);
+MsdkContext *msdk_open_joined_context (MsdkContext * parent);
+MsdkContext *msdk_context_ref (MsdkContext * context);
 void msdk_close_context (MsdkContext * context);
 mfxSession msdk_context_get_session (MsdkContext * context);
 
+/* sharing of a context between the elements of a pipeline */
+#define MSDK_CONTEXT_TYPE_NAME "gst.msdk.Context"
+
+#define MSDK_TYPE_CONTEXT (msdk_context_get_type ())
+GType msdk_context_get_type (void);
+
+gboolean msdk_context_find (GstElement * element, MsdkContext ** context);
+void msdk_context_propagate (GstElement * element, MsdkContext * context);
+void msdk_context_set (GstContext * gst_context, MsdkContext ** context);
+gboolean msdk_context_handle_query (GstQuery * query, MsdkContext * context);
+
 mfxFrameSurface1 *msdk_get_free_surface (mfxFrameSurface1 * surfaces,
     guint size);
 void msdk_frame_to_surface (GstVideoFrame * frame, mfxFrameSurface1 * surface);
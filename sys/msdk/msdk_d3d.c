@@ -31,20 +31,91 @@
 
 #include "msdk.h"
 
+GST_DEBUG_CATEGORY_EXTERN (gst_msdkenc_debug);
+#define GST_CAT_DEFAULT gst_msdkenc_debug
+
+struct _MsdkContext
+{
+  gint ref_count;
+  mfxSession session;
+  /* the context this one is joined to */
+  MsdkContext *parent;
+};
+
 MsdkContext *
 msdk_open_context (gboolean hardware)
 {
-  return (MsdkContext *) msdk_open_session (hardware);
+  MsdkContext *context;
+  mfxSession session;
+
+  session = msdk_open_session (hardware);
+  if (!session)
+    return NULL;
+
+  context = g_slice_new0 (MsdkContext);
+  context->ref_count = 1;
+  context->session = session;
+
+  return context;
+}
+
+MsdkContext *
+msdk_open_joined_context (MsdkContext * parent)
+{
+  MsdkContext *context;
+  mfxIMPL implementation;
+  mfxStatus status;
+
+  g_return_val_if_fail (parent != NULL, NULL);
+
+  /* sessions are joined to the one that was opened first */
+  while (parent->parent)
+    parent = parent->parent;
+
+  status = MFXQueryIMPL (parent->session, &implementation);
+  if (status != MFX_ERR_NONE)
+    return NULL;
+
+  context = msdk_open_context (MFX_IMPL_BASETYPE (implementation) !=
+      MFX_IMPL_SOFTWARE);
+  if (!context)
+    return NULL;
+
+  status = MFXJoinSession (parent->session, context->session);
+  if (status != MFX_ERR_NONE) {
+    GST_ERROR ("Joining session failed (%s)", msdk_status_to_string (status));
+    msdk_close_context (context);
+    return NULL;
+  }
+
+  context->parent = msdk_context_ref (parent);
+
+  return context;
+}
+
+MsdkContext *
+msdk_context_ref (MsdkContext * context)
+{
+  g_atomic_int_inc (&context->ref_count);
+  return context;
 }
 
 void
 msdk_close_context (MsdkContext * context)
 {
-  msdk_close_session ((mfxSession) context);
+  if (!context || !g_atomic_int_dec_and_test (&context->ref_count))
+    return;
+
+  if (context->parent)
+    MFXDisjoinSession (context->session);
+  msdk_close_session (context->session);
+  if (context->parent)
+    msdk_close_context (context->parent);
+  g_slice_free (MsdkContext, context);
 }
 
 mfxSession
 msdk_context_get_session (MsdkContext * context)
 {
-  return (mfxSession) context;
+  return context->session;
 }
@@ -45,9 +45,12 @@ GST_DEBUG_CATEGORY_EXTERN (gst_msdkenc_debug);
 
 struct _MsdkContext
 {
+  gint ref_count;
   mfxSession session;
   gint fd;
   VADisplay dpy;
+  /* the context this one is joined to, which owns the display */
+  MsdkContext *parent;
 };
 
 static gboolean
@@ -103,6 +106,7 @@ MsdkContext *
 msdk_open_context (gboolean hardware)
 {
   MsdkContext *context = g_slice_new0 (MsdkContext);
+  context->ref_count = 1;
   context->fd = -1;
 
   context->session = msdk_open_session (hardware);
@@ -122,17 +126,83 @@ failed:
   return NULL;
 }
 
+/* Opens a session on the device of @parent and joins it to the session of
+ * @parent, so that they share the scheduler and can exchange surfaces */
+MsdkContext *
+msdk_open_joined_context (MsdkContext * parent)
+{
+  MsdkContext *context;
+  mfxStatus status;
+
+  g_return_val_if_fail (parent != NULL, NULL);
+
+  /* sessions are joined to the one that was opened first */
+  while (parent->parent)
+    parent = parent->parent;
+
+  context = g_slice_new0 (MsdkContext);
+  context->ref_count = 1;
+  context->fd = -1;
+
+  context->session = msdk_open_session (parent->dpy != NULL);
+  if (!context->session)
+    goto failed;
+
+  if (parent->dpy) {
+    status = MFXVideoCORE_SetHandle (context->session, MFX_HANDLE_VA_DISPLAY,
+        (mfxHDL) parent->dpy);
+    if (status != MFX_ERR_NONE) {
+      GST_ERROR ("Setting VAAPI handle failed (%s)",
+          msdk_status_to_string (status));
+      goto failed;
+    }
+  }
+
+  status = MFXJoinSession (parent->session, context->session);
+  if (status != MFX_ERR_NONE) {
+    GST_ERROR ("Joining session failed (%s)", msdk_status_to_string (status));
+    goto failed;
+  }
+
+  context->parent = msdk_context_ref (parent);
+
+  return context;
+
+failed:
+  msdk_close_session (context->session);
+  g_slice_free (MsdkContext, context);
+  return NULL;
+}
+
+MsdkContext *
+msdk_context_ref (MsdkContext * context)
+{
+  g_atomic_int_inc (&context->ref_count);
+  return context;
+}
+
 void
 msdk_close_context (MsdkContext * context)
 {
-  if (!context)
+  mfxStatus status;
+
+  if (!context || !g_atomic_int_dec_and_test (&context->ref_count))
     return;
 
+  if (context->parent) {
+    status = MFXDisjoinSession (context->session);
+    if (status != MFX_ERR_NONE)
+      GST_WARNING ("Disjoining session failed (%s)",
+          msdk_status_to_string (status));
+  }
+
   msdk_close_session (context->session);
   if (context->dpy)
     vaTerminate (context->dpy);
   if (context->fd >= 0)
     close (context->fd);
+  if (context->parent)
+    msdk_close_context (context->parent);
   g_slice_free (MsdkContext, context);
 }
 
@@ -50,6 +50,16 @@ typedef struct _GstNvDecQueueItem
 GST_DEBUG_CATEGORY_STATIC (gst_nvdec_debug_category);
 #define GST_CAT_DEFAULT gst_nvdec_debug_category
 
+enum
+{
+  PROP_0,
+  PROP_NUM_DECODE_SURFACES,
+  PROP_CUDA_DEVICE_ID
+};
+
+#define DEFAULT_NUM_DECODE_SURFACES 20
+#define DEFAULT_CUDA_DEVICE_ID 0
+
 static inline gboolean
 cuda_OK (CUresult result)
 {
@@ -67,6 +77,36 @@ cuda_OK (CUresult result)
 
 G_DEFINE_TYPE (GstNvDecCudaContext, gst_nvdec_cuda_context, G_TYPE_OBJECT);
 
+/* The number of decoders using each CUDA device, for picking the least
+ * loaded device */
+static GMutex device_decoders_lock;
+static GHashTable *device_decoders;
+
+static guint
+get_device_decoders (CUdevice device)
+{
+  if (!device_decoders)
+    return 0;
+
+  return GPOINTER_TO_UINT (g_hash_table_lookup (device_decoders,
+          GINT_TO_POINTER (device)));
+}
+
+static void
+add_device_decoders (CUdevice device, gint n)
+{
+  guint decoders;
+
+  g_mutex_lock (&device_decoders_lock);
+  if (!device_decoders)
+    device_decoders = g_hash_table_new (NULL, NULL);
+  decoders = get_device_decoders (device);
+  g_assert (n > 0 || decoders > 0);
+  g_hash_table_insert (device_decoders, GINT_TO_POINTER (device),
+      GUINT_TO_POINTER (decoders + n));
+  g_mutex_unlock (&device_decoders_lock);
+}
+
 static void
 gst_nvdec_cuda_context_finalize (GObject * object)
 {
@@ -81,11 +121,12 @@ gst_nvdec_cuda_context_finalize (GObject * object)
   }
 
   if (self->context) {
-    GST_DEBUG ("destroying CUDA context");
-    if (cuda_OK (cuCtxDestroy (self->context)))
+    GST_DEBUG ("releasing CUDA context");
+    if (cuda_OK (cuDevicePrimaryCtxRelease (self->device)))
       self->context = NULL;
     else
-      GST_ERROR ("failed to destroy CUDA context");
+      GST_ERROR ("failed to release CUDA context");
+    add_device_decoders (self->device, -1);
   }
 
   G_OBJECT_CLASS (gst_nvdec_cuda_context_parent_class)->finalize (object);
@@ -100,17 +141,71 @@ gst_nvdec_cuda_context_class_init (GstNvDecCudaContextClass * klass)
 static void
 gst_nvdec_cuda_context_init (GstNvDecCudaContext * self)
 {
-  if (!cuda_OK (cuInit (0)))
+}
+
+/* Picks the device with the fewest decoders of this process */
+static gboolean
+select_device (CUdevice * device)
+{
+  CUdevice dev;
+  gint count = 0, i;
+  guint decoders, min_decoders = G_MAXUINT;
+
+  if (!cuda_OK (cuDeviceGetCount (&count)))
+    return FALSE;
+
+  g_mutex_lock (&device_decoders_lock);
+  for (i = 0; i < count; i++) {
+    if (!cuda_OK (cuDeviceGet (&dev, i)))
+      continue;
+    decoders = get_device_decoders (dev);
+    GST_DEBUG ("device %d has %u decoder(s)", i, decoders);
+    if (decoders < min_decoders) {
+      *device = dev;
+      min_decoders = decoders;
+    }
+  }
+  g_mutex_unlock (&device_decoders_lock);
+
+  return min_decoders != G_MAXUINT;
+}
+
+/* Creates a context on the CUDA device @device_id, or on the least loaded
+ * device if @device_id is -1. Check the context and lock fields for
+ * failures. */
+static GstNvDecCudaContext *
+gst_nvdec_cuda_context_new (gint device_id)
+{
+  GstNvDecCudaContext *self =
+      g_object_new (gst_nvdec_cuda_context_get_type (), NULL);
+
+  if (!cuda_OK (cuInit (0))) {
     GST_ERROR ("failed to init CUDA");
+    return self;
+  }
 
-  if (!cuda_OK (cuCtxCreate (&self->context, CU_CTX_SCHED_AUTO, 0)))
-    GST_ERROR ("failed to create CUDA context");
+  if (device_id < 0) {
+    if (!select_device (&self->device)) {
+      GST_ERROR ("failed to find a CUDA device");
+      return self;
+    }
+  } else if (!cuda_OK (cuDeviceGet (&self->device, device_id))) {
+    GST_ERROR ("failed to get CUDA device %d", device_id);
+    return self;
+  }
 
-  if (!cuda_OK (cuCtxPopCurrent (NULL)))
-    GST_ERROR ("failed to pop current CUDA context");
+  /* the primary context of the device is shared with nvenc, so that the
+   * decoders and encoders of a transcode don't switch contexts */
+  if (!cuda_OK (cuDevicePrimaryCtxRetain (&self->context, self->device))) {
+    GST_ERROR ("failed to retain CUDA context");
+    return self;
+  }
+  add_device_decoders (self->device, 1);
 
   if (!cuda_OK (cuvidCtxLockCreate (&self->lock, self->context)))
     GST_ERROR ("failed to create CUDA context lock");
+
+  return self;
 }
 
 typedef struct _GstNvDecCudaGraphicsResourceInfo
@@ -216,6 +311,10 @@ static gboolean gst_nvdec_decide_allocation (GstVideoDecoder * decoder,
 static void gst_nvdec_set_context (GstElement * element, GstContext * context);
 static gboolean gst_nvdec_src_query (GstVideoDecoder * decoder,
     GstQuery * query);
+static void gst_nvdec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_nvdec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstStaticPadTemplate gst_nvdec_sink_template =
     GST_STATIC_PAD_TEMPLATE (GST_VIDEO_DECODER_SINK_NAME,
@@ -230,7 +329,8 @@ static GstStaticPadTemplate gst_nvdec_src_template =
 GST_STATIC_PAD_TEMPLATE (GST_VIDEO_DECODER_SRC_NAME,
     GST_PAD_SRC, GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
-        (GST_CAPS_FEATURE_MEMORY_GL_MEMORY, "NV12") ", texture-target=2D")
+        (GST_CAPS_FEATURE_MEMORY_GL_MEMORY, "NV12") ", texture-target=2D; "
+        GST_VIDEO_CAPS_MAKE ("NV12"))
     );
 
 G_DEFINE_TYPE_WITH_CODE (GstNvDec, gst_nvdec, GST_TYPE_VIDEO_DECODER,
@@ -240,9 +340,27 @@ G_DEFINE_TYPE_WITH_CODE (GstNvDec, gst_nvdec, GST_TYPE_VIDEO_DECODER,
 static void
 gst_nvdec_class_init (GstNvDecClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstVideoDecoderClass *video_decoder_class = GST_VIDEO_DECODER_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
 
+  gobject_class->set_property = gst_nvdec_set_property;
+  gobject_class->get_property = gst_nvdec_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_NUM_DECODE_SURFACES,
+      g_param_spec_uint ("num-decode-surfaces", "Number of decode surfaces",
+          "Number of surfaces the decoder decodes into. Fewer surfaces "
+          "lower the memory use and latency, more allow the decoder to "
+          "run further ahead of the output", 1, 32,
+          DEFAULT_NUM_DECODE_SURFACES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CUDA_DEVICE_ID,
+      g_param_spec_int ("cuda-device-id", "CUDA device ID",
+          "The GPU device to decode on, "
+          "-1 for the device with the fewest decoders of this process",
+          -1, G_MAXINT, DEFAULT_CUDA_DEVICE_ID,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class,
       &gst_nvdec_sink_template);
   gst_element_class_add_static_pad_template (element_class,
@@ -269,6 +387,55 @@ gst_nvdec_init (GstNvDec * nvdec)
 {
   gst_video_decoder_set_packetized (GST_VIDEO_DECODER (nvdec), TRUE);
   gst_video_decoder_set_needs_format (GST_VIDEO_DECODER (nvdec), TRUE);
+
+  nvdec->num_decode_surfaces = DEFAULT_NUM_DECODE_SURFACES;
+  nvdec->cuda_device_id = DEFAULT_CUDA_DEVICE_ID;
+}
+
+static void
+gst_nvdec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstNvDec *nvdec = GST_NVDEC (object);
+
+  switch (prop_id) {
+    case PROP_NUM_DECODE_SURFACES:
+      GST_OBJECT_LOCK (nvdec);
+      nvdec->num_decode_surfaces = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (nvdec);
+      break;
+    case PROP_CUDA_DEVICE_ID:
+      GST_OBJECT_LOCK (nvdec);
+      nvdec->cuda_device_id = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (nvdec);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_nvdec_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstNvDec *nvdec = GST_NVDEC (object);
+
+  switch (prop_id) {
+    case PROP_NUM_DECODE_SURFACES:
+      GST_OBJECT_LOCK (nvdec);
+      g_value_set_uint (value, nvdec->num_decode_surfaces);
+      GST_OBJECT_UNLOCK (nvdec);
+      break;
+    case PROP_CUDA_DEVICE_ID:
+      GST_OBJECT_LOCK (nvdec);
+      g_value_set_int (value, nvdec->cuda_device_id);
+      GST_OBJECT_UNLOCK (nvdec);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static gboolean
@@ -301,7 +468,7 @@ parser_sequence_callback (GstNvDec * nvdec, CUVIDEOFORMAT * format)
     GST_DEBUG_OBJECT (nvdec, "creating decoder");
     create_info.ulWidth = width;
     create_info.ulHeight = height;
-    create_info.ulNumDecodeSurfaces = 20;
+    create_info.ulNumDecodeSurfaces = nvdec->parser_decode_surfaces;
     create_info.CodecType = format->codec;
     create_info.ChromaFormat = format->chroma_format;
     create_info.ulCreationFlags = cudaVideoCreate_Default;
@@ -385,9 +552,13 @@ static gboolean
 gst_nvdec_start (GstVideoDecoder * decoder)
 {
   GstNvDec *nvdec = GST_NVDEC (decoder);
+  gint device_id;
 
   GST_DEBUG_OBJECT (nvdec, "creating CUDA context");
-  nvdec->cuda_context = g_object_new (gst_nvdec_cuda_context_get_type (), NULL);
+  GST_OBJECT_LOCK (nvdec);
+  device_id = nvdec->cuda_device_id;
+  GST_OBJECT_UNLOCK (nvdec);
+  nvdec->cuda_context = gst_nvdec_cuda_context_new (device_id);
   nvdec->decode_queue = g_async_queue_new ();
 
   if (!nvdec->cuda_context->context || !nvdec->cuda_context->lock) {
@@ -538,7 +709,12 @@ gst_nvdec_set_format (GstVideoDecoder * decoder, GstVideoCodecState * state)
     return FALSE;
   }
 
-  parser_params.ulMaxNumDecodeSurfaces = 20;
+  /* the decoder must provide as many surfaces as the parser hands out
+   * picture indices, so a new value only applies to the next parser */
+  GST_OBJECT_LOCK (nvdec);
+  nvdec->parser_decode_surfaces = nvdec->num_decode_surfaces;
+  GST_OBJECT_UNLOCK (nvdec);
+  parser_params.ulMaxNumDecodeSurfaces = nvdec->parser_decode_surfaces;
   parser_params.ulErrorThreshold = 100;
   parser_params.ulMaxDisplayDelay = 0;
   parser_params.ulClockRate = GST_SECOND;
@@ -627,6 +803,108 @@ unlock_cuda_context:
     GST_WARNING_OBJECT (nvdec, "failed to unlock CUDA context");
 }
 
+static gboolean
+copy_video_frame_to_system_memory (GstNvDec * nvdec,
+    CUVIDPARSERDISPINFO * dispinfo, GstBuffer * buffer)
+{
+  GstVideoCodecState *state;
+  GstVideoFrame vframe;
+  CUVIDPROCPARAMS proc_params = { 0, };
+  CUdeviceptr dptr;
+  guint pitch, i;
+  CUDA_MEMCPY2D mcpy2d = { 0, };
+  gboolean ret = FALSE;
+
+  GST_LOG_OBJECT (nvdec, "picture index: %u", dispinfo->picture_index);
+
+  state = gst_video_decoder_get_output_state (GST_VIDEO_DECODER (nvdec));
+  if (!state)
+    return FALSE;
+
+  if (!gst_video_frame_map (&vframe, &state->info, buffer, GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (nvdec, "failed to map output buffer");
+    gst_video_codec_state_unref (state);
+    return FALSE;
+  }
+
+  proc_params.progressive_frame = dispinfo->progressive_frame;
+  proc_params.top_field_first = dispinfo->top_field_first;
+  proc_params.unpaired_field = dispinfo->repeat_first_field == -1;
+
+  if (!cuda_OK (cuvidCtxLock (nvdec->cuda_context->lock, 0))) {
+    GST_WARNING_OBJECT (nvdec, "failed to lock CUDA context");
+    goto unmap_output_frame;
+  }
+
+  if (!cuda_OK (cuvidMapVideoFrame (nvdec->decoder, dispinfo->picture_index,
+              &dptr, &pitch, &proc_params))) {
+    GST_WARNING_OBJECT (nvdec, "failed to map CUDA video frame");
+    goto unlock_cuda_context;
+  }
+
+  /* copy the planes straight from the decoded surface into the output
+   * buffer, the chroma plane follows the luma plane in the surface */
+  mcpy2d.srcMemoryType = CU_MEMORYTYPE_DEVICE;
+  mcpy2d.srcPitch = pitch;
+  mcpy2d.dstMemoryType = CU_MEMORYTYPE_HOST;
+
+  ret = TRUE;
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&vframe); i++) {
+    mcpy2d.srcDevice = dptr + (i * pitch * nvdec->height);
+    mcpy2d.dstHost = GST_VIDEO_FRAME_PLANE_DATA (&vframe, i);
+    mcpy2d.dstPitch = GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, i);
+    mcpy2d.WidthInBytes = GST_VIDEO_FRAME_COMP_WIDTH (&vframe, i) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (&vframe, i);
+    mcpy2d.Height = GST_VIDEO_FRAME_COMP_HEIGHT (&vframe, i);
+
+    if (!cuda_OK (cuMemcpy2D (&mcpy2d))) {
+      GST_WARNING_OBJECT (nvdec, "memcpy to system memory failed");
+      ret = FALSE;
+      break;
+    }
+  }
+
+  if (!cuda_OK (cuvidUnmapVideoFrame (nvdec->decoder, dptr)))
+    GST_WARNING_OBJECT (nvdec, "failed to unmap CUDA video frame");
+
+unlock_cuda_context:
+  if (!cuda_OK (cuvidCtxUnlock (nvdec->cuda_context->lock, 0)))
+    GST_WARNING_OBJECT (nvdec, "failed to unlock CUDA context");
+
+unmap_output_frame:
+  gst_video_frame_unmap (&vframe);
+  gst_video_codec_state_unref (state);
+
+  return ret;
+}
+
+/* Whether downstream can take GL memory. Otherwise the frames are copied
+ * to system memory, which works without any GL display. */
+static gboolean
+downstream_supports_gl_memory (GstNvDec * nvdec)
+{
+  GstCaps *caps;
+  GstCapsFeatures *features;
+  gboolean ret = FALSE;
+  guint i;
+
+  caps = gst_pad_peer_query_caps (GST_VIDEO_DECODER_SRC_PAD (nvdec), NULL);
+  if (!caps)
+    return FALSE;
+
+  for (i = 0; !ret && i < gst_caps_get_size (caps); i++) {
+    features = gst_caps_get_features (caps, i);
+    ret = features && gst_caps_features_contains (features,
+        GST_CAPS_FEATURE_MEMORY_GL_MEMORY);
+  }
+  gst_caps_unref (caps);
+
+  GST_DEBUG_OBJECT (nvdec, "downstream %s GL memory",
+      ret ? "supports" : "does not support");
+
+  return ret;
+}
+
 static GstFlowReturn
 handle_pending_frames (GstNvDec * nvdec)
 {
@@ -681,6 +959,7 @@ handle_pending_frames (GstNvDec * nvdec)
           nvdec->height = height;
           nvdec->fps_n = fps_n;
           nvdec->fps_d = fps_d;
+          nvdec->use_gl = downstream_supports_gl_memory (nvdec);
 
           state = gst_video_decoder_set_output_state (decoder,
               GST_VIDEO_FORMAT_NV12, nvdec->width, nvdec->height,
@@ -691,10 +970,14 @@ handle_pending_frames (GstNvDec * nvdec)
               "height", G_TYPE_INT, nvdec->height,
               "framerate", GST_TYPE_FRACTION, nvdec->fps_n, nvdec->fps_d,
               "interlace-mode", G_TYPE_STRING, format->progressive_sequence
-              ? "progressive" : "interleaved",
-              "texture-target", G_TYPE_STRING, "2D", NULL);
-          gst_caps_set_features (state->caps, 0,
-              gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_GL_MEMORY, NULL));
+              ? "progressive" : "interleaved", NULL);
+          if (nvdec->use_gl) {
+            gst_caps_set_simple (state->caps, "texture-target", G_TYPE_STRING,
+                "2D", NULL);
+            gst_caps_set_features (state->caps, 0,
+                gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_GL_MEMORY,
+                    NULL));
+          }
           gst_video_codec_state_unref (state);
 
           if (!gst_video_decoder_negotiate (decoder)) {
@@ -765,6 +1048,13 @@ handle_pending_frames (GstNvDec * nvdec)
           break;
         }
 
+        if (!nvdec->use_gl) {
+          if (!copy_video_frame_to_system_memory (nvdec, dispinfo,
+                  pending_frame->output_buffer))
+            GST_WARNING_OBJECT (nvdec, "failed to copy the decoded frame");
+          goto output_frame;
+        }
+
         num_resources = gst_buffer_n_memory (pending_frame->output_buffer);
         resources = g_new (CUgraphicsResource, num_resources);
 
@@ -785,6 +1075,7 @@ handle_pending_frames (GstNvDec * nvdec)
             (GstGLContextThreadFunc) copy_video_frame_to_gl_textures, args);
         g_free (resources);
 
+      output_frame:
         if (!dispinfo->progressive_frame) {
           GST_BUFFER_FLAG_SET (pending_frame->output_buffer,
               GST_VIDEO_BUFFER_FLAG_INTERLACED);
@@ -868,6 +1159,11 @@ gst_nvdec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
 
   GST_DEBUG_OBJECT (nvdec, "decide allocation");
 
+  /* system memory output uses the default video buffer pool */
+  if (!nvdec->use_gl)
+    return GST_VIDEO_DECODER_CLASS (gst_nvdec_parent_class)->decide_allocation
+        (decoder, query);
+
   if (!gst_gl_ensure_element_data (nvdec, &nvdec->gl_display,
           &nvdec->other_gl_context)) {
     GST_ERROR_OBJECT (nvdec, "failed to ensure OpenGL display");
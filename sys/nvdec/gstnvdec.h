@@ -40,6 +40,7 @@ struct _GstNvDecCudaContext
 {
   GObject parent;
 
+  CUdevice device;
   CUcontext context;
   CUvideoctxlock lock;
 };
@@ -80,6 +81,14 @@ struct _GstNvDec
   guint fps_d;
   GstClockTime min_latency;
   GstVideoCodecState *input_state;
+
+  /* TRUE if the frames are output in GL memory, FALSE for system memory */
+  gboolean use_gl;
+  guint parser_decode_surfaces;
+
+  /* properties */
+  guint num_decode_surfaces;
+  gint cuda_device_id;
 };
 
 struct _GstNvDecClass
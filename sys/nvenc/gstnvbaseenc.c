@@ -168,6 +168,7 @@ enum
   PROP_QP_CONST,
 };
 
+#define DEFAULT_DEVICE_ID 0
 #define DEFAULT_PRESET GST_NV_PRESET_DEFAULT
 #define DEFAULT_BITRATE 0
 #define DEFAULT_RC_MODE GST_NV_RC_MODE_DEFAULT
@@ -184,7 +185,6 @@ G_LOCK_DEFINE_STATIC (initialization_lock);
 struct gl_input_resource
 {
   GstGLMemory *gl_mem[GST_VIDEO_MAX_PLANES];
-  struct cudaGraphicsResource *cuda_texture;
   gpointer cuda_plane_pointers[GST_VIDEO_MAX_PLANES];
   gpointer cuda_pointer;
   gsize cuda_stride;
@@ -192,6 +192,15 @@ struct gl_input_resource
   NV_ENC_REGISTER_RESOURCE nv_resource;
   NV_ENC_MAP_INPUT_RESOURCE nv_mapped_resource;
 };
+
+/* CUDA registration of the PBO of a GL memory, kept on the memory as
+ * registering is expensive and upstream pools recycle their memories */
+struct gl_registered_pbo
+{
+  GstGLContext *gl_context;
+  CUcontext cuda_ctx;
+  struct cudaGraphicsResource *cuda_resource;
+};
 #endif
 
 struct frame_state
@@ -253,10 +262,12 @@ gst_nv_base_enc_class_init (GstNvBaseEncClass * klass)
   gst_element_class_add_static_pad_template (element_class, &sink_factory);
 
   g_object_class_install_property (gobject_class, PROP_DEVICE_ID,
-      g_param_spec_uint ("cuda-device-id",
+      g_param_spec_int ("cuda-device-id",
           "Cuda Device ID",
-          "Set the GPU device to use for operations",
-          0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          "Set the GPU device to use for operations, "
+          "-1 for the device with the fewest encoders of this process",
+          -1, G_MAXINT, DEFAULT_DEVICE_ID,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (gobject_class, PROP_PRESET,
       g_param_spec_enum ("preset", "Encoding Preset",
           "Encoding Preset",
@@ -1430,6 +1441,67 @@ _plane_get_n_components (GstVideoInfo * info, guint plane)
 }
 
 #if HAVE_NVENC_GST_GL
+static void
+_unregister_pbo (GstGLContext * context, struct gl_registered_pbo *reg)
+{
+  cudaError_t cuda_ret;
+
+  cuCtxPushCurrent (reg->cuda_ctx);
+  cuda_ret = cudaGraphicsUnregisterResource (reg->cuda_resource);
+  if (cuda_ret != cudaSuccess)
+    GST_WARNING ("failed to unregister GL buffer from cuda ret :%d", cuda_ret);
+  cuCtxPopCurrent (NULL);
+}
+
+static void
+_free_registered_pbo (struct gl_registered_pbo *reg)
+{
+  gst_gl_context_thread_add (reg->gl_context,
+      (GstGLContextThreadFunc) _unregister_pbo, reg);
+  gst_nvenc_unref_cuda_context (reg->cuda_ctx);
+  gst_object_unref (reg->gl_context);
+  g_slice_free (struct gl_registered_pbo, reg);
+}
+
+/* Called from the GL thread with the CUDA context pushed */
+static struct cudaGraphicsResource *
+_ensure_registered_pbo (GstNvBaseEnc * nvenc, GstGLMemoryPBO * gl_mem)
+{
+  static GQuark quark = 0;
+  struct gl_registered_pbo *reg;
+  GstGLBuffer *gl_buf_obj = (GstGLBuffer *) gl_mem->pbo;
+  cudaError_t cuda_ret;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("GstNvBaseEncRegisteredPbo");
+
+  reg = gst_mini_object_get_qdata (GST_MINI_OBJECT (gl_mem), quark);
+  if (reg)
+    return reg->cuda_resource;
+
+  reg = g_slice_new0 (struct gl_registered_pbo);
+  cuda_ret = cudaGraphicsGLRegisterBuffer (&reg->cuda_resource,
+      gl_buf_obj->id, cudaGraphicsRegisterFlagsReadOnly);
+  if (cuda_ret != cudaSuccess) {
+    GST_ERROR_OBJECT (nvenc, "failed to register GL texture %u to cuda "
+        "ret :%d", gl_mem->mem.tex_id, cuda_ret);
+    g_slice_free (struct gl_registered_pbo, reg);
+    return NULL;
+  }
+
+  /* the registration can outlive the encoder */
+  reg->cuda_ctx = gst_nvenc_ref_cuda_context (nvenc->cuda_ctx);
+  reg->gl_context =
+      gst_object_ref (GST_GL_BASE_MEMORY_CAST (gl_mem)->context);
+  gst_mini_object_set_qdata (GST_MINI_OBJECT (gl_mem), quark, reg,
+      (GDestroyNotify) _free_registered_pbo);
+
+  GST_LOG_OBJECT (nvenc, "registered GL texture %u to cuda",
+      gl_mem->mem.tex_id);
+
+  return reg->cuda_resource;
+}
+
 struct map_gl_input
 {
   GstNvBaseEnc *nvenc;
@@ -1441,6 +1513,7 @@ struct map_gl_input
 static void
 _map_gl_input_buffer (GstGLContext * context, struct map_gl_input *data)
 {
+  struct cudaGraphicsResource *cuda_resource;
   cudaError_t cuda_ret;
   guint8 *data_pointer;
   guint i;
@@ -1470,17 +1543,11 @@ _map_gl_input_buffer (GstGLContext * context, struct map_gl_input *data)
     GST_LOG_OBJECT (data->nvenc, "attempting to copy texture %u into cuda",
         gl_mem->mem.tex_id);
 
-    cuda_ret =
-        cudaGraphicsGLRegisterBuffer (&data->in_gl_resource->cuda_texture,
-        gl_buf_obj->id, cudaGraphicsRegisterFlagsReadOnly);
-    if (cuda_ret != cudaSuccess) {
-      GST_ERROR_OBJECT (data->nvenc, "failed to register GL texture %u to cuda "
-          "ret :%d", gl_mem->mem.tex_id, cuda_ret);
+    cuda_resource = _ensure_registered_pbo (data->nvenc, gl_mem);
+    if (!cuda_resource)
       g_assert_not_reached ();
-    }
 
-    cuda_ret =
-        cudaGraphicsMapResources (1, &data->in_gl_resource->cuda_texture, 0);
+    cuda_ret = cudaGraphicsMapResources (1, &cuda_resource, 0);
     if (cuda_ret != cudaSuccess) {
       GST_ERROR_OBJECT (data->nvenc, "failed to map GL texture %u into cuda "
           "ret :%d", gl_mem->mem.tex_id, cuda_ret);
@@ -1490,7 +1557,7 @@ _map_gl_input_buffer (GstGLContext * context, struct map_gl_input *data)
     cuda_ret =
         cudaGraphicsResourceGetMappedPointer (&data->in_gl_resource->
         cuda_plane_pointers[i], &data->in_gl_resource->cuda_num_bytes,
-        data->in_gl_resource->cuda_texture);
+        cuda_resource);
     if (cuda_ret != cudaSuccess) {
       GST_ERROR_OBJECT (data->nvenc, "failed to get mapped pointer of map GL "
           "texture %u in cuda ret :%d", gl_mem->mem.tex_id, cuda_ret);
@@ -1512,22 +1579,13 @@ _map_gl_input_buffer (GstGLContext * context, struct map_gl_input *data)
       g_assert_not_reached ();
     }
 
-    cuda_ret =
-        cudaGraphicsUnmapResources (1, &data->in_gl_resource->cuda_texture, 0);
+    cuda_ret = cudaGraphicsUnmapResources (1, &cuda_resource, 0);
     if (cuda_ret != cudaSuccess) {
       GST_ERROR_OBJECT (data->nvenc, "failed to unmap GL texture %u from cuda "
           "ret :%d", gl_mem->mem.tex_id, cuda_ret);
       g_assert_not_reached ();
     }
 
-    cuda_ret =
-        cudaGraphicsUnregisterResource (data->in_gl_resource->cuda_texture);
-    if (cuda_ret != cudaSuccess) {
-      GST_ERROR_OBJECT (data->nvenc, "failed to unregister GL texture %u from "
-          "cuda ret :%d", gl_mem->mem.tex_id, cuda_ret);
-      g_assert_not_reached ();
-    }
-
     data_pointer =
         data_pointer +
         data->in_gl_resource->cuda_stride *
@@ -1871,7 +1929,7 @@ gst_nv_base_enc_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_DEVICE_ID:
-      nvenc->cuda_device_id = g_value_get_uint (value);
+      nvenc->cuda_device_id = g_value_get_int (value);
       break;
     case PROP_PRESET:
       nvenc->preset_enum = g_value_get_enum (value);
@@ -1906,7 +1964,7 @@ gst_nv_base_enc_get_property (GObject * object, guint prop_id, GValue * value,
 
   switch (prop_id) {
     case PROP_DEVICE_ID:
-      g_value_set_uint (value, nvenc->cuda_device_id);
+      g_value_set_int (value, nvenc->cuda_device_id);
       break;
     case PROP_PRESET:
       g_value_set_enum (value, nvenc->preset_enum);
@@ -253,15 +253,48 @@ gst_nvenc_get_nv_buffer_format (GstVideoFormat fmt)
   return NV_ENC_BUFFER_FORMAT_UNDEFINED;
 }
 
+/* The number of encoders using each CUDA device, for picking the least
+ * loaded device */
+static GMutex device_sessions_lock;
+static GHashTable *device_sessions;
+
+static guint
+get_device_sessions (CUdevice dev)
+{
+  if (!device_sessions)
+    return 0;
+
+  return GPOINTER_TO_UINT (g_hash_table_lookup (device_sessions,
+          GINT_TO_POINTER (dev)));
+}
+
+static void
+add_device_sessions (CUdevice dev, gint n)
+{
+  guint sessions;
+
+  g_mutex_lock (&device_sessions_lock);
+  if (!device_sessions)
+    device_sessions = g_hash_table_new (NULL, NULL);
+  sessions = get_device_sessions (dev);
+  g_assert (n > 0 || sessions > 0);
+  g_hash_table_insert (device_sessions, GINT_TO_POINTER (dev),
+      GUINT_TO_POINTER (sessions + n));
+  g_mutex_unlock (&device_sessions_lock);
+}
+
+/* Retains the primary context of the CUDA device @device_id, or of the
+ * NVENC capable device with the fewest encoders if @device_id is -1 */
 CUcontext
-gst_nvenc_create_cuda_context (guint device_id)
+gst_nvenc_create_cuda_context (gint device_id)
 {
-  CUcontext cuda_ctx, old_ctx;
+  CUcontext cuda_ctx;
   CUresult cres = CUDA_SUCCESS;
   CUdevice cdev = 0, cuda_dev = -1;
   int dev_count = 0;
   char name[256];
   int min = 0, maj = 0;
+  guint sessions, min_sessions = G_MAXUINT;
   int i;
 
   GST_INFO ("Initialising CUDA..");
@@ -282,17 +315,25 @@ gst_nvenc_create_cuda_context (guint device_id)
   }
 
   GST_INFO ("%d CUDA device(s) detected", dev_count);
+  g_mutex_lock (&device_sessions_lock);
   for (i = 0; i < dev_count; ++i) {
     if (cuDeviceGet (&cdev, i) == CUDA_SUCCESS
         && cuDeviceGetName (name, sizeof (name), cdev) == CUDA_SUCCESS
         && cuDeviceComputeCapability (&maj, &min, cdev) == CUDA_SUCCESS) {
-      GST_INFO ("GPU #%d supports NVENC: %s (%s) (Compute SM %d.%d)",
-          i, (((maj << 4) + min) >= 0x30) ? "yes" : "no", name, maj, min);
+      sessions = get_device_sessions (cdev);
+      GST_INFO ("GPU #%d supports NVENC: %s (%s) (Compute SM %d.%d), "
+          "%u encoder(s)", i, (((maj << 4) + min) >= 0x30) ? "yes" : "no",
+          name, maj, min, sessions);
       if (i == device_id) {
         cuda_dev = cdev;
+      } else if (device_id < 0 && ((maj << 4) + min) >= 0x30
+          && sessions < min_sessions) {
+        cuda_dev = cdev;
+        min_sessions = sessions;
       }
     }
   }
+  g_mutex_unlock (&device_sessions_lock);
 
   if (cuda_dev == -1) {
     GST_WARNING ("Device with id %d does not exist or does not support NVENC",
@@ -300,25 +341,76 @@ gst_nvenc_create_cuda_context (guint device_id)
     return NULL;
   }
 
-  if (cuCtxCreate (&cuda_ctx, 0, cuda_dev) != CUDA_SUCCESS) {
-    GST_WARNING ("Failed to create CUDA context for cuda device %d", cuda_dev);
+  /* All the encoders of a device, and nvdec, share its primary context so
+   * that they can run in parallel without context switches */
+  if (cuDevicePrimaryCtxRetain (&cuda_ctx, cuda_dev) != CUDA_SUCCESS) {
+    GST_WARNING ("Failed to retain CUDA context for cuda device %d", cuda_dev);
     return NULL;
   }
 
-  if (cuCtxPopCurrent (&old_ctx) != CUDA_SUCCESS) {
-    return NULL;
-  }
+  add_device_sessions (cuda_dev, 1);
 
-  GST_INFO ("Created CUDA context %p", cuda_ctx);
+  GST_INFO ("Retained CUDA context %p", cuda_ctx);
 
   return cuda_ctx;
 }
 
+static gboolean
+get_context_device (CUcontext ctx, CUdevice * dev)
+{
+  CUresult cres;
+
+  if (cuCtxPushCurrent (ctx) != CUDA_SUCCESS)
+    return FALSE;
+  cres = cuCtxGetDevice (dev);
+  cuCtxPopCurrent (NULL);
+
+  return cres == CUDA_SUCCESS;
+}
+
+/* Takes another reference on the primary context @ctx, to be released with
+ * gst_nvenc_unref_cuda_context(). It is not counted as an encoder of the
+ * device. */
+CUcontext
+gst_nvenc_ref_cuda_context (CUcontext ctx)
+{
+  CUcontext ref = NULL;
+  CUdevice dev;
+
+  if (get_context_device (ctx, &dev))
+    cuDevicePrimaryCtxRetain (&ref, dev);
+
+  return ref;
+}
+
+gboolean
+gst_nvenc_unref_cuda_context (CUcontext ctx)
+{
+  CUdevice dev;
+
+  if (!get_context_device (ctx, &dev))
+    return FALSE;
+
+  return (cuDevicePrimaryCtxRelease (dev) == CUDA_SUCCESS);
+}
+
+/* Releases a context from gst_nvenc_create_cuda_context() */
 gboolean
 gst_nvenc_destroy_cuda_context (CUcontext ctx)
 {
-  GST_INFO ("Destroying CUDA context %p", ctx);
-  return (cuCtxDestroy (ctx) == CUDA_SUCCESS);
+  CUdevice dev;
+
+  GST_INFO ("Releasing CUDA context %p", ctx);
+
+  if (!get_context_device (ctx, &dev))
+    return FALSE;
+
+  if (cuDevicePrimaryCtxRelease (dev) != CUDA_SUCCESS)
+    return FALSE;
+
+  add_device_sessions (dev, -1);
+
+  return TRUE;
 }
 
 static gboolean
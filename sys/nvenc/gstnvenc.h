@@ -29,7 +29,11 @@
 GST_DEBUG_CATEGORY_EXTERN (gst_nvenc_debug);
 #define GST_CAT_DEFAULT gst_nvenc_debug
 
-CUcontext               gst_nvenc_create_cuda_context (guint device_id);
+CUcontext               gst_nvenc_create_cuda_context (gint device_id);
+
+CUcontext               gst_nvenc_ref_cuda_context (CUcontext ctx);
+
+gboolean                gst_nvenc_unref_cuda_context (CUcontext ctx);
 
 gboolean                gst_nvenc_destroy_cuda_context (CUcontext ctx);
 
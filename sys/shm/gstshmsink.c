@@ -39,6 +39,8 @@
 #include "gstshmsink.h"
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/allocators/allocators.h>
 
 #include <string.h>
 
@@ -58,7 +60,10 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_STATS,
+  PROP_FD_PASSING,
+  PROP_MAX_LAG_BUFFERS
 };
 
 struct GstShmClient
@@ -69,6 +74,9 @@ struct GstShmClient
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_POOL_MIN_BUFFERS 2
+#define DEFAULT_FD_PASSING FALSE
+#define DEFAULT_MAX_LAG_BUFFERS 0
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -353,6 +361,8 @@ gst_shm_sink_init (GstShmSink * self)
   self->size = DEFAULT_SIZE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
   self->perms = DEFAULT_PERMS;
+  self->fd_passing = DEFAULT_FD_PASSING;
+  self->max_lag_buffers = DEFAULT_MAX_LAG_BUFFERS;
 
   gst_allocation_params_init (&self->params);
 }
@@ -415,6 +425,29 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Number of buffers sent without a copy (zero-copy-buffers) and "
+          "copied into the shared memory area (copied-buffers), and the "
+          "buffers not released by each client yet (clients)",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FD_PASSING,
+      g_param_spec_boolean ("fd-passing",
+          "Pass file descriptors",
+          "Send buffers backed by a single file descriptor memory, like dmabuf "
+          "or memfd, by passing the file descriptor instead of copying them "
+          "into the shared memory area",
+          DEFAULT_FD_PASSING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_LAG_BUFFERS,
+      g_param_spec_uint ("max-lag-buffers",
+          "Maximum client lag in buffers",
+          "Disconnect the clients that did not release more than this number "
+          "of buffers, before they exhaust the shm area (0 = disabled)",
+          0, G_MAXINT, DEFAULT_MAX_LAG_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL,
       g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 1, G_TYPE_INT);
@@ -503,11 +536,54 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_FD_PASSING:
+      GST_OBJECT_LOCK (object);
+      self->fd_passing = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_MAX_LAG_BUFFERS:
+      GST_OBJECT_LOCK (object);
+      self->max_lag_buffers = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       break;
   }
 }
 
+static GstStructure *
+gst_shm_sink_get_stats_locked (GstShmSink * self)
+{
+  GstStructure *stats;
+  GValue clients = G_VALUE_INIT;
+  ShmClient *client;
+
+  stats = gst_structure_new ("application/x-shm-sink-stats",
+      "zero-copy-buffers", G_TYPE_UINT64, self->n_zero_copy,
+      "copied-buffers", G_TYPE_UINT64, self->n_copied, NULL);
+
+  /* how far behind each client is */
+  g_value_init (&clients, GST_TYPE_ARRAY);
+  for (client = self->pipe ? sp_writer_get_clients (self->pipe) : NULL;
+      client; client = sp_writer_get_next_client (client)) {
+    GValue value = G_VALUE_INIT;
+    size_t bytes;
+    int pending;
+
+    pending = sp_writer_get_client_pending (self->pipe, client, &bytes);
+
+    g_value_init (&value, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&value, gst_structure_new ("client",
+            "fd", G_TYPE_INT, sp_writer_get_client_fd (client),
+            "pending-buffers", G_TYPE_UINT, (guint) pending,
+            "pending-bytes", G_TYPE_UINT64, (guint64) bytes, NULL));
+    gst_value_array_append_and_take_value (&clients, &value);
+  }
+  gst_structure_take_value (stats, "clients", &clients);
+
+  return stats;
+}
+
 static void
 gst_shm_sink_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -532,6 +608,15 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_shm_sink_get_stats_locked (self));
+      break;
+    case PROP_FD_PASSING:
+      g_value_set_boolean (value, self->fd_passing);
+      break;
+    case PROP_MAX_LAG_BUFFERS:
+      g_value_set_uint (value, self->max_lag_buffers);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -549,6 +634,8 @@ gst_shm_sink_start (GstBaseSink * bsink)
   GError *err = NULL;
 
   self->stop = FALSE;
+  self->n_zero_copy = 0;
+  self->n_copied = 0;
 
   if (!self->socket_path) {
     GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ_WRITE,
@@ -656,6 +743,31 @@ gst_shm_sink_can_render (GstShmSink * self, GstClockTime time)
   return TRUE;
 }
 
+/* Wakes up the poll thread to drop the clients that are more than
+ * max-lag-buffers behind, it would only notice on their next ack */
+static void
+gst_shm_sink_check_lag (GstShmSink * self)
+{
+  ShmClient *client;
+
+  GST_OBJECT_LOCK (self);
+  if (self->max_lag_buffers == 0 || self->lag_wakeup) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+
+  for (client = sp_writer_get_clients (self->pipe); client;
+      client = sp_writer_get_next_client (client)) {
+    if (sp_writer_get_client_pending (self->pipe, client, NULL) >
+        (int) self->max_lag_buffers) {
+      self->lag_wakeup = TRUE;
+      gst_poll_write_control (self->poll);
+      break;
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
 static GstFlowReturn
 gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
@@ -681,6 +793,19 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   }
 
 
+  if (self->fd_passing && gst_buffer_n_memory (buf) == 1 &&
+      gst_is_fd_memory (gst_buffer_peek_memory (buf, 0))) {
+    memory = gst_buffer_peek_memory (buf, 0);
+    sendbuf = gst_buffer_ref (buf);
+    self->n_zero_copy++;
+
+    GST_LOG_OBJECT (self, "Passing the file descriptor of buffer %p", buf);
+    rv = sp_writer_send_fd_buf (self->pipe, gst_fd_memory_get_fd (memory),
+        memory->offset, memory->size, sendbuf);
+    GST_OBJECT_UNLOCK (self);
+    goto sent;
+  }
+
   if (gst_buffer_n_memory (buf) > 1) {
     GST_LOG_OBJECT (self, "Buffer %p has %d GstMemory, we only support a single"
         " one, need to do a memcpy", buf, gst_buffer_n_memory (buf));
@@ -731,8 +856,10 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     sendbuf = gst_buffer_new ();
     gst_buffer_copy_into (sendbuf, buf, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_append_memory (sendbuf, memory);
+    self->n_copied++;
   } else {
     sendbuf = gst_buffer_ref (buf);
+    self->n_zero_copy++;
   }
 
   gst_buffer_map (sendbuf, &map, GST_MAP_READ);
@@ -747,6 +874,10 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 
   GST_OBJECT_UNLOCK (self);
 
+sent:
+  if (rv > 0)
+    gst_shm_sink_check_lag (self);
+
   if (rv == 0) {
     GST_DEBUG_OBJECT (self, "No clients connected, unreffing buffer");
     gst_buffer_unref (sendbuf);
@@ -781,6 +912,7 @@ pollthread_func (gpointer data)
   GstShmSink *self = GST_SHM_SINK (data);
   GList *item;
   GstClockTime timeout = GST_CLOCK_TIME_NONE;
+  guint max_lag_buffers;
   int rv = 0;
 
   while (!self->stop) {
@@ -800,6 +932,14 @@ pollthread_func (gpointer data)
     if (self->stop)
       return NULL;
 
+    GST_OBJECT_LOCK (self);
+    if (self->lag_wakeup) {
+      gst_poll_read_control (self->poll);
+      self->lag_wakeup = FALSE;
+    }
+    max_lag_buffers = self->max_lag_buffers;
+    GST_OBJECT_UNLOCK (self);
+
     if (gst_poll_fd_has_closed (self->poll, &self->serverpollfd)) {
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed read from shmsink"),
           ("Control socket has closed"));
@@ -860,22 +1000,35 @@ pollthread_func (gpointer data)
 
       if (gst_poll_fd_can_read (self->poll, &gclient->pollfd)) {
         int rv;
-        gpointer tag = NULL;
+        GSList *list = NULL;
 
+        /* a single command may release a batch of buffers */
         GST_OBJECT_LOCK (self);
-        rv = sp_writer_recv (self->pipe, gclient->client, &tag);
+        rv = sp_writer_recv (self->pipe, gclient->client,
+            (sp_buffer_free_callback) free_buffer_locked, (void **) &list);
         GST_OBJECT_UNLOCK (self);
+        g_slist_free_full (list, (GDestroyNotify) gst_buffer_unref);
 
         if (rv < 0) {
           GST_WARNING_OBJECT (self, "One client has read error,"
               " closing (retval: %d errno: %d)", rv, errno);
           goto close_client;
         }
+      }
 
-        g_assert (rv == 0 || tag == NULL);
+      if (max_lag_buffers > 0) {
+        int pending;
 
-        if (rv == 0)
-          gst_buffer_unref (tag);
+        GST_OBJECT_LOCK (self);
+        pending = sp_writer_get_client_pending (self->pipe, gclient->client,
+            NULL);
+        GST_OBJECT_UNLOCK (self);
+
+        if (pending > (int) max_lag_buffers) {
+          GST_WARNING_OBJECT (self, "One client is %d buffers behind, "
+              "closing", pending);
+          goto close_client;
+        }
       }
       continue;
     close_client:
@@ -954,10 +1107,64 @@ static gboolean
 gst_shm_sink_propose_allocation (GstBaseSink * sink, GstQuery * query)
 {
   GstShmSink *self = GST_SHM_SINK (sink);
+  GstShmSinkAllocator *allocator = NULL;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstVideoInfo info;
+  GstCaps *caps;
+  gsize area_size = 0, block_size;
+  guint min_buffers, max_buffers;
 
-  if (self->allocator)
-    gst_query_add_allocation_param (query, GST_ALLOCATOR (self->allocator),
-        NULL);
+  GST_OBJECT_LOCK (self);
+  if (self->allocator) {
+    allocator = gst_object_ref (self->allocator);
+    area_size = sp_writer_get_max_buf_size (self->pipe);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (!allocator)
+    return TRUE;
+
+  gst_query_add_allocation_param (query, GST_ALLOCATOR (allocator), NULL);
+
+  /* Elements that do not use the allocator directly still write into the
+   * shared memory area through a pool, but the buffer size is only known
+   * for raw video */
+  gst_query_parse_allocation (query, &caps, NULL);
+  if (!caps || !gst_video_info_from_caps (&info, caps))
+    goto done;
+
+  /* as allocated by gst_shm_sink_allocator_alloc_locked() */
+  block_size = info.size + gst_memory_alignment;
+  max_buffers = area_size / block_size;
+  if (max_buffers < 2) {
+    GST_DEBUG_OBJECT (self, "Shared memory area of %" G_GSIZE_FORMAT
+        " bytes is too small for a pool of %" G_GSIZE_FORMAT " bytes buffers",
+        area_size, info.size);
+    goto done;
+  }
+  /* leave room for the buffers that still need to be copied */
+  max_buffers--;
+  min_buffers = MIN (DEFAULT_POOL_MIN_BUFFERS, max_buffers);
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, info.size, min_buffers,
+      max_buffers);
+  gst_buffer_pool_config_set_allocator (config, GST_ALLOCATOR (allocator),
+      NULL);
+  if (gst_buffer_pool_set_config (pool, config)) {
+    GST_DEBUG_OBJECT (self, "Proposing a pool of %u to %u buffers of %"
+        G_GSIZE_FORMAT " bytes", min_buffers, max_buffers, info.size);
+    gst_query_add_allocation_pool (query, pool, info.size, min_buffers,
+        max_buffers);
+  } else {
+    GST_WARNING_OBJECT (self, "Failed to configure the buffer pool");
+  }
+  gst_object_unref (pool);
+
+done:
+  gst_object_unref (allocator);
 
   return TRUE;
 }
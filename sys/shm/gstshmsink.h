@@ -60,6 +60,10 @@ struct _GstShmSink
   GstPollFD serverpollfd;
 
   gboolean wait_for_connection;
+  gboolean fd_passing;
+  guint max_lag_buffers;
+  /* the poll thread was woken up to drop lagging clients */
+  gboolean lag_wakeup;
   gboolean stop;
   gboolean unlock;
   GstClockTimeDiff buffer_time;
@@ -69,6 +73,11 @@ struct _GstShmSink
   GstShmSinkAllocator *allocator;
 
   GstAllocationParams params;
+
+  /* buffers sent from the shared memory area as is and buffers that had to
+   * be copied into it */
+  guint64 n_zero_copy;
+  guint64 n_copied;
 };
 
 struct _GstShmSinkClass
@@ -41,8 +41,10 @@
 #include "gstshmsrc.h"
 
 #include <gst/gst.h>
+#include <gst/allocators/allocators.h>
 
 #include <string.h>
+#include <unistd.h>
 
 /* signals */
 enum
@@ -56,15 +58,27 @@ enum
   PROP_0,
   PROP_SOCKET_PATH,
   PROP_IS_LIVE,
-  PROP_SHM_AREA_NAME
+  PROP_SHM_AREA_NAME,
+  PROP_ACK_BATCH
 };
 
+#define DEFAULT_ACK_BATCH 1
+
 struct GstShmBuffer
 {
   char *buf;
   GstShmPipe *pipe;
 };
 
+/* a buffer received as a file descriptor, acked when its memory is freed */
+struct GstShmFdBuffer
+{
+  int id;
+  GstShmPipe *pipe;
+};
+
+static GQuark fd_buffer_quark;
+
 
 GST_DEBUG_CATEGORY_STATIC (shmsrc_debug);
 #define GST_CAT_DEFAULT shmsrc_debug
@@ -122,6 +136,8 @@ gst_shm_src_class_init (GstShmSrcClass * klass)
 
   gstpush_src_class->create = gst_shm_src_create;
 
+  fd_buffer_quark = g_quark_from_static_string ("GstShmSrcFdBuffer");
+
   g_object_class_install_property (gobject_class, PROP_SOCKET_PATH,
       g_param_spec_string ("socket-path",
           "Path to the control socket",
@@ -139,6 +155,14 @@ gst_shm_src_class_init (GstShmSrcClass * klass)
           "The name of the shared memory area used to get buffers",
           NULL, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_ACK_BATCH,
+      g_param_spec_uint ("ack-batch",
+          "Number of buffers released together",
+          "Release up to this number of buffers to the sink with a single "
+          "message, the pending releases are always sent before waiting for "
+          "new data",
+          1, 64, DEFAULT_ACK_BATCH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -155,6 +179,9 @@ gst_shm_src_init (GstShmSrc * self)
 {
   self->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&self->pollfd);
+  self->ack_batch = DEFAULT_ACK_BATCH;
+
+  self->dmabuf_allocator = gst_dmabuf_allocator_new ();
 }
 
 static void
@@ -164,6 +191,7 @@ gst_shm_src_finalize (GObject * object)
 
   gst_poll_free (self->poll);
   g_free (self->socket_path);
+  gst_object_unref (self->dmabuf_allocator);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -191,6 +219,13 @@ gst_shm_src_set_property (GObject * object, guint prop_id,
       gst_base_src_set_live (GST_BASE_SRC (object),
           g_value_get_boolean (value));
       break;
+    case PROP_ACK_BATCH:
+      GST_OBJECT_LOCK (object);
+      self->ack_batch = g_value_get_uint (value);
+      if (self->pipe)
+        sp_client_set_ack_batch (self->pipe->pipe, self->ack_batch);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -218,6 +253,11 @@ gst_shm_src_get_property (GObject * object, guint prop_id,
         g_value_set_string (value, sp_get_shm_area_name (self->pipe->pipe));
       GST_OBJECT_UNLOCK (object);
       break;
+    case PROP_ACK_BATCH:
+      GST_OBJECT_LOCK (object);
+      g_value_set_uint (value, self->ack_batch);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -243,6 +283,8 @@ gst_shm_src_start_reading (GstShmSrc * self)
 
   GST_OBJECT_LOCK (self);
   gstpipe->pipe = sp_client_open (self->socket_path);
+  if (gstpipe->pipe)
+    sp_client_set_ack_batch (gstpipe->pipe, self->ack_batch);
   GST_OBJECT_UNLOCK (self);
 
   if (!gstpipe->pipe) {
@@ -300,6 +342,15 @@ gst_shm_src_stop (GstBaseSrc * bsrc)
 }
 
 
+/* Called with the object lock after queueing an ack. Acks are only held
+ * back while the source thread is busy, it sends them before waiting */
+static void
+gst_shm_pipe_flush_acks_locked (GstShmPipe * pipe)
+{
+  if (pipe->src->waiting || pipe != pipe->src->pipe)
+    sp_client_flush_acks (pipe->pipe);
+}
+
 static void
 free_buffer (gpointer data)
 {
@@ -311,6 +362,7 @@ free_buffer (gpointer data)
 
   GST_OBJECT_LOCK (gsb->pipe->src);
   sp_client_recv_finish (gsb->pipe->pipe, gsb->buf);
+  gst_shm_pipe_flush_acks_locked (gsb->pipe);
   GST_OBJECT_UNLOCK (gsb->pipe->src);
 
   gst_shm_pipe_dec (gsb->pipe);
@@ -318,20 +370,85 @@ free_buffer (gpointer data)
   g_slice_free (struct GstShmBuffer, gsb);
 }
 
+static void
+free_fd_buffer (gpointer data)
+{
+  struct GstShmFdBuffer *gsb = data;
+
+  GST_LOG ("Freeing fd buffer %d", gsb->id);
+
+  GST_OBJECT_LOCK (gsb->pipe->src);
+  sp_client_recv_finish_fd (gsb->pipe->pipe, gsb->id);
+  gst_shm_pipe_flush_acks_locked (gsb->pipe);
+  GST_OBJECT_UNLOCK (gsb->pipe->src);
+
+  gst_shm_pipe_dec (gsb->pipe);
+
+  g_slice_free (struct GstShmFdBuffer, gsb);
+}
+
+static GstBuffer *
+gst_shm_src_wrap_fd_buffer (GstShmSrc * self, ShmFdBuffer * fd_buf,
+    gsize size)
+{
+  struct GstShmFdBuffer *gsb;
+  GstMemory *mem;
+  GstBuffer *buffer;
+
+  /* the allocator takes ownership of the file descriptor */
+  mem = gst_dmabuf_allocator_alloc (self->dmabuf_allocator, fd_buf->fd,
+      fd_buf->offset + size);
+  if (!mem) {
+    close (fd_buf->fd);
+    GST_OBJECT_LOCK (self);
+    sp_client_recv_finish_fd (self->pipe->pipe, fd_buf->id);
+    GST_OBJECT_UNLOCK (self);
+    return NULL;
+  }
+  gst_memory_resize (mem, fd_buf->offset, size);
+
+  gsb = g_slice_new0 (struct GstShmFdBuffer);
+  gsb->id = fd_buf->id;
+  gsb->pipe = self->pipe;
+  gst_shm_pipe_inc (self->pipe);
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem), fd_buffer_quark,
+      gsb, free_fd_buffer);
+
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, mem);
+
+  return buffer;
+}
+
 static GstFlowReturn
 gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
   GstShmSrc *self = GST_SHM_SRC (psrc);
   gchar *buf = NULL;
+  ShmFdBuffer fd_buf = { -1, 0, 0 };
   int rv = 0;
   struct GstShmBuffer *gsb;
 
   do {
-    if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
-      if (errno == EBUSY)
+    gint res, err;
+
+    GST_OBJECT_LOCK (self);
+    sp_client_flush_acks (self->pipe->pipe);
+    self->waiting = TRUE;
+    GST_OBJECT_UNLOCK (self);
+
+    res = gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE);
+    err = errno;
+
+    GST_OBJECT_LOCK (self);
+    self->waiting = FALSE;
+    GST_OBJECT_UNLOCK (self);
+
+    if (res < 0) {
+      if (err == EBUSY)
         return GST_FLOW_FLUSHING;
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
-          ("Poll failed on fd: %s", strerror (errno)));
+          ("Poll failed on fd: %s", strerror (err)));
       return GST_FLOW_ERROR;
     }
 
@@ -352,9 +469,10 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 
     if (gst_poll_fd_can_read (self->poll, &self->pollfd)) {
       buf = NULL;
+      fd_buf.fd = -1;
       GST_LOG_OBJECT (self, "Reading from pipe");
       GST_OBJECT_LOCK (self);
-      rv = sp_client_recv (self->pipe->pipe, &buf);
+      rv = sp_client_recv (self->pipe->pipe, &buf, &fd_buf);
       GST_OBJECT_UNLOCK (self);
       if (rv < 0) {
         GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
@@ -362,7 +480,20 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
         return GST_FLOW_ERROR;
       }
     }
-  } while (buf == NULL);
+  } while (buf == NULL && fd_buf.fd < 0);
+
+  if (fd_buf.fd >= 0) {
+    GST_LOG_OBJECT (self, "Got fd buffer %d of size %d", fd_buf.id, rv);
+
+    *outbuf = gst_shm_src_wrap_fd_buffer (self, &fd_buf, rv);
+    if (!*outbuf) {
+      GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+          ("Could not wrap the file descriptor of buffer %d", fd_buf.id));
+      return GST_FLOW_ERROR;
+    }
+
+    return GST_FLOW_OK;
+  }
 
   GST_LOG_OBJECT (self, "Got buffer %p of size %d", buf, rv);
 
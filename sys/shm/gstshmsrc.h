@@ -56,6 +56,13 @@ struct _GstShmSrc
 
   GstFlowReturn flow_return;
   gboolean unlocked;
+
+  guint ack_batch;
+  /* waiting for data, buffer releases are sent right away */
+  gboolean waiting;
+
+  /* wraps the buffers passed as file descriptors */
+  GstAllocator *dmabuf_allocator;
 };
 
 struct _GstShmSrcClass
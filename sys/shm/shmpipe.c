@@ -67,7 +67,19 @@
  * type 4: ack buffer
  * offset
  *
- * Type 4 goes from the client to the server
+ * type 5: fd buffer, the area id is the buffer id and the file descriptor
+ * of the memory is passed as ancillary data (SCM_RIGHTS)
+ * offset
+ * bufsize
+ *
+ * type 6: ack fd buffer, the area id is the buffer id
+ * No payload
+ *
+ * type 7: ack buffers
+ * Number of acks (followed by the acks, each one with the type and area id
+ * of a type 4 or 6 command and the offset for type 4)
+ *
+ * Types 4, 6 and 7 go from the client to the server
  * The rest are from the server to the client
  * The client should never write in the SHM
  */
@@ -80,7 +92,20 @@ enum
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_NEW_FD_BUFFER = 5,
+  COMMAND_ACK_FD_BUFFER = 6,
+  COMMAND_ACK_BUFFERS = 7
+};
+
+/* The largest number of acks sent in one command */
+#define MAX_ACK_BATCH 64
+
+struct AckEntry
+{
+  unsigned int type;
+  int area_id;
+  unsigned long offset;
 };
 
 typedef struct _ShmArea ShmArea;
@@ -108,12 +133,15 @@ struct _ShmBuffer
 {
   int use_count;
 
+  /* NULL for buffers passed as file descriptors */
   ShmArea *shm_area;
   unsigned long offset;
   size_t size;
 
   ShmAllocBlock *ablock;
 
+  int fd_id;
+
   ShmBuffer *next;
 
   void *tag;
@@ -134,6 +162,7 @@ struct _ShmPipe
   ShmArea *shm_area;
 
   int next_area_id;
+  int next_fd_id;
 
   ShmBuffer *buffers;
 
@@ -141,6 +170,11 @@ struct _ShmPipe
   ShmClient *clients;
 
   mode_t perms;
+
+  /* client side, acks not sent yet */
+  struct AckEntry pending_acks[MAX_ACK_BATCH];
+  int num_pending_acks;
+  int ack_batch;
 };
 
 struct _ShmClient
@@ -179,6 +213,11 @@ struct CommandBuffer
     {
       unsigned long offset;
     } ack_buffer;
+    struct
+    {
+      unsigned int num_acks;
+      /* Followed by the acks */
+    } ack_buffers;
   } payload;
 };
 
@@ -187,6 +226,8 @@ static void sp_close_shm (ShmArea * area);
 static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf, ShmClient * client, void **tag);
 static void sp_shm_area_dec (ShmPipe * self, ShmArea * area);
+static int sp_client_queue_ack (ShmPipe * self, unsigned int type,
+    int area_id, unsigned long offset);
 
 
 
@@ -485,6 +526,38 @@ send_command (int fd, struct CommandBuffer *cb, unsigned short int type,
   return 1;
 }
 
+static int
+send_command_with_fd (int fd, struct CommandBuffer *cb,
+    unsigned short int type, int area_id, int passed_fd)
+{
+  struct msghdr msg = { 0 };
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  char control[CMSG_SPACE (sizeof (int))];
+
+  cb->type = type;
+  cb->area_id = area_id;
+
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  memset (control, 0, sizeof (control));
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof (control);
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &passed_fd, sizeof (int));
+
+  if (sendmsg (fd, &msg, MSG_NOSIGNAL) != sizeof (struct CommandBuffer))
+    return 0;
+
+  return 1;
+}
+
 int
 sp_writer_resize (ShmPipe * self, size_t size)
 {
@@ -639,6 +712,101 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   return c;
 }
 
+/* Returns the number of client @fd has successfully been sent to, the
+ * clients receive their own copy of the file descriptor */
+
+int
+sp_writer_send_fd_buf (ShmPipe * self, int fd, unsigned long offset,
+    size_t size, void *tag)
+{
+  ShmBuffer *sb;
+  ShmClient *client = NULL;
+  int i = 0;
+  int c = 0;
+
+  if (self->num_clients == 0)
+    return 0;
+
+  if (fd < 0)
+    return -1;
+
+  sb = spalloc_alloc (sizeof (ShmBuffer) + sizeof (int) * self->num_clients);
+  memset (sb, 0, sizeof (ShmBuffer));
+  memset (sb->clients, -1, sizeof (int) * self->num_clients);
+  sb->offset = offset;
+  sb->size = size;
+  sb->num_clients = self->num_clients;
+  sb->tag = tag;
+
+  if (self->next_fd_id == INT_MAX)
+    self->next_fd_id = 0;
+  sb->fd_id = ++self->next_fd_id;
+
+  for (client = self->clients; client; client = client->next) {
+    struct CommandBuffer cb = { 0 };
+    cb.payload.buffer.offset = offset;
+    cb.payload.buffer.size = size;
+    if (!send_command_with_fd (client->fd, &cb, COMMAND_NEW_FD_BUFFER,
+            sb->fd_id, fd))
+      continue;
+    sb->clients[i++] = client->fd;
+    c++;
+  }
+
+  if (c == 0) {
+    spalloc_free1 (sizeof (ShmBuffer) + sizeof (int) * sb->num_clients, sb);
+    return 0;
+  }
+
+  sb->use_count = c;
+
+  sb->next = self->buffers;
+  self->buffers = sb;
+
+  return c;
+}
+
+static int
+recv_command_with_fd (int fd, struct CommandBuffer *cb, int *passed_fd)
+{
+  struct msghdr msg = { 0 };
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  char control[CMSG_SPACE (sizeof (int))];
+  int flags = MSG_DONTWAIT;
+  int retval;
+
+#ifdef MSG_CMSG_CLOEXEC
+  flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+  *passed_fd = -1;
+
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof (control);
+
+  retval = recvmsg (fd, &msg, flags);
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN (sizeof (int)))
+      memcpy (passed_fd, CMSG_DATA (cmsg), sizeof (int));
+  }
+
+  if (retval == sizeof (struct CommandBuffer)) {
+    return 1;
+  } else {
+    if (*passed_fd >= 0)
+      close (*passed_fd);
+    *passed_fd = -1;
+    return 0;
+  }
+}
+
 static int
 recv_command (int fd, struct CommandBuffer *cb)
 {
@@ -653,17 +821,23 @@ recv_command (int fd, struct CommandBuffer *cb)
 }
 
 long int
-sp_client_recv (ShmPipe * self, char **buf)
+sp_client_recv (ShmPipe * self, char **buf, ShmFdBuffer * fd_buf)
 {
   char *area_name = NULL;
   ShmArea *newarea;
   ShmArea *area;
   struct CommandBuffer cb;
+  int passed_fd;
   int retval;
 
-  if (!recv_command (self->main_socket, &cb))
+  if (!recv_command_with_fd (self->main_socket, &cb, &passed_fd))
     return -1;
 
+  if (passed_fd >= 0 && cb.type != COMMAND_NEW_FD_BUFFER) {
+    close (passed_fd);
+    passed_fd = -1;
+  }
+
   switch (cb.type) {
     case COMMAND_NEW_SHM_AREA:
       assert (cb.payload.new_shm_area.path_size > 0);
@@ -709,6 +883,20 @@ sp_client_recv (ShmPipe * self, char **buf)
       }
       return -23;
 
+    case COMMAND_NEW_FD_BUFFER:
+      if (passed_fd < 0)
+        return -24;
+      if (!fd_buf) {
+        /* the caller can't handle it, give it back at once */
+        close (passed_fd);
+        sp_client_recv_finish_fd (self, cb.area_id);
+        return 0;
+      }
+      fd_buf->fd = passed_fd;
+      fd_buf->id = cb.area_id;
+      fd_buf->offset = cb.payload.buffer.offset;
+      return cb.payload.buffer.size;
+
     default:
       return -99;
   }
@@ -716,27 +904,76 @@ sp_client_recv (ShmPipe * self, char **buf)
   return 0;
 }
 
-int
-sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
+/* Releases the buffer acked by @client, @callback is called with its tag if
+ * it is not used by any client anymore */
+static int
+sp_writer_ack (ShmPipe * self, ShmClient * client, unsigned int type,
+    int area_id, unsigned long offset, sp_buffer_free_callback callback,
+    void *user_data)
 {
   ShmBuffer *buf = NULL, *prev_buf = NULL;
+  void *tag = NULL;
+
+  for (buf = self->buffers; buf; buf = buf->next) {
+    if (type == COMMAND_ACK_BUFFER && buf->shm_area &&
+        buf->shm_area->id == area_id && buf->offset == offset)
+      break;
+    if (type == COMMAND_ACK_FD_BUFFER && !buf->shm_area &&
+        buf->fd_id == area_id)
+      break;
+    prev_buf = buf;
+  }
+
+  if (!buf)
+    return -2;
+
+  if (!sp_shmbuf_dec (self, buf, prev_buf, client, &tag) && callback)
+    callback (tag, user_data);
+
+  return 0;
+}
+
+int
+sp_writer_recv (ShmPipe * self, ShmClient * client,
+    sp_buffer_free_callback callback, void *user_data)
+{
+  struct AckEntry acks[MAX_ACK_BATCH];
   struct CommandBuffer cb;
+  unsigned int i;
+  int retval;
+  size_t len;
 
   if (!recv_command (client->fd, &cb))
     return -1;
 
   switch (cb.type) {
     case COMMAND_ACK_BUFFER:
+      return sp_writer_ack (self, client, cb.type, cb.area_id,
+          cb.payload.ack_buffer.offset, callback, user_data);
+    case COMMAND_ACK_FD_BUFFER:
+      return sp_writer_ack (self, client, cb.type, cb.area_id, 0, callback,
+          user_data);
+    case COMMAND_ACK_BUFFERS:
+      if (cb.payload.ack_buffers.num_acks == 0 ||
+          cb.payload.ack_buffers.num_acks > MAX_ACK_BATCH)
+        return -3;
 
-      for (buf = self->buffers; buf; buf = buf->next) {
-        if (buf->shm_area->id == cb.area_id &&
-            buf->offset == cb.payload.ack_buffer.offset) {
-          return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
-        }
-        prev_buf = buf;
+      len = sizeof (struct AckEntry) * cb.payload.ack_buffers.num_acks;
+      retval = recv (client->fd, acks, len, MSG_WAITALL);
+      if (retval < 0 || (size_t) retval != len)
+        return -4;
+
+      for (i = 0; i < cb.payload.ack_buffers.num_acks; i++) {
+        if (acks[i].type != COMMAND_ACK_BUFFER &&
+            acks[i].type != COMMAND_ACK_FD_BUFFER)
+          return -5;
+        retval = sp_writer_ack (self, client, acks[i].type, acks[i].area_id,
+            acks[i].offset, callback, user_data);
+        if (retval < 0)
+          return retval;
       }
 
-      return -2;
+      return 0;
     default:
       return -99;
   }
@@ -749,7 +986,6 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
 {
   ShmArea *shm_area = NULL;
   unsigned long offset;
-  struct CommandBuffer cb = { 0 };
 
   for (shm_area = self->shm_area; shm_area; shm_area = shm_area->next) {
     if (buf >= shm_area->shm_area_buf &&
@@ -763,9 +999,80 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
 
   sp_shm_area_dec (self, shm_area);
 
-  cb.payload.ack_buffer.offset = offset;
-  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER,
-      self->shm_area->id);
+  return sp_client_queue_ack (self, COMMAND_ACK_BUFFER, self->shm_area->id,
+      offset);
+}
+
+int
+sp_client_recv_finish_fd (ShmPipe * self, int id)
+{
+  return sp_client_queue_ack (self, COMMAND_ACK_FD_BUFFER, id, 0);
+}
+
+void
+sp_client_set_ack_batch (ShmPipe * self, int num_acks)
+{
+  if (num_acks < 1)
+    num_acks = 1;
+  else if (num_acks > MAX_ACK_BATCH)
+    num_acks = MAX_ACK_BATCH;
+
+  self->ack_batch = num_acks;
+  if (self->num_pending_acks >= self->ack_batch)
+    sp_client_flush_acks (self);
+}
+
+int
+sp_client_flush_acks (ShmPipe * self)
+{
+  struct CommandBuffer cb = { 0 };
+  size_t len;
+  int num_acks = self->num_pending_acks;
+
+  if (num_acks == 0)
+    return 1;
+
+  self->num_pending_acks = 0;
+
+  if (num_acks == 1) {
+    cb.payload.ack_buffer.offset = self->pending_acks[0].offset;
+    return send_command (self->main_socket, &cb, self->pending_acks[0].type,
+        self->pending_acks[0].area_id);
+  }
+
+  cb.payload.ack_buffers.num_acks = num_acks;
+  if (!send_command (self->main_socket, &cb, COMMAND_ACK_BUFFERS, 0))
+    return 0;
+
+  len = sizeof (struct AckEntry) * num_acks;
+  if (send (self->main_socket, self->pending_acks, len, MSG_NOSIGNAL) != len)
+    return 0;
+
+  return 1;
+}
+
+static int
+sp_client_queue_ack (ShmPipe * self, unsigned int type, int area_id,
+    unsigned long offset)
+{
+  struct AckEntry *ack;
+
+  if (self->ack_batch <= 1 && self->num_pending_acks == 0) {
+    struct CommandBuffer cb = { 0 };
+
+    cb.payload.ack_buffer.offset = offset;
+    return send_command (self->main_socket, &cb, type, area_id);
+  }
+
+  ack = &self->pending_acks[self->num_pending_acks++];
+  ack->type = type;
+  ack->area_id = area_id;
+  ack->offset = offset;
+
+  if (self->num_pending_acks >= self->ack_batch)
+    return sp_client_flush_acks (self);
+
+  return 1;
 }
 
 ShmPipe *
@@ -883,8 +1190,10 @@ sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf, ShmBuffer * prev_buf,
 
     if (tag)
       *tag = buf->tag;
-    shm_alloc_space_block_dec (buf->ablock);
-    sp_shm_area_dec (self, buf->shm_area);
+    if (buf->ablock)
+      shm_alloc_space_block_dec (buf->ablock);
+    if (buf->shm_area)
+      sp_shm_area_dec (self, buf->shm_area);
     spalloc_free1 (sizeof (ShmBuffer) + sizeof (int) * buf->num_clients, buf);
     return 0;
   }
@@ -987,6 +1296,44 @@ sp_writer_buf_get_tag (ShmBuffer * buffer)
   return buffer->tag;
 }
 
+ShmClient *
+sp_writer_get_clients (ShmPipe * self)
+{
+  return self->clients;
+}
+
+ShmClient *
+sp_writer_get_next_client (ShmClient * client)
+{
+  return client->next;
+}
+
+/* Returns the number of buffers sent to @client it did not ack yet */
+int
+sp_writer_get_client_pending (ShmPipe * self, ShmClient * client,
+    size_t * bytes)
+{
+  ShmBuffer *buf;
+  int pending = 0;
+  size_t pending_bytes = 0;
+  int i;
+
+  for (buf = self->buffers; buf; buf = buf->next) {
+    for (i = 0; i < buf->num_clients; i++) {
+      if (buf->clients[i] == client->fd) {
+        pending++;
+        pending_bytes += buf->size;
+        break;
+      }
+    }
+  }
+
+  if (bytes)
+    *bytes = pending_bytes;
+
+  return pending;
+}
+
 size_t
 sp_writer_get_max_buf_size (ShmPipe * self)
 {
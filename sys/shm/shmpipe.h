@@ -80,6 +80,14 @@ typedef struct _ShmBuffer ShmBuffer;
 
 typedef void (*sp_buffer_free_callback) (void * tag, void * user_data);
 
+/* A buffer received as a file descriptor, owned by the receiver */
+typedef struct _ShmFdBuffer
+{
+  int fd;
+  int id;
+  unsigned long offset;
+} ShmFdBuffer;
+
 ShmPipe *sp_writer_create (const char *path, size_t size, mode_t perms);
 const char *sp_writer_get_path (ShmPipe *pipe);
 void sp_writer_close (ShmPipe * self, sp_buffer_free_callback callback,
@@ -97,6 +105,8 @@ int sp_writer_get_client_fd (ShmClient * client);
 ShmBlock *sp_writer_alloc_block (ShmPipe * self, size_t size);
 void sp_writer_free_block (ShmBlock *block);
 int sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void * tag);
+int sp_writer_send_fd_buf (ShmPipe * self, int fd, unsigned long offset,
+    size_t size, void * tag);
 char *sp_writer_block_get_buf (ShmBlock *block);
 ShmPipe *sp_writer_block_get_pipe (ShmBlock *block);
 size_t sp_writer_get_max_buf_size (ShmPipe * self);
@@ -104,7 +114,12 @@ size_t sp_writer_get_max_buf_size (ShmPipe * self);
 ShmClient * sp_writer_accept_client (ShmPipe * self);
 void sp_writer_close_client (ShmPipe *self, ShmClient * client,
     sp_buffer_free_callback callback, void * user_data);
-int sp_writer_recv (ShmPipe * self, ShmClient * client, void ** tag);
+int sp_writer_recv (ShmPipe * self, ShmClient * client,
+    sp_buffer_free_callback callback, void * user_data);
+ShmClient *sp_writer_get_clients (ShmPipe * self);
+ShmClient *sp_writer_get_next_client (ShmClient * client);
+int sp_writer_get_client_pending (ShmPipe * self, ShmClient * client,
+    size_t * bytes);
 
 int sp_writer_pending_writes (ShmPipe * self);
 
@@ -113,8 +128,11 @@ ShmBuffer *sp_writer_get_next_buffer (ShmBuffer * buffer);
 void *sp_writer_buf_get_tag (ShmBuffer * buffer);
 
 ShmPipe *sp_client_open (const char *path);
-long int sp_client_recv (ShmPipe * self, char **buf);
+long int sp_client_recv (ShmPipe * self, char **buf, ShmFdBuffer * fd_buf);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
+int sp_client_recv_finish_fd (ShmPipe * self, int id);
+void sp_client_set_ack_batch (ShmPipe * self, int num_acks);
+int sp_client_flush_acks (ShmPipe * self);
 void sp_client_close (ShmPipe * self);
 
 #ifdef __cplusplus
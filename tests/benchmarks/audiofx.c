@@ -0,0 +1,139 @@
+/* GStreamer
+ *
+ * audiofx.c: benchmark of the freeverb and audiochannelmix effects
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the CPU time the effects take per instance, running a number of
+ * instances side by side on stereo 48 kHz noise, and prints one CSV line per
+ * case:
+ *
+ *   element,format,instances,seconds,cpu_ms_per_instance,percent_of_realtime
+ *
+ * The CPU time is the one of the whole process, so it includes producing
+ * the noise. The "identity" element gives that reference, to be subtracted
+ * from the other results. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <time.h>
+
+static const gchar *elements[] = { "identity", "freeverb", "audiochannelmix" };
+
+static const gchar *formats[] = { "S16LE", "F32LE" };
+
+static const guint instances[] = { 1, 8, 40 };
+
+static gboolean
+benchmark_case (const gchar * element, const gchar * format,
+    guint n_instances, guint seconds)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  GError *err = NULL;
+  GString *desc;
+  clock_t start, elapsed;
+  gboolean ret = TRUE;
+  gdouble cpu_ms;
+  guint i;
+
+  desc = g_string_new (NULL);
+  for (i = 0; i < n_instances; i++)
+    g_string_append_printf (desc, "audiotestsrc wave=white-noise "
+        "samplesperbuffer=1024 num-buffers=%u ! "
+        "audio/x-raw,format=%s,rate=48000,channels=2 ! %s ! fakesink ",
+        seconds * 48000 / 1024, format, element);
+  pipeline = gst_parse_launch (desc->str, &err);
+  g_string_free (desc, TRUE);
+  if (!pipeline) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  /* preroll first, so the caps negotiation is not measured */
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+  start = clock ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = clock () - start;
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s,%s,%u failed: %s\n", element, format, n_instances,
+        err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  cpu_ms = (gdouble) elapsed * 1000 / CLOCKS_PER_SEC / n_instances;
+  if (ret)
+    g_print ("%s,%s,%u,%u,%.1f,%.3f\n", element, format, n_instances,
+        seconds, cpu_ms, cpu_ms / (seconds * 10.0));
+
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  gint seconds = 60;
+  GOptionEntry options[] = {
+    {"seconds", 's', 0, G_OPTION_ARG_INT, &seconds,
+        "Seconds of audio to process per instance for each case", NULL},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint i, j, k;
+  gint ret = 0;
+
+  ctx = g_option_context_new ("- benchmark the audio effects");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  g_print ("element,format,instances,seconds,cpu_ms_per_instance,"
+      "percent_of_realtime\n");
+
+  for (i = 0; i < G_N_ELEMENTS (elements); i++)
+    for (j = 0; j < G_N_ELEMENTS (formats); j++)
+      for (k = 0; k < G_N_ELEMENTS (instances); k++)
+        if (!benchmark_case (elements[i], formats[j], instances[k],
+                MAX (seconds, 1)))
+          ret = 1;
+
+  return ret;
+}
@@ -0,0 +1,590 @@
+/* GStreamer
+ *
+ * codecparsers.c: benchmark of the codec parsing library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Times the parsing functions of the codec parsers over a corpus, and prints
+ * one CSV line per function:
+ *
+ *   parser,function,calls,bytes,ns_per_call,mb_per_s
+ *
+ * Recorded streams are given with --corpus, as "h264:<file>" for an H.264
+ * byte-stream, "mpeg2:<file>" for an MPEG-2 video elementary stream or
+ * "vp9:<file>" for an IVF file holding one VP9 superframe per frame. Without
+ * any, small synthetic streams are generated. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gstmpegvideoparser.h>
+#include <gst/codecparsers/gstvp9parser.h>
+
+#include <string.h>
+
+/* minimum duration of a single measurement */
+#define BENCHMARK_MIN_TIME (GST_SECOND / 2)
+
+typedef struct
+{
+  GstClockTime start;
+  guint64 calls;
+  guint64 bytes;
+} Measurement;
+
+static GstClockTime min_time = BENCHMARK_MIN_TIME;
+
+static void
+measurement_start (Measurement * m)
+{
+  m->calls = m->bytes = 0;
+  m->start = gst_util_get_timestamp ();
+}
+
+static gboolean
+measurement_done (Measurement * m)
+{
+  return gst_util_get_timestamp () - m->start >= min_time;
+}
+
+static void
+measurement_print (Measurement * m, const gchar * parser,
+    const gchar * function)
+{
+  GstClockTime elapsed = gst_util_get_timestamp () - m->start;
+
+  if (!m->calls) {
+    g_print ("%s,%s,0,0,0,0\n", parser, function);
+    return;
+  }
+
+  g_print ("%s,%s,%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%.1f,%.2f\n",
+      parser, function, m->calls, m->bytes, (gdouble) elapsed / m->calls,
+      (gdouble) m->bytes * GST_SECOND / elapsed / (1024 * 1024));
+}
+
+/* Synthetic corpora */
+
+typedef struct
+{
+  GByteArray *data;
+  guint32 acc;
+  guint nbits;
+} BitWriter;
+
+static void
+bit_writer_put_bits (BitWriter * bw, guint32 value, guint nbits)
+{
+  while (nbits--) {
+    bw->acc = (bw->acc << 1) | ((value >> nbits) & 1);
+    if (++bw->nbits == 8) {
+      guint8 byte = bw->acc;
+
+      g_byte_array_append (bw->data, &byte, 1);
+      bw->acc = bw->nbits = 0;
+    }
+  }
+}
+
+static void
+bit_writer_put_ue (BitWriter * bw, guint32 value)
+{
+  guint len = g_bit_storage (value + 1);
+
+  bit_writer_put_bits (bw, 0, len - 1);
+  bit_writer_put_bits (bw, value + 1, len);
+}
+
+static void
+bit_writer_put_trailing_bits (BitWriter * bw)
+{
+  bit_writer_put_bits (bw, 1, 1);
+  if (bw->nbits)
+    bit_writer_put_bits (bw, 0, 8 - bw->nbits);
+}
+
+static void
+put_start_code (GByteArray * data, guint8 nal_header)
+{
+  const guint8 sc[] = { 0x00, 0x00, 0x00, 0x01, nal_header };
+
+  g_byte_array_append (data, sc, sizeof (sc));
+}
+
+/* slice data that doesn't need any emulation prevention */
+static void
+put_payload (GByteArray * data, guint size)
+{
+  guint i;
+
+  for (i = 0; i < size; i++) {
+    guint8 byte = (i * 37 + 11) | 0x01;
+
+    g_byte_array_append (data, &byte, 1);
+  }
+}
+
+/* 320x240 baseline stream: SPS, PPS, then an IDR slice followed by P slices,
+ * with every value coded so that no emulation prevention is needed */
+static GByteArray *
+create_h264_corpus (void)
+{
+  BitWriter bw = { g_byte_array_new (), 0, 0 };
+  guint i;
+
+  put_start_code (bw.data, 0x67);
+  bit_writer_put_bits (&bw, 66, 8);     /* profile_idc */
+  bit_writer_put_bits (&bw, 0xc0, 8);   /* constraint_set0/1 */
+  bit_writer_put_bits (&bw, 30, 8);     /* level_idc */
+  bit_writer_put_ue (&bw, 0);   /* seq_parameter_set_id */
+  bit_writer_put_ue (&bw, 0);   /* log2_max_frame_num_minus4 */
+  bit_writer_put_ue (&bw, 2);   /* pic_order_cnt_type */
+  bit_writer_put_ue (&bw, 1);   /* max_num_ref_frames */
+  bit_writer_put_bits (&bw, 0, 1);      /* gaps_in_frame_num_allowed */
+  bit_writer_put_ue (&bw, 19);  /* pic_width_in_mbs_minus1 */
+  bit_writer_put_ue (&bw, 14);  /* pic_height_in_map_units_minus1 */
+  bit_writer_put_bits (&bw, 1, 1);      /* frame_mbs_only_flag */
+  bit_writer_put_bits (&bw, 1, 1);      /* direct_8x8_inference_flag */
+  bit_writer_put_bits (&bw, 0, 1);      /* frame_cropping_flag */
+  bit_writer_put_bits (&bw, 0, 1);      /* vui_parameters_present_flag */
+  bit_writer_put_trailing_bits (&bw);
+
+  put_start_code (bw.data, 0x68);
+  bit_writer_put_ue (&bw, 0);   /* pic_parameter_set_id */
+  bit_writer_put_ue (&bw, 0);   /* seq_parameter_set_id */
+  bit_writer_put_bits (&bw, 0, 1);      /* entropy_coding_mode_flag */
+  bit_writer_put_bits (&bw, 0, 1);      /* bottom_field_pic_order_in_frame */
+  bit_writer_put_ue (&bw, 0);   /* num_slice_groups_minus1 */
+  bit_writer_put_ue (&bw, 0);   /* num_ref_idx_l0_default_active_minus1 */
+  bit_writer_put_ue (&bw, 0);   /* num_ref_idx_l1_default_active_minus1 */
+  bit_writer_put_bits (&bw, 0, 3);      /* weighted_pred/bipred */
+  bit_writer_put_ue (&bw, 0);   /* pic_init_qp_minus26 */
+  bit_writer_put_ue (&bw, 0);   /* pic_init_qs_minus26 */
+  bit_writer_put_ue (&bw, 0);   /* chroma_qp_index_offset */
+  bit_writer_put_bits (&bw, 1, 1);      /* deblocking_filter_control_present */
+  bit_writer_put_bits (&bw, 0, 2);      /* constrained_intra_pred, redundant */
+  bit_writer_put_trailing_bits (&bw);
+
+  for (i = 0; i < 30; i++) {
+    gboolean idr = i == 0;
+
+    put_start_code (bw.data, idr ? 0x65 : 0x41);
+    bit_writer_put_ue (&bw, 0); /* first_mb_in_slice */
+    bit_writer_put_ue (&bw, idr ? 7 : 5);       /* slice_type */
+    bit_writer_put_ue (&bw, 0); /* pic_parameter_set_id */
+    bit_writer_put_bits (&bw, i % 16, 4);       /* frame_num */
+    if (idr) {
+      bit_writer_put_ue (&bw, 0);       /* idr_pic_id */
+      bit_writer_put_bits (&bw, 0, 2);  /* no_output_of_prior_pics, long_term */
+    } else {
+      bit_writer_put_bits (&bw, 0, 1);  /* num_ref_idx_active_override_flag */
+      bit_writer_put_bits (&bw, 0, 1);  /* ref_pic_list_modification_flag_l0 */
+      bit_writer_put_bits (&bw, 0, 1);  /* adaptive_ref_pic_marking_mode */
+    }
+    bit_writer_put_ue (&bw, 0); /* slice_qp_delta */
+    bit_writer_put_ue (&bw, 1); /* disable_deblocking_filter_idc */
+    bit_writer_put_bits (&bw, 1, 1);
+    if (bw.nbits)
+      bit_writer_put_bits (&bw, 0x7f, 8 - bw.nbits);
+    put_payload (bw.data, idr ? 4000 : 600);
+  }
+
+  return bw.data;
+}
+
+/* sequence header, sequence extension and GOP, then 30 I pictures */
+static GByteArray *
+create_mpeg2_corpus (void)
+{
+  static const guint8 seq[] = {
+    0x00, 0x00, 0x01, 0xb3, 0x14, 0x00, 0xf0, 0x13, 0xff, 0xff, 0xe0, 0x18,
+    0x00, 0x00, 0x01, 0xb5, 0x14, 0x8a, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0xb8, 0x00, 0x08, 0x00, 0x00
+  };
+  static const guint8 pic[] = {
+    0x00, 0x00, 0x01, 0x00, 0x00, 0x0f, 0xff, 0xf8,
+    0x00, 0x00, 0x01, 0xb5, 0x8f, 0xff, 0xf3, 0x41, 0x80
+  };
+  GByteArray *data = g_byte_array_new ();
+  guint i, j;
+
+  g_byte_array_append (data, seq, sizeof (seq));
+  for (i = 0; i < 30; i++) {
+    g_byte_array_append (data, pic, sizeof (pic));
+    for (j = 1; j <= 15; j++) {
+      const guint8 slice[] = { 0x00, 0x00, 0x01, j };
+
+      g_byte_array_append (data, slice, sizeof (slice));
+      put_payload (data, 200);
+    }
+  }
+
+  return data;
+}
+
+/* a 352x288 key frame and an inter frame in a superframe */
+static GPtrArray *
+create_vp9_corpus (void)
+{
+  static const guint8 superframe[] = {
+    0x82, 0x49, 0x83, 0x42, 0x20, 0x15, 0xf0, 0x11, 0xf0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x86, 0x00, 0x40, 0x92, 0x00, 0x00, 0x00, 0x00,
+    0xc1, 0x14, 0x08, 0xc1
+  };
+  GPtrArray *frames = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      g_bytes_unref);
+
+  g_ptr_array_add (frames, g_bytes_new_static (superframe,
+          sizeof (superframe)));
+
+  return frames;
+}
+
+/* Recorded corpora */
+
+static GPtrArray *
+read_ivf (const gchar * filename)
+{
+  GPtrArray *frames;
+  gchar *contents;
+  gsize size, pos;
+
+  if (!g_file_get_contents (filename, &contents, &size, NULL)) {
+    g_printerr ("failed to read %s\n", filename);
+    return NULL;
+  }
+
+  if (size < 32 || memcmp (contents, "DKIF", 4)) {
+    g_printerr ("%s is not an IVF file\n", filename);
+    g_free (contents);
+    return NULL;
+  }
+
+  frames = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+  pos = GST_READ_UINT16_LE (contents + 6);
+  while (pos + 12 <= size) {
+    guint32 frame_size = GST_READ_UINT32_LE (contents + pos);
+
+    pos += 12;
+    if (frame_size > size - pos)
+      break;
+    g_ptr_array_add (frames, g_bytes_new (contents + pos, frame_size));
+    pos += frame_size;
+  }
+  g_free (contents);
+
+  return frames;
+}
+
+static GByteArray *
+read_file (const gchar * filename)
+{
+  gchar *contents;
+  gsize size;
+
+  if (!g_file_get_contents (filename, &contents, &size, NULL)) {
+    g_printerr ("failed to read %s\n", filename);
+    return NULL;
+  }
+
+  return g_byte_array_new_take ((guint8 *) contents, size);
+}
+
+/* Benchmarks */
+
+static void
+benchmark_h264 (GByteArray * corpus)
+{
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  GArray *nalus = g_array_new (FALSE, FALSE, sizeof (GstH264NalUnit));
+  GstH264NalUnit nalu;
+  GstH264ParserResult res;
+  Measurement m;
+  guint offset, i;
+
+  /* identify_nalu over the whole corpus, collecting the NALs */
+  measurement_start (&m);
+  do {
+    g_array_set_size (nalus, 0);
+    offset = 0;
+    do {
+      res = gst_h264_parser_identify_nalu (parser, corpus->data, offset,
+          corpus->len, &nalu);
+      if (res != GST_H264_PARSER_OK && res != GST_H264_PARSER_NO_NAL_END)
+        break;
+      g_array_append_val (nalus, nalu);
+      offset = nalu.offset + nalu.size;
+      m.calls++;
+    } while (res == GST_H264_PARSER_OK);
+    m.bytes += corpus->len;
+  } while (!measurement_done (&m));
+  measurement_print (&m, "h264", "identify_nalu");
+
+  /* SPS and PPS first, so that slices can be parsed */
+  for (i = 0; i < nalus->len; i++) {
+    GstH264NalUnit *n = &g_array_index (nalus, GstH264NalUnit, i);
+
+    if (n->type == GST_H264_NAL_SPS || n->type == GST_H264_NAL_PPS)
+      gst_h264_parser_parse_nal (parser, n);
+  }
+
+  measurement_start (&m);
+  do {
+    for (i = 0; i < nalus->len; i++) {
+      GstH264NalUnit *n = &g_array_index (nalus, GstH264NalUnit, i);
+      GstH264SPS sps;
+
+      if (n->type != GST_H264_NAL_SPS)
+        continue;
+      if (gst_h264_parser_parse_sps (parser, n, &sps, TRUE) ==
+          GST_H264_PARSER_OK)
+        gst_h264_sps_clear (&sps);
+      m.calls++;
+      m.bytes += n->size;
+    }
+  } while (m.calls && !measurement_done (&m));
+  measurement_print (&m, "h264", "parse_sps");
+
+  measurement_start (&m);
+  do {
+    for (i = 0; i < nalus->len; i++) {
+      GstH264NalUnit *n = &g_array_index (nalus, GstH264NalUnit, i);
+      GstH264PPS pps;
+
+      if (n->type != GST_H264_NAL_PPS)
+        continue;
+      if (gst_h264_parser_parse_pps (parser, n, &pps) == GST_H264_PARSER_OK)
+        gst_h264_pps_clear (&pps);
+      m.calls++;
+      m.bytes += n->size;
+    }
+  } while (m.calls && !measurement_done (&m));
+  measurement_print (&m, "h264", "parse_pps");
+
+  measurement_start (&m);
+  do {
+    for (i = 0; i < nalus->len; i++) {
+      GstH264NalUnit *n = &g_array_index (nalus, GstH264NalUnit, i);
+      GstH264SliceHdr slice;
+
+      if (n->type < GST_H264_NAL_SLICE || n->type > GST_H264_NAL_SLICE_IDR)
+        continue;
+      gst_h264_parser_parse_slice_hdr (parser, n, &slice, TRUE, TRUE);
+      m.calls++;
+      m.bytes += n->size;
+    }
+  } while (m.calls && !measurement_done (&m));
+  measurement_print (&m, "h264", "parse_slice_hdr");
+
+  g_array_free (nalus, TRUE);
+  gst_h264_nal_parser_free (parser);
+}
+
+static void
+benchmark_mpeg2 (GByteArray * corpus)
+{
+  GArray *packets = g_array_new (FALSE, FALSE, sizeof (GstMpegVideoPacket));
+  GstMpegVideoPacket packet;
+  Measurement m;
+  guint offset, i;
+
+  measurement_start (&m);
+  do {
+    g_array_set_size (packets, 0);
+    offset = 0;
+    while (gst_mpeg_video_parse (&packet, corpus->data, corpus->len, offset)) {
+      g_array_append_val (packets, packet);
+      m.calls++;
+      if (packet.size < 0)
+        break;
+      offset = packet.offset + packet.size;
+    }
+    m.bytes += corpus->len;
+  } while (!measurement_done (&m));
+  measurement_print (&m, "mpeg2", "parse");
+
+  measurement_start (&m);
+  do {
+    for (i = 0; i < packets->len; i++) {
+      GstMpegVideoPacket *p = &g_array_index (packets, GstMpegVideoPacket, i);
+      GstMpegVideoSequenceHdr seqhdr;
+
+      if (p->type != GST_MPEG_VIDEO_PACKET_SEQUENCE)
+        continue;
+      gst_mpeg_video_packet_parse_sequence_header (p, &seqhdr);
+      m.calls++;
+      m.bytes += p->size;
+    }
+  } while (m.calls && !measurement_done (&m));
+  measurement_print (&m, "mpeg2", "parse_sequence_header");
+
+  measurement_start (&m);
+  do {
+    for (i = 0; i < packets->len; i++) {
+      GstMpegVideoPacket *p = &g_array_index (packets, GstMpegVideoPacket, i);
+      GstMpegVideoPictureHdr pichdr;
+
+      if (p->type != GST_MPEG_VIDEO_PACKET_PICTURE)
+        continue;
+      gst_mpeg_video_packet_parse_picture_header (p, &pichdr);
+      m.calls++;
+      m.bytes += p->size;
+    }
+  } while (m.calls && !measurement_done (&m));
+  measurement_print (&m, "mpeg2", "parse_picture_header");
+
+  g_array_free (packets, TRUE);
+}
+
+static void
+benchmark_vp9 (GPtrArray * corpus)
+{
+  GstVp9Parser *parser = gst_vp9_parser_new ();
+  GstVp9SuperframeInfo info;
+  GstVp9FrameHdr frame_hdr;
+  Measurement m;
+  guint i, j;
+
+  measurement_start (&m);
+  do {
+    for (i = 0; i < corpus->len; i++) {
+      gsize size;
+      const guint8 *data = g_bytes_get_data (g_ptr_array_index (corpus, i),
+          &size);
+
+      gst_vp9_parser_parse_superframe_info (parser, &info, data, size);
+      m.calls++;
+      m.bytes += size;
+    }
+  } while (!measurement_done (&m));
+  measurement_print (&m, "vp9", "parse_superframe_info");
+
+  measurement_start (&m);
+  do {
+    for (i = 0; i < corpus->len; i++) {
+      gsize size, offset = 0;
+      const guint8 *data = g_bytes_get_data (g_ptr_array_index (corpus, i),
+          &size);
+
+      if (gst_vp9_parser_parse_superframe_info (parser, &info, data, size))
+        continue;
+      for (j = 0; j < info.frames_in_superframe; j++) {
+        gst_vp9_parser_parse_frame_header (parser, &frame_hdr, data + offset,
+            info.frame_sizes[j]);
+        offset += info.frame_sizes[j];
+        m.calls++;
+        m.bytes += info.frame_sizes[j];
+      }
+    }
+  } while (m.calls && !measurement_done (&m));
+  measurement_print (&m, "vp9", "parse_frame_header");
+
+  gst_vp9_parser_free (parser);
+}
+
+int
+main (int argc, char **argv)
+{
+  gchar **corpora = NULL;
+  gdouble min_seconds = (gdouble) BENCHMARK_MIN_TIME / GST_SECOND;
+  GOptionEntry options[] = {
+    {"corpus", 'c', 0, G_OPTION_ARG_STRING_ARRAY, &corpora,
+        "Stream to parse, as <h264|mpeg2|vp9>:<file>", NULL},
+    {"time", 't', 0, G_OPTION_ARG_DOUBLE, &min_seconds,
+        "Minimum duration of each measurement, in seconds", NULL},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gint ret = 0;
+
+  ctx = g_option_context_new ("- benchmark the codec parsers");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  min_time = min_seconds * GST_SECOND;
+
+  g_print ("parser,function,calls,bytes,ns_per_call,mb_per_s\n");
+
+  if (!corpora) {
+    GByteArray *data;
+    GPtrArray *frames;
+
+    data = create_h264_corpus ();
+    benchmark_h264 (data);
+    g_byte_array_unref (data);
+
+    data = create_mpeg2_corpus ();
+    benchmark_mpeg2 (data);
+    g_byte_array_unref (data);
+
+    frames = create_vp9_corpus ();
+    benchmark_vp9 (frames);
+    g_ptr_array_unref (frames);
+  } else {
+    gchar **corpus;
+
+    for (corpus = corpora; *corpus; corpus++) {
+      if (g_str_has_prefix (*corpus, "h264:")) {
+        GByteArray *data = read_file (*corpus + 5);
+
+        if (data) {
+          benchmark_h264 (data);
+          g_byte_array_unref (data);
+        } else {
+          ret = 1;
+        }
+      } else if (g_str_has_prefix (*corpus, "mpeg2:")) {
+        GByteArray *data = read_file (*corpus + 6);
+
+        if (data) {
+          benchmark_mpeg2 (data);
+          g_byte_array_unref (data);
+        } else {
+          ret = 1;
+        }
+      } else if (g_str_has_prefix (*corpus, "vp9:")) {
+        GPtrArray *frames = read_ivf (*corpus + 4);
+
+        if (frames) {
+          benchmark_vp9 (frames);
+          g_ptr_array_unref (frames);
+        } else {
+          ret = 1;
+        }
+      } else {
+        g_printerr ("unknown corpus %s\n", *corpus);
+        ret = 1;
+      }
+    }
+  }
+
+  g_strfreev (corpora);
+
+  return ret;
+}
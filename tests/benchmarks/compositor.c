@@ -0,0 +1,153 @@
+/* GStreamer
+ *
+ * compositor.c: benchmark of the compositor transitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the time compositor spends per output frame while transitioning
+ * between two full-frame inputs, and prints one CSV line per case:
+ *
+ *   format,width,height,transition,frames,us_per_frame
+ *
+ * The "none" transition composites the inputs without crossfading, as a
+ * reference. The time is taken from the aggregation statistics of the
+ * compositor, so it does not include producing the input frames. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+static const gchar *formats[] = { "I420", "NV12", "AYUV" };
+
+static const struct
+{
+  gint width, height;
+} sizes[] = {
+  {1920, 1080}, {3840, 2160}
+};
+
+static const gchar *transitions[] = {
+  "none", "crossfade", "wipe-left", "wipe-down", "slide-left", "slide-up"
+};
+
+static gboolean
+benchmark_case (const gchar * format, gint width, gint height,
+    const gchar * transition, guint n_frames)
+{
+  GstElement *pipeline, *comp;
+  GstStructure *stats = NULL;
+  guint64 count = 0, time = 0;
+  GstMessage *msg;
+  GstBus *bus;
+  GError *err = NULL;
+  gchar *desc, *pad_props;
+  gboolean ret = TRUE;
+
+  if (g_str_equal (transition, "none"))
+    pad_props = g_strdup ("");
+  else
+    pad_props = g_strdup_printf ("sink_0::crossfade-ratio=0.5 "
+        "sink_0::transition=%s", transition);
+
+  desc = g_strdup_printf ("compositor name=comp %s ! "
+      "video/x-raw,format=%s ! fakesink "
+      "videotestsrc num-buffers=%u ! "
+      "video/x-raw,format=%s,width=%d,height=%d ! comp. "
+      "videotestsrc num-buffers=%u pattern=ball ! "
+      "video/x-raw,format=%s,width=%d,height=%d ! comp.", pad_props, format,
+      n_frames, format, width, height, n_frames, format, width, height);
+  pipeline = gst_parse_launch (desc, &err);
+  g_free (desc);
+  g_free (pad_props);
+  if (!pipeline) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s,%d,%d,%s failed: %s\n", format, width, height, transition,
+        err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  comp = gst_bin_get_by_name (GST_BIN (pipeline), "comp");
+  g_object_get (comp, "stats", &stats, NULL);
+  gst_object_unref (comp);
+  if (stats) {
+    gst_structure_get_uint64 (stats, "aggregate-count", &count);
+    gst_structure_get_uint64 (stats, "aggregate-time", &time);
+    gst_structure_free (stats);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  if (ret)
+    g_print ("%s,%d,%d,%s,%" G_GUINT64_FORMAT ",%.1f\n", format, width,
+        height, transition, count,
+        count ? (gdouble) time / count / GST_USECOND : 0.0);
+
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  gint n_frames = 30;
+  GOptionEntry options[] = {
+    {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+        "Number of frames to composite for each case", NULL},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint i, j, k;
+  gint ret = 0;
+
+  ctx = g_option_context_new ("- benchmark the compositor transitions");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  g_print ("format,width,height,transition,frames,us_per_frame\n");
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    for (j = 0; j < G_N_ELEMENTS (formats); j++)
+      for (k = 0; k < G_N_ELEMENTS (transitions); k++)
+        if (!benchmark_case (formats[j], sizes[i].width, sizes[i].height,
+                transitions[k], MAX (n_frames, 1)))
+          ret = 1;
+
+  return ret;
+}
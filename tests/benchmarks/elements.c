@@ -0,0 +1,606 @@
+/* GStreamer
+ *
+ * elements.c: throughput benchmarks of muxers, demuxers, parsers, mixers
+ * and shared memory transport
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of tsmux and tsdemux (packets per second),
+ * compositor (frames per second per number of inputs), audiomixer (per
+ * number of pads and channels), h264parse and h265parse (MB/s) and of a
+ * shmsink to shmsrc round trip (frames per second). The results are printed
+ * as one JSON object, with one entry per case in its "results" array, so
+ * that they can be stored and compared between runs.
+ *
+ * The encoded streams are produced once at the start from the same
+ * videotestsrc input with a fixed bitrate, with whichever of the encoders is
+ * available; cases whose elements are missing are skipped with a note on
+ * stderr. Each case is run a number of times and the fastest run is kept.
+ * The tsmux case includes the time h264parse takes to frame the stream. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+
+#define TS_PACKET_SIZE 188
+
+static const struct
+{
+  const gchar *codec;
+  const gchar *encoder;
+} encoders[] = {
+  {"h264", "x264enc bitrate=8000 speed-preset=ultrafast key-int-max=30"},
+  {"h264", "openh264enc bitrate=8000000"},
+  {"h265", "x265enc bitrate=8000 speed-preset=ultrafast key-int-max=30"}
+};
+
+static const guint compositor_inputs[] = { 1, 2, 4, 8, 16 };
+
+static const guint audiomixer_pads[] = { 2, 8, 32 };
+
+static const guint audiomixer_channels[] = { 1, 2, 8 };
+
+static guint n_runs = 3;
+static GPtrArray *results;
+
+static GString *
+result_new (const gchar * name)
+{
+  GString *r = g_string_new (NULL);
+
+  g_string_append_printf (r, "{\"case\": \"%s\"", name);
+
+  return r;
+}
+
+static void
+result_add_uint (GString * r, const gchar * key, guint64 value)
+{
+  g_string_append_printf (r, ", \"%s\": %" G_GUINT64_FORMAT, key, value);
+}
+
+static void
+result_add_double (GString * r, const gchar * key, gdouble value)
+{
+  gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  /* not g_print, the decimal separator of the locale is no valid JSON */
+  g_string_append_printf (r, ", \"%s\": %s", key,
+      g_ascii_formatd (buf, sizeof (buf), "%.3f", value));
+}
+
+static void
+result_finish (GString * r)
+{
+  g_string_append_c (r, '}');
+  g_ptr_array_add (results, g_string_free (r, FALSE));
+}
+
+static gboolean
+have_element (const gchar * desc)
+{
+  GstElementFactory *factory;
+  gchar *name;
+
+  name = g_strndup (desc, strcspn (desc, " "));
+  factory = gst_element_factory_find (name);
+  if (!factory)
+    g_printerr ("Element %s not available, skipping\n", name);
+  else
+    gst_object_unref (factory);
+  g_free (name);
+
+  return factory != NULL;
+}
+
+static guint64
+file_size (const gchar * filename)
+{
+  GStatBuf st;
+
+  if (g_stat (filename, &st) < 0)
+    return 0;
+
+  return st.st_size;
+}
+
+/* Runs @desc until EOS and returns the time that took in @seconds. If
+ * @pipeline_out is given, the pipeline is returned there instead of being
+ * shut down, to read statistics from its elements. */
+static gboolean
+run_pipeline (const gchar * desc, gdouble * seconds,
+    GstElement ** pipeline_out)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  GError *err = NULL;
+  gboolean ret = TRUE;
+  gint64 start;
+
+  pipeline = gst_parse_launch (desc, &err);
+  if (!pipeline) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (seconds)
+    *seconds = (gdouble) (g_get_monotonic_time () - start) / G_USEC_PER_SEC;
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s failed: %s\n", desc, err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  if (ret && pipeline_out) {
+    *pipeline_out = pipeline;
+  } else {
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+  }
+
+  return ret;
+}
+
+/* runs @desc n_runs times and returns the fastest run */
+static gboolean
+run_pipeline_best (const gchar * desc, gdouble * seconds)
+{
+  gdouble s;
+  guint i;
+
+  *seconds = G_MAXDOUBLE;
+  for (i = 0; i < n_runs; i++) {
+    if (!run_pipeline (desc, &s, NULL))
+      return FALSE;
+    *seconds = MIN (*seconds, s);
+  }
+
+  return TRUE;
+}
+
+/* Returns the per-frame time of the aggregator called "mix" over n_runs
+ * runs of @desc, taking the fastest run */
+static gboolean
+run_aggregator_best (const gchar * desc, guint64 * count,
+    gdouble * us_per_buffer)
+{
+  GstElement *pipeline, *mix;
+  GstStructure *stats;
+  guint64 c, time;
+  guint i;
+
+  *count = 0;
+  *us_per_buffer = G_MAXDOUBLE;
+  for (i = 0; i < n_runs; i++) {
+    if (!run_pipeline (desc, NULL, &pipeline))
+      return FALSE;
+
+    c = time = 0;
+    mix = gst_bin_get_by_name (GST_BIN (pipeline), "mix");
+    g_object_get (mix, "stats", &stats, NULL);
+    gst_object_unref (mix);
+    if (stats) {
+      gst_structure_get_uint64 (stats, "aggregate-count", &c);
+      gst_structure_get_uint64 (stats, "aggregate-time", &time);
+      gst_structure_free (stats);
+    }
+
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+
+    if (c) {
+      *count = c;
+      *us_per_buffer = MIN (*us_per_buffer,
+          (gdouble) time / c / GST_USECOND);
+    }
+  }
+
+  return *count > 0;
+}
+
+static gchar *
+encode_stream (const gchar * dir, const gchar * codec, guint n_frames)
+{
+  gchar *filename, *desc;
+  gboolean ok = FALSE;
+  guint i;
+
+  filename = g_build_filename (dir, codec, NULL);
+  for (i = 0; i < G_N_ELEMENTS (encoders) && !ok; i++) {
+    if (!g_str_equal (encoders[i].codec, codec)
+        || !have_element (encoders[i].encoder))
+      continue;
+
+    desc = g_strdup_printf ("videotestsrc num-buffers=%u pattern=snow ! "
+        "video/x-raw,format=I420,width=1280,height=720,framerate=30/1 ! "
+        "%s ! video/x-%s,stream-format=byte-stream ! filesink location=%s",
+        n_frames, encoders[i].encoder, codec, filename);
+    ok = run_pipeline (desc, NULL, NULL) && file_size (filename) > 0;
+    g_free (desc);
+  }
+
+  if (!ok) {
+    g_printerr ("No %s stream, skipping its cases\n", codec);
+    g_unlink (filename);
+    g_clear_pointer (&filename, g_free);
+  }
+
+  return filename;
+}
+
+static gboolean
+benchmark_parser (const gchar * codec, const gchar * filename)
+{
+  GString *r;
+  gchar *desc, *name;
+  gdouble seconds;
+  guint64 size = file_size (filename);
+  gboolean ret;
+
+  name = g_strdup_printf ("%sparse", codec);
+  if (!have_element (name)) {
+    g_free (name);
+    return TRUE;
+  }
+
+  desc = g_strdup_printf ("filesrc location=%s ! %s ! fakesink", filename,
+      name);
+  ret = run_pipeline_best (desc, &seconds);
+  g_free (desc);
+
+  if (ret) {
+    r = result_new (name);
+    result_add_uint (r, "bytes", size);
+    result_add_double (r, "seconds", seconds);
+    result_add_double (r, "mb_per_s", size / seconds / 1000000.0);
+    result_finish (r);
+  }
+  g_free (name);
+
+  return ret;
+}
+
+static gboolean
+benchmark_ts (const gchar * dir, const gchar * h264)
+{
+  GString *r;
+  gchar *desc, *ts;
+  gdouble seconds;
+  guint64 packets;
+  gboolean ret;
+
+  if (!have_element ("tsmux") || !have_element ("tsdemux")
+      || !have_element ("h264parse"))
+    return TRUE;
+
+  ts = g_build_filename (dir, "ts", NULL);
+  desc = g_strdup_printf ("filesrc location=%s ! h264parse ! tsmux ! "
+      "filesink location=%s", h264, ts);
+  ret = run_pipeline (desc, NULL, NULL);
+  g_free (desc);
+  packets = file_size (ts) / TS_PACKET_SIZE;
+
+  if (ret) {
+    desc = g_strdup_printf ("filesrc location=%s ! h264parse ! tsmux ! "
+        "fakesink", h264);
+    ret = run_pipeline_best (desc, &seconds);
+    g_free (desc);
+
+    if (ret) {
+      r = result_new ("tsmux");
+      result_add_uint (r, "packets", packets);
+      result_add_double (r, "seconds", seconds);
+      result_add_double (r, "packets_per_second", packets / seconds);
+      result_finish (r);
+    }
+  }
+
+  if (ret) {
+    desc = g_strdup_printf ("filesrc location=%s ! tsdemux ! fakesink", ts);
+    ret = run_pipeline_best (desc, &seconds);
+    g_free (desc);
+
+    if (ret) {
+      r = result_new ("tsdemux");
+      result_add_uint (r, "packets", packets);
+      result_add_double (r, "seconds", seconds);
+      result_add_double (r, "packets_per_second", packets / seconds);
+      result_finish (r);
+    }
+  }
+
+  g_unlink (ts);
+  g_free (ts);
+
+  return ret;
+}
+
+static gboolean
+benchmark_compositor (guint n_inputs, guint n_frames)
+{
+  GString *desc, *r;
+  guint64 count;
+  gdouble us;
+  gboolean ret;
+  guint i;
+
+  desc = g_string_new ("compositor name=mix ! "
+      "video/x-raw,format=I420,width=1920,height=1080 ! fakesink ");
+  /* spread the inputs over a grid, so that all of them are visible */
+  for (i = 0; i < n_inputs; i++)
+    g_string_append_printf (desc, "videotestsrc num-buffers=%u pattern=ball ! "
+        "video/x-raw,format=I420,width=480,height=270 ! mix.sink_%u ", n_frames,
+        i);
+  for (i = 0; i < n_inputs; i++)
+    g_string_append_printf (desc, "mix.sink_%u::xpos=%u mix.sink_%u::ypos=%u ",
+        i, (i % 4) * 480, i, (i / 4) * 270);
+  ret = run_aggregator_best (desc->str, &count, &us);
+  g_string_free (desc, TRUE);
+
+  if (ret) {
+    r = result_new ("compositor");
+    result_add_uint (r, "inputs", n_inputs);
+    result_add_uint (r, "frames", count);
+    result_add_double (r, "us_per_frame", us);
+    result_add_double (r, "frames_per_second", G_USEC_PER_SEC / us);
+    result_finish (r);
+  }
+
+  return ret;
+}
+
+static gboolean
+benchmark_audiomixer (guint n_pads, guint channels, guint n_buffers)
+{
+  GString *desc, *r;
+  guint64 count;
+  gdouble us;
+  gboolean ret;
+  guint i;
+
+  desc = g_string_new ("audiomixer name=mix ! fakesink ");
+  for (i = 0; i < n_pads; i++)
+    g_string_append_printf (desc, "audiotestsrc num-buffers=%u "
+        "samplesperbuffer=1024 wave=white-noise ! "
+        "audio/x-raw,format=F32LE,rate=48000,channels=%u ! mix. ", n_buffers,
+        channels);
+  ret = run_aggregator_best (desc->str, &count, &us);
+  g_string_free (desc, TRUE);
+
+  if (ret) {
+    r = result_new ("audiomixer");
+    result_add_uint (r, "pads", n_pads);
+    result_add_uint (r, "channels", channels);
+    result_add_uint (r, "buffers", count);
+    result_add_double (r, "us_per_buffer", us);
+    /* 1024 samples at 48 kHz per buffer */
+    result_add_double (r, "realtime_factor", 1024.0 * G_USEC_PER_SEC /
+        48000 / us);
+    result_finish (r);
+  }
+
+  return ret;
+}
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint received;
+} ShmData;
+
+static void
+shm_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    ShmData * data)
+{
+  g_mutex_lock (&data->lock);
+  data->received++;
+  g_cond_signal (&data->cond);
+  g_mutex_unlock (&data->lock);
+}
+
+static gboolean
+benchmark_shm (const gchar * dir, guint n_frames)
+{
+  GstElement *sender, *receiver, *sink;
+  ShmData data;
+  GString *r;
+  GError *err = NULL;
+  gchar *path, *desc;
+  gint64 start, end, elapsed;
+  gboolean ret = TRUE;
+  guint frame_size = 1920 * 1080 * 3 / 2;
+
+  if (!have_element ("shmsink") || !have_element ("shmsrc"))
+    return TRUE;
+
+  path = g_build_filename (dir, "shm", NULL);
+  desc = g_strdup_printf ("videotestsrc num-buffers=%u ! "
+      "video/x-raw,format=I420,width=1920,height=1080,framerate=30/1 ! "
+      "shmsink socket-path=%s shm-size=%u wait-for-connection=true "
+      "sync=false", n_frames, path, 8 * frame_size);
+  sender = gst_parse_launch (desc, &err);
+  g_free (desc);
+  if (!sender) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    g_free (path);
+    return FALSE;
+  }
+
+  /* the sender creates the socket and waits for the receiver, whose
+   * fakesink counts the frames that made it through */
+  desc = g_strdup_printf ("shmsrc socket-path=%s ! "
+      "video/x-raw,format=I420,width=1920,height=1080,framerate=30/1 ! "
+      "fakesink name=sink signal-handoffs=true sync=false", path);
+  receiver = gst_parse_launch (desc, &err);
+  g_free (desc);
+  if (!receiver) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    gst_object_unref (sender);
+    g_free (path);
+    return FALSE;
+  }
+
+  memset (&data, 0, sizeof (data));
+  g_mutex_init (&data.lock);
+  g_cond_init (&data.cond);
+  sink = gst_bin_get_by_name (GST_BIN (receiver), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (shm_handoff_cb), &data);
+  gst_object_unref (sink);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (sender, GST_STATE_PLAYING);
+  gst_element_set_state (receiver, GST_STATE_PLAYING);
+
+  end = g_get_monotonic_time () + 60 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&data.lock);
+  while (data.received < n_frames)
+    if (!g_cond_wait_until (&data.cond, &data.lock, end))
+      break;
+  elapsed = g_get_monotonic_time () - start;
+  if (data.received < n_frames) {
+    g_printerr ("shm round trip timed out after %u frames\n", data.received);
+    ret = FALSE;
+  }
+  g_mutex_unlock (&data.lock);
+
+  gst_element_set_state (receiver, GST_STATE_NULL);
+  gst_element_set_state (sender, GST_STATE_NULL);
+  gst_object_unref (receiver);
+  gst_object_unref (sender);
+  g_mutex_clear (&data.lock);
+  g_cond_clear (&data.cond);
+  g_unlink (path);
+  g_free (path);
+
+  if (ret) {
+    gdouble seconds = (gdouble) elapsed / G_USEC_PER_SEC;
+
+    r = result_new ("shm");
+    result_add_uint (r, "frames", n_frames);
+    result_add_uint (r, "frame_size", frame_size);
+    result_add_double (r, "seconds", seconds);
+    result_add_double (r, "frames_per_second", n_frames / seconds);
+    result_add_double (r, "mb_per_s", (gdouble) n_frames * frame_size /
+        seconds / 1000000.0);
+    result_finish (r);
+  }
+
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  gint n_frames = 300;
+  gint runs = 3;
+  GOptionEntry options[] = {
+    {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+        "Number of frames of the streams of each case", NULL},
+    {"runs", 'r', 0, G_OPTION_ARG_INT, &runs,
+        "Number of runs of each case, the fastest one is kept", NULL},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gchar *dir, *h264, *h265;
+  guint i, j;
+  gint ret = 0;
+
+  ctx = g_option_context_new ("- benchmark the throughput of elements");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  n_frames = MAX (n_frames, 1);
+  n_runs = MAX (runs, 1);
+
+  dir = g_dir_make_tmp ("gst-benchmark-XXXXXX", &err);
+  if (!dir) {
+    g_printerr ("Could not create directory: %s\n", err->message);
+    g_clear_error (&err);
+    return 1;
+  }
+
+  results = g_ptr_array_new_with_free_func (g_free);
+
+  h264 = encode_stream (dir, "h264", n_frames);
+  h265 = encode_stream (dir, "h265", n_frames);
+
+  if (h264 && !benchmark_ts (dir, h264))
+    ret = 1;
+  if (h264 && !benchmark_parser ("h264", h264))
+    ret = 1;
+  if (h265 && !benchmark_parser ("h265", h265))
+    ret = 1;
+
+  for (i = 0; i < G_N_ELEMENTS (compositor_inputs); i++)
+    if (!benchmark_compositor (compositor_inputs[i], n_frames))
+      ret = 1;
+
+  for (i = 0; i < G_N_ELEMENTS (audiomixer_pads); i++)
+    for (j = 0; j < G_N_ELEMENTS (audiomixer_channels); j++)
+      if (!benchmark_audiomixer (audiomixer_pads[i], audiomixer_channels[j],
+              n_frames))
+        ret = 1;
+
+  if (!benchmark_shm (dir, n_frames))
+    ret = 1;
+
+  g_print ("{\n  \"benchmark\": \"elements\",\n  \"results\": [");
+  for (i = 0; i < results->len; i++)
+    g_print ("%s\n    %s", i ? "," : "", (gchar *) g_ptr_array_index (results,
+            i));
+  g_print ("\n  ]\n}\n");
+  g_ptr_array_unref (results);
+
+  if (h264) {
+    g_unlink (h264);
+    g_free (h264);
+  }
+  if (h265) {
+    g_unlink (h265);
+    g_free (h265);
+  }
+  g_rmdir (dir);
+  g_free (dir);
+
+  return ret;
+}
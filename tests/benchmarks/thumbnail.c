@@ -0,0 +1,174 @@
+/* GStreamer
+ *
+ * thumbnail.c: benchmark of decoding WebP images to thumbnails
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures how many images per second webpdec turns into thumbnails, either
+ * with a new pipeline for each image or with one pipeline decoding all of
+ * them, and either at full resolution or scaled down while decoding. Prints
+ * one CSV line per case:
+ *
+ *   mode,size,images,seconds,images_per_second
+ *
+ * The images are all the same 1920x1080 test picture, encoded once. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+
+static const struct
+{
+  const gchar *name;
+  const gchar *props;
+} sizes[] = {
+  {"full", ""}, {"160x160", " max-width=160 max-height=160"}
+};
+
+static gboolean
+run_pipeline (const gchar * desc)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  GError *err = NULL;
+  gboolean ret = TRUE;
+
+  pipeline = gst_parse_launch (desc, &err);
+  if (!pipeline) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s failed: %s\n", desc, err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return ret;
+}
+
+static gboolean
+benchmark_case (const gchar * filename, gboolean reuse, guint size,
+    guint n_images)
+{
+  gint64 start, elapsed;
+  gboolean ret = TRUE;
+  gdouble seconds;
+  gchar *desc;
+  guint i;
+
+  start = g_get_monotonic_time ();
+  if (reuse) {
+    /* without a %d in the location, the same file is read again for each
+     * buffer */
+    desc = g_strdup_printf ("multifilesrc location=%s num-buffers=%u "
+        "caps=image/webp ! webpdec%s ! fakesink", filename, n_images,
+        sizes[size].props);
+    ret = run_pipeline (desc);
+    g_free (desc);
+  } else {
+    desc = g_strdup_printf ("filesrc location=%s ! webpdec%s ! fakesink",
+        filename, sizes[size].props);
+    for (i = 0; i < n_images && ret; i++)
+      ret = run_pipeline (desc);
+    g_free (desc);
+  }
+  elapsed = g_get_monotonic_time () - start;
+
+  seconds = (gdouble) elapsed / G_USEC_PER_SEC;
+  if (ret)
+    g_print ("%s,%s,%u,%.3f,%.1f\n", reuse ? "reused-pipeline" :
+        "pipeline-per-image", sizes[size].name, n_images, seconds,
+        n_images / seconds);
+
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  gint images = 200;
+  GOptionEntry options[] = {
+    {"images", 'n', 0, G_OPTION_ARG_INT, &images,
+        "Number of images to decode for each case", NULL},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gchar *filename, *desc;
+  guint i;
+  gint fd;
+  gint ret = 0;
+
+  ctx = g_option_context_new ("- benchmark WebP thumbnails");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  fd = g_file_open_tmp ("gst-thumbnail-XXXXXX.webp", &filename, &err);
+  if (fd < 0) {
+    g_printerr ("Could not create image file: %s\n", err->message);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_close (fd, NULL);
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=1 ! "
+      "video/x-raw,width=1920,height=1080 ! webpenc ! filesink location=%s",
+      filename);
+  if (!run_pipeline (desc))
+    ret = 1;
+  g_free (desc);
+
+  if (!ret) {
+    g_print ("mode,size,images,seconds,images_per_second\n");
+
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+      if (!benchmark_case (filename, FALSE, i, MAX (images, 1)))
+        ret = 1;
+      if (!benchmark_case (filename, TRUE, i, MAX (images, 1)))
+        ret = 1;
+    }
+  }
+
+  g_unlink (filename);
+  g_free (filename);
+
+  return ret;
+}
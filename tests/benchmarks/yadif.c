@@ -0,0 +1,139 @@
+/* GStreamer
+ *
+ * yadif.c: benchmark of the yadif deinterlacer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of yadif on interlaced test frames for a number of
+ * thread counts, and prints one CSV line per case:
+ *
+ *   format,width,height,threads,frames,fps,fps_per_thread
+ *
+ * The line filter is picked at runtime from the instruction sets of the CPU,
+ * so the results of one run are for the best kernel available. The time
+ * includes producing the test frames, which are a plain black pattern to
+ * keep that small. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+static const gchar *formats[] = { "I420", "Y444", "I420_10LE" };
+
+static const struct
+{
+  gint width, height;
+} sizes[] = {
+  {1920, 1080}, {3840, 2160}
+};
+
+static const guint threads[] = { 1, 2, 4, 8 };
+
+static gboolean
+benchmark_case (const gchar * format, gint width, gint height,
+    guint n_threads, guint n_frames)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  GError *err = NULL;
+  gchar *desc;
+  gint64 start, elapsed;
+  gboolean ret = TRUE;
+  gdouble fps;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%u pattern=black ! "
+      "video/x-raw,format=%s,width=%d,height=%d,interlace-mode=interleaved ! "
+      "yadif n-threads=%u ! fakesink", n_frames, format, width, height,
+      n_threads);
+  pipeline = gst_parse_launch (desc, &err);
+  g_free (desc);
+  if (!pipeline) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  /* preroll first, so the caps negotiation is not measured */
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = g_get_monotonic_time () - start;
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s,%d,%d,%u failed: %s\n", format, width, height, n_threads,
+        err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  fps = elapsed > 0 ? (gdouble) n_frames * G_USEC_PER_SEC / elapsed : 0.0;
+  if (ret)
+    g_print ("%s,%d,%d,%u,%u,%.1f,%.1f\n", format, width, height, n_threads,
+        n_frames, fps, fps / n_threads);
+
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  gint n_frames = 100;
+  GOptionEntry options[] = {
+    {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+        "Number of frames to deinterlace for each case", NULL},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint i, j, k;
+  gint ret = 0;
+
+  ctx = g_option_context_new ("- benchmark the yadif deinterlacer");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  g_print ("format,width,height,threads,frames,fps,fps_per_thread\n");
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    for (j = 0; j < G_N_ELEMENTS (formats); j++)
+      for (k = 0; k < G_N_ELEMENTS (threads); k++)
+        if (!benchmark_case (formats[j], sizes[i].width, sizes[i].height,
+                threads[k], MAX (n_frames, 1)))
+          ret = 1;
+
+  return ret;
+}
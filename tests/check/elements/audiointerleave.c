@@ -673,6 +673,75 @@ GST_START_TEST (test_audiointerleave_2ch_pipeline_non_audiointerleaved)
 
 GST_END_TEST;
 
+static void
+sink_handoff_float32_planar (GstElement * element, GstBuffer * buffer,
+    GstPad * pad, gpointer user_data)
+{
+  gint i, n_samples;
+  GstMapInfo map;
+  gfloat *data;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  data = (gfloat *) map.data;
+  n_samples = map.size / sizeof (gfloat);
+
+  /* first the plane of the first channel, then the one of the second */
+  for (i = 0; i < n_samples; i++)
+    fail_unless_equals_float (data[i], i < n_samples / 2 ? -1.0 : 1.0);
+  have_data += map.size;
+
+  gst_buffer_unmap (buffer, &map);
+}
+
+GST_START_TEST (test_audiointerleave_2ch_pipeline_planar_output)
+{
+  GstElement *pipeline, *src, *interleave, *filter, *sink;
+  GstCaps *caps;
+  GstMessage *msg;
+  gint i;
+
+  have_data = 0;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  interleave = gst_element_factory_make ("audiointerleave", "audiointerleave");
+  filter = gst_element_factory_make ("capsfilter", "filter");
+  caps = gst_caps_from_string ("audio/x-raw, layout=non-interleaved");
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  sink = gst_element_factory_make ("fakesink", "sink");
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (sink_handoff_float32_planar),
+      NULL);
+  gst_bin_add_many (GST_BIN (pipeline), interleave, filter, sink, NULL);
+  fail_unless (gst_element_link_many (interleave, filter, sink, NULL));
+
+  for (i = 0; i < 2; i++) {
+    src = gst_element_factory_make ("fakesrc", NULL);
+    g_object_set (src, "num-buffers", 4, "sizetype", 2,
+        "sizemax", (int) 48000 * sizeof (gfloat),
+        "datarate", (int) 48000 * sizeof (gfloat),
+        "signal-handoffs", TRUE, "format", GST_FORMAT_TIME, NULL);
+    g_signal_connect (src, "handoff",
+        G_CALLBACK (src_handoff_float32_non_audiointerleaved),
+        GINT_TO_POINTER (i));
+    gst_bin_add (GST_BIN (pipeline), src);
+    fail_unless (gst_element_link (src, interleave));
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  msg = gst_bus_poll (GST_ELEMENT_BUS (pipeline), GST_MESSAGE_EOS, -1);
+  gst_message_unref (msg);
+
+  /* 48000 samples per buffer * 2 sources * 4 buffers */
+  fail_unless (have_data == 48000 * 2 * 4 * sizeof (gfloat));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_audiointerleave_2ch_pipeline_input_chanpos)
 {
   GstElement *pipeline, *queue, *src1, *src2, *interleave, *sink;
@@ -1117,6 +1186,7 @@ audiointerleave_suite (void)
   tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_audiointerleaved);
   tcase_add_test (tc_chain,
       test_audiointerleave_2ch_pipeline_non_audiointerleaved);
+  tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_planar_output);
   tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_input_chanpos);
   tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_custom_chanpos);
   tcase_add_test (tc_chain, test_audiointerleave_2ch_pipeline_no_chanpos);
@@ -1713,6 +1713,35 @@ GST_START_TEST (test_sinkpad_property_controller)
 
 GST_END_TEST;
 
+GST_START_TEST (test_convert_inputs)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  GstElement *pipeline;
+  GError *error = NULL;
+
+  pipeline = gst_parse_launch ("audiotestsrc num-buffers=20 ! "
+      "audio/x-raw,format=S16LE,channels=2,rate=44100 ! "
+      "audiomixer name=mix convert-inputs=true ! fakesink "
+      "audiotestsrc num-buffers=20 ! "
+      "audio/x-raw,format=F32LE,channels=1,rate=44100 ! mix.", &error);
+  fail_unless (pipeline != NULL, "%s", error ? error->message : "");
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
 static Suite *
 audiomixer_suite (void)
 {
@@ -1738,6 +1767,7 @@ audiomixer_suite (void)
   tcase_add_test (tc_chain, test_sync_unaligned);
   tcase_add_test (tc_chain, test_segment_base_handling);
   tcase_add_test (tc_chain, test_sinkpad_property_controller);
+  tcase_add_test (tc_chain, test_convert_inputs);
   tcase_add_checked_fixture (tc_chain, test_setup, test_teardown);
 
   /* Use a longer timeout */
@@ -1878,6 +1878,215 @@ GST_START_TEST (test_pad_z_order)
 
 GST_END_TEST;
 
+/* Runs the pipeline described by @desc and returns the last buffer of its
+ * "sink" */
+static GstBuffer *
+composite_last_buffer (const gchar * desc)
+{
+  GstElement *pipeline, *sink;
+  GstMessage *msg;
+  GstSample *sample;
+  GstBuffer *buffer;
+  GstBus *bus;
+
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_object_get (sink, "last-sample", &sample, NULL);
+  fail_unless (sample != NULL);
+  buffer = gst_buffer_ref (gst_sample_get_buffer (sample));
+  gst_sample_unref (sample);
+  gst_object_unref (sink);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return buffer;
+}
+
+static GstBuffer *
+composite_with_threads (const gchar * format, guint n_threads)
+{
+  GstBuffer *buffer;
+  gchar *desc;
+
+  /* overlapping inputs at odd positions that cross the stripe borders, one
+   * of them scaled */
+  desc = g_strdup_printf ("compositor name=comp n-threads=%u "
+      "sink_1::xpos=13 sink_1::ypos=21 sink_1::alpha=0.5 "
+      "sink_2::xpos=-7 sink_2::ypos=37 sink_2::width=75 sink_2::height=91 ! "
+      "video/x-raw,format=%s ! "
+      "fakesink name=sink enable-last-sample=true "
+      "videotestsrc num-buffers=1 ! video/x-raw,width=160,height=98 ! comp. "
+      "videotestsrc num-buffers=1 pattern=ball ! "
+      "video/x-raw,width=64,height=33 ! comp. "
+      "videotestsrc num-buffers=1 pattern=snow ! "
+      "video/x-raw,width=50,height=70 ! comp.", n_threads, format);
+  buffer = composite_last_buffer (desc);
+  g_free (desc);
+
+  return buffer;
+}
+
+GST_START_TEST (test_n_threads)
+{
+  static const gchar *formats[] = { "I420", "NV12", "AYUV", "BGRx", "YUY2" };
+  GstBuffer *single, *threaded;
+  GstMapInfo map;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    GST_INFO ("comparing %s output", formats[i]);
+
+    single = composite_with_threads (formats[i], 1);
+    threaded = composite_with_threads (formats[i], 3);
+
+    /* stripes must be composited exactly like the whole frame */
+    fail_unless_equals_int (gst_buffer_get_size (single),
+        gst_buffer_get_size (threaded));
+    fail_unless (gst_buffer_map (single, &map, GST_MAP_READ));
+    fail_unless (gst_buffer_memcmp (threaded, 0, map.data, map.size) == 0);
+    gst_buffer_unmap (single, &map);
+
+    gst_buffer_unref (single);
+    gst_buffer_unref (threaded);
+  }
+}
+
+GST_END_TEST;
+
+static void
+handoff_checksum_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GPtrArray * checksums)
+{
+  GstMapInfo map;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  g_ptr_array_add (checksums, g_compute_checksum_for_data (G_CHECKSUM_MD5,
+          map.data, map.size));
+  gst_buffer_unmap (buffer, &map);
+}
+
+static GPtrArray *
+composite_incremental (gboolean incremental)
+{
+  GstElement *pipeline, *sink;
+  GPtrArray *checksums;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *desc;
+
+  /* the moving ball is updated at twice the rate of the lower input, which
+   * is repeated every other output frame */
+  desc = g_strdup_printf ("compositor name=comp incremental=%d "
+      "sink_1::ypos=40 sink_1::xpos=8 ! video/x-raw,format=I420 ! "
+      "fakesink name=sink signal-handoffs=true "
+      "videotestsrc num-buffers=3 ! "
+      "video/x-raw,width=160,height=120,framerate=5/1 ! comp. "
+      "videotestsrc num-buffers=6 pattern=ball ! "
+      "video/x-raw,format=AYUV,width=64,height=33,framerate=10/1 ! comp.",
+      incremental);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  checksums = g_ptr_array_new_with_free_func (g_free);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_checksum_cb),
+      checksums);
+  gst_object_unref (sink);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return checksums;
+}
+
+GST_START_TEST (test_incremental)
+{
+  GPtrArray *full, *incremental;
+  guint i;
+
+  full = composite_incremental (FALSE);
+  incremental = composite_incremental (TRUE);
+
+  fail_unless (full->len > 0);
+  fail_unless_equals_int (full->len, incremental->len);
+  for (i = 0; i < full->len; i++)
+    fail_unless_equals_string (g_ptr_array_index (full, i),
+        g_ptr_array_index (incremental, i));
+
+  g_ptr_array_unref (full);
+  g_ptr_array_unref (incremental);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_transition_wipe)
+{
+  static const gchar *formats[] = { "I420", "NV12", "AYUV" };
+  GstVideoFrame frame;
+  GstVideoInfo info;
+  GstBuffer *buffer;
+  GstCaps *caps;
+  guint8 *y;
+  gint stride, pstride;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    gchar *desc;
+
+    /* halfway through, the left half still shows the first pad */
+    desc = g_strdup_printf ("compositor name=comp "
+        "sink_0::crossfade-ratio=0.5 sink_0::transition=wipe-left ! "
+        "video/x-raw,format=%s ! fakesink name=sink enable-last-sample=true "
+        "videotestsrc num-buffers=1 pattern=black ! "
+        "video/x-raw,width=64,height=32 ! comp. "
+        "videotestsrc num-buffers=1 pattern=white ! "
+        "video/x-raw,width=64,height=32 ! comp.", formats[i]);
+    buffer = composite_last_buffer (desc);
+    g_free (desc);
+
+    caps = gst_caps_from_string ("video/x-raw,width=64,height=32");
+    gst_caps_set_simple (caps, "format", G_TYPE_STRING, formats[i], NULL);
+    fail_unless (gst_video_info_from_caps (&info, caps));
+    gst_caps_unref (caps);
+
+    fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_READ));
+    y = GST_VIDEO_FRAME_COMP_DATA (&frame, GST_VIDEO_COMP_Y);
+    stride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, GST_VIDEO_COMP_Y);
+    pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, GST_VIDEO_COMP_Y);
+    fail_unless_equals_int (y[0], 16);
+    fail_unless_equals_int (y[31 * pstride], 16);
+    fail_unless_equals_int (y[32 * pstride], 235);
+    fail_unless_equals_int (y[31 * stride + 63 * pstride], 235);
+    gst_video_frame_unmap (&frame);
+
+    gst_buffer_unref (buffer);
+  }
+}
+
+GST_END_TEST;
+
 /* 
  * Test that the pad numbering assigned by aggregator behaves as follows:
  * 1. If a pad number is requested, it must be assigned if it is available
@@ -2102,6 +2311,9 @@ compositor_suite (void)
   tcase_add_test (tc_chain, test_ignore_eos);
   tcase_add_test (tc_chain, test_pad_z_order);
   tcase_add_test (tc_chain, test_pad_numbering);
+  tcase_add_test (tc_chain, test_n_threads);
+  tcase_add_test (tc_chain, test_incremental);
+  tcase_add_test (tc_chain, test_transition_wipe);
   tcase_add_test (tc_chain, test_start_time_zero_live_drop_0);
   tcase_add_test (tc_chain, test_start_time_zero_live_drop_3);
   tcase_add_test (tc_chain, test_start_time_zero_live_drop_3_unlinked_1);
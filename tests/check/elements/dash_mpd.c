@@ -4673,6 +4673,105 @@ GST_START_TEST (dash_mpdparser_segment_template)
 
 GST_END_TEST;
 
+/*
+ * Test merging a live manifest update that only extends the SegmentTimeline
+ *
+ */
+GST_START_TEST (dash_mpdparser_merge_update_segment_timeline)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaSegment *segment;
+  GstSNode *S;
+  GstMultSegmentBaseType *multSegBaseType;
+  GstClockTime ts;
+  GstFlowReturn flow;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"p0\" start=\"PT0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"v\" bandwidth=\"250000\">"
+      "        <SegmentTemplate timescale=\"10\" media=\"$Number$.m4s\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"10\" r=\"2\"></S>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+  const gchar *xml_update =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"p0\" start=\"PT0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"v\" bandwidth=\"250000\">"
+      "        <SegmentTemplate timescale=\"10\" media=\"$Number$.m4s\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"10\" d=\"10\" r=\"3\"></S>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+  GstMpdClient *update = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+
+  flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+  assert_equals_int (flow, GST_FLOW_OK);
+
+  ret = gst_mpd_parse (update, xml_update, (gint) strlen (xml_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_merge_update (mpdclient, update);
+  assert_equals_int (ret, TRUE);
+  gst_mpd_client_free (update);
+
+  /* the expired entry was dropped and the last one extended */
+  multSegBaseType = activeStream->cur_seg_template->MultSegBaseType;
+  assert_equals_int (g_queue_get_length (&multSegBaseType->
+          SegmentTimeline->S), 1);
+  S = g_queue_peek_head (&multSegBaseType->SegmentTimeline->S);
+  assert_equals_uint64 (S->t, 10);
+  assert_equals_uint64 (S->d, 10);
+  assert_equals_int (S->r, 3);
+
+  /* the stream kept its position */
+  assert_equals_int (activeStream->segments->len, 1);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->repeat, 4);
+  ret = gst_mpd_client_get_next_fragment_timestamp (mpdclient, 0, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 1 * GST_SECOND);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test segment timeline
  *
@@ -5936,6 +6035,8 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_list);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_template);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline);
+  tcase_add_test (tc_complexMPD,
+      dash_mpdparser_merge_update_segment_timeline);
   tcase_add_test (tc_complexMPD, dash_mpdparser_multiple_inherited_segmentURL);
 
   /* tests checking the parsing of missing/incomplete attributes of xml */
@@ -84,6 +84,37 @@ https://priv.example.com/fileSequence3003.ts\n\
 #EXTINF:8,\n\
 https://priv.example.com/fileSequence3004.ts";
 
+static const gchar *LIVE_SLIDED_PLAYLIST = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:8\n\
+#EXT-X-MEDIA-SEQUENCE:2682\n\
+\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2682.ts\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2683.ts\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2684.ts\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2685.ts";
+
+static const gchar *LOW_LATENCY_PLAYLIST = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:4\n\
+#EXT-X-VERSION:6\n\
+#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n\
+#EXT-X-PART-INF:PART-TARGET=1.0\n\
+#EXT-X-MEDIA-SEQUENCE:100\n\
+#EXTINF:4.0,\n\
+seg100.ts\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg101.0.ts\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg101.1.ts\"\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg101.2.ts\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg101.3.ts\"\n\
+#EXTINF:4.0,\n\
+seg101.ts\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg102.0.ts\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg102.1.ts\"\n\
+#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg102.2.ts\"";
+
 static const gchar *VARIANT_PLAYLIST = "#EXTM3U \n\
 #EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=128000\n\
 http://example.com/low.m3u8\n\
@@ -574,6 +605,87 @@ GST_START_TEST (test_live_playlist_rotated)
 
 GST_END_TEST;
 
+GST_START_TEST (test_live_playlist_reuse_media_files)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file, *known;
+  gboolean ret;
+
+  master = load_playlist (LIVE_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  known = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  assert_equals_int (known->sequence, 2682);
+  gst_m3u8_media_file_ref (known);
+
+  ret = gst_m3u8_update (pl, g_strdup (LIVE_SLIDED_PLAYLIST));
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (g_list_length (pl->files), 4);
+
+  /* segments that were already known are kept, new ones are added */
+  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  fail_unless (file == known);
+  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  assert_equals_int (file->sequence, 2685);
+  assert_equals_string (file->uri,
+      "https://priv.example.com/fileSequence2685.ts");
+
+  gst_m3u8_media_file_unref (known);
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_low_latency_playlist)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file;
+  const gchar *expected[] = { "seg101.2.ts", "seg101.3.ts", "seg102.0.ts",
+    "seg102.1.ts", "seg102.2.ts"
+  };
+  gchar *uri;
+  gint i;
+
+  master = load_playlist (LOW_LATENCY_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  assert_equals_int (g_list_length (pl->files), 2);
+  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  assert_equals_int (g_list_length (file->parts), 4);
+  assert_equals_int (g_list_length (pl->pending_parts), 2);
+  fail_unless (pl->preload_hint != NULL);
+  assert_equals_int (pl->preload_hint->part_index, 2);
+  assert_equals_uint64 (pl->part_target, GST_SECOND);
+
+  uri = gst_m3u8_get_reload_uri (pl);
+  assert_equals_string (uri,
+      "http://localhost/test.m3u8?_HLS_msn=102&_HLS_part=2");
+  g_free (uri);
+
+  /* start at the independent part at least PART-HOLD-BACK from the end */
+  gst_m3u8_set_low_latency (pl, TRUE);
+  assert_equals_int64 (pl->sequence, 101);
+  assert_equals_int (pl->part_index, 2);
+
+  for (i = 0; i < G_N_ELEMENTS (expected); i++) {
+    gchar *expected_uri = g_strdup_printf ("http://localhost/%s", expected[i]);
+
+    file = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+    fail_unless (file != NULL);
+    assert_equals_string (file->uri, expected_uri);
+    gst_m3u8_media_file_unref (file);
+    g_free (expected_uri);
+    gst_m3u8_advance_fragment (pl, TRUE);
+  }
+  fail_unless (gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL) == NULL);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_playlist_with_doubles_duration)
 {
   GstHLSMasterPlaylist *master;
@@ -1417,6 +1529,8 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_empty_lines_playlist);
   tcase_add_test (tc_m3u8, test_live_playlist);
   tcase_add_test (tc_m3u8, test_live_playlist_rotated);
+  tcase_add_test (tc_m3u8, test_live_playlist_reuse_media_files);
+  tcase_add_test (tc_m3u8, test_low_latency_playlist);
   tcase_add_test (tc_m3u8, test_playlist_with_doubles_duration);
   tcase_add_test (tc_m3u8, test_playlist_with_encryption);
   tcase_add_test (tc_m3u8, test_update_invalid_playlist);
@@ -49,6 +49,46 @@ GST_START_TEST (netsim_stress_delayed)
 
 GST_END_TEST;
 
+static guint
+push_and_count (const gchar * launchline, guint n_buffers)
+{
+  GstHarness *h = gst_harness_new_parse (launchline);
+  guint i, pulled;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+  for (i = 0; i < n_buffers; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            gst_harness_create_buffer (h, 100)), GST_FLOW_OK);
+
+  pulled = gst_harness_buffers_received (h);
+  gst_harness_teardown (h);
+
+  return pulled;
+}
+
+GST_START_TEST (netsim_seed_is_deterministic)
+{
+  guint first, second;
+
+  first = push_and_count ("netsim drop-probability=0.5 seed=1234", 200);
+  second = push_and_count ("netsim drop-probability=0.5 seed=1234", 200);
+
+  fail_unless (first > 0 && first < 200);
+  fail_unless_equals_int (first, second);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_max_queue_size)
+{
+  /* the bucket holds one buffer and nothing may wait for the rate limit, so
+   * only the first buffer gets through */
+  fail_unless_equals_int (push_and_count
+      ("netsim max-kbps=1 max-queue-size=0", 10), 1);
+}
+
+GST_END_TEST;
+
 static Suite *
 netsim_suite (void)
 {
@@ -58,6 +98,8 @@ netsim_suite (void)
   suite_add_tcase (s, (tc_chain = tcase_create ("general")));
   tcase_add_test (tc_chain, netsim_stress);
   tcase_add_test (tc_chain, netsim_stress_delayed);
+  tcase_add_test (tc_chain, netsim_seed_is_deterministic);
+  tcase_add_test (tc_chain, netsim_max_queue_size);
 
   return s;
 }
@@ -115,6 +115,116 @@ GST_START_TEST (test_parse_zerosize_frames)
 
 GST_END_TEST;
 
+/* section header, interface description and one enhanced packet block with
+ * the packet of pcap_frame_with_eth_padding, little endian */
+static GstBuffer *
+create_pcapng_buffer (void)
+{
+  const guint8 *packet = pcap_frame_with_eth_padding + 16;
+  const guint packet_len = sizeof (pcap_frame_with_eth_padding) - 16;
+  const guint epb_len = 32 + GST_ROUND_UP_4 (packet_len);
+  guint8 *data, *p;
+  gsize size;
+
+  size = 28 + 20 + epb_len;
+  p = data = g_malloc0 (size);
+
+  GST_WRITE_UINT32_LE (p, 0x0a0d0d0a);
+  GST_WRITE_UINT32_LE (p + 4, 28);
+  GST_WRITE_UINT32_LE (p + 8, 0x1a2b3c4d);
+  GST_WRITE_UINT16_LE (p + 12, 1);
+  GST_WRITE_UINT64_LE (p + 16, G_MAXUINT64);
+  GST_WRITE_UINT32_LE (p + 24, 28);
+  p += 28;
+
+  GST_WRITE_UINT32_LE (p, 1);
+  GST_WRITE_UINT32_LE (p + 4, 20);
+  GST_WRITE_UINT16_LE (p + 8, 1);
+  GST_WRITE_UINT32_LE (p + 12, 65535);
+  GST_WRITE_UINT32_LE (p + 16, 20);
+  p += 20;
+
+  /* 1.5 s, in the default microseconds */
+  GST_WRITE_UINT32_LE (p, 6);
+  GST_WRITE_UINT32_LE (p + 4, epb_len);
+  GST_WRITE_UINT32_LE (p + 16, 1500000);
+  GST_WRITE_UINT32_LE (p + 20, packet_len);
+  GST_WRITE_UINT32_LE (p + 24, packet_len);
+  memcpy (p + 28, packet, packet_len);
+  GST_WRITE_UINT32_LE (p + epb_len - 4, epb_len);
+
+  return gst_buffer_new_wrapped (data, size);
+}
+
+GST_START_TEST (test_parse_pcapng)
+{
+  GstBuffer *out_buf;
+  GstHarness *h;
+  guint payload_size;
+
+  h = gst_harness_new ("pcapparse");
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+
+  gst_harness_push (h, create_pcapng_buffer ());
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  out_buf = gst_harness_pull (h);
+
+  payload_size = sizeof (pcap_frame_with_eth_padding) -
+      pcap_frame_with_eth_padding_offset - 2;
+  fail_unless_equals_int (gst_buffer_get_size (out_buf), payload_size);
+  fail_unless (gst_buffer_memcmp (out_buf, 0,
+          pcap_frame_with_eth_padding + pcap_frame_with_eth_padding_offset,
+          payload_size) == 0);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (out_buf), 1500 * GST_MSECOND);
+
+  gst_buffer_unref (out_buf);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_rate)
+{
+  GstBuffer *in_buf, *out_buf;
+  GstHarness *h;
+  guint8 *data;
+  gsize size;
+  guint i;
+
+  h = gst_harness_new ("pcapparse");
+  g_object_set (h->element, "ts-offset", (gint64) 0, "rate", 2.0, NULL);
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+
+  /* the same packet twice, one second apart */
+  size = sizeof (pcap_header) + 2 * sizeof (pcap_frame_with_eth_padding);
+  data = g_malloc (size);
+  memcpy (data, pcap_header, sizeof (pcap_header));
+  for (i = 0; i < 2; i++) {
+    guint8 *frame = data + sizeof (pcap_header) +
+        i * sizeof (pcap_frame_with_eth_padding);
+
+    memcpy (frame, pcap_frame_with_eth_padding,
+        sizeof (pcap_frame_with_eth_padding));
+    GST_WRITE_UINT32_LE (frame, GST_READ_UINT32_LE (frame) + i);
+  }
+  in_buf = gst_buffer_new_wrapped (data, size);
+
+  gst_harness_push (h, in_buf);
+
+  out_buf = gst_harness_pull (h);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (out_buf), 0);
+  gst_buffer_unref (out_buf);
+
+  out_buf = gst_harness_pull (h);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (out_buf), 500 * GST_MSECOND);
+  gst_buffer_unref (out_buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 pcapparse_suite (void)
 {
@@ -133,6 +243,8 @@ pcapparse_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_parse_frames_with_eth_padding);
   tcase_add_test (tc_chain, test_parse_zerosize_frames);
+  tcase_add_test (tc_chain, test_parse_pcapng);
+  tcase_add_test (tc_chain, test_parse_rate);
 
   return s;
 }
@@ -26,6 +26,10 @@
 
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
+#include <gst/allocators/allocators.h>
+
+#include <glib/gstdio.h>
+#include <unistd.h>
 
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -169,6 +173,157 @@ GST_START_TEST (test_shm_alloc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_shm_pool)
+{
+  GstBuffer *buf;
+  GstQuery *query;
+  GstCaps *caps = gst_caps_from_string ("video/x-raw, format=GRAY8, "
+      "width=16, height=16, framerate=30/1");
+  GstBufferPool *pool;
+  GstStructure *stats;
+  guint size, min, max;
+  guint64 zero_copy = 0, copied = 0;
+  GstSegment segment;
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (srcpad, gst_event_new_caps (caps));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  query = gst_query_new_allocation (caps, TRUE);
+  gst_caps_unref (caps);
+
+  fail_unless (gst_pad_peer_query (srcpad, query));
+  fail_unless (gst_query_get_n_allocation_pools (query) == 1);
+  gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+  gst_query_unref (query);
+  fail_unless (pool != NULL);
+  fail_unless_equals_int (size, 16 * 16);
+  fail_unless (max > 0 && min <= max);
+
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+  g_mutex_lock (&check_mutex);
+  while (buffers == NULL)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+  fail_unless (g_list_length (buffers) == 1);
+  fail_unless (gst_buffer_get_size (buffers->data) == size);
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "zero-copy-buffers",
+          &zero_copy));
+  fail_unless (gst_structure_get_uint64 (stats, "copied-buffers", &copied));
+  fail_unless_equals_uint64 (zero_copy, 1);
+  fail_unless_equals_uint64 (copied, 0);
+  gst_structure_free (stats);
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_shm_fd_passing)
+{
+  GstAllocator *alloc;
+  GstBuffer *buf;
+  GstMemory *mem;
+  GstSegment segment;
+  GstMapInfo map;
+  gchar *filename = NULL;
+  gint fd;
+
+  g_object_set (sink, "fd-passing", TRUE, NULL);
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  fd = g_file_open_tmp ("shm-unit-test-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  g_unlink (filename);
+  g_free (filename);
+  fail_unless (ftruncate (fd, 4096) == 0);
+
+  alloc = gst_fd_allocator_new ();
+  mem = gst_fd_allocator_alloc (alloc, fd, 4096, GST_FD_MEMORY_FLAG_NONE);
+  gst_object_unref (alloc);
+  fail_unless (gst_memory_map (mem, &map, GST_MAP_WRITE));
+  memset (map.data, 0x42, map.size);
+  gst_memory_unmap (mem, &map);
+  gst_memory_resize (mem, 96, 1000);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+  g_mutex_lock (&check_mutex);
+  while (buffers == NULL)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+  fail_unless (g_list_length (buffers) == 1);
+
+  /* the memory arrives as a file descriptor, not through the shm area */
+  buf = buffers->data;
+  fail_unless (gst_buffer_get_size (buf) == 1000);
+  mem = gst_buffer_peek_memory (buf, 0);
+  fail_unless (gst_is_dmabuf_memory (mem));
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless (map.data[0] == 0x42 && map.data[999] == 0x42);
+  gst_buffer_unmap (buf, &map);
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_shm_client_lag)
+{
+  GstBuffer *buf;
+  GstSegment segment;
+  GstStructure *stats, *client;
+  const GValue *clients;
+  guint pending = 0;
+
+  g_object_set (src, "ack-batch", 4, NULL);
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  buf = gst_buffer_new_allocate (NULL, 1000, NULL);
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+  g_mutex_lock (&check_mutex);
+  while (buffers == NULL)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  /* the received buffer is still held, so the client did not release it */
+  g_object_get (sink, "stats", &stats, NULL);
+  clients = gst_structure_get_value (stats, "clients");
+  fail_unless (clients != NULL);
+  fail_unless_equals_int (gst_value_array_get_size (clients), 1);
+  client = (GstStructure *)
+      gst_value_get_structure (gst_value_array_get_value (clients, 0));
+  fail_unless (gst_structure_get_uint (client, "pending-buffers", &pending));
+  fail_unless_equals_int (pending, 1);
+  gst_structure_free (stats);
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
 static Suite *
 shm_suite (void)
 {
@@ -179,6 +334,9 @@ shm_suite (void)
   tcase_add_checked_fixture (tc, setup_shm, NULL);
   tcase_add_test (tc, test_shm_sysmem_alloc);
   tcase_add_test (tc, test_shm_alloc);
+  tcase_add_test (tc, test_shm_pool);
+  tcase_add_test (tc, test_shm_fd_passing);
+  tcase_add_test (tc, test_shm_client_lag);
   suite_add_tcase (s, tc);
 
   return s;
@@ -716,7 +716,10 @@ _test_timeout (gint buffer_wait)
   GstBus *bus;
   GstMessage *msg;
   GstElement *pipeline, *src, *src1, *agg, *sink;
-  GstPad *src1pad;
+  GstPad *src1pad, *aggpad;
+  GstStructure *s;
+  GstClockTime latency;
+  guint64 missed, n_aggregates;
   gint count = 0;
 
   pipeline = gst_pipeline_new ("pipeline");
@@ -762,6 +765,23 @@ _test_timeout (gint buffer_wait)
    * testaggregator */
   fail_if (count < TIMEOUT_NUM_BUFFERS);
 
+  /* the pad that never gets buffers has no own budget and keeps missing the
+   * deadline of the aggregator */
+  aggpad = gst_pad_get_peer (src1pad);
+  fail_if (aggpad == NULL);
+  g_object_get (aggpad, "latency", &latency, "stats", &s, NULL);
+  fail_unless (latency == GST_CLOCK_TIME_NONE);
+  fail_unless (gst_structure_get_uint64 (s, "missed-deadlines", &missed));
+  fail_unless (missed > 0);
+  gst_structure_free (s);
+  gst_object_unref (aggpad);
+
+  g_object_get (agg, "stats", &s, NULL);
+  fail_unless (gst_structure_get_uint64 (s, "aggregate-count",
+          &n_aggregates));
+  fail_unless (n_aggregates >= TIMEOUT_NUM_BUFFERS);
+  gst_structure_free (s);
+
   gst_element_set_state (pipeline, GST_STATE_NULL);
   gst_object_unref (src1pad);
   gst_object_unref (bus);
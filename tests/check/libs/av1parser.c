@@ -0,0 +1,169 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gstav1parser.h>
+
+/* A temporal unit with a temporal delimiter, a 640x360 main profile
+ * sequence header, the header of a key frame and a tile group */
+static const guint8 av1_temporal_unit[] = {
+  0x12, 0x00,
+  0x0a, 0x0b, 0x00, 0x00, 0x00, 0x42, 0x62, 0x7f, 0xb3, 0x9f, 0xff, 0x30,
+  0x08,
+  0x1a, 0x03, 0x10, 0x00, 0x90,
+  0x22, 0x03, 0xaa, 0xbb, 0xcc
+};
+
+GST_START_TEST (test_av1_parse_temporal_unit)
+{
+  GstAV1Parser *parser;
+  GstAV1OBU obu;
+  GstAV1SequenceHeaderOBU seq_header;
+  GstAV1FrameHeaderOBU frame_header;
+  GstAV1TileGroupOBU tile_group;
+  const guint8 *data = av1_temporal_unit;
+  guint32 size = sizeof (av1_temporal_unit), consumed;
+
+  parser = gst_av1_parser_new ();
+
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, data, size,
+          &obu, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (obu.obu_type, GST_AV1_OBU_TEMPORAL_DELIMITER);
+  assert_equals_int (consumed, 2);
+  assert_equals_int (gst_av1_parser_parse_temporal_delimiter_obu (parser,
+          &obu), GST_AV1_PARSER_OK);
+  data += consumed;
+  size -= consumed;
+
+  /* nothing to refer to yet */
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, data + 13,
+          size - 13, &obu, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (obu.obu_type, GST_AV1_OBU_FRAME_HEADER);
+  assert_equals_int (gst_av1_parser_parse_frame_header_obu (parser, &obu,
+          &frame_header), GST_AV1_PARSER_MISSING_OBU_REFERENCE);
+
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, data, size,
+          &obu, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (obu.obu_type, GST_AV1_OBU_SEQUENCE_HEADER);
+  assert_equals_int (obu.obu_size, 11);
+  assert_equals_int (consumed, 13);
+  assert_equals_int (gst_av1_parser_parse_sequence_header_obu (parser, &obu,
+          &seq_header), GST_AV1_PARSER_OK);
+  assert_equals_int (seq_header.seq_profile, GST_AV1_PROFILE_0);
+  assert_equals_int (seq_header.operating_points[0].seq_level_idx, 8);
+  assert_equals_int (seq_header.max_frame_width_minus_1, 639);
+  assert_equals_int (seq_header.max_frame_height_minus_1, 359);
+  assert_equals_int (seq_header.enable_order_hint, 1);
+  assert_equals_int (seq_header.order_hint_bits, 7);
+  assert_equals_int (seq_header.seq_force_screen_content_tools,
+      GST_AV1_SELECT_SCREEN_CONTENT_TOOLS);
+  assert_equals_int (seq_header.color_config.bit_depth, 8);
+  assert_equals_int (seq_header.color_config.subsampling_x, 1);
+  assert_equals_int (seq_header.color_config.subsampling_y, 1);
+  assert_equals_int (parser->have_seq_header, TRUE);
+  data += consumed;
+  size -= consumed;
+
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, data, size,
+          &obu, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (gst_av1_parser_parse_frame_header_obu (parser, &obu,
+          &frame_header), GST_AV1_PARSER_OK);
+  assert_equals_int (frame_header.show_existing_frame, 0);
+  assert_equals_int (frame_header.frame_type, GST_AV1_KEY_FRAME);
+  assert_equals_int (frame_header.show_frame, 1);
+  assert_equals_int (frame_header.error_resilient_mode, 1);
+  assert_equals_int (frame_header.refresh_frame_flags, 0xff);
+  assert_equals_int (frame_header.frame_width, 640);
+  assert_equals_int (frame_header.upscaled_width, 640);
+  assert_equals_int (frame_header.frame_height, 360);
+  assert_equals_int (frame_header.render_width, 640);
+  assert_equals_int (frame_header.render_height, 360);
+  assert_equals_int (frame_header.tile_info.tile_cols, 1);
+  assert_equals_int (frame_header.tile_info.tile_rows, 1);
+  data += consumed;
+  size -= consumed;
+
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, data, size,
+          &obu, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (obu.obu_type, GST_AV1_OBU_TILE_GROUP);
+  assert_equals_int (consumed, size);
+  assert_equals_int (gst_av1_parser_parse_tile_group_obu (parser, &obu,
+          &tile_group), GST_AV1_PARSER_OK);
+  assert_equals_int (tile_group.num_tiles, 1);
+  assert_equals_int (tile_group.tg_start, 0);
+  assert_equals_int (tile_group.tg_end, 0);
+
+  /* the frame is complete */
+  assert_equals_int (gst_av1_parser_parse_tile_group_obu (parser, &obu,
+          &tile_group), GST_AV1_PARSER_MISSING_OBU_REFERENCE);
+
+  /* truncated OBU */
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, data, size - 1,
+          &obu, &consumed), GST_AV1_PARSER_NO_MORE_DATA);
+
+  gst_av1_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_av1_leb128)
+{
+  static const guint64 values[] = { 0, 1, 127, 128, 16383, 16384,
+    G_MAXUINT32
+  };
+  guint8 data[8];
+  guint64 value;
+  guint32 n, consumed;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (values); i++) {
+    n = gst_av1_parser_write_leb128 (values[i], data);
+    assert_equals_int (n, gst_av1_parser_leb128_size (values[i]));
+    assert_equals_int (gst_av1_parser_read_leb128 (data, n, &value,
+            &consumed), GST_AV1_PARSER_OK);
+    assert_equals_uint64 (value, values[i]);
+    assert_equals_int (consumed, n);
+    if (n > 1)
+      assert_equals_int (gst_av1_parser_read_leb128 (data, n - 1, &value,
+              &consumed), GST_AV1_PARSER_NO_MORE_DATA);
+  }
+
+  /* does not fit in 32 bits */
+  memset (data, 0xff, 4);
+  data[4] = 0x7f;
+  assert_equals_int (gst_av1_parser_read_leb128 (data, 5, &value, &consumed),
+      GST_AV1_PARSER_BROKEN_DATA);
+}
+
+GST_END_TEST;
+
+static Suite *
+av1parsers_suite (void)
+{
+  Suite *s = suite_create ("AV1 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_av1_parse_temporal_unit);
+  tcase_add_test (tc_chain, test_av1_leb128);
+
+  return s;
+}
+
+GST_CHECK_MAIN (av1parsers);
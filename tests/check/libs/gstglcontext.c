@@ -30,6 +30,7 @@
 #include <stdio.h>
 
 static GstGLDisplay *display;
+static volatile gint n_async_notified;
 
 static void
 setup (void)
@@ -481,6 +482,59 @@ GST_START_TEST (test_current_context)
 
 GST_END_TEST;
 
+static void
+_append_index (GstGLContext * context, gpointer data)
+{
+  GArray *order = g_object_get_data (G_OBJECT (context), "test-order");
+
+  g_array_append_val (order, data);
+}
+
+static void
+_count_notify (gpointer data)
+{
+  g_atomic_int_inc (&n_async_notified);
+}
+
+GST_START_TEST (test_thread_add_async)
+{
+  GstGLContext *context;
+  GError *error = NULL;
+  GArray *order;
+  guint i, count;
+
+  context = gst_gl_context_new (display);
+  gst_gl_context_create (context, 0, &error);
+  fail_if (error != NULL, "Error creating context %s
+",
+      error ? error->message : "Unknown Error");
+
+  order = g_array_new (FALSE, FALSE, sizeof (gpointer));
+  g_object_set_data (G_OBJECT (context), "test-order", order);
+  n_async_notified = 0;
+  count = gst_gl_context_get_thread_message_count (context);
+
+  for (i = 0; i < 10; i++)
+    gst_gl_context_thread_add_async (context, _append_index,
+        GUINT_TO_POINTER (i), _count_notify);
+  /* runs after all the queued ones */
+  gst_gl_context_thread_add (context, _append_index, GUINT_TO_POINTER (10));
+
+  fail_unless_equals_int (g_atomic_int_get (&n_async_notified), 10);
+  fail_unless_equals_int (order->len, 11);
+  for (i = 0; i < order->len; i++)
+    fail_unless_equals_int (GPOINTER_TO_UINT (g_array_index (order, gpointer,
+                i)), i);
+  fail_unless (gst_gl_context_get_thread_message_count (context) >=
+      count + 11);
+
+  g_object_set_data (G_OBJECT (context), "test-order", NULL);
+  g_array_free (order, TRUE);
+  gst_object_unref (context);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_context_can_share)
 {
   GstGLContext *c1, *c2, *c3;
@@ -652,6 +706,7 @@ gst_gl_context_suite (void)
   tcase_add_test (tc_chain, test_share);
   tcase_add_test (tc_chain, test_wrapped_context);
   tcase_add_test (tc_chain, test_current_context);
+  tcase_add_test (tc_chain, test_thread_add_async);
   tcase_add_test (tc_chain, test_context_can_share);
   tcase_add_test (tc_chain, test_is_shared);
   tcase_add_test (tc_chain, test_display_list);
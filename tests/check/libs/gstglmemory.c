@@ -274,6 +274,55 @@ test_transfer_allocator (const gchar * allocator_name)
 }
 
 
+static GstMemory *
+_alloc_rgba (GstGLBaseMemoryAllocator * base_mem_alloc, gint width,
+    gint height)
+{
+  GstGLVideoAllocationParams *params;
+  GstVideoInfo v_info;
+  GstMemory *mem;
+
+  gst_video_info_set_format (&v_info, GST_VIDEO_FORMAT_RGBA, width, height);
+  params = gst_gl_video_allocation_params_new (context, NULL, &v_info, 0,
+      NULL, GST_GL_TEXTURE_TARGET_2D, GST_GL_RGBA);
+  mem = (GstMemory *) gst_gl_base_memory_alloc (base_mem_alloc,
+      (GstGLAllocationParams *) params);
+  gst_gl_allocation_params_free ((GstGLAllocationParams *) params);
+  fail_if (mem == NULL);
+
+  return mem;
+}
+
+GST_START_TEST (test_texture_reuse)
+{
+  GstGLBaseMemoryAllocator *base_mem_alloc;
+  GstAllocator *gl_allocator;
+  GstMemory *mem;
+  guint tex_id;
+
+  gl_allocator = gst_allocator_find (GST_GL_MEMORY_ALLOCATOR_NAME);
+  fail_if (gl_allocator == NULL);
+  base_mem_alloc = GST_GL_BASE_MEMORY_ALLOCATOR (gl_allocator);
+
+  mem = _alloc_rgba (base_mem_alloc, 320, 240);
+  tex_id = ((GstGLMemory *) mem)->tex_id;
+  fail_if (tex_id == 0);
+  gst_memory_unref (mem);
+
+  /* a different size cannot reuse the texture */
+  mem = _alloc_rgba (base_mem_alloc, 640, 480);
+  fail_if (((GstGLMemory *) mem)->tex_id == tex_id);
+  gst_memory_unref (mem);
+
+  mem = _alloc_rgba (base_mem_alloc, 320, 240);
+  fail_unless_equals_int (((GstGLMemory *) mem)->tex_id, tex_id);
+  gst_memory_unref (mem);
+
+  gst_object_unref (gl_allocator);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_transfer)
 {
   test_transfer_allocator (GST_GL_MEMORY_ALLOCATOR_NAME);
@@ -340,6 +389,7 @@ gst_gl_memory_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_checked_fixture (tc_chain, setup, teardown);
   tcase_add_test (tc_chain, test_basic);
+  tcase_add_test (tc_chain, test_texture_reuse);
   tcase_add_test (tc_chain, test_transfer);
   tcase_add_test (tc_chain, test_separate_transfer);
 
@@ -24,6 +24,7 @@
 #include <gst/check/gstcheck.h>
 
 #include <gst/gl/gl.h>
+#include <gst/gl/gstglfuncs.h>
 
 #include <stdio.h>
 
@@ -317,6 +318,47 @@ GST_START_TEST (test_query_end_end)
 
 GST_END_TEST;
 
+static void
+_test_timer_gl (GstGLContext * context, gpointer data)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  GstGLTimer *timer;
+  GstStructure *stats;
+  guint64 count, skipped, total, max;
+  gint i;
+
+  timer = gst_gl_timer_new (context);
+
+  for (i = 0; i < 4; i++) {
+    gst_gl_timer_start (timer);
+    gl->Clear (GL_COLOR_BUFFER_BIT);
+    gst_gl_timer_end (timer);
+    gl->Finish ();
+  }
+
+  stats = gst_gl_timer_get_stats (timer);
+  fail_unless (gst_structure_get_uint64 (stats, "count", &count));
+  fail_unless (gst_structure_get_uint64 (stats, "skipped", &skipped));
+  fail_unless (gst_structure_get_uint64 (stats, "total-time", &total));
+  fail_unless (gst_structure_get_uint64 (stats, "max-time", &max));
+  fail_unless (count + skipped <= 4);
+  fail_unless (max <= total);
+  /* the results of all but the last section were available */
+  if (gl->QueryCounter)
+    fail_unless (count >= 3);
+  gst_structure_free (stats);
+
+  gst_gl_timer_free (timer);
+}
+
+GST_START_TEST (test_timer)
+{
+  gst_gl_context_thread_add (context,
+      (GstGLContextThreadFunc) _test_timer_gl, NULL);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_gl_upload_suite (void)
 {
@@ -340,6 +382,7 @@ gst_gl_upload_suite (void)
   tcase_add_test (tc_chain, test_query_start_start);
   tcase_add_test (tc_chain, test_query_end);
   tcase_add_test (tc_chain, test_query_end_end);
+  tcase_add_test (tc_chain, test_timer);
 
   return s;
 }
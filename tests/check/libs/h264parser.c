@@ -19,6 +19,7 @@
  * Boston, MA 02110-1301, USA.
  */
 #include <gst/check/gstcheck.h>
+#include <gst/base/gstbytereader.h>
 #include <gst/codecparsers/gsth264parser.h>
 
 static guint8 slice_dpa[] = {
@@ -211,6 +212,56 @@ GST_START_TEST (test_h264_parse_slice_eoseq_slice)
 
 GST_END_TEST;
 
+GST_START_TEST (test_h264_scan_start_codes)
+{
+  GstH264NalParser *parser;
+  GstH264NalUnit nalu;
+  GstH264ParserResult res;
+  GstByteReader br;
+  GRand *rand;
+  guint8 data[4096];
+  gint expected;
+  guint i, start;
+
+  rand = g_rand_new_with_seed (42);
+
+  /* the first half is mostly zeros and ones, so that all kinds of almost
+   * start codes appear, the second half has long runs without zero bytes */
+  for (i = 0; i < sizeof (data) / 2; i++)
+    data[i] = g_rand_int_range (rand, 0, 3) ? g_rand_int_range (rand, 0, 2)
+        : g_rand_int_range (rand, 2, 256);
+  for (; i < sizeof (data); i++)
+    data[i] = g_rand_int_range (rand, 1, 256);
+  for (i = sizeof (data) / 2; i + 3 < sizeof (data); i += 331) {
+    data[i] = 0x00;
+    data[i + 1] = 0x00;
+    data[i + 2] = 0x01;
+  }
+
+  g_rand_free (rand);
+
+  parser = gst_h264_nal_parser_new ();
+
+  for (start = 0; start + 4 <= sizeof (data); start++) {
+    gst_byte_reader_init (&br, data + start, sizeof (data) - start);
+    expected = gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00,
+        0x00000100, 0, sizeof (data) - start);
+
+    res = gst_h264_parser_identify_nalu_unchecked (parser, data, start,
+        sizeof (data), &nalu);
+    if (expected < 0) {
+      assert_equals_int (res, GST_H264_PARSER_NO_NAL);
+    } else {
+      fail_if (res == GST_H264_PARSER_NO_NAL);
+      assert_equals_int (nalu.offset, start + expected + 3);
+    }
+  }
+
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
 static Suite *
 h264parser_suite (void)
 {
@@ -221,6 +272,7 @@ h264parser_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_h264_parse_slice_dpa);
   tcase_add_test (tc_chain, test_h264_parse_slice_eoseq_slice);
+  tcase_add_test (tc_chain, test_h264_scan_start_codes);
 
   return s;
 }
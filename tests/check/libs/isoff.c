@@ -306,6 +306,55 @@ GST_START_TEST (isoff_moof_parse_with_tfxd_tfrf)
 
 GST_END_TEST;
 
+GST_START_TEST (isoff_moof_parse_buffer_multiple_memories)
+{
+  GstBuffer *buffer;
+  guint32 type;
+  guint header_size;
+  guint64 size;
+  GstMoofBox *moof;
+  GstTrafBox *traf;
+
+  /* split the box header and the tfxd box over several memories */
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+          (gpointer) Fragments_audio, Fragments_audio_len, 0, 5, NULL, NULL));
+  gst_buffer_append_memory (buffer,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+          (gpointer) Fragments_audio, Fragments_audio_len, 5, 95, NULL, NULL));
+  gst_buffer_append_memory (buffer,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+          (gpointer) Fragments_audio, Fragments_audio_len, 100,
+          Fragments_audio_len - 100, NULL, NULL));
+
+  fail_unless (gst_isoff_parse_box_header_buffer (buffer, 0, &type, NULL,
+          &header_size, &size));
+  fail_unless (type == GST_ISOFF_FOURCC_MOOF);
+  fail_unless_equals_int (header_size, 8);
+  fail_unless_equals_uint64 (size, Fragments_audio_len);
+
+  moof = gst_isoff_moof_box_parse_buffer (buffer, header_size,
+      size - header_size);
+  fail_unless (moof != NULL);
+  fail_unless_equals_int (moof->mfhd.sequence_number, 124);
+  fail_unless_equals_int (moof->traf->len, 1);
+
+  traf = &g_array_index (moof->traf, GstTrafBox, 0);
+  fail_unless (traf->tfxd != NULL);
+  fail_unless_equals_uint64 (traf->tfxd->time, 1188108174758706);
+  fail_unless (traf->tfrf != NULL);
+  fail_unless_equals_int (traf->tfrf->entries_count, 2);
+
+  /* the buffer was not merged */
+  fail_unless_equals_int (gst_buffer_n_memory (buffer), 3);
+
+  gst_isoff_moof_box_free (moof);
+  gst_buffer_unref (buffer);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (isoff_moov_parse)
 {
   /* INDENT-ON */
@@ -356,6 +405,7 @@ dash_isoff_suite (void)
   tcase_add_test (tc_moof, isoff_moof_parse);
   tcase_add_test (tc_moof, isoff_moof_parse_with_tfdt);
   tcase_add_test (tc_moof, isoff_moof_parse_with_tfxd_tfrf);
+  tcase_add_test (tc_moof, isoff_moof_parse_buffer_multiple_memories);
   suite_add_tcase (s, tc_moof);
 
   tcase_add_test (tc_moov, isoff_moov_parse);
@@ -0,0 +1,104 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gstjpeg2000parser.h>
+
+/* A code stream with a main header made of SIZ, COD and QCD segments, and
+ * two tile-parts, the last of which doesn't signal its length */
+static const guint8 j2k_codestream[] = {
+  0xff, 0x4f,
+  /* SIZ, one component */
+  0xff, 0x51, 0x00, 0x29,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x40,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x40, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x07, 0x01, 0x01,
+  /* COD */
+  0xff, 0x52, 0x00, 0x0c,
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x05, 0x04, 0x04, 0x00, 0x01,
+  /* QCD */
+  0xff, 0x5c, 0x00, 0x04, 0x40, 0x48,
+  /* tile 0, part 0 of 2 */
+  0xff, 0x90, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x02,
+  0xff, 0x93, 0xff, 0xd9, 0x01, 0x02, 0x03, 0x04,
+  /* tile 0, part 1 of 2, up to the EOC */
+  0xff, 0x90, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02,
+  0xff, 0x93, 0x05, 0x06, 0x07, 0x08,
+  0xff, 0xd9
+};
+
+GST_START_TEST (test_jpeg2000_parse_codestream)
+{
+  GstJPEG2000Codestream codestream = { 0, };
+  GstJPEG2000TilePart *tile_part;
+  /* another code stream following this one */
+  guint8 data[sizeof (j2k_codestream) + 4];
+
+  memcpy (data, j2k_codestream, sizeof (j2k_codestream));
+  memcpy (data + sizeof (j2k_codestream), j2k_codestream, 4);
+
+  assert_equals_int (gst_jpeg2000_parser_parse_codestream (data,
+          sizeof (data), &codestream), GST_JPEG2000_PARSER_OK);
+  assert_equals_int (codestream.main_header_size, 65);
+  assert_equals_int (codestream.size, sizeof (j2k_codestream));
+  assert_equals_int (codestream.tile_parts->len, 2);
+
+  /* the EOC lookalike in the first tile-part is not looked at */
+  tile_part = &g_array_index (codestream.tile_parts, GstJPEG2000TilePart, 0);
+  assert_equals_int (tile_part->tile_index, 0);
+  assert_equals_int (tile_part->part_index, 0);
+  assert_equals_int (tile_part->num_parts, 2);
+  assert_equals_int (tile_part->offset, 65);
+  assert_equals_int (tile_part->size, 20);
+
+  tile_part = &g_array_index (codestream.tile_parts, GstJPEG2000TilePart, 1);
+  assert_equals_int (tile_part->part_index, 1);
+  assert_equals_int (tile_part->offset, 85);
+  assert_equals_int (tile_part->size, 18);
+
+  /* truncated code streams */
+  assert_equals_int (gst_jpeg2000_parser_parse_codestream (data,
+          sizeof (j2k_codestream) - 1, &codestream),
+      GST_JPEG2000_PARSER_NO_MORE_DATA);
+  assert_equals_int (gst_jpeg2000_parser_parse_codestream (data, 70,
+          &codestream), GST_JPEG2000_PARSER_NO_MORE_DATA);
+
+  /* not a code stream */
+  assert_equals_int (gst_jpeg2000_parser_parse_codestream (data + 2,
+          sizeof (data) - 2, &codestream), GST_JPEG2000_PARSER_BROKEN_DATA);
+
+  gst_jpeg2000_codestream_clear (&codestream);
+}
+
+GST_END_TEST;
+
+static Suite *
+jpeg2000parsers_suite (void)
+{
+  Suite *s = suite_create ("JPEG 2000 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_jpeg2000_parse_codestream);
+
+  return s;
+}
+
+GST_CHECK_MAIN (jpeg2000parsers);
@@ -560,6 +560,63 @@ GST_START_TEST (test_mpegts_dvb_descriptors)
 
 GST_END_TEST;
 
+GST_START_TEST (test_mpegts_crc_benchmark)
+{
+  static const guint nb_streams[] = { 1, 4, 16 };
+  guint8 info[200];
+  guint i, j, k;
+
+  for (i = 0; i < sizeof (info); i++)
+    info[i] = i;
+
+  for (i = 0; i < G_N_ELEMENTS (nb_streams); i++) {
+    GstMpegtsPMT *pmt;
+    GstMpegtsSection *section;
+    const guint8 *packet;
+    gsize size;
+    gint64 start, elapsed;
+
+    /* Build a PMT with large descriptors, so that validating it is
+     * dominated by the CRC check */
+    pmt = gst_mpegts_pmt_new ();
+    pmt->pcr_pid = 0x40;
+    pmt->program_number = 1;
+    for (j = 0; j < nb_streams[i]; j++) {
+      GstMpegtsPMTStream *stream = gst_mpegts_pmt_stream_new ();
+
+      stream->stream_type = GST_MPEGTS_STREAM_TYPE_VIDEO_H264;
+      stream->pid = 0x40 + j;
+      g_ptr_array_add (stream->descriptors,
+          gst_mpegts_descriptor_from_registration ("HDMV", info,
+              sizeof (info)));
+      g_ptr_array_add (pmt->streams, stream);
+    }
+
+    section = gst_mpegts_section_from_pmt (pmt, 0x30);
+    fail_if (section == NULL);
+    packet = gst_mpegts_section_packetize (section, &size);
+    fail_if (packet == NULL);
+
+    start = g_get_monotonic_time ();
+    for (k = 0; k < 1000; k++) {
+      GstMpegtsSection *parsed;
+
+      parsed = gst_mpegts_section_new (0x30, g_memdup (packet, size), size);
+      fail_if (parsed == NULL);
+      fail_if (gst_mpegts_section_get_pmt (parsed) == NULL);
+      gst_mpegts_section_unref (parsed);
+    }
+    elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+    GST_INFO ("%" G_GSIZE_FORMAT " byte sections: %.1f MB/s", size,
+        (gdouble) size * k / elapsed);
+
+    gst_mpegts_section_unref (section);
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegts_suite (void)
 {
@@ -577,6 +634,7 @@ mpegts_suite (void)
   tcase_add_test (tc_chain, test_mpegts_atsc_stt);
   tcase_add_test (tc_chain, test_mpegts_descriptors);
   tcase_add_test (tc_chain, test_mpegts_dvb_descriptors);
+  tcase_add_test (tc_chain, test_mpegts_crc_benchmark);
 
   return s;
 }
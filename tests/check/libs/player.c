@@ -754,6 +754,62 @@ START_TEST (test_play_media_info)
 
 END_TEST;
 
+START_TEST (test_discover_media_info)
+{
+  GstPlayerMediaInfo *media_info;
+  GstPlayerVideoInfo *video_info;
+  GstPlayer *player;
+  GError *err = NULL;
+  gchar *uri;
+
+  player = gst_player_new (NULL, NULL);
+  fail_unless (player != NULL);
+
+  uri = gst_filename_to_uri (TEST_PATH "/sintel.mkv", NULL);
+  fail_unless (uri != NULL);
+  media_info = gst_player_discover_media_info (player, uri, 10 * GST_SECOND,
+      &err);
+  g_free (uri);
+  fail_unless (media_info != NULL);
+  fail_unless (err == NULL);
+
+  fail_unless (gst_player_media_info_is_seekable (media_info) == TRUE);
+  fail_unless_equals_string (gst_player_media_info_get_title (media_info),
+      "Sintel");
+  fail_unless_equals_string (gst_player_media_info_get_container_format
+      (media_info), "Matroska");
+  fail_unless (strstr (gst_player_media_info_get_uri (media_info),
+          "sintel.mkv") != NULL);
+  fail_unless_equals_int (g_list_length
+      (gst_player_media_info_get_stream_list (media_info)), 10);
+  fail_unless_equals_int (g_list_length
+      (gst_player_media_info_get_video_streams (media_info)), 1);
+  fail_unless_equals_int (g_list_length
+      (gst_player_media_info_get_audio_streams (media_info)), 2);
+  fail_unless_equals_int (g_list_length
+      (gst_player_media_info_get_subtitle_streams (media_info)), 7);
+
+  video_info = gst_player_media_info_get_video_streams (media_info)->data;
+  fail_unless_equals_int (gst_player_video_info_get_width (video_info), 320);
+  fail_unless_equals_int (gst_player_video_info_get_height (video_info), 240);
+  g_object_unref (media_info);
+
+  /* the player itself is not touched by the discovery */
+  fail_unless (gst_player_get_media_info (player) == NULL);
+
+  uri = gst_filename_to_uri (TEST_PATH "/foo.mkv", NULL);
+  media_info = gst_player_discover_media_info (player, uri, 10 * GST_SECOND,
+      &err);
+  g_free (uri);
+  fail_unless (media_info == NULL);
+  fail_unless (err != NULL);
+  g_clear_error (&err);
+
+  g_object_unref (player);
+}
+
+END_TEST;
+
 static void
 test_play_error_invalid_external_suburi_cb (GstPlayer * player,
     TestPlayerStateChange change, TestPlayerState * old_state,
@@ -1713,6 +1769,7 @@ player_suite (void)
   tcase_add_test (tc_general, test_play_error_invalid_uri);
   tcase_add_test (tc_general, test_play_error_invalid_uri_and_play);
   tcase_add_test (tc_general, test_play_media_info);
+  tcase_add_test (tc_general, test_discover_media_info);
   tcase_add_test (tc_general, test_play_stream_disable);
   tcase_add_test (tc_general, test_play_stream_switch_audio);
   tcase_add_test (tc_general, test_play_stream_switch_subtitle);
@@ -0,0 +1,108 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gstvp9parser.h>
+
+/* A superframe with a 352x288 key frame and an inter frame which takes its
+ * size from the first reference */
+static const guint8 vp9_superframe[] = {
+  0x82, 0x49, 0x83, 0x42, 0x20, 0x15, 0xf0, 0x11, 0xf0, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x86, 0x00, 0x40, 0x92, 0x00, 0x00, 0x00, 0x00,
+  0xc1, 0x14, 0x08, 0xc1
+};
+
+GST_START_TEST (test_vp9_parse_superframe)
+{
+  GstVp9Parser *parser;
+  GstVp9SuperframeInfo info;
+  GstVp9FrameHdr frame_hdr;
+  const guint8 *data = vp9_superframe;
+
+  parser = gst_vp9_parser_new ();
+
+  assert_equals_int (gst_vp9_parser_parse_superframe_info (parser, &info,
+          vp9_superframe, sizeof (vp9_superframe)), GST_VP9_PARSER_OK);
+  assert_equals_int (info.frames_in_superframe, 2);
+  assert_equals_int (info.bytes_per_framesize, 1);
+  assert_equals_int (info.superframe_index_size, 4);
+  assert_equals_int (info.frame_sizes[0], 20);
+  assert_equals_int (info.frame_sizes[1], 8);
+
+  /* a single frame has no index */
+  assert_equals_int (gst_vp9_parser_parse_superframe_info (parser, &info,
+          data, info.frame_sizes[0]), GST_VP9_PARSER_OK);
+  assert_equals_int (info.frames_in_superframe, 1);
+  assert_equals_int (info.frame_sizes[0], 20);
+  assert_equals_int (info.superframe_index_size, 0);
+
+  /* index pointing past the data */
+  assert_equals_int (gst_vp9_parser_parse_superframe_info (parser, &info,
+          vp9_superframe + 8, sizeof (vp9_superframe) - 8),
+      GST_VP9_PARSER_BROKEN_DATA);
+
+  /* truncated key frame */
+  assert_equals_int (gst_vp9_parser_parse_frame_header_fast (parser,
+          &frame_hdr, data, 5), GST_VP9_PARSER_BROKEN_DATA);
+
+  assert_equals_int (gst_vp9_parser_parse_frame_header_fast (parser,
+          &frame_hdr, data, 20), GST_VP9_PARSER_OK);
+  assert_equals_int (frame_hdr.profile, GST_VP9_PROFILE_0);
+  assert_equals_int (frame_hdr.frame_type, GST_VP9_KEY_FRAME);
+  assert_equals_int (frame_hdr.show_frame, 1);
+  assert_equals_int (frame_hdr.refresh_frame_flags, 0xff);
+  assert_equals_int (frame_hdr.width, 352);
+  assert_equals_int (frame_hdr.height, 288);
+  assert_equals_int (parser->bit_depth, GST_VP9_BIT_DEPTH_8);
+  assert_equals_int (parser->color_space, GST_VP9_CS_BT_601);
+  assert_equals_int (parser->subsampling_x, 1);
+  assert_equals_int (parser->subsampling_y, 1);
+  data += 20;
+
+  assert_equals_int (gst_vp9_parser_parse_frame_header_fast (parser,
+          &frame_hdr, data, 8), GST_VP9_PARSER_OK);
+  assert_equals_int (frame_hdr.frame_type, GST_VP9_INTER_FRAME);
+  assert_equals_int (frame_hdr.show_frame, 1);
+  assert_equals_int (frame_hdr.intra_only, 0);
+  assert_equals_int (frame_hdr.refresh_frame_flags, 0x01);
+  assert_equals_int (frame_hdr.ref_frame_indices[0], 0);
+  assert_equals_int (frame_hdr.ref_frame_indices[1], 1);
+  assert_equals_int (frame_hdr.ref_frame_indices[2], 2);
+  assert_equals_int (frame_hdr.width, 352);
+  assert_equals_int (frame_hdr.height, 288);
+
+  gst_vp9_parser_free (parser);
+}
+
+GST_END_TEST;
+
+static Suite *
+vp9parsers_suite (void)
+{
+  Suite *s = suite_create ("VP9 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_vp9_parse_superframe);
+
+  return s;
+}
+
+GST_CHECK_MAIN (vp9parsers);